@@ -0,0 +1,203 @@
+/**
+ * The addon against Node's own crypto
+ *
+ *     node bench/compare.js [--filter regex] [--sizes 64,1024,...]
+ *                           [--time ms] [--rounds n] [--json file]
+ *
+ * For each primitive both offer, the binding and the equivalent
+ * `require('crypto')` call, backed by OpenSSL, are timed on the same
+ * inputs. The ratio is binding ops/s over Node ops/s: above 1 the binding
+ * is faster. Small messages mostly compare the cost of a call, large ones
+ * the implementations.
+ */
+/* jslint node: true */
+'use strict';
+
+var crypto = require('crypto');
+var fs = require('fs');
+var binding = require('../build/Release/sodium');
+var harness = require('./harness');
+
+var DEFAULT_SIZES = [16, 64, 1024, 16384, 1048576];
+
+function parseArgs(argv) {
+    var options = { sizes: DEFAULT_SIZES, time: 200, rounds: 3, filter: null, json: null };
+    for( var i = 0; i < argv.length; i += 2 ) {
+        switch( argv[i] ) {
+            case '--filter': options.filter = new RegExp(argv[i + 1]); break;
+            case '--sizes':  options.sizes = argv[i + 1].split(',').map(Number); break;
+            case '--time':   options.time = Number(argv[i + 1]); break;
+            case '--rounds': options.rounds = Number(argv[i + 1]); break;
+            case '--json':   options.json = argv[i + 1]; break;
+            default:
+                throw new Error('unknown option ' + argv[i]);
+        }
+    }
+    return options;
+}
+
+function bytes(size) {
+    var b = Buffer.alloc(size);
+    binding.randombytes_buf(b);
+    return b;
+}
+
+// One shot digest, crypto.hash where node has it
+function nodeHash(algorithm) {
+    if( typeof crypto.hash === 'function' ) {
+        return function(m) { return crypto.hash(algorithm, m, 'buffer'); };
+    }
+    return function(m) { return crypto.createHash(algorithm).update(m).digest(); };
+}
+
+function nodeSeal(cipher, key, nonce, ad) {
+    return function(m) {
+        var c = crypto.createCipheriv(cipher, key, nonce, { authTagLength: 16 });
+        c.setAAD(ad);
+        return Buffer.concat([c.update(m), c.final(), c.getAuthTag()]);
+    };
+}
+
+function nodeOpen(cipher, key, nonce, ad) {
+    return function(c) {
+        var d = crypto.createDecipheriv(cipher, key, nonce, { authTagLength: 16 });
+        d.setAAD(ad);
+        d.setAuthTag(c.subarray(c.length - 16));
+        return Buffer.concat([d.update(c.subarray(0, c.length - 16)), d.final()]);
+    };
+}
+
+// Pairs of { name, sized, sodium(m), node(m) }. `prepare(m)` gives the
+// input each side is timed on when it is not the message itself
+function pairs() {
+    var b = binding;
+    var authKey = bytes(32);
+    var ad = bytes(16);
+    var list = [
+        { name: 'sha256', sized: true,
+          sodium: function(m) { return b.crypto_hash_sha256(m); },
+          node: nodeHash('sha256') },
+        { name: 'sha512', sized: true,
+          sodium: function(m) { return b.crypto_hash_sha512(m); },
+          node: nodeHash('sha512') },
+        { name: 'hmacsha256', sized: true,
+          sodium: function(m) { return b.crypto_auth_hmacsha256(m, authKey); },
+          node: function(m) { return crypto.createHmac('sha256', authKey).update(m).digest(); } },
+        { name: 'hmacsha512', sized: true,
+          sodium: function(m) { return b.crypto_auth_hmacsha512(m, authKey); },
+          node: function(m) { return crypto.createHmac('sha512', authKey).update(m).digest(); } }
+    ];
+
+    var aeads = [
+        { algo: 'chacha20poly1305_ietf', cipher: 'chacha20-poly1305' },
+        { algo: 'aes256gcm', cipher: 'aes-256-gcm' }
+    ];
+    aeads.forEach(function(a) {
+        if( a.algo === 'aes256gcm' && !b.crypto_aead_aes256gcm_is_available() ) {
+            return;
+        }
+        var prefix = 'crypto_aead_' + a.algo;
+        var key = bytes(b[prefix + '_KEYBYTES']);
+        var nonce = bytes(b[prefix + '_NPUBBYTES']);
+        var encrypt = b[prefix + '_encrypt'];
+        var decrypt = b[prefix + '_decrypt'];
+        list.push({ name: a.algo + '_encrypt', sized: true,
+            sodium: function(m) { return encrypt(m, ad, nonce, key); },
+            node: nodeSeal(a.cipher, key, nonce, ad) });
+        list.push({ name: a.algo + '_decrypt', sized: true,
+            prepare: function(m) { return encrypt(m, ad, nonce, key); },
+            sodium: function(c) { return decrypt(c, ad, nonce, key); },
+            node: nodeOpen(a.cipher, key, nonce, ad) });
+    });
+
+    // Each side signs with its own key pair, the work is the same
+    var signKeys = b.crypto_sign_keypair();
+    var nodeSign = crypto.generateKeyPairSync('ed25519');
+    list.push({ name: 'ed25519_sign', sized: true,
+        sodium: function(m) { return b.crypto_sign_detached(m, signKeys.secretKey); },
+        node: function(m) { return crypto.sign(null, m, nodeSign.privateKey); } });
+    list.push({ name: 'ed25519_verify', sized: true,
+        prepare: function(m) {
+            return {
+                m: m,
+                sodium: b.crypto_sign_detached(m, signKeys.secretKey),
+                node: crypto.sign(null, m, nodeSign.privateKey)
+            };
+        },
+        sodium: function(s) { return b.crypto_sign_verify_detached(s.sodium, s.m, signKeys.publicKey); },
+        node: function(s) { return crypto.verify(null, s.m, nodeSign.publicKey, s.node); } });
+
+    var dhKeys = b.crypto_box_keypair();
+    var peerKeys = b.crypto_box_keypair();
+    var nodeDh = crypto.generateKeyPairSync('x25519');
+    var nodePeer = crypto.generateKeyPairSync('x25519');
+    list.push({ name: 'x25519', sized: false,
+        sodium: function() { return b.crypto_scalarmult(dhKeys.secretKey, peerKeys.publicKey); },
+        node: function() {
+            return crypto.diffieHellman({ privateKey: nodeDh.privateKey, publicKey: nodePeer.publicKey });
+        } });
+
+    return list;
+}
+
+function pad(s, n) {
+    s = String(s);
+    return s.length >= n ? s : s + ' '.repeat(n - s.length);
+}
+
+function run(options) {
+    var out = options.json === '-' ? process.stderr : process.stdout;
+    var results = [];
+
+    out.write(pad('case', 40) + pad('sodium ops/s', 16) + pad('node ops/s', 16) + 'ratio\n');
+    pairs().forEach(function(p) {
+        (p.sized ? options.sizes : [0]).forEach(function(size) {
+            var name = p.name + (p.sized ? '/' + size : '');
+            if( options.filter && !options.filter.test(name) ) {
+                return;
+            }
+            var input = bytes(size);
+            if( p.prepare ) {
+                input = p.prepare(input);
+            }
+            var measure = function(fn) {
+                return harness.measure(function() { fn(input); }, {
+                    minTime: options.time, rounds: options.rounds, bytes: p.sized ? size : 0
+                });
+            };
+            var s = measure(p.sodium);
+            var n = measure(p.node);
+            var r = {
+                name: name,
+                sodiumOpsPerSec: s.opsPerSec,
+                nodeOpsPerSec: n.opsPerSec,
+                ratio: Math.round(s.opsPerSec / n.opsPerSec * 100) / 100
+            };
+            results.push(r);
+            out.write(pad(name, 40) + pad(r.sodiumOpsPerSec, 16) + pad(r.nodeOpsPerSec, 16) + r.ratio + '\n');
+        });
+    });
+
+    return {
+        date: new Date().toISOString(),
+        node: process.version,
+        openssl: process.versions.openssl,
+        libsodium: binding.sodium_version_string(),
+        arch: process.arch,
+        build: binding.sodium_build_info(),
+        results: results
+    };
+}
+
+if( require.main === module ) {
+    var options = parseArgs(process.argv.slice(2));
+    var report = run(options);
+    if( options.json === '-' ) {
+        process.stdout.write(JSON.stringify(report, null, 2) + '\n');
+    }
+    else if( options.json ) {
+        fs.writeFileSync(options.json, JSON.stringify(report, null, 2) + '\n');
+    }
+}
+
+module.exports.run = run;
@@ -0,0 +1,93 @@
+/**
+ * Benchmark harness
+ *
+ * A case is a function run in a tight loop. It is warmed up, then run in
+ * batches that double in size until one batch takes at least `minTime`
+ * milliseconds, so the timer is read a handful of times per case whatever
+ * the cost of one call. The fastest of `rounds` runs is reported.
+ *
+ * With `counters`, the hardware counters of bench/run.js `--counters` are
+ * also read around each timed batch, and those of the fastest one turned
+ * into per call figures that compare across hosts: cycles per call and per
+ * byte, instructions per cycle and cache misses per call.
+ */
+/* jslint node: true */
+'use strict';
+
+function now() {
+    return process.hrtime.bigint();
+}
+
+function timeBatch(fn, n) {
+    var start = now();
+    for( var i = 0; i < n; i++ ) {
+        fn();
+    }
+    return Number(now() - start) / 1e6;
+}
+
+/**
+ * Measure one case
+ *
+ * @param {Function} fn         the operation to time
+ * @param {Object} options
+ *   - `minTime` (Number): milliseconds each timed batch must last
+ *   - `rounds` (Number): timed batches, the fastest one is kept
+ *   - `bytes` (Number): bytes processed per call, to report MB/s
+ *   - `counters` (Object): `{ start, stop }`, where `stop()` returns the
+ *     `{ cycles, instructions, cacheReferences, cacheMisses }` since
+ *     `start()`, as sodium_bench_counters_stop does
+ * @returns {Object} `{ ops, opsPerSec, nsPerOp, mbPerSec }`, plus
+ *   `{ cyclesPerOp, cyclesPerByte, ipc, cacheMissesPerOp }` with `counters`
+ */
+function measure(fn, options) {
+    var minTime = options.minTime || 200;
+    var rounds = options.rounds || 3;
+
+    // Warm up, and find a batch size that lasts long enough
+    var n = 1;
+    timeBatch(fn, 1);
+    while( timeBatch(fn, n) < minTime / 4 ) {
+        n *= 2;
+    }
+    while( timeBatch(fn, n) < minTime ) {
+        n *= 2;
+    }
+
+    var best = Infinity;
+    var counts;
+    for( var r = 0; r < rounds; r++ ) {
+        if( options.counters ) {
+            options.counters.start();
+        }
+        var ms = timeBatch(fn, n);
+        var c = options.counters ? options.counters.stop() : undefined;
+        if( ms < best ) {
+            best = ms;
+            counts = c;
+        }
+    }
+
+    var opsPerSec = n / (best / 1000);
+    var result = {
+        ops: n,
+        opsPerSec: Math.round(opsPerSec),
+        nsPerOp: Math.round(best * 1e6 / n)
+    };
+    if( options.bytes ) {
+        result.mbPerSec = Math.round(opsPerSec * options.bytes / 1e4) / 100;
+    }
+    if( counts && counts.cycles > 0 ) {
+        result.cyclesPerOp = Math.round(counts.cycles / n);
+        result.ipc = Math.round(counts.instructions / counts.cycles * 100) / 100;
+        if( options.bytes ) {
+            result.cyclesPerByte = Math.round(counts.cycles / n / options.bytes * 100) / 100;
+        }
+        if( counts.cacheMisses >= 0 ) {
+            result.cacheMissesPerOp = Math.round(counts.cacheMisses / n * 100) / 100;
+        }
+    }
+    return result;
+}
+
+module.exports.measure = measure;
@@ -0,0 +1,248 @@
+/**
+ * Event loop delay of a server doing crypto
+ *
+ *     node bench/loop_delay.js [--modes idle,sync,async] [--duration 10s]
+ *                              [--rate n] [--jobs n] [--json file]
+ *
+ * An HTTP server on the loopback answers `--rate` requests a second, each
+ * checking an HMAC, sent by a client in the same process. Meanwhile
+ * background jobs, `--jobs` of each kind a second, hash a password with
+ * Argon2id at its interactive limits, hash 16MB with SHA-256 and encrypt
+ * 16MB with XChaCha20-Poly1305. Each mode runs the same schedule:
+ *
+ *   * `idle`: no background jobs, the baseline
+ *   * `sync`: the jobs call the sync bindings on the event loop
+ *   * `async`: the jobs call the `_async` bindings
+ *
+ * For each mode it reports `perf_hooks.monitorEventLoopDelay` and the
+ * request latency, p50, p99 and max, in milliseconds. Requests are timed
+ * from when they were due, not when they could be sent, so a blocked loop
+ * shows up in the latency instead of hiding as fewer requests.
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var http = require('http');
+var perfHooks = require('perf_hooks');
+var binding = require('../build/Release/sodium');
+
+var BULK = 16 * 1024 * 1024;
+
+function parseDuration(value) {
+    var m = /^(\d+(?:\.\d+)?)(ms|s|m)?$/.exec(value);
+    if( !m ) {
+        throw new Error('bad duration ' + value);
+    }
+    return Number(m[1]) * { ms: 1, s: 1000, m: 60000 }[m[2] || 'ms'];
+}
+
+function parseArgs(argv) {
+    var options = { modes: ['idle', 'sync', 'async'], duration: 10000, rate: 1000, jobs: 2, json: null };
+    for( var i = 0; i < argv.length; i += 2 ) {
+        switch( argv[i] ) {
+            case '--modes':    options.modes = argv[i + 1].split(','); break;
+            case '--duration': options.duration = parseDuration(argv[i + 1]); break;
+            case '--rate':     options.rate = Number(argv[i + 1]); break;
+            case '--jobs':     options.jobs = Number(argv[i + 1]); break;
+            case '--json':     options.json = argv[i + 1]; break;
+            default:
+                throw new Error('unknown option ' + argv[i]);
+        }
+    }
+    return options;
+}
+
+function bytes(size) {
+    var b = Buffer.alloc(size);
+    binding.randombytes_buf(b);
+    return b;
+}
+
+// Background jobs, the same work in both forms. Async ones return a Promise
+function jobs() {
+    var b = binding;
+    var password = Buffer.from('correct horse battery staple');
+    var salt = bytes(b.crypto_pwhash_SALTBYTES);
+    var bulk = bytes(BULK);
+    var key = bytes(b.crypto_aead_xchacha20poly1305_ietf_KEYBYTES);
+    var nonce = bytes(b.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+    var chunk = 1024 * 1024;
+
+    return [
+        {
+            name: 'pwhash',
+            sync: function() {
+                b.crypto_pwhash(32, password, salt, b.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    b.crypto_pwhash_MEMLIMIT_INTERACTIVE, b.crypto_pwhash_ALG_ARGON2ID13);
+            },
+            async: function() {
+                return b.crypto_pwhash_async(32, password, salt, b.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    b.crypto_pwhash_MEMLIMIT_INTERACTIVE, b.crypto_pwhash_ALG_ARGON2ID13);
+            }
+        },
+        {
+            name: 'sha256',
+            sync: function() { b.crypto_hash_sha256(bulk); },
+            async: function() { return b.crypto_hash_sha256_async(bulk); }
+        },
+        {
+            name: 'aead',
+            sync: function() {
+                b.crypto_aead_xchacha20poly1305_ietf_encrypt_chunks(bulk, chunk, null, nonce, 0, key);
+            },
+            async: function() {
+                return b.crypto_aead_xchacha20poly1305_ietf_encrypt_chunks_async(bulk, chunk, null, nonce, 0, key);
+            }
+        }
+    ];
+}
+
+function histogram() {
+    return perfHooks.createHistogram();
+}
+
+function ms(ns) {
+    return Math.round(Number(ns) / 1e4) / 100;
+}
+
+function summary(h) {
+    return { p50: ms(h.percentile(50)), p99: ms(h.percentile(99)), max: ms(h.max) };
+}
+
+function runMode(mode, options, server, done) {
+    var authKey = bytes(binding.crypto_auth_hmacsha256_KEYBYTES);
+    var tag = binding.crypto_auth_hmacsha256(Buffer.from('/token'), authKey);
+    var agent = new http.Agent({ keepAlive: true, maxSockets: 64 });
+    var port = server.address().port;
+    var work = jobs();
+    var loop = perfHooks.monitorEventLoopDelay({ resolution: 1 });
+    var latency = histogram();
+    var sent = 0, answered = 0, failed = 0, jobsDone = 0, jobsRunning = 0;
+    var timers = [];
+    var stopping = false;
+
+    server.removeAllListeners('request');
+    server.on('request', function(req, res) {
+        var ok = binding.crypto_auth_hmacsha256_verify(tag, Buffer.from(req.url), authKey) === 0;
+        res.end(ok ? 'ok' : 'no');
+    });
+
+    // Open loop client: every 10ms, send the requests due since the last tick
+    var start = process.hrtime.bigint();
+    var interval = 1e9 / options.rate;
+    timers.push(setInterval(function() {
+        var now = process.hrtime.bigint();
+        var due = Math.floor(Number(now - start) / interval);
+        for( ; sent < due; sent++ ) {
+            request(start + BigInt(Math.round(sent * interval)));
+        }
+    }, 10));
+
+    function request(dueAt) {
+        http.get({ port: port, path: '/token', agent: agent }, function(res) {
+            res.resume();
+            res.on('end', function() {
+                answered++;
+                latency.record(Math.max(1, Number(process.hrtime.bigint() - dueAt)));
+                check();
+            });
+        }).on('error', function() {
+            failed++;
+            check();
+        });
+    }
+
+    if( mode !== 'idle' ) {
+        work.forEach(function(job) {
+            timers.push(setInterval(function() {
+                if( mode === 'sync' ) {
+                    job.sync();
+                    jobsDone++;
+                    return;
+                }
+                jobsRunning++;
+                job.async().then(function() {
+                    jobsDone++;
+                    jobsRunning--;
+                    check();
+                });
+            }, 1000 / options.jobs));
+        });
+    }
+
+    loop.enable();
+    timers.push(setTimeout(function() {
+        stopping = true;
+        loop.disable();
+        timers.forEach(clearInterval);
+        check();
+    }, options.duration));
+
+    function check() {
+        if( !stopping || answered + failed < sent || jobsRunning > 0 ) {
+            return;
+        }
+        agent.destroy();
+        done({
+            mode: mode,
+            loopDelay: summary(loop),
+            latency: summary(latency),
+            requests: answered,
+            failed: failed,
+            jobs: jobsDone
+        });
+        stopping = false;
+    }
+}
+
+function pad(s, n) {
+    s = String(s);
+    return s.length >= n ? s : s + ' '.repeat(n - s.length);
+}
+
+function run(options, done) {
+    var out = options.json === '-' ? process.stderr : process.stdout;
+    var server = http.createServer();
+    var results = [];
+
+    out.write(pad('mode', 8) + pad('loop p50', 10) + pad('loop p99', 10) + pad('loop max', 10) +
+              pad('req p50', 10) + pad('req p99', 10) + pad('req max', 10) + pad('requests', 10) + 'jobs\n');
+
+    server.listen(0, '127.0.0.1', function next() {
+        var mode = options.modes[results.length];
+        if( mode === undefined ) {
+            server.close();
+            done({
+                date: new Date().toISOString(),
+                node: process.version,
+                libsodium: binding.sodium_version_string(),
+                threadpool: process.env.UV_THREADPOOL_SIZE || 4,
+                options: options,
+                results: results
+            });
+            return;
+        }
+        runMode(mode, options, server, function(r) {
+            results.push(r);
+            out.write(pad(r.mode, 8) + pad(r.loopDelay.p50, 10) + pad(r.loopDelay.p99, 10) +
+                      pad(r.loopDelay.max, 10) + pad(r.latency.p50, 10) + pad(r.latency.p99, 10) +
+                      pad(r.latency.max, 10) + pad(r.requests, 10) + r.jobs + '\n');
+            next();
+        });
+    });
+}
+
+if( require.main === module ) {
+    var options = parseArgs(process.argv.slice(2));
+    run(options, function(report) {
+        if( options.json === '-' ) {
+            process.stdout.write(JSON.stringify(report, null, 2) + '\n');
+        }
+        else if( options.json ) {
+            fs.writeFileSync(options.json, JSON.stringify(report, null, 2) + '\n');
+        }
+    });
+}
+
+module.exports.run = run;
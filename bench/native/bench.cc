@@ -0,0 +1,578 @@
+/**
+ * Native benchmarks
+ *
+ *     build/Release/sodium_bench_native [--filter regex] [--sizes 64,1024,...]
+ *                                       [--time ms] [--rounds n] [--json file]
+ *                                       [--counters]
+ *
+ * Times the libsodium kernels, and the helpers the bindings run them
+ * through, in a C++ loop: no N-API crossing, argument parsing, output
+ * Buffers or garbage collection. Cases are named as in `bench/suites`, so
+ * for a case in both reports the difference between `make bench` and this
+ * is the cost of the binding. The cases past the suites time the batch,
+ * multi-message and chunk kernels of crypto_aead.h and the secure slot
+ * pool against `sodium_malloc`. `--counters` adds cycles per byte and
+ * instructions per cycle, as in bench/run.js.
+ *
+ * Built by `make bench-native`, against the same libsodium and with the same
+ * flags as the addon. The timing loop is the one of bench/harness.js.
+ */
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "crypto_aead.h"
+#include "sodium_perf_counters.h"
+#include "sodium_secure_slots.h"
+
+#ifndef SODIUM_BUILD_PROFILE
+#define SODIUM_BUILD_PROFILE "default"
+#endif
+#ifndef SODIUM_BUILD_MARCH
+#define SODIUM_BUILD_MARCH ""
+#endif
+
+// The kernels the addon instantiates in crypto_aead.cc
+CRYPTO_AEAD_MULTI_KERNELS(xchacha20poly1305_ietf)
+CRYPTO_AEAD_CHUNKS_KERNELS(xchacha20poly1305_ietf)
+
+// Results of the calls, so none is optimized out or warned about
+static volatile int sink;
+
+// Messages per batch case, and bytes per chunk of the chunk cases
+#define BENCH_BATCH 64
+#define BENCH_CHUNK_SIZE (64 * 1024)
+
+struct BenchCase {
+    std::string name;
+    size_t bytes;                   // bytes processed per call, 0 for none
+    std::function<void()> fn;
+};
+
+struct BenchResult {
+    std::string name;
+    double ops;
+    double opsPerSec;
+    double nsPerOp;
+    double mbPerSec;                // negative when the case has no bytes
+    double cyclesPerOp;             // the counters of --counters, negative
+    double cyclesPerByte;           // without them or, for cyclesPerByte,
+    double ipc;                     // bytes, and for cacheMissesPerOp the
+    double cacheMissesPerOp;        // cache counters
+};
+
+struct BenchOptions {
+    std::vector<size_t> sizes = { 16, 64, 256, 1024, 16384, 1048576 };
+    double time = 200;
+    int rounds = 3;
+    std::string filter;
+    std::string json;
+    bool counters = false;
+};
+
+static std::vector<unsigned char> message(size_t size) {
+    std::vector<unsigned char> m(size == 0 ? 1 : size);
+    randombytes_buf(m.data(), m.size());
+    return m;
+}
+
+static double time_batch(const std::function<void()>& fn, double n) {
+    auto start = std::chrono::steady_clock::now();
+    for(double i = 0; i < n; i++) {
+        fn();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Warm up, double the batch until it lasts `minTime` ms, keep the fastest
+// of `rounds` batches, and with `counters` the counts of that batch
+static BenchResult measure(const BenchCase& c, double minTime, int rounds, bool counters) {
+    double n = 1;
+    time_batch(c.fn, 1);
+    while( time_batch(c.fn, n) < minTime / 4 ) {
+        n *= 2;
+    }
+    while( time_batch(c.fn, n) < minTime ) {
+        n *= 2;
+    }
+
+    double best = 1e300;
+    SodiumPerfCounts counts = { false, 0, 0, -1, -1 };
+    for(int r = 0; r < rounds; r++) {
+        if( counters ) {
+            sodium_perf_counters_start();
+        }
+        double ms = time_batch(c.fn, n);
+        SodiumPerfCounts round = counters ? sodium_perf_counters_stop() : counts;
+        if( ms < best ) {
+            best = ms;
+            counts = round;
+        }
+    }
+
+    BenchResult result;
+    result.name = c.name;
+    result.ops = n;
+    result.opsPerSec = n / (best / 1000);
+    result.nsPerOp = best * 1e6 / n;
+    result.mbPerSec = c.bytes ? result.opsPerSec * c.bytes / 1e6 : -1;
+    bool counted = counts.valid && counts.cycles > 0;
+    result.cyclesPerOp = counted ? counts.cycles / n : -1;
+    result.cyclesPerByte = counted && c.bytes ? counts.cycles / n / c.bytes : -1;
+    result.ipc = counted ? counts.instructions / counts.cycles : -1;
+    result.cacheMissesPerOp = counted && counts.cacheMisses >= 0 ? counts.cacheMisses / n : -1;
+    return result;
+}
+
+// The buffers of a batch, and the spans of each message in them
+struct AeadBatch {
+    std::vector<unsigned char> messages;
+    std::vector<unsigned char> nonceBytes;
+    std::vector<unsigned char> sealedBytes;
+    std::vector<unsigned char> openedBytes;
+    std::vector<SodiumSpan> m;
+    std::vector<SodiumSpan> c;
+    std::vector<SodiumSpan> ad;
+    std::vector<SodiumSpan> npub;
+};
+
+static std::string sized(const std::string& name, size_t size) {
+    return name + "/" + std::to_string(size);
+}
+
+static void aead_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static std::vector<unsigned char> ad = message(16);
+    static std::vector<unsigned char> key = message(32);
+    static std::vector<unsigned char> nonce = message(crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+
+#define AEAD_CASES(ALGO) \
+    for(size_t size : sizes) { \
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size)); \
+        auto c = std::make_shared<std::vector<unsigned char> >(size + crypto_aead_ ## ALGO ## _ABYTES); \
+        sink = crypto_aead_ ## ALGO ## _encrypt(c->data(), NULL, m->data(), size, ad.data(), ad.size(), NULL, \
+                                                nonce.data(), key.data()); \
+        cases.push_back({ sized(#ALGO "_encrypt", size), size, [=]() { \
+            sink = crypto_aead_ ## ALGO ## _encrypt(c->data(), NULL, m->data(), size, ad.data(), ad.size(), NULL, \
+                                                    nonce.data(), key.data()); \
+        } }); \
+        auto out = std::make_shared<std::vector<unsigned char> >(size + 1); \
+        cases.push_back({ sized(#ALGO "_decrypt", size), size, [=]() { \
+            sink = crypto_aead_ ## ALGO ## _decrypt(out->data(), NULL, NULL, c->data(), c->size(), ad.data(), \
+                                                    ad.size(), nonce.data(), key.data()); \
+        } }); \
+    }
+
+    AEAD_CASES(chacha20poly1305_ietf)
+    AEAD_CASES(xchacha20poly1305_ietf)
+    if( crypto_aead_aes256gcm_is_available() ) {
+        AEAD_CASES(aes256gcm)
+    }
+#undef AEAD_CASES
+
+    // BENCH_BATCH messages per call, through the kernels of the _batch bindings
+    for(size_t size : sizes) {
+        size_t sealedSize = size + crypto_aead_xchacha20poly1305_ietf_ABYTES;
+        auto b = std::make_shared<AeadBatch>();
+        b->messages = message(size * BENCH_BATCH);
+        b->nonceBytes = message(crypto_aead_xchacha20poly1305_ietf_NPUBBYTES * BENCH_BATCH);
+        b->sealedBytes.resize(sealedSize * BENCH_BATCH);
+        b->openedBytes.resize(size * BENCH_BATCH + 1);
+        for(size_t i = 0; i < BENCH_BATCH; i++) {
+            b->m.push_back(SodiumSpan{ b->messages.data() + i * size, size });
+            b->c.push_back(SodiumSpan{ b->sealedBytes.data() + i * sealedSize, sealedSize });
+            b->ad.push_back(SodiumSpan{ ad.data(), ad.size() });
+            b->npub.push_back(SodiumSpan{ b->nonceBytes.data() + i * crypto_aead_xchacha20poly1305_ietf_NPUBBYTES,
+                                          crypto_aead_xchacha20poly1305_ietf_NPUBBYTES });
+        }
+        sink = aead_xchacha20poly1305_ietf_encrypt_batch(b->sealedBytes.data(), b->m, b->ad, b->npub, key.data());
+
+        cases.push_back({ sized("xchacha20poly1305_ietf_encrypt_batch", size), size * BENCH_BATCH, [=]() {
+            sink = aead_xchacha20poly1305_ietf_encrypt_batch(b->sealedBytes.data(), b->m, b->ad, b->npub, key.data());
+        } });
+        cases.push_back({ sized("xchacha20poly1305_ietf_decrypt_batch", size), size * BENCH_BATCH, [=]() {
+            sink = aead_xchacha20poly1305_ietf_decrypt_batch(b->openedBytes.data(), b->c, b->ad, b->npub, key.data());
+        } });
+    }
+
+    // Chunked messages on one thread, and on every core when there are more
+    std::vector<size_t> threadCounts = { 1 };
+    if( std::thread::hardware_concurrency() > 1 ) {
+        threadCounts.push_back(std::thread::hardware_concurrency());
+    }
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        size_t chunks = size == 0 ? 1 : (size + BENCH_CHUNK_SIZE - 1) / BENCH_CHUNK_SIZE;
+        auto c = std::make_shared<std::vector<unsigned char> >(size + chunks * crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        auto out = std::make_shared<std::vector<unsigned char> >(size + 1);
+        for(size_t threads : threadCounts) {
+            std::string suffix = threads == 1 ? "_chunks" : "_chunks_threads";
+            cases.push_back({ sized("xchacha20poly1305_ietf_encrypt" + suffix, size), size, [=]() {
+                std::atomic<bool> stopped(false);
+                aead_xchacha20poly1305_ietf_encrypt_chunks(c->data(), m->data(), size, BENCH_CHUNK_SIZE,
+                    ad.data(), ad.size(), nonce.data(), 0, key.data(), threads, NULL, stopped);
+            } });
+            cases.push_back({ sized("xchacha20poly1305_ietf_decrypt" + suffix, size), size, [=]() {
+                std::atomic<bool> stopped(false);
+                aead_xchacha20poly1305_ietf_decrypt_chunks(out->data(), c->data(), c->size(), BENCH_CHUNK_SIZE,
+                    ad.data(), ad.size(), nonce.data(), 0, key.data(), threads, NULL, stopped);
+            } });
+        }
+    }
+}
+
+static void auth_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static std::vector<unsigned char> key = message(crypto_auth_hmacsha512_KEYBYTES);
+    static unsigned char tag[crypto_auth_hmacsha512_BYTES];
+
+#define AUTH_CASES(FN) \
+    cases.push_back({ sized(#FN, size), size, [=]() { \
+        FN(tag, m->data(), size, key.data()); \
+    } }); \
+    cases.push_back({ sized(#FN "_verify", size), size, [=]() { \
+        sink = FN ## _verify(tag, m->data(), size, key.data()); \
+    } });
+
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        AUTH_CASES(crypto_auth)
+        AUTH_CASES(crypto_auth_hmacsha256)
+        AUTH_CASES(crypto_onetimeauth)
+    }
+#undef AUTH_CASES
+}
+
+static void box_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static unsigned char pk[crypto_box_PUBLICKEYBYTES];
+    static unsigned char sk[crypto_box_SECRETKEYBYTES];
+    static unsigned char shared[crypto_box_BEFORENMBYTES];
+    static std::vector<unsigned char> nonce = message(crypto_box_NONCEBYTES);
+    crypto_box_keypair(pk, sk);
+    sink = crypto_box_beforenm(shared, pk, sk);
+
+    cases.push_back({ "crypto_box_keypair", 0, []() {
+        unsigned char p[crypto_box_PUBLICKEYBYTES], s[crypto_box_SECRETKEYBYTES];
+        crypto_box_keypair(p, s);
+    } });
+    cases.push_back({ "crypto_box_beforenm", 0, []() {
+        unsigned char k[crypto_box_BEFORENMBYTES];
+        sink = crypto_box_beforenm(k, pk, sk);
+    } });
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        auto c = std::make_shared<std::vector<unsigned char> >(size + crypto_box_MACBYTES);
+        auto out = std::make_shared<std::vector<unsigned char> >(size + 1);
+        sink = crypto_box_easy(c->data(), m->data(), size, nonce.data(), pk, sk);
+        cases.push_back({ sized("crypto_box_easy", size), size, [=]() {
+            sink = crypto_box_easy(c->data(), m->data(), size, nonce.data(), pk, sk);
+        } });
+        cases.push_back({ sized("crypto_box_open_easy", size), size, [=]() {
+            sink = crypto_box_open_easy(out->data(), c->data(), c->size(), nonce.data(), pk, sk);
+        } });
+        cases.push_back({ sized("crypto_box_easy_afternm", size), size, [=]() {
+            sink = crypto_box_easy_afternm(c->data(), m->data(), size, nonce.data(), shared);
+        } });
+    }
+}
+
+static void generichash_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static std::vector<unsigned char> key = message(crypto_generichash_KEYBYTES);
+    static unsigned char out[crypto_generichash_BYTES];
+
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        cases.push_back({ sized("crypto_generichash", size), size, [=]() {
+            crypto_generichash(out, sizeof out, m->data(), size, NULL, 0);
+        } });
+        cases.push_back({ sized("crypto_generichash_keyed", size), size, [=]() {
+            crypto_generichash(out, sizeof out, m->data(), size, key.data(), key.size());
+        } });
+    }
+}
+
+static void hash_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static unsigned char out[crypto_hash_sha512_BYTES];
+
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        cases.push_back({ sized("crypto_hash_sha256", size), size, [=]() {
+            crypto_hash_sha256(out, m->data(), size);
+        } });
+        cases.push_back({ sized("crypto_hash_sha512", size), size, [=]() {
+            crypto_hash_sha512(out, m->data(), size);
+        } });
+    }
+}
+
+// The secret memory of wrapped objects: a `sodium_malloc` block each, or a
+// slot of the secure pool when it is on, see sodium_secure_slots.cc
+static void memory_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    for(size_t size : { (size_t) 32, (size_t) 64, (size_t) 1024 }) {
+        cases.push_back({ sized("sodium_malloc", size), 0, [=]() {
+            sodium_free(sodium_malloc(size));
+        } });
+        cases.push_back({ sized("secure_slot", size), 0, [=]() {
+            size_t footprint;
+            sodium_slot_free(sodium_slot_alloc(size, footprint));
+        } });
+    }
+}
+
+static void randombytes_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    cases.push_back({ "randombytes_random", 0, []() {
+        randombytes_random();
+    } });
+    cases.push_back({ "randombytes_uniform", 0, []() {
+        randombytes_uniform(1000);
+    } });
+    for(size_t size : sizes) {
+        auto out = std::make_shared<std::vector<unsigned char> >(size + 1);
+        cases.push_back({ sized("randombytes_buf", size), size, [=]() {
+            randombytes_buf(out->data(), size);
+        } });
+    }
+}
+
+static void secretbox_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static std::vector<unsigned char> key = message(crypto_secretbox_KEYBYTES);
+    static std::vector<unsigned char> nonce = message(crypto_secretbox_NONCEBYTES);
+
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        auto c = std::make_shared<std::vector<unsigned char> >(size + crypto_secretbox_MACBYTES);
+        auto out = std::make_shared<std::vector<unsigned char> >(size + 1);
+        sink = crypto_secretbox_easy(c->data(), m->data(), size, nonce.data(), key.data());
+        cases.push_back({ sized("crypto_secretbox_easy", size), size, [=]() {
+            sink = crypto_secretbox_easy(c->data(), m->data(), size, nonce.data(), key.data());
+        } });
+        cases.push_back({ sized("crypto_secretbox_open_easy", size), size, [=]() {
+            sink = crypto_secretbox_open_easy(out->data(), c->data(), c->size(), nonce.data(), key.data());
+        } });
+    }
+}
+
+static void sign_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static unsigned char pk[crypto_sign_PUBLICKEYBYTES];
+    static unsigned char sk[crypto_sign_SECRETKEYBYTES];
+    crypto_sign_keypair(pk, sk);
+
+    cases.push_back({ "crypto_sign_keypair", 0, []() {
+        unsigned char p[crypto_sign_PUBLICKEYBYTES], s[crypto_sign_SECRETKEYBYTES];
+        crypto_sign_keypair(p, s);
+    } });
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        auto sig = std::make_shared<std::vector<unsigned char> >(crypto_sign_BYTES);
+        crypto_sign_detached(sig->data(), NULL, m->data(), size, sk);
+        cases.push_back({ sized("crypto_sign_detached", size), size, [=]() {
+            crypto_sign_detached(sig->data(), NULL, m->data(), size, sk);
+        } });
+        cases.push_back({ sized("crypto_sign_verify_detached", size), size, [=]() {
+            sink = crypto_sign_verify_detached(sig->data(), m->data(), size, pk);
+        } });
+    }
+}
+
+static void stream_cases(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes) {
+    static std::vector<unsigned char> key = message(32);
+    static std::vector<unsigned char> nonce = message(crypto_stream_xchacha20_NONCEBYTES);
+
+#define STREAM_CASE(ALGO) \
+    cases.push_back({ sized(#ALGO "_xor", size), size, [=]() { \
+        crypto_stream_ ## ALGO ## _xor(out->data(), m->data(), size, nonce.data(), key.data()); \
+    } });
+
+    for(size_t size : sizes) {
+        auto m = std::make_shared<std::vector<unsigned char> >(message(size));
+        auto out = std::make_shared<std::vector<unsigned char> >(size + 1);
+        STREAM_CASE(xsalsa20)
+        STREAM_CASE(salsa20)
+        STREAM_CASE(chacha20)
+        STREAM_CASE(chacha20_ietf)
+        STREAM_CASE(xchacha20)
+    }
+#undef STREAM_CASE
+}
+
+struct BenchSuite {
+    const char* name;
+    void (*cases)(std::vector<BenchCase>& cases, const std::vector<size_t>& sizes);
+};
+
+// In the order of bench/suites, then the native only ones
+static const BenchSuite suites[] = {
+    { "aead", aead_cases },
+    { "auth", auth_cases },
+    { "box", box_cases },
+    { "generichash", generichash_cases },
+    { "hash", hash_cases },
+    { "randombytes", randombytes_cases },
+    { "secretbox", secretbox_cases },
+    { "sign", sign_cases },
+    { "stream", stream_cases },
+    { "memory", memory_cases }
+};
+
+static BenchOptions parse_args(int argc, char** argv) {
+    BenchOptions options;
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if( arg == "--counters" ) {
+            options.counters = true;
+            continue;
+        }
+        if( i + 1 >= argc ) {
+            throw std::runtime_error("missing value of " + arg);
+        }
+        std::string value = argv[++i];
+        if( arg == "--filter" ) {
+            options.filter = value;
+        } else if( arg == "--sizes" ) {
+            options.sizes.clear();
+            size_t start = 0;
+            while( start <= value.size() ) {
+                size_t end = value.find(',', start);
+                end = end == std::string::npos ? value.size() : end;
+                options.sizes.push_back(std::stoul(value.substr(start, end - start)));
+                start = end + 1;
+            }
+        } else if( arg == "--time" ) {
+            options.time = std::stod(value);
+        } else if( arg == "--rounds" ) {
+            options.rounds = std::stoi(value);
+        } else if( arg == "--json" ) {
+            options.json = value;
+        } else {
+            throw std::runtime_error("unknown option " + arg);
+        }
+    }
+    return options;
+}
+
+static const char* compiler() {
+#if defined(__clang__)
+    return "clang " __clang_version__;
+#elif defined(__GNUC__)
+    return "gcc " __VERSION__;
+#else
+    return "unknown";
+#endif
+}
+
+// The report of bench/run.js, with `native` set and the CPU features
+// libsodium picks its kernels from in place of the node details
+static void write_json(FILE* f, const std::vector<BenchResult>& results, bool counters) {
+    char date[32];
+    time_t now = time(NULL);
+    strftime(date, sizeof date, "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+    fprintf(f, "{\n  \"date\": \"%s\",\n  \"native\": true,\n", date);
+    fprintf(f, "  \"libsodium\": \"%s\",\n", sodium_version_string());
+    fprintf(f, "  \"cpus\": %u,\n", std::thread::hardware_concurrency());
+    fprintf(f, "  \"build\": { \"profile\": \"%s\", \"march\": \"%s\", \"compiler\": \"%s\" },\n",
+            SODIUM_BUILD_PROFILE, SODIUM_BUILD_MARCH, compiler());
+    fprintf(f, "  \"cpu\": { \"aesni\": %s, \"pclmul\": %s, \"avx2\": %s, \"avx512f\": %s, \"neon\": %s },\n",
+            sodium_runtime_has_aesni() ? "true" : "false", sodium_runtime_has_pclmul() ? "true" : "false",
+            sodium_runtime_has_avx2() ? "true" : "false", sodium_runtime_has_avx512f() ? "true" : "false",
+            sodium_runtime_has_neon() ? "true" : "false");
+    fprintf(f, "  \"counters\": %s,\n", counters ? "true" : "false");
+    fprintf(f, "  \"results\": [");
+    for(size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        fprintf(f, "%s\n    { \"name\": \"%s\", \"ops\": %.0f, \"opsPerSec\": %.0f, \"nsPerOp\": %.0f",
+                i ? "," : "", r.name.c_str(), r.ops, r.opsPerSec, r.nsPerOp);
+        if( r.mbPerSec >= 0 ) {
+            fprintf(f, ", \"mbPerSec\": %.2f", r.mbPerSec);
+        }
+        if( r.cyclesPerOp >= 0 ) {
+            fprintf(f, ", \"cyclesPerOp\": %.0f, \"ipc\": %.2f", r.cyclesPerOp, r.ipc);
+        }
+        if( r.cyclesPerByte >= 0 ) {
+            fprintf(f, ", \"cyclesPerByte\": %.2f", r.cyclesPerByte);
+        }
+        if( r.cacheMissesPerOp >= 0 ) {
+            fprintf(f, ", \"cacheMissesPerOp\": %.2f", r.cacheMissesPerOp);
+        }
+        fprintf(f, " }");
+    }
+    fprintf(f, "\n  ]\n}\n");
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    try {
+        options = parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        fprintf(stderr, "usage: sodium_bench_native [--filter regex] [--sizes 64,1024,...] "
+                        "[--time ms] [--rounds n] [--json file] [--counters]\n");
+        return 1;
+    }
+    if( sodium_init() < 0 ) {
+        fprintf(stderr, "sodium_init failed\n");
+        return 1;
+    }
+    sodium_slots_enable();
+
+    std::regex filter(options.filter);
+    FILE* out = options.json == "-" ? stderr : stdout;
+    std::vector<BenchResult> results;
+
+    std::string error;
+    if( options.counters && !sodium_perf_counters_open(error) ) {
+        fprintf(out, "hardware counters not available: %s\n", error.c_str());
+        options.counters = false;
+    }
+
+    for(const BenchSuite& suite : suites) {
+        std::vector<BenchCase> cases;
+        suite.cases(cases, options.sizes);
+        for(const BenchCase& c : cases) {
+            std::string name = std::string(suite.name) + "/" + c.name;
+            if( !options.filter.empty() && !std::regex_search(name, filter) ) {
+                continue;
+            }
+            BenchResult r = measure(c, options.time, options.rounds, options.counters);
+            r.name = name;
+            results.push_back(r);
+
+            char ops[32];
+            snprintf(ops, sizeof ops, "%.0f ops/s", r.opsPerSec);
+            fprintf(out, "%-56s%-18s", name.c_str(), ops);
+            if( r.cyclesPerOp >= 0 ) {
+                char mb[32] = "", cycles[32];
+                if( r.mbPerSec >= 0 ) {
+                    snprintf(mb, sizeof mb, "%.2f MB/s", r.mbPerSec);
+                }
+                if( r.cyclesPerByte >= 0 ) {
+                    snprintf(cycles, sizeof cycles, "%.2f c/B", r.cyclesPerByte);
+                } else {
+                    snprintf(cycles, sizeof cycles, "%.0f c/op", r.cyclesPerOp);
+                }
+                fprintf(out, "%-16s%-14s%.2f IPC", mb, cycles, r.ipc);
+            } else if( r.mbPerSec >= 0 ) {
+                fprintf(out, "%.2f MB/s", r.mbPerSec);
+            }
+            fprintf(out, "\n");
+        }
+    }
+
+    if( options.json == "-" ) {
+        write_json(stdout, results, options.counters);
+    } else if( !options.json.empty() ) {
+        FILE* f = fopen(options.json.c_str(), "w");
+        if( f == NULL ) {
+            fprintf(stderr, "cannot write %s\n", options.json.c_str());
+            return 1;
+        }
+        write_json(f, results, options.counters);
+        fclose(f);
+    }
+    return 0;
+}
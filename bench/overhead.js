@@ -0,0 +1,138 @@
+/**
+ * Fixed cost of calling into the addon
+ *
+ *     node bench/overhead.js [--sizes 0,64,1024] [--time ms] [--json file]
+ *
+ * For each binding the time of a call from JavaScript is set against the
+ * time libsodium takes for the same work in a C++ loop. The difference is
+ * the tax paid per call: the N-API crossing, the argument macros and the
+ * output Buffer. The first rows split that tax into its parts.
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var binding = require('../build/Release/sodium');
+var harness = require('./harness');
+
+function parseArgs(argv) {
+    var options = { sizes: [0, 64, 1024], time: 200, rounds: 3, json: null };
+    for( var i = 0; i < argv.length; i += 2 ) {
+        switch( argv[i] ) {
+            case '--sizes':  options.sizes = argv[i + 1].split(',').map(Number); break;
+            case '--time':   options.time = Number(argv[i + 1]); break;
+            case '--rounds': options.rounds = Number(argv[i + 1]); break;
+            case '--json':   options.json = argv[i + 1]; break;
+            default:
+                throw new Error('unknown option ' + argv[i]);
+        }
+    }
+    return options;
+}
+
+function bytes(size) {
+    var b = Buffer.alloc(size);
+    binding.randombytes_buf(b);
+    return b;
+}
+
+// JavaScript side of each case, matching sodium_bench_native
+var calls = {
+    crypto_generichash: function(m) {
+        return function() { binding.crypto_generichash(binding.crypto_generichash_BYTES, m, null); };
+    },
+    crypto_verify_16: function() {
+        var a = bytes(16), b = bytes(16);
+        return function() { binding.crypto_verify_16(a, b); };
+    },
+    crypto_auth: function(m) {
+        var key = bytes(binding.crypto_auth_KEYBYTES);
+        return function() { binding.crypto_auth(m, key); };
+    },
+    crypto_onetimeauth: function(m) {
+        var key = bytes(binding.crypto_onetimeauth_KEYBYTES);
+        return function() { binding.crypto_onetimeauth(m, key); };
+    },
+    crypto_secretbox_easy: function(m) {
+        var key = bytes(binding.crypto_secretbox_KEYBYTES);
+        var nonce = bytes(binding.crypto_secretbox_NONCEBYTES);
+        return function() { binding.crypto_secretbox_easy(m, nonce, key); };
+    },
+    randombytes_buf: function(m) {
+        return function() { binding.randombytes_buf(m); };
+    }
+};
+
+// Fixed size cases are only run once
+var fixedSize = { crypto_verify_16: true };
+
+function nativeNs(name, size, jsNs, time) {
+    // About as long as the JavaScript measurement, at least 1000 calls
+    var iterations = Math.max(1000, Math.round(time * 1e6 / Math.max(jsNs, 1)));
+    var best = Infinity;
+    for( var r = 0; r < 3; r++ ) {
+        best = Math.min(best, binding.sodium_bench_native(name, size, iterations));
+    }
+    return best;
+}
+
+function pad(s, n) {
+    s = String(s);
+    return s.length >= n ? s : s + ' '.repeat(n - s.length);
+}
+
+function run(options) {
+    var out = options.json === '-' ? process.stderr : process.stdout;
+    var measure = function(fn) {
+        return harness.measure(fn, { minTime: options.time, rounds: options.rounds }).nsPerOp;
+    };
+    var a = bytes(32), b = bytes(32);
+
+    var parts = {
+        // Crossing into the addon and back
+        noop: measure(function() { binding.sodium_bench_noop(); }),
+
+        // ARGS plus two ARG_TO_UCHAR_BUFFER
+        args: measure(function() { binding.sodium_bench_args(a, b); }),
+
+        // A number argument and a 32 byte result Buffer
+        alloc: measure(function() { binding.sodium_bench_alloc(32); })
+    };
+    out.write('crossing ' + parts.noop + ' ns, two buffer arguments ' + parts.args +
+              ' ns, 32 byte result ' + parts.alloc + ' ns\n\n');
+    out.write(pad('case', 32) + pad('js ns', 12) + pad('native ns', 12) + 'tax ns\n');
+
+    var results = [];
+    Object.keys(calls).forEach(function(name) {
+        var sizes = fixedSize[name] ? [16] : options.sizes;
+        sizes.forEach(function(size) {
+            var js = measure(calls[name](bytes(size)));
+            var native = Math.round(nativeNs(name, size, js, options.time));
+            var r = { name: name + '/' + size, jsNs: js, nativeNs: native, taxNs: js - native };
+            results.push(r);
+            out.write(pad(r.name, 32) + pad(js, 12) + pad(native, 12) + r.taxNs + '\n');
+        });
+    });
+
+    return {
+        date: new Date().toISOString(),
+        node: process.version,
+        libsodium: binding.sodium_version_string(),
+        arch: process.arch,
+        parts: parts,
+        results: results
+    };
+}
+
+if( require.main === module ) {
+    var options = parseArgs(process.argv.slice(2));
+    var report = run(options);
+    if( options.json === '-' ) {
+        process.stdout.write(JSON.stringify(report, null, 2) + '\n');
+    }
+    else if( options.json ) {
+        fs.writeFileSync(options.json, JSON.stringify(report, null, 2) + '\n');
+    }
+}
+
+module.exports.run = run;
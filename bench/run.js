@@ -0,0 +1,140 @@
+/**
+ * Run the benchmark suites
+ *
+ *     node bench/run.js [--filter regex] [--sizes 64,1024,...] [--time ms]
+ *                       [--rounds n] [--json file] [--counters]
+ *
+ * Results are printed as a table. With `--json` they are also written to
+ * `file`, or to stdout for `-`, together with the node, libsodium and
+ * machine details needed to compare runs. `--counters` adds cycles per
+ * byte, or per call, and instructions per cycle from the hardware counters,
+ * on Linux hosts that expose them.
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var binding = require('../build/Release/sodium');
+var harness = require('./harness');
+
+var DEFAULT_SIZES = [16, 64, 256, 1024, 16384, 1048576];
+
+function parseArgs(argv) {
+    var options = { sizes: DEFAULT_SIZES, time: 200, rounds: 3, filter: null, json: null, counters: false };
+    for( var i = 0; i < argv.length; i++ ) {
+        var value = argv[i + 1];
+        switch( argv[i] ) {
+            case '--filter': options.filter = new RegExp(value); i++; break;
+            case '--sizes':  options.sizes = value.split(',').map(Number); i++; break;
+            case '--time':   options.time = Number(value); i++; break;
+            case '--rounds': options.rounds = Number(value); i++; break;
+            case '--json':   options.json = value; i++; break;
+            case '--counters': options.counters = true; break;
+            default:
+                throw new Error('unknown option ' + argv[i]);
+        }
+    }
+    return options;
+}
+
+function message(size) {
+    var m = Buffer.alloc(size);
+    binding.randombytes_buf(m);
+    return m;
+}
+
+function pad(s, n) {
+    s = String(s);
+    return s.length >= n ? s : s + ' '.repeat(n - s.length);
+}
+
+// Kernel libsodium selected for each primitive, the first thing to compare
+// when two hosts give different numbers
+function implementations() {
+    var report = binding.sodium_implementation_report();
+    var selected = {};
+    Object.keys(report).forEach(function(name) {
+        if( report[name].selected ) {
+            selected[name] = report[name].selected;
+        }
+    });
+    return selected;
+}
+
+// The counters of bench/harness.js, or undefined, with a warning, where
+// the host does not expose them
+function counters(out) {
+    try {
+        binding.sodium_bench_counters_open();
+    } catch (e) {
+        out.write('hardware counters not available: ' + e.message + '\n');
+        return undefined;
+    }
+    return { start: binding.sodium_bench_counters_start, stop: binding.sodium_bench_counters_stop };
+}
+
+// Cycles per byte, or per call for cases without bytes, and instructions
+// per cycle
+function counted(r) {
+    return pad(r.cyclesPerByte !== undefined ? r.cyclesPerByte + ' c/B' : r.cyclesPerOp + ' c/op', 14) +
+           r.ipc + ' IPC';
+}
+
+function run(options) {
+    var dir = path.join(__dirname, 'suites');
+    var ctx = { binding: binding, sizes: options.sizes, message: message };
+    var results = [];
+    var out = options.json === '-' ? process.stderr : process.stdout;
+    var hw = options.counters ? counters(out) : undefined;
+
+    fs.readdirSync(dir).filter(function(f) {
+        return /\.js$/.test(f);
+    }).sort().forEach(function(file) {
+        var suite = require(path.join(dir, file));
+        suite.cases(ctx).forEach(function(c) {
+            var name = suite.name + '/' + c.name + (c.size !== undefined ? '/' + c.size : '');
+            if( options.filter && !options.filter.test(name) ) {
+                return;
+            }
+            var r = harness.measure(c.fn, {
+                minTime: c.slow ? Math.max(options.time, 500) : options.time,
+                rounds: options.rounds,
+                bytes: c.size,
+                counters: hw
+            });
+            r.name = name;
+            results.push(r);
+            var mb = r.mbPerSec !== undefined ? r.mbPerSec + ' MB/s' : '';
+            out.write(pad(name, 56) + pad(r.opsPerSec + ' ops/s', 18) +
+                      (r.cyclesPerOp !== undefined ? pad(mb, 16) + counted(r) : mb) + '\n');
+        });
+    });
+
+    return {
+        date: new Date().toISOString(),
+        node: process.version,
+        libsodium: binding.sodium_version_string ? binding.sodium_version_string() : undefined,
+        arch: process.arch,
+        cpu: (os.cpus()[0] || {}).model,
+        cpus: os.cpus().length,
+        build: binding.sodium_build_info(),
+        implementations: implementations(),
+        counters: hw !== undefined,
+        results: results
+    };
+}
+
+if( require.main === module ) {
+    var options = parseArgs(process.argv.slice(2));
+    var report = run(options);
+    if( options.json === '-' ) {
+        process.stdout.write(JSON.stringify(report, null, 2) + '\n');
+    }
+    else if( options.json ) {
+        fs.writeFileSync(options.json, JSON.stringify(report, null, 2) + '\n');
+    }
+}
+
+module.exports.run = run;
@@ -0,0 +1,352 @@
+/**
+ * Soak test
+ *
+ *     node --expose-gc bench/soak.js [--duration 4h] [--interval 10s]
+ *                                    [--sizes 64,1024] [--filter regex]
+ *                                    [--concurrency n] [--slice ms]
+ *                                    [--warmup 5m] [--max-growth mb]
+ *                                    [--json file]
+ *
+ * Calls every binding family for a long time at full rate and samples the
+ * process every `--interval`: RSS, V8 heap, external and ArrayBuffer
+ * memory, the native memory the addon reports, garbage collection pauses
+ * and calls per second. Correctness is the mocha suite's job; this catches
+ * what only shows after millions of calls, such as a result Buffer, a pool
+ * slab or a cache entry that is never released.
+ *
+ * The sync cases are the ones of `bench/suites`, run round robin in slices
+ * of `--slice` milliseconds. Between slices the event loop runs, and with
+ * it `--concurrency` async calls kept in flight, some on the threadpool and
+ * some tiered inline, plus objects with native state that are created and
+ * dropped, half disposed and half left to the garbage collector.
+ *
+ * With `--expose-gc` a full collection runs before each sample, so the
+ * figures are what is retained rather than garbage not yet collected. After
+ * `--warmup` the growth of each figure is fitted to a line; the run fails
+ * if RSS, external or native memory grows by more than `--max-growth` MB
+ * an hour.
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var path = require('path');
+var perfHooks = require('perf_hooks');
+var binding = require('../build/Release/sodium');
+
+var MB = 1024 * 1024;
+
+function parseDuration(value) {
+    var m = /^(\d+(?:\.\d+)?)(ms|s|m|h)?$/.exec(value);
+    if( !m ) {
+        throw new Error('bad duration ' + value);
+    }
+    var scale = { ms: 1, s: 1000, m: 60000, h: 3600000 }[m[2] || 'ms'];
+    return Number(m[1]) * scale;
+}
+
+function parseArgs(argv) {
+    var options = {
+        duration: 60000, interval: 10000, sizes: [64, 1024], filter: null,
+        concurrency: 16, slice: 20, warmup: null, maxGrowth: 16, json: null
+    };
+    for( var i = 0; i < argv.length; i++ ) {
+        var value = argv[i + 1];
+        switch( argv[i] ) {
+            case '--duration':    options.duration = parseDuration(value); i++; break;
+            case '--interval':    options.interval = parseDuration(value); i++; break;
+            case '--sizes':       options.sizes = value.split(',').map(Number); i++; break;
+            case '--filter':      options.filter = new RegExp(value); i++; break;
+            case '--concurrency': options.concurrency = Number(value); i++; break;
+            case '--slice':       options.slice = Number(value); i++; break;
+            case '--warmup':      options.warmup = parseDuration(value); i++; break;
+            case '--max-growth':  options.maxGrowth = Number(value); i++; break;
+            case '--json':        options.json = value; i++; break;
+            default:
+                throw new Error('unknown option ' + argv[i]);
+        }
+    }
+    if( options.warmup === null ) {
+        options.warmup = Math.min(options.duration / 5, 300000);
+    }
+    return options;
+}
+
+function message(size) {
+    var m = Buffer.alloc(size);
+    binding.randombytes_buf(m);
+    return m;
+}
+
+// Sync cases of the bench suites, without the slow ones: a soak wants many
+// calls, not long ones
+function syncCases(options) {
+    var dir = path.join(__dirname, 'suites');
+    var ctx = { binding: binding, sizes: options.sizes, message: message };
+    var cases = [];
+
+    fs.readdirSync(dir).filter(function(f) {
+        return /\.js$/.test(f);
+    }).sort().forEach(function(file) {
+        var suite = require(path.join(dir, file));
+        suite.cases(ctx).forEach(function(c) {
+            var name = suite.name + '/' + c.name + (c.size !== undefined ? '/' + c.size : '');
+            if( c.slow || (options.filter && !options.filter.test(name)) ) {
+                return;
+            }
+            cases.push({ name: name, fn: c.fn });
+        });
+    });
+    return cases;
+}
+
+// Async cases return a Promise. Small messages are hashed inline, large
+// ones on the threadpool, so both paths of the tiered calls are covered
+function asyncCases(options) {
+    var b = binding;
+    var small = message(1024);
+    var large = message(256 * 1024);
+    var authKey = message(b.crypto_auth_hmacsha256_KEYBYTES);
+    var box = b.crypto_box_keypair();
+    var sealed = b.crypto_box_seal(small, box.publicKey);
+    var password = Buffer.from('correct horse battery staple');
+    var cases = [];
+
+    [small, large].forEach(function(m) {
+        cases.push({ name: 'async/crypto_generichash_async/' + m.length, fn: function() {
+            return b.crypto_generichash_async(32, m, null);
+        }});
+        cases.push({ name: 'async/crypto_hash_sha256_async/' + m.length, fn: function() {
+            return b.crypto_hash_sha256_async(m);
+        }});
+        cases.push({ name: 'async/crypto_auth_hmacsha256_async/' + m.length, fn: function() {
+            return b.crypto_auth_hmacsha256_async(m, authKey);
+        }});
+    });
+    cases.push({ name: 'async/crypto_box_seal_async', fn: function() {
+        return b.crypto_box_seal_async(small, box.publicKey);
+    }});
+    cases.push({ name: 'async/crypto_box_seal_open_async', fn: function() {
+        return b.crypto_box_seal_open_async(sealed, box.publicKey, box.secretKey);
+    }});
+    cases.push({ name: 'async/randombytes_buf_async', fn: function() {
+        return b.randombytes_buf_async(Buffer.alloc(4096));
+    }});
+    cases.push({ name: 'async/crypto_pwhash_str_async', fn: function() {
+        return b.crypto_pwhash_str_async(password,
+            b.crypto_pwhash_OPSLIMIT_MIN, b.crypto_pwhash_MEMLIMIT_MIN);
+    }});
+
+    return cases.filter(function(c) {
+        return !options.filter || options.filter.test(c.name);
+    });
+}
+
+// Objects holding native memory, created and dropped. Every other one is
+// disposed, the rest are released by their finalizers
+function objectCases(options) {
+    var b = binding;
+    var key = message(32);
+    var n = 0;
+    var cases = [
+        { name: 'objects/HmacKey', fn: function() {
+            var k = new b.HmacKey('hmacsha256', key);
+            k.mac(key);
+            if( n++ & 1 ) {
+                k.dispose();
+            }
+        }},
+        { name: 'objects/BloomFilter', fn: function() {
+            var f = new b.BloomFilter(key.subarray(0, 16), { bits: 4096 });
+            f.add(key);
+            if( n++ & 1 ) {
+                f.dispose();
+            }
+        }}
+    ];
+    return cases.filter(function(c) {
+        return !options.filter || options.filter.test(c.name);
+    });
+}
+
+function memory() {
+    var m = process.memoryUsage();
+    return {
+        rss: m.rss,
+        heapUsed: m.heapUsed,
+        external: m.external,
+        arrayBuffers: m.arrayBuffers,
+        native: binding.sodium_memory_usage().total
+    };
+}
+
+// Least squares slope of `key` against time, in bytes an hour
+function slope(samples, key) {
+    var n = samples.length;
+    if( n < 2 ) {
+        return 0;
+    }
+    var sx = 0, sy = 0, sxx = 0, sxy = 0;
+    samples.forEach(function(s) {
+        var x = s.t / 3600000;
+        sx += x; sy += s[key]; sxx += x * x; sxy += x * s[key];
+    });
+    var d = n * sxx - sx * sx;
+    return d === 0 ? 0 : (n * sxy - sx * sy) / d;
+}
+
+function pad(s, n) {
+    s = String(s);
+    return s.length >= n ? s : ' '.repeat(n - s.length) + s;
+}
+
+function mb(bytes) {
+    return (bytes / MB).toFixed(1);
+}
+
+function run(options, done) {
+    var sync = syncCases(options);
+    var async = asyncCases(options);
+    var objects = objectCases(options);
+    var all = sync.concat(objects);
+    var out = options.json === '-' ? process.stderr : process.stdout;
+
+    var start = Date.now();
+    var calls = 0, asyncCalls = 0, asyncErrors = 0, inFlight = 0;
+    var gcCount = 0, gcPause = 0;
+    var samples = [];
+    var last = { t: 0, calls: 0, asyncCalls: 0, gcCount: 0, gcPause: 0 };
+    var next = 0;
+    var stopping = false;
+
+    var observer = new perfHooks.PerformanceObserver(function(list) {
+        list.getEntries().forEach(function(entry) {
+            gcCount++;
+            gcPause += entry.duration;
+        });
+    });
+    observer.observe({ entryTypes: ['gc'] });
+
+    function pump() {
+        while( !stopping && async.length && inFlight < options.concurrency ) {
+            var c = async[asyncCalls++ % async.length];
+            inFlight++;
+            c.fn().then(settle, function() {
+                asyncErrors++;
+                settle();
+            });
+        }
+    }
+
+    function settle() {
+        inFlight--;
+        pump();
+        if( stopping && inFlight === 0 ) {
+            finish();
+        }
+    }
+
+    function slice() {
+        if( stopping ) {
+            return;
+        }
+        var end = Date.now() + options.slice;
+        while( Date.now() < end && all.length ) {
+            var c = all[next++ % all.length];
+            for( var i = 0; i < 64; i++ ) {
+                c.fn();
+            }
+            calls += 64;
+        }
+        pump();
+        setImmediate(slice);
+    }
+
+    function sample() {
+        if( global.gc ) {
+            global.gc();
+        }
+        var t = Date.now() - start;
+        var s = memory();
+        s.t = t;
+        s.opsPerSec = Math.round((calls - last.calls) * 1000 / (t - last.t));
+        s.asyncPerSec = Math.round((asyncCalls - last.asyncCalls) * 1000 / (t - last.t));
+        s.gcCount = gcCount - last.gcCount;
+        s.gcPauseMs = Math.round(gcPause - last.gcPause);
+        last = { t: t, calls: calls, asyncCalls: asyncCalls, gcCount: gcCount, gcPause: gcPause };
+        samples.push(s);
+        out.write(pad(Math.round(t / 1000) + 's', 8) + pad(s.opsPerSec, 12) + pad(s.asyncPerSec, 10) +
+                  pad(mb(s.rss), 10) + pad(mb(s.heapUsed), 10) + pad(mb(s.external), 10) +
+                  pad(mb(s.native), 10) + pad(s.gcCount, 8) + pad(s.gcPauseMs, 10) + '\n');
+    }
+
+    function finish() {
+        observer.disconnect();
+        var settled = samples.filter(function(s) {
+            return s.t >= options.warmup;
+        });
+        var growth = {};
+        ['rss', 'heapUsed', 'external', 'arrayBuffers', 'native'].forEach(function(key) {
+            growth[key] = Math.round(slope(settled, key) / MB * 100) / 100;
+        });
+        var failed = ['rss', 'external', 'native'].filter(function(key) {
+            return growth[key] > options.maxGrowth;
+        });
+
+        out.write('\ngrowth after warmup, MB/hour: ' + JSON.stringify(growth) + '\n');
+        out.write('calls: ' + calls + ' sync, ' + asyncCalls + ' async (' + asyncErrors + ' failed), ' +
+                  'gc: ' + gcCount + ' collections, ' + Math.round(gcPause) + 'ms paused\n');
+        if( failed.length ) {
+            out.write('FAIL: ' + failed.join(', ') + ' grew more than ' + options.maxGrowth + ' MB/hour\n');
+        }
+        if( !global.gc ) {
+            out.write('run with node --expose-gc to sample retained memory only\n');
+        }
+
+        done({
+            date: new Date(start).toISOString(),
+            node: process.version,
+            libsodium: binding.sodium_version_string(),
+            options: options,
+            cases: all.concat(async).map(function(c) { return c.name; }),
+            calls: calls,
+            asyncCalls: asyncCalls,
+            asyncErrors: asyncErrors,
+            gcCount: gcCount,
+            gcPauseMs: Math.round(gcPause),
+            growth: growth,
+            failed: failed,
+            samples: samples
+        });
+    }
+
+    out.write(pad('time', 8) + pad('calls/s', 12) + pad('async/s', 10) + pad('rss', 10) +
+              pad('heap', 10) + pad('external', 10) + pad('native', 10) + pad('gcs', 8) +
+              pad('gc ms', 10) + '\n');
+
+    var sampler = setInterval(sample, options.interval);
+    setTimeout(function() {
+        clearInterval(sampler);
+        sample();
+        stopping = true;
+        if( inFlight === 0 ) {
+            finish();
+        }
+    }, options.duration);
+    slice();
+}
+
+if( require.main === module ) {
+    var options = parseArgs(process.argv.slice(2));
+    run(options, function(report) {
+        if( options.json === '-' ) {
+            process.stdout.write(JSON.stringify(report, null, 2) + '\n');
+        }
+        else if( options.json ) {
+            fs.writeFileSync(options.json, JSON.stringify(report, null, 2) + '\n');
+        }
+        process.exitCode = report.failed.length ? 1 : 0;
+    });
+}
+
+module.exports.run = run;
@@ -0,0 +1,46 @@
+/* jslint node: true */
+'use strict';
+
+var ALGOS = ['chacha20poly1305_ietf', 'xchacha20poly1305_ietf', 'aes256gcm'];
+
+module.exports.name = 'aead';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var ad = ctx.message(16);
+    var cases = [];
+
+    ALGOS.forEach(function(algo) {
+        if( algo === 'aes256gcm' && !b.crypto_aead_aes256gcm_is_available() ) {
+            return;
+        }
+        var prefix = 'crypto_aead_' + algo;
+        var key = ctx.message(b[prefix + '_KEYBYTES']);
+        var nonce = ctx.message(b[prefix + '_NPUBBYTES']);
+        var encrypt = b[prefix + '_encrypt'];
+        var decrypt = b[prefix + '_decrypt'];
+
+        ctx.sizes.forEach(function(size) {
+            var m = ctx.message(size);
+            var c = encrypt(m, ad, nonce, key);
+            cases.push({ name: algo + '_encrypt', size: size, fn: function() {
+                encrypt(m, ad, nonce, key);
+            }});
+            cases.push({ name: algo + '_decrypt', size: size, fn: function() {
+                decrypt(c, ad, nonce, key);
+            }});
+            // Fixed size bindings for key wrap and token sized payloads
+            if( size === 32 || size === 64 ) {
+                var encryptFixed = b[prefix + '_encrypt_' + size];
+                var decryptFixed = b[prefix + '_decrypt_' + size];
+                cases.push({ name: algo + '_encrypt_' + size, size: size, fn: function() {
+                    encryptFixed(m, ad, nonce, key);
+                }});
+                cases.push({ name: algo + '_decrypt_' + size, size: size, fn: function() {
+                    decryptFixed(c, ad, nonce, key);
+                }});
+            }
+        });
+    });
+    return cases;
+};
@@ -0,0 +1,24 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'auth';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var cases = [];
+
+    ['crypto_auth', 'crypto_auth_hmacsha256', 'crypto_onetimeauth'].forEach(function(fn) {
+        var key = ctx.message(b[fn + '_KEYBYTES']);
+        ctx.sizes.forEach(function(size) {
+            var m = ctx.message(size);
+            var tag = b[fn](m, key);
+            cases.push({ name: fn, size: size, fn: function() {
+                b[fn](m, key);
+            }});
+            cases.push({ name: fn + '_verify', size: size, fn: function() {
+                b[fn + '_verify'](tag, m, key);
+            }});
+        });
+    });
+    return cases;
+};
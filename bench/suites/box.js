@@ -0,0 +1,35 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'box';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var alice = b.crypto_box_keypair();
+    var bob = b.crypto_box_keypair();
+    var nonce = ctx.message(b.crypto_box_NONCEBYTES);
+    var shared = b.crypto_box_beforenm(bob.publicKey, alice.secretKey);
+
+    var cases = [
+        { name: 'crypto_box_keypair', fn: function() {
+            b.crypto_box_keypair();
+        }},
+        { name: 'crypto_box_beforenm', fn: function() {
+            b.crypto_box_beforenm(bob.publicKey, alice.secretKey);
+        }}
+    ];
+    ctx.sizes.forEach(function(size) {
+        var m = ctx.message(size);
+        var c = b.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+        cases.push({ name: 'crypto_box_easy', size: size, fn: function() {
+            b.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+        }});
+        cases.push({ name: 'crypto_box_open_easy', size: size, fn: function() {
+            b.crypto_box_open_easy(c, nonce, alice.publicKey, bob.secretKey);
+        }});
+        cases.push({ name: 'crypto_box_easy_afternm', size: size, fn: function() {
+            b.crypto_box_easy_afternm(m, nonce, shared);
+        }});
+    });
+    return cases;
+};
@@ -0,0 +1,21 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'generichash';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var key = ctx.message(b.crypto_generichash_KEYBYTES);
+    var cases = [];
+
+    ctx.sizes.forEach(function(size) {
+        var m = ctx.message(size);
+        cases.push({ name: 'crypto_generichash', size: size, fn: function() {
+            b.crypto_generichash(b.crypto_generichash_BYTES, m, null);
+        }});
+        cases.push({ name: 'crypto_generichash_keyed', size: size, fn: function() {
+            b.crypto_generichash(b.crypto_generichash_BYTES, m, key);
+        }});
+    });
+    return cases;
+};
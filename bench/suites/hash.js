@@ -0,0 +1,20 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'hash';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var cases = [];
+
+    ctx.sizes.forEach(function(size) {
+        var m = ctx.message(size);
+        cases.push({ name: 'crypto_hash_sha256', size: size, fn: function() {
+            b.crypto_hash_sha256(m);
+        }});
+        cases.push({ name: 'crypto_hash_sha512', size: size, fn: function() {
+            b.crypto_hash_sha512(m);
+        }});
+    });
+    return cases;
+};
@@ -0,0 +1,31 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'pwhash';
+
+// Password hashing costs are set by its limits, not the input size. The
+// minimum limits track regressions quickly; interactive is what apps use
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var password = Buffer.from('correct horse battery staple');
+    var salt = ctx.message(b.crypto_pwhash_SALTBYTES);
+    var scryptSalt = ctx.message(b.crypto_pwhash_scryptsalsa208sha256_SALTBYTES);
+
+    return [
+        { name: 'argon2id_min', fn: function() {
+            b.crypto_pwhash(32, password, salt,
+                b.crypto_pwhash_OPSLIMIT_MIN, b.crypto_pwhash_MEMLIMIT_MIN,
+                b.crypto_pwhash_ALG_ARGON2ID13);
+        }},
+        { name: 'argon2id_interactive', slow: true, fn: function() {
+            b.crypto_pwhash(32, password, salt,
+                b.crypto_pwhash_OPSLIMIT_INTERACTIVE, b.crypto_pwhash_MEMLIMIT_INTERACTIVE,
+                b.crypto_pwhash_ALG_ARGON2ID13);
+        }},
+        { name: 'scryptsalsa208sha256_interactive', slow: true, fn: function() {
+            b.crypto_pwhash_scryptsalsa208sha256(32, password, scryptSalt,
+                b.crypto_pwhash_scryptsalsa208sha256_OPSLIMIT_INTERACTIVE,
+                b.crypto_pwhash_scryptsalsa208sha256_MEMLIMIT_INTERACTIVE);
+        }}
+    ];
+};
@@ -0,0 +1,26 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'randombytes';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var cases = [
+        { name: 'randombytes_random', fn: function() {
+            b.randombytes_random();
+        }},
+        { name: 'randombytes_uniform', fn: function() {
+            b.randombytes_uniform(1000);
+        }}
+    ];
+    ctx.sizes.forEach(function(size) {
+        var buf = Buffer.alloc(size);
+        cases.push({ name: 'randombytes_buf', size: size, fn: function() {
+            b.randombytes_buf(buf);
+        }});
+        cases.push({ name: 'randombytes_buf_buffered', size: size, fn: function() {
+            b.randombytes_buf_buffered(buf);
+        }});
+    });
+    return cases;
+};
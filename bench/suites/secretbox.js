@@ -0,0 +1,33 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'secretbox';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var key = ctx.message(b.crypto_secretbox_KEYBYTES);
+    var nonce = ctx.message(b.crypto_secretbox_NONCEBYTES);
+    var cases = [];
+
+    ctx.sizes.forEach(function(size) {
+        var m = ctx.message(size);
+        var c = b.crypto_secretbox_easy(m, nonce, key);
+        cases.push({ name: 'crypto_secretbox_easy', size: size, fn: function() {
+            b.crypto_secretbox_easy(m, nonce, key);
+        }});
+        cases.push({ name: 'crypto_secretbox_open_easy', size: size, fn: function() {
+            b.crypto_secretbox_open_easy(c, nonce, key);
+        }});
+        if( size === 32 || size === 64 ) {
+            var easy = b['crypto_secretbox_easy_' + size];
+            var openEasy = b['crypto_secretbox_open_easy_' + size];
+            cases.push({ name: 'crypto_secretbox_easy_' + size, size: size, fn: function() {
+                easy(m, nonce, key);
+            }});
+            cases.push({ name: 'crypto_secretbox_open_easy_' + size, size: size, fn: function() {
+                openEasy(c, nonce, key);
+            }});
+        }
+    });
+    return cases;
+};
@@ -0,0 +1,26 @@
+/* jslint node: true */
+'use strict';
+
+module.exports.name = 'sign';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var keys = b.crypto_sign_keypair();
+
+    var cases = [
+        { name: 'crypto_sign_keypair', fn: function() {
+            b.crypto_sign_keypair();
+        }}
+    ];
+    ctx.sizes.forEach(function(size) {
+        var m = ctx.message(size);
+        var sig = b.crypto_sign_detached(m, keys.secretKey);
+        cases.push({ name: 'crypto_sign_detached', size: size, fn: function() {
+            b.crypto_sign_detached(m, keys.secretKey);
+        }});
+        cases.push({ name: 'crypto_sign_verify_detached', size: size, fn: function() {
+            b.crypto_sign_verify_detached(sig, m, keys.publicKey);
+        }});
+    });
+    return cases;
+};
@@ -0,0 +1,24 @@
+/* jslint node: true */
+'use strict';
+
+var ALGOS = ['xsalsa20', 'salsa20', 'chacha20', 'chacha20_ietf', 'xchacha20'];
+
+module.exports.name = 'stream';
+
+module.exports.cases = function(ctx) {
+    var b = ctx.binding;
+    var cases = [];
+
+    ALGOS.forEach(function(algo) {
+        var xor = b['crypto_stream_' + algo + '_xor'];
+        var key = ctx.message(b['crypto_stream_' + algo + '_KEYBYTES']);
+        var nonce = ctx.message(b['crypto_stream_' + algo + '_NONCEBYTES']);
+        ctx.sizes.forEach(function(size) {
+            var m = ctx.message(size);
+            cases.push({ name: algo + '_xor', size: size, fn: function() {
+                xor(m, nonce, key);
+            }});
+        });
+    });
+    return cases;
+};
@@ -1,40 +1,17 @@
 {
   'variables': {
-    'target_arch%': '<!(node -e \"var os = require(\'os\'); console.log(os.arch());\")>'
+    'target_arch%': '<!(node -e \"var os = require(\'os\'); console.log(os.arch());\")>',
+    'sodium_build%': 'default',
+    'sodium_march%': '',
+    'sodium_subsystems%': 'all',
+    'sodium_pgo%': '',
+    'sodium_pgo_profile%': '',
+    'sodium_native_bench%': 0
   },
   'targets': [{
     'target_name': 'sodium',
     'sources': [
-      'src/crypto_aead.cc',
-      'src/crypto_sign.cc',
-      'src/crypto_sign_ed25519.cc',
-      'src/crypto_box.cc',
-      'src/crypto_box_curve25519xsalsa20poly1305.cc',
-      'src/sodium_runtime.cc',
-      'src/crypto_auth.cc',
-      'src/crypto_auth_algos.cc',
-      'src/crypto_core.cc',
-      'src/crypto_scalarmult_curve25519.cc',
-      'src/crypto_scalarmult.cc',
-      'src/crypto_sign.cc',
-      'src/crypto_secretbox_xsalsa20poly1305.cc',
-      'src/crypto_secretbox.cc',
-      'src/sodium.cc',
-      'src/crypto_stream.cc',
-      'src/crypto_streams.cc',
-      'src/helpers.cc',
-      'src/randombytes.cc',
-      'src/crypto_pwhash_algos.cc',
-      'src/crypto_pwhash.cc',
-      'src/crypto_hash.cc',
-      'src/crypto_hash_sha256.cc',
-      'src/crypto_hash_sha512.cc',
-      'src/crypto_shorthash.cc',
-      'src/crypto_shorthash_siphash24.cc',
-      'src/crypto_generichash.cc',
-      'src/crypto_generichash_blake2b.cc',
-      'src/crypto_onetimeauth.cc',
-      'src/crypto_onetimeauth_poly1305.cc'
+      '<!@(node lib/subsystems.js sources <(sodium_subsystems))'
     ],
     'dependencies': ["<!(node -p \"require('node-addon-api').gyp\")"],
     'include_dirs': [
@@ -62,7 +39,55 @@
         },
       },
     },
+    'defines': [
+      'SODIUM_BUILD_PROFILE="<(sodium_build)"',
+      'SODIUM_BUILD_MARCH="<(sodium_march)"',
+      'SODIUM_BUILD_SUBSYSTEMS="<(sodium_subsystems)"',
+      'SODIUM_BUILD_PGO="<(sodium_pgo)"',
+      '<!@(node lib/subsystems.js defines <(sodium_subsystems))'
+    ],
     'conditions': [
+      ['sodium_build=="performance"', {
+        'cflags': [ '-O3', '-flto' ],
+        'ldflags': [ '-flto', '-O3' ],
+        'defines': [ 'SODIUM_BUILD_LTO=1' ],
+        'xcode_settings': {
+          'GCC_OPTIMIZATION_LEVEL': '3',
+          'LLVM_LTO': 'YES'
+        },
+        'msvs_settings': {
+          'VCCLCompilerTool': {
+            'Optimization': 2,
+            'WholeProgramOptimization': 'true'
+          },
+          'VCLinkerTool': {
+            'LinkTimeCodeGeneration': 1
+          }
+        }
+      }],
+      ['sodium_build=="performance" and sodium_march!="" and OS!="win"', {
+        'cflags': [ '-march=<(sodium_march)' ],
+        'xcode_settings': {
+          'OTHER_CFLAGS': [ '-march=<(sodium_march)' ]
+        }
+      }],
+      # make pgo: an instrumented build, then one with the profile of the
+      # training run. gcc on Linux, clang on macOS
+      ['sodium_pgo=="generate"', {
+        'cflags': [ '-fprofile-generate=<(sodium_pgo_profile)', '-fprofile-update=atomic' ],
+        'ldflags': [ '-fprofile-generate=<(sodium_pgo_profile)' ],
+        'xcode_settings': {
+          'OTHER_CFLAGS': [ '-fprofile-generate=<(sodium_pgo_profile)' ],
+          'OTHER_LDFLAGS': [ '-fprofile-generate=<(sodium_pgo_profile)' ]
+        }
+      }],
+      ['sodium_pgo=="use"', {
+        'cflags': [ '-fprofile-use=<(sodium_pgo_profile)', '-fprofile-partial-training', '-Wno-missing-profile' ],
+        'ldflags': [ '-fprofile-use=<(sodium_pgo_profile)' ],
+        'xcode_settings': {
+          'OTHER_CFLAGS': [ '-fprofile-use=<(sodium_pgo_profile)', '-Wno-profile-instr-unprofiled' ]
+        }
+      }],
       ['OS=="mac"', {
         'libraries': [
           '../deps/build/lib/libsodium.a'
@@ -84,9 +109,74 @@
       }],
       ['OS=="linux"', {
         'libraries': [
-          '../deps/build/lib/libsodium.a'
+          '../deps/build/lib/libsodium.a',
+          '-lrt'
         ]
       }]
     ]
-  }]
+  }],
+  'conditions': [
+    # make bench-native: the libsodium kernels and the helpers of the
+    # bindings timed without N-API, see bench/native/bench.cc. Linked with
+    # the same libsodium and flags as the addon
+    ['sodium_native_bench==1', {
+      'targets': [{
+        'target_name': 'sodium_bench_native',
+        'type': 'executable',
+        'sources': [
+          'bench/native/bench.cc',
+          'src/sodium_secure_slots.cc',
+          'src/sodium_perf_counters.cc'
+        ],
+        'dependencies': ["<!(node -p \"require('node-addon-api').gyp\")"],
+        'include_dirs': [
+          'src/include',
+          'deps/build/include',
+          "<!@(node -p \"require('node-addon-api').include\")"
+        ],
+        'cflags!': [ '-fno-exceptions' ],
+        'cflags_cc!': [ '-fno-exceptions' ],
+        'defines': [
+          'SODIUM_BUILD_PROFILE="<(sodium_build)"',
+          'SODIUM_BUILD_MARCH="<(sodium_march)"'
+        ],
+        'conditions': [
+          ['sodium_build=="performance"', {
+            'cflags': [ '-O3', '-flto' ],
+            'ldflags': [ '-flto', '-O3' ],
+            'xcode_settings': {
+              'GCC_OPTIMIZATION_LEVEL': '3',
+              'LLVM_LTO': 'YES'
+            }
+          }],
+          ['sodium_build=="performance" and sodium_march!="" and OS!="win"', {
+            'cflags': [ '-march=<(sodium_march)' ],
+            'xcode_settings': {
+              'OTHER_CFLAGS': [ '-march=<(sodium_march)' ]
+            }
+          }],
+          ['OS=="mac"', {
+            'libraries': [ '../deps/build/lib/libsodium.a' ],
+            'xcode_settings': {
+              'GCC_ENABLE_CPP_EXCEPTIONS': 'YES'
+            }
+          }],
+          ['OS=="win"', {
+            'libraries': [ '../deps/build/lib/libsodium.lib' ],
+            'msvs_settings': {
+              'VCCLCompilerTool': {
+                'ExceptionHandling': 1
+              }
+            }
+          }],
+          ['OS=="linux"', {
+            'libraries': [
+              '../deps/build/lib/libsodium.a',
+              '-pthread'
+            ]
+          }]
+        ]
+      }]
+    }]
+  ]
 }
\ No newline at end of file
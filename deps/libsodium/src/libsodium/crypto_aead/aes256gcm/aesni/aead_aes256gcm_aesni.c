@@ -11,6 +11,7 @@
 #include <string.h>
 
 #include "core.h"
+#include "crypto_verify_16.h"
 #include "crypto_aead_aes256gcm.h"
 #include "export.h"
 #include "private/common.h"
@@ -911,13 +912,324 @@ crypto_aead_aes256gcm_decrypt(unsigned char *m,
     return ret;
 }
 
+/*
+ * Many short messages under one key. A message of a few blocks never fills
+ * the AES pipeline on its own, and every call computes the powers of H
+ * again. Here the powers of H are computed once per batch, and the counter
+ * blocks of several messages, tag blocks included, go through AES 8 at a
+ * time as if they were one long message.
+ */
+
+/* counter blocks of one pass; longer messages are sealed on their own */
+#define MULTI_BLOCKS 64
+
+#define BLOCKLOADx(a) \
+    temp##a = _mm_xor_si128(_mm_load_si128((const __m128i *) (in + a * 16)), rkeys[0])
+
+/* encrypt nblocks blocks of in into out, which may be the same */
+static void
+aesni_encrypt_blocks(unsigned char *out, const unsigned char *in,
+                     size_t nblocks, const __m128i *rkeys)
+{
+    size_t i;
+    int    roundctr;
+
+    for (i = 0; i + 8 <= nblocks; i += 8, in += 8 * 16, out += 8 * 16) {
+        MAKE8(TEMPDECLx);
+
+        MAKE8(BLOCKLOADx);
+        for (roundctr = 1; roundctr < 14; roundctr++) {
+            MAKE8(AESENCx);
+        }
+        MAKE8(AESENCLASTx);
+        MAKE8(STOREx);
+    }
+    for (; i < nblocks; i++, in += 16, out += 16) {
+        aesni_encrypt1(out, _mm_load_si128((const __m128i *) in), rkeys);
+    }
+}
+
+/* blocks of keystream a message needs: the tag block, then its counters */
+static size_t
+multi_blocks(unsigned long long mlen)
+{
+    return 1 + (size_t) ((mlen + 15) / 16);
+}
+
+/* the keystream of n messages back to back, multi_blocks() each */
+static void
+multi_keystream(unsigned char *ks, const unsigned char * const *npub,
+                const unsigned long long *mlen, size_t n,
+                const __m128i *rkeys)
+{
+    unsigned char *block = ks;
+    size_t         i;
+    size_t         b;
+    size_t         count;
+
+    for (i = 0; i < n; i++) {
+        count = multi_blocks(mlen[i]);
+        for (b = 0; b < count; b++, block += 16) {
+            memcpy(block, npub[i], 12);
+            STORE32_BE(block + 12, (uint32_t) (b + 1));
+        }
+    }
+    aesni_encrypt_blocks(ks, ks, (size_t) (block - ks) / 16, rkeys);
+}
+
+/* out = in ^ keystream, for len bytes */
+static void
+multi_xor(unsigned char *out, const unsigned char *in, const unsigned char *ks,
+          unsigned long long len)
+{
+    unsigned long long j;
+
+    for (j = 0; j + 16 <= len; j += 16) {
+        _mm_storeu_si128((__m128i *) (out + j),
+                         _mm_xor_si128(_mm_loadu_si128((const __m128i *) (in + j)),
+                                       _mm_load_si128((const __m128i *) (ks + j))));
+    }
+    for (; j < len; j++) {
+        out[j] = in[j] ^ ks[j];
+    }
+}
+
+static void
+multi_ghash(unsigned char *accum, const unsigned char *x, unsigned long long xlen,
+            const __m128i Hv, const __m128i H2v, const __m128i H3v,
+            const __m128i H4v, const unsigned char *H)
+{
+    const __m128i      rev = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m128i            accv = _mm_load_si128((const __m128i *) accum);
+    unsigned long long xlen_rnd64 = xlen & ~63ULL;
+    unsigned long long i;
+
+    for (i = 0; i < xlen_rnd64; i += 64) {
+        __m128i X4_ = _mm_loadu_si128((const __m128i *) (x + i + 0));
+        __m128i X3_ = _mm_loadu_si128((const __m128i *) (x + i + 16));
+        __m128i X2_ = _mm_loadu_si128((const __m128i *) (x + i + 32));
+        __m128i X1_ = _mm_loadu_si128((const __m128i *) (x + i + 48));
+        MULREDUCE4(rev, Hv, H2v, H3v, H4v, X1_, X2_, X3_, X4_, accv);
+    }
+    _mm_store_si128((__m128i *) accum, accv);
+    for (i = xlen_rnd64; i < xlen; i += 16) {
+        unsigned int blocklen = 16;
+
+        if (i + (unsigned long long) blocklen > xlen) {
+            blocklen = (unsigned int) (xlen - i);
+        }
+        addmul(accum, x + i, blocklen, H);
+    }
+}
+
+/* the tag of a message from its additional data, cipher text and T */
+static void
+multi_tag(unsigned char *mac, const unsigned char *ad, unsigned long long adlen,
+          const unsigned char *c, unsigned long long mlen, const unsigned char *T,
+          const __m128i Hv, const __m128i H2v, const __m128i H3v,
+          const __m128i H4v, const unsigned char *H)
+{
+    CRYPTO_ALIGN(16) unsigned char accum[16];
+    CRYPTO_ALIGN(16) unsigned char fb[16];
+    uint64_t                       x;
+    unsigned int                   i;
+
+    x = _bswap64((uint64_t) (8 * adlen));
+    memcpy(&fb[0], &x, sizeof x);
+    x = _bswap64((uint64_t) (8 * mlen));
+    memcpy(&fb[8], &x, sizeof x);
+
+    memset(accum, 0, sizeof accum);
+    multi_ghash(accum, ad, adlen, Hv, H2v, H3v, H4v, H);
+    multi_ghash(accum, c, mlen, Hv, H2v, H3v, H4v, H);
+    addmul(accum, fb, 16, H);
+    for (i = 0; i < 16; ++i) {
+        mac[i] = T[i] ^ accum[15 - i];
+    }
+}
+
+/* H byte-reverted and its powers, as the single message code keeps them */
+static void
+multi_hpowers(unsigned char *H, __m128i *Hv, __m128i *H2v, __m128i *H3v,
+              __m128i *H4v, const context *ctx)
+{
+    const __m128i rev = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+    memcpy(H, ctx->H, 16);
+    *Hv = _mm_shuffle_epi8(_mm_load_si128((const __m128i *) H), rev);
+    _mm_store_si128((__m128i *) H, *Hv);
+    *H2v = mulv(*Hv, *Hv);
+    *H3v = mulv(*H2v, *Hv);
+    *H4v = mulv(*H3v, *Hv);
+}
+
+/*
+ * Encrypt n messages, in combined mode: c[i] gets mlen[i] bytes of cipher
+ * text followed by the tag. ad[i] may be NULL when adlen[i] is 0.
+ */
+int
+crypto_aead_aes256gcm_encrypt_multi_afternm(unsigned char * const *c,
+                                            const unsigned char * const *m,
+                                            const unsigned long long *mlen,
+                                            const unsigned char * const *ad,
+                                            const unsigned long long *adlen,
+                                            const unsigned char * const *npub,
+                                            size_t n,
+                                            const crypto_aead_aes256gcm_state *ctx_)
+{
+    const context *ctx = (const context *) ctx_;
+    __m128i        Hv, H2v, H3v, H4v;
+    size_t         first;
+    size_t         last;
+    size_t         blocks;
+    size_t         i;
+    const unsigned char *ks;
+    CRYPTO_ALIGN(16) unsigned char H[16];
+    CRYPTO_ALIGN(16) unsigned char keystream[MULTI_BLOCKS * 16];
+
+    for (i = 0; i < n; i++) {
+        if (mlen[i] > crypto_aead_aes256gcm_MESSAGEBYTES_MAX) {
+            sodium_misuse(); /* LCOV_EXCL_LINE */
+        }
+    }
+    multi_hpowers(H, &Hv, &H2v, &H3v, &H4v, ctx);
+
+    for (first = 0; first < n; first = last) {
+        if (multi_blocks(mlen[first]) > MULTI_BLOCKS) {
+            crypto_aead_aes256gcm_encrypt_afternm(c[first], NULL, m[first], mlen[first],
+                                                  ad[first], adlen[first], NULL,
+                                                  npub[first], ctx_);
+            last = first + 1;
+            continue;
+        }
+        blocks = 0;
+        for (last = first; last < n && blocks + multi_blocks(mlen[last]) <= MULTI_BLOCKS; last++) {
+            blocks += multi_blocks(mlen[last]);
+        }
+        multi_keystream(keystream, npub + first, mlen + first, last - first,
+                        ctx->rkeys);
+
+        ks = keystream;
+        for (i = first; i < last; i++) {
+            multi_xor(c[i], m[i], ks + 16, mlen[i]);
+            multi_tag(c[i] + mlen[i], ad[i], adlen[i], c[i], mlen[i], ks,
+                      Hv, H2v, H3v, H4v, H);
+            ks += 16 * multi_blocks(mlen[i]);
+        }
+    }
+    sodium_memzero(keystream, sizeof keystream);
+
+    return 0;
+}
+
+/*
+ * Decrypt n combined mode cipher texts, each clen[i] >= ABYTES bytes long.
+ * ok[i] is set to 1 and m[i] gets the clen[i] - ABYTES bytes of the
+ * message if it authenticates, else ok[i] is 0 and m[i] is zeroed.
+ * Returns 0 if every message authenticates, -1 if not.
+ */
+int
+crypto_aead_aes256gcm_decrypt_multi_afternm(unsigned char *ok,
+                                            unsigned char * const *m,
+                                            const unsigned char * const *c,
+                                            const unsigned long long *clen,
+                                            const unsigned char * const *ad,
+                                            const unsigned long long *adlen,
+                                            const unsigned char * const *npub,
+                                            size_t n,
+                                            const crypto_aead_aes256gcm_state *ctx_)
+{
+    const context *ctx = (const context *) ctx_;
+    __m128i        Hv, H2v, H3v, H4v;
+    size_t         first;
+    size_t         last;
+    size_t         blocks;
+    size_t         i;
+    unsigned long long mlen[MULTI_BLOCKS + 1];
+    const unsigned char *ks;
+    int            ret = 0;
+    CRYPTO_ALIGN(16) unsigned char H[16];
+    CRYPTO_ALIGN(16) unsigned char mac[16];
+    CRYPTO_ALIGN(16) unsigned char keystream[MULTI_BLOCKS * 16];
+
+    multi_hpowers(H, &Hv, &H2v, &H3v, &H4v, ctx);
+
+    for (first = 0; first < n; first = last) {
+        if (clen[first] < crypto_aead_aes256gcm_ABYTES ||
+            multi_blocks(clen[first] - crypto_aead_aes256gcm_ABYTES) > MULTI_BLOCKS) {
+            ok[first] = crypto_aead_aes256gcm_decrypt_afternm(m[first], NULL, NULL,
+                                                              c[first], clen[first],
+                                                              ad[first], adlen[first],
+                                                              npub[first], ctx_) == 0;
+            ret |= ok[first] ? 0 : -1;
+            last = first + 1;
+            continue;
+        }
+        blocks = 0;
+        for (last = first; last < n && clen[last] >= crypto_aead_aes256gcm_ABYTES; last++) {
+            mlen[last - first] = clen[last] - crypto_aead_aes256gcm_ABYTES;
+            if (blocks + multi_blocks(mlen[last - first]) > MULTI_BLOCKS) {
+                break;
+            }
+            blocks += multi_blocks(mlen[last - first]);
+        }
+        multi_keystream(keystream, npub + first, mlen, last - first, ctx->rkeys);
+
+        ks = keystream;
+        for (i = first; i < last; i++) {
+            const unsigned long long ml = mlen[i - first];
+
+            multi_tag(mac, ad[i], adlen[i], c[i], ml, ks, Hv, H2v, H3v, H4v, H);
+            ok[i] = crypto_verify_16(mac, c[i] + ml) == 0;
+            if (ok[i]) {
+                multi_xor(m[i], c[i], ks + 16, ml);
+            } else {
+                memset(m[i], 0, ml);
+                ret = -1;
+            }
+            ks += 16 * multi_blocks(ml);
+        }
+    }
+    sodium_memzero(keystream, sizeof keystream);
+
+    return ret;
+}
+
+/*
+ * AES-256 alone, in ECB mode, with the round keys of a precomputed state:
+ * nblocks 16 byte blocks of in into out, which may be the same. For QUIC
+ * style header protection masks, which are single AES blocks of samples.
+ */
+int
+crypto_aead_aes256gcm_encrypt_blocks_afternm(unsigned char *out,
+                                             const unsigned char *in,
+                                             size_t nblocks,
+                                             const crypto_aead_aes256gcm_state *ctx_)
+{
+    const context *ctx = (const context *) ctx_;
+    size_t         i;
+
+    if ((((uintptr_t) in) & 15U) == 0U) {
+        aesni_encrypt_blocks(out, in, nblocks, ctx->rkeys);
+        return 0;
+    }
+    for (i = 0; i < nblocks; i++) {
+        aesni_encrypt1(out + i * 16,
+                       _mm_loadu_si128((const __m128i *) (in + i * 16)), ctx->rkeys);
+    }
+    return 0;
+}
+
 int
 crypto_aead_aes256gcm_is_available(void)
 {
     return sodium_runtime_has_pclmul() & sodium_runtime_has_aesni();
 }
 
-#else
+#elif !(defined(HAVE_ARMCRYPTO) && defined(__aarch64__) && \
+       defined(USE_ARM64_KERNELS))
+
+/* on arm64 with USE_ARM64_KERNELS, aead_aes256gcm_armcrypto.c defines these */
 
 int
 crypto_aead_aes256gcm_encrypt_detached(unsigned char *c,
@@ -1028,6 +1340,45 @@ crypto_aead_aes256gcm_decrypt_afternm(unsigned char *m, unsigned long long *mlen
     return -1;
 }
 
+int
+crypto_aead_aes256gcm_encrypt_multi_afternm(unsigned char * const *c,
+                                            const unsigned char * const *m,
+                                            const unsigned long long *mlen,
+                                            const unsigned char * const *ad,
+                                            const unsigned long long *adlen,
+                                            const unsigned char * const *npub,
+                                            size_t n,
+                                            const crypto_aead_aes256gcm_state *ctx_)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+int
+crypto_aead_aes256gcm_decrypt_multi_afternm(unsigned char *ok,
+                                            unsigned char * const *m,
+                                            const unsigned char * const *c,
+                                            const unsigned long long *clen,
+                                            const unsigned char * const *ad,
+                                            const unsigned long long *adlen,
+                                            const unsigned char * const *npub,
+                                            size_t n,
+                                            const crypto_aead_aes256gcm_state *ctx_)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+int
+crypto_aead_aes256gcm_encrypt_blocks_afternm(unsigned char *out,
+                                             const unsigned char *in,
+                                             size_t nblocks,
+                                             const crypto_aead_aes256gcm_state *ctx_)
+{
+    errno = ENOSYS;
+    return -1;
+}
+
 int
 crypto_aead_aes256gcm_is_available(void)
 {
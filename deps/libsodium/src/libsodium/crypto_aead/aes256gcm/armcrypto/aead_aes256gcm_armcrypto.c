@@ -0,0 +1,596 @@
+
+/*
+ * AES256-GCM with the ARMv8 Crypto Extensions: aese/aesmc for AES, and
+ * pmull for GHASH, using the same bit-reflected representation and
+ * aggregated reduction as the AES-NI implementation.
+ */
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "crypto_verify_16.h"
+#include "crypto_aead_aes256gcm.h"
+#include "export.h"
+#include "private/common.h"
+#include "randombytes.h"
+#include "runtime.h"
+#include "utils.h"
+
+#if defined(HAVE_ARMCRYPTO) && defined(__aarch64__) && \
+    defined(USE_ARM64_KERNELS)
+
+# ifdef __clang__
+#  pragma clang attribute push(__attribute__((target("neon,crypto"))), \
+                               apply_to = function)
+# elif defined(__GNUC__)
+#  pragma GCC target("+simd+crypto")
+# endif
+
+# include <arm_neon.h>
+
+typedef struct context {
+    CRYPTO_ALIGN(16) unsigned char H[16];
+    uint8x16_t rkeys[15];
+} context;
+
+/* bytes encrypted, then hashed, at a time, so that GHASH reads from L1 */
+#define CHUNK_BYTES 4096
+
+static uint32_t
+aes_subword(uint32_t w)
+{
+    /* all four columns equal: ShiftRows is a no-op, only SubBytes is left */
+    uint8x16_t x = vreinterpretq_u8_u32(vdupq_n_u32(w));
+
+    x = vaeseq_u8(x, vdupq_n_u8(0));
+
+    return vgetq_lane_u32(vreinterpretq_u32_u8(x), 0);
+}
+
+static void
+aes256_key_expand(const unsigned char *key, uint8x16_t *rkeys)
+{
+    uint32_t w[60];
+    uint32_t t;
+    uint32_t rcon = 1;
+    int      i;
+
+    for (i = 0; i < 8; i++) {
+        w[i] = LOAD32_LE(key + 4 * i);
+    }
+    for (i = 8; i < 60; i++) {
+        t = w[i - 1];
+        if (i % 8 == 0) {
+            t = ROTR32(aes_subword(t), 8) ^ rcon;
+            rcon = (rcon << 1) ^ (0x1b & -(rcon >> 7));
+        } else if (i % 8 == 4) {
+            t = aes_subword(t);
+        }
+        w[i] = w[i - 8] ^ t;
+    }
+    for (i = 0; i < 15; i++) {
+        rkeys[i] = vreinterpretq_u8_u32(vld1q_u32(&w[4 * i]));
+    }
+    sodium_memzero(w, sizeof w);
+}
+
+static inline uint8x16_t
+aes_encrypt1(uint8x16_t b, const uint8x16_t *rkeys)
+{
+    int i;
+
+    for (i = 0; i < 13; i++) {
+        b = vaesmcq_u8(vaeseq_u8(b, rkeys[i]));
+    }
+    b = vaeseq_u8(b, rkeys[13]);
+
+    return veorq_u8(b, rkeys[14]);
+}
+
+/* the counter block of npub and ctr; n holds npub followed by zeros */
+static inline uint8x16_t
+aes_counter(uint8x16_t n, uint32_t ctr)
+{
+    return vreinterpretq_u8_u32(vsetq_lane_u32(__builtin_bswap32(ctr),
+                                               vreinterpretq_u32_u8(n), 3));
+}
+
+/* out = in ^ keystream from counter ctr on, for len bytes */
+static void
+aes_ctr_xor(unsigned char *out, const unsigned char *in, unsigned long long len,
+            uint8x16_t n, uint32_t ctr, const uint8x16_t *rkeys)
+{
+    unsigned char      pad[16];
+    uint8x16_t         b0, b1, b2, b3;
+    unsigned long long i;
+    int                r;
+
+    for (i = 0; i + 64 <= len; i += 64, ctr += 4) {
+        b0 = aes_counter(n, ctr);
+        b1 = aes_counter(n, ctr + 1);
+        b2 = aes_counter(n, ctr + 2);
+        b3 = aes_counter(n, ctr + 3);
+        for (r = 0; r < 13; r++) {
+            b0 = vaesmcq_u8(vaeseq_u8(b0, rkeys[r]));
+            b1 = vaesmcq_u8(vaeseq_u8(b1, rkeys[r]));
+            b2 = vaesmcq_u8(vaeseq_u8(b2, rkeys[r]));
+            b3 = vaesmcq_u8(vaeseq_u8(b3, rkeys[r]));
+        }
+        b0 = veorq_u8(vaeseq_u8(b0, rkeys[13]), rkeys[14]);
+        b1 = veorq_u8(vaeseq_u8(b1, rkeys[13]), rkeys[14]);
+        b2 = veorq_u8(vaeseq_u8(b2, rkeys[13]), rkeys[14]);
+        b3 = veorq_u8(vaeseq_u8(b3, rkeys[13]), rkeys[14]);
+        vst1q_u8(out + i, veorq_u8(vld1q_u8(in + i), b0));
+        vst1q_u8(out + i + 16, veorq_u8(vld1q_u8(in + i + 16), b1));
+        vst1q_u8(out + i + 32, veorq_u8(vld1q_u8(in + i + 32), b2));
+        vst1q_u8(out + i + 48, veorq_u8(vld1q_u8(in + i + 48), b3));
+    }
+    for (; i + 16 <= len; i += 16, ctr++) {
+        b0 = aes_encrypt1(aes_counter(n, ctr), rkeys);
+        vst1q_u8(out + i, veorq_u8(vld1q_u8(in + i), b0));
+    }
+    if (i < len) {
+        memset(pad, 0, sizeof pad);
+        memcpy(pad, in + i, (size_t) (len - i));
+        b0 = aes_encrypt1(aes_counter(n, ctr), rkeys);
+        vst1q_u8(pad, veorq_u8(vld1q_u8(pad), b0));
+        memcpy(out + i, pad, (size_t) (len - i));
+    }
+}
+
+/* a block as a bit-reflected field element: its bytes in reverse order */
+static inline uint64x2_t
+gf_load(const unsigned char *p)
+{
+    const uint8x16_t b = vrev64q_u8(vld1q_u8(p));
+
+    return vreinterpretq_u64_u8(vextq_u8(b, b, 8));
+}
+
+static inline uint8x16_t
+gf_bytes(uint64x2_t x)
+{
+    const uint8x16_t b = vrev64q_u8(vreinterpretq_u8_u64(x));
+
+    return vextq_u8(b, b, 8);
+}
+
+static inline uint64x2_t
+pmull_lo(uint64x2_t a, uint64x2_t b)
+{
+    return vreinterpretq_u64_p128(vmull_p64((poly64_t) vgetq_lane_u64(a, 0),
+                                            (poly64_t) vgetq_lane_u64(b, 0)));
+}
+
+static inline uint64x2_t
+pmull_hi(uint64x2_t a, uint64x2_t b)
+{
+    return vreinterpretq_u64_p128(vmull_high_p64(vreinterpretq_p64_u64(a),
+                                                 vreinterpretq_p64_u64(b)));
+}
+
+/* lo, mid, hi += a * b, unreduced */
+static inline void
+gf_mul_acc(uint64x2_t *lo, uint64x2_t *mid, uint64x2_t *hi,
+           uint64x2_t a, uint64x2_t b)
+{
+    *lo  = veorq_u64(*lo, pmull_lo(a, b));
+    *hi  = veorq_u64(*hi, pmull_hi(a, b));
+    *mid = veorq_u64(*mid, veorq_u64(pmull_lo(vextq_u64(a, a, 1), b),
+                                     pmull_hi(vextq_u64(a, a, 1), b)));
+}
+
+/* the 256 bit product lo + mid * 2^64 + hi * 2^128, reduced */
+static inline uint64x2_t
+gf_reduce(uint64x2_t lo, uint64x2_t mid, uint64x2_t hi)
+{
+    const uint64x2_t zero = vdupq_n_u64(0);
+    uint64_t         x0, x1, x2, x3;
+    uint64_t         d, h0, h1;
+
+    lo = veorq_u64(lo, vextq_u64(zero, mid, 1));
+    hi = veorq_u64(hi, vextq_u64(mid, zero, 1));
+    x0 = vgetq_lane_u64(lo, 0);
+    x1 = vgetq_lane_u64(lo, 1);
+    x2 = vgetq_lane_u64(hi, 0);
+    x3 = vgetq_lane_u64(hi, 1);
+
+    /* the product of two reflected values is one bit short */
+    x3 = (x3 << 1) | (x2 >> 63);
+    x2 = (x2 << 1) | (x1 >> 63);
+    x1 = (x1 << 1) | (x0 >> 63);
+    x0 <<= 1;
+
+    d  = x1 ^ (x0 << 63) ^ (x0 << 62) ^ (x0 << 57);
+    h1 = d ^ (d >> 1) ^ (d >> 2) ^ (d >> 7);
+    h0 = x0 ^ ((x0 >> 1) | (d << 63)) ^ ((x0 >> 2) | (d << 62)) ^
+         ((x0 >> 7) | (d << 57));
+
+    return vcombine_u64(vcreate_u64(x2 ^ h0), vcreate_u64(x3 ^ h1));
+}
+
+static inline uint64x2_t
+gf_mul(uint64x2_t a, uint64x2_t b)
+{
+    uint64x2_t lo  = vdupq_n_u64(0);
+    uint64x2_t mid = vdupq_n_u64(0);
+    uint64x2_t hi  = vdupq_n_u64(0);
+
+    gf_mul_acc(&lo, &mid, &hi, a, b);
+
+    return gf_reduce(lo, mid, hi);
+}
+
+/* Hp[i] = H^(i + 1) */
+static void
+gf_powers(uint64x2_t Hp[4], const context *ctx)
+{
+    Hp[0] = gf_load(ctx->H);
+    Hp[1] = gf_mul(Hp[0], Hp[0]);
+    Hp[2] = gf_mul(Hp[1], Hp[0]);
+    Hp[3] = gf_mul(Hp[2], Hp[0]);
+}
+
+/* GHASH of x, zero padded to a whole number of blocks, into acc */
+static uint64x2_t
+ghash_update(uint64x2_t acc, const unsigned char *x, unsigned long long xlen,
+             const uint64x2_t Hp[4])
+{
+    unsigned char      pad[16];
+    uint64x2_t         lo, mid, hi;
+    unsigned long long i;
+
+    for (i = 0; i + 64 <= xlen; i += 64) {
+        lo = mid = hi = vdupq_n_u64(0);
+        gf_mul_acc(&lo, &mid, &hi, veorq_u64(acc, gf_load(x + i)), Hp[3]);
+        gf_mul_acc(&lo, &mid, &hi, gf_load(x + i + 16), Hp[2]);
+        gf_mul_acc(&lo, &mid, &hi, gf_load(x + i + 32), Hp[1]);
+        gf_mul_acc(&lo, &mid, &hi, gf_load(x + i + 48), Hp[0]);
+        acc = gf_reduce(lo, mid, hi);
+    }
+    for (; i + 16 <= xlen; i += 16) {
+        acc = gf_mul(veorq_u64(acc, gf_load(x + i)), Hp[0]);
+    }
+    if (i < xlen) {
+        memset(pad, 0, sizeof pad);
+        memcpy(pad, x + i, (size_t) (xlen - i));
+        acc = gf_mul(veorq_u64(acc, gf_load(pad)), Hp[0]);
+    }
+    return acc;
+}
+
+/* the tag, from GHASH of everything but the length block, and T */
+static void
+gcm_final(unsigned char *mac, uint64x2_t acc, unsigned long long adlen,
+          unsigned long long mlen, uint8x16_t T, const uint64x2_t Hp[4])
+{
+    const uint64x2_t lengths = vcombine_u64(vcreate_u64((uint64_t) (8 * mlen)),
+                                            vcreate_u64((uint64_t) (8 * adlen)));
+
+    acc = gf_mul(veorq_u64(acc, lengths), Hp[0]);
+    vst1q_u8(mac, veorq_u8(T, gf_bytes(acc)));
+}
+
+static inline uint8x16_t
+gcm_nonce(const unsigned char *npub)
+{
+    CRYPTO_ALIGN(16) unsigned char n[16];
+
+    memcpy(n, npub, 12);
+    memset(n + 12, 0, 4);
+
+    return vld1q_u8(n);
+}
+
+int
+crypto_aead_aes256gcm_beforenm(crypto_aead_aes256gcm_state *ctx_,
+                               const unsigned char *k)
+{
+    context *ctx = (context *) ctx_;
+
+    COMPILER_ASSERT((sizeof *ctx_) >= (sizeof *ctx));
+    aes256_key_expand(k, ctx->rkeys);
+    vst1q_u8(ctx->H, aes_encrypt1(vdupq_n_u8(0), ctx->rkeys));
+
+    return 0;
+}
+
+int
+crypto_aead_aes256gcm_encrypt_detached_afternm(unsigned char *c,
+                                               unsigned char *mac, unsigned long long *maclen_p,
+                                               const unsigned char *m, unsigned long long mlen,
+                                               const unsigned char *ad, unsigned long long adlen,
+                                               const unsigned char *nsec,
+                                               const unsigned char *npub,
+                                               const crypto_aead_aes256gcm_state *ctx_)
+{
+    const context     *ctx = (const context *) ctx_;
+    const uint8x16_t   n = gcm_nonce(npub);
+    uint64x2_t         Hp[4];
+    uint64x2_t         acc = vdupq_n_u64(0);
+    uint8x16_t         T;
+    unsigned long long i;
+    unsigned long long len;
+
+    (void) nsec;
+    if (mlen > crypto_aead_aes256gcm_MESSAGEBYTES_MAX) {
+        sodium_misuse(); /* LCOV_EXCL_LINE */
+    }
+    gf_powers(Hp, ctx);
+    T = aes_encrypt1(aes_counter(n, 1U), ctx->rkeys);
+
+    acc = ghash_update(acc, ad, adlen, Hp);
+    for (i = 0; i < mlen; i += len) {
+        len = mlen - i < CHUNK_BYTES ? mlen - i : CHUNK_BYTES;
+        aes_ctr_xor(c + i, m + i, len, n, (uint32_t) (2U + i / 16), ctx->rkeys);
+        acc = ghash_update(acc, c + i, len, Hp);
+    }
+    gcm_final(mac, acc, adlen, mlen, T, Hp);
+
+    if (maclen_p != NULL) {
+        *maclen_p = 16;
+    }
+    return 0;
+}
+
+int
+crypto_aead_aes256gcm_encrypt_afternm(unsigned char *c, unsigned long long *clen_p,
+                                      const unsigned char *m, unsigned long long mlen,
+                                      const unsigned char *ad, unsigned long long adlen,
+                                      const unsigned char *nsec,
+                                      const unsigned char *npub,
+                                      const crypto_aead_aes256gcm_state *ctx_)
+{
+    int ret = crypto_aead_aes256gcm_encrypt_detached_afternm(c,
+                                                             c + mlen, NULL,
+                                                             m, mlen,
+                                                             ad, adlen,
+                                                             nsec, npub, ctx_);
+    if (clen_p != NULL) {
+        *clen_p = mlen + crypto_aead_aes256gcm_ABYTES;
+    }
+    return ret;
+}
+
+int
+crypto_aead_aes256gcm_decrypt_detached_afternm(unsigned char *m, unsigned char *nsec,
+                                               const unsigned char *c, unsigned long long clen,
+                                               const unsigned char *mac,
+                                               const unsigned char *ad, unsigned long long adlen,
+                                               const unsigned char *npub,
+                                               const crypto_aead_aes256gcm_state *ctx_)
+{
+    const context     *ctx = (const context *) ctx_;
+    const uint8x16_t   n = gcm_nonce(npub);
+    uint64x2_t         Hp[4];
+    uint64x2_t         acc = vdupq_n_u64(0);
+    uint8x16_t         T;
+    unsigned long long mlen;
+    CRYPTO_ALIGN(16) unsigned char computed_mac[16];
+
+    (void) nsec;
+    if (clen > crypto_aead_aes256gcm_MESSAGEBYTES_MAX) {
+        sodium_misuse(); /* LCOV_EXCL_LINE */
+    }
+    mlen = clen;
+    gf_powers(Hp, ctx);
+    T = aes_encrypt1(aes_counter(n, 1U), ctx->rkeys);
+
+    acc = ghash_update(acc, ad, adlen, Hp);
+    acc = ghash_update(acc, c, mlen, Hp);
+    gcm_final(computed_mac, acc, adlen, mlen, T, Hp);
+
+    if (crypto_verify_16(computed_mac, mac) != 0) {
+        if (m != NULL) {
+            memset(m, 0, mlen);
+        }
+        return -1;
+    }
+    if (m == NULL) {
+        return 0;
+    }
+    aes_ctr_xor(m, c, mlen, n, 2U, ctx->rkeys);
+
+    return 0;
+}
+
+int
+crypto_aead_aes256gcm_decrypt_afternm(unsigned char *m, unsigned long long *mlen_p,
+                                      unsigned char *nsec,
+                                      const unsigned char *c, unsigned long long clen,
+                                      const unsigned char *ad, unsigned long long adlen,
+                                      const unsigned char *npub,
+                                      const crypto_aead_aes256gcm_state *ctx_)
+{
+    unsigned long long mlen = 0ULL;
+    int                ret = -1;
+
+    if (clen >= crypto_aead_aes256gcm_ABYTES) {
+        ret = crypto_aead_aes256gcm_decrypt_detached_afternm
+            (m, nsec, c, clen - crypto_aead_aes256gcm_ABYTES,
+             c + clen - crypto_aead_aes256gcm_ABYTES,
+             ad, adlen, npub, ctx_);
+    }
+    if (mlen_p != NULL) {
+        if (ret == 0) {
+            mlen = clen - crypto_aead_aes256gcm_ABYTES;
+        }
+        *mlen_p = mlen;
+    }
+    return ret;
+}
+
+int
+crypto_aead_aes256gcm_encrypt_detached(unsigned char *c,
+                                       unsigned char *mac,
+                                       unsigned long long *maclen_p,
+                                       const unsigned char *m,
+                                       unsigned long long mlen,
+                                       const unsigned char *ad,
+                                       unsigned long long adlen,
+                                       const unsigned char *nsec,
+                                       const unsigned char *npub,
+                                       const unsigned char *k)
+{
+    CRYPTO_ALIGN(16) crypto_aead_aes256gcm_state ctx;
+    int ret;
+
+    crypto_aead_aes256gcm_beforenm(&ctx, k);
+
+    ret = crypto_aead_aes256gcm_encrypt_detached_afternm
+        (c, mac, maclen_p, m, mlen, ad, adlen, nsec, npub,
+            (const crypto_aead_aes256gcm_state *) &ctx);
+    sodium_memzero(ctx, sizeof ctx);
+
+    return ret;
+}
+
+int
+crypto_aead_aes256gcm_encrypt(unsigned char *c,
+                              unsigned long long *clen_p,
+                              const unsigned char *m,
+                              unsigned long long mlen,
+                              const unsigned char *ad,
+                              unsigned long long adlen,
+                              const unsigned char *nsec,
+                              const unsigned char *npub,
+                              const unsigned char *k)
+{
+    CRYPTO_ALIGN(16) crypto_aead_aes256gcm_state ctx;
+    int ret;
+
+    crypto_aead_aes256gcm_beforenm(&ctx, k);
+
+    ret = crypto_aead_aes256gcm_encrypt_afternm
+        (c, clen_p, m, mlen, ad, adlen, nsec, npub,
+            (const crypto_aead_aes256gcm_state *) &ctx);
+    sodium_memzero(ctx, sizeof ctx);
+
+    return ret;
+}
+
+int
+crypto_aead_aes256gcm_decrypt_detached(unsigned char *m,
+                                       unsigned char *nsec,
+                                       const unsigned char *c,
+                                       unsigned long long clen,
+                                       const unsigned char *mac,
+                                       const unsigned char *ad,
+                                       unsigned long long adlen,
+                                       const unsigned char *npub,
+                                       const unsigned char *k)
+{
+    CRYPTO_ALIGN(16) crypto_aead_aes256gcm_state ctx;
+    int ret;
+
+    crypto_aead_aes256gcm_beforenm(&ctx, k);
+
+    ret = crypto_aead_aes256gcm_decrypt_detached_afternm
+        (m, nsec, c, clen, mac, ad, adlen, npub,
+            (const crypto_aead_aes256gcm_state *) &ctx);
+    sodium_memzero(ctx, sizeof ctx);
+
+    return ret;
+}
+
+int
+crypto_aead_aes256gcm_decrypt(unsigned char *m,
+                              unsigned long long *mlen_p,
+                              unsigned char *nsec,
+                              const unsigned char *c,
+                              unsigned long long clen,
+                              const unsigned char *ad,
+                              unsigned long long adlen,
+                              const unsigned char *npub,
+                              const unsigned char *k)
+{
+    CRYPTO_ALIGN(16) crypto_aead_aes256gcm_state ctx;
+    int ret;
+
+    crypto_aead_aes256gcm_beforenm(&ctx, k);
+
+    ret = crypto_aead_aes256gcm_decrypt_afternm
+        (m, mlen_p, nsec, c, clen, ad, adlen, npub,
+         (const crypto_aead_aes256gcm_state *) &ctx);
+    sodium_memzero(ctx, sizeof ctx);
+
+    return ret;
+}
+
+/*
+ * The batch API of the AES-NI implementation, one message at a time: the
+ * powers of H are cheap to recompute here, and aes_ctr_xor() already keeps
+ * 4 blocks in flight.
+ */
+int
+crypto_aead_aes256gcm_encrypt_multi_afternm(unsigned char * const *c,
+                                            const unsigned char * const *m,
+                                            const unsigned long long *mlen,
+                                            const unsigned char * const *ad,
+                                            const unsigned long long *adlen,
+                                            const unsigned char * const *npub,
+                                            size_t n,
+                                            const crypto_aead_aes256gcm_state *ctx_)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        crypto_aead_aes256gcm_encrypt_afternm(c[i], NULL, m[i], mlen[i],
+                                              ad[i], adlen[i], NULL, npub[i], ctx_);
+    }
+    return 0;
+}
+
+int
+crypto_aead_aes256gcm_decrypt_multi_afternm(unsigned char *ok,
+                                            unsigned char * const *m,
+                                            const unsigned char * const *c,
+                                            const unsigned long long *clen,
+                                            const unsigned char * const *ad,
+                                            const unsigned long long *adlen,
+                                            const unsigned char * const *npub,
+                                            size_t n,
+                                            const crypto_aead_aes256gcm_state *ctx_)
+{
+    size_t i;
+    int    ret = 0;
+
+    for (i = 0; i < n; i++) {
+        ok[i] = crypto_aead_aes256gcm_decrypt_afternm(m[i], NULL, NULL,
+                                                      c[i], clen[i],
+                                                      ad[i], adlen[i],
+                                                      npub[i], ctx_) == 0;
+        ret |= ok[i] ? 0 : -1;
+    }
+    return ret;
+}
+
+int
+crypto_aead_aes256gcm_encrypt_blocks_afternm(unsigned char *out,
+                                             const unsigned char *in,
+                                             size_t nblocks,
+                                             const crypto_aead_aes256gcm_state *ctx_)
+{
+    const context *ctx = (const context *) ctx_;
+    size_t         i;
+
+    for (i = 0; i < nblocks; i++) {
+        vst1q_u8(out + i * 16, aes_encrypt1(vld1q_u8(in + i * 16), ctx->rkeys));
+    }
+    return 0;
+}
+
+int
+crypto_aead_aes256gcm_is_available(void)
+{
+    return sodium_runtime_has_armcrypto();
+}
+
+# ifdef __clang__
+#  pragma clang attribute pop
+# endif
+
+#endif
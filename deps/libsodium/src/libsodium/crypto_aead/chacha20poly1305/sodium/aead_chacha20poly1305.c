@@ -10,8 +10,10 @@
 #include "crypto_stream_chacha20.h"
 #include "crypto_verify_16.h"
 #include "randombytes.h"
+#include "runtime.h"
 #include "utils.h"
 
+#include "private/chacha20poly1305_multi.h"
 #include "private/common.h"
 
 static const unsigned char _pad0[16] = { 0 };
@@ -326,6 +328,211 @@ crypto_aead_chacha20poly1305_ietf_decrypt(unsigned char *m,
     return ret;
 }
 
+/*
+ * Many IETF messages in one call. On CPUs with AVX2, messages up to
+ * CHACHA20POLY1305_MULTI_MAXBYTES go through the multi-buffer kernel,
+ * 8 at a time; the other ones are sealed and opened one by one.
+ */
+
+#if defined(HAVE_AVX2INTRIN_H) && defined(HAVE_EMMINTRIN_H) && \
+    defined(HAVE_TMMINTRIN_H) && defined(HAVE_SMMINTRIN_H)
+# define HAVE_MULTI_AVX2
+
+typedef struct multi_batch {
+    unsigned char       *mac[CHACHA20POLY1305_MULTI_MAX];
+    unsigned char       *out[CHACHA20POLY1305_MULTI_MAX];
+    const unsigned char *in[CHACHA20POLY1305_MULTI_MAX];
+    unsigned long long   inlen[CHACHA20POLY1305_MULTI_MAX];
+    const unsigned char *ad[CHACHA20POLY1305_MULTI_MAX];
+    unsigned long long   adlen[CHACHA20POLY1305_MULTI_MAX];
+    const unsigned char *npub[CHACHA20POLY1305_MULTI_MAX];
+    const unsigned char *k[CHACHA20POLY1305_MULTI_MAX];
+    size_t               index[CHACHA20POLY1305_MULTI_MAX];
+    unsigned char        tag[CHACHA20POLY1305_MULTI_MAX][16];
+    size_t               count;
+} multi_batch;
+
+static void
+multi_batch_add(multi_batch *batch, size_t i, unsigned char *out,
+                const unsigned char *in, unsigned long long inlen,
+                const unsigned char *ad, unsigned long long adlen,
+                const unsigned char *npub, const unsigned char *k)
+{
+    const size_t j = batch->count++;
+
+    batch->index[j] = i;
+    batch->mac[j] = batch->tag[j];
+    batch->out[j] = out;
+    batch->in[j] = in;
+    batch->inlen[j] = inlen;
+    batch->ad[j] = ad;
+    batch->adlen[j] = adlen;
+    batch->npub[j] = npub;
+    batch->k[j] = k;
+}
+
+static void
+multi_batch_run(multi_batch *batch, int decrypt)
+{
+    _crypto_aead_chacha20poly1305_ietf_multi_avx2
+        (batch->mac, batch->out, batch->in, batch->inlen, batch->ad,
+         batch->adlen, batch->npub, batch->k, batch->count, decrypt);
+}
+#endif
+
+/* n is at most CHACHA20POLY1305_MULTI_MAX */
+int
+_crypto_aead_chacha20poly1305_ietf_encrypt_multi(unsigned char * const *c,
+                                                 const unsigned char * const *m,
+                                                 const unsigned long long *mlen,
+                                                 const unsigned char * const *ad,
+                                                 const unsigned long long *adlen,
+                                                 const unsigned char * const *npub,
+                                                 const unsigned char * const *k,
+                                                 size_t n)
+{
+#ifdef HAVE_MULTI_AVX2
+    multi_batch batch;
+    const int   multi = sodium_runtime_has_avx2();
+#endif
+    size_t      i;
+
+#ifdef HAVE_MULTI_AVX2
+    batch.count = 0;
+#endif
+    for (i = 0; i < n; i++) {
+#ifdef HAVE_MULTI_AVX2
+        if (multi && mlen[i] <= CHACHA20POLY1305_MULTI_MAXBYTES) {
+            multi_batch_add(&batch, i, c[i], m[i], mlen[i], ad[i], adlen[i],
+                            npub[i], k[i]);
+            batch.mac[batch.count - 1] = c[i] + mlen[i];
+            continue;
+        }
+#endif
+        crypto_aead_chacha20poly1305_ietf_encrypt(c[i], NULL, m[i], mlen[i],
+                                                  ad[i], adlen[i], NULL,
+                                                  npub[i], k[i]);
+    }
+#ifdef HAVE_MULTI_AVX2
+    if (batch.count > 0) {
+        multi_batch_run(&batch, 0);
+    }
+#endif
+    return 0;
+}
+
+/* n is at most CHACHA20POLY1305_MULTI_MAX */
+int
+_crypto_aead_chacha20poly1305_ietf_decrypt_multi(unsigned char *ok,
+                                                 unsigned char * const *m,
+                                                 const unsigned char * const *c,
+                                                 const unsigned long long *clen,
+                                                 const unsigned char * const *ad,
+                                                 const unsigned long long *adlen,
+                                                 const unsigned char * const *npub,
+                                                 const unsigned char * const *k,
+                                                 size_t n)
+{
+#ifdef HAVE_MULTI_AVX2
+    multi_batch        batch;
+    const int          multi = sodium_runtime_has_avx2();
+    size_t             index;
+    size_t             j;
+    unsigned long long mlen;
+#endif
+    size_t             i;
+    int                ret = 0;
+
+#ifdef HAVE_MULTI_AVX2
+    batch.count = 0;
+#endif
+    for (i = 0; i < n; i++) {
+#ifdef HAVE_MULTI_AVX2
+        if (multi && clen[i] >= crypto_aead_chacha20poly1305_ietf_ABYTES &&
+            clen[i] - crypto_aead_chacha20poly1305_ietf_ABYTES <= CHACHA20POLY1305_MULTI_MAXBYTES) {
+            multi_batch_add(&batch, i, m[i], c[i],
+                            clen[i] - crypto_aead_chacha20poly1305_ietf_ABYTES,
+                            ad[i], adlen[i], npub[i], k[i]);
+            continue;
+        }
+#endif
+        ok[i] = crypto_aead_chacha20poly1305_ietf_decrypt(m[i], NULL, NULL, c[i],
+                                                          clen[i], ad[i], adlen[i],
+                                                          npub[i], k[i]) == 0;
+        if (!ok[i]) {
+            ret = -1;
+        }
+    }
+#ifdef HAVE_MULTI_AVX2
+    if (batch.count > 0) {
+        multi_batch_run(&batch, 1);
+        for (j = 0; j < batch.count; j++) {
+            index = batch.index[j];
+            mlen = batch.inlen[j];
+            ok[index] = crypto_verify_16(batch.tag[j], c[index] + mlen) == 0;
+            if (!ok[index]) {
+                memset(m[index], 0, mlen);
+                ret = -1;
+            }
+        }
+        sodium_memzero(batch.tag, sizeof batch.tag);
+    }
+#endif
+    return ret;
+}
+
+int
+crypto_aead_chacha20poly1305_ietf_encrypt_multi(unsigned char * const *c,
+                                                const unsigned char * const *m,
+                                                const unsigned long long *mlen,
+                                                const unsigned char * const *ad,
+                                                const unsigned long long *adlen,
+                                                const unsigned char * const *npub,
+                                                size_t n,
+                                                const unsigned char *k)
+{
+    const unsigned char *keys[CHACHA20POLY1305_MULTI_MAX];
+    size_t               count;
+    size_t               i;
+
+    for (i = 0; i < CHACHA20POLY1305_MULTI_MAX; i++) {
+        keys[i] = k;
+    }
+    for (i = 0; i < n; i += count) {
+        count = n - i < CHACHA20POLY1305_MULTI_MAX ? n - i : CHACHA20POLY1305_MULTI_MAX;
+        _crypto_aead_chacha20poly1305_ietf_encrypt_multi
+            (c + i, m + i, mlen + i, ad + i, adlen + i, npub + i, keys, count);
+    }
+    return 0;
+}
+
+int
+crypto_aead_chacha20poly1305_ietf_decrypt_multi(unsigned char *ok,
+                                                unsigned char * const *m,
+                                                const unsigned char * const *c,
+                                                const unsigned long long *clen,
+                                                const unsigned char * const *ad,
+                                                const unsigned long long *adlen,
+                                                const unsigned char * const *npub,
+                                                size_t n,
+                                                const unsigned char *k)
+{
+    const unsigned char *keys[CHACHA20POLY1305_MULTI_MAX];
+    size_t               count;
+    size_t               i;
+    int                  ret = 0;
+
+    for (i = 0; i < CHACHA20POLY1305_MULTI_MAX; i++) {
+        keys[i] = k;
+    }
+    for (i = 0; i < n; i += count) {
+        count = n - i < CHACHA20POLY1305_MULTI_MAX ? n - i : CHACHA20POLY1305_MULTI_MAX;
+        ret |= _crypto_aead_chacha20poly1305_ietf_decrypt_multi
+            (ok + i, m + i, c + i, clen + i, ad + i, adlen + i, npub + i, keys, count);
+    }
+    return ret;
+}
+
 size_t
 crypto_aead_chacha20poly1305_ietf_keybytes(void)
 {
@@ -11,6 +11,7 @@
 #include "randombytes.h"
 #include "utils.h"
 
+#include "private/chacha20poly1305_multi.h"
 #include "private/common.h"
 
 int
@@ -123,6 +124,84 @@ crypto_aead_xchacha20poly1305_ietf_decrypt(unsigned char *m,
     return ret;
 }
 
+/* Many messages in one call, as crypto_aead_chacha20poly1305_ietf_*_multi() */
+static void
+multi_subkeys(unsigned char (*k2)[crypto_core_hchacha20_OUTPUTBYTES],
+              unsigned char (*npub2)[crypto_aead_chacha20poly1305_ietf_NPUBBYTES],
+              const unsigned char **k2p, const unsigned char **npub2p,
+              const unsigned char * const *npub, size_t n,
+              const unsigned char *k)
+{
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        crypto_core_hchacha20(k2[i], npub[i], k, NULL);
+        memset(npub2[i], 0, 4);
+        memcpy(npub2[i] + 4, npub[i] + crypto_core_hchacha20_INPUTBYTES,
+               crypto_aead_chacha20poly1305_ietf_NPUBBYTES - 4);
+        k2p[i] = k2[i];
+        npub2p[i] = npub2[i];
+    }
+}
+
+int
+crypto_aead_xchacha20poly1305_ietf_encrypt_multi(unsigned char * const *c,
+                                                 const unsigned char * const *m,
+                                                 const unsigned long long *mlen,
+                                                 const unsigned char * const *ad,
+                                                 const unsigned long long *adlen,
+                                                 const unsigned char * const *npub,
+                                                 size_t n,
+                                                 const unsigned char *k)
+{
+    unsigned char        k2[CHACHA20POLY1305_MULTI_MAX][crypto_core_hchacha20_OUTPUTBYTES];
+    unsigned char        npub2[CHACHA20POLY1305_MULTI_MAX][crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    const unsigned char *k2p[CHACHA20POLY1305_MULTI_MAX];
+    const unsigned char *npub2p[CHACHA20POLY1305_MULTI_MAX];
+    size_t               count;
+    size_t               i;
+
+    for (i = 0; i < n; i += count) {
+        count = n - i < CHACHA20POLY1305_MULTI_MAX ? n - i : CHACHA20POLY1305_MULTI_MAX;
+        multi_subkeys(k2, npub2, k2p, npub2p, npub + i, count, k);
+        _crypto_aead_chacha20poly1305_ietf_encrypt_multi
+            (c + i, m + i, mlen + i, ad + i, adlen + i, npub2p, k2p, count);
+    }
+    sodium_memzero(k2, sizeof k2);
+
+    return 0;
+}
+
+int
+crypto_aead_xchacha20poly1305_ietf_decrypt_multi(unsigned char *ok,
+                                                 unsigned char * const *m,
+                                                 const unsigned char * const *c,
+                                                 const unsigned long long *clen,
+                                                 const unsigned char * const *ad,
+                                                 const unsigned long long *adlen,
+                                                 const unsigned char * const *npub,
+                                                 size_t n,
+                                                 const unsigned char *k)
+{
+    unsigned char        k2[CHACHA20POLY1305_MULTI_MAX][crypto_core_hchacha20_OUTPUTBYTES];
+    unsigned char        npub2[CHACHA20POLY1305_MULTI_MAX][crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    const unsigned char *k2p[CHACHA20POLY1305_MULTI_MAX];
+    const unsigned char *npub2p[CHACHA20POLY1305_MULTI_MAX];
+    size_t               count;
+    size_t               i;
+    int                  ret = 0;
+
+    for (i = 0; i < n; i += count) {
+        count = n - i < CHACHA20POLY1305_MULTI_MAX ? n - i : CHACHA20POLY1305_MULTI_MAX;
+        multi_subkeys(k2, npub2, k2p, npub2p, npub + i, count, k);
+        ret |= _crypto_aead_chacha20poly1305_ietf_decrypt_multi
+            (ok + i, m + i, c + i, clen + i, ad + i, adlen + i, npub2p, k2p, count);
+    }
+    sodium_memzero(k2, sizeof k2);
+
+    return ret;
+}
+
 size_t
 crypto_aead_xchacha20poly1305_ietf_keybytes(void)
 {
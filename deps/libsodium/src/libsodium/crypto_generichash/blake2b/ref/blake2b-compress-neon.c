@@ -0,0 +1,99 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "blake2.h"
+#include "private/common.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(USE_ARM64_KERNELS)
+
+# include <arm_neon.h>
+
+# include "blake2b-compress-neon.h"
+
+/*
+ * The SSSE3 compression function on NEON: each row of the state is split
+ * in a low and a high vector of 2 words, the byte rotations are table
+ * lookups, and the diagonalization moves words with vext.
+ */
+
+CRYPTO_ALIGN(64)
+static const uint64_t blake2b_IV[8] = {
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL,
+    0xa54ff53a5f1d36f1ULL, 0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+static const uint8_t blake2b_sigma[12][16] = {
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 },
+    { 11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4 },
+    { 7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8 },
+    { 9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13 },
+    { 2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9 },
+    { 12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11 },
+    { 13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10 },
+    { 6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5 },
+    { 10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0 },
+    { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 },
+    { 14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3 }
+};
+
+static const uint8_t blake2b_r16[16] = {
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9
+};
+
+static const uint8_t blake2b_r24[16] = {
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10
+};
+
+int
+blake2b_compress_neon(blake2b_state *S,
+                      const uint8_t  block[BLAKE2B_BLOCKBYTES])
+{
+    uint64x2_t       row1l, row1h;
+    uint64x2_t       row2l, row2h;
+    uint64x2_t       row3l, row3h;
+    uint64x2_t       row4l, row4h;
+    uint64x2_t       b0, b1;
+    uint64x2_t       t0, t1;
+    const uint8x16_t r16 = vld1q_u8(blake2b_r16);
+    const uint8x16_t r24 = vld1q_u8(blake2b_r24);
+    uint64_t         m[16];
+    int              i;
+
+    for (i = 0; i < 16; i++) {
+        m[i] = LOAD64_LE(block + i * sizeof m[0]);
+    }
+    row1l = LOADU(&S->h[0]);
+    row1h = LOADU(&S->h[2]);
+    row2l = LOADU(&S->h[4]);
+    row2h = LOADU(&S->h[6]);
+    row3l = LOADU(&blake2b_IV[0]);
+    row3h = LOADU(&blake2b_IV[2]);
+    row4l = veorq_u64(LOADU(&blake2b_IV[4]), LOADU(&S->t[0]));
+    row4h = veorq_u64(LOADU(&blake2b_IV[6]), LOADU(&S->f[0]));
+    ROUND(0);
+    ROUND(1);
+    ROUND(2);
+    ROUND(3);
+    ROUND(4);
+    ROUND(5);
+    ROUND(6);
+    ROUND(7);
+    ROUND(8);
+    ROUND(9);
+    ROUND(10);
+    ROUND(11);
+    row1l = veorq_u64(row3l, row1l);
+    row1h = veorq_u64(row3h, row1h);
+    STOREU(&S->h[0], veorq_u64(LOADU(&S->h[0]), row1l));
+    STOREU(&S->h[2], veorq_u64(LOADU(&S->h[2]), row1h));
+    row2l = veorq_u64(row4l, row2l);
+    row2h = veorq_u64(row4h, row2h);
+    STOREU(&S->h[4], veorq_u64(LOADU(&S->h[4]), row2l));
+    STOREU(&S->h[6], veorq_u64(LOADU(&S->h[6]), row2h));
+    return 0;
+}
+
+#endif
@@ -0,0 +1,105 @@
+
+#ifndef blake2b_compress_neon_H
+#define blake2b_compress_neon_H
+
+#define LOADU(p) vld1q_u64((const uint64_t *) (const void *) (p))
+#define STOREU(p, r) vst1q_u64((uint64_t *) (void *) (p), r)
+
+/* rotations right by 32, 24, 16 and 63 bits */
+#define vrorq_n_u64_32(x) vreinterpretq_u64_u32(vrev64q_u32(vreinterpretq_u32_u64(x)))
+#define vrorq_n_u64_24(x) \
+    vreinterpretq_u64_u8(vqtbl1q_u8(vreinterpretq_u8_u64(x), r24))
+#define vrorq_n_u64_16(x) \
+    vreinterpretq_u64_u8(vqtbl1q_u8(vreinterpretq_u8_u64(x), r16))
+#define vrorq_n_u64_63(x) veorq_u64(vaddq_u64((x), (x)), vshrq_n_u64((x), 63))
+
+#define G1(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h, b0, b1) \
+    row1l = vaddq_u64(vaddq_u64(row1l, b0), row2l);                        \
+    row1h = vaddq_u64(vaddq_u64(row1h, b1), row2h);                        \
+                                                                           \
+    row4l = veorq_u64(row4l, row1l);                                       \
+    row4h = veorq_u64(row4h, row1h);                                       \
+                                                                           \
+    row4l = vrorq_n_u64_32(row4l);                                         \
+    row4h = vrorq_n_u64_32(row4h);                                         \
+                                                                           \
+    row3l = vaddq_u64(row3l, row4l);                                       \
+    row3h = vaddq_u64(row3h, row4h);                                       \
+                                                                           \
+    row2l = veorq_u64(row2l, row3l);                                       \
+    row2h = veorq_u64(row2h, row3h);                                       \
+                                                                           \
+    row2l = vrorq_n_u64_24(row2l);                                         \
+    row2h = vrorq_n_u64_24(row2h);
+
+#define G2(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h, b0, b1) \
+    row1l = vaddq_u64(vaddq_u64(row1l, b0), row2l);                        \
+    row1h = vaddq_u64(vaddq_u64(row1h, b1), row2h);                        \
+                                                                           \
+    row4l = veorq_u64(row4l, row1l);                                       \
+    row4h = veorq_u64(row4h, row1h);                                       \
+                                                                           \
+    row4l = vrorq_n_u64_16(row4l);                                         \
+    row4h = vrorq_n_u64_16(row4h);                                         \
+                                                                           \
+    row3l = vaddq_u64(row3l, row4l);                                       \
+    row3h = vaddq_u64(row3h, row4h);                                       \
+                                                                           \
+    row2l = veorq_u64(row2l, row3l);                                       \
+    row2h = veorq_u64(row2h, row3h);                                       \
+                                                                           \
+    row2l = vrorq_n_u64_63(row2l);                                         \
+    row2h = vrorq_n_u64_63(row2h);
+
+#define DIAGONALIZE(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h) \
+    t0    = vextq_u64(row2l, row2h, 1);                                     \
+    t1    = vextq_u64(row2h, row2l, 1);                                     \
+    row2l = t0;                                                             \
+    row2h = t1;                                                             \
+                                                                            \
+    t0    = row3l;                                                          \
+    row3l = row3h;                                                          \
+    row3h = t0;                                                             \
+                                                                            \
+    t0    = vextq_u64(row4l, row4h, 1);                                     \
+    t1    = vextq_u64(row4h, row4l, 1);                                     \
+    row4l = t1;                                                             \
+    row4h = t0;
+
+#define UNDIAGONALIZE(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h) \
+    t0    = vextq_u64(row2h, row2l, 1);                                       \
+    t1    = vextq_u64(row2l, row2h, 1);                                       \
+    row2l = t0;                                                               \
+    row2h = t1;                                                               \
+                                                                              \
+    t0    = row3l;                                                            \
+    row3l = row3h;                                                            \
+    row3h = t0;                                                               \
+                                                                              \
+    t0    = vextq_u64(row4h, row4l, 1);                                       \
+    t1    = vextq_u64(row4l, row4h, 1);                                       \
+    row4l = t1;                                                               \
+    row4h = t0;
+
+/* message words sigma[r][A] and sigma[r][B] in the low and high lanes */
+#define LOAD_MSG(r, A, B) \
+    vcombine_u64(vcreate_u64(m[blake2b_sigma[r][A]]), \
+                 vcreate_u64(m[blake2b_sigma[r][B]]))
+
+#define ROUND(r)                                                         \
+    b0 = LOAD_MSG(r, 0, 2);                                              \
+    b1 = LOAD_MSG(r, 4, 6);                                              \
+    G1(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h, b0, b1);  \
+    b0 = LOAD_MSG(r, 1, 3);                                              \
+    b1 = LOAD_MSG(r, 5, 7);                                              \
+    G2(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h, b0, b1);  \
+    DIAGONALIZE(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h); \
+    b0 = LOAD_MSG(r, 8, 10);                                             \
+    b1 = LOAD_MSG(r, 12, 14);                                            \
+    G1(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h, b0, b1);  \
+    b0 = LOAD_MSG(r, 9, 11);                                             \
+    b1 = LOAD_MSG(r, 13, 15);                                            \
+    G2(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h, b0, b1);  \
+    UNDIAGONALIZE(row1l, row2l, row3l, row4l, row1h, row2h, row3h, row4h);
+
+#endif
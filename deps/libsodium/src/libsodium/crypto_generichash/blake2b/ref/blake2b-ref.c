@@ -428,6 +428,12 @@ blake2b_pick_best_implementation(void)
         blake2b_compress = blake2b_compress_ssse3;
         return 0;
     }
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(USE_ARM64_KERNELS)
+    if (sodium_runtime_has_neon()) {
+        blake2b_compress = blake2b_compress_neon;
+        return 0;
+    }
 #endif
     blake2b_compress = blake2b_compress_ref;
 
@@ -35,8 +35,13 @@
 
 #include "crypto_hash_sha256.h"
 #include "private/common.h"
+#include "private/implementations.h"
+#include "runtime.h"
 #include "utils.h"
 
+#include "sha256_armcrypto.h"
+#include "sha256_shani.h"
+
 static void
 be32enc_vect(unsigned char *dst, const uint32_t *src, size_t len)
 {
@@ -144,6 +149,23 @@ SHA256_Transform(uint32_t state[8], const uint8_t block[64], uint32_t W[64],
     }
 }
 
+static void
+SHA256_Blocks_ref(uint32_t state[8], const unsigned char *in,
+                  unsigned long long blocks)
+{
+    uint32_t tmp32[64 + 8];
+
+    while (blocks > 0) {
+        SHA256_Transform(state, in, &tmp32[0], &tmp32[64]);
+        in += 64;
+        blocks--;
+    }
+    sodium_memzero((void *) tmp32, sizeof tmp32);
+}
+
+static void (*SHA256_Blocks)(uint32_t state[8], const unsigned char *in,
+                             unsigned long long blocks) = SHA256_Blocks_ref;
+
 static const uint8_t PAD[64] = { 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
                                  0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
                                  0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
@@ -151,7 +173,7 @@ static const uint8_t PAD[64] = { 0x80, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
                                  0,    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
 
 static void
-SHA256_Pad(crypto_hash_sha256_state *state, uint32_t tmp32[64 + 8])
+SHA256_Pad(crypto_hash_sha256_state *state)
 {
     unsigned int r;
     unsigned int i;
@@ -165,11 +187,11 @@ SHA256_Pad(crypto_hash_sha256_state *state, uint32_t tmp32[64 + 8])
         for (i = 0; i < 64 - r; i++) {
             state->buf[r + i] = PAD[i];
         }
-        SHA256_Transform(state->state, state->buf, &tmp32[0], &tmp32[64]);
+        SHA256_Blocks(state->state, state->buf, 1);
         memset(&state->buf[0], 0, 56);
     }
     STORE64_BE(&state->buf[56], state->count);
-    SHA256_Transform(state->state, state->buf, &tmp32[0], &tmp32[64]);
+    SHA256_Blocks(state->state, state->buf, 1);
 }
 
 int
@@ -190,7 +212,6 @@ int
 crypto_hash_sha256_update(crypto_hash_sha256_state *state,
                           const unsigned char *in, unsigned long long inlen)
 {
-    uint32_t           tmp32[64 + 8];
     unsigned long long i;
     unsigned long long r;
 
@@ -209,20 +230,18 @@ crypto_hash_sha256_update(crypto_hash_sha256_state *state,
     for (i = 0; i < 64 - r; i++) {
         state->buf[r + i] = in[i];
     }
-    SHA256_Transform(state->state, state->buf, &tmp32[0], &tmp32[64]);
+    SHA256_Blocks(state->state, state->buf, 1);
     in += 64 - r;
     inlen -= 64 - r;
 
-    while (inlen >= 64) {
-        SHA256_Transform(state->state, in, &tmp32[0], &tmp32[64]);
-        in += 64;
-        inlen -= 64;
+    if (inlen >= 64) {
+        SHA256_Blocks(state->state, in, inlen / 64);
+        in += inlen & ~(unsigned long long) 63;
     }
     inlen &= 63;
     for (i = 0; i < inlen; i++) {
         state->buf[i] = in[i];
     }
-    sodium_memzero((void *) tmp32, sizeof tmp32);
 
     return 0;
 }
@@ -230,11 +249,8 @@ crypto_hash_sha256_update(crypto_hash_sha256_state *state,
 int
 crypto_hash_sha256_final(crypto_hash_sha256_state *state, unsigned char *out)
 {
-    uint32_t tmp32[64 + 8];
-
-    SHA256_Pad(state, tmp32);
+    SHA256_Pad(state);
     be32enc_vect(out, state->state, 32);
-    sodium_memzero((void *) tmp32, sizeof tmp32);
     sodium_memzero((void *) state, sizeof *state);
 
     return 0;
@@ -252,3 +268,23 @@ crypto_hash_sha256(unsigned char *out, const unsigned char *in,
 
     return 0;
 }
+
+int
+_crypto_hash_sha256_pick_best_implementation(void)
+{
+    SHA256_Blocks = SHA256_Blocks_ref;
+#if defined(HAVE_SHANI) && defined(HAVE_EMMINTRIN_H) && \
+    defined(HAVE_TMMINTRIN_H) && defined(HAVE_SMMINTRIN_H)
+    if (sodium_runtime_has_shani() && sodium_runtime_has_sse41()) {
+        SHA256_Blocks = crypto_hash_sha256_blocks_shani;
+        return 0;
+    }
+#endif
+#if defined(HAVE_ARMCRYPTO) && defined(__aarch64__)
+    if (sodium_runtime_has_armcrypto()) {
+        SHA256_Blocks = crypto_hash_sha256_blocks_armcrypto;
+        return 0;
+    }
+#endif
+    return 0;
+}
@@ -0,0 +1,99 @@
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "private/common.h"
+#include "sha256_armcrypto.h"
+
+#if defined(HAVE_ARMCRYPTO) && defined(__aarch64__)
+
+# ifdef __clang__
+#  pragma clang attribute push(__attribute__((target("neon,crypto"))), \
+                               apply_to = function)
+# elif defined(__GNUC__)
+#  pragma GCC target("+simd+crypto")
+# endif
+
+# include <arm_neon.h>
+
+/*
+ * SHA-256 compression with the ARMv8 SHA2 instructions: sha256h and
+ * sha256h2 do 4 rounds on the ABCD and EFGH halves of the state, and
+ * sha256su0/sha256su1 compute the message schedule 4 words at a time.
+ */
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* 4 rounds with the schedule words W */
+# define ARMCRYPTO_ROUNDS4(ABCD, EFGH, W, I)                    \
+    do {                                                       \
+        const uint32x4_t wk_   = vaddq_u32((W), vld1q_u32(&K[I])); \
+        const uint32x4_t abcd_ = (ABCD);                       \
+        (ABCD) = vsha256hq_u32((ABCD), (EFGH), wk_);           \
+        (EFGH) = vsha256h2q_u32((EFGH), abcd_, wk_);           \
+    } while (0)
+
+/* W0 = the next 4 schedule words, from W0 ... W3 */
+# define ARMCRYPTO_SCHEDULE(W0, W1, W2, W3)                          \
+    (W0) = vsha256su1q_u32(vsha256su0q_u32((W0), (W1)), (W2), (W3))
+
+void
+crypto_hash_sha256_blocks_armcrypto(uint32_t state[8], const unsigned char *in,
+                                    unsigned long long blocks)
+{
+    uint32x4_t abcd = vld1q_u32(&state[0]);
+    uint32x4_t efgh = vld1q_u32(&state[4]);
+    uint32x4_t abcd_save, efgh_save;
+    uint32x4_t w0, w1, w2, w3;
+    int        i;
+
+    while (blocks > 0) {
+        abcd_save = abcd;
+        efgh_save = efgh;
+
+        w0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(in + 0)));
+        w1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(in + 16)));
+        w2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(in + 32)));
+        w3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(in + 48)));
+
+        for (i = 0; i < 48; i += 16) {
+            ARMCRYPTO_ROUNDS4(abcd, efgh, w0, i);
+            ARMCRYPTO_SCHEDULE(w0, w1, w2, w3);
+            ARMCRYPTO_ROUNDS4(abcd, efgh, w1, i + 4);
+            ARMCRYPTO_SCHEDULE(w1, w2, w3, w0);
+            ARMCRYPTO_ROUNDS4(abcd, efgh, w2, i + 8);
+            ARMCRYPTO_SCHEDULE(w2, w3, w0, w1);
+            ARMCRYPTO_ROUNDS4(abcd, efgh, w3, i + 12);
+            ARMCRYPTO_SCHEDULE(w3, w0, w1, w2);
+        }
+        ARMCRYPTO_ROUNDS4(abcd, efgh, w0, 48);
+        ARMCRYPTO_ROUNDS4(abcd, efgh, w1, 52);
+        ARMCRYPTO_ROUNDS4(abcd, efgh, w2, 56);
+        ARMCRYPTO_ROUNDS4(abcd, efgh, w3, 60);
+
+        abcd = vaddq_u32(abcd, abcd_save);
+        efgh = vaddq_u32(efgh, efgh_save);
+        in += 64;
+        blocks--;
+    }
+    vst1q_u32(&state[0], abcd);
+    vst1q_u32(&state[4], efgh);
+}
+
+# ifdef __clang__
+#  pragma clang attribute pop
+# endif
+
+#endif
@@ -0,0 +1,124 @@
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "private/common.h"
+#include "sha256_shani.h"
+
+#if defined(HAVE_SHANI) && defined(HAVE_EMMINTRIN_H) && \
+    defined(HAVE_TMMINTRIN_H) && defined(HAVE_SMMINTRIN_H)
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("sha")
+# endif
+
+# include <emmintrin.h>
+# include <immintrin.h>
+# include <smmintrin.h>
+# include <tmmintrin.h>
+
+/*
+ * SHA-256 compression with the x86 SHA extensions. The state is kept as
+ * ABEF and CDGH, the layout sha256rnds2 works on; each sha256rnds2 does 2
+ * rounds, and sha256msg1/sha256msg2 compute the message schedule 4 words
+ * at a time.
+ */
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+/* 4 rounds with the schedule words W, state S0 = ABEF, S1 = CDGH */
+# define SHANI_ROUNDS4(S0, S1, W, I)                                        \
+    do {                                                                   \
+        __m128i wk_ = _mm_add_epi32(                                       \
+            (W), _mm_loadu_si128((const __m128i *) (const void *) &K[I])); \
+        (S1) = _mm_sha256rnds2_epu32((S1), (S0), wk_);                     \
+        wk_  = _mm_shuffle_epi32(wk_, 0x0e);                               \
+        (S0) = _mm_sha256rnds2_epu32((S0), (S1), wk_);                     \
+    } while (0)
+
+/* W0 = the next 4 schedule words, from W0 ... W3 */
+# define SHANI_SCHEDULE(W0, W1, W2, W3)                                 \
+    do {                                                               \
+        (W0) = _mm_sha256msg1_epu32((W0), (W1));                       \
+        (W0) = _mm_add_epi32((W0), _mm_alignr_epi8((W3), (W2), 4));    \
+        (W0) = _mm_sha256msg2_epu32((W0), (W3));                       \
+    } while (0)
+
+void
+crypto_hash_sha256_blocks_shani(uint32_t state[8], const unsigned char *in,
+                                unsigned long long blocks)
+{
+    const __m128i bswap =
+        _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i abef, cdgh, abef_save, cdgh_save;
+    __m128i w0, w1, w2, w3;
+    __m128i t;
+    int     i;
+
+    /* lanes listed from high to low: rnds2 wants ABEF and CDGH */
+    t    = _mm_loadu_si128((const __m128i *) (const void *) &state[0]); /* DCBA */
+    cdgh = _mm_loadu_si128((const __m128i *) (const void *) &state[4]); /* HGFE */
+    t    = _mm_shuffle_epi32(t, 0xb1);     /* CDAB */
+    cdgh = _mm_shuffle_epi32(cdgh, 0x1b);  /* EFGH */
+    abef = _mm_alignr_epi8(t, cdgh, 8);    /* ABEF */
+    cdgh = _mm_blend_epi16(cdgh, t, 0xf0); /* CDGH */
+
+    while (blocks > 0) {
+        abef_save = abef;
+        cdgh_save = cdgh;
+
+        w0 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *) (const void *) (in + 0)), bswap);
+        w1 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *) (const void *) (in + 16)), bswap);
+        w2 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *) (const void *) (in + 32)), bswap);
+        w3 = _mm_shuffle_epi8(
+            _mm_loadu_si128((const __m128i *) (const void *) (in + 48)), bswap);
+
+        SHANI_ROUNDS4(abef, cdgh, w0, 0);
+        SHANI_ROUNDS4(abef, cdgh, w1, 4);
+        SHANI_ROUNDS4(abef, cdgh, w2, 8);
+        SHANI_ROUNDS4(abef, cdgh, w3, 12);
+        for (i = 16; i < 64; i += 16) {
+            SHANI_SCHEDULE(w0, w1, w2, w3);
+            SHANI_ROUNDS4(abef, cdgh, w0, i);
+            SHANI_SCHEDULE(w1, w2, w3, w0);
+            SHANI_ROUNDS4(abef, cdgh, w1, i + 4);
+            SHANI_SCHEDULE(w2, w3, w0, w1);
+            SHANI_ROUNDS4(abef, cdgh, w2, i + 8);
+            SHANI_SCHEDULE(w3, w0, w1, w2);
+            SHANI_ROUNDS4(abef, cdgh, w3, i + 12);
+        }
+
+        abef = _mm_add_epi32(abef, abef_save);
+        cdgh = _mm_add_epi32(cdgh, cdgh_save);
+        in += 64;
+        blocks--;
+    }
+
+    /* back to DCBA and HGFE */
+    t    = _mm_shuffle_epi32(abef, 0x1b);  /* FEBA */
+    cdgh = _mm_shuffle_epi32(cdgh, 0xb1);  /* DCHG */
+    abef = _mm_blend_epi16(t, cdgh, 0xf0); /* DCBA */
+    cdgh = _mm_alignr_epi8(cdgh, t, 8);    /* HGFE */
+    _mm_storeu_si128((__m128i *) (void *) &state[0], abef);
+    _mm_storeu_si128((__m128i *) (void *) &state[4], cdgh);
+}
+
+#endif
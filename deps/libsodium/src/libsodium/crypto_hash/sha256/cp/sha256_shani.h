@@ -0,0 +1,10 @@
+#ifndef sha256_shani_H
+#define sha256_shani_H
+
+#include <stdint.h>
+
+void crypto_hash_sha256_blocks_shani(uint32_t state[8],
+                                     const unsigned char *in,
+                                     unsigned long long blocks);
+
+#endif
@@ -0,0 +1,534 @@
+
+#include <stdint.h>
+#include <string.h>
+
+#include "../onetimeauth_poly1305.h"
+#include "crypto_verify_16.h"
+#include "poly1305_avx2.h"
+#include "../sse2/poly1305_sse2.h"
+#include "private/common.h"
+#include "utils.h"
+
+#if defined(HAVE_AVX2INTRIN_H) && defined(HAVE_EMMINTRIN_H) && \
+    defined(HAVE_TMMINTRIN_H) && defined(HAVE_SMMINTRIN_H)
+
+# ifdef __GNUC__
+#  pragma GCC target("sse2")
+#  pragma GCC target("ssse3")
+#  pragma GCC target("sse4.1")
+#  pragma GCC target("avx2")
+# endif
+
+# include <emmintrin.h>
+# include <immintrin.h>
+
+/*
+ * Poly1305 with 26 bit limbs. Long runs of blocks go through AVX2: two
+ * vectors of 4 lanes, each lane accumulating every 8th block multiplied
+ * by r^8, so that the two multiplications of an iteration do not wait for
+ * each other. The lanes are folded back into h with r^8 ... r at the end
+ * of the run. A run of 4 blocks left over uses one vector and r^4 ... r,
+ * and shorter inputs and the tail are done one block at a time.
+ */
+
+# define poly1305_block_size 16
+
+/* runs shorter than this are not worth folding the lanes for */
+# define poly1305_avx2_min_bytes 256
+
+/* one-shot messages shorter than this are faster with the sse2 code */
+# define poly1305_avx2_oneshot_min_bytes 1024
+
+typedef struct poly1305_state_internal_t {
+    uint32_t           r[8][5]; /* r, r^2, ... r^8 */
+    uint32_t           h[5];
+    uint32_t           pad[4];
+    unsigned long long leftover;
+    unsigned char      buffer[poly1305_block_size];
+    unsigned char      final;
+} poly1305_state_internal_t;
+
+/* (partial) h %= p of d, the 5 limbs of a product */
+# define POLY1305_CARRY(H, D)                               \
+    do {                                                    \
+        uint32_t c_;                                        \
+        c_ = (uint32_t) ((D)[0] >> 26);                     \
+        (H)[0] = (uint32_t) (D)[0] & 0x3ffffff;             \
+        (D)[1] += c_;                                       \
+        c_ = (uint32_t) ((D)[1] >> 26);                     \
+        (H)[1] = (uint32_t) (D)[1] & 0x3ffffff;             \
+        (D)[2] += c_;                                       \
+        c_ = (uint32_t) ((D)[2] >> 26);                     \
+        (H)[2] = (uint32_t) (D)[2] & 0x3ffffff;             \
+        (D)[3] += c_;                                       \
+        c_ = (uint32_t) ((D)[3] >> 26);                     \
+        (H)[3] = (uint32_t) (D)[3] & 0x3ffffff;             \
+        (D)[4] += c_;                                       \
+        c_ = (uint32_t) ((D)[4] >> 26);                     \
+        (H)[4] = (uint32_t) (D)[4] & 0x3ffffff;             \
+        (H)[0] += c_ * 5;                                   \
+        c_ = (H)[0] >> 26;                                  \
+        (H)[0] &= 0x3ffffff;                                \
+        (H)[1] += c_;                                       \
+    } while (0)
+
+/* d = h * r, unreduced */
+static void
+poly1305_mul(uint64_t d[5], const uint32_t h[5], const uint32_t r[5])
+{
+    const uint64_t s1 = (uint64_t) r[1] * 5;
+    const uint64_t s2 = (uint64_t) r[2] * 5;
+    const uint64_t s3 = (uint64_t) r[3] * 5;
+    const uint64_t s4 = (uint64_t) r[4] * 5;
+
+    d[0] = (uint64_t) h[0] * r[0] + h[1] * s4 + h[2] * s3 + h[3] * s2 + h[4] * s1;
+    d[1] = (uint64_t) h[0] * r[1] + (uint64_t) h[1] * r[0] + h[2] * s4 + h[3] * s3 + h[4] * s2;
+    d[2] = (uint64_t) h[0] * r[2] + (uint64_t) h[1] * r[1] + (uint64_t) h[2] * r[0] + h[3] * s4 + h[4] * s3;
+    d[3] = (uint64_t) h[0] * r[3] + (uint64_t) h[1] * r[2] + (uint64_t) h[2] * r[1] + (uint64_t) h[3] * r[0] + h[4] * s4;
+    d[4] = (uint64_t) h[0] * r[4] + (uint64_t) h[1] * r[3] + (uint64_t) h[2] * r[2] + (uint64_t) h[3] * r[1] + (uint64_t) h[4] * r[0];
+}
+
+static void
+poly1305_init(poly1305_state_internal_t *st, const unsigned char key[32])
+{
+    uint64_t d[5];
+    int      i;
+
+    /* r &= 0xffffffc0ffffffc0ffffffc0fffffff - wiped after finalization */
+    st->r[0][0] = (LOAD32_LE(&key[0])) & 0x3ffffff;
+    st->r[0][1] = (LOAD32_LE(&key[3]) >> 2) & 0x3ffff03;
+    st->r[0][2] = (LOAD32_LE(&key[6]) >> 4) & 0x3ffc0ff;
+    st->r[0][3] = (LOAD32_LE(&key[9]) >> 6) & 0x3f03fff;
+    st->r[0][4] = (LOAD32_LE(&key[12]) >> 8) & 0x00fffff;
+
+    /* r^2 ... r^8 */
+    for (i = 1; i < 8; i++) {
+        poly1305_mul(d, st->r[i - 1], st->r[0]);
+        POLY1305_CARRY(st->r[i], d);
+    }
+
+    memset(st->h, 0, sizeof st->h);
+
+    /* save pad for later */
+    st->pad[0] = LOAD32_LE(&key[16]);
+    st->pad[1] = LOAD32_LE(&key[20]);
+    st->pad[2] = LOAD32_LE(&key[24]);
+    st->pad[3] = LOAD32_LE(&key[28]);
+
+    st->leftover = 0;
+    st->final    = 0;
+}
+
+static void
+poly1305_blocks(poly1305_state_internal_t *st, const unsigned char *m,
+                unsigned long long bytes)
+{
+    const uint32_t hibit = (st->final) ? 0U : (1U << 24); /* 1 << 128 */
+    uint64_t       d[5];
+
+    while (bytes >= poly1305_block_size) {
+        /* h += m[i] */
+        st->h[0] += (LOAD32_LE(m + 0)) & 0x3ffffff;
+        st->h[1] += (LOAD32_LE(m + 3) >> 2) & 0x3ffffff;
+        st->h[2] += (LOAD32_LE(m + 6) >> 4) & 0x3ffffff;
+        st->h[3] += (LOAD32_LE(m + 9) >> 6) & 0x3ffffff;
+        st->h[4] += (LOAD32_LE(m + 12) >> 8) | hibit;
+
+        /* h *= r */
+        poly1305_mul(d, st->h, st->r[0]);
+        POLY1305_CARRY(st->h, d);
+
+        m += poly1305_block_size;
+        bytes -= poly1305_block_size;
+    }
+}
+
+/* the limbs of 4 blocks, lanes holding blocks 0, 2, 1 and 3 */
+# define POLY1305_LOAD4(M, P)                                                     \
+    do {                                                                          \
+        const __m256i a_  = _mm256_loadu_si256((const __m256i *) (const void *) (P));        \
+        const __m256i b_  = _mm256_loadu_si256((const __m256i *) (const void *) ((P) + 32)); \
+        const __m256i lo_ = _mm256_unpacklo_epi64(a_, b_);                        \
+        const __m256i hi_ = _mm256_unpackhi_epi64(a_, b_);                        \
+        (M)[0] = _mm256_and_si256(lo_, mask);                                     \
+        (M)[1] = _mm256_and_si256(_mm256_srli_epi64(lo_, 26), mask);              \
+        (M)[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo_, 52),     \
+                                                  _mm256_slli_epi64(hi_, 12)),    \
+                                  mask);                                          \
+        (M)[3] = _mm256_and_si256(_mm256_srli_epi64(hi_, 14), mask);              \
+        (M)[4] = _mm256_or_si256(_mm256_srli_epi64(hi_, 40), hibit);              \
+    } while (0)
+
+/* h = h * r with a partial reduction, r and s = 5 * r per lane */
+static inline void
+poly1305_mul4(__m256i h[5], const __m256i r[5], const __m256i s[5])
+{
+    const __m256i mask = _mm256_set1_epi64x(0x3ffffff);
+    __m256i       d[5];
+    __m256i       c;
+
+    d[0] = _mm256_add_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(h[0], r[0]), _mm256_mul_epu32(h[1], s[4])),
+        _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], s[3]), _mm256_mul_epu32(h[3], s[2])),
+                         _mm256_mul_epu32(h[4], s[1])));
+    d[1] = _mm256_add_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(h[0], r[1]), _mm256_mul_epu32(h[1], r[0])),
+        _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], s[4]), _mm256_mul_epu32(h[3], s[3])),
+                         _mm256_mul_epu32(h[4], s[2])));
+    d[2] = _mm256_add_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(h[0], r[2]), _mm256_mul_epu32(h[1], r[1])),
+        _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], r[0]), _mm256_mul_epu32(h[3], s[4])),
+                         _mm256_mul_epu32(h[4], s[3])));
+    d[3] = _mm256_add_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(h[0], r[3]), _mm256_mul_epu32(h[1], r[2])),
+        _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], r[1]), _mm256_mul_epu32(h[3], r[0])),
+                         _mm256_mul_epu32(h[4], s[4])));
+    d[4] = _mm256_add_epi64(
+        _mm256_add_epi64(_mm256_mul_epu32(h[0], r[4]), _mm256_mul_epu32(h[1], r[3])),
+        _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], r[2]), _mm256_mul_epu32(h[3], r[1])),
+                         _mm256_mul_epu32(h[4], r[0])));
+
+    c    = _mm256_srli_epi64(d[0], 26);
+    h[0] = _mm256_and_si256(d[0], mask);
+    d[1] = _mm256_add_epi64(d[1], c);
+    c    = _mm256_srli_epi64(d[1], 26);
+    h[1] = _mm256_and_si256(d[1], mask);
+    d[2] = _mm256_add_epi64(d[2], c);
+    c    = _mm256_srli_epi64(d[2], 26);
+    h[2] = _mm256_and_si256(d[2], mask);
+    d[3] = _mm256_add_epi64(d[3], c);
+    c    = _mm256_srli_epi64(d[3], 26);
+    h[3] = _mm256_and_si256(d[3], mask);
+    d[4] = _mm256_add_epi64(d[4], c);
+    c    = _mm256_srli_epi64(d[4], 26);
+    h[4] = _mm256_and_si256(d[4], mask);
+    h[0] = _mm256_add_epi64(h[0], _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+    c    = _mm256_srli_epi64(h[0], 26);
+    h[0] = _mm256_and_si256(h[0], mask);
+    h[1] = _mm256_add_epi64(h[1], c);
+}
+
+/* r^A, r^B, r^C and r^D in lanes 0 to 3, and s = 5 * r */
+static inline void
+poly1305_powers4(__m256i r[5], __m256i s[5], const poly1305_state_internal_t *st,
+                 int a, int b, int c, int d)
+{
+    int i;
+
+    for (i = 0; i < 5; i++) {
+        r[i] = _mm256_set_epi64x(st->r[d - 1][i], st->r[c - 1][i],
+                                 st->r[b - 1][i], st->r[a - 1][i]);
+        s[i] = _mm256_add_epi64(r[i], _mm256_slli_epi64(r[i], 2));
+    }
+}
+
+/* h = the sum of the lanes of h, carried */
+static inline void
+poly1305_sum4(poly1305_state_internal_t *st, const __m256i h[5])
+{
+    uint64_t d[5];
+    int      i;
+
+    for (i = 0; i < 5; i++) {
+        __m128i t = _mm_add_epi64(_mm256_castsi256_si128(h[i]),
+                                  _mm256_extracti128_si256(h[i], 1));
+
+        t = _mm_add_epi64(t, _mm_unpackhi_epi64(t, t));
+        d[i] = (uint64_t) _mm_cvtsi128_si64(t);
+    }
+    POLY1305_CARRY(st->h, d);
+}
+
+/* 4 blocks */
+static void
+poly1305_blocks_avx2_4(poly1305_state_internal_t *st, const unsigned char *m)
+{
+    const __m256i mask  = _mm256_set1_epi64x(0x3ffffff);
+    const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+    __m256i       h[5], r[5], s[5];
+    int           i;
+
+    POLY1305_LOAD4(h, m);
+    for (i = 0; i < 5; i++) {
+        h[i] = _mm256_add_epi64(h[i], _mm256_set_epi64x(0, 0, 0, st->h[i]));
+    }
+    /* blocks 0, 2, 1 and 3 times r^4, r^2, r^3 and r */
+    poly1305_powers4(r, s, st, 4, 2, 3, 1);
+    poly1305_mul4(h, r, s);
+    poly1305_sum4(st, h);
+}
+
+/* bytes is a multiple of 128 */
+static void
+poly1305_blocks_avx2_8(poly1305_state_internal_t *st, const unsigned char *m,
+                       unsigned long long bytes)
+{
+    const __m256i mask  = _mm256_set1_epi64x(0x3ffffff);
+    const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+    __m256i       h[5], g[5], x[5], y[5], r[5], s[5];
+    int           i;
+
+    /* lane 0 of h starts from h, the other lanes from 0 */
+    POLY1305_LOAD4(h, m);
+    POLY1305_LOAD4(g, m + 64);
+    for (i = 0; i < 5; i++) {
+        h[i] = _mm256_add_epi64(h[i], _mm256_set_epi64x(0, 0, 0, st->h[i]));
+        r[i] = _mm256_set1_epi64x(st->r[7][i]);
+        s[i] = _mm256_set1_epi64x((long long) st->r[7][i] * 5);
+    }
+    m += 128;
+    bytes -= 128;
+
+    while (bytes >= 128) {
+        poly1305_mul4(h, r, s);
+        poly1305_mul4(g, r, s);
+        POLY1305_LOAD4(x, m);
+        POLY1305_LOAD4(y, m + 64);
+        for (i = 0; i < 5; i++) {
+            h[i] = _mm256_add_epi64(h[i], x[i]);
+            g[i] = _mm256_add_epi64(g[i], y[i]);
+        }
+        m += 128;
+        bytes -= 128;
+    }
+
+    /* blocks 0, 2, 1, 3 and 4, 6, 5, 7 of the last run times r^8 ... r */
+    poly1305_powers4(r, s, st, 8, 6, 7, 5);
+    poly1305_mul4(h, r, s);
+    poly1305_powers4(r, s, st, 4, 2, 3, 1);
+    poly1305_mul4(g, r, s);
+    for (i = 0; i < 5; i++) {
+        h[i] = _mm256_add_epi64(h[i], g[i]);
+    }
+    poly1305_sum4(st, h);
+}
+
+static void
+poly1305_update(poly1305_state_internal_t *st, const unsigned char *m,
+                unsigned long long bytes)
+{
+    unsigned long long i;
+
+    /* handle leftover */
+    if (st->leftover) {
+        unsigned long long want = (poly1305_block_size - st->leftover);
+
+        if (want > bytes) {
+            want = bytes;
+        }
+        for (i = 0; i < want; i++) {
+            st->buffer[st->leftover + i] = m[i];
+        }
+        bytes -= want;
+        m += want;
+        st->leftover += want;
+        if (st->leftover < poly1305_block_size) {
+            return;
+        }
+        poly1305_blocks(st, st->buffer, poly1305_block_size);
+        st->leftover = 0;
+    }
+
+    /* process runs of 8 blocks, then 4 */
+    if (bytes >= poly1305_avx2_min_bytes) {
+        unsigned long long want = (bytes & ~(128ULL - 1));
+
+        poly1305_blocks_avx2_8(st, m, want);
+        m += want;
+        bytes -= want;
+        if (bytes >= 64) {
+            poly1305_blocks_avx2_4(st, m);
+            m += 64;
+            bytes -= 64;
+        }
+    }
+
+    /* process full blocks */
+    if (bytes >= poly1305_block_size) {
+        unsigned long long want = (bytes & ~(poly1305_block_size - 1));
+
+        poly1305_blocks(st, m, want);
+        m += want;
+        bytes -= want;
+    }
+
+    /* store leftover */
+    if (bytes) {
+        for (i = 0; i < bytes; i++) {
+            st->buffer[st->leftover + i] = m[i];
+        }
+        st->leftover += bytes;
+    }
+}
+
+static void
+poly1305_finish(poly1305_state_internal_t *st, unsigned char mac[16])
+{
+    uint32_t h0, h1, h2, h3, h4, c;
+    uint32_t g0, g1, g2, g3, g4;
+    uint64_t f;
+    uint32_t mask;
+
+    /* process the remaining block */
+    if (st->leftover) {
+        unsigned long long i = st->leftover;
+
+        st->buffer[i++] = 1;
+        for (; i < poly1305_block_size; i++) {
+            st->buffer[i] = 0;
+        }
+        st->final = 1;
+        poly1305_blocks(st, st->buffer, poly1305_block_size);
+    }
+
+    /* fully carry h */
+    h0 = st->h[0];
+    h1 = st->h[1];
+    h2 = st->h[2];
+    h3 = st->h[3];
+    h4 = st->h[4];
+
+    c  = h1 >> 26;
+    h1 = h1 & 0x3ffffff;
+    h2 += c;
+    c  = h2 >> 26;
+    h2 = h2 & 0x3ffffff;
+    h3 += c;
+    c  = h3 >> 26;
+    h3 = h3 & 0x3ffffff;
+    h4 += c;
+    c  = h4 >> 26;
+    h4 = h4 & 0x3ffffff;
+    h0 += c * 5;
+    c  = h0 >> 26;
+    h0 = h0 & 0x3ffffff;
+    h1 += c;
+
+    /* compute h + -p */
+    g0 = h0 + 5;
+    c  = g0 >> 26;
+    g0 &= 0x3ffffff;
+    g1 = h1 + c;
+    c  = g1 >> 26;
+    g1 &= 0x3ffffff;
+    g2 = h2 + c;
+    c  = g2 >> 26;
+    g2 &= 0x3ffffff;
+    g3 = h3 + c;
+    c  = g3 >> 26;
+    g3 &= 0x3ffffff;
+    g4 = h4 + c - (1U << 26);
+
+    /* select h if h < p, or h + -p if h >= p */
+    mask = (g4 >> 31) - 1;
+    g0 &= mask;
+    g1 &= mask;
+    g2 &= mask;
+    g3 &= mask;
+    g4 &= mask;
+    mask = ~mask;
+
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+
+    /* h = h % (2^128) */
+    h0 = ((h0) | (h1 << 26));
+    h1 = ((h1 >> 6) | (h2 << 20));
+    h2 = ((h2 >> 12) | (h3 << 14));
+    h3 = ((h3 >> 18) | (h4 << 8));
+
+    /* mac = (h + pad) % (2^128) */
+    f  = (uint64_t) h0 + st->pad[0];
+    h0 = (uint32_t) f;
+    f  = (uint64_t) h1 + st->pad[1] + (f >> 32);
+    h1 = (uint32_t) f;
+    f  = (uint64_t) h2 + st->pad[2] + (f >> 32);
+    h2 = (uint32_t) f;
+    f  = (uint64_t) h3 + st->pad[3] + (f >> 32);
+    h3 = (uint32_t) f;
+
+    STORE32_LE(mac + 0, h0);
+    STORE32_LE(mac + 4, h1);
+    STORE32_LE(mac + 8, h2);
+    STORE32_LE(mac + 12, h3);
+
+    /* zero out the state */
+    sodium_memzero((void *) st, sizeof *st);
+}
+
+static int
+crypto_onetimeauth_poly1305_avx2(unsigned char *out, const unsigned char *m,
+                                 unsigned long long   inlen,
+                                 const unsigned char *key)
+{
+    poly1305_state_internal_t st;
+
+    if (inlen < poly1305_avx2_oneshot_min_bytes) {
+        return crypto_onetimeauth_poly1305_sse2_implementation.onetimeauth(
+            out, m, inlen, key);
+    }
+    poly1305_init(&st, key);
+    poly1305_update(&st, m, inlen);
+    poly1305_finish(&st, out);
+
+    return 0;
+}
+
+static int
+crypto_onetimeauth_poly1305_avx2_verify(const unsigned char *h,
+                                        const unsigned char *in,
+                                        unsigned long long   inlen,
+                                        const unsigned char *k)
+{
+    unsigned char correct[16];
+
+    crypto_onetimeauth_poly1305_avx2(correct, in, inlen, k);
+
+    return crypto_verify_16(h, correct);
+}
+
+static int
+crypto_onetimeauth_poly1305_avx2_init(crypto_onetimeauth_poly1305_state *state,
+                                      const unsigned char *key)
+{
+    COMPILER_ASSERT(sizeof(crypto_onetimeauth_poly1305_state) >=
+                    sizeof(poly1305_state_internal_t));
+    poly1305_init((poly1305_state_internal_t *) (void *) state, key);
+
+    return 0;
+}
+
+static int
+crypto_onetimeauth_poly1305_avx2_update(
+    crypto_onetimeauth_poly1305_state *state, const unsigned char *in,
+    unsigned long long inlen)
+{
+    poly1305_update((poly1305_state_internal_t *) (void *) state, in, inlen);
+
+    return 0;
+}
+
+static int
+crypto_onetimeauth_poly1305_avx2_final(crypto_onetimeauth_poly1305_state *state,
+                                       unsigned char *out)
+{
+    poly1305_finish((poly1305_state_internal_t *) (void *) state, out);
+
+    return 0;
+}
+
+struct crypto_onetimeauth_poly1305_implementation
+    crypto_onetimeauth_poly1305_avx2_implementation = {
+        SODIUM_C99(.onetimeauth =) crypto_onetimeauth_poly1305_avx2,
+        SODIUM_C99(.onetimeauth_verify =)
+            crypto_onetimeauth_poly1305_avx2_verify,
+        SODIUM_C99(.onetimeauth_init =) crypto_onetimeauth_poly1305_avx2_init,
+        SODIUM_C99(.onetimeauth_update =)
+            crypto_onetimeauth_poly1305_avx2_update,
+        SODIUM_C99(.onetimeauth_final =) crypto_onetimeauth_poly1305_avx2_final
+    };
+
+#endif
@@ -10,6 +10,10 @@
 #if defined(HAVE_TI_MODE) && defined(HAVE_EMMINTRIN_H)
 # include "sse2/poly1305_sse2.h"
 #endif
+#if defined(HAVE_AVX2INTRIN_H) && defined(HAVE_EMMINTRIN_H) && \
+    defined(HAVE_TMMINTRIN_H) && defined(HAVE_SMMINTRIN_H)
+# include "avx2/poly1305_avx2.h"
+#endif
 
 static const crypto_onetimeauth_poly1305_implementation *implementation =
     &crypto_onetimeauth_poly1305_donna_implementation;
@@ -85,6 +89,12 @@ _crypto_onetimeauth_poly1305_pick_best_implementation(void)
     if (sodium_runtime_has_sse2()) {
         implementation = &crypto_onetimeauth_poly1305_sse2_implementation;
     }
+#endif
+#if defined(HAVE_AVX2INTRIN_H) && defined(HAVE_EMMINTRIN_H) && \
+    defined(HAVE_TMMINTRIN_H) && defined(HAVE_SMMINTRIN_H)
+    if (sodium_runtime_has_avx2()) {
+        implementation = &crypto_onetimeauth_poly1305_avx2_implementation;
+    }
 #endif
     return 0;
 }
@@ -62,6 +62,17 @@ store_block(void *output, const block *src)
 }
 
 /***************Memory allocators*****************/
+static argon2_region_alloc_fn   region_alloc_hook;
+static argon2_region_release_fn region_release_hook;
+
+void
+argon2_set_region_allocator(argon2_region_alloc_fn alloc,
+                            argon2_region_release_fn release)
+{
+    region_alloc_hook   = alloc;
+    region_release_hook = release;
+}
+
 /* Allocates memory to the given pointer
  * @param memory pointer to the pointer to the memory
  * @param m_cost number of blocks to allocate in the memory
@@ -91,6 +102,16 @@ allocate_memory(block_region **region, uint32_t m_cost)
         return ARGON2_MEMORY_ALLOCATION_ERROR; /* LCOV_EXCL_LINE */
     }
     (*region)->base = (*region)->memory = NULL;
+    (*region)->release = NULL;
+
+    if (region_alloc_hook != NULL &&
+        (base = region_alloc_hook(memory_size)) != NULL) {
+        (*region)->base    = base;
+        (*region)->memory  = (block *) base;
+        (*region)->size    = memory_size;
+        (*region)->release = region_release_hook;
+        return ARGON2_OK;
+    }
 
 #if defined(MAP_ANON) && defined(HAVE_MMAP)
     if ((base = mmap(NULL, memory_size, PROT_READ | PROT_WRITE,
@@ -144,7 +165,8 @@ clear_memory(argon2_instance_t *instance, int clear)
         }
         if (instance->pseudo_rands != NULL) {
             sodium_memzero(instance->pseudo_rands,
-                           sizeof(uint64_t) * instance->segment_length);
+                           sizeof(uint64_t) * instance->segment_length *
+                               instance->lanes);
         }
     }
     /* LCOV_EXCL_STOP */
@@ -158,7 +180,9 @@ static void free_memory(block_region *memory);
 static void
 free_memory(block_region *region)
 {
-    if (region && region->base) {
+    if (region && region->base && region->release != NULL) {
+        region->release(region->base, region->size);
+    } else if (region && region->base) {
 #if defined(MAP_ANON) && defined(HAVE_MMAP)
         if (munmap(region->base, region->size)) {
             return; /* LCOV_EXCL_LINE */
@@ -217,12 +241,41 @@ finalize(const argon2_context *context, argon2_instance_t *instance)
     }
 }
 
+static argon2_lanes_runner_t lanes_runner;
+
+void
+argon2_set_lanes_runner(argon2_lanes_runner_t run)
+{
+    lanes_runner = run;
+}
+
+struct fill_lanes {
+    const argon2_instance_t *instance;
+    argon2_position_t        position;
+};
+
+/* One segment of the current slice for the lanes runner */
+static int
+fill_lane(void *ctx_, uint32_t lane)
+{
+    const struct fill_lanes *ctx = (const struct fill_lanes *) ctx_;
+    argon2_position_t        position = ctx->position;
+
+    position.lane  = lane;
+    position.index = 0;
+    fill_segment(ctx->instance, position);
+
+    return 0;
+}
+
 void
 fill_memory_blocks(argon2_instance_t *instance, uint32_t pass)
 {
     argon2_position_t position;
+    struct fill_lanes lanes;
     uint32_t l;
     uint32_t s;
+    int      declined;
 
     if (instance == NULL || instance->lanes == 0) {
         return; /* LCOV_EXCL_LINE */
@@ -231,6 +284,16 @@ fill_memory_blocks(argon2_instance_t *instance, uint32_t pass)
     position.pass = pass;
     for (s = 0; s < ARGON2_SYNC_POINTS; ++s) {
         position.slice = (uint8_t) s;
+        declined = 1;
+        if (instance->lanes > 1 && instance->threads > 1 &&
+            lanes_runner != NULL) {
+            lanes.instance = instance;
+            lanes.position = position;
+            declined = lanes_runner(fill_lane, &lanes, instance->lanes);
+        }
+        if (!declined) {
+            continue;
+        }
         for (l = 0; l < instance->lanes; ++l) {
             position.lane  = l;
             position.index = 0;
@@ -483,8 +546,10 @@ initialize(argon2_instance_t *instance, argon2_context *context)
 
     /* 1. Memory allocation */
 
+    /* One row of addresses per lane, for lanes filled at the same time */
     if ((instance->pseudo_rands = (uint64_t *)
-         malloc(sizeof(uint64_t) * instance->segment_length)) == NULL) {
+         malloc(sizeof(uint64_t) * instance->segment_length *
+                instance->lanes)) == NULL) {
         return ARGON2_MEMORY_ALLOCATION_ERROR;
     }
 
@@ -535,6 +600,12 @@ argon2_pick_best_implementation(void)
         fill_segment = fill_segment_ssse3;
         return 0;
     }
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(USE_ARM64_KERNELS)
+    if (sodium_runtime_has_neon()) {
+        fill_segment = fill_segment_neon;
+        return 0;
+    }
 #endif
     fill_segment = fill_segment_ref;
 
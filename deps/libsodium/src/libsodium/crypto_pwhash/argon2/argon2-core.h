@@ -58,8 +58,36 @@ typedef struct block_region_ {
     void * base;
     block *memory;
     size_t size;
+    void (*release)(void *base, size_t size); /* set for hook allocations */
 } block_region;
 
+/*
+ * Optional allocator for the block memory. node-sodium installs one to reuse
+ * regions between hashes. `alloc` returns memory aligned to 64 bytes, or
+ * NULL to fall back to the default allocation; `release` gets back what
+ * `alloc` returned. Must be called before any hash is computed.
+ */
+typedef void *(*argon2_region_alloc_fn)(size_t size);
+typedef void (*argon2_region_release_fn)(void *base, size_t size);
+
+void argon2_set_region_allocator(argon2_region_alloc_fn alloc,
+                                 argon2_region_release_fn release);
+
+/*
+ * Optional runner for the lanes of a slice.  Segments of the same slice in
+ * different lanes only read blocks of earlier slices, so when an instance
+ * has more than one lane and `threads` above 1 each slice is handed to the
+ * runner, which calls `lane(ctx, l)` once for every `l` below `lanes`, on
+ * as many threads as it likes, and returns 0 when they are all done; or 1
+ * without calling any of them to have the lanes filled in turn.  Must be
+ * called before any hash is computed.
+ */
+typedef int (*argon2_lane_fn)(void *ctx, uint32_t lane);
+typedef int (*argon2_lanes_runner_t)(argon2_lane_fn lane, void *ctx,
+                                     uint32_t lanes);
+
+void argon2_set_lanes_runner(argon2_lanes_runner_t run);
+
 /*****************Functions that work with the block******************/
 
 /* Initialize each byte of the block with @in */
@@ -94,7 +122,7 @@ xor_block(block *dst, const block *src)
  */
 typedef struct Argon2_instance_t {
     block_region *region;        /* Memory region pointer */
-    uint64_t     *pseudo_rands;
+    uint64_t     *pseudo_rands;  /* segment_length addresses per lane */
     uint32_t      passes;        /* Number of passes */
     uint32_t      current_pass;
     uint32_t      memory_blocks; /* Number of blocks in memory */
@@ -283,6 +311,8 @@ void fill_segment_avx2(const argon2_instance_t *instance,
                        argon2_position_t        position);
 void fill_segment_ssse3(const argon2_instance_t *instance,
                         argon2_position_t        position);
+void fill_segment_neon(const argon2_instance_t *instance,
+                       argon2_position_t        position);
 void fill_segment_ref(const argon2_instance_t *instance,
                       argon2_position_t        position);
 
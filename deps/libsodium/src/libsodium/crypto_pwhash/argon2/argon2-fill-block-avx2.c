@@ -163,7 +163,8 @@ fill_segment_avx2(const argon2_instance_t *instance,
         data_independent_addressing = 0;
     }
 
-    pseudo_rands = instance->pseudo_rands;
+    pseudo_rands = instance->pseudo_rands +
+                   (size_t) position.lane * instance->segment_length;
 
     if (data_independent_addressing) {
         generate_addresses(instance, &position, pseudo_rands);
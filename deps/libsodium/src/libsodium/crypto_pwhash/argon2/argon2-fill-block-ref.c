@@ -161,7 +161,8 @@ fill_segment_ref(const argon2_instance_t *instance, argon2_position_t position)
         data_independent_addressing = 0;
     }
 
-    pseudo_rands = instance->pseudo_rands;
+    pseudo_rands = instance->pseudo_rands +
+                   (size_t) position.lane * instance->segment_length;
 
     if (data_independent_addressing) {
         generate_addresses(instance, &position, pseudo_rands);
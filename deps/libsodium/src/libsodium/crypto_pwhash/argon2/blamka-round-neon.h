@@ -0,0 +1,118 @@
+#ifndef blamka_round_neon_H
+#define blamka_round_neon_H
+
+#include "private/common.h"
+
+static const uint8_t blamka_r16[16] = {
+    2, 3, 4, 5, 6, 7, 0, 1, 10, 11, 12, 13, 14, 15, 8, 9
+};
+static const uint8_t blamka_r24[16] = {
+    3, 4, 5, 6, 7, 0, 1, 2, 11, 12, 13, 14, 15, 8, 9, 10
+};
+
+/* rotations right by 32, 24, 16 and 63 bits */
+#define vrorq_n_u64_32(x) \
+    vreinterpretq_u64_u32(vrev64q_u32(vreinterpretq_u32_u64(x)))
+#define vrorq_n_u64_24(x) \
+    vreinterpretq_u64_u8(vqtbl1q_u8(vreinterpretq_u8_u64(x), vld1q_u8(blamka_r24)))
+#define vrorq_n_u64_16(x) \
+    vreinterpretq_u64_u8(vqtbl1q_u8(vreinterpretq_u8_u64(x), vld1q_u8(blamka_r16)))
+#define vrorq_n_u64_63(x) veorq_u64(vaddq_u64((x), (x)), vshrq_n_u64((x), 63))
+
+static inline uint64x2_t
+fBlaMka(uint64x2_t x, uint64x2_t y)
+{
+    const uint64x2_t z = vmull_u32(vmovn_u64(x), vmovn_u64(y));
+    return vaddq_u64(vaddq_u64(x, y), vaddq_u64(z, z));
+}
+
+#define G1(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do {                                   \
+        A0 = fBlaMka(A0, B0);              \
+        A1 = fBlaMka(A1, B1);              \
+                                           \
+        D0 = veorq_u64(D0, A0);            \
+        D1 = veorq_u64(D1, A1);            \
+                                           \
+        D0 = vrorq_n_u64_32(D0);           \
+        D1 = vrorq_n_u64_32(D1);           \
+                                           \
+        C0 = fBlaMka(C0, D0);              \
+        C1 = fBlaMka(C1, D1);              \
+                                           \
+        B0 = veorq_u64(B0, C0);            \
+        B1 = veorq_u64(B1, C1);            \
+                                           \
+        B0 = vrorq_n_u64_24(B0);           \
+        B1 = vrorq_n_u64_24(B1);           \
+    } while ((void) 0, 0)
+
+#define G2(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do {                                   \
+        A0 = fBlaMka(A0, B0);              \
+        A1 = fBlaMka(A1, B1);              \
+                                           \
+        D0 = veorq_u64(D0, A0);            \
+        D1 = veorq_u64(D1, A1);            \
+                                           \
+        D0 = vrorq_n_u64_16(D0);           \
+        D1 = vrorq_n_u64_16(D1);           \
+                                           \
+        C0 = fBlaMka(C0, D0);              \
+        C1 = fBlaMka(C1, D1);              \
+                                           \
+        B0 = veorq_u64(B0, C0);            \
+        B1 = veorq_u64(B1, C1);            \
+                                           \
+        B0 = vrorq_n_u64_63(B0);           \
+        B1 = vrorq_n_u64_63(B1);           \
+    } while ((void) 0, 0)
+
+#define DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do {                                            \
+        uint64x2_t t0 = vextq_u64(B0, B1, 1);       \
+        uint64x2_t t1 = vextq_u64(B1, B0, 1);       \
+        B0            = t0;                         \
+        B1            = t1;                         \
+                                                    \
+        t0 = C0;                                    \
+        C0 = C1;                                    \
+        C1 = t0;                                    \
+                                                    \
+        t0 = vextq_u64(D0, D1, 1);                  \
+        t1 = vextq_u64(D1, D0, 1);                  \
+        D0 = t1;                                    \
+        D1 = t0;                                    \
+    } while ((void) 0, 0)
+
+#define UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1) \
+    do {                                              \
+        uint64x2_t t0 = vextq_u64(B1, B0, 1);         \
+        uint64x2_t t1 = vextq_u64(B0, B1, 1);         \
+        B0            = t0;                           \
+        B1            = t1;                           \
+                                                      \
+        t0 = C0;                                      \
+        C0 = C1;                                      \
+        C1 = t0;                                      \
+                                                      \
+        t0 = vextq_u64(D1, D0, 1);                    \
+        t1 = vextq_u64(D0, D1, 1);                    \
+        D0 = t1;                                      \
+        D1 = t0;                                      \
+    } while ((void) 0, 0)
+
+#define BLAKE2_ROUND(A0, A1, B0, B1, C0, C1, D0, D1)   \
+    do {                                               \
+        G1(A0, B0, C0, D0, A1, B1, C1, D1);            \
+        G2(A0, B0, C0, D0, A1, B1, C1, D1);            \
+                                                       \
+        DIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1);   \
+                                                       \
+        G1(A0, B0, C0, D0, A1, B1, C1, D1);            \
+        G2(A0, B0, C0, D0, A1, B1, C1, D1);            \
+                                                       \
+        UNDIAGONALIZE(A0, B0, C0, D0, A1, B1, C1, D1); \
+    } while ((void) 0, 0)
+
+#endif
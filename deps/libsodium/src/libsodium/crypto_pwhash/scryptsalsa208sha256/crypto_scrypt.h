@@ -68,6 +68,22 @@ extern int escrypt_free_local(escrypt_local_t *__local);
 extern void *alloc_region(escrypt_region_t *region, size_t size);
 extern int free_region(escrypt_region_t *region);
 
+/*
+ * Optional runner for the SMix lanes of parameters with p > 1.  When set,
+ * escrypt_kdf_* pass it lane(ctx, i), which must be called once for every
+ * i < p, in any order and possibly at the same time.  The runner returns 0
+ * when all lanes succeeded, -1 when one of them failed, or 1 without
+ * calling any of them to have the lanes run in turn.  Every lane after the
+ * first allocates its own 128rN bytes.
+ */
+typedef int (*escrypt_lane_fn)(void *__ctx, uint32_t __lane);
+typedef int (*escrypt_lanes_runner_t)(escrypt_lane_fn __lane, void *__ctx,
+                                      uint32_t __p);
+
+extern escrypt_lanes_runner_t escrypt_lanes_runner;
+
+extern void escrypt_set_lanes_runner(escrypt_lanes_runner_t __run);
+
 typedef int (*escrypt_kdf_t)(escrypt_local_t *__local, const uint8_t *__passwd,
                              size_t __passwdlen, const uint8_t *__salt,
                              size_t __saltlen, uint64_t __N, uint32_t __r,
@@ -106,3 +106,11 @@ escrypt_free_local(escrypt_local_t *local)
 {
     return free_region(local);
 }
+
+escrypt_lanes_runner_t escrypt_lanes_runner;
+
+void
+escrypt_set_lanes_runner(escrypt_lanes_runner_t run)
+{
+    escrypt_lanes_runner = run;
+}
@@ -295,6 +295,41 @@ smix(uint8_t *B, size_t r, uint32_t N, void *V, void *XY)
     }
 }
 
+struct smix_lanes {
+    uint8_t *B;
+    size_t   r;
+    uint32_t N;
+    void *V;
+    void *XY;
+    size_t   V_size;
+    size_t   XY_size;
+};
+
+/*
+ * One SMix lane for an escrypt_lanes_runner.  Lane 0 uses the memory of the
+ * caller, the others map their own.
+ */
+static int
+smix_lane(void *ctx_, uint32_t lane)
+{
+    struct smix_lanes *ctx = (struct smix_lanes *) ctx_;
+    escrypt_region_t   region;
+    uint8_t           *V;
+
+    if (lane == 0) {
+        smix(ctx->B, ctx->r, ctx->N, ctx->V, ctx->XY);
+        return 0;
+    }
+    escrypt_init_local(&region);
+    if ((V = (uint8_t *) alloc_region(&region, ctx->V_size + ctx->XY_size)) == NULL) {
+        return -1;
+    }
+    smix(&ctx->B[(size_t) 128 * lane * ctx->r], ctx->r, ctx->N,
+         (void *) V, (void *) (V + ctx->V_size));
+
+    return free_region(&region);
+}
+
 /**
  * escrypt_kdf(local, passwd, passwdlen, salt, saltlen,
  *     N, r, p, buf, buflen):
@@ -315,6 +350,7 @@ escrypt_kdf_sse(escrypt_local_t *local, const uint8_t *passwd, size_t passwdlen,
     uint32_t *V, *XY;
     size_t    r = _r, p = _p;
     uint32_t  i;
+    int       declined;
 
 /* Sanity-check parameters. */
 # if SIZE_MAX > UINT32_MAX
@@ -385,10 +421,28 @@ escrypt_kdf_sse(escrypt_local_t *local, const uint8_t *passwd, size_t passwdlen,
     /* 1: (B_0 ... B_{p-1}) <-- PBKDF2(P, S, 1, p * MFLen) */
     PBKDF2_SHA256(passwd, passwdlen, salt, saltlen, 1, B, B_size);
 
-    /* 2: for i = 0 to p - 1 do */
-    for (i = 0; i < p; i++) {
-        /* 3: B_i <-- MF(B_i, N) */
-        smix(&B[(size_t) 128 * i * r], r, (uint32_t) N, V, XY);
+    /* 2: for i = 0 to p - 1 do, on the lanes runner if there is one */
+    declined = 1;
+    if (p > 1 && escrypt_lanes_runner != NULL) {
+        struct smix_lanes lanes;
+
+        lanes.B       = B;
+        lanes.r       = r;
+        lanes.N       = (uint32_t) N;
+        lanes.V       = V;
+        lanes.XY      = XY;
+        lanes.V_size  = V_size;
+        lanes.XY_size = XY_size;
+        if ((declined = escrypt_lanes_runner(smix_lane, &lanes, (uint32_t) p)) < 0) {
+            errno = ENOMEM;
+            return -1;
+        }
+    }
+    if (declined) {
+        for (i = 0; i < p; i++) {
+            /* 3: B_i <-- MF(B_i, N) */
+            smix(&B[(size_t) 128 * i * r], r, (uint32_t) N, V, XY);
+        }
     }
 
     /* 5: DK <-- PBKDF2(P, B, 1, dkLen) */
@@ -30,7 +30,12 @@ crypto_scalarmult_curve25519(unsigned char *q, const unsigned char *n,
 int
 crypto_scalarmult_curve25519_base(unsigned char *q, const unsigned char *n)
 {
-    return implementation->mult_base(q, n);
+    /*
+     * Always the ref10 fixed-base comb: an Ed25519 base point multiplication
+     * from precomputed tables, then the birational map. It is more than
+     * twice as fast as the sandy2x base point ladder.
+     */
+    return crypto_scalarmult_curve25519_ref10_implementation.mult_base(q, n);
 }
 
 size_t
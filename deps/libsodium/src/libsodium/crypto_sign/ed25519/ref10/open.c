@@ -10,48 +10,134 @@
 #include "private/ed25519_ref10.h"
 #include "utils.h"
 
-int
-_crypto_sign_ed25519_verify_detached(const unsigned char *sig,
+/*
+ * A public key checked and decompressed once, for callers that verify many
+ * signatures against the same key. Opaque to them: they only get its size.
+ */
+typedef struct crypto_sign_ed25519_verifykey_ {
+    unsigned char pk[32];
+    ge25519_p3    A;
+} crypto_sign_ed25519_verifykey;
+
+static int
+_crypto_sign_ed25519_pk_prepare(ge25519_p3 *A, const unsigned char *pk)
+{
+#ifndef ED25519_COMPAT
+    if (ge25519_is_canonical(pk) == 0) {
+        return -1;
+    }
+#endif
+    if (ge25519_has_small_order(pk) != 0 ||
+        ge25519_frombytes_negate_vartime(A, pk) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+static int
+_crypto_sign_ed25519_verify_prepared(const unsigned char *sig,
                                      const unsigned char *m,
                                      unsigned long long   mlen,
                                      const unsigned char *pk,
+                                     const ge25519_p3    *A,
                                      int prehashed)
 {
     crypto_hash_sha512_state hs;
     unsigned char            h[64];
     unsigned char            rcheck[32];
-    ge25519_p3               A;
     ge25519_p2               R;
 
+    _crypto_sign_ed25519_ref10_hinit(&hs, prehashed);
+    crypto_hash_sha512_update(&hs, sig, 32);
+    crypto_hash_sha512_update(&hs, pk, 32);
+    crypto_hash_sha512_update(&hs, m, mlen);
+    crypto_hash_sha512_final(&hs, h);
+    sc25519_reduce(h);
+
+    ge25519_double_scalarmult_vartime(&R, h, A, sig + 32);
+    ge25519_tobytes(rcheck, &R);
+
+    return crypto_verify_32(rcheck, sig) | (-(rcheck == sig)) |
+           sodium_memcmp(sig, rcheck, 32);
+}
+
+static int
+_crypto_sign_ed25519_sig_check(const unsigned char *sig)
+{
 #ifndef ED25519_COMPAT
     if (sc25519_is_canonical(sig + 32) == 0 ||
         ge25519_has_small_order(sig) != 0) {
         return -1;
     }
-    if (ge25519_is_canonical(pk) == 0) {
-        return -1;
-    }
 #else
     if (sig[63] & 224) {
         return -1;
     }
 #endif
-    if (ge25519_has_small_order(pk) != 0 ||
-        ge25519_frombytes_negate_vartime(&A, pk) != 0) {
+    return 0;
+}
+
+int
+_crypto_sign_ed25519_verify_detached(const unsigned char *sig,
+                                     const unsigned char *m,
+                                     unsigned long long   mlen,
+                                     const unsigned char *pk,
+                                     int prehashed)
+{
+    ge25519_p3 A;
+
+    if (_crypto_sign_ed25519_sig_check(sig) != 0 ||
+        _crypto_sign_ed25519_pk_prepare(&A, pk) != 0) {
         return -1;
     }
-    _crypto_sign_ed25519_ref10_hinit(&hs, prehashed);
-    crypto_hash_sha512_update(&hs, sig, 32);
-    crypto_hash_sha512_update(&hs, pk, 32);
-    crypto_hash_sha512_update(&hs, m, mlen);
-    crypto_hash_sha512_final(&hs, h);
-    sc25519_reduce(h);
+    return _crypto_sign_ed25519_verify_prepared(sig, m, mlen, pk, &A,
+                                                prehashed);
+}
 
-    ge25519_double_scalarmult_vartime(&R, h, &A, sig + 32);
-    ge25519_tobytes(rcheck, &R);
+size_t
+crypto_sign_ed25519_verifykeybytes(void)
+{
+    return sizeof(crypto_sign_ed25519_verifykey);
+}
 
-    return crypto_verify_32(rcheck, sig) | (-(rcheck == sig)) |
-           sodium_memcmp(sig, rcheck, 32);
+int
+crypto_sign_ed25519_verifykey_init(void *vk_, const unsigned char *pk)
+{
+    crypto_sign_ed25519_verifykey *vk = (crypto_sign_ed25519_verifykey *) vk_;
+
+    if (_crypto_sign_ed25519_pk_prepare(&vk->A, pk) != 0) {
+        sodium_memzero(vk, sizeof *vk);
+        return -1;
+    }
+    memcpy(vk->pk, pk, 32);
+
+    return 0;
+}
+
+int
+_crypto_sign_ed25519_verify_detached_vk(const unsigned char *sig,
+                                        const unsigned char *m,
+                                        unsigned long long   mlen,
+                                        const void          *vk_,
+                                        int prehashed)
+{
+    const crypto_sign_ed25519_verifykey *vk =
+        (const crypto_sign_ed25519_verifykey *) vk_;
+
+    if (_crypto_sign_ed25519_sig_check(sig) != 0) {
+        return -1;
+    }
+    return _crypto_sign_ed25519_verify_prepared(sig, m, mlen, vk->pk, &vk->A,
+                                                prehashed);
+}
+
+int
+crypto_sign_ed25519_verify_detached_vk(const unsigned char *sig,
+                                       const unsigned char *m,
+                                       unsigned long long   mlen,
+                                       const void          *vk)
+{
+    return _crypto_sign_ed25519_verify_detached_vk(sig, m, mlen, vk, 0);
 }
 
 int
@@ -63,6 +149,48 @@ crypto_sign_ed25519_verify_detached(const unsigned char *sig,
     return _crypto_sign_ed25519_verify_detached(sig, m, mlen, pk, 0);
 }
 
+/*
+ * Every signature is verified as crypto_sign_ed25519_verify_detached() does,
+ * a key being checked and decompressed once for a run of signatures it made.
+ *
+ * A randomized group check, one multi-scalar multiplication for many
+ * signatures, cannot give the same answers: whether it is multiplied by the
+ * cofactor or not, a point of small order added to R or A by a key holder
+ * can pass it while the cofactorless check rejects the signature, depending
+ * on the random coefficients and on the other signatures of the group.
+ * Ruling those points out first takes a multiplication by l per signature,
+ * which costs more than the group check saves.
+ */
+
+int
+crypto_sign_ed25519_verify_batch(unsigned char *ok,
+                                 const unsigned char * const *sigs,
+                                 const unsigned char * const *ms,
+                                 const unsigned long long *mlens,
+                                 const unsigned char * const *pks,
+                                 size_t n)
+{
+    ge25519_p3           A;
+    const unsigned char *pk = NULL;
+    int                  pk_ok = 0;
+    int                  ret = 0;
+    size_t               i;
+
+    for (i = 0; i < n; i++) {
+        if (pk == NULL || sodium_memcmp(pk, pks[i], 32) != 0) {
+            pk = pks[i];
+            pk_ok = _crypto_sign_ed25519_pk_prepare(&A, pk) == 0;
+        }
+        ok[i] = pk_ok && _crypto_sign_ed25519_sig_check(sigs[i]) == 0 &&
+                _crypto_sign_ed25519_verify_prepared(sigs[i], ms[i], mlens[i],
+                                                     pks[i], &A, 0) == 0;
+        if (!ok[i]) {
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
 int
 crypto_sign_ed25519_open(unsigned char *m, unsigned long long *mlen_p,
                          const unsigned char *sm, unsigned long long smlen,
@@ -15,4 +15,26 @@ int _crypto_sign_ed25519_verify_detached(const unsigned char *sig,
                                          unsigned long long   mlen,
                                          const unsigned char *pk,
                                          int prehashed);
+
+size_t crypto_sign_ed25519_verifykeybytes(void);
+
+int crypto_sign_ed25519_verifykey_init(void *vk, const unsigned char *pk);
+
+int _crypto_sign_ed25519_verify_detached_vk(const unsigned char *sig,
+                                            const unsigned char *m,
+                                            unsigned long long   mlen,
+                                            const void          *vk,
+                                            int prehashed);
+
+int crypto_sign_ed25519_verify_detached_vk(const unsigned char *sig,
+                                           const unsigned char *m,
+                                           unsigned long long   mlen,
+                                           const void          *vk);
+
+int crypto_sign_ed25519_verify_batch(unsigned char *ok,
+                                     const unsigned char * const *sigs,
+                                     const unsigned char * const *ms,
+                                     const unsigned long long *mlens,
+                                     const unsigned char * const *pks,
+                                     size_t n);
 #endif
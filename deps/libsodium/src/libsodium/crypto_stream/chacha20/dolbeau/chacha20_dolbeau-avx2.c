@@ -26,6 +26,7 @@
 
 # include "../stream_chacha20.h"
 # include "chacha20_dolbeau-avx2.h"
+# include "private/chacha20poly1305_multi.h"
 
 # define ROUNDS 20
 
@@ -169,6 +170,485 @@ stream_ietf_ref_xor_ic(unsigned char *c, const unsigned char *m,
     return 0;
 }
 
+/*
+ * Multi-buffer ChaCha20-Poly1305 (IETF). Lane l of every vector works on a
+ * message of its own, so 8 short messages use the 8 lanes that one short
+ * message would leave idle. A lane that is done with its message takes the
+ * next one. Only meant for messages of a few blocks: a long one keeps a
+ * single lane busy while the other ones run out of work.
+ */
+
+# define MULTI_LANES 8
+# define MULTI_IDLE  ((size_t) -1)
+
+# define MULTI_ROTL(X, B) \
+    _mm256_or_si256(_mm256_slli_epi32((X), (B)), _mm256_srli_epi32((X), 32 - (B)))
+
+# define MULTI_QUARTERROUND(A, B, C, D)                              \
+    x[A] = _mm256_add_epi32(x[A], x[B]);                             \
+    x[D] = _mm256_shuffle_epi8(_mm256_xor_si256(x[D], x[A]), rot16); \
+    x[C] = _mm256_add_epi32(x[C], x[D]);                             \
+    x[B] = MULTI_ROTL(_mm256_xor_si256(x[B], x[C]), 12);             \
+    x[A] = _mm256_add_epi32(x[A], x[B]);                             \
+    x[D] = _mm256_shuffle_epi8(_mm256_xor_si256(x[D], x[A]), rot8);  \
+    x[C] = _mm256_add_epi32(x[C], x[D]);                             \
+    x[B] = MULTI_ROTL(_mm256_xor_si256(x[B], x[C]), 7)
+
+/* words W..W+7 of the 8 lanes, lane major, to ks[lane][4 * W] */
+static void
+multi_transpose(unsigned char ks[MULTI_LANES][64], const __m256i *x, int w)
+{
+    __m256i t0 = _mm256_unpacklo_epi32(x[w + 0], x[w + 1]);
+    __m256i t1 = _mm256_unpackhi_epi32(x[w + 0], x[w + 1]);
+    __m256i t2 = _mm256_unpacklo_epi32(x[w + 2], x[w + 3]);
+    __m256i t3 = _mm256_unpackhi_epi32(x[w + 2], x[w + 3]);
+    __m256i t4 = _mm256_unpacklo_epi32(x[w + 4], x[w + 5]);
+    __m256i t5 = _mm256_unpackhi_epi32(x[w + 4], x[w + 5]);
+    __m256i t6 = _mm256_unpacklo_epi32(x[w + 6], x[w + 7]);
+    __m256i t7 = _mm256_unpackhi_epi32(x[w + 6], x[w + 7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    _mm256_store_si256((__m256i *) (ks[0] + 4 * w), _mm256_permute2x128_si256(u0, u4, 0x20));
+    _mm256_store_si256((__m256i *) (ks[1] + 4 * w), _mm256_permute2x128_si256(u1, u5, 0x20));
+    _mm256_store_si256((__m256i *) (ks[2] + 4 * w), _mm256_permute2x128_si256(u2, u6, 0x20));
+    _mm256_store_si256((__m256i *) (ks[3] + 4 * w), _mm256_permute2x128_si256(u3, u7, 0x20));
+    _mm256_store_si256((__m256i *) (ks[4] + 4 * w), _mm256_permute2x128_si256(u0, u4, 0x31));
+    _mm256_store_si256((__m256i *) (ks[5] + 4 * w), _mm256_permute2x128_si256(u1, u5, 0x31));
+    _mm256_store_si256((__m256i *) (ks[6] + 4 * w), _mm256_permute2x128_si256(u2, u6, 0x31));
+    _mm256_store_si256((__m256i *) (ks[7] + 4 * w), _mm256_permute2x128_si256(u3, u7, 0x31));
+}
+
+/* one ChaCha20 block per lane, from the lane states in st[word][lane] */
+static void
+multi_chacha_blocks(unsigned char ks[MULTI_LANES][64],
+                    const uint32_t st[16][MULTI_LANES])
+{
+    const __m256i rot16 =
+        _mm256_set_epi8(13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2,
+                        13, 12, 15, 14, 9, 8, 11, 10, 5, 4, 7, 6, 1, 0, 3, 2);
+    const __m256i rot8 =
+        _mm256_set_epi8(14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3,
+                        14, 13, 12, 15, 10, 9, 8, 11, 6, 5, 4, 7, 2, 1, 0, 3);
+    __m256i x[16];
+    int     i;
+
+    for (i = 0; i < 16; i++) {
+        x[i] = _mm256_load_si256((const __m256i *) st[i]);
+    }
+    for (i = 0; i < ROUNDS; i += 2) {
+        MULTI_QUARTERROUND(0, 4, 8, 12);
+        MULTI_QUARTERROUND(1, 5, 9, 13);
+        MULTI_QUARTERROUND(2, 6, 10, 14);
+        MULTI_QUARTERROUND(3, 7, 11, 15);
+        MULTI_QUARTERROUND(0, 5, 10, 15);
+        MULTI_QUARTERROUND(1, 6, 11, 12);
+        MULTI_QUARTERROUND(2, 7, 8, 13);
+        MULTI_QUARTERROUND(3, 4, 9, 14);
+    }
+    for (i = 0; i < 16; i++) {
+        x[i] = _mm256_add_epi32(x[i], _mm256_load_si256((const __m256i *) st[i]));
+    }
+    multi_transpose(ks, x, 0);
+    multi_transpose(ks, x, 8);
+}
+
+/* out = in ^ ks, len <= 64 */
+static void
+multi_xor(unsigned char *out, const unsigned char *in, const unsigned char *ks,
+          unsigned long long len)
+{
+    unsigned long long j = 0;
+
+    if (len == 64) {
+        _mm256_storeu_si256((__m256i *) out,
+                            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) in),
+                                             _mm256_load_si256((const __m256i *) ks)));
+        _mm256_storeu_si256((__m256i *) (out + 32),
+                            _mm256_xor_si256(_mm256_loadu_si256((const __m256i *) (in + 32)),
+                                             _mm256_load_si256((const __m256i *) (ks + 32))));
+        return;
+    }
+    for (; j + 16 <= len; j += 16) {
+        _mm_storeu_si128((__m128i *) (out + j),
+                         _mm_xor_si128(_mm_loadu_si128((const __m128i *) (in + j)),
+                                       _mm_load_si128((const __m128i *) (ks + j))));
+    }
+    for (; j < len; j++) {
+        out[j] = in[j] ^ ks[j];
+    }
+}
+
+static void
+multi_chacha_lane(uint32_t st[16][MULTI_LANES], size_t l,
+                  const unsigned char *npub, const unsigned char *k,
+                  uint32_t block)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        st[4 + i][l] = LOAD32_LE(k + 4 * i);
+    }
+    st[12][l] = block;
+    for (i = 0; i < 3; i++) {
+        st[13 + i][l] = LOAD32_LE(npub + 4 * i);
+    }
+}
+
+/*
+ * Block 0 of every message to polykey, the Poly1305 keys, and the
+ * following blocks XORed with in into out. From block 1 (block == 1),
+ * polykey is not used
+ */
+static void
+multi_chacha(unsigned char (*polykey)[32], unsigned char * const *out,
+             const unsigned char * const *in, const unsigned long long *inlen,
+             const unsigned char * const *npub, const unsigned char * const *k,
+             size_t n, uint32_t block)
+{
+    CRYPTO_ALIGN(32) uint32_t      st[16][MULTI_LANES];
+    CRYPTO_ALIGN(32) unsigned char ks[MULTI_LANES][64];
+    size_t                         msg[MULTI_LANES];
+    size_t                         next = 0;
+    size_t                         active = 0;
+    size_t                         i;
+    size_t                         l;
+    unsigned long long             offset;
+
+    memset(st, 0, sizeof st);
+    for (l = 0; l < MULTI_LANES; l++) {
+        st[0][l] = 0x61707865;
+        st[1][l] = 0x3320646e;
+        st[2][l] = 0x79622d32;
+        st[3][l] = 0x6b206574;
+        msg[l] = MULTI_IDLE;
+        if (next < n) {
+            msg[l] = next;
+            multi_chacha_lane(st, l, npub[next], k[next], block);
+            next++;
+            active++;
+        }
+    }
+    while (active > 0) {
+        multi_chacha_blocks(ks, st);
+        for (l = 0; l < MULTI_LANES; l++) {
+            if ((i = msg[l]) == MULTI_IDLE) {
+                continue;
+            }
+            if (st[12][l] == 0) {
+                memcpy(polykey[i], ks[l], 32);
+            } else {
+                offset = 64 * (unsigned long long) (st[12][l] - 1);
+                multi_xor(out[i] + offset, in[i] + offset, ks[l],
+                          inlen[i] - offset < 64 ? inlen[i] - offset : 64);
+            }
+            if (64 * (unsigned long long) st[12][l] < inlen[i]) {
+                st[12][l]++;
+            } else if (next < n) {
+                msg[l] = next;
+                multi_chacha_lane(st, l, npub[next], k[next], block);
+                next++;
+            } else {
+                msg[l] = MULTI_IDLE;
+                active--;
+            }
+        }
+    }
+    sodium_memzero(st, sizeof st);
+    sodium_memzero(ks, sizeof ks);
+}
+
+/* Poly1305 with 26 bit limbs, 4 lanes per vector, r and h of lane l in
+ * r[limb][l] and h[limb][l], and s5 = 5 * r */
+typedef struct multi_poly_state {
+    CRYPTO_ALIGN(32) uint64_t h[5][MULTI_LANES];
+    CRYPTO_ALIGN(32) uint64_t r[5][MULTI_LANES];
+    CRYPTO_ALIGN(32) uint64_t s5[5][MULTI_LANES];
+    uint32_t                  pad[4][MULTI_LANES];
+} multi_poly_state;
+
+static void
+multi_poly_blocks(multi_poly_state *st, const unsigned char * const *b)
+{
+    const __m256i mask = _mm256_set1_epi64x(0x3ffffff);
+    const __m256i hibit = _mm256_set1_epi64x(1 << 24);
+    __m256i       lo, hi, m[5], h[5], r[5], s[5], d[5], c;
+    int           g;
+    int           i;
+
+    for (g = 0; g < MULTI_LANES; g += 4) {
+        lo = _mm256_set_epi64x((long long) LOAD64_LE(b[g + 3]), (long long) LOAD64_LE(b[g + 2]),
+                               (long long) LOAD64_LE(b[g + 1]), (long long) LOAD64_LE(b[g + 0]));
+        hi = _mm256_set_epi64x((long long) LOAD64_LE(b[g + 3] + 8), (long long) LOAD64_LE(b[g + 2] + 8),
+                               (long long) LOAD64_LE(b[g + 1] + 8), (long long) LOAD64_LE(b[g + 0] + 8));
+        m[0] = _mm256_and_si256(lo, mask);
+        m[1] = _mm256_and_si256(_mm256_srli_epi64(lo, 26), mask);
+        m[2] = _mm256_and_si256(_mm256_or_si256(_mm256_srli_epi64(lo, 52),
+                                                _mm256_slli_epi64(hi, 12)), mask);
+        m[3] = _mm256_and_si256(_mm256_srli_epi64(hi, 14), mask);
+        m[4] = _mm256_or_si256(_mm256_srli_epi64(hi, 40), hibit);
+        for (i = 0; i < 5; i++) {
+            h[i] = _mm256_add_epi64(_mm256_load_si256((const __m256i *) &st->h[i][g]), m[i]);
+            r[i] = _mm256_load_si256((const __m256i *) &st->r[i][g]);
+            s[i] = _mm256_load_si256((const __m256i *) &st->s5[i][g]);
+        }
+        d[0] = _mm256_add_epi64(
+            _mm256_add_epi64(_mm256_mul_epu32(h[0], r[0]), _mm256_mul_epu32(h[1], s[4])),
+            _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], s[3]), _mm256_mul_epu32(h[3], s[2])),
+                             _mm256_mul_epu32(h[4], s[1])));
+        d[1] = _mm256_add_epi64(
+            _mm256_add_epi64(_mm256_mul_epu32(h[0], r[1]), _mm256_mul_epu32(h[1], r[0])),
+            _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], s[4]), _mm256_mul_epu32(h[3], s[3])),
+                             _mm256_mul_epu32(h[4], s[2])));
+        d[2] = _mm256_add_epi64(
+            _mm256_add_epi64(_mm256_mul_epu32(h[0], r[2]), _mm256_mul_epu32(h[1], r[1])),
+            _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], r[0]), _mm256_mul_epu32(h[3], s[4])),
+                             _mm256_mul_epu32(h[4], s[3])));
+        d[3] = _mm256_add_epi64(
+            _mm256_add_epi64(_mm256_mul_epu32(h[0], r[3]), _mm256_mul_epu32(h[1], r[2])),
+            _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], r[1]), _mm256_mul_epu32(h[3], r[0])),
+                             _mm256_mul_epu32(h[4], s[4])));
+        d[4] = _mm256_add_epi64(
+            _mm256_add_epi64(_mm256_mul_epu32(h[0], r[4]), _mm256_mul_epu32(h[1], r[3])),
+            _mm256_add_epi64(_mm256_add_epi64(_mm256_mul_epu32(h[2], r[2]), _mm256_mul_epu32(h[3], r[1])),
+                             _mm256_mul_epu32(h[4], r[0])));
+        c = _mm256_srli_epi64(d[0], 26);
+        h[0] = _mm256_and_si256(d[0], mask);
+        d[1] = _mm256_add_epi64(d[1], c);
+        c = _mm256_srli_epi64(d[1], 26);
+        h[1] = _mm256_and_si256(d[1], mask);
+        d[2] = _mm256_add_epi64(d[2], c);
+        c = _mm256_srli_epi64(d[2], 26);
+        h[2] = _mm256_and_si256(d[2], mask);
+        d[3] = _mm256_add_epi64(d[3], c);
+        c = _mm256_srli_epi64(d[3], 26);
+        h[3] = _mm256_and_si256(d[3], mask);
+        d[4] = _mm256_add_epi64(d[4], c);
+        c = _mm256_srli_epi64(d[4], 26);
+        h[4] = _mm256_and_si256(d[4], mask);
+        h[0] = _mm256_add_epi64(h[0], _mm256_add_epi64(c, _mm256_slli_epi64(c, 2)));
+        c = _mm256_srli_epi64(h[0], 26);
+        h[0] = _mm256_and_si256(h[0], mask);
+        h[1] = _mm256_add_epi64(h[1], c);
+        for (i = 0; i < 5; i++) {
+            _mm256_store_si256((__m256i *) &st->h[i][g], h[i]);
+        }
+    }
+}
+
+static void
+multi_poly_lane(multi_poly_state *st, size_t l, const unsigned char key[32])
+{
+    const uint32_t t0 = LOAD32_LE(key + 0);
+    const uint32_t t1 = LOAD32_LE(key + 4);
+    const uint32_t t2 = LOAD32_LE(key + 8);
+    const uint32_t t3 = LOAD32_LE(key + 12);
+    int            i;
+
+    st->r[0][l] = t0 & 0x3ffffff;
+    st->r[1][l] = ((t0 >> 26) | (t1 << 6)) & 0x3ffff03;
+    st->r[2][l] = ((t1 >> 20) | (t2 << 12)) & 0x3ffc0ff;
+    st->r[3][l] = ((t2 >> 14) | (t3 << 18)) & 0x3f03fff;
+    st->r[4][l] = (t3 >> 8) & 0x00fffff;
+    for (i = 0; i < 5; i++) {
+        st->s5[i][l] = st->r[i][l] * 5;
+        st->h[i][l] = 0;
+    }
+    for (i = 0; i < 4; i++) {
+        st->pad[i][l] = LOAD32_LE(key + 16 + 4 * i);
+    }
+}
+
+static void
+multi_poly_finish(multi_poly_state *st, size_t l, unsigned char mac[16])
+{
+    uint32_t h0 = (uint32_t) st->h[0][l], h1 = (uint32_t) st->h[1][l];
+    uint32_t h2 = (uint32_t) st->h[2][l], h3 = (uint32_t) st->h[3][l];
+    uint32_t h4 = (uint32_t) st->h[4][l];
+    uint32_t c, g0, g1, g2, g3, g4, mask;
+    uint64_t f;
+
+    c = h1 >> 26; h1 &= 0x3ffffff;
+    h2 += c; c = h2 >> 26; h2 &= 0x3ffffff;
+    h3 += c; c = h3 >> 26; h3 &= 0x3ffffff;
+    h4 += c; c = h4 >> 26; h4 &= 0x3ffffff;
+    h0 += c * 5; c = h0 >> 26; h0 &= 0x3ffffff;
+    h1 += c;
+
+    g0 = h0 + 5; c = g0 >> 26; g0 &= 0x3ffffff;
+    g1 = h1 + c; c = g1 >> 26; g1 &= 0x3ffffff;
+    g2 = h2 + c; c = g2 >> 26; g2 &= 0x3ffffff;
+    g3 = h3 + c; c = g3 >> 26; g3 &= 0x3ffffff;
+    g4 = h4 + c - (1UL << 26);
+
+    mask = (g4 >> 31) - 1;
+    g0 &= mask; g1 &= mask; g2 &= mask; g3 &= mask; g4 &= mask;
+    mask = ~mask;
+    h0 = (h0 & mask) | g0;
+    h1 = (h1 & mask) | g1;
+    h2 = (h2 & mask) | g2;
+    h3 = (h3 & mask) | g3;
+    h4 = (h4 & mask) | g4;
+
+    h0 = ((h0) | (h1 << 26)) & 0xffffffff;
+    h1 = ((h1 >> 6) | (h2 << 20)) & 0xffffffff;
+    h2 = ((h2 >> 12) | (h3 << 14)) & 0xffffffff;
+    h3 = ((h3 >> 18) | (h4 << 8)) & 0xffffffff;
+
+    f = (uint64_t) h0 + st->pad[0][l];
+    h0 = (uint32_t) f;
+    f = (uint64_t) h1 + st->pad[1][l] + (f >> 32);
+    h1 = (uint32_t) f;
+    f = (uint64_t) h2 + st->pad[2][l] + (f >> 32);
+    h2 = (uint32_t) f;
+    f = (uint64_t) h3 + st->pad[3][l] + (f >> 32);
+    h3 = (uint32_t) f;
+
+    STORE32_LE(mac + 0, h0);
+    STORE32_LE(mac + 4, h1);
+    STORE32_LE(mac + 8, h2);
+    STORE32_LE(mac + 12, h3);
+}
+
+/* where a lane is in ad || pad || c || pad || le64(adlen) || le64(clen) */
+typedef struct multi_poly_cursor {
+    unsigned long long pos;
+    int                part;
+    unsigned char      block[16];
+} multi_poly_cursor;
+
+static const unsigned char *
+multi_poly_next(multi_poly_cursor *cur, const unsigned char *ad,
+                unsigned long long adlen, const unsigned char *c,
+                unsigned long long clen)
+{
+    const unsigned char *p;
+    unsigned long long   len;
+
+    while (cur->part < 2) {
+        p = cur->part == 0 ? ad : c;
+        len = cur->part == 0 ? adlen : clen;
+        if (cur->pos < len) {
+            p += cur->pos;
+            if (len - cur->pos < 16) {
+                memset(cur->block, 0, 16);
+                memcpy(cur->block, p, (size_t) (len - cur->pos));
+                p = cur->block;
+            }
+            cur->pos += 16;
+            return p;
+        }
+        cur->part++;
+        cur->pos = 0;
+    }
+    STORE64_LE(cur->block, (uint64_t) adlen);
+    STORE64_LE(cur->block + 8, (uint64_t) clen);
+    cur->part++;
+
+    return cur->block;
+}
+
+/*
+ * The tags of n messages, mac[i] from polykey[i] over ad[i] and the cipher
+ * text c[i]
+ */
+static void
+multi_poly(unsigned char * const *mac, const unsigned char (*polykey)[32],
+           const unsigned char * const *c, const unsigned long long *clen,
+           const unsigned char * const *ad, const unsigned long long *adlen,
+           size_t n)
+{
+    static const unsigned char zero[32] = { 0 };
+    multi_poly_state           st;
+    multi_poly_cursor          cur[MULTI_LANES];
+    const unsigned char       *b[MULTI_LANES];
+    size_t                     msg[MULTI_LANES];
+    size_t                     next = 0;
+    size_t                     active = 0;
+    size_t                     i;
+    size_t                     l;
+
+    memset(&st, 0, sizeof st);
+    for (l = 0; l < MULTI_LANES; l++) {
+        msg[l] = MULTI_IDLE;
+        if (next < n) {
+            msg[l] = next;
+            multi_poly_lane(&st, l, polykey[next]);
+            memset(&cur[l], 0, sizeof cur[l]);
+            next++;
+            active++;
+        }
+    }
+    while (active > 0) {
+        for (l = 0; l < MULTI_LANES; l++) {
+            i = msg[l];
+            b[l] = i == MULTI_IDLE ? zero :
+                multi_poly_next(&cur[l], ad[i], adlen[i], c[i], clen[i]);
+        }
+        multi_poly_blocks(&st, b);
+        for (l = 0; l < MULTI_LANES; l++) {
+            if ((i = msg[l]) == MULTI_IDLE || cur[l].part < 3) {
+                continue;
+            }
+            multi_poly_finish(&st, l, mac[i]);
+            if (next < n) {
+                msg[l] = next;
+                multi_poly_lane(&st, l, polykey[next]);
+                memset(&cur[l], 0, sizeof cur[l]);
+                next++;
+            } else {
+                msg[l] = MULTI_IDLE;
+                multi_poly_lane(&st, l, zero);
+                active--;
+            }
+        }
+    }
+    sodium_memzero(&st, sizeof st);
+    sodium_memzero(cur, sizeof cur);
+}
+
+/*
+ * ChaCha20-Poly1305 (IETF) of n messages, each under its own key k[i] and
+ * nonce npub[i]. out[i] gets in[i] XORed with the key stream, and mac[i]
+ * the tag over ad[i] and the cipher text: out[i] when encrypting
+ * (decrypt == 0), in[i] when decrypting, which is then authenticated
+ * before it is XORed. out[i] may be in[i], but must not otherwise overlap
+ * it. At most CHACHA20POLY1305_MULTI_MAX messages.
+ */
+void
+_crypto_aead_chacha20poly1305_ietf_multi_avx2(unsigned char * const *mac,
+                                               unsigned char * const *out,
+                                               const unsigned char * const *in,
+                                               const unsigned long long *inlen,
+                                               const unsigned char * const *ad,
+                                               const unsigned long long *adlen,
+                                               const unsigned char * const *npub,
+                                               const unsigned char * const *k,
+                                               size_t n, int decrypt)
+{
+    static const unsigned long long none[CHACHA20POLY1305_MULTI_MAX] = { 0 };
+    CRYPTO_ALIGN(16) unsigned char  polykey[CHACHA20POLY1305_MULTI_MAX][32];
+
+    if (decrypt) {
+        /* the Poly1305 keys alone, the tags, then the key stream */
+        multi_chacha(polykey, out, in, none, npub, k, n, 0);
+        multi_poly(mac, (const unsigned char (*)[32]) polykey, in, inlen,
+                   ad, adlen, n);
+        multi_chacha(NULL, out, in, inlen, npub, k, n, 1);
+    } else {
+        multi_chacha(polykey, out, in, inlen, npub, k, n, 0);
+        multi_poly(mac, (const unsigned char (*)[32]) polykey,
+                   (const unsigned char * const *) out, inlen, ad, adlen, n);
+    }
+    sodium_memzero(polykey, sizeof polykey);
+}
+
 struct crypto_stream_chacha20_implementation
     crypto_stream_chacha20_dolbeau_avx2_implementation = {
         SODIUM_C99(.stream =) stream_ref,
@@ -0,0 +1,349 @@
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "crypto_stream_chacha20.h"
+#include "private/common.h"
+#include "utils.h"
+
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(USE_ARM64_KERNELS)
+
+# include <arm_neon.h>
+
+# include "../stream_chacha20.h"
+# include "chacha20_neon.h"
+
+# define ROUNDS 20
+
+typedef struct chacha_ctx {
+    uint32_t input[16];
+} chacha_ctx;
+
+static void
+chacha_keysetup(chacha_ctx *ctx, const uint8_t *k)
+{
+    ctx->input[0]  = 0x61707865;
+    ctx->input[1]  = 0x3320646e;
+    ctx->input[2]  = 0x79622d32;
+    ctx->input[3]  = 0x6b206574;
+    ctx->input[4]  = LOAD32_LE(k + 0);
+    ctx->input[5]  = LOAD32_LE(k + 4);
+    ctx->input[6]  = LOAD32_LE(k + 8);
+    ctx->input[7]  = LOAD32_LE(k + 12);
+    ctx->input[8]  = LOAD32_LE(k + 16);
+    ctx->input[9]  = LOAD32_LE(k + 20);
+    ctx->input[10] = LOAD32_LE(k + 24);
+    ctx->input[11] = LOAD32_LE(k + 28);
+}
+
+static void
+chacha_ivsetup(chacha_ctx *ctx, const uint8_t *iv, const uint8_t *counter)
+{
+    ctx->input[12] = counter == NULL ? 0 : LOAD32_LE(counter + 0);
+    ctx->input[13] = counter == NULL ? 0 : LOAD32_LE(counter + 4);
+    ctx->input[14] = LOAD32_LE(iv + 0);
+    ctx->input[15] = LOAD32_LE(iv + 4);
+}
+
+static void
+chacha_ietf_ivsetup(chacha_ctx *ctx, const uint8_t *iv, const uint8_t *counter)
+{
+    ctx->input[12] = counter == NULL ? 0 : LOAD32_LE(counter);
+    ctx->input[13] = LOAD32_LE(iv + 0);
+    ctx->input[14] = LOAD32_LE(iv + 4);
+    ctx->input[15] = LOAD32_LE(iv + 8);
+}
+
+# define VROTL(X, N) vsriq_n_u32(vshlq_n_u32((X), (N)), (X), 32 - (N))
+# define VROTL16(X) \
+    vreinterpretq_u32_u16(vrev32q_u16(vreinterpretq_u16_u32(X)))
+
+/*
+ * 4 blocks at a time, one vector per state word holding that word of the
+ * 4 blocks, as dolbeau's u4.h does with SSE.
+ */
+# define VEC4_QUARTERROUND(A, B, C, D)      \
+    x##A = vaddq_u32(x##A, x##B);           \
+    x##D = VROTL16(veorq_u32(x##D, x##A));  \
+    x##C = vaddq_u32(x##C, x##D);           \
+    x##B = VROTL(veorq_u32(x##B, x##C), 12); \
+    x##A = vaddq_u32(x##A, x##B);           \
+    x##D = VROTL(veorq_u32(x##D, x##A), 8);  \
+    x##C = vaddq_u32(x##C, x##D);           \
+    x##B = VROTL(veorq_u32(x##B, x##C), 7)
+
+/* the words A ... D of the 4 blocks, xored into 16 bytes of each block */
+static inline void
+chacha20_neon_quad(unsigned char *c, const unsigned char *m, uint32x4_t a,
+                   uint32x4_t b, uint32x4_t cc, uint32x4_t d)
+{
+    const uint32x4_t ab_lo = vzip1q_u32(a, b);
+    const uint32x4_t ab_hi = vzip2q_u32(a, b);
+    const uint32x4_t cd_lo = vzip1q_u32(cc, d);
+    const uint32x4_t cd_hi = vzip2q_u32(cc, d);
+    uint32x4_t       block[4];
+    int              i;
+
+    block[0] = vreinterpretq_u32_u64(vzip1q_u64(vreinterpretq_u64_u32(ab_lo),
+                                                vreinterpretq_u64_u32(cd_lo)));
+    block[1] = vreinterpretq_u32_u64(vzip2q_u64(vreinterpretq_u64_u32(ab_lo),
+                                                vreinterpretq_u64_u32(cd_lo)));
+    block[2] = vreinterpretq_u32_u64(vzip1q_u64(vreinterpretq_u64_u32(ab_hi),
+                                                vreinterpretq_u64_u32(cd_hi)));
+    block[3] = vreinterpretq_u32_u64(vzip2q_u64(vreinterpretq_u64_u32(ab_hi),
+                                                vreinterpretq_u64_u32(cd_hi)));
+    for (i = 0; i < 4; i++) {
+        vst1q_u8(c + i * 64,
+                 veorq_u8(vreinterpretq_u8_u32(block[i]), vld1q_u8(m + i * 64)));
+    }
+}
+
+/* one block, one vector per row of the state */
+static inline void
+chacha20_neon_block(uint32x4_t out[4], const uint32_t x[16])
+{
+    uint32x4_t x0 = vld1q_u32(x + 0);
+    uint32x4_t x1 = vld1q_u32(x + 4);
+    uint32x4_t x2 = vld1q_u32(x + 8);
+    uint32x4_t x3 = vld1q_u32(x + 12);
+    int        i;
+
+    for (i = 0; i < ROUNDS; i += 2) {
+        x0 = vaddq_u32(x0, x1);
+        x3 = VROTL16(veorq_u32(x3, x0));
+        x2 = vaddq_u32(x2, x3);
+        x1 = VROTL(veorq_u32(x1, x2), 12);
+        x0 = vaddq_u32(x0, x1);
+        x3 = VROTL(veorq_u32(x3, x0), 8);
+        x2 = vaddq_u32(x2, x3);
+        x1 = VROTL(veorq_u32(x1, x2), 7);
+
+        x1 = vextq_u32(x1, x1, 1);
+        x2 = vextq_u32(x2, x2, 2);
+        x3 = vextq_u32(x3, x3, 3);
+
+        x0 = vaddq_u32(x0, x1);
+        x3 = VROTL16(veorq_u32(x3, x0));
+        x2 = vaddq_u32(x2, x3);
+        x1 = VROTL(veorq_u32(x1, x2), 12);
+        x0 = vaddq_u32(x0, x1);
+        x3 = VROTL(veorq_u32(x3, x0), 8);
+        x2 = vaddq_u32(x2, x3);
+        x1 = VROTL(veorq_u32(x1, x2), 7);
+
+        x1 = vextq_u32(x1, x1, 3);
+        x2 = vextq_u32(x2, x2, 2);
+        x3 = vextq_u32(x3, x3, 1);
+    }
+    out[0] = vaddq_u32(x0, vld1q_u32(x + 0));
+    out[1] = vaddq_u32(x1, vld1q_u32(x + 4));
+    out[2] = vaddq_u32(x2, vld1q_u32(x + 8));
+    out[3] = vaddq_u32(x3, vld1q_u32(x + 12));
+}
+
+static void
+chacha20_encrypt_bytes(chacha_ctx *ctx, const uint8_t *m, uint8_t *c,
+                       unsigned long long bytes)
+{
+    uint32_t * const x = &ctx->input[0];
+    uint64_t         counter;
+
+    if (!bytes) {
+        return; /* LCOV_EXCL_LINE */
+    }
+    if (bytes > crypto_stream_chacha20_MESSAGEBYTES_MAX) {
+        sodium_misuse();
+    }
+    counter = ((uint64_t) x[12]) | (((uint64_t) x[13]) << 32);
+
+    while (bytes >= 256) {
+        uint32x4_t x0  = vdupq_n_u32(x[0]);
+        uint32x4_t x1  = vdupq_n_u32(x[1]);
+        uint32x4_t x2  = vdupq_n_u32(x[2]);
+        uint32x4_t x3  = vdupq_n_u32(x[3]);
+        uint32x4_t x4  = vdupq_n_u32(x[4]);
+        uint32x4_t x5  = vdupq_n_u32(x[5]);
+        uint32x4_t x6  = vdupq_n_u32(x[6]);
+        uint32x4_t x7  = vdupq_n_u32(x[7]);
+        uint32x4_t x8  = vdupq_n_u32(x[8]);
+        uint32x4_t x9  = vdupq_n_u32(x[9]);
+        uint32x4_t x10 = vdupq_n_u32(x[10]);
+        uint32x4_t x11 = vdupq_n_u32(x[11]);
+        uint32x4_t x12, x13;
+        uint32x4_t x14 = vdupq_n_u32(x[14]);
+        uint32x4_t x15 = vdupq_n_u32(x[15]);
+        uint32x4_t orig12, orig13;
+        uint32_t   in12[4], in13[4];
+        int        i;
+
+        for (i = 0; i < 4; i++) {
+            in12[i] = (uint32_t) (counter + i);
+            in13[i] = (uint32_t) ((counter + i) >> 32);
+        }
+        x12 = orig12 = vld1q_u32(in12);
+        x13 = orig13 = vld1q_u32(in13);
+
+        for (i = 0; i < ROUNDS; i += 2) {
+            VEC4_QUARTERROUND(0, 4, 8, 12);
+            VEC4_QUARTERROUND(1, 5, 9, 13);
+            VEC4_QUARTERROUND(2, 6, 10, 14);
+            VEC4_QUARTERROUND(3, 7, 11, 15);
+            VEC4_QUARTERROUND(0, 5, 10, 15);
+            VEC4_QUARTERROUND(1, 6, 11, 12);
+            VEC4_QUARTERROUND(2, 7, 8, 13);
+            VEC4_QUARTERROUND(3, 4, 9, 14);
+        }
+        chacha20_neon_quad(c + 0, m + 0,
+                           vaddq_u32(x0, vdupq_n_u32(x[0])),
+                           vaddq_u32(x1, vdupq_n_u32(x[1])),
+                           vaddq_u32(x2, vdupq_n_u32(x[2])),
+                           vaddq_u32(x3, vdupq_n_u32(x[3])));
+        chacha20_neon_quad(c + 16, m + 16,
+                           vaddq_u32(x4, vdupq_n_u32(x[4])),
+                           vaddq_u32(x5, vdupq_n_u32(x[5])),
+                           vaddq_u32(x6, vdupq_n_u32(x[6])),
+                           vaddq_u32(x7, vdupq_n_u32(x[7])));
+        chacha20_neon_quad(c + 32, m + 32,
+                           vaddq_u32(x8, vdupq_n_u32(x[8])),
+                           vaddq_u32(x9, vdupq_n_u32(x[9])),
+                           vaddq_u32(x10, vdupq_n_u32(x[10])),
+                           vaddq_u32(x11, vdupq_n_u32(x[11])));
+        chacha20_neon_quad(c + 48, m + 48,
+                           vaddq_u32(x12, orig12),
+                           vaddq_u32(x13, orig13),
+                           vaddq_u32(x14, vdupq_n_u32(x[14])),
+                           vaddq_u32(x15, vdupq_n_u32(x[15])));
+
+        counter += 4;
+        x[12] = (uint32_t) counter;
+        x[13] = (uint32_t) (counter >> 32);
+        bytes -= 256;
+        c += 256;
+        m += 256;
+    }
+    while (bytes >= 64) {
+        uint32x4_t block[4];
+        int        i;
+
+        chacha20_neon_block(block, x);
+        for (i = 0; i < 4; i++) {
+            vst1q_u8(c + i * 16, veorq_u8(vreinterpretq_u8_u32(block[i]),
+                                          vld1q_u8(m + i * 16)));
+        }
+        counter++;
+        x[12] = (uint32_t) counter;
+        x[13] = (uint32_t) (counter >> 32);
+        bytes -= 64;
+        c += 64;
+        m += 64;
+    }
+    if (bytes > 0) {
+        uint32x4_t   block[4];
+        uint8_t      partialblock[64];
+        unsigned int i;
+
+        chacha20_neon_block(block, x);
+        for (i = 0; i < 4; i++) {
+            vst1q_u8(partialblock + i * 16, vreinterpretq_u8_u32(block[i]));
+        }
+        for (i = 0; i < bytes; i++) {
+            c[i] = m[i] ^ partialblock[i];
+        }
+        sodium_memzero(partialblock, sizeof partialblock);
+    }
+}
+
+static int
+stream_ref(unsigned char *c, unsigned long long clen, const unsigned char *n,
+           const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+
+    if (!clen) {
+        return 0;
+    }
+    COMPILER_ASSERT(crypto_stream_chacha20_KEYBYTES == 256 / 8);
+    chacha_keysetup(&ctx, k);
+    chacha_ivsetup(&ctx, n, NULL);
+    memset(c, 0, clen);
+    chacha20_encrypt_bytes(&ctx, c, c, clen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+static int
+stream_ietf_ref(unsigned char *c, unsigned long long clen,
+                const unsigned char *n, const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+
+    if (!clen) {
+        return 0;
+    }
+    COMPILER_ASSERT(crypto_stream_chacha20_KEYBYTES == 256 / 8);
+    chacha_keysetup(&ctx, k);
+    chacha_ietf_ivsetup(&ctx, n, NULL);
+    memset(c, 0, clen);
+    chacha20_encrypt_bytes(&ctx, c, c, clen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+static int
+stream_ref_xor_ic(unsigned char *c, const unsigned char *m,
+                  unsigned long long mlen, const unsigned char *n, uint64_t ic,
+                  const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+    uint8_t           ic_bytes[8];
+    uint32_t          ic_high;
+    uint32_t          ic_low;
+
+    if (!mlen) {
+        return 0;
+    }
+    ic_high = (uint32_t) (ic >> 32);
+    ic_low  = (uint32_t) ic;
+    STORE32_LE(&ic_bytes[0], ic_low);
+    STORE32_LE(&ic_bytes[4], ic_high);
+    chacha_keysetup(&ctx, k);
+    chacha_ivsetup(&ctx, n, ic_bytes);
+    chacha20_encrypt_bytes(&ctx, m, c, mlen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+static int
+stream_ietf_ref_xor_ic(unsigned char *c, const unsigned char *m,
+                       unsigned long long mlen, const unsigned char *n,
+                       uint32_t ic, const unsigned char *k)
+{
+    struct chacha_ctx ctx;
+    uint8_t           ic_bytes[4];
+
+    if (!mlen) {
+        return 0;
+    }
+    STORE32_LE(ic_bytes, ic);
+    chacha_keysetup(&ctx, k);
+    chacha_ietf_ivsetup(&ctx, n, ic_bytes);
+    chacha20_encrypt_bytes(&ctx, m, c, mlen);
+    sodium_memzero(&ctx, sizeof ctx);
+
+    return 0;
+}
+
+struct crypto_stream_chacha20_implementation
+    crypto_stream_chacha20_neon_implementation = {
+        SODIUM_C99(.stream =) stream_ref,
+        SODIUM_C99(.stream_ietf =) stream_ietf_ref,
+        SODIUM_C99(.stream_xor_ic =) stream_ref_xor_ic,
+        SODIUM_C99(.stream_ietf_xor_ic =) stream_ietf_ref_xor_ic
+    };
+
+#endif
@@ -13,6 +13,9 @@
 #if defined(HAVE_EMMINTRIN_H) && defined(HAVE_TMMINTRIN_H)
 # include "dolbeau/chacha20_dolbeau-ssse3.h"
 #endif
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(USE_ARM64_KERNELS)
+# include "neon/chacha20_neon.h"
+#endif
 
 static const crypto_stream_chacha20_implementation *implementation =
     &crypto_stream_chacha20_ref_implementation;
@@ -125,6 +128,12 @@ _crypto_stream_chacha20_pick_best_implementation(void)
         implementation = &crypto_stream_chacha20_dolbeau_ssse3_implementation;
         return 0;
     }
+#endif
+#if defined(__aarch64__) && defined(__ARM_NEON) && defined(USE_ARM64_KERNELS)
+    if (sodium_runtime_has_neon()) {
+        implementation = &crypto_stream_chacha20_neon_implementation;
+        return 0;
+    }
 #endif
     return 0;
 }
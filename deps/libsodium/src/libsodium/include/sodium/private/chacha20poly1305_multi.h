@@ -0,0 +1,41 @@
+#ifndef chacha20poly1305_multi_H
+#define chacha20poly1305_multi_H
+
+#include <stddef.h>
+
+/* messages per call of the multi-buffer kernel */
+#define CHACHA20POLY1305_MULTI_MAX 64
+
+/* longer messages are sealed on their own, by the 8 block code */
+#define CHACHA20POLY1305_MULTI_MAXBYTES 512
+
+void _crypto_aead_chacha20poly1305_ietf_multi_avx2(unsigned char * const *mac,
+                                                    unsigned char * const *out,
+                                                    const unsigned char * const *in,
+                                                    const unsigned long long *inlen,
+                                                    const unsigned char * const *ad,
+                                                    const unsigned long long *adlen,
+                                                    const unsigned char * const *npub,
+                                                    const unsigned char * const *k,
+                                                    size_t n, int decrypt);
+
+int _crypto_aead_chacha20poly1305_ietf_encrypt_multi(unsigned char * const *c,
+                                                     const unsigned char * const *m,
+                                                     const unsigned long long *mlen,
+                                                     const unsigned char * const *ad,
+                                                     const unsigned long long *adlen,
+                                                     const unsigned char * const *npub,
+                                                     const unsigned char * const *k,
+                                                     size_t n);
+
+int _crypto_aead_chacha20poly1305_ietf_decrypt_multi(unsigned char *ok,
+                                                     unsigned char * const *m,
+                                                     const unsigned char * const *c,
+                                                     const unsigned long long *clen,
+                                                     const unsigned char * const *ad,
+                                                     const unsigned long long *adlen,
+                                                     const unsigned char * const *npub,
+                                                     const unsigned char * const *k,
+                                                     size_t n);
+
+#endif
@@ -2,6 +2,7 @@
 #define implementations_H
 
 int _crypto_generichash_blake2b_pick_best_implementation(void);
+int _crypto_hash_sha256_pick_best_implementation(void);
 int _crypto_onetimeauth_poly1305_pick_best_implementation(void);
 int _crypto_pwhash_argon2_pick_best_implementation(void);
 int _crypto_scalarmult_curve25519_pick_best_implementation(void);
@@ -41,6 +41,12 @@ int sodium_runtime_has_aesni(void);
 SODIUM_EXPORT_WEAK
 int sodium_runtime_has_rdrand(void);
 
+SODIUM_EXPORT_WEAK
+int sodium_runtime_has_shani(void);
+
+SODIUM_EXPORT_WEAK
+int sodium_runtime_has_armcrypto(void);
+
 /* ------------------------------------------------------------------------- */
 
 int _sodium_runtime_get_cpu_features(void);
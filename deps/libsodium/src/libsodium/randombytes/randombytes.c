@@ -6,7 +6,7 @@
 
 #include <sys/types.h>
 
-#ifdef __EMSCRIPTEN__
+#if defined(__EMSCRIPTEN__) && !defined(SODIUM_WASM_STANDALONE)
 # include <emscripten.h>
 #endif
 
@@ -41,6 +41,13 @@ static const randombytes_implementation *implementation;
 # endif
 #endif
 
+#ifdef SODIUM_WASM_STANDALONE
+/* Standalone WebAssembly builds have no JavaScript glue: the host fills
+ * `size` bytes at `buf` with random data, crypto.randomFillSync in node */
+__attribute__((import_module("sodium"), import_name("random_fill")))
+extern void sodium_random_fill(void *buf, size_t size);
+#endif
+
 static void
 randombytes_init_if_needed(void)
 {
@@ -75,6 +82,11 @@ randombytes_random(void)
 #ifndef __EMSCRIPTEN__
     randombytes_init_if_needed();
     return implementation->random();
+#elif defined(SODIUM_WASM_STANDALONE)
+    uint32_t r;
+
+    sodium_random_fill(&r, sizeof r);
+    return r;
 #else
     return EM_ASM_INT_V({
         return Module.getRandomValue();
@@ -90,7 +102,7 @@ randombytes_stir(void)
     if (implementation->stir != NULL) {
         implementation->stir();
     }
-#else
+#elif !defined(SODIUM_WASM_STANDALONE)
     EM_ASM({
         if (Module.getRandomValue === undefined) {
             try {
@@ -154,6 +166,10 @@ randombytes_buf(void * const buf, const size_t size)
     if (size > (size_t) 0U) {
         implementation->buf(buf, size);
     }
+#elif defined(SODIUM_WASM_STANDALONE)
+    if (size > (size_t) 0U) {
+        sodium_random_fill(buf, size);
+    }
 #else
     unsigned char *p = (unsigned char *) buf;
     size_t         i;
@@ -3,6 +3,9 @@
 #ifdef HAVE_ANDROID_GETCPUFEATURES
 # include <cpu-features.h>
 #endif
+#if defined(HAVE_ARMCRYPTO) && defined(__aarch64__) && defined(__linux__)
+# include <sys/auxv.h>
+#endif
 
 #include "private/common.h"
 #include "runtime.h"
@@ -20,12 +23,15 @@ typedef struct CPUFeatures_ {
     int has_pclmul;
     int has_aesni;
     int has_rdrand;
+    int has_shani;
+    int has_armcrypto;
 } CPUFeatures;
 
 static CPUFeatures _cpu_features;
 
 #define CPUID_EBX_AVX2    0x00000020
 #define CPUID_EBX_AVX512F 0x00010000
+#define CPUID_EBX_SHA     0x20000000
 
 #define CPUID_ECX_SSE3    0x00000001
 #define CPUID_ECX_PCLMUL  0x00000002
@@ -42,10 +48,28 @@ static CPUFeatures _cpu_features;
 #define XCR0_SSE 0x00000002
 #define XCR0_AVX 0x00000004
 
+#define HWCAP_ARM64_AES   (1UL << 3)
+#define HWCAP_ARM64_PMULL (1UL << 4)
+#define HWCAP_ARM64_SHA2  (1UL << 6)
+#define HWCAP_ARM64_CRYPTO (HWCAP_ARM64_AES | HWCAP_ARM64_PMULL | HWCAP_ARM64_SHA2)
+
 static int
 _sodium_runtime_arm_cpu_features(CPUFeatures * const cpu_features)
 {
-#ifndef __arm__
+    cpu_features->has_armcrypto = 0;
+#if defined(HAVE_ARMCRYPTO) && defined(__aarch64__)
+# ifdef __APPLE__
+    cpu_features->has_armcrypto = 1;
+# elif defined(__linux__)
+    cpu_features->has_armcrypto =
+        (getauxval(AT_HWCAP) & HWCAP_ARM64_CRYPTO) == HWCAP_ARM64_CRYPTO;
+# endif
+#endif
+#ifdef __aarch64__
+    /* Advanced SIMD is part of every ARMv8-A core */
+    cpu_features->has_neon = 1;
+    return 0;
+#elif !defined(__arm__)
     cpu_features->has_neon = 0;
     return -1;
 #else
@@ -115,6 +139,30 @@ _sodium_runtime_intel_cpu_features(CPUFeatures * const cpu_features)
     unsigned int cpu_info[4];
     unsigned int id;
 
+#if defined(__EMSCRIPTEN__) && defined(__wasm_simd128__)
+    /* No cpuid: Emscripten compiles the SSE intrinsics to WebAssembly SIMD,
+     * so every SSE kernel the build has can run */
+    (void) cpu_info;
+    (void) id;
+    cpu_features->has_sse2 = cpu_features->has_sse3 = 0;
+    cpu_features->has_ssse3 = cpu_features->has_sse41 = 0;
+# ifdef HAVE_EMMINTRIN_H
+    cpu_features->has_sse2 = 1;
+# endif
+# ifdef HAVE_PMMINTRIN_H
+    cpu_features->has_sse3 = 1;
+# endif
+# ifdef HAVE_TMMINTRIN_H
+    cpu_features->has_ssse3 = 1;
+# endif
+# ifdef HAVE_SMMINTRIN_H
+    cpu_features->has_sse41 = 1;
+# endif
+    cpu_features->has_avx = cpu_features->has_avx2 = cpu_features->has_avx512f = 0;
+    cpu_features->has_shani = cpu_features->has_pclmul = 0;
+    cpu_features->has_aesni = cpu_features->has_rdrand = 0;
+    return 0;
+#endif
     _cpuid(cpu_info, 0x0);
     if ((id = cpu_info[0]) == 0U) {
         return -1; /* LCOV_EXCL_LINE */
@@ -190,6 +238,16 @@ _sodium_runtime_intel_cpu_features(CPUFeatures * const cpu_features)
     }
 #endif
 
+    cpu_features->has_shani = 0;
+#ifdef HAVE_SHANI
+    if (id >= 0x00000007) {
+        unsigned int cpu_info7[4];
+
+        _cpuid(cpu_info7, 0x00000007);
+        cpu_features->has_shani = ((cpu_info7[1] & CPUID_EBX_SHA) != 0x0);
+    }
+#endif
+
 #ifdef HAVE_WMMINTRIN_H
     cpu_features->has_pclmul = ((cpu_info[2] & CPUID_ECX_PCLMUL) != 0x0);
     cpu_features->has_aesni  = ((cpu_info[2] & CPUID_ECX_AESNI) != 0x0);
@@ -284,3 +342,15 @@ sodium_runtime_has_rdrand(void)
 {
     return _cpu_features.has_rdrand;
 }
+
+int
+sodium_runtime_has_shani(void)
+{
+    return _cpu_features.has_shani;
+}
+
+int
+sodium_runtime_has_armcrypto(void)
+{
+    return _cpu_features.has_armcrypto;
+}
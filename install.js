@@ -342,7 +342,37 @@ function isPreInstallMode() {
 }
 
 
+// Prebuilt binaries need no build, unless asked with --build-from-source
+function hasPrebuilds() {
+    if (process.env.npm_config_build_from_source) {
+        return false;
+    }
+    return require('./lib/prebuilds').available().some(function(tier) {
+        return tier.name === 'baseline';
+    });
+}
+
+// The WebAssembly build runs anywhere: a failed native build falls back
+// to it instead of failing the install
+function hasWasm() {
+    return !process.env.npm_config_build_from_source &&
+        fs.existsSync(require('./lib/prebuilds').wasm());
+}
+
 // Start
+if (hasPrebuilds()) {
+    console.log('Using prebuilt binaries in ' + require('./lib/prebuilds').dir());
+    process.exit(0);
+}
+
+if (hasWasm()) {
+    process.on('uncaughtException', function(err) {
+        console.log(err.message);
+        console.log('Native build failed, using the WebAssembly build in ' + require('./lib/prebuilds').wasm());
+        process.exit(0);
+    });
+}
+
 if (os.platform() !== 'win32') {
     if (isPreInstallMode()) {
         run('make libsodium');
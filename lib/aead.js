@@ -0,0 +1,318 @@
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var toBuffer = require('./toBuffer');
+var assert = require('assert');
+
+/**
+ * Algorithms an Aead box can be sealed with. The id is the first byte of
+ * every box, so any Aead holding the key can open it whatever the host that
+ * sealed it picked
+ */
+var ALGORITHMS = {
+    aes256gcm: {
+        id: 1,
+        name: 'aes256gcm',
+        npubbytes: binding.crypto_aead_aes256gcm_NPUBBYTES,
+        abytes: binding.crypto_aead_aes256gcm_ABYTES
+    },
+    xchacha20poly1305_ietf: {
+        id: 2,
+        name: 'xchacha20poly1305_ietf',
+        npubbytes: binding.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES,
+        abytes: binding.crypto_aead_xchacha20poly1305_ietf_ABYTES
+    }
+};
+
+var BY_ID = [];
+Object.keys(ALGORITHMS).forEach(function(name) {
+    BY_ID[ALGORITHMS[name].id] = ALGORITHMS[name];
+});
+
+/** Both algorithms take 32 byte keys */
+var KEYBYTES = binding.crypto_aead_xchacha20poly1305_ietf_KEYBYTES;
+
+/**
+ * Fastest algorithm on this host: AES-256-GCM when the CPU has AES-NI and
+ * PCLMUL, XChaCha20-Poly1305 everywhere else
+ * @returns {String}
+ */
+function best() {
+    return binding.crypto_aead_aes256gcm_is_available() ? 'aes256gcm' : 'xchacha20poly1305_ietf';
+}
+
+/**
+ * Authenticated encryption with additional data, on the fastest algorithm
+ * this host has.
+ *
+ * Boxes are self describing: one algorithm byte, the random nonce, then the
+ * cipher text and tag. Any Aead with the same key opens them, so a fleet of
+ * mixed hosts can share a key. A box sealed with AES-256-GCM cannot be
+ * opened on a host without AES-NI.
+ *
+ * AES-256-GCM nonces are 96 bit random values. Rotate the key well before
+ * 2^32 messages; XChaCha20-Poly1305 has no such limit.
+ *
+ * The key is copied into a native AeadContext, in guarded memory, and
+ * messages are sealed straight into the box buffer.
+ *
+ * @param {String|Buffer|Array} [key]  32 byte secret key. A random key is made when not given
+ * @param {String} [encoding]          encoding of key if it is a string
+ * @param {Object} [options]           `{ algorithm }`, `'auto'` (the default), `'aes256gcm'`
+ *                                     or `'xchacha20poly1305_ietf'`
+ * @constructor
+ */
+function Aead(key, encoding, options) {
+    if( typeof encoding == 'object' && encoding !== null ) {
+        options = encoding;
+        encoding = undefined;
+    }
+    options = options || {};
+
+    var name = !options.algorithm || options.algorithm === 'auto' ? best() : options.algorithm;
+    assert(ALGORITHMS[name], 'Aead algorithm must be auto, aes256gcm or xchacha20poly1305_ietf');
+
+    if( key === undefined ) {
+        key = binding.crypto_aead_xchacha20poly1305_ietf_keygen();
+    }
+    var k = toBuffer(key, encoding);
+    assert(k.length === KEYBYTES, 'Aead key must be ' + KEYBYTES + ' bytes long');
+
+    /** algorithm used to seal new boxes */
+    this.algorithm = ALGORITHMS[name];
+
+    /** default encoding of decrypted messages */
+    this.defaultEncoding = undefined;
+
+    // One AeadContext per algorithm, made when first needed. Only the key is
+    // kept until then, in guarded memory
+    this.secretKey = binding.sodium_malloc(KEYBYTES);
+    k.copy(this.secretKey);
+    binding.sodium_mprotect_readonly(this.secretKey);
+    this.contexts = [];
+}
+
+/**
+ * Native context of an algorithm
+ * @private
+ */
+Aead.prototype.context = function(algo) {
+    var ctx = this.contexts[algo.id];
+    if( !ctx ) {
+        if( !this.secretKey ) {
+            throw new Error('Aead was disposed');
+        }
+        ctx = this.contexts[algo.id] = new binding.AeadContext(algo.name, this.secretKey);
+    }
+    return ctx;
+};
+
+/** Name of the algorithm new boxes are sealed with */
+Aead.prototype.primitive = function() {
+    return this.algorithm.name;
+};
+
+/**
+ * Set the default encoding of decrypted messages
+ * @param {String} encoding  encoding to use
+ */
+Aead.prototype.setEncoding = function(encoding) {
+    assert(!!encoding.match(/^(?:utf8|ascii|binary|hex|utf16le|ucs2|base64)$/), 'Encoding ' + encoding + ' is currently unsupported.');
+    this.defaultEncoding = encoding;
+};
+
+/**
+ * Get the current default encoding
+ * @returns {undefined|String}
+ */
+Aead.prototype.getEncoding = function() {
+    return this.defaultEncoding;
+};
+
+/**
+ * Size of the box of a `length` byte message
+ * @param {Number} length
+ * @returns {Number}
+ */
+Aead.prototype.boxBytes = function(length) {
+    return 1 + this.algorithm.npubbytes + length + this.algorithm.abytes;
+};
+
+/**
+ * Seal a message with a new random nonce
+ *
+ * @param {Buffer|String|Array} message           message to encrypt
+ * @param {Buffer|String|Array} [additionalData]  authenticated, not encrypted
+ * @param {String} [encoding]                     encoding of message and additionalData strings
+ *
+ * @returns {Buffer} box
+ */
+Aead.prototype.encrypt = function(message, additionalData, encoding) {
+    var m = toBuffer(message, encoding);
+    var ad = additionalData ? toBuffer(additionalData, encoding) : null;
+    var box = Buffer.allocUnsafe(this.boxBytes(m.length));
+
+    this.seal(box, 0, m, ad);
+    return box;
+};
+
+/**
+ * Seal a message into `box` at `offset`
+ * @private
+ */
+Aead.prototype.seal = function(box, offset, m, ad) {
+    var algo = this.algorithm;
+    var header = offset + 1 + algo.npubbytes;
+    var nonce = box.subarray(offset + 1, header);
+
+    box[offset] = algo.id;
+    binding.randombytes_buf(nonce);
+    if( this.context(algo).encryptInto(box, header, m, ad, nonce) === null ) {
+        throw new Error('Aead: message could not be encrypted');
+    }
+    return header + m.length + algo.abytes;
+};
+
+/**
+ * Seal several messages. The boxes share one allocation
+ *
+ * @param {Array} messages                      messages to encrypt
+ * @param {Buffer|String|Array} [additionalData]  authenticated data for every message
+ * @param {String} [encoding]                   encoding of message and additionalData strings
+ *
+ * @returns {Array} boxes, in the order of messages
+ */
+Aead.prototype.encryptBatch = function(messages, additionalData, encoding) {
+    assert(Array.isArray(messages), 'messages must be an Array');
+    var ad = additionalData ? toBuffer(additionalData, encoding) : null;
+    var bufs = new Array(messages.length);
+    var total = 0;
+
+    for( var i = 0; i < messages.length; i++ ) {
+        bufs[i] = toBuffer(messages[i], encoding);
+        total += this.boxBytes(bufs[i].length);
+    }
+
+    var all = Buffer.allocUnsafe(total);
+    var boxes = new Array(bufs.length);
+    var pos = 0;
+    for( var j = 0; j < bufs.length; j++ ) {
+        var end = this.seal(all, pos, bufs[j], ad);
+        boxes[j] = all.subarray(pos, end);
+        pos = end;
+    }
+    return boxes;
+};
+
+/**
+ * Algorithm a box was sealed with
+ * @private
+ */
+Aead.prototype.algorithmOf = function(box) {
+    assert(Buffer.isBuffer(box), 'box must be a Buffer');
+    var algo = BY_ID[box[0]];
+    if( !algo ) {
+        throw new Error('Aead: unknown algorithm in box');
+    }
+    if( box.length < 1 + algo.npubbytes + algo.abytes ) {
+        throw new Error('Aead: box is too short');
+    }
+    return algo;
+};
+
+/**
+ * Verify and open a box returned by `encrypt`
+ *
+ * @param {Buffer} box                            box to open
+ * @param {Buffer|String|Array} [additionalData]  the data given to encrypt
+ * @param {String} [encoding]                     return the message as a string in this encoding
+ *
+ * @returns {Buffer|String|undefined} message, or undefined if the box is forged
+ */
+Aead.prototype.decrypt = function(box, additionalData, encoding) {
+    encoding = encoding || this.defaultEncoding;
+
+    var algo = this.algorithmOf(box);
+    var header = 1 + algo.npubbytes;
+    var ad = additionalData ? toBuffer(additionalData, encoding) : null;
+
+    var m = this.context(algo).decrypt(box, header, ad, box.subarray(1, header));
+    if( !m ) {
+        return undefined;
+    }
+    if( encoding ) {
+        return m.toString(encoding);
+    }
+    return m;
+};
+
+/**
+ * Open several boxes in one native call per algorithm
+ *
+ * @param {Array} boxes                           boxes to open
+ * @param {Buffer|String|Array} [additionalData]  the data given to encryptBatch
+ *
+ * @returns {Array|undefined} messages, in the order of boxes, or undefined if
+ *                            any box is forged
+ */
+Aead.prototype.decryptBatch = function(boxes, additionalData) {
+    assert(Array.isArray(boxes), 'boxes must be an Array');
+    var ad = additionalData ? toBuffer(additionalData) : null;
+    var groups = [];
+
+    // Cipher texts and nonces are views of the boxes, nothing is copied
+    for( var i = 0; i < boxes.length; i++ ) {
+        var algo = this.algorithmOf(boxes[i]);
+        var header = 1 + algo.npubbytes;
+        var group = groups[algo.id] || (groups[algo.id] = { algo: algo, index: [], c: [], ad: [], npub: [] });
+        group.index.push(i);
+        group.c.push(boxes[i].subarray(header));
+        group.ad.push(ad);
+        group.npub.push(boxes[i].subarray(1, header));
+    }
+
+    var messages = new Array(boxes.length);
+    for( var id = 0; id < groups.length; id++ ) {
+        var g = groups[id];
+        if( !g ) {
+            continue;
+        }
+        var all = this.context(g.algo).decryptBatch(g.c, g.ad, g.npub);
+        if( !all ) {
+            return undefined;
+        }
+        var pos = 0;
+        for( var j = 0; j < g.index.length; j++ ) {
+            var len = g.c[j].length - g.algo.abytes;
+            messages[g.index[j]] = all.subarray(pos, pos + len);
+            pos += len;
+        }
+    }
+    return messages;
+};
+
+/** Wipe the key and the native contexts. The Aead cannot be used afterwards */
+Aead.prototype.dispose = function() {
+    this.contexts.forEach(function(ctx) {
+        ctx.dispose();
+    });
+    this.contexts = [];
+    if( this.secretKey ) {
+        binding.sodium_mprotect_readwrite(this.secretKey);
+        binding.memzero(this.secretKey);
+        this.secretKey = undefined;
+    }
+};
+
+// Aliases
+Aead.prototype.close = Aead.prototype.encrypt;
+Aead.prototype.open = Aead.prototype.decrypt;
+
+/** Algorithm `new Aead()` picks on this host */
+Aead.best = best;
+
+/** Key size in bytes */
+Aead.KEYBYTES = KEYBYTES;
+
+module.exports = Aead;
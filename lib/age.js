@@ -0,0 +1,331 @@
+/**
+ * # Age
+ * age v1 files (https://age-encryption.org/v1) to X25519 recipients
+ *
+ * The header, the payload key and every chunk are handled by the native
+ * AgeStream of src/crypto_age.cc; these streams only cut their input into
+ * whole 64KB chunks, so memory use is bounded by a chunk plus the stream
+ * high water marks. `encryptFile` and `decryptFile` run the whole file on
+ * native threads without passing it through JavaScript.
+ *
+ * Keys are 32 byte X25519 keys, as from `crypto_box_keypair`, or their
+ * age encodings: `age1...` recipients and `AGE-SECRET-KEY-1...` identities,
+ * so keys made by `age-keygen` work as they are.
+ *
+ *     var alice = sodium.Age.keygen();
+ *     fs.createReadStream('backup.tar')
+ *         .pipe(new sodium.Age.Encryptor([alice.recipient, bob.recipient]))
+ *         .pipe(fs.createWriteStream('backup.tar.age'));
+ *
+ *     await sodium.Age.decryptFile('backup.tar.age', 'backup.tar', [alice.identity]);
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var stream = require('stream');
+var util = require('util');
+var assert = require('assert');
+var ChunkQueue = require('./secretstream').ChunkQueue;
+
+var AgeStream = binding.AgeStream;
+var CHUNK_SIZE = AgeStream.CHUNK_SIZE;
+var FRAME_SIZE = AgeStream.FRAME_SIZE;
+var KEYBYTES = binding.crypto_scalarmult_BYTES;
+
+var RECIPIENT_PREFIX = 'age';
+var IDENTITY_PREFIX = 'AGE-SECRET-KEY-';
+
+// Bech32 (BIP 173) without its 90 character limit, as age uses it
+var CHARSET = 'qpzry9x8gf2tvdw0s3jn54khce6mua7l';
+var GENERATOR = [0x3b6a57b2, 0x26508e6d, 0x1ea119fa, 0x3d4233dd, 0x2a1462b3];
+
+function polymod(values) {
+    var chk = 1;
+    values.forEach(function(v) {
+        var top = chk >>> 25;
+        chk = ((chk & 0x1ffffff) << 5) ^ v;
+        for( var i = 0; i < 5; i++ ) {
+            if( (top >>> i) & 1 ) {
+                chk ^= GENERATOR[i];
+            }
+        }
+    });
+    return chk;
+}
+
+function expandPrefix(prefix) {
+    var high = [], low = [];
+    for( var i = 0; i < prefix.length; i++ ) {
+        high.push(prefix.charCodeAt(i) >>> 5);
+        low.push(prefix.charCodeAt(i) & 31);
+    }
+    return high.concat([0], low);
+}
+
+function convertBits(data, from, to, pad) {
+    var acc = 0, bits = 0, out = [];
+    var max = (1 << to) - 1;
+    for( var i = 0; i < data.length; i++ ) {
+        acc = (acc << from) | data[i];
+        bits += from;
+        while( bits >= to ) {
+            bits -= to;
+            out.push((acc >>> bits) & max);
+        }
+        acc &= (1 << bits) - 1;
+    }
+    if( pad ) {
+        if( bits > 0 ) {
+            out.push((acc << (to - bits)) & max);
+        }
+    }
+    else if( bits >= from || acc !== 0 ) {
+        return null;
+    }
+    return out;
+}
+
+function bech32Encode(prefix, bytes) {
+    var words = convertBits(bytes, 8, 5, true);
+    var chk = polymod(expandPrefix(prefix).concat(words, [0, 0, 0, 0, 0, 0])) ^ 1;
+    var out = prefix + '1';
+    words.forEach(function(w) {
+        out += CHARSET[w];
+    });
+    for( var i = 0; i < 6; i++ ) {
+        out += CHARSET[(chk >>> (5 * (5 - i))) & 31];
+    }
+    return out;
+}
+
+// The bytes of `text` if it is a valid bech32 string of `prefix`, or null
+function bech32Decode(prefix, text) {
+    if( text !== text.toLowerCase() && text !== text.toUpperCase() ) {
+        return null;
+    }
+    text = text.toLowerCase();
+    var sep = text.lastIndexOf('1');
+    if( sep < 1 || text.slice(0, sep) !== prefix.toLowerCase() || text.length - sep - 1 < 6 ) {
+        return null;
+    }
+    var words = [];
+    for( var i = sep + 1; i < text.length; i++ ) {
+        var w = CHARSET.indexOf(text[i]);
+        if( w < 0 ) {
+            return null;
+        }
+        words.push(w);
+    }
+    if( polymod(expandPrefix(prefix.toLowerCase()).concat(words)) !== 1 ) {
+        return null;
+    }
+    var bytes = convertBits(words.slice(0, -6), 5, 8, false);
+    return bytes && Buffer.from(bytes);
+}
+
+/** The `age1...` encoding of an X25519 public key */
+function recipient(publicKey) {
+    assert.ok(Buffer.isBuffer(publicKey) && publicKey.length === KEYBYTES,
+        'publicKey must be a ' + KEYBYTES + ' byte Buffer');
+    return bech32Encode(RECIPIENT_PREFIX, publicKey);
+}
+
+/** The `AGE-SECRET-KEY-1...` encoding of an X25519 secret key */
+function identity(secretKey) {
+    assert.ok(Buffer.isBuffer(secretKey) && secretKey.length === KEYBYTES,
+        'secretKey must be a ' + KEYBYTES + ' byte Buffer');
+    return bech32Encode(IDENTITY_PREFIX.toLowerCase(), secretKey).toUpperCase();
+}
+
+function parseKey(key, prefix, what) {
+    if( Buffer.isBuffer(key) && key.length === KEYBYTES ) {
+        return key;
+    }
+    var bytes = typeof key === 'string' ? bech32Decode(prefix, key.trim()) : null;
+    assert.ok(bytes && bytes.length === KEYBYTES,
+        what + ' must be a ' + KEYBYTES + ' byte Buffer or an ' + prefix + '1... string');
+    return bytes;
+}
+
+/** The public key of an `age1...` recipient */
+function parseRecipient(text) {
+    return parseKey(text, RECIPIENT_PREFIX, 'recipient');
+}
+
+/** The secret key of an `AGE-SECRET-KEY-1...` identity */
+function parseIdentity(text) {
+    return parseKey(text, IDENTITY_PREFIX, 'identity');
+}
+
+function parseList(keys, parse, what) {
+    if( !Array.isArray(keys) ) {
+        keys = [keys];
+    }
+    assert.ok(keys.length > 0, what + ' must not be empty');
+    return keys.map(parse);
+}
+
+/**
+ * A new X25519 key pair, with its age encodings
+ *
+ * @returns {Object} `{ publicKey, secretKey, recipient, identity }`
+ */
+function keygen() {
+    var pair = binding.crypto_box_keypair();
+    pair.recipient = recipient(pair.publicKey);
+    pair.identity = identity(pair.secretKey);
+    return pair;
+}
+
+/**
+ * Transform stream that encrypts everything written to it into an age file
+ *
+ * @param {Array} recipients    public keys or `age1...` strings, or one of them
+ * @param {Object} [options]    stream.Transform options
+ * @constructor
+ */
+function Encryptor(recipients, options) {
+    if( !(this instanceof Encryptor) ) {
+        return new Encryptor(recipients, options);
+    }
+
+    var age = new AgeStream({ recipients: parseList(recipients, parseRecipient, 'recipients') });
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var queue = new ChunkQueue();
+
+    self.push(age.header);
+
+    self._transform = function(chunk, encoding, callback) {
+        if( !Buffer.isBuffer(chunk) ) {
+            chunk = Buffer.from(chunk, encoding);
+        }
+        queue.append(chunk);
+
+        // Seal every whole chunk at once, but keep at least one byte back
+        // so the last chunk is never empty unless the whole file is
+        var whole = Math.floor((queue.length - 1) / CHUNK_SIZE) * CHUNK_SIZE;
+        if( whole > 0 ) {
+            self.push(age.seal(queue.take(whole), false));
+        }
+        callback();
+    };
+
+    self._flush = function(callback) {
+        self.push(age.seal(queue.take(queue.length), true));
+        age.dispose();
+        callback();
+    };
+}
+util.inherits(Encryptor, stream.Transform);
+
+/**
+ * Transform stream that decrypts an age file. Emits an error if no identity
+ * matches a recipient, if the header or a chunk fails authentication or if
+ * the file was truncated
+ *
+ * @param {Array} identities    secret keys or `AGE-SECRET-KEY-1...` strings
+ * @param {Object} [options]    stream.Transform options
+ * @constructor
+ */
+function Decryptor(identities, options) {
+    if( !(this instanceof Decryptor) ) {
+        return new Decryptor(identities, options);
+    }
+
+    var keys = parseList(identities, parseIdentity, 'identities');
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var queue = new ChunkQueue();
+    var age = null;
+
+    self._transform = function(chunk, encoding, callback) {
+        if( !Buffer.isBuffer(chunk) ) {
+            chunk = Buffer.from(chunk, encoding);
+        }
+        queue.append(chunk);
+
+        try {
+            if( !age ) {
+                var head = queue.take(queue.length);
+                var length = AgeStream.headerLength(head);
+                if( length === 0 ) {
+                    queue.append(head);
+                    return callback();
+                }
+                age = new AgeStream({ identities: keys, header: head });
+                queue.append(head.slice(length));
+            }
+
+            // The last chunk may be a whole frame, so one is always held back
+            var whole = Math.floor((queue.length - 1) / FRAME_SIZE) * FRAME_SIZE;
+            if( whole > 0 ) {
+                self.push(age.open(queue.take(whole), false));
+            }
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback();
+    };
+
+    self._flush = function(callback) {
+        if( !age ) {
+            return callback(new Error('age header truncated'));
+        }
+        try {
+            self.push(age.open(queue.take(queue.length), true));
+        }
+        catch(err) {
+            return callback(err);
+        }
+        finally {
+            age.dispose();
+        }
+        callback();
+    };
+}
+util.inherits(Decryptor, stream.Transform);
+
+/**
+ * Encrypt the file `src` into the age file `dst` on native threads
+ *
+ *     encryptFile(src, dst, recipients, [options], [callback])
+ *
+ * `options` takes `signal`, `deadline` and `timeout`. Returns a Promise for
+ * the bytes written when no callback is given
+ */
+function encryptFile(src, dst, recipients) {
+    var args = Array.prototype.slice.call(arguments);
+    args[2] = parseList(recipients, parseRecipient, 'recipients');
+    return binding.crypto_age_encrypt_file.apply(binding, args);
+}
+
+/**
+ * Decrypt the age file `src` into `dst` on native threads
+ *
+ *     decryptFile(src, dst, identities, [options], [callback])
+ */
+function decryptFile(src, dst, identities) {
+    var args = Array.prototype.slice.call(arguments);
+    args[2] = parseList(identities, parseIdentity, 'identities');
+    return binding.crypto_age_decrypt_file.apply(binding, args);
+}
+
+module.exports.Encryptor = Encryptor;
+module.exports.Decryptor = Decryptor;
+module.exports.encryptFile = encryptFile;
+module.exports.decryptFile = decryptFile;
+module.exports.keygen = keygen;
+module.exports.recipient = recipient;
+module.exports.identity = identity;
+module.exports.parseRecipient = parseRecipient;
+module.exports.parseIdentity = parseIdentity;
+
+/** Plain text bytes per chunk */
+module.exports.CHUNK_SIZE = CHUNK_SIZE;
@@ -1,7 +1,7 @@
 /* jslint node: true */
 'use strict';
 
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var AuthKey = require('./keys/auth-key');
 var toBuffer = require('./toBuffer');
 var assert = require('assert');
@@ -0,0 +1,169 @@
+/**
+ * # BatchPack
+ * Build the packed batches every batch binding takes
+ *
+ * A batch argument given as an Array of Buffers costs the native side one
+ * lookup per element, and the elements are wherever the heap put them. A
+ * packed batch is one data Buffer and two Uint32Arrays, struct of arrays:
+ *
+ *     { data: Buffer, offsets: Uint32Array, lengths: Uint32Array }
+ *
+ * Element `i` is `data.subarray(offsets[i], offsets[i] + lengths[i])`, or
+ * null when `lengths[i]` is `BatchPack.NULL`. Any batch argument that takes
+ * an Array of Buffers takes one instead, at three lookups whatever its
+ * size:
+ *
+ *     var pack = new sodium.BatchPack();
+ *     messages.forEach(function(m) { pack.push(m); });
+ *     sodium.crypto_sign_ed25519_verify_detached_batch(signatures, pack.toBatch(), publicKeys);
+ *
+ * A BatchPack copies each element into its data block, which grows by
+ * doubling, so pushing costs no allocation of its own. Elements are packed
+ * back to back, so `data` and `lengths` of a batch without nulls also fit
+ * the bindings that take a buffer and a length table, such as
+ * `crypto_generichash_many` and `crypto_shorthash_batch`.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+/** `lengths` value of a null element */
+var NULL_ELEMENT = 0xffffffff;
+
+/**
+ * @param {Number} [bytes]  initial data capacity
+ * @param {Number} [count]  initial element capacity
+ * @constructor
+ */
+function BatchPack(bytes, count) {
+    if( !(this instanceof BatchPack) ) {
+        return new BatchPack(bytes, count);
+    }
+    this._data = Buffer.allocUnsafe(bytes || 4096);
+    this._offsets = new Uint32Array(count || 64);
+    this._lengths = new Uint32Array(count || 64);
+    this.count = 0;
+    this.size = 0;
+}
+
+BatchPack.NULL = NULL_ELEMENT;
+
+/**
+ * Pack an Array of Buffers, nulls allowed, in one data block of exactly
+ * their size
+ *
+ * @param {Array} elements
+ * @returns {BatchPack}
+ */
+BatchPack.from = function(elements) {
+    var bytes = 0;
+    for(var i = 0; i < elements.length; i++) {
+        if( elements[i] !== null ) {
+            bytes += elements[i].byteLength;
+        }
+    }
+    var pack = new BatchPack(bytes || 1, elements.length || 1);
+    for(i = 0; i < elements.length; i++) {
+        if( elements[i] === null ) {
+            pack.pushNull();
+        } else {
+            pack.push(elements[i]);
+        }
+    }
+    return pack;
+};
+
+BatchPack.prototype._reserve = function(bytes) {
+    if( this.count === this._lengths.length ) {
+        var offsets = new Uint32Array(this.count * 2);
+        var lengths = new Uint32Array(this.count * 2);
+        offsets.set(this._offsets);
+        lengths.set(this._lengths);
+        this._offsets = offsets;
+        this._lengths = lengths;
+    }
+    if( this.size + bytes > this._data.length ) {
+        var capacity = this._data.length * 2;
+        while( capacity < this.size + bytes ) {
+            capacity *= 2;
+        }
+        if( capacity > NULL_ELEMENT ) {
+            throw new RangeError('a BatchPack holds at most 4GB');
+        }
+        var data = Buffer.allocUnsafe(capacity);
+        this._data.copy(data, 0, 0, this.size);
+        this._data = data;
+    }
+};
+
+/**
+ * Copy an element in
+ *
+ * @param {Buffer|TypedArray|DataView} element
+ * @returns {Number} its index
+ */
+BatchPack.prototype.push = function(element) {
+    var bytes = Buffer.isBuffer(element) ? element :
+        Buffer.from(element.buffer, element.byteOffset, element.byteLength);
+    this._reserve(bytes.length);
+    bytes.copy(this._data, this.size);
+    return this._add(bytes.length);
+};
+
+/**
+ * Add an element of `length` bytes for the caller to write in place, into
+ * the view returned, before anything else is pushed
+ *
+ * @param {Number} length
+ * @returns {Buffer}
+ */
+BatchPack.prototype.alloc = function(length) {
+    this._reserve(length);
+    var offset = this.size;
+    this._add(length);
+    return this._data.subarray(offset, offset + length);
+};
+
+/**
+ * Add a null element, for arguments that take null elements
+ *
+ * @returns {Number} its index
+ */
+BatchPack.prototype.pushNull = function() {
+    this._reserve(0);
+    this._offsets[this.count] = this.size;
+    this._lengths[this.count] = NULL_ELEMENT;
+    return this.count++;
+};
+
+BatchPack.prototype._add = function(length) {
+    this._offsets[this.count] = this.size;
+    this._lengths[this.count] = length;
+    this.size += length;
+    return this.count++;
+};
+
+/**
+ * The packed batch, views of the pack's storage: push nothing more until
+ * the call it is given to is done with it
+ *
+ * @returns {Object} `{ data, offsets, lengths }`
+ */
+BatchPack.prototype.toBatch = function() {
+    return {
+        data: this._data.subarray(0, this.size),
+        offsets: this._offsets.subarray(0, this.count),
+        lengths: this._lengths.subarray(0, this.count)
+    };
+};
+
+/**
+ * Empty the pack, keeping its storage for the next batch
+ */
+BatchPack.prototype.reset = function() {
+    this.count = 0;
+    this.size = 0;
+};
+
+module.exports = BatchPack;
@@ -0,0 +1,132 @@
+/**
+ * # batchStream
+ * Results of a large batch job as they come, through an async iterator
+ *
+ * The `_stream` bindings run a batch on the threadpool and hand its results
+ * back a chunk of items at a time, to `options.onChunk(start, results)`,
+ * instead of all at once when the last item is done:
+ *
+ *  - `crypto_sign_ed25519_verify_detached_batch_stream`, booleans
+ *  - `crypto_aead_<algorithm>_decrypt_each_stream`, messages or nulls
+ *  - `crypto_generichash_many_stream`, hashes
+ *
+ * `batchStream(name, args, [options])` calls one with `args` and returns an
+ * async iterator of `{ start, results }` chunks, in order, so downstream
+ * work can start on the first items while the native side works on the
+ * rest:
+ *
+ *     var chunks = sodium.batchStream('crypto_sign_ed25519_verify_detached_batch_stream',
+ *                                     [signatures, messages, publicKeys], { chunkSize: 4096 });
+ *     for await (var chunk of chunks) {
+ *         chunk.results.forEach(function(valid, i) {
+ *             accept(chunk.start + i, valid);
+ *         });
+ *     }
+ *
+ * `options` are those of the binding, `chunkSize`, `threads`, `signal`,
+ * `deadline`, `timeout` and `priority`, less `onChunk`. The native side
+ * stops once a few chunks wait undelivered, but chunks delivered to an
+ * iterator that is not read pile up here. Leaving the loop early cancels
+ * the job.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+
+/**
+ * @param {String} name     a `_stream` binding
+ * @param {Array} args      its arguments before the options
+ * @param {Object} [options]
+ * @returns {AsyncIterator} of `{ start, results }`
+ */
+function batchStream(name, args, options) {
+    var fn = binding[name];
+    if( typeof fn !== 'function' || !/_stream$/.test(name) ) {
+        throw new TypeError(name + ' is not a streamed batch binding');
+    }
+
+    var chunks = [];
+    var waiting = null;
+    var finished = false;
+    var failure = null;
+    var closed = false;
+    var controller = new AbortController();
+
+    var opts = Object.assign({}, options);
+    if( opts.signal ) {
+        var outer = opts.signal;
+        if( outer.aborted ) {
+            controller.abort(outer.reason);
+        } else {
+            outer.addEventListener('abort', function() {
+                controller.abort(outer.reason);
+            }, { once: true });
+        }
+    }
+    opts.signal = controller.signal;
+    opts.onChunk = function(start, results) {
+        if( closed ) {
+            return;
+        }
+        chunks.push({ start: start, results: results });
+        wake();
+    };
+
+    function wake() {
+        if( waiting !== null ) {
+            var w = waiting;
+            waiting = null;
+            w();
+        }
+    }
+
+    fn.apply(binding, args.concat([opts])).then(function() {
+        finished = true;
+        wake();
+    }, function(err) {
+        // The abort of an iterator that was left is not an error
+        failure = closed ? null : err;
+        finished = true;
+        wake();
+    });
+
+    var iterator = {
+        next: function() {
+            if( chunks.length > 0 ) {
+                return Promise.resolve({ value: chunks.shift(), done: false });
+            }
+            if( finished ) {
+                if( failure !== null ) {
+                    var err = failure;
+                    failure = null;
+                    return Promise.reject(err);
+                }
+                return Promise.resolve({ value: undefined, done: true });
+            }
+            return new Promise(function(resolve) {
+                waiting = resolve;
+            }).then(function() {
+                return iterator.next();
+            });
+        },
+        return: function() {
+            closed = true;
+            if( !finished ) {
+                controller.abort();
+            }
+            chunks = [];
+            finished = true;
+            failure = null;
+            return Promise.resolve({ value: undefined, done: true });
+        }
+    };
+    iterator[Symbol.asyncIterator] = function() {
+        return iterator;
+    };
+    return iterator;
+}
+
+module.exports = batchStream;
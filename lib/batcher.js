@@ -0,0 +1,186 @@
+/**
+ * # Batcher
+ * Coalesce async calls made in the same tick into one native job
+ *
+ * Each `_async` call is its own threadpool job, with its own completion
+ * callback on the event loop. A server checking hundreds of signatures or
+ * opening hundreds of messages a tick spends more on that round trip than
+ * on the crypto. A Batcher queues calls of the same kind, and once the
+ * current tick is over hands each queue to a batch kernel as one job per
+ * `maxBatch` calls, then settles every call's Promise from its result.
+ *
+ *     var batcher = new sodium.Batcher();
+ *     batcher.verifyDetached(signature, message, publicKey).then(function(valid) {
+ *         ...
+ *     });
+ *     batcher.decrypt('xchacha20poly1305_ietf', cipherText, ad, nonce, key).then(function(m) {
+ *         ...   // null if the cipher text does not authenticate
+ *     });
+ *
+ * Calls are checked when they are made and a bad one is rejected on its
+ * own. Inputs are copied when the batch is queued, at the end of the tick:
+ * do not change them before that. Decrypted messages of one batch are views
+ * on one Buffer.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+
+/** Most calls in one native job */
+var DEFAULT_MAX_BATCH = 256;
+
+var AEADS = ['aes256gcm', 'chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'];
+
+function isBytes(value) {
+    return Buffer.isBuffer(value) || ArrayBuffer.isView(value);
+}
+
+/**
+ * @param {Object} [options]
+ *   - `maxBatch` (Number): most calls in one native job. Default 256
+ *   - `threads` (Number): threads each signature batch is spread over.
+ *     Default 1
+ * @constructor
+ */
+function Batcher(options) {
+    if( !(this instanceof Batcher) ) {
+        return new Batcher(options);
+    }
+
+    options = options || {};
+    var self = this;
+    var maxBatch = options.maxBatch || DEFAULT_MAX_BATCH;
+    var threads = options.threads || 1;
+    var queues = {};
+    var scheduled = false;
+
+    /** Counters: `{ calls, batches, errors }` */
+    self.stats = { calls: 0, batches: 0, errors: 0 };
+
+    function enqueue(kind, run, args) {
+        return new Promise(function(resolve, reject) {
+            var queue = queues[kind];
+            if( !queue ) {
+                queue = queues[kind] = { run: run, calls: [] };
+            }
+            queue.calls.push({ args: args, resolve: resolve, reject: reject });
+            self.stats.calls++;
+            if( !scheduled ) {
+                scheduled = true;
+                process.nextTick(flush);
+            }
+        });
+    }
+
+    function flush() {
+        scheduled = false;
+        var pending = queues;
+        queues = {};
+        Object.keys(pending).forEach(function(kind) {
+            var queue = pending[kind];
+            for( var i = 0; i < queue.calls.length; i += maxBatch ) {
+                submit(queue.run, queue.calls.slice(i, i + maxBatch));
+            }
+        });
+    }
+
+    function submit(run, calls) {
+        self.stats.batches++;
+        var job;
+        try {
+            job = run(calls);
+        }
+        catch (err) {
+            job = Promise.reject(err);
+        }
+        job.then(function(results) {
+            calls.forEach(function(call, i) {
+                call.resolve(results(i));
+            });
+        }, function(err) {
+            self.stats.errors++;
+            calls.forEach(function(call) {
+                call.reject(err);
+            });
+        });
+    }
+
+    function column(calls, i) {
+        return calls.map(function(call) { return call.args[i]; });
+    }
+
+    function verifyBatch(calls) {
+        return binding.crypto_sign_ed25519_verify_detached_batch_async(
+            column(calls, 0), column(calls, 1), column(calls, 2), threads
+        ).then(function(bitmap) {
+            return function(i) {
+                return (bitmap[i >> 3] & (1 << (i & 7))) !== 0;
+            };
+        });
+    }
+
+    function decryptBatch(algorithm) {
+        var fn = binding['crypto_aead_' + algorithm + '_decrypt_each_async'];
+        return function(calls) {
+            return fn(column(calls, 0), column(calls, 1), column(calls, 2), column(calls, 3))
+                .then(function(messages) {
+                    return function(i) {
+                        return messages[i];
+                    };
+                });
+        };
+    }
+
+    var decrypters = {};
+    AEADS.forEach(function(algorithm) {
+        decrypters[algorithm] = decryptBatch(algorithm);
+    });
+
+    /**
+     * Check a detached Ed25519 signature
+     *
+     * @param {Buffer} signature  `crypto_sign_BYTES` long
+     * @param {Buffer} message
+     * @param {Buffer} publicKey  `crypto_sign_PUBLICKEYBYTES` long
+     * @returns {Promise} true if the signature is valid
+     */
+    self.verifyDetached = function(signature, message, publicKey) {
+        if( !isBytes(signature) || signature.length !== binding.crypto_sign_ed25519_BYTES ||
+            !isBytes(message) ||
+            !isBytes(publicKey) || publicKey.length !== binding.crypto_sign_ed25519_PUBLICKEYBYTES ) {
+            return Promise.reject(new TypeError('[Batcher] signature, message and publicKey must be buffers of the right sizes'));
+        }
+        return enqueue('verify', verifyBatch, [signature, message, publicKey]);
+    };
+
+    /**
+     * Open a combined mode AEAD message
+     *
+     * @param {String} algorithm  `aes256gcm`, `chacha20poly1305`,
+     *                            `chacha20poly1305_ietf` or `xchacha20poly1305_ietf`
+     * @param {Buffer} cipherText
+     * @param {Buffer} additionalData  or null
+     * @param {Buffer} nonce
+     * @param {Buffer} key
+     * @returns {Promise} the message, or null if it does not authenticate
+     */
+    self.decrypt = function(algorithm, cipherText, additionalData, nonce, key) {
+        var run = decrypters[algorithm];
+        if( !run ) {
+            return Promise.reject(new TypeError('[Batcher] unknown AEAD algorithm ' + algorithm));
+        }
+        var prefix = 'crypto_aead_' + algorithm;
+        if( !isBytes(cipherText) || cipherText.length < binding[prefix + '_ABYTES'] ||
+            (additionalData !== null && additionalData !== undefined && !isBytes(additionalData)) ||
+            !isBytes(nonce) || nonce.length !== binding[prefix + '_NPUBBYTES'] ||
+            !isBytes(key) || key.length !== binding[prefix + '_KEYBYTES'] ) {
+            return Promise.reject(new TypeError('[Batcher] cipherText, nonce and key must be buffers of the right sizes'));
+        }
+        return enqueue(algorithm, run, [cipherText, additionalData || null, nonce, key]);
+    };
+}
+
+module.exports = Batcher;
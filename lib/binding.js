@@ -0,0 +1,59 @@
+/**
+ * The native addon
+ *
+ * A build from source, in `build/Release`, is used when there is one.
+ * Otherwise the `baseline` prebuilt binary is loaded, its
+ * `sodium_runtime_has_*` checks pick the fastest prebuilt tier this CPU
+ * runs, and that one is loaded instead. Set `SODIUM_TIER` to load a given
+ * tier, for instance to compare them. `tier` on the exported object tells
+ * which one was loaded, `source` for a build from source.
+ *
+ * With no binary for this host, the WebAssembly build of lib/wasm.js is
+ * loaded, tier `wasm`. It has the libsodium functions but none of the
+ * addon's own extensions. `SODIUM_TIER=wasm` loads it anyway.
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var path = require('path');
+var prebuilds = require('./prebuilds');
+
+var SOURCE = path.join(__dirname, '..', 'build', 'Release', 'sodium.node');
+
+function load() {
+    if( fs.existsSync(SOURCE) ) {
+        return { binding: require(SOURCE), tier: 'source' };
+    }
+
+    var forced = process.env.SODIUM_TIER;
+    if( forced === 'wasm' ) {
+        return { binding: require('./wasm').load(), tier: 'wasm' };
+    }
+    if( forced ) {
+        return { binding: require(prebuilds.file(forced)), tier: forced };
+    }
+
+    var baseline = prebuilds.file('baseline');
+    if( !fs.existsSync(baseline) ) {
+        if( fs.existsSync(prebuilds.wasm()) ) {
+            return { binding: require('./wasm').load(), tier: 'wasm' };
+        }
+        throw new Error('sodium: no build in ' + path.dirname(SOURCE) +
+                        ' and no prebuilt binary in ' + prebuilds.dir() + '. Run npm rebuild sodium');
+    }
+    var binding = require(baseline);
+    var best = prebuilds.select(binding);
+    if( !best || best.name === 'baseline' ) {
+        return { binding: binding, tier: 'baseline' };
+    }
+    return { binding: require(prebuilds.file(best.name)), tier: best.name };
+}
+
+var loaded = load();
+Object.defineProperty(loaded.binding, 'tier', { value: loaded.tier, enumerable: false });
+
+// Publish crypto calls on diagnostics_channel while anyone subscribes
+require('./diagnostics').install(loaded.binding);
+
+module.exports = loaded.binding;
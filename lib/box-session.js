@@ -0,0 +1,123 @@
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var toBuffer = require('./toBuffer');
+var BoxKey = require('./keys/box-key');
+var CryptoBaseBuffer = require('./crypto-base-buffer');
+var Nonce = require('./nonces/box-nonce');
+var assert = require('assert');
+
+/**
+ * Public-key authenticated encryption with a precomputed shared key.
+ *
+ * Same messages as `Box` in easy mode, but the Curve25519 shared key is
+ * computed once, when the session is created, and kept in guarded native
+ * memory. Use it for chatty traffic with the same peer.
+ *
+ * @param {String|Buffer|Array} publicKey  recipient's public key
+ * @param {String|Buffer|Array} secretKey  sender's private key
+ * @param {String} [encoding]              encoding of the keys if they are strings
+ *
+ * @see Box
+ * @constructor
+ */
+module.exports = function BoxSession(publicKey, secretKey, encoding) {
+    var self = this;
+
+    /** default encoding to use in all string operations */
+    self.defaultEncoding = undefined;
+
+    /** Set of keys used to build the session */
+    self.boxKey = new BoxKey(publicKey, secretKey, encoding);
+
+    var session = new binding.BoxSession(
+        self.boxKey.getPublicKey().get(),
+        self.boxKey.getSecretKey().get());
+
+    /**
+     * Get the box-key secret keypair object
+     * @returns {BoxKey|*}
+     */
+    self.key = function() {
+        return self.boxKey;
+    };
+
+    /**
+     * Set the default encoding to use in all string conversions
+     * @param {String} encoding  encoding to use
+     */
+    self.setEncoding = function(encoding) {
+        assert(!!encoding.match(/^(?:utf8|ascii|binary|hex|utf16le|ucs2|base64)$/), 'Encoding ' + encoding + ' is currently unsupported.');
+        self.defaultEncoding = encoding;
+    };
+
+    /**
+     * Get the current default encoding
+     * @returns {undefined|String}
+     */
+    self.getEncoding = function() {
+        return self.defaultEncoding;
+    };
+
+    /**
+     * Encrypt a message with a new random nonce
+     *
+     * @param {Buffer|String|Array} plainText  message to encrypt
+     * @param {String} [encoding]             encoding of message string
+     *
+     * @returns {Object}                       cipher box `{ cipherText, nonce }`
+     */
+    self.encrypt = function(plainText, encoding) {
+        encoding = encoding || self.defaultEncoding;
+
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_box_NONCEBYTES);
+        var cipherText = session.encrypt(toBuffer(plainText, encoding), nonce);
+
+        if( !cipherText ) {
+            return undefined;
+        }
+
+        return {
+            cipherText: cipherText,
+            nonce: nonce
+        };
+    };
+
+    /**
+     * Verify and decrypt a cipher box returned by `encrypt`
+     *
+     * @param {Object} cipherBox   `{ cipherText, nonce }`
+     * @param {String} [encoding]  return the plain text as a string in this encoding
+     *
+     * @returns {Buffer|String|undefined} plain text, or undefined if the box is forged
+     */
+    self.decrypt = function(cipherBox, encoding) {
+        encoding = encoding || self.defaultEncoding;
+
+        assert(typeof cipherBox == 'object' && cipherBox.hasOwnProperty('cipherText') && cipherBox.hasOwnProperty('nonce'), 'cipherBox is an object with properties `cipherText` and `nonce`.');
+        assert(cipherBox.cipherText instanceof Buffer, 'cipherBox should have a cipherText property that is a buffer');
+
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_box_NONCEBYTES, cipherBox.nonce);
+        var plainText = session.decrypt(cipherBox.cipherText, nonce);
+
+        if( !plainText ) {
+            return undefined;
+        }
+
+        if( encoding ) {
+            return plainText.toString(encoding);
+        }
+
+        return plainText;
+    };
+
+    /** Wipe the shared key. The session cannot be used afterwards */
+    self.dispose = function() {
+        session.dispose();
+    };
+
+    // Aliases
+    self.close = self.encrypt;
+    self.open = self.decrypt;
+};
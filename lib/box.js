@@ -6,9 +6,10 @@
  /* jslint node: true */
 'use strict';
 
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var toBuffer = require('./toBuffer');
 var BoxKey = require('./keys/box-key');
+var CryptoBaseBuffer = require('./crypto-base-buffer');
 var Nonce = require('./nonces/box-nonce');
 var assert = require('assert');
 
@@ -116,12 +117,12 @@ module.exports = function Box(publicKey, secretKey, easy) {
         encoding = encoding || self.defaultEncoding;
 
         // generate a new random nonce
-        var nonce = new Nonce();
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_box_NONCEBYTES);
 
         var buf = toBuffer(plainText, encoding);
         var cipherText = (self.easy ? binding.crypto_box_easy : binding.crypto_box)(
             buf,
-            nonce.get(),
+            nonce,
             self.boxKey.getPublicKey().get(),
             self.boxKey.getSecretKey().get());
 
@@ -131,7 +132,7 @@ module.exports = function Box(publicKey, secretKey, easy) {
 
         return {
             cipherText: cipherText,
-            nonce : nonce.get()
+            nonce : nonce
         };
     };
 
@@ -150,11 +151,11 @@ module.exports = function Box(publicKey, secretKey, easy) {
         assert(typeof cipherBox == 'object' && cipherBox.hasOwnProperty('cipherText') && cipherBox.hasOwnProperty('nonce'), 'cipherBox is an object with properties `cipherText` and `nonce`.');
         assert(cipherBox.cipherText instanceof Buffer, 'cipherBox should have a cipherText property that is a buffer') ;
 
-        var nonce = new Nonce(cipherBox.nonce);
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_box_NONCEBYTES, cipherBox.nonce);
 
         var plainText = (self.easy ? binding.crypto_box_open_easy : binding.crypto_box_open)(
             cipherBox.cipherText,
-            nonce.get(),
+            nonce,
             self.boxKey.getPublicKey().get(),
             self.boxKey.getSecretKey().get()
         );
@@ -166,6 +167,68 @@ module.exports = function Box(publicKey, secretKey, easy) {
         return plainText;
     };
 
+    /**
+     * Sign a message with Ed25519 and box the signature and the message in
+     * one native call, see `crypto_box_sign_easy`. Always uses easy mode
+     *
+     * @param {Buffer|String|Array} plainText  message to sign and encrypt
+     * @param {Buffer} signSecretKey           sender's Ed25519 secret key
+     * @param {String} [encoding]              encoding of message string
+     *
+     * @returns {Object}                       cipher box
+     */
+    self.signAndBox = function (plainText, signSecretKey, encoding) {
+        encoding = encoding || self.defaultEncoding;
+
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_box_NONCEBYTES);
+        var cipherText = binding.crypto_box_sign_easy(
+            toBuffer(plainText, encoding),
+            nonce,
+            self.boxKey.getPublicKey().get(),
+            self.boxKey.getSecretKey().get(),
+            signSecretKey);
+
+        if( !cipherText ) {
+            return undefined;
+        }
+
+        return {
+            cipherText: cipherText,
+            nonce : nonce
+        };
+    };
+
+    /**
+     * Open a cipher box from `signAndBox` and verify its signature
+     *
+     * @param {Object} cipherBox         `{ cipherText, nonce }`
+     * @param {Buffer} signPublicKey     sender's Ed25519 public key
+     * @param {String} [encoding]        encoding of the returned message
+     *
+     * @returns {Buffer|String}          the message, or undefined if the box
+     *                                   does not open or verify
+     */
+    self.openAndVerify = function (cipherBox, signPublicKey, encoding) {
+        encoding = encoding || self.defaultEncoding;
+
+        assert(typeof cipherBox == 'object' && cipherBox.hasOwnProperty('cipherText') && cipherBox.hasOwnProperty('nonce'), 'cipherBox is an object with properties `cipherText` and `nonce`.');
+        assert(cipherBox.cipherText instanceof Buffer, 'cipherBox should have a cipherText property that is a buffer') ;
+
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_box_NONCEBYTES, cipherBox.nonce);
+        var plainText = binding.crypto_box_open_verify_easy(
+            cipherBox.cipherText,
+            nonce,
+            self.boxKey.getPublicKey().get(),
+            self.boxKey.getSecretKey().get(),
+            signPublicKey);
+
+        if( !plainText ) {
+            return undefined;
+        }
+
+        return encoding ? plainText.toString(encoding) : plainText;
+    };
+
     // Aliases
     self.close = self.encrypt;
     self.open = self.decrypt;
@@ -5,316 +5,393 @@
 'use strict';
 
 var assert = require('assert');
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var toBuffer = require('./toBuffer');
 
-module.exports =  function CryptoBaseBuffer() {
-    var self = this;
+/**
+ * Compiled valid encoding lists, shared by every buffer that sets the same list
+ */
+var encodingPatterns = {};
 
+/**
+ * Base of every key and nonce class.
+ *
+ * Instances only carry their state, methods live on the prototype, so
+ * holding many keys costs a few fields each and not a set of closures.
+ * Sub-classes call CryptoBaseBuffer.call(this) and then this.init()
+ */
+function CryptoBaseBuffer() {
     /**
      * Expected size of the buffer.
      * All buffers need to have expectedSize bytes to be valid
      * */
-    self.expectedSize = 0;          // This should be set to the appropriate Lib Sodium constant
+    this.expectedSize = 0;          // This should be set to the appropriate Lib Sodium constant
 
     /** internal state buffer */
-    self.baseBuffer = undefined;
+    this.baseBuffer = undefined;
 
     /** default encoding to use in all string operations */
-    self.defaultEncoding = undefined;
-
-    /** Default valid string encoding schemes */
-    self.validEncodings = /^(?:hex|base64)$/;
+    this.defaultEncoding = undefined;
 
     /** Type of data stored in the buffer. (key, pulicKey, secretKey, nonce) **/
-    self.type = undefined;
+    this.type = undefined;
 
-    /**
-     * Initialize object
-     * If a key is not given generate a new random key.
-     *
-     * Valid keys, once converted to a node buffer, must have expectedSize in length.
-     * If a key is represented by a string the string length depends on the encoding
-     * so do not rely on string lengths to calculate key sizes.
-     *
-     * @param {number} expectedSize          expected size of the buffer in bytes
-     * @param {String|Buffer|Array} [value]  value to initialize the buffer with
-     * @param {Srting} [encoding]            encoding to use in conversion if value is a string. Defaults to 'hex'
-     */
-    self.init = function(options) {
-        options = options || {};
-
-        assert(typeof options.expectedSize == 'number' && options.expectedSize > 0, 'options.expectedSize > 0');
-
-        if ( !options.type ) {
-            throw self.error('type must be passed to init');
-        }
-        assert(typeof options.type == 'string');
+    /** keep the buffer in locked, guarded memory from sodium_malloc **/
+    this.secure = CryptoBaseBuffer.secureMemory;
+}
 
-        self.type = options.type;
+/** Default valid string encoding schemes */
+CryptoBaseBuffer.prototype.validEncodings = /^(?:hex|base64)$/;
 
-        if ( !options.expectedSize ) {
-            throw self.error('expectedSize must be passed to init');
-        }
-        self.expectedSize = options.expectedSize;
-
-        if( !options.buffer ) {
-            self.generate();
-            return;
-        }
-
-        self.set(options.buffer, options.encoding);
-    };
+/**
+ * Initialize object
+ * If a key is not given generate a new random key.
+ *
+ * Valid keys, once converted to a node buffer, must have expectedSize in length.
+ * If a key is represented by a string the string length depends on the encoding
+ * so do not rely on string lengths to calculate key sizes.
+ *
+ * @param {number} expectedSize          expected size of the buffer in bytes
+ * @param {String|Buffer|Array} [value]  value to initialize the buffer with
+ * @param {Srting} [encoding]            encoding to use in conversion if value is a string. Defaults to 'hex'
+ * @param {boolean} [secure]             store the buffer in secure memory. Defaults to CryptoBaseBuffer.secureMemory
+ */
+CryptoBaseBuffer.prototype.init = function(options) {
+    options = options || {};
 
-    /**
-     * Set the default encoding to use in all string conversions
-     * @param {String} encoding  encoding to use
-     */
-    self.setEncoding = function(encoding) {
-        assert(typeof encoding == 'string');
-        assert(encoding.match(self.validEncodings));
-        self.defaultEncoding = encoding;
-    };
+    if( options.secure !== undefined ) {
+        this.secure = !!options.secure;
+    }
 
-    /**
-     * Get the current default encoding
-     * @returns {undefined|String}
-     */
-    self.getEncoding = function() {
-        return self.defaultEncoding;
-    };
+    assert(typeof options.expectedSize == 'number' && options.expectedSize > 0, 'options.expectedSize > 0');
 
-    /**
-     * Return the type of data stored in the buffer.
-     * Example: "BoxKeyPublicKey" for a Box object's public key
-     * @returns {undefined|String}
-     */
-    self.getType = function() {
-        return self.type;
-    };
+    if ( !options.type ) {
+        throw this.error('type must be passed to init');
+    }
+    assert(typeof options.type == 'string');
 
-    /**
-     * Set the valid string encodings
-     *
-     * A lot of cryptographic functions rely on random buffer data that cannot
-     * be accurately converted to and from some encoding schemes. This method
-     * allows you to restrict the string encoding to settings you know will work
-     *
-     * @param {Array} encList   array of strings with supported encodings
-     */
-    self.setValidEncodings = function(encList) {
-        if( !encList ) {
-            return;
-        }
-        assert(encList instanceof Array);
-        var rxStr = '^(?:';
-        var l = encList.length;
-        for(var i=0; i < l; i++) {
-            if( encList[i] === 'utf8' ) {
-                throw self.error('utf8 cannot be used to decode random byte buffers. Crypto is "random"');
-            }
-            rxStr += encList[i];
-            if( i != l-1 ) rxStr += '|';
-        }
-        rxStr += ')$';
+    this.type = options.type;
 
-        self.validEncodings = new RegExp(rxStr);
-    };
+    if ( !options.expectedSize ) {
+        throw this.error('expectedSize must be passed to init');
+    }
+    this.expectedSize = options.expectedSize;
 
-    /**
-     * Generate a new Error appropriate to use with throw
-     * @param errorMessage
-     * @returns {Error}
-     */
-    self.error = function(errorMessage) {
-        return new Error('[CryptoBaseBuffer] ' + self.type + ' ' + errorMessage);
-    };
+    if( !options.buffer ) {
+        this.generate();
+        return;
+    }
 
-    /**
-     * Convert value into a buffer
-     *
-     * @param {String|Buffer|Array} value  a buffer, and array of bytes or a string that you want to convert to a buffer
-     * @param {String} [encoding]          encoding to use in conversion if value is a string. Defaults to 'hex'
-     * @returns {*}
-     */
-    self.toBuffer = function(value, encoding) {
-        encoding = encoding || self.defaultEncoding;
-
-        if( encoding && !encoding.match(self.validEncodings)) {
-            throw self.error('invalid encoding');
-        }
+    this.set(options.buffer, options.encoding);
+};
 
-        return toBuffer(value, encoding);
-    };
+/**
+ * Set the default encoding to use in all string conversions
+ * @param {String} encoding  encoding to use
+ */
+CryptoBaseBuffer.prototype.setEncoding = function(encoding) {
+    assert(typeof encoding == 'string');
+    assert(encoding.match(this.validEncodings));
+    this.defaultEncoding = encoding;
+};
 
-    /**
-     * Get the length of the buffer
-     * @returns {number} length in bytes of the buffer
-     */
-    self.size = function() {
-        return self.expectedSize;
-    };
+/**
+ * Get the current default encoding
+ * @returns {undefined|String}
+ */
+CryptoBaseBuffer.prototype.getEncoding = function() {
+    return this.defaultEncoding;
+};
 
-    /**
-     * Get the length of the buffer
-     * @returns {number} length in bytes of the buffer
-     */
-    self.bytes = self.size;
+/**
+ * Return the type of data stored in the buffer.
+ * Example: "BoxKeyPublicKey" for a Box object's public key
+ * @returns {undefined|String}
+ */
+CryptoBaseBuffer.prototype.getType = function() {
+    return this.type;
+};
 
-    /**
-     * Check if value could be used by CryptoBaseBuffer as a buffer
-     *
-     * @param {String|Buffer|Array} value to test
-     * @param {String} [encoding]   encoding to use in conversion if value is a string. Defaults to 'hex'
-     * @returns {boolean} true      if value could be used as a CryptoBaseBuffer
-     */
-    self.isValid = function(value, encoding) {
-        if( !self.expectedSize ) {
-            throw self.error('expectedSize must be set in the sub-class by calling init()');
+/**
+ * Set the valid string encodings
+ *
+ * A lot of cryptographic functions rely on random buffer data that cannot
+ * be accurately converted to and from some encoding schemes. This method
+ * allows you to restrict the string encoding to settings you know will work
+ *
+ * @param {Array} encList   array of strings with supported encodings
+ */
+CryptoBaseBuffer.prototype.setValidEncodings = function(encList) {
+    if( !encList ) {
+        return;
+    }
+    assert(encList instanceof Array);
+    var rxStr = '^(?:';
+    var l = encList.length;
+    for(var i=0; i < l; i++) {
+        if( encList[i] === 'utf8' ) {
+            throw this.error('utf8 cannot be used to decode random byte buffers. Crypto is "random"');
         }
+        rxStr += encList[i];
+        if( i != l-1 ) rxStr += '|';
+    }
+    rxStr += ')$';
+
+    if( !encodingPatterns[rxStr] ) {
+        encodingPatterns[rxStr] = new RegExp(rxStr);
+    }
+    this.validEncodings = encodingPatterns[rxStr];
+};
 
-        if( typeof value === 'string' ) {
-            encoding = encoding || self.defaultEncoding || 'hex';
+/**
+ * Generate a new Error appropriate to use with throw
+ * @param errorMessage
+ * @returns {Error}
+ */
+CryptoBaseBuffer.prototype.error = function(errorMessage) {
+    return new Error('[CryptoBaseBuffer] ' + this.type + ' ' + errorMessage);
+};
 
-            if( encoding === 'utf8' ) {
-                throw self.error('utf8 cannot be used to encode/decode random byte buffers. Crypto is "random"');
-            }
+/**
+ * Convert value into a buffer
+ *
+ * @param {String|Buffer|Array} value  a buffer, and array of bytes or a string that you want to convert to a buffer
+ * @param {String} [encoding]          encoding to use in conversion if value is a string. Defaults to 'hex'
+ * @returns {*}
+ */
+CryptoBaseBuffer.prototype.toBuffer = function(value, encoding) {
+    encoding = encoding || this.defaultEncoding;
 
-            if( encoding && !encoding.match(self.validEncodings)) {
-                throw self.error('invalid encoding');
-            }
+    if( encoding && !encoding.match(this.validEncodings)) {
+        throw this.error('invalid encoding');
+    }
 
-            return Buffer.byteLength(value, encoding) == self.expectedSize;
-        }
+    return toBuffer(value, encoding);
+};
 
-        if( typeof value == 'object' ) {
-            if( value instanceof Array || value instanceof Buffer ) {
-                return value.length == self.expectedSize;
-            }
-            if( value instanceof CryptoBaseBuffer ) {
-                return value.size() == self.expectedSize;
-            }
-        }
-        return false;
-    };
+/**
+ * Get the length of the buffer
+ * @returns {number} length in bytes of the buffer
+ */
+CryptoBaseBuffer.prototype.size = function() {
+    return this.expectedSize;
+};
 
-    /**
-     * Wipe buffer securely
-     */
-    self.wipe = function() {
-        if( self.baseBuffer ) {
-            binding.memzero(self.baseBuffer);
-        }
-    };
+/**
+ * Get the length of the buffer
+ * @returns {number} length in bytes of the buffer
+ */
+CryptoBaseBuffer.prototype.bytes = CryptoBaseBuffer.prototype.size;
 
-    /**
-     * Fill buffer with random bytes
-     * This method can be redefined in each sub-class to implement
-     * the specific needs of that class
-     */
-    self.generate = function() {
-        if( !self.expectedSize ) {
-            throw self.error('expectedSize must be set in the sub-class by calling init()');
-        }
-        self.baseBuffer = Buffer.allocUnsafe(self.expectedSize);
-        binding.randombytes_buf(self.baseBuffer);
-    };
+/**
+ * Check if value could be used by CryptoBaseBuffer as a buffer
+ *
+ * @param {String|Buffer|Array} value to test
+ * @param {String} [encoding]   encoding to use in conversion if value is a string. Defaults to 'hex'
+ * @returns {boolean} true      if value could be used as a CryptoBaseBuffer
+ */
+CryptoBaseBuffer.prototype.isValid = function(value, encoding) {
+    if( !this.expectedSize ) {
+        throw this.error('expectedSize must be set in the sub-class by calling init()');
+    }
 
-    /**
-     *  Getter for the baseBuffer
-     * @returns {undefined| Buffer} secret key
-     */
-    self.get = function() {
-        return self.baseBuffer;
-    };
+    if( typeof value === 'string' ) {
+        encoding = encoding || this.defaultEncoding || 'hex';
 
-    /**
-     * Set the secret key to a known value
-     * @param {String|Buffer|Array} value   the secret value to set the buffer to
-     * @param {String} [encoding]           If v is a string you can specify the encoding.
-     */
-    self.set = function(value, encoding) {
-        encoding = encoding || self.defaultEncoding;
-
-        if( !value ) {
-            self.wipe();
-            return;
+        if( encoding === 'utf8' ) {
+            throw this.error('utf8 cannot be used to encode/decode random byte buffers. Crypto is "random"');
         }
 
-        if( encoding && !encoding.match(self.validEncodings)) {
-            throw self.error('invalid encoding');
+        if( encoding && !encoding.match(this.validEncodings)) {
+            throw this.error('invalid encoding');
         }
 
-        if( !self.isValid(value, encoding) ) {
-            throw self.error('baseBuffer length must be ' + self.expectedSize + ' bytes');
-        }
+        return Buffer.byteLength(value, encoding) == this.expectedSize;
+    }
 
-        if( value instanceof CryptoBaseBuffer ) {
-            self.baseBuffer = value;
+    if( typeof value == 'object' ) {
+        if( value instanceof Array || value instanceof Buffer ) {
+            return value.length == this.expectedSize;
         }
-        else {
-            self.baseBuffer = self.toBuffer(value, encoding);
+        if( value instanceof CryptoBaseBuffer ) {
+            return value.size() == this.expectedSize;
         }
-    };
+    }
+    return false;
+};
 
-    /**
-     * Convert the secret key to a string object
-     * @param encoding {String} optional sting encoding. defaults to 'hex'
-     */
-    self.toString = function(encoding) {
-        encoding = encoding || self.defaultEncoding || 'hex';
-
-        if( encoding.toLowerCase() === 'utf8' ) {
-            throw self.error('utf8 cannot be used to decode random byte buffers. Crypto is "random"');
-        }
+/**
+ * Wipe buffer securely
+ */
+CryptoBaseBuffer.prototype.wipe = function() {
+    if( this.baseBuffer ) {
+        binding.memzero(this.baseBuffer);
+    }
+};
 
-        if( encoding && !encoding.match(self.validEncodings)) {
-            throw self.error('invalid encoding');
-        }
+/**
+ * Fill buffer with random bytes
+ * This method can be redefined in each sub-class to implement
+ * the specific needs of that class
+ */
+CryptoBaseBuffer.prototype.generate = function() {
+    if( !this.expectedSize ) {
+        throw this.error('expectedSize must be set in the sub-class by calling init()');
+    }
+    this.baseBuffer = this.alloc(this.expectedSize);
+    binding.randombytes_buf(this.baseBuffer);
+};
 
-        if( !self.baseBuffer ) {
-            throw self.error('buffer has not been generated or set yet.');
-        }
+/**
+ * Allocate a buffer for the secret, in secure memory if this.secure is set
+ * @param {number} size   size in bytes
+ * @returns {Buffer}
+ */
+CryptoBaseBuffer.prototype.alloc = function(size) {
+    return this.secure ? binding.sodium_malloc(size) : Buffer.allocUnsafe(size);
+};
 
-        return self.baseBuffer.toString(encoding);
-    };
+/**
+ *  Getter for the baseBuffer
+ * @returns {undefined| Buffer} secret key
+ */
+CryptoBaseBuffer.prototype.get = function() {
+    return this.baseBuffer;
+};
 
-    /**
-     * Serialize a CryptoBaseBuffer
-     *
-     * @param {String} [encoding]   encoding used to convert the buffer to a string
-     * @returns {string}            parsable JSON string
-     */
-    self.serialize = function(encoding) {
-        encoding = encoding || self.defaultEncoding || 'hex';
-
-        if( encoding.toLowerCase() === 'utf8' ) {
-            throw self.error('utf8 cannot be used to decode random byte buffers. Crypto is "random"');
+/**
+ * Set the secret key to a known value
+ * @param {String|Buffer|Array} value   the secret value to set the buffer to
+ * @param {String} [encoding]           If v is a string you can specify the encoding.
+ */
+CryptoBaseBuffer.prototype.set = function(value, encoding) {
+    encoding = encoding || this.defaultEncoding;
+
+    if( !value ) {
+        this.wipe();
+        return;
+    }
+
+    if( encoding && !encoding.match(this.validEncodings)) {
+        throw this.error('invalid encoding');
+    }
+
+    if( !this.isValid(value, encoding) ) {
+        throw this.error('baseBuffer length must be ' + this.expectedSize + ' bytes');
+    }
+
+    if( value instanceof CryptoBaseBuffer ) {
+        this.baseBuffer = value;
+    }
+    else if( this.secure ) {
+        var buffer = this.toBuffer(value, encoding);
+        this.baseBuffer = this.alloc(buffer.length);
+        buffer.copy(this.baseBuffer);
+        if( buffer !== value ) {
+            binding.memzero(buffer);
         }
+    }
+    else {
+        this.baseBuffer = this.toBuffer(value, encoding);
+    }
+};
 
-        var out = '{ "buffer:"' + self.toString(encoding) + ',';
-        out += ' "encoding:"' + encoding + '}';
-        return out;
-    };
+/**
+ * Convert the secret key to a string object
+ * @param encoding {String} optional sting encoding. defaults to 'hex'
+ */
+CryptoBaseBuffer.prototype.toString = function(encoding) {
+    encoding = encoding || this.defaultEncoding || 'hex';
+
+    if( encoding.toLowerCase() === 'utf8' ) {
+        throw this.error('utf8 cannot be used to decode random byte buffers. Crypto is "random"');
+    }
+
+    if( encoding && !encoding.match(this.validEncodings)) {
+        throw this.error('invalid encoding');
+    }
+
+    if( !this.baseBuffer ) {
+        throw this.error('buffer has not been generated or set yet.');
+    }
+
+    // Constant time encoders, the buffer usually holds a key
+    if( encoding === 'hex' ) {
+        return binding.sodium_bin2hex(this.baseBuffer);
+    }
+    if( encoding === 'base64' ) {
+        return binding.sodium_bin2base64(this.baseBuffer, binding.sodium_base64_VARIANT_ORIGINAL);
+    }
+    return this.baseBuffer.toString(encoding);
+};
 
-    /**
-     * Deserialize object. Take a parsable JSON string and create a valid buffer object
-     *
-     * @param {Object} obj    parsable JSON String
-     */
-    self.deserialize = function(obj) {
-        var o;
-        try {
-            o = JSON.parse(obj);
-        }
-        catch (e) {
-            throw self.error('invalid object to deserialize: ' + e.message);
-        }
+/**
+ * Serialize a CryptoBaseBuffer
+ *
+ * @param {String} [encoding]   encoding used to convert the buffer to a string
+ * @returns {string}            parsable JSON string
+ */
+CryptoBaseBuffer.prototype.serialize = function(encoding) {
+    encoding = encoding || this.defaultEncoding || 'hex';
 
-        self.set(o.buffer, o.encoding);
-    };
+    if( encoding.toLowerCase() === 'utf8' ) {
+        throw this.error('utf8 cannot be used to decode random byte buffers. Crypto is "random"');
+    }
 
-    // some aliases
-    self.toJSON = self.serialize;
-    self.parse = self.deserialize;
+    var out = '{ "buffer:"' + this.toString(encoding) + ',';
+    out += ' "encoding:"' + encoding + '}';
+    return out;
 };
+
+/**
+ * Deserialize object. Take a parsable JSON string and create a valid buffer object
+ *
+ * @param {Object} obj    parsable JSON String
+ */
+CryptoBaseBuffer.prototype.deserialize = function(obj) {
+    var o;
+    try {
+        o = JSON.parse(obj);
+    }
+    catch (e) {
+        throw this.error('invalid object to deserialize: ' + e.message);
+    }
+
+    this.set(o.buffer, o.encoding);
+};
+
+// some aliases
+CryptoBaseBuffer.prototype.toJSON = CryptoBaseBuffer.prototype.serialize;
+CryptoBaseBuffer.prototype.parse = CryptoBaseBuffer.prototype.deserialize;
+
+/**
+ * Nonce bytes for a single call, without building a nonce object when
+ * there is nothing to convert
+ *
+ * A Buffer of `size` bytes is returned as is and no value gives `size` random
+ * bytes. Anything else is converted and checked by a new `Nonce`
+ *
+ * @param {Function} Nonce               nonce class, BoxNonce for example
+ * @param {number} size                  nonce size in bytes
+ * @param {String|Buffer|Array} [value]  nonce
+ * @returns {Buffer}
+ */
+CryptoBaseBuffer.nonce = function(Nonce, size, value) {
+    if( value === undefined ) {
+        var nonce = Buffer.allocUnsafe(size);
+        binding.randombytes_buf(nonce);
+        return nonce;
+    }
+    if( Buffer.isBuffer(value) && value.length === size ) {
+        return value;
+    }
+    return new Nonce(value).get();
+};
+
+/**
+ * Default for new buffers: when true keys are kept in sodium_malloc memory,
+ * locked and guarded, instead of ordinary Buffers
+ */
+CryptoBaseBuffer.secureMemory = false;
+
+module.exports = CryptoBaseBuffer;
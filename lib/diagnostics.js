@@ -0,0 +1,189 @@
+/**
+ * # Diagnostics
+ * Publish crypto calls on `diagnostics_channel`
+ *
+ * Every crypto function of the addon is wrapped so that, while anyone
+ * subscribes, each call is published with its primitive, input size and
+ * duration. Without subscribers a wrapper only checks `hasSubscribers` and
+ * calls through.
+ *
+ *     var dc = require('diagnostics_channel');
+ *     dc.subscribe('sodium:crypto', function(message) {
+ *         // { primitive: 'crypto_pwhash', size: 12, duration: 251.3, async: true, error: null }
+ *     });
+ *
+ * Where `diagnostics_channel.tracingChannel` exists, calls are also traced
+ * on `tracing:sodium:crypto:start`, `:end`, `:asyncStart`, `:asyncEnd` and
+ * `:error`, which APM tools turn into spans of the current request.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var dc;
+try {
+    dc = require('diagnostics_channel');
+}
+catch (e) {
+    dc = null;
+}
+
+var performance = require('perf_hooks').performance;
+
+/** Channel of completed calls */
+var CHANNEL_NAME = 'sodium:crypto';
+
+/** Functions traced, by name */
+var TRACED = /^crypto_(aead|auth|box|generichash|hash|kdf|kx|onetimeauth|pwhash|scalarmult|secretbox|secretstream|shorthash|sign|stream)/;
+
+/** Size and name getters, not crypto work */
+var UNTRACED = /_(\w*bytes(_min|_max)?|primitive|strprefix|(ops|mem)limit_\w+|alg_\w+)$/i;
+
+/**
+ * True for the addon functions that do crypto work, as opposed to size and
+ * name getters
+ * @param {String} name
+ */
+function isCrypto(name) {
+    return TRACED.test(name) && !UNTRACED.test(name);
+}
+
+var channel = dc ? dc.channel(CHANNEL_NAME) : null;
+var tracing = dc && dc.tracingChannel ? dc.tracingChannel(CHANNEL_NAME) : null;
+
+function tracingSubscribed() {
+    return tracing !== null && (tracing.start.hasSubscribers || tracing.end.hasSubscribers ||
+        tracing.asyncStart.hasSubscribers || tracing.asyncEnd.hasSubscribers ||
+        tracing.error.hasSubscribers);
+}
+
+// Bytes of the buffer and typed array arguments
+function inputSize(args) {
+    var size = 0;
+    for (var i = 0; i < args.length; i++) {
+        if (ArrayBuffer.isView(args[i])) {
+            size += args[i].byteLength;
+        }
+    }
+    return size;
+}
+
+/**
+ * Call `fn` with `args` on `self`, publishing the call. Async calls are
+ * published when their callback runs or their Promise settles
+ */
+function traced(name, fn, self, args) {
+    var context = { primitive: name, size: inputSize(args), duration: 0, async: false, error: null };
+    var trace = tracingSubscribed();
+    var start = performance.now();
+
+    function finish(err) {
+        context.duration = performance.now() - start;
+        context.error = err || null;
+        if (err && trace) {
+            tracing.error.publish(context);
+        }
+        if (channel.hasSubscribers) {
+            channel.publish(context);
+        }
+    }
+
+    function settled(result) {
+        if (trace) {
+            context.result = result;
+            tracing.asyncStart.publish(context);
+            tracing.asyncEnd.publish(context);
+        }
+    }
+
+    var last = args.length - 1;
+    if (last >= 0 && typeof args[last] === 'function') {
+        var callback = args[last];
+        context.async = true;
+        args = Array.prototype.slice.call(args);
+        args[last] = function(err, result) {
+            finish(err);
+            if (!trace) {
+                return callback.apply(this, arguments);
+            }
+            context.result = result;
+            var self = this;
+            var callArgs = arguments;
+            return tracing.asyncStart.runStores(context, function() {
+                try {
+                    return callback.apply(self, callArgs);
+                }
+                finally {
+                    tracing.asyncEnd.publish(context);
+                }
+            });
+        };
+    }
+
+    // Same order of events as TracingChannel.traceSync
+    function run() {
+        try {
+            return fn.apply(self, args);
+        }
+        catch (err) {
+            finish(err);
+            throw err;
+        }
+        finally {
+            if (trace) {
+                tracing.end.publish(context);
+            }
+        }
+    }
+    var result = trace ? tracing.start.runStores(context, run) : run();
+
+    if (context.async || context.error) {
+        return result;
+    }
+    if (result && typeof result.then === 'function') {
+        context.async = true;
+        return result.then(function(value) {
+            finish(null);
+            settled(value);
+            return value;
+        }, function(err) {
+            finish(err);
+            settled(undefined);
+            throw err;
+        });
+    }
+    finish(null);
+    return result;
+}
+
+function wrap(name, fn) {
+    return function() {
+        if (!channel.hasSubscribers && !tracingSubscribed()) {
+            return fn.apply(this, arguments);
+        }
+        return traced(name, fn, this, arguments);
+    };
+}
+
+/**
+ * Wrap the crypto functions of `binding` in place. Does nothing where
+ * `diagnostics_channel` is not available, or when already done
+ * @param {Object} binding the addon
+ */
+function install(binding) {
+    if (!channel || binding.__sodium_diagnostics) {
+        return;
+    }
+    Object.keys(binding).forEach(function(name) {
+        var fn = binding[name];
+        if (typeof fn === 'function' && isCrypto(name)) {
+            binding[name] = wrap(name, fn);
+        }
+    });
+    Object.defineProperty(binding, '__sodium_diagnostics', { value: true });
+}
+
+module.exports.install = install;
+module.exports.isCrypto = isCrypto;
+module.exports.CHANNEL_NAME = CHANNEL_NAME;
@@ -8,7 +8,7 @@
 /* jslint node: true */
 'use strict';
 
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var DHKey = require('./keys/dh-key');
 
 module.exports = function ECDH(publicKey, secretKey) {
@@ -16,6 +16,8 @@ module.exports = function ECDH(publicKey, secretKey) {
 
     self.iSecret = undefined;
     self.iSessionKey = undefined;
+    self.iPublicKey = undefined;
+    self.iSharedKeys = {};
 
     self.iKey = new DHKey(publicKey, secretKey);
 
@@ -30,6 +32,54 @@ module.exports = function ECDH(publicKey, secretKey) {
     self.reset = function () {
         self.iSecret = undefined;
         self.iSessionKey = undefined;
+        self.iSharedKeys = {};
+    };
+
+    /**
+     * Own public key, computed from the secret key on first use
+     */
+    self.publicKey = function () {
+        if (!self.iPublicKey) {
+            self.iPublicKey = binding.crypto_scalarmult_base(self.iKey.sk().get());
+        }
+        return self.iPublicKey;
+    };
+
+    /**
+     * BLAKE2b(q || client public key || server public key), in one native
+     * call. Pass `client` true on the client and false on the server. Left
+     * out, the two public keys are hashed in byte order, so both sides
+     * agree without roles
+     *
+     * @param {Boolean} [client]
+     * @param {Number} [size]  bytes of key, crypto_generichash_BYTES by default
+     * @returns {Buffer} the key, or null if the peer key is rejected
+     */
+    self.sharedKey = function (client, size) {
+        var id = String(client) + ':' + (size || binding.crypto_generichash_BYTES);
+        if (!self.iSharedKeys[id]) {
+            var own = self.publicKey();
+            var peer = self.iKey.pk().get();
+            var first = client === undefined ? Buffer.compare(own, peer) <= 0 : client;
+            self.iSharedKeys[id] = binding.crypto_scalarmult_shared_key(self.iKey.sk().get(), peer,
+                first ? own : peer, first ? peer : own, size);
+        }
+        return self.iSharedKeys[id];
+    };
+
+    /**
+     * The shared keys of this key, as the server, with many clients, back to
+     * back. A key is all zeros where a client key is rejected
+     *
+     * @param {Array|Buffer|Object} clientPublicKeys  array, packed batch or
+     *                                                keys back to back
+     * @param {Number} [size]
+     * @param {Number} [threads]
+     * @returns {Buffer}
+     */
+    self.sharedKeys = function (clientPublicKeys, size, threads) {
+        return binding.crypto_scalarmult_shared_key_batch(self.iKey.sk().get(), self.publicKey(),
+            clientPublicKeys, size, threads);
     };
 
     self.sessionKey = function () {
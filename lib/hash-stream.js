@@ -0,0 +1,220 @@
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var stream = require('stream');
+var util = require('util');
+var assert = require('assert');
+
+/** Default size of the write coalescing buffer */
+var DEFAULT_COALESCE_SIZE = 64 * 1024;
+
+/**
+ * Incremental hash primitives. Each one keeps its state in a Buffer
+ * returned by the native `_init` call and updated in place.
+ */
+var algorithms = {
+    generichash: {
+        init: function(options) {
+            return binding.crypto_generichash_init(options.key || null, options.outputLength);
+        },
+        update: binding.crypto_generichash_update,
+        final: function(state, options) {
+            return binding.crypto_generichash_final(state, options.outputLength);
+        },
+        outputLength: binding.crypto_generichash_BYTES
+    },
+
+    sha256: {
+        init: binding.crypto_hash_sha256_init,
+        update: binding.crypto_hash_sha256_update,
+        final: binding.crypto_hash_sha256_final,
+        outputLength: binding.crypto_hash_sha256_BYTES
+    },
+
+    sha512: {
+        init: binding.crypto_hash_sha512_init,
+        update: binding.crypto_hash_sha512_update,
+        final: binding.crypto_hash_sha512_final,
+        outputLength: binding.crypto_hash_sha512_BYTES
+    }
+};
+
+/**
+ * Hash a stream of data with an incremental hash.
+ *
+ * Writes smaller than `coalesceSize` are copied into a staging buffer and
+ * handed to libsodium in one `update` call once it fills up; larger writes go
+ * to `update` directly. Memory use is constant whatever the size of the
+ * input.
+ *
+ * The readable side emits the digest once the writable side ends. `update()`
+ * and `digest()` can be used instead when a stream is not needed.
+ *
+ * @param {String} algorithm  'generichash', 'sha256' or 'sha512'
+ * @param {Object} [options]  stream.Transform options, plus
+ *   - `key` (Buffer): generichash key, optional
+ *   - `outputLength` (Number): generichash digest size. Default crypto_generichash_BYTES
+ *   - `coalesceSize` (Number): staging buffer size. Default 64KB
+ * @constructor
+ */
+function HashStream(algorithm, options) {
+    if( !(this instanceof HashStream) ) {
+        return new HashStream(algorithm, options);
+    }
+
+    var algo = algorithms[algorithm];
+    assert.ok(algo, 'unknown hash algorithm ' + algorithm);
+
+    options = options || {};
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var params = {
+        key: options.key,
+        outputLength: options.outputLength || algo.outputLength
+    };
+    var coalesceSize = options.coalesceSize || DEFAULT_COALESCE_SIZE;
+    var staging = null;
+    var used = 0;
+    var state = algo.init(params);
+    var result = null;
+
+    assert.ok(state, 'failed to initialize ' + algorithm + ' state');
+
+    /** Name of the hash primitive */
+    self.algorithm = algorithm;
+
+    function drain() {
+        if( used > 0 ) {
+            algo.update(state, staging.slice(0, used));
+            used = 0;
+        }
+    }
+
+    /**
+     * Add data to the hash
+     * @param {Buffer|String} data
+     * @param {String} [encoding]  string encoding
+     * @returns {HashStream} this
+     */
+    self.update = function(data, encoding) {
+        assert.ok(!result, 'digest already computed');
+
+        if( !Buffer.isBuffer(data) ) {
+            data = Buffer.from(data, encoding);
+        }
+
+        if( data.length >= coalesceSize ) {
+            drain();
+            algo.update(state, data);
+            return self;
+        }
+
+        if( !staging ) {
+            staging = Buffer.allocUnsafe(coalesceSize);
+        }
+        if( used + data.length > coalesceSize ) {
+            drain();
+        }
+        data.copy(staging, used);
+        used += data.length;
+        return self;
+    };
+
+    /**
+     * Finish hashing. Later calls return the same digest.
+     * @param {String} [encoding]  return a string in this encoding
+     * @returns {Buffer|String} digest
+     */
+    self.digest = function(encoding) {
+        if( !result ) {
+            drain();
+            result = algo.final(state, params);
+            binding.memzero(state);
+            if( staging ) {
+                binding.memzero(staging);
+                staging = null;
+            }
+        }
+        return encoding ? result.toString(encoding) : result;
+    };
+
+    self._transform = function(chunk, encoding, callback) {
+        try {
+            self.update(chunk, encoding);
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback();
+    };
+
+    self._flush = function(callback) {
+        self.push(self.digest());
+        callback();
+    };
+}
+util.inherits(HashStream, stream.Transform);
+
+/**
+ * Hash everything that flows through, passing the data on unchanged.
+ * The digest is available from `digest()` and the `digest` event once the
+ * stream ends.
+ *
+ * @param {String} algorithm  see HashStream
+ * @param {Object} [options]  see HashStream
+ * @constructor
+ */
+function HashPassThrough(algorithm, options) {
+    if( !(this instanceof HashPassThrough) ) {
+        return new HashPassThrough(algorithm, options);
+    }
+
+    options = options || {};
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var hash = new HashStream(algorithm, {
+        key: options.key,
+        outputLength: options.outputLength,
+        coalesceSize: options.coalesceSize
+    });
+
+    /** Name of the hash primitive */
+    self.algorithm = algorithm;
+
+    self.digest = hash.digest;
+
+    self._transform = function(chunk, encoding, callback) {
+        try {
+            hash.update(chunk, encoding);
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback(null, chunk);
+    };
+
+    self._flush = function(callback) {
+        self.emit('digest', hash.digest());
+        callback();
+    };
+}
+util.inherits(HashPassThrough, stream.Transform);
+
+module.exports.HashStream = HashStream;
+module.exports.HashPassThrough = HashPassThrough;
+module.exports.DEFAULT_COALESCE_SIZE = DEFAULT_COALESCE_SIZE;
+
+/** The incremental hash primitives, by name */
+module.exports.algorithms = algorithms;
+
+/**
+ * Create a hash stream
+ * @param {String} algorithm  'generichash', 'sha256' or 'sha512'
+ * @param {Object} [options]  see HashStream
+ */
+module.exports.createHash = function(algorithm, options) {
+    return new HashStream(algorithm, options);
+};
@@ -5,7 +5,7 @@
 'use strict';
 
 var util = require('util');
-var binding = require('../../build/Release/sodium');
+var binding = require('../binding');
 var CryptoBaseBuffer = require('../crypto-base-buffer');
 
 /**
@@ -5,7 +5,7 @@
 'use strict';
 
 var util = require('util');
-var binding = require('../../build/Release/sodium');
+var binding = require('../binding');
 var KeyPair = require('./keypair');
 
 var Box = function BoxKey(publicKey, secretKey, encoding) {
@@ -21,13 +21,6 @@ var Box = function BoxKey(publicKey, secretKey, encoding) {
         type: 'BoxKey'
     });
 
-    self.generate = function() {
-        var keys = binding.crypto_box_keypair();
-        self.secretKey.set(keys.secretKey);
-        self.publicKey.set(keys.publicKey);
-    };
-    
-
     if( !publicKey || !secretKey ||
         !self.isValid({ 'publicKey': publicKey, 'secretKey': secretKey }) ) {
 
@@ -36,4 +29,11 @@ var Box = function BoxKey(publicKey, secretKey, encoding) {
     }
 };
 util.inherits(Box, KeyPair);
+
+Box.prototype.generate = function() {
+    var keys = binding.crypto_box_keypair();
+    this.secretKey.set(keys.secretKey);
+    this.publicKey.set(keys.publicKey);
+};
+
 module.exports = Box;
\ No newline at end of file
@@ -2,8 +2,9 @@
  * Created by bmf on 11/2/13.
  */
 var util = require('util');
-var binding = require('../../build/Release/sodium');
+var binding = require('../binding');
 var KeyPair = require('./keypair');
+var toBuffer = require('../toBuffer');
 
 var DHKey = function DHKey(publicKey, secretKey, encoding) {
     var self = this;
@@ -20,35 +21,6 @@ var DHKey = function DHKey(publicKey, secretKey, encoding) {
         type: 'DHKey'
     });
 
-    self.setBasePoint = function (point, encoding) {
-        var b = toBuffer(point, encoding);
-        if (b.length != binding.crypto_scalarmult_BYTES) {
-            throw new Error('invalid base point length');
-        }
-        self.basePoint = b;
-    };
-
-    self.resetBasePoint = function () {
-        if (!self.basePoint) {
-            self.basePoint = Buffer.allocUnsafe(binding.crypto_scalarmult_BYTES);
-        }
-
-        self.basePoint.fill(0);
-        self.basePoint[0] = 9;
-    };
-
-    self.generate = function () {
-        self.secretKey.generate();
-        var pk = binding.crypto_scalarmult(self.secretKey.get(), self.basePoint);
-        self.publicKey.set(pk);
-    };
-
-    self.makePublicKey = function (secretKey, encoding) {
-        self.secretKey.set(secretKey, encoding);
-        var pk = binding.crypto_scalarmult(self.secretKey.get(), self.basePoint);
-        self.publicKey.set(pk);
-    };
-
     self.resetBasePoint();
 
     if (!publicKey || !secretKey || !self.isValid({
@@ -67,4 +39,42 @@ var DHKey = function DHKey(publicKey, secretKey, encoding) {
 
 };
 util.inherits(DHKey, KeyPair);
+
+DHKey.prototype.setBasePoint = function (point, encoding) {
+    var b = toBuffer(point, encoding);
+    if (b.length != binding.crypto_scalarmult_BYTES) {
+        throw new Error('invalid base point length');
+    }
+    this.basePoint = b;
+};
+
+DHKey.prototype.resetBasePoint = function () {
+    if (!this.basePoint) {
+        this.basePoint = Buffer.allocUnsafe(binding.crypto_scalarmult_BYTES);
+    }
+
+    this.basePoint.fill(0);
+    this.basePoint[0] = 9;
+};
+
+DHKey.prototype.generate = function () {
+    // With the standard base point this is crypto_box_keypair, which can
+    // take a pre-generated pair from the key pair pool
+    if (this.basePoint[0] === 9 && binding.sodium_is_zero(this.basePoint.slice(1)) === 1) {
+        var keys = binding.crypto_box_keypair();
+        this.secretKey.set(keys.secretKey);
+        this.publicKey.set(keys.publicKey);
+        return;
+    }
+    this.secretKey.generate();
+    var pk = binding.crypto_scalarmult(this.secretKey.get(), this.basePoint);
+    this.publicKey.set(pk);
+};
+
+DHKey.prototype.makePublicKey = function (secretKey, encoding) {
+    this.secretKey.set(secretKey, encoding);
+    var pk = binding.crypto_scalarmult(this.secretKey.get(), this.basePoint);
+    this.publicKey.set(pk);
+};
+
 module.exports = DHKey;
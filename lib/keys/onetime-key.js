@@ -2,7 +2,7 @@
  * Created by bmf on 11/2/13.
  */
 var util = require('util');
-var binding = require('../../build/Release/sodium');
+var binding = require('../binding');
 var CryptoBaseBuffer = require('../crypto-base-buffer');
 
 var OneTime = function OneTimeAuthKey(key, encoding) {
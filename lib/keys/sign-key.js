@@ -2,7 +2,7 @@
  * Created by bmf on 11/2/13.
  */
 var util = require('util');
-var binding = require('../../build/Release/sodium');
+var binding = require('../binding');
 var KeyPair = require('./keypair');
 var toBuffer = require('../toBuffer');
 
@@ -20,12 +20,6 @@ var Sign = function SignKey(publicKey, secretKey, encoding) {
         type: 'SignKey'
     });
 
-    self.generate = function() {
-        var keys = binding.crypto_sign_keypair();
-        self.secretKey.set(keys.secretKey);
-        self.publicKey.set(keys.publicKey);
-    };
-
     if( !publicKey || !secretKey ||
         !self.isValid({ 'publicKey': publicKey, 'secretKey': secretKey }) ) {
 
@@ -35,6 +29,12 @@ var Sign = function SignKey(publicKey, secretKey, encoding) {
 };
 util.inherits(Sign, KeyPair);
 
+Sign.prototype.generate = function() {
+    var keys = binding.crypto_sign_keypair();
+    this.secretKey.set(keys.secretKey);
+    this.publicKey.set(keys.publicKey);
+};
+
 Sign.fromSeed = function(seed, encoding) {
     encoding = String(encoding) || 'utf8';
 
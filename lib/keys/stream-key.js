@@ -1,5 +1,5 @@
 var util = require('util');
-var binding = require('../../build/Release/sodium');
+var binding = require('../binding');
 var CryptoBaseBuffer = require('../crypto-base-buffer');
 
 var Stream = function StreamKey(key, encoding) {
@@ -0,0 +1,81 @@
+/**
+ * # Latency
+ * Queue wait and run time of the async bindings
+ *
+ * The addon keeps a pair of histograms per async call, such as
+ * `crypto_pwhash`: how long jobs waited for a thread and how long they ran,
+ * in nanoseconds. `stats()` returns them with the fields of a `perf_hooks`
+ * Histogram, `prometheus()` in the Prometheus text format.
+ *
+ *     http.createServer(function(req, res) {
+ *         res.end(sodium.Latency.prometheus());
+ *     });
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+
+/** Default histogram bounds of `prometheus()`, in seconds */
+var DEFAULT_BUCKETS = [0.0001, 0.0005, 0.001, 0.005, 0.01, 0.05, 0.1, 0.5, 1, 5];
+
+/**
+ * Histograms of every async call made so far
+ * @param {Boolean} [reset] clear them once they are read
+ * @returns {Object} `{ crypto_pwhash: { wait, run }, ... }`
+ */
+function stats(reset) {
+    return binding.sodium_async_latency(!!reset);
+}
+
+function histogramLines(lines, metric, op, histogram, bounds) {
+    var labels = 'op="' + op + '"';
+    var i = 0;
+    var seen = 0;
+    bounds.forEach(function(bound) {
+        var ns = bound * 1e9;
+        // A bucket that straddles the bound counts above it
+        while (i < histogram.buckets.length && histogram.buckets[i][0] <= ns) {
+            seen += histogram.buckets[i][1];
+            i++;
+        }
+        lines.push(metric + '_bucket{' + labels + ',le="' + bound + '"} ' + seen);
+    });
+    lines.push(metric + '_bucket{' + labels + ',le="+Inf"} ' + histogram.count);
+    lines.push(metric + '_sum{' + labels + '} ' + histogram.sum / 1e9);
+    lines.push(metric + '_count{' + labels + '} ' + histogram.count);
+}
+
+/**
+ * The histograms in the Prometheus text exposition format, as
+ * `<prefix>_wait_seconds` and `<prefix>_run_seconds` with an `op` label
+ *
+ * @param {Object} [options]
+ * @param {String} [options.prefix] metric name prefix, `sodium_async` by default
+ * @param {Number[]} [options.buckets] histogram bounds in seconds, ascending
+ * @returns {String}
+ */
+function prometheus(options) {
+    options = options || {};
+    var prefix = options.prefix || 'sodium_async';
+    var bounds = options.buckets || DEFAULT_BUCKETS;
+    var latency = stats();
+    var lines = [];
+
+    [['wait', 'Time async sodium jobs waited for a thread'],
+     ['run', 'Time async sodium jobs ran on a thread']].forEach(function(kind) {
+        var metric = prefix + '_' + kind[0] + '_seconds';
+        lines.push('# HELP ' + metric + ' ' + kind[1]);
+        lines.push('# TYPE ' + metric + ' histogram');
+        Object.keys(latency).forEach(function(op) {
+            histogramLines(lines, metric, op, latency[op][kind[0]], bounds);
+        });
+    });
+    return lines.join('\n') + '\n';
+}
+
+module.exports.stats = stats;
+module.exports.prometheus = prometheus;
+module.exports.DEFAULT_BUCKETS = DEFAULT_BUCKETS;
@@ -2,7 +2,7 @@
 'use strict';
 
 var assert = require('assert');
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var OneTimeKey = require('./keys/onetime-key');
 var toBuffer = require('./toBuffer');
 
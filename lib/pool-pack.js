@@ -0,0 +1,98 @@
+/**
+ * Packing of pool jobs and results
+ *
+ * All the bytes of a batch travel in one ArrayBuffer that is transferred,
+ * not copied, between threads. Arguments and results that are Buffers or
+ * typed arrays are replaced by `{ $bytes: [offset, length] }` into it. Plain
+ * objects, such as key pairs, are packed one level deep. Anything else goes
+ * through the structured clone as it is.
+ */
+/* jslint node: true */
+'use strict';
+
+function isBytes(value) {
+    return ArrayBuffer.isView(value);
+}
+
+function isPlainObject(value) {
+    return value !== null && typeof value === 'object' &&
+        Object.getPrototypeOf(value) === Object.prototype;
+}
+
+function sizeOf(value) {
+    if( isBytes(value) ) {
+        return value.byteLength;
+    }
+    if( isPlainObject(value) ) {
+        var size = 0;
+        for( var k in value ) {
+            if( isBytes(value[k]) ) {
+                size += value[k].byteLength;
+            }
+        }
+        return size;
+    }
+    return 0;
+}
+
+/**
+ * Start packing `values`, a list of argument lists or of results
+ * @returns {Object} `{ bytes, write }` where `write(value)` packs one value
+ */
+function packer(values) {
+    var total = 0;
+    values.forEach(function(list) {
+        list.forEach(function(value) {
+            total += sizeOf(value);
+        });
+    });
+
+    var bytes = new ArrayBuffer(total);
+    var view = new Uint8Array(bytes);
+    var offset = 0;
+
+    function copy(value) {
+        var desc = { $bytes: [offset, value.byteLength] };
+        view.set(new Uint8Array(value.buffer, value.byteOffset, value.byteLength), offset);
+        offset += value.byteLength;
+        return desc;
+    }
+
+    function write(value) {
+        if( isBytes(value) ) {
+            return copy(value);
+        }
+        if( isPlainObject(value) ) {
+            var out = {};
+            for( var k in value ) {
+                out[k] = isBytes(value[k]) ? copy(value[k]) : value[k];
+            }
+            return { $object: out };
+        }
+        return value;
+    }
+
+    return { bytes: bytes, write: write };
+}
+
+/**
+ * Turn a packed value back into Buffers over `bytes`
+ */
+function unpack(value, bytes) {
+    if( value !== null && typeof value === 'object' ) {
+        if( value.$bytes ) {
+            return Buffer.from(bytes, value.$bytes[0], value.$bytes[1]);
+        }
+        if( value.$object ) {
+            var out = {};
+            for( var k in value.$object ) {
+                out[k] = unpack(value.$object[k], bytes);
+            }
+            return out;
+        }
+    }
+    return value;
+}
+
+module.exports.packer = packer;
+module.exports.unpack = unpack;
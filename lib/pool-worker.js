@@ -0,0 +1,37 @@
+/**
+ * Worker side of CryptoPool. Runs each job of a batch against the addon and
+ * sends the results back in one transferred buffer.
+ */
+/* jslint node: true */
+'use strict';
+
+var wt = require('worker_threads');
+var binding = require('./binding');
+var pack = require('./pool-pack');
+
+wt.parentPort.on('message', function(batch) {
+    var results = batch.jobs.map(function(job) {
+        var fn = binding[job.fn];
+        if( typeof fn !== 'function' ) {
+            return [undefined, 'unknown function ' + job.fn];
+        }
+        try {
+            var args = job.args.map(function(arg) {
+                return pack.unpack(arg, batch.bytes);
+            });
+            return [fn.apply(binding, args), undefined];
+        }
+        catch (e) {
+            return [undefined, e.message];
+        }
+    });
+
+    var out = pack.packer(results.map(function(r) { return [r[0]]; }));
+    wt.parentPort.postMessage({
+        id: batch.id,
+        bytes: out.bytes,
+        results: results.map(function(r) {
+            return [out.write(r[0]), r[1]];
+        })
+    }, [out.bytes]);
+});
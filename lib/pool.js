@@ -0,0 +1,207 @@
+/**
+ * # CryptoPool
+ * Run low level calls on a pool of worker threads
+ *
+ * Each worker loads its own copy of the addon. Jobs are queued and handed
+ * to idle workers in batches: while every worker is busy new jobs pile up,
+ * and the next free worker takes its share of them in one message, so the
+ * cost of a round trip is spread over more jobs exactly when the pool is
+ * loaded. With idle workers a job is sent right away.
+ *
+ * All the bytes of a batch move in a single transferred ArrayBuffer, each
+ * way, so a job costs one copy in and one copy out. Results that come back
+ * in the same batch share that ArrayBuffer.
+ *
+ *     var pool = new sodium.CryptoPool({ threads: 4 });
+ *     pool.run('crypto_sign_detached', message, secretKey).then(function(sig) {
+ *         ...
+ *     });
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var os = require('os');
+var path = require('path');
+var pack = require('./pool-pack');
+
+var Worker;
+try {
+    Worker = require('worker_threads').Worker;
+}
+catch (e) {
+    Worker = null;
+}
+
+var WORKER_SCRIPT = path.join(__dirname, 'pool-worker.js');
+
+/** Most jobs a worker takes in one message */
+var DEFAULT_MAX_BATCH = 256;
+
+/**
+ * @param {Object} [options]
+ *   - `threads` (Number): number of workers. Default: one per CPU
+ *   - `maxBatch` (Number): most jobs sent to a worker at once. Default 256
+ * @constructor
+ */
+function CryptoPool(options) {
+    if( !(this instanceof CryptoPool) ) {
+        return new CryptoPool(options);
+    }
+    if( !Worker ) {
+        throw new Error('[CryptoPool] worker_threads are not available in this version of node');
+    }
+
+    options = options || {};
+    var self = this;
+    var threads = options.threads || os.cpus().length || 1;
+    var maxBatch = options.maxBatch || DEFAULT_MAX_BATCH;
+    var queue = [];
+    var idle = [];
+    var workers = [];
+    var closed = false;
+    var nextId = 0;
+
+    /** Counters: `{ jobs, batches, errors }` */
+    self.stats = { jobs: 0, batches: 0, errors: 0 };
+
+    function spawn() {
+        var worker = new Worker(WORKER_SCRIPT);
+        worker.inflight = null;
+        worker.on('message', function(reply) {
+            finish(worker, reply);
+        });
+        worker.on('error', function(err) {
+            fail(worker, err);
+        });
+        worker.on('exit', function() {
+            if( !closed ) {
+                fail(worker, new Error('[CryptoPool] worker stopped'));
+            }
+        });
+        workers.push(worker);
+        release(worker);
+    }
+
+    // Idle workers do not keep the process alive
+    function release(worker) {
+        worker.inflight = null;
+        worker.unref();
+        idle.push(worker);
+    }
+
+    function dispatch() {
+        while( idle.length > 0 && queue.length > 0 ) {
+            var share = Math.min(maxBatch, Math.ceil(queue.length / idle.length));
+            var jobs = queue.splice(0, share);
+            var worker = idle.shift();
+            var packed = pack.packer(jobs.map(function(job) { return job.args; }));
+            var message = {
+                id: nextId++,
+                jobs: jobs.map(function(job) {
+                    return { fn: job.fn, args: job.args.map(packed.write) };
+                }),
+                bytes: packed.bytes
+            };
+
+            worker.inflight = { id: message.id, jobs: jobs };
+            worker.ref();
+            worker.postMessage(message, [packed.bytes]);
+            self.stats.batches++;
+        }
+    }
+
+    function finish(worker, reply) {
+        var jobs = worker.inflight.jobs;
+        release(worker);
+        reply.results.forEach(function(result, i) {
+            if( result[1] !== undefined ) {
+                self.stats.errors++;
+                jobs[i].reject(new Error(result[1]));
+            }
+            else {
+                jobs[i].resolve(pack.unpack(result[0], reply.bytes));
+            }
+        });
+        dispatch();
+    }
+
+    // A worker that crashed is replaced, its jobs are failed
+    function fail(worker, err) {
+        var at = workers.indexOf(worker);
+        if( at < 0 ) {
+            return;
+        }
+        workers.splice(at, 1);
+        var i = idle.indexOf(worker);
+        if( i >= 0 ) {
+            idle.splice(i, 1);
+        }
+        if( worker.inflight ) {
+            worker.inflight.jobs.forEach(function(job) {
+                self.stats.errors++;
+                job.reject(err);
+            });
+        }
+        worker.terminate();
+        if( !closed ) {
+            spawn();
+            dispatch();
+        }
+    }
+
+    /**
+     * Run a low level function, such as `'crypto_box_easy'`, on a worker
+     *
+     * Arguments are copied, so a function that changes its arguments in
+     * place, such as `randombytes_buf`, does not change the caller's.
+     *
+     * @param {String} fn  name of the function in the low level API
+     * @param {...*} args  its arguments
+     * @returns {Promise}  resolves with the result, rejects with the error thrown
+     */
+    self.run = function(fn) {
+        var args = Array.prototype.slice.call(arguments, 1);
+        if( closed ) {
+            return Promise.reject(new Error('[CryptoPool] pool is closed'));
+        }
+        return new Promise(function(resolve, reject) {
+            queue.push({ fn: fn, args: args, resolve: resolve, reject: reject });
+            self.stats.jobs++;
+            dispatch();
+        });
+    };
+
+    /**
+     * Stop the workers. Queued and running jobs are rejected
+     * @returns {Promise}  resolves once every worker has exited
+     */
+    self.close = function() {
+        if( closed ) {
+            return Promise.resolve();
+        }
+        closed = true;
+        var err = new Error('[CryptoPool] pool is closed');
+        queue.splice(0).forEach(function(job) {
+            job.reject(err);
+        });
+        return Promise.all(workers.splice(0).map(function(worker) {
+            if( worker.inflight ) {
+                worker.inflight.jobs.forEach(function(job) {
+                    job.reject(err);
+                });
+            }
+            return worker.terminate();
+        })).then(function() {});
+    };
+
+    /** Number of workers */
+    self.threads = threads;
+
+    for( var i = 0; i < threads; i++ ) {
+        spawn();
+    }
+}
+
+module.exports = CryptoPool;
@@ -0,0 +1,115 @@
+/**
+ * Prebuilt binaries
+ *
+ * `prebuild.js` builds the addon once per CPU tier of an architecture and
+ * stores each in `prebuilds/<platform>-<arch>/<tier>/sodium.node`. Tiers
+ * are listed slowest first. Every tier but `baseline` needs the CPU
+ * features in its `has` list, checked with the `sodium_runtime_has_*`
+ * functions of a binary that is already loaded.
+ *
+ * libsodium picks its SIMD kernels at run time in every tier; a tier adds
+ * `-march` code generation for everything else, libsodium's portable code
+ * and the addon itself.
+ *
+ * `prebuild-wasm.js` adds `prebuilds/wasm32/sodium.wasm`, libsodium alone
+ * compiled to WebAssembly, for hosts with no binary at all.
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var path = require('path');
+
+var TIERS = {
+    x64: [
+        { name: 'baseline', march: 'x86-64' },
+        { name: 'avx2', march: 'x86-64-v3', has: ['avx2'] },
+        { name: 'avx512', march: 'x86-64-v4', has: ['avx2', 'avx512f'] }
+    ],
+    arm64: [
+        { name: 'baseline', march: 'armv8-a' },
+        { name: 'crypto', march: 'armv8-a+crypto', has: ['armcrypto'] }
+    ]
+};
+
+var ROOT = path.join(__dirname, '..', 'prebuilds');
+
+/**
+ * Tiers for `arch`, process.arch by default
+ */
+function tiers(arch) {
+    return TIERS[arch || process.arch] || [];
+}
+
+/**
+ * Directory holding the prebuilt tiers of this host
+ */
+function dir() {
+    return path.join(ROOT, process.platform + '-' + process.arch);
+}
+
+/**
+ * Path to the binary of `tier` on this host
+ */
+function file(tier) {
+    return path.join(dir(), tier, 'sodium.node');
+}
+
+/**
+ * Path to the WebAssembly build, the same on every host
+ */
+function wasm() {
+    return path.join(ROOT, 'wasm32', 'sodium.wasm');
+}
+
+/**
+ * Tiers with a binary present, slowest first
+ */
+function available() {
+    return tiers().filter(function(tier) {
+        return fs.existsSync(file(tier.name));
+    });
+}
+
+// libsodium 1.0.16 cannot tell about the ARMv8 crypto extensions: every
+// Apple arm64 CPU has them, Linux lists them in /proc/cpuinfo
+function hasArmCrypto() {
+    if( process.platform === 'darwin' ) {
+        return true;
+    }
+    try {
+        var features = /^Features\s*:(.*)$/m.exec(fs.readFileSync('/proc/cpuinfo', 'utf8'));
+        return !!features && / aes( |$)/.test(features[1]) && / pmull( |$)/.test(features[1]);
+    } catch (e) {
+        return false;
+    }
+}
+
+function has(binding, feature) {
+    var check = binding['sodium_runtime_has_' + feature];
+    if( typeof check === 'function' ) {
+        return check() === 1;
+    }
+    return feature === 'armcrypto' && hasArmCrypto();
+}
+
+/**
+ * The fastest available tier this CPU runs, judged by `binding`
+ *
+ * @param {Object} binding  a loaded addon, for its sodium_runtime_has_*
+ * @returns {Object} the tier, or undefined when none is present
+ */
+function select(binding) {
+    return available().filter(function(tier) {
+        return (tier.has || []).every(function(feature) {
+            return has(binding, feature);
+        });
+    }).pop();
+}
+
+module.exports.tiers = tiers;
+module.exports.dir = dir;
+module.exports.file = file;
+module.exports.wasm = wasm;
+module.exports.available = available;
+module.exports.select = select;
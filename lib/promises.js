@@ -0,0 +1,83 @@
+/**
+ * # promises
+ * A Promise twin of every crypto function of the low level API
+ *
+ * `sodium.promises.<name>(...args)` takes the arguments of
+ * `sodium.api.<name>` and returns a Promise for its result, computed off the
+ * event loop:
+ *
+ *   * functions with an `_async` binding call it, on the libuv threadpool
+ *   * the others run on a shared CryptoPool of worker threads, started the
+ *     first time one is called
+ *
+ * The functions are the ones the diagnostics channel reports, the crypto
+ * work of the addon, less those that write into their arguments or build
+ * state step by step: the `_into` and `_inplace` forms and the `_init`,
+ * `_update` and `_final` calls. Arguments are copied to the worker, so
+ * those would not change the caller's buffers.
+ *
+ *     sodium.promises.crypto_secretbox_easy(message, nonce, key).then(function(c) {
+ *         ...
+ *     });
+ *
+ * `sodium.promises.close()` stops the shared pool, which is otherwise
+ * left to exit with the process: its idle workers do not keep it alive.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var diagnostics = require('./diagnostics');
+var CryptoPool = require('./pool');
+
+/**
+ * Functions that change their arguments or keep state in them, and the
+ * `_async` and streamed batch bindings themselves
+ */
+var IN_PLACE = /_(into|inplace|init|update|final|final_verify|async|each_stream|batch_stream|many_stream)$/;
+
+var pool = null;
+
+function sharedPool() {
+    if( pool === null ) {
+        pool = new CryptoPool();
+    }
+    return pool;
+}
+
+function twin(name) {
+    var async = binding[name + '_async'];
+    if( typeof async === 'function' ) {
+        return function() {
+            return async.apply(binding, arguments);
+        };
+    }
+    return function() {
+        var args = Array.prototype.slice.call(arguments);
+        return sharedPool().run.apply(null, [name].concat(args));
+    };
+}
+
+var promises = {};
+
+Object.keys(binding).forEach(function(name) {
+    if( typeof binding[name] === 'function' && diagnostics.isCrypto(name) && !IN_PLACE.test(name) ) {
+        promises[name] = twin(name);
+    }
+});
+
+/**
+ * Stop the worker threads of the shared pool, if it was started
+ * @returns {Promise}
+ */
+Object.defineProperty(promises, 'close', {
+    value: function() {
+        var closing = pool;
+        pool = null;
+        return closing ? closing.close() : Promise.resolve();
+    }
+});
+
+module.exports = promises;
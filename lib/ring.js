@@ -0,0 +1,196 @@
+/**
+ * # CryptoRing
+ * Offload crypto to a native thread through shared memory rings
+ *
+ * Jobs are descriptors written into a SharedArrayBuffer: an operation and
+ * the offsets of its input, output, key and nonce in a shared arena. The
+ * ring's thread picks them up without any call into the addon, works on the
+ * arena in place and posts completions to a second ring. There are no
+ * Promises, no copies and, while jobs keep coming, no N-API calls at all.
+ *
+ *     var ring = new sodium.CryptoRing({
+ *         entries: 256,
+ *         arenaSize: 1 << 20,
+ *         onComplete: function(id, status, length) { ... }
+ *     });
+ *     ring.arena.set(message, 0);
+ *     ring.submit('crypto_hash_sha256', 4096, 32, 0, message.length);
+ *
+ * Offsets and lengths are bytes in `ring.arena`. `onComplete` gets the id
+ * `submit` returned, a status (`CryptoRing.OK`, `CryptoRing.FAILED` for a
+ * forged message or a bad signature, `CryptoRing.BAD_JOB` for a descriptor
+ * outside the arena) and the bytes written at `out`. Completions are
+ * delivered from the event loop; `poll()` reaps them sooner.
+ *
+ * The caller owns the arena: bytes of a job must not change until it
+ * completes.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+
+var SodiumRing = binding.SodiumRing;
+var L = SodiumRing.layout;
+
+var DEFAULT_ENTRIES = 256;
+var DEFAULT_ARENA = 1 << 20;
+
+/**
+ * @param {Object} [options]
+ *   - `entries` (Number): most jobs in flight, a power of two. Default 256
+ *   - `arenaSize` (Number): bytes of the shared arena. Default 1MB
+ *   - `arena` (SharedArrayBuffer|Uint8Array): use this arena instead
+ *   - `onComplete` (Function): `onComplete(id, status, length)` per job
+ * @constructor
+ */
+function CryptoRing(options) {
+    if( !(this instanceof CryptoRing) ) {
+        return new CryptoRing(options);
+    }
+    options = options || {};
+    var self = this;
+    var entries = options.entries || DEFAULT_ENTRIES;
+    if( entries > L.MAX_ENTRIES || (entries & (entries - 1)) !== 0 ) {
+        throw new RangeError('[CryptoRing] entries must be a power of two up to ' + L.MAX_ENTRIES);
+    }
+
+    var arena = options.arena || new SharedArrayBuffer(options.arenaSize || DEFAULT_ARENA);
+    if( arena instanceof SharedArrayBuffer ) {
+        arena = new Uint8Array(arena);
+    }
+    var control = new Int32Array(new SharedArrayBuffer(4 * (L.HEADER + entries * (L.SQE + L.CQE))));
+    control[L.ENTRIES] = entries;
+
+    var mask = entries - 1;
+    var sqBase = L.HEADER;
+    var cqBase = L.HEADER + entries * L.SQE;
+    var tail = 0;           // next submission slot, ours alone
+    var head = 0;           // next completion to reap, ours alone
+    var inflight = 0;
+    var nextId = 0;
+    var armed = false;
+    var closed = false;
+    var onComplete = options.onComplete || function() {};
+
+    var native = new SodiumRing(control, arena, function() {
+        armed = false;
+        self.poll();
+    });
+
+    // Ask for onWake, unless completions came in meanwhile
+    function arm() {
+        if( armed || inflight === 0 ) {
+            return;
+        }
+        armed = true;
+        Atomics.or(control, L.FLAGS, L.WAITING);
+        if( Atomics.load(control, L.CQ_TAIL) !== head ) {
+            // Posted before the flag was seen: deliver from the event loop
+            armed = false;
+            Atomics.and(control, L.FLAGS, ~L.WAITING);
+            setImmediate(function() { self.poll(); });
+        }
+    }
+
+    /** The shared arena, a Uint8Array */
+    self.arena = arena;
+
+    /** Jobs submitted and not reaped yet */
+    Object.defineProperty(self, 'inflight', { get: function() { return inflight; } });
+
+    /**
+     * Queue a job
+     *
+     * @param {String|Number} op  name of the operation, see `CryptoRing.ops`
+     * @param {Number} out, outLen  where the result goes. For
+     *   `crypto_generichash` outLen is the hash length
+     * @param {Number} input, inputLen  the message
+     * @param {Number} [aux], [auxLen]  additional data for the AEADs, the key
+     *   of `crypto_generichash`, the signature to verify
+     * @param {Number} [key], [nonce]  offsets of the key and the nonce
+     * @returns {Number}  the job id, or -1 if the ring is full
+     */
+    self.submit = function(op, out, outLen, input, inputLen, aux, auxLen, key, nonce) {
+        if( closed ) {
+            throw new Error('[CryptoRing] ring is closed');
+        }
+        if( inflight === entries ) {
+            return -1;
+        }
+        var code = typeof op === 'number' ? op : CryptoRing.ops[op];
+        if( code === undefined ) {
+            throw new TypeError('[CryptoRing] unknown operation ' + op);
+        }
+        var id = nextId;
+        nextId = (nextId + 1) | 0;
+
+        var e = sqBase + (tail & mask) * L.SQE;
+        control[e] = code;
+        control[e + 1] = id;
+        control[e + 2] = out;
+        control[e + 3] = outLen;
+        control[e + 4] = input;
+        control[e + 5] = inputLen;
+        control[e + 6] = aux || 0;
+        control[e + 7] = auxLen || 0;
+        control[e + 8] = key || 0;
+        control[e + 9] = nonce || 0;
+        tail = (tail + 1) | 0;
+
+        if( inflight++ === 0 ) {
+            native.ref();
+        }
+        Atomics.store(control, L.SQ_TAIL, tail);
+        if( Atomics.load(control, L.FLAGS) & L.SLEEPING ) {
+            native.wake();
+        }
+        arm();
+        return id;
+    };
+
+    /**
+     * Deliver the completions posted so far to `onComplete`
+     * @returns {Number} how many there were
+     */
+    self.poll = function() {
+        var done = Atomics.load(control, L.CQ_TAIL);
+        var count = 0;
+        while( head !== done ) {
+            var c = cqBase + (head & mask) * L.CQE;
+            var id = control[c], status = control[c + 1], length = control[c + 2];
+            head = (head + 1) | 0;
+            Atomics.store(control, L.CQ_HEAD, head);
+            inflight--;
+            count++;
+            onComplete(id, status, length);
+        }
+        if( inflight === 0 && count > 0 && !closed ) {
+            native.unref();
+        }
+        arm();
+        return count;
+    };
+
+    /** Native counters, `{ jobs, failed, sleeps, wakeups, notified }` */
+    self.stats = function() {
+        return native.stats();
+    };
+
+    /** Stop the thread. Jobs not run yet never complete */
+    self.close = function() {
+        if( !closed ) {
+            closed = true;
+            native.close();
+        }
+    };
+}
+
+CryptoRing.ops = SodiumRing.ops;
+CryptoRing.OK = L.OK;
+CryptoRing.FAILED = L.FAILED;
+CryptoRing.BAD_JOB = L.BAD_JOB;
+
+module.exports = CryptoRing;
@@ -6,27 +6,48 @@
  /* jslint node: true */
 'use strict';
 
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var assert = require('assert');
 var toBuffer = require('./toBuffer');
 var SecretBoxKey = require('./keys/secretbox-key');
+var CryptoBaseBuffer = require('./crypto-base-buffer');
 var Nonce = require('./nonces/secretbox-nonce');
 
 /**
- * Public-key authenticated encryption: Box
+ * Secret-key authenticated encryption: SecretBox
  *
- * @param {String|Buffer|Array} secretKey sender's private key.
- * @param {String|Buffer|Array} publicKey recipient's private key.
+ * `options.algorithm` picks the construction: `'xsalsa20poly1305'`, the
+ * default, boxes with `crypto_secretbox` and its zero padded layout, while
+ * `'xchacha20poly1305'` uses `crypto_secretbox_xchacha20poly1305_easy`,
+ * whose cipher text is the MAC followed by the encrypted message. Both take
+ * the same 32 byte key and 24 byte random nonce, but a box can only be opened
+ * with the algorithm that sealed it.
+ *
+ * @param {String|Buffer|Array} secretKey shared secret key.
+ * @param {String} [encoding]          encoding of secretKey if it is a string.
+ * @param {Object} [options]           `{ algorithm }`
  *
  * @see Keys
  * @constructor
  */
-module.exports  = function SecretBox(secretKey, encoding) {
+module.exports  = function SecretBox(secretKey, encoding, options) {
     var self = this;
 
+    if( typeof encoding == 'object' && encoding !== null ) {
+        options = encoding;
+        encoding = undefined;
+    }
+    options = options || {};
+
     /** default encoding to use in all string operations */
     self.defaultEncoding = undefined;
 
+    /** construction used by encrypt and decrypt */
+    self.algorithm = options.algorithm || 'xsalsa20poly1305';
+    assert(self.algorithm == 'xsalsa20poly1305' || self.algorithm == 'xchacha20poly1305',
+        'SecretBox algorithm must be xsalsa20poly1305 or xchacha20poly1305');
+    var xchacha = self.algorithm == 'xchacha20poly1305';
+
     if( secretKey instanceof SecretBoxKey) {
         self.boxKey = secretKey;
     }
@@ -37,17 +58,17 @@ module.exports  = function SecretBox(secretKey, encoding) {
 
     /** SecretBox padding of cipher text buffer */
     self.boxZeroBytes = function() {
-        return binding.crypto_secretbox_BOXZEROBYTES;
+        return xchacha ? 0 : binding.crypto_secretbox_BOXZEROBYTES;
     };
 
     /** Passing of message. This implementation does message padding automatically */
     self.zeroBytes = function() {
-        return binding.crypto_secretbox_ZEROBYTES;
+        return xchacha ? 0 : binding.crypto_secretbox_ZEROBYTES;
     };
 
     /** String name of the default crypto primitive used in secretbox operations */
     self.primitive = function() {
-        return binding.crypto_secretbox_PRIMITIVE;
+        return xchacha ? 'xchacha20poly1305' : binding.crypto_secretbox_PRIMITIVE;
     };
 
     /**
@@ -101,13 +122,14 @@ module.exports  = function SecretBox(secretKey, encoding) {
         encoding = encoding || self.defaultEncoding;
 
         // generate a new random nonce
-        var nonce = new Nonce();
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_secretbox_NONCEBYTES);
 
         var buf = toBuffer(plainText, encoding);
 
-        var cipherText = binding.crypto_secretbox(
+        var seal = xchacha ? binding.crypto_secretbox_xchacha20poly1305_easy : binding.crypto_secretbox;
+        var cipherText = seal(
             buf,
-            nonce.get(),
+            nonce,
             self.boxKey.get());
 
         if( !cipherText ) {
@@ -116,7 +138,7 @@ module.exports  = function SecretBox(secretKey, encoding) {
 
         return {
             cipherText: cipherText,
-            nonce : nonce.get()
+            nonce : nonce
         };
     };
 
@@ -136,11 +158,12 @@ module.exports  = function SecretBox(secretKey, encoding) {
         assert(cipherBox.cipherText instanceof Buffer, 'cipherBox should have a cipherText property that is a buffer') ;
         assert(cipherBox.nonce instanceof Buffer, 'cipherBox should have a nonce property that is a buffer') ;
 
-        var nonce = new Nonce(cipherBox.nonce);
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_secretbox_NONCEBYTES, cipherBox.nonce);
 
-        var plainText = binding.crypto_secretbox_open(
+        var open = xchacha ? binding.crypto_secretbox_xchacha20poly1305_open_easy : binding.crypto_secretbox_open;
+        var plainText = open(
             cipherBox.cipherText,
-            nonce.get(),
+            nonce,
             self.boxKey.get()
         );
 
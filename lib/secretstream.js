@@ -0,0 +1,241 @@
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var stream = require('stream');
+var util = require('util');
+var assert = require('assert');
+
+var ABYTES = binding.crypto_secretstream_xchacha20poly1305_ABYTES;
+var HEADERBYTES = binding.crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+var KEYBYTES = binding.crypto_secretstream_xchacha20poly1305_KEYBYTES;
+var TAG_MESSAGE = binding.crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+var TAG_FINAL = binding.crypto_secretstream_xchacha20poly1305_TAG_FINAL;
+
+/** Default plain text bytes per encrypted chunk */
+var DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * FIFO of buffers that hands out byte ranges without copying when it can
+ * @constructor
+ */
+function ChunkQueue() {
+    this.list = [];
+    this.length = 0;
+}
+
+ChunkQueue.prototype.append = function(buf) {
+    if( buf.length ) {
+        this.list.push(buf);
+        this.length += buf.length;
+    }
+};
+
+/** Remove and return the first `n` bytes */
+ChunkQueue.prototype.take = function(n) {
+    var out;
+    var first = this.list[0];
+
+    if( n === 0 ) {
+        return Buffer.alloc(0);
+    }
+
+    if( first.length === n ) {
+        out = this.list.shift();
+    }
+    else if( first.length > n ) {
+        out = first.slice(0, n);
+        this.list[0] = first.slice(n);
+    }
+    else {
+        out = Buffer.allocUnsafe(n);
+        var pos = 0;
+        while( pos < n ) {
+            var b = this.list[0];
+            var len = Math.min(b.length, n - pos);
+            b.copy(out, pos, 0, len);
+            pos += len;
+            if( len === b.length ) {
+                this.list.shift();
+            }
+            else {
+                this.list[0] = b.slice(len);
+            }
+        }
+    }
+    this.length -= n;
+    return out;
+};
+
+function checkOptions(key, options) {
+    assert.ok(Buffer.isBuffer(key) && key.length === KEYBYTES,
+        'key must be a ' + KEYBYTES + ' byte Buffer');
+    options = options || {};
+    var chunkSize = options.chunkSize || DEFAULT_CHUNK_SIZE;
+    assert.ok(typeof chunkSize === 'number' && chunkSize > 0, 'chunkSize must be a positive number');
+    return chunkSize;
+}
+
+/**
+ * Transform stream that encrypts everything written to it.
+ *
+ * Output is the stream header followed by encrypted chunks. Every chunk but
+ * the last carries exactly `chunkSize` bytes of plain text and
+ * `crypto_secretstream_xchacha20poly1305_ABYTES` bytes of overhead. The last
+ * chunk is tagged `TAG_FINAL`, so truncation is detected by the decryptor.
+ *
+ * Memory use is bounded by `chunkSize` plus the stream's high water marks.
+ *
+ * @param {Buffer} key                  crypto_secretstream_xchacha20poly1305_KEYBYTES long
+ * @param {Object} [options]            stream.Transform options, plus
+ * @param {Number} [options.chunkSize]  plain text bytes per chunk. Default 64KB
+ * @constructor
+ */
+function Encryptor(key, options) {
+    if( !(this instanceof Encryptor) ) {
+        return new Encryptor(key, options);
+    }
+
+    var chunkSize = checkOptions(key, options);
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var queue = new ChunkQueue();
+    var s = binding.crypto_secretstream_xchacha20poly1305_init_push(key);
+    var state = s.state;
+
+    /** Plain text bytes per chunk */
+    self.chunkSize = chunkSize;
+
+    self.push(s.header);
+
+    self._transform = function(chunk, encoding, callback) {
+        if( !Buffer.isBuffer(chunk) ) {
+            chunk = Buffer.from(chunk, encoding);
+        }
+        queue.append(chunk);
+
+        // Keep at least one byte back so the final chunk is never empty
+        // unless the whole stream is
+        while( queue.length > chunkSize ) {
+            self.push(binding.crypto_secretstream_xchacha20poly1305_push(
+                state, queue.take(chunkSize), null, TAG_MESSAGE));
+        }
+        callback();
+    };
+
+    self._flush = function(callback) {
+        self.push(binding.crypto_secretstream_xchacha20poly1305_push(
+            state, queue.take(queue.length), null, TAG_FINAL));
+        binding.memzero(state);
+        callback();
+    };
+}
+util.inherits(Encryptor, stream.Transform);
+
+/**
+ * Transform stream that decrypts the output of an `Encryptor`.
+ *
+ * Emits an error if a chunk fails authentication, if chunks were reordered
+ * or if the stream ends before the final chunk.
+ *
+ * @param {Buffer} key                  same key given to the Encryptor
+ * @param {Object} [options]            stream.Transform options, plus
+ * @param {Number} [options.chunkSize]  must match the Encryptor's chunkSize
+ * @constructor
+ */
+function Decryptor(key, options) {
+    if( !(this instanceof Decryptor) ) {
+        return new Decryptor(key, options);
+    }
+
+    var chunkSize = checkOptions(key, options);
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var queue = new ChunkQueue();
+    var frameSize = chunkSize + ABYTES;
+    var state = null;
+    var finished = false;
+
+    /** Plain text bytes per chunk */
+    self.chunkSize = chunkSize;
+
+    function pull(frame) {
+        var r = binding.crypto_secretstream_xchacha20poly1305_pull(state, frame, null);
+        if( !r ) {
+            throw new Error('secretstream chunk failed authentication');
+        }
+        return r;
+    }
+
+    self._transform = function(chunk, encoding, callback) {
+        if( finished ) {
+            return callback(new Error('secretstream data after the final chunk'));
+        }
+        if( !Buffer.isBuffer(chunk) ) {
+            chunk = Buffer.from(chunk, encoding);
+        }
+        queue.append(chunk);
+
+        try {
+            if( !state ) {
+                if( queue.length < HEADERBYTES ) {
+                    return callback();
+                }
+                state = binding.crypto_secretstream_xchacha20poly1305_init_pull(queue.take(HEADERBYTES), key);
+                if( !state ) {
+                    return callback(new Error('invalid secretstream header'));
+                }
+            }
+
+            while( queue.length > frameSize ) {
+                var r = pull(queue.take(frameSize));
+                if( r.tag === TAG_FINAL ) {
+                    finished = true;
+                    return callback(new Error('secretstream data after the final chunk'));
+                }
+                self.push(r.message);
+            }
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback();
+    };
+
+    self._flush = function(callback) {
+        if( !state || queue.length < ABYTES ) {
+            return callback(new Error('secretstream truncated'));
+        }
+
+        try {
+            var r = pull(queue.take(queue.length));
+            if( r.tag !== TAG_FINAL ) {
+                return callback(new Error('secretstream truncated'));
+            }
+            finished = true;
+            binding.memzero(state);
+            self.push(r.message);
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback();
+    };
+}
+util.inherits(Decryptor, stream.Transform);
+
+module.exports.Encryptor = Encryptor;
+module.exports.Decryptor = Decryptor;
+module.exports.DEFAULT_CHUNK_SIZE = DEFAULT_CHUNK_SIZE;
+
+/** Generate a random secretstream key */
+module.exports.keygen = binding.crypto_secretstream_xchacha20poly1305_keygen;
+
+/** Encrypt or decrypt a whole file on the threadpool, in the same format */
+module.exports.encryptFile = binding.sodium_encrypt_file;
+module.exports.decryptFile = binding.sodium_decrypt_file;
+
+/** Byte FIFO of the streams above, shared with the Age streams */
+module.exports.ChunkQueue = ChunkQueue;
@@ -0,0 +1,297 @@
+/**
+ * # SecureChannel
+ * Encrypted Duplex over a socket, small writes coalesced into frames
+ *
+ * Everything written to the channel is sealed with
+ * `crypto_aead_xchacha20poly1305_ietf` under the `tx` session key and sent
+ * in frames; frames read from the socket are opened with the `rx` key. Take
+ * the keys from `crypto_kx_client_session_keys` on one side and
+ * `crypto_kx_server_session_keys` on the other.
+ *
+ *     frame    header (4) | cipher text (length + ABYTES)
+ *     header   uint32 little endian plain text length, top bit set on the
+ *              last frame
+ *
+ * The header is the additional data of its frame and the nonce is the
+ * frame number, counted by both sides, so nonces never travel and frames
+ * cannot be dropped, replayed or reordered. `end()` sends an empty last
+ * frame, and a socket that ends without one is reported as truncated.
+ *
+ * Writes made in the same tick are corked and handed to `_writev` together,
+ * cut into frames of up to `frameSize` bytes and sealed with one
+ * `_encrypt_batch` call. The frames go to the socket corked, as one
+ * `writev`. Frames that arrive together are opened with one
+ * `_decrypt_batch` call and pushed as one Buffer.
+ *
+ *     var channel = new sodium.SecureChannel(socket, sodium.api.crypto_kx_client_session_keys(...));
+ *     channel.write('hello');
+ *     channel.on('data', function(data) { ... });
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var stream = require('stream');
+var util = require('util');
+
+var ABYTES = binding.crypto_aead_xchacha20poly1305_ietf_ABYTES;
+var KEYBYTES = binding.crypto_aead_xchacha20poly1305_ietf_KEYBYTES;
+var NPUBBYTES = binding.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+
+var HEADERBYTES = 4;
+var FINAL = 0x80000000;
+
+/** Default and largest plain text bytes per frame */
+var DEFAULT_FRAME_SIZE = 16 * 1024;
+var MAX_FRAME_SIZE = 1024 * 1024;
+
+function checkKey(name, key) {
+    if( !Buffer.isBuffer(key) || key.length !== KEYBYTES ) {
+        throw new TypeError('keys.' + name + ' must be a ' + KEYBYTES + ' byte Buffer');
+    }
+}
+
+// Nonces of `count` frames from `counter` on, back to back
+function nonces(counter, count) {
+    var out = Buffer.alloc(count * NPUBBYTES);
+    for( var i = 0; i < count; i++, counter++ ) {
+        out.writeUInt32LE(counter % 0x100000000, i * NPUBBYTES);
+        out.writeUInt32LE(Math.floor(counter / 0x100000000), i * NPUBBYTES + 4);
+    }
+    return out;
+}
+
+function uncorkTick(channel) {
+    channel.corkedTick = false;
+    channel.uncork();
+}
+
+/**
+ * @param {net.Socket} socket          connected socket, or any Duplex of bytes
+ * @param {Object} keys                `{ rx, tx }` session keys, as returned by crypto_kx
+ * @param {Object} [options]           stream.Duplex options, plus
+ * @param {Number} [options.frameSize] largest plain text bytes per frame, 16KB by
+ *                                     default. Frames over it are refused, so use
+ *                                     the same value on both sides
+ * @param {Boolean} [options.coalesce] cork writes until the next tick, true by default
+ * @constructor
+ */
+function SecureChannel(socket, keys, options) {
+    if( !(this instanceof SecureChannel) ) {
+        return new SecureChannel(socket, keys, options);
+    }
+    options = options || {};
+    checkKey('rx', keys && keys.rx);
+    checkKey('tx', keys.tx);
+
+    var frameSize = options.frameSize !== undefined ? options.frameSize : DEFAULT_FRAME_SIZE;
+    if( typeof frameSize !== 'number' || frameSize < 1 || frameSize > MAX_FRAME_SIZE || frameSize % 1 !== 0 ) {
+        throw new RangeError('frameSize must be a whole number of bytes up to ' + MAX_FRAME_SIZE);
+    }
+
+    stream.Duplex.call(this, options);
+
+    var self = this;
+    this.socket = socket;
+    this.rx = Buffer.from(keys.rx);
+    this.tx = Buffer.from(keys.tx);
+    this.frameSize = frameSize;
+    this.coalesce = options.coalesce !== false;
+    this.corkedTick = false;
+    this.sent = 0;
+    this.received = 0;
+    this.input = null;
+    this.finished = false;
+
+    /** Frames sealed and socket writes made, a write being one corked batch */
+    this.stats = { frames: 0, batches: 0 };
+
+    // The final frames say when each side is done. A socket that ended its
+    // own side as soon as the peer's FIN arrived would drop what we still
+    // have to send
+    socket.allowHalfOpen = true;
+
+    socket.on('data', function(chunk) {
+        self.receive(chunk);
+    });
+    socket.on('end', function() {
+        if( !self.finished ) {
+            self.destroy(new Error('secure channel truncated'));
+        }
+    });
+    socket.on('error', function(err) {
+        self.destroy(err);
+    });
+    socket.on('close', function() {
+        if( !self.finished ) {
+            self.destroy(new Error('secure channel truncated'));
+        }
+    });
+}
+util.inherits(SecureChannel, stream.Duplex);
+
+SecureChannel.prototype.write = function() {
+    if( this.coalesce && !this.corkedTick ) {
+        this.corkedTick = true;
+        this.cork();
+        process.nextTick(uncorkTick, this);
+    }
+    return stream.Duplex.prototype.write.apply(this, arguments);
+};
+
+/**
+ * Cut `buffers` into frames, seal them in one batch and write them corked.
+ * A `last` batch ends with an empty final frame
+ */
+SecureChannel.prototype.send = function(buffers, last, callback) {
+    var frameSize = this.frameSize;
+    var messages = [];
+    var current = [];
+    var length = 0;
+
+    function flush() {
+        messages.push(current.length === 1 ? current[0] : Buffer.concat(current, length));
+        current = [];
+        length = 0;
+    }
+
+    for( var i = 0; i < buffers.length; i++ ) {
+        var buf = buffers[i];
+        for( var offset = 0; offset < buf.length; ) {
+            var take = Math.min(frameSize - length, buf.length - offset);
+            current.push(offset === 0 && take === buf.length ? buf : buf.slice(offset, offset + take));
+            length += take;
+            offset += take;
+            if( length === frameSize ) {
+                flush();
+            }
+        }
+    }
+    if( length > 0 ) {
+        flush();
+    }
+    if( last ) {
+        messages.push(Buffer.alloc(0));
+    }
+    if( messages.length === 0 ) {
+        return callback();
+    }
+
+    var count = messages.length;
+    var headers = Buffer.allocUnsafe(count * HEADERBYTES);
+    var ads = new Array(count);
+    for( i = 0; i < count; i++ ) {
+        var flags = last && i === count - 1 ? FINAL : 0;
+        headers.writeUInt32LE((messages[i].length | flags) >>> 0, i * HEADERBYTES);
+        ads[i] = headers.slice(i * HEADERBYTES, (i + 1) * HEADERBYTES);
+    }
+    var sealed = binding.crypto_aead_xchacha20poly1305_ietf_encrypt_batch(
+        messages, ads, nonces(this.sent, count), this.tx);
+    this.sent += count;
+    this.stats.frames += count;
+    this.stats.batches++;
+
+    var socket = this.socket;
+    var ok = true;
+    socket.cork();
+    for( i = 0, offset = 0; i < count; i++ ) {
+        var end = offset + messages[i].length + ABYTES;
+        socket.write(ads[i]);
+        ok = socket.write(sealed.slice(offset, end));
+        offset = end;
+    }
+    socket.uncork();
+
+    if( ok ) {
+        callback();
+    }
+    else {
+        socket.once('drain', callback);
+    }
+};
+
+SecureChannel.prototype._write = function(chunk, encoding, callback) {
+    this.send([chunk], false, callback);
+};
+
+SecureChannel.prototype._writev = function(chunks, callback) {
+    this.send(chunks.map(function(c) { return c.chunk; }), false, callback);
+};
+
+SecureChannel.prototype._final = function(callback) {
+    var socket = this.socket;
+    this.send([], true, function() {
+        socket.end();
+        callback();
+    });
+};
+
+/** Open every whole frame received so far, in one batch */
+SecureChannel.prototype.receive = function(chunk) {
+    if( this.destroyed ) {
+        return;
+    }
+    if( this.finished ) {
+        return this.destroy(new Error('secure channel data after the final frame'));
+    }
+    var data = this.input ? Buffer.concat([this.input, chunk]) : chunk;
+    var frames = [];
+    var ads = [];
+    var last = false;
+    var offset = 0;
+
+    while( !last && data.length - offset >= HEADERBYTES ) {
+        var header = data.readUInt32LE(offset);
+        var length = (header & ~FINAL) >>> 0;
+        if( length > this.frameSize ) {
+            return this.destroy(new Error('secure channel frame larger than frameSize'));
+        }
+        var end = offset + HEADERBYTES + length + ABYTES;
+        if( end > data.length ) {
+            break;
+        }
+        ads.push(data.slice(offset, offset + HEADERBYTES));
+        frames.push(data.slice(offset + HEADERBYTES, end));
+        last = (header & FINAL) !== 0;
+        offset = end;
+    }
+    this.input = offset < data.length ? data.slice(offset) : null;
+    if( last && this.input ) {
+        return this.destroy(new Error('secure channel data after the final frame'));
+    }
+    if( frames.length === 0 ) {
+        return;
+    }
+
+    var plain = binding.crypto_aead_xchacha20poly1305_ietf_decrypt_batch(
+        frames, ads, nonces(this.received, frames.length), this.rx);
+    if( !plain ) {
+        return this.destroy(new Error('secure channel frame failed authentication'));
+    }
+    this.received += frames.length;
+
+    if( plain.length > 0 && !this.push(plain) ) {
+        this.socket.pause();
+    }
+    if( last ) {
+        this.finished = true;
+        this.push(null);
+    }
+};
+
+SecureChannel.prototype._read = function() {
+    this.socket.resume();
+};
+
+SecureChannel.prototype._destroy = function(err, callback) {
+    binding.memzero(this.rx);
+    binding.memzero(this.tx);
+    this.socket.destroy();
+    callback(err);
+};
+
+module.exports = SecureChannel;
+module.exports.DEFAULT_FRAME_SIZE = DEFAULT_FRAME_SIZE;
+module.exports.MAX_FRAME_SIZE = MAX_FRAME_SIZE;
@@ -0,0 +1,249 @@
+/**
+ * # Seekable
+ * Encrypted container that is decrypted a byte range at a time
+ *
+ * The message is cut in chunks of `chunkSize` bytes, each sealed on its own
+ * with `crypto_aead_xchacha20poly1305_ietf` and the nonce `nonce + index`.
+ * Chunks have a fixed size, so the chunks holding any plain text range, and
+ * their place in the container, follow from the header alone: there is no
+ * chunk index to store or fetch.
+ *
+ *     header   magic (4) | chunkSize (4) | length (8) | nonce (24)
+ *     chunk i  chunkSize bytes of cipher text, the last one shorter | tag (16)
+ *
+ * Numbers are little endian. The header is the additional data of every
+ * chunk, so changing it, reordering chunks or dropping the last ones makes
+ * decryption fail.
+ *
+ *     var container = sodium.Seekable.encrypt(blob, key);
+ *
+ *     // Later, with only the header and an HTTP range request
+ *     var d = new sodium.Seekable.Decryptor(key, header);
+ *     var range = d.cipherRange(1000000, 4096);      // { start, end }
+ *     var bytes = await fetchRange(range.start, range.end);
+ *     var plain = d.decryptRange(1000000, 4096, bytes);
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+
+var ABYTES = binding.crypto_aead_xchacha20poly1305_ietf_ABYTES;
+var KEYBYTES = binding.crypto_aead_xchacha20poly1305_ietf_KEYBYTES;
+var NPUBBYTES = binding.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+
+var MAGIC = 0x01414b53;   // "SKA" and format version 1
+var HEADERBYTES = 16 + NPUBBYTES;
+
+/** Default plain text bytes per chunk */
+var DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+function checkKey(key) {
+    if( !(key instanceof Uint8Array) || key.length !== KEYBYTES ) {
+        throw new TypeError('key must be a ' + KEYBYTES + ' byte Buffer or Uint8Array');
+    }
+}
+
+/**
+ * Fields shared by the Encryptor and the Decryptor
+ * @constructor
+ */
+function Container(key, header, chunkSize, length) {
+    checkKey(key);
+    this.key = key;
+    this.header = header;
+    this.chunkSize = chunkSize;
+    this.length = length;
+    this.nonce = header.slice(16, HEADERBYTES);
+
+    /** Number of chunks, at least one */
+    this.chunks = length === 0 ? 1 : Math.ceil(length / chunkSize);
+
+    /** Bytes of the whole container */
+    this.size = HEADERBYTES + length + this.chunks * ABYTES;
+}
+
+// First and last chunks of the non empty range [offset, offset + length)
+Container.prototype.chunkSpan = function(offset, length) {
+    if( !(offset >= 0 && length >= 0 && offset + length <= this.length) ||
+        offset % 1 !== 0 || length % 1 !== 0 ) {
+        throw new RangeError('range ' + offset + '+' + length + ' is outside the ' + this.length + ' byte message');
+    }
+    return {
+        first: Math.floor(offset / this.chunkSize),
+        last: Math.floor((offset + Math.max(length, 1) - 1) / this.chunkSize)
+    };
+};
+
+/**
+ * Bytes of the container holding the plain text range
+ * [offset, offset + length): whole chunks from `start` up to, not including,
+ * `end`
+ * @returns {Object} `{ start, end }`
+ */
+Container.prototype.cipherRange = function(offset, length) {
+    var span = this.chunkSpan(offset, length);
+    if( length === 0 ) {
+        return { start: HEADERBYTES, end: HEADERBYTES };
+    }
+    var frame = this.chunkSize + ABYTES;
+    return {
+        start: HEADERBYTES + span.first * frame,
+        end: Math.min(HEADERBYTES + (span.last + 1) * frame, this.size)
+    };
+};
+
+/**
+ * Writes a container, whole or in parts that start on chunk boundaries, such
+ * as the parts of a multipart upload. The nonce is random, so each
+ * Encryptor writes one container: encrypting a chunk again with different
+ * plain text would reuse its nonce.
+ *
+ * @param {Buffer} key                 crypto_aead_xchacha20poly1305_ietf_KEYBYTES long
+ * @param {Number} length              plain text bytes of the whole message
+ * @param {Object} [options]
+ * @param {Number} [options.chunkSize] plain text bytes per chunk. Default 64KB
+ * @param {Number} [options.threads]   split large ranges across this many threads
+ * @constructor
+ */
+function Encryptor(key, length, options) {
+    options = options || {};
+    var chunkSize = options.chunkSize || DEFAULT_CHUNK_SIZE;
+    if( typeof chunkSize !== 'number' || chunkSize < 1 || chunkSize > 0xffffffff || chunkSize % 1 !== 0 ) {
+        throw new RangeError('chunkSize must be a whole number of bytes up to 4GB');
+    }
+    if( typeof length !== 'number' || !(length >= 0) || length > Number.MAX_SAFE_INTEGER || length % 1 !== 0 ) {
+        throw new RangeError('length must be a whole number of bytes');
+    }
+
+    var header = Buffer.alloc(HEADERBYTES);
+    header.writeUInt32LE(MAGIC, 0);
+    header.writeUInt32LE(chunkSize, 4);
+    header.writeUInt32LE(length % 0x100000000, 8);
+    header.writeUInt32LE(Math.floor(length / 0x100000000), 12);
+    binding.randombytes_buf(header.slice(16));
+
+    Container.call(this, key, header, chunkSize, length);
+    this.threads = options.threads;
+}
+Encryptor.prototype = Object.create(Container.prototype);
+Encryptor.prototype.constructor = Encryptor;
+
+/**
+ * Encrypt the plain text that starts at `offset` of the message. `offset`
+ * must be a multiple of `chunkSize`, and `plainText` must fill whole chunks
+ * unless it runs to the end of the message.
+ * @returns {Buffer} the bytes of the container at `cipherRange(offset, plainText.length)`
+ */
+Encryptor.prototype.encryptRange = function(offset, plainText) {
+    this.chunkSpan(offset, plainText.length);
+    if( offset % this.chunkSize !== 0 ) {
+        throw new RangeError('offset must be a multiple of chunkSize');
+    }
+    if( offset + plainText.length !== this.length && plainText.length % this.chunkSize !== 0 ) {
+        throw new RangeError('only the end of the message may fill part of a chunk');
+    }
+    if( plainText.length === 0 && this.length !== 0 ) {
+        return Buffer.alloc(0);
+    }
+    return binding.crypto_aead_xchacha20poly1305_ietf_encrypt_chunks(plainText, this.chunkSize,
+        this.header, this.nonce, offset / this.chunkSize, this.key, this.threads);
+};
+
+/**
+ * Reads ranges of a container
+ *
+ * @param {Buffer} key          the key of the Encryptor
+ * @param {Buffer} header       at least the first HEADERBYTES bytes of the container
+ * @param {Object} [options]
+ * @param {Number} [options.threads] split large ranges across this many threads
+ * @constructor
+ */
+function Decryptor(key, header, options) {
+    if( !Buffer.isBuffer(header) || header.length < HEADERBYTES || header.readUInt32LE(0) !== MAGIC ) {
+        throw new Error('not a seekable container header');
+    }
+    header = Buffer.from(header.slice(0, HEADERBYTES));
+    var chunkSize = header.readUInt32LE(4);
+    var length = header.readUInt32LE(8) + header.readUInt32LE(12) * 0x100000000;
+    if( chunkSize === 0 || length > Number.MAX_SAFE_INTEGER ) {
+        throw new Error('not a seekable container header');
+    }
+
+    Container.call(this, key, header, chunkSize, length);
+    this.threads = (options || {}).threads;
+}
+Decryptor.prototype = Object.create(Container.prototype);
+Decryptor.prototype.constructor = Decryptor;
+
+/**
+ * Decrypt the plain text range [offset, offset + length)
+ * @param {Number} offset
+ * @param {Number} length
+ * @param {Uint8Array} cipherText the container bytes at `cipherRange(offset, length)`
+ * @returns {Buffer} `length` bytes of plain text
+ * @throws if a chunk fails authentication
+ */
+Decryptor.prototype.decryptRange = function(offset, length, cipherText) {
+    var range = this.cipherRange(offset, length);
+    if( length === 0 ) {
+        return Buffer.alloc(0);
+    }
+    if( !(cipherText instanceof Uint8Array) || cipherText.length !== range.end - range.start ) {
+        throw new RangeError('cipherText must be the ' + (range.end - range.start) + ' bytes of cipherRange()');
+    }
+    var first = this.chunkSpan(offset, length).first;
+    var plain = binding.crypto_aead_xchacha20poly1305_ietf_decrypt_chunks(cipherText, this.chunkSize,
+        this.header, this.nonce, first, this.key, this.threads);
+    if( !plain ) {
+        throw new Error('seekable container chunk failed authentication');
+    }
+    var start = offset - first * this.chunkSize;
+    return plain.slice(start, start + length);
+};
+
+/**
+ * Encrypt a whole message into a container
+ * @param {Buffer} message
+ * @param {Buffer} key
+ * @param {Object} [options] `chunkSize` and `threads`, as for the Encryptor
+ * @returns {Buffer} header and chunks
+ */
+function encrypt(message, key, options) {
+    var e = new Encryptor(key, message.length, options);
+    return Buffer.concat([e.header, e.encryptRange(0, message)]);
+}
+
+/**
+ * Decrypt a range of a whole container held in memory
+ * @param {Buffer} container
+ * @param {Buffer} key
+ * @param {Number} [offset] 0 by default
+ * @param {Number} [length] to the end of the message by default
+ * @param {Object} [options] `threads`, as for the Decryptor
+ * @returns {Buffer}
+ */
+function decryptRange(container, key, offset, length, options) {
+    var d = new Decryptor(key, container, options);
+    offset = offset || 0;
+    if( length === undefined || length === null ) {
+        length = d.length - offset;
+    }
+    if( container.length !== d.size ) {
+        throw new Error('seekable container truncated or extended');
+    }
+    var range = d.cipherRange(offset, length);
+    return d.decryptRange(offset, length, container.slice(range.start, range.end));
+}
+
+module.exports.Encryptor = Encryptor;
+module.exports.Decryptor = Decryptor;
+module.exports.encrypt = encrypt;
+module.exports.decryptRange = decryptRange;
+module.exports.HEADERBYTES = HEADERBYTES;
+module.exports.DEFAULT_CHUNK_SIZE = DEFAULT_CHUNK_SIZE;
+
+/** Generate a random key */
+module.exports.keygen = binding.crypto_aead_xchacha20poly1305_ietf_keygen;
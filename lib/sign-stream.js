@@ -0,0 +1,209 @@
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var stream = require('stream');
+var util = require('util');
+var assert = require('assert');
+var toBuffer = require('./toBuffer');
+
+/** Default size of the write coalescing buffer */
+var DEFAULT_COALESCE_SIZE = 64 * 1024;
+
+/**
+ * Feed a native SignState, copying small writes into a staging buffer so
+ * libsodium sees one `update` call per `coalesceSize` bytes. Larger writes go
+ * to the state directly.
+ */
+function Coalescer(state, coalesceSize) {
+    var staging = null;
+    var used = 0;
+
+    this.drain = function() {
+        if( used > 0 ) {
+            state.update(staging.slice(0, used));
+            used = 0;
+        }
+    };
+
+    this.write = function(data) {
+        if( data.length >= coalesceSize ) {
+            this.drain();
+            state.update(data);
+            return;
+        }
+
+        if( !staging ) {
+            staging = Buffer.allocUnsafe(coalesceSize);
+        }
+        if( used + data.length > coalesceSize ) {
+            this.drain();
+        }
+        data.copy(staging, used);
+        used += data.length;
+    };
+
+    this.wipe = function() {
+        if( staging ) {
+            binding.memzero(staging);
+            staging = null;
+        }
+    };
+}
+
+function toData(data, encoding) {
+    return Buffer.isBuffer(data) ? data : Buffer.from(data, encoding);
+}
+
+/**
+ * Sign a stream of data with Ed25519ph, in constant memory.
+ *
+ * The readable side emits the `crypto_sign_BYTES` signature once the
+ * writable side ends. `update()` and `sign()` can be used instead when a
+ * stream is not needed. Signatures are the ones of `crypto_sign_final_create`
+ * and are checked with VerifyStream or `crypto_sign_final_verify`, not
+ * `crypto_sign_verify_detached`.
+ *
+ * @param {String|Buffer|Array} secretKey  signer's secret key
+ * @param {Object} [options]  stream.Transform options, plus
+ *   - `coalesceSize` (Number): staging buffer size. Default 64KB
+ * @constructor
+ */
+function SignStream(secretKey, options) {
+    if( !(this instanceof SignStream) ) {
+        return new SignStream(secretKey, options);
+    }
+
+    options = options || {};
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var key = toBuffer(secretKey);
+    assert.ok(key && key.length === binding.crypto_sign_SECRETKEYBYTES,
+              'secret key must be crypto_sign_SECRETKEYBYTES long');
+
+    var state = new binding.SignState();
+    var input = new Coalescer(state, options.coalesceSize || DEFAULT_COALESCE_SIZE);
+    var result = null;
+
+    /**
+     * Add data to the signed message
+     * @param {Buffer|String} data
+     * @param {String} [encoding]  string encoding
+     * @returns {SignStream} this
+     */
+    self.update = function(data, encoding) {
+        assert.ok(!result, 'signature already computed');
+        input.write(toData(data, encoding));
+        return self;
+    };
+
+    /**
+     * Finish signing. Later calls return the same signature.
+     * @param {String} [encoding]  return a string in this encoding
+     * @returns {Buffer|String} signature
+     */
+    self.sign = function(encoding) {
+        if( !result ) {
+            input.drain();
+            input.wipe();
+            result = state.finalCreate(key);
+            key = null;
+        }
+        return encoding ? result.toString(encoding) : result;
+    };
+
+    self._transform = function(chunk, encoding, callback) {
+        try {
+            self.update(chunk, encoding);
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback();
+    };
+
+    self._flush = function(callback) {
+        self.push(self.sign());
+        callback();
+    };
+}
+util.inherits(SignStream, stream.Transform);
+
+/**
+ * Verify an Ed25519ph signature of a stream of data, in constant memory.
+ *
+ * Once the stream finishes, `verify()` returns the result and the `verify`
+ * event is emitted with it.
+ *
+ * @param {String|Buffer|Array} signature  signature from SignStream
+ * @param {String|Buffer|Array} publicKey  signer's public key
+ * @param {Object} [options]  stream.Writable options, plus
+ *   - `coalesceSize` (Number): staging buffer size. Default 64KB
+ * @constructor
+ */
+function VerifyStream(signature, publicKey, options) {
+    if( !(this instanceof VerifyStream) ) {
+        return new VerifyStream(signature, publicKey, options);
+    }
+
+    options = options || {};
+    stream.Writable.call(this, options);
+
+    var self = this;
+    var sig = toBuffer(signature);
+    var key = toBuffer(publicKey);
+    assert.ok(sig && sig.length === binding.crypto_sign_BYTES,
+              'signature must be crypto_sign_BYTES long');
+    assert.ok(key && key.length === binding.crypto_sign_PUBLICKEYBYTES,
+              'public key must be crypto_sign_PUBLICKEYBYTES long');
+
+    var state = new binding.SignState();
+    var input = new Coalescer(state, options.coalesceSize || DEFAULT_COALESCE_SIZE);
+    var result = null;
+
+    /**
+     * Add data to the signed message
+     * @param {Buffer|String} data
+     * @param {String} [encoding]  string encoding
+     * @returns {VerifyStream} this
+     */
+    self.update = function(data, encoding) {
+        assert.ok(result === null, 'signature already verified');
+        input.write(toData(data, encoding));
+        return self;
+    };
+
+    /**
+     * Finish verifying. Later calls return the same result.
+     * @returns {Boolean} true if the signature is valid
+     */
+    self.verify = function() {
+        if( result === null ) {
+            input.drain();
+            input.wipe();
+            result = state.finalVerify(sig, key);
+        }
+        return result;
+    };
+
+    self._write = function(chunk, encoding, callback) {
+        try {
+            self.update(chunk, encoding);
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback();
+    };
+
+    self._final = function(callback) {
+        self.emit('verify', self.verify());
+        callback();
+    };
+}
+util.inherits(VerifyStream, stream.Writable);
+
+module.exports.SignStream = SignStream;
+module.exports.VerifyStream = VerifyStream;
+module.exports.DEFAULT_COALESCE_SIZE = DEFAULT_COALESCE_SIZE;
@@ -6,7 +6,7 @@
  /* jslint node: true */
 'use strict';
 
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var assert = require('assert');
 var SignKey = require('./keys/sign-key');
 var toBuffer = require('./toBuffer');
@@ -12,148 +12,287 @@
 'use strict';
 
 
-// Base
-var binding = require('../build/Release/sodium');
-var toBuffer = require('./toBuffer');
+var v8 = require('v8');
 
-// Public Key
-var Box = require('./box');
-var Sign = require('./sign');
-
-// Symmetric Key  
-var SecretBox = require('./secretbox');
-var Auth = require('./auth');
-var OneTimeAuth = require('./onetime-auth');
-var Stream = require('./stream');
+/**
+ * The addon, loaded by the first call that needs it. Requiring this module
+ * loads nothing native, so it can be part of a user-land startup snapshot
+ * (`node --build-snapshot`): every member that reads the addon is a lazy
+ * getter, and the addon is loaded in the process that runs the snapshot.
+ */
+var binding = null;
+
+function addon() {
+    if( binding === null ) {
+        if( v8.startupSnapshot && v8.startupSnapshot.isBuildingSnapshot() ) {
+            throw new Error('sodium: the addon cannot be loaded while building a startup snapshot, ' +
+                            'use it from the deserialize main function');
+        }
+        binding = require('./binding');
+    }
+    return binding;
+}
 
-// Elliptic Curve Diffie-Hellman using Curve25519
-var ECDH = require('./ecdh');
+/**
+ * Define `name` on `target` as a getter that requires `path` the first time
+ * it is read, then replaces itself with the loaded value. The high level
+ * classes pull in keys, nonces and node streams, and loading them all up
+ * front costs several times what the addon itself does, so a process only
+ * pays for the ones it uses.
+ *
+ * @param {Object} target
+ * @param {String} name
+ * @param {String|Function} path    module to require, or a function that
+ *                                  builds the value
+ * @param {String} [key]   export of the module to use, instead of the module
+ */
+function lazy(target, name, path, key) {
+    function define(value) {
+        Object.defineProperty(target, name, {
+            value: value,
+            writable: true,
+            enumerable: true,
+            configurable: true
+        });
+        return value;
+    }
 
-// Nonces
-var BoxNonce = require('./nonces/box-nonce');
-var SecretBoxNonce = require('./nonces/secretbox-nonce');
-var StreamNonce = require('./nonces/stream-nonce');
-
-// Keys
-var AuthKey = require('./keys/auth-key');
-var BoxKey = require('./keys/box-key');
-var OneTimeKey = require('./keys/onetime-key');
-var SecretBoxKey = require('./keys/secretbox-key');
-var SignKey = require('./keys/sign-key');
-var StreamKey = require('./keys/stream-key');
-var DHKey = require('./keys/dh-key');
+    Object.defineProperty(target, name, {
+        get: function() {
+            var value = typeof path === 'function' ? path() : require(path);
+            return define(key ? value[key] : value);
+        },
+        set: define,
+        enumerable: true,
+        configurable: true
+    });
+}
 
 /**
  * # API
  * Export all low level lib sodium functions directly
  * for developers that are used to lib sodium C interface
  */
-module.exports.api = binding;
+lazy(module.exports, 'api', addon);
 
 /** `libsodium` version */
-module.exports.version = binding.version;
-module.exports.versionMinor = binding.versionMinor;
-module.exports.versionMajor = binding.versionMajor;
+lazy(module.exports, 'version', function() { return addon().version; });
+lazy(module.exports, 'versionMinor', function() { return addon().versionMinor; });
+lazy(module.exports, 'versionMajor', function() { return addon().versionMajor; });
 
-/** Utilities */
-module.exports.Utils = {
-    memzero:  binding.memzero,
-    memcmp:   binding.memcmp,
-    verify16: binding.crypto_verify_16,
-    verify32: binding.crypto_verify_32,
-    verify64: binding.crypto_verify_64,
-    toBuffer: toBuffer,    
+/**
+ * Load the addon now and page in what the first calls would otherwise pay
+ * for: a call of each primitive that was built, the counters of the calling
+ * thread and the secure pool regions of common key sizes. Call it at startup,
+ * or first thing after a startup snapshot is restored.
+ * @returns {Number} milliseconds taken
+ */
+module.exports.warmup = function() {
+    var binding = addon();
+    return binding.sodium_warmup ? binding.sodium_warmup() : 0;
 };
 
-module.exports.Utils.to_hex = function (args) {
-    var ret = "";
-    for ( var i = 0; i < args.length; i++ )
-        ret += (args[i] < 16 ? "0" : "") + args[i].toString(16);
-    return ret; //.toUpperCase();
-};
+/** Utilities */
+lazy(module.exports, 'Utils', function() {
+    var binding = addon();
+    var Utils = {
+        memzero:  binding.memzero,
+        memcmp:   binding.memcmp,
+        verify16: binding.crypto_verify_16,
+        verify32: binding.crypto_verify_32,
+        verify64: binding.crypto_verify_64,
+        toBuffer: require('./toBuffer'),
+
+        /** Buffers in locked memory with guard pages */
+        secureBuffer: binding.sodium_malloc,
+        isSecureBuffer: binding.sodium_is_secure_buffer,
+        mprotectNoAccess: binding.sodium_mprotect_noaccess,
+        mprotectReadOnly: binding.sodium_mprotect_readonly,
+        mprotectReadWrite: binding.sodium_mprotect_readwrite
+    };
+
+    Utils.to_hex = function (args) {
+        var ret = "";
+        for ( var i = 0; i < args.length; i++ )
+            ret += (args[i] < 16 ? "0" : "") + args[i].toString(16);
+        return ret; //.toUpperCase();
+    };
+
+    Utils.from_hex = function (str) {
+        if (typeof str == 'string') {
+            var ret = new Uint8Array(Math.floor(str.length / 2));
+            var i = 0;
+            str.replace(/(..)/g, function(str) { ret[i++] = parseInt(str, 16);});
+            return ret;
+        }
+    };
+    return Utils;
+});
 
-module.exports.Utils.from_hex = function (str) {
-    if (typeof str == 'string') {
-        var ret = new Uint8Array(Math.floor(str.length / 2));
-        var i = 0;
-        str.replace(/(..)/g, function(str) { ret[i++] = parseInt(str, 16);});
-        return ret;
-    }
+/**
+ * Keep keys created from now on in locked, guarded memory
+ * @param {boolean} enable
+ */
+module.exports.useSecureMemory = function(enable) {
+    require('./crypto-base-buffer').secureMemory = !!enable;
 };
 
+/**
+ * Calls, bytes in, bytes out and failures of each primitive since the
+ * addon was loaded or `resetStats` was called
+ * @returns {Object} `{ secretbox: { calls, bytesIn, bytesOut, failures }, ... }`
+ */
+lazy(module.exports, 'stats', function() { return addon().sodium_stats; });
+lazy(module.exports, 'resetStats', function() { return addon().sodium_stats_reset; });
+
+/**
+ * Native memory the addon holds, in bytes, by category
+ * @returns {Object} `{ secure, objects, hashStates, boxCache, ..., total }`
+ */
+lazy(module.exports, 'memoryUsage', function() { return addon().sodium_memory_usage; });
+
 /** Hash functions */
-module.exports.Hash = {
+lazy(module.exports, 'Hash', function() {
+    var binding = addon();
+    var Hash = {
 
-    /** Default message hash */
-    hash: binding.crypto_hash,
+        /** Default message hash */
+        hash: binding.crypto_hash,
 
-    /** SHA 256 */
-    sha256: binding.crypto_hash_sha256,
+        /** SHA 256 */
+        sha256: binding.crypto_hash_sha256,
 
-    /** SHA 512 */
-    sha512: binding.crypto_hash_sha512,
-    
-    /** Size of hash buffer in bytes */
-    bytes: binding.crypto_hash_BYTES,
-    
-    /** Size of hash block */
-    blockBytes: binding.crypto_hash_BLOCKBYTES,
-    
-    /** Default primitive */
-    primitive: binding.crypto_hash_PRIMITIVE
-};
+        /** SHA 512 */
+        sha512: binding.crypto_hash_sha512,
+
+        /** Size of hash buffer in bytes */
+        bytes: binding.crypto_hash_BYTES,
+
+        /** Size of hash block */
+        blockBytes: binding.crypto_hash_BLOCKBYTES,
+
+        /** Default primitive */
+        primitive: binding.crypto_hash_PRIMITIVE,
+
+        /** Hash or authenticate a file on the threadpool, without reading it into JS */
+        hashFile: binding.sodium_hash_file,
+        authFile: binding.sodium_auth_file
+    };
+
+    /** Incremental hash stream: 'generichash', 'sha256' or 'sha512' */
+    lazy(Hash, 'createHash', './hash-stream', 'createHash');
+
+    /** Incremental hash stream class */
+    lazy(Hash, 'HashStream', './hash-stream', 'HashStream');
+
+    /** Pass through stream that hashes the data flowing through it */
+    lazy(Hash, 'HashPassThrough', './hash-stream', 'HashPassThrough');
+    return Hash;
+});
 
 /** Random Functions */
-module.exports.Random = {
+lazy(module.exports, 'Random', function() {
+    var binding = addon();
+    return {
 
-    /** Fill buffer with random bytest */
-    buffer : binding.randombytes_buf,
+        /** Fill buffer with random bytest */
+        buffer : binding.randombytes_buf,
 
-    /** Initialize OS dependent random device */
-    stir : binding.randombytes_stir,
+        /** Initialize OS dependent random device */
+        stir : binding.randombytes_stir,
 
-    /** Close the random device */
-    close : binding.randombytes_close,
+        /** Close the random device */
+        close : binding.randombytes_close,
 
-    /** Return a random 32-bit unsigned value */
-    rand : binding.randombytes_random,
+        /** Return a random 32-bit unsigned value */
+        rand : binding.randombytes_random,
 
-    /** Return a value between 0 and upper_bound using a uniform distribution */
-    uniform : binding.randombytes_uniform
-};
+        /** Return a value between 0 and upper_bound using a uniform distribution */
+        uniform : binding.randombytes_uniform
+    };
+});
 
 // Public Key
-module.exports.Box = Box;
-module.exports.Sign = Sign;
+lazy(module.exports, 'Box', './box');
+lazy(module.exports, 'BoxSession', './box-session');
+lazy(module.exports, 'Sign', './sign');
 
 // Symmetric Key
-module.exports.Auth = Auth;
-module.exports.SecretBox = SecretBox;
-module.exports.Stream = Stream;
-module.exports.OneTimeAuth = OneTimeAuth;
+lazy(module.exports, 'Auth', './auth');
+lazy(module.exports, 'SecretBox', './secretbox');
+lazy(module.exports, 'Stream', './stream');
+lazy(module.exports, 'OneTimeAuth', './onetime-auth');
+lazy(module.exports, 'Aead', './aead');
+
+// Encrypted node streams
+lazy(module.exports, 'SecretStream', './secretstream');
+
+// Node streams XORed with a crypto_stream key stream, unauthenticated
+lazy(module.exports, 'XorStream', './stream-xor', 'XorStream');
+
+// Encrypted Duplex over a socket, with crypto_kx session keys
+lazy(module.exports, 'SecureChannel', './secure-channel');
+
+// Encrypted containers decrypted a byte range at a time
+lazy(module.exports, 'Seekable', './seekable');
+
+// age v1 files to X25519 recipients
+lazy(module.exports, 'Age', './age');
+
+// WHATWG TransformStreams: secretstream, Seekable containers and hashes
+lazy(module.exports, 'WebStreams', './web-streams');
+
+// Multipart Ed25519ph signatures of node streams
+lazy(module.exports, 'SignStream', './sign-stream', 'SignStream');
+lazy(module.exports, 'VerifyStream', './sign-stream', 'VerifyStream');
+
+// Low level calls on worker threads
+lazy(module.exports, 'CryptoPool', './pool');
+
+// Async calls of one tick coalesced into batch jobs
+lazy(module.exports, 'Batcher', './batcher');
+
+// Packed batch arguments built without an allocation per element
+lazy(module.exports, 'BatchPack', './batch-pack');
+
+// Results of the `_stream` batch bindings through an async iterator
+lazy(module.exports, 'batchStream', './batch-stream');
+
+// Promise twins of the crypto functions of the low level API
+lazy(module.exports, 'promises', './promises');
+
+// Async call latency histograms
+lazy(module.exports, 'Latency', './latency');
+
+// Reports of synchronous calls that block the event loop
+lazy(module.exports, 'BlockingWatchdog', './watchdog');
+
+// Low level calls through shared memory rings
+lazy(module.exports, 'CryptoRing', './ring');
 
 // Nonces
-module.exports.Nonces = {
-    Box: BoxNonce,
-    SecretBox: SecretBoxNonce,
-    Stream: StreamNonce
-};
+module.exports.Nonces = {};
+
+/** Counter nonces, for keys used by a single sender */
+lazy(module.exports.Nonces, 'Sequence', function() { return addon().NonceSequence; });
+lazy(module.exports.Nonces, 'Box', './nonces/box-nonce');
+lazy(module.exports.Nonces, 'SecretBox', './nonces/secretbox-nonce');
+lazy(module.exports.Nonces, 'Stream', './nonces/stream-nonce');
 
 // Symmetric Keys
-module.exports.Key = {
-    SecretBox: SecretBoxKey,
-    Auth: AuthKey,
-    OneTimeAuth: OneTimeKey,
-    Stream: StreamKey,
-
-    // Public/Secret Key Pairs
-    Box: BoxKey,
-    Sign: SignKey,
-    ECDH: DHKey
-};
+module.exports.Key = {};
+lazy(module.exports.Key, 'SecretBox', './keys/secretbox-key');
+lazy(module.exports.Key, 'Auth', './keys/auth-key');
+lazy(module.exports.Key, 'OneTimeAuth', './keys/onetime-key');
+lazy(module.exports.Key, 'Stream', './keys/stream-key');
+
+// Public/Secret Key Pairs
+lazy(module.exports.Key, 'Box', './keys/box-key');
+lazy(module.exports.Key, 'Sign', './keys/sign-key');
+lazy(module.exports.Key, 'ECDH', './keys/dh-key');
 
 // Elliptic Curve Diffie-Hellman with Curve25519
-module.exports.ECDH = ECDH;
+lazy(module.exports, 'ECDH', './ecdh');
 
 /**
  * Lib Sodium Constants
@@ -163,165 +302,169 @@ module.exports.ECDH = ECDH;
  *
  * All constants represent the size of the buffer or zone of a buffer in bytes
  */
-module.exports.Const = {};
+lazy(module.exports, 'Const', function() {
+    var binding = addon();
+    var Const = {};
 
-/** ScalarMult related constants */
-module.exports.Const.ECDH = {
-    /** Size of scalar buffers */
-    scalarBytes: binding.crypto_scalarmult_SCALARBYTES,
-    
-    /** Size of scalar buffers */
-    bytes: binding.crypto_scalarmult_BYTES,
-    
-    /** Size of the public and secret keys */
-    keyBytes: binding.crypto_scalarmult_BYTES,
-    
-    /** String name of the default crypto primitive used in scalarmult operations */
-    primitive: binding.crypto_scalarmult_PRIMITIVE
-};
+    /** ScalarMult related constants */
+    Const.ECDH = {
+        /** Size of scalar buffers */
+        scalarBytes: binding.crypto_scalarmult_SCALARBYTES,
 
-/** ScalarMult related constants */
-module.exports.Const.ScalarMult = {
-    /** Size of scalar buffers */
-    scalarBytes: binding.crypto_scalarmult_SCALARBYTES,
-    
-    /** Size of the scalarmult keys and points */
-    bytes: binding.crypto_scalarmult_BYTES,
-    
-    /** String name of the default crypto primitive used in scalarmult operations */
-    primitive: binding.crypto_scalarmult_PRIMITIVE
-};
+        /** Size of scalar buffers */
+        bytes: binding.crypto_scalarmult_BYTES,
 
-/** Hash related constants */
-module.exports.Const.Hash = {
-    /** Size of hash buffer in bytes */
-    bytes: binding.crypto_hash_BYTES,
-    
-    /** Size of hash block */
-    blockBytes: binding.crypto_hash_BLOCKBYTES,
-    
-    /** Default primitive */
-    primitive: binding.crypto_hash_PRIMITIVE
-};
+        /** Size of the public and secret keys */
+        keyBytes: binding.crypto_scalarmult_BYTES,
 
-/** Box related constant sizes in bytes */
-module.exports.Const.Box = {
-    
-    /** Box Nonce buffer size in bytes */
-    nonceBytes : binding.crypto_box_NONCEBYTES,
-    
-    /** Box Public Key buffer size in bytes */
-    publicKeyBytes : binding.crypto_box_PUBLICKEYBYTES,
-    
-    /** Box Public Key buffer size in bytes */
-    secretKeyBytes : binding.crypto_box_SECRETKEYBYTES,
-    
-    /**
-     * Messages passed to low level API should be padded with zeroBytes at the beginning.
-     * This implementation automatically pads the message, so no need to do it on your own
-     */
-    zeroBytes : binding.crypto_box_ZEROBYTES,
-    
-    /**
-     * Encrypted messages are padded with zeroBoxSize bytes of zeros. If the padding is not
-     * there the message will not decrypt successfully.
-     */
-    boxZeroBytes : binding.crypto_box_BOXZEROBYTES,
-    
-    /**
-     * Padding used in beforenm method. Like zeroBytes this implementation automatically
-     * pads the message.
-     *
-     * @see Const.Box.zeroBytes
-     */
-    beforenmBytes : binding.crypto_box_BEFORENMBYTES,
-    
-    /** String name of the default crypto primitive used in box operations */
-    primitive: binding.crypto_box_PRIMITIVE
-};
+        /** String name of the default crypto primitive used in scalarmult operations */
+        primitive: binding.crypto_scalarmult_PRIMITIVE
+    };
 
-/** Authentication Constants */
-module.exports.Const.Auth = {
-    
-    /** Size of the authentication token */
-    bytes: binding.crypto_auth_BYTES,
+    /** ScalarMult related constants */
+    Const.ScalarMult = {
+        /** Size of scalar buffers */
+        scalarBytes: binding.crypto_scalarmult_SCALARBYTES,
 
-    /** Size of the secret key used to generate the authentication token */
-    keyBytes: binding.crypto_auth_KEYBYTES,
-    
-    /** String name of the default crypto primitive used in auth operations */
-    primitive: binding.crypto_auth_PRIMITIVE
-};
+        /** Size of the scalarmult keys and points */
+        bytes: binding.crypto_scalarmult_BYTES,
 
-/** One Time Authentication Constants */
-module.exports.Const.OneTimeAuth = {
+        /** String name of the default crypto primitive used in scalarmult operations */
+        primitive: binding.crypto_scalarmult_PRIMITIVE
+    };
 
-    /** Size of the authentication token */
-    bytes: binding.crypto_onetimeauth_BYTES,
-    
-    /** Size of the secret key used to generate the authentication token */
-    keyBytes: binding.crypto_onetimeauth_KEYBYTES,
-    
-    /** String name of the default crypto primitive used in onetimeauth operations */
-    primitive: binding.crypto_onetimeauth_PRIMITIVE
-};
+    /** Hash related constants */
+    Const.Hash = {
+        /** Size of hash buffer in bytes */
+        bytes: binding.crypto_hash_BYTES,
 
-/** SecretBox Symmetric Key Crypto Constants */
-module.exports.Const.SecretBox = {
+        /** Size of hash block */
+        blockBytes: binding.crypto_hash_BLOCKBYTES,
 
-    /** SecretBox padding of cipher text buffer */
-    boxZeroBytes: binding.crypto_secretbox_BOXZEROBYTES,
-    
-    /** Size of the secret key used to encrypt/decrypt messages */
-    keyBytes: binding.crypto_secretbox_KEYBYTES,
-    
-    /** Size of the Nonce used in encryption/decryption of messages */
-    nonceBytes: binding.crypto_secretbox_NONCEBYTES,
-    
-    /** Passing of message. This implementation does message padding automatically */
-    zeroBytes: binding.crypto_secretbox_ZEROBYTES,
-    
-    /** String name of the default crypto primitive used in secretbox operations */
-    primitive: binding.crypto_secretbox_PRIMITIVE
-};
+        /** Default primitive */
+        primitive: binding.crypto_hash_PRIMITIVE
+    };
 
-/** Digital message signature constants */
-module.exports.Const.Sign = {
+    /** Box related constant sizes in bytes */
+    Const.Box = {
 
-    /** Size of the generated message signature */
-    bytes: binding.crypto_sign_BYTES,
+        /** Box Nonce buffer size in bytes */
+        nonceBytes : binding.crypto_box_NONCEBYTES,
 
-    /** Size of the public key used to verify signatures */
-    publicKeyBytes: binding.crypto_sign_PUBLICKEYBYTES,
+        /** Box Public Key buffer size in bytes */
+        publicKeyBytes : binding.crypto_box_PUBLICKEYBYTES,
 
-    /** Size of the secret key used to sign a message */
-    secretKeyBytes: binding.crypto_sign_SECRETKEYBYTES,
-    
-    /** String name of the default crypto primitive used in sign operations */
-    primitive: binding.crypto_sign_PRIMITIVE
-};
+        /** Box Public Key buffer size in bytes */
+        secretKeyBytes : binding.crypto_box_SECRETKEYBYTES,
 
-/** Symmetric Encryption Constants */
-module.exports.Const.Stream = {
-    /** Size of secret key used to encrypt/decrypt messages */
-    keyBytes : binding.crypto_stream_KEYBYTES,
+        /**
+         * Messages passed to low level API should be padded with zeroBytes at the beginning.
+         * This implementation automatically pads the message, so no need to do it on your own
+         */
+        zeroBytes : binding.crypto_box_ZEROBYTES,
 
-    /** Size of nonce used to encrypt/decrypt messages */
-    nonceBytes : binding.crypto_stream_NONCEBYTES,
-    
-    /** String name of the default crypto primitive used in stream operations */
-    primitive: binding.crypto_stream_PRIMITIVE
-};
+        /**
+         * Encrypted messages are padded with zeroBoxSize bytes of zeros. If the padding is not
+         * there the message will not decrypt successfully.
+         */
+        boxZeroBytes : binding.crypto_box_BOXZEROBYTES,
 
-/** Short hash related constants */
-module.exports.Const.ShortHash = {
-    /** Size of short hash buffer in bytes*/
-    bytes: binding.crypto_shorthash_BYTES,
-    
-    /** Size of short hash Key buffer in bytes */
-    keyBytes: binding.crypto_shorthash_KEYBYTES,
-    
-    /** String name of primitive used to calculate short hash */
-    primitive: binding.crypto_shorthash_PRIMITIVE
-};
+        /**
+         * Padding used in beforenm method. Like zeroBytes this implementation automatically
+         * pads the message.
+         *
+         * @see Const.Box.zeroBytes
+         */
+        beforenmBytes : binding.crypto_box_BEFORENMBYTES,
+
+        /** String name of the default crypto primitive used in box operations */
+        primitive: binding.crypto_box_PRIMITIVE
+    };
+
+    /** Authentication Constants */
+    Const.Auth = {
+
+        /** Size of the authentication token */
+        bytes: binding.crypto_auth_BYTES,
+
+        /** Size of the secret key used to generate the authentication token */
+        keyBytes: binding.crypto_auth_KEYBYTES,
+
+        /** String name of the default crypto primitive used in auth operations */
+        primitive: binding.crypto_auth_PRIMITIVE
+    };
+
+    /** One Time Authentication Constants */
+    Const.OneTimeAuth = {
+
+        /** Size of the authentication token */
+        bytes: binding.crypto_onetimeauth_BYTES,
+
+        /** Size of the secret key used to generate the authentication token */
+        keyBytes: binding.crypto_onetimeauth_KEYBYTES,
+
+        /** String name of the default crypto primitive used in onetimeauth operations */
+        primitive: binding.crypto_onetimeauth_PRIMITIVE
+    };
+
+    /** SecretBox Symmetric Key Crypto Constants */
+    Const.SecretBox = {
+
+        /** SecretBox padding of cipher text buffer */
+        boxZeroBytes: binding.crypto_secretbox_BOXZEROBYTES,
+
+        /** Size of the secret key used to encrypt/decrypt messages */
+        keyBytes: binding.crypto_secretbox_KEYBYTES,
+
+        /** Size of the Nonce used in encryption/decryption of messages */
+        nonceBytes: binding.crypto_secretbox_NONCEBYTES,
+
+        /** Passing of message. This implementation does message padding automatically */
+        zeroBytes: binding.crypto_secretbox_ZEROBYTES,
+
+        /** String name of the default crypto primitive used in secretbox operations */
+        primitive: binding.crypto_secretbox_PRIMITIVE
+    };
+
+    /** Digital message signature constants */
+    Const.Sign = {
+
+        /** Size of the generated message signature */
+        bytes: binding.crypto_sign_BYTES,
+
+        /** Size of the public key used to verify signatures */
+        publicKeyBytes: binding.crypto_sign_PUBLICKEYBYTES,
+
+        /** Size of the secret key used to sign a message */
+        secretKeyBytes: binding.crypto_sign_SECRETKEYBYTES,
+
+        /** String name of the default crypto primitive used in sign operations */
+        primitive: binding.crypto_sign_PRIMITIVE
+    };
+
+    /** Symmetric Encryption Constants */
+    Const.Stream = {
+        /** Size of secret key used to encrypt/decrypt messages */
+        keyBytes : binding.crypto_stream_KEYBYTES,
+
+        /** Size of nonce used to encrypt/decrypt messages */
+        nonceBytes : binding.crypto_stream_NONCEBYTES,
+
+        /** String name of the default crypto primitive used in stream operations */
+        primitive: binding.crypto_stream_PRIMITIVE
+    };
+
+    /** Short hash related constants */
+    Const.ShortHash = {
+        /** Size of short hash buffer in bytes*/
+        bytes: binding.crypto_shorthash_BYTES,
+
+        /** Size of short hash Key buffer in bytes */
+        keyBytes: binding.crypto_shorthash_KEYBYTES,
+
+        /** String name of primitive used to calculate short hash */
+        primitive: binding.crypto_shorthash_PRIMITIVE
+    };
 
+    return Const;
+});
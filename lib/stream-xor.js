@@ -0,0 +1,160 @@
+/**
+ * # XorStream
+ * XOR a node stream with a `crypto_stream` key stream
+ *
+ * `Stream.encrypt` XORs a whole buffer at once. An XorStream XORs data as it
+ * flows through, in constant memory, continuing the key stream from one
+ * chunk to the next:
+ *
+ *     var enc = new sodium.XorStream('xchacha20', key, nonce);
+ *     fs.createReadStream('movie.mp4').pipe(enc).pipe(out);
+ *
+ * The output is the same as `crypto_stream_<algorithm>_xor` over the whole
+ * stream, whatever the chunk boundaries. Whole 64 byte blocks go straight
+ * to `crypto_stream_<algorithm>_xor_ic` at their block counter; a chunk
+ * that stops in the middle of a block keeps the rest of that block's key
+ * stream for the next chunk. XOR is its own inverse, so the same stream
+ * decrypts.
+ *
+ * There is no authentication: use SecretStream unless the data is
+ * authenticated some other way, or random access into it is what you need.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var binding = require('./binding');
+var stream = require('stream');
+var util = require('util');
+var assert = require('assert');
+
+/** Size of a key stream block, the unit of the block counter */
+var BLOCKBYTES = 64;
+
+/** Algorithms with a `_xor_ic` binding */
+var ALGORITHMS = ['chacha20', 'chacha20_ietf', 'xchacha20', 'salsa20', 'xsalsa20'];
+
+/**
+ * @param {String} algorithm  'chacha20', 'chacha20_ietf', 'xchacha20',
+ *   'salsa20' or 'xsalsa20'
+ * @param {Buffer} key        `crypto_stream_<algorithm>_KEYBYTES` key
+ * @param {Buffer} nonce      `crypto_stream_<algorithm>_NONCEBYTES` nonce
+ * @param {Object} [options]  stream.Transform options, plus
+ *   - `position` (Number): offset in the key stream of the first byte, to
+ *     resume or seek into a stream. Default 0
+ *   - `inPlace` (Boolean): XOR the written Buffers in place and pass them on,
+ *     instead of copying. Writers must not reuse them. Default false
+ * @constructor
+ */
+function XorStream(algorithm, key, nonce, options) {
+    if( !(this instanceof XorStream) ) {
+        return new XorStream(algorithm, key, nonce, options);
+    }
+
+    assert.ok(ALGORITHMS.indexOf(algorithm) !== -1, 'unknown stream algorithm ' + algorithm);
+    assert.ok(Buffer.isBuffer(key) && key.length === binding['crypto_stream_' + algorithm + '_KEYBYTES'],
+        'key must be a crypto_stream_' + algorithm + '_KEYBYTES Buffer');
+    assert.ok(Buffer.isBuffer(nonce) && nonce.length === binding['crypto_stream_' + algorithm + '_NONCEBYTES'],
+        'nonce must be a crypto_stream_' + algorithm + '_NONCEBYTES Buffer');
+
+    options = options || {};
+    var position = options.position !== undefined ? options.position : 0;
+    assert.ok(Number.isSafeInteger(position) && position >= 0,
+        'options.position must be a positive integer');
+
+    stream.Transform.call(this, options);
+
+    var self = this;
+    var xorIc = binding['crypto_stream_' + algorithm + '_xor_ic_inplace'];
+    var inPlace = !!options.inPlace;
+
+    // Copies, so the caller can wipe theirs
+    key = Buffer.from(key);
+    nonce = Buffer.from(nonce);
+
+    // Counter of the next unused block, and the rest of a partly used block
+    var block = Math.floor(position / BLOCKBYTES);
+    var keyStream = Buffer.alloc(BLOCKBYTES);
+    var used = BLOCKBYTES;
+
+    function nextBlock() {
+        keyStream.fill(0);
+        xorIc(keyStream, nonce, block, key);
+        block++;
+    }
+
+    if( position % BLOCKBYTES !== 0 ) {
+        nextBlock();
+        used = position % BLOCKBYTES;
+    }
+
+    /** Name of the stream cipher */
+    self.algorithm = algorithm;
+
+    /**
+     * XOR `data` with the next `data.length` bytes of key stream
+     * @param {Buffer} data  changed in place
+     * @returns {Buffer} data
+     */
+    self.update = function(data) {
+        var length = data.length;
+        var i = 0;
+
+        // Rest of the block the last chunk stopped in
+        for( ; i < length && used < BLOCKBYTES; i++ ) {
+            data[i] ^= keyStream[used++];
+        }
+
+        var whole = length - i - (length - i) % BLOCKBYTES;
+        if( whole > 0 ) {
+            xorIc(data, i, whole, nonce, block, key);
+            block += whole / BLOCKBYTES;
+            i += whole;
+        }
+
+        if( i < length ) {
+            nextBlock();
+            used = 0;
+            for( ; i < length; i++ ) {
+                data[i] ^= keyStream[used++];
+            }
+        }
+        return data;
+    };
+
+    /**
+     * Offset in the key stream of the next byte
+     * @returns {Number}
+     */
+    self.position = function() {
+        return block * BLOCKBYTES - (BLOCKBYTES - used);
+    };
+
+    self._transform = function(chunk, encoding, callback) {
+        if( !Buffer.isBuffer(chunk) ) {
+            chunk = Buffer.from(chunk, encoding);
+        }
+        else if( !inPlace ) {
+            chunk = Buffer.from(chunk);
+        }
+        try {
+            self.update(chunk);
+        }
+        catch(err) {
+            return callback(err);
+        }
+        callback(null, chunk);
+    };
+
+    self._flush = function(callback) {
+        binding.memzero(keyStream);
+        binding.memzero(key);
+        callback();
+    };
+}
+util.inherits(XorStream, stream.Transform);
+
+module.exports.XorStream = XorStream;
+module.exports.ALGORITHMS = ALGORITHMS;
+module.exports.BLOCKBYTES = BLOCKBYTES;
@@ -1,9 +1,10 @@
 /* jslint node: true */
 'use strict';
 
-var binding = require('../build/Release/sodium');
+var binding = require('./binding');
 var StreamKey = require('./keys/stream-key');
 var toBuffer = require('./toBuffer');
+var CryptoBaseBuffer = require('./crypto-base-buffer');
 var Nonce = require('./nonces/stream-nonce');
 var assert = require('assert');
 
@@ -79,9 +80,9 @@ module.exports = function Stream(secretKey, encoding) {
 
         var messageBuf = toBuffer(message, encoding);
 
-        var nonce = new Nonce();
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_stream_NONCEBYTES);
 
-        var cipherText = binding.crypto_stream_xor(messageBuf, nonce.get(), self.secretKey.get());
+        var cipherText = binding.crypto_stream_xor(messageBuf, nonce, self.secretKey.get());
 
         if( !cipherText ) {
             return undefined;
@@ -89,7 +90,7 @@ module.exports = function Stream(secretKey, encoding) {
 
         return {
             cipherText: cipherText,
-            nonce : nonce.get()
+            nonce : nonce
         };
     };
 
@@ -111,11 +112,11 @@ module.exports = function Stream(secretKey, encoding) {
         assert.ok(cipherBox.cipherText instanceof Buffer);
         assert.ok(cipherBox.nonce instanceof Buffer);
 
-        var nonce = new Nonce(cipherBox.nonce);
+        var nonce = CryptoBaseBuffer.nonce(Nonce, binding.crypto_stream_NONCEBYTES, cipherBox.nonce);
 
         var plainText = binding.crypto_stream_xor(
             cipherBox.cipherText,
-            nonce.get(),
+            nonce,
             self.secretKey.get()
         );
 
@@ -0,0 +1,150 @@
+/**
+ * Subsystems of the addon
+ *
+ * The addon is built from the `core` sources plus the sources of the
+ * subsystems selected with the `sodium_subsystems` gyp variable, a comma
+ * separated list of the names below or `all`, the default:
+ *
+ *     make sodium SODIUM_SUBSYSTEMS=aead,sign
+ *     npm install sodium --sodium-subsystems=aead,sign
+ *
+ * binding.gyp runs this file to get the sources and the defines of a
+ * selection. Every subsystem left out is compiled with `SODIUM_NO_<NAME>`,
+ * which drops its registration in src/sodium.cc. libsodium is linked
+ * statically, so the linker leaves out its code that only the dropped
+ * sources called. Subsystems link on their own: each one needs only the
+ * core.
+ *
+ *     node lib/subsystems.js sources|defines <selection>
+ */
+/* jslint node: true */
+'use strict';
+
+var SUBSYSTEMS = {
+    // Always built: module setup, argument and output helpers, statistics,
+    // thread pools, secure memory, random numbers and the key pair pool
+    core: [
+        'sodium', 'helpers', 'sodium_args', 'sodium_stats', 'sodium_latency',
+        'sodium_runtime', 'sodium_pool', 'sodium_memory', 'sodium_secure_slots',
+        'sodium_secure_pool', 'sodium_arena', 'sodium_bench', 'sodium_perf_counters',
+        'sodium_file', 'sodium_chunker', 'sodium_log', 'sodium_async_channel',
+        'sodium_async_scheduler', 'sodium_threads', 'sodium_ring', 'sodium_pipeline',
+        'sodium_shared_cache', 'sodium_snapshot', 'randombytes', 'crypto_keypair_pool'
+    ],
+    aead: [
+        'crypto_aead', 'crypto_aead_context', 'crypto_aead_envelope',
+        'crypto_aead_convergent', 'crypto_aead_column', 'crypto_aead_transport',
+        'crypto_aead_packet', 'nonce_sequence'
+    ],
+    box: [
+        'crypto_box', 'crypto_box_session', 'crypto_box_multi', 'crypto_box_cache', 'crypto_box_signed',
+        'crypto_box_curve25519xsalsa20poly1305', 'crypto_box_curve25519xchacha20poly1305',
+        'crypto_age'
+    ],
+    sign: [
+        'crypto_sign', 'crypto_paseto', 'crypto_sign_ed25519', 'crypto_sign_context',
+        'crypto_sign_verify_cache', 'crypto_sign_curve25519_cache'
+    ],
+    pwhash: [
+        'crypto_pwhash_algos', 'crypto_pwhash', 'sodium_pwhash_pool', 'sodium_pwhash_memory'
+    ],
+    hash: [
+        'crypto_hash', 'crypto_hash_sha256', 'crypto_hash_sha512', 'crypto_hash_state',
+        'crypto_merkle', 'crypto_generichash', 'crypto_generichash_blake2b',
+        'crypto_generichash_index', 'crypto_shorthash', 'crypto_shorthash_siphash24',
+        'crypto_shorthash_filter'
+    ],
+    auth: [
+        'crypto_auth', 'crypto_auth_algos', 'crypto_auth_key', 'crypto_onetimeauth',
+        'crypto_onetimeauth_poly1305'
+    ],
+    secretbox: [
+        'crypto_secretbox', 'crypto_secretbox_xsalsa20poly1305', 'crypto_secretbox_xchacha20poly1305'
+    ],
+    secretstream: [
+        'crypto_secretstream'
+    ],
+    stream: [
+        'crypto_stream', 'crypto_streams', 'crypto_stream_keystream'
+    ],
+    kx: [
+        'crypto_scalarmult', 'crypto_scalarmult_curve25519', 'crypto_kx', 'crypto_noise',
+        'crypto_ratchet'
+    ],
+    kdf: [
+        'crypto_kdf', 'crypto_kdf_tree', 'crypto_core'
+    ]
+};
+
+/**
+ * Names of the optional subsystems
+ */
+function names() {
+    return Object.keys(SUBSYSTEMS).filter(function(name) {
+        return name !== 'core';
+    });
+}
+
+/**
+ * Subsystems of `selection`, a comma separated list or `all`
+ */
+function parse(selection) {
+    if( !selection || selection === 'all' ) {
+        return names();
+    }
+    var selected = selection.split(',').map(function(name) {
+        return name.trim();
+    }).filter(function(name) {
+        return name !== '' && name !== 'core';
+    });
+    selected.forEach(function(name) {
+        if( !SUBSYSTEMS[name] ) {
+            throw new Error('unknown subsystem ' + name + ', pick from ' + names().join(','));
+        }
+    });
+    return names().filter(function(name) {
+        return selected.indexOf(name) !== -1;
+    });
+}
+
+/**
+ * Source files of `selection`, relative to the package
+ */
+function sources(selection) {
+    return ['core'].concat(parse(selection)).reduce(function(files, name) {
+        return files.concat(SUBSYSTEMS[name].map(function(file) {
+            return 'src/' + file + '.cc';
+        }));
+    }, []);
+}
+
+/**
+ * `SODIUM_NO_<NAME>` for every subsystem left out of `selection`
+ */
+function defines(selection) {
+    var selected = parse(selection);
+    return names().filter(function(name) {
+        return selected.indexOf(name) === -1;
+    }).map(function(name) {
+        return 'SODIUM_NO_' + name.toUpperCase();
+    });
+}
+
+module.exports.names = names;
+module.exports.parse = parse;
+module.exports.sources = sources;
+module.exports.defines = defines;
+
+if( require.main === module ) {
+    var command = { sources: sources, defines: defines }[process.argv[2]];
+    if( !command ) {
+        console.error('usage: node lib/subsystems.js sources|defines <selection>');
+        process.exit(1);
+    }
+    try {
+        console.log(command(process.argv[3]).join(' '));
+    } catch (e) {
+        console.error(e.message);
+        process.exit(1);
+    }
+}
@@ -10,16 +10,23 @@
 /* jslint node: true */
 'use strict';
 
+var binding = require('./binding');
+
 var re = /^(?:utf8|ascii|binary|hex|utf16le|ucs2|base64)$/
 /**
  * Convert value into a buffer
  *
- * @param {String|Buffer|Array} value  a buffer, and array of bytes or a string that you want to convert to a buffer
+ * @param {String|Buffer|Uint8Array|Array} value  a buffer, and array of bytes or a string that you want to convert to a buffer
  * @param {String} [encoding]          encoding to use in conversion if value is a string. Defaults to 'hex'
  * @returns {*}
  */
 function toBuffer(value, encoding) {
 
+    // Most callers already hold a Buffer, return it before any other check
+    if( Buffer.isBuffer(value) ) {
+        return value;
+    }
+
     if( typeof value === 'string') {
 
         encoding = encoding || 'hex';
@@ -28,6 +35,20 @@ function toBuffer(value, encoding) {
             throw new Error('[toBuffer] bad encoding. Must be: utf8|ascii|binary|hex|utf16le|ucs2|base64');
         }
         
+        // Keys and secrets are usually hex or base64. libsodium decodes those
+        // in constant time. Buffer.from is more lenient, so it still handles
+        // anything the strict decoders reject
+        var decoded = null;
+        if( encoding === 'hex' ) {
+            decoded = binding.sodium_hex2bin(value);
+        }
+        else if( encoding === 'base64' ) {
+            decoded = binding.sodium_base642bin(value, binding.sodium_base64_VARIANT_ORIGINAL);
+        }
+        if( decoded ) {
+            return decoded;
+        }
+
         try {
             return Buffer.from(value, encoding);
         }
@@ -37,8 +58,9 @@ function toBuffer(value, encoding) {
 
     }
     else if( typeof value === 'object' ) {
-        if( Buffer.isBuffer(value) ) {
-            return value;
+        if( value instanceof Uint8Array ) {
+            // Same memory, no copy
+            return Buffer.from(value.buffer, value.byteOffset, value.byteLength);
         }
         else if( value instanceof Array ) {
             try {
@@ -0,0 +1,1167 @@
+/**
+ * WebAssembly build of libsodium
+ *
+ * `prebuild-wasm.js` compiles the bundled libsodium to
+ * `prebuilds/wasm32/sodium.wasm` with Emscripten: a standalone module with
+ * WebAssembly SIMD, exporting the functions listed in
+ * `exported_functions.js`. lib/binding.js loads it through this module when
+ * there is neither a build from source nor a prebuilt binary for the host,
+ * so the package installs and runs where the addon cannot be compiled.
+ *
+ * The module is wrapped into an object with the arguments and results of
+ * the addon: buffers in, new buffers out, `null` when a call fails, and
+ * the same constants. Only the libsodium functions of the list are there;
+ * the addon's own extensions, such as the `_async` and `_batch` calls, the
+ * caches and the native classes, are not. Arguments are copied into the
+ * module's memory for each call and the copies are wiped afterwards.
+ *
+ * libsodium picks its SSE2 to SSE4.1 kernels, BLAKE2b, Argon2, ChaCha20
+ * and Salsa20, which Emscripten compiles to WebAssembly SIMD.
+ */
+/* jslint node: true */
+'use strict';
+
+var crypto = require('crypto');
+var fs = require('fs');
+var prebuilds = require('./prebuilds');
+
+// WASI errno returned by the system calls the module has no use for
+var ENOSYS = 52;
+
+/**
+ * Compile and start the module in `file`
+ *
+ * @returns {Object} its exports
+ */
+function instantiate(file) {
+    var module = new WebAssembly.Module(fs.readFileSync(file));
+    var memory = null;
+
+    function fill(ptr, size) {
+        crypto.randomFillSync(new Uint8Array(memory.buffer, ptr, size));
+    }
+
+    var imports = {
+        // randombytes of the SODIUM_WASM_STANDALONE build
+        sodium: {
+            random_fill: fill
+        },
+        wasi_snapshot_preview1: {
+            random_get: function(ptr, size) {
+                fill(ptr, size);
+                return 0;
+            },
+            proc_exit: function(code) {
+                throw new Error('sodium: libsodium aborted with code ' + code);
+            }
+        }
+    };
+    WebAssembly.Module.imports(module).forEach(function(entry) {
+        if( entry.kind !== 'function' ) {
+            return;
+        }
+        var scope = imports[entry.module] = imports[entry.module] || {};
+        if( !scope[entry.name] ) {
+            scope[entry.name] = function() {
+                return ENOSYS;
+            };
+        }
+    });
+
+    var instance = new WebAssembly.Instance(module, imports);
+    memory = instance.exports.memory;
+    if( typeof instance.exports._initialize === 'function' ) {
+        instance.exports._initialize();
+    }
+    return instance.exports;
+}
+
+/**
+ * Argument `value` as a Uint8Array over the caller's memory
+ */
+function bytes(value, name, length) {
+    var view = null;
+    if( ArrayBuffer.isView(value) ) {
+        view = new Uint8Array(value.buffer, value.byteOffset, value.byteLength);
+    } else if( value instanceof ArrayBuffer ) {
+        view = new Uint8Array(value);
+    }
+    if( view === null ) {
+        throw new TypeError('argument ' + name + ' must be a buffer');
+    }
+    if( length !== undefined && view.length !== length ) {
+        throw new TypeError('argument ' + name + ' must be ' + length + ' bytes long');
+    }
+    return view;
+}
+
+function bytesOrNull(value, name, length) {
+    return value === null || value === undefined ? null : bytes(value, name, length);
+}
+
+function bytesOrString(value, name) {
+    return typeof value === 'string' ? Buffer.from(value) : bytes(value, name);
+}
+
+function number(value, name) {
+    if( typeof value !== 'number' || !(value >= 0) || Math.floor(value) !== value ) {
+        throw new TypeError('argument ' + name + ' must be a positive integer');
+    }
+    return value;
+}
+
+/**
+ * Build the `sodium.api` object over the exports of the module
+ */
+function wrap(lib) {
+    var api = {};
+
+    if( lib.sodium_init() < 0 ) {
+        throw new Error('sodium: cannot initialize libsodium');
+    }
+
+    function view(ptr, size) {
+        return new Uint8Array(lib.memory.buffer, ptr, size);
+    }
+
+    function string(ptr) {
+        var heap = new Uint8Array(lib.memory.buffer);
+        var end = ptr;
+        while( heap[end] !== 0 ) {
+            end++;
+        }
+        return Buffer.from(heap.subarray(ptr, end)).toString('latin1');
+    }
+
+    /**
+     * Memory for one call. Every block is wiped and freed by `free`
+     */
+    function Frame() {
+        this.blocks = [];
+    }
+
+    Frame.prototype.alloc = function(size, align) {
+        align = align || 8;
+        var base = lib.malloc(size + align);
+        if( base === 0 ) {
+            throw new Error('sodium: out of WebAssembly memory');
+        }
+        this.blocks.push(base, size + align);
+        return (base + align - 1) & ~(align - 1);
+    };
+
+    // Copy `value` in, or return NULL for null
+    Frame.prototype.input = function(value, align) {
+        if( value === null ) {
+            return 0;
+        }
+        var ptr = this.alloc(value.length, align);
+        view(ptr, value.length).set(value);
+        return ptr;
+    };
+
+    Frame.prototype.output = function(ptr, size) {
+        return Buffer.from(view(ptr, size));
+    };
+
+    Frame.prototype.uint32 = function(ptr) {
+        return new Uint32Array(lib.memory.buffer, ptr, 1)[0];
+    };
+
+    Frame.prototype.free = function() {
+        for( var i = 0; i < this.blocks.length; i += 2 ) {
+            view(this.blocks[i], this.blocks[i + 1]).fill(0);
+            lib.free(this.blocks[i]);
+        }
+        this.blocks.length = 0;
+    };
+
+    function call(work) {
+        var frame = new Frame();
+        try {
+            return work(frame);
+        } finally {
+            frame.free();
+        }
+    }
+
+    // Write `ptr` back into the caller's `target`, for state and in place
+    // arguments
+    function writeBack(frame, target, ptr) {
+        target.set(view(ptr, target.length));
+    }
+
+    function ull(n) {
+        return BigInt(n);
+    }
+
+    function constant(name) {
+        return api[name];
+    }
+
+    // Size, limit and name getters: both `crypto_box_noncebytes()` and
+    // `crypto_box_NONCEBYTES`, as the addon exports them
+    var CONSTANT = /_((?:[a-z0-9]*bytes|opslimit|memlimit|passwd|alg|strprefix|primitive|tag)(?:_[a-z0-9]+)*)$/;
+    var STRING = /_(primitive|strprefix)$/;
+
+    Object.keys(lib).forEach(function(name) {
+        var match = CONSTANT.exec(name);
+        if( !match || typeof lib[name] !== 'function' || lib[name].length !== 0 ) {
+            return;
+        }
+        // size_t results come back signed, unsigned long long ones as BigInt
+        var raw = lib[name]();
+        var value = STRING.test(name) ? string(raw) : typeof raw === 'bigint' ? Number(raw) : raw >>> 0;
+        api[name] = function() {
+            return value;
+        };
+        api[name.slice(0, match.index + 1) + match[1].toUpperCase()] = value;
+    });
+
+    // `*_keygen()` returns a new random key
+    Object.keys(lib).forEach(function(name) {
+        var keyBytes = api[name.replace(/_keygen$/, '_keybytes')];
+        if( !/_keygen$/.test(name) || !keyBytes ) {
+            return;
+        }
+        var size = keyBytes();
+        api[name] = function() {
+            return call(function(frame) {
+                var k = frame.alloc(size);
+                lib[name](k);
+                return frame.output(k, size);
+            });
+        };
+    });
+
+    function keypair(prefix, seedName) {
+        var pkBytes = constant(prefix + '_PUBLICKEYBYTES');
+        var skBytes = constant(prefix + '_SECRETKEYBYTES');
+        var seedBytes = constant(prefix + '_SEEDBYTES');
+
+        api[prefix + '_keypair'] = function() {
+            return call(function(frame) {
+                var pk = frame.alloc(pkBytes);
+                var sk = frame.alloc(skBytes);
+                if( lib[prefix + '_keypair'](pk, sk) !== 0 ) {
+                    return null;
+                }
+                return { publicKey: frame.output(pk, pkBytes), secretKey: frame.output(sk, skBytes) };
+            });
+        };
+        api[prefix + '_seed_keypair'] = function(seed) {
+            seed = bytes(seed, seedName, seedBytes);
+            return call(function(frame) {
+                var pk = frame.alloc(pkBytes);
+                var sk = frame.alloc(skBytes);
+                if( lib[prefix + '_seed_keypair'](pk, sk, frame.input(seed)) !== 0 ) {
+                    return null;
+                }
+                return { publicKey: frame.output(pk, pkBytes), secretKey: frame.output(sk, skBytes) };
+            });
+        };
+    }
+
+    /*
+     * Version and utilities
+     */
+    api.sodium_version_string = function() {
+        return string(lib.sodium_version_string());
+    };
+    api.sodium_library_version_major = function() {
+        return lib.sodium_library_version_major();
+    };
+    api.sodium_library_version_minor = function() {
+        return lib.sodium_library_version_minor();
+    };
+    api.sodium_library_minimal = function() {
+        return lib.sodium_library_minimal();
+    };
+    api.version = api.sodium_version_string();
+    api.versionMajor = api.sodium_library_version_major();
+    api.versionMinor = api.sodium_library_version_minor();
+
+    api.memzero = function(buffer) {
+        bytes(buffer, 'buffer').fill(0);
+        return null;
+    };
+
+    // Constant time for a given size, as sodium_memcmp
+    function compare(a, b, size) {
+        var d = 0;
+        for( var i = 0; i < size; i++ ) {
+            d |= a[i] ^ b[i];
+        }
+        return d === 0 ? 0 : -1;
+    }
+
+    api.memcmp = function(buffer1, buffer2, size) {
+        var a = bytes(buffer1, 'buffer1');
+        var b = bytes(buffer2, 'buffer2');
+        return compare(a, b, Math.min(number(size, 'size'), a.length, b.length));
+    };
+    [16, 32, 64].forEach(function(n) {
+        api['crypto_verify_' + n] = function(buffer1, buffer2) {
+            return compare(bytes(buffer1, 'buffer1', n), bytes(buffer2, 'buffer2', n), n);
+        };
+        api['crypto_verify_' + n + '_BYTES'] = n;
+    });
+
+    api.sodium_bin2hex = function(buffer) {
+        var bin = bytes(buffer, 'buffer');
+        return call(function(frame) {
+            var hex = frame.alloc(2 * bin.length + 1);
+            lib.sodium_bin2hex(hex, 2 * bin.length + 1, frame.input(bin), bin.length);
+            return frame.output(hex, 2 * bin.length).toString('latin1');
+        });
+    };
+
+    function text(value, name) {
+        return typeof value === 'string' ? Buffer.from(value) : bytes(value, name);
+    }
+
+    function ignoreArg(frame, ignore) {
+        return typeof ignore === 'string' ? frame.input(Buffer.from(ignore + '\0')) : 0;
+    }
+
+    api.sodium_hex2bin = function(hex, ignore) {
+        var input = text(hex, 'hex');
+        return call(function(frame) {
+            var max = input.length >> 1;
+            var bin = frame.alloc(max);
+            var len = frame.alloc(4);
+            if( lib.sodium_hex2bin(bin, max, frame.input(input), input.length, ignoreArg(frame, ignore), len, 0) !== 0 ) {
+                return null;
+            }
+            return frame.output(bin, frame.uint32(len));
+        });
+    };
+
+    function variantArg(variant) {
+        return variant === undefined ? api.sodium_base64_VARIANT_ORIGINAL : number(variant, 'variant');
+    }
+
+    api.sodium_base64_VARIANT_ORIGINAL = 1;
+    api.sodium_base64_VARIANT_ORIGINAL_NO_PADDING = 3;
+    api.sodium_base64_VARIANT_URLSAFE = 5;
+    api.sodium_base64_VARIANT_URLSAFE_NO_PADDING = 7;
+
+    api.sodium_base64_encoded_len = function(length, variant) {
+        return lib.sodium_base64_encoded_len(number(length, 'length'), variantArg(variant)) - 1;
+    };
+
+    api.sodium_bin2base64 = function(buffer, variant) {
+        var bin = bytes(buffer, 'buffer');
+        variant = variantArg(variant);
+        return call(function(frame) {
+            var size = lib.sodium_base64_encoded_len(bin.length, variant);
+            var b64 = frame.alloc(size);
+            lib.sodium_bin2base64(b64, size, frame.input(bin), bin.length, variant);
+            return frame.output(b64, size - 1).toString('latin1');
+        });
+    };
+
+    api.sodium_base642bin = function(b64, variant, ignore) {
+        var input = text(b64, 'text');
+        variant = variantArg(variant);
+        return call(function(frame) {
+            var max = Math.floor(input.length * 3 / 4) + 3;
+            var bin = frame.alloc(max);
+            var len = frame.alloc(4);
+            if( lib.sodium_base642bin(bin, max, frame.input(input), input.length, ignoreArg(frame, ignore),
+                                      len, 0, variant) !== 0 ) {
+                return null;
+            }
+            return frame.output(bin, frame.uint32(len));
+        });
+    };
+
+    api.sodium_pad = function(buffer, blockSize) {
+        var input = bytes(buffer, 'buffer');
+        if( number(blockSize, 'blockSize') === 0 ) {
+            throw new Error('argument blockSize must be bigger than 0');
+        }
+        return call(function(frame) {
+            var size = (Math.floor(input.length / blockSize) + 1) * blockSize;
+            var padded = frame.alloc(size);
+            var len = frame.alloc(4);
+            view(padded, input.length).set(input);
+            lib.sodium_pad(len, padded, input.length, blockSize, size);
+            return frame.output(padded, size);
+        });
+    };
+
+    api.sodium_unpad = function(buffer, blockSize) {
+        var input = bytes(buffer, 'buffer');
+        if( number(blockSize, 'blockSize') === 0 ) {
+            throw new Error('argument blockSize must be bigger than 0');
+        }
+        return call(function(frame) {
+            var len = frame.alloc(4);
+            if( lib.sodium_unpad(len, frame.input(input), input.length, blockSize) !== 0 ) {
+                return null;
+            }
+            return buffer.subarray(0, frame.uint32(len));
+        });
+    };
+
+    /*
+     * Random numbers
+     */
+    api.randombytes_buf = function(buffer) {
+        var out = bytes(buffer, 'buffer');
+        call(function(frame) {
+            var ptr = frame.alloc(out.length);
+            lib.randombytes_buf(ptr, out.length);
+            writeBack(frame, out, ptr);
+        });
+        return null;
+    };
+    api.randombytes = api.randombytes_buf;
+    api.randombytes_random = function() {
+        return lib.randombytes_random() >>> 0;
+    };
+    api.randombytes_uniform = function(upperBound) {
+        return lib.randombytes_uniform(number(upperBound, 'upperBound')) >>> 0;
+    };
+    api.randombytes_stir = function() {
+        lib.randombytes_stir();
+        return null;
+    };
+    api.randombytes_close = function() {
+        return lib.randombytes_close();
+    };
+    api.randombytes_SEEDBYTES = lib.randombytes_seedbytes();
+    api.randombytes_buf_deterministic = function(buffer, seed) {
+        var out = bytes(buffer, 'buf');
+        seed = bytes(seed, 'seed', api.randombytes_SEEDBYTES);
+        call(function(frame) {
+            var ptr = frame.alloc(out.length);
+            lib.randombytes_buf_deterministic(ptr, out.length, frame.input(seed));
+            writeBack(frame, out, ptr);
+        });
+        return buffer;
+    };
+
+    /*
+     * Hashing and MACs
+     */
+    api.crypto_hash = function(buffer) {
+        var m = bytes(buffer, 'buffer');
+        return call(function(frame) {
+            var out = frame.alloc(api.crypto_hash_BYTES);
+            lib.crypto_hash(out, frame.input(m), ull(m.length));
+            return frame.output(out, api.crypto_hash_BYTES);
+        });
+    };
+
+    // crypto_auth(message, key) and crypto_shorthash(message, key)
+    function keyed(name, size, keySize) {
+        api[name] = function(message, key) {
+            var m = bytes(message, 'message');
+            var k = bytes(key, 'key', keySize);
+            return call(function(frame) {
+                var out = frame.alloc(size);
+                if( lib[name](out, frame.input(m), ull(m.length), frame.input(k)) !== 0 ) {
+                    return null;
+                }
+                return frame.output(out, size);
+            });
+        };
+    }
+    keyed('crypto_auth', api.crypto_auth_BYTES, api.crypto_auth_KEYBYTES);
+    keyed('crypto_shorthash', api.crypto_shorthash_BYTES, api.crypto_shorthash_KEYBYTES);
+
+    api.crypto_auth_verify = function(token, message, key) {
+        var h = bytes(token, 'token', api.crypto_auth_BYTES);
+        var m = bytes(message, 'message');
+        var k = bytes(key, 'key', api.crypto_auth_KEYBYTES);
+        return call(function(frame) {
+            return lib.crypto_auth_verify(frame.input(h), frame.input(m), ull(m.length), frame.input(k));
+        });
+    };
+
+    // BLAKE2b states are 64 byte aligned
+    var STATE_ALIGN = 64;
+    var GENERICHASH_STATEBYTES = (lib.crypto_generichash_statebytes() + 63) & ~63;
+
+    api.crypto_generichash = function(size, message, key) {
+        number(size, 'size');
+        var m = bytesOrString(message, 'message');
+        var k = bytesOrNull(key, 'key');
+        return call(function(frame) {
+            var out = frame.alloc(size);
+            if( lib.crypto_generichash(out, size, frame.input(m), ull(m.length),
+                                       frame.input(k), k === null ? 0 : k.length) !== 0 ) {
+                return null;
+            }
+            return frame.output(out, size);
+        });
+    };
+
+    api.crypto_generichash_init = function(key, size) {
+        var k = bytesOrNull(key, 'key');
+        number(size, 'size');
+        return call(function(frame) {
+            var state = frame.alloc(GENERICHASH_STATEBYTES, STATE_ALIGN);
+            if( lib.crypto_generichash_init(state, frame.input(k), k === null ? 0 : k.length, size) !== 0 ) {
+                return null;
+            }
+            return frame.output(state, GENERICHASH_STATEBYTES);
+        });
+    };
+
+    api.crypto_generichash_update = function(state, message) {
+        var s = bytes(state, 'state');
+        var m = bytes(message, 'message');
+        return call(function(frame) {
+            var ptr = frame.input(s, STATE_ALIGN);
+            var ok = lib.crypto_generichash_update(ptr, frame.input(m), ull(m.length)) === 0;
+            writeBack(frame, s, ptr);
+            return ok;
+        });
+    };
+
+    api.crypto_generichash_final = function(state, size) {
+        var s = bytes(state, 'state');
+        number(size, 'size');
+        return call(function(frame) {
+            var ptr = frame.input(s, STATE_ALIGN);
+            var out = frame.alloc(size);
+            var ok = lib.crypto_generichash_final(ptr, out, size) === 0;
+            writeBack(frame, s, ptr);
+            return ok ? frame.output(out, size) : null;
+        });
+    };
+
+    /*
+     * Public key boxes
+     */
+    keypair('crypto_box', 'seed');
+
+    function box(name, pre) {
+        var MAC = api.crypto_box_MACBYTES;
+        var NONCE = api.crypto_box_NONCEBYTES;
+
+        function keys(frame, k) {
+            return pre ? [frame.input(k[0])] : [frame.input(k[0]), frame.input(k[1])];
+        }
+
+        function keyArgs(args) {
+            return pre ? [bytes(args[0], 'k', api.crypto_box_BEFORENMBYTES)] :
+                         [bytes(args[0], 'publicKey', api.crypto_box_PUBLICKEYBYTES),
+                          bytes(args[1], 'secretKey', api.crypto_box_SECRETKEYBYTES)];
+        }
+
+        var suffix = pre ? '_afternm' : '';
+
+        api['crypto_box_easy' + suffix] = function(message, nonce) {
+            var m = bytes(message, 'message');
+            var n = bytes(nonce, 'nonce', NONCE);
+            var k = keyArgs([].slice.call(arguments, 2));
+            return call(function(frame) {
+                var c = frame.alloc(m.length + MAC);
+                var rc = lib['crypto_box_easy' + suffix].apply(null,
+                    [c, frame.input(m), ull(m.length), frame.input(n)].concat(keys(frame, k)));
+                return rc === 0 ? frame.output(c, m.length + MAC) : null;
+            });
+        };
+
+        api['crypto_box_open_easy' + suffix] = function(cipherText, nonce) {
+            var c = bytes(cipherText, 'cipherText');
+            var n = bytes(nonce, 'nonce', NONCE);
+            var k = keyArgs([].slice.call(arguments, 2));
+            if( c.length < MAC ) {
+                throw new Error('argument cipherText must have a length of at least crypto_box_MACBYTES bytes');
+            }
+            return call(function(frame) {
+                var m = frame.alloc(c.length - MAC);
+                var rc = lib['crypto_box_open_easy' + suffix].apply(null,
+                    [m, frame.input(c), ull(c.length), frame.input(n)].concat(keys(frame, k)));
+                return rc === 0 ? frame.output(m, c.length - MAC) : null;
+            });
+        };
+
+        api['crypto_box_detached' + suffix] = function(message, nonce) {
+            var m = bytes(message, 'message');
+            var n = bytes(nonce, 'nonce', NONCE);
+            var k = keyArgs([].slice.call(arguments, 2));
+            return call(function(frame) {
+                var c = frame.alloc(m.length);
+                var mac = frame.alloc(MAC);
+                var rc = lib['crypto_box_detached' + suffix].apply(null,
+                    [c, mac, frame.input(m), ull(m.length), frame.input(n)].concat(keys(frame, k)));
+                if( rc !== 0 ) {
+                    return null;
+                }
+                return { cipherText: frame.output(c, m.length), mac: frame.output(mac, MAC) };
+            });
+        };
+
+        api['crypto_box_open_detached' + suffix] = function(cipherText, mac, nonce) {
+            var c = bytes(cipherText, 'cipherText');
+            var t = bytes(mac, 'mac', MAC);
+            var n = bytes(nonce, 'nonce', NONCE);
+            var k = keyArgs([].slice.call(arguments, 3));
+            return call(function(frame) {
+                var m = frame.alloc(c.length);
+                var rc = lib['crypto_box_open_detached' + suffix].apply(null,
+                    [m, frame.input(c), frame.input(t), ull(c.length), frame.input(n)].concat(keys(frame, k)));
+                return rc === 0 ? frame.output(m, c.length) : null;
+            });
+        };
+    }
+    box('crypto_box', false);
+    box('crypto_box', true);
+
+    api.crypto_box_beforenm = function(publicKey, secretKey) {
+        var pk = bytes(publicKey, 'publicKey', api.crypto_box_PUBLICKEYBYTES);
+        var sk = bytes(secretKey, 'secretKey', api.crypto_box_SECRETKEYBYTES);
+        return call(function(frame) {
+            var k = frame.alloc(api.crypto_box_BEFORENMBYTES);
+            if( lib.crypto_box_beforenm(k, frame.input(pk), frame.input(sk)) !== 0 ) {
+                return null;
+            }
+            return frame.output(k, api.crypto_box_BEFORENMBYTES);
+        });
+    };
+
+    api.crypto_box_seal = function(message, publicKey) {
+        var m = bytes(message, 'message');
+        var pk = bytes(publicKey, 'publicKey', api.crypto_box_PUBLICKEYBYTES);
+        return call(function(frame) {
+            var size = m.length + api.crypto_box_SEALBYTES;
+            var c = frame.alloc(size);
+            if( lib.crypto_box_seal(c, frame.input(m), ull(m.length), frame.input(pk)) !== 0 ) {
+                return null;
+            }
+            return frame.output(c, size);
+        });
+    };
+
+    api.crypto_box_seal_open = function(cipherText, publicKey, secretKey) {
+        var c = bytes(cipherText, 'cipherText');
+        var pk = bytes(publicKey, 'publicKey', api.crypto_box_PUBLICKEYBYTES);
+        var sk = bytes(secretKey, 'secretKey', api.crypto_box_SECRETKEYBYTES);
+        if( c.length < api.crypto_box_SEALBYTES ) {
+            return null;
+        }
+        return call(function(frame) {
+            var size = c.length - api.crypto_box_SEALBYTES;
+            var m = frame.alloc(size);
+            if( lib.crypto_box_seal_open(m, frame.input(c), ull(c.length), frame.input(pk), frame.input(sk)) !== 0 ) {
+                return null;
+            }
+            return frame.output(m, size);
+        });
+    };
+
+    /*
+     * Secret key boxes
+     */
+    var SECRETBOX_MAC = api.crypto_secretbox_MACBYTES;
+
+    function secretboxArgs(nonce, key) {
+        return [bytes(nonce, 'nonce', api.crypto_secretbox_NONCEBYTES),
+                bytes(key, 'key', api.crypto_secretbox_KEYBYTES)];
+    }
+
+    api.crypto_secretbox_easy = function(message, nonce, key) {
+        var m = bytes(message, 'message');
+        var nk = secretboxArgs(nonce, key);
+        return call(function(frame) {
+            var c = frame.alloc(m.length + SECRETBOX_MAC);
+            if( lib.crypto_secretbox_easy(c, frame.input(m), ull(m.length), frame.input(nk[0]), frame.input(nk[1])) !== 0 ) {
+                return null;
+            }
+            return frame.output(c, m.length + SECRETBOX_MAC);
+        });
+    };
+
+    api.crypto_secretbox_open_easy = function(cipherText, nonce, key) {
+        var c = bytes(cipherText, 'cipherText');
+        var nk = secretboxArgs(nonce, key);
+        if( c.length < SECRETBOX_MAC ) {
+            return null;
+        }
+        return call(function(frame) {
+            var m = frame.alloc(c.length - SECRETBOX_MAC);
+            if( lib.crypto_secretbox_open_easy(m, frame.input(c), ull(c.length), frame.input(nk[0]), frame.input(nk[1])) !== 0 ) {
+                return null;
+            }
+            return frame.output(m, c.length - SECRETBOX_MAC);
+        });
+    };
+
+    // Writes the MAC into `mac`, as the addon does
+    api.crypto_secretbox_detached = function(mac, message, nonce, key) {
+        var t = bytes(mac, 'mac', SECRETBOX_MAC);
+        var m = bytes(message, 'message');
+        var nk = secretboxArgs(nonce, key);
+        return call(function(frame) {
+            var c = frame.alloc(m.length);
+            var macPtr = frame.alloc(SECRETBOX_MAC);
+            if( lib.crypto_secretbox_detached(c, macPtr, frame.input(m), ull(m.length),
+                                              frame.input(nk[0]), frame.input(nk[1])) !== 0 ) {
+                return null;
+            }
+            writeBack(frame, t, macPtr);
+            return frame.output(c, m.length);
+        });
+    };
+
+    api.crypto_secretbox_open_detached = function(cipherText, mac, nonce, key) {
+        var c = bytes(cipherText, 'cipherText');
+        var t = bytes(mac, 'mac', SECRETBOX_MAC);
+        var nk = secretboxArgs(nonce, key);
+        return call(function(frame) {
+            var m = frame.alloc(c.length);
+            if( lib.crypto_secretbox_open_detached(m, frame.input(c), frame.input(t), ull(c.length),
+                                                   frame.input(nk[0]), frame.input(nk[1])) !== 0 ) {
+                return null;
+            }
+            return frame.output(m, c.length);
+        });
+    };
+
+    /*
+     * AEAD
+     */
+    ['chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'].forEach(function(algo) {
+        var prefix = 'crypto_aead_' + algo;
+        var ABYTES = api[prefix + '_ABYTES'];
+        var NPUB = api[prefix + '_NPUBBYTES'];
+        var KEY = api[prefix + '_KEYBYTES'];
+
+        function args(ad, nonce, key) {
+            return [bytesOrNull(ad, 'additional data'), bytes(nonce, 'nonce', NPUB), bytes(key, 'key', KEY)];
+        }
+
+        api[prefix + '_encrypt'] = function(message, ad, nonce, key) {
+            var m = bytes(message, 'message');
+            var a = args(ad, nonce, key);
+            return call(function(frame) {
+                var c = frame.alloc(m.length + ABYTES);
+                if( lib[prefix + '_encrypt'](c, 0, frame.input(m), ull(m.length), frame.input(a[0]),
+                                             ull(a[0] === null ? 0 : a[0].length), 0,
+                                             frame.input(a[1]), frame.input(a[2])) !== 0 ) {
+                    return null;
+                }
+                return frame.output(c, m.length + ABYTES);
+            });
+        };
+
+        api[prefix + '_decrypt'] = function(cipherText, ad, nonce, key) {
+            var c = bytes(cipherText, 'cipherText');
+            var a = args(ad, nonce, key);
+            if( c.length < ABYTES ) {
+                return null;
+            }
+            return call(function(frame) {
+                var m = frame.alloc(c.length - ABYTES);
+                if( lib[prefix + '_decrypt'](m, 0, 0, frame.input(c), ull(c.length), frame.input(a[0]),
+                                             ull(a[0] === null ? 0 : a[0].length),
+                                             frame.input(a[1]), frame.input(a[2])) !== 0 ) {
+                    return null;
+                }
+                return frame.output(m, c.length - ABYTES);
+            });
+        };
+
+        api[prefix + '_encrypt_detached'] = function(message, ad, nonce, key) {
+            var m = bytes(message, 'message');
+            var a = args(ad, nonce, key);
+            return call(function(frame) {
+                var c = frame.alloc(m.length);
+                var mac = frame.alloc(ABYTES);
+                if( lib[prefix + '_encrypt_detached'](c, mac, 0, frame.input(m), ull(m.length), frame.input(a[0]),
+                                                      ull(a[0] === null ? 0 : a[0].length), 0,
+                                                      frame.input(a[1]), frame.input(a[2])) !== 0 ) {
+                    return null;
+                }
+                return { cipherText: frame.output(c, m.length), mac: frame.output(mac, ABYTES) };
+            });
+        };
+
+        api[prefix + '_decrypt_detached'] = function(cipherText, mac, ad, nonce, key) {
+            var c = bytes(cipherText, 'cipherText');
+            var t = bytes(mac, 'mac', ABYTES);
+            var a = args(ad, nonce, key);
+            return call(function(frame) {
+                var m = frame.alloc(c.length);
+                if( lib[prefix + '_decrypt_detached'](m, 0, frame.input(c), ull(c.length), frame.input(t),
+                                                      frame.input(a[0]), ull(a[0] === null ? 0 : a[0].length),
+                                                      frame.input(a[1]), frame.input(a[2])) !== 0 ) {
+                    return null;
+                }
+                return frame.output(m, c.length);
+            });
+        };
+    });
+
+    /*
+     * Secret streams
+     */
+    var SS = 'crypto_secretstream_xchacha20poly1305';
+    var SS_STATEBYTES = lib[SS + '_statebytes']();
+
+    function stateArg(state) {
+        return bytes(state, 'state', SS_STATEBYTES);
+    }
+
+    api[SS + '_init_push'] = function(key) {
+        var k = bytes(key, 'key', api[SS + '_KEYBYTES']);
+        return call(function(frame) {
+            var state = frame.alloc(SS_STATEBYTES);
+            var header = frame.alloc(api[SS + '_HEADERBYTES']);
+            if( lib[SS + '_init_push'](state, header, frame.input(k)) !== 0 ) {
+                return null;
+            }
+            return {
+                state: frame.output(state, SS_STATEBYTES),
+                header: frame.output(header, api[SS + '_HEADERBYTES'])
+            };
+        });
+    };
+
+    api[SS + '_push'] = function(state, message, ad, tag) {
+        var s = stateArg(state);
+        var m = bytes(message, 'message');
+        var a = bytesOrNull(ad, 'additional data');
+        number(tag, 'tag');
+        return call(function(frame) {
+            var ptr = frame.input(s);
+            var c = frame.alloc(m.length + api[SS + '_ABYTES']);
+            var rc = lib[SS + '_push'](ptr, c, 0, frame.input(m), ull(m.length),
+                                       frame.input(a), ull(a === null ? 0 : a.length), tag);
+            writeBack(frame, s, ptr);
+            return rc === 0 ? frame.output(c, m.length + api[SS + '_ABYTES']) : null;
+        });
+    };
+
+    api[SS + '_init_pull'] = function(header, key) {
+        var h = bytes(header, 'header', api[SS + '_HEADERBYTES']);
+        var k = bytes(key, 'key', api[SS + '_KEYBYTES']);
+        return call(function(frame) {
+            var state = frame.alloc(SS_STATEBYTES);
+            if( lib[SS + '_init_pull'](state, frame.input(h), frame.input(k)) !== 0 ) {
+                return null;
+            }
+            return frame.output(state, SS_STATEBYTES);
+        });
+    };
+
+    api[SS + '_pull'] = function(state, cipherText, ad) {
+        var s = stateArg(state);
+        var c = bytes(cipherText, 'cipherText');
+        var a = bytesOrNull(ad, 'additional data');
+        if( c.length < api[SS + '_ABYTES'] ) {
+            throw new Error('argument cipher text must be at least ' + SS + '_ABYTES bytes long');
+        }
+        return call(function(frame) {
+            var ptr = frame.input(s);
+            var size = c.length - api[SS + '_ABYTES'];
+            var m = frame.alloc(size);
+            var tag = frame.alloc(1);
+            var rc = lib[SS + '_pull'](ptr, m, 0, tag, frame.input(c), ull(c.length),
+                                       frame.input(a), ull(a === null ? 0 : a.length));
+            writeBack(frame, s, ptr);
+            if( rc !== 0 ) {
+                return null;
+            }
+            return { message: frame.output(m, size), tag: view(tag, 1)[0] };
+        });
+    };
+
+    api[SS + '_rekey'] = function(state) {
+        var s = stateArg(state);
+        call(function(frame) {
+            var ptr = frame.input(s);
+            lib[SS + '_rekey'](ptr);
+            writeBack(frame, s, ptr);
+        });
+    };
+
+    /*
+     * Signatures
+     */
+    keypair('crypto_sign', 'seed');
+    var SIGN = api.crypto_sign_BYTES;
+    var SIGN_STATEBYTES = lib.crypto_sign_statebytes();
+
+    function signKey(key) {
+        return bytes(key, 'secretKey', api.crypto_sign_SECRETKEYBYTES);
+    }
+
+    function verifyKey(key) {
+        return bytes(key, 'publicKey', api.crypto_sign_PUBLICKEYBYTES);
+    }
+
+    api.crypto_sign = function(message, secretKey) {
+        var m = bytesOrString(message, 'message');
+        var sk = signKey(secretKey);
+        return call(function(frame) {
+            var sm = frame.alloc(m.length + SIGN);
+            if( lib.crypto_sign(sm, 0, frame.input(m), ull(m.length), frame.input(sk)) !== 0 ) {
+                return null;
+            }
+            return frame.output(sm, m.length + SIGN);
+        });
+    };
+
+    api.crypto_sign_open = function(signedMessage, publicKey) {
+        var sm = bytes(signedMessage, 'signedMessage');
+        var pk = verifyKey(publicKey);
+        if( sm.length < SIGN ) {
+            return null;
+        }
+        return call(function(frame) {
+            var m = frame.alloc(sm.length);
+            if( lib.crypto_sign_open(m, 0, frame.input(sm), ull(sm.length), frame.input(pk)) !== 0 ) {
+                return null;
+            }
+            return frame.output(m, sm.length - SIGN);
+        });
+    };
+
+    api.crypto_sign_detached = function(message, secretKey) {
+        var m = bytesOrString(message, 'message');
+        var sk = signKey(secretKey);
+        return call(function(frame) {
+            var sig = frame.alloc(SIGN);
+            if( lib.crypto_sign_detached(sig, 0, frame.input(m), ull(m.length), frame.input(sk)) !== 0 ) {
+                return null;
+            }
+            return frame.output(sig, SIGN);
+        });
+    };
+
+    api.crypto_sign_verify_detached = function(signature, message, publicKey) {
+        var sig = bytes(signature, 'signature', SIGN);
+        var m = bytesOrString(message, 'message');
+        var pk = verifyKey(publicKey);
+        return call(function(frame) {
+            return lib.crypto_sign_verify_detached(frame.input(sig), frame.input(m), ull(m.length), frame.input(pk)) === 0;
+        });
+    };
+
+    api.crypto_sign_init = function() {
+        return call(function(frame) {
+            var state = frame.alloc(SIGN_STATEBYTES);
+            if( lib.crypto_sign_init(state) !== 0 ) {
+                return null;
+            }
+            return frame.output(state, SIGN_STATEBYTES);
+        });
+    };
+
+    api.crypto_sign_update = function(state, message) {
+        var s = bytes(state, 'state', SIGN_STATEBYTES);
+        var m = bytes(message, 'message');
+        return call(function(frame) {
+            var ptr = frame.input(s);
+            var ok = lib.crypto_sign_update(ptr, frame.input(m), ull(m.length)) === 0;
+            writeBack(frame, s, ptr);
+            return ok;
+        });
+    };
+
+    api.crypto_sign_final_create = function(state, secretKey) {
+        var s = bytes(state, 'state', SIGN_STATEBYTES);
+        var sk = signKey(secretKey);
+        return call(function(frame) {
+            var ptr = frame.input(s);
+            var sig = frame.alloc(SIGN);
+            var rc = lib.crypto_sign_final_create(ptr, sig, 0, frame.input(sk));
+            writeBack(frame, s, ptr);
+            return rc === 0 ? frame.output(sig, SIGN) : null;
+        });
+    };
+
+    api.crypto_sign_final_verify = function(state, signature, publicKey) {
+        var s = bytes(state, 'state', SIGN_STATEBYTES);
+        var sig = bytes(signature, 'signature', SIGN);
+        var pk = verifyKey(publicKey);
+        return call(function(frame) {
+            var ptr = frame.input(s);
+            var rc = lib.crypto_sign_final_verify(ptr, frame.input(sig), frame.input(pk));
+            writeBack(frame, s, ptr);
+            return rc === 0;
+        });
+    };
+
+    function convert(name, size, inSize, argName) {
+        api[name] = function(key) {
+            var k = bytes(key, argName, inSize);
+            return call(function(frame) {
+                var out = frame.alloc(size);
+                if( lib[name](out, frame.input(k)) !== 0 ) {
+                    return null;
+                }
+                return frame.output(out, size);
+            });
+        };
+    }
+    convert('crypto_sign_ed25519_pk_to_curve25519', api.crypto_box_PUBLICKEYBYTES,
+            api.crypto_sign_PUBLICKEYBYTES, 'ed25519_pk');
+    convert('crypto_sign_ed25519_sk_to_curve25519', api.crypto_box_SECRETKEYBYTES,
+            api.crypto_sign_SECRETKEYBYTES, 'ed25519_sk');
+
+    /*
+     * Key exchange and derivation
+     */
+    api.crypto_scalarmult_base = function(n) {
+        var s = bytes(n, 'n', api.crypto_scalarmult_SCALARBYTES);
+        return call(function(frame) {
+            var q = frame.alloc(api.crypto_scalarmult_BYTES);
+            if( lib.crypto_scalarmult_base(q, frame.input(s)) !== 0 ) {
+                return null;
+            }
+            return frame.output(q, api.crypto_scalarmult_BYTES);
+        });
+    };
+
+    api.crypto_scalarmult = function(n, p) {
+        var s = bytes(n, 'n', api.crypto_scalarmult_SCALARBYTES);
+        var point = bytes(p, 'p', api.crypto_scalarmult_BYTES);
+        return call(function(frame) {
+            var q = frame.alloc(api.crypto_scalarmult_BYTES);
+            if( lib.crypto_scalarmult(q, frame.input(s), frame.input(point)) !== 0 ) {
+                return null;
+            }
+            return frame.output(q, api.crypto_scalarmult_BYTES);
+        });
+    };
+
+    keypair('crypto_kx', 'seed');
+
+    function sessionKeys(side, own, ownKey, other) {
+        var SESSION = api.crypto_kx_SESSIONKEYBYTES;
+        api['crypto_kx_' + side + '_session_keys'] = function(publicKey, secretKey, otherKey) {
+            var pk = bytes(publicKey, own, api.crypto_kx_PUBLICKEYBYTES);
+            var sk = bytes(secretKey, ownKey, api.crypto_kx_SECRETKEYBYTES);
+            var opk = bytes(otherKey, other, api.crypto_kx_PUBLICKEYBYTES);
+            return call(function(frame) {
+                var rx = frame.alloc(SESSION);
+                var tx = frame.alloc(SESSION);
+                if( lib['crypto_kx_' + side + '_session_keys'](rx, tx, frame.input(pk), frame.input(sk),
+                                                               frame.input(opk)) !== 0 ) {
+                    return null;
+                }
+                return { rx: frame.output(rx, SESSION), tx: frame.output(tx, SESSION) };
+            });
+        };
+    }
+    sessionKeys('client', 'clientPublicKey', 'clientSecretKey', 'serverPublicKey');
+    sessionKeys('server', 'serverPublicKey', 'serverSecretKey', 'clientPublicKey');
+
+    api.crypto_kdf_derive_from_key = function(subkeyLength, subkeyId, context, key) {
+        number(subkeyLength, 'subkeyLength');
+        if( subkeyLength < api.crypto_kdf_BYTES_MIN || subkeyLength > api.crypto_kdf_BYTES_MAX ) {
+            throw new Error('argument subkeyLength must be between crypto_kdf_BYTES_MIN and crypto_kdf_BYTES_MAX');
+        }
+        var id = typeof subkeyId === 'bigint' ? subkeyId : BigInt(number(subkeyId, 'subkeyId'));
+        var ctx = typeof context === 'string' ? Buffer.from(context) : bytes(context, 'context');
+        if( ctx.length !== api.crypto_kdf_CONTEXTBYTES ) {
+            throw new Error('argument context must be crypto_kdf_CONTEXTBYTES bytes long');
+        }
+        var k = bytes(key, 'key', api.crypto_kdf_KEYBYTES);
+        return call(function(frame) {
+            var out = frame.alloc(subkeyLength);
+            if( lib.crypto_kdf_derive_from_key(out, subkeyLength, id, frame.input(ctx), frame.input(k)) !== 0 ) {
+                return null;
+            }
+            return frame.output(out, subkeyLength);
+        });
+    };
+
+    api.crypto_core_hchacha20 = function(input, key, c) {
+        var i = bytes(input, 'in', api.crypto_core_hchacha20_INPUTBYTES);
+        var k = bytes(key, 'key', api.crypto_core_hchacha20_KEYBYTES);
+        var constant = bytesOrNull(c, 'c', api.crypto_core_hchacha20_CONSTBYTES);
+        return call(function(frame) {
+            var out = frame.alloc(api.crypto_core_hchacha20_OUTPUTBYTES);
+            if( lib.crypto_core_hchacha20(out, frame.input(i), frame.input(k), frame.input(constant)) !== 0 ) {
+                return null;
+            }
+            return frame.output(out, api.crypto_core_hchacha20_OUTPUTBYTES);
+        });
+    };
+
+    /*
+     * Password hashing
+     */
+    var STRBYTES = api.crypto_pwhash_STRBYTES;
+
+    api.crypto_pwhash = function(outLen, password, salt, opsLimit, memLimit, alg) {
+        if( number(outLen, 'outLen') === 0 ) {
+            throw new Error('output buffer length must be bigger than 0.');
+        }
+        var p = bytes(password, 'password');
+        var s = bytes(salt, 'salt', api.crypto_pwhash_SALTBYTES);
+        return call(function(frame) {
+            var out = frame.alloc(outLen);
+            if( lib.crypto_pwhash(out, ull(outLen), frame.input(p), ull(p.length), frame.input(s),
+                                  ull(number(opsLimit, 'opsLimit')), number(memLimit, 'memLimit'),
+                                  number(alg, 'alg')) !== 0 ) {
+                return null;
+            }
+            return frame.output(out, outLen);
+        });
+    };
+
+    function pwhashStr(name, password, opsLimit, memLimit, alg) {
+        var p = bytes(password, 'password');
+        return call(function(frame) {
+            var out = frame.alloc(STRBYTES);
+            var args = [out, frame.input(p), ull(p.length), ull(number(opsLimit, 'opsLimit')),
+                        number(memLimit, 'memLimit')];
+            if( alg !== undefined ) {
+                args.push(number(alg, 'alg'));
+            }
+            if( lib[name].apply(null, args) !== 0 ) {
+                return null;
+            }
+            return frame.output(out, STRBYTES);
+        });
+    }
+
+    api.crypto_pwhash_str = function(password, opsLimit, memLimit) {
+        return pwhashStr('crypto_pwhash_str', password, opsLimit, memLimit);
+    };
+
+    api.crypto_pwhash_str_alg = function(password, opsLimit, memLimit, alg) {
+        return pwhashStr('crypto_pwhash_str_alg', password, opsLimit, memLimit, alg);
+    };
+
+    api.crypto_pwhash_str_verify = function(hash, password) {
+        var h = bytes(hash, 'hash', STRBYTES);
+        var p = bytes(password, 'password');
+        return call(function(frame) {
+            return lib.crypto_pwhash_str_verify(frame.input(h), frame.input(p), ull(p.length)) === 0;
+        });
+    };
+
+    // Same result as the addon: true when the call returns 0
+    api.crypto_pwhash_str_needs_rehash = function(hash, opsLimit, memLimit) {
+        var h = bytes(hash, 'hash', STRBYTES);
+        return call(function(frame) {
+            return lib.crypto_pwhash_str_needs_rehash(frame.input(h), ull(number(opsLimit, 'opsLimit')),
+                                                      number(memLimit, 'memLimit')) === 0;
+        });
+    };
+
+    return api;
+}
+
+/**
+ * Load `prebuilds/wasm32/sodium.wasm`
+ *
+ * @returns {Object} the `sodium.api` object
+ */
+function load() {
+    return wrap(instantiate(prebuilds.wasm()));
+}
+
+module.exports.load = load;
+module.exports.wrap = wrap;
@@ -0,0 +1,130 @@
+/**
+ * # BlockingWatchdog
+ * Find synchronous crypto calls that stall the event loop
+ *
+ * A synchronous binding blocks the event loop for as long as it runs, and
+ * one-shot hashes, `crypto_stream` or `crypto_box` over large inputs can run
+ * for milliseconds. The watchdog listens to the `sodium:crypto` diagnostics
+ * channel, see lib/diagnostics.js, and reports every synchronous call that
+ * took longer than a threshold, with its primitive and input size.
+ *
+ *     var watchdog = new sodium.BlockingWatchdog({ thresholdMs: 5 }, function(report) {
+ *         // { primitive: 'crypto_hash_sha256', size: 67108864, duration: 212.4,
+ *         //   asyncAlternative: 'crypto_hash_sha256_async' }
+ *     });
+ *     ...
+ *     watchdog.stats();   // { crypto_hash_sha256: { count, totalMs, maxMs, maxSize } }
+ *     watchdog.stop();
+ *
+ * Calls are not rerouted: a synchronous caller expects its result, not a
+ * Promise. `asyncAlternative` names the binding to switch to, if there is one.
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var dc;
+try {
+    dc = require('diagnostics_channel');
+}
+catch (e) {
+    dc = null;
+}
+
+var binding = require('./binding');
+var diagnostics = require('./diagnostics');
+var CHANNEL_NAME = diagnostics.CHANNEL_NAME;
+
+diagnostics.install(binding);
+
+/** Calls longer than this many milliseconds are reported by default */
+var DEFAULT_THRESHOLD_MS = 10;
+
+// Async binding that does the same work as `primitive`, if any
+function asyncAlternative(primitive) {
+    var name = primitive + '_async';
+    return typeof binding[name] === 'function' ? name : null;
+}
+
+/**
+ * @param {Object} [options]
+ * @param {Number} [options.thresholdMs] report calls longer than this, 10 by default
+ * @param {Function} [onBlock] called with a report of each call over the threshold
+ * @constructor
+ */
+function BlockingWatchdog(options, onBlock) {
+    if (typeof options === 'function') {
+        onBlock = options;
+        options = {};
+    }
+    options = options || {};
+
+    if (!dc) {
+        throw new Error('BlockingWatchdog needs diagnostics_channel');
+    }
+
+    this.thresholdMs = options.thresholdMs !== undefined ? options.thresholdMs : DEFAULT_THRESHOLD_MS;
+    if (typeof this.thresholdMs !== 'number' || !(this.thresholdMs >= 0)) {
+        throw new TypeError('options.thresholdMs must be a positive number of milliseconds');
+    }
+    this.onBlock = onBlock || null;
+    this.offenders = {};
+
+    var self = this;
+    this.listener = function(message) {
+        if (!message.async && message.duration >= self.thresholdMs) {
+            self.record(message);
+        }
+    };
+    dc.subscribe(CHANNEL_NAME, this.listener);
+}
+
+BlockingWatchdog.prototype.record = function(message) {
+    var stats = this.offenders[message.primitive];
+    if (!stats) {
+        stats = this.offenders[message.primitive] = { count: 0, totalMs: 0, maxMs: 0, maxSize: 0 };
+    }
+    stats.count++;
+    stats.totalMs += message.duration;
+    stats.maxMs = Math.max(stats.maxMs, message.duration);
+    stats.maxSize = Math.max(stats.maxSize, message.size);
+
+    if (this.onBlock) {
+        this.onBlock({
+            primitive: message.primitive,
+            size: message.size,
+            duration: message.duration,
+            asyncAlternative: asyncAlternative(message.primitive)
+        });
+    }
+};
+
+/**
+ * Calls over the threshold so far, by primitive
+ * @returns {Object} `{ crypto_hash_sha256: { count, totalMs, maxMs, maxSize }, ... }`
+ */
+BlockingWatchdog.prototype.stats = function() {
+    var result = {};
+    var offenders = this.offenders;
+    Object.keys(offenders).forEach(function(primitive) {
+        result[primitive] = Object.assign({}, offenders[primitive]);
+    });
+    return result;
+};
+
+/** Forget the calls counted so far */
+BlockingWatchdog.prototype.reset = function() {
+    this.offenders = {};
+};
+
+/** Stop watching. Without other subscribers, calls cost nothing again */
+BlockingWatchdog.prototype.stop = function() {
+    if (this.listener) {
+        dc.unsubscribe(CHANNEL_NAME, this.listener);
+        this.listener = null;
+    }
+};
+
+module.exports = BlockingWatchdog;
+module.exports.DEFAULT_THRESHOLD_MS = DEFAULT_THRESHOLD_MS;
@@ -0,0 +1,436 @@
+/**
+ * # WHATWG streams
+ * `TransformStream`s over the native states, for `fetch` bodies and other
+ * Web Streams
+ *
+ * Chunks can be any `Uint8Array`, Buffers included, and are handed to the
+ * addon as they are: nothing is converted to a Buffer or copied except to
+ * join the bytes of a chunk that spans writes. Output chunks are Buffers,
+ * which are `Uint8Array`s. The formats are those of the node streams:
+ *
+ *  - `SecretStreamEncryptor` and `SecretStreamDecryptor` read and write the
+ *    format of `sodium.SecretStream`
+ *  - `SeekableEncryptor` and `SeekableDecryptor` read and write
+ *    `sodium.Seekable` containers
+ *  - `HashStream` and `HashPassThrough` hash like `sodium.Hash.HashStream`
+ *
+ *     var response = await fetch(url);
+ *     var plain = response.body.pipeThrough(new sodium.WebStreams.SecretStreamDecryptor(key));
+ *
+ * @name node-sodium
+ */
+/* jslint node: true */
+'use strict';
+
+var TransformStream = require('stream/web').TransformStream;
+var binding = require('./binding');
+var seekable = require('./seekable');
+var algorithms = require('./hash-stream').algorithms;
+
+var ABYTES = binding.crypto_secretstream_xchacha20poly1305_ABYTES;
+var HEADERBYTES = binding.crypto_secretstream_xchacha20poly1305_HEADERBYTES;
+var KEYBYTES = binding.crypto_secretstream_xchacha20poly1305_KEYBYTES;
+var TAG_MESSAGE = binding.crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+var TAG_FINAL = binding.crypto_secretstream_xchacha20poly1305_TAG_FINAL;
+var AEAD_ABYTES = binding.crypto_aead_xchacha20poly1305_ietf_ABYTES;
+
+/** Default plain text bytes per encrypted chunk */
+var DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+/**
+ * FIFO of byte arrays that hands out byte ranges as views when it can
+ * @constructor
+ */
+function ByteQueue() {
+    this.list = [];
+    this.length = 0;
+}
+
+ByteQueue.prototype.append = function(bytes) {
+    if( !(bytes instanceof Uint8Array) ) {
+        throw new TypeError('chunks must be Uint8Arrays');
+    }
+    if( bytes.length ) {
+        this.list.push(bytes);
+        this.length += bytes.length;
+    }
+};
+
+/** Remove and return the first `n` bytes */
+ByteQueue.prototype.take = function(n) {
+    var first = this.list[0];
+    var out;
+
+    if( n === 0 ) {
+        return new Uint8Array(0);
+    }
+
+    if( first.length === n ) {
+        out = this.list.shift();
+    }
+    else if( first.length > n ) {
+        out = first.subarray(0, n);
+        this.list[0] = first.subarray(n);
+    }
+    else {
+        out = new Uint8Array(n);
+        var pos = 0;
+        while( pos < n ) {
+            var b = this.list[0];
+            var len = Math.min(b.length, n - pos);
+            out.set(len === b.length ? b : b.subarray(0, len), pos);
+            pos += len;
+            if( len === b.length ) {
+                this.list.shift();
+            }
+            else {
+                this.list[0] = b.subarray(len);
+            }
+        }
+    }
+    this.length -= n;
+    return out;
+};
+
+/**
+ * Construct a TransformStream for the subclass `Ctor` called with `new`
+ * @returns {TransformStream}
+ */
+function construct(Ctor, newTarget, transformer) {
+    return Reflect.construct(TransformStream, [transformer], newTarget || Ctor);
+}
+
+function inherit(Ctor) {
+    Object.setPrototypeOf(Ctor.prototype, TransformStream.prototype);
+    Object.setPrototypeOf(Ctor, TransformStream);
+}
+
+function chunkSizeOf(options) {
+    var chunkSize = (options || {}).chunkSize || DEFAULT_CHUNK_SIZE;
+    if( typeof chunkSize !== 'number' || chunkSize < 1 || chunkSize % 1 !== 0 ) {
+        throw new RangeError('chunkSize must be a positive whole number');
+    }
+    return chunkSize;
+}
+
+function checkSecretStreamKey(key) {
+    if( !(key instanceof Uint8Array) || key.length !== KEYBYTES ) {
+        throw new TypeError('key must be a ' + KEYBYTES + ' byte Uint8Array');
+    }
+}
+
+/**
+ * Encrypts everything written to it with crypto_secretstream, in the format
+ * of `SecretStream.Encryptor`: the header, then chunks of `chunkSize` bytes
+ * of plain text, the last one tagged `TAG_FINAL`
+ *
+ * @param {Uint8Array} key              crypto_secretstream_xchacha20poly1305_KEYBYTES long
+ * @param {Object} [options]
+ * @param {Number} [options.chunkSize]  plain text bytes per chunk. Default 64KB
+ * @constructor
+ */
+function SecretStreamEncryptor(key, options) {
+    checkSecretStreamKey(key);
+    var chunkSize = chunkSizeOf(options);
+    var queue = new ByteQueue();
+    var state = null;
+
+    var self = construct(SecretStreamEncryptor, new.target, {
+        start: function(controller) {
+            var s = binding.crypto_secretstream_xchacha20poly1305_init_push(key);
+            state = s.state;
+            controller.enqueue(s.header);
+        },
+        transform: function(chunk, controller) {
+            queue.append(chunk);
+            // Keep at least one byte back so the final chunk is never empty
+            // unless the whole stream is
+            while( queue.length > chunkSize ) {
+                controller.enqueue(binding.crypto_secretstream_xchacha20poly1305_push(
+                    state, queue.take(chunkSize), null, TAG_MESSAGE));
+            }
+        },
+        flush: function(controller) {
+            controller.enqueue(binding.crypto_secretstream_xchacha20poly1305_push(
+                state, queue.take(queue.length), null, TAG_FINAL));
+            binding.memzero(state);
+        }
+    });
+
+    /** Plain text bytes per chunk */
+    self.chunkSize = chunkSize;
+    return self;
+}
+inherit(SecretStreamEncryptor);
+
+/**
+ * Decrypts the output of a `SecretStreamEncryptor` or of
+ * `SecretStream.Encryptor`. Errors the stream if a chunk fails
+ * authentication, if chunks were reordered or if the input ends before the
+ * final chunk.
+ *
+ * @param {Uint8Array} key              the key of the encryptor
+ * @param {Object} [options]
+ * @param {Number} [options.chunkSize]  must match the encryptor's chunkSize
+ * @constructor
+ */
+function SecretStreamDecryptor(key, options) {
+    checkSecretStreamKey(key);
+    var chunkSize = chunkSizeOf(options);
+    var frameSize = chunkSize + ABYTES;
+    var queue = new ByteQueue();
+    var state = null;
+
+    function pull(frame) {
+        var r = binding.crypto_secretstream_xchacha20poly1305_pull(state, frame, null);
+        if( !r ) {
+            throw new Error('secretstream chunk failed authentication');
+        }
+        return r;
+    }
+
+    var self = construct(SecretStreamDecryptor, new.target, {
+        transform: function(chunk, controller) {
+            queue.append(chunk);
+            if( !state ) {
+                if( queue.length < HEADERBYTES ) {
+                    return;
+                }
+                state = binding.crypto_secretstream_xchacha20poly1305_init_pull(queue.take(HEADERBYTES), key);
+                if( !state ) {
+                    throw new Error('invalid secretstream header');
+                }
+            }
+            while( queue.length > frameSize ) {
+                var r = pull(queue.take(frameSize));
+                if( r.tag === TAG_FINAL ) {
+                    throw new Error('secretstream data after the final chunk');
+                }
+                controller.enqueue(r.message);
+            }
+        },
+        flush: function(controller) {
+            if( !state || queue.length < ABYTES ) {
+                throw new Error('secretstream truncated');
+            }
+            var r = pull(queue.take(queue.length));
+            if( r.tag !== TAG_FINAL ) {
+                throw new Error('secretstream truncated');
+            }
+            binding.memzero(state);
+            controller.enqueue(r.message);
+        }
+    });
+
+    /** Plain text bytes per chunk */
+    self.chunkSize = chunkSize;
+    return self;
+}
+inherit(SecretStreamDecryptor);
+
+/**
+ * Writes a `Seekable` container of a message of `length` bytes: the header,
+ * then the chunks. The whole chunks that have arrived are sealed together in
+ * one native call, on `threads` threads.
+ *
+ * @param {Uint8Array} key     crypto_aead_xchacha20poly1305_ietf_KEYBYTES long
+ * @param {Number} length      plain text bytes that will be written
+ * @param {Object} [options]   `chunkSize` and `threads`, as for `Seekable.Encryptor`
+ * @constructor
+ */
+function SeekableEncryptor(key, length, options) {
+    var encryptor = new seekable.Encryptor(key, length, options);
+    var chunkSize = encryptor.chunkSize;
+    var queue = new ByteQueue();
+    var offset = 0;
+
+    function seal(controller, bytes) {
+        if( offset + bytes > length ) {
+            throw new RangeError('more than the ' + length + ' bytes of the message were written');
+        }
+        var plain = queue.take(bytes);
+        controller.enqueue(encryptor.encryptRange(offset, plain));
+        offset += bytes;
+    }
+
+    var self = construct(SeekableEncryptor, new.target, {
+        start: function(controller) {
+            controller.enqueue(encryptor.header);
+        },
+        transform: function(chunk, controller) {
+            queue.append(chunk);
+            var whole = queue.length - queue.length % chunkSize;
+            if( whole > 0 ) {
+                seal(controller, whole);
+            }
+        },
+        flush: function(controller) {
+            if( queue.length > 0 || length === 0 ) {
+                seal(controller, queue.length);
+            }
+            if( offset !== length ) {
+                throw new RangeError('the stream ended after ' + offset + ' of the ' + length + ' bytes of the message');
+            }
+        }
+    });
+
+    /** The container being written, for `cipherRange()` and `size` */
+    self.container = encryptor;
+    return self;
+}
+inherit(SeekableEncryptor);
+
+/**
+ * Reads a whole `Seekable` container and writes its plain text. The whole
+ * chunks that have arrived are opened together in one native call, on
+ * `threads` threads.
+ *
+ * @param {Uint8Array} key     the key of the encryptor
+ * @param {Object} [options]   `threads`, as for `Seekable.Decryptor`
+ * @constructor
+ */
+function SeekableDecryptor(key, options) {
+    var queue = new ByteQueue();
+    var decryptor = null;
+    var frame = 0;
+    var chunk = 0;     // next chunk to open
+
+    // Open the next `count` chunks, the last one of the container included
+    // only when `count` runs to it
+    function open(controller, count) {
+        var offset = chunk * decryptor.chunkSize;
+        var length = Math.min(offset + count * decryptor.chunkSize, decryptor.length) - offset;
+        var range = decryptor.cipherRange(offset, length);
+        controller.enqueue(decryptor.decryptRange(offset, length, queue.take(range.end - range.start)));
+        chunk += count;
+    }
+
+    return construct(SeekableDecryptor, new.target, {
+        transform: function(bytes, controller) {
+            queue.append(bytes);
+            if( !decryptor ) {
+                if( queue.length < seekable.HEADERBYTES ) {
+                    return;
+                }
+                decryptor = new seekable.Decryptor(key, Buffer.from(queue.take(seekable.HEADERBYTES)), options);
+                frame = decryptor.chunkSize + AEAD_ABYTES;
+            }
+            // The last chunk is left for flush, which knows it is whole
+            var count = Math.min(Math.floor(queue.length / frame), decryptor.chunks - chunk - 1);
+            if( count > 0 ) {
+                open(controller, count);
+            }
+        },
+        flush: function(controller) {
+            if( !decryptor ) {
+                throw new Error('seekable container truncated');
+            }
+            // Every chunk opened so far was a whole frame
+            var remaining = decryptor.size - seekable.HEADERBYTES - chunk * frame;
+            if( queue.length !== remaining ) {
+                throw new Error(queue.length < remaining ? 'seekable container truncated' : 'seekable container extended');
+            }
+            if( decryptor.length > 0 ) {
+                open(controller, decryptor.chunks - chunk);
+            }
+        }
+    });
+}
+inherit(SeekableDecryptor);
+
+/**
+ * Hashes everything written to it. The readable side carries one chunk,
+ * the digest, once the writable side closes.
+ *
+ * @param {String} algorithm  'generichash', 'sha256' or 'sha512'
+ * @param {Object} [options]
+ *   - `key` (Uint8Array): generichash key, optional
+ *   - `outputLength` (Number): generichash digest size. Default crypto_generichash_BYTES
+ * @constructor
+ */
+function HashStream(algorithm, options) {
+    var hash = hasher(algorithm, options);
+    return construct(HashStream, new.target, {
+        transform: function(chunk) {
+            hash.update(chunk);
+        },
+        flush: function(controller) {
+            controller.enqueue(hash.digest());
+        }
+    });
+}
+inherit(HashStream);
+
+/**
+ * Hashes everything that flows through, passing the chunks on unchanged.
+ * `digest` is a Promise for the digest, settled when the stream closes or
+ * fails.
+ *
+ * @param {String} algorithm  see HashStream
+ * @param {Object} [options]  see HashStream
+ * @constructor
+ */
+function HashPassThrough(algorithm, options) {
+    var hash = hasher(algorithm, options);
+    var settle = {};
+    var digest = new Promise(function(resolve, reject) {
+        settle.resolve = resolve;
+        settle.reject = reject;
+    });
+    // Nobody may ever wait for it
+    digest.catch(function() {});
+
+    var self = construct(HashPassThrough, new.target, {
+        transform: function(chunk, controller) {
+            hash.update(chunk);
+            controller.enqueue(chunk);
+        },
+        flush: function() {
+            settle.resolve(hash.digest());
+        },
+        cancel: function(reason) {
+            settle.reject(reason);
+        }
+    });
+
+    /** Promise for the digest */
+    self.digest = digest;
+    return self;
+}
+inherit(HashPassThrough);
+
+// Incremental hash over a native state, see hash-stream.js
+function hasher(algorithm, options) {
+    var algo = algorithms[algorithm];
+    if( !algo ) {
+        throw new Error('unknown hash algorithm ' + algorithm);
+    }
+    options = options || {};
+    var params = {
+        key: options.key,
+        outputLength: options.outputLength || algo.outputLength
+    };
+    var state = algo.init(params);
+
+    return {
+        update: function(chunk) {
+            if( !(chunk instanceof Uint8Array) ) {
+                throw new TypeError('chunks must be Uint8Arrays');
+            }
+            algo.update(state, chunk);
+        },
+        digest: function() {
+            var result = algo.final(state, params);
+            binding.memzero(state);
+            return result;
+        }
+    };
+}
+
+module.exports.SecretStreamEncryptor = SecretStreamEncryptor;
+module.exports.SecretStreamDecryptor = SecretStreamDecryptor;
+module.exports.SeekableEncryptor = SeekableEncryptor;
+module.exports.SeekableDecryptor = SeekableDecryptor;
+module.exports.HashStream = HashStream;
+module.exports.HashPassThrough = HashPassThrough;
+module.exports.DEFAULT_CHUNK_SIZE = DEFAULT_CHUNK_SIZE;
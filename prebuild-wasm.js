@@ -0,0 +1,75 @@
+/**
+ * Build the WebAssembly fallback, `prebuilds/wasm32/sodium.wasm`
+ *
+ *     node prebuild-wasm.js
+ *
+ * Compiles the bundled libsodium with Emscripten (`emcc` in the PATH) to a
+ * standalone WebAssembly module with SIMD, exporting the functions of
+ * `exported_functions.js` for lib/wasm.js. libsodium 1.0.16 has no
+ * WebAssembly kernels of its own: its SSE2 to SSE4.1 code is built with
+ * `-msimd128`, which Emscripten turns into WebAssembly SIMD, and
+ * `SODIUM_WASM_STANDALONE` takes random bytes from the host instead of
+ * Emscripten's JavaScript glue. Node 16.4 or later runs the module.
+ *
+ * The result is the same on every host: build it once and ship it with
+ * the prebuilt binaries.
+ *
+ * @License MIT
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var path = require('path');
+var execSync = require('child_process').execSync;
+var prebuilds = require('./lib/prebuilds');
+
+var SOURCE = path.join(__dirname, 'deps', 'libsodium');
+var BUILD = path.join(__dirname, 'build', 'wasm');
+
+var CFLAGS = '-O3 -msimd128 -msse4.1 -DSODIUM_WASM_STANDALONE';
+
+function sh(cmd, cwd) {
+    console.log('> ' + cmd);
+    execSync(cmd, { stdio: 'inherit', cwd: cwd || __dirname });
+}
+
+// The standard list of exported_functions.js, without the leading `_` some
+// entries have
+function exportedFunctions() {
+    var text = fs.readFileSync(path.join(__dirname, 'exported_functions.js'), 'utf8');
+    var list = /EXPORTED_FUNCTIONS_STANDARD=(\[[^\]]*\])/.exec(text);
+    if( !list ) {
+        throw new Error('no EXPORTED_FUNCTIONS_STANDARD in exported_functions.js');
+    }
+    return JSON.parse(list[1]).map(function(name) {
+        return name.replace(/^_/, '');
+    });
+}
+
+try {
+    execSync('emcc --version', { stdio: 'ignore' });
+} catch (e) {
+    console.log('emcc not found, install and activate the Emscripten SDK first');
+    process.exit(1);
+}
+
+// Out of tree, so the native build of deps/libsodium is left alone
+fs.rmSync(BUILD, { recursive: true, force: true });
+fs.mkdirSync(path.dirname(BUILD), { recursive: true });
+fs.cpSync(SOURCE, BUILD, { recursive: true });
+
+sh('./autogen.sh', BUILD);
+sh('emconfigure ./configure --disable-shared --without-pthreads --disable-ssp --disable-asm ' +
+   '--disable-pie --prefix="' + path.join(BUILD, 'install') + '" CFLAGS="' + CFLAGS + '"', BUILD);
+sh('emmake make -j4 install', BUILD);
+
+var exported = exportedFunctions().concat(['malloc', 'free']).map(function(name) {
+    return '"_' + name + '"';
+});
+var target = prebuilds.wasm();
+fs.mkdirSync(path.dirname(target), { recursive: true });
+sh('emcc -O3 -msimd128 --no-entry -s STANDALONE_WASM=1 -s ALLOW_MEMORY_GROWTH=1 ' +
+   '-s EXPORTED_FUNCTIONS=\'[' + exported.join(',') + ']\' ' +
+   path.join(BUILD, 'install', 'lib', 'libsodium.a') + ' -o ' + target);
+console.log('Wrote ' + target);
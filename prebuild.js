@@ -0,0 +1,62 @@
+/**
+ * Build the prebuilt binaries of this platform and architecture
+ *
+ *     node prebuild.js [--tiers baseline,avx2,...]
+ *
+ * Each tier of lib/prebuilds.js is a performance build of libsodium and
+ * the addon with its `-march`, copied to
+ * `prebuilds/<platform>-<arch>/<tier>/sodium.node`. libsodium is rebuilt
+ * for every tier, so this takes a few minutes per tier. Run it on the
+ * oldest toolchain the binaries must support, with a compiler that knows
+ * the `x86-64-v3` and `x86-64-v4` levels (gcc 11, clang 12).
+ *
+ * @License MIT
+ */
+/* jslint node: true */
+'use strict';
+
+var fs = require('fs');
+var path = require('path');
+var execSync = require('child_process').execSync;
+var prebuilds = require('./lib/prebuilds');
+
+function parseArgs(argv) {
+    var options = { tiers: null };
+    for( var i = 0; i < argv.length; i += 2 ) {
+        switch( argv[i] ) {
+            case '--tiers': options.tiers = argv[i + 1].split(','); break;
+            default:
+                throw new Error('unknown option ' + argv[i]);
+        }
+    }
+    return options;
+}
+
+function sh(cmd) {
+    console.log('> ' + cmd);
+    execSync(cmd, { stdio: 'inherit', cwd: __dirname });
+}
+
+var options = parseArgs(process.argv.slice(2));
+var tiers = prebuilds.tiers().filter(function(tier) {
+    return !options.tiers || options.tiers.indexOf(tier.name) !== -1;
+});
+if( process.platform === 'win32' || tiers.length === 0 ) {
+    console.log('No prebuilt tiers for ' + process.platform + '-' + process.arch);
+    process.exit(1);
+}
+
+var built = path.join(__dirname, 'build', 'Release', 'sodium.node');
+tiers.forEach(function(tier) {
+    console.log('Building tier ' + tier.name + ' (-march=' + tier.march + ')');
+    sh('make clean');
+    sh('make sodium SODIUM_BUILD=performance SODIUM_MARCH=' + tier.march);
+
+    var target = prebuilds.file(tier.name);
+    fs.mkdirSync(path.dirname(target), { recursive: true });
+    fs.copyFileSync(built, target);
+    console.log('Wrote ' + target);
+});
+
+// Leave no source build behind, or lib/binding.js would load it first
+sh('make cleanbuild');
@@ -5,8 +5,12 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <cstdint>
+#include <cstring>
+
 #include "node_sodium.h"
 #include "crypto_aead.h"
+#include "sodium_fixed.h"
 
 /***
  * Authenticated Encryption with Additional Data:
@@ -138,6 +142,36 @@ NAPI_METHOD(crypto_aead_aes256gcm_is_available) {
 }
 
 
+// The AES-NI code loads the precomputed state with aligned instructions.
+// A state Buffer that is not 16 byte aligned is copied to an aligned stack
+// block for the call, and the copy is wiped once the call returns
+class Aes256gcmAlignedState {
+public:
+    explicit Aes256gcmAlignedState(const unsigned char* ctx) {
+        if( ((uintptr_t) ctx & 15) == 0 ) {
+            state = (const crypto_aead_aes256gcm_state*) ctx;
+        } else {
+            memcpy(&copy, ctx, sizeof copy);
+            state = &copy;
+        }
+    }
+
+    ~Aes256gcmAlignedState() {
+        if( state == &copy ) {
+            sodium_memzero(&copy, sizeof copy);
+        }
+    }
+
+    const crypto_aead_aes256gcm_state* state;
+
+private:
+    crypto_aead_aes256gcm_state copy;
+};
+
+#define ARG_TO_AES256GCM_STATE(NAME) \
+    ARG_TO_UCHAR_BUFFER_LEN(NAME, crypto_aead_aes256gcm_statebytes()); \
+    Aes256gcmAlignedState NAME ## _state(NAME)
+
 /**
  * crypto_aead_aes256gcm_beforenm:
  * Precompute AES key expansion.
@@ -202,13 +236,12 @@ NAPI_METHOD(crypto_aead_aes256gcm_encrypt_afternm) {
     ARG_TO_UCHAR_BUFFER(m);
     ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
     ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_aes256gcm_NPUBBYTES);
-    ARG_TO_UCHAR_BUFFER_LEN(ctx, crypto_aead_aes256gcm_statebytes());
+    ARG_TO_AES256GCM_STATE(ctx);
 
     NEW_BUFFER_AND_PTR(c, crypto_aead_aes256gcm_ABYTES + m_size);
-    sodium_memzero(c_ptr, crypto_aead_aes256gcm_ABYTES + m_size);
     unsigned long long clen;
 
-    if( crypto_aead_aes256gcm_encrypt_afternm (c_ptr, &clen, m, m_size, ad, ad_size, NULL, npub, (crypto_aead_aes256gcm_state*)ctx) == 0 ) {
+    if( crypto_aead_aes256gcm_encrypt_afternm (c_ptr, &clen, m, m_size, ad, ad_size, NULL, npub, ctx_state.state) == 0 ) {
         return c;
     }
     return NAPI_NULL;
@@ -245,13 +278,104 @@ NAPI_METHOD(crypto_aead_aes256gcm_decrypt_afternm) {
     }
     ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
     ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_aes256gcm_NPUBBYTES);
-    ARG_TO_UCHAR_BUFFER_LEN(ctx, crypto_aead_aes256gcm_statebytes());
+    ARG_TO_AES256GCM_STATE(ctx);
 
-    NEW_BUFFER_AND_PTR(m, c_size - crypto_aead_aes256gcm_ABYTES);
     unsigned long long mlen;
+    RETURN_DECRYPTED(m, c_size - crypto_aead_aes256gcm_ABYTES,
+        crypto_aead_aes256gcm_decrypt_afternm (m_ptr, &mlen, NULL, c, c_size, ad, ad_size, npub, ctx_state.state));
+}
 
-    if( crypto_aead_aes256gcm_decrypt_afternm (m_ptr, &mlen, NULL, c, c_size, ad, ad_size, npub, (crypto_aead_aes256gcm_state*)ctx) == 0 ) {
-        return m;
+/**
+ * crypto_aead_aes256gcm_encrypt_afternm_into:
+ * Encrypt data in Combined Mode into an existing buffer
+ *
+ *    var clen = sodium.crypto_aead_aes256gcm_encrypt_afternm_into(
+ *              out,
+ *              offset,
+ *              message,
+ *              additionalData,
+ *              nonce,
+ *              ctx);
+ *
+ * ~ out (Buffer): destination buffer
+ * ~ offset (Number): where to start writing in `out`. `out` must have
+ *   `message.length + crypto_aead_aes256gcm_ABYTES` bytes free from `offset`
+ * ~ message (Buffer): plain text buffer
+ * ~ additionalData (Buffer): non-confidential data to add to the cipher text. Can be `null`
+ * ~ nonce (Buffer): a nonce with `sodium.crypto_aead_aes256gcm_NPUBBYTES` in length
+ * ~ ctx (Buffer): state computed by `crypto_aead_aes256gcm_beforenm()`
+ *
+ * **Returns**:
+ *
+ * ~ clen (Number): number of bytes written to `out`
+ * ~ null: if `message` fails to encrypt
+ *
+ * See [crypto_aead_aes256gcm_encrypt_into](#crypto_aead_aes256gcm_encrypt_into)
+ */
+NAPI_METHOD(crypto_aead_aes256gcm_encrypt_afternm_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments output buffer, offset, message, additional data, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER(m);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_aes256gcm_NPUBBYTES);
+    ARG_TO_AES256GCM_STATE(ctx);
+    CHECK_OUTPUT_SPACE(out, offset, m_size + crypto_aead_aes256gcm_ABYTES);
+
+    unsigned long long clen;
+
+    if( crypto_aead_aes256gcm_encrypt_afternm (out + offset, &clen, m, m_size, ad, ad_size, NULL, npub, ctx_state.state) == 0 ) {
+        return Napi::Number::New(env, clen);
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_aead_aes256gcm_decrypt_afternm_into:
+ * Decrypt data in Combined Mode into an existing buffer
+ *
+ *    var mlen = sodium.crypto_aead_aes256gcm_decrypt_afternm_into(
+ *              out,
+ *              offset,
+ *              cipherText,
+ *              additionalData,
+ *              nonce,
+ *              ctx);
+ *
+ * ~ out (Buffer): destination buffer
+ * ~ offset (Number): where to start writing in `out`. `out` must have
+ *   `cipherText.length - crypto_aead_aes256gcm_ABYTES` bytes free from `offset`
+ * ~ cipherText (Buffer): cipher text buffer, encrypted by crypto_aead_aes256gcm_encrypt_afternm()
+ * ~ additionalData (Buffer): non-confidential data to add to the cipher text. Can be `null`
+ * ~ nonce (Buffer): a nonce with `sodium.crypto_aead_aes256gcm_NPUBBYTES` in length
+ * ~ ctx (Buffer): state computed by `crypto_aead_aes256gcm_beforenm()`
+ *
+ * **Returns**:
+ *
+ * ~ mlen (Number): number of bytes written to `out`
+ * ~ null: if `cipherText` is not valid
+ */
+NAPI_METHOD(crypto_aead_aes256gcm_decrypt_afternm_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments output buffer, offset, chiper text, additional data, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER(c);
+    if( c_size < crypto_aead_aes256gcm_ABYTES ) {
+        THROW_ERROR("argument cipher text must be at least crypto_aead_aes256gcm_ABYTES bytes long");
+    }
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_aes256gcm_NPUBBYTES);
+    ARG_TO_AES256GCM_STATE(ctx);
+    CHECK_OUTPUT_SPACE(out, offset, c_size - crypto_aead_aes256gcm_ABYTES);
+
+    unsigned long long mlen;
+
+    if( crypto_aead_aes256gcm_decrypt_afternm (out + offset, &mlen, NULL, c, c_size, ad, ad_size, npub, ctx_state.state) == 0 ) {
+        return Napi::Number::New(env, mlen);
     }
 
     return NAPI_NULL;
@@ -316,12 +440,12 @@ NAPI_METHOD(crypto_aead_aes256gcm_encrypt_detached_afternm) {
     ARG_TO_UCHAR_BUFFER(m);
     ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
     ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_aes256gcm_NPUBBYTES);
-    ARG_TO_UCHAR_BUFFER_LEN(ctx, crypto_aead_aes256gcm_statebytes());
+    ARG_TO_AES256GCM_STATE(ctx);
 
     NEW_BUFFER_AND_PTR(c, m_size);
     NEW_BUFFER_AND_PTR(mac, crypto_aead_aes256gcm_ABYTES);
 
-    if( crypto_aead_aes256gcm_encrypt_detached_afternm(c_ptr, mac_ptr, NULL, m, m_size, ad, ad_size, NULL, npub, (crypto_aead_aes256gcm_state*)ctx) == 0 ) {
+    if( crypto_aead_aes256gcm_encrypt_detached_afternm(c_ptr, mac_ptr, NULL, m, m_size, ad, ad_size, NULL, npub, ctx_state.state) == 0 ) {
         Napi::Object result = Napi::Object::New(env);
         result.Set(Napi::String::New(env, "cipherText"), c);
         result.Set(Napi::String::New(env, "mac"), mac);
@@ -363,11 +487,11 @@ NAPI_METHOD(crypto_aead_aes256gcm_decrypt_detached_afternm) {
     ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_aead_aes256gcm_ABYTES);
     ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
     ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_aes256gcm_NPUBBYTES);
-    ARG_TO_UCHAR_BUFFER_LEN(ctx, crypto_aead_aes256gcm_statebytes());
+    ARG_TO_AES256GCM_STATE(ctx);
 
     NEW_BUFFER_AND_PTR(m, c_size);
 
-    if( crypto_aead_aes256gcm_decrypt_detached_afternm(m_ptr, NULL, c, c_size, mac, ad, ad_size, npub, (crypto_aead_aes256gcm_state*)ctx) == 0 ) {
+    if( crypto_aead_aes256gcm_decrypt_detached_afternm(m_ptr, NULL, c, c_size, mac, ad, ad_size, npub, ctx_state.state) == 0 ) {
         return m;
     }
 
@@ -441,7 +565,99 @@ NAPI_METHOD(crypto_aead_aes256gcm_decrypt_detached_afternm) {
   *
   * **See**: [crypto_aead_aes256gcm_encrypt](#crypto_aead_aes256gcm_encrypt)
   */
+
+/**
+ * crypto_aead_aes256gcm_encrypt_into:
+ * Encrypt Message in Combined Mode into an existing buffer
+ *
+ *    var clen = sodium.crypto_aead_aes256gcm_encrypt_into(
+ *              out,
+ *              offset,
+ *              message,
+ *              additionalData,
+ *              nonce,
+ *              key);
+ *
+ * Same as `crypto_aead_aes256gcm_encrypt` but the cipher text is written to
+ * `out` starting at `offset`, so no buffer is allocated per message.
+ * `out` may be the same memory as `message` (in place encryption).
+ *
+ * ~ out (Buffer): destination buffer with at least
+ *   `message.length + crypto_aead_aes256gcm_ABYTES` bytes free from `offset`
+ * ~ offset (Number): where to start writing in `out`
+ * ~ message, additionalData, nonce, key: as in `crypto_aead_aes256gcm_encrypt`
+ *
+ * **Returns**:
+ *
+ * ~ clen (Number): number of bytes written to `out`
+ * ~ null: if `message` fails to encrypt
+ *
+ * **Sample**:
+ *
+ *     var frame = Buffer.allocUnsafe(4096);
+ *     var len = sodium.crypto_aead_aes256gcm_encrypt_into(
+ *        frame, 4, message, additionalData, nonce, key);
+ *     frame.writeUInt32BE(len, 0);
+ */
+
+/**
+ * crypto_aead_aes256gcm_decrypt_into:
+ * Decrypt Message in Combined Mode into an existing buffer
+ *
+ *    var mlen = sodium.crypto_aead_aes256gcm_decrypt_into(
+ *              out,
+ *              offset,
+ *              cipherText,
+ *              additionalData,
+ *              nonce,
+ *              key);
+ *
+ * ~ out (Buffer): destination buffer with at least
+ *   `cipherText.length - crypto_aead_aes256gcm_ABYTES` bytes free from `offset`
+ * ~ offset (Number): where to start writing in `out`
+ *
+ * **Returns**:
+ *
+ * ~ mlen (Number): number of bytes written to `out`
+ * ~ null: if `cipherText` is not valid
+ */
+
+/**
+ * crypto_aead_aes256gcm_encrypt_detached_into:
+ * crypto_aead_aes256gcm_decrypt_detached_into:
+ * Detached Mode into existing buffers
+ *
+ *    var clen = sodium.crypto_aead_aes256gcm_encrypt_detached_into(
+ *              out, offset, mac, macOffset, message, additionalData, nonce, key);
+ *
+ *    var mlen = sodium.crypto_aead_aes256gcm_decrypt_detached_into(
+ *              out, offset, cipherText, mac, additionalData, nonce, key);
+ *
+ * The cipher text (or plain text) is written to `out` at `offset` and the
+ * authentication tag to `mac` at `macOffset`. Both return the number of
+ * bytes written to `out`, or `null` on failure.
+ *
+ * The `_into` variants exist for every AEAD algorithm.
+ */
+/**
+ * crypto_aead_aes256gcm_encrypt_32:
+ * crypto_aead_aes256gcm_decrypt_32:
+ * crypto_aead_aes256gcm_encrypt_64:
+ * crypto_aead_aes256gcm_decrypt_64:
+ * Combined Mode for payloads of exactly 32 or 64 bytes
+ *
+ *    var c = sodium.crypto_aead_aes256gcm_encrypt_32(key32, additionalData, nonce, key);
+ *    var m = sodium.crypto_aead_aes256gcm_decrypt_32(c, additionalData, nonce, key);
+ *
+ * Same results as `crypto_aead_aes256gcm_encrypt` and `_decrypt`, built for
+ * one message size so wrapped keys and tokens skip the generic argument
+ * handling. See src/include/sodium_fixed.h. The message must be exactly 32
+ * (or 64) bytes and the cipher text that plus `ABYTES`; there is no offset
+ * and length form. The fixed size variants exist for every AEAD algorithm.
+ */
 CRYPTO_AEAD_DEF(aes256gcm)
+CRYPTO_AEAD_BASE64URL_DEF(aes256gcm)
+CRYPTO_AEAD_FIXED_DEF(aes256gcm)
 
 /**
  * crypto_aead_aes256gcm_encrypt_detached:
@@ -513,8 +729,208 @@ CRYPTO_AEAD_DEF(aes256gcm)
   *
   * **See**: [crypto_aead_aes256gcm_encrypt](#crypto_aead_aes256gcm_encrypt)
   */
+
+/**
+ * crypto_aead_aes256gcm_encrypt_detached_inplace:
+ * Encrypt a message over itself
+ *
+ *    var mac = sodium.crypto_aead_aes256gcm_encrypt_detached_inplace(
+ *              message,
+ *              additionalData,
+ *              nonce,
+ *              key);
+ *
+ * Same arguments as `crypto_aead_aes256gcm_encrypt_detached`, but `message`
+ * is overwritten with the cipher text and no output buffer is allocated.
+ *
+ * **Returns**:
+ *
+ * ~ mac (Buffer): the authentication tag
+ */
+
+/**
+ * crypto_aead_aes256gcm_decrypt_detached_inplace:
+ * Decrypt a cipher text over itself
+ *
+ *    var ok = sodium.crypto_aead_aes256gcm_decrypt_detached_inplace(
+ *              cipherText,
+ *              mac,
+ *              additionalData,
+ *              nonce,
+ *              key);
+ *
+ * **Returns**:
+ *
+ * ~ true: `cipherText` now holds the plain text
+ * ~ false: the message was forged. Do not use the buffer, its contents may
+ *   have been wiped
+ *
+ * The `_inplace` functions exist for every AEAD algorithm.
+ */
 CRYPTO_AEAD_DETACHED_DEF(aes256gcm)
 
+extern "C" {
+int crypto_aead_aes256gcm_encrypt_multi_afternm(unsigned char * const *c,
+                                                const unsigned char * const *m,
+                                                const unsigned long long *mlen,
+                                                const unsigned char * const *ad,
+                                                const unsigned long long *adlen,
+                                                const unsigned char * const *npub,
+                                                size_t n,
+                                                const crypto_aead_aes256gcm_state *ctx_);
+int crypto_aead_aes256gcm_decrypt_multi_afternm(unsigned char *ok,
+                                                unsigned char * const *m,
+                                                const unsigned char * const *c,
+                                                const unsigned long long *clen,
+                                                const unsigned char * const *ad,
+                                                const unsigned long long *adlen,
+                                                const unsigned char * const *npub,
+                                                size_t n,
+                                                const crypto_aead_aes256gcm_state *ctx_);
+}
+
+// Batch kernels of AES-256-GCM. The key is expanded once for the whole
+// batch, and libsodium runs the counter blocks of several short messages
+// through AES together, with the powers of H computed once.
+class Aes256gcmBatchState {
+public:
+    explicit Aes256gcmBatchState(const unsigned char* k) {
+        crypto_aead_aes256gcm_beforenm(&state, k);
+    }
+
+    ~Aes256gcmBatchState() {
+        sodium_memzero(&state, sizeof state);
+    }
+
+    crypto_aead_aes256gcm_state state;
+};
+
+static int aead_aes256gcm_encrypt_batch(unsigned char* out, const std::vector<SodiumSpan>& m,
+                                        const std::vector<SodiumSpan>& ad, const std::vector<SodiumSpan>& npub,
+                                        const unsigned char* k) {
+    AeadBatchPointers batch(m, ad, npub, out, crypto_aead_aes256gcm_ABYTES, true);
+    Aes256gcmBatchState ctx(k);
+    return crypto_aead_aes256gcm_encrypt_multi_afternm(batch.out.data(), batch.in.data(), batch.inLen.data(),
+                                                       batch.ad.data(), batch.adLen.data(), batch.npub.data(),
+                                                       m.size(), &ctx.state);
+}
+
+// Cipher texts are at least ABYTES long, checked by the caller
+static int aead_aes256gcm_decrypt_batch(unsigned char* out, const std::vector<SodiumSpan>& c,
+                                        const std::vector<SodiumSpan>& ad, const std::vector<SodiumSpan>& npub,
+                                        const unsigned char* k) {
+    AeadBatchPointers batch(c, ad, npub, out, crypto_aead_aes256gcm_ABYTES, false);
+    Aes256gcmBatchState ctx(k);
+    std::vector<unsigned char> ok(c.size());
+    return crypto_aead_aes256gcm_decrypt_multi_afternm(ok.data(), batch.out.data(), batch.in.data(), batch.inLen.data(),
+                                                       batch.ad.data(), batch.adLen.data(), batch.npub.data(),
+                                                       c.size(), &ctx.state);
+}
+
+/**
+ * crypto_aead_aes256gcm_encrypt_batch:
+ * Encrypt several messages under one key in a single call
+ *
+ *    var c = sodium.crypto_aead_aes256gcm_encrypt_batch(
+ *              messages,
+ *              additionalData,
+ *              nonces,
+ *              key);
+ *
+ * ~ messages (Array): plain text buffers
+ * ~ additionalData (Array): one buffer or `null` per message. Can be `null`
+ *   for the whole batch
+ * ~ nonces (Array|Buffer): one nonce per message, or a single buffer with all
+ *   the nonces back to back
+ * ~ key (Buffer): secret key `sodium.crypto_aead_aes256gcm_KEYBYTES` in length
+ *
+ * **Returns**:
+ *
+ * ~ cipherTexts (Buffer): all the cipher texts back to back, in order. Cipher
+ *   text `i` is `messages[i].length + crypto_aead_aes256gcm_ABYTES` long
+ * ~ null: if a message fails to encrypt
+ *
+ * The key is expanded once per batch, and messages up to about 1KB are
+ * encrypted several at a time: the batch is much faster than one call per
+ * message for small packets.
+ */
+
+/**
+ * crypto_aead_aes256gcm_decrypt_batch:
+ * Decrypt several messages under one key in a single call
+ *
+ *    var m = sodium.crypto_aead_aes256gcm_decrypt_batch(
+ *              cipherTexts,
+ *              additionalData,
+ *              nonces,
+ *              key);
+ *
+ * ~ cipherTexts (Array): cipher text buffers
+ * ~ additionalData, nonces, key: as in `crypto_aead_aes256gcm_encrypt_batch`
+ *
+ * **Returns**:
+ *
+ * ~ plainTexts (Buffer): all the plain texts back to back, in order
+ * ~ null: if any cipher text is not valid. Nothing is returned for the
+ *   other messages in the batch.
+ *
+ * The `_batch` functions exist for every AEAD algorithm.
+ */
+CRYPTO_AEAD_BATCH_METHODS(aes256gcm)
+
+/**
+ * crypto_aead_aes256gcm_reencrypt:
+ * Move a cipher text from an old key to a new one
+ *
+ *    var c2 = sodium.crypto_aead_aes256gcm_reencrypt(
+ *              cipherText,
+ *              additionalData,
+ *              oldNonce,
+ *              oldKey,
+ *              newNonce,
+ *              newKey);
+ *
+ * ~ cipherText (Buffer): sealed with `oldNonce` and `oldKey`
+ * ~ additionalData (Buffer): authenticated data of the message, kept for the
+ *   new cipher text. Can be `null`
+ * ~ newNonce (Buffer): nonce for the new cipher text
+ *
+ * **Returns**:
+ *
+ * ~ the cipher text under `newKey`, as long as `cipherText`
+ * ~ null: if `cipherText` is not valid under the old key
+ *
+ * The plain text is only ever held in `sodium_malloc` memory, wiped before
+ * the call returns.
+ */
+
+/**
+ * crypto_aead_aes256gcm_reencrypt_batch:
+ * Move several cipher texts from an old key to a new one
+ *
+ *    var c2 = sodium.crypto_aead_aes256gcm_reencrypt_batch(
+ *              cipherTexts,
+ *              additionalData,
+ *              oldNonces,
+ *              oldKey,
+ *              newNonces,
+ *              newKey);
+ *
+ * ~ cipherTexts (Array): cipher text buffers
+ * ~ additionalData, oldNonces, newNonces: as in
+ *   `crypto_aead_aes256gcm_encrypt_batch`
+ *
+ * **Returns**:
+ *
+ * ~ the new cipher texts back to back, in order. Each is as long as the old
+ *   one
+ * ~ null: if any cipher text is not valid under the old key
+ *
+ * `crypto_aead_aes256gcm_reencrypt_batch_async` does the same on the
+ * threadpool. The `_reencrypt` functions exist for every AEAD algorithm.
+ */
+CRYPTO_AEAD_REENCRYPT_DEF(aes256gcm)
+
 /** Crypto AEAD ChaCha20-Poly1305 API: */
 /**
  * crypto_aead_chacha20poly1305_encrypt:
@@ -530,6 +946,8 @@ CRYPTO_AEAD_DETACHED_DEF(aes256gcm)
  * See [crypto_aead_aes256gcm_decrypt](#crypto_aead_aes256gcm_decrypt)
  */
 CRYPTO_AEAD_DEF(chacha20poly1305)
+CRYPTO_AEAD_BASE64URL_DEF(chacha20poly1305)
+CRYPTO_AEAD_FIXED_DEF(chacha20poly1305)
 
 /**
  * crypto_aead_chacha20poly1305_encrypt_detached:
@@ -545,6 +963,8 @@ CRYPTO_AEAD_DEF(chacha20poly1305)
  * See [crypto_aead_aes256gcm_decrypt_detached](#crypto_aead_aes256gcm_decrypt_detached)
  */
 CRYPTO_AEAD_DETACHED_DEF(chacha20poly1305)
+CRYPTO_AEAD_BATCH_DEF(chacha20poly1305)
+CRYPTO_AEAD_REENCRYPT_DEF(chacha20poly1305)
 
 /** Crypto AEAD ChaCha20-Poly1305-IETF API: */
 /**
@@ -561,6 +981,8 @@ CRYPTO_AEAD_DETACHED_DEF(chacha20poly1305)
  * See [crypto_aead_aes256gcm_decrypt](#crypto_aead_aes256gcm_decrypt)
  */
 CRYPTO_AEAD_DEF(chacha20poly1305_ietf)
+CRYPTO_AEAD_BASE64URL_DEF(chacha20poly1305_ietf)
+CRYPTO_AEAD_FIXED_DEF(chacha20poly1305_ietf)
 
 /**
  * crypto_aead_chacha20poly1305_ietf_encrypt_detached:
@@ -577,6 +999,19 @@ CRYPTO_AEAD_DEF(chacha20poly1305_ietf)
  */
 CRYPTO_AEAD_DETACHED_DEF(chacha20poly1305_ietf)
 
+/**
+ * crypto_aead_chacha20poly1305_ietf_encrypt_batch:
+ * crypto_aead_chacha20poly1305_ietf_decrypt_batch:
+ *
+ * See [crypto_aead_aes256gcm_encrypt_batch](#crypto_aead_aes256gcm_encrypt_batch).
+ * On CPUs with AVX2, messages up to 512 bytes are sealed and opened 8 at a
+ * time, one per vector lane, for two to three times the throughput of one
+ * call per message. The same goes for XChaCha20-Poly1305-IETF.
+ */
+CRYPTO_AEAD_MULTI_KERNELS(chacha20poly1305_ietf)
+CRYPTO_AEAD_BATCH_METHODS(chacha20poly1305_ietf)
+CRYPTO_AEAD_REENCRYPT_DEF(chacha20poly1305_ietf)
+
 /**
  * crypto_aead_chacha20poly1305_ietf_decrypt:
  * Dencrypt Message in Combined Mode using ChaCha20-Poly1305-IETF
@@ -584,6 +1019,8 @@ CRYPTO_AEAD_DETACHED_DEF(chacha20poly1305_ietf)
  * See [crypto_aead_aes256gcm_decrypt](#crypto_aead_aes256gcm_decrypt)
  */
 CRYPTO_AEAD_DEF(xchacha20poly1305_ietf)
+CRYPTO_AEAD_BASE64URL_DEF(xchacha20poly1305_ietf)
+CRYPTO_AEAD_FIXED_DEF(xchacha20poly1305_ietf)
 
 /**
  * crypto_aead_chacha20poly1305_decrypt_detached:
@@ -592,7 +1029,92 @@ CRYPTO_AEAD_DEF(xchacha20poly1305_ietf)
  * See [crypto_aead_aes256gcm_decrypt_detached](#crypto_aead_aes256gcm_decrypt_detached)
  */
 CRYPTO_AEAD_DETACHED_DEF(xchacha20poly1305_ietf)
+CRYPTO_AEAD_MULTI_KERNELS(xchacha20poly1305_ietf)
+CRYPTO_AEAD_BATCH_METHODS(xchacha20poly1305_ietf)
+CRYPTO_AEAD_REENCRYPT_DEF(xchacha20poly1305_ietf)
 
+/**
+ * crypto_aead_xchacha20poly1305_ietf_encrypt_chunks:
+ * Encrypt a message as independent chunks
+ *
+ *     var c = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_chunks(
+ *                  message, chunkSize, additionalData, nonce, firstIndex, key, [threads]);
+ *
+ * ~ message (Buffer): plain text. Every chunk but the last holds `chunkSize`
+ *   bytes of it. An empty message is one empty chunk
+ * ~ chunkSize (Number): plain text bytes per chunk
+ * ~ additionalData (Buffer): authenticated with every chunk, or null
+ * ~ nonce (Buffer): base nonce. Chunk `i` uses `nonce + firstIndex + i`, so
+ *   never encrypt the same index twice under one nonce and key
+ * ~ firstIndex (Number): index of the first chunk, to encrypt a message in
+ *   parts that start on chunk boundaries
+ * ~ key (Buffer): secret key
+ * ~ threads (Number): optional, split the chunks across this many threads.
+ *   The call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ the chunks back to back, each followed by its `ABYTES` tag: chunk `i`
+ *   starts at `i * (chunkSize + ABYTES)`
+ */
+
+/**
+ * crypto_aead_xchacha20poly1305_ietf_decrypt_chunks:
+ * Decrypt a run of chunks written by the `_encrypt_chunks` function
+ *
+ *     var m = sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_chunks(
+ *                  cipherText, chunkSize, additionalData, nonce, firstIndex, key, [threads]);
+ *
+ * ~ cipherText (Buffer): whole chunks with their tags. Only the last one may
+ *   be shorter than `chunkSize + ABYTES`
+ * ~ firstIndex (Number): index of the first chunk in `cipherText`
+ * ~ chunkSize, additionalData, nonce, key, threads: as given to encrypt
+ *
+ * **Returns**:
+ *
+ * ~ the plain text of the chunks, or null if any of them fails to
+ *   authenticate
+ */
+
+/**
+ * crypto_aead_xchacha20poly1305_ietf_encrypt_chunks_async:
+ * Encrypt a large message on every core
+ *
+ *     sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_chunks_async(
+ *          message, chunkSize, additionalData, nonce, firstIndex, key,
+ *          [out], [options], [callback]);
+ *
+ * Same output as `_encrypt_chunks`. The job runs on the libuv threadpool,
+ * which fans the chunks out to `options.threads` threads, every core by
+ * default. `out`, if given, must be exactly the size of the output and is
+ * written in place. `options` also takes `signal`, `deadline` and `timeout`.
+ * The message is not copied: do not change it until the job is done.
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the output when no callback is given
+ */
+
+/**
+ * crypto_aead_xchacha20poly1305_ietf_decrypt_chunks_async:
+ * Decrypt and verify every chunk of a large cipher text on every core
+ *
+ *     sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_chunks_async(
+ *          cipherText, chunkSize, additionalData, nonce, firstIndex, key,
+ *          [out], [options], [callback]);
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the plain text, or for null if any chunk fails to
+ *   authenticate. The output is wiped then
+ *
+ * The chunk functions also exist for `chacha20poly1305` and
+ * `chacha20poly1305_ietf`. Mind the nonce sizes: random 64 or 96 bit base
+ * nonces leave less room between messages than the 192 bit XChaCha20 ones.
+ */
+CRYPTO_AEAD_CHUNKS_DEF(chacha20poly1305)
+CRYPTO_AEAD_CHUNKS_DEF(chacha20poly1305_ietf)
+CRYPTO_AEAD_CHUNKS_DEF(xchacha20poly1305_ietf)
 
 /*
  * Register function calls in node binding
@@ -603,11 +1125,20 @@ void register_crypto_aead(Napi::Env env, Napi::Object exports) {
     EXPORT(crypto_aead_aes256gcm_beforenm);
     EXPORT(crypto_aead_aes256gcm_encrypt_afternm);
     EXPORT(crypto_aead_aes256gcm_decrypt_afternm);
+    EXPORT(crypto_aead_aes256gcm_encrypt_afternm_into);
+    EXPORT(crypto_aead_aes256gcm_decrypt_afternm_into);
     EXPORT(crypto_aead_aes256gcm_encrypt_detached_afternm);
     EXPORT(crypto_aead_aes256gcm_decrypt_detached_afternm);
 
     METHOD_AND_PROPS(aes256gcm);
+    CRYPTO_AEAD_FIXED_EXPORT(aes256gcm);
     METHOD_AND_PROPS(chacha20poly1305);
+    CRYPTO_AEAD_FIXED_EXPORT(chacha20poly1305);
     METHOD_AND_PROPS(chacha20poly1305_ietf);
+    CRYPTO_AEAD_FIXED_EXPORT(chacha20poly1305_ietf);
     METHOD_AND_PROPS(xchacha20poly1305_ietf);
+    CRYPTO_AEAD_FIXED_EXPORT(xchacha20poly1305_ietf);
+    CRYPTO_AEAD_CHUNKS_EXPORT(chacha20poly1305);
+    CRYPTO_AEAD_CHUNKS_EXPORT(chacha20poly1305_ietf);
+    CRYPTO_AEAD_CHUNKS_EXPORT(xchacha20poly1305_ietf);
 }
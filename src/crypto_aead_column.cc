@@ -0,0 +1,353 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "sodium_stats.h"
+
+/**
+ * Searchable encrypted database columns.
+ *
+ * Each value of a column is encrypted with XChaCha20-Poly1305 under a
+ * random nonce, and gets a blind index, a truncated keyed BLAKE2b digest
+ * of the value, that the database can look up:
+ *
+ *     encryption key = crypto_kdf(column key, 1, "dbcolumn")
+ *     index key      = crypto_kdf(column key, 2, "dbcolumn")
+ *     cipher text    = nonce (24) | crypto_aead_xchacha20poly1305_ietf(value, ad)
+ *     blind index    = first indexBytes of BLAKE2b-256(index key, value)
+ *
+ * Equal values have equal indexes, so the index tells which rows share a
+ * value; shorter indexes make unequal values collide on purpose and leak
+ * less. Queries compute the index of the value searched for with
+ * `crypto_aead_column_index` and filter the false positives after
+ * decryption.
+ */
+#define crypto_aead_column_KEYBYTES crypto_kdf_KEYBYTES
+#define crypto_aead_column_NPUBBYTES crypto_aead_xchacha20poly1305_ietf_NPUBBYTES
+#define crypto_aead_column_ABYTES \
+    (crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES)
+#define crypto_aead_column_INDEXBYTES_MIN 1
+#define crypto_aead_column_INDEXBYTES_MAX crypto_generichash_BYTES
+
+static const char column_context[crypto_kdf_CONTEXTBYTES + 1] = "dbcolumn";
+
+/**
+ * The subkeys of a column key, derived once per call
+ */
+struct ColumnKeys {
+    unsigned char encrypt[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+    crypto_generichash_state index;
+
+    explicit ColumnKeys(const unsigned char* key) {
+        unsigned char index_key[crypto_generichash_KEYBYTES];
+        crypto_kdf_derive_from_key(encrypt, sizeof encrypt, 1, column_context, key);
+        crypto_kdf_derive_from_key(index_key, sizeof index_key, 2, column_context, key);
+        crypto_generichash_init(&index, index_key, sizeof index_key, crypto_generichash_BYTES);
+        sodium_memzero(index_key, sizeof index_key);
+    }
+
+    ~ColumnKeys() {
+        sodium_memzero(encrypt, sizeof encrypt);
+        sodium_memzero(&index, sizeof index);
+    }
+
+    // Blind index of `v`, `size` bytes to `out`
+    void Index(unsigned char* out, size_t size, const unsigned char* v, size_t vlen) const {
+        unsigned char digest[crypto_generichash_BYTES];
+        crypto_generichash_state s;
+        memcpy(&s, &index, sizeof s);
+        crypto_generichash_update(&s, v, vlen);
+        crypto_generichash_final(&s, digest, sizeof digest);
+        memcpy(out, digest, size);
+        sodium_memzero(&s, sizeof s);
+        sodium_memzero(digest, sizeof digest);
+    }
+};
+
+// Cipher text `i` starts at the sum of the lengths before it
+static std::vector<size_t> column_offsets(const std::vector<SodiumSpan>& values, size_t& total) {
+    std::vector<size_t> offsets(values.size());
+    total = 0;
+    for(size_t i = 0; i < values.size(); i++) {
+        offsets[i] = total;
+        total += values[i].size + crypto_aead_column_ABYTES;
+    }
+    return offsets;
+}
+
+/**
+ * Encrypt and index every value of `values`, to `c` and `indexes`, on up to
+ * `threads` threads
+ */
+static int column_encrypt_batch(unsigned char* c, unsigned char* indexes, size_t index_bytes,
+                                const std::vector<SodiumSpan>& values, const unsigned char* ad, size_t adlen,
+                                const unsigned char* key, size_t threads) {
+    ColumnKeys keys(key);
+    size_t total;
+    std::vector<size_t> offsets = column_offsets(values, total);
+
+    // One call to the random source for all the nonces
+    std::vector<unsigned char> nonces(values.size() * crypto_aead_column_NPUBBYTES);
+    randombytes_buf(nonces.data(), nonces.size());
+
+    std::vector<unsigned char> ok(values.size(), 0);
+    sodium_batch_parallel(values.size(), threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            unsigned char* out = c + offsets[i];
+            memcpy(out, &nonces[i * crypto_aead_column_NPUBBYTES], crypto_aead_column_NPUBBYTES);
+            ok[i] = SODIUM_STAT(aead_xchacha20poly1305_ietf, values[i].size,
+                                values[i].size + crypto_aead_column_ABYTES,
+                crypto_aead_xchacha20poly1305_ietf_encrypt(out + crypto_aead_column_NPUBBYTES, NULL,
+                    values[i].data, values[i].size, ad, adlen, NULL, out, keys.encrypt)) == 0;
+            keys.Index(indexes + i * index_bytes, index_bytes, values[i].data, values[i].size);
+        }
+    });
+
+    for(size_t i = 0; i < values.size(); i++) {
+        if( !ok[i] ) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Decrypt every cipher text of `cs` to `m`, back to back. Returns -1 if any
+ * does not verify
+ */
+static int column_decrypt_batch(unsigned char* m, const std::vector<SodiumSpan>& cs,
+                                const unsigned char* ad, size_t adlen, const unsigned char* key,
+                                size_t threads) {
+    ColumnKeys keys(key);
+    std::vector<size_t> offsets(cs.size());
+    size_t total = 0;
+    for(size_t i = 0; i < cs.size(); i++) {
+        offsets[i] = total;
+        total += cs[i].size - crypto_aead_column_ABYTES;
+    }
+
+    std::vector<unsigned char> ok(cs.size(), 0);
+    sodium_batch_parallel(cs.size(), threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ok[i] = SODIUM_STAT(aead_xchacha20poly1305_ietf, cs[i].size, cs[i].size - crypto_aead_column_ABYTES,
+                crypto_aead_xchacha20poly1305_ietf_decrypt(m + offsets[i], NULL, NULL,
+                    cs[i].data + crypto_aead_column_NPUBBYTES, cs[i].size - crypto_aead_column_NPUBBYTES,
+                    ad, adlen, cs[i].data, keys.encrypt)) == 0;
+        }
+    });
+
+    for(size_t i = 0; i < cs.size(); i++) {
+        if( !ok[i] ) {
+            sodium_memzero(m, total);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Returns `{ cipherTexts, indexes }` from the two buffers it holds, or null
+ * if the job failed
+ */
+class ColumnWorker : public SodiumAsyncWorker {
+public:
+    ColumnWorker(const Napi::CallbackInfo& info)
+        : SodiumAsyncWorker(info, "crypto_aead_column_encrypt_batch") {}
+
+    void Hold(Napi::Object c, Napi::Object indexes) {
+        c_ref = Napi::Persistent(c);
+        indexes_ref = Napi::Persistent(indexes);
+    }
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        if( status != 0 ) {
+            return env.Null();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "cipherTexts"), c_ref.Value());
+        result.Set(Napi::String::New(env, "indexes"), indexes_ref.Value());
+        return result;
+    }
+
+private:
+    Napi::ObjectReference c_ref;
+    Napi::ObjectReference indexes_ref;
+};
+
+// Optional `threads` number argument, before an optional callback
+#define ARG_TO_THREADS(NAME) \
+    size_t NAME = 1; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        NAME = NAME ## _arg; \
+    }
+
+#define ARG_TO_INDEX_BYTES(NAME) \
+    ARG_TO_NUMBER(NAME); \
+    if( NAME < crypto_aead_column_INDEXBYTES_MIN || NAME > crypto_aead_column_INDEXBYTES_MAX ) { \
+        THROW_ERROR("argument indexBytes must be between crypto_aead_column_INDEXBYTES_MIN and crypto_aead_column_INDEXBYTES_MAX"); \
+    }
+
+/**
+ * crypto_aead_column_encrypt_batch(values, lengths, additionalData, key, indexBytes, [threads])
+ *
+ * Encrypt and index the values of a column, in one call for the whole
+ * batch. The two subkeys are derived from `key` once.
+ *
+ * Parameters:
+ *  [in] values           the values back to back
+ *  [in] lengths          length of each value, an Array or Uint32Array, or
+ *                        one Number for values of the same length
+ *  [in] additionalData   authenticated with every value, or null
+ *  [in] key              `crypto_aead_column_KEYBYTES` column key
+ *  [in] indexBytes       bytes kept of each blind index, from
+ *                        `crypto_aead_column_INDEXBYTES_MIN` to
+ *                        `crypto_aead_column_INDEXBYTES_MAX`
+ *  [in] threads          threads to spread the batch on, 1 by default
+ *
+ * Returns `{ cipherTexts, indexes }`: the cipher texts back to back, each
+ * `crypto_aead_column_ABYTES` longer than its value, and the `indexBytes`
+ * blind indexes back to back
+ */
+NAPI_METHOD(crypto_aead_column_encrypt_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments values, lengths, additional data, key, and indexBytes are required");
+    ARG_TO_CHUNKS(values, lengths);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_aead_column_KEYBYTES);
+    ARG_TO_INDEX_BYTES(index_bytes);
+    ARG_TO_THREADS(threads);
+
+    size_t total;
+    column_offsets(values, total);
+    NEW_BUFFER_AND_PTR(c, total);
+    NEW_BUFFER_AND_PTR(indexes, values.size() * index_bytes);
+    if( column_encrypt_batch(c_ptr, indexes_ptr, index_bytes, values, ad, ad_size, key, threads) != 0 ) {
+        return NAPI_NULL;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "cipherTexts"), c);
+    result.Set(Napi::String::New(env, "indexes"), indexes);
+    return result;
+}
+
+/**
+ * crypto_aead_column_encrypt_batch_async(values, lengths, additionalData, key, indexBytes, [threads], [callback])
+ *
+ * `crypto_aead_column_encrypt_batch` on the threadpool, which fans the
+ * batch out to `threads` threads. The values are not copied, so do not
+ * change them until the result is delivered.
+ */
+NAPI_METHOD(crypto_aead_column_encrypt_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments values, lengths, additional data, key, and indexBytes are required");
+    ARG_TO_CHUNKS(values, lengths);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_aead_column_KEYBYTES);
+    ARG_TO_INDEX_BYTES(index_bytes);
+    ARG_TO_THREADS(threads);
+
+    size_t total;
+    column_offsets(values, total);
+    NEW_BUFFER_AND_PTR(c, total);
+    NEW_BUFFER_AND_PTR(indexes, values.size() * index_bytes);
+
+    ColumnWorker* worker = new ColumnWorker(info);
+    worker->Hold(c, indexes);
+    worker->Pin(values_packed_buffer);
+    const unsigned char* data = ad != NULL ? worker->Copy(ad, ad_size) : NULL;
+    size_t adlen = ad_size;
+    const unsigned char* k = worker->Copy(key, crypto_aead_column_KEYBYTES);
+    size_t n = index_bytes;
+    unsigned char* out = c_ptr;
+    unsigned char* idx = indexes_ptr;
+
+    return worker->Start([=]() {
+        return column_encrypt_batch(out, idx, n, values, data, adlen, k, threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_aead_column_decrypt_batch(cipherTexts, lengths, additionalData, key, [threads])
+ *
+ * Decrypt cipher texts of `crypto_aead_column_encrypt_batch`, back to back
+ * with their `lengths` as for the values.
+ *
+ * Returns the values back to back, or null if any cipher text does not
+ * verify
+ */
+NAPI_METHOD(crypto_aead_column_decrypt_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments cipher texts, lengths, additional data, and key are required");
+    ARG_TO_CHUNKS(cipherTexts, lengths);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_aead_column_KEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    size_t total = 0;
+    for(size_t i = 0; i < cipherTexts.size(); i++) {
+        if( cipherTexts[i].size < crypto_aead_column_ABYTES ) {
+            THROW_ERROR("argument cipher texts must each be crypto_aead_column_ABYTES or more bytes long");
+        }
+        total += cipherTexts[i].size - crypto_aead_column_ABYTES;
+    }
+
+    NEW_BUFFER_AND_PTR(m, total);
+    if( column_decrypt_batch(m_ptr, cipherTexts, ad, ad_size, key, threads) != 0 ) {
+        return NAPI_NULL;
+    }
+    return m;
+}
+
+/**
+ * crypto_aead_column_index(value, key, indexBytes)
+ *
+ * The blind index of `value` under a column key, to look up the rows that
+ * hold it
+ */
+NAPI_METHOD(crypto_aead_column_index) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments value, key, and indexBytes are required");
+    ARG_TO_UCHAR_BUFFER(value);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_aead_column_KEYBYTES);
+    ARG_TO_INDEX_BYTES(index_bytes);
+
+    NEW_BUFFER_AND_PTR(index, index_bytes);
+    ColumnKeys keys(key);
+    keys.Index(index_ptr, index_bytes, value, value_size);
+    return index;
+}
+
+#undef ARG_TO_INDEX_BYTES
+#undef ARG_TO_THREADS
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_aead_column(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_aead_column_encrypt_batch);
+    EXPORT(crypto_aead_column_encrypt_batch_async);
+    EXPORT(crypto_aead_column_decrypt_batch);
+    EXPORT(crypto_aead_column_index);
+
+    EXPORT_INT(crypto_aead_column_KEYBYTES);
+    EXPORT_INT(crypto_aead_column_NPUBBYTES);
+    EXPORT_INT(crypto_aead_column_ABYTES);
+    EXPORT_INT(crypto_aead_column_INDEXBYTES_MIN);
+    EXPORT_INT(crypto_aead_column_INDEXBYTES_MAX);
+}
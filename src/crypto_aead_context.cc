@@ -0,0 +1,1072 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "nonce_sequence.h"
+#include "sodium_memory.h"
+#include "sodium_snapshot.h"
+#include "sodium_stats.h"
+
+/**
+ * AeadContext:
+ * Keyed AEAD object
+ *
+ * Holds the AEAD key (or, for AES-GCM, the expanded key schedule) in memory
+ * allocated with `sodium_malloc`, protected with guard pages and made read
+ * only after setup, or in a slot of the secure pool when
+ * `sodium_secure_pool_enable` was called. The key is checked once, when the object is built, and
+ * each call only validates the message, additional data and nonce.
+ *
+ * The state block is 64 byte aligned, so the AES-NI code reads the AES-GCM
+ * round keys and GHASH powers with aligned loads. Prefer it to the Buffer
+ * returned by `crypto_aead_aes256gcm_beforenm` on hot paths.
+ *
+ * XChaCha20 derives a subkey from the key and the first 16 bytes of each
+ * nonce with HChaCha20. A context keeps the subkeys of the last few nonce
+ * prefixes, in guarded memory, and goes straight to ChaCha20-Poly1305-IETF
+ * with the last 8 nonce bytes, as libsodium does after the derivation. Nonces
+ * made of a fixed session prefix and a counter then cost one HChaCha20 per
+ * session instead of one per message, and the output is unchanged.
+ *
+ *    var ctx = new sodium.AeadContext(algorithm, key, [nonces]);
+ *
+ * ~ algorithm (String): one of `chacha20poly1305`, `chacha20poly1305_ietf`,
+ *   `xchacha20poly1305_ietf` or `aes256gcm`
+ * ~ key (Buffer): secret key with `crypto_aead_<algorithm>_KEYBYTES` bytes.
+ *   The context keeps its own copy
+ * ~ nonces (NonceSequence): optional, `crypto_aead_<algorithm>_NPUBBYTES`
+ *   long. When given, the nonce argument of every method can be left out
+ *   and the next nonce of the sequence is used. Decryption only moves the
+ *   sequence on when it succeeds, so both ends stay in step as long as
+ *   messages arrive in order
+ *
+ * Methods:
+ *
+ * ~ encrypt(message, additionalData, nonce): same as `crypto_aead_<algorithm>_encrypt`
+ * ~ decrypt(cipherText, additionalData, nonce): same as `crypto_aead_<algorithm>_decrypt`
+ * ~ encryptDetached(message, additionalData, nonce): returns `{ cipherText, mac }`
+ * ~ decryptDetached(cipherText, mac, additionalData, nonce)
+ * ~ encryptInto(out, offset, message, additionalData, nonce) and
+ *   decryptInto(out, offset, cipherText, additionalData, nonce): write to
+ *   `out` at `offset`, as `crypto_aead_<algorithm>_encrypt_into`, and return
+ *   the number of bytes written or null
+ * ~ encryptBatch(messages, additionalData, nonces) and
+ *   decryptBatch(cipherTexts, additionalData, nonces): as
+ *   `crypto_aead_<algorithm>_encrypt_batch`. The nonces are always given,
+ *   the nonce sequence is not used
+ * ~ dispose(): wipes and frees the key. Later calls throw
+ * ~ nonces: the NonceSequence given to the constructor, or undefined
+ *
+ * **Sample**:
+ *
+ *     var key = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+ *     var ctx = new sodium.AeadContext('xchacha20poly1305_ietf', key);
+ *
+ *     var c = ctx.encrypt(message, additionalData, nonce);
+ *     var m = ctx.decrypt(c, additionalData, nonce);
+ *
+ *     // Sender and receiver each count nonces on their own
+ *     var tx = new sodium.AeadContext('chacha20poly1305_ietf', key,
+ *                  new sodium.NonceSequence(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES));
+ *     var c = tx.encrypt(message, additionalData);
+ */
+
+struct AeadAlgorithm {
+    const char* name;
+    size_t keybytes;
+    size_t npubbytes;
+    size_t abytes;
+    size_t statebytes;
+
+    // Called once on the copied key; may expand it into the state.
+    int (*setup)(unsigned char* state, const unsigned char* k);
+
+    int (*encrypt)(unsigned char* c, unsigned long long* clen_p,
+                   const unsigned char* m, unsigned long long mlen,
+                   const unsigned char* ad, unsigned long long adlen,
+                   const unsigned char* nsec, const unsigned char* npub,
+                   const unsigned char* state);
+
+    int (*decrypt)(unsigned char* m, unsigned long long* mlen_p,
+                   unsigned char* nsec,
+                   const unsigned char* c, unsigned long long clen,
+                   const unsigned char* ad, unsigned long long adlen,
+                   const unsigned char* npub, const unsigned char* state);
+
+    int (*encrypt_detached)(unsigned char* c, unsigned char* mac, unsigned long long* maclen_p,
+                            const unsigned char* m, unsigned long long mlen,
+                            const unsigned char* ad, unsigned long long adlen,
+                            const unsigned char* nsec, const unsigned char* npub,
+                            const unsigned char* state);
+
+    int (*decrypt_detached)(unsigned char* m, unsigned char* nsec,
+                            const unsigned char* c, unsigned long long clen,
+                            const unsigned char* mac,
+                            const unsigned char* ad, unsigned long long adlen,
+                            const unsigned char* npub, const unsigned char* state);
+
+    // Counters of sodium_stats
+    SodiumStatKind stat;
+};
+
+static int aead_copy_key(unsigned char* state, const unsigned char* k, size_t keybytes) {
+    memcpy(state, k, keybytes);
+    return 0;
+}
+
+#define AEAD_COPY_KEY_SETUP(ALGO) \
+    static int ALGO ## _setup(unsigned char* state, const unsigned char* k) { \
+        return aead_copy_key(state, k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+    }
+
+AEAD_COPY_KEY_SETUP(chacha20poly1305)
+AEAD_COPY_KEY_SETUP(chacha20poly1305_ietf)
+AEAD_COPY_KEY_SETUP(xchacha20poly1305_ietf)
+
+#define AEAD_KEY_ALGORITHM(ALGO) \
+    { #ALGO, crypto_aead_ ## ALGO ## _KEYBYTES, crypto_aead_ ## ALGO ## _NPUBBYTES, \
+      crypto_aead_ ## ALGO ## _ABYTES, crypto_aead_ ## ALGO ## _KEYBYTES, \
+      ALGO ## _setup, \
+      crypto_aead_ ## ALGO ## _encrypt, crypto_aead_ ## ALGO ## _decrypt, \
+      crypto_aead_ ## ALGO ## _encrypt_detached, crypto_aead_ ## ALGO ## _decrypt_detached, \
+      SODIUM_STAT_aead_ ## ALGO }
+
+// AES-GCM keeps the expanded key schedule instead of the raw key
+static int aes256gcm_setup(unsigned char* state, const unsigned char* k) {
+    return crypto_aead_aes256gcm_beforenm((crypto_aead_aes256gcm_state*) state, k);
+}
+
+static int aes256gcm_encrypt(unsigned char* c, unsigned long long* clen_p,
+                             const unsigned char* m, unsigned long long mlen,
+                             const unsigned char* ad, unsigned long long adlen,
+                             const unsigned char* nsec, const unsigned char* npub,
+                             const unsigned char* state) {
+    return crypto_aead_aes256gcm_encrypt_afternm(c, clen_p, m, mlen, ad, adlen, nsec, npub,
+                                                 (const crypto_aead_aes256gcm_state*) state);
+}
+
+static int aes256gcm_decrypt(unsigned char* m, unsigned long long* mlen_p,
+                             unsigned char* nsec,
+                             const unsigned char* c, unsigned long long clen,
+                             const unsigned char* ad, unsigned long long adlen,
+                             const unsigned char* npub, const unsigned char* state) {
+    return crypto_aead_aes256gcm_decrypt_afternm(m, mlen_p, nsec, c, clen, ad, adlen, npub,
+                                                 (const crypto_aead_aes256gcm_state*) state);
+}
+
+static int aes256gcm_encrypt_detached(unsigned char* c, unsigned char* mac, unsigned long long* maclen_p,
+                                      const unsigned char* m, unsigned long long mlen,
+                                      const unsigned char* ad, unsigned long long adlen,
+                                      const unsigned char* nsec, const unsigned char* npub,
+                                      const unsigned char* state) {
+    return crypto_aead_aes256gcm_encrypt_detached_afternm(c, mac, maclen_p, m, mlen, ad, adlen, nsec, npub,
+                                                          (const crypto_aead_aes256gcm_state*) state);
+}
+
+static int aes256gcm_decrypt_detached(unsigned char* m, unsigned char* nsec,
+                                      const unsigned char* c, unsigned long long clen,
+                                      const unsigned char* mac,
+                                      const unsigned char* ad, unsigned long long adlen,
+                                      const unsigned char* npub, const unsigned char* state) {
+    return crypto_aead_aes256gcm_decrypt_detached_afternm(m, nsec, c, clen, mac, ad, adlen, npub,
+                                                          (const crypto_aead_aes256gcm_state*) state);
+}
+
+static const AeadAlgorithm aead_algorithms[] = {
+    AEAD_KEY_ALGORITHM(chacha20poly1305),
+    AEAD_KEY_ALGORITHM(chacha20poly1305_ietf),
+    AEAD_KEY_ALGORITHM(xchacha20poly1305_ietf),
+    { "aes256gcm", crypto_aead_aes256gcm_KEYBYTES, crypto_aead_aes256gcm_NPUBBYTES,
+      crypto_aead_aes256gcm_ABYTES, sizeof(crypto_aead_aes256gcm_state),
+      aes256gcm_setup,
+      aes256gcm_encrypt, aes256gcm_decrypt,
+      aes256gcm_encrypt_detached, aes256gcm_decrypt_detached,
+      SODIUM_STAT_aead_aes256gcm }
+};
+
+// What XChaCha20-Poly1305 runs once the subkey is known
+static const AeadAlgorithm* const aead_xchacha20_inner = &aead_algorithms[1];
+
+#define XCHACHA_PREFIX_BYTES crypto_core_hchacha20_INPUTBYTES
+#define XCHACHA_SUBKEY_SLOTS 4
+
+// Subkeys of the last nonce prefixes, replaced in turn
+struct XChaChaSubkeys {
+    unsigned char prefix[XCHACHA_SUBKEY_SLOTS][XCHACHA_PREFIX_BYTES];
+    unsigned char subkey[XCHACHA_SUBKEY_SLOTS][crypto_core_hchacha20_OUTPUTBYTES];
+    size_t used;
+    size_t next;
+};
+
+#define AEAD_STATE_ALIGN 64
+#define AEAD_STATE_SIZE(SIZE) (((SIZE) + AEAD_STATE_ALIGN - 1) & ~((size_t) AEAD_STATE_ALIGN - 1))
+
+class AeadContext : public Napi::ObjectWrap<AeadContext> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "AeadContext", {
+            InstanceMethod("encrypt", &AeadContext::Encrypt),
+            InstanceMethod("decrypt", &AeadContext::Decrypt),
+            InstanceMethod("encryptDetached", &AeadContext::EncryptDetached),
+            InstanceMethod("decryptDetached", &AeadContext::DecryptDetached),
+            InstanceMethod("encryptInto", &AeadContext::EncryptInto),
+            InstanceMethod("decryptInto", &AeadContext::DecryptInto),
+            InstanceMethod("encryptBatch", &AeadContext::EncryptBatch),
+            InstanceMethod("decryptBatch", &AeadContext::DecryptBatch),
+            InstanceMethod("dispose", &AeadContext::Dispose)
+        });
+        exports.Set(Napi::String::New(env, "AeadContext"), ctor);
+    }
+
+    AeadContext(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<AeadContext>(info), algo(NULL), state(NULL), subkeys(NULL), nonces(NULL) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() < 2 || !info[0].IsString() || !sodium_arg_bytes(info[1], key, key_size) ) {
+            Napi::TypeError::New(env, "arguments must be: algorithm name, key buffer").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::string name = info[0].As<Napi::String>().Utf8Value();
+        for(size_t i = 0; i < sizeof(aead_algorithms) / sizeof(aead_algorithms[0]); i++) {
+            if( name == aead_algorithms[i].name ) {
+                algo = &aead_algorithms[i];
+            }
+        }
+        if( algo == NULL ) {
+            Napi::Error::New(env, "unknown AEAD algorithm " + name).ThrowAsJavaScriptException();
+            return;
+        }
+        if( algo->setup == aes256gcm_setup && crypto_aead_aes256gcm_is_available() != 1 ) {
+            algo = NULL;
+            Napi::Error::New(env, "aes256gcm is not supported by this CPU").ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( key_size != algo->keybytes ) {
+            algo = NULL;
+            Napi::Error::New(env, "argument key must be crypto_aead_" + name + "_KEYBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            nonces = NonceSequence::From(info[2]);
+            if( nonces == NULL || nonces->Size() != algo->npubbytes ) {
+                nonces = NULL;
+                algo = NULL;
+                Napi::TypeError::New(env, "argument nonces must be a NonceSequence of crypto_aead_" + name + "_NPUBBYTES bytes").ThrowAsJavaScriptException();
+                return;
+            }
+            info.This().As<Napi::Object>().Set("nonces", info[2]);
+            nonces_ref.Reset(info[2].As<Napi::Object>(), 1);
+        }
+
+        // sodium_malloc places the block against the end of a page, so a size
+        // that is a multiple of AEAD_STATE_ALIGN gives an aligned block, and
+        // secure pool slots are all AEAD_STATE_ALIGN aligned
+        state = (unsigned char*) sodium_secret_alloc(env, AEAD_STATE_SIZE(algo->statebytes));
+        if( state == NULL ) {
+            algo = NULL;
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        algo->setup(state, key);
+        sodium_secret_readonly(state);
+
+        // The subkeys change as nonces come, so they stay writable
+        if( algo->setup == xchacha20poly1305_ietf_setup ) {
+            subkeys = (XChaChaSubkeys*) sodium_secret_alloc(env, sizeof(XChaChaSubkeys));
+            if( subkeys != NULL ) {
+                subkeys->used = 0;
+                subkeys->next = 0;
+            }
+        }
+    }
+
+    ~AeadContext() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( state != NULL ) {
+            sodium_secret_free(Env(), state, AEAD_STATE_SIZE(algo->statebytes));
+            state = NULL;
+        }
+        if( subkeys != NULL ) {
+            sodium_secret_free(Env(), subkeys, sizeof(XChaChaSubkeys));
+            subkeys = NULL;
+        }
+    }
+
+    // The algorithm, key and nonce a call runs with
+    struct AeadCall {
+        const AeadAlgorithm* algo;
+        const unsigned char* key;
+        const unsigned char* npub;
+        unsigned char inner_npub[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    };
+
+    /**
+     * Fill `call` for the nonce `npub`. For XChaCha20 this is the subkey of
+     * the nonce prefix, derived on a miss, and the inner IETF nonce: four
+     * zero bytes and the last 8 bytes of `npub`. Only the JS thread calls it
+     */
+    void Route(AeadCall& call, const unsigned char* npub) {
+        call.algo = algo;
+        call.key = state;
+        call.npub = npub;
+        if( subkeys == NULL ) {
+            return;
+        }
+
+        size_t slot = XCHACHA_SUBKEY_SLOTS;
+        for(size_t i = 0; i < subkeys->used; i++) {
+            if( memcmp(subkeys->prefix[i], npub, XCHACHA_PREFIX_BYTES) == 0 ) {
+                slot = i;
+                break;
+            }
+        }
+        if( slot == XCHACHA_SUBKEY_SLOTS ) {
+            slot = subkeys->next;
+            subkeys->next = (subkeys->next + 1) % XCHACHA_SUBKEY_SLOTS;
+            if( subkeys->used < XCHACHA_SUBKEY_SLOTS ) {
+                subkeys->used++;
+            }
+            memcpy(subkeys->prefix[slot], npub, XCHACHA_PREFIX_BYTES);
+            crypto_core_hchacha20(subkeys->subkey[slot], npub, state, NULL);
+        }
+
+        memset(call.inner_npub, 0, 4);
+        memcpy(call.inner_npub + 4, npub + XCHACHA_PREFIX_BYTES,
+               crypto_aead_xchacha20poly1305_ietf_NPUBBYTES - XCHACHA_PREFIX_BYTES);
+        call.algo = aead_xchacha20_inner;
+        call.key = subkeys->subkey[slot];
+        call.npub = call.inner_npub;
+    }
+
+#define CHECK_CONTEXT() \
+    if( state == NULL ) { \
+        THROW_ERROR("AeadContext was disposed"); \
+    }
+
+// nonce argument, or the next nonce of the sequence when it is left out.
+// NAME ## _next says if the sequence must be moved on once the call succeeds
+#define ARG_TO_CONTEXT_NONCE(NAME) \
+    const unsigned char* NAME = NULL; \
+    unsigned char NAME ## _sequence[NONCE_SEQUENCE_MAX_BYTES]; \
+    bool NAME ## _next = false; \
+    if( nonces != NULL && ((size_t) _arg >= info.Length() || info[_arg].IsUndefined()) ) { \
+        if( !nonces->Peek(NAME ## _sequence) ) { \
+            THROW_ERROR("nonce sequence is exhausted"); \
+        } \
+        NAME = NAME ## _sequence; \
+        NAME ## _next = true; \
+    } else { \
+        ARG_TO_UCHAR_BUFFER(NAME ## _arg); \
+        if( NAME ## _arg_size != algo->npubbytes ) { \
+            THROW_ERROR("argument npub has the wrong length for this algorithm"); \
+        } \
+        NAME = NAME ## _arg; \
+    }
+
+    // Move the sequence on when `rc` says the call succeeded, as NONCE_DONE
+    int Committed(int rc, const unsigned char* npub, bool next) {
+        if( rc == 0 && next ) {
+            nonces->Commit(npub);
+        }
+        return rc;
+    }
+
+#define NONCE_DONE(NAME) \
+    if( NAME ## _next ) { \
+        nonces->Commit(NAME); \
+    }
+
+    Napi::Value Encrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(nonces ? 2 : 3, "arguments message, additional data, and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER_RANGE(m);
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        ARG_TO_CONTEXT_NONCE(npub);
+        AeadCall call;
+        Route(call, npub);
+
+        NEW_BUFFER_AND_PTR(c, m_size + algo->abytes);
+        unsigned long long clen;
+        if( SODIUM_STAT_AS(algo->stat, m_size, m_size + algo->abytes,
+                call.algo->encrypt(c_ptr, &clen, m, m_size, ad, ad_size, NULL, call.npub, call.key)) == 0 ) {
+            NONCE_DONE(npub);
+            return c;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value Decrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(nonces ? 2 : 3, "arguments cipher text, additional data, and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER_RANGE(c);
+        if( c_size < algo->abytes ) {
+            THROW_ERROR("argument cipher text is shorter than the authentication tag");
+        }
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        ARG_TO_CONTEXT_NONCE(npub);
+        AeadCall call;
+        Route(call, npub);
+
+        unsigned long long mlen;
+        RETURN_DECRYPTED(m, c_size - algo->abytes,
+            Committed(SODIUM_STAT_AS(algo->stat, c_size, m_size,
+                call.algo->decrypt(m_ptr, &mlen, NULL, c, c_size, ad, ad_size, call.npub, call.key)), npub, npub_next));
+    }
+
+    Napi::Value EncryptDetached(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(nonces ? 2 : 3, "arguments message, additional data, and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER_RANGE(m);
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        ARG_TO_CONTEXT_NONCE(npub);
+        AeadCall call;
+        Route(call, npub);
+
+        NEW_BUFFER_AND_PTR(c, m_size);
+        NEW_BUFFER_AND_PTR(mac, algo->abytes);
+        if( SODIUM_STAT_AS(algo->stat, m_size, m_size + algo->abytes,
+                call.algo->encrypt_detached(c_ptr, mac_ptr, NULL, m, m_size, ad, ad_size, NULL, call.npub, call.key)) == 0 ) {
+            NONCE_DONE(npub);
+            Napi::Object result = Napi::Object::New(env);
+            result.Set(Napi::String::New(env, "cipherText"), c);
+            result.Set(Napi::String::New(env, "mac"), mac);
+            return result;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value DecryptDetached(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(nonces ? 3 : 4, "arguments cipher text, mac, additional data, and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER_RANGE(c);
+        ARG_TO_UCHAR_BUFFER(mac);
+        if( mac_size != algo->abytes ) {
+            THROW_ERROR("argument mac has the wrong length for this algorithm");
+        }
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        ARG_TO_CONTEXT_NONCE(npub);
+        AeadCall call;
+        Route(call, npub);
+
+        NEW_BUFFER_AND_PTR(m, c_size);
+        if( SODIUM_STAT_AS(algo->stat, c_size + mac_size, c_size,
+                call.algo->decrypt_detached(m_ptr, NULL, c, c_size, mac, ad, ad_size, call.npub, call.key)) == 0 ) {
+            NONCE_DONE(npub);
+            return m;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value EncryptInto(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(nonces ? 4 : 5, "arguments output buffer, offset, message, additional data, and nonce are required");
+        ARG_TO_UCHAR_BUFFER(out);
+        ARG_TO_NUMBER(offset);
+        ARG_TO_UCHAR_BUFFER_RANGE(m);
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        ARG_TO_CONTEXT_NONCE(npub);
+        CHECK_OUTPUT_SPACE(out, offset, m_size + algo->abytes);
+        AeadCall call;
+        Route(call, npub);
+
+        unsigned long long clen;
+        if( SODIUM_STAT_AS(algo->stat, m_size, m_size + algo->abytes,
+                call.algo->encrypt(out + offset, &clen, m, m_size, ad, ad_size, NULL, call.npub, call.key)) == 0 ) {
+            NONCE_DONE(npub);
+            return Napi::Number::New(env, (double) clen);
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value DecryptInto(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(nonces ? 4 : 5, "arguments output buffer, offset, cipher text, additional data, and nonce are required");
+        ARG_TO_UCHAR_BUFFER(out);
+        ARG_TO_NUMBER(offset);
+        ARG_TO_UCHAR_BUFFER_RANGE(c);
+        if( c_size < algo->abytes ) {
+            THROW_ERROR("argument cipher text is shorter than the authentication tag");
+        }
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        ARG_TO_CONTEXT_NONCE(npub);
+        CHECK_OUTPUT_SPACE(out, offset, c_size - algo->abytes);
+        AeadCall call;
+        Route(call, npub);
+
+        unsigned long long mlen;
+        if( SODIUM_STAT_AS(algo->stat, c_size, c_size - algo->abytes,
+                call.algo->decrypt(out + offset, &mlen, NULL, c, c_size, ad, ad_size, call.npub, call.key)) == 0 ) {
+            NONCE_DONE(npub);
+            return Napi::Number::New(env, (double) mlen);
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value EncryptBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(3, "arguments messages, additional data, and nonces are required");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(m, count);
+        ARG_TO_BATCH_OR_NULL(ad, count);
+        ARG_TO_BATCH_LEN(npub, count, algo->npubbytes);
+
+        size_t total = count * algo->abytes;
+        for(size_t i = 0; i < count; i++) {
+            total += m[i].size;
+        }
+        NEW_BUFFER_AND_PTR(c, total);
+        unsigned char* pos = c_ptr;
+        for(size_t i = 0; i < count; i++) {
+            AeadCall call;
+            Route(call, npub[i].data);
+            unsigned long long clen;
+            if( SODIUM_STAT_AS(algo->stat, m[i].size, m[i].size + algo->abytes,
+                    call.algo->encrypt(pos, &clen, m[i].data, m[i].size, ad[i].data, ad[i].size, NULL, call.npub, call.key)) != 0 ) {
+                return NAPI_NULL;
+            }
+            pos += clen;
+        }
+        return c;
+    }
+
+    Napi::Value DecryptBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(3, "arguments cipher texts, additional data, and nonces are required");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(c, count);
+        ARG_TO_BATCH_OR_NULL(ad, count);
+        ARG_TO_BATCH_LEN(npub, count, algo->npubbytes);
+
+        size_t total = 0;
+        for(size_t i = 0; i < count; i++) {
+            if( c[i].size < algo->abytes ) {
+                THROW_ERROR("every cipher text must be at least as long as the authentication tag");
+            }
+            total += c[i].size - algo->abytes;
+        }
+        NEW_BUFFER_AND_PTR(m, total);
+        unsigned char* pos = m_ptr;
+        for(size_t i = 0; i < count; i++) {
+            AeadCall call;
+            Route(call, npub[i].data);
+            unsigned long long mlen;
+            if( SODIUM_STAT_AS(algo->stat, c[i].size, c[i].size - algo->abytes,
+                    call.algo->decrypt(pos, &mlen, NULL, c[i].data, c[i].size, ad[i].data, ad[i].size, call.npub, call.key)) != 0 ) {
+                sodium_memzero(m_ptr, total);
+                return NAPI_NULL;
+            }
+            pos += mlen;
+        }
+        return m;
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+#undef ARG_TO_CONTEXT_NONCE
+#undef NONCE_DONE
+
+    const AeadAlgorithm* algo;
+    unsigned char* state;
+    XChaChaSubkeys* subkeys;
+    NonceSequence* nonces;
+    Napi::ObjectReference nonces_ref;
+};
+
+/**
+ * AeadKeyring:
+ * AEAD keys looked up by a key id carried in the cipher text
+ *
+ * Each key is held as in an AeadContext, in its own `sodium_malloc` block
+ * made read only or in a secure pool slot, and found by its 32 bit id in a hash map. `encrypt` seals
+ * with the primary key and `decrypt` picks the key named in the frame, so a
+ * key rotation only changes which key is primary. Frames are laid out as:
+ *
+ *     key id (4 bytes, big endian) | nonce | cipher text and tag
+ *
+ *    var ring = new sodium.AeadKeyring(algorithm);
+ *
+ * ~ algorithm (String): one of `chacha20poly1305`, `chacha20poly1305_ietf`,
+ *   `xchacha20poly1305_ietf` or `aes256gcm`
+ *
+ * Properties:
+ *
+ * ~ primary (Number): id of the key `encrypt` uses, -1 while there is none
+ * ~ size (Number): number of keys
+ * ~ overhead (Number): bytes a frame adds to its message, 4 +
+ *   `crypto_aead_<algorithm>_NPUBBYTES` + `crypto_aead_<algorithm>_ABYTES`
+ *
+ * Methods:
+ *
+ * ~ add(keyId, key, [primary]): keep a copy of `key` under `keyId`, an
+ *   integer from 0 to 2^32 - 1, replacing the key already there. The first
+ *   key, or any key added with `primary` true, becomes the primary key
+ * ~ setPrimary(keyId), has(keyId), remove(keyId). Removing the primary key
+ *   leaves the keyring without one
+ * ~ encrypt(message, additionalData, [nonce]): frame of `message` under the
+ *   primary key. The nonce is random when left out, which is only allowed
+ *   for `xchacha20poly1305_ietf`: the shorter nonces of the other
+ *   algorithms are not safe to pick at random
+ * ~ decrypt(frame, additionalData): the message, or null if the key id is
+ *   unknown or the frame does not verify
+ * ~ keyId(frame): the key id of a frame
+ * ~ save(path, snapshotKey): seal every key into the snapshot file `path`,
+ *   see `sodium_snapshot_save`. Keys are written as their prepared states,
+ *   so a loaded `aes256gcm` key does not expand its schedule again
+ * ~ load(path, snapshotKey): add the keys of a snapshot of a keyring of the
+ *   same algorithm, replacing keys with the same ids, and its primary key.
+ *   Returns the number of keys loaded; throws, leaving the keyring as it
+ *   was, if the file does not verify
+ * ~ dispose(): wipes and frees every key. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var ring = new sodium.AeadKeyring('xchacha20poly1305_ietf');
+ *     ring.add(1, oldKey);
+ *     ring.add(2, newKey, true);
+ *
+ *     var frame = ring.encrypt(message, tenantId);
+ *     var m = ring.decrypt(frame, tenantId);     // frames of key 1 as well
+ */
+
+#define AEAD_KEYRING_ID_BYTES 4
+
+// Snapshot records: key id (4) | primary (1) | padding (3) | key state
+#define AEAD_KEYRING_RECORD_HEADER 8
+
+class AeadKeyring : public Napi::ObjectWrap<AeadKeyring> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "AeadKeyring", {
+            InstanceMethod("add", &AeadKeyring::Add),
+            InstanceMethod("setPrimary", &AeadKeyring::SetPrimary),
+            InstanceMethod("has", &AeadKeyring::Has),
+            InstanceMethod("remove", &AeadKeyring::Remove),
+            InstanceMethod("encrypt", &AeadKeyring::Encrypt),
+            InstanceMethod("decrypt", &AeadKeyring::Decrypt),
+            InstanceMethod("keyId", &AeadKeyring::KeyId),
+            InstanceMethod("save", &AeadKeyring::Save),
+            InstanceMethod("load", &AeadKeyring::Load),
+            InstanceMethod("dispose", &AeadKeyring::Dispose),
+            InstanceAccessor("primary", &AeadKeyring::Primary, nullptr),
+            InstanceAccessor("size", &AeadKeyring::Size, nullptr),
+            InstanceAccessor("overhead", &AeadKeyring::Overhead, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "AeadKeyring"), ctor);
+    }
+
+    AeadKeyring(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<AeadKeyring>(info), algo(NULL), primary(NULL), primary_id(0), disposed(false) {
+        Napi::Env env = info.Env();
+
+        if( info.Length() < 1 || !info[0].IsString() ) {
+            Napi::TypeError::New(env, "argument algorithm must be a string").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::string name = info[0].As<Napi::String>().Utf8Value();
+        for(size_t i = 0; i < sizeof(aead_algorithms) / sizeof(aead_algorithms[0]); i++) {
+            if( name == aead_algorithms[i].name ) {
+                algo = &aead_algorithms[i];
+            }
+        }
+        if( algo == NULL ) {
+            Napi::Error::New(env, "unknown AEAD algorithm " + name).ThrowAsJavaScriptException();
+            return;
+        }
+        if( algo->setup == aes256gcm_setup && crypto_aead_aes256gcm_is_available() != 1 ) {
+            algo = NULL;
+            Napi::Error::New(env, "aes256gcm is not supported by this CPU").ThrowAsJavaScriptException();
+            return;
+        }
+    }
+
+    ~AeadKeyring() {
+        Free();
+    }
+
+private:
+    void FreeKey(unsigned char* state) {
+        sodium_secret_free(Env(), state, AEAD_STATE_SIZE(algo->statebytes));
+    }
+
+    void Free() {
+        for(auto& entry : keys) {
+            FreeKey(entry.second);
+        }
+        keys.clear();
+        primary = NULL;
+        disposed = true;
+    }
+
+#define CHECK_CONTEXT() \
+    if( algo == NULL || disposed ) { \
+        THROW_ERROR("AeadKeyring was disposed"); \
+    }
+
+#define ARG_TO_KEY_ID(NAME) \
+    uint64_t NAME; \
+    if( !SODIUM_ARG_IS_INTEGER(info[_arg]) ) { \
+        THROW_ERROR("argument " #NAME " must be an integer"); \
+    } \
+    if( !sodium_arg_uint64(info[_arg], #NAME, UINT32_MAX, NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments must be: key id, key");
+        ARG_TO_KEY_ID(keyId);
+        ARG_TO_UCHAR_BUFFER(key);
+        if( key_size != algo->keybytes ) {
+            THROW_ERROR("argument key must be crypto_aead_" + std::string(algo->name) + "_KEYBYTES bytes long");
+        }
+        bool make_primary = keys.empty() || (info.Length() > 2 && info[2].ToBoolean());
+
+        unsigned char* state = (unsigned char*) sodium_secret_alloc(env, AEAD_STATE_SIZE(algo->statebytes));
+        if( state == NULL ) {
+            THROW_ERROR("cannot allocate secure memory for the key");
+        }
+        algo->setup(state, key);
+        sodium_secret_readonly(state);
+
+        uint32_t id = (uint32_t) keyId;
+        auto found = keys.find(id);
+        if( found != keys.end() ) {
+            if( primary == found->second ) {
+                primary = state;
+            }
+            FreeKey(found->second);
+            found->second = state;
+        } else {
+            keys[id] = state;
+        }
+        if( make_primary ) {
+            primary = state;
+            primary_id = id;
+        }
+        return info.This();
+    }
+
+    Napi::Value SetPrimary(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument key id must be a number");
+        ARG_TO_KEY_ID(keyId);
+        auto found = keys.find((uint32_t) keyId);
+        if( found == keys.end() ) {
+            THROW_ERROR("unknown key id " + std::to_string(keyId));
+        }
+        primary = found->second;
+        primary_id = found->first;
+        return info.This();
+    }
+
+    Napi::Value Has(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument key id must be a number");
+        ARG_TO_KEY_ID(keyId);
+        return keys.count((uint32_t) keyId) ? NAPI_TRUE : NAPI_FALSE;
+    }
+
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument key id must be a number");
+        ARG_TO_KEY_ID(keyId);
+        auto found = keys.find((uint32_t) keyId);
+        if( found == keys.end() ) {
+            return NAPI_FALSE;
+        }
+        if( primary == found->second ) {
+            primary = NULL;
+        }
+        FreeKey(found->second);
+        keys.erase(found);
+        return NAPI_TRUE;
+    }
+
+    Napi::Value Encrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments message and additional data must be buffers");
+        ARG_TO_UCHAR_BUFFER(m);
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        if( primary == NULL ) {
+            THROW_ERROR("the keyring has no primary key");
+        }
+
+        const unsigned char* npub = NULL;
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            ARG_TO_UCHAR_BUFFER(nonce);
+            if( nonce_size != algo->npubbytes ) {
+                THROW_ERROR("argument npub has the wrong length for this algorithm");
+            }
+            npub = nonce;
+        } else if( algo->npubbytes < crypto_aead_xchacha20poly1305_ietf_NPUBBYTES ) {
+            THROW_ERROR("argument nonce is required for " + std::string(algo->name));
+        }
+
+        NEW_BUFFER_AND_PTR(frame, AEAD_KEYRING_ID_BYTES + algo->npubbytes + m_size + algo->abytes);
+        frame_ptr[0] = (unsigned char) (primary_id >> 24);
+        frame_ptr[1] = (unsigned char) (primary_id >> 16);
+        frame_ptr[2] = (unsigned char) (primary_id >> 8);
+        frame_ptr[3] = (unsigned char) primary_id;
+        unsigned char* frame_npub = frame_ptr + AEAD_KEYRING_ID_BYTES;
+        if( npub != NULL ) {
+            memcpy(frame_npub, npub, algo->npubbytes);
+        } else {
+            randombytes_buf(frame_npub, algo->npubbytes);
+        }
+
+        unsigned long long clen;
+        if( SODIUM_STAT_AS(algo->stat, m_size, m_size + algo->abytes,
+                algo->encrypt(frame_npub + algo->npubbytes, &clen, m, m_size, ad, ad_size,
+                              NULL, frame_npub, primary)) == 0 ) {
+            return frame;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value Decrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments frame and additional data must be buffers");
+        ARG_TO_UCHAR_BUFFER(frame);
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+        size_t header = AEAD_KEYRING_ID_BYTES + algo->npubbytes;
+        if( frame_size < header + algo->abytes ) {
+            THROW_ERROR("argument frame is shorter than its header and authentication tag");
+        }
+
+        auto found = keys.find(FrameKeyId(frame));
+        if( found == keys.end() ) {
+            return NAPI_NULL;
+        }
+        const unsigned char* npub = frame + AEAD_KEYRING_ID_BYTES;
+        const unsigned char* c = frame + header;
+        size_t c_size = frame_size - header;
+        unsigned char* state = found->second;
+
+        unsigned long long mlen;
+        RETURN_DECRYPTED(m, c_size - algo->abytes,
+            SODIUM_STAT_AS(algo->stat, c_size, m_size,
+                algo->decrypt(m_ptr, &mlen, NULL, c, c_size, ad, ad_size, npub, state)));
+    }
+
+    Napi::Value KeyId(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        ARGS(1, "argument frame must be a buffer");
+        ARG_TO_UCHAR_BUFFER(frame);
+        if( frame_size < AEAD_KEYRING_ID_BYTES ) {
+            THROW_ERROR("argument frame is shorter than its key id");
+        }
+        return Napi::Number::New(env, FrameKeyId(frame));
+    }
+
+    Napi::Value Save(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments path and snapshot key are required");
+        if( !info[0].IsString() ) {
+            THROW_ERROR("argument path must be a string");
+        }
+        std::string path = info[0].As<Napi::String>().Utf8Value();
+        _arg++;
+        ARG_TO_UCHAR_BUFFER_LEN(snapshotKey, SNAPSHOT_KEYBYTES);
+
+        size_t record_size = AEAD_KEYRING_RECORD_HEADER + algo->statebytes;
+        size_t body_size = record_size * keys.size();
+        unsigned char* body = NULL;
+        if( body_size > 0 ) {
+            body = (unsigned char*) sodium_secret_alloc(env, body_size);
+            if( body == NULL ) {
+                THROW_ERROR("cannot allocate secure memory for the snapshot");
+            }
+            memset(body, 0, body_size);
+        }
+        unsigned char* record = body;
+        for(auto& entry : keys) {
+            memcpy(record, &entry.first, sizeof entry.first);
+            record[4] = entry.second == primary;
+            memcpy(record + AEAD_KEYRING_RECORD_HEADER, entry.second, algo->statebytes);
+            record += record_size;
+        }
+
+        std::string error = sodium_snapshot_save(path, SnapshotKind().c_str(), body, 0, record_size,
+                                                 keys.size(), snapshotKey);
+        if( body != NULL ) {
+            sodium_secret_free(env, body, body_size);
+        }
+        if( !error.empty() ) {
+            THROW_ERROR(error);
+        }
+        return info.This();
+    }
+
+    Napi::Value Load(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments path and snapshot key are required");
+        if( !info[0].IsString() ) {
+            THROW_ERROR("argument path must be a string");
+        }
+        std::string path = info[0].As<Napi::String>().Utf8Value();
+        _arg++;
+        ARG_TO_UCHAR_BUFFER_LEN(snapshotKey, SNAPSHOT_KEYBYTES);
+
+        SodiumSnapshot snapshot;
+        std::string error = sodium_snapshot_load(env, path, SnapshotKind().c_str(), 0, snapshotKey, snapshot);
+        if( !error.empty() ) {
+            THROW_ERROR(error);
+        }
+        if( snapshot.count > 0 && snapshot.record_size != AEAD_KEYRING_RECORD_HEADER + algo->statebytes ) {
+            sodium_snapshot_release(env, snapshot);
+            THROW_ERROR(path + ": the snapshot layout is invalid");
+        }
+
+        // Every state is made before the first is swapped in, so a failed
+        // allocation leaves the keyring untouched
+        std::vector<unsigned char*> states(snapshot.count);
+        for(uint64_t i = 0; i < snapshot.count; i++) {
+            states[i] = (unsigned char*) sodium_secret_alloc(env, AEAD_STATE_SIZE(algo->statebytes));
+            if( states[i] == NULL ) {
+                for(uint64_t j = 0; j < i; j++) {
+                    FreeKey(states[j]);
+                }
+                sodium_snapshot_release(env, snapshot);
+                THROW_ERROR("cannot allocate secure memory for the key");
+            }
+            memcpy(states[i], snapshot.body + i * snapshot.record_size + AEAD_KEYRING_RECORD_HEADER,
+                   algo->statebytes);
+            sodium_secret_readonly(states[i]);
+        }
+
+        for(uint64_t i = 0; i < snapshot.count; i++) {
+            const unsigned char* record = snapshot.body + i * snapshot.record_size;
+            uint32_t id;
+            memcpy(&id, record, sizeof id);
+            auto found = keys.find(id);
+            if( found != keys.end() ) {
+                if( primary == found->second ) {
+                    primary = NULL;
+                }
+                FreeKey(found->second);
+                found->second = states[i];
+            } else {
+                keys[id] = states[i];
+            }
+            if( record[4] ) {
+                primary = states[i];
+                primary_id = id;
+            }
+        }
+        sodium_snapshot_release(env, snapshot);
+        return Napi::Number::New(env, (double) states.size());
+    }
+
+    std::string SnapshotKind() {
+        return std::string("aead.") + algo->name;
+    }
+
+    static uint32_t FrameKeyId(const unsigned char* frame) {
+        return ((uint32_t) frame[0] << 24) | ((uint32_t) frame[1] << 16) |
+               ((uint32_t) frame[2] << 8) | (uint32_t) frame[3];
+    }
+
+    Napi::Value Primary(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, primary != NULL ? (double) primary_id : -1);
+    }
+
+    Napi::Value Size(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, (double) keys.size());
+    }
+
+    Napi::Value Overhead(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, AEAD_KEYRING_ID_BYTES + algo->npubbytes + algo->abytes);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+#undef ARG_TO_KEY_ID
+
+    const AeadAlgorithm* algo;
+
+    // Key states by id, each in its own sodium_malloc block
+    std::unordered_map<uint32_t, unsigned char*> keys;
+    unsigned char* primary;
+    uint32_t primary_id;
+    bool disposed;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_aead_context(Napi::Env env, Napi::Object exports) {
+    AeadContext::Init(env, exports);
+    AeadKeyring::Init(env, exports);
+}
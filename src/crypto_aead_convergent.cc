@@ -0,0 +1,365 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "sodium_stats.h"
+
+/**
+ * Convergent encryption with XChaCha20-Poly1305.
+ *
+ * The key and nonce of a message are derived from the message itself, with
+ * BLAKE2b keyed with a secret shared by everyone who should dedupe
+ * together:
+ *
+ *     key | nonce = BLAKE2b-56(secret, LE64(adlen) | ad | message)
+ *     cipher text = nonce (24) | crypto_aead_xchacha20poly1305_ietf(message, ad)
+ *
+ * so the same message and additional data under the same secret always
+ * give the same cipher text. The nonce, the first NPUBBYTES of the cipher
+ * text, is a deterministic content id. The key is what the holder of a
+ * chunk needs to decrypt it; the secret is only needed to encrypt.
+ *
+ * Equal messages are visibly equal, which is the point: use this for
+ * chunks whose equality may be known to the storage, not for small or
+ * guessable messages, which anyone with the secret can confirm.
+ */
+#define crypto_aead_convergent_KEYBYTES crypto_aead_xchacha20poly1305_ietf_KEYBYTES
+#define crypto_aead_convergent_NPUBBYTES crypto_aead_xchacha20poly1305_ietf_NPUBBYTES
+#define crypto_aead_convergent_ABYTES \
+    (crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES)
+
+static const unsigned char convergent_personal[crypto_generichash_blake2b_PERSONALBYTES] = {
+    'c', 'o', 'n', 'v', 'e', 'r', 'g', 'e', 'n', 't', '-', 'a', 'e', 'a', 'd', 0
+};
+
+/**
+ * Encrypt `m` to `c`, `mlen + crypto_aead_convergent_ABYTES` bytes, and
+ * write its key to `key`
+ */
+static int convergent_encrypt(unsigned char* key, unsigned char* c, const unsigned char* m, size_t mlen,
+                              const unsigned char* ad, size_t adlen, const unsigned char* secret) {
+    unsigned char derived[crypto_aead_convergent_KEYBYTES + crypto_aead_convergent_NPUBBYTES];
+    unsigned char le[8];
+    for(int i = 0; i < 8; i++) {
+        le[i] = (unsigned char) ((uint64_t) adlen >> (8 * i));
+    }
+    crypto_generichash_blake2b_state state;
+    crypto_generichash_blake2b_init_salt_personal(&state, secret, crypto_aead_convergent_KEYBYTES,
+                                                  sizeof derived, NULL, convergent_personal);
+    crypto_generichash_blake2b_update(&state, le, sizeof le);
+    crypto_generichash_blake2b_update(&state, ad, adlen);
+    crypto_generichash_blake2b_update(&state, m, mlen);
+    crypto_generichash_blake2b_final(&state, derived, sizeof derived);
+
+    memcpy(key, derived, crypto_aead_convergent_KEYBYTES);
+    memcpy(c, derived + crypto_aead_convergent_KEYBYTES, crypto_aead_convergent_NPUBBYTES);
+    sodium_memzero(derived, sizeof derived);
+    return SODIUM_STAT(aead_xchacha20poly1305_ietf, mlen, mlen + crypto_aead_convergent_ABYTES,
+        crypto_aead_xchacha20poly1305_ietf_encrypt(c + crypto_aead_convergent_NPUBBYTES, NULL, m, mlen,
+            ad, adlen, NULL, c, key));
+}
+
+static int convergent_decrypt(unsigned char* m, const unsigned char* c, size_t clen,
+                              const unsigned char* ad, size_t adlen, const unsigned char* key) {
+    return SODIUM_STAT(aead_xchacha20poly1305_ietf, clen, clen - crypto_aead_convergent_ABYTES,
+        crypto_aead_xchacha20poly1305_ietf_decrypt(m, NULL, NULL, c + crypto_aead_convergent_NPUBBYTES,
+            clen - crypto_aead_convergent_NPUBBYTES, ad, adlen, c, key));
+}
+
+// Encrypt message `i` of `ms` to `c` at the sum of the lengths before it
+static int convergent_encrypt_batch(unsigned char* keys, unsigned char* c, const std::vector<SodiumSpan>& ms,
+                                    const unsigned char* ad, size_t adlen, const unsigned char* secret,
+                                    size_t threads) {
+    std::vector<size_t> offsets(ms.size());
+    size_t offset = 0;
+    for(size_t i = 0; i < ms.size(); i++) {
+        offsets[i] = offset;
+        offset += ms[i].size + crypto_aead_convergent_ABYTES;
+    }
+    sodium_batch_parallel(ms.size(), threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            convergent_encrypt(keys + i * crypto_aead_convergent_KEYBYTES, c + offsets[i],
+                               ms[i].data, ms[i].size, ad, adlen, secret);
+        }
+    });
+    return 0;
+}
+
+/**
+ * Returns `{ <key name>, <cipher text name> }` from the two buffers it
+ * pinned, or null if the job failed
+ */
+class ConvergentWorker : public SodiumAsyncWorker {
+public:
+    ConvergentWorker(const Napi::CallbackInfo& info, const char* name, const char* key_name, const char* c_name)
+        : SodiumAsyncWorker(info, name), key_name(key_name), c_name(c_name) {}
+
+    void Hold(Napi::Object key, Napi::Object c) {
+        key_ref = Napi::Persistent(key);
+        c_ref = Napi::Persistent(c);
+    }
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        if( status != 0 ) {
+            return env.Null();
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, key_name), key_ref.Value());
+        result.Set(Napi::String::New(env, c_name), c_ref.Value());
+        return result;
+    }
+
+private:
+    const char* key_name;
+    const char* c_name;
+    Napi::ObjectReference key_ref;
+    Napi::ObjectReference c_ref;
+};
+
+// Optional `threads` number argument, before an optional callback
+#define ARG_TO_THREADS(NAME) \
+    size_t NAME = 1; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        NAME = NAME ## _arg; \
+    }
+
+/**
+ * crypto_aead_convergent_encrypt(message, additionalData, secret)
+ *
+ * Encrypt `message` under a key and nonce derived from it.
+ *
+ * Parameters:
+ *  [in] message          the message to encrypt
+ *  [in] additionalData   authenticated, and part of the derivation, or null
+ *  [in] secret           `crypto_aead_convergent_KEYBYTES` secret shared by
+ *                        the parties that dedupe together
+ *
+ * Returns `{ key, cipherText }`: the `crypto_aead_convergent_KEYBYTES` key
+ * to decrypt with, and the cipher text, `crypto_aead_convergent_ABYTES`
+ * longer than the message
+ */
+NAPI_METHOD(crypto_aead_convergent_encrypt) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, additional data, and secret are required");
+    ARG_TO_UCHAR_BUFFER_RANGE(m);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(secret, crypto_aead_convergent_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(key, crypto_aead_convergent_KEYBYTES);
+    NEW_BUFFER_AND_PTR(c, m_size + crypto_aead_convergent_ABYTES);
+    if( convergent_encrypt(key_ptr, c_ptr, m, m_size, ad, ad_size, secret) != 0 ) {
+        return NAPI_NULL;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "key"), key);
+    result.Set(Napi::String::New(env, "cipherText"), c);
+    return result;
+}
+
+/**
+ * crypto_aead_convergent_decrypt(cipherText, additionalData, key)
+ *
+ * Returns the message, or null if the cipher text does not verify
+ */
+NAPI_METHOD(crypto_aead_convergent_decrypt) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments cipher text, additional data, and key are required");
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
+    if( c_size < crypto_aead_convergent_ABYTES ) {
+        THROW_ERROR("argument cipher text is shorter than crypto_aead_convergent_ABYTES");
+    }
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_aead_convergent_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(m, c_size - crypto_aead_convergent_ABYTES);
+    if( convergent_decrypt(m_ptr, c, c_size, ad, ad_size, key) != 0 ) {
+        sodium_memzero(m_ptr, m.Length());
+        return NAPI_NULL;
+    }
+    return m;
+}
+
+/**
+ * crypto_aead_convergent_encrypt_async(message, additionalData, secret, [options], [callback])
+ *
+ * `crypto_aead_convergent_encrypt` on the threadpool. The message is not
+ * copied, so do not change it until the result is delivered.
+ */
+NAPI_METHOD(crypto_aead_convergent_encrypt_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, additional data, and secret are required");
+    ARG_TO_UCHAR_BUFFER(m);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(secret, crypto_aead_convergent_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(key, crypto_aead_convergent_KEYBYTES);
+    NEW_BUFFER_AND_PTR(c, m_size + crypto_aead_convergent_ABYTES);
+    ConvergentWorker* worker = new ConvergentWorker(info, "crypto_aead_convergent_encrypt", "key", "cipherText");
+    worker->Hold(key, c);
+    const unsigned char* message = worker->Pin(m_buffer);
+    size_t mlen = m_size;
+    const unsigned char* data = ad != NULL ? worker->Copy(ad, ad_size) : NULL;
+    size_t adlen = ad_size;
+    const unsigned char* s = worker->Copy(secret, crypto_aead_convergent_KEYBYTES);
+    unsigned char* k = key_ptr;
+    unsigned char* out = c_ptr;
+
+    return worker->Start([=]() {
+        return convergent_encrypt(k, out, message, mlen, data, adlen, s);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_aead_convergent_encrypt_batch(messages, additionalData, secret, [threads])
+ *
+ * Encrypt each message of the `messages` Array, with the same additional
+ * data, on up to `threads` threads.
+ *
+ * Returns `{ keys, cipherTexts }`: the keys back to back, and the cipher
+ * texts back to back, cipher text `i` being `messages[i].length +
+ * crypto_aead_convergent_ABYTES` bytes
+ */
+NAPI_METHOD(crypto_aead_convergent_encrypt_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments messages, additional data, and secret are required");
+    size_t count = SODIUM_BATCH_ANY;
+    ARG_TO_BATCH(messages, count);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(secret, crypto_aead_convergent_KEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    size_t total = 0;
+    for(size_t i = 0; i < count; i++) {
+        total += messages[i].size + crypto_aead_convergent_ABYTES;
+    }
+    NEW_BUFFER_AND_PTR(keys, count * crypto_aead_convergent_KEYBYTES);
+    NEW_BUFFER_AND_PTR(c, total);
+    convergent_encrypt_batch(keys_ptr, c_ptr, messages, ad, ad_size, secret, threads);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "keys"), keys);
+    result.Set(Napi::String::New(env, "cipherTexts"), c);
+    return result;
+}
+
+/**
+ * crypto_aead_convergent_encrypt_batch_async(messages, additionalData, secret, [threads], [callback])
+ *
+ * `crypto_aead_convergent_encrypt_batch` on the threadpool, which fans the
+ * batch out to `threads` threads. The messages are copied.
+ */
+NAPI_METHOD(crypto_aead_convergent_encrypt_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments messages, additional data, and secret are required");
+    size_t count = SODIUM_BATCH_ANY;
+    ARG_TO_BATCH(messages, count);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(secret, crypto_aead_convergent_KEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    size_t total = 0;
+    for(size_t i = 0; i < count; i++) {
+        total += messages[i].size + crypto_aead_convergent_ABYTES;
+    }
+    NEW_BUFFER_AND_PTR(keys, count * crypto_aead_convergent_KEYBYTES);
+    NEW_BUFFER_AND_PTR(c, total);
+
+    ConvergentWorker* worker = new ConvergentWorker(info, "crypto_aead_convergent_encrypt_batch",
+                                                    "keys", "cipherTexts");
+    worker->Hold(keys, c);
+    std::vector<SodiumSpan> ms(count);
+    for(size_t i = 0; i < count; i++) {
+        ms[i].data = worker->Copy(messages[i].data, messages[i].size);
+        ms[i].size = messages[i].size;
+    }
+    const unsigned char* data = ad != NULL ? worker->Copy(ad, ad_size) : NULL;
+    size_t adlen = ad_size;
+    const unsigned char* s = worker->Copy(secret, crypto_aead_convergent_KEYBYTES);
+    unsigned char* k = keys_ptr;
+    unsigned char* out = c_ptr;
+
+    return worker->Start([=]() {
+        return convergent_encrypt_batch(k, out, ms, data, adlen, s, threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_aead_convergent_decrypt_batch(cipherTexts, additionalData, keys, [threads])
+ *
+ * Decrypt each cipher text of the `cipherTexts` Array with the key at the
+ * same index of `keys`, an Array or the keys back to back.
+ *
+ * Returns the messages back to back, or null if any cipher text does not
+ * verify
+ */
+NAPI_METHOD(crypto_aead_convergent_decrypt_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments cipher texts, additional data, and keys are required");
+    size_t count = SODIUM_BATCH_ANY;
+    ARG_TO_BATCH(cipherTexts, count);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_BATCH_LEN(keys, count, crypto_aead_convergent_KEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    std::vector<size_t> offsets(count);
+    size_t total = 0;
+    for(size_t i = 0; i < count; i++) {
+        if( cipherTexts[i].size < crypto_aead_convergent_ABYTES ) {
+            THROW_ERROR("argument cipher texts must each be crypto_aead_convergent_ABYTES or more bytes long");
+        }
+        offsets[i] = total;
+        total += cipherTexts[i].size - crypto_aead_convergent_ABYTES;
+    }
+
+    NEW_BUFFER_AND_PTR(m, total);
+    std::vector<unsigned char> ok(count, 0);
+    sodium_batch_parallel(count, threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ok[i] = convergent_decrypt(m_ptr + offsets[i], cipherTexts[i].data, cipherTexts[i].size,
+                                       ad, ad_size, keys[i].data) == 0;
+        }
+    });
+    for(size_t i = 0; i < count; i++) {
+        if( !ok[i] ) {
+            sodium_memzero(m_ptr, m.Length());
+            return NAPI_NULL;
+        }
+    }
+    return m;
+}
+
+#undef ARG_TO_THREADS
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_aead_convergent(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_aead_convergent_encrypt);
+    EXPORT(crypto_aead_convergent_decrypt);
+    EXPORT(crypto_aead_convergent_encrypt_async);
+    EXPORT(crypto_aead_convergent_encrypt_batch);
+    EXPORT(crypto_aead_convergent_encrypt_batch_async);
+    EXPORT(crypto_aead_convergent_decrypt_batch);
+
+    EXPORT_INT(crypto_aead_convergent_KEYBYTES);
+    EXPORT_INT(crypto_aead_convergent_NPUBBYTES);
+    EXPORT_INT(crypto_aead_convergent_ABYTES);
+}
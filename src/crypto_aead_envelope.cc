@@ -0,0 +1,252 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "sodium_stats.h"
+
+/**
+ * Envelope encryption with XChaCha20-Poly1305.
+ *
+ * Every object is encrypted under its own random data key (DEK), and the
+ * DEK is stored wrapped, encrypted under a key encryption key (KEK). Both
+ * use `crypto_aead_xchacha20poly1305_ietf` with random nonces, which the
+ * 24 byte nonces make safe, and the same additional data:
+ *
+ *     wrapped key: nonce (24) | DEK encrypted under the KEK (32 + 16)
+ *     cipher text: nonce (24) | message encrypted under the DEK (+ 16)
+ *
+ * The DEK only lives on the stack of the call and is wiped before it
+ * returns, except in `crypto_aead_envelope_keygen`, which hands DEKs out.
+ */
+#define crypto_aead_envelope_KEYBYTES crypto_aead_xchacha20poly1305_ietf_KEYBYTES
+#define crypto_aead_envelope_NPUBBYTES crypto_aead_xchacha20poly1305_ietf_NPUBBYTES
+#define crypto_aead_envelope_ABYTES \
+    (crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES)
+#define crypto_aead_envelope_WRAPPEDBYTES \
+    (crypto_aead_envelope_ABYTES + crypto_aead_envelope_KEYBYTES)
+
+// Encrypt `m` as nonce | cipher text at `out`, with a random nonce
+static int envelope_seal(unsigned char* out, const unsigned char* m, size_t mlen,
+                         const unsigned char* ad, size_t adlen, const unsigned char* key) {
+    randombytes_buf(out, crypto_aead_envelope_NPUBBYTES);
+    return SODIUM_STAT(aead_xchacha20poly1305_ietf, mlen, mlen + crypto_aead_xchacha20poly1305_ietf_ABYTES,
+        crypto_aead_xchacha20poly1305_ietf_encrypt(out + crypto_aead_envelope_NPUBBYTES, NULL,
+            m, mlen, ad, adlen, NULL, out, key));
+}
+
+static int envelope_open(unsigned char* m, const unsigned char* c, size_t clen,
+                         const unsigned char* ad, size_t adlen, const unsigned char* key) {
+    return SODIUM_STAT(aead_xchacha20poly1305_ietf, clen - crypto_aead_envelope_NPUBBYTES,
+        clen - crypto_aead_envelope_ABYTES,
+        crypto_aead_xchacha20poly1305_ietf_decrypt(m, NULL, NULL,
+            c + crypto_aead_envelope_NPUBBYTES, clen - crypto_aead_envelope_NPUBBYTES,
+            ad, adlen, c, key));
+}
+
+/**
+ * crypto_aead_envelope_seal(message, additionalData, kek)
+ *
+ * Generate a DEK, wrap it under `kek` and encrypt `message` under it, in
+ * one call.
+ *
+ * Parameters:
+ *  [in] message          the message to encrypt
+ *  [in] additionalData   authenticated with both the message and the DEK,
+ *                        or null
+ *  [in] kek              `crypto_aead_envelope_KEYBYTES` key encryption key
+ *
+ * Returns `{ wrappedKey, cipherText }`: `crypto_aead_envelope_WRAPPEDBYTES`
+ * and `message.length + crypto_aead_envelope_ABYTES` bytes
+ */
+NAPI_METHOD(crypto_aead_envelope_seal) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, additional data, and kek are required");
+    ARG_TO_UCHAR_BUFFER_RANGE(m);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(kek, crypto_aead_envelope_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(wrapped, crypto_aead_envelope_WRAPPEDBYTES);
+    NEW_BUFFER_AND_PTR(c, m_size + crypto_aead_envelope_ABYTES);
+
+    unsigned char dek[crypto_aead_envelope_KEYBYTES];
+    crypto_aead_xchacha20poly1305_ietf_keygen(dek);
+    int rc = envelope_seal(wrapped_ptr, dek, sizeof dek, ad, ad_size, kek);
+    if( rc == 0 ) {
+        rc = envelope_seal(c_ptr, m, m_size, ad, ad_size, dek);
+    }
+    sodium_memzero(dek, sizeof dek);
+    if( rc != 0 ) {
+        return NAPI_NULL;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "wrappedKey"), wrapped);
+    result.Set(Napi::String::New(env, "cipherText"), c);
+    return result;
+}
+
+/**
+ * crypto_aead_envelope_open(wrappedKey, cipherText, additionalData, kek)
+ *
+ * Unwrap the DEK with `kek` and decrypt `cipherText` with it.
+ *
+ * Returns the message, or null if the key or the message does not verify
+ */
+NAPI_METHOD(crypto_aead_envelope_open) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments wrapped key, cipher text, additional data, and kek are required");
+    ARG_TO_UCHAR_BUFFER_LEN(wrapped, crypto_aead_envelope_WRAPPEDBYTES);
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
+    if( c_size < crypto_aead_envelope_ABYTES ) {
+        THROW_ERROR("argument cipher text is shorter than crypto_aead_envelope_ABYTES");
+    }
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_UCHAR_BUFFER_LEN(kek, crypto_aead_envelope_KEYBYTES);
+
+    unsigned char dek[crypto_aead_envelope_KEYBYTES];
+    if( envelope_open(dek, wrapped, wrapped_size, ad, ad_size, kek) != 0 ) {
+        return NAPI_NULL;
+    }
+
+    NEW_BUFFER_AND_PTR(m, c_size - crypto_aead_envelope_ABYTES);
+    int rc = envelope_open(m_ptr, c, c_size, ad, ad_size, dek);
+    sodium_memzero(dek, sizeof dek);
+    if( rc != 0 ) {
+        sodium_memzero(m_ptr, m.Length());
+        return NAPI_NULL;
+    }
+    return m;
+}
+
+/**
+ * crypto_aead_envelope_keygen(count, kek, [additionalData], [threads])
+ *
+ * Generate `count` DEKs and wrap each under `kek`, for objects encrypted
+ * later, one at a time, with `crypto_aead_xchacha20poly1305_ietf_encrypt`
+ * or an AeadContext.
+ *
+ * Returns `{ keys, wrappedKeys }`, each one Buffer of `count` entries back to
+ * back: `crypto_aead_envelope_KEYBYTES` keys and
+ * `crypto_aead_envelope_WRAPPEDBYTES` wrapped keys. `threads` splits large
+ * batches, the call still blocks
+ */
+NAPI_METHOD(crypto_aead_envelope_keygen) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments count and kek are required");
+    ARG_TO_NUMBER(count);
+    ARG_TO_UCHAR_BUFFER_LEN(kek, crypto_aead_envelope_KEYBYTES);
+    const unsigned char* ad = NULL;
+    size_t ad_size = 0;
+    if( info.Length() > 2 && !info[2].IsUndefined() ) {
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad_arg);
+        ad = ad_arg;
+        ad_size = ad_arg_size;
+    } else {
+        _arg++;
+    }
+    size_t threads = 1;
+    if( info.Length() > 3 && !info[3].IsUndefined() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+    if( count > SIZE_MAX / crypto_aead_envelope_WRAPPEDBYTES ) {
+        THROW_ERROR("argument count is too large");
+    }
+
+    NEW_BUFFER_AND_PTR(keys, count * crypto_aead_envelope_KEYBYTES);
+    NEW_BUFFER_AND_PTR(wrapped, count * crypto_aead_envelope_WRAPPEDBYTES);
+    randombytes_buf(keys_ptr, keys.Length());
+    sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            envelope_seal(wrapped_ptr + i * crypto_aead_envelope_WRAPPEDBYTES,
+                          keys_ptr + i * crypto_aead_envelope_KEYBYTES, crypto_aead_envelope_KEYBYTES,
+                          ad, ad_size, kek);
+        }
+    });
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "keys"), keys);
+    result.Set(Napi::String::New(env, "wrappedKeys"), wrapped);
+    return result;
+}
+
+/**
+ * crypto_aead_envelope_unwrap(wrappedKeys, kek, [additionalData], [threads])
+ *
+ * Unwrap DEKs made by `crypto_aead_envelope_seal` or `_keygen`.
+ * `wrappedKeys` is one wrapped key, an array of them, or one Buffer of them
+ * back to back.
+ *
+ * Returns the DEKs back to back, or null if any of them does not verify
+ */
+NAPI_METHOD(crypto_aead_envelope_unwrap) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments wrapped keys and kek are required");
+    size_t count = SODIUM_BATCH_ANY;
+    unsigned char* packed = NULL;
+    size_t packed_size = 0;
+    if( !info[_arg].IsArray() && sodium_arg_bytes(info[_arg], packed, packed_size) ) {
+        if( packed_size % crypto_aead_envelope_WRAPPEDBYTES != 0 ) {
+            THROW_ERROR("argument wrapped keys must be a multiple of crypto_aead_envelope_WRAPPEDBYTES bytes long");
+        }
+        count = packed_size / crypto_aead_envelope_WRAPPEDBYTES;
+    }
+    ARG_TO_BATCH_LEN(wrapped, count, crypto_aead_envelope_WRAPPEDBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(kek, crypto_aead_envelope_KEYBYTES);
+    const unsigned char* ad = NULL;
+    size_t ad_size = 0;
+    if( info.Length() > 2 && !info[2].IsUndefined() ) {
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad_arg);
+        ad = ad_arg;
+        ad_size = ad_arg_size;
+    } else {
+        _arg++;
+    }
+    size_t threads = 1;
+    if( info.Length() > 3 && !info[3].IsUndefined() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    NEW_BUFFER_AND_PTR(keys, count * crypto_aead_envelope_KEYBYTES);
+    std::vector<unsigned char> ok(count, 0);
+    sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ok[i] = envelope_open(keys_ptr + i * crypto_aead_envelope_KEYBYTES,
+                                  wrapped[i].data, wrapped[i].size, ad, ad_size, kek) == 0;
+        }
+    });
+    for(size_t i = 0; i < count; i++) {
+        if( !ok[i] ) {
+            sodium_memzero(keys_ptr, keys.Length());
+            return NAPI_NULL;
+        }
+    }
+    return keys;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_aead_envelope(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_aead_envelope_seal);
+    EXPORT(crypto_aead_envelope_open);
+    EXPORT(crypto_aead_envelope_keygen);
+    EXPORT(crypto_aead_envelope_unwrap);
+
+    EXPORT_INT(crypto_aead_envelope_KEYBYTES);
+    EXPORT_INT(crypto_aead_envelope_NPUBBYTES);
+    EXPORT_INT(crypto_aead_envelope_ABYTES);
+    EXPORT_INT(crypto_aead_envelope_WRAPPEDBYTES);
+}
@@ -0,0 +1,497 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <vector>
+
+#include "node_sodium.h"
+#include "sodium_memory.h"
+#include "sodium_stats.h"
+
+// AES-256 blocks with the round keys of a state, in the vendored AES-GCM code
+extern "C" {
+int crypto_aead_aes256gcm_encrypt_blocks_afternm(unsigned char *out,
+                                                 const unsigned char *in,
+                                                 size_t nblocks,
+                                                 const crypto_aead_aes256gcm_state *ctx_);
+}
+
+/**
+ * PacketProtector:
+ * QUIC style packet protection, payload AEAD and header protection in one call
+ *
+ * Protecting a packet as RFC 9001 does takes an AEAD over the payload, with
+ * the header as additional data and the IV xored with the packet number as
+ * nonce, then a mask computed from a sample of the cipher text and xored
+ * over the low bits of the first byte and the packet number. A protector
+ * holds the three keys in one `sodium_malloc` block made read only and
+ * does both steps in place on the datagram, in one native call.
+ *
+ *    var p = new sodium.PacketProtector(algorithm, key, iv, hpKey);
+ *
+ * ~ algorithm (String): `aes256gcm`, with AES-256 header protection, or
+ *   `chacha20poly1305_ietf`, with ChaCha20 header protection
+ * ~ key (Buffer): the packet key, `crypto_aead_<algorithm>_KEYBYTES` long
+ * ~ iv (Buffer): the 12 byte packet IV
+ * ~ hpKey (Buffer): the 32 byte header protection key
+ *
+ * Properties:
+ *
+ * ~ PacketProtector.ABYTES, SAMPLEBYTES: the tag and sample lengths
+ *
+ * Methods:
+ *
+ * ~ protect(packet, headerLength, pnLength, packetNumber, payloadLength):
+ *   `packet` holds the header, whose last `pnLength` bytes are left for the
+ *   packet number, then the payload, then ABYTES free bytes. Writes the
+ *   truncated packet number and its length bits, encrypts the payload and
+ *   masks the header. Returns the packet length
+ * ~ unprotect(packet, pnOffset, largestPacketNumber, [length]): removes the
+ *   header protection, decodes the packet number against the largest one
+ *   received, -1 for none, and decrypts the payload in place. The first
+ *   `length` bytes of `packet` are the packet, all of them by default.
+ *   Returns the packet number, or null if the packet does not verify, in
+ *   which case it must be dropped
+ * ~ protectBatch(buffer, segmentSize, headerLength, pnLength,
+ *   firstPacketNumber, payloadLengths): protect a burst of packets laid out
+ *   every `segmentSize` bytes, as a UDP GSO send wants them, with
+ *   consecutive packet numbers. Header protection masks are computed for
+ *   the whole burst at once. Returns the bytes to send
+ * ~ unprotectBatch(buffer, segmentSize, pnOffset, largestPacketNumber,
+ *   [packetNumbers]): unprotect the packets of a GRO receive, every
+ *   `segmentSize` bytes, the last one possibly shorter. Fills and returns
+ *   `packetNumbers`, a Float64Array, with each packet number or -1
+ * ~ dispose(): wipes and frees the keys. Later calls throw
+ */
+
+#define PACKET_ABYTES 16
+#define PACKET_SAMPLEBYTES 16
+#define PACKET_IVBYTES 12
+#define PACKET_HPKEYBYTES 32
+#define PACKET_MAX_PN_BYTES 4
+#define PACKET_MAX_PN ((uint64_t) 1 << 62)
+
+// Bursts whose masks are computed at once
+#define PACKET_BATCH_MAX 64
+
+enum PacketCipher {
+    PACKET_AES256GCM,
+    PACKET_CHACHA20POLY1305
+};
+
+// For ChaCha20 only the first 32 bytes of each state are used, as the key
+struct PacketKeys {
+    crypto_aead_aes256gcm_state aead;
+    crypto_aead_aes256gcm_state hp;
+    unsigned char iv[PACKET_IVBYTES];
+};
+
+#define PACKET_KEYS_SIZE ((sizeof(PacketKeys) + 63) & ~(size_t) 63)
+
+// RFC 9000, A.3
+static uint64_t packet_number_decode(int64_t largest, uint64_t truncated, size_t pn_length) {
+    int64_t expected = largest + 1;
+    int64_t win = (int64_t) 1 << (pn_length * 8);
+    int64_t hwin = win / 2;
+    int64_t candidate = (expected & ~(win - 1)) | (int64_t) truncated;
+
+    if( candidate <= expected - hwin && candidate < (int64_t) PACKET_MAX_PN - win ) {
+        return (uint64_t) (candidate + win);
+    }
+    if( candidate > expected + hwin && candidate >= win ) {
+        return (uint64_t) (candidate - win);
+    }
+    return (uint64_t) candidate;
+}
+
+// Xor the mask over the first byte, 4 or 5 bits of it, and the packet number
+static void packet_mask(unsigned char* packet, size_t pn_offset, size_t pn_length,
+                        const unsigned char* mask) {
+    packet[0] ^= mask[0] & ((packet[0] & 0x80) ? 0x0f : 0x1f);
+    for(size_t i = 0; i < pn_length; i++) {
+        packet[pn_offset + i] ^= mask[1 + i];
+    }
+}
+
+class PacketProtector : public Napi::ObjectWrap<PacketProtector> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "PacketProtector", {
+            InstanceMethod("protect", &PacketProtector::Protect),
+            InstanceMethod("unprotect", &PacketProtector::Unprotect),
+            InstanceMethod("protectBatch", &PacketProtector::ProtectBatch),
+            InstanceMethod("unprotectBatch", &PacketProtector::UnprotectBatch),
+            InstanceMethod("dispose", &PacketProtector::Dispose)
+        });
+        ctor.Set("ABYTES", Napi::Number::New(env, PACKET_ABYTES));
+        ctor.Set("SAMPLEBYTES", Napi::Number::New(env, PACKET_SAMPLEBYTES));
+        exports.Set(Napi::String::New(env, "PacketProtector"), ctor);
+    }
+
+    PacketProtector(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<PacketProtector>(info), keys(NULL) {
+        Napi::Env env = info.Env();
+
+        unsigned char *key = NULL, *iv = NULL, *hp = NULL;
+        size_t key_size = 0, iv_size = 0, hp_size = 0;
+        if( info.Length() < 4 || !info[0].IsString() || !sodium_arg_bytes(info[1], key, key_size) ||
+            !sodium_arg_bytes(info[2], iv, iv_size) || !sodium_arg_bytes(info[3], hp, hp_size) ) {
+            Napi::TypeError::New(env, "arguments must be: algorithm name, key, iv and hpKey buffers").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::string name = info[0].As<Napi::String>().Utf8Value();
+        if( name == "aes256gcm" ) {
+            if( crypto_aead_aes256gcm_is_available() != 1 ) {
+                Napi::Error::New(env, "aes256gcm is not supported by this CPU").ThrowAsJavaScriptException();
+                return;
+            }
+            cipher = PACKET_AES256GCM;
+        } else if( name == "chacha20poly1305_ietf" ) {
+            cipher = PACKET_CHACHA20POLY1305;
+        } else {
+            Napi::Error::New(env, "unknown packet protection algorithm " + name).ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( key_size != 32 || iv_size != PACKET_IVBYTES || hp_size != PACKET_HPKEYBYTES ) {
+            Napi::Error::New(env, "arguments key and hpKey must be 32 bytes long, iv 12 bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+
+        // A multiple of 64 bytes, so sodium_malloc aligns the AES states
+        keys = (PacketKeys*) sodium_secret_alloc(env, PACKET_KEYS_SIZE);
+        if( keys == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the keys").ThrowAsJavaScriptException();
+            return;
+        }
+        if( cipher == PACKET_AES256GCM ) {
+            crypto_aead_aes256gcm_beforenm(&keys->aead, key);
+            crypto_aead_aes256gcm_beforenm(&keys->hp, hp);
+        } else {
+            memcpy(&keys->aead, key, crypto_aead_chacha20poly1305_ietf_KEYBYTES);
+            memcpy(&keys->hp, hp, crypto_stream_chacha20_ietf_KEYBYTES);
+        }
+        memcpy(keys->iv, iv, PACKET_IVBYTES);
+        sodium_secret_readonly(keys);
+    }
+
+    ~PacketProtector() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( keys != NULL ) {
+            sodium_secret_free(Env(), keys, PACKET_KEYS_SIZE);
+            keys = NULL;
+        }
+    }
+
+    void Nonce(unsigned char* npub, uint64_t pn) {
+        memcpy(npub, keys->iv, PACKET_IVBYTES);
+        for(size_t i = 0; i < 8; i++) {
+            npub[PACKET_IVBYTES - 1 - i] ^= (unsigned char) (pn >> (8 * i));
+        }
+    }
+
+    // Masks of n samples, 16 bytes each back to back in `samples`
+    void Masks(unsigned char* masks, const unsigned char* samples, size_t n) {
+        if( cipher == PACKET_AES256GCM ) {
+            crypto_aead_aes256gcm_encrypt_blocks_afternm(masks, samples, n, &keys->hp);
+            return;
+        }
+        static const unsigned char zero[5] = { 0 };
+        for(size_t i = 0; i < n; i++) {
+            const unsigned char* sample = samples + i * PACKET_SAMPLEBYTES;
+            uint32_t counter = (uint32_t) sample[0] | ((uint32_t) sample[1] << 8) |
+                               ((uint32_t) sample[2] << 16) | ((uint32_t) sample[3] << 24);
+            crypto_stream_chacha20_ietf_xor_ic(masks + i * PACKET_SAMPLEBYTES, zero, sizeof zero,
+                                               sample + 4, counter, (const unsigned char*) &keys->hp);
+        }
+    }
+
+    int Seal(unsigned char* packet, size_t header_length, size_t payload_length, uint64_t pn) {
+        unsigned char npub[PACKET_IVBYTES];
+        Nonce(npub, pn);
+        unsigned char* m = packet + header_length;
+        if( cipher == PACKET_AES256GCM ) {
+            return SODIUM_STAT(aead_aes256gcm, payload_length, payload_length + PACKET_ABYTES,
+                crypto_aead_aes256gcm_encrypt_detached_afternm(m, m + payload_length, NULL, m, payload_length,
+                                                               packet, header_length, NULL, npub, &keys->aead));
+        }
+        return SODIUM_STAT(aead_chacha20poly1305_ietf, payload_length, payload_length + PACKET_ABYTES,
+            crypto_aead_chacha20poly1305_ietf_encrypt_detached(m, m + payload_length, NULL, m, payload_length,
+                                                               packet, header_length, NULL, npub,
+                                                               (const unsigned char*) &keys->aead));
+    }
+
+    int Open(unsigned char* packet, size_t header_length, size_t length, uint64_t pn) {
+        unsigned char npub[PACKET_IVBYTES];
+        Nonce(npub, pn);
+        unsigned char* c = packet + header_length;
+        size_t c_size = length - header_length - PACKET_ABYTES;
+        if( cipher == PACKET_AES256GCM ) {
+            return SODIUM_STAT(aead_aes256gcm, length - header_length, c_size,
+                crypto_aead_aes256gcm_decrypt_detached_afternm(c, NULL, c, c_size, c + c_size,
+                                                               packet, header_length, npub, &keys->aead));
+        }
+        return SODIUM_STAT(aead_chacha20poly1305_ietf, length - header_length, c_size,
+            crypto_aead_chacha20poly1305_ietf_decrypt_detached(c, NULL, c, c_size, c + c_size,
+                                                               packet, header_length, npub,
+                                                               (const unsigned char*) &keys->aead));
+    }
+
+    // Write the truncated packet number and its length bits
+    static void WritePacketNumber(unsigned char* packet, size_t header_length, size_t pn_length, uint64_t pn) {
+        packet[0] = (unsigned char) ((packet[0] & ~0x03) | (pn_length - 1));
+        for(size_t i = 0; i < pn_length; i++) {
+            packet[header_length - 1 - i] = (unsigned char) (pn >> (8 * i));
+        }
+    }
+
+    /**
+     * Remove the header protection of the `length` byte packet and decrypt
+     * it. Returns the packet number, or -1
+     */
+    int64_t UnprotectPacket(unsigned char* packet, size_t length, size_t pn_offset, int64_t largest) {
+        if( pn_offset + PACKET_MAX_PN_BYTES + PACKET_SAMPLEBYTES > length ) {
+            return -1;
+        }
+        alignas(16) unsigned char mask[PACKET_SAMPLEBYTES];
+        Masks(mask, packet + pn_offset + PACKET_MAX_PN_BYTES, 1);
+
+        packet[0] ^= mask[0] & ((packet[0] & 0x80) ? 0x0f : 0x1f);
+        size_t pn_length = (packet[0] & 0x03) + 1;
+        uint64_t truncated = 0;
+        for(size_t i = 0; i < pn_length; i++) {
+            packet[pn_offset + i] ^= mask[1 + i];
+            truncated = (truncated << 8) | packet[pn_offset + i];
+        }
+
+        size_t header_length = pn_offset + pn_length;
+        if( length < header_length + PACKET_ABYTES ) {
+            return -1;
+        }
+        uint64_t pn = packet_number_decode(largest, truncated, pn_length);
+        if( pn >= PACKET_MAX_PN || Open(packet, header_length, length, pn) != 0 ) {
+            return -1;
+        }
+        return (int64_t) pn;
+    }
+
+#define CHECK_CONTEXT() \
+    if( keys == NULL ) { \
+        THROW_ERROR("PacketProtector was disposed"); \
+    }
+
+// A packet number between 0 and 2^53 - 1, or -1 for none when ALLOW_NONE
+#define ARG_TO_PACKET_NUMBER(NAME, ALLOW_NONE) \
+    int64_t NAME; \
+    { \
+        Napi::Value NAME ## _value = info[_arg]; \
+        double NAME ## _number = NAME ## _value.IsNumber() ? NAME ## _value.As<Napi::Number>().DoubleValue() : -2; \
+        if( NAME ## _number != (double) (int64_t) NAME ## _number || NAME ## _number > 9007199254740991.0 || \
+            NAME ## _number < ((ALLOW_NONE) ? -1 : 0) ) { \
+            THROW_ERROR("argument " #NAME " must be an integer packet number"); \
+        } \
+        NAME = (int64_t) NAME ## _number; \
+    } \
+    _arg++
+
+    Napi::Value Protect(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(5, "arguments packet, headerLength, pnLength, packetNumber and payloadLength are required");
+        ARG_TO_UCHAR_BUFFER(packet);
+        ARG_TO_NUMBER(headerLength);
+        ARG_TO_NUMBER(pnLength);
+        ARG_TO_PACKET_NUMBER(packetNumber, false);
+        ARG_TO_NUMBER(payloadLength);
+
+        if( pnLength < 1 || pnLength > PACKET_MAX_PN_BYTES || headerLength <= pnLength ) {
+            THROW_ERROR("argument pnLength must be 1 to 4, and less than headerLength");
+        }
+        if( headerLength > packet_size || payloadLength > packet_size - headerLength ||
+            packet_size - headerLength - payloadLength < PACKET_ABYTES ) {
+            THROW_ERROR("argument packet must hold the header, the payload and PacketProtector.ABYTES bytes");
+        }
+        if( pnLength + payloadLength < PACKET_MAX_PN_BYTES ) {
+            THROW_ERROR("the payload is too short to sample, it must be padded");
+        }
+
+        size_t pn_offset = headerLength - pnLength;
+        WritePacketNumber(packet, headerLength, pnLength, packetNumber);
+        Seal(packet, headerLength, payloadLength, packetNumber);
+
+        alignas(16) unsigned char mask[PACKET_SAMPLEBYTES];
+        Masks(mask, packet + pn_offset + PACKET_MAX_PN_BYTES, 1);
+        packet_mask(packet, pn_offset, pnLength, mask);
+
+        return Napi::Number::New(env, (double) (headerLength + payloadLength + PACKET_ABYTES));
+    }
+
+    Napi::Value Unprotect(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(3, "arguments packet, pnOffset and largestPacketNumber are required");
+        ARG_TO_UCHAR_BUFFER(packet);
+        ARG_TO_NUMBER(pnOffset);
+        ARG_TO_PACKET_NUMBER(largestPacketNumber, true);
+        size_t length = packet_size;
+        if( info.Length() > 3 && !info[3].IsUndefined() ) {
+            ARG_TO_NUMBER(packetLength);
+            if( packetLength > packet_size ) {
+                THROW_ERROR("argument length is larger than the packet buffer");
+            }
+            length = packetLength;
+        }
+
+        int64_t pn = UnprotectPacket(packet, length, pnOffset, largestPacketNumber);
+        if( pn < 0 ) {
+            return NAPI_NULL;
+        }
+        return Napi::Number::New(env, (double) pn);
+    }
+
+    Napi::Value ProtectBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(6, "arguments buffer, segmentSize, headerLength, pnLength, firstPacketNumber and payloadLengths are required");
+        ARG_TO_UCHAR_BUFFER(buffer);
+        ARG_TO_NUMBER(segmentSize);
+        ARG_TO_NUMBER(headerLength);
+        ARG_TO_NUMBER(pnLength);
+        ARG_TO_PACKET_NUMBER(firstPacketNumber, false);
+        if( !info[_arg].IsTypedArray() && !info[_arg].IsArray() ) {
+            THROW_ERROR("argument payloadLengths must be an array or a typed array of numbers");
+        }
+        Napi::Object lengths = info[_arg].As<Napi::Object>();
+        uint32_t count = info[_arg].IsArray() ? info[_arg].As<Napi::Array>().Length()
+                                              : (uint32_t) info[_arg].As<Napi::TypedArray>().ElementLength();
+
+        if( pnLength < 1 || pnLength > PACKET_MAX_PN_BYTES || headerLength <= pnLength ) {
+            THROW_ERROR("argument pnLength must be 1 to 4, and less than headerLength");
+        }
+        if( count == 0 ) {
+            return Napi::Number::New(env, 0);
+        }
+        if( segmentSize == 0 || (count - 1) > (buffer_size / segmentSize) ) {
+            THROW_ERROR("argument buffer is too small for the packets");
+        }
+
+        // Check every packet before touching any
+        std::vector<size_t> payload(count);
+        for(uint32_t i = 0; i < count; i++) {
+            Napi::Value v = lengths.Get(i);
+            double d = v.IsNumber() ? v.As<Napi::Number>().DoubleValue() : -1;
+            if( d < 0 || d != (double) (size_t) d ) {
+                THROW_ERROR("argument payloadLengths must hold non negative integers");
+            }
+            payload[i] = (size_t) d;
+            size_t room = buffer_size - (size_t) i * segmentSize;
+            if( room > segmentSize ) {
+                room = segmentSize;
+            }
+            if( payload[i] > room || room - payload[i] < headerLength + PACKET_ABYTES ) {
+                THROW_ERROR("a packet does not fit in its segment");
+            }
+            if( pnLength + payload[i] < PACKET_MAX_PN_BYTES ) {
+                THROW_ERROR("the payload is too short to sample, it must be padded");
+            }
+        }
+        if( (uint64_t) firstPacketNumber + count > PACKET_MAX_PN ) {
+            THROW_ERROR("argument firstPacketNumber is too large");
+        }
+
+        size_t pn_offset = headerLength - pnLength;
+        alignas(16) unsigned char samples[PACKET_BATCH_MAX * PACKET_SAMPLEBYTES];
+        alignas(16) unsigned char masks[PACKET_BATCH_MAX * PACKET_SAMPLEBYTES];
+        for(uint32_t first = 0; first < count; first += PACKET_BATCH_MAX) {
+            uint32_t n = count - first < PACKET_BATCH_MAX ? count - first : PACKET_BATCH_MAX;
+            for(uint32_t j = 0; j < n; j++) {
+                unsigned char* packet = buffer + (size_t) (first + j) * segmentSize;
+                uint64_t pn = (uint64_t) firstPacketNumber + first + j;
+                WritePacketNumber(packet, headerLength, pnLength, pn);
+                Seal(packet, headerLength, payload[first + j], pn);
+                memcpy(samples + j * PACKET_SAMPLEBYTES, packet + pn_offset + PACKET_MAX_PN_BYTES,
+                       PACKET_SAMPLEBYTES);
+            }
+            Masks(masks, samples, n);
+            for(uint32_t j = 0; j < n; j++) {
+                packet_mask(buffer + (size_t) (first + j) * segmentSize, pn_offset, pnLength,
+                            masks + j * PACKET_SAMPLEBYTES);
+            }
+        }
+
+        return Napi::Number::New(env, (double) ((size_t) (count - 1) * segmentSize +
+                                                headerLength + payload[count - 1] + PACKET_ABYTES));
+    }
+
+    Napi::Value UnprotectBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(4, "arguments buffer, segmentSize, pnOffset and largestPacketNumber are required");
+        ARG_TO_UCHAR_BUFFER(buffer);
+        ARG_TO_NUMBER(segmentSize);
+        ARG_TO_NUMBER(pnOffset);
+        ARG_TO_PACKET_NUMBER(largestPacketNumber, true);
+        if( segmentSize == 0 ) {
+            THROW_ERROR("argument segmentSize must not be 0");
+        }
+        size_t count = (buffer_size + segmentSize - 1) / segmentSize;
+
+        Napi::Float64Array numbers;
+        if( info.Length() > 4 && !info[4].IsUndefined() ) {
+            if( !info[4].IsTypedArray() ||
+                info[4].As<Napi::TypedArray>().TypedArrayType() != napi_float64_array ) {
+                THROW_ERROR("argument packetNumbers must be a Float64Array");
+            }
+            numbers = info[4].As<Napi::Float64Array>();
+            if( numbers.ElementLength() < count ) {
+                THROW_ERROR("argument packetNumbers must have an element per packet");
+            }
+        } else {
+            numbers = Napi::Float64Array::New(env, count);
+        }
+
+        int64_t largest = largestPacketNumber;
+        for(size_t i = 0; i < count; i++) {
+            size_t offset = i * segmentSize;
+            size_t length = buffer_size - offset < segmentSize ? buffer_size - offset : segmentSize;
+            int64_t pn = UnprotectPacket(buffer + offset, length, pnOffset, largest);
+            if( pn > largest ) {
+                largest = pn;
+            }
+            numbers[i] = (double) pn;
+        }
+        return numbers;
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+#undef ARG_TO_PACKET_NUMBER
+
+    PacketKeys* keys;
+    PacketCipher cipher;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_aead_packet(Napi::Env env, Napi::Object exports) {
+    PacketProtector::Init(env, exports);
+}
@@ -0,0 +1,355 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <algorithm>
+#include <cstring>
+
+#include "node_sodium.h"
+#include "sodium_memory.h"
+#include "sodium_stats.h"
+
+/**
+ * TransportSession:
+ * Counter nonce datagram encryption with a replay window, as in WireGuard
+ *
+ * Holds a sending and a receiving ChaCha20-Poly1305-IETF key in one block
+ * allocated with `sodium_malloc` and made read only, the next sending
+ * counter and the receiving replay window. Each packet is sealed and opened
+ * in place, in one call, with no allocation:
+ *
+ *     counter (8 bytes, little endian) | cipher text | tag (16 bytes)
+ *
+ * The nonce is four zero bytes and the counter, and the counter is
+ * authenticated through it. The window is the bitmap of RFC 6479 over the
+ * last TRANSPORT_WINDOW counters: a packet is accepted once, in any order,
+ * unless it is older than the window. Forged packets do not move it.
+ *
+ *    var session = new sodium.TransportSession(sendKey, receiveKey);
+ *
+ * ~ sendKey (Buffer): `crypto_aead_chacha20poly1305_ietf_KEYBYTES` key of
+ *   our packets, the peer's receiveKey
+ * ~ receiveKey (Buffer): key of the peer's packets. Must differ from sendKey
+ *
+ * Properties:
+ *
+ * ~ sendCounter (Number): counter of the next packet sealed
+ * ~ TransportSession.HEADERBYTES, ABYTES, OVERHEAD, WINDOW: the counter
+ *   length, the tag length, their sum, and the window in packets
+ *
+ * Methods:
+ *
+ * ~ seal(packet, length): encrypt the `length` bytes at
+ *   `packet[HEADERBYTES]`, writing the counter before them and the tag
+ *   after. `packet` must hold `length + OVERHEAD` bytes. Returns the packet
+ *   length. Throws once the counter space is used up
+ * ~ open(packet): check and decrypt the datagram `packet`, in place.
+ *   Returns the message length, the message being at `packet[HEADERBYTES]`,
+ *   or null if the packet is short, forged, replayed or too old
+ * ~ openBatch(packets, [lengths]): open an array of datagrams, in order.
+ *   Fills and returns `lengths`, an Int32Array, with the message length of
+ *   each packet or -1
+ * ~ stats(): `{ sent, received, replayed, rejected }`
+ * ~ dispose(): wipes and frees the keys. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var session = new sodium.TransportSession(myKey, peerKey);
+ *
+ *     message.copy(packet, sodium.TransportSession.HEADERBYTES);
+ *     socket.send(packet, 0, session.seal(packet, message.length));
+ *
+ *     socket.on('message', function(packet) {
+ *         var length = session.open(packet);
+ *         if( length !== null ) {
+ *             deliver(packet.subarray(8, 8 + length));
+ *         }
+ *     });
+ */
+
+#define TRANSPORT_HEADERBYTES 8
+#define TRANSPORT_ABYTES crypto_aead_chacha20poly1305_ietf_ABYTES
+#define TRANSPORT_OVERHEAD (TRANSPORT_HEADERBYTES + TRANSPORT_ABYTES)
+
+// Window bitmap words. One word is being rotated in, so the window is one
+// word short of the bitmap
+#define TRANSPORT_WORDS 128
+#define TRANSPORT_WINDOW ((TRANSPORT_WORDS - 1) * 64)
+
+// Counters this close to 2^64 are never sent nor accepted
+#define TRANSPORT_REJECT_AFTER (UINT64_MAX - TRANSPORT_WINDOW - 1)
+
+struct TransportKeys {
+    unsigned char send[crypto_aead_chacha20poly1305_ietf_KEYBYTES];
+    unsigned char receive[crypto_aead_chacha20poly1305_ietf_KEYBYTES];
+};
+
+struct ReplayWindow {
+    uint64_t next;  // greatest accepted counter + 1, 0 before the first
+    uint64_t bits[TRANSPORT_WORDS];
+};
+
+// True if `counter` was not accepted yet and is inside the window
+static bool replay_fresh(const ReplayWindow& w, uint64_t counter) {
+    if( counter >= TRANSPORT_REJECT_AFTER ) {
+        return false;
+    }
+    counter++;
+    if( counter + TRANSPORT_WINDOW < w.next ) {
+        return false;
+    }
+    if( counter > w.next ) {
+        return true;
+    }
+    return ((w.bits[(counter / 64) % TRANSPORT_WORDS] >> (counter % 64)) & 1) == 0;
+}
+
+// Record `counter`, sliding the window when it is the greatest yet
+static void replay_accept(ReplayWindow& w, uint64_t counter) {
+    counter++;
+    uint64_t index = counter / 64;
+    if( counter > w.next ) {
+        uint64_t current = w.next / 64;
+        uint64_t top = std::min(index - current, (uint64_t) TRANSPORT_WORDS);
+        for(uint64_t i = 1; i <= top; i++) {
+            w.bits[(current + i) % TRANSPORT_WORDS] = 0;
+        }
+        w.next = counter;
+    }
+    w.bits[index % TRANSPORT_WORDS] |= (uint64_t) 1 << (counter % 64);
+}
+
+static void transport_nonce(unsigned char* npub, const unsigned char* header) {
+    memset(npub, 0, crypto_aead_chacha20poly1305_ietf_NPUBBYTES - TRANSPORT_HEADERBYTES);
+    memcpy(npub + crypto_aead_chacha20poly1305_ietf_NPUBBYTES - TRANSPORT_HEADERBYTES,
+           header, TRANSPORT_HEADERBYTES);
+}
+
+class TransportSession : public Napi::ObjectWrap<TransportSession> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "TransportSession", {
+            InstanceMethod("seal", &TransportSession::Seal),
+            InstanceMethod("open", &TransportSession::Open),
+            InstanceMethod("openBatch", &TransportSession::OpenBatch),
+            InstanceMethod("stats", &TransportSession::Stats),
+            InstanceMethod("dispose", &TransportSession::Dispose),
+            InstanceAccessor("sendCounter", &TransportSession::SendCounter, nullptr)
+        });
+        ctor.Set("HEADERBYTES", Napi::Number::New(env, TRANSPORT_HEADERBYTES));
+        ctor.Set("ABYTES", Napi::Number::New(env, TRANSPORT_ABYTES));
+        ctor.Set("OVERHEAD", Napi::Number::New(env, TRANSPORT_OVERHEAD));
+        ctor.Set("WINDOW", Napi::Number::New(env, TRANSPORT_WINDOW));
+        exports.Set(Napi::String::New(env, "TransportSession"), ctor);
+    }
+
+    TransportSession(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<TransportSession>(info), keys(NULL), send_counter(0),
+          sent(0), received(0), replayed(0), rejected(0) {
+        Napi::Env env = info.Env();
+
+        unsigned char *send = NULL, *receive = NULL;
+        size_t send_size = 0, receive_size = 0;
+        if( info.Length() < 2 || !sodium_arg_bytes(info[0], send, send_size) ||
+            !sodium_arg_bytes(info[1], receive, receive_size) ) {
+            Napi::TypeError::New(env, "arguments sendKey and receiveKey must be buffers").ThrowAsJavaScriptException();
+            return;
+        }
+        if( send_size != crypto_aead_chacha20poly1305_ietf_KEYBYTES ||
+            receive_size != crypto_aead_chacha20poly1305_ietf_KEYBYTES ) {
+            Napi::Error::New(env, "arguments sendKey and receiveKey must be "
+                                  "crypto_aead_chacha20poly1305_ietf_KEYBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+        // Both ends would seal packets under the same key and nonces
+        if( sodium_memcmp(send, receive, crypto_aead_chacha20poly1305_ietf_KEYBYTES) == 0 ) {
+            Napi::Error::New(env, "arguments sendKey and receiveKey must differ").ThrowAsJavaScriptException();
+            return;
+        }
+
+        keys = (TransportKeys*) sodium_secret_alloc(env, sizeof(TransportKeys));
+        if( keys == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the keys").ThrowAsJavaScriptException();
+            return;
+        }
+        memcpy(keys->send, send, sizeof keys->send);
+        memcpy(keys->receive, receive, sizeof keys->receive);
+        sodium_secret_readonly(keys);
+
+        memset(&window, 0, sizeof window);
+    }
+
+    ~TransportSession() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( keys != NULL ) {
+            sodium_secret_free(Env(), keys, sizeof(TransportKeys));
+            keys = NULL;
+        }
+    }
+
+    // Length of the message opened in place in `packet`, or -1
+    int64_t OpenPacket(unsigned char* packet, size_t packet_size) {
+        if( packet_size < TRANSPORT_OVERHEAD ) {
+            rejected++;
+            return -1;
+        }
+
+        uint64_t counter = 0;
+        for(int i = TRANSPORT_HEADERBYTES - 1; i >= 0; i--) {
+            counter = (counter << 8) | packet[i];
+        }
+        if( !replay_fresh(window, counter) ) {
+            replayed++;
+            return -1;
+        }
+
+        unsigned char npub[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+        transport_nonce(npub, packet);
+        unsigned char* c = packet + TRANSPORT_HEADERBYTES;
+        size_t c_size = packet_size - TRANSPORT_OVERHEAD;
+        if( SODIUM_STAT(aead_chacha20poly1305_ietf, packet_size, c_size,
+                crypto_aead_chacha20poly1305_ietf_decrypt_detached(c, NULL, c, c_size, c + c_size,
+                                                                   NULL, 0, npub, keys->receive)) != 0 ) {
+            rejected++;
+            return -1;
+        }
+
+        replay_accept(window, counter);
+        received++;
+        return (int64_t) c_size;
+    }
+
+#define CHECK_CONTEXT() \
+    if( keys == NULL ) { \
+        THROW_ERROR("TransportSession was disposed"); \
+    }
+
+    Napi::Value Seal(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments packet and length are required");
+        ARG_TO_UCHAR_BUFFER(packet);
+        ARG_TO_NUMBER(length);
+        if( length > packet_size || packet_size - length < TRANSPORT_OVERHEAD ) {
+            THROW_ERROR("argument packet must hold length + TransportSession.OVERHEAD bytes");
+        }
+        if( send_counter >= TRANSPORT_REJECT_AFTER ) {
+            THROW_ERROR("send counter is exhausted, the session must be rekeyed");
+        }
+
+        uint64_t counter = send_counter;
+        for(size_t i = 0; i < TRANSPORT_HEADERBYTES; i++) {
+            packet[i] = (unsigned char) (counter >> (8 * i));
+        }
+        unsigned char npub[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+        transport_nonce(npub, packet);
+
+        unsigned char* m = packet + TRANSPORT_HEADERBYTES;
+        SODIUM_STAT(aead_chacha20poly1305_ietf, length, length + TRANSPORT_OVERHEAD,
+            crypto_aead_chacha20poly1305_ietf_encrypt_detached(m, m + length, NULL, m, length,
+                                                               NULL, 0, NULL, npub, keys->send));
+        send_counter++;
+        sent++;
+        return Napi::Number::New(env, (double) (length + TRANSPORT_OVERHEAD));
+    }
+
+    Napi::Value Open(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument packet must be a buffer");
+        ARG_TO_UCHAR_BUFFER(packet);
+
+        int64_t length = OpenPacket(packet, packet_size);
+        if( length < 0 ) {
+            return NAPI_NULL;
+        }
+        return Napi::Number::New(env, (double) length);
+    }
+
+    Napi::Value OpenBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument packets must be an array of buffers");
+        if( !info[0].IsArray() ) {
+            THROW_ERROR("argument packets must be an array of buffers");
+        }
+        Napi::Array packets = info[0].As<Napi::Array>();
+        uint32_t count = packets.Length();
+
+        Napi::Int32Array lengths;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            if( !info[1].IsTypedArray() ||
+                info[1].As<Napi::TypedArray>().TypedArrayType() != napi_int32_array ) {
+                THROW_ERROR("argument lengths must be an Int32Array");
+            }
+            lengths = info[1].As<Napi::Int32Array>();
+            if( lengths.ElementLength() < count ) {
+                THROW_ERROR("argument lengths must have an element per packet");
+            }
+        } else {
+            lengths = Napi::Int32Array::New(env, count);
+        }
+
+        for(uint32_t i = 0; i < count; i++) {
+            unsigned char* packet = NULL;
+            size_t packet_size = 0;
+            if( !sodium_arg_bytes(packets.Get(i), packet, packet_size) ) {
+                THROW_ERROR("argument packets must be an array of buffers");
+            }
+            lengths[i] = (int32_t) OpenPacket(packet, packet_size);
+        }
+        return lengths;
+    }
+
+    Napi::Value Stats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "sent"), Napi::Number::New(env, sent));
+        result.Set(Napi::String::New(env, "received"), Napi::Number::New(env, received));
+        result.Set(Napi::String::New(env, "replayed"), Napi::Number::New(env, replayed));
+        result.Set(Napi::String::New(env, "rejected"), Napi::Number::New(env, rejected));
+        return result;
+    }
+
+    Napi::Value SendCounter(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, (double) send_counter);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    TransportKeys* keys;
+    uint64_t send_counter;
+    ReplayWindow window;
+
+    double sent;
+    double received;
+    double replayed;
+    double rejected;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_aead_transport(Napi::Env env, Napi::Object exports) {
+    TransportSession::Init(env, exports);
+}
@@ -0,0 +1,992 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "crypto_keypair_pool.h"
+#include "sodium_file_buffer.h"
+#include "sodium_memory.h"
+
+/**
+ * age v1 file encryption (https://age-encryption.org/v1) to X25519
+ * recipients, so files encrypted here open with `age -d` and the other way
+ * around.
+ *
+ * A random 16 byte file key is wrapped once per recipient: an ephemeral
+ * X25519 exchange with the recipient's public key, HKDF-SHA256 salted with
+ * the ephemeral and the recipient's public keys, and ChaCha20-Poly1305 with
+ * a zero nonce. The header lists one stanza per recipient and ends with an
+ * HMAC-SHA256, keyed from the file key, of everything before it.
+ *
+ *   header  = "age-encryption.org/v1\n"
+ *             "-> X25519 " base64(ephemeral key) "\n" base64(wrapped key) "\n"
+ *             ... one stanza per recipient
+ *             "--- " base64(header MAC) "\n"
+ *   payload = nonce (16) | chunks
+ *
+ * The payload key is HKDF-SHA256 of the file key salted with the nonce.
+ * The payload is cut in chunks of 64KB of plain text, each sealed with
+ * `crypto_aead_chacha20poly1305_ietf` under the nonce of its 11 byte big
+ * endian number and a last chunk flag. Only the last chunk may be short,
+ * and it is only empty when the whole payload is.
+ *
+ * Base64 is the standard alphabet without padding, and the header is read
+ * strictly: a non canonical encoding, a stanza body line over 64 columns
+ * or a header MAC that does not verify fails. Stanzas of other types, such
+ * as scrypt, are skipped.
+ */
+#define AGE_FILE_KEYBYTES 16
+#define AGE_KEYBYTES crypto_aead_chacha20poly1305_ietf_KEYBYTES
+#define AGE_X25519BYTES crypto_scalarmult_BYTES
+#define AGE_NONCEBYTES 16
+#define AGE_CHUNK_SIZE (64 * 1024)
+#define AGE_TAGBYTES crypto_aead_chacha20poly1305_ietf_ABYTES
+#define AGE_FRAME_SIZE (AGE_CHUNK_SIZE + AGE_TAGBYTES)
+#define AGE_COLUMNS 64
+
+// Largest header read, and the most recipients one file is written to,
+// which keeps its header well under that
+#define AGE_MAX_HEADER (1024 * 1024)
+#define AGE_MAX_RECIPIENTS 4096
+
+#define AGE_BASE64 sodium_base64_VARIANT_ORIGINAL_NO_PADDING
+
+static const char age_version[] = "age-encryption.org/v1\n";
+static const char age_x25519_info[] = "age-encryption.org/v1/X25519";
+
+// Payload key and the number of the next chunk
+struct AgePayload {
+    unsigned char key[AGE_KEYBYTES];
+    uint64_t counter;
+    bool done;
+};
+
+// HKDF-SHA256 of `ikm` into one 32 byte key
+static void age_hkdf(unsigned char* out, const unsigned char* salt, size_t salt_size,
+                     const unsigned char* ikm, size_t ikm_size, const char* info) {
+    static const unsigned char one = 1;
+    unsigned char prk[crypto_auth_hmacsha256_BYTES];
+    crypto_auth_hmacsha256_state state;
+
+    crypto_auth_hmacsha256_init(&state, salt, salt_size);
+    crypto_auth_hmacsha256_update(&state, ikm, ikm_size);
+    crypto_auth_hmacsha256_final(&state, prk);
+
+    crypto_auth_hmacsha256_init(&state, prk, sizeof prk);
+    crypto_auth_hmacsha256_update(&state, (const unsigned char*) info, strlen(info));
+    crypto_auth_hmacsha256_update(&state, &one, 1);
+    crypto_auth_hmacsha256_final(&state, out);
+
+    sodium_memzero(prk, sizeof prk);
+    sodium_memzero(&state, sizeof state);
+}
+
+static void age_payload_init(AgePayload* payload, const unsigned char* file_key, const unsigned char* nonce) {
+    age_hkdf(payload->key, nonce, AGE_NONCEBYTES, file_key, AGE_FILE_KEYBYTES, "payload");
+    payload->counter = 0;
+    payload->done = false;
+}
+
+// Chunk number, big endian, then the last chunk flag
+static void age_chunk_nonce(unsigned char* nonce, uint64_t counter, bool last) {
+    memset(nonce, 0, crypto_aead_chacha20poly1305_ietf_NPUBBYTES);
+    for(int i = 0; i < 8; i++) {
+        nonce[10 - i] = (unsigned char) (counter >> (8 * i));
+    }
+    nonce[11] = last ? 1 : 0;
+}
+
+/**
+ * Seal `n` bytes of plain text as the next chunks of `payload`, into
+ * `n + AGE_TAGBYTES` per started chunk of `out`. Unless `last`, `n` must be
+ * a non zero multiple of AGE_CHUNK_SIZE. Returns the bytes written
+ */
+static size_t age_seal(AgePayload* payload, unsigned char* out, const unsigned char* in, size_t n, bool last) {
+    unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    size_t pos = 0, length = 0;
+    do {
+        size_t m = n - pos < AGE_CHUNK_SIZE ? n - pos : AGE_CHUNK_SIZE;
+        age_chunk_nonce(nonce, payload->counter++, last && pos + m == n);
+        crypto_aead_chacha20poly1305_ietf_encrypt(out + length, NULL, in + pos, m, NULL, 0, NULL,
+                                                  nonce, payload->key);
+        length += m + AGE_TAGBYTES;
+        pos += m;
+    } while( pos < n );
+    payload->done = last;
+    return length;
+}
+
+// Open one chunk, and when it fails tell a forgery from a chunk in the
+// wrong place by trying the other value of the last chunk flag
+static const char* age_open_chunk(AgePayload* payload, unsigned char* out, const unsigned char* in,
+                                  size_t m, bool last) {
+    unsigned char nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+    age_chunk_nonce(nonce, payload->counter, last);
+    if( crypto_aead_chacha20poly1305_ietf_decrypt(out, NULL, NULL, in, m, NULL, 0, nonce, payload->key) == 0 ) {
+        payload->counter++;
+        return NULL;
+    }
+    age_chunk_nonce(nonce, payload->counter, !last);
+    if( crypto_aead_chacha20poly1305_ietf_decrypt(out, NULL, NULL, in, m, NULL, 0, nonce, payload->key) == 0 ) {
+        sodium_memzero(out, m - AGE_TAGBYTES);
+        return last ? "age payload truncated" : "age payload has data after the last chunk";
+    }
+    return "age chunk failed authentication";
+}
+
+/**
+ * Open `n` bytes of sealed chunks of `payload` into `out`, adding the plain
+ * text bytes to `length`. Unless `last`, `n` must be a multiple of
+ * AGE_FRAME_SIZE. With `last` the final chunk is the rest of `in`, which
+ * may be a whole frame. Returns NULL, or the error
+ */
+static const char* age_open(AgePayload* payload, unsigned char* out, size_t& length,
+                            const unsigned char* in, size_t n, bool last) {
+    size_t pos = 0;
+    do {
+        size_t m = n - pos;
+        bool final_chunk = last && m <= AGE_FRAME_SIZE;
+        if( !final_chunk ) {
+            m = AGE_FRAME_SIZE;
+        } else if( m < AGE_TAGBYTES ) {
+            return "age payload truncated";
+        } else if( m == AGE_TAGBYTES && payload->counter != 0 ) {
+            return "age payload ends with an empty chunk";
+        }
+        const char* error = age_open_chunk(payload, out + length, in + pos, m, final_chunk);
+        if( error != NULL ) {
+            return error;
+        }
+        length += m - AGE_TAGBYTES;
+        pos += m;
+    } while( pos < n );
+    payload->done = last;
+    return NULL;
+}
+
+static void age_base64(std::string& out, const unsigned char* bin, size_t size) {
+    char b64[sodium_base64_ENCODED_LEN(AGE_KEYBYTES, AGE_BASE64)];
+    out += sodium_bin2base64(b64, sizeof b64, bin, size, AGE_BASE64);
+}
+
+// Strict base64 of exactly `size` bytes
+static bool age_unbase64(unsigned char* bin, size_t size, const unsigned char* b64, size_t b64_size) {
+    size_t bin_size = 0;
+    return sodium_base642bin(bin, size, (const char*) b64, b64_size, NULL, &bin_size, NULL, AGE_BASE64) == 0 &&
+           bin_size == size;
+}
+
+static bool age_base64_char(unsigned char c) {
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '+' || c == '/';
+}
+
+/**
+ * Header of a new file to `count` recipients into `header`, the payload
+ * nonce included, and the key of its payload into `payload`. Returns an
+ * empty string, or the error
+ */
+static std::string age_write_header(std::string& header, AgePayload* payload,
+                                    const unsigned char* const* recipients, size_t count) {
+    static const unsigned char zero_nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES] = { 0 };
+    unsigned char file_key[AGE_FILE_KEYBYTES], key[AGE_KEYBYTES], mac[crypto_auth_hmacsha256_BYTES];
+    unsigned char share[AGE_X25519BYTES], ephemeral[AGE_X25519BYTES], shared[AGE_X25519BYTES];
+    unsigned char salt[2 * AGE_X25519BYTES], body[AGE_FILE_KEYBYTES + AGE_TAGBYTES], nonce[AGE_NONCEBYTES];
+    std::string error;
+
+    randombytes_buf(file_key, sizeof file_key);
+    header = age_version;
+    for(size_t i = 0; i < count && error.empty(); i++) {
+        if( keypair_pool_take(KEYPAIR_POOL_X25519, share, ephemeral) != 0 ||
+            crypto_scalarmult(shared, ephemeral, recipients[i]) != 0 ) {
+            error = "recipient " + std::to_string(i) + " is not a valid X25519 public key";
+            break;
+        }
+        memcpy(salt, share, AGE_X25519BYTES);
+        memcpy(salt + AGE_X25519BYTES, recipients[i], AGE_X25519BYTES);
+        age_hkdf(key, salt, sizeof salt, shared, sizeof shared, age_x25519_info);
+        crypto_aead_chacha20poly1305_ietf_encrypt(body, NULL, file_key, sizeof file_key, NULL, 0, NULL,
+                                                  zero_nonce, key);
+        header += "-> X25519 ";
+        age_base64(header, share, sizeof share);
+        header += '\n';
+        age_base64(header, body, sizeof body);
+        header += '\n';
+    }
+
+    if( error.empty() ) {
+        header += "---";
+        age_hkdf(key, NULL, 0, file_key, sizeof file_key, "header");
+        crypto_auth_hmacsha256(mac, (const unsigned char*) header.data(), header.size(), key);
+        header += ' ';
+        age_base64(header, mac, sizeof mac);
+        header += '\n';
+        randombytes_buf(nonce, sizeof nonce);
+        header.append((const char*) nonce, sizeof nonce);
+        age_payload_init(payload, file_key, nonce);
+    }
+
+    sodium_memzero(file_key, sizeof file_key);
+    sodium_memzero(key, sizeof key);
+    sodium_memzero(ephemeral, sizeof ephemeral);
+    sodium_memzero(shared, sizeof shared);
+    return error;
+}
+
+/**
+ * Length of the header at the start of `in`, payload nonce included: 0
+ * when `in` ends before the header does, -1 when `in` is not an age file or
+ * its header is over AGE_MAX_HEADER
+ */
+static long age_header_length(const unsigned char* in, size_t n) {
+    size_t version = sizeof age_version - 1;
+    if( memcmp(in, age_version, n < version ? n : version) != 0 ) {
+        return -1;
+    }
+    // No line of a stanza starts with "-- ", so the first one is the MAC's
+    static const char mac_line[] = "\n--- ";
+    const unsigned char* end = in + (n < AGE_MAX_HEADER ? n : AGE_MAX_HEADER);
+    const unsigned char* p = std::search(in, end, mac_line, mac_line + sizeof mac_line - 1);
+    if( p != end ) {
+        p = (const unsigned char*) memchr(p + 1, '\n', end - (p + 1));
+    }
+    if( p == NULL || p == end ) {
+        return n >= AGE_MAX_HEADER ? -1 : 0;
+    }
+    size_t length = (size_t) (p + 1 - in) + AGE_NONCEBYTES;
+    if( length > AGE_MAX_HEADER ) {
+        return -1;
+    }
+    return n >= length ? (long) length : 0;
+}
+
+// The file key of an X25519 stanza, if it was wrapped for `identity`
+static bool age_unwrap_x25519(unsigned char* file_key, const unsigned char* share, const unsigned char* body,
+                              const unsigned char* identity, const unsigned char* public_key) {
+    static const unsigned char zero_nonce[crypto_aead_chacha20poly1305_ietf_NPUBBYTES] = { 0 };
+    unsigned char shared[AGE_X25519BYTES], salt[2 * AGE_X25519BYTES], key[AGE_KEYBYTES];
+    bool found = false;
+
+    if( crypto_scalarmult(shared, identity, share) == 0 ) {
+        memcpy(salt, share, AGE_X25519BYTES);
+        memcpy(salt + AGE_X25519BYTES, public_key, AGE_X25519BYTES);
+        age_hkdf(key, salt, sizeof salt, shared, sizeof shared, age_x25519_info);
+        found = crypto_aead_chacha20poly1305_ietf_decrypt(file_key, NULL, NULL, body,
+                                                          AGE_FILE_KEYBYTES + AGE_TAGBYTES, NULL, 0,
+                                                          zero_nonce, key) == 0;
+    }
+    sodium_memzero(shared, sizeof shared);
+    sodium_memzero(key, sizeof key);
+    return found;
+}
+
+/**
+ * Read the `size` byte header at `in`, as measured by age_header_length,
+ * unwrap the file key with one of `count` X25519 secret keys and set up
+ * `payload` with it. Returns NULL, or the error
+ */
+static const char* age_read_header(AgePayload* payload, const unsigned char* in, size_t size,
+                                   const unsigned char* const* identities, size_t count) {
+    unsigned char file_key[AGE_FILE_KEYBYTES], key[AGE_KEYBYTES], mac[crypto_auth_hmacsha256_BYTES];
+    unsigned char share[AGE_X25519BYTES], body[AGE_FILE_KEYBYTES + AGE_TAGBYTES];
+    std::vector<unsigned char> public_keys(count * AGE_X25519BYTES);
+    const unsigned char* end = in + size - AGE_NONCEBYTES;
+    const unsigned char* p = in + sizeof age_version - 1;
+    const char* error = NULL;
+    bool found = false;
+
+    for(size_t i = 0; i < count; i++) {
+        crypto_scalarmult_base(&public_keys[i * AGE_X25519BYTES], identities[i]);
+    }
+
+    while( error == NULL ) {
+        const unsigned char* eol = (const unsigned char*) memchr(p, '\n', end - p);
+        size_t line = eol - p;
+        if( line >= 4 && memcmp(p, "--- ", 4) == 0 ) {
+            break;
+        }
+        if( line < 4 || memcmp(p, "-> ", 3) != 0 ) {
+            error = "malformed age header";
+            break;
+        }
+
+        // Arguments, one or more non empty runs of visible characters
+        const unsigned char* args[3];
+        size_t arg_sizes[3], nargs = 0;
+        for(const unsigned char* a = p + 3; a <= eol && error == NULL; ) {
+            const unsigned char* b = a;
+            while( b < eol && *b > 32 && *b < 127 ) {
+                b++;
+            }
+            if( b == a || (b < eol && *b != ' ') ) {
+                error = "malformed age stanza";
+            } else if( nargs < 3 ) {
+                args[nargs] = a;
+                arg_sizes[nargs] = b - a;
+            }
+            nargs++;
+            a = b + 1;
+        }
+
+        // Body, lines of AGE_COLUMNS base64 characters up to a shorter one
+        const unsigned char* body_start = eol + 1;
+        p = body_start;
+        while( error == NULL ) {
+            eol = (const unsigned char*) memchr(p, '\n', end - p);
+            line = eol - p;
+            if( line > AGE_COLUMNS || !std::all_of(p, eol, age_base64_char) ) {
+                error = "malformed age stanza";
+            }
+            p = eol + 1;
+            if( line < AGE_COLUMNS ) {
+                break;
+            }
+        }
+        if( error != NULL ) {
+            break;
+        }
+
+        if( arg_sizes[0] == 6 && memcmp(args[0], "X25519", 6) == 0 ) {
+            if( nargs != 2 || !age_unbase64(share, sizeof share, args[1], arg_sizes[1]) ||
+                !age_unbase64(body, sizeof body, body_start, (size_t) (p - 1 - body_start)) ) {
+                error = "malformed X25519 stanza";
+                break;
+            }
+            for(size_t i = 0; i < count && !found; i++) {
+                found = age_unwrap_x25519(file_key, share, body, identities[i], &public_keys[i * AGE_X25519BYTES]);
+            }
+        }
+    }
+
+    if( error == NULL ) {
+        // The line age_header_length found, right before the payload nonce
+        const unsigned char* eol = end - 1;
+        if( !age_unbase64(mac, sizeof mac, p + 4, (size_t) (eol - p - 4)) ) {
+            error = "malformed age header MAC";
+        } else if( !found ) {
+            error = "no identity matches a recipient of the age file";
+        } else {
+            age_hkdf(key, NULL, 0, file_key, sizeof file_key, "header");
+            if( crypto_auth_hmacsha256_verify(mac, in, (size_t) (p + 3 - in), key) != 0 ) {
+                error = "age header failed authentication";
+            } else {
+                age_payload_init(payload, file_key, end);
+            }
+        }
+    }
+
+    sodium_memzero(file_key, sizeof file_key);
+    sodium_memzero(key, sizeof key);
+    return error;
+}
+
+// Key list argument: an array of 32 byte keys, or one buffer of them back
+// to back. Throws, and returns false, when it is not one or is empty
+static bool age_arg_keys(Napi::Env env, Napi::Value arg, const char* name, std::vector<const unsigned char*>& keys) {
+    size_t count = SODIUM_BATCH_ANY;
+    unsigned char* packed = NULL;
+    size_t packed_size = 0;
+    if( !arg.IsArray() && sodium_arg_bytes(arg, packed, packed_size) ) {
+        count = packed_size / AGE_X25519BYTES;
+    }
+    std::vector<SodiumSpan> spans;
+    if( !sodium_batch_arg(env, arg, name, count, AGE_X25519BYTES, false, spans) ) {
+        return false;
+    }
+    if( spans.empty() || spans.size() > AGE_MAX_RECIPIENTS ) {
+        Napi::Error::New(env, std::string("argument ") + name + " must hold from 1 to " +
+                         std::to_string(AGE_MAX_RECIPIENTS) + " keys").ThrowAsJavaScriptException();
+        return false;
+    }
+    for(auto& span : spans) {
+        keys.push_back(span.data);
+    }
+    return true;
+}
+
+/**
+ * AgeStream:
+ * One age file, encrypted or decrypted a block of chunks at a time. The
+ * payload key stays in `sodium_malloc` memory. lib/age.js builds node
+ * streams on it
+ *
+ *     new sodium.AgeStream({ recipients })
+ *     new sodium.AgeStream({ identities, header })
+ *
+ * ~ recipients (Array): X25519 public keys to encrypt to, as from
+ *   `crypto_box_keypair`, or one buffer of them back to back
+ * ~ identities (Array): X25519 secret keys to try on the recipient stanzas
+ *   of `header`
+ * ~ header (Buffer): the start of the file, at least
+ *   `AgeStream.headerLength(header)` bytes of it
+ *
+ * Methods:
+ *
+ * ~ seal(plain, last): the next chunks of the payload. Unless `last`,
+ *   `plain` must be a non zero multiple of `AgeStream.CHUNK_SIZE` bytes.
+ *   The last call may only be empty when the whole payload is
+ * ~ open(sealed, last): the plain text of the next chunks. Unless `last`,
+ *   `sealed` must be a multiple of `AgeStream.FRAME_SIZE` bytes. Throws
+ *   when a chunk fails authentication or the file was truncated
+ * ~ dispose(): wipes the payload key. Later calls throw
+ *
+ * Properties:
+ *
+ * ~ header (Buffer): the header to write before the sealed chunks, or
+ *   null when decrypting
+ * ~ headerLength (Number): bytes of the header, payload nonce included
+ *
+ * `AgeStream.headerLength(bytes)` is the length of the header at the start
+ * of `bytes`, 0 when more bytes are needed. It throws when `bytes` is not
+ * the start of an age file or the header is over 1MB.
+ *
+ * **Sample**:
+ *
+ *     var alice = sodium.crypto_box_keypair();
+ *     var enc = new sodium.AgeStream({ recipients: [alice.publicKey] });
+ *     var file = Buffer.concat([enc.header, enc.seal(Buffer.from('hello'), true)]);
+ *     var dec = new sodium.AgeStream({ identities: [alice.secretKey], header: file });
+ *     var plain = dec.open(file.slice(dec.headerLength), true);
+ */
+class AgeStream : public Napi::ObjectWrap<AgeStream> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "AgeStream", {
+            InstanceMethod("seal", &AgeStream::Seal),
+            InstanceMethod("open", &AgeStream::Open),
+            InstanceMethod("dispose", &AgeStream::Dispose),
+            InstanceAccessor("header", &AgeStream::Header, nullptr),
+            InstanceAccessor("headerLength", &AgeStream::HeaderLength, nullptr),
+            StaticMethod("headerLength", &AgeStream::MeasureHeader),
+            StaticValue("CHUNK_SIZE", Napi::Number::New(env, AGE_CHUNK_SIZE)),
+            StaticValue("FRAME_SIZE", Napi::Number::New(env, AGE_FRAME_SIZE))
+        });
+        exports.Set(Napi::String::New(env, "AgeStream"), ctor);
+    }
+
+    AgeStream(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<AgeStream>(info), payload(NULL), encrypt(false), header_length(0) {
+        Napi::Env env = info.Env();
+
+        if( info.Length() < 1 || !info[0].IsObject() ) {
+            Napi::TypeError::New(env, "argument options must be an object").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+        Napi::Value recipients = options.Get("recipients");
+        Napi::Value identities = options.Get("identities");
+        if( recipients.IsUndefined() == identities.IsUndefined() ) {
+            Napi::TypeError::New(env, "give either option recipients, to encrypt, or identities, to decrypt")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+        encrypt = !recipients.IsUndefined();
+
+        std::vector<const unsigned char*> keys;
+        if( !age_arg_keys(env, encrypt ? recipients : identities, encrypt ? "recipients" : "identities", keys) ) {
+            return;
+        }
+        unsigned char* in = NULL;
+        size_t in_size = 0;
+        if( !encrypt && !sodium_arg_bytes(options.Get("header"), in, in_size) ) {
+            Napi::TypeError::New(env, "option header must be a buffer").ThrowAsJavaScriptException();
+            return;
+        }
+
+        payload = (AgePayload*) sodium_secret_alloc(env, sizeof(AgePayload));
+        if( payload == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the payload key").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::string error;
+        if( encrypt ) {
+            error = age_write_header(header, payload, keys.data(), keys.size());
+            header_length = header.size();
+        } else {
+            long length = age_header_length(in, in_size);
+            if( length <= 0 ) {
+                error = length < 0 ? "option header is not an age file" : "option header is truncated";
+            } else {
+                const char* failed = age_read_header(payload, in, (size_t) length, keys.data(), keys.size());
+                error = failed != NULL ? failed : "";
+                header_length = (size_t) length;
+            }
+        }
+        if( !error.empty() ) {
+            Free();
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+        }
+    }
+
+    ~AgeStream() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( payload != NULL ) {
+            sodium_secret_free(Env(), payload, sizeof(AgePayload));
+            payload = NULL;
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( payload == NULL ) { \
+        THROW_ERROR("AgeStream was disposed"); \
+    } \
+    if( payload->done ) { \
+        THROW_ERROR("AgeStream already went past the last chunk"); \
+    }
+
+    Napi::Value Seal(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( !encrypt ) {
+            THROW_ERROR("AgeStream was created to decrypt");
+        }
+        ARGS(1, "argument plain must be a buffer");
+        ARG_TO_UCHAR_BUFFER(plain);
+        bool last = info.Length() > 1 && info[1].ToBoolean().Value();
+        if( !last && (plain_size == 0 || plain_size % AGE_CHUNK_SIZE != 0) ) {
+            THROW_ERROR("argument plain must be whole chunks, unless it is the last");
+        }
+        if( last && plain_size == 0 && payload->counter != 0 ) {
+            THROW_ERROR("the last chunk can only be empty when the whole payload is");
+        }
+
+        size_t chunks = plain_size == 0 ? 1 : (plain_size + AGE_CHUNK_SIZE - 1) / AGE_CHUNK_SIZE;
+        NEW_BUFFER_AND_PTR(sealed, plain_size + chunks * AGE_TAGBYTES);
+        age_seal(payload, sealed_ptr, plain, plain_size, last);
+        return sealed;
+    }
+
+    Napi::Value Open(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( encrypt ) {
+            THROW_ERROR("AgeStream was created to encrypt");
+        }
+        ARGS(1, "argument sealed must be a buffer");
+        ARG_TO_UCHAR_BUFFER(sealed);
+        bool last = info.Length() > 1 && info[1].ToBoolean().Value();
+        if( !last && (sealed_size == 0 || sealed_size % AGE_FRAME_SIZE != 0) ) {
+            THROW_ERROR("argument sealed must be whole chunks, unless it is the last");
+        }
+
+        size_t chunks = (sealed_size + AGE_FRAME_SIZE - 1) / AGE_FRAME_SIZE;
+        size_t size = sealed_size > chunks * AGE_TAGBYTES ? sealed_size - chunks * AGE_TAGBYTES : 0;
+        NEW_BUFFER_AND_PTR(plain, size);
+        size_t length = 0;
+        const char* error = age_open(payload, plain_ptr, length, sealed, sealed_size, last);
+        if( error != NULL ) {
+            sodium_memzero(plain_ptr, size);
+            THROW_ERROR(error);
+        }
+        return plain;
+    }
+
+    Napi::Value Header(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if( !encrypt ) {
+            return NAPI_NULL;
+        }
+        NEW_BUFFER_AND_PTR(out, header.size());
+        memcpy(out_ptr, header.data(), header.size());
+        return out;
+    }
+
+    Napi::Value HeaderLength(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) header_length);
+    }
+
+    static Napi::Value MeasureHeader(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        ARGS(1, "argument bytes must be a buffer");
+        ARG_TO_UCHAR_BUFFER(bytes);
+        long length = age_header_length(bytes, bytes_size);
+        if( length < 0 ) {
+            THROW_ERROR("not an age file, or its header is over 1MB");
+        }
+        return Napi::Number::New(env, (double) length);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    AgePayload* payload;
+    bool encrypt;
+    std::string header;
+    size_t header_length;
+};
+
+/**
+ * File encryption
+ *
+ * The file jobs run the pipeline of `sodium_encrypt_file`: a reader thread,
+ * the pool thread that runs the cipher and a writer thread, with two blocks
+ * of 16 chunks between each pair, so reads and writes overlap the cipher
+ * and memory stays the same whatever the size of the file.
+ */
+#define AGE_BLOCK_CHUNKS (FILE_DIGEST_BLOCK_SIZE / AGE_CHUNK_SIZE)
+
+class AgeFileWorker : public SodiumAsyncWorker {
+public:
+    AgeFileWorker(const Napi::CallbackInfo& info, const char* name, bool encrypt,
+                  const std::string& src, const std::string& dst)
+        : SodiumAsyncWorker(info, name), encrypt(encrypt), src(src), dst(dst), written(0) {
+        sodium_memzero(&payload, sizeof payload);
+    }
+
+    ~AgeFileWorker() {
+        sodium_memzero(&payload, sizeof payload);
+    }
+
+    // Queue the encryption of the payload after `header`, under the key of
+    // `payload`, which is copied
+    Napi::Value Encrypt(const std::string& header, const AgePayload* payload) {
+        this->header = header;
+        memcpy(&this->payload, payload, sizeof(AgePayload));
+        return Start(nullptr, ASYNC_RESULT_BUFFER);
+    }
+
+    // Queue the decryption. The secret keys are copied
+    Napi::Value Decrypt(const std::vector<const unsigned char*>& keys) {
+        for(auto key : keys) {
+            identities.push_back(Copy(key, AGE_X25519BYTES));
+        }
+        return Start(nullptr, ASYNC_RESULT_BUFFER);
+    }
+
+protected:
+    void Run() override {
+        FILE* in = fopen(src.c_str(), "rb");
+        if( in == NULL ) {
+            SetError("cannot open " + src + ": " + strerror(errno));
+            return;
+        }
+        FILE* out = fopen(dst.c_str(), "wb");
+        if( out == NULL ) {
+            SetError("cannot open " + dst + ": " + strerror(errno));
+            fclose(in);
+            return;
+        }
+        setvbuf(in, NULL, _IONBF, 0);
+        setvbuf(out, NULL, _IONBF, 0);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(fileno(in), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        std::vector<unsigned char> rest;
+        if( encrypt ) {
+            if( fwrite(header.data(), 1, header.size(), out) != header.size() ) {
+                Fail("cannot write " + dst, errno);
+            }
+        } else {
+            ReadHeader(in, rest);
+        }
+        if( !Failed() ) {
+            Pipeline(in, out, rest);
+        }
+        sodium_memzero(rest.data(), rest.size());
+        sodium_memzero(&payload, sizeof payload);
+
+        fclose(in);
+        if( fclose(out) != 0 ) {
+            Fail("cannot write " + dst, errno);
+        }
+        if( Failed() ) {
+            // Never leave a partial file behind, it would look complete
+            remove(dst.c_str());
+            SetError(failure);
+        } else {
+            status = 0;
+        }
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return Napi::Number::New(env, (double) written);
+    }
+
+private:
+    // Record the first failure, with the errno of the call that failed
+    void Fail(const std::string& message, int error = 0) {
+        std::lock_guard<std::mutex> guard(failure_lock);
+        if( failure.empty() ) {
+            failure = error != 0 ? message + ": " + strerror(error) : message;
+        }
+    }
+
+    bool Failed() {
+        std::lock_guard<std::mutex> guard(failure_lock);
+        return !failure.empty();
+    }
+
+    // Read until the header is whole and open it. What was read past it,
+    // the first sealed chunks, is left in `rest`
+    void ReadHeader(FILE* in, std::vector<unsigned char>& rest) {
+        std::vector<unsigned char> head;
+        long length = 0;
+        while( length == 0 ) {
+            size_t size = head.size();
+            head.resize(size + AGE_CHUNK_SIZE);
+            size_t n = fread(head.data() + size, 1, AGE_CHUNK_SIZE, in);
+            head.resize(size + n);
+            if( ferror(in) ) {
+                Fail("cannot read " + src, errno);
+                return;
+            }
+            length = age_header_length(head.data(), head.size());
+            if( length == 0 && n == 0 ) {
+                Fail("age header truncated");
+                return;
+            }
+        }
+        if( length < 0 ) {
+            Fail(src + " is not an age file");
+            return;
+        }
+        const char* error = age_read_header(&payload, head.data(), (size_t) length,
+                                            identities.data(), identities.size());
+        if( error != NULL ) {
+            Fail(error);
+            return;
+        }
+        rest.assign(head.begin() + length, head.end());
+    }
+
+    void Pipeline(FILE* in, FILE* out, const std::vector<unsigned char>& rest) {
+        FileDoubleBuffer input(AGE_BLOCK_CHUNKS * (encrypt ? AGE_CHUNK_SIZE : AGE_FRAME_SIZE));
+        FileDoubleBuffer output(AGE_BLOCK_CHUNKS * (encrypt ? AGE_FRAME_SIZE : AGE_CHUNK_SIZE));
+
+        std::thread reader([this, in, &rest, &input, &output] {
+            for(int i = 0, first = 1; ; i ^= 1, first = 0) {
+                if( !input.WaitEmpty(i) ) {
+                    return;
+                }
+                // The header block may have read into the first chunks
+                size_t n = first ? rest.size() : 0;
+                memcpy(input.Data(i), rest.data(), n);
+                n += fread(input.Data(i) + n, 1, input.Size() - n, in);
+                if( ferror(in) ) {
+                    Fail("cannot read " + src, errno);
+                    input.Stop();
+                    output.Stop();
+                    return;
+                }
+                bool last = n < input.Size();
+                input.Fill(i, n, last);
+                if( last ) {
+                    return;
+                }
+            }
+        });
+        std::thread writer([this, out, &input, &output] {
+            for(int i = 0; ; i ^= 1) {
+                if( !output.WaitFull(i) ) {
+                    return;
+                }
+                size_t n = output.Length(i);
+                if( n > 0 && fwrite(output.Data(i), 1, n, out) != n ) {
+                    Fail("cannot write " + dst, errno);
+                    input.Stop();
+                    output.Stop();
+                    return;
+                }
+                bool last = output.Last(i);
+                output.Empty(i);
+                if( last ) {
+                    return;
+                }
+            }
+        });
+
+        for(int i = 0; ; i ^= 1) {
+            if( Cancelled() ) {
+                Fail("cancelled");
+                break;
+            }
+            if( !input.WaitFull(i) ) {
+                break;
+            }
+            // A full block is the last one when the reader finds nothing
+            // after it, which it is reading while this one waits
+            bool last = input.Last(i);
+            if( !last ) {
+                if( !input.WaitFull(i ^ 1) ) {
+                    break;
+                }
+                last = input.Last(i ^ 1) && input.Length(i ^ 1) == 0;
+            }
+            if( !output.WaitEmpty(i) ) {
+                break;
+            }
+
+            size_t n = input.Length(i);
+            size_t length = 0;
+            const char* error = NULL;
+            if( encrypt ) {
+                length = age_seal(&payload, output.Data(i), input.Data(i), n, last);
+            } else {
+                error = age_open(&payload, output.Data(i), length, input.Data(i), n, last);
+            }
+            input.Empty(i);
+            if( error != NULL ) {
+                Fail(error);
+                break;
+            }
+            written += length;
+            output.Fill(i, length, last);
+            if( last ) {
+                break;
+            }
+        }
+
+        if( Failed() ) {
+            input.Stop();
+            output.Stop();
+        }
+        reader.join();
+        writer.join();
+    }
+
+    bool encrypt;
+    std::string src;
+    std::string dst;
+    std::string header;
+    std::vector<const unsigned char*> identities;
+    AgePayload payload;
+    size_t written;
+    std::mutex failure_lock;
+    std::string failure;
+};
+
+// Arguments shared by crypto_age_encrypt_file and crypto_age_decrypt_file
+static Napi::Value age_file(const Napi::CallbackInfo& info, const char* name, bool encrypt) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, encrypt ? "arguments src, dst and recipients are required"
+                    : "arguments src, dst and identities are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument src must be a string");
+    }
+    if( !info[1].IsString() ) {
+        THROW_ERROR("argument dst must be a string");
+    }
+    std::string src = info[0].As<Napi::String>().Utf8Value();
+    std::string dst = info[1].As<Napi::String>().Utf8Value();
+    if( src == dst ) {
+        THROW_ERROR("arguments src and dst must be different files");
+    }
+    std::vector<const unsigned char*> keys;
+    if( !age_arg_keys(env, info[2], encrypt ? "recipients" : "identities", keys) ) {
+        return NAPI_NULL;
+    }
+
+    if( !encrypt ) {
+        AgeFileWorker* worker = new AgeFileWorker(info, name, false, src, dst);
+        return worker->Decrypt(keys);
+    }
+
+    // The header is written on the JS thread, since its ephemeral keys come
+    // from the key pair pool
+    std::string header;
+    AgePayload payload;
+    std::string error = age_write_header(header, &payload, keys.data(), keys.size());
+    if( !error.empty() ) {
+        THROW_ERROR(error);
+    }
+    AgeFileWorker* worker = new AgeFileWorker(info, name, true, src, dst);
+    Napi::Value result = worker->Encrypt(header, &payload);
+    sodium_memzero(&payload, sizeof payload);
+    return result;
+}
+
+/**
+ * crypto_age_encrypt_file:
+ * Encrypt a file into an age file to X25519 recipients, on the libuv
+ * threadpool
+ *
+ *     sodium.crypto_age_encrypt_file(src, dst, recipients, [options], [callback]);
+ *
+ * ~ src (String): file to encrypt
+ * ~ dst (String): file to write, replaced if it exists
+ * ~ recipients (Array): X25519 public keys, as from `crypto_box_keypair`,
+ *   or one buffer of them back to back. Up to 4096
+ * ~ options (Object): optional, `signal`, `deadline` and `timeout` stop
+ *   the job between blocks
+ * ~ callback (Function): optional, called as `callback(err, bytes)`
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the bytes written to `dst` when no callback is given.
+ *   On failure `dst` is removed
+ *
+ * The output is what `age -r` writes, without armor.
+ *
+ * **Sample**:
+ *
+ *     var alice = sodium.crypto_box_keypair();
+ *     await sodium.crypto_age_encrypt_file('backup.tar', 'backup.tar.age', [alice.publicKey]);
+ */
+NAPI_METHOD(crypto_age_encrypt_file) {
+    return age_file(info, "crypto_age_encrypt_file", true);
+}
+
+/**
+ * crypto_age_decrypt_file:
+ * Decrypt an age file with X25519 identities, on the libuv threadpool
+ *
+ *     sodium.crypto_age_decrypt_file(src, dst, identities, [options], [callback]);
+ *
+ * ~ identities (Array): X25519 secret keys, tried on every X25519 stanza.
+ *   The worker keeps its own copies, wiped when done
+ *
+ * The other arguments are those of crypto_age_encrypt_file.
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the plain text bytes written to `dst`. It is rejected,
+ *   and `dst` removed, when no identity matches a recipient, the header or
+ *   a chunk fails authentication or the file was truncated or extended
+ */
+NAPI_METHOD(crypto_age_decrypt_file) {
+    return age_file(info, "crypto_age_decrypt_file", false);
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_age(Napi::Env env, Napi::Object exports) {
+    AgeStream::Init(env, exports);
+    EXPORT(crypto_age_encrypt_file);
+    EXPORT(crypto_age_decrypt_file);
+}
@@ -0,0 +1,639 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "sodium_env.h"
+#include "sodium_memory.h"
+
+/**
+ * MAC `m` with a copy of the keyed state `keyed`. The inner and outer pads
+ * were hashed into it once, so each message only costs its own blocks and
+ * the final outer block
+ */
+template<typename STATE,
+         int (*UPDATE)(STATE*, const unsigned char*, unsigned long long),
+         int (*FINAL)(STATE*, unsigned char*)>
+void hmac_key_mac(const void* keyed, unsigned char* out, const unsigned char* m, size_t mlen) {
+    STATE state;
+    memcpy(&state, keyed, sizeof state);
+    UPDATE(&state, m, mlen);
+    FINAL(&state, out);
+    sodium_memzero(&state, sizeof state);
+}
+
+template<typename STATE, int (*INIT)(STATE*, const unsigned char*, size_t)>
+void hmac_key_init(void* keyed, const unsigned char* key, size_t key_size) {
+    INIT((STATE*) keyed, key, key_size);
+}
+
+struct HmacAlgorithm {
+    const char* name;
+    size_t bytes;
+    size_t keybytes;
+    size_t statebytes;
+    void (*init)(void* keyed, const unsigned char* key, size_t key_size);
+    void (*mac)(const void* keyed, unsigned char* out, const unsigned char* m, size_t mlen);
+};
+
+#define HMAC_ALGORITHM(ALGO, STATE) \
+    { #ALGO, crypto_auth_ ## ALGO ## _BYTES, crypto_auth_ ## ALGO ## _KEYBYTES, sizeof(STATE), \
+      hmac_key_init<STATE, crypto_auth_ ## ALGO ## _init>, \
+      hmac_key_mac<STATE, crypto_auth_ ## ALGO ## _update, crypto_auth_ ## ALGO ## _final> }
+
+static const HmacAlgorithm hmac_algorithms[] = {
+    HMAC_ALGORITHM(hmacsha256, crypto_auth_hmacsha256_state),
+    HMAC_ALGORITHM(hmacsha512, crypto_auth_hmacsha512_state),
+    HMAC_ALGORITHM(hmacsha512256, crypto_auth_hmacsha512256_state)
+};
+
+/**
+ * HmacKey:
+ * HMAC key with its pads hashed once
+ *
+ * `crypto_auth_hmacsha256` and friends hash the key into the inner and outer
+ * pad blocks on every call: two compression function calls before the
+ * message is even looked at. An HmacKey does it once, when it is built, and
+ * keeps the keyed state in memory allocated with `sodium_malloc`, protected
+ * with guard pages and made read only. Every MAC starts from a copy of it.
+ *
+ *    var key = new sodium.HmacKey(algorithm, secret);
+ *
+ * ~ algorithm (String): `hmacsha256`, `hmacsha512` or `hmacsha512256`
+ * ~ secret (Buffer|String): key of any length, as the `_init` functions
+ *   take. Tags match `crypto_auth_<algorithm>` for
+ *   `crypto_auth_<algorithm>_KEYBYTES` long keys
+ *
+ * Properties:
+ *
+ * ~ bytes (Number): length of the tags, `crypto_auth_<algorithm>_BYTES`
+ *
+ * Methods:
+ *
+ * ~ mac(message, [encoding]): the tag of `message`
+ * ~ verify(tag, message): true if `tag` is the tag of `message`, compared in
+ *   constant time
+ * ~ macBatch(messages, [threads]): tags of an array of messages, back to
+ *   back in one buffer
+ * ~ verifyBatch(tags, messages, [threads]): check `tags[i]` against
+ *   `messages[i]`. `tags` is an array, or one buffer of tags back to back.
+ *   Returns a bitmap: bit `i % 8` of byte `i / 8` is set when tag `i` is
+ *   valid. `threads` splits large batches, the call still blocks
+ * ~ hotp(counter, [digits]): the HOTP code (RFC 4226) for `counter`, a
+ *   string of `digits` digits, 6 by default
+ * ~ totp([time], [options]): the TOTP code (RFC 6238) at `time`, in seconds
+ *   since the epoch, now by default. `options` takes `step` (30 seconds),
+ *   `t0` (0) and `digits`
+ * ~ verifyHotp(code, counter, [window]): check `code` against counters
+ *   `counter` to `counter + window`. Returns the matching counter, or null
+ * ~ verifyTotp(code, [time], [options]): check `code` against the time
+ *   steps from `window` (option, 1 by default) before the one of `time` to
+ *   `window` after it. Returns the matching step number, or null
+ * ~ dispose(): wipes and frees the key. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var hooks = new sodium.HmacKey('hmacsha256', process.env.WEBHOOK_SECRET);
+ *     if( !hooks.verify(Buffer.from(signature, 'hex'), body) ) {
+ *         res.statusCode = 401;
+ *     }
+ *
+ * One time passwords take the codes the HMAC of the counter gives, so they
+ * only match authenticator apps set to SHA-256 or SHA-512: libsodium has
+ * no HMAC-SHA-1. Every code of a window is computed and compared, so the
+ * time taken does not tell which step matched:
+ *
+ *     var otp = new sodium.HmacKey('hmacsha256', user.totpSecret);
+ *     var step = otp.verifyTotp(req.body.code, undefined, { window: 1 });
+ *     if( step === null || step <= user.lastTotpStep ) {
+ *         res.statusCode = 401;
+ *     }
+ */
+class HmacKey : public Napi::ObjectWrap<HmacKey> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "HmacKey", {
+            InstanceMethod("mac", &HmacKey::Mac),
+            InstanceMethod("verify", &HmacKey::Verify),
+            InstanceMethod("macBatch", &HmacKey::MacBatch),
+            InstanceMethod("verifyBatch", &HmacKey::VerifyBatch),
+            InstanceMethod("hotp", &HmacKey::Hotp),
+            InstanceMethod("totp", &HmacKey::Totp),
+            InstanceMethod("verifyHotp", &HmacKey::VerifyHotp),
+            InstanceMethod("verifyTotp", &HmacKey::VerifyTotp),
+            InstanceMethod("dispose", &HmacKey::Dispose),
+            InstanceAccessor("bytes", &HmacKey::Bytes, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "HmacKey"), ctor);
+
+        // Kept to recognize HmacKeys in the keyrings of `_verify_any`
+        napi_create_reference(env, ctor, 1, &SodiumEnv::Get(env)->hmac_key_class);
+    }
+
+    static HmacKey* FromValue(Napi::Env env, Napi::Value value) {
+        napi_value ctor;
+        if( !value.IsObject() ||
+            napi_get_reference_value(env, SodiumEnv::Get(env)->hmac_key_class, &ctor) != napi_ok ||
+            !value.As<Napi::Object>().InstanceOf(Napi::Function(env, ctor)) ) {
+            return NULL;
+        }
+        return HmacKey::Unwrap(value.As<Napi::Object>());
+    }
+
+    HmacKey(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<HmacKey>(info), algo(NULL), keyed(NULL) {
+        Napi::Env env = info.Env();
+
+        if( info.Length() < 2 || !info[0].IsString() ) {
+            Napi::TypeError::New(env, "arguments must be: algorithm name, key").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::string secret;
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info[1].IsString() ) {
+            secret = info[1].As<Napi::String>().Utf8Value();
+            key = (unsigned char*) secret.data();
+            key_size = secret.size();
+        } else if( !sodium_arg_bytes(info[1], key, key_size) ) {
+            Napi::TypeError::New(env, "argument key must be a buffer or a string").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::string name = info[0].As<Napi::String>().Utf8Value();
+        const HmacAlgorithm* found = NULL;
+        for(size_t i = 0; i < sizeof(hmac_algorithms) / sizeof(hmac_algorithms[0]); i++) {
+            if( name == hmac_algorithms[i].name ) {
+                found = &hmac_algorithms[i];
+            }
+        }
+        if( found == NULL ) {
+            sodium_memzero(&secret[0], secret.size());
+            Napi::Error::New(env, "unknown HMAC algorithm " + name).ThrowAsJavaScriptException();
+            return;
+        }
+
+        keyed = (unsigned char*) sodium_secret_alloc(env, found->statebytes);
+        if( keyed == NULL ) {
+            sodium_memzero(&secret[0], secret.size());
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        algo = found;
+        algo->init(keyed, key, key_size);
+        sodium_memzero(&secret[0], secret.size());
+        sodium_secret_readonly(keyed);
+    }
+
+    ~HmacKey() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( keyed != NULL ) {
+            sodium_secret_free(Env(), keyed, algo->statebytes);
+            keyed = NULL;
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( keyed == NULL ) { \
+        THROW_ERROR("HmacKey was disposed"); \
+    }
+
+    Napi::Value Bytes(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, algo->bytes);
+    }
+
+    Napi::Value Mac(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER_OR_STRING(message);
+        ARG_TO_ENCODING(encoding);
+
+        NEW_OUTPUT_AND_PTR(tag, algo->bytes, encoding);
+        algo->mac(keyed, tag_ptr, message, message_size);
+        return OUTPUT_VALUE(tag, algo->bytes, encoding);
+    }
+
+    Napi::Value Verify(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments tag and message must be buffers");
+        ARG_TO_UCHAR_BUFFER(tag);
+        ARG_TO_UCHAR_BUFFER_OR_STRING(message);
+        if( tag_size != algo->bytes ) {
+            THROW_ERROR("argument tag must be crypto_auth_" + std::string(algo->name) + "_BYTES bytes long");
+        }
+
+        unsigned char expected[crypto_auth_hmacsha512_BYTES];
+        algo->mac(keyed, expected, message, message_size);
+        bool ok = sodium_memcmp(expected, tag, algo->bytes) == 0;
+        sodium_memzero(expected, sizeof expected);
+        return ok ? NAPI_TRUE : NAPI_FALSE;
+    }
+
+    Napi::Value MacBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument messages must be an array of buffers");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(messages, count);
+
+        size_t threads = 1;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            ARG_TO_NUMBER(nthreads);
+            threads = nthreads;
+        }
+
+        size_t bytes = algo->bytes;
+        NEW_BUFFER_AND_PTR(tags, count * bytes);
+        sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                algo->mac(keyed, tags_ptr + i * bytes, messages[i].data, messages[i].size);
+            }
+        });
+        return tags;
+    }
+
+    Napi::Value VerifyBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments must be: tags, messages");
+
+        size_t count = SODIUM_BATCH_ANY;
+        std::vector<SodiumSpan> messages;
+        if( !sodium_batch_arg(env, info[1], "messages", count, 0, false, messages) ) {
+            return NAPI_NULL;
+        }
+
+        ARG_TO_BATCH_LEN(tags, count, algo->bytes);
+        _arg++; // messages
+
+        size_t threads = 1;
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            ARG_TO_NUMBER(nthreads);
+            threads = nthreads;
+        }
+
+        std::vector<unsigned char> ok(count, 0);
+        sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+            unsigned char expected[crypto_auth_hmacsha512_BYTES];
+            for(size_t i = begin; i < end; i++) {
+                algo->mac(keyed, expected, messages[i].data, messages[i].size);
+                ok[i] = sodium_memcmp(expected, tags[i].data, algo->bytes) == 0;
+            }
+            sodium_memzero(expected, sizeof expected);
+        });
+
+        return sodium_batch_bitmap(env, ok);
+    }
+
+#define OTP_DIGITS_MIN 6
+#define OTP_DIGITS_MAX 10
+#define OTP_WINDOW_MAX 100
+
+    // The `digits` digit code of `counter`, with RFC 4226 dynamic truncation
+    void Otp(uint64_t counter, size_t digits, char* code) {
+        unsigned char message[8];
+        for(int i = 7; i >= 0; i--) {
+            message[i] = (unsigned char) counter;
+            counter >>= 8;
+        }
+        unsigned char mac[crypto_auth_hmacsha512_BYTES];
+        algo->mac(keyed, mac, message, sizeof message);
+        size_t offset = mac[algo->bytes - 1] & 0x0f;
+        uint64_t value = ((uint64_t) (mac[offset] & 0x7f) << 24) | ((uint64_t) mac[offset + 1] << 16) |
+                         ((uint64_t) mac[offset + 2] << 8) | (uint64_t) mac[offset + 3];
+        sodium_memzero(mac, sizeof mac);
+        for(size_t i = digits; i > 0; i--) {
+            code[i - 1] = (char) ('0' + value % 10);
+            value /= 10;
+        }
+    }
+
+    /**
+     * Check `code` against the codes of counters `first` to `last`. Every
+     * code is computed and compared. Returns true with `found` set to the
+     * first matching counter
+     */
+    bool OtpMatch(const std::string& code, size_t digits, uint64_t first, uint64_t last, uint64_t& found) {
+        if( code.size() != digits ) {
+            return false;
+        }
+        bool matched = false;
+        char expected[OTP_DIGITS_MAX];
+        for(uint64_t counter = first; ; counter++) {
+            Otp(counter, digits, expected);
+            if( sodium_memcmp(expected, code.data(), digits) == 0 && !matched ) {
+                matched = true;
+                found = counter;
+            }
+            if( counter == last ) {
+                break;
+            }
+        }
+        sodium_memzero(expected, sizeof expected);
+        return matched;
+    }
+
+#define ARG_TO_OTP_COUNTER(NAME) \
+    uint64_t NAME = 0; \
+    if( !sodium_arg_uint64(info[_arg], #NAME, (1ULL << 53) - 1, NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+    // Digits, step, t0 and window of the TOTP options at `index`
+    bool OtpOptions(const Napi::CallbackInfo& info, size_t index, size_t& digits, double& step,
+                    double& t0, size_t& window) {
+        Napi::Env env = info.Env();
+        if( info.Length() <= index || info[index].IsUndefined() ) {
+            return true;
+        }
+        if( !info[index].IsObject() ) {
+            sodium_throw(env, "argument options must be an object");
+            return false;
+        }
+        Napi::Object options = info[index].As<Napi::Object>();
+        Napi::Value value;
+        if( !(value = options.Get("digits")).IsUndefined() ) {
+            if( !value.IsNumber() ) {
+                sodium_throw(env, "option digits must be a number");
+                return false;
+            }
+            digits = value.As<Napi::Number>().Uint32Value();
+        }
+        if( !(value = options.Get("step")).IsUndefined() ) {
+            if( !value.IsNumber() || !(value.As<Napi::Number>().DoubleValue() >= 1) ) {
+                sodium_throw(env, "option step must be a number of seconds, 1 or more");
+                return false;
+            }
+            step = value.As<Napi::Number>().DoubleValue();
+        }
+        if( !(value = options.Get("t0")).IsUndefined() ) {
+            if( !value.IsNumber() ) {
+                sodium_throw(env, "option t0 must be a number of seconds");
+                return false;
+            }
+            t0 = value.As<Napi::Number>().DoubleValue();
+        }
+        if( !(value = options.Get("window")).IsUndefined() ) {
+            if( !value.IsNumber() ) {
+                sodium_throw(env, "option window must be a number");
+                return false;
+            }
+            window = value.As<Napi::Number>().Uint32Value();
+        }
+        return true;
+    }
+
+    // The time step of the time argument at `index`, or of now
+    bool OtpStep(const Napi::CallbackInfo& info, size_t index, double step, double t0, uint64_t& counter) {
+        double now;
+        if( info.Length() > index && !info[index].IsUndefined() ) {
+            if( !info[index].IsNumber() ) {
+                sodium_throw(info.Env(), "argument time must be a number of seconds");
+                return false;
+            }
+            now = info[index].As<Napi::Number>().DoubleValue();
+        } else {
+            now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+        }
+        double steps = std::floor((now - t0) / step);
+        if( !(steps >= 0 && steps < 9007199254740992.0) ) {
+            sodium_throw(info.Env(), "argument time must be after t0");
+            return false;
+        }
+        counter = (uint64_t) steps;
+        return true;
+    }
+
+#define CHECK_OTP_DIGITS(DIGITS) \
+    if( (DIGITS) < OTP_DIGITS_MIN || (DIGITS) > OTP_DIGITS_MAX ) { \
+        THROW_ERROR("digits must be between 6 and 10"); \
+    }
+
+    Napi::Value Hotp(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument counter is required");
+        ARG_TO_OTP_COUNTER(counter);
+        size_t digits = OTP_DIGITS_MIN;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            ARG_TO_NUMBER(ndigits);
+            digits = ndigits;
+        }
+        CHECK_OTP_DIGITS(digits);
+
+        char code[OTP_DIGITS_MAX];
+        Otp(counter, digits, code);
+        return Napi::String::New(env, code, digits);
+    }
+
+    Napi::Value Totp(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        size_t digits = OTP_DIGITS_MIN, window = 0;
+        double step = 30, t0 = 0;
+        uint64_t counter = 0;
+        if( !OtpOptions(info, 1, digits, step, t0, window) || !OtpStep(info, 0, step, t0, counter) ) {
+            return NAPI_NULL;
+        }
+        CHECK_OTP_DIGITS(digits);
+
+        char code[OTP_DIGITS_MAX];
+        Otp(counter, digits, code);
+        return Napi::String::New(env, code, digits);
+    }
+
+    Napi::Value VerifyHotp(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments code and counter are required");
+        if( !info[0].IsString() ) {
+            THROW_ERROR("argument code must be a string");
+        }
+        std::string code = info[0].As<Napi::String>().Utf8Value();
+        _arg++;
+        ARG_TO_OTP_COUNTER(counter);
+        size_t window = 0;
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            ARG_TO_NUMBER(nwindow);
+            window = nwindow;
+        }
+        if( window > OTP_WINDOW_MAX ) {
+            THROW_ERROR("argument window must be 100 or less");
+        }
+
+        // The length of the code picks the digits
+        uint64_t found = 0;
+        bool ok = code.size() >= OTP_DIGITS_MIN && code.size() <= OTP_DIGITS_MAX &&
+                  OtpMatch(code, code.size(), counter, counter + window, found);
+        sodium_memzero(&code[0], code.size());
+        return ok ? Napi::Number::New(env, (double) found) : NAPI_NULL;
+    }
+
+    Napi::Value VerifyTotp(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument code is required");
+        if( !info[0].IsString() ) {
+            THROW_ERROR("argument code must be a string");
+        }
+        size_t digits = OTP_DIGITS_MIN, window = 1;
+        double step = 30, t0 = 0;
+        uint64_t counter = 0;
+        if( !OtpOptions(info, 2, digits, step, t0, window) || !OtpStep(info, 1, step, t0, counter) ) {
+            return NAPI_NULL;
+        }
+        CHECK_OTP_DIGITS(digits);
+        if( window > OTP_WINDOW_MAX ) {
+            THROW_ERROR("option window must be 100 or less");
+        }
+
+        std::string code = info[0].As<Napi::String>().Utf8Value();
+        uint64_t first = counter > window ? counter - window : 0;
+        uint64_t found = 0;
+        bool ok = OtpMatch(code, digits, first, counter + window, found);
+        sodium_memzero(&code[0], code.size());
+        return ok ? Napi::Number::New(env, (double) found) : NAPI_NULL;
+    }
+
+#undef CHECK_OTP_DIGITS
+#undef OTP_DIGITS_MIN
+#undef OTP_DIGITS_MAX
+#undef OTP_WINDOW_MAX
+#undef ARG_TO_OTP_COUNTER
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    friend Napi::Value hmac_verify_any(const Napi::CallbackInfo& info, const HmacAlgorithm* algo);
+
+    const HmacAlgorithm* algo;
+
+    // The HMAC state right after `_init` with the key
+    unsigned char* keyed;
+};
+
+/**
+ * Check `token` against `message` under every key of `keyring`, an array
+ * of `crypto_auth_<algo>_KEYBYTES` Buffers or HmacKeys of the same
+ * algorithm. HmacKeys skip the pad hashing, so a keyring of them costs one
+ * MAC of the message per key. Every key is tried, whichever matches, so the
+ * time taken does not tell where the match is.
+ *
+ * Returns the index of the first matching key, -1 if none matches
+ */
+Napi::Value hmac_verify_any(const Napi::CallbackInfo& info, const HmacAlgorithm* algo) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: token, message, keyring");
+    ARG_TO_UCHAR_BUFFER(token);
+    ARG_TO_UCHAR_BUFFER(message);
+    if( token_size != algo->bytes ) {
+        THROW_ERROR("argument token must be crypto_auth_" + std::string(algo->name) + "_BYTES bytes long");
+    }
+    if( !info[2].IsArray() ) {
+        THROW_ERROR("argument keyring must be an array of keys");
+    }
+
+    Napi::Array keyring = info[2].As<Napi::Array>();
+    uint32_t count = keyring.Length();
+    std::vector<const void*> keyed(count);
+    std::vector<SodiumSpan> keys(count);
+    for(uint32_t i = 0; i < count; i++) {
+        Napi::Value item = keyring.Get(i);
+        HmacKey* hmac = HmacKey::FromValue(env, item);
+        if( hmac != NULL ) {
+            if( hmac->keyed == NULL ) {
+                THROW_ERROR("keyring[" + std::to_string(i) + "] was disposed");
+            }
+            if( hmac->algo != algo ) {
+                THROW_ERROR("keyring[" + std::to_string(i) + "] is not a " + std::string(algo->name) + " key");
+            }
+            keyed[i] = hmac->keyed;
+        } else {
+            unsigned char* key = NULL;
+            size_t key_size = 0;
+            if( !sodium_arg_bytes(item, key, key_size) || key_size != algo->keybytes ) {
+                THROW_ERROR("keyring[" + std::to_string(i) + "] must be an HmacKey or a crypto_auth_" +
+                            std::string(algo->name) + "_KEYBYTES bytes long buffer");
+            }
+            keyed[i] = NULL;
+            keys[i].data = key;
+            keys[i].size = key_size;
+        }
+    }
+
+    int32_t found = -1;
+    // Big enough for any of the states
+    crypto_auth_hmacsha512_state state;
+    unsigned char expected[crypto_auth_hmacsha512_BYTES];
+    for(uint32_t i = 0; i < count; i++) {
+        const void* from = keyed[i];
+        if( from == NULL ) {
+            algo->init(&state, keys[i].data, keys[i].size);
+            from = &state;
+        }
+        algo->mac(from, expected, message, message_size);
+        if( sodium_memcmp(expected, token, algo->bytes) == 0 && found < 0 ) {
+            found = (int32_t) i;
+        }
+    }
+    sodium_memzero(&state, sizeof state);
+    sodium_memzero(expected, sizeof expected);
+
+    return Napi::Number::New(env, found);
+}
+
+#define CRYPTO_AUTH_VERIFY_ANY_DEF(ALGO, INDEX) \
+    NAPI_METHOD(crypto_auth_ ## ALGO ## _verify_any) { \
+        return hmac_verify_any(info, &hmac_algorithms[INDEX]); \
+    }
+
+CRYPTO_AUTH_VERIFY_ANY_DEF(hmacsha256, 0)
+CRYPTO_AUTH_VERIFY_ANY_DEF(hmacsha512, 1)
+CRYPTO_AUTH_VERIFY_ANY_DEF(hmacsha512256, 2)
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_auth_key(Napi::Env env, Napi::Object exports) {
+    HmacKey::Init(env, exports);
+
+    EXPORT(crypto_auth_hmacsha256_verify_any);
+    EXPORT(crypto_auth_hmacsha512_verify_any);
+    EXPORT(crypto_auth_hmacsha512256_verify_any);
+    EXPORT_ALIAS(crypto_auth_verify_any, crypto_auth_hmacsha512256_verify_any);
+}
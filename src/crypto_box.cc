@@ -5,7 +5,14 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <map>
+
 #include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "crypto_box_cache.h"
+#include "crypto_keypair_pool.h"
+#include "sodium_stats.h"
 
 /**
  * Encrypts a message given the senders secret key, and receivers public key.
@@ -45,27 +52,35 @@ NAPI_METHOD(crypto_box) {
     ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
 
-    NEW_BUFFER_AND_PTR(msg, message_size + crypto_box_ZEROBYTES);
-
-    // Fill the first crypto_box_ZEROBYTES with 0
-    unsigned int i;
-    for(i = 0; i < crypto_box_ZEROBYTES; i++) {
-       msg_ptr[i] = 0U;
-    }
-
-    //Copy the message to the new buffer
-    memcpy((void*) (msg_ptr + crypto_box_ZEROBYTES), (void *) message, message_size);
-    message_size += crypto_box_ZEROBYTES;
+    // NaCl layout: crypto_box_BOXZEROBYTES zeros, the MAC, then the cipher text.
+    // Write it straight into the result with the detached API instead of
+    // padding and copying the message first.
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_ZEROBYTES);
+    memset(ctxt_ptr, 0, crypto_box_BOXZEROBYTES);
 
-    NEW_BUFFER_AND_PTR(ctxt, message_size);
+    BOX_CACHE_CALL(rc, publicKey, secretKey,
+        crypto_box_detached_afternm(ctxt_ptr + crypto_box_ZEROBYTES, ctxt_ptr + crypto_box_BOXZEROBYTES,
+            message, message_size, nonce, box_k),
+        crypto_box_detached(ctxt_ptr + crypto_box_ZEROBYTES, ctxt_ptr + crypto_box_BOXZEROBYTES,
+            message, message_size, nonce, publicKey, secretKey));
+    SODIUM_STAT(box, message_size, message_size + crypto_box_ZEROBYTES, rc);
 
-    if (crypto_box(ctxt_ptr, msg_ptr, message_size, nonce, publicKey, secretKey) == 0) {
+    if (rc == 0) {
         return ctxt;
     }
 
     return NAPI_NULL;
 }
 
+// crypto_box_easy through the shared key cache
+static int box_easy(unsigned char* c, const unsigned char* m, unsigned long long mlen,
+                    const unsigned char* n, const unsigned char* pk, const unsigned char* sk) {
+    BOX_CACHE_CALL(rc, pk, sk,
+        crypto_box_easy_afternm(c, m, mlen, n, box_k),
+        crypto_box_easy(c, m, mlen, n, pk, sk));
+    return SODIUM_STAT(box, mlen, mlen + crypto_box_MACBYTES, rc);
+}
+
 /**
  * Encrypts a message given the senders secret key, and receivers public key.
  * int crypto_box_easy   (
@@ -105,7 +120,7 @@ NAPI_METHOD(crypto_box_easy) {
     // The ciphertext will include the mac.
     NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_MACBYTES);
 
-    if (crypto_box_easy(ctxt_ptr, message, message_size, nonce, publicKey, secretKey) == 0) {
+    if (box_easy(ctxt_ptr, message, message_size, nonce, publicKey, secretKey) == 0) {
         return ctxt;
     } 
 
@@ -141,7 +156,7 @@ NAPI_METHOD(crypto_box_keypair) {
     NEW_BUFFER_AND_PTR(pk, crypto_box_PUBLICKEYBYTES);
     NEW_BUFFER_AND_PTR(sk, crypto_box_SECRETKEYBYTES);
 
-    if (crypto_box_keypair(pk_ptr, sk_ptr) == 0) {
+    if (keypair_pool_take(KEYPAIR_POOL_X25519, pk_ptr, sk_ptr) == 0) {
         Napi::Object result = Napi::Object::New(env);
 
         result.Set(Napi::String::New(env, "publicKey"), pk);
@@ -153,6 +168,96 @@ NAPI_METHOD(crypto_box_keypair) {
     return NAPI_NULL;
 }
 
+/**
+ * crypto_box_keypair_packed:
+ * Same as crypto_box_keypair, in one buffer
+ *
+ * Returns publicKey || secretKey, `crypto_box_PUBLICKEYBYTES +
+ * crypto_box_SECRETKEYBYTES` bytes, instead of an object holding two buffers
+ */
+NAPI_METHOD(crypto_box_keypair_packed) {
+    Napi::Env env = info.Env();
+
+    NEW_BUFFER_AND_PTR(kp, crypto_box_PUBLICKEYBYTES + crypto_box_SECRETKEYBYTES);
+
+    if (keypair_pool_take(KEYPAIR_POOL_X25519, kp_ptr, kp_ptr + crypto_box_PUBLICKEYBYTES) == 0) {
+        return kp;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_box_keypair_batch:
+ * Make many key pairs in one call
+ *
+ *     var kps = sodium.crypto_box_keypair_batch(count, [threads]);
+ *     var kps = sodium.crypto_box_keypair_batch(seeds, [threads]);
+ *
+ * ~ count (Number): random key pairs to make
+ * ~ seeds (Buffer): `crypto_box_SEEDBYTES` seeds back to back, one key pair
+ *   each, as `crypto_box_seed_keypair` makes it
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   The call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ keyPairs (Buffer): publicKey || secretKey of every pair back to back,
+ *   `crypto_box_PUBLICKEYBYTES + crypto_box_SECRETKEYBYTES` bytes each
+ */
+NAPI_METHOD(crypto_box_keypair_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument count or seeds is required");
+    ARG_TO_KEYPAIR_BATCH(count, seeds, crypto_box_SEEDBYTES);
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    NEW_BUFFER_AND_PTR(kps, count * (crypto_box_PUBLICKEYBYTES + crypto_box_SECRETKEYBYTES));
+
+    if( sodium_batch_keypairs(kps_ptr, count, crypto_box_PUBLICKEYBYTES, crypto_box_SECRETKEYBYTES,
+                              seeds, crypto_box_SEEDBYTES, crypto_box_keypair, crypto_box_seed_keypair,
+                              threads) == 0 ) {
+        return kps;
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_box_keypair_batch_async:
+ * Same as `crypto_box_keypair_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_box_keypair_batch_async(countOrSeeds, [threads], [callback]);
+ *
+ * Seeds are copied, and the copy wiped once the job is done.
+ */
+NAPI_METHOD(crypto_box_keypair_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument count or seeds is required");
+    ARG_TO_KEYPAIR_BATCH(count, seeds, crypto_box_SEEDBYTES);
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    NEW_BUFFER_AND_PTR(kps, count * (crypto_box_PUBLICKEYBYTES + crypto_box_SECRETKEYBYTES));
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_keypair_batch");
+    unsigned char* out = worker->Pin(kps);
+    const unsigned char* sd = seeds != NULL ? worker->Copy(seeds, count * crypto_box_SEEDBYTES) : NULL;
+
+    return worker->Start([=]() {
+        return sodium_batch_keypairs(out, count, crypto_box_PUBLICKEYBYTES, crypto_box_SECRETKEYBYTES,
+                                     sd, crypto_box_SEEDBYTES, crypto_box_keypair, crypto_box_seed_keypair,
+                                     threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
 /**
  * Decrypts a ciphertext ctxt given the receivers private key, and senders public key.
  *
@@ -207,20 +312,38 @@ NAPI_METHOD(crypto_box_open) {
         THROW_ERROR("the first crypto_box_BOXZEROBYTES bytes of argument cipherText must be 0");
     }
 
-    NEW_BUFFER_AND_PTR(msg, cipherText_size);
+    // Shorter than the padding plus the MAC: cannot be valid
+    if (cipherText_size < crypto_box_ZEROBYTES) {
+        return NAPI_NULL;
+    }
 
-    if (crypto_box_open(msg_ptr, cipherText, cipherText_size, nonce, publicKey, secretKey) == 0) {
+    // Decrypt straight into the result; the detached API checks the MAC
+    // before writing any plain text
+    NEW_BUFFER_AND_PTR(plain_text, cipherText_size - crypto_box_ZEROBYTES);
 
-        // Remove the padding at the beginning of the message
-        NEW_BUFFER_AND_PTR(plain_text, cipherText_size - crypto_box_ZEROBYTES);
-        memcpy(plain_text_ptr,(void*) (msg_ptr + crypto_box_ZEROBYTES), cipherText_size - crypto_box_ZEROBYTES);
+    BOX_CACHE_CALL(rc, publicKey, secretKey,
+        crypto_box_open_detached_afternm(plain_text_ptr, cipherText + crypto_box_ZEROBYTES, cipherText + crypto_box_BOXZEROBYTES,
+            cipherText_size - crypto_box_ZEROBYTES, nonce, box_k),
+        crypto_box_open_detached(plain_text_ptr, cipherText + crypto_box_ZEROBYTES, cipherText + crypto_box_BOXZEROBYTES,
+            cipherText_size - crypto_box_ZEROBYTES, nonce, publicKey, secretKey));
+    SODIUM_STAT(box, cipherText_size, cipherText_size - crypto_box_ZEROBYTES, rc);
 
+    if (rc == 0) {
         return plain_text;
-    } 
-    
+    }
+
     return NAPI_NULL;
 }
 
+// crypto_box_open_easy through the shared key cache
+static int box_open_easy(unsigned char* m, const unsigned char* c, unsigned long long clen,
+                         const unsigned char* n, const unsigned char* pk, const unsigned char* sk) {
+    BOX_CACHE_CALL(rc, pk, sk,
+        crypto_box_open_easy_afternm(m, c, clen, n, box_k),
+        crypto_box_open_easy(m, c, clen, n, pk, sk));
+    return SODIUM_STAT(box, clen, clen - crypto_box_MACBYTES, rc);
+}
+
 /**
  * Decrypts a ciphertext ctxt given the receivers private key, and senders public key.
  *
@@ -253,7 +376,7 @@ NAPI_METHOD(crypto_box_open_easy) {
     Napi::Env env = info.Env();
 
     ARGS(4, "arguments cipherText, nonce, publicKey and secretKey must be buffers");
-    ARG_TO_UCHAR_BUFFER(cipherText);
+    ARG_TO_UCHAR_BUFFER_RANGE(cipherText);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
@@ -263,13 +386,77 @@ NAPI_METHOD(crypto_box_open_easy) {
         THROW_ERROR("argument cipherText must have a length of at least crypto_box_MACBYTES bytes");
     }
 
+    RETURN_DECRYPTED(msg, cipherText_size - crypto_box_MACBYTES,
+        box_open_easy(msg_ptr, cipherText, cipherText_size, nonce, publicKey, secretKey));
+}
+
+/**
+ * crypto_box_easy_async:
+ * Same as `crypto_box_easy` but runs on the libuv threadpool
+ *
+ *     sodium.crypto_box_easy_async(message, nonce, publicKey, secretKey, [options], [callback]);
+ *
+ * crypto_box_open_easy_async:
+ * Same as `crypto_box_open_easy` but runs on the libuv threadpool. Resolves
+ * to the plain text, or null if `cipherText` does not verify
+ *
+ *     sodium.crypto_box_open_easy_async(cipherText, nonce, publicKey, secretKey, [options], [callback]);
+ *
+ * For uploads and exports of several MB. The input is pinned, not copied,
+ * so do not change it until the result is delivered; the output is
+ * allocated up front and filled in place on the pool thread. When a Promise
+ * is returned and the input is shorter than `sodium_async_threshold()`
+ * bytes the box is computed inline. Keys go through the shared key cache
+ * like the sync calls.
+ */
+NAPI_METHOD(crypto_box_easy_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments message, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_MACBYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_easy");
+    unsigned char* out = worker->Pin(ctxt);
+    const unsigned char* m = worker->Pin(message_buffer);
+    const unsigned char* n = worker->Copy(nonce, crypto_box_NONCEBYTES);
+    const unsigned char* pk = worker->Copy(publicKey, crypto_box_PUBLICKEYBYTES);
+    const unsigned char* sk = worker->Copy(secretKey, crypto_box_SECRETKEYBYTES);
+
+    return worker->StartTiered([=]() {
+        return box_easy(out, m, message_size, n, pk, sk);
+    }, ASYNC_RESULT_BUFFER, message_size);
+}
+
+NAPI_METHOD(crypto_box_open_easy_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments cipherText, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(cipherText);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
+
+    if (cipherText_size < crypto_box_MACBYTES) {
+        THROW_ERROR("argument cipherText must have a length of at least crypto_box_MACBYTES bytes");
+    }
+
     NEW_BUFFER_AND_PTR(msg, cipherText_size - crypto_box_MACBYTES);
 
-    if( crypto_box_open_easy(msg_ptr, cipherText, cipherText_size, nonce, publicKey, secretKey) == 0) {
-        return msg;
-    } 
-    
-    return NAPI_NULL;
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_open_easy");
+    unsigned char* out = worker->Pin(msg);
+    const unsigned char* c = worker->Pin(cipherText_buffer);
+    const unsigned char* n = worker->Copy(nonce, crypto_box_NONCEBYTES);
+    const unsigned char* pk = worker->Copy(publicKey, crypto_box_PUBLICKEYBYTES);
+    const unsigned char* sk = worker->Copy(secretKey, crypto_box_SECRETKEYBYTES);
+
+    return worker->StartTiered([=]() {
+        return box_open_easy(out, c, cipherText_size, n, pk, sk);
+    }, ASYNC_RESULT_BUFFER, cipherText_size);
 }
 
 /**
@@ -333,24 +520,15 @@ NAPI_METHOD(crypto_box_afternm) {
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_BEFORENMBYTES);
 
-    // Pad the message with crypto_box_ZEROBYTES zeros
-    NEW_BUFFER_AND_PTR(msg, message_size + crypto_box_ZEROBYTES);
+    // Same NaCl layout as crypto_box
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_ZEROBYTES);
+    memset(ctxt_ptr, 0, crypto_box_BOXZEROBYTES);
 
-    unsigned int i;
-    for(i = 0; i < crypto_box_ZEROBYTES; i++) {
-       msg_ptr[i] = 0U;
+    if (crypto_box_detached_afternm(ctxt_ptr + crypto_box_ZEROBYTES, ctxt_ptr + crypto_box_BOXZEROBYTES,
+            message, message_size, nonce, k) == 0) {
+        return ctxt;
     }
 
-    //Copy the message to the new buffer
-    memcpy((void*) (msg_ptr + crypto_box_ZEROBYTES), (void *) message, message_size);
-    message_size += crypto_box_ZEROBYTES;
-
-    NEW_BUFFER_AND_PTR(ctxt, message_size);
-
-    if (crypto_box_afternm(ctxt_ptr, msg_ptr, message_size, nonce, k) == 0) {
-        return ctxt;
-    } 
-    
     return NAPI_NULL;
 }
 
@@ -403,17 +581,17 @@ NAPI_METHOD(crypto_box_open_afternm) {
         THROW_ERROR("the first crypto_box_BOXZEROBYTES bytes of argument cipherText must be 0");
     }
 
-    NEW_BUFFER_AND_PTR(msg, cipherText_size);
-
-    if (crypto_box_open_afternm(msg_ptr, cipherText, cipherText_size, nonce, k) == 0) {
+    if (cipherText_size < crypto_box_ZEROBYTES) {
+        return NAPI_NULL;
+    }
 
-        // Remove the padding at the beginning of the message
-        NEW_BUFFER_AND_PTR(plain_text,cipherText_size - crypto_box_ZEROBYTES);
-        memcpy(plain_text_ptr,(void*) (msg_ptr + crypto_box_ZEROBYTES), cipherText_size - crypto_box_ZEROBYTES);
+    NEW_BUFFER_AND_PTR(plain_text, cipherText_size - crypto_box_ZEROBYTES);
 
+    if (crypto_box_open_detached_afternm(plain_text_ptr, cipherText + crypto_box_ZEROBYTES, cipherText + crypto_box_BOXZEROBYTES,
+            cipherText_size - crypto_box_ZEROBYTES, nonce, k) == 0) {
         return plain_text;
     }
-        
+
     return NAPI_NULL;
 }
 
@@ -438,7 +616,12 @@ NAPI_METHOD(crypto_box_detached) {
     NEW_BUFFER_AND_PTR(c, message_size);
     NEW_BUFFER_AND_PTR(mac, crypto_secretbox_MACBYTES);
 
-    if (crypto_box_detached(c_ptr, mac_ptr, message, message_size, nonce, pk, sk) == 0) {
+    BOX_CACHE_CALL(rc, pk, sk,
+        crypto_box_detached_afternm(c_ptr, mac_ptr, message, message_size, nonce, box_k),
+        crypto_box_detached(c_ptr, mac_ptr, message, message_size, nonce, pk, sk));
+    SODIUM_STAT(box, message_size, message_size + crypto_box_MACBYTES, rc);
+
+    if (rc == 0) {
         Napi::Object result = Napi::Object::New(env);
         result.Set(Napi::String::New(env, "cipherText"), c);
         result.Set(Napi::String::New(env, "mac"), mac);
@@ -448,6 +631,37 @@ NAPI_METHOD(crypto_box_detached) {
     return NAPI_NULL;
 }
 
+/**
+ * crypto_box_detached_packed:
+ * Same as crypto_box_detached, in one buffer
+ *
+ * Returns cipherText || mac, `message.length + crypto_box_MACBYTES` bytes,
+ * instead of an object holding two buffers
+ */
+NAPI_METHOD(crypto_box_detached_packed) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments message, nonce, and public and private key must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size + crypto_box_MACBYTES);
+    unsigned char* mac_ptr = c_ptr + message_size;
+
+    BOX_CACHE_CALL(rc, pk, sk,
+        crypto_box_detached_afternm(c_ptr, mac_ptr, message, message_size, nonce, box_k),
+        crypto_box_detached(c_ptr, mac_ptr, message, message_size, nonce, pk, sk));
+    SODIUM_STAT(box, message_size, message_size + crypto_box_MACBYTES, rc);
+
+    if (rc == 0) {
+        return c;
+    }
+
+    return NAPI_NULL;
+}
+
 /*
  *int crypto_box_open_detached(unsigned char *m,
  *                           const unsigned char *c,
@@ -470,7 +684,12 @@ NAPI_METHOD(crypto_box_open_detached) {
 
     NEW_BUFFER_AND_PTR(m, c_size);
 
-    if (crypto_box_open_detached(m_ptr, c, mac, c_size, nonce, pk, sk) == 0) {
+    BOX_CACHE_CALL(rc, pk, sk,
+        crypto_box_open_detached_afternm(m_ptr, c, mac, c_size, nonce, box_k),
+        crypto_box_open_detached(m_ptr, c, mac, c_size, nonce, pk, sk));
+    SODIUM_STAT(box, c_size + crypto_box_MACBYTES, c_size, rc);
+
+    if (rc == 0) {
         return m;
     }
     
@@ -490,7 +709,7 @@ NAPI_METHOD(crypto_box_seal) {
 
     NEW_BUFFER_AND_PTR(c, message_size + crypto_box_SEALBYTES);
 
-    if (crypto_box_seal(c_ptr, message, message_size, pk) == 0) {
+    if (keypair_pool_box_seal(c_ptr, message, message_size, pk) == 0) {
         return c;
     }
     
@@ -519,6 +738,472 @@ NAPI_METHOD(crypto_box_seal_open) {
     return NAPI_NULL;
 }
 
+/**
+ * crypto_box_seal_async:
+ * Same as `crypto_box_seal` but runs on the libuv threadpool
+ *
+ *     sodium.crypto_box_seal_async(message, publicKey, [callback]);
+ *
+ * Returns a Promise when no callback is given. The ephemeral key pair and the
+ * X25519 scalar multiplication run on the pool thread.
+ */
+NAPI_METHOD(crypto_box_seal_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments unencrypted message, and recipient public key must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_PUBLICKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size + crypto_box_SEALBYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_seal");
+    unsigned char* out = worker->Pin(c);
+    const unsigned char* m = worker->Copy(message, message_size);
+    const unsigned char* key = worker->Copy(pk, crypto_box_PUBLICKEYBYTES);
+
+    return worker->Start([=]() {
+        return keypair_pool_box_seal(out, m, message_size, key);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_box_seal_open_async:
+ * Same as `crypto_box_seal_open` but runs on the libuv threadpool
+ *
+ *     sodium.crypto_box_seal_open_async(cipherText, publicKey, secretKey, [callback]);
+ *
+ * Resolves to the plain text, or null if `cipherText` is not valid.
+ */
+NAPI_METHOD(crypto_box_seal_open_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments encrypted message, recipient public key, and recipient secret key must be buffers");
+    ARG_TO_UCHAR_BUFFER(c);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+
+    if( c_size < crypto_box_SEALBYTES ) {
+        THROW_ERROR("argument encrypted message must be at least crypto_box_SEALBYTES bytes long");
+    }
+
+    NEW_BUFFER_AND_PTR(m, c_size - crypto_box_SEALBYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_seal_open");
+    unsigned char* out = worker->Pin(m);
+    const unsigned char* ctxt = worker->Copy(c, c_size);
+    const unsigned char* rpk = worker->Copy(pk, crypto_box_PUBLICKEYBYTES);
+    const unsigned char* rsk = worker->Copy(sk, crypto_box_SECRETKEYBYTES);
+
+    return worker->Start([=]() {
+        return crypto_box_seal_open(out, ctxt, c_size, rpk, rsk);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+// Seal the same message to every recipient, `threads` at a time. Sealed box
+// `i` starts at `out + i * (mlen + crypto_box_SEALBYTES)`.
+static int box_seal_batch(unsigned char* out, const unsigned char* m, size_t mlen,
+                          const std::vector<SodiumSpan>& pks, size_t threads) {
+    size_t stride = mlen + crypto_box_SEALBYTES;
+    std::vector<unsigned char> ok(pks.size(), 0);
+
+    sodium_batch_parallel(pks.size(), threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ok[i] = keypair_pool_box_seal(out + i * stride, m, mlen, pks[i].data) == 0;
+        }
+    });
+
+    for(size_t i = 0; i < ok.size(); i++) {
+        if( !ok[i] ) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Open every sealed box for one recipient. Plain text `i` is written at the
+// sum of the lengths of plain texts 0 to i - 1.
+static int box_seal_open_batch(unsigned char* out, const std::vector<SodiumSpan>& cs,
+                               const unsigned char* pk, const unsigned char* sk, size_t threads) {
+    std::vector<size_t> offsets(cs.size());
+    size_t offset = 0;
+    for(size_t i = 0; i < cs.size(); i++) {
+        offsets[i] = offset;
+        offset += cs[i].size - crypto_box_SEALBYTES;
+    }
+
+    std::vector<unsigned char> ok(cs.size(), 0);
+    sodium_batch_parallel(cs.size(), threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ok[i] = crypto_box_seal_open(out + offsets[i], cs[i].data, cs[i].size, pk, sk) == 0;
+        }
+    });
+
+    for(size_t i = 0; i < ok.size(); i++) {
+        if( !ok[i] ) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Optional `threads` number argument, before an optional callback
+#define ARG_TO_THREADS(NAME) \
+    size_t NAME = 1; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        NAME = NAME ## _arg; \
+    }
+
+// Public keys are an array of buffers or one buffer with the keys back to back
+#define ARG_TO_PUBLIC_KEYS(NAME, COUNT) \
+    size_t COUNT = SODIUM_BATCH_ANY; \
+    { \
+        unsigned char* NAME ## _packed = NULL; \
+        size_t NAME ## _packed_size = 0; \
+        if( sodium_arg_bytes(info[_arg], NAME ## _packed, NAME ## _packed_size) ) { \
+            COUNT = NAME ## _packed_size / crypto_box_PUBLICKEYBYTES; \
+        } \
+    } \
+    ARG_TO_BATCH_LEN(NAME, COUNT, crypto_box_PUBLICKEYBYTES)
+
+// Every sealed box must at least hold the ephemeral key and the MAC
+#define CHECK_SEALED_BOXES(NAME, TOTAL) \
+    size_t TOTAL = 0; \
+    for(size_t i = 0; i < NAME.size(); i++) { \
+        if( NAME[i].size < crypto_box_SEALBYTES ) { \
+            THROW_ERROR("argument " #NAME " elements must be at least crypto_box_SEALBYTES bytes long"); \
+        } \
+        TOTAL += NAME[i].size - crypto_box_SEALBYTES; \
+    }
+
+/**
+ * crypto_box_seal_batch:
+ * Seal one message to many recipients
+ *
+ *     var c = sodium.crypto_box_seal_batch(message, publicKeys, [threads]);
+ *
+ * ~ message (Buffer): message to seal
+ * ~ publicKeys (Array|Buffer): recipient public keys, or one buffer with the
+ *   keys back to back
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   The call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ cipherTexts (Buffer): the sealed boxes back to back, in the order of
+ *   `publicKeys`. Each is `message.length + crypto_box_SEALBYTES` long
+ * ~ null: if any public key is rejected
+ *
+ * Every recipient gets its own ephemeral key pair, exactly as with
+ * `crypto_box_seal`.
+ */
+NAPI_METHOD(crypto_box_seal_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments message and publicKeys are required");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_PUBLIC_KEYS(publicKeys, count);
+    ARG_TO_THREADS(threads);
+
+    NEW_BUFFER_AND_PTR(c, count * (message_size + crypto_box_SEALBYTES));
+
+    if( box_seal_batch(c_ptr, message, message_size, publicKeys, threads) == 0 ) {
+        return c;
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_box_seal_batch_async:
+ * Same as `crypto_box_seal_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_box_seal_batch_async(message, publicKeys, [threads], [callback]);
+ *
+ * Returns a Promise when no callback is given. With `threads` above 1 the
+ * pool thread fans the batch out to that many threads.
+ */
+NAPI_METHOD(crypto_box_seal_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments message and publicKeys are required");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_PUBLIC_KEYS(publicKeys, count);
+    ARG_TO_THREADS(threads);
+
+    NEW_BUFFER_AND_PTR(c, count * (message_size + crypto_box_SEALBYTES));
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_seal_batch");
+    unsigned char* out = worker->Pin(c);
+    const unsigned char* m = worker->Copy(message, message_size);
+    std::vector<SodiumSpan> pks(count);
+    for(size_t i = 0; i < count; i++) {
+        pks[i].data = worker->Copy(publicKeys[i].data, crypto_box_PUBLICKEYBYTES);
+        pks[i].size = crypto_box_PUBLICKEYBYTES;
+    }
+
+    return worker->Start([=]() {
+        return box_seal_batch(out, m, message_size, pks, threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_box_seal_open_batch:
+ * Open many sealed boxes addressed to one recipient
+ *
+ *     var m = sodium.crypto_box_seal_open_batch(cipherTexts, publicKey, secretKey, [threads]);
+ *
+ * ~ cipherTexts (Array): sealed boxes
+ * ~ publicKey, secretKey (Buffer): the recipient key pair
+ * ~ threads (Number): optional, as in `crypto_box_seal_batch`
+ *
+ * **Returns**:
+ *
+ * ~ plainTexts (Buffer): all the plain texts back to back, in order. Plain
+ *   text `i` is `cipherTexts[i].length - crypto_box_SEALBYTES` long
+ * ~ null: if any sealed box is not valid
+ */
+NAPI_METHOD(crypto_box_seal_open_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments cipherTexts, publicKey and secretKey are required");
+    size_t count = SODIUM_BATCH_ANY;
+    ARG_TO_BATCH(cipherTexts, count);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_THREADS(threads);
+    CHECK_SEALED_BOXES(cipherTexts, total);
+
+    NEW_BUFFER_AND_PTR(m, total);
+
+    if( box_seal_open_batch(m_ptr, cipherTexts, pk, sk, threads) == 0 ) {
+        return m;
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_box_seal_open_batch_async:
+ * Same as `crypto_box_seal_open_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_box_seal_open_batch_async(cipherTexts, publicKey, secretKey, [threads], [callback]);
+ */
+NAPI_METHOD(crypto_box_seal_open_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments cipherTexts, publicKey and secretKey are required");
+    size_t count = SODIUM_BATCH_ANY;
+    ARG_TO_BATCH(cipherTexts, count);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_THREADS(threads);
+    CHECK_SEALED_BOXES(cipherTexts, total);
+
+    NEW_BUFFER_AND_PTR(m, total);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_seal_open_batch");
+    unsigned char* out = worker->Pin(m);
+    const unsigned char* rpk = worker->Copy(pk, crypto_box_PUBLICKEYBYTES);
+    const unsigned char* rsk = worker->Copy(sk, crypto_box_SECRETKEYBYTES);
+    std::vector<SodiumSpan> cs(count);
+    for(size_t i = 0; i < count; i++) {
+        cs[i].data = worker->Copy(cipherTexts[i].data, cipherTexts[i].size);
+        cs[i].size = cipherTexts[i].size;
+    }
+
+    return worker->Start([=]() {
+        return box_seal_open_batch(out, cs, rpk, rsk, threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+// Where each plain text of a crypto_box_open_easy batch goes, back to back.
+// Boxes too short to hold a MAC get no room. Returns the total length
+static size_t box_open_easy_batch_offsets(const std::vector<SodiumSpan>& cs, std::vector<size_t>& offsets) {
+    size_t total = 0;
+    offsets.resize(cs.size());
+    for(size_t i = 0; i < cs.size(); i++) {
+        offsets[i] = total;
+        total += cs[i].size < crypto_box_MACBYTES ? 0 : cs[i].size - crypto_box_MACBYTES;
+    }
+    return total;
+}
+
+// Open boxes from many senders to one recipient. The shared key of each
+// distinct sender is computed once, through the shared key cache, and both
+// the scalar multiplications and the boxes are split across `threads`.
+// Plain text `i` is written at `offsets[i]` and zeroed if it does not open.
+static void box_open_easy_batch(unsigned char* out, const std::vector<SodiumSpan>& cs,
+                                const unsigned char* nonces, const unsigned char* pks,
+                                const unsigned char* sk, const std::vector<size_t>& offsets,
+                                std::vector<unsigned char>& ok, size_t threads) {
+    std::map<std::string, size_t> index;
+    std::vector<const unsigned char*> senders;
+    std::vector<size_t> sender(cs.size());
+    for(size_t i = 0; i < cs.size(); i++) {
+        const unsigned char* pk = pks + i * crypto_box_PUBLICKEYBYTES;
+        auto added = index.emplace(std::string((const char*) pk, crypto_box_PUBLICKEYBYTES), senders.size());
+        if( added.second ) {
+            senders.push_back(pk);
+        }
+        sender[i] = added.first->second;
+    }
+
+    std::vector<unsigned char> keys(senders.size() * crypto_box_BEFORENMBYTES);
+    std::vector<unsigned char> valid(senders.size(), 0);
+    sodium_batch_parallel(senders.size(), threads, 4, [&](size_t begin, size_t end) {
+        for(size_t j = begin; j < end; j++) {
+            unsigned char* k = keys.data() + j * crypto_box_BEFORENMBYTES;
+            int rc = box_cache_lookup(k, senders[j], sk);
+            if( rc == BOX_CACHE_DISABLED ) {
+                rc = box_cache_beforenm(k, senders[j], sk);
+            }
+            valid[j] = rc == 0;
+        }
+    });
+
+    sodium_batch_parallel(cs.size(), threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            size_t mlen = cs[i].size < crypto_box_MACBYTES ? 0 : cs[i].size - crypto_box_MACBYTES;
+            ok[i] = cs[i].size >= crypto_box_MACBYTES && valid[sender[i]] &&
+                SODIUM_STAT(box, cs[i].size, mlen,
+                    crypto_box_open_easy_afternm(out + offsets[i], cs[i].data, cs[i].size,
+                                                 nonces + i * crypto_box_NONCEBYTES,
+                                                 keys.data() + sender[i] * crypto_box_BEFORENMBYTES)) == 0;
+            if( !ok[i] ) {
+                sodium_memzero(out + offsets[i], mlen);
+            }
+        }
+    });
+    if( !keys.empty() ) {
+        sodium_memzero(keys.data(), keys.size());
+    }
+}
+
+// Nonces and sender keys, an array of buffers or one buffer back to back each
+#define ARG_TO_BOX_BATCH_RECORDS(CS, NONCES, PKS) \
+    ARG_TO_CHUNKS(CS, lengths); \
+    size_t CS ## _count = CS.size(); \
+    ARG_TO_BATCH_LEN(NONCES ## _spans, CS ## _count, crypto_box_NONCEBYTES); \
+    ARG_TO_BATCH_LEN(PKS ## _spans, CS ## _count, crypto_box_PUBLICKEYBYTES); \
+    std::vector<unsigned char> NONCES(CS ## _count * crypto_box_NONCEBYTES); \
+    std::vector<unsigned char> PKS(CS ## _count * crypto_box_PUBLICKEYBYTES); \
+    for(size_t i = 0; i < CS ## _count; i++) { \
+        memcpy(NONCES.data() + i * crypto_box_NONCEBYTES, NONCES ## _spans[i].data, crypto_box_NONCEBYTES); \
+        memcpy(PKS.data() + i * crypto_box_PUBLICKEYBYTES, PKS ## _spans[i].data, crypto_box_PUBLICKEYBYTES); \
+    }
+
+/**
+ * crypto_box_open_easy_batch:
+ * Open many `crypto_box_easy` boxes sent to one recipient by different
+ * senders
+ *
+ *     var r = sodium.crypto_box_open_easy_batch(cipherTexts, lengths, nonces, publicKeys, secretKey, [threads]);
+ *
+ * ~ cipherTexts (Buffer): the boxes back to back
+ * ~ lengths (Array|Uint32Array|Number): the length of each box, or one
+ *   length for all of them
+ * ~ nonces (Array|Buffer): one `crypto_box_NONCEBYTES` nonce per box
+ * ~ publicKeys (Array|Buffer): the public key of the sender of each box
+ * ~ secretKey (Buffer): the recipient secret key
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   The call still blocks
+ *
+ * **Returns** `{ plainTexts, status }`:
+ *
+ * ~ plainTexts (Buffer): the plain texts back to back, in order. Plain text
+ *   `i` is `lengths[i] - crypto_box_MACBYTES` bytes long, zeroed if the box
+ *   did not open
+ * ~ status (Buffer): bit `i % 8` of byte `i / 8` is set when box `i` opened
+ *
+ * Senders that appear several times in the batch cost one X25519 scalar
+ * multiplication, and with the shared key cache on, none once cached. The
+ * scalar multiplications are spread across the threads as well.
+ */
+NAPI_METHOD(crypto_box_open_easy_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments cipherTexts, lengths, nonces, publicKeys and secretKey are required");
+    ARG_TO_BOX_BATCH_RECORDS(cipherTexts, nonces, publicKeys);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    std::vector<size_t> offsets;
+    NEW_BUFFER_AND_PTR(m, box_open_easy_batch_offsets(cipherTexts, offsets));
+    std::vector<unsigned char> ok(cipherTexts_count, 0);
+
+    box_open_easy_batch(m_ptr, cipherTexts, nonces.data(), publicKeys.data(), sk, offsets, ok, threads);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("plainTexts", m);
+    result.Set("status", sodium_batch_bitmap(env, ok));
+    return result;
+}
+
+/**
+ * Resolves to `{ plainTexts, status }` like crypto_box_open_easy_batch
+ */
+class BoxOpenBatchWorker : public SodiumAsyncWorker {
+public:
+    BoxOpenBatchWorker(const Napi::CallbackInfo& info, size_t count)
+        : SodiumAsyncWorker(info, "crypto_box_open_easy_batch"), ok(count, 0) {}
+
+    unsigned char* Output(Napi::Object buffer) {
+        out = Napi::Persistent(buffer);
+        return Pin(buffer);
+    }
+
+    std::vector<unsigned char> ok;
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("plainTexts", out.Value());
+        result.Set("status", sodium_batch_bitmap(env, ok));
+        return result;
+    }
+
+private:
+    Napi::ObjectReference out;
+};
+
+/**
+ * crypto_box_open_easy_batch_async:
+ * Same as `crypto_box_open_easy_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_box_open_easy_batch_async(cipherTexts, lengths, nonces, publicKeys, secretKey, [threads], [callback]);
+ *
+ * The cipher texts are pinned, not copied, so do not change them until the
+ * result is delivered. With `threads` above 1 the pool thread fans the batch
+ * out to that many threads.
+ */
+NAPI_METHOD(crypto_box_open_easy_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments cipherTexts, lengths, nonces, publicKeys and secretKey are required");
+    ARG_TO_BOX_BATCH_RECORDS(cipherTexts, nonces, publicKeys);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    std::vector<size_t> offsets;
+    NEW_BUFFER_AND_PTR(m, box_open_easy_batch_offsets(cipherTexts, offsets));
+
+    BoxOpenBatchWorker* worker = new BoxOpenBatchWorker(info, cipherTexts_count);
+    unsigned char* out = worker->Output(m);
+    worker->Pin(cipherTexts_packed_buffer);
+    const unsigned char* n = worker->Copy(nonces.data(), nonces.size());
+    const unsigned char* pks = worker->Copy(publicKeys.data(), publicKeys.size());
+    const unsigned char* rsk = worker->Copy(sk, crypto_box_SECRETKEYBYTES);
+
+    return worker->Start([=]() {
+        box_open_easy_batch(out, cipherTexts, n, pks, rsk, offsets, worker->ok, threads);
+        return 0;
+    }, ASYNC_RESULT_BUFFER);
+}
+
+#undef ARG_TO_BOX_BATCH_RECORDS
+#undef ARG_TO_THREADS
+#undef ARG_TO_PUBLIC_KEYS
+#undef CHECK_SEALED_BOXES
+
 /*
  *int crypto_box_seed_keypair(unsigned char *pk, unsigned char *sk,
                             const unsigned char *seed);
@@ -612,7 +1297,8 @@ NAPI_METHOD(crypto_box_easy_afternm) {
     // The ciphertext will include the mac.
     NEW_BUFFER_AND_PTR(ctxt, crypto_box_MACBYTES + message_size);
 
-    if (crypto_box_easy_afternm(ctxt_ptr, message, message_size, nonce, k) == 0) {
+    if (SODIUM_STAT(box, message_size, message_size + crypto_box_MACBYTES,
+            crypto_box_easy_afternm(ctxt_ptr, message, message_size, nonce, k)) == 0) {
         return ctxt;
     }
     
@@ -628,7 +1314,7 @@ NAPI_METHOD(crypto_box_open_easy_afternm) {
     Napi::Env env = info.Env();
 
     ARGS(3, "arguments message, nonce and k must be buffers");
-    ARG_TO_UCHAR_BUFFER(ctxt);
+    ARG_TO_UCHAR_BUFFER_RANGE(ctxt);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_BEFORENMBYTES);
 
@@ -637,13 +1323,9 @@ NAPI_METHOD(crypto_box_open_easy_afternm) {
         THROW_ERROR("argument cipherText must have a length of at least crypto_box_MACBYTES bytes");
     }
 
-    NEW_BUFFER_AND_PTR(message, ctxt_size - crypto_box_MACBYTES);
-
-    if (crypto_box_open_easy_afternm(message_ptr, ctxt, ctxt_size, nonce, k) == 0) {
-        return message;
-    }
-    
-    return NAPI_NULL;   
+    RETURN_DECRYPTED(message, ctxt_size - crypto_box_MACBYTES,
+        SODIUM_STAT(box, ctxt_size, message_size,
+            crypto_box_open_easy_afternm(message_ptr, ctxt, ctxt_size, nonce, k)));
 }
 
 NAPI_METHOD_FROM_INT(crypto_box_noncebytes)
@@ -666,8 +1348,12 @@ void register_crypto_box(Napi::Env env, Napi::Object exports) {
      // Box
     EXPORT(crypto_box);
     EXPORT(crypto_box_keypair);
+    EXPORT(crypto_box_keypair_packed);
+    EXPORT(crypto_box_keypair_batch);
+    EXPORT(crypto_box_keypair_batch_async);
     
     EXPORT(crypto_box_easy);
+    EXPORT(crypto_box_easy_async);
     EXPORT(crypto_box_easy_afternm);
     
     EXPORT(crypto_box_beforenm);
@@ -675,17 +1361,27 @@ void register_crypto_box(Napi::Env env, Napi::Object exports) {
     EXPORT(crypto_box_seed_keypair);
     
     EXPORT(crypto_box_detached);
+    EXPORT(crypto_box_detached_packed);
     EXPORT(crypto_box_detached_afternm);
     
     EXPORT(crypto_box_open);
     EXPORT(crypto_box_open_afternm);
     EXPORT(crypto_box_open_easy);
+    EXPORT(crypto_box_open_easy_async);
     EXPORT(crypto_box_open_detached);
     EXPORT(crypto_box_open_detached_afternm);
     EXPORT(crypto_box_open_easy_afternm);
     
     EXPORT(crypto_box_seal);
     EXPORT(crypto_box_seal_open);
+    EXPORT(crypto_box_seal_async);
+    EXPORT(crypto_box_seal_open_async);
+    EXPORT(crypto_box_seal_batch);
+    EXPORT(crypto_box_seal_batch_async);
+    EXPORT(crypto_box_seal_open_batch);
+    EXPORT(crypto_box_seal_open_batch_async);
+    EXPORT(crypto_box_open_easy_batch);
+    EXPORT(crypto_box_open_easy_batch_async);
     
     EXPORT_INT(crypto_box_NONCEBYTES);
     EXPORT_INT(crypto_box_MACBYTES);
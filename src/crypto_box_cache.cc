@@ -0,0 +1,493 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <chrono>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "node_sodium.h"
+#include "crypto_box_cache.h"
+#include "sodium_memory.h"
+#include "sodium_shared_cache.h"
+#include "sodium_snapshot.h"
+
+/**
+ * crypto_box shared key cache
+ *
+ * When enabled, crypto_box, crypto_box_easy, crypto_box_detached and their
+ * open counterparts look up the `crypto_box_beforenm` result for the
+ * (publicKey, secretKey) pair here instead of redoing the X25519 scalar
+ * multiplication for every message.
+ *
+ * Entries are indexed by a keyed BLAKE2b digest of the key pair, with a
+ * random per process key, so no secret key is stored in the index. Shared
+ * keys live in one `sodium_malloc` slab: locked in memory, surrounded by
+ * guard pages and wiped when evicted or when the cache is disabled.
+ *
+ * The least recently used entry is evicted when the cache is full, and
+ * entries older than the time to live are dropped on lookup.
+ *
+ * A shared memory segment attached with crypto_box_cache_share sits behind
+ * it: a local miss, and every BoxSession, looks there before computing the
+ * key, and puts what it computed there for the other processes.
+ *
+ * crypto_box_cache_save and crypto_box_cache_load carry the cache over a
+ * restart in an encrypted snapshot, so a new process starts with the keys
+ * of its busiest peers instead of an empty cache.
+ */
+
+typedef std::chrono::steady_clock BoxCacheClock;
+
+struct BoxCacheEntry {
+    std::string id;
+    size_t slot;
+    BoxCacheClock::time_point expires;
+};
+
+static std::mutex box_cache_mutex;
+static std::list<BoxCacheEntry> box_cache_lru;   // most recent first
+static std::unordered_map<std::string, std::list<BoxCacheEntry>::iterator> box_cache_index;
+static std::vector<size_t> box_cache_free;
+static unsigned char* box_cache_keys = NULL;
+static size_t box_cache_capacity = 0;
+static BoxCacheClock::duration box_cache_ttl;
+static unsigned char box_cache_id_key[crypto_generichash_KEYBYTES];
+
+// Swapped with std::atomic_store, read with std::atomic_load
+static std::shared_ptr<SharedCache> box_cache_shared;
+
+static const unsigned char box_cache_shared_format[SHARED_CACHE_FORMATBYTES] = "box_beforenm.v1";
+
+static double box_cache_hits = 0;
+static double box_cache_misses = 0;
+static double box_cache_evictions = 0;
+static double box_cache_expirations = 0;
+
+static std::string box_cache_id(const unsigned char* pk, const unsigned char* sk) {
+    crypto_generichash_state state;
+    unsigned char id[crypto_generichash_BYTES];
+
+    crypto_generichash_init(&state, box_cache_id_key, sizeof box_cache_id_key, sizeof id);
+    crypto_generichash_update(&state, pk, crypto_box_PUBLICKEYBYTES);
+    crypto_generichash_update(&state, sk, crypto_box_SECRETKEYBYTES);
+    crypto_generichash_final(&state, id, sizeof id);
+    sodium_memzero(&state, sizeof state);
+
+    return std::string((const char*) id, sizeof id);
+}
+
+static unsigned char* box_cache_slot(size_t slot) {
+    return box_cache_keys + slot * crypto_box_BEFORENMBYTES;
+}
+
+// Caller holds box_cache_mutex
+static void box_cache_erase(std::list<BoxCacheEntry>::iterator it) {
+    sodium_memzero(box_cache_slot(it->slot), crypto_box_BEFORENMBYTES);
+    box_cache_free.push_back(it->slot);
+    box_cache_index.erase(it->id);
+    box_cache_lru.erase(it);
+}
+
+// Caller holds box_cache_mutex
+static void box_cache_reset() {
+    box_cache_lru.clear();
+    box_cache_index.clear();
+    box_cache_free.clear();
+    if( box_cache_keys != NULL ) {
+        sodium_free(box_cache_keys);
+        box_cache_keys = NULL;
+    }
+    box_cache_capacity = 0;
+}
+
+int box_cache_beforenm(unsigned char* k, const unsigned char* pk, const unsigned char* sk) {
+    std::shared_ptr<SharedCache> shared = std::atomic_load(&box_cache_shared);
+    if( !shared ) {
+        return crypto_box_beforenm(k, pk, sk);
+    }
+
+    unsigned char id[SHARED_CACHE_IDBYTES];
+    shared_cache_id(shared.get(), id, pk, crypto_box_PUBLICKEYBYTES, sk, crypto_box_SECRETKEYBYTES);
+    if( shared_cache_get(shared.get(), id, k) ) {
+        return 0;
+    }
+    if( crypto_box_beforenm(k, pk, sk) != 0 ) {
+        return -1;
+    }
+    shared_cache_put(shared.get(), id, k);
+    return 0;
+}
+
+int box_cache_lookup(unsigned char* k, const unsigned char* pk, const unsigned char* sk) {
+    std::unique_lock<std::mutex> lock(box_cache_mutex);
+
+    if( box_cache_keys == NULL ) {
+        if( !std::atomic_load(&box_cache_shared) ) {
+            return BOX_CACHE_DISABLED;
+        }
+        lock.unlock();
+        return box_cache_beforenm(k, pk, sk);
+    }
+
+    std::string id = box_cache_id(pk, sk);
+    BoxCacheClock::time_point now = BoxCacheClock::now();
+
+    auto found = box_cache_index.find(id);
+    if( found != box_cache_index.end() ) {
+        auto it = found->second;
+        if( box_cache_ttl.count() == 0 || now < it->expires ) {
+            box_cache_lru.splice(box_cache_lru.begin(), box_cache_lru, it);
+            memcpy(k, box_cache_slot(it->slot), crypto_box_BEFORENMBYTES);
+            box_cache_hits++;
+            return 0;
+        }
+        box_cache_erase(it);
+        box_cache_expirations++;
+    }
+    box_cache_misses++;
+
+    // Do the scalar multiplication without holding the lock
+    lock.unlock();
+    if( box_cache_beforenm(k, pk, sk) != 0 ) {
+        return -1;
+    }
+    lock.lock();
+
+    // The cache may have been disabled, or filled by another thread, meanwhile
+    if( box_cache_keys == NULL || box_cache_index.count(id) != 0 ) {
+        return 0;
+    }
+
+    if( box_cache_free.empty() ) {
+        box_cache_erase(std::prev(box_cache_lru.end()));
+        box_cache_evictions++;
+    }
+    size_t slot = box_cache_free.back();
+    box_cache_free.pop_back();
+    memcpy(box_cache_slot(slot), k, crypto_box_BEFORENMBYTES);
+
+    box_cache_lru.push_front(BoxCacheEntry{ id, slot, now + box_cache_ttl });
+    box_cache_index[id] = box_cache_lru.begin();
+    return 0;
+}
+
+/**
+ * crypto_box_cache_enable:
+ * Turn the shared key cache on, or resize it
+ *
+ *     sodium.crypto_box_cache_enable(capacity, [ttl]);
+ *
+ * ~ capacity (Number): maximum number of cached key pairs. 0 disables the cache
+ * ~ ttl (Number): optional, drop entries this many milliseconds after they
+ *   were computed. 0, the default, keeps them until evicted
+ *
+ * Enabling an enabled cache clears it. Counters are reset.
+ */
+NAPI_METHOD(crypto_box_cache_enable) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument capacity must be a number");
+    ARG_TO_NUMBER(capacity);
+    size_t ttl = 0;
+    if( info.Length() > 1 && !info[1].IsUndefined() ) {
+        ARG_TO_NUMBER(ttl_ms);
+        ttl = ttl_ms;
+    }
+
+    std::lock_guard<std::mutex> lock(box_cache_mutex);
+    box_cache_reset();
+    box_cache_hits = box_cache_misses = box_cache_evictions = box_cache_expirations = 0;
+
+    if( capacity == 0 ) {
+        return env.Undefined();
+    }
+
+    box_cache_keys = (unsigned char*) sodium_malloc(capacity * crypto_box_BEFORENMBYTES);
+    if( box_cache_keys == NULL ) {
+        THROW_ERROR("cannot allocate secure memory for the box key cache");
+    }
+    randombytes_buf(box_cache_id_key, sizeof box_cache_id_key);
+
+    box_cache_capacity = capacity;
+    box_cache_ttl = std::chrono::milliseconds(ttl);
+    box_cache_free.reserve(capacity);
+    for(size_t i = capacity; i > 0; i--) {
+        box_cache_free.push_back(i - 1);
+    }
+    box_cache_index.reserve(capacity);
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_box_cache_disable:
+ * Turn the shared key cache off and wipe every cached key
+ */
+NAPI_METHOD(crypto_box_cache_disable) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(box_cache_mutex);
+    box_cache_reset();
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_box_cache_clear:
+ * Wipe every cached key, keeping the cache enabled
+ */
+NAPI_METHOD(crypto_box_cache_clear) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(box_cache_mutex);
+    while( !box_cache_lru.empty() ) {
+        box_cache_erase(box_cache_lru.begin());
+    }
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_box_cache_stats:
+ * Cache counters
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ enabled, capacity, size, hits, misses, evictions, expirations,
+ *   shared }`. `shared` is null, or the stats of the attached segment:
+ *   `{ name, capacity, size, locked, hits, misses, inserts, evictions }`
+ */
+NAPI_METHOD(crypto_box_cache_stats) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(box_cache_mutex);
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "enabled"), Napi::Boolean::New(env, box_cache_keys != NULL));
+    result.Set(Napi::String::New(env, "capacity"), Napi::Number::New(env, (double) box_cache_capacity));
+    result.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double) box_cache_lru.size()));
+    result.Set(Napi::String::New(env, "hits"), Napi::Number::New(env, box_cache_hits));
+    result.Set(Napi::String::New(env, "misses"), Napi::Number::New(env, box_cache_misses));
+    result.Set(Napi::String::New(env, "evictions"), Napi::Number::New(env, box_cache_evictions));
+    result.Set(Napi::String::New(env, "expirations"), Napi::Number::New(env, box_cache_expirations));
+    std::shared_ptr<SharedCache> shared = std::atomic_load(&box_cache_shared);
+    result.Set(Napi::String::New(env, "shared"), shared ? shared_cache_stats(env, shared.get()) : NAPI_NULL);
+    return result;
+}
+
+/**
+ * crypto_box_cache_share:
+ * Attach a shared memory segment to the shared key cache
+ *
+ *     sodium.crypto_box_cache_share(name, capacity);
+ *
+ * ~ name (String): the segment, the same in every process that should share
+ *   keys. null detaches the current one
+ * ~ capacity (Number): keys the segment holds, when this process creates it.
+ *   A process that finds it already created takes its size
+ *
+ * Works with or without crypto_box_cache_enable. The segment is readable and
+ * writable by the user running the process only. Not supported on Windows.
+ */
+NAPI_METHOD(crypto_box_cache_share) {
+    Napi::Env env = info.Env();
+
+    if( info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined() ) {
+        std::atomic_store(&box_cache_shared, std::shared_ptr<SharedCache>());
+        return env.Undefined();
+    }
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument name must be a string or null");
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    ARGS(2, "argument capacity must be a number");
+    _arg = 1;
+    ARG_TO_NUMBER(capacity);
+
+    std::string error;
+    SharedCache* cache = shared_cache_open(name.c_str(), crypto_box_BEFORENMBYTES, capacity,
+                                           box_cache_shared_format, error);
+    if( cache == NULL ) {
+        THROW_ERROR(error.c_str());
+    }
+    std::atomic_store(&box_cache_shared, std::shared_ptr<SharedCache>(cache, shared_cache_close));
+
+    return env.Undefined();
+}
+
+// Snapshot records: id | shared key | milliseconds left to live, 0 if none
+#define BOX_CACHE_RECORD_BYTES (crypto_generichash_BYTES + crypto_box_BEFORENMBYTES + 8)
+#define BOX_CACHE_SNAPSHOT_KIND "box.beforenm"
+
+/**
+ * crypto_box_cache_save:
+ * Seal the cached shared keys into a snapshot file
+ *
+ *     sodium.crypto_box_cache_save(path, snapshotKey);
+ *
+ * ~ path (String): file to write, replaced as a whole
+ * ~ snapshotKey (Buffer): `crypto_aead_xchacha20poly1305_ietf_KEYBYTES` long
+ *
+ * The file holds the digest key of the index and every live entry, most
+ * recently used first, with the time it has left to live; no secret key of
+ * a key pair is written.
+ *
+ * **Returns**:
+ *
+ * ~ the number of entries written. Throws if the cache is disabled
+ */
+NAPI_METHOD(crypto_box_cache_save) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments path and snapshot key are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument path must be a string");
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    _arg++;
+    ARG_TO_UCHAR_BUFFER_LEN(snapshotKey, SNAPSHOT_KEYBYTES);
+
+    std::unique_lock<std::mutex> lock(box_cache_mutex);
+    if( box_cache_keys == NULL ) {
+        THROW_ERROR("the box key cache is disabled");
+    }
+
+    size_t body_size = sizeof box_cache_id_key + box_cache_lru.size() * BOX_CACHE_RECORD_BYTES;
+    unsigned char* body = (unsigned char*) sodium_secret_alloc(env, body_size);
+    if( body == NULL ) {
+        THROW_ERROR("cannot allocate secure memory for the snapshot");
+    }
+    memcpy(body, box_cache_id_key, sizeof box_cache_id_key);
+
+    BoxCacheClock::time_point now = BoxCacheClock::now();
+    unsigned char* record = body + sizeof box_cache_id_key;
+    size_t count = 0;
+    for(auto& entry : box_cache_lru) {
+        uint64_t left = 0;
+        if( box_cache_ttl.count() != 0 ) {
+            if( now >= entry.expires ) {
+                continue;
+            }
+            left = std::chrono::duration_cast<std::chrono::milliseconds>(entry.expires - now).count() + 1;
+        }
+        memcpy(record, entry.id.data(), crypto_generichash_BYTES);
+        memcpy(record + crypto_generichash_BYTES, box_cache_slot(entry.slot), crypto_box_BEFORENMBYTES);
+        memcpy(record + crypto_generichash_BYTES + crypto_box_BEFORENMBYTES, &left, sizeof left);
+        record += BOX_CACHE_RECORD_BYTES;
+        count++;
+    }
+    lock.unlock();
+
+    std::string error = sodium_snapshot_save(path, BOX_CACHE_SNAPSHOT_KIND, body, sizeof box_cache_id_key,
+                                             BOX_CACHE_RECORD_BYTES, count, snapshotKey);
+    sodium_secret_free(env, body, body_size);
+    if( !error.empty() ) {
+        THROW_ERROR(error);
+    }
+    return Napi::Number::New(env, (double) count);
+}
+
+/**
+ * crypto_box_cache_load:
+ * Replace the cached shared keys with those of a snapshot file
+ *
+ *     sodium.crypto_box_cache_load(path, snapshotKey);
+ *
+ * The cache must be enabled. Entries past its capacity are left out, the
+ * least recently used first, and entries keep what was left of their time
+ * to live, at most the current ttl. Counters are kept.
+ *
+ * **Returns**:
+ *
+ * ~ the number of entries loaded. Throws, leaving the cache as it was, if
+ *   the file does not verify
+ */
+NAPI_METHOD(crypto_box_cache_load) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments path and snapshot key are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument path must be a string");
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    _arg++;
+    ARG_TO_UCHAR_BUFFER_LEN(snapshotKey, SNAPSHOT_KEYBYTES);
+
+    SodiumSnapshot snapshot;
+    std::string error = sodium_snapshot_load(env, path, BOX_CACHE_SNAPSHOT_KIND, sizeof box_cache_id_key,
+                                             snapshotKey, snapshot);
+    if( !error.empty() ) {
+        THROW_ERROR(error);
+    }
+    if( snapshot.count > 0 && snapshot.record_size != BOX_CACHE_RECORD_BYTES ) {
+        sodium_snapshot_release(env, snapshot);
+        THROW_ERROR(path + ": the snapshot layout is invalid");
+    }
+
+    std::lock_guard<std::mutex> lock(box_cache_mutex);
+    if( box_cache_keys == NULL ) {
+        sodium_snapshot_release(env, snapshot);
+        THROW_ERROR("the box key cache is disabled");
+    }
+    while( !box_cache_lru.empty() ) {
+        box_cache_erase(box_cache_lru.begin());
+    }
+    memcpy(box_cache_id_key, snapshot.body, sizeof box_cache_id_key);
+
+    BoxCacheClock::time_point now = BoxCacheClock::now();
+    const unsigned char* record = snapshot.body + sizeof box_cache_id_key;
+    size_t count = 0;
+    for(uint64_t i = 0; i < snapshot.count && !box_cache_free.empty(); i++, record += BOX_CACHE_RECORD_BYTES) {
+        std::string id((const char*) record, crypto_generichash_BYTES);
+        if( box_cache_index.count(id) != 0 ) {
+            continue;
+        }
+        uint64_t left;
+        memcpy(&left, record + crypto_generichash_BYTES + crypto_box_BEFORENMBYTES, sizeof left);
+        BoxCacheClock::duration ttl = box_cache_ttl;
+        if( left != 0 && ttl.count() != 0 && std::chrono::milliseconds(left) < ttl ) {
+            ttl = std::chrono::milliseconds(left);
+        }
+
+        size_t slot = box_cache_free.back();
+        box_cache_free.pop_back();
+        memcpy(box_cache_slot(slot), record + crypto_generichash_BYTES, crypto_box_BEFORENMBYTES);
+        box_cache_lru.push_back(BoxCacheEntry{ id, slot, now + ttl });
+        box_cache_index[id] = std::prev(box_cache_lru.end());
+        count++;
+    }
+    sodium_snapshot_release(env, snapshot);
+    return Napi::Number::New(env, (double) count);
+}
+
+// See sodium_memory_usage
+size_t crypto_box_cache_memory() {
+    std::lock_guard<std::mutex> lock(box_cache_mutex);
+    if( box_cache_keys == NULL ) {
+        return 0;
+    }
+    return sodium_secure_footprint(box_cache_capacity * crypto_box_BEFORENMBYTES) +
+           sodium_lru_memory(box_cache_lru, box_cache_index, crypto_generichash_BYTES) +
+           box_cache_free.capacity() * sizeof(size_t);
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_box_cache(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_box_cache_enable);
+    EXPORT(crypto_box_cache_disable);
+    EXPORT(crypto_box_cache_clear);
+    EXPORT(crypto_box_cache_stats);
+    EXPORT(crypto_box_cache_share);
+    EXPORT(crypto_box_cache_save);
+    EXPORT(crypto_box_cache_load);
+}
@@ -0,0 +1,448 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+
+/**
+ * crypto_box_curve25519xchacha20poly1305 is crypto_box with XChaCha20 in
+ * place of XSalsa20: the X25519 shared secret goes through HChaCha20, and the
+ * message is sealed with crypto_secretbox_xchacha20poly1305. The API follows
+ * the crypto_box `_easy`, `_detached`, `_afternm` and `_seal` functions.
+ *
+ * As in crypto_secretbox_xchacha20poly1305.cc, the `_into` variants write to
+ * `out` at `offset` and return the number of bytes written, or null when a
+ * cipher text does not verify. The output may overlap the input.
+ */
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_keypair) {
+    Napi::Env env = info.Env();
+
+    NEW_BUFFER_AND_PTR(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    NEW_BUFFER_AND_PTR(sk, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_keypair(pk_ptr, sk_ptr) == 0) {
+        Napi::Object result = Napi::Object::New(env);
+
+        result.Set(Napi::String::New(env, "publicKey"), pk);
+        result.Set(Napi::String::New(env, "secretKey"), sk);
+
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_seed_keypair) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument seed must be a buffer");
+    ARG_TO_UCHAR_BUFFER_LEN(seed, crypto_box_curve25519xchacha20poly1305_SEEDBYTES);
+
+    NEW_BUFFER_AND_PTR(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    NEW_BUFFER_AND_PTR(sk, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_seed_keypair(pk_ptr, sk_ptr, seed) == 0) {
+        Napi::Object result = Napi::Object::New(env);
+
+        result.Set(Napi::String::New(env, "publicKey"), pk);
+        result.Set(Napi::String::New(env, "secretKey"), sk);
+
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+/*
+int crypto_box_curve25519xchacha20poly1305_beforenm(unsigned char *k,
+                                                    const unsigned char *pk,
+                                                    const unsigned char *sk);
+*/
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_beforenm) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments publicKey, and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(k, crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_beforenm(k_ptr, publicKey, secretKey) == 0) {
+        return k;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_easy) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments message, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_easy(ctxt_ptr, message, message_size, nonce, publicKey, secretKey) == 0) {
+        return ctxt;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_open_easy) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments cipherText, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(cipherText);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    if (cipherText_size < crypto_box_curve25519xchacha20poly1305_MACBYTES) {
+        THROW_ERROR("argument cipherText must have a length of at least crypto_box_curve25519xchacha20poly1305_MACBYTES bytes");
+    }
+
+    NEW_BUFFER_AND_PTR(msg, cipherText_size - crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_open_easy(msg_ptr, cipherText, cipherText_size, nonce, publicKey, secretKey) == 0) {
+        return msg;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_detached) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments message, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size);
+    NEW_BUFFER_AND_PTR(mac, crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_detached(c_ptr, mac_ptr, message, message_size, nonce, pk, sk) == 0) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "cipherText"), c);
+        result.Set(Napi::String::New(env, "mac"), mac);
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_open_detached) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments encrypted message, mac, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
+    ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_box_curve25519xchacha20poly1305_MACBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(m, c_size);
+
+    if (crypto_box_curve25519xchacha20poly1305_open_detached(m_ptr, c, mac, c_size, nonce, pk, sk) == 0) {
+        return m;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_easy_afternm) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, nonce and k must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_easy_afternm(ctxt_ptr, message, message_size, nonce, k) == 0) {
+        return ctxt;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_open_easy_afternm) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments cipherText, nonce and k must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(ctxt);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+
+    if (ctxt_size < crypto_box_curve25519xchacha20poly1305_MACBYTES) {
+        THROW_ERROR("argument cipherText must have a length of at least crypto_box_curve25519xchacha20poly1305_MACBYTES bytes");
+    }
+
+    NEW_BUFFER_AND_PTR(message, ctxt_size - crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_open_easy_afternm(message_ptr, ctxt, ctxt_size, nonce, k) == 0) {
+        return message;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_detached_afternm) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, nonce and k must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size);
+    NEW_BUFFER_AND_PTR(mac, crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_detached_afternm(c_ptr, mac_ptr, message, message_size, nonce, k) == 0) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "cipherText"), c);
+        result.Set(Napi::String::New(env, "mac"), mac);
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_open_detached_afternm) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments cipherText, mac, nonce and k must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(ctxt);
+    ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_box_curve25519xchacha20poly1305_MACBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+
+    NEW_BUFFER_AND_PTR(message, ctxt_size);
+
+    if (crypto_box_curve25519xchacha20poly1305_open_detached_afternm(message_ptr, ctxt, mac, ctxt_size, nonce, k) == 0) {
+        return message;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_seal) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments unencrypted message, and recipient public key must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size + crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_seal(c_ptr, message, message_size, pk) == 0) {
+        return c;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_seal_open) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments encrypted message, recipient public key, and recipient secret key must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    if (c_size < crypto_box_curve25519xchacha20poly1305_SEALBYTES) {
+        return NAPI_NULL;
+    }
+
+    NEW_BUFFER_AND_PTR(m, c_size - crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_seal_open(m_ptr, c, c_size, pk, sk) == 0) {
+        return m;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_easy_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments output buffer, offset, message, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+    CHECK_OUTPUT_SPACE(out, offset, message_size + crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_easy(out + offset, message, message_size, nonce, publicKey, secretKey) == 0) {
+        return Napi::Number::New(env, message_size + crypto_box_curve25519xchacha20poly1305_MACBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_open_easy_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments output buffer, offset, cipherText, nonce, publicKey and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(cipherText);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    if (cipherText_size < crypto_box_curve25519xchacha20poly1305_MACBYTES) {
+        THROW_ERROR("argument cipherText must have a length of at least crypto_box_curve25519xchacha20poly1305_MACBYTES bytes");
+    }
+    CHECK_OUTPUT_SPACE(out, offset, cipherText_size - crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_open_easy(out + offset, cipherText, cipherText_size, nonce, publicKey, secretKey) == 0) {
+        return Napi::Number::New(env, cipherText_size - crypto_box_curve25519xchacha20poly1305_MACBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_easy_afternm_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments output buffer, offset, message, nonce and k must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+    CHECK_OUTPUT_SPACE(out, offset, message_size + crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_easy_afternm(out + offset, message, message_size, nonce, k) == 0) {
+        return Napi::Number::New(env, message_size + crypto_box_curve25519xchacha20poly1305_MACBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_open_easy_afternm_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments output buffer, offset, cipherText, nonce and k must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(ctxt);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+
+    if (ctxt_size < crypto_box_curve25519xchacha20poly1305_MACBYTES) {
+        THROW_ERROR("argument cipherText must have a length of at least crypto_box_curve25519xchacha20poly1305_MACBYTES bytes");
+    }
+    CHECK_OUTPUT_SPACE(out, offset, ctxt_size - crypto_box_curve25519xchacha20poly1305_MACBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_open_easy_afternm(out + offset, ctxt, ctxt_size, nonce, k) == 0) {
+        return Napi::Number::New(env, ctxt_size - crypto_box_curve25519xchacha20poly1305_MACBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_seal_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments output buffer, offset, unencrypted message, and recipient public key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    CHECK_OUTPUT_SPACE(out, offset, message_size + crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_seal(out + offset, message, message_size, pk) == 0) {
+        return Napi::Number::New(env, message_size + crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_box_curve25519xchacha20poly1305_seal_open_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments output buffer, offset, encrypted message, recipient public key, and recipient secret key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+
+    if (c_size < crypto_box_curve25519xchacha20poly1305_SEALBYTES) {
+        return NAPI_NULL;
+    }
+    CHECK_OUTPUT_SPACE(out, offset, c_size - crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+
+    if (crypto_box_curve25519xchacha20poly1305_seal_open(out + offset, c, c_size, pk, sk) == 0) {
+        return Napi::Number::New(env, c_size - crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_seedbytes)
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_publickeybytes)
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_secretkeybytes)
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_beforenmbytes)
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_noncebytes)
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_macbytes)
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_sealbytes)
+NAPI_METHOD_FROM_INT(crypto_box_curve25519xchacha20poly1305_messagebytes_max)
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_box_curve25519xchacha20poly1305(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_box_curve25519xchacha20poly1305_keypair);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_seed_keypair);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_beforenm);
+
+    EXPORT(crypto_box_curve25519xchacha20poly1305_easy);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_open_easy);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_detached);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_open_detached);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_easy_afternm);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_open_easy_afternm);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_detached_afternm);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_open_detached_afternm);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_seal);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_seal_open);
+
+    EXPORT(crypto_box_curve25519xchacha20poly1305_easy_into);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_open_easy_into);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_easy_afternm_into);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_open_easy_afternm_into);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_seal_into);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_seal_open_into);
+
+    EXPORT_INT(crypto_box_curve25519xchacha20poly1305_SEEDBYTES);
+    EXPORT_INT(crypto_box_curve25519xchacha20poly1305_PUBLICKEYBYTES);
+    EXPORT_INT(crypto_box_curve25519xchacha20poly1305_SECRETKEYBYTES);
+    EXPORT_INT(crypto_box_curve25519xchacha20poly1305_BEFORENMBYTES);
+    EXPORT_INT(crypto_box_curve25519xchacha20poly1305_NONCEBYTES);
+    EXPORT_INT(crypto_box_curve25519xchacha20poly1305_MACBYTES);
+    EXPORT_INT(crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+
+    EXPORT(crypto_box_curve25519xchacha20poly1305_seedbytes);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_publickeybytes);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_secretkeybytes);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_beforenmbytes);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_noncebytes);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_macbytes);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_sealbytes);
+    EXPORT(crypto_box_curve25519xchacha20poly1305_messagebytes_max);
+}
@@ -16,25 +16,17 @@ NAPI_METHOD(crypto_box_curve25519xsalsa20poly1305) {
     ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_curve25519xsalsa20poly1305_PUBLICKEYBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_curve25519xsalsa20poly1305_SECRETKEYBYTES);
 
-    NEW_BUFFER_AND_PTR(msg, message_size + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
+    // crypto_box_detached is this same construction; see crypto_box.cc
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
+    memset(ctxt_ptr, 0, crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES);
 
-    // Fill the first crypto_box_curve25519xsalsa20poly1305_ZEROBYTES with 0
-    unsigned int i;
-    for(i = 0; i < crypto_box_curve25519xsalsa20poly1305_ZEROBYTES; i++) {
-       msg_ptr[i] = 0U;
-    }
-
-    //Copy the message to the new buffer
-    memcpy((void*) (msg_ptr + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES), (void *) message, message_size);
-    message_size += crypto_box_curve25519xsalsa20poly1305_ZEROBYTES;
-
-    NEW_BUFFER_AND_PTR(ctxt, message_size);
-
-    if (crypto_box_curve25519xsalsa20poly1305(ctxt_ptr, msg_ptr, message_size, nonce, publicKey, secretKey) == 0) {
+    if (crypto_box_detached(ctxt_ptr + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES,
+            ctxt_ptr + crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES,
+            message, message_size, nonce, publicKey, secretKey) == 0) {
         return ctxt;
-    } else {
-        return NAPI_NULL;
     }
+
+    return NAPI_NULL;
 }
 
 NAPI_METHOD(crypto_box_curve25519xsalsa20poly1305_keypair) {
@@ -79,18 +71,19 @@ NAPI_METHOD(crypto_box_curve25519xsalsa20poly1305_open) {
         THROW_ERROR("the first crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES bytes of argument cipherText must be 0");
     }
 
-    NEW_BUFFER_AND_PTR(msg, cipherText_size);
-
-    if (crypto_box_curve25519xsalsa20poly1305_open(msg_ptr, cipherText, cipherText_size, nonce, publicKey, secretKey) == 0) {
+    if (cipherText_size < crypto_box_curve25519xsalsa20poly1305_ZEROBYTES) {
+        return NAPI_NULL;
+    }
 
-        // Remove the padding at the beginning of the message
-        NEW_BUFFER_AND_PTR(plain_text, cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
-        memcpy(plain_text_ptr,(void*) (msg_ptr + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES), cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
+    NEW_BUFFER_AND_PTR(plain_text, cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
 
+    if (crypto_box_open_detached(plain_text_ptr, cipherText + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES,
+            cipherText + crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES,
+            cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES, nonce, publicKey, secretKey) == 0) {
         return plain_text;
-    } else {
-        return NAPI_NULL;
     }
+
+    return NAPI_NULL;
 }
 
 NAPI_METHOD(crypto_box_curve25519xsalsa20poly1305_beforenm) {
@@ -118,25 +111,17 @@ NAPI_METHOD(crypto_box_curve25519xsalsa20poly1305_afternm) {
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_curve25519xsalsa20poly1305_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(k, crypto_box_curve25519xsalsa20poly1305_BEFORENMBYTES);
 
-    // Pad the message with crypto_box_curve25519xsalsa20poly1305_ZEROBYTES zeros
-    NEW_BUFFER_AND_PTR(msg, message_size + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
+    // crypto_box_detached is this same construction; see crypto_box.cc
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
+    memset(ctxt_ptr, 0, crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES);
 
-    unsigned int i;
-    for(i = 0; i < crypto_box_curve25519xsalsa20poly1305_ZEROBYTES; i++) {
-       msg_ptr[i] = 0U;
-    }
-
-    //Copy the message to the new buffer
-    memcpy((void*) (msg_ptr + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES), (void *) message, message_size);
-    message_size += crypto_box_curve25519xsalsa20poly1305_ZEROBYTES;
-
-    NEW_BUFFER_AND_PTR(ctxt, message_size);
-
-    if (crypto_box_curve25519xsalsa20poly1305_afternm(ctxt_ptr, msg_ptr, message_size, nonce, k) == 0) {
+    if (crypto_box_detached_afternm(ctxt_ptr + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES,
+            ctxt_ptr + crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES,
+            message, message_size, nonce, k) == 0) {
         return ctxt;
-    } else {
-        return NAPI_NULL;
     }
+
+    return NAPI_NULL;
 }
 
 NAPI_METHOD(crypto_box_curve25519xsalsa20poly1305_open_afternm) {
@@ -161,18 +146,19 @@ NAPI_METHOD(crypto_box_curve25519xsalsa20poly1305_open_afternm) {
         THROW_ERROR("the first crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES bytes of argument cipherText must be 0");
     }
 
-    NEW_BUFFER_AND_PTR(msg, cipherText_size);
-
-    if (crypto_box_curve25519xsalsa20poly1305_open_afternm(msg_ptr, cipherText, cipherText_size, nonce, k) == 0) {
+    if (cipherText_size < crypto_box_curve25519xsalsa20poly1305_ZEROBYTES) {
+        return NAPI_NULL;
+    }
 
-        // Remove the padding at the beginning of the message
-        NEW_BUFFER_AND_PTR(plain_text,cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
-        memcpy(plain_text_ptr,(void*) (msg_ptr + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES), cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
+    NEW_BUFFER_AND_PTR(plain_text, cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES);
 
+    if (crypto_box_open_detached_afternm(plain_text_ptr, cipherText + crypto_box_curve25519xsalsa20poly1305_ZEROBYTES,
+            cipherText + crypto_box_curve25519xsalsa20poly1305_BOXZEROBYTES,
+            cipherText_size - crypto_box_curve25519xsalsa20poly1305_ZEROBYTES, nonce, k) == 0) {
         return plain_text;
-    } else {
-        return NAPI_NULL;
     }
+
+    return NAPI_NULL;
 }
 
 NAPI_METHOD_FROM_INT(crypto_box_curve25519xsalsa20poly1305_noncebytes)
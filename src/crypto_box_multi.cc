@@ -0,0 +1,264 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "crypto_keypair_pool.h"
+#include "sodium_stats.h"
+
+/**
+ * Multi-recipient public key encryption.
+ *
+ * The message is encrypted once, with `crypto_aead_xchacha20poly1305_ietf`
+ * under a random key and nonce, and only that key is sealed to each
+ * recipient with `crypto_box_seal`, taking ephemeral key pairs from the
+ * key pair pool when it is on. The cost grows with the message plus
+ * `crypto_box_multi_WRAPBYTES` per recipient, not with the message times
+ * the recipients:
+ *
+ *     count (4 bytes, big endian)
+ *     count wrapped keys, crypto_box_seal of the key, in recipient order
+ *     nonce (24) | cipher text and tag
+ *
+ * The header and wrapped keys are the additional data of the cipher text,
+ * so the recipient list cannot be changed without the message failing to
+ * open. As with any shared key scheme, every recipient can read the key
+ * and make other messages for the same recipients: sign the envelope when
+ * recipients must know who sent it.
+ */
+#define crypto_box_multi_HEADERBYTES 4
+#define crypto_box_multi_WRAPBYTES (crypto_box_SEALBYTES + crypto_aead_xchacha20poly1305_ietf_KEYBYTES)
+#define crypto_box_multi_ABYTES \
+    (crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES)
+
+static size_t box_multi_size(size_t count, size_t mlen) {
+    return crypto_box_multi_HEADERBYTES + count * crypto_box_multi_WRAPBYTES + crypto_box_multi_ABYTES + mlen;
+}
+
+/**
+ * Write the envelope of `m` for the public keys `pks` to `out`, which has
+ * box_multi_size() bytes. The key is sealed to the recipients on up to
+ * `threads` threads. Returns 0, or -1 if a public key was rejected
+ */
+static int box_multi_seal(unsigned char* out, const unsigned char* m, size_t mlen,
+                          const std::vector<const unsigned char*>& pks, size_t threads) {
+    size_t count = pks.size();
+    out[0] = (unsigned char) (count >> 24);
+    out[1] = (unsigned char) (count >> 16);
+    out[2] = (unsigned char) (count >> 8);
+    out[3] = (unsigned char) count;
+
+    unsigned char key[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+    crypto_aead_xchacha20poly1305_ietf_keygen(key);
+
+    unsigned char* wraps = out + crypto_box_multi_HEADERBYTES;
+    std::atomic<bool> failed(false);
+    sodium_batch_parallel(count, threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            if( keypair_pool_box_seal(wraps + i * crypto_box_multi_WRAPBYTES, key, sizeof key, pks[i]) != 0 ) {
+                failed = true;
+            }
+        }
+    });
+
+    size_t header = crypto_box_multi_HEADERBYTES + count * crypto_box_multi_WRAPBYTES;
+    unsigned char* npub = out + header;
+    randombytes_buf(npub, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+    int rc = failed ? -1 : SODIUM_STAT(box, mlen, box_multi_size(count, mlen),
+        crypto_aead_xchacha20poly1305_ietf_encrypt(npub + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, NULL,
+            m, mlen, out, header, NULL, npub, key));
+    sodium_memzero(key, sizeof key);
+    return rc;
+}
+
+/**
+ * crypto_box_multi_seal(message, publicKeys, [threads])
+ *
+ * Encrypt `message` once for every recipient of `publicKeys`.
+ *
+ * Parameters:
+ *  [in] message      the message to encrypt
+ *  [in] publicKeys   array of `crypto_box_PUBLICKEYBYTES` public keys, or one
+ *                    Buffer of them back to back
+ *  [in] threads      seal the key to large recipient lists on up to this
+ *                    many threads, the call still blocks
+ *
+ * Returns the envelope, `crypto_box_multi_HEADERBYTES +
+ * recipients * crypto_box_multi_WRAPBYTES + crypto_box_multi_ABYTES`
+ * bytes longer than `message`, or null if a public key is rejected
+ */
+NAPI_METHOD(crypto_box_multi_seal) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments message and public keys are required");
+    ARG_TO_UCHAR_BUFFER_RANGE(m);
+    size_t count = SODIUM_BATCH_ANY;
+    unsigned char* packed = NULL;
+    size_t packed_size = 0;
+    if( !info[_arg].IsArray() && sodium_arg_bytes(info[_arg], packed, packed_size) ) {
+        count = packed_size / crypto_box_PUBLICKEYBYTES;
+    }
+    ARG_TO_BATCH_LEN(pk, count, crypto_box_PUBLICKEYBYTES);
+    if( count > UINT32_MAX ) {
+        THROW_ERROR("too many recipients");
+    }
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && !info[_arg].IsUndefined() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    std::vector<const unsigned char*> pks(count);
+    for(size_t i = 0; i < count; i++) {
+        pks[i] = pk[i].data;
+    }
+
+    NEW_BUFFER_AND_PTR(envelope, box_multi_size(count, m_size));
+    if( box_multi_seal(envelope_ptr, m, m_size, pks, threads) == 0 ) {
+        return envelope;
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_box_multi_seal_async(message, publicKeys, [options], [callback])
+ *
+ * `crypto_box_multi_seal` on the threadpool. `options.threads` seals the
+ * key on up to that many threads; the cancel and priority options of the
+ * other async functions apply too.
+ */
+NAPI_METHOD(crypto_box_multi_seal_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments message and public keys are required");
+    ARG_TO_UCHAR_BUFFER_RANGE(m);
+    size_t count = SODIUM_BATCH_ANY;
+    unsigned char* packed = NULL;
+    size_t packed_size = 0;
+    if( !info[_arg].IsArray() && sodium_arg_bytes(info[_arg], packed, packed_size) ) {
+        count = packed_size / crypto_box_PUBLICKEYBYTES;
+    }
+    ARG_TO_BATCH_LEN(pk, count, crypto_box_PUBLICKEYBYTES);
+    if( count > UINT32_MAX ) {
+        THROW_ERROR("too many recipients");
+    }
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && sodium_async_is_options(info[_arg]) ) {
+        Napi::Value value = info[_arg].As<Napi::Object>().Get("threads");
+        if( !value.IsUndefined() ) {
+            if( !value.IsNumber() || !(value.As<Napi::Number>().DoubleValue() >= 1) ) {
+                THROW_ERROR("option threads must be a positive number");
+            }
+            threads = (size_t) value.As<Napi::Number>().DoubleValue();
+        }
+    }
+
+    NEW_BUFFER_AND_PTR(envelope, box_multi_size(count, m_size));
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_multi_seal");
+    worker->Pin(envelope);
+    unsigned char* out = envelope_ptr;
+    const unsigned char* message = worker->Copy(m, m_size);
+    size_t mlen = m_size;
+
+    // Recipients copied back to back, then pointed into
+    std::vector<unsigned char> keys(count * crypto_box_PUBLICKEYBYTES);
+    for(size_t i = 0; i < count; i++) {
+        memcpy(keys.data() + i * crypto_box_PUBLICKEYBYTES, pk[i].data, crypto_box_PUBLICKEYBYTES);
+    }
+    const unsigned char* copied = worker->Copy(keys.data(), keys.size());
+    std::vector<const unsigned char*> pks(count);
+    for(size_t i = 0; i < count; i++) {
+        pks[i] = copied + i * crypto_box_PUBLICKEYBYTES;
+    }
+
+    return worker->Start([=]() {
+        return box_multi_seal(out, message, mlen, pks, threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_box_multi_open(envelope, publicKey, secretKey, [index])
+ *
+ * Open an envelope of `crypto_box_multi_seal` with the recipient's key pair.
+ * `index` is the position of the recipient in the list the envelope was
+ * made for. Without it each wrapped key is tried in turn, one
+ * `crypto_box_seal_open` each.
+ *
+ * Returns the message, or null if the envelope is not for this key pair or
+ * does not verify
+ */
+NAPI_METHOD(crypto_box_multi_open) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments envelope, public key, and secret key are required");
+    ARG_TO_UCHAR_BUFFER_RANGE(envelope);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+
+    if( envelope_size < crypto_box_multi_HEADERBYTES ) {
+        THROW_ERROR("argument envelope is too short");
+    }
+    size_t count = ((size_t) envelope[0] << 24) | ((size_t) envelope[1] << 16) |
+                   ((size_t) envelope[2] << 8) | (size_t) envelope[3];
+    if( envelope_size < box_multi_size(count, 0) ) {
+        THROW_ERROR("argument envelope is too short");
+    }
+
+    size_t first = 0, last = count;
+    if( info.Length() > (size_t) _arg && !info[_arg].IsUndefined() ) {
+        ARG_TO_NUMBER(index);
+        if( index >= count ) {
+            THROW_ERROR("argument index is past the last recipient");
+        }
+        first = index;
+        last = index + 1;
+    }
+
+    const unsigned char* wraps = envelope + crypto_box_multi_HEADERBYTES;
+    unsigned char key[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+    bool found = false;
+    for(size_t i = first; i < last && !found; i++) {
+        found = crypto_box_seal_open(key, wraps + i * crypto_box_multi_WRAPBYTES,
+                                     crypto_box_multi_WRAPBYTES, pk, sk) == 0;
+    }
+    if( !found ) {
+        return NAPI_NULL;
+    }
+
+    size_t header = crypto_box_multi_HEADERBYTES + count * crypto_box_multi_WRAPBYTES;
+    const unsigned char* npub = envelope + header;
+    const unsigned char* c = npub + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+    size_t c_size = envelope_size - header - crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+
+    NEW_BUFFER_AND_PTR(m, c_size - crypto_aead_xchacha20poly1305_ietf_ABYTES);
+    int rc = SODIUM_STAT(box, envelope_size, m.Length(),
+        crypto_aead_xchacha20poly1305_ietf_decrypt(m_ptr, NULL, NULL, c, c_size,
+            envelope, header, npub, key));
+    sodium_memzero(key, sizeof key);
+    if( rc != 0 ) {
+        return NAPI_NULL;
+    }
+    return m;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_box_multi(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_box_multi_seal);
+    EXPORT(crypto_box_multi_seal_async);
+    EXPORT(crypto_box_multi_open);
+
+    EXPORT_INT(crypto_box_multi_HEADERBYTES);
+    EXPORT_INT(crypto_box_multi_WRAPBYTES);
+    EXPORT_INT(crypto_box_multi_ABYTES);
+}
@@ -0,0 +1,196 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+#include "crypto_box_cache.h"
+#include "sodium_memory.h"
+
+/**
+ * BoxSession:
+ * Public-key authenticated encryption with a precomputed shared key
+ *
+ * Runs `crypto_box_beforenm` once, when the object is built, and keeps the
+ * shared key in memory allocated with `sodium_malloc`, protected with guard
+ * pages and made read only. Every message after that costs only the
+ * symmetric `_afternm` encryption, not an X25519 scalar multiplication.
+ * With a segment attached by `crypto_box_cache_share`, a key another
+ * process already computed is taken from there.
+ *
+ *    var session = new sodium.BoxSession(publicKey, secretKey);
+ *
+ * ~ publicKey (Buffer): the peer's public key, `crypto_box_PUBLICKEYBYTES` long
+ * ~ secretKey (Buffer): our secret key, `crypto_box_SECRETKEYBYTES` long
+ *
+ * Both sides of a conversation compute the same shared key, so a session
+ * built with (bob.publicKey, alice.secretKey) decrypts messages from one
+ * built with (alice.publicKey, bob.secretKey).
+ *
+ * Methods:
+ *
+ * ~ encrypt(message, nonce): same as `crypto_box_easy_afternm`
+ * ~ decrypt(cipherText, nonce): same as `crypto_box_open_easy_afternm`.
+ *   Returns null if the cipher text is forged
+ * ~ encryptDetached(message, nonce): returns `{ cipherText, mac }`
+ * ~ decryptDetached(cipherText, mac, nonce)
+ * ~ dispose(): wipes and frees the shared key. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var session = new sodium.BoxSession(bob.publicKey, alice.secretKey);
+ *     var c = session.encrypt(message, nonce);
+ *     var m = session.decrypt(c, nonce);
+ */
+class BoxSession : public Napi::ObjectWrap<BoxSession> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "BoxSession", {
+            InstanceMethod("encrypt", &BoxSession::Encrypt),
+            InstanceMethod("decrypt", &BoxSession::Decrypt),
+            InstanceMethod("encryptDetached", &BoxSession::EncryptDetached),
+            InstanceMethod("decryptDetached", &BoxSession::DecryptDetached),
+            InstanceMethod("dispose", &BoxSession::Dispose)
+        });
+        exports.Set(Napi::String::New(env, "BoxSession"), ctor);
+    }
+
+    BoxSession(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<BoxSession>(info), k(NULL) {
+        Napi::Env env = info.Env();
+
+        unsigned char *pk = NULL, *sk = NULL;
+        size_t pk_size = 0, sk_size = 0;
+        if( info.Length() < 2 || !sodium_arg_bytes(info[0], pk, pk_size) ||
+            !sodium_arg_bytes(info[1], sk, sk_size) ) {
+            Napi::TypeError::New(env, "arguments publicKey and secretKey must be buffers").ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( pk_size != crypto_box_PUBLICKEYBYTES ) {
+            Napi::Error::New(env, "argument publicKey must be crypto_box_PUBLICKEYBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+        if( sk_size != crypto_box_SECRETKEYBYTES ) {
+            Napi::Error::New(env, "argument secretKey must be crypto_box_SECRETKEYBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+
+        k = (unsigned char*) sodium_secret_alloc(env, crypto_box_BEFORENMBYTES);
+        if( k == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the shared key").ThrowAsJavaScriptException();
+            return;
+        }
+        if( box_cache_beforenm(k, pk, sk) != 0 ) {
+            Free();
+            Napi::Error::New(env, "crypto_box_beforenm failed").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_secret_readonly(k);
+    }
+
+    ~BoxSession() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( k != NULL ) {
+            sodium_secret_free(Env(), k, crypto_box_BEFORENMBYTES);
+            k = NULL;
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( k == NULL ) { \
+        THROW_ERROR("BoxSession was disposed"); \
+    }
+
+    Napi::Value Encrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments message and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER(message);
+        ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+
+        NEW_BUFFER_AND_PTR(c, message_size + crypto_box_MACBYTES);
+        if( crypto_box_easy_afternm(c_ptr, message, message_size, nonce, k) == 0 ) {
+            return c;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value Decrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments cipherText and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER(cipherText);
+        ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+
+        if( cipherText_size < crypto_box_MACBYTES ) {
+            THROW_ERROR("argument cipherText must have a length of at least crypto_box_MACBYTES bytes");
+        }
+
+        NEW_BUFFER_AND_PTR(m, cipherText_size - crypto_box_MACBYTES);
+        if( crypto_box_open_easy_afternm(m_ptr, cipherText, cipherText_size, nonce, k) == 0 ) {
+            return m;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value EncryptDetached(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments message and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER(message);
+        ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+
+        NEW_BUFFER_AND_PTR(c, message_size);
+        NEW_BUFFER_AND_PTR(mac, crypto_box_MACBYTES);
+        if( crypto_box_detached_afternm(c_ptr, mac_ptr, message, message_size, nonce, k) == 0 ) {
+            Napi::Object result = Napi::Object::New(env);
+            result.Set(Napi::String::New(env, "cipherText"), c);
+            result.Set(Napi::String::New(env, "mac"), mac);
+            return result;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value DecryptDetached(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(3, "arguments cipherText, mac and nonce must be buffers");
+        ARG_TO_UCHAR_BUFFER(cipherText);
+        ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_box_MACBYTES);
+        ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+
+        NEW_BUFFER_AND_PTR(m, cipherText_size);
+        if( crypto_box_open_detached_afternm(m_ptr, cipherText, mac, cipherText_size, nonce, k) == 0 ) {
+            return m;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    unsigned char* k;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_box_session(Napi::Env env, Napi::Object exports) {
+    BoxSession::Init(env, exports);
+}
@@ -0,0 +1,551 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "crypto_box_cache.h"
+#include "sodium_stats.h"
+
+/**
+ * Signed boxes
+ *
+ * A signed box is a `crypto_box_easy` box of an Ed25519 detached signature
+ * followed by the message:
+ *
+ *     box( signature (64) | message )
+ *
+ * the same bytes as calling `crypto_sign_ed25519_detached` then
+ * `crypto_box_easy` on the signature and the message put together, so
+ * either end can keep doing it in two steps. Here the signature is written
+ * straight into the output, the message copied after it, and the box is
+ * encrypted in place: no intermediate Buffer and one crossing. Opening
+ * decrypts into the output, checks the signature over it and returns a
+ * view of the message. Shared keys go through the box key cache.
+ *
+ * The signature covers the message only: a recipient can box the same
+ * signed message to someone else. Put the recipient in the message when
+ * that matters.
+ */
+#define BOX_SIGNED_OVERHEAD (crypto_box_MACBYTES + crypto_sign_ed25519_BYTES)
+
+// Sign `m` with `ssk` and box it for `pk` from `sk` into the
+// mlen + BOX_SIGNED_OVERHEAD bytes at `out`
+static int box_sign_easy(unsigned char* out, const unsigned char* m, size_t mlen,
+                         const unsigned char* n, const unsigned char* pk, const unsigned char* sk,
+                         const unsigned char* ssk) {
+    unsigned char* signed_m = out + crypto_box_MACBYTES;
+    if( SODIUM_STAT(sign, mlen, crypto_sign_ed25519_BYTES,
+            crypto_sign_ed25519_detached(signed_m, NULL, m, mlen, ssk)) != 0 ) {
+        return -1;
+    }
+    if( mlen > 0 ) {
+        memmove(signed_m + crypto_sign_ed25519_BYTES, m, mlen);
+    }
+
+    size_t smlen = crypto_sign_ed25519_BYTES + mlen;
+    BOX_CACHE_CALL(rc, pk, sk,
+        crypto_box_easy_afternm(out, signed_m, smlen, n, box_k),
+        crypto_box_easy(out, signed_m, smlen, n, pk, sk));
+    if( SODIUM_STAT(box, smlen, smlen + crypto_box_MACBYTES, rc) != 0 ) {
+        sodium_memzero(out, smlen + crypto_box_MACBYTES);
+        return -1;
+    }
+    return 0;
+}
+
+// Open the signed box `c` into the clen - crypto_box_MACBYTES bytes at
+// `out`, signature then message, and verify the signature with `spk`.
+// `out` is wiped when either fails
+static int box_open_verify_easy(unsigned char* out, const unsigned char* c, size_t clen,
+                                const unsigned char* n, const unsigned char* pk, const unsigned char* sk,
+                                const unsigned char* spk) {
+    if( clen < BOX_SIGNED_OVERHEAD ) {
+        return -1;
+    }
+    size_t smlen = clen - crypto_box_MACBYTES;
+    BOX_CACHE_CALL(rc, pk, sk,
+        crypto_box_open_easy_afternm(out, c, clen, n, box_k),
+        crypto_box_open_easy(out, c, clen, n, pk, sk));
+    if( SODIUM_STAT(box, clen, smlen, rc) != 0 ) {
+        return -1;
+    }
+
+    size_t mlen = smlen - crypto_sign_ed25519_BYTES;
+    if( SODIUM_STAT(verify, mlen, 0,
+            crypto_sign_ed25519_verify_detached(out, out + crypto_sign_ed25519_BYTES, mlen, spk)) != 0 ) {
+        sodium_memzero(out, smlen);
+        return -1;
+    }
+    return 0;
+}
+
+// The message of an opened signed box: a view past the signature
+static Napi::Value box_signed_message(Napi::Env env, Napi::Object opened) {
+    Napi::Function subarray = opened.Get("subarray").As<Napi::Function>();
+    return subarray.Call(opened, { Napi::Number::New(env, crypto_sign_ed25519_BYTES) });
+}
+
+/**
+ * crypto_box_sign_easy:
+ * Sign a message with Ed25519 and box the signature and the message
+ *
+ *     var c = sodium.crypto_box_sign_easy(message, nonce, publicKey, secretKey, signSecretKey);
+ *
+ * ~ message (Buffer): message to sign and encrypt
+ * ~ nonce (Buffer): `crypto_box_NONCEBYTES` nonce
+ * ~ publicKey (Buffer): the recipient's box public key
+ * ~ secretKey (Buffer): the sender's box secret key
+ * ~ signSecretKey (Buffer): the sender's `crypto_sign_SECRETKEYBYTES` key
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: `message.length + crypto_box_MACBYTES + crypto_sign_BYTES`
+ *   bytes, the same as `crypto_box_easy` of the detached signature followed
+ *   by the message
+ * ~ null: if the public key is rejected
+ */
+NAPI_METHOD(crypto_box_sign_easy) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments message, nonce, publicKey, secretKey and signSecretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_OR_NULL(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(signSecretKey, crypto_sign_ed25519_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(ctxt, message_size + BOX_SIGNED_OVERHEAD);
+    if( box_sign_easy(ctxt_ptr, message, message_size, nonce, publicKey, secretKey, signSecretKey) == 0 ) {
+        return ctxt;
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_box_open_verify_easy:
+ * Open a signed box and verify its signature
+ *
+ *     var m = sodium.crypto_box_open_verify_easy(cipherText, nonce, publicKey, secretKey, signPublicKey);
+ *
+ * ~ cipherText (Buffer): box from `crypto_box_sign_easy`
+ * ~ publicKey (Buffer): the sender's box public key
+ * ~ secretKey (Buffer): the recipient's box secret key
+ * ~ signPublicKey (Buffer): the sender's `crypto_sign_PUBLICKEYBYTES` key
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: the message, a view past the signature in the opened box
+ * ~ null: if the box does not open or the signature does not verify
+ */
+NAPI_METHOD(crypto_box_open_verify_easy) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments cipherText, nonce, publicKey, secretKey and signPublicKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(cipherText);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(signPublicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
+
+    if( cipherText_size < BOX_SIGNED_OVERHEAD ) {
+        THROW_ERROR("argument cipherText must be at least crypto_box_MACBYTES + crypto_sign_BYTES bytes long");
+    }
+
+    NEW_BUFFER_AND_PTR(opened, cipherText_size - crypto_box_MACBYTES);
+    if( box_open_verify_easy(opened_ptr, cipherText, cipherText_size, nonce, publicKey, secretKey,
+                             signPublicKey) == 0 ) {
+        return box_signed_message(env, opened);
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * Resolves to the view of the message of crypto_box_open_verify_easy_async
+ */
+class BoxOpenVerifyWorker : public SodiumAsyncWorker {
+public:
+    BoxOpenVerifyWorker(const Napi::CallbackInfo& info)
+        : SodiumAsyncWorker(info, "crypto_box_open_verify_easy") {}
+
+    unsigned char* Output(Napi::Object buffer) {
+        out = Napi::Persistent(buffer);
+        return Pin(buffer);
+    }
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        if( status != 0 ) {
+            return env.Null();
+        }
+        return box_signed_message(env, out.Value());
+    }
+
+private:
+    Napi::ObjectReference out;
+};
+
+/**
+ * crypto_box_sign_easy_async:
+ * Same as `crypto_box_sign_easy` on the libuv threadpool
+ *
+ *     sodium.crypto_box_sign_easy_async(message, nonce, publicKey, secretKey, signSecretKey, [options], [callback]);
+ *
+ * The message is pinned, not copied, so do not change it until the result
+ * is delivered. Messages shorter than `sodium_async_threshold()` bytes are
+ * boxed inline when a Promise is returned.
+ */
+NAPI_METHOD(crypto_box_sign_easy_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments message, nonce, publicKey, secretKey and signSecretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(signSecretKey, crypto_sign_ed25519_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(ctxt, message_size + BOX_SIGNED_OVERHEAD);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_sign_easy");
+    unsigned char* out = worker->Pin(ctxt);
+    const unsigned char* m = worker->Pin(message_buffer);
+    const unsigned char* n = worker->Copy(nonce, crypto_box_NONCEBYTES);
+    const unsigned char* pk = worker->Copy(publicKey, crypto_box_PUBLICKEYBYTES);
+    const unsigned char* sk = worker->Copy(secretKey, crypto_box_SECRETKEYBYTES);
+    const unsigned char* ssk = worker->Copy(signSecretKey, crypto_sign_ed25519_SECRETKEYBYTES);
+
+    return worker->StartTiered([=]() {
+        return box_sign_easy(out, m, message_size, n, pk, sk, ssk);
+    }, ASYNC_RESULT_BUFFER, message_size);
+}
+
+/**
+ * crypto_box_open_verify_easy_async:
+ * Same as `crypto_box_open_verify_easy` on the libuv threadpool. Resolves to
+ * the message, or null
+ */
+NAPI_METHOD(crypto_box_open_verify_easy_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments cipherText, nonce, publicKey, secretKey and signPublicKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(cipherText);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_box_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_box_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(signPublicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
+
+    if( cipherText_size < BOX_SIGNED_OVERHEAD ) {
+        THROW_ERROR("argument cipherText must be at least crypto_box_MACBYTES + crypto_sign_BYTES bytes long");
+    }
+
+    NEW_BUFFER_AND_PTR(opened, cipherText_size - crypto_box_MACBYTES);
+
+    BoxOpenVerifyWorker* worker = new BoxOpenVerifyWorker(info);
+    unsigned char* out = worker->Output(opened);
+    const unsigned char* c = worker->Pin(cipherText_buffer);
+    const unsigned char* n = worker->Copy(nonce, crypto_box_NONCEBYTES);
+    const unsigned char* pk = worker->Copy(publicKey, crypto_box_PUBLICKEYBYTES);
+    const unsigned char* sk = worker->Copy(secretKey, crypto_box_SECRETKEYBYTES);
+    const unsigned char* spk = worker->Copy(signPublicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
+
+    return worker->StartTiered([=]() {
+        return box_open_verify_easy(out, c, cipherText_size, n, pk, sk, spk);
+    }, ASYNC_RESULT_BUFFER, cipherText_size);
+}
+
+// Optional `threads` number argument, before an optional callback
+#define ARG_TO_THREADS(NAME) \
+    size_t NAME = 1; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        NAME = NAME ## _arg; \
+    }
+
+// A batch of one size per record, an array of buffers or one buffer back
+// to back, copied into one vector
+#define ARG_TO_RECORDS(NAME, COUNT, SIZE) \
+    std::vector<unsigned char> NAME((COUNT) * (SIZE)); \
+    { \
+        size_t NAME ## _count = COUNT; \
+        ARG_TO_BATCH_LEN(NAME ## _spans, NAME ## _count, SIZE); \
+        for(size_t i = 0; i < (COUNT); i++) { \
+            memcpy(NAME.data() + i * (SIZE), NAME ## _spans[i].data, SIZE); \
+        } \
+    }
+
+// Where each record of a batch goes in its output, back to back, when
+// record `i` takes `spans[i].size + grow - shrink` bytes, or none if it is
+// shorter than `shrink`. Returns the total length
+static size_t box_signed_offsets(const std::vector<SodiumSpan>& spans, size_t grow, size_t shrink,
+                                 std::vector<size_t>& offsets) {
+    size_t total = 0;
+    offsets.resize(spans.size());
+    for(size_t i = 0; i < spans.size(); i++) {
+        offsets[i] = total;
+        total += spans[i].size < shrink ? 0 : spans[i].size + grow - shrink;
+    }
+    return total;
+}
+
+static int box_sign_easy_batch(unsigned char* out, const std::vector<SodiumSpan>& ms,
+                               const std::vector<size_t>& offsets, const unsigned char* nonces,
+                               const unsigned char* pks, const unsigned char* sk,
+                               const unsigned char* ssk, size_t threads) {
+    std::vector<unsigned char> ok(ms.size(), 0);
+    sodium_batch_parallel(ms.size(), threads, 8, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ok[i] = box_sign_easy(out + offsets[i], ms[i].data, ms[i].size,
+                                  nonces + i * crypto_box_NONCEBYTES,
+                                  pks + i * crypto_box_PUBLICKEYBYTES, sk, ssk) == 0;
+        }
+    });
+    for(size_t i = 0; i < ok.size(); i++) {
+        if( !ok[i] ) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Each thread opens into its own scratch block, then copies the message out
+// once the signature verifies, so the plain texts stay back to back
+static void box_open_verify_easy_batch(unsigned char* out, const std::vector<SodiumSpan>& cs,
+                                       const std::vector<size_t>& offsets, const unsigned char* nonces,
+                                       const unsigned char* pks, const unsigned char* sk,
+                                       const unsigned char* spks, std::vector<unsigned char>& ok,
+                                       size_t threads) {
+    sodium_batch_parallel(cs.size(), threads, 8, [&](size_t begin, size_t end) {
+        std::vector<unsigned char> scratch;
+        for(size_t i = begin; i < end; i++) {
+            if( cs[i].size < BOX_SIGNED_OVERHEAD ) {
+                continue;
+            }
+            size_t smlen = cs[i].size - crypto_box_MACBYTES;
+            if( scratch.size() < smlen ) {
+                scratch.resize(smlen);
+            }
+            ok[i] = box_open_verify_easy(scratch.data(), cs[i].data, cs[i].size,
+                                         nonces + i * crypto_box_NONCEBYTES,
+                                         pks + i * crypto_box_PUBLICKEYBYTES, sk,
+                                         spks + i * crypto_sign_ed25519_PUBLICKEYBYTES) == 0;
+            if( ok[i] ) {
+                memcpy(out + offsets[i], scratch.data() + crypto_sign_ed25519_BYTES,
+                       smlen - crypto_sign_ed25519_BYTES);
+            }
+        }
+        if( !scratch.empty() ) {
+            sodium_memzero(scratch.data(), scratch.size());
+        }
+    });
+}
+
+/**
+ * crypto_box_sign_easy_batch:
+ * Sign and box many messages from one sender
+ *
+ *     var c = sodium.crypto_box_sign_easy_batch(messages, lengths, nonces, publicKeys, secretKey, signSecretKey, [threads]);
+ *
+ * ~ messages (Buffer): the messages back to back
+ * ~ lengths (Array|Uint32Array|Number): the length of each message, or one
+ *   length for all of them
+ * ~ nonces (Array|Buffer): one `crypto_box_NONCEBYTES` nonce per message
+ * ~ publicKeys (Array|Buffer): the recipient of each message
+ * ~ secretKey (Buffer): the sender's box secret key
+ * ~ signSecretKey (Buffer): the sender's signing key
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   The call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: the signed boxes back to back, box `i` being `lengths[i] +
+ *   crypto_box_MACBYTES + crypto_sign_BYTES` bytes long
+ * ~ null: if any public key is rejected
+ */
+NAPI_METHOD(crypto_box_sign_easy_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments messages, lengths, nonces, publicKeys, secretKey and signSecretKey are required");
+    ARG_TO_CHUNKS(messages, lengths);
+    ARG_TO_RECORDS(nonces, messages.size(), crypto_box_NONCEBYTES);
+    ARG_TO_RECORDS(publicKeys, messages.size(), crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(ssk, crypto_sign_ed25519_SECRETKEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    std::vector<size_t> offsets;
+    NEW_BUFFER_AND_PTR(c, box_signed_offsets(messages, BOX_SIGNED_OVERHEAD, 0, offsets));
+    if( box_sign_easy_batch(c_ptr, messages, offsets, nonces.data(), publicKeys.data(), sk, ssk,
+                            threads) == 0 ) {
+        return c;
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_box_sign_easy_batch_async:
+ * Same as `crypto_box_sign_easy_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_box_sign_easy_batch_async(messages, lengths, nonces, publicKeys, secretKey, signSecretKey, [threads], [callback]);
+ *
+ * The messages are pinned, not copied, so do not change them until the
+ * result is delivered.
+ */
+NAPI_METHOD(crypto_box_sign_easy_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments messages, lengths, nonces, publicKeys, secretKey and signSecretKey are required");
+    ARG_TO_CHUNKS(messages, lengths);
+    ARG_TO_RECORDS(nonces, messages.size(), crypto_box_NONCEBYTES);
+    ARG_TO_RECORDS(publicKeys, messages.size(), crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(ssk, crypto_sign_ed25519_SECRETKEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    std::vector<size_t> offsets;
+    NEW_BUFFER_AND_PTR(c, box_signed_offsets(messages, BOX_SIGNED_OVERHEAD, 0, offsets));
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_box_sign_easy_batch");
+    unsigned char* out = worker->Pin(c);
+    worker->Pin(messages_packed_buffer);
+    const unsigned char* n = worker->Copy(nonces.data(), nonces.size());
+    const unsigned char* pks = worker->Copy(publicKeys.data(), publicKeys.size());
+    const unsigned char* bsk = worker->Copy(sk, crypto_box_SECRETKEYBYTES);
+    const unsigned char* sign_sk = worker->Copy(ssk, crypto_sign_ed25519_SECRETKEYBYTES);
+
+    return worker->Start([=]() {
+        return box_sign_easy_batch(out, messages, offsets, n, pks, bsk, sign_sk, threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_box_open_verify_easy_batch:
+ * Open and verify many signed boxes sent to one recipient
+ *
+ *     var r = sodium.crypto_box_open_verify_easy_batch(cipherTexts, lengths, nonces, publicKeys, secretKey, signPublicKeys, [threads]);
+ *
+ * ~ cipherTexts (Buffer): the signed boxes back to back
+ * ~ lengths (Array|Uint32Array|Number): the length of each box
+ * ~ nonces (Array|Buffer): one nonce per box
+ * ~ publicKeys (Array|Buffer): the box public key of the sender of each box
+ * ~ secretKey (Buffer): the recipient's box secret key
+ * ~ signPublicKeys (Array|Buffer): the signing key of the sender of each box
+ * ~ threads (Number): optional, split the batch across this many threads
+ *
+ * **Returns** `{ plainTexts, status }`:
+ *
+ * ~ plainTexts (Buffer): the messages back to back, message `i` being
+ *   `lengths[i] - crypto_box_MACBYTES - crypto_sign_BYTES` bytes long,
+ *   zeroed if the box did not open or verify
+ * ~ status (Buffer): bit `i % 8` of byte `i / 8` is set when box `i` opened
+ *   and its signature verified
+ */
+NAPI_METHOD(crypto_box_open_verify_easy_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments cipherTexts, lengths, nonces, publicKeys, secretKey and signPublicKeys are required");
+    ARG_TO_CHUNKS(cipherTexts, lengths);
+    ARG_TO_RECORDS(nonces, cipherTexts.size(), crypto_box_NONCEBYTES);
+    ARG_TO_RECORDS(publicKeys, cipherTexts.size(), crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_RECORDS(signPublicKeys, cipherTexts.size(), crypto_sign_ed25519_PUBLICKEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    std::vector<size_t> offsets;
+    NEW_BUFFER_AND_PTR(m, box_signed_offsets(cipherTexts, 0, BOX_SIGNED_OVERHEAD, offsets));
+    memset(m_ptr, 0, m.Length());
+    std::vector<unsigned char> ok(cipherTexts.size(), 0);
+
+    box_open_verify_easy_batch(m_ptr, cipherTexts, offsets, nonces.data(), publicKeys.data(), sk,
+                               signPublicKeys.data(), ok, threads);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("plainTexts", m);
+    result.Set("status", sodium_batch_bitmap(env, ok));
+    return result;
+}
+
+/**
+ * Resolves to `{ plainTexts, status }` like crypto_box_open_verify_easy_batch
+ */
+class BoxOpenVerifyBatchWorker : public SodiumAsyncWorker {
+public:
+    BoxOpenVerifyBatchWorker(const Napi::CallbackInfo& info, size_t count)
+        : SodiumAsyncWorker(info, "crypto_box_open_verify_easy_batch"), ok(count, 0) {}
+
+    unsigned char* Output(Napi::Object buffer) {
+        out = Napi::Persistent(buffer);
+        return Pin(buffer);
+    }
+
+    std::vector<unsigned char> ok;
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("plainTexts", out.Value());
+        result.Set("status", sodium_batch_bitmap(env, ok));
+        return result;
+    }
+
+private:
+    Napi::ObjectReference out;
+};
+
+/**
+ * crypto_box_open_verify_easy_batch_async:
+ * Same as `crypto_box_open_verify_easy_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_box_open_verify_easy_batch_async(cipherTexts, lengths, nonces, publicKeys, secretKey, signPublicKeys, [threads], [callback]);
+ */
+NAPI_METHOD(crypto_box_open_verify_easy_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments cipherTexts, lengths, nonces, publicKeys, secretKey and signPublicKeys are required");
+    ARG_TO_CHUNKS(cipherTexts, lengths);
+    ARG_TO_RECORDS(nonces, cipherTexts.size(), crypto_box_NONCEBYTES);
+    ARG_TO_RECORDS(publicKeys, cipherTexts.size(), crypto_box_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_box_SECRETKEYBYTES);
+    ARG_TO_RECORDS(signPublicKeys, cipherTexts.size(), crypto_sign_ed25519_PUBLICKEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    std::vector<size_t> offsets;
+    NEW_BUFFER_AND_PTR(m, box_signed_offsets(cipherTexts, 0, BOX_SIGNED_OVERHEAD, offsets));
+    memset(m_ptr, 0, m.Length());
+
+    BoxOpenVerifyBatchWorker* worker = new BoxOpenVerifyBatchWorker(info, cipherTexts.size());
+    unsigned char* out = worker->Output(m);
+    worker->Pin(cipherTexts_packed_buffer);
+    const unsigned char* n = worker->Copy(nonces.data(), nonces.size());
+    const unsigned char* pks = worker->Copy(publicKeys.data(), publicKeys.size());
+    const unsigned char* rsk = worker->Copy(sk, crypto_box_SECRETKEYBYTES);
+    const unsigned char* spks = worker->Copy(signPublicKeys.data(), signPublicKeys.size());
+
+    return worker->Start([=]() {
+        box_open_verify_easy_batch(out, cipherTexts, offsets, n, pks, rsk, spks, worker->ok, threads);
+        return 0;
+    }, ASYNC_RESULT_BUFFER);
+}
+
+#undef ARG_TO_THREADS
+#undef ARG_TO_RECORDS
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_box_signed(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_box_sign_easy);
+    EXPORT(crypto_box_open_verify_easy);
+    EXPORT(crypto_box_sign_easy_async);
+    EXPORT(crypto_box_open_verify_easy_async);
+    EXPORT(crypto_box_sign_easy_batch);
+    EXPORT(crypto_box_sign_easy_batch_async);
+    EXPORT(crypto_box_open_verify_easy_batch);
+    EXPORT(crypto_box_open_verify_easy_batch_async);
+}
@@ -6,6 +6,8 @@
  * @License MIT
  */
 #include "node_sodium.h"
+#include "sodium_stats.h"
+#include "node_sodium_async.h"
 
 /**
  * int crypto_generichash(unsigned char *out,
@@ -24,19 +26,21 @@ NAPI_METHOD(crypto_generichash) {
 
     ARGS(3, "arguments must be: hash size, message, key");
     ARG_TO_NUMBER(out_size);
-    ARG_TO_UCHAR_BUFFER(in);
+    ARG_TO_UCHAR_BUFFER_OR_STRING(in);
     ARG_TO_UCHAR_BUFFER_OR_NULL(key);
+    ARG_TO_ENCODING(encoding);
 
     if (key != NULL) {
         CHECK_SIZE(key_size, crypto_generichash_KEYBYTES_MIN, crypto_generichash_KEYBYTES_MAX);
     }
     CHECK_SIZE(out_size, crypto_generichash_BYTES_MIN, crypto_generichash_BYTES_MAX);
 
-    NEW_BUFFER_AND_PTR(hash, out_size);
+    NEW_OUTPUT_AND_PTR(hash, out_size, encoding);
     sodium_memzero(hash_ptr, out_size);
 
-    if (crypto_generichash(hash_ptr, out_size, in, in_size, key, key_size) == 0) {
-        return hash;
+    if (SODIUM_STAT(hash, in_size, out_size,
+            crypto_generichash(hash_ptr, out_size, in, in_size, key, key_size)) == 0) {
+        return OUTPUT_VALUE(hash, out_size, encoding);
     }
 
     return NAPI_NULL;
@@ -117,6 +121,52 @@ NAPI_METHOD(crypto_generichash_final) {
     return NAPI_NULL;
 }
 
+/**
+ * Async version of crypto_generichash with the same arguments plus an
+ * optional callback. Without a callback a Promise is returned, and messages
+ * shorter than sodium_async_threshold() bytes are hashed inline.
+ *
+ * The message is hashed in pieces, so a cancelled hash stops at the next
+ * one. The message buffer is not copied: do not change it until the hash
+ * is done.
+ */
+NAPI_METHOD(crypto_generichash_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: hash size, message, key");
+    ARG_TO_NUMBER(out_size);
+    ARG_TO_UCHAR_BUFFER(in);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(key);
+
+    if (key != NULL) {
+        CHECK_SIZE(key_size, crypto_generichash_KEYBYTES_MIN, crypto_generichash_KEYBYTES_MAX);
+    }
+    CHECK_SIZE(out_size, crypto_generichash_BYTES_MIN, crypto_generichash_BYTES_MAX);
+
+    NEW_BUFFER_AND_PTR(hash, out_size);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_generichash");
+    unsigned char* h = worker->Pin(hash);
+    const unsigned char* m = worker->Pin(in_buffer);
+    const unsigned char* k = key != NULL ? worker->Copy(key, key_size) : NULL;
+
+    return worker->StartTiered([=]() {
+        crypto_generichash_state state;
+        crypto_generichash_init(&state, k, key_size, out_size);
+        bool done = sodium_async_chunks(worker, m, in_size, [&](const unsigned char* piece, size_t n) {
+            crypto_generichash_update(&state, piece, n);
+        });
+        int ret = done ? crypto_generichash_final(&state, h, out_size) : -1;
+        sodium_memzero(&state, sizeof state);
+        return ret;
+    }, ASYNC_RESULT_BUFFER, in_size);
+}
+
+// crypto_generichash is BLAKE2b, so the multi chunk functions are shared
+NAPI_METHOD(crypto_generichash_blake2b_many);
+NAPI_METHOD(crypto_generichash_blake2b_many_async);
+NAPI_METHOD(crypto_generichash_blake2b_many_stream);
+
 NAPI_METHOD_FROM_STRING(crypto_generichash_primitive)
 NAPI_METHOD_FROM_INT(crypto_generichash_statebytes)
 NAPI_METHOD_FROM_INT(crypto_generichash_bytes)
@@ -135,10 +185,14 @@ void register_crypto_generichash(Napi::Env env, Napi::Object exports) {
 
      // Generic Hash
     EXPORT(crypto_generichash);
+    EXPORT(crypto_generichash_async);
     EXPORT(crypto_generichash_init);
     EXPORT(crypto_generichash_update);
     EXPORT(crypto_generichash_final);
     EXPORT(crypto_generichash_keygen);
+    EXPORT_ALIAS(crypto_generichash_many, crypto_generichash_blake2b_many);
+    EXPORT_ALIAS(crypto_generichash_many_async, crypto_generichash_blake2b_many_async);
+    EXPORT_ALIAS(crypto_generichash_many_stream, crypto_generichash_blake2b_many_stream);
 
     EXPORT_STRING(crypto_generichash_PRIMITIVE);
     EXPORT(crypto_generichash_statebytes);
@@ -6,6 +6,9 @@
  * @License MIT
  */
 #include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "sodium_batch_stream.h"
 
 /**
  * int crypto_generichash_blake2b(unsigned char *out,
@@ -24,19 +27,20 @@ NAPI_METHOD(crypto_generichash_blake2b) {
 
     ARGS(3, "arguments must be: hash size, message, key");
     ARG_TO_NUMBER(out_size);
-    ARG_TO_UCHAR_BUFFER(in);
+    ARG_TO_UCHAR_BUFFER_OR_STRING(in);
     ARG_TO_UCHAR_BUFFER_OR_NULL(key);
+    ARG_TO_ENCODING(encoding);
 
     if (key != NULL) {
         CHECK_SIZE(key_size, crypto_generichash_blake2b_KEYBYTES_MIN, crypto_generichash_blake2b_KEYBYTES_MAX);
     }
     CHECK_SIZE(out_size, crypto_generichash_blake2b_BYTES_MIN, crypto_generichash_blake2b_BYTES_MAX);
 
-    NEW_BUFFER_AND_PTR(hash, out_size);
+    NEW_OUTPUT_AND_PTR(hash, out_size, encoding);
     sodium_memzero(hash_ptr, out_size);
 
     if (crypto_generichash_blake2b(hash_ptr, out_size, in, in_size, key, key_size) == 0) {
-        return hash;
+        return OUTPUT_VALUE(hash, out_size, encoding);
     }
 
     return NAPI_NULL;
@@ -154,6 +158,406 @@ NAPI_METHOD(crypto_generichash_blake2b_salt_personal) {
     return NAPI_FALSE;
 }
 
+// Threads are only worth starting for a few hundred KiB of input each
+#define GENERICHASH_MANY_MIN_BYTES_PER_THREAD (256 * 1024)
+
+static void generichash_many(unsigned char* out, size_t out_size, const std::vector<SodiumSpan>& chunks,
+                             const unsigned char* key, size_t key_size, size_t threads) {
+    size_t total = 0;
+    for(const SodiumSpan& chunk : chunks) {
+        total += chunk.size;
+    }
+    size_t average = chunks.empty() ? 1 : total / chunks.size() + 1;
+
+    sodium_batch_parallel(chunks.size(), threads, GENERICHASH_MANY_MIN_BYTES_PER_THREAD / average,
+                          [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            crypto_generichash_blake2b(out + i * out_size, out_size, chunks[i].data, chunks[i].size,
+                                       key, key_size);
+        }
+    });
+}
+
+#define ARG_TO_GENERICHASH_MANY() \
+    ARGS(3, "arguments must be: hash size, chunks, lengths"); \
+    ARG_TO_NUMBER(out_size); \
+    ARG_TO_CHUNKS(chunks, lengths); \
+    unsigned char* key = NULL; \
+    size_t key_size = 0; \
+    if( info.Length() > 3 && !info[3].IsUndefined() && !info[3].IsNull() && !info[3].IsFunction() ) { \
+        ARG_TO_UCHAR_BUFFER(key_arg); \
+        key = key_arg; \
+        key_size = key_arg_size; \
+        CHECK_SIZE(key_size, crypto_generichash_blake2b_KEYBYTES_MIN, crypto_generichash_blake2b_KEYBYTES_MAX); \
+    } \
+    _arg = 4; \
+    size_t threads = 1; \
+    if( info.Length() > 4 && info[4].IsNumber() ) { \
+        ARG_TO_NUMBER(nthreads); \
+        threads = nthreads; \
+    } \
+    CHECK_SIZE(out_size, crypto_generichash_blake2b_BYTES_MIN, crypto_generichash_blake2b_BYTES_MAX)
+
+/**
+ * crypto_generichash_blake2b_many:
+ * Hash many chunks of one buffer in a single call
+ *
+ *     var hashes = sodium.crypto_generichash_blake2b_many(
+ *                      hashSize,
+ *                      chunks,
+ *                      lengths,
+ *                      [key],
+ *                      [threads]);
+ *
+ * ~ hashSize (Number): between `crypto_generichash_blake2b_BYTES_MIN` and
+ *   `crypto_generichash_blake2b_BYTES_MAX`
+ * ~ chunks (Buffer): the chunks back to back
+ * ~ lengths (Array|Uint32Array|Number): the length of each chunk, adding up
+ *   to `chunks.length`. A single Number cuts `chunks` into pieces of that
+ *   size, the last one possibly shorter
+ * ~ key (Buffer): optional, hash every chunk with this key. May be `null`
+ * ~ threads (Number): optional, split the chunks across this many threads.
+ *   The call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ hashes (Buffer): one hash per chunk, back to back. Bytes
+ *   `i * hashSize` to `(i + 1) * hashSize` are the hash of chunk `i`
+ *
+ * Also exported as `crypto_generichash_many`.
+ *
+ * **Sample**:
+ *
+ *     // 4 KiB content addressed blocks
+ *     var ids = sodium.crypto_generichash_blake2b_many(32, data, 4096, null, 4);
+ */
+NAPI_METHOD(crypto_generichash_blake2b_many) {
+    Napi::Env env = info.Env();
+
+    ARG_TO_GENERICHASH_MANY();
+
+    NEW_BUFFER_AND_PTR(hashes, chunks.size() * out_size);
+    generichash_many(hashes_ptr, out_size, chunks, key, key_size, threads);
+    return hashes;
+}
+
+/**
+ * crypto_generichash_blake2b_many_async:
+ * Same as `crypto_generichash_blake2b_many` on the libuv threadpool
+ *
+ *     sodium.crypto_generichash_blake2b_many_async(hashSize, chunks, lengths, [key], [threads], [callback]);
+ *
+ * Returns a Promise when no callback is given. The chunks buffer is not
+ * copied: do not change it until the hashes are done.
+ */
+NAPI_METHOD(crypto_generichash_blake2b_many_async) {
+    Napi::Env env = info.Env();
+
+    ARG_TO_GENERICHASH_MANY();
+
+    NEW_BUFFER_AND_PTR(hashes, chunks.size() * out_size);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_generichash_blake2b_many");
+    unsigned char* h = worker->Pin(hashes);
+    worker->Pin(chunks_packed_buffer);
+    const unsigned char* k = key != NULL ? worker->Copy(key, key_size) : NULL;
+
+    return worker->Start([=]() {
+        generichash_many(h, out_size, chunks, k, key_size, threads);
+        return 0;
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_generichash_blake2b_many_stream:
+ * `crypto_generichash_blake2b_many` on the libuv threadpool, handing the
+ * hashes back by chunks as they are done
+ *
+ *     sodium.crypto_generichash_blake2b_many_stream(hashSize, chunks, lengths, key, options, [callback]);
+ *
+ * `options.onChunk(start, hashes)` is called for every `options.chunkSize`
+ * chunks of input, 1024 by default, in order, with `hashes` an Array of
+ * `hashSize` byte Buffers for chunks `start` on. `key` may be `null`, and
+ * `options.threads` splits each chunk. Resolves to 0 once every hash has
+ * been delivered. As with `_many_async`, the chunks buffer is not copied.
+ * See src/include/sodium_batch_stream.h
+ *
+ * Also exported as `crypto_generichash_many_stream`.
+ */
+NAPI_METHOD(crypto_generichash_blake2b_many_stream) {
+    Napi::Env env = info.Env();
+
+    ARG_TO_GENERICHASH_MANY();
+    ARG_TO_STREAM_OPTIONS(options);
+
+    SodiumStreamWorker* worker = new SodiumStreamWorker(info, "crypto_generichash_blake2b_many_stream",
+                                                        chunks.size(), STREAM_RESULT_BUFFERS, options);
+    worker->sizes.assign(chunks.size(), out_size);
+    worker->Pin(chunks_packed_buffer);
+    const unsigned char* k = key != NULL ? worker->Copy(key, key_size) : NULL;
+    threads = worker->threads;
+
+    return worker->Stream([=](size_t begin, size_t end, unsigned char* out, unsigned char* ok) {
+        std::vector<SodiumSpan> range(chunks.begin() + begin, chunks.begin() + end);
+        generichash_many(out, out_size, range, k, key_size, threads);
+        memset(ok, 1, end - begin);
+    });
+}
+
+/**
+ * Tree hashing
+ *
+ * Plain BLAKE2b is sequential, so one large input only ever uses one core.
+ * The tree mode cuts the input into leaves of `leafSize` bytes, hashes the
+ * leaves independently, on as many threads as asked for, and hashes the
+ * concatenated leaf digests into the root:
+ *
+ *     leaf i = BLAKE2b-512(leaf bytes, key,
+ *                          salt = LE64(i) || LE64(leafSize),
+ *                          personal = "node-sodium-leaf")
+ *     root   = BLAKE2b-outSize(leaf 0 || leaf 1 || ..., key,
+ *                          salt = LE64(leafCount) || LE64(leafSize),
+ *                          personal = "node-sodium-root")
+ *
+ * Only the last leaf may be shorter than `leafSize`, and an empty input has
+ * no leaves. The salt binds every leaf to its position and every root to
+ * the shape of the tree. This is not BLAKE2bp: the digest differs from both
+ * BLAKE2bp and `crypto_generichash`, and only matches another tree hash
+ * with the same leaf size.
+ */
+#define GENERICHASH_TREE_LEAF_BYTES         crypto_generichash_blake2b_BYTES_MAX
+#define GENERICHASH_TREE_DEFAULT_LEAF_SIZE  (1024 * 1024)
+#define GENERICHASH_TREE_LEAF_SIZE_UNIT     1024
+
+#define crypto_generichash_blake2b_TREE_LEAFBYTES GENERICHASH_TREE_LEAF_BYTES
+#define crypto_generichash_blake2b_TREE_LEAFSIZE  GENERICHASH_TREE_DEFAULT_LEAF_SIZE
+
+static const unsigned char generichash_tree_leaf_personal[] = "node-sodium-leaf";
+static const unsigned char generichash_tree_root_personal[] = "node-sodium-root";
+
+static void generichash_tree_salt(unsigned char* salt, uint64_t first, uint64_t second) {
+    for(int i = 0; i < 8; i++) {
+        salt[i] = (unsigned char) (first >> (8 * i));
+        salt[8 + i] = (unsigned char) (second >> (8 * i));
+    }
+}
+
+static void generichash_tree_leaves(unsigned char* out, const unsigned char* in, size_t in_size,
+                                    uint64_t first_leaf, size_t leaf_size,
+                                    const unsigned char* key, size_t key_size, size_t threads) {
+    size_t count = (in_size + leaf_size - 1) / leaf_size;
+    size_t min_leaves = GENERICHASH_MANY_MIN_BYTES_PER_THREAD / leaf_size;
+
+    sodium_batch_parallel(count, threads, min_leaves, [&](size_t begin, size_t end) {
+        unsigned char salt[crypto_generichash_blake2b_SALTBYTES];
+        for(size_t i = begin; i < end; i++) {
+            size_t offset = i * leaf_size;
+            size_t size = in_size - offset < leaf_size ? in_size - offset : leaf_size;
+            generichash_tree_salt(salt, first_leaf + i, leaf_size);
+            crypto_generichash_blake2b_salt_personal(out + i * GENERICHASH_TREE_LEAF_BYTES, GENERICHASH_TREE_LEAF_BYTES,
+                                                     in + offset, size, key, key_size,
+                                                     salt, generichash_tree_leaf_personal);
+        }
+    });
+}
+
+static void generichash_tree_root(unsigned char* out, size_t out_size, const unsigned char* leaves,
+                                  size_t count, size_t leaf_size, const unsigned char* key, size_t key_size) {
+    unsigned char salt[crypto_generichash_blake2b_SALTBYTES];
+    generichash_tree_salt(salt, count, leaf_size);
+    crypto_generichash_blake2b_salt_personal(out, out_size, leaves, count * GENERICHASH_TREE_LEAF_BYTES,
+                                             key, key_size, salt, generichash_tree_root_personal);
+}
+
+// Optional key at the current argument, skipped when undefined or null
+#define ARG_TO_TREE_KEY() \
+    unsigned char* key = NULL; \
+    size_t key_size = 0; \
+    if( info.Length() > (size_t) _arg && !info[_arg].IsUndefined() && !info[_arg].IsNull() && \
+        !info[_arg].IsFunction() ) { \
+        ARG_TO_UCHAR_BUFFER(key_arg); \
+        key = key_arg; \
+        key_size = key_arg_size; \
+        CHECK_SIZE(key_size, crypto_generichash_blake2b_KEYBYTES_MIN, crypto_generichash_blake2b_KEYBYTES_MAX); \
+    } else { \
+        _arg++; \
+    }
+
+// Optional leaf size at the current argument
+#define ARG_TO_TREE_LEAF_SIZE() \
+    size_t leaf_size = GENERICHASH_TREE_DEFAULT_LEAF_SIZE; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(leaf_size_arg); \
+        leaf_size = leaf_size_arg; \
+        if( leaf_size == 0 || leaf_size % GENERICHASH_TREE_LEAF_SIZE_UNIT != 0 ) { \
+            THROW_ERROR("argument leafSize must be a multiple of 1024 bytes"); \
+        } \
+    } else { \
+        _arg++; \
+    }
+
+// Optional thread count at the current argument
+#define ARG_TO_TREE_THREADS() \
+    size_t threads = 1; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(nthreads); \
+        threads = nthreads; \
+    }
+
+/**
+ * crypto_generichash_blake2b_tree:
+ * Tree hash of a large input, with the leaves hashed in parallel
+ *
+ *     var hash = sodium.crypto_generichash_blake2b_tree(
+ *                      hashSize,
+ *                      message,
+ *                      [key],
+ *                      [leafSize],
+ *                      [threads]);
+ *
+ * ~ hashSize (Number): between `crypto_generichash_blake2b_BYTES_MIN` and
+ *   `crypto_generichash_blake2b_BYTES_MAX`
+ * ~ message (Buffer): message to hash
+ * ~ key (Buffer): optional, may be `null`
+ * ~ leafSize (Number): optional, a multiple of 1024 bytes.
+ *   `crypto_generichash_blake2b_TREE_LEAFSIZE` (1 MiB) by default. It is
+ *   part of the digest
+ * ~ threads (Number): optional, hash the leaves on this many threads. The
+ *   call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ hash (Buffer): the root of the tree, see above. It is not the
+ *   `crypto_generichash_blake2b` hash of the message
+ *
+ * `crypto_generichash_blake2b_tree_async` takes the same arguments plus an
+ * optional callback and runs on the libuv threadpool. The message is not
+ * copied: do not change it until the hash is done.
+ *
+ * **Sample**:
+ *
+ *     var hash = sodium.crypto_generichash_blake2b_tree(32, bigBuffer, null, undefined, 8);
+ */
+#define ARG_TO_GENERICHASH_TREE() \
+    ARGS(2, "arguments must be: hash size, message"); \
+    ARG_TO_NUMBER(out_size); \
+    ARG_TO_UCHAR_BUFFER(in); \
+    ARG_TO_TREE_KEY(); \
+    ARG_TO_TREE_LEAF_SIZE(); \
+    ARG_TO_TREE_THREADS(); \
+    CHECK_SIZE(out_size, crypto_generichash_blake2b_BYTES_MIN, crypto_generichash_blake2b_BYTES_MAX); \
+    size_t leaf_count = (in_size + leaf_size - 1) / leaf_size
+
+NAPI_METHOD(crypto_generichash_blake2b_tree) {
+    Napi::Env env = info.Env();
+
+    ARG_TO_GENERICHASH_TREE();
+
+    std::vector<unsigned char> leaves(leaf_count * GENERICHASH_TREE_LEAF_BYTES);
+    generichash_tree_leaves(leaves.data(), in, in_size, 0, leaf_size, key, key_size, threads);
+
+    NEW_BUFFER_AND_PTR(hash, out_size);
+    generichash_tree_root(hash_ptr, out_size, leaves.data(), leaf_count, leaf_size, key, key_size);
+    return hash;
+}
+
+NAPI_METHOD(crypto_generichash_blake2b_tree_async) {
+    Napi::Env env = info.Env();
+
+    ARG_TO_GENERICHASH_TREE();
+
+    NEW_BUFFER_AND_PTR(hash, out_size);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_generichash_blake2b_tree");
+    unsigned char* h = worker->Pin(hash);
+    const unsigned char* m = worker->Pin(in_buffer);
+    const unsigned char* k = key != NULL ? worker->Copy(key, key_size) : NULL;
+
+    return worker->Start([=]() {
+        std::vector<unsigned char> leaves(leaf_count * GENERICHASH_TREE_LEAF_BYTES);
+        generichash_tree_leaves(leaves.data(), m, in_size, 0, leaf_size, k, key_size, threads);
+        generichash_tree_root(h, out_size, leaves.data(), leaf_count, leaf_size, k, key_size);
+        sodium_memzero(leaves.data(), leaves.size());
+        return 0;
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_generichash_blake2b_tree_leaves:
+ * Leaf digests of one part of a tree hashed input
+ *
+ *     var leaves = sodium.crypto_generichash_blake2b_tree_leaves(
+ *                      part,
+ *                      firstLeaf,
+ *                      [key],
+ *                      [leafSize],
+ *                      [threads]);
+ *
+ * ~ part (Buffer): the next part of the input. Every part except the last
+ *   must be a multiple of `leafSize` bytes long
+ * ~ firstLeaf (Number): index of the first leaf in `part`, the number of
+ *   leaves of all the parts before it
+ * ~ key, leafSize, threads: as in `crypto_generichash_blake2b_tree`
+ *
+ * **Returns**:
+ *
+ * ~ leaves (Buffer): `crypto_generichash_blake2b_TREE_LEAFBYTES` bytes per
+ *   leaf, back to back
+ *
+ * Inputs too large to hold in memory are hashed part by part: concatenate
+ * the leaves of every part and give them to
+ * `crypto_generichash_blake2b_tree_root`.
+ */
+NAPI_METHOD(crypto_generichash_blake2b_tree_leaves) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: part, first leaf");
+    ARG_TO_UCHAR_BUFFER(part);
+    ARG_TO_NUMBER(first_leaf);
+    ARG_TO_TREE_KEY();
+    ARG_TO_TREE_LEAF_SIZE();
+    ARG_TO_TREE_THREADS();
+
+    size_t count = (part_size + leaf_size - 1) / leaf_size;
+    NEW_BUFFER_AND_PTR(leaves, count * GENERICHASH_TREE_LEAF_BYTES);
+    generichash_tree_leaves(leaves_ptr, part, part_size, first_leaf, leaf_size, key, key_size, threads);
+    return leaves;
+}
+
+/**
+ * crypto_generichash_blake2b_tree_root:
+ * Root of a tree hash from all its leaf digests
+ *
+ *     var hash = sodium.crypto_generichash_blake2b_tree_root(hashSize, leaves, [key], [leafSize]);
+ *
+ * ~ leaves (Buffer): the leaf digests of the whole input, in order
+ * ~ hashSize, key, leafSize: as in `crypto_generichash_blake2b_tree`
+ *
+ * **Returns**:
+ *
+ * ~ hash (Buffer): the same hash `crypto_generichash_blake2b_tree` gives for
+ *   the whole input
+ */
+NAPI_METHOD(crypto_generichash_blake2b_tree_root) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: hash size, leaves");
+    ARG_TO_NUMBER(out_size);
+    ARG_TO_UCHAR_BUFFER(leaves);
+    ARG_TO_TREE_KEY();
+    ARG_TO_TREE_LEAF_SIZE();
+
+    CHECK_SIZE(out_size, crypto_generichash_blake2b_BYTES_MIN, crypto_generichash_blake2b_BYTES_MAX);
+    if( leaves_size % GENERICHASH_TREE_LEAF_BYTES != 0 ) {
+        THROW_ERROR("argument leaves must be a multiple of crypto_generichash_blake2b_TREE_LEAFBYTES bytes long");
+    }
+
+    NEW_BUFFER_AND_PTR(hash, out_size);
+    generichash_tree_root(hash_ptr, out_size, leaves, leaves_size / GENERICHASH_TREE_LEAF_BYTES,
+                          leaf_size, key, key_size);
+    return hash;
+}
+
 NAPI_METHOD_FROM_INT(crypto_generichash_blake2b_bytes)
 NAPI_METHOD_FROM_INT(crypto_generichash_blake2b_bytes_min)
 NAPI_METHOD_FROM_INT(crypto_generichash_blake2b_bytes_max)
@@ -177,6 +581,15 @@ void register_crypto_generichash_blake2b(Napi::Env env, Napi::Object exports) {
     EXPORT(crypto_generichash_blake2b_update);
     EXPORT(crypto_generichash_blake2b_final);
     EXPORT(crypto_generichash_blake2b_salt_personal);
+    EXPORT(crypto_generichash_blake2b_many);
+    EXPORT(crypto_generichash_blake2b_many_async);
+    EXPORT(crypto_generichash_blake2b_many_stream);
+    EXPORT(crypto_generichash_blake2b_tree);
+    EXPORT(crypto_generichash_blake2b_tree_async);
+    EXPORT(crypto_generichash_blake2b_tree_leaves);
+    EXPORT(crypto_generichash_blake2b_tree_root);
+    EXPORT_INT(crypto_generichash_blake2b_TREE_LEAFBYTES);
+    EXPORT_INT(crypto_generichash_blake2b_TREE_LEAFSIZE);
     EXPORT(crypto_generichash_blake2b_keygen);
     EXPORT(crypto_generichash_blake2b_statebytes);
 
@@ -0,0 +1,336 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <vector>
+
+#include "node_sodium.h"
+#include "sodium_memory.h"
+
+#define INDEX_DIGEST_BYTES  crypto_generichash_BYTES_MIN
+#define INDEX_SLOTS_MIN     16
+#define INDEX_SLOTS_MAX     (1ULL << 32)
+#define INDEX_ID_MAX        SODIUM_MAX_SAFE_INTEGER
+
+// A slot is free when `id` is 0, otherwise it holds the digest of a key and
+// its id plus one
+struct KeyIndexSlot {
+    unsigned char digest[INDEX_DIGEST_BYTES];
+    uint64_t id;
+};
+
+/**
+ * KeyIndex:
+ * A set of secret keys, API keys or session tokens, that answers which one
+ * was presented in constant time per lookup
+ *
+ *     var index = new sodium.KeyIndex([options]);
+ *
+ * ~ options.capacity: number of keys to make room for up front. The table
+ *   grows as needed anyway
+ * ~ options.key: `crypto_generichash_KEYBYTES` hashing key, random by
+ *   default
+ *
+ * The raw keys are never stored: each one is reduced to a 128 bit keyed
+ * BLAKE2b digest, `crypto_generichash`, kept in an open addressing table
+ * with linear probing. A lookup hashes the presented key once, goes to the
+ * slot its digest picks and compares every digest of the probe run with
+ * `sodium_memcmp`. Which slots are probed depends only on digests an
+ * attacker cannot compute without the hashing key, and no comparison
+ * returns early, so the time taken says nothing about how close a guess is
+ * to a stored key. Replaces a scan over all keys with `sodium_memcmp`.
+ *
+ * The table is kept at most 3/4 full and doubled from the stored digests,
+ * without the keys.
+ *
+ * Methods:
+ *
+ * ~ set(key, id): store `key` with `id`, an integer from 0 to
+ *   `Number.MAX_SAFE_INTEGER - 1`, replacing the id of an equal key
+ * ~ lookup(key): the id stored with `key`, -1 if there is none
+ * ~ remove(key): forget `key`. Returns true if it was stored
+ * ~ clear(): forget every key
+ * ~ dispose(): wipes the table and the hashing key. Later calls throw
+ *
+ * Properties: `size`, the number of keys, and `capacity`, the slots
+ *
+ * **Sample**:
+ *
+ *     var index = new sodium.KeyIndex({ capacity: accounts.length });
+ *     accounts.forEach(function(account, i) {
+ *         index.set(account.apiKey, i);
+ *     });
+ *
+ *     var i = index.lookup(request.apiKey);
+ *     if( i < 0 ) {
+ *         // unknown key
+ *     }
+ */
+class KeyIndex : public Napi::ObjectWrap<KeyIndex> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "KeyIndex", {
+            InstanceMethod("set", &KeyIndex::Set),
+            InstanceMethod("lookup", &KeyIndex::Lookup),
+            InstanceMethod("remove", &KeyIndex::Remove),
+            InstanceMethod("clear", &KeyIndex::Clear),
+            InstanceMethod("dispose", &KeyIndex::Dispose),
+            InstanceAccessor("size", &KeyIndex::Size, nullptr),
+            InstanceAccessor("capacity", &KeyIndex::Capacity, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "KeyIndex"), ctor);
+    }
+
+    KeyIndex(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<KeyIndex>(info), state(NULL), count(0), held(0) {
+        Napi::Env env = info.Env();
+
+        Napi::Object options = Napi::Object::New(env);
+        if( info.Length() > 0 && !info[0].IsUndefined() ) {
+            if( !info[0].IsObject() ) {
+                Napi::TypeError::New(env, "argument options must be an object").ThrowAsJavaScriptException();
+                return;
+            }
+            options = info[0].As<Napi::Object>();
+        }
+
+        size_t slots = INDEX_SLOTS_MIN;
+        Napi::Value value = options.Get("capacity");
+        if( !value.IsUndefined() ) {
+            double capacity = value.IsNumber() ? value.As<Napi::Number>().DoubleValue() : -1;
+            if( !(capacity >= 0 && capacity <= INDEX_SLOTS_MAX / 4 * 3) ) {
+                Napi::RangeError::New(env, "option capacity must be a number of keys").ThrowAsJavaScriptException();
+                return;
+            }
+            while( slots / 4 * 3 < capacity ) {
+                slots *= 2;
+            }
+        }
+
+        unsigned char key[crypto_generichash_KEYBYTES];
+        value = options.Get("key");
+        if( !value.IsUndefined() ) {
+            unsigned char* k = NULL;
+            size_t k_size = 0;
+            if( !sodium_arg_bytes(value, k, k_size) || k_size != crypto_generichash_KEYBYTES ) {
+                Napi::TypeError::New(env, "option key must be a crypto_generichash_KEYBYTES buffer").ThrowAsJavaScriptException();
+                return;
+            }
+            memcpy(key, k, sizeof key);
+        } else {
+            randombytes_buf(key, sizeof key);
+        }
+
+        // Absorb the key once, lookups start from a copy of this state
+        state = (crypto_generichash_state*) sodium_secret_alloc(env, sizeof(crypto_generichash_state));
+        if( state == NULL ) {
+            sodium_memzero(key, sizeof key);
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        crypto_generichash_init(state, key, sizeof key, INDEX_DIGEST_BYTES);
+        sodium_memzero(key, sizeof key);
+        sodium_secret_readonly(state);
+
+        Resize(slots);
+    }
+
+    ~KeyIndex() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( state != NULL ) {
+            sodium_secret_free(Env(), state, sizeof(crypto_generichash_state));
+            state = NULL;
+        }
+        if( !table.empty() ) {
+            sodium_memzero(table.data(), table.size() * sizeof(KeyIndexSlot));
+        }
+        std::vector<KeyIndexSlot>().swap(table);
+        count = 0;
+        Hold(0);
+    }
+
+    // Report the table to the GC as memory held by this object
+    void Hold(size_t bytes) {
+        sodium_memory_hold(Env(), (int64_t) bytes - (int64_t) held);
+        held = bytes;
+    }
+
+    void Digest(const unsigned char* key, size_t size, unsigned char digest[INDEX_DIGEST_BYTES]) {
+        crypto_generichash_state s;
+        memcpy(&s, state, sizeof s);
+        crypto_generichash_update(&s, key, size);
+        crypto_generichash_final(&s, digest, INDEX_DIGEST_BYTES);
+        sodium_memzero(&s, sizeof s);
+    }
+
+    size_t Home(const unsigned char digest[INDEX_DIGEST_BYTES]) {
+        uint64_t h = 0;
+        for(int i = 7; i >= 0; i--) {
+            h = (h << 8) | digest[i];
+        }
+        return (size_t) (h & (table.size() - 1));
+    }
+
+    // The slot holding `digest`, or the free slot ending its probe run. Every
+    // occupied slot of the run is compared in full
+    size_t Find(const unsigned char digest[INDEX_DIGEST_BYTES], bool& found) {
+        size_t mask = table.size() - 1;
+        size_t at = table.size();
+        size_t i = Home(digest);
+        for(; table[i].id != 0; i = (i + 1) & mask) {
+            if( sodium_memcmp(table[i].digest, digest, INDEX_DIGEST_BYTES) == 0 ) {
+                at = i;
+            }
+        }
+        found = at != table.size();
+        return found ? at : i;
+    }
+
+    void Resize(size_t slots) {
+        std::vector<KeyIndexSlot> old(slots);
+        old.swap(table);
+        for(size_t i = 0; i < old.size(); i++) {
+            if( old[i].id != 0 ) {
+                size_t j = Home(old[i].digest);
+                while( table[j].id != 0 ) {
+                    j = (j + 1) & (slots - 1);
+                }
+                table[j] = old[i];
+            }
+        }
+        if( !old.empty() ) {
+            sodium_memzero(old.data(), old.size() * sizeof(KeyIndexSlot));
+        }
+        Hold(slots * sizeof(KeyIndexSlot));
+    }
+
+#define CHECK_CONTEXT() \
+    if( state == NULL ) { \
+        THROW_ERROR("KeyIndex was disposed"); \
+    }
+
+    Napi::Value Set(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments key and id must be a buffer and a number");
+        ARG_TO_UCHAR_BUFFER(key);
+        if( !info[1].IsNumber() ) {
+            THROW_ERROR("argument id must be a number");
+        }
+        double id = info[1].As<Napi::Number>().DoubleValue();
+        if( !(id >= 0 && id < INDEX_ID_MAX) || id != (double) (uint64_t) id ) {
+            THROW_ERROR("argument id must be an integer from 0 to Number.MAX_SAFE_INTEGER - 1");
+        }
+
+        unsigned char digest[INDEX_DIGEST_BYTES];
+        Digest(key, key_size, digest);
+
+        bool found;
+        size_t i = Find(digest, found);
+        if( !found ) {
+            if( (count + 1) > table.size() / 4 * 3 ) {
+                if( table.size() >= INDEX_SLOTS_MAX ) {
+                    THROW_ERROR("KeyIndex is full");
+                }
+                Resize(table.size() * 2);
+                i = Find(digest, found);
+            }
+            memcpy(table[i].digest, digest, INDEX_DIGEST_BYTES);
+            count++;
+        }
+        table[i].id = (uint64_t) id + 1;
+        return env.Undefined();
+    }
+
+    Napi::Value Lookup(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument key must be a buffer");
+        ARG_TO_UCHAR_BUFFER(key);
+
+        unsigned char digest[INDEX_DIGEST_BYTES];
+        Digest(key, key_size, digest);
+
+        bool found;
+        size_t i = Find(digest, found);
+        return Napi::Number::New(env, found ? (double) (table[i].id - 1) : -1);
+    }
+
+    Napi::Value Remove(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument key must be a buffer");
+        ARG_TO_UCHAR_BUFFER(key);
+
+        unsigned char digest[INDEX_DIGEST_BYTES];
+        Digest(key, key_size, digest);
+
+        bool found;
+        size_t i = Find(digest, found);
+        if( !found ) {
+            return NAPI_FALSE;
+        }
+
+        // Shift the rest of the run back instead of leaving a tombstone, so
+        // probe runs never outgrow the keys in them
+        size_t mask = table.size() - 1;
+        for(size_t j = (i + 1) & mask; table[j].id != 0; j = (j + 1) & mask) {
+            size_t home = Home(table[j].digest);
+            if( ((j - home) & mask) >= ((j - i) & mask) ) {
+                table[i] = table[j];
+                i = j;
+            }
+        }
+        sodium_memzero(&table[i], sizeof(KeyIndexSlot));
+        count--;
+        return NAPI_TRUE;
+    }
+
+    Napi::Value Clear(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        sodium_memzero(table.data(), table.size() * sizeof(KeyIndexSlot));
+        count = 0;
+        return env.Undefined();
+    }
+
+    Napi::Value Size(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) count);
+    }
+
+    Napi::Value Capacity(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) table.size());
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    crypto_generichash_state* state;
+    std::vector<KeyIndexSlot> table;
+    size_t count;
+    size_t held;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_generichash_index(Napi::Env env, Napi::Object exports) {
+    KeyIndex::Init(env, exports);
+}
@@ -17,12 +17,13 @@ NAPI_METHOD(crypto_hash) {
     Napi::Env env = info.Env();
 
     ARGS(1, "argument message must be a buffer");
-    ARG_TO_UCHAR_BUFFER(msg);
+    ARG_TO_UCHAR_BUFFER_OR_STRING(msg);
+    ARG_TO_ENCODING(encoding);
 
-    NEW_BUFFER_AND_PTR(hash, crypto_hash_BYTES);
+    NEW_OUTPUT_AND_PTR(hash, crypto_hash_BYTES, encoding);
 
     if( crypto_hash(hash_ptr, msg, msg_size) == 0 ) {
-        return hash;
+        return OUTPUT_VALUE(hash, crypto_hash_BYTES, encoding);
     } else {
         return NAPI_NULL;
     }
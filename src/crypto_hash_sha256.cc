@@ -6,6 +6,8 @@
  * @License MIT
  */
 #include "node_sodium.h"
+#include "sodium_stats.h"
+#include "node_sodium_async.h"
 
 /**
  * int crypto_hash_sha256(
@@ -17,12 +19,14 @@ NAPI_METHOD(crypto_hash_sha256) {
     Napi::Env env = info.Env();
 
     ARGS(1, "argument message must be a buffer");
-    ARG_TO_UCHAR_BUFFER(msg);
+    ARG_TO_UCHAR_BUFFER_OR_STRING(msg);
+    ARG_TO_ENCODING(encoding);
 
-    NEW_BUFFER_AND_PTR(hash, crypto_hash_sha256_BYTES);
+    NEW_OUTPUT_AND_PTR(hash, crypto_hash_sha256_BYTES, encoding);
 
-    if( crypto_hash_sha256(hash_ptr, msg, msg_size) == 0 ) {
-        return hash;
+    if( SODIUM_STAT(hash, msg_size, crypto_hash_sha256_BYTES,
+            crypto_hash_sha256(hash_ptr, msg, msg_size)) == 0 ) {
+        return OUTPUT_VALUE(hash, crypto_hash_sha256_BYTES, encoding);
     }
 
     return NAPI_NULL;
@@ -63,6 +67,37 @@ NAPI_METHOD(crypto_hash_sha256_update) {
     return NAPI_FALSE;
 }
 
+/**
+ * Async version of crypto_hash_sha256(message, [callback]). Without a
+ * callback a Promise is returned, and messages shorter than
+ * sodium_async_threshold() bytes are hashed inline.
+ *
+ * The message buffer is not copied: do not change it until the hash is done.
+ */
+NAPI_METHOD(crypto_hash_sha256_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument message must be a buffer");
+    ARG_TO_UCHAR_BUFFER(msg);
+
+    NEW_BUFFER_AND_PTR(hash, crypto_hash_sha256_BYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_hash_sha256");
+    unsigned char* h = worker->Pin(hash);
+    const unsigned char* m = worker->Pin(msg_buffer);
+
+    return worker->StartTiered([=]() {
+        crypto_hash_sha256_state state;
+        crypto_hash_sha256_init(&state);
+        bool done = sodium_async_chunks(worker, m, msg_size, [&](const unsigned char* piece, size_t n) {
+            crypto_hash_sha256_update(&state, piece, n);
+        });
+        int ret = done ? crypto_hash_sha256_final(&state, h) : -1;
+        sodium_memzero(&state, sizeof state);
+        return SODIUM_STAT(hash, msg_size, crypto_hash_sha256_BYTES, ret);
+    }, ASYNC_RESULT_BUFFER, msg_size);
+}
+
 NAPI_METHOD_FROM_INT(crypto_hash_sha256_bytes)
 NAPI_METHOD_FROM_INT(crypto_hash_sha256_statebytes)
 
@@ -91,6 +126,7 @@ void register_crypto_hash_sha256(Napi::Env env, Napi::Object exports) {
 
     // Hash
     EXPORT(crypto_hash_sha256);
+    EXPORT(crypto_hash_sha256_async);
     EXPORT(crypto_hash_sha256_init);
     EXPORT(crypto_hash_sha256_update);
     EXPORT(crypto_hash_sha256_final);
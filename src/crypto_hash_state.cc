@@ -0,0 +1,464 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "sodium_env.h"
+#include "sodium_memory.h"
+
+/**
+ * Incremental hash state objects
+ *
+ * The `_init` functions return the state in a JS Buffer: it is not aligned,
+ * it can be changed or truncated by any code holding it, and every
+ * `_update` has to check and cast it again. A hash state object keeps the
+ * state in native memory instead, where JS cannot reach it.
+ *
+ *     var h = new sodium.GenerichashState([key], [outputLength]);
+ *     var h = new sodium.Sha256State();
+ *     var h = new sodium.Sha512State();
+ *     var h = new sodium.HmacSha256State(key);
+ *     var h = new sodium.HmacSha512State(key);
+ *     var h = new sodium.HmacSha512256State(key);
+ *     var h = new sodium.Poly1305State(key);
+ *
+ * ~ key (Buffer): the key, as for the matching `_init` function. It is only
+ *   used to set up the state, no copy is kept. For `GenerichashState` it is
+ *   optional and may be `null`
+ * ~ outputLength (Number): `GenerichashState` only, between
+ *   `crypto_generichash_BYTES_MIN` and `crypto_generichash_BYTES_MAX`.
+ *   `crypto_generichash_BYTES` by default
+ *
+ * Methods:
+ *
+ * ~ update(message): hash the next part of the message. Returns the object,
+ *   so calls can be chained
+ * ~ final(): the hash or tag of everything given to `update`. The state is
+ *   wiped and released, later calls throw
+ * ~ clone(): a new object with a copy of the current state. Hashing a common
+ *   prefix once and cloning it is cheaper than hashing it again
+ * ~ copy(source): overwrite the state with the one of `source`, an object of
+ *   the same class. Works on finalized or disposed objects too, so one
+ *   scratch object can be forked from a prefix for every message without
+ *   making new objects. Returns the object
+ * ~ finalBatch(messages, [threads]): the hash of the current state followed
+ *   by each message, as if every message was given to its own clone. Returns
+ *   one Buffer with the results back to back and leaves the state as it was.
+ *   `threads` splits the batch across that many threads, the call still
+ *   blocks
+ * ~ dispose(): wipe and release the state without finishing it
+ *
+ * **Sample**:
+ *
+ *     var prefix = new sodium.HmacSha256State(key).update(header);
+ *     var t1 = prefix.clone().update(body1).final();
+ *     var t2 = prefix.clone().update(body2).final();
+ *
+ *     var scratch = prefix.clone();
+ *     var t3 = scratch.copy(prefix).update(body3).final();
+ *     var tags = prefix.finalBatch([body1, body2, body3]);
+ *     // tags.slice(32, 64) equals t2
+ */
+
+/**
+ * States are kept in fixed size slots carved from `sodium_malloc` slabs.
+ * A slab is locked in memory and fenced by guard pages like any other secure
+ * allocation, but it costs several pages and system calls, far more than
+ * hashing a short message, so one slab serves many states and `clone()` only
+ * takes a free slot. Slabs are page aligned and slots are a multiple of 64
+ * bytes, which keeps every state on a cache line boundary.
+ *
+ * Slots are wiped when released. A slab is freed once none of its slots is
+ * used, except for the last one. The slabs are shared by all threads.
+ */
+#define HASH_STATE_SLOT_SIZE    512
+#define HASH_STATE_SLAB_SLOTS   64
+
+static_assert(sizeof(crypto_generichash_state) <= HASH_STATE_SLOT_SIZE &&
+              sizeof(crypto_hash_sha256_state) <= HASH_STATE_SLOT_SIZE &&
+              sizeof(crypto_hash_sha512_state) <= HASH_STATE_SLOT_SIZE &&
+              sizeof(crypto_auth_hmacsha256_state) <= HASH_STATE_SLOT_SIZE &&
+              sizeof(crypto_auth_hmacsha512_state) <= HASH_STATE_SLOT_SIZE &&
+              sizeof(crypto_auth_hmacsha512256_state) <= HASH_STATE_SLOT_SIZE &&
+              sizeof(crypto_onetimeauth_poly1305_state) <= HASH_STATE_SLOT_SIZE,
+              "a hash state does not fit in a slot");
+
+struct HashStateSlab {
+    unsigned char* base;
+    size_t used;
+};
+
+static std::mutex hash_state_mutex;
+static std::vector<HashStateSlab> hash_state_slabs;
+static std::vector<unsigned char*> hash_state_free_slots;
+
+static HashStateSlab* hash_state_slab_of(unsigned char* slot) {
+    for(HashStateSlab& slab : hash_state_slabs) {
+        if( slot >= slab.base && slot < slab.base + HASH_STATE_SLOT_SIZE * HASH_STATE_SLAB_SLOTS ) {
+            return &slab;
+        }
+    }
+    return NULL;
+}
+
+static unsigned char* hash_state_alloc() {
+    std::lock_guard<std::mutex> lock(hash_state_mutex);
+
+    if( hash_state_free_slots.empty() ) {
+        unsigned char* base = (unsigned char*) sodium_malloc(HASH_STATE_SLOT_SIZE * HASH_STATE_SLAB_SLOTS);
+        if( base == NULL ) {
+            return NULL;
+        }
+        hash_state_slabs.push_back({ base, 0 });
+        for(size_t i = HASH_STATE_SLAB_SLOTS; i > 0; i--) {
+            hash_state_free_slots.push_back(base + (i - 1) * HASH_STATE_SLOT_SIZE);
+        }
+    }
+
+    unsigned char* slot = hash_state_free_slots.back();
+    hash_state_free_slots.pop_back();
+    hash_state_slab_of(slot)->used++;
+    return slot;
+}
+
+static void hash_state_release(unsigned char* slot) {
+    sodium_memzero(slot, HASH_STATE_SLOT_SIZE);
+
+    std::lock_guard<std::mutex> lock(hash_state_mutex);
+    HashStateSlab* slab = hash_state_slab_of(slot);
+    if( --slab->used > 0 || hash_state_slabs.size() == 1 ) {
+        hash_state_free_slots.push_back(slot);
+        return;
+    }
+
+    unsigned char* base = slab->base;
+    size_t kept = 0;
+    for(unsigned char* free_slot : hash_state_free_slots) {
+        if( free_slot < base || free_slot >= base + HASH_STATE_SLOT_SIZE * HASH_STATE_SLAB_SLOTS ) {
+            hash_state_free_slots[kept++] = free_slot;
+        }
+    }
+    hash_state_free_slots.resize(kept);
+    hash_state_slabs.erase(hash_state_slabs.begin() + (slab - hash_state_slabs.data()));
+    sodium_free(base);
+}
+
+// See sodium_memory_usage
+size_t crypto_hash_state_memory() {
+    std::lock_guard<std::mutex> lock(hash_state_mutex);
+    return hash_state_slabs.size() * sodium_secure_footprint(HASH_STATE_SLOT_SIZE * HASH_STATE_SLAB_SLOTS);
+}
+
+// clone() passes this as the only constructor argument to get an object
+// whose state is then copied in. JS code cannot make the same External
+static char hash_state_clone_tag;
+
+/**
+ * Algorithms
+ *
+ * Each one names its state type and exported class, and sets up a state from
+ * the constructor arguments. Setup returns false after throwing.
+ */
+struct GenerichashAlgo {
+    typedef crypto_generichash_state State;
+    static const char* Name() { return "GenerichashState"; }
+
+    static bool Setup(const Napi::CallbackInfo& info, State* state, size_t& out_size) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() > 0 && !info[0].IsNull() && !info[0].IsUndefined() ) {
+            if( !sodium_arg_bytes(info[0], key, key_size) ) {
+                Napi::TypeError::New(env, "argument key must be a buffer or null").ThrowAsJavaScriptException();
+                return false;
+            }
+            if( key_size < crypto_generichash_KEYBYTES_MIN || key_size > crypto_generichash_KEYBYTES_MAX ) {
+                Napi::Error::New(env, "argument key must be between crypto_generichash_KEYBYTES_MIN "
+                                      "and crypto_generichash_KEYBYTES_MAX bytes long").ThrowAsJavaScriptException();
+                return false;
+            }
+        }
+
+        out_size = crypto_generichash_BYTES;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            if( !info[1].IsNumber() ) {
+                Napi::TypeError::New(env, "argument outputLength must be a number").ThrowAsJavaScriptException();
+                return false;
+            }
+            double length = info[1].As<Napi::Number>().DoubleValue();
+            if( !(length >= crypto_generichash_BYTES_MIN && length <= crypto_generichash_BYTES_MAX) ) {
+                Napi::Error::New(env, "argument outputLength must be between crypto_generichash_BYTES_MIN "
+                                      "and crypto_generichash_BYTES_MAX").ThrowAsJavaScriptException();
+                return false;
+            }
+            out_size = (size_t) length;
+        }
+
+        crypto_generichash_init(state, key, key_size, out_size);
+        return true;
+    }
+
+    static void Update(State* state, const unsigned char* in, size_t in_size) {
+        crypto_generichash_update(state, in, in_size);
+    }
+
+    static void Final(State* state, unsigned char* out, size_t out_size) {
+        crypto_generichash_final(state, out, out_size);
+    }
+};
+
+#define HASH_STATE_UNKEYED_ALGO(CLASS, HASH) \
+    struct CLASS ## Algo { \
+        typedef HASH ## _state State; \
+        static const char* Name() { return #CLASS "State"; } \
+        static bool Setup(const Napi::CallbackInfo& info, State* state, size_t& out_size) { \
+            out_size = HASH ## _BYTES; \
+            HASH ## _init(state); \
+            return true; \
+        } \
+        static void Update(State* state, const unsigned char* in, size_t in_size) { \
+            HASH ## _update(state, in, in_size); \
+        } \
+        static void Final(State* state, unsigned char* out, size_t out_size) { \
+            HASH ## _final(state, out); \
+        } \
+    }
+
+// HMAC takes keys of any length, Poly1305 exactly KEYBYTES
+#define HASH_STATE_KEYED_ALGO(CLASS, MAC, FIXED_KEY, INIT) \
+    struct CLASS ## Algo { \
+        typedef MAC ## _state State; \
+        static const char* Name() { return #CLASS "State"; } \
+        static bool Setup(const Napi::CallbackInfo& info, State* state, size_t& out_size) { \
+            Napi::Env env = info.Env(); \
+            unsigned char* key = NULL; \
+            size_t key_size = 0; \
+            if( info.Length() < 1 || !sodium_arg_bytes(info[0], key, key_size) ) { \
+                Napi::TypeError::New(env, "argument key must be a buffer").ThrowAsJavaScriptException(); \
+                return false; \
+            } \
+            if( FIXED_KEY && key_size != MAC ## _KEYBYTES ) { \
+                Napi::Error::New(env, "argument key must be " #MAC "_KEYBYTES bytes long").ThrowAsJavaScriptException(); \
+                return false; \
+            } \
+            out_size = MAC ## _BYTES; \
+            INIT; \
+            return true; \
+        } \
+        static void Update(State* state, const unsigned char* in, size_t in_size) { \
+            MAC ## _update(state, in, in_size); \
+        } \
+        static void Final(State* state, unsigned char* out, size_t out_size) { \
+            MAC ## _final(state, out); \
+        } \
+    }
+
+HASH_STATE_UNKEYED_ALGO(Sha256, crypto_hash_sha256);
+HASH_STATE_UNKEYED_ALGO(Sha512, crypto_hash_sha512);
+
+HASH_STATE_KEYED_ALGO(HmacSha256, crypto_auth_hmacsha256, false,
+                      crypto_auth_hmacsha256_init(state, key, key_size));
+HASH_STATE_KEYED_ALGO(HmacSha512, crypto_auth_hmacsha512, false,
+                      crypto_auth_hmacsha512_init(state, key, key_size));
+HASH_STATE_KEYED_ALGO(HmacSha512256, crypto_auth_hmacsha512256, false,
+                      crypto_auth_hmacsha512256_init(state, key, key_size));
+HASH_STATE_KEYED_ALGO(Poly1305, crypto_onetimeauth_poly1305, true,
+                      crypto_onetimeauth_poly1305_init(state, key));
+
+enum HashStateClass {
+    HASH_STATE_GENERICHASH,
+    HASH_STATE_SHA256,
+    HASH_STATE_SHA512,
+    HASH_STATE_HMACSHA256,
+    HASH_STATE_HMACSHA512,
+    HASH_STATE_HMACSHA512256,
+    HASH_STATE_POLY1305
+};
+
+template <class Algo, HashStateClass Id>
+class HashState : public Napi::ObjectWrap<HashState<Algo, Id>> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports, Napi::Object classes) {
+        Napi::Function ctor = HashState::DefineClass(env, Algo::Name(), {
+            HashState::InstanceMethod("update", &HashState::Update),
+            HashState::InstanceMethod("final", &HashState::Final),
+            HashState::InstanceMethod("clone", &HashState::Clone),
+            HashState::InstanceMethod("copy", &HashState::Copy),
+            HashState::InstanceMethod("finalBatch", &HashState::FinalBatch),
+            HashState::InstanceMethod("dispose", &HashState::Dispose)
+        });
+        exports.Set(Napi::String::New(env, Algo::Name()), ctor);
+        classes.Set((uint32_t) Id, ctor);
+    }
+
+    HashState(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<HashState<Algo, Id>>(info), state(NULL), out_size(0) {
+        Napi::Env env = info.Env();
+
+        bool cloning = info.Length() == 1 && info[0].IsExternal() &&
+                       info[0].As<Napi::External<char>>().Data() == &hash_state_clone_tag;
+
+        unsigned char* slot = hash_state_alloc();
+        if( slot == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the hash state").ThrowAsJavaScriptException();
+            return;
+        }
+        state = (typename Algo::State*) slot;
+
+        if( !cloning && !Algo::Setup(info, state, out_size) ) {
+            Free();
+        }
+    }
+
+    ~HashState() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( state != NULL ) {
+            hash_state_release((unsigned char*) state);
+            state = NULL;
+        }
+    }
+
+#define CHECK_STATE() \
+    if( state == NULL ) { \
+        THROW_ERROR("hash state was finalized or disposed"); \
+    }
+
+    Napi::Value Update(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_STATE();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER(message);
+
+        Algo::Update(state, message, message_size);
+        return info.This();
+    }
+
+    Napi::Value Final(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_STATE();
+        NEW_BUFFER_AND_PTR(out, out_size);
+        Algo::Final(state, out_ptr, out_size);
+        Free();
+        return out;
+    }
+
+    static Napi::Function Constructor(Napi::Env env) {
+        napi_value classes;
+        napi_get_reference_value(env, SodiumEnv::Get(env)->hash_state_classes, &classes);
+        return Napi::Object(env, classes).Get((uint32_t) Id).As<Napi::Function>();
+    }
+
+    Napi::Value Clone(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_STATE();
+        Napi::Object copy = Constructor(env).New({ Napi::External<char>::New(env, &hash_state_clone_tag) });
+        HashState* other = HashState::Unwrap(copy);
+        if( other->state == NULL ) {
+            return NAPI_NULL;
+        }
+        memcpy(other->state, state, sizeof(typename Algo::State));
+        other->out_size = out_size;
+        return copy;
+    }
+
+    Napi::Value Copy(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        ARGS(1, "argument source must be a hash state of the same class");
+        if( !info[0].IsObject() || !info[0].As<Napi::Object>().InstanceOf(Constructor(env)) ) {
+            THROW_ERROR("argument source must be a hash state of the same class");
+        }
+        HashState* source = HashState::Unwrap(info[0].As<Napi::Object>());
+        if( source->state == NULL ) {
+            THROW_ERROR("argument source was finalized or disposed");
+        }
+        if( source == this ) {
+            return info.This();
+        }
+
+        if( state == NULL ) {
+            state = (typename Algo::State*) hash_state_alloc();
+            if( state == NULL ) {
+                THROW_ERROR("cannot allocate secure memory for the hash state");
+            }
+        }
+        memcpy(state, source->state, sizeof(typename Algo::State));
+        out_size = source->out_size;
+        return info.This();
+    }
+
+    Napi::Value FinalBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_STATE();
+        ARGS(1, "argument messages must be an array of buffers");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(messages, count);
+
+        size_t threads = 1;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            ARG_TO_NUMBER(nthreads);
+            threads = nthreads;
+        }
+
+        NEW_BUFFER_AND_PTR(out, count * out_size);
+        const typename Algo::State* prefix = state;
+        const size_t size = out_size;
+        sodium_batch_parallel(count, threads, 64, [&](size_t begin, size_t end) {
+            // Each slice forks the prefix into its own state on the stack
+            // (aligned like the state type) and wipes it when done
+            typename Algo::State fork;
+            for(size_t i = begin; i < end; i++) {
+                memcpy(&fork, prefix, sizeof(fork));
+                Algo::Update(&fork, messages[i].data, messages[i].size);
+                Algo::Final(&fork, out_ptr + i * size, size);
+            }
+            sodium_memzero(&fork, sizeof(fork));
+        });
+        return out;
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Free();
+        return info.Env().Undefined();
+    }
+
+#undef CHECK_STATE
+
+    typename Algo::State* state;
+    size_t out_size;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_hash_state(Napi::Env env, Napi::Object exports) {
+    // Constructors kept for clone(), one set per environment
+    Napi::Object classes = Napi::Object::New(env);
+
+    HashState<GenerichashAlgo, HASH_STATE_GENERICHASH>::Init(env, exports, classes);
+    HashState<Sha256Algo, HASH_STATE_SHA256>::Init(env, exports, classes);
+    HashState<Sha512Algo, HASH_STATE_SHA512>::Init(env, exports, classes);
+    HashState<HmacSha256Algo, HASH_STATE_HMACSHA256>::Init(env, exports, classes);
+    HashState<HmacSha512Algo, HASH_STATE_HMACSHA512>::Init(env, exports, classes);
+    HashState<HmacSha512256Algo, HASH_STATE_HMACSHA512256>::Init(env, exports, classes);
+    HashState<Poly1305Algo, HASH_STATE_POLY1305>::Init(env, exports, classes);
+
+    napi_create_reference(env, classes, 1, &SodiumEnv::Get(env)->hash_state_classes);
+}
@@ -0,0 +1,466 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+
+// Subkey ids are full 64 bit in libsodium. Numbers are exact only up to
+// 2^53 - 1, so larger ids must be given as BigInts. NAME ## _max is the
+// largest id the caller's type can express, for range checks on batches.
+#define ARG_TO_SUBKEY_ID(NAME) \
+    uint64_t NAME = 0; \
+    uint64_t NAME ## _max = UINT64_MAX; \
+    { \
+        if( !SODIUM_ARG_IS_INTEGER(info[_arg]) ) { \
+            THROW_ERROR("argument " #NAME " must be a number"); \
+        } \
+        if( info[_arg].IsNumber() ) { \
+            double NAME ## _value = info[_arg].As<Napi::Number>().DoubleValue(); \
+            if( !(NAME ## _value >= 0) || NAME ## _value > SODIUM_MAX_SAFE_INTEGER || \
+                std::floor(NAME ## _value) != NAME ## _value ) { \
+                THROW_ERROR("argument " #NAME " must be an integer between 0 and 2^53 - 1, or a BigInt"); \
+            } \
+            NAME ## _max = (uint64_t) SODIUM_MAX_SAFE_INTEGER; \
+        } \
+        if( !sodium_arg_uint64(info[_arg], #NAME, UINT64_MAX, NAME) ) { \
+            return NAPI_NULL; \
+        } \
+    } \
+    _arg++
+
+// The context is an 8 byte Buffer, or a string of 8 bytes in UTF-8
+#define ARG_TO_KDF_CONTEXT(NAME, CONTEXTBYTES) \
+    char NAME[CONTEXTBYTES]; \
+    { \
+        std::string NAME ## _string; \
+        if( info[_arg].IsString() ) { \
+            NAME ## _string = info[_arg].As<Napi::String>().Utf8Value(); \
+        } else { \
+            unsigned char* NAME ## _bytes = NULL; \
+            size_t NAME ## _size = 0; \
+            if( !sodium_arg_bytes(info[_arg], NAME ## _bytes, NAME ## _size) ) { \
+                THROW_ERROR("argument " #NAME " must be a buffer or a string"); \
+            } \
+            NAME ## _string.assign((const char*) NAME ## _bytes, NAME ## _size); \
+        } \
+        if( NAME ## _string.size() != CONTEXTBYTES ) { \
+            THROW_ERROR("argument " #NAME " must be " #CONTEXTBYTES " bytes long"); \
+        } \
+        memcpy(NAME, NAME ## _string.data(), CONTEXTBYTES); \
+    } \
+    _arg++
+
+#define CHECK_SUBKEY_LENGTH(NAME, KDF) \
+    if( NAME < KDF ## _BYTES_MIN || NAME > KDF ## _BYTES_MAX ) { \
+        THROW_ERROR("argument " #NAME " must be between " #KDF "_BYTES_MIN and " #KDF "_BYTES_MAX"); \
+    }
+
+#define CRYPTO_KDF_DEF(KDF) \
+    NAPI_METHOD(KDF ## _derive_from_key) { \
+        Napi::Env env = info.Env(); \
+        \
+        ARGS(4, "arguments subkeyLength, subkeyId, context and key are required"); \
+        ARG_TO_NUMBER(subkeyLength); \
+        ARG_TO_SUBKEY_ID(subkeyId); \
+        ARG_TO_KDF_CONTEXT(context, KDF ## _CONTEXTBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(key, KDF ## _KEYBYTES); \
+        CHECK_SUBKEY_LENGTH(subkeyLength, KDF); \
+        \
+        NEW_BUFFER_AND_PTR(subkey, subkeyLength); \
+        if( KDF ## _derive_from_key(subkey_ptr, subkeyLength, subkeyId, context, key) == 0 ) { \
+            return subkey; \
+        } \
+        return NAPI_NULL; \
+    } \
+    NAPI_METHOD(KDF ## _derive_batch) { \
+        Napi::Env env = info.Env(); \
+        \
+        ARGS(5, "arguments subkeyLength, firstSubkeyId, count, context and key are required"); \
+        ARG_TO_NUMBER(subkeyLength); \
+        ARG_TO_SUBKEY_ID(firstSubkeyId); \
+        ARG_TO_NUMBER(count); \
+        ARG_TO_KDF_CONTEXT(context, KDF ## _CONTEXTBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(key, KDF ## _KEYBYTES); \
+        CHECK_SUBKEY_LENGTH(subkeyLength, KDF); \
+        if( count != 0 && count - 1 > firstSubkeyId_max - firstSubkeyId ) { \
+            THROW_ERROR("subkey ids must not go above 2^53 - 1, or 2^64 - 1 for a BigInt"); \
+        } \
+        size_t threads = 1; \
+        if( info.Length() > 5 && !info[5].IsUndefined() ) { \
+            ARG_TO_NUMBER(nthreads); \
+            threads = nthreads; \
+        } \
+        \
+        NEW_BUFFER_AND_PTR(subkeys, count * subkeyLength); \
+        sodium_batch_parallel(count, threads, 1024, [&](size_t begin, size_t end) { \
+            for(size_t i = begin; i < end; i++) { \
+                KDF ## _derive_from_key(subkeys_ptr + i * subkeyLength, subkeyLength, \
+                                        firstSubkeyId + i, context, key); \
+            } \
+        }); \
+        return subkeys; \
+    } \
+    NAPI_METHOD_FROM_INT(KDF ## _bytes_min) \
+    NAPI_METHOD_FROM_INT(KDF ## _bytes_max) \
+    NAPI_METHOD_FROM_INT(KDF ## _contextbytes) \
+    NAPI_METHOD_FROM_INT(KDF ## _keybytes)
+
+#define CRYPTO_KDF_EXPORT(KDF) \
+    EXPORT(KDF ## _derive_from_key); \
+    EXPORT(KDF ## _derive_batch); \
+    EXPORT(KDF ## _bytes_min); \
+    EXPORT(KDF ## _bytes_max); \
+    EXPORT(KDF ## _contextbytes); \
+    EXPORT(KDF ## _keybytes); \
+    EXPORT_INT(KDF ## _BYTES_MIN); \
+    EXPORT_INT(KDF ## _BYTES_MAX); \
+    EXPORT_INT(KDF ## _CONTEXTBYTES); \
+    EXPORT_INT(KDF ## _KEYBYTES)
+
+/**
+ * crypto_kdf_keygen:
+ * Generate a random master key
+ *
+ *     var key = sodium.crypto_kdf_keygen();
+ *
+ * **Returns**:
+ *
+ * ~ key (Buffer): `crypto_kdf_KEYBYTES` master key
+ */
+NAPI_METHOD_KEYGEN(crypto_kdf)
+
+/**
+ * crypto_kdf_derive_from_key:
+ * Derive a subkey from a master key
+ *
+ *     var subkey = sodium.crypto_kdf_derive_from_key(
+ *                      subkeyLength,
+ *                      subkeyId,
+ *                      context,
+ *                      key);
+ *
+ * ~ subkeyLength (Number): between `crypto_kdf_BYTES_MIN` and `crypto_kdf_BYTES_MAX`
+ * ~ subkeyId (Number|BigInt): subkey number, up to 2^53 - 1 as a Number or
+ *   2^64 - 1 as a BigInt
+ * ~ context (Buffer|String): `crypto_kdf_CONTEXTBYTES` bytes describing what
+ *   the subkeys are for, such as `"UserKeys"`
+ * ~ key (Buffer): `crypto_kdf_KEYBYTES` master key
+ *
+ * **Returns**:
+ *
+ * ~ subkey (Buffer)
+ */
+
+/**
+ * crypto_kdf_derive_batch:
+ * Derive a range of subkeys in one call
+ *
+ *     var subkeys = sodium.crypto_kdf_derive_batch(
+ *                      subkeyLength,
+ *                      firstSubkeyId,
+ *                      count,
+ *                      context,
+ *                      key,
+ *                      [threads]);
+ *
+ * ~ firstSubkeyId (Number|BigInt): id of the first subkey
+ * ~ count (Number): number of subkeys to derive
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   The call still blocks
+ * ~ subkeyLength, context, key: as in `crypto_kdf_derive_from_key`
+ *
+ * **Returns**:
+ *
+ * ~ subkeys (Buffer): `count` subkeys back to back. Bytes
+ *   `i * subkeyLength` to `(i + 1) * subkeyLength` hold the subkey with id
+ *   `firstSubkeyId + i`
+ *
+ * The `_derive_from_key` and `_derive_batch` functions also exist as
+ * `crypto_kdf_blake2b_*`.
+ */
+CRYPTO_KDF_DEF(crypto_kdf)
+CRYPTO_KDF_DEF(crypto_kdf_blake2b)
+
+/**
+ * HKDF, RFC 5869, over the HMAC state functions of libsodium
+ *
+ * HASH is a traits struct with the HMAC state type, its init, update and
+ * final functions and its output size.
+ */
+struct HkdfSha256 {
+    typedef crypto_auth_hmacsha256_state State;
+    static constexpr size_t BYTES = crypto_auth_hmacsha256_BYTES;
+    static int Init(State* s, const unsigned char* k, size_t klen) { return crypto_auth_hmacsha256_init(s, k, klen); }
+    static int Update(State* s, const unsigned char* m, size_t mlen) { return crypto_auth_hmacsha256_update(s, m, mlen); }
+    static int Final(State* s, unsigned char* out) { return crypto_auth_hmacsha256_final(s, out); }
+};
+
+struct HkdfSha512 {
+    typedef crypto_auth_hmacsha512_state State;
+    static constexpr size_t BYTES = crypto_auth_hmacsha512_BYTES;
+    static int Init(State* s, const unsigned char* k, size_t klen) { return crypto_auth_hmacsha512_init(s, k, klen); }
+    static int Update(State* s, const unsigned char* m, size_t mlen) { return crypto_auth_hmacsha512_update(s, m, mlen); }
+    static int Final(State* s, unsigned char* out) { return crypto_auth_hmacsha512_final(s, out); }
+};
+
+// PRK = HMAC(salt, ikm). No salt is the same as HASH::BYTES zeros
+template<typename HASH>
+void hkdf_extract(unsigned char* prk, const unsigned char* salt, size_t salt_size,
+                  const unsigned char* ikm, size_t ikm_size) {
+    typename HASH::State state;
+    HASH::Init(&state, salt, salt_size);
+    HASH::Update(&state, ikm, ikm_size);
+    HASH::Final(&state, prk);
+    sodium_memzero(&state, sizeof state);
+}
+
+// T(i) = HMAC(PRK, T(i - 1) | info | i). The state keyed with PRK is set up
+// once and copied for every block
+template<typename HASH>
+void hkdf_expand_keyed(unsigned char* out, size_t out_size, const typename HASH::State& keyed,
+                       const unsigned char* info, size_t info_size) {
+    typename HASH::State state;
+    unsigned char t[HASH::BYTES];
+    unsigned char counter = 0;
+
+    for(size_t offset = 0; offset < out_size; offset += HASH::BYTES) {
+        state = keyed;
+        if( counter != 0 ) {
+            HASH::Update(&state, t, sizeof t);
+        }
+        counter++;
+        HASH::Update(&state, info, info_size);
+        HASH::Update(&state, &counter, 1);
+        HASH::Final(&state, t);
+        memcpy(out + offset, t, out_size - offset < HASH::BYTES ? out_size - offset : HASH::BYTES);
+    }
+    sodium_memzero(&state, sizeof state);
+    sodium_memzero(t, sizeof t);
+}
+
+// One labelled output of an HKDF call
+struct HkdfOutput {
+    std::string info;
+    size_t length;
+};
+
+/**
+ * Read the `outputs` argument: an Array of `{ info, length }` objects,
+ * `info` a Buffer or a string. Throws and returns false when one is wrong
+ */
+template<typename HASH>
+bool hkdf_arg_outputs(Napi::Env env, Napi::Value arg, std::vector<HkdfOutput>& outputs, size_t& total) {
+    if( !arg.IsArray() ) {
+        sodium_throw(env, "argument outputs must be an array of { info, length } objects");
+        return false;
+    }
+    Napi::Array array = arg.As<Napi::Array>();
+    total = 0;
+    for(uint32_t i = 0; i < array.Length(); i++) {
+        Napi::Value item = array.Get(i);
+        std::string index = "outputs[" + std::to_string(i) + "]";
+        if( !item.IsObject() || item.IsArray() ) {
+            sodium_throw(env, "argument " + index + " must be an { info, length } object");
+            return false;
+        }
+        Napi::Object output = item.As<Napi::Object>();
+        HkdfOutput o;
+
+        Napi::Value info = output.Get("info");
+        unsigned char* bytes = NULL;
+        size_t size = 0;
+        if( info.IsString() ) {
+            o.info = info.As<Napi::String>().Utf8Value();
+        } else if( sodium_arg_bytes(info, bytes, size) ) {
+            o.info.assign((const char*) bytes, size);
+        } else if( !info.IsUndefined() ) {
+            sodium_throw(env, "argument " + index + ".info must be a buffer or a string");
+            return false;
+        }
+
+        Napi::Value length = output.Get("length");
+        if( !length.IsNumber() || !(length.As<Napi::Number>().DoubleValue() >= 1) ||
+            length.As<Napi::Number>().DoubleValue() > 255.0 * HASH::BYTES ) {
+            sodium_throw(env, "argument " + index + ".length must be between 1 and " +
+                              std::to_string(255 * HASH::BYTES));
+            return false;
+        }
+        o.length = (size_t) length.As<Napi::Number>().DoubleValue();
+        total += o.length;
+        outputs.push_back(o);
+    }
+    return true;
+}
+
+// Extract, then expand every output back to back into `out`
+template<typename HASH>
+void hkdf_derive(unsigned char* out, const unsigned char* salt, size_t salt_size,
+                 const unsigned char* ikm, size_t ikm_size, const std::vector<HkdfOutput>& outputs) {
+    unsigned char prk[HASH::BYTES];
+    typename HASH::State keyed;
+
+    hkdf_extract<HASH>(prk, salt, salt_size, ikm, ikm_size);
+    HASH::Init(&keyed, prk, sizeof prk);
+    for(const HkdfOutput& o : outputs) {
+        hkdf_expand_keyed<HASH>(out, o.length, keyed, (const unsigned char*) o.info.data(), o.info.size());
+        out += o.length;
+    }
+    sodium_memzero(prk, sizeof prk);
+    sodium_memzero(&keyed, sizeof keyed);
+}
+
+#define CRYPTO_KDF_HKDF_DEF(NAME, HASH) \
+    NAPI_METHOD(crypto_kdf_hkdf_ ## NAME ## _extract) { \
+        Napi::Env env = info.Env(); \
+        ARGS(2, "arguments ikm and salt are required"); \
+        ARG_TO_UCHAR_BUFFER(ikm); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(salt); \
+        NEW_BUFFER_AND_PTR(prk, HASH::BYTES); \
+        hkdf_extract<HASH>(prk_ptr, salt, salt_size, ikm, ikm_size); \
+        return prk; \
+    } \
+    NAPI_METHOD(crypto_kdf_hkdf_ ## NAME ## _expand) { \
+        Napi::Env env = info.Env(); \
+        ARGS(3, "arguments prk, info and length are required"); \
+        ARG_TO_UCHAR_BUFFER_LEN(prk, HASH::BYTES); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ctx); \
+        ARG_TO_NUMBER(length); \
+        if( length < 1 || length > 255 * HASH::BYTES ) { \
+            THROW_ERROR("argument length must be between 1 and 255 * crypto_auth_hmac" #NAME "_BYTES"); \
+        } \
+        NEW_BUFFER_AND_PTR(okm, length); \
+        HASH::State keyed; \
+        HASH::Init(&keyed, prk, HASH::BYTES); \
+        hkdf_expand_keyed<HASH>(okm_ptr, length, keyed, ctx, ctx_size); \
+        sodium_memzero(&keyed, sizeof keyed); \
+        return okm; \
+    } \
+    NAPI_METHOD(crypto_kdf_hkdf_ ## NAME) { \
+        Napi::Env env = info.Env(); \
+        ARGS(3, "arguments ikm, salt and outputs are required"); \
+        ARG_TO_UCHAR_BUFFER(ikm); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(salt); \
+        std::vector<HkdfOutput> outputs; \
+        size_t total = 0; \
+        if( !hkdf_arg_outputs<HASH>(env, info[_arg++], outputs, total) ) { \
+            return NAPI_NULL; \
+        } \
+        NEW_BUFFER_AND_PTR(okm, total); \
+        hkdf_derive<HASH>(okm_ptr, salt, salt_size, ikm, ikm_size, outputs); \
+        return okm; \
+    } \
+    NAPI_METHOD(crypto_kdf_hkdf_ ## NAME ## _batch) { \
+        Napi::Env env = info.Env(); \
+        ARGS(3, "arguments ikm, salts and outputs are required"); \
+        ARG_TO_UCHAR_BUFFER(ikm); \
+        size_t count = SODIUM_BATCH_ANY; \
+        std::vector<SodiumSpan> salts; \
+        if( !sodium_batch_arg(env, info[_arg++], "salts", count, 0, false, salts) ) { \
+            return NAPI_NULL; \
+        } \
+        std::vector<HkdfOutput> outputs; \
+        size_t total = 0; \
+        if( !hkdf_arg_outputs<HASH>(env, info[_arg++], outputs, total) ) { \
+            return NAPI_NULL; \
+        } \
+        size_t threads = 1; \
+        if( info.Length() > 3 && !info[3].IsUndefined() ) { \
+            ARG_TO_NUMBER(nthreads); \
+            threads = nthreads; \
+        } \
+        NEW_BUFFER_AND_PTR(okm, count * total); \
+        sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) { \
+            for(size_t i = begin; i < end; i++) { \
+                hkdf_derive<HASH>(okm_ptr + i * total, salts[i].data, salts[i].size, ikm, ikm_size, outputs); \
+            } \
+        }); \
+        return okm; \
+    }
+
+/**
+ * crypto_kdf_hkdf_sha256:
+ * HKDF extract and expand (RFC 5869) with HMAC-SHA-256, several outputs in
+ * one call
+ *
+ *     var keys = sodium.crypto_kdf_hkdf_sha256(
+ *                    ikm,
+ *                    salt,
+ *                    outputs);
+ *
+ * ~ ikm (Buffer): input key material, such as a `crypto_kx` shared secret
+ * ~ salt (Buffer): optional salt, or null
+ * ~ outputs (Array): `{ info, length }` objects, one per key to derive.
+ *   `info` is a Buffer or a string, `length` at most
+ *   `255 * crypto_auth_hmacsha256_BYTES`
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: the outputs back to back, in the order given. The pseudo random
+ *   key is extracted once and keyed into HMAC once for all of them
+ *
+ *     var okm = sodium.crypto_kdf_hkdf_sha256(shared, salt, [
+ *         { info: 'client write key', length: 32 },
+ *         { info: 'server write key', length: 32 },
+ *         { info: 'client write iv', length: 12 }
+ *     ]);
+ *     var clientKey = okm.slice(0, 32);
+ *
+ * `crypto_kdf_hkdf_sha256_extract(ikm, salt)` and
+ * `crypto_kdf_hkdf_sha256_expand(prk, info, length)` are the two steps on
+ * their own.
+ */
+
+/**
+ * crypto_kdf_hkdf_sha256_batch:
+ * The same outputs for many salts
+ *
+ *     var okm = sodium.crypto_kdf_hkdf_sha256_batch(
+ *                   ikm,
+ *                   salts,
+ *                   outputs,
+ *                   [threads]);
+ *
+ * ~ salts (Array): Buffers, one per derivation
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   The call still blocks
+ * ~ ikm, outputs: as in `crypto_kdf_hkdf_sha256`
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: the outputs of each salt back to back, salt `i` at
+ *   `i * total`, `total` being the sum of the output lengths
+ *
+ * Every function also exists as `crypto_kdf_hkdf_sha512*`.
+ */
+CRYPTO_KDF_HKDF_DEF(sha256, HkdfSha256)
+CRYPTO_KDF_HKDF_DEF(sha512, HkdfSha512)
+
+#define CRYPTO_KDF_HKDF_EXPORT(NAME) \
+    EXPORT(crypto_kdf_hkdf_ ## NAME ## _extract); \
+    EXPORT(crypto_kdf_hkdf_ ## NAME ## _expand); \
+    EXPORT(crypto_kdf_hkdf_ ## NAME); \
+    EXPORT(crypto_kdf_hkdf_ ## NAME ## _batch)
+
+NAPI_METHOD_FROM_STRING(crypto_kdf_primitive)
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_kdf(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_kdf_keygen);
+    EXPORT(crypto_kdf_primitive);
+    EXPORT_STRING(crypto_kdf_PRIMITIVE);
+
+    CRYPTO_KDF_EXPORT(crypto_kdf);
+    CRYPTO_KDF_EXPORT(crypto_kdf_blake2b);
+    CRYPTO_KDF_HKDF_EXPORT(sha256);
+    CRYPTO_KDF_HKDF_EXPORT(sha512);
+}
@@ -0,0 +1,398 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "sodium_memory.h"
+
+/**
+ * KdfTree:
+ * Keys derived along paths, with the inner nodes of the tree cached
+ *
+ * A key for `tenant / project / object` is derived one level at a time,
+ * each node key being the keyed BLAKE2b of its label under its parent key:
+ *
+ *     node(root, [])         = masterKey
+ *     node(root, path + [l]) = crypto_generichash(32, l, node(root, path))
+ *
+ * and the leaf is the same hash with `bytes` of output. Done by hand, every
+ * object pays a hash per level. A KdfTree keeps the inner node keys it
+ * derives in a bounded LRU cache in secure memory, so once the parent of a
+ * leaf is cached a new leaf costs one hash. The results are the same as
+ * chaining `crypto_generichash` calls, cached or not.
+ *
+ *    var tree = new sodium.KdfTree(masterKey, [options]);
+ *
+ * ~ masterKey (Buffer): `crypto_generichash_KEYBYTES_MIN` to `_MAX` bytes.
+ *   The tree keeps its own copy
+ * ~ options.capacity (Number): inner node keys to keep, 4096 by default.
+ *   0 caches nothing
+ * ~ options.bytes (Number): leaf key length, `crypto_generichash_BYTES` by
+ *   default, between `crypto_generichash_BYTES_MIN` and `_MAX`
+ *
+ * A path is an array of 1 to KDF_TREE_MAX_DEPTH labels, Buffers or strings
+ * in UTF-8. Cached nodes are found by their path, which is kept in ordinary
+ * memory: labels should name things, not be secrets. Node keys sit in one
+ * `sodium_malloc` block and are wiped when evicted.
+ *
+ * Methods:
+ *
+ * ~ derive(path): the leaf key of `path`
+ * ~ deriveBatch(paths, [threads]): the leaf keys of an array of paths, back
+ *   to back in one Buffer. `threads` splits the batch across that many
+ *   threads, which share the cache; the call still blocks
+ * ~ stats(): `{ size, capacity, hits, derived, evictions }`. `hits` counts
+ *   leaves whose parent was cached, `derived` the inner node keys computed
+ * ~ clear(): wipe the cached node keys
+ * ~ dispose(): wipe and free the master key and the cache. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var tree = new sodium.KdfTree(masterKey, { capacity: 100000 });
+ *     var k = tree.derive(['acme', 'billing', 'invoice-42']);
+ *     var keys = tree.deriveBatch(objects.map(function(o) {
+ *         return [o.tenant, o.project, o.id];
+ *     }), 4);
+ */
+
+#define KDF_TREE_MAX_DEPTH 32
+#define KDF_TREE_DEFAULT_CAPACITY 4096
+#define KDF_TREE_NODEBYTES crypto_generichash_BYTES
+
+struct KdfTreeNode {
+    std::string id;
+    size_t slot;
+};
+
+class KdfTree : public Napi::ObjectWrap<KdfTree> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "KdfTree", {
+            InstanceMethod("derive", &KdfTree::Derive),
+            InstanceMethod("deriveBatch", &KdfTree::DeriveBatch),
+            InstanceMethod("stats", &KdfTree::Stats),
+            InstanceMethod("clear", &KdfTree::Clear),
+            InstanceMethod("dispose", &KdfTree::Dispose)
+        });
+        exports.Set(Napi::String::New(env, "KdfTree"), ctor);
+    }
+
+    KdfTree(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<KdfTree>(info), root(NULL), root_size(0), bytes(crypto_generichash_BYTES),
+          slab(NULL), capacity(KDF_TREE_DEFAULT_CAPACITY), hits(0), derived(0), evictions(0) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() < 1 || !sodium_arg_bytes(info[0], key, key_size) ) {
+            Napi::TypeError::New(env, "argument masterKey must be a buffer").ThrowAsJavaScriptException();
+            return;
+        }
+        if( key_size < crypto_generichash_KEYBYTES_MIN || key_size > crypto_generichash_KEYBYTES_MAX ) {
+            Napi::Error::New(env, "argument masterKey must be between crypto_generichash_KEYBYTES_MIN and crypto_generichash_KEYBYTES_MAX bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( info.Length() > 1 && info[1].IsObject() ) {
+            Napi::Object options = info[1].As<Napi::Object>();
+            Napi::Value c = options.Get("capacity");
+            if( !c.IsUndefined() ) {
+                double v = c.IsNumber() ? c.As<Napi::Number>().DoubleValue() : -1;
+                if( !(v >= 0 && v <= SODIUM_MAX_SAFE_INTEGER) ) {
+                    Napi::TypeError::New(env, "options.capacity must be a number of nodes").ThrowAsJavaScriptException();
+                    return;
+                }
+                capacity = (size_t) v;
+            }
+            Napi::Value b = options.Get("bytes");
+            if( !b.IsUndefined() ) {
+                double v = b.IsNumber() ? b.As<Napi::Number>().DoubleValue() : 0;
+                if( !(v >= crypto_generichash_BYTES_MIN && v <= crypto_generichash_BYTES_MAX) ) {
+                    Napi::Error::New(env, "options.bytes must be between crypto_generichash_BYTES_MIN and crypto_generichash_BYTES_MAX").ThrowAsJavaScriptException();
+                    return;
+                }
+                bytes = (size_t) v;
+            }
+        }
+
+        root = (unsigned char*) sodium_secret_alloc(env, key_size);
+        if( root == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        root_size = key_size;
+        memcpy(root, key, key_size);
+        sodium_secret_readonly(root);
+
+        if( capacity > 0 ) {
+            slab = (unsigned char*) sodium_secret_alloc(env, capacity * KDF_TREE_NODEBYTES);
+            if( slab == NULL ) {
+                Free();
+                Napi::Error::New(env, "cannot allocate secure memory for the node cache").ThrowAsJavaScriptException();
+                return;
+            }
+            free_slots.reserve(capacity);
+            for(size_t i = capacity; i > 0; i--) {
+                free_slots.push_back(i - 1);
+            }
+        }
+    }
+
+    ~KdfTree() {
+        Free();
+    }
+
+private:
+    void Free() {
+        std::lock_guard<std::mutex> guard(lock);
+        if( root != NULL ) {
+            sodium_secret_free(Env(), root, root_size);
+            root = NULL;
+        }
+        if( slab != NULL ) {
+            sodium_secret_free(Env(), slab, capacity * KDF_TREE_NODEBYTES);
+            slab = NULL;
+        }
+        lru.clear();
+        index.clear();
+        free_slots.clear();
+    }
+
+    unsigned char* Slot(size_t slot) {
+        return slab + slot * KDF_TREE_NODEBYTES;
+    }
+
+    // Caller holds `lock`
+    void Insert(const std::string& id, const unsigned char* key) {
+        if( slab == NULL || index.count(id) != 0 ) {
+            return;
+        }
+        if( free_slots.empty() ) {
+            auto last = std::prev(lru.end());
+            sodium_memzero(Slot(last->slot), KDF_TREE_NODEBYTES);
+            free_slots.push_back(last->slot);
+            index.erase(last->id);
+            lru.erase(last);
+            evictions++;
+        }
+        size_t slot = free_slots.back();
+        free_slots.pop_back();
+        memcpy(Slot(slot), key, KDF_TREE_NODEBYTES);
+        lru.push_front(KdfTreeNode{ id, slot });
+        index[id] = lru.begin();
+    }
+
+    /**
+     * Leaf key of `path` into `out`. Starts from the deepest cached node on
+     * the path, or the root, and caches the inner nodes it derives. Hashes
+     * run without the lock, so batch threads only wait on lookups
+     */
+    void Leaf(const std::vector<SodiumSpan>& path, unsigned char* out) {
+        size_t depth = path.size();
+
+        // Node ids: each label as a 4 byte length then its bytes
+        std::string id;
+        size_t ends[KDF_TREE_MAX_DEPTH];
+        for(size_t d = 0; d + 1 < depth; d++) {
+            uint32_t n = (uint32_t) path[d].size;
+            id.append((const char*) &n, sizeof n);
+            id.append((const char*) path[d].data, path[d].size);
+            ends[d] = id.size();
+        }
+
+        unsigned char key[KDF_TREE_NODEBYTES];
+        const unsigned char* k = root;
+        size_t k_size = root_size;
+        size_t from = 0;
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            for(size_t d = depth - 1; d > 0 && slab != NULL; d--) {
+                auto found = index.find(id.substr(0, ends[d - 1]));
+                if( found != index.end() ) {
+                    auto it = found->second;
+                    lru.splice(lru.begin(), lru, it);
+                    memcpy(key, Slot(it->slot), KDF_TREE_NODEBYTES);
+                    k = key;
+                    k_size = KDF_TREE_NODEBYTES;
+                    from = d;
+                    if( d == depth - 1 ) {
+                        hits++;
+                    }
+                    break;
+                }
+            }
+        }
+
+        unsigned char next[KDF_TREE_NODEBYTES];
+        for(size_t d = from; d + 1 < depth; d++) {
+            crypto_generichash(next, KDF_TREE_NODEBYTES, path[d].data, path[d].size, k, k_size);
+            memcpy(key, next, KDF_TREE_NODEBYTES);
+            k = key;
+            k_size = KDF_TREE_NODEBYTES;
+
+            std::lock_guard<std::mutex> guard(lock);
+            derived++;
+            Insert(id.substr(0, ends[d]), key);
+        }
+        crypto_generichash(out, bytes, path[depth - 1].data, path[depth - 1].size, k, k_size);
+
+        sodium_memzero(key, sizeof key);
+        sodium_memzero(next, sizeof next);
+    }
+
+    // Read `value` as a path into `path`, strings converted into `strings`.
+    // Returns an empty string, or the error
+    std::string ReadPath(Napi::Value value, std::vector<SodiumSpan>& path, std::deque<std::string>& strings) {
+        if( !value.IsArray() ) {
+            return "a path must be an array of labels";
+        }
+        Napi::Array labels = value.As<Napi::Array>();
+        if( labels.Length() == 0 || labels.Length() > KDF_TREE_MAX_DEPTH ) {
+            return "a path must have 1 to " + std::to_string(KDF_TREE_MAX_DEPTH) + " labels";
+        }
+        path.resize(labels.Length());
+        for(uint32_t i = 0; i < labels.Length(); i++) {
+            Napi::Value label = labels.Get(i);
+            if( label.IsString() ) {
+                strings.push_back(label.As<Napi::String>().Utf8Value());
+                path[i].data = (const unsigned char*) strings.back().data();
+                path[i].size = strings.back().size();
+            } else {
+                unsigned char* data = NULL;
+                if( !sodium_arg_bytes(label, data, path[i].size) ) {
+                    return "labels must be buffers or strings";
+                }
+                path[i].data = data;
+            }
+            if( path[i].size > UINT32_MAX ) {
+                return "labels must be shorter than 4GB";
+            }
+        }
+        return "";
+    }
+
+#define CHECK_CONTEXT() \
+    if( root == NULL ) { \
+        THROW_ERROR("KdfTree was disposed"); \
+    }
+
+    Napi::Value Derive(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument path must be an array of labels");
+        std::vector<SodiumSpan> path;
+        std::deque<std::string> strings;
+        std::string error = ReadPath(info[0], path, strings);
+        if( !error.empty() ) {
+            THROW_ERROR(error);
+        }
+
+        NEW_BUFFER_AND_PTR(leaf, bytes);
+        Leaf(path, leaf_ptr);
+        return leaf;
+    }
+
+    Napi::Value DeriveBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument paths must be an array of paths");
+        if( !info[0].IsArray() ) {
+            THROW_ERROR("argument paths must be an array of paths");
+        }
+        Napi::Array list = info[0].As<Napi::Array>();
+        size_t threads = 1;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            _arg = 1;
+            ARG_TO_NUMBER(nthreads);
+            threads = nthreads;
+        }
+
+        std::vector<std::vector<SodiumSpan>> paths(list.Length());
+        std::deque<std::string> strings;
+        for(uint32_t i = 0; i < list.Length(); i++) {
+            std::string error = ReadPath(list.Get(i), paths[i], strings);
+            if( !error.empty() ) {
+                THROW_ERROR("paths[" + std::to_string(i) + "]: " + error);
+            }
+        }
+
+        NEW_BUFFER_AND_PTR(leaves, paths.size() * bytes);
+        sodium_batch_parallel(paths.size(), threads, 64, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                Leaf(paths[i], leaves_ptr + i * bytes);
+            }
+        });
+        return leaves;
+    }
+
+    Napi::Value Stats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        std::lock_guard<std::mutex> guard(lock);
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("size", Napi::Number::New(env, (double) lru.size()));
+        stats.Set("capacity", Napi::Number::New(env, (double) capacity));
+        stats.Set("hits", Napi::Number::New(env, hits));
+        stats.Set("derived", Napi::Number::New(env, derived));
+        stats.Set("evictions", Napi::Number::New(env, evictions));
+        return stats;
+    }
+
+    Napi::Value Clear(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        std::lock_guard<std::mutex> guard(lock);
+        for(const KdfTreeNode& node : lru) {
+            sodium_memzero(Slot(node.slot), KDF_TREE_NODEBYTES);
+            free_slots.push_back(node.slot);
+        }
+        lru.clear();
+        index.clear();
+        return env.Undefined();
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    unsigned char* root;
+    size_t root_size;
+    size_t bytes;
+
+    // Node cache, most recent first. `lock` guards it and the counters
+    std::mutex lock;
+    std::list<KdfTreeNode> lru;
+    std::unordered_map<std::string, std::list<KdfTreeNode>::iterator> index;
+    std::vector<size_t> free_slots;
+    unsigned char* slab;
+    size_t capacity;
+    double hits;
+    double derived;
+    double evictions;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_kdf_tree(Napi::Env env, Napi::Object exports) {
+    KdfTree::Init(env, exports);
+}
@@ -0,0 +1,311 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#include "node_sodium.h"
+#include "crypto_keypair_pool.h"
+#include "sodium_memory.h"
+
+/**
+ * Key pair pool
+ *
+ * `crypto_box_seal` and every handshake need a fresh key pair, and making
+ * one costs a fixed base scalar multiplication, most of the time of a short
+ * seal. When enabled, a background thread keeps a stock of X25519 and,
+ * optionally, Ed25519 key pairs, and these calls take one instead:
+ *
+ * ~ crypto_box_seal, crypto_box_seal_async and crypto_box_seal_batch, for
+ *   the ephemeral key
+ * ~ crypto_box_keypair and crypto_kx_keypair
+ * ~ crypto_sign_keypair and crypto_sign_ed25519_keypair
+ *
+ * Key pairs are stored in `sodium_malloc` memory and each one is wiped as it
+ * is taken, so none is ever handed out twice. The thread refills a stock
+ * once it falls below half its capacity. When a stock is empty the key pair
+ * is generated on the spot, as it would be without the pool.
+ */
+
+struct KeypairStock {
+    size_t pk_size;
+    size_t sk_size;
+    size_t capacity = 0;
+    size_t size = 0;
+    unsigned char* pairs = NULL;    // capacity entries of pk followed by sk
+
+    double taken = 0;
+    double misses = 0;
+
+    KeypairStock(size_t pk_size, size_t sk_size) : pk_size(pk_size), sk_size(sk_size) {}
+
+    size_t EntrySize() const { return pk_size + sk_size; }
+    bool Low() const { return capacity > 0 && size < (capacity + 1) / 2; }
+};
+
+struct KeypairPool {
+    std::mutex lock;
+    std::condition_variable wake;
+
+    // Bumped by every enable and disable; a refill thread exits once the
+    // generation it was started for is over
+    size_t generation = 0;
+    double generated = 0;
+
+    KeypairStock stocks[2] = {
+        KeypairStock(crypto_box_PUBLICKEYBYTES, crypto_box_SECRETKEYBYTES),
+        KeypairStock(crypto_sign_ed25519_PUBLICKEYBYTES, crypto_sign_ed25519_SECRETKEYBYTES)
+    };
+};
+
+// Never destroyed: the refill thread is detached and may still be waiting on
+// the condition variable while the process exits
+static KeypairPool& keypair_pool = *new KeypairPool();
+
+static int keypair_generate(KeypairPoolKind kind, unsigned char* pk, unsigned char* sk) {
+    if( kind == KEYPAIR_POOL_ED25519 ) {
+        return crypto_sign_ed25519_keypair(pk, sk);
+    }
+    return crypto_box_keypair(pk, sk);
+}
+
+// Wipe and free both stocks. Called with the lock held
+static void keypair_pool_reset() {
+    for(KeypairStock& stock : keypair_pool.stocks) {
+        if( stock.pairs != NULL ) {
+            sodium_free(stock.pairs);
+        }
+        stock.pairs = NULL;
+        stock.capacity = stock.size = 0;
+        stock.taken = stock.misses = 0;
+    }
+    keypair_pool.generated = 0;
+}
+
+static void keypair_pool_thread(size_t generation) {
+    unsigned char pair[crypto_sign_ed25519_PUBLICKEYBYTES + crypto_sign_ed25519_SECRETKEYBYTES];
+
+    std::unique_lock<std::mutex> guard(keypair_pool.lock);
+    for(;;) {
+        keypair_pool.wake.wait(guard, [=] {
+            return keypair_pool.generation != generation ||
+                   keypair_pool.stocks[KEYPAIR_POOL_X25519].Low() ||
+                   keypair_pool.stocks[KEYPAIR_POOL_ED25519].Low();
+        });
+        if( keypair_pool.generation != generation ) {
+            break;
+        }
+
+        // Refill the low stock up to capacity, one pair at a time so takers
+        // never wait for more than a single append
+        KeypairPoolKind kind = keypair_pool.stocks[KEYPAIR_POOL_X25519].Low() ?
+                               KEYPAIR_POOL_X25519 : KEYPAIR_POOL_ED25519;
+        for(;;) {
+            KeypairStock& stock = keypair_pool.stocks[kind];
+            if( keypair_pool.generation != generation || stock.size >= stock.capacity ) {
+                break;
+            }
+            size_t pk_size = stock.pk_size;
+
+            guard.unlock();
+            int rc = keypair_generate(kind, pair, pair + pk_size);
+            guard.lock();
+
+            if( rc != 0 || keypair_pool.generation != generation || stock.size >= stock.capacity ) {
+                continue;
+            }
+            memcpy(stock.pairs + stock.size * stock.EntrySize(), pair, stock.EntrySize());
+            stock.size++;
+            keypair_pool.generated++;
+        }
+        sodium_memzero(pair, sizeof pair);
+    }
+}
+
+int keypair_pool_take(KeypairPoolKind kind, unsigned char* pk, unsigned char* sk) {
+    std::unique_lock<std::mutex> guard(keypair_pool.lock);
+    KeypairStock& stock = keypair_pool.stocks[kind];
+
+    if( stock.size == 0 ) {
+        if( stock.capacity > 0 ) {
+            stock.misses++;
+        }
+        guard.unlock();
+        return keypair_generate(kind, pk, sk);
+    }
+
+    stock.size--;
+    stock.taken++;
+    unsigned char* entry = stock.pairs + stock.size * stock.EntrySize();
+    memcpy(pk, entry, stock.pk_size);
+    memcpy(sk, entry + stock.pk_size, stock.sk_size);
+    sodium_memzero(entry, stock.EntrySize());
+
+    bool low = stock.Low();
+    guard.unlock();
+    if( low ) {
+        keypair_pool.wake.notify_one();
+    }
+    return 0;
+}
+
+int keypair_pool_box_seal(unsigned char* c, const unsigned char* m,
+                          unsigned long long mlen, const unsigned char* pk) {
+    unsigned char nonce[crypto_box_NONCEBYTES];
+    unsigned char esk[crypto_box_SECRETKEYBYTES];
+    crypto_generichash_state st;
+
+    // The ephemeral public key goes first, as in crypto_box_seal
+    if( keypair_pool_take(KEYPAIR_POOL_X25519, c, esk) != 0 ) {
+        return -1;
+    }
+    crypto_generichash_init(&st, NULL, 0U, crypto_box_NONCEBYTES);
+    crypto_generichash_update(&st, c, crypto_box_PUBLICKEYBYTES);
+    crypto_generichash_update(&st, pk, crypto_box_PUBLICKEYBYTES);
+    crypto_generichash_final(&st, nonce, crypto_box_NONCEBYTES);
+
+    int ret = crypto_box_easy(c + crypto_box_PUBLICKEYBYTES, m, mlen, nonce, pk, esk);
+    sodium_memzero(esk, sizeof esk);
+    sodium_memzero(nonce, sizeof nonce);
+    return ret;
+}
+
+/**
+ * crypto_keypair_pool_enable:
+ * Turn the key pair pool on, or resize it
+ *
+ *     sodium.crypto_keypair_pool_enable(x25519, [ed25519]);
+ *
+ * ~ x25519 (Number): X25519 key pairs to keep ready, for sealed boxes and
+ *   handshakes
+ * ~ ed25519 (Number): optional, Ed25519 key pairs to keep ready. 0, the
+ *   default, generates them on demand
+ *
+ * Stocks are refilled by a background thread. Enabling an enabled pool
+ * wipes the stocks and starts over. Counters are reset.
+ */
+NAPI_METHOD(crypto_keypair_pool_enable) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument x25519 must be a number");
+    ARG_TO_NUMBER(x25519);
+    size_t ed25519 = 0;
+    if( info.Length() > 1 && !info[1].IsUndefined() ) {
+        ARG_TO_NUMBER(ed25519_count);
+        ed25519 = ed25519_count;
+    }
+
+    std::unique_lock<std::mutex> guard(keypair_pool.lock);
+    keypair_pool_reset();
+    keypair_pool.generation++;
+
+    size_t capacities[2] = { (size_t) x25519, ed25519 };
+    for(size_t i = 0; i < 2; i++) {
+        KeypairStock& stock = keypair_pool.stocks[i];
+        if( capacities[i] == 0 ) {
+            continue;
+        }
+        if( capacities[i] > SIZE_MAX / stock.EntrySize() ) {
+            keypair_pool_reset();
+            guard.unlock();
+            keypair_pool.wake.notify_all();
+            THROW_ERROR("key pair pool capacity is too large");
+        }
+        stock.pairs = (unsigned char*) sodium_malloc(capacities[i] * stock.EntrySize());
+        if( stock.pairs == NULL ) {
+            keypair_pool_reset();
+            guard.unlock();
+            keypair_pool.wake.notify_all();
+            THROW_ERROR("cannot allocate secure memory for the key pair pool");
+        }
+        stock.capacity = capacities[i];
+    }
+
+    if( keypair_pool.stocks[KEYPAIR_POOL_X25519].capacity > 0 ||
+        keypair_pool.stocks[KEYPAIR_POOL_ED25519].capacity > 0 ) {
+        std::thread(keypair_pool_thread, keypair_pool.generation).detach();
+    }
+    guard.unlock();
+    keypair_pool.wake.notify_all();
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_keypair_pool_disable:
+ * Stop the refill thread and wipe every pooled key pair
+ */
+NAPI_METHOD(crypto_keypair_pool_disable) {
+    Napi::Env env = info.Env();
+
+    {
+        std::lock_guard<std::mutex> guard(keypair_pool.lock);
+        keypair_pool_reset();
+        keypair_pool.generation++;
+    }
+    keypair_pool.wake.notify_all();
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_keypair_pool_stats:
+ * Pool counters
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ enabled, generated, x25519, ed25519 }`. `generated` counts
+ *   key pairs made by the refill thread. `x25519` and `ed25519` are
+ *   `{ capacity, size, taken, misses }`, where `misses` counts key pairs
+ *   generated on the spot because the stock was empty
+ */
+NAPI_METHOD(crypto_keypair_pool_stats) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> guard(keypair_pool.lock);
+    Napi::Object result = Napi::Object::New(env);
+    bool enabled = false;
+    const char* names[2] = { "x25519", "ed25519" };
+
+    for(size_t i = 0; i < 2; i++) {
+        KeypairStock& stock = keypair_pool.stocks[i];
+        enabled = enabled || stock.capacity > 0;
+
+        Napi::Object counts = Napi::Object::New(env);
+        counts.Set(Napi::String::New(env, "capacity"), Napi::Number::New(env, (double) stock.capacity));
+        counts.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double) stock.size));
+        counts.Set(Napi::String::New(env, "taken"), Napi::Number::New(env, stock.taken));
+        counts.Set(Napi::String::New(env, "misses"), Napi::Number::New(env, stock.misses));
+        result.Set(Napi::String::New(env, names[i]), counts);
+    }
+    result.Set(Napi::String::New(env, "enabled"), Napi::Boolean::New(env, enabled));
+    result.Set(Napi::String::New(env, "generated"), Napi::Number::New(env, keypair_pool.generated));
+    return result;
+}
+
+// See sodium_memory_usage
+size_t crypto_keypair_pool_memory() {
+    std::lock_guard<std::mutex> lock(keypair_pool.lock);
+    size_t bytes = 0;
+    for(const KeypairStock& stock : keypair_pool.stocks) {
+        if( stock.pairs != NULL ) {
+            bytes += sodium_secure_footprint(stock.capacity * stock.EntrySize());
+        }
+    }
+    return bytes;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_keypair_pool(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_keypair_pool_enable);
+    EXPORT(crypto_keypair_pool_disable);
+    EXPORT(crypto_keypair_pool_stats);
+}
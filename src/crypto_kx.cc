@@ -0,0 +1,185 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+#include "crypto_keypair_pool.h"
+
+/**
+ * Return `{ rx, tx }` as two views on one `2 * crypto_kx_SESSIONKEYBYTES`
+ * buffer, rx first, so a handshake allocates a single Buffer.
+ */
+static Napi::Value kx_session_keys(Napi::Env env, Napi::Buffer<unsigned char> keys) {
+    Napi::Function subarray = keys.Get("subarray").As<Napi::Function>();
+    Napi::Number start = Napi::Number::New(env, 0);
+    Napi::Number middle = Napi::Number::New(env, crypto_kx_SESSIONKEYBYTES);
+    Napi::Number end = Napi::Number::New(env, 2 * crypto_kx_SESSIONKEYBYTES);
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "rx"), subarray.Call(keys, { start, middle }));
+    result.Set(Napi::String::New(env, "tx"), subarray.Call(keys, { middle, end }));
+    return result;
+}
+
+/**
+ * crypto_kx_keypair:
+ * Generate a key exchange key pair
+ *
+ *     var keys = sodium.crypto_kx_keypair();
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ publicKey, secretKey }`
+ */
+NAPI_METHOD(crypto_kx_keypair) {
+    Napi::Env env = info.Env();
+
+    NEW_BUFFER_AND_PTR(pk, crypto_kx_PUBLICKEYBYTES);
+    NEW_BUFFER_AND_PTR(sk, crypto_kx_SECRETKEYBYTES);
+
+    if( keypair_pool_take(KEYPAIR_POOL_X25519, pk_ptr, sk_ptr) == 0 ) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "publicKey"), pk);
+        result.Set(Napi::String::New(env, "secretKey"), sk);
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_kx_seed_keypair:
+ * Deterministically derive a key exchange key pair from a seed
+ *
+ *     var keys = sodium.crypto_kx_seed_keypair(seed);
+ *
+ * ~ seed (Buffer): `crypto_kx_SEEDBYTES` seed
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ publicKey, secretKey }`
+ */
+NAPI_METHOD(crypto_kx_seed_keypair) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument seed must be a buffer");
+    ARG_TO_UCHAR_BUFFER_LEN(seed, crypto_kx_SEEDBYTES);
+
+    NEW_BUFFER_AND_PTR(pk, crypto_kx_PUBLICKEYBYTES);
+    NEW_BUFFER_AND_PTR(sk, crypto_kx_SECRETKEYBYTES);
+
+    if( crypto_kx_seed_keypair(pk_ptr, sk_ptr, seed) == 0 ) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "publicKey"), pk);
+        result.Set(Napi::String::New(env, "secretKey"), sk);
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_kx_client_session_keys:
+ * Compute the client's session keys
+ *
+ *     var keys = sodium.crypto_kx_client_session_keys(
+ *                    clientPublicKey,
+ *                    clientSecretKey,
+ *                    serverPublicKey);
+ *
+ * ~ clientPublicKey (Buffer): client public key, `crypto_kx_PUBLICKEYBYTES` long
+ * ~ clientSecretKey (Buffer): client secret key, `crypto_kx_SECRETKEYBYTES` long
+ * ~ serverPublicKey (Buffer): server public key, `crypto_kx_PUBLICKEYBYTES` long
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ rx, tx }`, the keys to receive from and send to the server.
+ *   Both are `crypto_kx_SESSIONKEYBYTES` long and share one allocation
+ * ~ null: if the server public key is not acceptable
+ *
+ * The client's `rx` is the server's `tx` and the other way around.
+ */
+NAPI_METHOD(crypto_kx_client_session_keys) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments clientPublicKey, clientSecretKey and serverPublicKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_LEN(clientPublicKey, crypto_kx_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(clientSecretKey, crypto_kx_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(serverPublicKey, crypto_kx_PUBLICKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(keys, 2 * crypto_kx_SESSIONKEYBYTES);
+
+    if( crypto_kx_client_session_keys(keys_ptr, keys_ptr + crypto_kx_SESSIONKEYBYTES,
+                                      clientPublicKey, clientSecretKey, serverPublicKey) == 0 ) {
+        return kx_session_keys(env, keys);
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_kx_server_session_keys:
+ * Compute the server's session keys
+ *
+ *     var keys = sodium.crypto_kx_server_session_keys(
+ *                    serverPublicKey,
+ *                    serverSecretKey,
+ *                    clientPublicKey);
+ *
+ * ~ serverPublicKey (Buffer): server public key, `crypto_kx_PUBLICKEYBYTES` long
+ * ~ serverSecretKey (Buffer): server secret key, `crypto_kx_SECRETKEYBYTES` long
+ * ~ clientPublicKey (Buffer): client public key, `crypto_kx_PUBLICKEYBYTES` long
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ rx, tx }`, as in `crypto_kx_client_session_keys`
+ * ~ null: if the client public key is not acceptable
+ */
+NAPI_METHOD(crypto_kx_server_session_keys) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments serverPublicKey, serverSecretKey and clientPublicKey must be buffers");
+    ARG_TO_UCHAR_BUFFER_LEN(serverPublicKey, crypto_kx_PUBLICKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(serverSecretKey, crypto_kx_SECRETKEYBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(clientPublicKey, crypto_kx_PUBLICKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(keys, 2 * crypto_kx_SESSIONKEYBYTES);
+
+    if( crypto_kx_server_session_keys(keys_ptr, keys_ptr + crypto_kx_SESSIONKEYBYTES,
+                                      serverPublicKey, serverSecretKey, clientPublicKey) == 0 ) {
+        return kx_session_keys(env, keys);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD_FROM_INT(crypto_kx_publickeybytes)
+NAPI_METHOD_FROM_INT(crypto_kx_secretkeybytes)
+NAPI_METHOD_FROM_INT(crypto_kx_seedbytes)
+NAPI_METHOD_FROM_INT(crypto_kx_sessionkeybytes)
+NAPI_METHOD_FROM_STRING(crypto_kx_primitive)
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_kx(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_kx_keypair);
+    EXPORT(crypto_kx_seed_keypair);
+    EXPORT(crypto_kx_client_session_keys);
+    EXPORT(crypto_kx_server_session_keys);
+
+    EXPORT_INT(crypto_kx_PUBLICKEYBYTES);
+    EXPORT_INT(crypto_kx_SECRETKEYBYTES);
+    EXPORT_INT(crypto_kx_SEEDBYTES);
+    EXPORT_INT(crypto_kx_SESSIONKEYBYTES);
+    EXPORT_STRING(crypto_kx_PRIMITIVE);
+
+    EXPORT(crypto_kx_publickeybytes);
+    EXPORT(crypto_kx_secretkeybytes);
+    EXPORT(crypto_kx_seedbytes);
+    EXPORT(crypto_kx_sessionkeybytes);
+    EXPORT(crypto_kx_primitive);
+}
@@ -0,0 +1,423 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "sodium_stats.h"
+
+/**
+ * Merkle trees over BLAKE2b.
+ *
+ * Leaves and nodes are domain separated, as in RFC 6962:
+ *
+ *     leaf = BLAKE2b(0x00 | chunk)
+ *     node = BLAKE2b(0x01 | left | right)
+ *
+ * A node without a right sibling moves up a level unchanged, so a tree of
+ * any size has the RFC 6962 root. All levels are kept in one flat array,
+ * leaves first and the root last, and each level is hashed on up to
+ * `threads` threads.
+ */
+#define crypto_merkle_BYTES crypto_generichash_blake2b_BYTES
+#define crypto_merkle_BYTES_MIN crypto_generichash_blake2b_BYTES_MIN
+#define crypto_merkle_BYTES_MAX crypto_generichash_blake2b_BYTES_MAX
+
+static void merkle_leaf_hash(unsigned char* out, size_t outlen, const unsigned char* chunk, size_t len) {
+    static const unsigned char prefix = 0x00;
+    crypto_generichash_blake2b_state state;
+    crypto_generichash_blake2b_init(&state, NULL, 0, outlen);
+    crypto_generichash_blake2b_update(&state, &prefix, 1);
+    crypto_generichash_blake2b_update(&state, chunk, len);
+    crypto_generichash_blake2b_final(&state, out, outlen);
+}
+
+static void merkle_node_hash(unsigned char* out, size_t outlen,
+                             const unsigned char* left, const unsigned char* right) {
+    static const unsigned char prefix = 0x01;
+    crypto_generichash_blake2b_state state;
+    crypto_generichash_blake2b_init(&state, NULL, 0, outlen);
+    crypto_generichash_blake2b_update(&state, &prefix, 1);
+    crypto_generichash_blake2b_update(&state, left, outlen);
+    crypto_generichash_blake2b_update(&state, right, outlen);
+    crypto_generichash_blake2b_final(&state, out, outlen);
+}
+
+/**
+ * Check that `leaf` at `index` of a `count` leaf tree hashes up to `root`
+ * with the sibling digests of `proof`, all `outlen` bytes
+ */
+static bool merkle_verify(const unsigned char* root, const unsigned char* leaf, size_t outlen,
+                          size_t index, size_t count, const unsigned char* proof, size_t proof_size) {
+    if( index >= count || proof_size % outlen != 0 ) {
+        return false;
+    }
+    unsigned char digest[crypto_merkle_BYTES_MAX];
+    memcpy(digest, leaf, outlen);
+    size_t used = 0;
+    for(size_t width = count; width > 1; width = (width + 1) / 2, index /= 2) {
+        size_t sibling = index ^ 1;
+        if( sibling >= width ) {
+            continue;
+        }
+        if( used + outlen > proof_size ) {
+            return false;
+        }
+        if( index & 1 ) {
+            merkle_node_hash(digest, outlen, proof + used, digest);
+        } else {
+            merkle_node_hash(digest, outlen, digest, proof + used);
+        }
+        used += outlen;
+    }
+    return used == proof_size && sodium_memcmp(digest, root, outlen) == 0;
+}
+
+/**
+ * MerkleTree:
+ * Merkle tree kept in native memory
+ *
+ *    var tree = new sodium.MerkleTree(leaves, [options]);
+ *
+ * ~ leaves (Buffer|Array): leaf digests back to back, or with
+ *   `options.chunkSize` the data to split into chunks of that size, the last
+ *   one shorter. An Array holds one data chunk per leaf. Chunks are hashed
+ *   with `crypto_merkle_leaf_hash`
+ * ~ options.bytes (Number): digest size, `crypto_merkle_BYTES` by default
+ * ~ options.chunkSize (Number): see `leaves`
+ * ~ options.threads (Number): hash chunks and wide levels on up to this many
+ *   threads, the call still blocks
+ *
+ * Methods:
+ *
+ * ~ leaf(index): copy of a leaf digest
+ * ~ update(index, digest), updateData(index, chunk): replace a leaf and
+ *   hash the nodes on its path to the root again
+ * ~ proof(index): the sibling digests from the leaf up to the root, back
+ *   to back, for `crypto_merkle_verify`
+ *
+ * Accessors: `root`, a copy of the root digest, `size`, the number of
+ * leaves, and `bytes`.
+ *
+ * **Sample**:
+ *
+ *     var tree = new sodium.MerkleTree(file, { chunkSize: 65536, threads: 4 });
+ *     var proof = tree.proof(7);
+ *     sodium.crypto_merkle_verify(tree.root, tree.leaf(7), 7, tree.size, proof);
+ */
+class MerkleTree : public Napi::ObjectWrap<MerkleTree> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "MerkleTree", {
+            InstanceMethod("leaf", &MerkleTree::Leaf),
+            InstanceMethod("update", &MerkleTree::Update),
+            InstanceMethod("updateData", &MerkleTree::UpdateData),
+            InstanceMethod("proof", &MerkleTree::Proof),
+            InstanceAccessor("root", &MerkleTree::Root, nullptr),
+            InstanceAccessor("size", &MerkleTree::Size, nullptr),
+            InstanceAccessor("bytes", &MerkleTree::Bytes, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "MerkleTree"), ctor);
+    }
+
+    MerkleTree(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<MerkleTree>(info), bytes(crypto_merkle_BYTES) {
+        Napi::Env env = info.Env();
+
+        size_t chunk_size = 0;
+        size_t threads = 1;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            if( !info[1].IsObject() ) {
+                Napi::TypeError::New(env, "argument options must be an object").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Object options = info[1].As<Napi::Object>();
+            if( !OptionNumber(env, options, "bytes", bytes) ||
+                !OptionNumber(env, options, "chunkSize", chunk_size) ||
+                !OptionNumber(env, options, "threads", threads) ) {
+                return;
+            }
+        }
+        if( bytes < crypto_merkle_BYTES_MIN || bytes > crypto_merkle_BYTES_MAX ) {
+            Napi::RangeError::New(env, "option bytes must be between crypto_merkle_BYTES_MIN and crypto_merkle_BYTES_MAX")
+                .ThrowAsJavaScriptException();
+            return;
+        }
+
+        unsigned char* data = NULL;
+        size_t data_size = 0;
+        if( info.Length() > 0 && info[0].IsArray() ) {
+            Napi::Array array = info[0].As<Napi::Array>();
+            std::vector<unsigned char*> chunks(array.Length());
+            std::vector<size_t> sizes(array.Length());
+            for(size_t i = 0; i < chunks.size(); i++) {
+                if( !sodium_arg_bytes(array.Get((uint32_t) i), chunks[i], sizes[i]) ) {
+                    Napi::TypeError::New(env, "argument leaves must be an array of buffers").ThrowAsJavaScriptException();
+                    return;
+                }
+            }
+            if( !Layout(env, chunks.size()) ) {
+                return;
+            }
+            sodium_batch_parallel(chunks.size(), threads, 64, [&](size_t begin, size_t end) {
+                for(size_t i = begin; i < end; i++) {
+                    merkle_leaf_hash(Node(0, i), bytes, chunks[i], sizes[i]);
+                }
+            });
+        } else if( info.Length() > 0 && sodium_arg_bytes(info[0], data, data_size) ) {
+            if( chunk_size > 0 ) {
+                if( !Layout(env, (data_size + chunk_size - 1) / chunk_size) ) {
+                    return;
+                }
+                sodium_batch_parallel(counts[0], threads, 64, [&](size_t begin, size_t end) {
+                    for(size_t i = begin; i < end; i++) {
+                        size_t offset = i * chunk_size;
+                        size_t len = data_size - offset < chunk_size ? data_size - offset : chunk_size;
+                        merkle_leaf_hash(Node(0, i), bytes, data + offset, len);
+                    }
+                });
+            } else {
+                if( data_size % bytes != 0 ) {
+                    Napi::Error::New(env, "argument leaves must be a multiple of the digest size long")
+                        .ThrowAsJavaScriptException();
+                    return;
+                }
+                if( !Layout(env, data_size / bytes) ) {
+                    return;
+                }
+                memcpy(nodes.data(), data, data_size);
+            }
+        } else {
+            Napi::TypeError::New(env, "argument leaves must be a buffer or an array of buffers").ThrowAsJavaScriptException();
+            return;
+        }
+
+        for(size_t level = 1; level < counts.size(); level++) {
+            sodium_batch_parallel(counts[level], threads, 4096, [&](size_t begin, size_t end) {
+                for(size_t i = begin; i < end; i++) {
+                    HashNode(level, i);
+                }
+            });
+        }
+        SODIUM_STAT(hash, nodes.size(), bytes, 0);
+    }
+
+private:
+    bool OptionNumber(Napi::Env env, Napi::Object options, const char* name, size_t& out) {
+        Napi::Value value = options.Get(name);
+        if( value.IsUndefined() ) {
+            return true;
+        }
+        if( !value.IsNumber() || !(value.As<Napi::Number>().DoubleValue() >= 1) ) {
+            Napi::TypeError::New(env, std::string("option ") + name + " must be a positive number")
+                .ThrowAsJavaScriptException();
+            return false;
+        }
+        out = (size_t) value.As<Napi::Number>().DoubleValue();
+        return true;
+    }
+
+    // Level widths and offsets for `leaves` leaves, and the node array
+    bool Layout(Napi::Env env, size_t leaves) {
+        if( leaves == 0 ) {
+            Napi::Error::New(env, "a Merkle tree needs at least one leaf").ThrowAsJavaScriptException();
+            return false;
+        }
+        size_t total = 0;
+        for(size_t width = leaves; ; width = (width + 1) / 2) {
+            counts.push_back(width);
+            offsets.push_back(total);
+            total += width;
+            if( width == 1 ) {
+                break;
+            }
+        }
+        nodes.resize(total * bytes);
+        return true;
+    }
+
+    unsigned char* Node(size_t level, size_t index) {
+        return nodes.data() + (offsets[level] + index) * bytes;
+    }
+
+    // Node `index` of `level` from its children one level down
+    void HashNode(size_t level, size_t index) {
+        size_t left = index * 2;
+        if( left + 1 < counts[level - 1] ) {
+            merkle_node_hash(Node(level, index), bytes, Node(level - 1, left), Node(level - 1, left + 1));
+        } else {
+            memcpy(Node(level, index), Node(level - 1, left), bytes);
+        }
+    }
+
+    void Rehash(size_t index) {
+        for(size_t level = 1; level < counts.size(); level++) {
+            index /= 2;
+            HashNode(level, index);
+        }
+    }
+
+#define ARG_TO_LEAF_INDEX(NAME) \
+    ARG_TO_NUMBER(NAME); \
+    if( NAME >= counts[0] ) { \
+        THROW_ERROR("argument index is past the last leaf"); \
+    }
+
+    Napi::Value Leaf(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        ARGS(1, "argument index is required");
+        ARG_TO_LEAF_INDEX(index);
+        NEW_BUFFER_AND_PTR(leaf, bytes);
+        memcpy(leaf_ptr, Node(0, index), bytes);
+        return leaf;
+    }
+
+    Napi::Value Update(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        ARGS(2, "arguments index and digest are required");
+        ARG_TO_LEAF_INDEX(index);
+        ARG_TO_UCHAR_BUFFER(digest);
+        if( digest_size != bytes ) {
+            THROW_ERROR("argument digest must be the tree's digest size long");
+        }
+        memcpy(Node(0, index), digest, bytes);
+        Rehash(index);
+        return env.Undefined();
+    }
+
+    Napi::Value UpdateData(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        ARGS(2, "arguments index and chunk are required");
+        ARG_TO_LEAF_INDEX(index);
+        ARG_TO_UCHAR_BUFFER(chunk);
+        merkle_leaf_hash(Node(0, index), bytes, chunk, chunk_size);
+        Rehash(index);
+        return env.Undefined();
+    }
+
+    Napi::Value Proof(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        ARGS(1, "argument index is required");
+        ARG_TO_LEAF_INDEX(index);
+        std::vector<unsigned char> proof;
+        for(size_t level = 0; level + 1 < counts.size(); level++, index /= 2) {
+            size_t sibling = index ^ 1;
+            if( sibling < counts[level] ) {
+                const unsigned char* node = Node(level, sibling);
+                proof.insert(proof.end(), node, node + bytes);
+            }
+        }
+        NEW_BUFFER_AND_PTR(out, proof.size());
+        if( proof.size() > 0 ) {
+            memcpy(out_ptr, proof.data(), proof.size());
+        }
+        return out;
+    }
+
+#undef ARG_TO_LEAF_INDEX
+
+    Napi::Value Root(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        NEW_BUFFER_AND_PTR(root, bytes);
+        memcpy(root_ptr, Node(counts.size() - 1, 0), bytes);
+        return root;
+    }
+
+    Napi::Value Size(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) counts[0]);
+    }
+
+    Napi::Value Bytes(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) bytes);
+    }
+
+    size_t bytes;
+    std::vector<size_t> counts;
+    std::vector<size_t> offsets;
+    std::vector<unsigned char> nodes;
+};
+
+/**
+ * crypto_merkle_leaf_hash(chunk, [bytes])
+ *
+ * The leaf digest of `chunk`, as MerkleTree computes it for data chunks:
+ * `bytes` (default `crypto_merkle_BYTES`) of BLAKE2b(0x00 | chunk)
+ */
+NAPI_METHOD(crypto_merkle_leaf_hash) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument chunk is required");
+    ARG_TO_UCHAR_BUFFER(chunk);
+    size_t bytes = crypto_merkle_BYTES;
+    if( info.Length() > 1 && !info[1].IsUndefined() ) {
+        ARG_TO_NUMBER(outlen);
+        bytes = outlen;
+    }
+    if( bytes < crypto_merkle_BYTES_MIN || bytes > crypto_merkle_BYTES_MAX ) {
+        THROW_ERROR("argument bytes must be between crypto_merkle_BYTES_MIN and crypto_merkle_BYTES_MAX");
+    }
+
+    NEW_BUFFER_AND_PTR(leaf, bytes);
+    merkle_leaf_hash(leaf_ptr, bytes, chunk, chunk_size);
+    return leaf;
+}
+
+/**
+ * crypto_merkle_verify(root, leaf, index, count, proof)
+ *
+ * Check an inclusion proof of `MerkleTree.proof`.
+ *
+ * Parameters:
+ *  [in] root    root digest, whose length is the digest size
+ *  [in] leaf    the leaf digest
+ *  [in] index   position of the leaf
+ *  [in] count   number of leaves in the tree
+ *  [in] proof   the sibling digests, back to back
+ *
+ * Returns true if the leaf is at `index` in the tree with this root
+ */
+NAPI_METHOD(crypto_merkle_verify) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments root, leaf, index, count, and proof are required");
+    ARG_TO_UCHAR_BUFFER(root);
+    if( root_size < crypto_merkle_BYTES_MIN || root_size > crypto_merkle_BYTES_MAX ) {
+        THROW_ERROR("argument root must be between crypto_merkle_BYTES_MIN and crypto_merkle_BYTES_MAX bytes long");
+    }
+    ARG_TO_UCHAR_BUFFER(leaf);
+    if( leaf_size != root_size ) {
+        THROW_ERROR("argument leaf must be as long as the root");
+    }
+    ARG_TO_NUMBER(index);
+    ARG_TO_NUMBER(count);
+    ARG_TO_UCHAR_BUFFER(proof);
+
+    if( merkle_verify(root, leaf, root_size, index, count, proof, proof_size) ) {
+        return NAPI_TRUE;
+    }
+    return NAPI_FALSE;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_merkle(Napi::Env env, Napi::Object exports) {
+    MerkleTree::Init(env, exports);
+
+    EXPORT(crypto_merkle_leaf_hash);
+    EXPORT(crypto_merkle_verify);
+
+    EXPORT_INT(crypto_merkle_BYTES);
+    EXPORT_INT(crypto_merkle_BYTES_MIN);
+    EXPORT_INT(crypto_merkle_BYTES_MAX);
+}
@@ -0,0 +1,644 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+#include "crypto_keypair_pool.h"
+#include "sodium_memory.h"
+
+/**
+ * Noise protocol framework, revision 34, with the 25519, ChaChaPoly and
+ * BLAKE2b functions: X25519 is `crypto_scalarmult`, ChaChaPoly is
+ * `crypto_aead_chacha20poly1305_ietf` with a 4 zero byte, 8 byte little
+ * endian counter nonce, and BLAKE2b is `crypto_generichash` with 64 byte
+ * output, used as HMAC-BLAKE2b inside HKDF.
+ */
+#define NOISE_DHLEN crypto_scalarmult_BYTES
+#define NOISE_HASHLEN 64
+#define NOISE_BLOCKLEN 128
+#define NOISE_KEYLEN crypto_aead_chacha20poly1305_ietf_KEYBYTES
+#define NOISE_TAGLEN crypto_aead_chacha20poly1305_ietf_ABYTES
+#define NOISE_MAX_MESSAGE 65535
+
+enum NoiseToken {
+    NOISE_END,
+    NOISE_E,
+    NOISE_S,
+    NOISE_EE,
+    NOISE_ES,
+    NOISE_SE,
+    NOISE_SS
+};
+
+#define NOISE_MAX_MESSAGES 3
+#define NOISE_MAX_TOKENS 5
+
+struct NoisePattern {
+    const char* name;
+
+    // Pre-message `<- s`: the initiator knows the responder's static key
+    bool responder_static_known;
+
+    // Messages in order, initiator first, each ended by NOISE_END
+    NoiseToken messages[NOISE_MAX_MESSAGES][NOISE_MAX_TOKENS];
+    size_t count;
+};
+
+static const NoisePattern noise_patterns[] = {
+    { "XX", false, {
+        { NOISE_E, NOISE_END },
+        { NOISE_E, NOISE_EE, NOISE_S, NOISE_ES, NOISE_END },
+        { NOISE_S, NOISE_SE, NOISE_END } }, 3 },
+    { "IK", true, {
+        { NOISE_E, NOISE_ES, NOISE_S, NOISE_SS, NOISE_END },
+        { NOISE_E, NOISE_EE, NOISE_SE, NOISE_END } }, 2 }
+};
+
+// Handshake state, CipherState and SymmetricState of the specification
+struct NoiseState {
+    unsigned char ck[NOISE_HASHLEN];
+    unsigned char h[NOISE_HASHLEN];
+    unsigned char k[NOISE_KEYLEN];
+    uint64_t n;
+    bool has_key;
+
+    unsigned char s_pk[NOISE_DHLEN], s_sk[NOISE_DHLEN];
+    unsigned char e_pk[NOISE_DHLEN], e_sk[NOISE_DHLEN];
+    unsigned char rs[NOISE_DHLEN], re[NOISE_DHLEN];
+    bool has_s, has_e, has_rs, has_re;
+};
+
+static void noise_hash(unsigned char* out, const unsigned char* a, size_t alen,
+                       const unsigned char* b, size_t blen) {
+    crypto_generichash_state state;
+    crypto_generichash_init(&state, NULL, 0, NOISE_HASHLEN);
+    crypto_generichash_update(&state, a, alen);
+    crypto_generichash_update(&state, b, blen);
+    crypto_generichash_final(&state, out, NOISE_HASHLEN);
+}
+
+// HMAC-BLAKE2b of `a | b` under a NOISE_HASHLEN key
+static void noise_hmac(unsigned char* out, const unsigned char* key,
+                       const unsigned char* a, size_t alen,
+                       const unsigned char* b, size_t blen) {
+    unsigned char pad[NOISE_BLOCKLEN];
+    unsigned char inner[NOISE_HASHLEN];
+    crypto_generichash_state state;
+
+    memset(pad, 0x36, sizeof pad);
+    for(size_t i = 0; i < NOISE_HASHLEN; i++) {
+        pad[i] ^= key[i];
+    }
+    crypto_generichash_init(&state, NULL, 0, NOISE_HASHLEN);
+    crypto_generichash_update(&state, pad, sizeof pad);
+    crypto_generichash_update(&state, a, alen);
+    crypto_generichash_update(&state, b, blen);
+    crypto_generichash_final(&state, inner, sizeof inner);
+
+    memset(pad, 0x5c, sizeof pad);
+    for(size_t i = 0; i < NOISE_HASHLEN; i++) {
+        pad[i] ^= key[i];
+    }
+    noise_hash(out, pad, sizeof pad, inner, sizeof inner);
+
+    sodium_memzero(pad, sizeof pad);
+    sodium_memzero(inner, sizeof inner);
+    sodium_memzero(&state, sizeof state);
+}
+
+// HKDF(ck, ikm) with two outputs, as MixKey and Split use it
+static void noise_hkdf(const unsigned char* ck, const unsigned char* ikm, size_t ikmlen,
+                       unsigned char* out1, unsigned char* out2) {
+    static const unsigned char one = 1, two = 2;
+    unsigned char temp[NOISE_HASHLEN];
+    noise_hmac(temp, ck, ikm, ikmlen, NULL, 0);
+    noise_hmac(out1, temp, &one, 1, NULL, 0);
+    noise_hmac(out2, temp, out1, NOISE_HASHLEN, &two, 1);
+    sodium_memzero(temp, sizeof temp);
+}
+
+static void noise_mix_hash(NoiseState* st, const unsigned char* data, size_t len) {
+    noise_hash(st->h, st->h, NOISE_HASHLEN, data, len);
+}
+
+static void noise_mix_key(NoiseState* st, const unsigned char* ikm, size_t len) {
+    unsigned char temp_k[NOISE_HASHLEN];
+    noise_hkdf(st->ck, ikm, len, st->ck, temp_k);
+    memcpy(st->k, temp_k, NOISE_KEYLEN);
+    st->n = 0;
+    st->has_key = true;
+    sodium_memzero(temp_k, sizeof temp_k);
+}
+
+static void noise_nonce(unsigned char* npub, uint64_t n) {
+    memset(npub, 0, 4);
+    for(int i = 0; i < 8; i++) {
+        npub[4 + i] = (unsigned char) (n >> (8 * i));
+    }
+}
+
+// EncryptAndHash: writes `len` bytes, plus the tag once there is a key
+static size_t noise_encrypt_and_hash(NoiseState* st, unsigned char* out,
+                                     const unsigned char* m, size_t len) {
+    size_t clen = len;
+    if( st->has_key ) {
+        unsigned char npub[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+        noise_nonce(npub, st->n++);
+        crypto_aead_chacha20poly1305_ietf_encrypt(out, NULL, m, len, st->h, NOISE_HASHLEN, NULL, npub, st->k);
+        clen += NOISE_TAGLEN;
+    } else if( len > 0 ) {
+        memmove(out, m, len);
+    }
+    noise_mix_hash(st, out, clen);
+    return clen;
+}
+
+// DecryptAndHash of `clen` bytes. Returns 0, or -1 if the tag is wrong
+static int noise_decrypt_and_hash(NoiseState* st, unsigned char* out,
+                                  const unsigned char* c, size_t clen) {
+    unsigned char h[NOISE_HASHLEN];
+    noise_hash(h, st->h, NOISE_HASHLEN, c, clen);
+    if( st->has_key ) {
+        unsigned char npub[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+        noise_nonce(npub, st->n);
+        if( crypto_aead_chacha20poly1305_ietf_decrypt(out, NULL, NULL, c, clen, st->h, NOISE_HASHLEN,
+                                                      npub, st->k) != 0 ) {
+            return -1;
+        }
+        st->n++;
+    } else if( clen > 0 ) {
+        memmove(out, c, clen);
+    }
+    memcpy(st->h, h, NOISE_HASHLEN);
+    return 0;
+}
+
+static int noise_dh(NoiseState* st, NoiseToken token, bool initiator) {
+    const unsigned char* sk;
+    const unsigned char* pk;
+    switch( token ) {
+        case NOISE_EE: sk = st->e_sk; pk = st->re; break;
+        case NOISE_SS: sk = st->s_sk; pk = st->rs; break;
+        case NOISE_ES: sk = initiator ? st->e_sk : st->s_sk; pk = initiator ? st->rs : st->re; break;
+        default:       sk = initiator ? st->s_sk : st->e_sk; pk = initiator ? st->re : st->rs; break;
+    }
+    unsigned char shared[NOISE_DHLEN];
+    if( crypto_scalarmult(shared, sk, pk) != 0 ) {
+        return -1;
+    }
+    noise_mix_key(st, shared, sizeof shared);
+    sodium_memzero(shared, sizeof shared);
+    return 0;
+}
+
+/**
+ * InitializeSymmetric with the protocol name, MixHash(prologue), and the
+ * pre-message of the pattern
+ */
+static void noise_initialize(NoiseState* st, const NoisePattern* pattern, bool initiator,
+                             const unsigned char* prologue, size_t prologue_size) {
+    std::string name = std::string("Noise_") + pattern->name + "_25519_ChaChaPoly_BLAKE2b";
+    memset(st->h, 0, NOISE_HASHLEN);
+    if( name.size() <= NOISE_HASHLEN ) {
+        memcpy(st->h, name.data(), name.size());
+    } else {
+        noise_hash(st->h, (const unsigned char*) name.data(), name.size(), NULL, 0);
+    }
+    memcpy(st->ck, st->h, NOISE_HASHLEN);
+    st->has_key = false;
+    st->n = 0;
+    noise_mix_hash(st, prologue, prologue_size);
+    if( pattern->responder_static_known ) {
+        noise_mix_hash(st, initiator ? st->rs : st->s_pk, NOISE_DHLEN);
+    }
+}
+
+// Exact size of a message with a payload of `len` bytes
+static size_t noise_message_size(const NoiseState* st, const NoiseToken* tokens, size_t len) {
+    bool keyed = st->has_key;
+    size_t size = 0;
+    for(; *tokens != NOISE_END; tokens++) {
+        if( *tokens == NOISE_E ) {
+            size += NOISE_DHLEN;
+        } else if( *tokens == NOISE_S ) {
+            size += NOISE_DHLEN + (keyed ? NOISE_TAGLEN : 0);
+        } else {
+            keyed = true;
+        }
+    }
+    return size + len + (keyed ? NOISE_TAGLEN : 0);
+}
+
+/**
+ * WriteMessage. `out` has noise_message_size() bytes.
+ * Returns 0, or -1 if a key exchange gave the all zero point
+ */
+static int noise_write_message(NoiseState* st, const NoiseToken* tokens, bool initiator,
+                               const unsigned char* payload, size_t len, unsigned char* out) {
+    for(; *tokens != NOISE_END; tokens++) {
+        switch( *tokens ) {
+            case NOISE_E:
+                if( !st->has_e && keypair_pool_take(KEYPAIR_POOL_X25519, st->e_pk, st->e_sk) != 0 ) {
+                    return -1;
+                }
+                st->has_e = true;
+                memcpy(out, st->e_pk, NOISE_DHLEN);
+                noise_mix_hash(st, st->e_pk, NOISE_DHLEN);
+                out += NOISE_DHLEN;
+                break;
+            case NOISE_S:
+                out += noise_encrypt_and_hash(st, out, st->s_pk, NOISE_DHLEN);
+                break;
+            default:
+                if( noise_dh(st, *tokens, initiator) != 0 ) {
+                    return -1;
+                }
+        }
+    }
+    noise_encrypt_and_hash(st, out, payload, len);
+    return 0;
+}
+
+/**
+ * ReadMessage of `size` bytes. The payload goes to `payload`, which has
+ * room for `size` bytes, and its length to `len`.
+ * Returns 0, or -1 if the message is short, forged or gives a zero point
+ */
+static int noise_read_message(NoiseState* st, const NoiseToken* tokens, bool initiator,
+                              const unsigned char* in, size_t size,
+                              unsigned char* payload, size_t* len) {
+    const unsigned char* end = in + size;
+    for(; *tokens != NOISE_END; tokens++) {
+        switch( *tokens ) {
+            case NOISE_E:
+                if( (size_t) (end - in) < NOISE_DHLEN ) {
+                    return -1;
+                }
+                memcpy(st->re, in, NOISE_DHLEN);
+                st->has_re = true;
+                noise_mix_hash(st, st->re, NOISE_DHLEN);
+                in += NOISE_DHLEN;
+                break;
+            case NOISE_S: {
+                size_t slen = NOISE_DHLEN + (st->has_key ? NOISE_TAGLEN : 0);
+                if( (size_t) (end - in) < slen || noise_decrypt_and_hash(st, st->rs, in, slen) != 0 ) {
+                    return -1;
+                }
+                st->has_rs = true;
+                in += slen;
+                break;
+            }
+            default:
+                if( noise_dh(st, *tokens, initiator) != 0 ) {
+                    return -1;
+                }
+        }
+    }
+    size_t clen = end - in;
+    if( st->has_key && clen < NOISE_TAGLEN ) {
+        return -1;
+    }
+    *len = clen - (st->has_key ? NOISE_TAGLEN : 0);
+    return noise_decrypt_and_hash(st, payload, in, clen);
+}
+
+/**
+ * NoiseHandshake:
+ * Native Noise handshake state machine
+ *
+ * Runs a `Noise_<pattern>_25519_ChaChaPoly_BLAKE2b` handshake in C++: every
+ * message is one call, and the chaining key, handshake hash and ephemeral
+ * keys stay in memory allocated with `sodium_malloc`. Ephemeral key pairs
+ * come from the key pair pool when it is on.
+ *
+ *    var hs = new sodium.NoiseHandshake(pattern, initiator, [options]);
+ *
+ * ~ pattern (String): `XX` or `IK`
+ * ~ initiator (Boolean): true for the side that sends the first message
+ * ~ options (Object):
+ *   - `staticKeyPair`: `{ publicKey, secretKey }`, as from
+ *     `crypto_box_keypair`. Both sides of XX and IK need one
+ *   - `remoteStaticKey` (Buffer): the responder's public key, required by
+ *     the IK initiator
+ *   - `prologue` (Buffer): data both sides must agree on, hashed first
+ *   - `ephemeralKeyPair`: fixed ephemeral key pair, only for test vectors
+ *
+ * Methods:
+ *
+ * ~ writeMessage([payload]): the next handshake message, carrying
+ *   `payload`. Messages are at most 65535 bytes long
+ * ~ readMessage(message): the payload of the peer's next message, or null
+ *   if it does not verify. A failed handshake throws on every later call
+ * ~ split(): once finished, returns `{ tx, rx, handshakeHash }`: the
+ *   `crypto_aead_chacha20poly1305_ietf` keys to send and receive with and
+ *   the final handshake hash, then wipes the handshake state. Transport
+ *   nonces are 4 zero bytes and a 64 bit little endian counter
+ * ~ dispose(): wipes and frees the state. Later calls throw
+ *
+ * Properties:
+ *
+ * ~ finished (Boolean): all messages were written or read
+ * ~ remoteStaticKey (Buffer): the peer's static public key once known, or
+ *   null
+ * ~ handshakeHash (Buffer): the current handshake hash, for channel binding
+ *
+ * **Sample**:
+ *
+ *     var a = new sodium.NoiseHandshake('XX', true, { staticKeyPair: alice });
+ *     var b = new sodium.NoiseHandshake('XX', false, { staticKeyPair: bob });
+ *     b.readMessage(a.writeMessage());
+ *     a.readMessage(b.writeMessage());
+ *     b.readMessage(a.writeMessage());
+ *     var keys = a.split();
+ */
+class NoiseHandshake : public Napi::ObjectWrap<NoiseHandshake> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "NoiseHandshake", {
+            InstanceMethod("writeMessage", &NoiseHandshake::WriteMessage),
+            InstanceMethod("readMessage", &NoiseHandshake::ReadMessage),
+            InstanceMethod("split", &NoiseHandshake::Split),
+            InstanceMethod("dispose", &NoiseHandshake::Dispose),
+            InstanceAccessor("finished", &NoiseHandshake::Finished, nullptr),
+            InstanceAccessor("remoteStaticKey", &NoiseHandshake::RemoteStaticKey, nullptr),
+            InstanceAccessor("handshakeHash", &NoiseHandshake::HandshakeHash, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "NoiseHandshake"), ctor);
+    }
+
+    NoiseHandshake(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<NoiseHandshake>(info), pattern(NULL), initiator(false),
+          message(0), failed(false), st(NULL) {
+        Napi::Env env = info.Env();
+
+        if( info.Length() < 2 || !info[0].IsString() || !info[1].IsBoolean() ) {
+            Napi::TypeError::New(env, "arguments must be: pattern name, initiator").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string name = info[0].As<Napi::String>().Utf8Value();
+        const NoisePattern* found = NULL;
+        for(size_t i = 0; i < sizeof(noise_patterns) / sizeof(noise_patterns[0]); i++) {
+            if( name == noise_patterns[i].name ) {
+                found = &noise_patterns[i];
+            }
+        }
+        if( found == NULL ) {
+            Napi::Error::New(env, "unknown Noise pattern " + name).ThrowAsJavaScriptException();
+            return;
+        }
+        initiator = info[1].As<Napi::Boolean>().Value();
+
+        Napi::Object options = Napi::Object::New(env);
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            if( !info[2].IsObject() ) {
+                Napi::TypeError::New(env, "argument options must be an object").ThrowAsJavaScriptException();
+                return;
+            }
+            options = info[2].As<Napi::Object>();
+        }
+
+        st = (NoiseState*) sodium_malloc(sizeof(NoiseState));
+        if( st == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the handshake").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_memzero(st, sizeof(NoiseState));
+        sodium_memory_hold(env, sodium_secure_footprint(sizeof(NoiseState)));
+
+        std::string error;
+        st->has_s = OptionKeyPair(options, "staticKeyPair", st->s_pk, st->s_sk, error);
+        st->has_e = OptionKeyPair(options, "ephemeralKeyPair", st->e_pk, st->e_sk, error);
+        st->has_rs = OptionKey(options, "remoteStaticKey", st->rs, error);
+        if( error.empty() && !st->has_s ) {
+            error = "option staticKeyPair is required by the " + name + " pattern";
+        }
+        if( error.empty() && found->responder_static_known && initiator && !st->has_rs ) {
+            error = "option remoteStaticKey is required by the " + name + " initiator";
+        }
+
+        unsigned char* prologue = NULL;
+        size_t prologue_size = 0;
+        Napi::Value value = options.Get("prologue");
+        if( error.empty() && !value.IsUndefined() && !sodium_arg_bytes(value, prologue, prologue_size) ) {
+            error = "option prologue must be a buffer";
+        }
+        if( !error.empty() ) {
+            Free();
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+
+        pattern = found;
+        noise_initialize(st, pattern, initiator, prologue, prologue_size);
+    }
+
+    ~NoiseHandshake() {
+        Free();
+    }
+
+private:
+    static bool OptionKey(Napi::Object options, const char* name, unsigned char* key, std::string& error) {
+        Napi::Value value = options.Get(name);
+        if( value.IsUndefined() ) {
+            return false;
+        }
+        unsigned char* data = NULL;
+        size_t size = 0;
+        if( !sodium_arg_bytes(value, data, size) || size != NOISE_DHLEN ) {
+            error = std::string("option ") + name + " must be a crypto_scalarmult_BYTES buffer";
+            return false;
+        }
+        memcpy(key, data, NOISE_DHLEN);
+        return true;
+    }
+
+    static bool OptionKeyPair(Napi::Object options, const char* name, unsigned char* pk, unsigned char* sk,
+                              std::string& error) {
+        Napi::Value value = options.Get(name);
+        if( value.IsUndefined() ) {
+            return false;
+        }
+        if( !value.IsObject() ) {
+            error = std::string("option ") + name + " must be { publicKey, secretKey }";
+            return false;
+        }
+        Napi::Object pair = value.As<Napi::Object>();
+        if( !OptionKey(pair, "publicKey", pk, error) || !OptionKey(pair, "secretKey", sk, error) ) {
+            error = std::string("option ") + name + " must be { publicKey, secretKey } of crypto_box_keypair";
+            return false;
+        }
+        return true;
+    }
+
+    void Free() {
+        if( st != NULL ) {
+            sodium_free(st);
+            st = NULL;
+            sodium_memory_hold(Env(), -(int64_t) sodium_secure_footprint(sizeof(NoiseState)));
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( st == NULL ) { \
+        THROW_ERROR("NoiseHandshake was disposed"); \
+    } \
+    if( failed ) { \
+        THROW_ERROR("NoiseHandshake failed"); \
+    }
+
+    // Whose turn it is: the initiator writes the even messages
+    bool Writing() {
+        return (message % 2 == 0) == initiator;
+    }
+
+    Napi::Value WriteMessage(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( message >= pattern->count ) {
+            THROW_ERROR("the handshake is finished");
+        }
+        if( !Writing() ) {
+            THROW_ERROR("it is the peer's turn to write a message");
+        }
+
+        unsigned char* payload = NULL;
+        size_t payload_size = 0;
+        if( info.Length() > 0 && !info[0].IsUndefined() && !sodium_arg_bytes(info[0], payload, payload_size) ) {
+            THROW_ERROR("argument payload must be a buffer");
+        }
+
+        const NoiseToken* tokens = pattern->messages[message];
+        size_t size = noise_message_size(st, tokens, payload_size);
+        if( size > NOISE_MAX_MESSAGE ) {
+            THROW_ERROR("handshake messages cannot be longer than 65535 bytes");
+        }
+
+        NEW_BUFFER_AND_PTR(out, size);
+        if( noise_write_message(st, tokens, initiator, payload, payload_size, out_ptr) != 0 ) {
+            failed = true;
+            THROW_ERROR("NoiseHandshake failed: bad public key");
+        }
+        message++;
+        return out;
+    }
+
+    Napi::Value ReadMessage(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER(in);
+        if( message >= pattern->count ) {
+            THROW_ERROR("the handshake is finished");
+        }
+        if( Writing() ) {
+            THROW_ERROR("it is our turn to write a message");
+        }
+        if( in_size > NOISE_MAX_MESSAGE ) {
+            THROW_ERROR("handshake messages cannot be longer than 65535 bytes");
+        }
+
+        std::vector<unsigned char> payload(in_size);
+        size_t len = 0;
+        if( noise_read_message(st, pattern->messages[message], initiator, in, in_size,
+                               payload.data(), &len) != 0 ) {
+            failed = true;
+            return NAPI_NULL;
+        }
+        message++;
+
+        NEW_BUFFER_AND_PTR(out, len);
+        if( len > 0 ) {
+            memcpy(out_ptr, payload.data(), len);
+        }
+        sodium_memzero(payload.data(), payload.size());
+        return out;
+    }
+
+    Napi::Value Split(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( message < pattern->count ) {
+            THROW_ERROR("the handshake is not finished");
+        }
+
+        unsigned char k1[NOISE_HASHLEN], k2[NOISE_HASHLEN];
+        noise_hkdf(st->ck, NULL, 0, k1, k2);
+
+        NEW_BUFFER_AND_PTR(tx, NOISE_KEYLEN);
+        NEW_BUFFER_AND_PTR(rx, NOISE_KEYLEN);
+        NEW_BUFFER_AND_PTR(hash, NOISE_HASHLEN);
+        memcpy(tx_ptr, initiator ? k1 : k2, NOISE_KEYLEN);
+        memcpy(rx_ptr, initiator ? k2 : k1, NOISE_KEYLEN);
+        memcpy(hash_ptr, st->h, NOISE_HASHLEN);
+        sodium_memzero(k1, sizeof k1);
+        sodium_memzero(k2, sizeof k2);
+        Free();
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "tx"), tx);
+        result.Set(Napi::String::New(env, "rx"), rx);
+        result.Set(Napi::String::New(env, "handshakeHash"), hash);
+        return result;
+    }
+
+    Napi::Value Finished(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return message >= pattern->count ? NAPI_TRUE : NAPI_FALSE;
+    }
+
+    Napi::Value RemoteStaticKey(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( !st->has_rs ) {
+            return NAPI_NULL;
+        }
+        NEW_BUFFER_AND_PTR(rs, NOISE_DHLEN);
+        memcpy(rs_ptr, st->rs, NOISE_DHLEN);
+        return rs;
+    }
+
+    Napi::Value HandshakeHash(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        NEW_BUFFER_AND_PTR(hash, NOISE_HASHLEN);
+        memcpy(hash_ptr, st->h, NOISE_HASHLEN);
+        return hash;
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    const NoisePattern* pattern;
+    bool initiator;
+
+    // Index of the next handshake message
+    size_t message;
+    bool failed;
+    NoiseState* st;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_noise(Napi::Env env, Napi::Object exports) {
+    NoiseHandshake::Init(env, exports);
+}
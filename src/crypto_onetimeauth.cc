@@ -15,6 +15,9 @@ void register_crypto_onetimeauth(Napi::Env env, Napi::Object exports) {
 
     EXPORT_ALIAS(crypto_onetimeauth, crypto_onetimeauth_poly1305);
     EXPORT_ALIAS(crypto_onetimeauth_verify, crypto_onetimeauth_poly1305_verify);
+    EXPORT_ALIAS(crypto_onetimeauth_verify_any, crypto_onetimeauth_poly1305_verify_any);
+    EXPORT_ALIAS(crypto_onetimeauth_batch, crypto_onetimeauth_poly1305_batch);
+    EXPORT_ALIAS(crypto_onetimeauth_verify_batch, crypto_onetimeauth_poly1305_verify_batch);
     EXPORT_ALIAS(crypto_onetimeauth_init, crypto_onetimeauth_poly1305_init);
     EXPORT_ALIAS(crypto_onetimeauth_update, crypto_onetimeauth_poly1305_update);
     EXPORT_ALIAS(crypto_onetimeauth_final, crypto_onetimeauth_poly1305_final);
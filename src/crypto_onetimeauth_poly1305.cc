@@ -6,6 +6,7 @@
  * @License MIT
  */
 #include "node_sodium.h"
+#include "node_sodium_batch.h"
 
 /**
  * int crypto_onetimeauth_poly1305(
@@ -63,6 +64,36 @@ NAPI_METHOD(crypto_onetimeauth_poly1305_verify) {
     return NAPI_FALSE;
 }
 
+/**
+ * crypto_onetimeauth_poly1305_verify_any(token, message, keyring)
+ *
+ * Check `token` against `message` under each key of `keyring`, an array of
+ * `crypto_onetimeauth_poly1305_KEYBYTES` Buffers, in one call. Every key is
+ * tried, so the time taken does not tell which one matched.
+ *
+ * Returns the index of the first matching key, -1 if none matches
+ */
+NAPI_METHOD(crypto_onetimeauth_poly1305_verify_any) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: token, message, keyring");
+    ARG_TO_UCHAR_BUFFER_LEN(token, crypto_onetimeauth_poly1305_BYTES);
+    ARG_TO_UCHAR_BUFFER(message);
+    if( !info[_arg].IsArray() ) {
+        THROW_ERROR("argument keyring must be an array of keys");
+    }
+    size_t count = SODIUM_BATCH_ANY;
+    ARG_TO_BATCH_LEN(keyring, count, crypto_onetimeauth_poly1305_KEYBYTES);
+
+    int32_t found = -1;
+    for(size_t i = 0; i < count; i++) {
+        if( crypto_onetimeauth_poly1305_verify(token, message, message_size, keyring[i].data) == 0 && found < 0 ) {
+            found = (int32_t) i;
+        }
+    }
+    return Napi::Number::New(env, found);
+}
+
 /*
 int crypto_onetimeauth_poly1305_init(crypto_onetimeauth_poly1305_state *state,
                                      const unsigned char *key);
@@ -123,6 +154,158 @@ NAPI_METHOD(crypto_onetimeauth_poly1305_final) {
     return NAPI_NULL;
 }
 
+// Optional thread count at the current argument
+#define ARG_TO_THREADS(NAME) \
+    size_t NAME = 1; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        NAME = NAME ## _arg; \
+    }
+
+// The Poly1305 key of a frame: the first 32 bytes of its ChaCha20 key stream
+static void poly1305_chacha20_key(unsigned char* poly_key, const unsigned char* nonce, const unsigned char* key) {
+    crypto_stream_chacha20(poly_key, crypto_onetimeauth_poly1305_KEYBYTES, nonce, key);
+}
+
+/**
+ * crypto_onetimeauth_poly1305_batch(messages, lengths, keys, [threads])
+ *
+ * One Poly1305 tag per (message, key) pair in one call.
+ *
+ * ~ messages (Buffer): the messages back to back
+ * ~ lengths (Array|Uint32Array|Number): length of each message, as for
+ *   `crypto_shorthash_batch`
+ * ~ keys (Buffer|Array): one `crypto_onetimeauth_poly1305_KEYBYTES` key per
+ *   message, back to back or as an array
+ *
+ * Returns the `crypto_onetimeauth_poly1305_BYTES` tags back to back
+ */
+NAPI_METHOD(crypto_onetimeauth_poly1305_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: messages, lengths, keys");
+    ARG_TO_CHUNKS(messages, lengths);
+    size_t count = messages.size();
+    ARG_TO_BATCH_LEN(keys, count, crypto_onetimeauth_poly1305_KEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    NEW_BUFFER_AND_PTR(tags, count * crypto_onetimeauth_poly1305_BYTES);
+    sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            crypto_onetimeauth_poly1305(tags_ptr + i * crypto_onetimeauth_poly1305_BYTES,
+                                        messages[i].data, messages[i].size, keys[i].data);
+        }
+    });
+    return tags;
+}
+
+/**
+ * crypto_onetimeauth_poly1305_verify_batch(tags, messages, lengths, keys, [threads])
+ *
+ * Check one tag per (message, key) pair. `tags` are back to back or an
+ * array. Returns a bitmap: bit `i % 8` of byte `i / 8` is set when tag `i`
+ * is valid
+ */
+NAPI_METHOD(crypto_onetimeauth_poly1305_verify_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: tags, messages, lengths, keys");
+    _arg++; // tags, once the count is known
+    ARG_TO_CHUNKS(messages, lengths);
+    size_t count = messages.size();
+    ARG_TO_BATCH_LEN(keys, count, crypto_onetimeauth_poly1305_KEYBYTES);
+    ARG_TO_THREADS(threads);
+    std::vector<SodiumSpan> tags;
+    if( !sodium_batch_arg(env, info[0], "tags", count, crypto_onetimeauth_poly1305_BYTES, false, tags) ) {
+        return NAPI_NULL;
+    }
+
+    std::vector<unsigned char> ok(count, 0);
+    sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            ok[i] = crypto_onetimeauth_poly1305_verify(tags[i].data, messages[i].data, messages[i].size,
+                                                       keys[i].data) == 0;
+        }
+    });
+    return sodium_batch_bitmap(env, ok);
+}
+
+/**
+ * crypto_onetimeauth_poly1305_chacha20_batch(messages, lengths, nonces, key, [threads])
+ *
+ * Tag frames whose Poly1305 keys come from a stream cipher, in one call.
+ * The key of frame `i` is the first `crypto_onetimeauth_poly1305_KEYBYTES`
+ * bytes of `crypto_stream_chacha20(nonces[i], key)`, the same as
+ *
+ *     var polyKey = sodium.crypto_stream_chacha20(32, nonces[i], key);
+ *     var tag = sodium.crypto_onetimeauth_poly1305(message, polyKey);
+ *
+ * without the two calls and the key Buffer per frame. The derived keys are
+ * wiped after use.
+ *
+ * ~ nonces (Buffer|Array): one `crypto_stream_chacha20_NONCEBYTES` nonce
+ *   per message, never used twice with `key`
+ * ~ key (Buffer): `crypto_stream_chacha20_KEYBYTES` key
+ */
+NAPI_METHOD(crypto_onetimeauth_poly1305_chacha20_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: messages, lengths, nonces, key");
+    ARG_TO_CHUNKS(messages, lengths);
+    size_t count = messages.size();
+    ARG_TO_BATCH_LEN(nonces, count, crypto_stream_chacha20_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_stream_chacha20_KEYBYTES);
+    ARG_TO_THREADS(threads);
+
+    NEW_BUFFER_AND_PTR(tags, count * crypto_onetimeauth_poly1305_BYTES);
+    sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+        unsigned char poly_key[crypto_onetimeauth_poly1305_KEYBYTES];
+        for(size_t i = begin; i < end; i++) {
+            poly1305_chacha20_key(poly_key, nonces[i].data, key);
+            crypto_onetimeauth_poly1305(tags_ptr + i * crypto_onetimeauth_poly1305_BYTES,
+                                        messages[i].data, messages[i].size, poly_key);
+        }
+        sodium_memzero(poly_key, sizeof poly_key);
+    });
+    return tags;
+}
+
+/**
+ * crypto_onetimeauth_poly1305_chacha20_verify_batch(tags, messages, lengths, nonces, key, [threads])
+ *
+ * Check tags made by `crypto_onetimeauth_poly1305_chacha20_batch`. Returns
+ * the bitmap of the valid tags
+ */
+NAPI_METHOD(crypto_onetimeauth_poly1305_chacha20_verify_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments must be: tags, messages, lengths, nonces, key");
+    _arg++; // tags, once the count is known
+    ARG_TO_CHUNKS(messages, lengths);
+    size_t count = messages.size();
+    ARG_TO_BATCH_LEN(nonces, count, crypto_stream_chacha20_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_stream_chacha20_KEYBYTES);
+    ARG_TO_THREADS(threads);
+    std::vector<SodiumSpan> tags;
+    if( !sodium_batch_arg(env, info[0], "tags", count, crypto_onetimeauth_poly1305_BYTES, false, tags) ) {
+        return NAPI_NULL;
+    }
+
+    std::vector<unsigned char> ok(count, 0);
+    sodium_batch_parallel(count, threads, 256, [&](size_t begin, size_t end) {
+        unsigned char poly_key[crypto_onetimeauth_poly1305_KEYBYTES];
+        for(size_t i = begin; i < end; i++) {
+            poly1305_chacha20_key(poly_key, nonces[i].data, key);
+            ok[i] = crypto_onetimeauth_poly1305_verify(tags[i].data, messages[i].data, messages[i].size,
+                                                       poly_key) == 0;
+        }
+        sodium_memzero(poly_key, sizeof poly_key);
+    });
+    return sodium_batch_bitmap(env, ok);
+}
+
+#undef ARG_TO_THREADS
+
 NAPI_METHOD_FROM_INT(crypto_onetimeauth_poly1305_bytes)
 NAPI_METHOD_FROM_INT(crypto_onetimeauth_poly1305_keybytes)
 NAPI_METHOD_FROM_INT(crypto_onetimeauth_poly1305_statebytes)
@@ -136,6 +319,11 @@ void register_crypto_onetimeauth_poly1305(Napi::Env env, Napi::Object exports) {
     // One Time Auth
     EXPORT(crypto_onetimeauth_poly1305);
     EXPORT(crypto_onetimeauth_poly1305_verify);
+    EXPORT(crypto_onetimeauth_poly1305_verify_any);
+    EXPORT(crypto_onetimeauth_poly1305_batch);
+    EXPORT(crypto_onetimeauth_poly1305_verify_batch);
+    EXPORT(crypto_onetimeauth_poly1305_chacha20_batch);
+    EXPORT(crypto_onetimeauth_poly1305_chacha20_verify_batch);
     EXPORT(crypto_onetimeauth_poly1305_init);
     EXPORT(crypto_onetimeauth_poly1305_update);
     EXPORT(crypto_onetimeauth_poly1305_final);
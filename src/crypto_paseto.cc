@@ -0,0 +1,541 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "crypto_sign_verify_cache.h"
+#include "sodium_memory.h"
+#include "sodium_stats.h"
+
+/**
+ * PASETO tokens, versions 2 and 4, local and public purposes.
+ *
+ *     v2.local   XChaCha20-Poly1305, nonce BLAKE2b-24 of the message keyed
+ *                with 24 random bytes
+ *     v4.local   XChaCha20 and a BLAKE2b-32 MAC, keys split from the key
+ *                and a 32 byte random nonce with keyed BLAKE2b
+ *     v2.public, v4.public   Ed25519
+ *
+ * Pre-authentication encoding (PAE), the cryptography and base64url all
+ * run here, so a token is one call.
+ */
+#define PASETO_V2_NONCEBYTES crypto_aead_xchacha20poly1305_ietf_NPUBBYTES
+#define PASETO_V4_NONCEBYTES 32
+#define PASETO_V4_MACBYTES 32
+#define PASETO_KEYBYTES 32
+
+struct PasetoPiece {
+    const unsigned char* data;
+    size_t size;
+};
+
+static void paseto_le64(unsigned char* out, uint64_t n) {
+    for(int i = 0; i < 8; i++) {
+        out[i] = (unsigned char) (n >> (8 * i));
+    }
+    out[7] &= 0x7f;
+}
+
+// PAE(pieces) as one buffer, for Ed25519 and the v2 additional data
+static void paseto_pae(std::vector<unsigned char>& out, const PasetoPiece* pieces, size_t count) {
+    size_t size = 8;
+    for(size_t i = 0; i < count; i++) {
+        size += 8 + pieces[i].size;
+    }
+    out.resize(size);
+    unsigned char* pos = out.data();
+    paseto_le64(pos, count);
+    pos += 8;
+    for(size_t i = 0; i < count; i++) {
+        paseto_le64(pos, pieces[i].size);
+        pos += 8;
+        if( pieces[i].size > 0 ) {
+            memcpy(pos, pieces[i].data, pieces[i].size);
+        }
+        pos += pieces[i].size;
+    }
+}
+
+// Keyed BLAKE2b of PAE(pieces), without building the encoding
+static void paseto_pae_mac(unsigned char* out, size_t outlen, const unsigned char* key,
+                           const PasetoPiece* pieces, size_t count) {
+    crypto_generichash_state state;
+    unsigned char le[8];
+    crypto_generichash_init(&state, key, PASETO_KEYBYTES, outlen);
+    paseto_le64(le, count);
+    crypto_generichash_update(&state, le, 8);
+    for(size_t i = 0; i < count; i++) {
+        paseto_le64(le, pieces[i].size);
+        crypto_generichash_update(&state, le, 8);
+        crypto_generichash_update(&state, pieces[i].data, pieces[i].size);
+    }
+    crypto_generichash_final(&state, out, outlen);
+}
+
+// BLAKE2b of `label | n` keyed with `key`
+static void paseto_v4_derive(unsigned char* out, size_t outlen, const unsigned char* key,
+                             const char* label, const unsigned char* n) {
+    crypto_generichash_state state;
+    crypto_generichash_init(&state, key, PASETO_KEYBYTES, outlen);
+    crypto_generichash_update(&state, (const unsigned char*) label, strlen(label));
+    crypto_generichash_update(&state, n, PASETO_V4_NONCEBYTES);
+    crypto_generichash_final(&state, out, outlen);
+}
+
+static void paseto_base64(std::string& out, const unsigned char* bin, size_t len) {
+    size_t start = out.size();
+    size_t encoded = sodium_base64_encoded_len(len, sodium_base64_VARIANT_URLSAFE_NO_PADDING);
+    out.resize(start + encoded);
+    sodium_bin2base64(&out[start], encoded, bin, len, sodium_base64_VARIANT_URLSAFE_NO_PADDING);
+    out.resize(out.size() - 1);
+}
+
+static bool paseto_unbase64(std::vector<unsigned char>& out, const char* text, size_t len) {
+    out.resize(len / 4 * 3 + 3);
+    size_t bin_len = 0;
+    if( sodium_base642bin(out.data(), out.size(), text, len, NULL, &bin_len, NULL,
+                          sodium_base64_VARIANT_URLSAFE_NO_PADDING) != 0 ) {
+        return false;
+    }
+    out.resize(bin_len);
+    return true;
+}
+
+struct PasetoKeyData {
+    int version;
+    bool local;
+
+    // local: the key. public: secret key, or only the public key
+    const unsigned char* key;
+    bool can_sign;
+    unsigned char pk[crypto_sign_ed25519_PUBLICKEYBYTES];
+    std::string header;
+};
+
+/**
+ * Body of a token for `m`, footer `f` and implicit assertion `i`, base64url
+ * encoded and appended to `token` after the header
+ */
+static bool paseto_encode(const PasetoKeyData& k, std::string& token,
+                          const unsigned char* m, size_t mlen,
+                          const unsigned char* f, size_t flen,
+                          const unsigned char* i, size_t ilen) {
+    const unsigned char* h = (const unsigned char*) k.header.data();
+    std::vector<unsigned char> body;
+    std::vector<unsigned char> pae;
+
+    if( k.local && k.version == 2 ) {
+        body.resize(PASETO_V2_NONCEBYTES + mlen + crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        unsigned char b[PASETO_V2_NONCEBYTES];
+        randombytes_buf(b, sizeof b);
+        crypto_generichash(body.data(), PASETO_V2_NONCEBYTES, m, mlen, b, sizeof b);
+        PasetoPiece pieces[] = { { h, k.header.size() }, { body.data(), PASETO_V2_NONCEBYTES }, { f, flen } };
+        paseto_pae(pae, pieces, 3);
+        SODIUM_STAT(aead_xchacha20poly1305_ietf, mlen, body.size(),
+            crypto_aead_xchacha20poly1305_ietf_encrypt(body.data() + PASETO_V2_NONCEBYTES, NULL, m, mlen,
+                pae.data(), pae.size(), NULL, body.data(), k.key));
+    } else if( k.local ) {
+        body.resize(PASETO_V4_NONCEBYTES + mlen + PASETO_V4_MACBYTES);
+        unsigned char* n = body.data();
+        unsigned char* c = n + PASETO_V4_NONCEBYTES;
+        randombytes_buf(n, PASETO_V4_NONCEBYTES);
+
+        unsigned char tmp[PASETO_KEYBYTES + crypto_stream_xchacha20_NONCEBYTES];
+        unsigned char ak[PASETO_KEYBYTES];
+        paseto_v4_derive(tmp, sizeof tmp, k.key, "paseto-encryption-key", n);
+        paseto_v4_derive(ak, sizeof ak, k.key, "paseto-auth-key-for-aead", n);
+        crypto_stream_xchacha20_xor(c, m, mlen, tmp + PASETO_KEYBYTES, tmp);
+
+        PasetoPiece pieces[] = { { h, k.header.size() }, { n, PASETO_V4_NONCEBYTES }, { c, mlen },
+                                 { f, flen }, { i, ilen } };
+        paseto_pae_mac(c + mlen, PASETO_V4_MACBYTES, ak, pieces, 5);
+        sodium_memzero(tmp, sizeof tmp);
+        sodium_memzero(ak, sizeof ak);
+        SODIUM_STAT(secretbox, mlen, body.size(), 0);
+    } else {
+        if( !k.can_sign ) {
+            return false;
+        }
+        PasetoPiece pieces[] = { { h, k.header.size() }, { m, mlen }, { f, flen }, { i, ilen } };
+        paseto_pae(pae, pieces, k.version == 2 ? 3 : 4);
+        body.resize(mlen + crypto_sign_ed25519_BYTES);
+        if( mlen > 0 ) {
+            memcpy(body.data(), m, mlen);
+        }
+        SODIUM_STAT(sign, pae.size(), crypto_sign_ed25519_BYTES,
+            crypto_sign_ed25519_detached(body.data() + mlen, NULL, pae.data(), pae.size(), k.key));
+    }
+
+    paseto_base64(token, body.data(), body.size());
+    if( flen > 0 ) {
+        token += '.';
+        paseto_base64(token, f, flen);
+    }
+    sodium_memzero(body.data(), body.size());
+    return true;
+}
+
+/**
+ * Check and open `token`. The payload goes to `m` and the footer to `f`.
+ * Returns false if the token is malformed, for another key type, or forged
+ */
+static bool paseto_decode(const PasetoKeyData& k, const std::string& token,
+                          const unsigned char* i, size_t ilen,
+                          std::vector<unsigned char>& m, std::vector<unsigned char>& f) {
+    const std::string& header = k.header;
+    if( token.size() < header.size() || token.compare(0, header.size(), header) != 0 ) {
+        return false;
+    }
+    size_t dot = token.find('.', header.size());
+    size_t body_end = dot == std::string::npos ? token.size() : dot;
+
+    std::vector<unsigned char> body;
+    if( !paseto_unbase64(body, token.data() + header.size(), body_end - header.size()) ) {
+        return false;
+    }
+    f.clear();
+    if( dot != std::string::npos &&
+        (dot + 1 == token.size() || !paseto_unbase64(f, token.data() + dot + 1, token.size() - dot - 1)) ) {
+        return false;
+    }
+
+    const unsigned char* h = (const unsigned char*) header.data();
+    std::vector<unsigned char> pae;
+    bool ok;
+
+    if( k.local && k.version == 2 ) {
+        if( body.size() < PASETO_V2_NONCEBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES ) {
+            return false;
+        }
+        size_t clen = body.size() - PASETO_V2_NONCEBYTES;
+        PasetoPiece pieces[] = { { h, header.size() }, { body.data(), PASETO_V2_NONCEBYTES }, { f.data(), f.size() } };
+        paseto_pae(pae, pieces, 3);
+        m.resize(clen - crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        ok = SODIUM_STAT(aead_xchacha20poly1305_ietf, clen, m.size(),
+            crypto_aead_xchacha20poly1305_ietf_decrypt(m.data(), NULL, NULL, body.data() + PASETO_V2_NONCEBYTES,
+                clen, pae.data(), pae.size(), body.data(), k.key)) == 0;
+    } else if( k.local ) {
+        if( body.size() < PASETO_V4_NONCEBYTES + PASETO_V4_MACBYTES ) {
+            return false;
+        }
+        const unsigned char* n = body.data();
+        const unsigned char* c = n + PASETO_V4_NONCEBYTES;
+        size_t clen = body.size() - PASETO_V4_NONCEBYTES - PASETO_V4_MACBYTES;
+
+        unsigned char tmp[PASETO_KEYBYTES + crypto_stream_xchacha20_NONCEBYTES];
+        unsigned char ak[PASETO_KEYBYTES];
+        unsigned char t[PASETO_V4_MACBYTES];
+        paseto_v4_derive(tmp, sizeof tmp, k.key, "paseto-encryption-key", n);
+        paseto_v4_derive(ak, sizeof ak, k.key, "paseto-auth-key-for-aead", n);
+        PasetoPiece pieces[] = { { h, header.size() }, { n, PASETO_V4_NONCEBYTES }, { c, clen },
+                                 { f.data(), f.size() }, { i, ilen } };
+        paseto_pae_mac(t, sizeof t, ak, pieces, 5);
+        ok = crypto_verify_32(t, c + clen) == 0;
+        if( ok ) {
+            m.resize(clen);
+            crypto_stream_xchacha20_xor(m.data(), c, clen, tmp + PASETO_KEYBYTES, tmp);
+        }
+        SODIUM_STAT(secretbox, body.size(), ok ? clen : 0, ok ? 0 : -1);
+        sodium_memzero(tmp, sizeof tmp);
+        sodium_memzero(ak, sizeof ak);
+    } else {
+        if( body.size() < crypto_sign_ed25519_BYTES ) {
+            return false;
+        }
+        size_t mlen = body.size() - crypto_sign_ed25519_BYTES;
+        PasetoPiece pieces[] = { { h, header.size() }, { body.data(), mlen }, { f.data(), f.size() }, { i, ilen } };
+        paseto_pae(pae, pieces, k.version == 2 ? 3 : 4);
+        ok = SODIUM_STAT(verify, pae.size(), 0,
+            sign_verify_cache_verify(body.data() + mlen, pae.data(), pae.size(), k.pk)) == 0;
+        if( ok ) {
+            m.assign(body.begin(), body.begin() + mlen);
+        }
+    }
+
+    sodium_memzero(body.data(), body.size());
+    if( !ok ) {
+        sodium_memzero(m.data(), m.size());
+    }
+    return ok;
+}
+
+// Bytes of a Buffer or UTF-8 string argument, undefined or null for none
+static bool paseto_arg_bytes(Napi::Value value, std::string& text, const unsigned char*& data, size_t& size) {
+    data = NULL;
+    size = 0;
+    if( value.IsUndefined() || value.IsNull() ) {
+        return true;
+    }
+    if( value.IsString() ) {
+        text = value.As<Napi::String>().Utf8Value();
+        data = (const unsigned char*) text.data();
+        size = text.size();
+        return true;
+    }
+    unsigned char* bytes = NULL;
+    if( !sodium_arg_bytes(value, bytes, size) ) {
+        return false;
+    }
+    data = bytes;
+    return true;
+}
+
+/**
+ * PasetoKey:
+ * PASETO key for encoding and decoding tokens
+ *
+ * Checks and copies the key once, into memory allocated with
+ * `sodium_malloc` and made read only, and encodes or decodes each token in
+ * one call: PAE, encryption or signature and base64url.
+ *
+ *    var key = new sodium.PasetoKey(version, purpose, key);
+ *
+ * ~ version (String): `v2` or `v4`
+ * ~ purpose (String): `local` or `public`
+ * ~ key (Buffer): `local`: 32 byte symmetric key. `public`: a
+ *   `crypto_sign_SECRETKEYBYTES` secret key, which encodes and decodes, or a
+ *   `crypto_sign_PUBLICKEYBYTES` public key, which only decodes
+ *
+ * Methods:
+ *
+ * ~ encode(payload, [footer], [implicit]): the token string. `payload`,
+ *   `footer` and the v4 implicit assertion are Buffers or strings
+ * ~ decode(token, [implicit]): `{ payload, footer }` Buffers, or null if
+ *   the token is malformed, for another version or purpose, or forged
+ * ~ decodeBatch(tokens, [implicit], [threads]): an array with the payload
+ *   of each token, or null for the ones that do not verify
+ * ~ dispose(): wipes and frees the key. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var key = new sodium.PasetoKey('v4', 'local', sodium.crypto_secretbox_keygen());
+ *     var token = key.encode(JSON.stringify({ sub: 'alice' }), 'kid-1');
+ *     var claims = JSON.parse(key.decode(token).payload);
+ */
+class PasetoKey : public Napi::ObjectWrap<PasetoKey> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "PasetoKey", {
+            InstanceMethod("encode", &PasetoKey::Encode),
+            InstanceMethod("decode", &PasetoKey::Decode),
+            InstanceMethod("decodeBatch", &PasetoKey::DecodeBatch),
+            InstanceMethod("dispose", &PasetoKey::Dispose)
+        });
+        exports.Set(Napi::String::New(env, "PasetoKey"), ctor);
+    }
+
+    PasetoKey(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<PasetoKey>(info), key(NULL), key_size(0) {
+        Napi::Env env = info.Env();
+
+        unsigned char* bytes = NULL;
+        size_t size = 0;
+        if( info.Length() < 3 || !info[0].IsString() || !info[1].IsString() ||
+            !sodium_arg_bytes(info[2], bytes, size) ) {
+            Napi::TypeError::New(env, "arguments must be: version, purpose, key buffer").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string version = info[0].As<Napi::String>().Utf8Value();
+        std::string purpose = info[1].As<Napi::String>().Utf8Value();
+        if( version != "v2" && version != "v4" ) {
+            Napi::Error::New(env, "unknown PASETO version " + version).ThrowAsJavaScriptException();
+            return;
+        }
+        if( purpose != "local" && purpose != "public" ) {
+            Napi::Error::New(env, "unknown PASETO purpose " + purpose).ThrowAsJavaScriptException();
+            return;
+        }
+
+        data.version = version == "v2" ? 2 : 4;
+        data.local = purpose == "local";
+        data.header = version + "." + purpose + ".";
+        data.can_sign = false;
+        if( data.local ? size != PASETO_KEYBYTES :
+            size != crypto_sign_ed25519_SECRETKEYBYTES && size != crypto_sign_ed25519_PUBLICKEYBYTES ) {
+            Napi::Error::New(env, data.local ? "argument key must be 32 bytes long" :
+                "argument key must be a crypto_sign secret or public key").ThrowAsJavaScriptException();
+            return;
+        }
+
+        key = (unsigned char*) sodium_secret_alloc(env, size);
+        if( key == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        key_size = size;
+        memcpy(key, bytes, size);
+        sodium_secret_readonly(key);
+
+        data.key = key;
+        if( !data.local ) {
+            data.can_sign = size == crypto_sign_ed25519_SECRETKEYBYTES;
+            memcpy(data.pk, data.can_sign ? key + crypto_sign_ed25519_SEEDBYTES : key,
+                   crypto_sign_ed25519_PUBLICKEYBYTES);
+        }
+    }
+
+    ~PasetoKey() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( key != NULL ) {
+            sodium_secret_free(Env(), key, key_size);
+            key = NULL;
+            data.key = NULL;
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( key == NULL ) { \
+        THROW_ERROR("PasetoKey was disposed"); \
+    }
+
+// Implicit assertion argument, which only v4 takes
+#define ARG_TO_IMPLICIT(INDEX) \
+    std::string implicit_text; \
+    const unsigned char* implicit = NULL; \
+    size_t implicit_size = 0; \
+    if( info.Length() > (INDEX) && \
+        !paseto_arg_bytes(info[INDEX], implicit_text, implicit, implicit_size) ) { \
+        THROW_ERROR("argument implicit must be a buffer or a string"); \
+    } \
+    if( implicit_size > 0 && data.version == 2 ) { \
+        THROW_ERROR("v2 tokens have no implicit assertions"); \
+    }
+
+    Napi::Value Encode(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument payload must be a buffer or a string");
+        std::string payload_text, footer_text;
+        const unsigned char *payload = NULL, *footer = NULL;
+        size_t payload_size = 0, footer_size = 0;
+        if( !paseto_arg_bytes(info[0], payload_text, payload, payload_size) ) {
+            THROW_ERROR("argument payload must be a buffer or a string");
+        }
+        if( info.Length() > 1 && !paseto_arg_bytes(info[1], footer_text, footer, footer_size) ) {
+            THROW_ERROR("argument footer must be a buffer or a string");
+        }
+        ARG_TO_IMPLICIT(2);
+        if( !data.local && !data.can_sign ) {
+            THROW_ERROR("a public key can only decode tokens");
+        }
+
+        std::string token = data.header;
+        paseto_encode(data, token, payload, payload_size, footer, footer_size, implicit, implicit_size);
+        sodium_memzero(&payload_text[0], payload_text.size());
+        return Napi::String::New(env, token);
+    }
+
+    Napi::Value Decode(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( info.Length() < 1 || !info[0].IsString() ) {
+            THROW_ERROR("argument token must be a string");
+        }
+        ARG_TO_IMPLICIT(1);
+        std::string token = info[0].As<Napi::String>().Utf8Value();
+
+        std::vector<unsigned char> m, f;
+        if( !paseto_decode(data, token, implicit, implicit_size, m, f) ) {
+            return NAPI_NULL;
+        }
+
+        NEW_BUFFER_AND_PTR(payload, m.size());
+        NEW_BUFFER_AND_PTR(footer, f.size());
+        if( m.size() > 0 ) {
+            memcpy(payload_ptr, m.data(), m.size());
+            sodium_memzero(m.data(), m.size());
+        }
+        if( f.size() > 0 ) {
+            memcpy(footer_ptr, f.data(), f.size());
+        }
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "payload"), payload);
+        result.Set(Napi::String::New(env, "footer"), footer);
+        return result;
+    }
+
+    Napi::Value DecodeBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( info.Length() < 1 || !info[0].IsArray() ) {
+            THROW_ERROR("argument tokens must be an array of strings");
+        }
+        ARG_TO_IMPLICIT(1);
+        size_t threads = 1;
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            int _arg = 2;
+            ARG_TO_NUMBER(nthreads);
+            threads = nthreads;
+        }
+
+        Napi::Array array = info[0].As<Napi::Array>();
+        size_t count = array.Length();
+        std::vector<std::string> tokens(count);
+        for(size_t i = 0; i < count; i++) {
+            Napi::Value item = array.Get((uint32_t) i);
+            if( !item.IsString() ) {
+                THROW_ERROR("argument tokens must be an array of strings");
+            }
+            tokens[i] = item.As<Napi::String>().Utf8Value();
+        }
+
+        std::vector<std::vector<unsigned char>> payloads(count);
+        std::vector<unsigned char> ok(count, 0);
+        sodium_batch_parallel(count, threads, 64, [&](size_t begin, size_t end) {
+            std::vector<unsigned char> f;
+            for(size_t i = begin; i < end; i++) {
+                ok[i] = paseto_decode(data, tokens[i], implicit, implicit_size, payloads[i], f);
+            }
+        });
+
+        Napi::Array result = Napi::Array::New(env, count);
+        for(size_t i = 0; i < count; i++) {
+            if( !ok[i] ) {
+                result.Set((uint32_t) i, env.Null());
+                continue;
+            }
+            NEW_BUFFER_AND_PTR(payload, payloads[i].size());
+            if( payloads[i].size() > 0 ) {
+                memcpy(payload_ptr, payloads[i].data(), payloads[i].size());
+                sodium_memzero(payloads[i].data(), payloads[i].size());
+            }
+            result.Set((uint32_t) i, payload);
+        }
+        return result;
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+#undef ARG_TO_IMPLICIT
+
+    PasetoKeyData data;
+    unsigned char* key;
+    size_t key_size;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_paseto(Napi::Env env, Napi::Object exports) {
+    PasetoKey::Init(env, exports);
+}
@@ -5,7 +5,18 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "node_sodium.h"
+#include "sodium_stats.h"
+#include "node_sodium_async.h"
 
 
 /*
@@ -37,7 +48,8 @@ NAPI_METHOD(crypto_pwhash) {
         THROW_ERROR("output buffer length must be bigger than 0.");
     }
     NEW_BUFFER_AND_PTR(out, outLen);
-    if (crypto_pwhash(out_ptr, outLen, passwd, passwd_size, salt, oppLimit, memLimit, alg) == 0) {
+    if (SODIUM_STAT(pwhash, passwd_size, outLen,
+            crypto_pwhash(out_ptr, outLen, passwd, passwd_size, salt, oppLimit, memLimit, alg)) == 0) {
         return out;
     }
     return NAPI_NULL;
@@ -65,7 +77,8 @@ NAPI_METHOD(crypto_pwhash_str) {
 
     NEW_BUFFER_AND_PTR(out, crypto_pwhash_STRBYTES);
 
-    if (crypto_pwhash_str((char*)out_ptr, passwd, passwd_size, oppLimit, memLimit) == 0) {
+    if (SODIUM_STAT(pwhash, passwd_size, crypto_pwhash_STRBYTES,
+            crypto_pwhash_str((char*)out_ptr, passwd, passwd_size, oppLimit, memLimit)) == 0) {
         return out;
     }
 
@@ -133,6 +146,520 @@ NAPI_METHOD(crypto_pwhash_str_alg) {
     return NAPI_NULL;
 }
 
+/**
+ * Async versions of crypto_pwhash, crypto_pwhash_str and
+ * crypto_pwhash_str_verify. The hash runs on the password hashing pool
+ * (see sodium_pwhash_pool.cc) so the event loop is not blocked while Argon2
+ * fills its memory, and the libuv threadpool stays free for I/O.
+ *
+ * Arguments are the same as the sync versions plus an optional callback.
+ * With a callback the result is delivered as callback(err, result),
+ * otherwise a Promise is returned. Results match the sync versions.
+ */
+NAPI_METHOD(crypto_pwhash_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments must be: output buffer length, password buffer, salt buffer, oLimit, memLimit, algorithm");
+
+    ARG_TO_NUMBER(outLen);
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_UCHAR_BUFFER_LEN(salt, crypto_pwhash_SALTBYTES);
+    ARG_TO_NUMBER(oppLimit);
+    ARG_TO_NUMBER(memLimit);
+    ARG_TO_NUMBER(alg);
+    if( outLen <= 0 ) {
+        THROW_ERROR("output buffer length must be bigger than 0.");
+    }
+    NEW_BUFFER_AND_PTR(out, outLen);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash");
+    unsigned char* o = worker->Pin(out);
+    const char* p = (const char*) worker->Copy(passwd, passwd_size);
+    const unsigned char* s = worker->Copy(salt, salt_size);
+
+    return worker->StartPwhash([=]() {
+        return SODIUM_STAT(pwhash, passwd_size, outLen,
+            crypto_pwhash(o, outLen, p, passwd_size, s, oppLimit, memLimit, alg));
+    }, ASYNC_RESULT_BUFFER);
+}
+
+NAPI_METHOD(crypto_pwhash_str_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: password buffer, oLimit, memLimit");
+
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_NUMBER(oppLimit);
+    ARG_TO_NUMBER(memLimit);
+
+    NEW_BUFFER_AND_PTR(out, crypto_pwhash_STRBYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_str");
+    char* o = (char*) worker->Pin(out);
+    const char* p = (const char*) worker->Copy(passwd, passwd_size);
+
+    return worker->StartPwhash([=]() {
+        return SODIUM_STAT(pwhash, passwd_size, crypto_pwhash_STRBYTES,
+            crypto_pwhash_str(o, p, passwd_size, oppLimit, memLimit));
+    }, ASYNC_RESULT_BUFFER);
+}
+
+NAPI_METHOD(crypto_pwhash_str_verify_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: pwhash string, password");
+
+    ARG_TO_UCHAR_BUFFER_LEN(hash, crypto_pwhash_STRBYTES);
+    ARG_TO_BUFFER_TYPE(passwd, char);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_str_verify");
+    const char* h = (const char*) worker->Copy(hash, hash_size);
+    const char* p = (const char*) worker->Copy(passwd, passwd_size);
+
+    return worker->StartPwhash([=]() {
+        return crypto_pwhash_str_verify(h, p, passwd_size);
+    }, ASYNC_RESULT_BOOLEAN);
+}
+
+/**
+ * Verify and rehash
+ *
+ * Raising the Argon2 limits means checking every login with
+ * crypto_pwhash_str_verify, then crypto_pwhash_str_needs_rehash, then
+ * hashing the password again with crypto_pwhash_str: three calls, and two
+ * memory hard hashes one after the other. These jobs do all of it on one
+ * password hashing thread.
+ *
+ * A hash needs rehashing when its limits are not the ones given, when it
+ * was not made with the default algorithm, so Argon2i hashes move to
+ * Argon2id, or when it cannot be parsed.
+ */
+struct PwhashRehashEntry {
+    char hash[crypto_pwhash_STRBYTES];
+    const char* passwd;
+    size_t passwd_size;
+    bool valid;
+    bool needs_rehash;
+    bool rehashed;
+    char new_hash[crypto_pwhash_STRBYTES];
+};
+
+static bool pwhash_needs_rehash(const char* hash, unsigned long long opslimit, size_t memlimit) {
+    return crypto_pwhash_str_needs_rehash(hash, opslimit, memlimit) != 0 ||
+           strncmp(hash, crypto_pwhash_STRPREFIX, sizeof(crypto_pwhash_STRPREFIX) - 1) != 0;
+}
+
+// A hash string, as a Buffer from crypto_pwhash_str or a String, copied
+// zero padded to `out`
+static bool pwhash_arg_str(Napi::Value value, char* out) {
+    memset(out, 0, crypto_pwhash_STRBYTES);
+    if( value.IsString() ) {
+        std::string s = value.As<Napi::String>().Utf8Value();
+        if( s.size() >= crypto_pwhash_STRBYTES ) {
+            return false;
+        }
+        memcpy(out, s.data(), s.size());
+        return true;
+    }
+    unsigned char* data = NULL;
+    size_t size = 0;
+    if( !sodium_arg_bytes(value, data, size) || size > crypto_pwhash_STRBYTES ) {
+        return false;
+    }
+    memcpy(out, data, size);
+    out[crypto_pwhash_STRBYTES - 1] = 0;
+    return true;
+}
+
+class PwhashRehashWorker : public SodiumAsyncWorker {
+public:
+    PwhashRehashWorker(const Napi::CallbackInfo& info, const char* name, bool batch,
+                       unsigned long long opslimit, size_t memlimit)
+        : SodiumAsyncWorker(info, name), batch(batch), opslimit(opslimit), memlimit(memlimit),
+          verify(true) {}
+
+    ~PwhashRehashWorker() {
+        sodium_memzero(entries.data(), entries.size() * sizeof(PwhashRehashEntry));
+    }
+
+    std::vector<PwhashRehashEntry> entries;
+    // False for a batch without passwords, which only sorts out stale hashes
+    bool verify;
+
+protected:
+    void Run() override {
+        for(auto& entry : entries) {
+            if( Cancelled() ) {
+                SetError("cancelled");
+                return;
+            }
+            entry.needs_rehash = pwhash_needs_rehash(entry.hash, opslimit, memlimit);
+            if( !verify ) {
+                continue;
+            }
+            entry.valid = crypto_pwhash_str_verify(entry.hash, entry.passwd, entry.passwd_size) == 0;
+            // A rehash that fails, for lack of memory, leaves the old hash
+            entry.rehashed = entry.valid && entry.needs_rehash &&
+                SODIUM_STAT(pwhash, entry.passwd_size, crypto_pwhash_STRBYTES,
+                    crypto_pwhash_str(entry.new_hash, entry.passwd, entry.passwd_size, opslimit, memlimit)) == 0;
+        }
+        status = 0;
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        if( !batch ) {
+            PwhashRehashEntry& entry = entries[0];
+            Napi::Object result = Napi::Object::New(env);
+            result.Set("valid", Napi::Boolean::New(env, entry.valid));
+            result.Set("newHash", NewHash(env, entry));
+            return result;
+        }
+
+        Napi::Object result = Napi::Object::New(env);
+        Napi::Uint8Array needs = Napi::Uint8Array::New(env, entries.size());
+        for(size_t i = 0; i < entries.size(); i++) {
+            needs[i] = entries[i].needs_rehash;
+        }
+        result.Set("needsRehash", needs);
+        if( verify ) {
+            Napi::Uint8Array valid = Napi::Uint8Array::New(env, entries.size());
+            Napi::Array hashes = Napi::Array::New(env, entries.size());
+            for(size_t i = 0; i < entries.size(); i++) {
+                valid[i] = entries[i].valid;
+                hashes.Set((uint32_t) i, NewHash(env, entries[i]));
+            }
+            result.Set("valid", valid);
+            result.Set("newHashes", hashes);
+        }
+        return result;
+    }
+
+private:
+    // The new hash, as crypto_pwhash_str returns it, or null
+    static Napi::Value NewHash(Napi::Env env, const PwhashRehashEntry& entry) {
+        if( !entry.rehashed ) {
+            return env.Null();
+        }
+        return Napi::Buffer<unsigned char>::Copy(env, (const unsigned char*) entry.new_hash, crypto_pwhash_STRBYTES);
+    }
+
+    bool batch;
+    unsigned long long opslimit;
+    size_t memlimit;
+};
+
+/**
+ * crypto_pwhash_str_verify_rehash_async:
+ * Verify a password and hash it again if its hash is stale, in one job on
+ * the password hashing pool
+ *
+ *     sodium.crypto_pwhash_str_verify_rehash_async(pwhash, passwd, opsLimit, memLimit, [options], [callback]);
+ *
+ * ~ pwhash (Buffer|String): hash from crypto_pwhash_str
+ * ~ passwd (Buffer): password to check
+ * ~ opsLimit, memLimit (Number): the limits hashes should have
+ * ~ options (Object): optional, `signal`, `deadline` and `timeout`
+ *
+ * **Returns**:
+ *
+ * ~ a Promise, when no callback is given, for `{ valid, newHash }`.
+ *   `newHash` is null unless the password is valid and its hash needed
+ *   rehashing; store it in place of `pwhash`
+ */
+NAPI_METHOD(crypto_pwhash_str_verify_rehash_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: pwhash string, password, oLimit, memLimit");
+
+    char hash[crypto_pwhash_STRBYTES];
+    if( !pwhash_arg_str(info[0], hash) ) {
+        THROW_ERROR("argument pwhash must be a buffer or string of at most crypto_pwhash_STRBYTES bytes");
+    }
+    _arg++;
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_NUMBER(oppLimit);
+    ARG_TO_NUMBER(memLimit);
+
+    PwhashRehashWorker* worker = new PwhashRehashWorker(info, "crypto_pwhash_str_verify_rehash",
+                                                        false, oppLimit, memLimit);
+    PwhashRehashEntry entry = {};
+    memcpy(entry.hash, hash, sizeof hash);
+    entry.passwd = (const char*) worker->Copy(passwd, passwd_size);
+    entry.passwd_size = passwd_size;
+    worker->entries.push_back(entry);
+    sodium_memzero(&entry, sizeof entry);
+
+    return worker->StartPwhash(nullptr, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_pwhash_str_verify_rehash_batch_async:
+ * crypto_pwhash_str_verify_rehash_async over a table of hashes, for
+ * offline migrations
+ *
+ *     sodium.crypto_pwhash_str_verify_rehash_batch_async(pwhashes, passwds, opsLimit, memLimit, [options], [callback]);
+ *
+ * ~ pwhashes (Array): hashes, Buffers or Strings
+ * ~ passwds (Array|null): the password of each hash. With null the hashes
+ *   are only checked against the limits, without hashing
+ *
+ * The batch runs on one password hashing thread, one hash after the other,
+ * so a migration leaves the other threads of the pool to logins. It stops
+ * between hashes once cancelled.
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for `{ needsRehash, valid, newHashes }`: a Uint8Array with 1
+ *   for each stale hash, and with passwords a Uint8Array with 1 for each
+ *   valid one and an Array with each new hash or null
+ */
+NAPI_METHOD(crypto_pwhash_str_verify_rehash_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: pwhash strings, passwords, oLimit, memLimit");
+
+    if( !info[0].IsArray() ) {
+        THROW_ERROR("argument pwhashes must be an array");
+    }
+    Napi::Array hashes = info[0].As<Napi::Array>();
+    bool verify = !info[1].IsNull();
+    if( verify && (!info[1].IsArray() || info[1].As<Napi::Array>().Length() != hashes.Length()) ) {
+        THROW_ERROR("argument passwds must be an array with a password per hash, or null");
+    }
+    _arg = 2;
+    ARG_TO_NUMBER(oppLimit);
+    ARG_TO_NUMBER(memLimit);
+
+    PwhashRehashWorker* worker = new PwhashRehashWorker(info, "crypto_pwhash_str_verify_rehash_batch",
+                                                        true, oppLimit, memLimit);
+    worker->verify = verify;
+    worker->entries.resize(hashes.Length());
+    for(uint32_t i = 0; i < hashes.Length(); i++) {
+        PwhashRehashEntry& entry = worker->entries[i];
+        if( !pwhash_arg_str(hashes.Get(i), entry.hash) ) {
+            delete worker;
+            THROW_ERROR("argument pwhashes must hold buffers or strings of at most crypto_pwhash_STRBYTES bytes");
+        }
+        if( verify ) {
+            unsigned char* passwd = NULL;
+            size_t passwd_size = 0;
+            if( !sodium_arg_bytes(info[1].As<Napi::Array>().Get(i), passwd, passwd_size) ) {
+                delete worker;
+                THROW_ERROR("argument passwds must hold buffers");
+            }
+            entry.passwd = (const char*) worker->Copy(passwd, passwd_size);
+            entry.passwd_size = passwd_size;
+        }
+    }
+
+    return worker->StartPwhash(nullptr, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * Parameter calibration
+ *
+ * The INTERACTIVE/MODERATE/SENSITIVE constants are fixed points; how long
+ * they take depends on the host. `crypto_pwhash_calibrate` times real
+ * hashes on this machine, with the Argon2 kernel libsodium picked for its
+ * CPU, and returns the limits that fit a latency budget. Following the
+ * libsodium advice it spends the budget on memory first: it starts at
+ * `maxMem`, halves it until one pass fits, then raises the passes.
+ */
+
+#define PWHASH_CALIBRATE_ROUNDS 2
+
+struct PwhashCalibration {
+    unsigned long long opslimit;
+    size_t memlimit;
+    double ms;
+};
+
+static std::mutex pwhash_calibrate_lock;
+static std::map<std::string, PwhashCalibration>& pwhash_calibrate_cache =
+    *new std::map<std::string, PwhashCalibration>();
+
+// Milliseconds of wall time for `concurrency` hashes run at once, or a
+// negative number if one of them failed
+static double pwhash_calibrate_time(unsigned long long ops, size_t mem, int alg, size_t concurrency) {
+    std::atomic<bool> failed(false);
+    auto run = [&]() {
+        unsigned char out[32];
+        unsigned char salt[crypto_pwhash_SALTBYTES] = { 0 };
+        if( crypto_pwhash(out, sizeof out, "calibrate", 9, salt, ops, mem, alg) != 0 ) {
+            failed = true;
+        }
+    };
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> others;
+    for(size_t i = 1; i < concurrency; i++) {
+        others.emplace_back(run);
+    }
+    run();
+    for(std::thread& t : others) {
+        t.join();
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return failed ? -1 : ms;
+}
+
+static bool pwhash_calibrate_option(Napi::Object options, const char* name, double min, double max, double& value) {
+    Napi::Value v = options.Get(name);
+    if( v.IsUndefined() ) {
+        return true;
+    }
+    if( !v.IsNumber() ) {
+        return false;
+    }
+    double n = v.As<Napi::Number>().DoubleValue();
+    if( !(n >= min && n <= max) ) {
+        return false;
+    }
+    value = n;
+    return true;
+}
+
+/**
+ * crypto_pwhash_calibrate:
+ * Find the Argon2 limits that take `targetMs` on this host
+ *
+ *     var params = sodium.crypto_pwhash_calibrate({ targetMs: 250 });
+ *     sodium.crypto_pwhash_str(password, params.opslimit, params.memlimit);
+ *
+ * ~ options.targetMs (Number): latency budget of one hash, in milliseconds
+ * ~ options.maxMem (Number): optional, most memory to use, in bytes.
+ *   `crypto_pwhash_MEMLIMIT_MODERATE` by default
+ * ~ options.alg (Number): optional, `crypto_pwhash_ALG_ARGON2ID13` or
+ *   `crypto_pwhash_ALG_ARGON2I13`, `crypto_pwhash_ALG_DEFAULT` by default
+ * ~ options.concurrency (Number): optional, hashes to time at once, 1 by
+ *   default. Set it to the password hashing pool `threads` to budget for
+ *   hashes competing for memory bandwidth
+ * ~ options.cache (Boolean): optional, reuse the result of an earlier call
+ *   with the same options, true by default
+ *
+ * Calibration runs several hashes of up to `targetMs` each and blocks the
+ * thread meanwhile: call it at startup, or from a worker.
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ opslimit, memlimit, alg, ms, met, concurrency, kernel,
+ *   cached }`. `ms` is the measured time of the returned limits. `met` is
+ *   false when even the smallest limits take longer than `targetMs`, and
+ *   `kernel` names the Argon2 implementation that ran
+ */
+NAPI_METHOD(crypto_pwhash_calibrate) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument options must be an object");
+    if( !info[0].IsObject() ) {
+        THROW_ERROR("argument options must be an object");
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+
+    double targetMs = 0;
+    double maxMem = (double) crypto_pwhash_MEMLIMIT_MODERATE;
+    double alg = crypto_pwhash_ALG_DEFAULT;
+    double concurrency = 1;
+    if( options.Get("targetMs").IsUndefined() ||
+        !pwhash_calibrate_option(options, "targetMs", 1, 1e6, targetMs) ) {
+        THROW_ERROR("options.targetMs must be a number of milliseconds between 1 and 1000000");
+    }
+    if( !pwhash_calibrate_option(options, "maxMem", crypto_pwhash_MEMLIMIT_MIN, (double) crypto_pwhash_MEMLIMIT_MAX, maxMem) ) {
+        THROW_ERROR("options.maxMem must be between crypto_pwhash_MEMLIMIT_MIN and crypto_pwhash_MEMLIMIT_MAX");
+    }
+    if( !pwhash_calibrate_option(options, "alg", 0, 10, alg) ||
+        (alg != crypto_pwhash_ALG_ARGON2ID13 && alg != crypto_pwhash_ALG_ARGON2I13) ) {
+        THROW_ERROR("options.alg must be crypto_pwhash_ALG_ARGON2ID13 or crypto_pwhash_ALG_ARGON2I13");
+    }
+    if( !pwhash_calibrate_option(options, "concurrency", 1, 64, concurrency) || concurrency != (double) (size_t) concurrency ) {
+        THROW_ERROR("options.concurrency must be an integer between 1 and 64");
+    }
+    Napi::Value cacheOption = options.Get("cache");
+    bool useCache = cacheOption.IsUndefined() || cacheOption.ToBoolean().Value();
+
+    int a = (int) alg;
+    size_t threads = (size_t) concurrency;
+    size_t minMem = crypto_pwhash_MEMLIMIT_MIN;
+    unsigned long long minOps = a == crypto_pwhash_ALG_ARGON2I13 ?
+        crypto_pwhash_argon2i_OPSLIMIT_MIN : crypto_pwhash_argon2id_OPSLIMIT_MIN;
+    unsigned long long maxOps = crypto_pwhash_OPSLIMIT_MAX;
+
+    std::string key = std::to_string(targetMs) + "/" + std::to_string(maxMem) + "/" +
+                      std::to_string(a) + "/" + std::to_string(threads);
+    PwhashCalibration found;
+    bool cached = false;
+    if( useCache ) {
+        std::lock_guard<std::mutex> guard(pwhash_calibrate_lock);
+        auto it = pwhash_calibrate_cache.find(key);
+        if( it != pwhash_calibrate_cache.end() ) {
+            found = it->second;
+            cached = true;
+        }
+    }
+
+    if( !cached ) {
+        // Spend the budget on memory first: halve it until one pass fits
+        size_t mem = ((size_t) maxMem / 1024) * 1024;
+        unsigned long long ops = minOps;
+        double ms = pwhash_calibrate_time(ops, mem, a, threads);
+        while( (ms < 0 || ms > targetMs) && mem > minMem ) {
+            mem = ((mem / 2) / 1024) * 1024;
+            if( mem < minMem ) {
+                mem = minMem;
+            }
+            ms = pwhash_calibrate_time(ops, mem, a, threads);
+        }
+        if( ms < 0 ) {
+            THROW_ERROR("could not compute a password hash to calibrate with");
+        }
+
+        // Then the passes: Argon2 time grows linearly with them
+        for(int round = 0; round < PWHASH_CALIBRATE_ROUNDS && ms > 0; round++) {
+            double scaled = (double) ops * targetMs / ms;
+            unsigned long long next = scaled > (double) maxOps ? maxOps : (unsigned long long) scaled;
+            if( next < minOps ) {
+                next = minOps;
+            }
+            if( next == ops ) {
+                break;
+            }
+            double t = pwhash_calibrate_time(next, mem, a, threads);
+            if( t < 0 ) {
+                break;
+            }
+            if( t > targetMs && next > ops ) {
+                // Overshot: settle between the two measurements
+                unsigned long long back = (unsigned long long) ((double) next * targetMs / t);
+                if( back <= ops ) {
+                    break;
+                }
+                next = back;
+                t = pwhash_calibrate_time(next, mem, a, threads);
+                if( t < 0 || t > targetMs ) {
+                    break;
+                }
+            }
+            ops = next;
+            ms = t;
+        }
+
+        found = { ops, mem, ms };
+        std::lock_guard<std::mutex> guard(pwhash_calibrate_lock);
+        pwhash_calibrate_cache[key] = found;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "opslimit"), Napi::Number::New(env, (double) found.opslimit));
+    result.Set(Napi::String::New(env, "memlimit"), Napi::Number::New(env, (double) found.memlimit));
+    result.Set(Napi::String::New(env, "alg"), Napi::Number::New(env, a));
+    result.Set(Napi::String::New(env, "ms"), Napi::Number::New(env, found.ms));
+    result.Set(Napi::String::New(env, "met"), Napi::Boolean::New(env, found.ms <= targetMs));
+    result.Set(Napi::String::New(env, "concurrency"), Napi::Number::New(env, (double) threads));
+    result.Set(Napi::String::New(env, "kernel"), Napi::String::New(env, sodium_implementation_selected("pwhash_argon2")));
+    result.Set(Napi::String::New(env, "cached"), Napi::Boolean::New(env, cached));
+    return result;
+}
+
 NAPI_METHOD_FROM_INT(crypto_pwhash_bytes_max)
 NAPI_METHOD_FROM_INT(crypto_pwhash_bytes_min)
 NAPI_METHOD_FROM_INT(crypto_pwhash_opslimit_max)
@@ -167,6 +694,14 @@ void register_crypto_pwhash(Napi::Env env, Napi::Object exports) {
     EXPORT(crypto_pwhash_str_alg);
     EXPORT(crypto_pwhash_str_needs_rehash);
 
+    EXPORT(crypto_pwhash_async);
+    EXPORT(crypto_pwhash_str_async);
+    EXPORT(crypto_pwhash_str_verify_async);
+    EXPORT(crypto_pwhash_str_verify_rehash_async);
+    EXPORT(crypto_pwhash_str_verify_rehash_batch_async);
+
+    EXPORT(crypto_pwhash_calibrate);
+
     EXPORT(crypto_pwhash_alg_default);
     EXPORT(crypto_pwhash_alg_argon2id13);
     EXPORT(crypto_pwhash_alg_argon2i13);
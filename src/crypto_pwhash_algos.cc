@@ -5,9 +5,104 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
 #include "node_sodium.h"
 #include "crypto_pwhash_algos.h"
 
+/**
+ * Parallel lanes
+ *
+ * scrypt with p > 1 runs p independent SMix lanes between its two PBKDF2
+ * steps, and libsodium runs them one after the other. The vendored escrypt
+ * (crypto_scrypt.h) hands them to a runner when one is set; this one
+ * spreads them over threads for the hashes that ask for it, so the wall time
+ * of `_ll_async` drops with the cores while the result stays the same. Each
+ * lane running at the same time holds its own 128 * r * N bytes.
+ *
+ * Argon2 with p > 1 lanes splits its memory into p rows, and the segments
+ * of one slice in different rows only read blocks of earlier slices. The
+ * vendored Argon2 (argon2-core.h) hands each of the 4 slices of a pass to
+ * the same runner, so the lanes of `crypto_pwhash_argon2id_parallel` fill
+ * on several cores over one shared region. libsodium itself always hashes
+ * with one lane, and leaves the runner unused.
+ */
+extern "C" {
+typedef int (*escrypt_lane_fn)(void *ctx, uint32_t lane);
+typedef int (*escrypt_lanes_runner_t)(escrypt_lane_fn lane, void *ctx, uint32_t p);
+
+void escrypt_set_lanes_runner(escrypt_lanes_runner_t run);
+
+typedef int (*argon2_lane_fn)(void *ctx, uint32_t lane);
+typedef int (*argon2_lanes_runner_t)(argon2_lane_fn lane, void *ctx, uint32_t lanes);
+
+void argon2_set_lanes_runner(argon2_lanes_runner_t run);
+
+int argon2id_hash_raw(const uint32_t t_cost, const uint32_t m_cost,
+                      const uint32_t parallelism, const void *pwd,
+                      const size_t pwdlen, const void *salt,
+                      const size_t saltlen, void *hash, const size_t hashlen);
+int argon2id_hash_encoded(const uint32_t t_cost, const uint32_t m_cost,
+                          const uint32_t parallelism, const void *pwd,
+                          const size_t pwdlen, const void *salt,
+                          const size_t saltlen, const size_t hashlen,
+                          char *encoded, const size_t encodedlen);
+}
+
+// Threads the hash running on this thread may use, 0 or 1 to decline
+static thread_local size_t pwhash_lane_threads = 0;
+
+static int pwhash_run_lanes(escrypt_lane_fn lane, void* ctx, uint32_t p) {
+    size_t threads = std::min<size_t>(pwhash_lane_threads, p);
+    if( threads < 2 ) {
+        return 1;
+    }
+
+    std::atomic<uint32_t> next(0);
+    std::atomic<bool> failed(false);
+    auto work = [&]() {
+        for(uint32_t i; (i = next++) < p; ) {
+            if( lane(ctx, i) != 0 ) {
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> helpers;
+    try {
+        for(size_t i = 1; i < threads; i++) {
+            helpers.emplace_back(work);
+        }
+    } catch(const std::system_error&) {
+        // Fewer threads than asked for: the ones started take the rest
+    }
+    work();
+    for(std::thread& t : helpers) {
+        t.join();
+    }
+    return failed ? -1 : 0;
+}
+
+int pwhash_lanes(size_t threads, const std::function<int()>& hash) {
+    static std::once_flag installed;
+    std::call_once(installed, [] {
+        escrypt_set_lanes_runner(pwhash_run_lanes);
+        argon2_set_lanes_runner(pwhash_run_lanes);
+    });
+
+    if( threads == 0 ) {
+        threads = std::max<unsigned>(std::thread::hardware_concurrency(), 1);
+    }
+    pwhash_lane_threads = threads;
+    int ret = hash();
+    pwhash_lane_threads = 0;
+    return ret;
+}
+
 
 CRYPTO_PWHASH_DEF_EXT(argon2i)
 CRYPTO_PWHASH_DEF_STR(argon2i)
@@ -22,6 +117,251 @@ NAPI_METHOD_FROM_INT(crypto_pwhash_argon2id_opslimit_moderate)
 NAPI_METHOD_FROM_INT(crypto_pwhash_argon2id_memlimit_moderate)
 NAPI_METHOD_FROM_INT(crypto_pwhash_argon2id_alg_argon2id13);
 
+/**
+ * Argon2id with several lanes
+ *
+ * `crypto_pwhash_argon2id` fixes the parallelism at one lane, so a hash of
+ * 256MB runs on one core. These take the number of `lanes` p, and fill them
+ * on up to `threads` threads: 0, the default, uses one per lane up to the
+ * number of CPUs. The result depends on `lanes` but not on `threads`, and
+ * is the RFC 9106 Argon2id of the same parameters. The hash strings read
+ * `$argon2id$v=19$m=...,t=...,p=N$`, which `crypto_pwhash_str_verify` and
+ * other Argon2 libraries already accept; `_str_verify_parallel` checks
+ * them on several threads too.
+ *
+ * Each thread is a core held for the whole hash, on top of the password
+ * hashing pool thread of the async calls.
+ */
+#define PWHASH_ARGON2_MAX_LANES 255
+
+#define ARG_TO_ARGON2_THREADS(I) \
+    size_t lane_threads = 0; \
+    if( info.Length() > (I) && !info[I].IsFunction() && !info[I].IsUndefined() && !sodium_async_is_options(info[I]) ) { \
+        GET_ARG_AS_NUMBER(I, threads); \
+        if( threads < 1 || threads > PWHASH_MAX_LANE_THREADS ) { \
+            THROW_ERROR("argument threads must be between 1 and 64"); \
+        } \
+        lane_threads = threads; \
+    }
+
+static const char* pwhash_argon2id_parallel_check(size_t passwdlen, size_t opslimit,
+                                                  size_t memlimit, size_t lanes) {
+    if( passwdlen > crypto_pwhash_argon2id_PASSWD_MAX ) {
+        return "password is too long";
+    }
+    if( opslimit < crypto_pwhash_argon2id_OPSLIMIT_MIN || opslimit > crypto_pwhash_argon2id_OPSLIMIT_MAX ) {
+        return "opsLimit is out of range";
+    }
+    if( memlimit < crypto_pwhash_argon2id_MEMLIMIT_MIN || memlimit > crypto_pwhash_argon2id_MEMLIMIT_MAX ) {
+        return "memLimit is out of range";
+    }
+    if( lanes < 1 || lanes > PWHASH_ARGON2_MAX_LANES ) {
+        return "argument lanes must be between 1 and 255";
+    }
+    // Argon2 needs 8 blocks of 1KB per lane
+    if( memlimit / 1024 < 8 * lanes ) {
+        return "memLimit must be at least 8KB per lane";
+    }
+    return NULL;
+}
+
+static int pwhash_argon2id_parallel(unsigned char* out, size_t outlen, const char* passwd, size_t passwdlen,
+                                    const unsigned char* salt, size_t opslimit, size_t memlimit, size_t lanes) {
+    return argon2id_hash_raw((uint32_t) opslimit, (uint32_t) (memlimit / 1024U), (uint32_t) lanes,
+                             passwd, passwdlen, salt, crypto_pwhash_argon2id_SALTBYTES, out, outlen) == 0 ? 0 : -1;
+}
+
+static int pwhash_argon2id_str_parallel(char* out, const char* passwd, size_t passwdlen,
+                                        size_t opslimit, size_t memlimit, size_t lanes) {
+    unsigned char salt[crypto_pwhash_argon2id_SALTBYTES];
+    randombytes_buf(salt, sizeof salt);
+
+    // 32 byte tags, as crypto_pwhash_argon2id_str
+    memset(out, 0, crypto_pwhash_argon2id_STRBYTES);
+    return argon2id_hash_encoded((uint32_t) opslimit, (uint32_t) (memlimit / 1024U), (uint32_t) lanes,
+                                 passwd, passwdlen, salt, sizeof salt, 32U,
+                                 out, crypto_pwhash_argon2id_STRBYTES) == 0 ? 0 : -1;
+}
+
+/**
+ * crypto_pwhash_argon2id_parallel:
+ * Derive `outLen` bytes from a password with Argon2id over `lanes` lanes
+ *
+ *     var out = sodium.crypto_pwhash_argon2id_parallel(outLen, passwd, salt, opsLimit, memLimit, lanes, [threads]);
+ *     sodium.crypto_pwhash_argon2id_parallel_async(outLen, passwd, salt, opsLimit, memLimit, lanes,
+ *                                                  [threads], [options], [callback]);
+ */
+NAPI_METHOD(crypto_pwhash_argon2id_parallel) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments must be: output length, password buffer, salt buffer, opsLimit, memLimit, lanes");
+    ARG_TO_NUMBER(outLen);
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_UCHAR_BUFFER_LEN(salt, crypto_pwhash_argon2id_SALTBYTES);
+    ARG_TO_NUMBER(opsLimit);
+    ARG_TO_NUMBER(memLimit);
+    ARG_TO_NUMBER(lanes);
+    ARG_TO_ARGON2_THREADS(6);
+
+    if( outLen < crypto_pwhash_argon2id_BYTES_MIN || outLen > crypto_pwhash_argon2id_BYTES_MAX ) {
+        THROW_ERROR("output length is out of range");
+    }
+    const char* invalid = pwhash_argon2id_parallel_check(passwd_size, opsLimit, memLimit, lanes);
+    if( invalid != NULL ) {
+        THROW_ERROR(invalid);
+    }
+
+    NEW_BUFFER_AND_PTR(out, outLen);
+    int ret = pwhash_lanes(lane_threads, [&]() {
+        return pwhash_argon2id_parallel(out_ptr, outLen, passwd, passwd_size, salt, opsLimit, memLimit, lanes);
+    });
+    if( ret == 0 ) {
+        return out;
+    }
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_pwhash_argon2id_parallel_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments must be: output length, password buffer, salt buffer, opsLimit, memLimit, lanes");
+    ARG_TO_NUMBER(outLen);
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_UCHAR_BUFFER_LEN(salt, crypto_pwhash_argon2id_SALTBYTES);
+    ARG_TO_NUMBER(opsLimit);
+    ARG_TO_NUMBER(memLimit);
+    ARG_TO_NUMBER(lanes);
+    ARG_TO_ARGON2_THREADS(6);
+
+    if( outLen < crypto_pwhash_argon2id_BYTES_MIN || outLen > crypto_pwhash_argon2id_BYTES_MAX ) {
+        THROW_ERROR("output length is out of range");
+    }
+    const char* invalid = pwhash_argon2id_parallel_check(passwd_size, opsLimit, memLimit, lanes);
+    if( invalid != NULL ) {
+        THROW_ERROR(invalid);
+    }
+
+    NEW_BUFFER_AND_PTR(out, outLen);
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_argon2id_parallel");
+    unsigned char* o = worker->Pin(out);
+    const char* p = (const char*) worker->Copy(passwd, passwd_size);
+    const unsigned char* s = worker->Copy(salt, salt_size);
+    return worker->StartPwhash([=]() {
+        return pwhash_lanes(lane_threads, [=]() {
+            return pwhash_argon2id_parallel(o, outLen, p, passwd_size, s, opsLimit, memLimit, lanes);
+        });
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_pwhash_argon2id_str_parallel:
+ * Hash a password for storage with Argon2id over `lanes` lanes
+ *
+ *     var hash = sodium.crypto_pwhash_argon2id_str_parallel(passwd, opsLimit, memLimit, lanes, [threads]);
+ *     sodium.crypto_pwhash_argon2id_str_parallel_async(passwd, opsLimit, memLimit, lanes,
+ *                                                      [threads], [options], [callback]);
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: `crypto_pwhash_argon2id_STRBYTES` bytes, the hash string padded
+ *   with zeros, as `crypto_pwhash_argon2id_str`
+ */
+NAPI_METHOD(crypto_pwhash_argon2id_str_parallel) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: password buffer, opsLimit, memLimit, lanes");
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_NUMBER(opsLimit);
+    ARG_TO_NUMBER(memLimit);
+    ARG_TO_NUMBER(lanes);
+    ARG_TO_ARGON2_THREADS(4);
+
+    const char* invalid = pwhash_argon2id_parallel_check(passwd_size, opsLimit, memLimit, lanes);
+    if( invalid != NULL ) {
+        THROW_ERROR(invalid);
+    }
+
+    NEW_BUFFER_AND_PTR(out, crypto_pwhash_argon2id_STRBYTES);
+    int ret = pwhash_lanes(lane_threads, [&]() {
+        return pwhash_argon2id_str_parallel((char*) out_ptr, passwd, passwd_size, opsLimit, memLimit, lanes);
+    });
+    if( ret == 0 ) {
+        return out;
+    }
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_pwhash_argon2id_str_parallel_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: password buffer, opsLimit, memLimit, lanes");
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_NUMBER(opsLimit);
+    ARG_TO_NUMBER(memLimit);
+    ARG_TO_NUMBER(lanes);
+    ARG_TO_ARGON2_THREADS(4);
+
+    const char* invalid = pwhash_argon2id_parallel_check(passwd_size, opsLimit, memLimit, lanes);
+    if( invalid != NULL ) {
+        THROW_ERROR(invalid);
+    }
+
+    NEW_BUFFER_AND_PTR(out, crypto_pwhash_argon2id_STRBYTES);
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_argon2id_str_parallel");
+    char* o = (char*) worker->Pin(out);
+    const char* p = (const char*) worker->Copy(passwd, passwd_size);
+    return worker->StartPwhash([=]() {
+        return pwhash_lanes(lane_threads, [=]() {
+            return pwhash_argon2id_str_parallel(o, p, passwd_size, opsLimit, memLimit, lanes);
+        });
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_pwhash_argon2id_str_verify_parallel:
+ * Check a password against an Argon2id hash string, filling its lanes on
+ * up to `threads` threads
+ *
+ *     var ok = sodium.crypto_pwhash_argon2id_str_verify_parallel(hash, passwd, [threads]);
+ *     sodium.crypto_pwhash_argon2id_str_verify_parallel_async(hash, passwd, [threads], [options], [callback]);
+ */
+NAPI_METHOD(crypto_pwhash_argon2id_str_verify_parallel) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: pwhash string, password");
+    ARG_TO_UCHAR_BUFFER_LEN(hash, crypto_pwhash_argon2id_STRBYTES);
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_ARGON2_THREADS(2);
+
+    int ret = pwhash_lanes(lane_threads, [&]() {
+        return crypto_pwhash_argon2id_str_verify((char*) hash, passwd, passwd_size);
+    });
+    if( ret == 0 ) {
+        return NAPI_TRUE;
+    }
+    return NAPI_FALSE;
+}
+
+NAPI_METHOD(crypto_pwhash_argon2id_str_verify_parallel_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: pwhash string, password");
+    ARG_TO_UCHAR_BUFFER_LEN(hash, crypto_pwhash_argon2id_STRBYTES);
+    ARG_TO_BUFFER_TYPE(passwd, char);
+    ARG_TO_ARGON2_THREADS(2);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_argon2id_str_verify_parallel");
+    const char* h = (const char*) worker->Copy(hash, hash_size);
+    const char* p = (const char*) worker->Copy(passwd, passwd_size);
+    return worker->StartPwhash([=]() {
+        return pwhash_lanes(lane_threads, [=]() {
+            return crypto_pwhash_argon2id_str_verify(h, p, passwd_size);
+        });
+    }, ASYNC_RESULT_BOOLEAN);
+}
+
+#undef ARG_TO_ARGON2_THREADS
+
 CRYPTO_PWHASH_DEF(scryptsalsa208sha256)
 CRYPTO_PWHASH_DEF_STR(scryptsalsa208sha256)
 CRYPTO_PWHASH_DEF_LL(scryptsalsa208sha256)
@@ -43,9 +383,16 @@ void register_crypto_pwhash_algos(Napi::Env env, Napi::Object exports) {
     EXPORT(crypto_pwhash_argon2id_memlimit_moderate);
     EXPORT_INT(crypto_pwhash_argon2id_OPSLIMIT_MODERATE);
     EXPORT_INT(crypto_pwhash_argon2id_MEMLIMIT_MODERATE);
+    EXPORT(crypto_pwhash_argon2id_parallel);
+    EXPORT(crypto_pwhash_argon2id_parallel_async);
+    EXPORT(crypto_pwhash_argon2id_str_parallel);
+    EXPORT(crypto_pwhash_argon2id_str_parallel_async);
+    EXPORT(crypto_pwhash_argon2id_str_verify_parallel);
+    EXPORT(crypto_pwhash_argon2id_str_verify_parallel_async);
 
     METHOD_AND_PROPS(scryptsalsa208sha256);
     EXPORT(crypto_pwhash_scryptsalsa208sha256_ll);
+    EXPORT(crypto_pwhash_scryptsalsa208sha256_ll_async);
 
     EXPORT(crypto_pwhash_argon2id_opslimit_moderate);
     EXPORT(crypto_pwhash_argon2id_memlimit_moderate);
@@ -0,0 +1,741 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+#include "crypto_keypair_pool.h"
+#include "sodium_memory.h"
+
+/**
+ * Double Ratchet algorithm, as specified by Signal, without header
+ * encryption: X25519 is `crypto_scalarmult`, KDF_RK is HKDF-SHA256 with the
+ * root key as salt, KDF_CK is HMAC-SHA256 of the chain key over 0x01 for the
+ * message key and 0x02 for the next chain key, both `crypto_auth_hmacsha256`.
+ *
+ * Messages are sealed with `crypto_aead_xchacha20poly1305_ietf` under the
+ * message key, with a random nonce and the associated data of the session
+ * followed by the header as associated data. A message key is only used
+ * once, but a state restored from an old serialization would use it again,
+ * and the random nonce keeps that from being a nonce reuse.
+ *
+ *   message = header | nonce (24) | cipher text | tag (16)
+ *   header  = ratchet public key (32) | previous chain length (4) |
+ *             message number (4), big endian
+ */
+#define RATCHET_DHLEN crypto_scalarmult_BYTES
+#define RATCHET_KEYLEN crypto_auth_hmacsha256_BYTES
+#define RATCHET_HEADERBYTES (RATCHET_DHLEN + 8)
+#define RATCHET_NPUBBYTES crypto_aead_xchacha20poly1305_ietf_NPUBBYTES
+#define RATCHET_ABYTES crypto_aead_xchacha20poly1305_ietf_ABYTES
+#define RATCHET_OVERHEAD (RATCHET_HEADERBYTES + RATCHET_NPUBBYTES + RATCHET_ABYTES)
+
+// Default and largest number of message keys kept for messages not received
+// yet, and of messages a single message may skip
+#define RATCHET_MAX_SKIP 1000
+#define RATCHET_MAX_SKIP_LIMIT 100000
+
+#define RATCHET_STATE_VERSION 1
+
+static const char ratchet_info[] = "node-sodium DoubleRatchet";
+
+// Root, chain and ratchet keys, and the message numbers
+struct RatchetKeys {
+    unsigned char rk[RATCHET_KEYLEN];
+    unsigned char cks[RATCHET_KEYLEN], ckr[RATCHET_KEYLEN];
+    unsigned char dhs_pk[RATCHET_DHLEN], dhs_sk[RATCHET_DHLEN];
+    unsigned char dhr[RATCHET_DHLEN];
+    uint32_t ns, nr, pn;
+    bool has_cks, has_ckr, has_dhr;
+};
+
+// Message key of a message skipped over, by ratchet key and number
+struct RatchetSkipped {
+    unsigned char dh[RATCHET_DHLEN];
+    uint32_t n;
+    unsigned char mk[RATCHET_KEYLEN];
+};
+
+static void ratchet_put32(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char) (v >> 24);
+    p[1] = (unsigned char) (v >> 16);
+    p[2] = (unsigned char) (v >> 8);
+    p[3] = (unsigned char) v;
+}
+
+static uint32_t ratchet_get32(const unsigned char* p) {
+    return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+// KDF_CK: the message key of `ck`, which moves on to the next chain key
+static void ratchet_kdf_ck(unsigned char* ck, unsigned char* mk) {
+    static const unsigned char one = 1, two = 2;
+    crypto_auth_hmacsha256(mk, &one, 1, ck);
+    crypto_auth_hmacsha256(ck, &two, 1, ck);
+}
+
+/**
+ * KDF_RK: HKDF-SHA256 of the X25519 output of `sk` and `pk`, salted with
+ * the root key, into a new root key and a chain key.
+ * Returns 0, or -1 if the exchange gives the all zero point
+ */
+static int ratchet_kdf_rk(unsigned char* rk, unsigned char* ck,
+                          const unsigned char* sk, const unsigned char* pk) {
+    static const unsigned char one = 1, two = 2;
+    unsigned char shared[RATCHET_DHLEN], prk[RATCHET_KEYLEN];
+    crypto_auth_hmacsha256_state state;
+
+    if( crypto_scalarmult(shared, sk, pk) != 0 ) {
+        return -1;
+    }
+    crypto_auth_hmacsha256_init(&state, rk, RATCHET_KEYLEN);
+    crypto_auth_hmacsha256_update(&state, shared, sizeof shared);
+    crypto_auth_hmacsha256_final(&state, prk);
+
+    crypto_auth_hmacsha256_init(&state, prk, sizeof prk);
+    crypto_auth_hmacsha256_update(&state, (const unsigned char*) ratchet_info, sizeof ratchet_info - 1);
+    crypto_auth_hmacsha256_update(&state, &one, 1);
+    crypto_auth_hmacsha256_final(&state, rk);
+
+    crypto_auth_hmacsha256_init(&state, prk, sizeof prk);
+    crypto_auth_hmacsha256_update(&state, rk, RATCHET_KEYLEN);
+    crypto_auth_hmacsha256_update(&state, (const unsigned char*) ratchet_info, sizeof ratchet_info - 1);
+    crypto_auth_hmacsha256_update(&state, &two, 1);
+    crypto_auth_hmacsha256_final(&state, ck);
+
+    sodium_memzero(shared, sizeof shared);
+    sodium_memzero(prk, sizeof prk);
+    sodium_memzero(&state, sizeof state);
+    return 0;
+}
+
+/**
+ * DHRatchet on the peer's new ratchet key `dh`: the receiving chain of `dh`
+ * and a sending chain from a new key pair of ours.
+ * Returns 0, or -1 if a key pair or an exchange failed
+ */
+static int ratchet_step(RatchetKeys* keys, const unsigned char* dh) {
+    keys->pn = keys->ns;
+    keys->ns = 0;
+    keys->nr = 0;
+    memcpy(keys->dhr, dh, RATCHET_DHLEN);
+    keys->has_dhr = true;
+    if( ratchet_kdf_rk(keys->rk, keys->ckr, keys->dhs_sk, keys->dhr) != 0 ) {
+        return -1;
+    }
+    keys->has_ckr = true;
+    if( keypair_pool_take(KEYPAIR_POOL_X25519, keys->dhs_pk, keys->dhs_sk) != 0 ||
+        ratchet_kdf_rk(keys->rk, keys->cks, keys->dhs_sk, keys->dhr) != 0 ) {
+        return -1;
+    }
+    keys->has_cks = true;
+    return 0;
+}
+
+/**
+ * State of one side: the keys, the message keys of messages skipped over,
+ * oldest first, and the associated data. Plain C++ below the class, `env`
+ * only goes to the secure memory accounting
+ */
+struct RatchetState {
+    RatchetKeys* keys;
+    RatchetSkipped* skipped;
+    uint32_t skipped_count;
+    uint32_t skipped_capacity;
+    uint32_t max_skip;
+
+    // Associated data of the session, followed by room for a header
+    std::vector<unsigned char> aad;
+    size_t ad_size;
+};
+
+static void ratchet_set_associated_data(RatchetState* st, const unsigned char* data, size_t size) {
+    st->ad_size = size;
+    st->aad.assign(size + RATCHET_HEADERBYTES, 0);
+    if( size > 0 ) {
+        memcpy(st->aad.data(), data, size);
+    }
+}
+
+static void ratchet_free_skipped(napi_env env, RatchetState* st) {
+    if( st->skipped != NULL ) {
+        sodium_secret_free(env, st->skipped, st->skipped_capacity * sizeof(RatchetSkipped));
+        st->skipped = NULL;
+        st->skipped_capacity = 0;
+    }
+    st->skipped_count = 0;
+}
+
+/**
+ * Make room for `count` more skipped keys, dropping the oldest ones past
+ * max_skip. Returns how many of the `count` to keep, the last ones, or -1
+ * if no memory could be allocated, with nothing changed
+ */
+static int64_t ratchet_reserve(napi_env env, RatchetState* st, uint64_t count) {
+    uint32_t keep = count < st->max_skip ? (uint32_t) count : st->max_skip;
+    uint32_t drop = st->skipped_count + keep > st->max_skip ? st->skipped_count + keep - st->max_skip : 0;
+    uint32_t needed = st->skipped_count - drop + keep;
+
+    if( needed > st->skipped_capacity ) {
+        uint32_t capacity = st->skipped_capacity < 8 ? 8 : st->skipped_capacity * 2;
+        capacity = capacity < needed ? needed : capacity > st->max_skip ? st->max_skip : capacity;
+        RatchetSkipped* grown = (RatchetSkipped*) sodium_secret_alloc(env, capacity * sizeof(RatchetSkipped));
+        if( grown == NULL ) {
+            return -1;
+        }
+        uint32_t kept = st->skipped_count - drop;
+        if( kept > 0 ) {
+            memcpy(grown, st->skipped + drop, kept * sizeof(RatchetSkipped));
+        }
+        ratchet_free_skipped(env, st);
+        st->skipped = grown;
+        st->skipped_capacity = capacity;
+        st->skipped_count = kept;
+    } else if( drop > 0 ) {
+        st->skipped_count -= drop;
+        memmove(st->skipped, st->skipped + drop, st->skipped_count * sizeof(RatchetSkipped));
+        sodium_memzero(st->skipped + st->skipped_count, drop * sizeof(RatchetSkipped));
+    }
+    return keep;
+}
+
+/**
+ * Keep the message keys of numbers `from` to `until` of the chain `ck` of
+ * ratchet key `dh`, but for the first `ignore` ones of the walk. The room
+ * was made by ratchet_reserve
+ */
+static void ratchet_store_skipped(RatchetState* st, const unsigned char* dh, unsigned char* ck,
+                                  uint32_t from, uint32_t until, uint64_t& ignore) {
+    unsigned char mk[RATCHET_KEYLEN];
+    for(uint32_t n = from; n < until; n++) {
+        ratchet_kdf_ck(ck, mk);
+        if( ignore > 0 ) {
+            ignore--;
+            continue;
+        }
+        RatchetSkipped* entry = &st->skipped[st->skipped_count++];
+        memcpy(entry->dh, dh, RATCHET_DHLEN);
+        entry->n = n;
+        memcpy(entry->mk, mk, RATCHET_KEYLEN);
+    }
+    sodium_memzero(mk, sizeof mk);
+}
+
+/**
+ * RatchetEncrypt of `mlen` bytes into `out`, RATCHET_OVERHEAD bytes longer.
+ * Returns 0, or -1 if there is no sending chain yet or it is exhausted
+ */
+static int ratchet_encrypt(RatchetState* st, unsigned char* out, const unsigned char* m, size_t mlen) {
+    RatchetKeys* keys = st->keys;
+    if( !keys->has_cks || keys->ns == UINT32_MAX ) {
+        return -1;
+    }
+    unsigned char* npub = out + RATCHET_HEADERBYTES;
+    memcpy(out, keys->dhs_pk, RATCHET_DHLEN);
+    ratchet_put32(out + RATCHET_DHLEN, keys->pn);
+    ratchet_put32(out + RATCHET_DHLEN + 4, keys->ns);
+    memcpy(st->aad.data() + st->ad_size, out, RATCHET_HEADERBYTES);
+    randombytes_buf(npub, RATCHET_NPUBBYTES);
+
+    unsigned char mk[RATCHET_KEYLEN];
+    ratchet_kdf_ck(keys->cks, mk);
+    keys->ns++;
+    crypto_aead_xchacha20poly1305_ietf_encrypt(npub + RATCHET_NPUBBYTES, NULL, m, mlen,
+                                               st->aad.data(), st->aad.size(), NULL, npub, mk);
+    sodium_memzero(mk, sizeof mk);
+    return 0;
+}
+
+/**
+ * RatchetDecrypt of the `size` byte message `in` into `m`, RATCHET_OVERHEAD
+ * bytes shorter. The ratchet runs on a copy of the keys, kept only if the
+ * message decrypts, so a forged message changes nothing.
+ * Returns 0, -1 if the message does not decrypt, or -2 if there was no
+ * memory for the skipped keys
+ */
+static int ratchet_decrypt(napi_env env, RatchetState* st, unsigned char* m, const unsigned char* in, size_t size) {
+    RatchetKeys* keys = st->keys;
+    if( size < RATCHET_OVERHEAD ) {
+        return -1;
+    }
+    const unsigned char* dh = in;
+    uint32_t pn = ratchet_get32(in + RATCHET_DHLEN);
+    uint32_t n = ratchet_get32(in + RATCHET_DHLEN + 4);
+    const unsigned char* npub = in + RATCHET_HEADERBYTES;
+    const unsigned char* c = npub + RATCHET_NPUBBYTES;
+    size_t clen = size - RATCHET_HEADERBYTES - RATCHET_NPUBBYTES;
+    memcpy(st->aad.data() + st->ad_size, in, RATCHET_HEADERBYTES);
+
+    // A message skipped over earlier
+    for(uint32_t i = 0; i < st->skipped_count; i++) {
+        RatchetSkipped* entry = &st->skipped[i];
+        if( entry->n == n && memcmp(entry->dh, dh, RATCHET_DHLEN) == 0 ) {
+            if( crypto_aead_xchacha20poly1305_ietf_decrypt(m, NULL, NULL, c, clen, st->aad.data(), st->aad.size(),
+                                                           npub, entry->mk) != 0 ) {
+                return -1;
+            }
+            st->skipped_count--;
+            memmove(entry, entry + 1, (st->skipped_count - i) * sizeof(RatchetSkipped));
+            sodium_memzero(st->skipped + st->skipped_count, sizeof(RatchetSkipped));
+            return 0;
+        }
+    }
+
+    RatchetKeys next;
+    memcpy(&next, keys, sizeof next);
+    bool new_chain = !keys->has_dhr || memcmp(dh, keys->dhr, RATCHET_DHLEN) != 0;
+    uint64_t old_skips = new_chain && keys->has_ckr && pn > keys->nr ? pn - keys->nr : 0;
+    bool valid = old_skips <= st->max_skip && (!new_chain || ratchet_step(&next, dh) == 0) &&
+                 next.has_ckr && n >= next.nr && n != UINT32_MAX && n - next.nr <= st->max_skip;
+    uint64_t new_skips = valid ? n - next.nr : 0;
+
+    unsigned char ck[RATCHET_KEYLEN], mk[RATCHET_KEYLEN];
+    memcpy(ck, next.ckr, RATCHET_KEYLEN);
+    for(uint64_t i = 0; valid && i <= new_skips; i++) {
+        ratchet_kdf_ck(ck, mk);
+    }
+    valid = valid && crypto_aead_xchacha20poly1305_ietf_decrypt(m, NULL, NULL, c, clen, st->aad.data(),
+                                                                st->aad.size(), npub, mk) == 0;
+    sodium_memzero(mk, sizeof mk);
+
+    int64_t keep = valid ? ratchet_reserve(env, st, old_skips + new_skips) : 0;
+    if( valid && keep >= 0 ) {
+        // The keys of the messages skipped in the old receiving chain and
+        // in the new one, the last max_skip of them
+        uint64_t ignore = old_skips + new_skips - (uint64_t) keep;
+        unsigned char walk[RATCHET_KEYLEN];
+        if( old_skips > 0 ) {
+            memcpy(walk, keys->ckr, RATCHET_KEYLEN);
+            ratchet_store_skipped(st, keys->dhr, walk, keys->nr, pn, ignore);
+        }
+        memcpy(walk, next.ckr, RATCHET_KEYLEN);
+        ratchet_store_skipped(st, next.dhr, walk, next.nr, n, ignore);
+        sodium_memzero(walk, sizeof walk);
+
+        memcpy(next.ckr, ck, RATCHET_KEYLEN);
+        next.nr = n + 1;
+        memcpy(keys, &next, sizeof next);
+    }
+    sodium_memzero(ck, sizeof ck);
+    sodium_memzero(&next, sizeof next);
+    return keep < 0 ? -2 : valid ? 0 : -1;
+}
+
+/**
+ * Serialized state:
+ *
+ *   version (1) | flags (1) | ns, nr, pn, max_skip (4 each) | rk | cks |
+ *   ckr | dhs_pk | dhs_sk | dhr | ad size (4) | ad | skipped (4) |
+ *   skipped keys, each ratchet key | number (4) | message key
+ *
+ * numbers big endian
+ */
+#define RATCHET_SKIPPEDBYTES (RATCHET_DHLEN + 4 + RATCHET_KEYLEN)
+
+static size_t ratchet_state_size(size_t ad, size_t count) {
+    return 2 + 16 + 6 * RATCHET_KEYLEN + 4 + ad + 4 + count * RATCHET_SKIPPEDBYTES;
+}
+
+static void ratchet_write_state(const RatchetState* st, unsigned char* p) {
+    const RatchetKeys* keys = st->keys;
+    *p++ = RATCHET_STATE_VERSION;
+    *p++ = (keys->has_cks ? 1 : 0) | (keys->has_ckr ? 2 : 0) | (keys->has_dhr ? 4 : 0);
+    ratchet_put32(p, keys->ns); p += 4;
+    ratchet_put32(p, keys->nr); p += 4;
+    ratchet_put32(p, keys->pn); p += 4;
+    ratchet_put32(p, st->max_skip); p += 4;
+    const unsigned char* fields[] = { keys->rk, keys->cks, keys->ckr, keys->dhs_pk, keys->dhs_sk, keys->dhr };
+    for(const unsigned char* field : fields) {
+        memcpy(p, field, RATCHET_KEYLEN);
+        p += RATCHET_KEYLEN;
+    }
+    ratchet_put32(p, (uint32_t) st->ad_size); p += 4;
+    if( st->ad_size > 0 ) {
+        memcpy(p, st->aad.data(), st->ad_size);
+        p += st->ad_size;
+    }
+    ratchet_put32(p, st->skipped_count); p += 4;
+    for(uint32_t i = 0; i < st->skipped_count; i++) {
+        memcpy(p, st->skipped[i].dh, RATCHET_DHLEN); p += RATCHET_DHLEN;
+        ratchet_put32(p, st->skipped[i].n); p += 4;
+        memcpy(p, st->skipped[i].mk, RATCHET_KEYLEN); p += RATCHET_KEYLEN;
+    }
+}
+
+/**
+ * Read the state written by ratchet_write_state into `st`, whose keys are
+ * allocated and its skipped keys empty.
+ * Returns NULL, or why the state cannot be read
+ */
+static const char* ratchet_read_state(napi_env env, RatchetState* st, const unsigned char* p, size_t size) {
+    const unsigned char* end = p + size;
+    RatchetKeys* keys = st->keys;
+    if( size < ratchet_state_size(0, 0) || *p++ != RATCHET_STATE_VERSION ) {
+        return "option state is not a RatchetSession state";
+    }
+    unsigned char flags = *p++;
+    keys->has_cks = (flags & 1) != 0;
+    keys->has_ckr = (flags & 2) != 0;
+    keys->has_dhr = (flags & 4) != 0;
+    keys->ns = ratchet_get32(p); p += 4;
+    keys->nr = ratchet_get32(p); p += 4;
+    keys->pn = ratchet_get32(p); p += 4;
+    st->max_skip = ratchet_get32(p); p += 4;
+    unsigned char* fields[] = { keys->rk, keys->cks, keys->ckr, keys->dhs_pk, keys->dhs_sk, keys->dhr };
+    for(unsigned char* field : fields) {
+        memcpy(field, p, RATCHET_KEYLEN);
+        p += RATCHET_KEYLEN;
+    }
+    uint32_t ad = ratchet_get32(p); p += 4;
+    if( (size_t) (end - p) < (size_t) ad + 4 ) {
+        return "option state is truncated";
+    }
+    ratchet_set_associated_data(st, p, ad);
+    p += ad;
+    uint32_t count = ratchet_get32(p); p += 4;
+    if( st->max_skip > RATCHET_MAX_SKIP_LIMIT || count > st->max_skip || ratchet_state_size(ad, count) != size ) {
+        return "option state is truncated";
+    }
+    if( ratchet_reserve(env, st, count) < 0 ) {
+        return "cannot allocate secure memory for the skipped message keys";
+    }
+    for(uint32_t i = 0; i < count; i++) {
+        RatchetSkipped* entry = &st->skipped[st->skipped_count++];
+        memcpy(entry->dh, p, RATCHET_DHLEN); p += RATCHET_DHLEN;
+        entry->n = ratchet_get32(p); p += 4;
+        memcpy(entry->mk, p, RATCHET_KEYLEN); p += RATCHET_KEYLEN;
+    }
+    return NULL;
+}
+
+/**
+ * RatchetSession:
+ * Native Double Ratchet session
+ *
+ * Holds the root, chain and ratchet keys of one side of a conversation, and
+ * the message keys of messages skipped over, in memory allocated with
+ * `sodium_malloc`, or the secure pool. Encrypting or decrypting a message is
+ * one call: the chain steps, the DH ratchet and the AEAD all run in C++.
+ *
+ *    var session = new sodium.RatchetSession(options);
+ *
+ * ~ options (Object):
+ *   - `sharedKey` (Buffer): the 32 byte secret both sides agreed on, as from
+ *     X3DH or `crypto_kx`
+ *   - `remotePublicKey` (Buffer): the responder's ratchet public key. Makes
+ *     this session the initiator, which sends first
+ *   - `keyPair`: the responder's ratchet key pair, `{ publicKey, secretKey }`
+ *     from `crypto_box_keypair`. Makes this session the responder
+ *   - `associatedData` (Buffer): authenticated with every message, such as
+ *     the identity keys of both sides. Both sides must give the same
+ *   - `maxSkip` (Number): message keys kept for messages not received yet,
+ *     and messages one message may skip. 1000 by default
+ *   - `state` (Buffer), `stateKey` (Buffer): restore a session from
+ *     `serialize(stateKey)` in place of the options above
+ *
+ * Methods:
+ *
+ * ~ encrypt(message): the message for the peer, `message.length + 80`
+ *   bytes. The responder can only encrypt once it decrypted a message
+ * ~ decrypt(message): the plain text, or null if the message is forged,
+ *   replayed, skips more than `maxSkip` messages or its key was dropped. A
+ *   message that fails leaves the session as it was
+ * ~ serialize(key): the whole state sealed with
+ *   `crypto_aead_xchacha20poly1305_ietf` under the 32 byte `key`
+ * ~ dispose(): wipes and frees the state. Later calls throw
+ *
+ * Properties:
+ *
+ * ~ publicKey (Buffer): our current ratchet public key
+ * ~ remotePublicKey (Buffer): the peer's current ratchet public key, or
+ *   null before the responder receives a message
+ * ~ skippedKeys (Number): message keys kept for skipped messages
+ *
+ * **Sample**:
+ *
+ *     var bobRatchet = sodium.crypto_box_keypair();
+ *     var alice = new sodium.RatchetSession({ sharedKey: sk, remotePublicKey: bobRatchet.publicKey });
+ *     var bob = new sodium.RatchetSession({ sharedKey: sk, keyPair: bobRatchet });
+ *     var m = bob.decrypt(alice.encrypt(Buffer.from('hello')));
+ */
+class RatchetSession : public Napi::ObjectWrap<RatchetSession> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "RatchetSession", {
+            InstanceMethod("encrypt", &RatchetSession::Encrypt),
+            InstanceMethod("decrypt", &RatchetSession::Decrypt),
+            InstanceMethod("serialize", &RatchetSession::Serialize),
+            InstanceMethod("dispose", &RatchetSession::Dispose),
+            InstanceAccessor("publicKey", &RatchetSession::PublicKey, nullptr),
+            InstanceAccessor("remotePublicKey", &RatchetSession::RemotePublicKey, nullptr),
+            InstanceAccessor("skippedKeys", &RatchetSession::SkippedKeys, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "RatchetSession"), ctor);
+    }
+
+    RatchetSession(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<RatchetSession>(info) {
+        Napi::Env env = info.Env();
+
+        st.keys = NULL;
+        st.skipped = NULL;
+        st.skipped_count = 0;
+        st.skipped_capacity = 0;
+        st.max_skip = RATCHET_MAX_SKIP;
+        st.ad_size = 0;
+
+        if( info.Length() < 1 || !info[0].IsObject() ) {
+            Napi::TypeError::New(env, "argument options must be an object").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Object options = info[0].As<Napi::Object>();
+
+        st.keys = (RatchetKeys*) sodium_secret_alloc(env, sizeof(RatchetKeys));
+        if( st.keys == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the session").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_memzero(st.keys, sizeof(RatchetKeys));
+
+        std::string error = options.Get("state").IsUndefined() ? Start(options) : Restore(options);
+        if( !error.empty() ) {
+            Free();
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+    }
+
+    ~RatchetSession() {
+        Free();
+    }
+
+private:
+    static bool OptionBytes(Napi::Object options, const char* name, size_t size,
+                            unsigned char*& data, std::string& error) {
+        Napi::Value value = options.Get(name);
+        if( value.IsUndefined() ) {
+            return false;
+        }
+        size_t length = 0;
+        if( !sodium_arg_bytes(value, data, length) || length != size ) {
+            error = std::string("option ") + name + " must be a " + std::to_string(size) + " byte buffer";
+            return false;
+        }
+        return true;
+    }
+
+    // A new session from the shared key and a ratchet key of the responder
+    std::string Start(Napi::Object options) {
+        std::string error;
+        unsigned char *sk = NULL, *remote = NULL, *pk = NULL, *secret = NULL;
+
+        if( !OptionBytes(options, "sharedKey", RATCHET_KEYLEN, sk, error) ) {
+            return error.empty() ? "option sharedKey or state is required" : error;
+        }
+        bool initiator = OptionBytes(options, "remotePublicKey", RATCHET_DHLEN, remote, error);
+        Napi::Value pair = options.Get("keyPair");
+        bool responder = !pair.IsUndefined();
+        if( responder && (!pair.IsObject() ||
+                          !OptionBytes(pair.As<Napi::Object>(), "publicKey", RATCHET_DHLEN, pk, error) ||
+                          !OptionBytes(pair.As<Napi::Object>(), "secretKey", RATCHET_DHLEN, secret, error)) ) {
+            return "option keyPair must be { publicKey, secretKey } of crypto_box_keypair";
+        }
+        if( !error.empty() ) {
+            return error;
+        }
+        if( initiator == responder ) {
+            return "give either option remotePublicKey, for the initiator, or keyPair, for the responder";
+        }
+
+        Napi::Value value = options.Get("maxSkip");
+        if( !value.IsUndefined() ) {
+            double n = value.IsNumber() ? value.As<Napi::Number>().DoubleValue() : -1;
+            if( n < 0 || n > RATCHET_MAX_SKIP_LIMIT || n != (double) (uint32_t) n ) {
+                return "option maxSkip must be an integer from 0 to " + std::to_string(RATCHET_MAX_SKIP_LIMIT);
+            }
+            st.max_skip = (uint32_t) n;
+        }
+        unsigned char* ad = NULL;
+        size_t ad_size = 0;
+        value = options.Get("associatedData");
+        if( !value.IsUndefined() && !sodium_arg_bytes(value, ad, ad_size) ) {
+            return "option associatedData must be a buffer";
+        }
+        ratchet_set_associated_data(&st, ad, ad_size);
+
+        RatchetKeys* keys = st.keys;
+        memcpy(keys->rk, sk, RATCHET_KEYLEN);
+        if( initiator ) {
+            memcpy(keys->dhr, remote, RATCHET_DHLEN);
+            keys->has_dhr = true;
+            if( keypair_pool_take(KEYPAIR_POOL_X25519, keys->dhs_pk, keys->dhs_sk) != 0 ||
+                ratchet_kdf_rk(keys->rk, keys->cks, keys->dhs_sk, keys->dhr) != 0 ) {
+                return "option remotePublicKey is not a valid public key";
+            }
+            keys->has_cks = true;
+        } else {
+            memcpy(keys->dhs_pk, pk, RATCHET_DHLEN);
+            memcpy(keys->dhs_sk, secret, RATCHET_DHLEN);
+        }
+        return "";
+    }
+
+    // A session from the state of serialize()
+    std::string Restore(Napi::Object options) {
+        std::string error;
+        unsigned char *sealed = NULL, *key = NULL;
+        size_t sealed_size = 0;
+
+        if( !sodium_arg_bytes(options.Get("state"), sealed, sealed_size) ) {
+            return "option state must be a buffer";
+        }
+        if( !OptionBytes(options, "stateKey", crypto_aead_xchacha20poly1305_ietf_KEYBYTES, key, error) ) {
+            return error.empty() ? "option stateKey is required with option state" : error;
+        }
+        size_t header = 1 + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES;
+        if( sealed_size < header + crypto_aead_xchacha20poly1305_ietf_ABYTES + ratchet_state_size(0, 0) ||
+            sealed[0] != RATCHET_STATE_VERSION ) {
+            return "option state is not a RatchetSession state";
+        }
+
+        size_t size = sealed_size - header - crypto_aead_xchacha20poly1305_ietf_ABYTES;
+        unsigned char* state = (unsigned char*) sodium_secret_alloc(Env(), size);
+        if( state == NULL ) {
+            return "cannot allocate secure memory for the state";
+        }
+        const char* failed = "option state does not verify with stateKey";
+        if( crypto_aead_xchacha20poly1305_ietf_decrypt(state, NULL, NULL, sealed + header, sealed_size - header,
+                                                       sealed, 1, sealed + 1, key) == 0 ) {
+            failed = ratchet_read_state(Env(), &st, state, size);
+        }
+        sodium_secret_free(Env(), state, size);
+        return failed != NULL ? failed : "";
+    }
+
+    void Free() {
+        ratchet_free_skipped(Env(), &st);
+        if( st.keys != NULL ) {
+            sodium_secret_free(Env(), st.keys, sizeof(RatchetKeys));
+            st.keys = NULL;
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( st.keys == NULL ) { \
+        THROW_ERROR("RatchetSession was disposed"); \
+    }
+
+    Napi::Value Encrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER(message);
+        if( !st.keys->has_cks ) {
+            THROW_ERROR("the responder cannot encrypt before it decrypts a first message");
+        }
+
+        NEW_BUFFER_AND_PTR(out, message_size + RATCHET_OVERHEAD);
+        if( ratchet_encrypt(&st, out_ptr, message, message_size) != 0 ) {
+            THROW_ERROR("too many messages in the sending chain");
+        }
+        return out;
+    }
+
+    Napi::Value Decrypt(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER(message);
+        if( message_size < RATCHET_OVERHEAD ) {
+            return NAPI_NULL;
+        }
+
+        NEW_BUFFER_AND_PTR(m, message_size - RATCHET_OVERHEAD);
+        int rc = ratchet_decrypt(env, &st, m_ptr, message, message_size);
+        if( rc == -2 ) {
+            THROW_ERROR("cannot allocate secure memory for the skipped message keys");
+        }
+        if( rc != 0 ) {
+            return NAPI_NULL;
+        }
+        return m;
+    }
+
+    Napi::Value Serialize(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument key must be a buffer");
+        ARG_TO_UCHAR_BUFFER_LEN(key, crypto_aead_xchacha20poly1305_ietf_KEYBYTES);
+
+        size_t size = ratchet_state_size(st.ad_size, st.skipped_count);
+        unsigned char* state = (unsigned char*) sodium_secret_alloc(env, size);
+        if( state == NULL ) {
+            THROW_ERROR("cannot allocate secure memory for the state");
+        }
+        ratchet_write_state(&st, state);
+
+        // version | nonce | sealed state, the version authenticated
+        NEW_BUFFER_AND_PTR(out, 1 + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + size +
+                                crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        out_ptr[0] = RATCHET_STATE_VERSION;
+        randombytes_buf(out_ptr + 1, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+        crypto_aead_xchacha20poly1305_ietf_encrypt(out_ptr + 1 + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, NULL,
+                                                   state, size, out_ptr, 1, NULL, out_ptr + 1, key);
+        sodium_secret_free(env, state, size);
+        return out;
+    }
+
+    Napi::Value PublicKey(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        NEW_BUFFER_AND_PTR(pk, RATCHET_DHLEN);
+        memcpy(pk_ptr, st.keys->dhs_pk, RATCHET_DHLEN);
+        return pk;
+    }
+
+    Napi::Value RemotePublicKey(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( !st.keys->has_dhr ) {
+            return NAPI_NULL;
+        }
+        NEW_BUFFER_AND_PTR(pk, RATCHET_DHLEN);
+        memcpy(pk_ptr, st.keys->dhr, RATCHET_DHLEN);
+        return pk;
+    }
+
+    Napi::Value SkippedKeys(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, st.skipped_count);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    RatchetState st;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_ratchet(Napi::Env env, Napi::Object exports) {
+    RatchetSession::Init(env, exports);
+}
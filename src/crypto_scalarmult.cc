@@ -16,6 +16,10 @@ void register_crypto_scalarmult(Napi::Env env, Napi::Object exports) {
     // Scalar Mult
     EXPORT_ALIAS(crypto_scalarmult, crypto_scalarmult_curve25519);
     EXPORT_ALIAS(crypto_scalarmult_base, crypto_scalarmult_curve25519_base);
+    EXPORT_ALIAS(crypto_scalarmult_batch, crypto_scalarmult_curve25519_batch);
+    EXPORT_ALIAS(crypto_scalarmult_batch_async, crypto_scalarmult_curve25519_batch_async);
+    EXPORT_ALIAS(crypto_scalarmult_shared_key, crypto_scalarmult_curve25519_shared_key);
+    EXPORT_ALIAS(crypto_scalarmult_shared_key_batch, crypto_scalarmult_curve25519_shared_key_batch);
     
     EXPORT_INT(crypto_scalarmult_SCALARBYTES);
     EXPORT_INT(crypto_scalarmult_BYTES);
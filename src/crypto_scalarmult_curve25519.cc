@@ -6,6 +6,8 @@
  * @License MIT
  */
 #include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
 
 /**
  * int crypto_scalarmult_curve25519_base(unsigned char *q, const unsigned char *n)
@@ -46,6 +48,261 @@ NAPI_METHOD(crypto_scalarmult_curve25519) {
     }
 }
 
+// Multiply point `i` by scalar `i`, or by the only scalar, `threads` at a
+// time. Result `i` is written at `out + i * crypto_scalarmult_curve25519_BYTES`
+// and left all zero when the point is rejected.
+static void scalarmult_batch(unsigned char* out, const std::vector<SodiumSpan>& scalars,
+                             const std::vector<SodiumSpan>& points, size_t threads) {
+    sodium_batch_parallel(points.size(), threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            const unsigned char* n = scalars[scalars.size() == 1 ? 0 : i].data;
+            unsigned char* q = out + i * crypto_scalarmult_curve25519_BYTES;
+            if( crypto_scalarmult_curve25519(q, n, points[i].data) != 0 ) {
+                sodium_memzero(q, crypto_scalarmult_curve25519_BYTES);
+            }
+        }
+    });
+}
+
+// Points are an array of buffers or one buffer with the points back to back.
+// Scalars are one scalar for every point, or one per point in the same forms
+#define ARG_TO_SCALARMULT_BATCH(SCALARS, POINTS, COUNT) \
+    size_t COUNT = SODIUM_BATCH_ANY; \
+    std::vector<SodiumSpan> SCALARS; \
+    { \
+        unsigned char* packed = NULL; \
+        size_t packed_size = 0; \
+        if( sodium_arg_bytes(info[1], packed, packed_size) ) { \
+            COUNT = packed_size / crypto_scalarmult_curve25519_BYTES; \
+        } \
+    } \
+    _arg = 1; \
+    ARG_TO_BATCH_LEN(POINTS, COUNT, crypto_scalarmult_curve25519_BYTES); \
+    { \
+        unsigned char* one = NULL; \
+        size_t one_size = 0; \
+        if( sodium_arg_bytes(info[0], one, one_size) && one_size == crypto_scalarmult_curve25519_SCALARBYTES ) { \
+            SCALARS.push_back(SodiumSpan{ one, one_size }); \
+        } else { \
+            size_t scalar_count = COUNT; \
+            if( !sodium_batch_arg(env, info[0], #SCALARS, scalar_count, crypto_scalarmult_curve25519_SCALARBYTES, false, SCALARS) ) { \
+                return NAPI_NULL; \
+            } \
+            if( scalar_count != COUNT ) { \
+                THROW_ERROR("argument " #SCALARS " must have one scalar per point"); \
+            } \
+        } \
+    } \
+    size_t threads = 1; \
+    if( info.Length() > 2 && info[2].IsNumber() ) { \
+        ARG_TO_NUMBER(nthreads); \
+        threads = nthreads; \
+    }
+
+/**
+ * crypto_scalarmult_curve25519_batch:
+ * Compute many shared secrets in one call
+ *
+ *     var q = sodium.crypto_scalarmult_curve25519_batch(scalars, points, [threads]);
+ *
+ * ~ scalars (Buffer|Array): one `crypto_scalarmult_curve25519_SCALARBYTES`
+ *   scalar, multiplied with every point, or one scalar per point as an array
+ *   of buffers or one buffer with the scalars back to back
+ * ~ points (Array|Buffer): array of `crypto_scalarmult_curve25519_BYTES`
+ *   buffers, or one buffer with the points back to back. Sets the batch size
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   Default 1. The call still blocks until every product is computed
+ *
+ * **Returns**:
+ *
+ * ~ q (Buffer): the products back to back, in the order of `points`. A
+ *   product is all zeros where `crypto_scalarmult_curve25519` would have
+ *   rejected the point and returned null
+ *
+ * **Sample**:
+ *
+ *     var secrets = sodium.crypto_scalarmult_curve25519_batch(sk, peerKeys, 4);
+ *     var secret = secrets.slice(i * 32, (i + 1) * 32);
+ */
+NAPI_METHOD(crypto_scalarmult_curve25519_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments scalars and points are required");
+    ARG_TO_SCALARMULT_BATCH(scalars, points, count);
+
+    NEW_BUFFER_AND_PTR(q, count * crypto_scalarmult_curve25519_BYTES);
+    scalarmult_batch(q_ptr, scalars, points, threads);
+    return q;
+}
+
+/**
+ * crypto_scalarmult_curve25519_batch_async:
+ * Same as `crypto_scalarmult_curve25519_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_scalarmult_curve25519_batch_async(scalars, points, [threads], [callback]);
+ *
+ * Returns a Promise when no callback is given. With `threads` above 1 the
+ * pool thread fans the batch out to that many threads. Scalars and points
+ * are copied, the copies of the scalars are wiped once the batch is done.
+ */
+NAPI_METHOD(crypto_scalarmult_curve25519_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments scalars and points are required");
+    ARG_TO_SCALARMULT_BATCH(scalars, points, count);
+
+    NEW_BUFFER_AND_PTR(q, count * crypto_scalarmult_curve25519_BYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_scalarmult_curve25519_batch");
+    unsigned char* out = worker->Pin(q);
+    std::vector<SodiumSpan> ns(scalars.size()), ps(count);
+    for(size_t i = 0; i < scalars.size(); i++) {
+        ns[i].data = worker->Copy(scalars[i].data, crypto_scalarmult_curve25519_SCALARBYTES);
+        ns[i].size = crypto_scalarmult_curve25519_SCALARBYTES;
+    }
+    for(size_t i = 0; i < count; i++) {
+        ps[i].data = worker->Copy(points[i].data, crypto_scalarmult_curve25519_BYTES);
+        ps[i].size = crypto_scalarmult_curve25519_BYTES;
+    }
+
+    return worker->Start([=]() {
+        scalarmult_batch(out, ns, ps, threads);
+        return 0;
+    }, ASYNC_RESULT_BUFFER);
+}
+
+#undef ARG_TO_SCALARMULT_BATCH
+
+/**
+ * Shared keys
+ *
+ * A raw X25519 product is not a key: libsodium hashes it with both public
+ * keys, BLAKE2b(q || client public key || server public key). Done from JS
+ * that is a scalar multiplication, a concatenation and a hash, three
+ * crossings and two short lived Buffers per handshake. The shared key
+ * bindings multiply and hash in one call, with `q` kept on the stack and
+ * wiped.
+ */
+static int shared_key(unsigned char* out, size_t out_size, const unsigned char* sk,
+                      const unsigned char* peer, const unsigned char* pk1, const unsigned char* pk2) {
+    unsigned char q[crypto_scalarmult_curve25519_BYTES];
+    crypto_generichash_state state;
+
+    if( crypto_scalarmult_curve25519(q, sk, peer) != 0 ) {
+        return -1;
+    }
+    crypto_generichash_init(&state, NULL, 0, out_size);
+    crypto_generichash_update(&state, q, sizeof q);
+    crypto_generichash_update(&state, pk1, crypto_scalarmult_curve25519_BYTES);
+    crypto_generichash_update(&state, pk2, crypto_scalarmult_curve25519_BYTES);
+    crypto_generichash_final(&state, out, out_size);
+    sodium_memzero(q, sizeof q);
+    sodium_memzero(&state, sizeof state);
+    return 0;
+}
+
+// Optional key size argument, crypto_generichash_BYTES by default
+#define ARG_TO_SHARED_KEY_SIZE(NAME) \
+    size_t NAME = crypto_generichash_BYTES; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        CHECK_SIZE(NAME ## _arg, crypto_generichash_BYTES_MIN, crypto_generichash_BYTES_MAX); \
+        NAME = NAME ## _arg; \
+    } else { \
+        _arg++; \
+    }
+
+/**
+ * crypto_scalarmult_curve25519_shared_key:
+ * X25519 and BLAKE2b of the transcript in one call
+ *
+ *     var key = sodium.crypto_scalarmult_curve25519_shared_key(
+ *         secretKey, peerPublicKey, clientPublicKey, serverPublicKey, [size]);
+ *
+ * ~ secretKey (Buffer): own `crypto_scalarmult_curve25519_SCALARBYTES` key
+ * ~ peerPublicKey (Buffer): the other side's public key
+ * ~ clientPublicKey, serverPublicKey (Buffer): both public keys, in the
+ *   order both sides hash them
+ * ~ size (Number): optional, bytes of key, `crypto_generichash_BYTES` by
+ *   default
+ *
+ * **Returns**:
+ *
+ * ~ BLAKE2b(q || clientPublicKey || serverPublicKey) with `q` the product
+ *   of `secretKey` and `peerPublicKey`, or null when the peer key is
+ *   rejected
+ */
+NAPI_METHOD(crypto_scalarmult_curve25519_shared_key) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments secret key, peer public key, client public key and server public key are required");
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_scalarmult_curve25519_SCALARBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(peer, crypto_scalarmult_curve25519_BYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(pk1, crypto_scalarmult_curve25519_BYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(pk2, crypto_scalarmult_curve25519_BYTES);
+    ARG_TO_SHARED_KEY_SIZE(size);
+
+    NEW_BUFFER_AND_PTR(key, size);
+    if( shared_key(key_ptr, size, sk, peer, pk1, pk2) != 0 ) {
+        return NAPI_NULL;
+    }
+    return key;
+}
+
+/**
+ * crypto_scalarmult_curve25519_shared_key_batch:
+ * The shared keys of one server key pair with many clients
+ *
+ *     var keys = sodium.crypto_scalarmult_curve25519_shared_key_batch(
+ *         secretKey, publicKey, clientPublicKeys, [size], [threads]);
+ *
+ * Key `i` is BLAKE2b(q || clientPublicKeys[i] || publicKey), the key
+ * `crypto_scalarmult_curve25519_shared_key` gives both sides.
+ * `clientPublicKeys` is an array of buffers, a packed batch or one buffer
+ * with the keys back to back.
+ *
+ * **Returns**:
+ *
+ * ~ the keys back to back, `size` bytes each. A key is all zeros where the
+ *   client key is rejected
+ */
+NAPI_METHOD(crypto_scalarmult_curve25519_shared_key_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments secret key, public key and client public keys are required");
+    ARG_TO_UCHAR_BUFFER_LEN(sk, crypto_scalarmult_curve25519_SCALARBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(pk, crypto_scalarmult_curve25519_BYTES);
+
+    size_t count = SODIUM_BATCH_ANY;
+    {
+        unsigned char* packed = NULL;
+        size_t packed_size = 0;
+        if( sodium_arg_bytes(info[2], packed, packed_size) ) {
+            count = packed_size / crypto_scalarmult_curve25519_BYTES;
+        }
+    }
+    ARG_TO_BATCH_LEN(clients, count, crypto_scalarmult_curve25519_BYTES);
+    ARG_TO_SHARED_KEY_SIZE(size);
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    NEW_BUFFER_AND_PTR(keys, count * size);
+    sodium_batch_parallel(count, threads, 16, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            unsigned char* key = keys_ptr + i * size;
+            if( shared_key(key, size, sk, clients[i].data, clients[i].data, pk) != 0 ) {
+                sodium_memzero(key, size);
+            }
+        }
+    });
+    return keys;
+}
+
+#undef ARG_TO_SHARED_KEY_SIZE
+
 /**
  * Register function calls in node binding
  */
@@ -54,6 +311,10 @@ void register_crypto_scalarmult_curve25519(Napi::Env env, Napi::Object exports)
     // Scalar Mult
     EXPORT(crypto_scalarmult_curve25519);
     EXPORT(crypto_scalarmult_curve25519_base);
+    EXPORT(crypto_scalarmult_curve25519_batch);
+    EXPORT(crypto_scalarmult_curve25519_batch_async);
+    EXPORT(crypto_scalarmult_curve25519_shared_key);
+    EXPORT(crypto_scalarmult_curve25519_shared_key_batch);
     EXPORT_INT(crypto_scalarmult_curve25519_SCALARBYTES);
     EXPORT_INT(crypto_scalarmult_curve25519_BYTES);
 }
\ No newline at end of file
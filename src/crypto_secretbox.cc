@@ -6,6 +6,9 @@
  * @License MIT
  */
 #include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "sodium_stats.h"
+#include "sodium_fixed.h"
 
 /**
  * Encrypts and authenticates a message using the given secret key, and nonce.
@@ -38,28 +41,21 @@ NAPI_METHOD(crypto_secretbox) {
     Napi::Env env = info.Env();
 
     ARGS(3, "arguments message, nonce, and key must be buffers");
-    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
 
-    NEW_BUFFER_AND_PTR(pmb, message_size + crypto_secretbox_ZEROBYTES);
+    // crypto_secretbox_BOXZEROBYTES zeros, the MAC and the cipher text, written
+    // in place by the detached API so the message is never copied
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_secretbox_ZEROBYTES);
+    memset(ctxt_ptr, 0, crypto_secretbox_BOXZEROBYTES);
 
-    // Fill the first crypto_secretbox_ZEROBYTES with 0
-    unsigned int i;
-    for(i = 0; i < crypto_secretbox_ZEROBYTES; i++) {
-        pmb_ptr[i] = 0U;
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_ZEROBYTES,
+            crypto_secretbox_detached(ctxt_ptr + crypto_secretbox_ZEROBYTES, ctxt_ptr + crypto_secretbox_BOXZEROBYTES,
+                message, message_size, nonce, key)) == 0) {
+        return ctxt;
     }
 
-    //Copy the message to the new buffer
-    memcpy((void*) (pmb_ptr + crypto_secretbox_ZEROBYTES), (void *) message, message_size);
-    message_size += crypto_secretbox_ZEROBYTES;
-
-    NEW_BUFFER_AND_PTR(ctxt, message_size);
-
-    if( crypto_secretbox(ctxt_ptr, pmb_ptr, message_size, nonce, key) == 0) {
-        return ctxt;
-    } 
-    
     return NAPI_NULL;
 }
 
@@ -98,12 +94,10 @@ NAPI_METHOD(crypto_secretbox_open) {
     Napi::Env env = info.Env();
 
     ARGS(3, "arguments cipherText, nonce, and key must be buffers");
-    ARG_TO_UCHAR_BUFFER(cipher_text);
+    ARG_TO_UCHAR_BUFFER_RANGE(cipher_text);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
 
-    NEW_BUFFER_AND_PTR(message, cipher_text_size);
-
     // API requires that the first crypto_secretbox_ZEROBYTES of msg be 0 so lets check
     if (cipher_text_size < crypto_secretbox_BOXZEROBYTES) {
         THROW_ERROR("argument cipherText must have at least crypto_secretbox_BOXZEROBYTES bytes");
@@ -118,16 +112,20 @@ NAPI_METHOD(crypto_secretbox_open) {
         THROW_ERROR("the first crypto_secretbox_BOXZEROBYTES bytes of argument cipherText must be 0");
     }
 
-    if (crypto_secretbox_open(message_ptr, cipher_text, cipher_text_size, nonce, key) == 0) {
+    if (cipher_text_size < crypto_secretbox_ZEROBYTES) {
+        return NAPI_NULL;
+    }
 
-        // Remove the padding at the beginning of the message
-        NEW_BUFFER_AND_PTR(plain_text, cipher_text_size - crypto_secretbox_ZEROBYTES);
-        memcpy(plain_text_ptr,(void*) (message_ptr + crypto_secretbox_ZEROBYTES), cipher_text_size - crypto_secretbox_ZEROBYTES);
+    // The MAC is checked before any plain text is written
+    NEW_BUFFER_AND_PTR(plain_text, cipher_text_size - crypto_secretbox_ZEROBYTES);
 
+    if (SODIUM_STAT(secretbox, cipher_text_size, cipher_text_size - crypto_secretbox_ZEROBYTES,
+            crypto_secretbox_open_detached(plain_text_ptr, cipher_text + crypto_secretbox_ZEROBYTES, cipher_text + crypto_secretbox_BOXZEROBYTES,
+                cipher_text_size - crypto_secretbox_ZEROBYTES, nonce, key)) == 0) {
         return plain_text;
-    } else {
-        return NAPI_NULL;
     }
+
+    return NAPI_NULL;
 }
 
 /**
@@ -159,13 +157,14 @@ NAPI_METHOD(crypto_secretbox_easy) {
     Napi::Env env = info.Env();
 
     ARGS(3, "arguments message, nonce, and key must be buffers");
-    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
 
     NEW_BUFFER_AND_PTR(c, message_size + crypto_secretbox_MACBYTES);
 
-    if (crypto_secretbox_easy(c_ptr, message, message_size, nonce, key) == 0) {
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_MACBYTES,
+            crypto_secretbox_easy(c_ptr, message, message_size, nonce, key)) == 0) {
         return c;
     } 
     
@@ -203,16 +202,162 @@ NAPI_METHOD(crypto_secretbox_open_easy) {
     Napi::Env env = info.Env();
 
     ARGS(3, "arguments message, nonce, and key must be buffers");
-    ARG_TO_UCHAR_BUFFER(cipher_text);
+    ARG_TO_UCHAR_BUFFER_RANGE(cipher_text);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
 
-    NEW_BUFFER_AND_PTR(c, cipher_text_size - crypto_secretbox_MACBYTES);
+    if (cipher_text_size < crypto_secretbox_MACBYTES) {
+        return NAPI_NULL;
+    }
 
-    if (crypto_secretbox_open_easy(c_ptr, cipher_text, cipher_text_size, nonce, key) == 0) {
-        return c;
+    RETURN_DECRYPTED(m, cipher_text_size - crypto_secretbox_MACBYTES,
+        SODIUM_STAT(secretbox, cipher_text_size, m_size,
+            crypto_secretbox_open_easy(m_ptr, cipher_text, cipher_text_size, nonce, key)));
+}
+
+/**
+ * crypto_secretbox_easy_32(message, nonce, key)
+ * crypto_secretbox_open_easy_32(cipherText, nonce, key)
+ * crypto_secretbox_easy_64(message, nonce, key)
+ * crypto_secretbox_open_easy_64(cipherText, nonce, key)
+ *
+ * crypto_secretbox_easy and crypto_secretbox_open_easy for messages of
+ * exactly 32 or 64 bytes, such as wrapped keys and session tokens. Sizes
+ * are checked against constants and the plain text is opened on the
+ * stack. See src/include/sodium_fixed.h
+ */
+NAPI_METHOD(crypto_secretbox_easy_32) {
+    return secretbox_easy_fixed<SODIUM_FIXED_SMALL>(info);
+}
+
+NAPI_METHOD(crypto_secretbox_open_easy_32) {
+    return secretbox_open_easy_fixed<SODIUM_FIXED_SMALL>(info);
+}
+
+NAPI_METHOD(crypto_secretbox_easy_64) {
+    return secretbox_easy_fixed<SODIUM_FIXED_LARGE>(info);
+}
+
+NAPI_METHOD(crypto_secretbox_open_easy_64) {
+    return secretbox_open_easy_fixed<SODIUM_FIXED_LARGE>(info);
+}
+
+/**
+ * crypto_secretbox_easy_async:
+ * Same as `crypto_secretbox_easy` but runs on the libuv threadpool
+ *
+ *     sodium.crypto_secretbox_easy_async(message, nonce, key, [options], [callback]);
+ *
+ * crypto_secretbox_open_easy_async:
+ * Same as `crypto_secretbox_open_easy` but runs on the libuv threadpool.
+ * Resolves to the plain text, or null if `cipherText` does not verify
+ *
+ *     sodium.crypto_secretbox_open_easy_async(cipherText, nonce, key, [options], [callback]);
+ *
+ * The input is pinned, not copied, so do not change it until the result is
+ * delivered. Inputs shorter than `sodium_async_threshold()` bytes are
+ * handled inline when a Promise is returned.
+ */
+NAPI_METHOD(crypto_secretbox_easy_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size + crypto_secretbox_MACBYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_secretbox_easy");
+    unsigned char* out = worker->Pin(c);
+    const unsigned char* m = worker->Pin(message_buffer);
+    const unsigned char* n = worker->Copy(nonce, crypto_secretbox_NONCEBYTES);
+    const unsigned char* k = worker->Copy(key, crypto_secretbox_KEYBYTES);
+
+    return worker->StartTiered([=]() {
+        return SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_MACBYTES,
+            crypto_secretbox_easy(out, m, message_size, n, k));
+    }, ASYNC_RESULT_BUFFER, message_size);
+}
+
+NAPI_METHOD(crypto_secretbox_open_easy_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments cipherText, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(cipherText);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
+
+    if (cipherText_size < crypto_secretbox_MACBYTES) {
+        THROW_ERROR("argument cipherText must have a length of at least crypto_secretbox_MACBYTES bytes");
     }
-    
+
+    NEW_BUFFER_AND_PTR(m, cipherText_size - crypto_secretbox_MACBYTES);
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_secretbox_open_easy");
+    unsigned char* out = worker->Pin(m);
+    const unsigned char* c = worker->Pin(cipherText_buffer);
+    const unsigned char* n = worker->Copy(nonce, crypto_secretbox_NONCEBYTES);
+    const unsigned char* k = worker->Copy(key, crypto_secretbox_KEYBYTES);
+
+    return worker->StartTiered([=]() {
+        return SODIUM_STAT(secretbox, cipherText_size, cipherText_size - crypto_secretbox_MACBYTES,
+            crypto_secretbox_open_easy(out, c, cipherText_size, n, k));
+    }, ASYNC_RESULT_BUFFER, cipherText_size);
+}
+
+/**
+ * crypto_secretbox_easy_base64url(message, nonce, key):
+ *   crypto_secretbox_easy, returning the box as unpadded base64url text.
+ *   No Buffer is created for the box
+ *
+ * crypto_secretbox_open_easy_base64url(text, nonce, key):
+ *   crypto_secretbox_open_easy of a box given as base64url text, decoded to
+ *   scratch memory and opened straight into the returned Buffer. Null when
+ *   the text is not base64url or the box does not verify
+ */
+NAPI_METHOD(crypto_secretbox_easy_base64url) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
+
+    SodiumBase64url text;
+    unsigned char* c = text.Reserve(message_size + crypto_secretbox_MACBYTES);
+
+    if (SODIUM_STAT(secretbox, message_size, text.size,
+            crypto_secretbox_easy(c, message, message_size, nonce, key)) == 0) {
+        return text.Encode(env);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_secretbox_open_easy_base64url) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments text, nonce, and key must be a string and buffers");
+    if (!info[0].IsString()) {
+        THROW_ERROR("argument text must be a base64url string");
+    }
+    _arg++;
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
+
+    SodiumBase64url text;
+    if (!text.Decode(env, info[0]) || text.size < crypto_secretbox_MACBYTES) {
+        return NAPI_NULL;
+    }
+
+    NEW_BUFFER_AND_PTR(m, text.size - crypto_secretbox_MACBYTES);
+    if (SODIUM_STAT(secretbox, text.size, m.Length(),
+            crypto_secretbox_open_easy(m_ptr, text.data, text.size, nonce, key)) == 0) {
+        return m;
+    }
+
+    sodium_memzero(m_ptr, m.Length());
     return NAPI_NULL;
 }
 
@@ -229,19 +374,45 @@ NAPI_METHOD(crypto_secretbox_detached) {
 
     ARGS(4, "arguments mac, message, nonce, and key must be buffers");
     ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_secretbox_MACBYTES);
-    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
 
     NEW_BUFFER_AND_PTR(c, message_size);
 
-    if (crypto_secretbox_detached(c_ptr, mac, message, message_size, nonce, key) == 0) {
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_MACBYTES,
+            crypto_secretbox_detached(c_ptr, mac, message, message_size, nonce, key)) == 0) {
         return c;
     }
     
     return NAPI_NULL;
 }
 
+/**
+ * crypto_secretbox_detached_packed:
+ * Same as crypto_secretbox_detached, in one buffer
+ *
+ * Returns cipherText || mac, `message.length + crypto_secretbox_MACBYTES`
+ * bytes. Unlike crypto_secretbox_easy the mac follows the cipher text
+ */
+NAPI_METHOD(crypto_secretbox_detached_packed) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size + crypto_secretbox_MACBYTES);
+
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_MACBYTES,
+            crypto_secretbox_detached(c_ptr, c_ptr + message_size, message, message_size, nonce, key)) == 0) {
+        return c;
+    }
+
+    return NAPI_NULL;
+}
+
 /*
 int crypto_secretbox_open_detached(unsigned char *m,
                                    const unsigned char *c,
@@ -254,14 +425,15 @@ NAPI_METHOD(crypto_secretbox_open_detached) {
     Napi::Env env = info.Env();
 
     ARGS(4, "arguments encrypted message, mac, nonce, and key must be buffers");
-    ARG_TO_UCHAR_BUFFER(c);
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
     ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_secretbox_MACBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_KEYBYTES);
 
     NEW_BUFFER_AND_PTR(m, c_size);
 
-    if (crypto_secretbox_open_detached(m_ptr, c, mac, c_size, nonce, key) == 0) {
+    if (SODIUM_STAT(secretbox, c_size + crypto_secretbox_MACBYTES, c_size,
+            crypto_secretbox_open_detached(m_ptr, c, mac, c_size, nonce, key)) == 0) {
         return m;
     }
     
@@ -277,8 +449,17 @@ void register_crypto_secretbox(Napi::Env env, Napi::Object exports) {
     EXPORT(crypto_secretbox);
     EXPORT(crypto_secretbox_open);
     EXPORT(crypto_secretbox_easy);
+    EXPORT(crypto_secretbox_easy_async);
     EXPORT(crypto_secretbox_open_easy);
+    EXPORT(crypto_secretbox_open_easy_async);
+    EXPORT(crypto_secretbox_easy_32);
+    EXPORT(crypto_secretbox_open_easy_32);
+    EXPORT(crypto_secretbox_easy_64);
+    EXPORT(crypto_secretbox_open_easy_64);
+    EXPORT(crypto_secretbox_easy_base64url);
+    EXPORT(crypto_secretbox_open_easy_base64url);
     EXPORT(crypto_secretbox_detached);
+    EXPORT(crypto_secretbox_detached_packed);
     EXPORT(crypto_secretbox_open_detached);
     
     EXPORT_INT(crypto_secretbox_BOXZEROBYTES);
@@ -0,0 +1,224 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+#include "sodium_stats.h"
+
+/**
+ * crypto_secretbox_xchacha20poly1305 is crypto_secretbox with XChaCha20 as
+ * the stream cipher. Keys and nonces have the same sizes as XSalsa20's, the
+ * cipher text layout is the `_easy` one: MAC first, then the cipher text.
+ *
+ * The `_into` variants write to a caller supplied buffer at `offset` and
+ * return the number of bytes written, so a loop sealing many messages does
+ * not allocate a Buffer per message. The output may be the input itself.
+ */
+
+/*
+int crypto_secretbox_xchacha20poly1305_easy(unsigned char *c,
+                                            const unsigned char *m,
+                                            unsigned long long mlen,
+                                            const unsigned char *n,
+                                            const unsigned char *k);
+*/
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_easy) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size + crypto_secretbox_xchacha20poly1305_MACBYTES);
+
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_xchacha20poly1305_MACBYTES,
+            crypto_secretbox_xchacha20poly1305_easy(c_ptr, message, message_size, nonce, key)) == 0) {
+        return c;
+    }
+
+    return NAPI_NULL;
+}
+
+/*
+int crypto_secretbox_xchacha20poly1305_open_easy(unsigned char *m,
+                                                 const unsigned char *c,
+                                                 unsigned long long clen,
+                                                 const unsigned char *n,
+                                                 const unsigned char *k);
+*/
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_open_easy) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments cipherText, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(cipher_text);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+
+    if (cipher_text_size < crypto_secretbox_xchacha20poly1305_MACBYTES) {
+        return NAPI_NULL;
+    }
+
+    RETURN_DECRYPTED(m, cipher_text_size - crypto_secretbox_xchacha20poly1305_MACBYTES,
+        SODIUM_STAT(secretbox, cipher_text_size, m_size,
+            crypto_secretbox_xchacha20poly1305_open_easy(m_ptr, cipher_text, cipher_text_size, nonce, key)));
+}
+
+/*
+int crypto_secretbox_xchacha20poly1305_detached(unsigned char *c,
+                                                unsigned char *mac,
+                                                const unsigned char *m,
+                                                unsigned long long mlen,
+                                                const unsigned char *n,
+                                                const unsigned char *k);
+*/
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_detached) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments mac, message, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_secretbox_xchacha20poly1305_MACBYTES);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(c, message_size);
+
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_xchacha20poly1305_MACBYTES,
+            crypto_secretbox_xchacha20poly1305_detached(c_ptr, mac, message, message_size, nonce, key)) == 0) {
+        return c;
+    }
+
+    return NAPI_NULL;
+}
+
+/*
+int crypto_secretbox_xchacha20poly1305_open_detached(unsigned char *m,
+                                                     const unsigned char *c,
+                                                     const unsigned char *mac,
+                                                     unsigned long long clen,
+                                                     const unsigned char *n,
+                                                     const unsigned char *k);
+*/
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_open_detached) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments encrypted message, mac, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
+    ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_secretbox_xchacha20poly1305_MACBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(m, c_size);
+
+    if (SODIUM_STAT(secretbox, c_size + crypto_secretbox_xchacha20poly1305_MACBYTES, c_size,
+            crypto_secretbox_xchacha20poly1305_open_detached(m_ptr, c, mac, c_size, nonce, key)) == 0) {
+        return m;
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_easy_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments output buffer, offset, message, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+    CHECK_OUTPUT_SPACE(out, offset, message_size + crypto_secretbox_xchacha20poly1305_MACBYTES);
+
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_xchacha20poly1305_MACBYTES,
+            crypto_secretbox_xchacha20poly1305_easy(out + offset, message, message_size, nonce, key)) == 0) {
+        return Napi::Number::New(env, message_size + crypto_secretbox_xchacha20poly1305_MACBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_open_easy_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(5, "arguments output buffer, offset, cipherText, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(cipher_text);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+
+    if (cipher_text_size < crypto_secretbox_xchacha20poly1305_MACBYTES) {
+        return NAPI_NULL;
+    }
+    CHECK_OUTPUT_SPACE(out, offset, cipher_text_size - crypto_secretbox_xchacha20poly1305_MACBYTES);
+
+    if (SODIUM_STAT(secretbox, cipher_text_size, cipher_text_size - crypto_secretbox_xchacha20poly1305_MACBYTES,
+            crypto_secretbox_xchacha20poly1305_open_easy(out + offset, cipher_text, cipher_text_size, nonce, key)) == 0) {
+        return Napi::Number::New(env, cipher_text_size - crypto_secretbox_xchacha20poly1305_MACBYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_detached_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(7, "arguments output buffer, offset, mac buffer, mac offset, message, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER(mac);
+    ARG_TO_NUMBER(macOffset);
+    ARG_TO_UCHAR_BUFFER_RANGE(message);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+    CHECK_OUTPUT_SPACE(out, offset, message_size);
+    CHECK_OUTPUT_SPACE(mac, macOffset, crypto_secretbox_xchacha20poly1305_MACBYTES);
+
+    if (SODIUM_STAT(secretbox, message_size, message_size + crypto_secretbox_xchacha20poly1305_MACBYTES,
+            crypto_secretbox_xchacha20poly1305_detached(out + offset, mac + macOffset, message, message_size, nonce, key)) == 0) {
+        return Napi::Number::New(env, message_size);
+    }
+
+    return NAPI_NULL;
+}
+
+NAPI_METHOD(crypto_secretbox_xchacha20poly1305_open_detached_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(6, "arguments output buffer, offset, encrypted message, mac, nonce, and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER_RANGE(c);
+    ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_secretbox_xchacha20poly1305_MACBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xchacha20poly1305_KEYBYTES);
+    CHECK_OUTPUT_SPACE(out, offset, c_size);
+
+    if (SODIUM_STAT(secretbox, c_size + crypto_secretbox_xchacha20poly1305_MACBYTES, c_size,
+            crypto_secretbox_xchacha20poly1305_open_detached(out + offset, c, mac, c_size, nonce, key)) == 0) {
+        return Napi::Number::New(env, c_size);
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_secretbox_xchacha20poly1305(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_secretbox_xchacha20poly1305_easy);
+    EXPORT(crypto_secretbox_xchacha20poly1305_open_easy);
+    EXPORT(crypto_secretbox_xchacha20poly1305_detached);
+    EXPORT(crypto_secretbox_xchacha20poly1305_open_detached);
+    EXPORT(crypto_secretbox_xchacha20poly1305_easy_into);
+    EXPORT(crypto_secretbox_xchacha20poly1305_open_easy_into);
+    EXPORT(crypto_secretbox_xchacha20poly1305_detached_into);
+    EXPORT(crypto_secretbox_xchacha20poly1305_open_detached_into);
+
+    EXPORT_INT(crypto_secretbox_xchacha20poly1305_KEYBYTES);
+    EXPORT_INT(crypto_secretbox_xchacha20poly1305_NONCEBYTES);
+    EXPORT_INT(crypto_secretbox_xchacha20poly1305_MACBYTES);
+}
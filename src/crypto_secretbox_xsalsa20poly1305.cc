@@ -15,24 +15,16 @@ NAPI_METHOD(crypto_secretbox_xsalsa20poly1305) {
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xsalsa20poly1305_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xsalsa20poly1305_KEYBYTES);
 
-    NEW_BUFFER_AND_PTR(pmb, message_size + crypto_secretbox_xsalsa20poly1305_ZEROBYTES);
+    // crypto_secretbox_detached is this same construction; see crypto_secretbox.cc
+    NEW_BUFFER_AND_PTR(ctxt, message_size + crypto_secretbox_xsalsa20poly1305_ZEROBYTES);
+    memset(ctxt_ptr, 0, crypto_secretbox_xsalsa20poly1305_BOXZEROBYTES);
 
-    // Fill the first crypto_secretbox_xsalsa20poly1305_ZEROBYTES with 0
-    unsigned int i;
-    for(i = 0; i < crypto_secretbox_xsalsa20poly1305_ZEROBYTES; i++) {
-        pmb_ptr[i] = 0U;
+    if (crypto_secretbox_detached(ctxt_ptr + crypto_secretbox_xsalsa20poly1305_ZEROBYTES,
+            ctxt_ptr + crypto_secretbox_xsalsa20poly1305_BOXZEROBYTES,
+            message, message_size, nonce, key) == 0) {
+        return ctxt;
     }
 
-    //Copy the message to the new buffer
-    memcpy((void*) (pmb_ptr + crypto_secretbox_xsalsa20poly1305_ZEROBYTES), (void *) message, message_size);
-    message_size += crypto_secretbox_xsalsa20poly1305_ZEROBYTES;
-
-    NEW_BUFFER_AND_PTR(ctxt, message_size);
-
-    if( crypto_secretbox_xsalsa20poly1305(ctxt_ptr, pmb_ptr, message_size, nonce, key) == 0) {
-        return ctxt;
-    } 
-    
     return NAPI_NULL;
 }
 
@@ -44,8 +36,6 @@ NAPI_METHOD(crypto_secretbox_xsalsa20poly1305_open) {
     ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_secretbox_xsalsa20poly1305_NONCEBYTES);
     ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretbox_xsalsa20poly1305_KEYBYTES);
 
-    NEW_BUFFER_AND_PTR(message, cipher_text_size);
-
     // API requires that the first crypto_secretbox_xsalsa20poly1305_ZEROBYTES of msg be 0 so lets check
     if (cipher_text_size < crypto_secretbox_xsalsa20poly1305_BOXZEROBYTES) {
         THROW_ERROR("argument cipherText must have at least crypto_secretbox_xsalsa20poly1305_BOXZEROBYTES bytes");
@@ -60,16 +50,19 @@ NAPI_METHOD(crypto_secretbox_xsalsa20poly1305_open) {
         THROW_ERROR("the first crypto_secretbox_xsalsa20poly1305_BOXZEROBYTES bytes of argument cipherText must be 0");
     }
 
-    if (crypto_secretbox_xsalsa20poly1305_open(message_ptr, cipher_text, cipher_text_size, nonce, key) == 0) {
+    if (cipher_text_size < crypto_secretbox_xsalsa20poly1305_ZEROBYTES) {
+        return NAPI_NULL;
+    }
 
-        // Remove the padding at the beginning of the message
-        NEW_BUFFER_AND_PTR(plain_text, cipher_text_size - crypto_secretbox_xsalsa20poly1305_ZEROBYTES);
-        memcpy(plain_text_ptr,(void*) (message_ptr + crypto_secretbox_xsalsa20poly1305_ZEROBYTES), cipher_text_size - crypto_secretbox_xsalsa20poly1305_ZEROBYTES);
+    NEW_BUFFER_AND_PTR(plain_text, cipher_text_size - crypto_secretbox_xsalsa20poly1305_ZEROBYTES);
 
+    if (crypto_secretbox_open_detached(plain_text_ptr, cipher_text + crypto_secretbox_xsalsa20poly1305_ZEROBYTES,
+            cipher_text + crypto_secretbox_xsalsa20poly1305_BOXZEROBYTES,
+            cipher_text_size - crypto_secretbox_xsalsa20poly1305_ZEROBYTES, nonce, key) == 0) {
         return plain_text;
-    } else {
-        return NAPI_NULL;
     }
+
+    return NAPI_NULL;
 }
 
 /**
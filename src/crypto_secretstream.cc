@@ -0,0 +1,236 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+
+/**
+ * Encrypted streams with crypto_secretstream_xchacha20poly1305
+ *
+ * Encrypts a sequence of messages (chunks of a larger stream) under one key.
+ * Each chunk is authenticated and tagged; chunks cannot be removed, reordered,
+ * duplicated or truncated without detection.
+ *
+ * The stream state is kept in a Buffer of
+ * `crypto_secretstream_xchacha20poly1305_statebytes()` bytes, returned by the
+ * `init_*` functions and updated in place by `push`, `pull` and `rekey`.
+ *
+ * **Sample**:
+ *
+ *     var key = sodium.crypto_secretstream_xchacha20poly1305_keygen();
+ *     var s = sodium.crypto_secretstream_xchacha20poly1305_init_push(key);
+ *
+ *     var c1 = sodium.crypto_secretstream_xchacha20poly1305_push(s.state, chunk1, null,
+ *                  sodium.crypto_secretstream_xchacha20poly1305_TAG_MESSAGE);
+ *     var c2 = sodium.crypto_secretstream_xchacha20poly1305_push(s.state, chunk2, null,
+ *                  sodium.crypto_secretstream_xchacha20poly1305_TAG_FINAL);
+ *
+ *     var state = sodium.crypto_secretstream_xchacha20poly1305_init_pull(s.header, key);
+ *     var r1 = sodium.crypto_secretstream_xchacha20poly1305_pull(state, c1, null);
+ *     // r1.message, r1.tag
+ */
+
+/**
+ * crypto_secretstream_xchacha20poly1305_init_push:
+ * Start an encrypted stream
+ *
+ *     var s = sodium.crypto_secretstream_xchacha20poly1305_init_push(key);
+ *
+ * ~ key (Buffer): secret key `crypto_secretstream_xchacha20poly1305_KEYBYTES` long
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ state: <Buffer>, header: <Buffer> }`. The header must be sent
+ *   to the receiver, it is needed by `init_pull`
+ * ~ null: on error
+ */
+NAPI_METHOD(crypto_secretstream_xchacha20poly1305_init_push) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument key must be a buffer");
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretstream_xchacha20poly1305_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(state, crypto_secretstream_xchacha20poly1305_statebytes());
+    NEW_BUFFER_AND_PTR(header, crypto_secretstream_xchacha20poly1305_HEADERBYTES);
+
+    if( crypto_secretstream_xchacha20poly1305_init_push(
+            (crypto_secretstream_xchacha20poly1305_state*) state_ptr, header_ptr, key) == 0 ) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "state"), state);
+        result.Set(Napi::String::New(env, "header"), header);
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_secretstream_xchacha20poly1305_push:
+ * Encrypt one chunk of the stream
+ *
+ *     var c = sodium.crypto_secretstream_xchacha20poly1305_push(state, message, additionalData, tag);
+ *
+ * ~ state (Buffer): state returned by `init_push`. Updated in place
+ * ~ message (Buffer): chunk to encrypt
+ * ~ additionalData (Buffer): authenticated but not encrypted data. Can be `null`
+ * ~ tag (Number): one of `crypto_secretstream_xchacha20poly1305_TAG_MESSAGE`,
+ *   `_TAG_PUSH`, `_TAG_REKEY` or `_TAG_FINAL`
+ *
+ * **Returns**:
+ *
+ * ~ cipherText (Buffer): `message.length + crypto_secretstream_xchacha20poly1305_ABYTES` long
+ * ~ null: on error
+ */
+NAPI_METHOD(crypto_secretstream_xchacha20poly1305_push) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: state buffer, message buffer, additional data buffer, tag");
+    ARG_TO_UCHAR_BUFFER_LEN(state, crypto_secretstream_xchacha20poly1305_statebytes());
+    ARG_TO_UCHAR_BUFFER(m);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+    ARG_TO_NUMBER(tag);
+
+    if( m_size > crypto_secretstream_xchacha20poly1305_MESSAGEBYTES_MAX ) {
+        THROW_ERROR("message is longer than crypto_secretstream_xchacha20poly1305_MESSAGEBYTES_MAX");
+    }
+    CHECK_MAX_SIZE(tag, 0xff);
+
+    NEW_BUFFER_AND_PTR(c, m_size + crypto_secretstream_xchacha20poly1305_ABYTES);
+
+    if( crypto_secretstream_xchacha20poly1305_push(
+            (crypto_secretstream_xchacha20poly1305_state*) state, c_ptr, NULL,
+            m, m_size, ad, ad_size, (unsigned char) tag) == 0 ) {
+        return c;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_secretstream_xchacha20poly1305_init_pull:
+ * Start decrypting a stream
+ *
+ *     var state = sodium.crypto_secretstream_xchacha20poly1305_init_pull(header, key);
+ *
+ * ~ header (Buffer): header returned by `init_push`
+ * ~ key (Buffer): secret key `crypto_secretstream_xchacha20poly1305_KEYBYTES` long
+ *
+ * **Returns**:
+ *
+ * ~ state (Buffer): the stream state
+ * ~ null: if the header is invalid
+ */
+NAPI_METHOD(crypto_secretstream_xchacha20poly1305_init_pull) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: header buffer, key buffer");
+    ARG_TO_UCHAR_BUFFER_LEN(header, crypto_secretstream_xchacha20poly1305_HEADERBYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretstream_xchacha20poly1305_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(state, crypto_secretstream_xchacha20poly1305_statebytes());
+
+    if( crypto_secretstream_xchacha20poly1305_init_pull(
+            (crypto_secretstream_xchacha20poly1305_state*) state_ptr, header, key) == 0 ) {
+        return state;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_secretstream_xchacha20poly1305_pull:
+ * Decrypt one chunk of the stream
+ *
+ *     var r = sodium.crypto_secretstream_xchacha20poly1305_pull(state, cipherText, additionalData);
+ *
+ * ~ state (Buffer): state returned by `init_pull`. Updated in place
+ * ~ cipherText (Buffer): chunk returned by `push`
+ * ~ additionalData (Buffer): additional data given to `push`. Can be `null`
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ message: <Buffer>, tag: <Number> }`
+ * ~ null: if the chunk is invalid, out of order or forged
+ */
+NAPI_METHOD(crypto_secretstream_xchacha20poly1305_pull) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: state buffer, cipher text buffer, additional data buffer");
+    ARG_TO_UCHAR_BUFFER_LEN(state, crypto_secretstream_xchacha20poly1305_statebytes());
+    ARG_TO_UCHAR_BUFFER(c);
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad);
+
+    if( c_size < crypto_secretstream_xchacha20poly1305_ABYTES ) {
+        THROW_ERROR("argument cipher text must be at least crypto_secretstream_xchacha20poly1305_ABYTES bytes long");
+    }
+
+    NEW_BUFFER_AND_PTR(m, c_size - crypto_secretstream_xchacha20poly1305_ABYTES);
+    unsigned char tag;
+
+    if( crypto_secretstream_xchacha20poly1305_pull(
+            (crypto_secretstream_xchacha20poly1305_state*) state, m_ptr, NULL, &tag,
+            c, c_size, ad, ad_size) == 0 ) {
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "message"), m);
+        result.Set(Napi::String::New(env, "tag"), Napi::Number::New(env, tag));
+        return result;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_secretstream_xchacha20poly1305_rekey:
+ * Explicitly rekey the stream state
+ *
+ *     sodium.crypto_secretstream_xchacha20poly1305_rekey(state);
+ *
+ * ~ state (Buffer): push or pull state. Updated in place
+ */
+NAPI_METHOD(crypto_secretstream_xchacha20poly1305_rekey) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument state must be a buffer");
+    ARG_TO_UCHAR_BUFFER_LEN(state, crypto_secretstream_xchacha20poly1305_statebytes());
+
+    crypto_secretstream_xchacha20poly1305_rekey((crypto_secretstream_xchacha20poly1305_state*) state);
+
+    return env.Undefined();
+}
+
+NAPI_METHOD_KEYGEN(crypto_secretstream_xchacha20poly1305)
+NAPI_METHOD_FROM_INT(crypto_secretstream_xchacha20poly1305_abytes)
+NAPI_METHOD_FROM_INT(crypto_secretstream_xchacha20poly1305_headerbytes)
+NAPI_METHOD_FROM_INT(crypto_secretstream_xchacha20poly1305_keybytes)
+NAPI_METHOD_FROM_INT(crypto_secretstream_xchacha20poly1305_messagebytes_max)
+NAPI_METHOD_FROM_INT(crypto_secretstream_xchacha20poly1305_statebytes)
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_secretstream(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_secretstream_xchacha20poly1305_keygen);
+    EXPORT(crypto_secretstream_xchacha20poly1305_init_push);
+    EXPORT(crypto_secretstream_xchacha20poly1305_push);
+    EXPORT(crypto_secretstream_xchacha20poly1305_init_pull);
+    EXPORT(crypto_secretstream_xchacha20poly1305_pull);
+    EXPORT(crypto_secretstream_xchacha20poly1305_rekey);
+
+    EXPORT(crypto_secretstream_xchacha20poly1305_abytes);
+    EXPORT(crypto_secretstream_xchacha20poly1305_headerbytes);
+    EXPORT(crypto_secretstream_xchacha20poly1305_keybytes);
+    EXPORT(crypto_secretstream_xchacha20poly1305_messagebytes_max);
+    EXPORT(crypto_secretstream_xchacha20poly1305_statebytes);
+
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_ABYTES);
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_HEADERBYTES);
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_KEYBYTES);
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_MESSAGEBYTES_MAX);
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_TAG_MESSAGE);
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_TAG_PUSH);
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_TAG_REKEY);
+    EXPORT_INT(crypto_secretstream_xchacha20poly1305_TAG_FINAL);
+}
@@ -45,6 +45,14 @@ NAPI_METHOD(crypto_shorthash) {
     }
 }
 
+// crypto_shorthash is SipHash-2-4, so these are shared
+NAPI_METHOD(crypto_shorthash_siphash24_bigint);
+NAPI_METHOD(crypto_shorthash_siphash24_uint32);
+NAPI_METHOD(crypto_shorthash_siphash24_batch);
+NAPI_METHOD(crypto_shorthash_siphash24_rendezvous);
+NAPI_METHOD(crypto_shorthash_siphash24_rendezvous_batch);
+NAPI_METHOD(crypto_shorthash_siphash24_jump);
+
 /**
  * Register function calls in node binding
  */
@@ -52,6 +60,12 @@ void register_crypto_shorthash(Napi::Env env, Napi::Object exports) {
 
     // Short Hash
     EXPORT(crypto_shorthash);
+    EXPORT_ALIAS(crypto_shorthash_bigint, crypto_shorthash_siphash24_bigint);
+    EXPORT_ALIAS(crypto_shorthash_uint32, crypto_shorthash_siphash24_uint32);
+    EXPORT_ALIAS(crypto_shorthash_batch, crypto_shorthash_siphash24_batch);
+    EXPORT_ALIAS(crypto_shorthash_rendezvous, crypto_shorthash_siphash24_rendezvous);
+    EXPORT_ALIAS(crypto_shorthash_rendezvous_batch, crypto_shorthash_siphash24_rendezvous_batch);
+    EXPORT_ALIAS(crypto_shorthash_jump, crypto_shorthash_siphash24_jump);
     EXPORT_INT(crypto_shorthash_BYTES);
     EXPORT_INT(crypto_shorthash_KEYBYTES);
     EXPORT_STRING(crypto_shorthash_PRIMITIVE);
@@ -0,0 +1,373 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "sodium_memory.h"
+
+// A block is one 64 byte cache line of 512 bits
+#define FILTER_BLOCK_BYTES  64
+#define FILTER_BLOCK_WORDS  8
+#define FILTER_BLOCK_BITS   512
+#define FILTER_HASHES_MIN   1
+#define FILTER_HASHES_MAX   16
+#define FILTER_HASHES       8
+#define FILTER_BLOCKS_MAX   0xffffffffULL
+
+typedef std::atomic<uint64_t> filter_word;
+static_assert(sizeof(filter_word) == sizeof(uint64_t), "filter words are 64 bit elements of the storage");
+
+/**
+ * BloomFilter:
+ * A keyed Bloom filter, for sets that must stand up to chosen inputs: seen
+ * nonces, revoked tokens
+ *
+ *     var filter = new sodium.BloomFilter(key, [options]);
+ *
+ * ~ key (Buffer): `crypto_shorthash_KEYBYTES` secret key. Without it nobody
+ *   can build items that all land on the same bits
+ * ~ options.bits: the size of the filter, rounded up to whole blocks
+ * ~ options.capacity, options.rate: instead of `bits`, the number of items
+ *   and the false positive rate wanted, 0.01 by default. `hashes` is then
+ *   picked too
+ * ~ options.hashes: bits set per item, 1 to 16, 8 by default
+ * ~ options.buffer: the storage to use, kept as it is. Any TypedArray over
+ *   an ArrayBuffer or SharedArrayBuffer, a multiple of 64 bytes long and 8
+ *   byte aligned. Workers that build filters over the same SharedArrayBuffer
+ *   with the same key and `hashes` share one set
+ *
+ * Each item costs one SipHash-2-4 call, the 128 bit `crypto_shorthash_siphashx24`.
+ * The first half picks a block of 64 bytes, one cache line, and the second
+ * half the `hashes` bits inside it by double hashing, so a lookup touches
+ * one line of memory. Bits are set with atomic ORs: adding from several
+ * threads or workers at once loses nothing, and a concurrent `has` sees an
+ * item either whole or not at all.
+ *
+ * Methods:
+ *
+ * ~ add(item): add `item`. Returns true if it was not in the filter yet,
+ *   false if it was, or is a false positive
+ * ~ has(item): true if `item` may be in the filter, false if it is not
+ * ~ addBatch(items, [lengths], [threads]): add many items. `items` is an
+ *   array of buffers, or one buffer with the items back to back and their
+ *   `lengths` as in `crypto_shorthash_batch`. Returns a bitmap: bit `i % 8`
+ *   of byte `i / 8` is set when item `i` was new
+ * ~ hasBatch(items, [lengths], [threads]): the bitmap of the items that may
+ *   be in the filter
+ * ~ clear(): empty the filter
+ * ~ dispose(): wipes the key. Later calls throw
+ *
+ * Properties: `bits`, `hashes` and `buffer`, the storage
+ *
+ * **Sample**:
+ *
+ *     var seen = new sodium.BloomFilter(key, { capacity: 1e6, rate: 1e-6 });
+ *     if( !seen.add(nonce) ) {
+ *         // replayed, or one in a million
+ *     }
+ */
+class BloomFilter : public Napi::ObjectWrap<BloomFilter> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "BloomFilter", {
+            InstanceMethod("add", &BloomFilter::Add),
+            InstanceMethod("has", &BloomFilter::Has),
+            InstanceMethod("addBatch", &BloomFilter::AddBatch),
+            InstanceMethod("hasBatch", &BloomFilter::HasBatch),
+            InstanceMethod("clear", &BloomFilter::Clear),
+            InstanceMethod("dispose", &BloomFilter::Dispose),
+            InstanceAccessor("bits", &BloomFilter::Bits, nullptr),
+            InstanceAccessor("hashes", &BloomFilter::Hashes, nullptr),
+            InstanceAccessor("buffer", &BloomFilter::Buffer, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "BloomFilter"), ctor);
+    }
+
+    BloomFilter(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<BloomFilter>(info), key(NULL), words(NULL), blocks(0), hashes(FILTER_HASHES) {
+        Napi::Env env = info.Env();
+
+        unsigned char* k = NULL;
+        size_t k_size = 0;
+        if( info.Length() < 1 || !sodium_arg_bytes(info[0], k, k_size) ||
+            k_size != crypto_shorthash_siphashx24_KEYBYTES ) {
+            Napi::TypeError::New(env, "argument key must be a crypto_shorthash_KEYBYTES buffer").ThrowAsJavaScriptException();
+            return;
+        }
+
+        Napi::Object options = Napi::Object::New(env);
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            if( !info[1].IsObject() ) {
+                Napi::TypeError::New(env, "argument options must be an object").ThrowAsJavaScriptException();
+                return;
+            }
+            options = info[1].As<Napi::Object>();
+        }
+
+        double bits = FILTER_BLOCK_BITS * 1024.0;
+        Napi::Value value;
+        if( !(value = options.Get("capacity")).IsUndefined() ) {
+            double rate = 0.01;
+            Napi::Value r = options.Get("rate");
+            if( !r.IsUndefined() ) {
+                rate = r.IsNumber() ? r.As<Napi::Number>().DoubleValue() : 0;
+            }
+            if( !value.IsNumber() || !(value.As<Napi::Number>().DoubleValue() >= 1) || !(rate > 0 && rate < 1) ) {
+                Napi::RangeError::New(env, "options capacity must be 1 or more and rate between 0 and 1").ThrowAsJavaScriptException();
+                return;
+            }
+            double n = value.As<Napi::Number>().DoubleValue();
+            bits = std::ceil(-n * std::log(rate) / (std::log(2.0) * std::log(2.0)));
+            double k = std::round(bits / n * std::log(2.0));
+            hashes = (size_t) (k < FILTER_HASHES_MIN ? FILTER_HASHES_MIN : k > FILTER_HASHES_MAX ? FILTER_HASHES_MAX : k);
+        } else if( !(value = options.Get("bits")).IsUndefined() ) {
+            if( !value.IsNumber() || !(value.As<Napi::Number>().DoubleValue() >= 1) ) {
+                Napi::RangeError::New(env, "option bits must be 1 or more").ThrowAsJavaScriptException();
+                return;
+            }
+            bits = value.As<Napi::Number>().DoubleValue();
+        }
+        if( !(value = options.Get("hashes")).IsUndefined() ) {
+            double h = value.IsNumber() ? value.As<Napi::Number>().DoubleValue() : 0;
+            if( !(h >= FILTER_HASHES_MIN && h <= FILTER_HASHES_MAX) ) {
+                Napi::RangeError::New(env, "option hashes must be between 1 and 16").ThrowAsJavaScriptException();
+                return;
+            }
+            hashes = (size_t) h;
+        }
+
+        Napi::Value storage = options.Get("buffer");
+        if( !storage.IsUndefined() ) {
+            unsigned char* data = NULL;
+            size_t size = 0;
+            if( !sodium_arg_bytes(storage, data, size) ) {
+                Napi::TypeError::New(env, "option buffer must be a buffer").ThrowAsJavaScriptException();
+                return;
+            }
+            if( size == 0 || size % FILTER_BLOCK_BYTES != 0 || size / FILTER_BLOCK_BYTES > FILTER_BLOCKS_MAX ) {
+                Napi::RangeError::New(env, "option buffer must be a non empty multiple of 64 bytes long").ThrowAsJavaScriptException();
+                return;
+            }
+            if( ((uintptr_t) data) % sizeof(uint64_t) != 0 ) {
+                Napi::RangeError::New(env, "option buffer must be 8 byte aligned").ThrowAsJavaScriptException();
+                return;
+            }
+            words = (filter_word*) data;
+            blocks = size / FILTER_BLOCK_BYTES;
+        } else {
+            double nblocks = std::ceil(bits / FILTER_BLOCK_BITS);
+            if( nblocks > FILTER_BLOCKS_MAX || nblocks * FILTER_BLOCK_BYTES > SODIUM_MAX_SAFE_INTEGER ) {
+                Napi::RangeError::New(env, "the filter is too large").ThrowAsJavaScriptException();
+                return;
+            }
+            blocks = (size_t) nblocks;
+
+            // ArrayBuffers are zero filled and aligned for any element type
+            Napi::ArrayBuffer array_buffer = Napi::ArrayBuffer::New(env, blocks * FILTER_BLOCK_BYTES);
+            storage = Napi::Uint8Array::New(env, blocks * FILTER_BLOCK_BYTES, array_buffer, 0);
+            words = (filter_word*) array_buffer.Data();
+        }
+        keep_storage = Napi::Persistent(storage.As<Napi::Object>());
+
+        key = (unsigned char*) sodium_malloc(crypto_shorthash_siphashx24_KEYBYTES);
+        if( key == NULL ) {
+            words = NULL;
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_memory_hold(env, sodium_secure_footprint(crypto_shorthash_siphashx24_KEYBYTES));
+        memcpy(key, k, crypto_shorthash_siphashx24_KEYBYTES);
+        sodium_mprotect_readonly(key);
+    }
+
+    ~BloomFilter() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( key != NULL ) {
+            sodium_free(key);
+            key = NULL;
+            sodium_memory_hold(Env(), -(int64_t) sodium_secure_footprint(crypto_shorthash_siphashx24_KEYBYTES));
+        }
+    }
+
+    // The block of `item` and its bits in the block, one mask per word
+    filter_word* Locate(const unsigned char* item, size_t size, uint64_t mask[FILTER_BLOCK_WORDS]) {
+        unsigned char h[crypto_shorthash_siphashx24_BYTES];
+        crypto_shorthash_siphashx24(h, item, size, key);
+        uint64_t a = 0, b = 0;
+        for(int i = 7; i >= 0; i--) {
+            a = (a << 8) | h[i];
+            b = (b << 8) | h[8 + i];
+        }
+
+        // Multiply and shift instead of a modulo to pick the block
+        uint64_t block = ((a >> 32) * (uint64_t) blocks) >> 32;
+        uint32_t h1 = (uint32_t) b, h2 = (uint32_t) (b >> 32) | 1;
+        memset(mask, 0, FILTER_BLOCK_WORDS * sizeof(uint64_t));
+        for(size_t i = 0; i < hashes; i++) {
+            uint32_t bit = (h1 + (uint32_t) i * h2) & (FILTER_BLOCK_BITS - 1);
+            mask[bit >> 6] |= 1ULL << (bit & 63);
+        }
+        return words + block * FILTER_BLOCK_WORDS;
+    }
+
+    bool Insert(const unsigned char* item, size_t size) {
+        uint64_t mask[FILTER_BLOCK_WORDS];
+        filter_word* line = Locate(item, size, mask);
+        bool added = false;
+        for(int i = 0; i < FILTER_BLOCK_WORDS; i++) {
+            if( mask[i] != 0 && (line[i].fetch_or(mask[i], std::memory_order_relaxed) & mask[i]) != mask[i] ) {
+                added = true;
+            }
+        }
+        return added;
+    }
+
+    bool Contains(const unsigned char* item, size_t size) {
+        uint64_t mask[FILTER_BLOCK_WORDS];
+        filter_word* line = Locate(item, size, mask);
+        for(int i = 0; i < FILTER_BLOCK_WORDS; i++) {
+            if( (line[i].load(std::memory_order_relaxed) & mask[i]) != mask[i] ) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+#define CHECK_CONTEXT() \
+    if( key == NULL ) { \
+        THROW_ERROR("BloomFilter was disposed"); \
+    }
+
+    // The items of a batch: an array of buffers, or a packed buffer and lengths
+#define ARG_TO_FILTER_ITEMS(NAME) \
+    std::vector<SodiumSpan> NAME; \
+    unsigned char* NAME ## _packed = NULL; \
+    size_t NAME ## _packed_size = 0; \
+    if( info[0].IsArray() ) { \
+        size_t NAME ## _count = SODIUM_BATCH_ANY; \
+        if( !sodium_batch_arg(env, info[0], #NAME, NAME ## _count, 0, false, NAME) ) { \
+            return NAPI_NULL; \
+        } \
+    } else if( !sodium_arg_bytes(info[0], NAME ## _packed, NAME ## _packed_size) ) { \
+        THROW_ERROR("argument " #NAME " must be an array of buffers or a buffer"); \
+    } else if( !sodium_batch_chunks(env, NAME ## _packed, NAME ## _packed_size, info[1], "lengths", NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg = 2; \
+    size_t threads = 1; \
+    if( info.Length() > 2 && !info[2].IsUndefined() ) { \
+        ARG_TO_NUMBER(nthreads); \
+        threads = nthreads; \
+    }
+
+    Napi::Value Add(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument item must be a buffer");
+        ARG_TO_UCHAR_BUFFER(item);
+
+        return Insert(item, item_size) ? NAPI_TRUE : NAPI_FALSE;
+    }
+
+    Napi::Value Has(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument item must be a buffer");
+        ARG_TO_UCHAR_BUFFER(item);
+
+        return Contains(item, item_size) ? NAPI_TRUE : NAPI_FALSE;
+    }
+
+    Napi::Value AddBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument items must be an array of buffers or a buffer");
+        ARG_TO_FILTER_ITEMS(items);
+
+        std::vector<unsigned char> added(items.size(), 0);
+        sodium_batch_parallel(items.size(), threads, 4096, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                added[i] = Insert(items[i].data, items[i].size);
+            }
+        });
+        return sodium_batch_bitmap(env, added);
+    }
+
+    Napi::Value HasBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument items must be an array of buffers or a buffer");
+        ARG_TO_FILTER_ITEMS(items);
+
+        std::vector<unsigned char> found(items.size(), 0);
+        sodium_batch_parallel(items.size(), threads, 4096, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                found[i] = Contains(items[i].data, items[i].size);
+            }
+        });
+        return sodium_batch_bitmap(env, found);
+    }
+
+#undef ARG_TO_FILTER_ITEMS
+
+    Napi::Value Clear(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        for(size_t i = 0; i < blocks * FILTER_BLOCK_WORDS; i++) {
+            words[i].store(0, std::memory_order_relaxed);
+        }
+        return env.Undefined();
+    }
+
+    Napi::Value Bits(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) blocks * FILTER_BLOCK_BITS);
+    }
+
+    Napi::Value Hashes(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) hashes);
+    }
+
+    Napi::Value Buffer(const Napi::CallbackInfo& info) {
+        return keep_storage.IsEmpty() ? info.Env().Null() : keep_storage.Value();
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    unsigned char* key;
+    filter_word* words;
+    size_t blocks;
+    size_t hashes;
+
+    // The storage, alive as long as the filter
+    Napi::ObjectReference keep_storage;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_shorthash_filter(Napi::Env env, Napi::Object exports) {
+    BloomFilter::Init(env, exports);
+}
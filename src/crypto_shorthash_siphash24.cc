@@ -5,7 +5,13 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <vector>
+
 #include "node_sodium.h"
+#include "node_sodium_batch.h"
 
 /**
  * int crypto_shorthash_siphash24(
@@ -45,6 +51,427 @@ NAPI_METHOD(crypto_shorthash_siphash24) {
     return NAPI_NULL;
 }
 
+// The 8 byte hash as the 64 bit integer libsodium stores little endian
+static uint64_t siphash24_u64(const unsigned char* in, size_t in_size, const unsigned char* key) {
+    unsigned char hash[crypto_shorthash_siphash24_BYTES];
+    crypto_shorthash_siphash24(hash, in, in_size, key);
+
+    uint64_t value = 0;
+    for(int i = crypto_shorthash_siphash24_BYTES - 1; i >= 0; i--) {
+        value = (value << 8) | hash[i];
+    }
+    return value;
+}
+
+/**
+ * crypto_shorthash_siphash24_bigint:
+ * SipHash-2-4 of a message as a BigInt, without allocating a Buffer
+ *
+ *     var h = sodium.crypto_shorthash_siphash24_bigint(message, key);
+ *
+ * **Returns**:
+ *
+ * ~ hash (BigInt): the 8 byte hash read as a little endian unsigned integer,
+ *   the same value `buffer.readBigUInt64LE()` gives for the Buffer returned
+ *   by `crypto_shorthash_siphash24`
+ *
+ * `crypto_shorthash_siphash24_uint32` returns the low 32 bits as a Number,
+ * which is usually all a hash table needs to pick a bucket.
+ */
+NAPI_METHOD(crypto_shorthash_siphash24_bigint) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments message and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphash24_KEYBYTES);
+
+    napi_value result;
+    napi_create_bigint_uint64(env, siphash24_u64(message, message_size, key), &result);
+    return Napi::Value(env, result);
+}
+
+NAPI_METHOD(crypto_shorthash_siphash24_uint32) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments message and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphash24_KEYBYTES);
+
+    return Napi::Number::New(env, (uint32_t) siphash24_u64(message, message_size, key));
+}
+
+/**
+ * crypto_shorthash_siphash24_batch:
+ * SipHash-2-4 of many messages packed in one buffer
+ *
+ *     var hashes = sodium.crypto_shorthash_siphash24_batch(messages, lengths, key, [out]);
+ *
+ * ~ messages (Buffer): the messages back to back
+ * ~ lengths (Array|Uint32Array|Number): length of each message, adding up to
+ *   `messages.length`, or a single Number when they all have the same length
+ * ~ key (Buffer): `crypto_shorthash_siphash24_KEYBYTES` key
+ * ~ out (BigUint64Array|Uint32Array|Buffer): optional, where to write the
+ *   hashes. A BigUint64Array gets one value per message, a Uint32Array
+ *   either the low 32 bits of each hash (one element per message) or the low
+ *   and high halves (two elements per message), and a Buffer of
+ *   `count * crypto_shorthash_siphash24_BYTES` bytes the hashes as
+ *   `crypto_shorthash_siphash24` returns them
+ *
+ * **Returns**:
+ *
+ * ~ out, or a new BigUint64Array with one hash per message
+ *
+ * **Sample**:
+ *
+ *     var buckets = new Uint32Array(count);
+ *     sodium.crypto_shorthash_siphash24_batch(ids, 16, key, buckets);
+ *     // buckets[i] % tableSize picks the bucket for message i
+ */
+NAPI_METHOD(crypto_shorthash_siphash24_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments messages, lengths and key are required");
+    ARG_TO_CHUNKS(messages, lengths);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphash24_KEYBYTES);
+    size_t count = messages.size();
+
+    Napi::Value out;
+    if( info.Length() > 3 && !info[3].IsUndefined() ) {
+        out = info[3];
+    } else {
+        napi_value array_buffer, array;
+        void* data = NULL;
+        napi_create_arraybuffer(env, count * sizeof(uint64_t), &data, &array_buffer);
+        napi_create_typedarray(env, napi_biguint64_array, count, array_buffer, 0, &array);
+        out = Napi::Value(env, array);
+    }
+
+    napi_typedarray_type type;
+    size_t length = 0;
+    void* data = NULL;
+    if( !out.IsTypedArray() ||
+        napi_get_typedarray_info(env, out, &type, &length, &data, NULL, NULL) != napi_ok ) {
+        THROW_ERROR("argument out must be a BigUint64Array, a Uint32Array or a Buffer");
+    }
+
+    if( type == napi_biguint64_array && length == count ) {
+        uint64_t* values = (uint64_t*) data;
+        for(size_t i = 0; i < count; i++) {
+            values[i] = siphash24_u64(messages[i].data, messages[i].size, key);
+        }
+    } else if( type == napi_uint32_array && (length == count || length == 2 * count) ) {
+        uint32_t* values = (uint32_t*) data;
+        bool halves = length == 2 * count && count != 0;
+        for(size_t i = 0; i < count; i++) {
+            uint64_t h = siphash24_u64(messages[i].data, messages[i].size, key);
+            if( halves ) {
+                values[2 * i] = (uint32_t) h;
+                values[2 * i + 1] = (uint32_t) (h >> 32);
+            } else {
+                values[i] = (uint32_t) h;
+            }
+        }
+    } else if( type == napi_uint8_array && length == count * crypto_shorthash_siphash24_BYTES ) {
+        unsigned char* bytes = (unsigned char*) data;
+        for(size_t i = 0; i < count; i++) {
+            crypto_shorthash_siphash24(bytes + i * crypto_shorthash_siphash24_BYTES,
+                                       messages[i].data, messages[i].size, key);
+        }
+    } else {
+        THROW_ERROR("argument out must be a BigUint64Array, or a Uint32Array or Buffer, "
+                    "with room for one hash per message");
+    }
+    return out;
+}
+
+// A node table: the BigUint64Array of node hashes crypto_shorthash_batch returns
+static bool siphash24_table_arg(Napi::Env env, Napi::Value value, const uint64_t*& table, size_t& count) {
+    napi_typedarray_type type;
+    void* data = NULL;
+    if( !value.IsTypedArray() ||
+        napi_get_typedarray_info(env, value, &type, &count, &data, NULL, NULL) != napi_ok ||
+        type != napi_biguint64_array || count == 0 ) {
+        sodium_throw(env, "argument nodes must be a non empty BigUint64Array of node hashes");
+        return false;
+    }
+    table = (const uint64_t*) data;
+    return true;
+}
+
+// Rendezvous score of the message hash `h` for a node: SipHash of both
+static uint64_t siphash24_score(uint64_t h, uint64_t node, const unsigned char* key) {
+    unsigned char pair[16];
+    for(int i = 0; i < 8; i++) {
+        pair[i] = (unsigned char) (h >> (8 * i));
+        pair[8 + i] = (unsigned char) (node >> (8 * i));
+    }
+    return siphash24_u64(pair, sizeof pair, key);
+}
+
+// The index of the highest score, the lowest index on a tie
+static uint32_t siphash24_rendezvous(uint64_t h, const uint64_t* table, size_t count, const unsigned char* key) {
+    uint32_t best = 0;
+    uint64_t best_score = siphash24_score(h, table[0], key);
+    for(size_t i = 1; i < count; i++) {
+        uint64_t score = siphash24_score(h, table[i], key);
+        if( score > best_score ) {
+            best_score = score;
+            best = (uint32_t) i;
+        }
+    }
+    return best;
+}
+
+/**
+ * crypto_shorthash_siphash24_rendezvous:
+ * Rendezvous (highest random weight) hashing of a message over a node table
+ *
+ *     var nodes = sodium.crypto_shorthash_siphash24_batch(ids, lengths, key);
+ *     var index = sodium.crypto_shorthash_siphash24_rendezvous(message, nodes, key, [k]);
+ *
+ * ~ message (Buffer): what to route, a request key
+ * ~ nodes (BigUint64Array): the hash of each node id, computed once with
+ *   `crypto_shorthash_siphash24_batch` and the same key
+ * ~ key (Buffer): `crypto_shorthash_siphash24_KEYBYTES` key
+ * ~ k (Number): optional, how many nodes to rank
+ *
+ * The message is hashed once, then each node scores the SipHash of that
+ * hash and its own, so a request costs one short hash per node whatever the
+ * message length. The node with the highest score wins. Removing a node
+ * only moves the messages it won, and without the key nobody can aim
+ * messages at one node.
+ *
+ * **Returns**:
+ *
+ * ~ index (Number): the index of the winning node in `nodes`
+ * ~ ranking (Uint32Array): with `k`, the indexes of the `k` best nodes, the
+ *   winner first, for replicas or failover
+ */
+NAPI_METHOD(crypto_shorthash_siphash24_rendezvous) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, nodes and key are required");
+    ARG_TO_UCHAR_BUFFER(message);
+    const uint64_t* table = NULL;
+    size_t count = 0;
+    if( !siphash24_table_arg(env, info[_arg++], table, count) ) {
+        return NAPI_NULL;
+    }
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphash24_KEYBYTES);
+
+    uint64_t h = siphash24_u64(message, message_size, key);
+    if( info.Length() <= 3 || info[3].IsUndefined() ) {
+        return Napi::Number::New(env, siphash24_rendezvous(h, table, count, key));
+    }
+
+    ARG_TO_NUMBER(k);
+    if( k == 0 || k > count ) {
+        THROW_ERROR("argument k must be between 1 and the number of nodes");
+    }
+    std::vector<std::pair<uint64_t, uint32_t>> scores(count);
+    for(size_t i = 0; i < count; i++) {
+        // Negated index, so that the lowest index wins a tie
+        scores[i] = std::make_pair(siphash24_score(h, table[i], key), (uint32_t) ~i);
+    }
+    std::partial_sort(scores.begin(), scores.begin() + k, scores.end(),
+                      std::greater<std::pair<uint64_t, uint32_t>>());
+    Napi::Uint32Array ranking = Napi::Uint32Array::New(env, k);
+    for(size_t i = 0; i < k; i++) {
+        ranking[i] = ~scores[i].second;
+    }
+    return ranking;
+}
+
+/**
+ * crypto_shorthash_siphash24_rendezvous_batch:
+ * The winning node of many messages packed in one buffer
+ *
+ *     var winners = sodium.crypto_shorthash_siphash24_rendezvous_batch(messages, lengths, nodes, key, [out]);
+ *
+ * ~ messages, lengths: as for `crypto_shorthash_siphash24_batch`
+ * ~ nodes, key: as for `crypto_shorthash_siphash24_rendezvous`
+ * ~ out (Uint32Array): optional, one element per message
+ *
+ * **Returns**:
+ *
+ * ~ out, or a new Uint32Array with the winning node index of each message
+ */
+NAPI_METHOD(crypto_shorthash_siphash24_rendezvous_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments messages, lengths, nodes and key are required");
+    ARG_TO_CHUNKS(messages, lengths);
+    const uint64_t* table = NULL;
+    size_t count = 0;
+    if( !siphash24_table_arg(env, info[_arg++], table, count) ) {
+        return NAPI_NULL;
+    }
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphash24_KEYBYTES);
+
+    Napi::Uint32Array out;
+    if( info.Length() > 4 && !info[4].IsUndefined() ) {
+        if( !info[4].IsTypedArray() || info[4].As<Napi::TypedArray>().TypedArrayType() != napi_uint32_array ||
+            info[4].As<Napi::Uint32Array>().ElementLength() != messages.size() ) {
+            THROW_ERROR("argument out must be a Uint32Array with one element per message");
+        }
+        out = info[4].As<Napi::Uint32Array>();
+    } else {
+        out = Napi::Uint32Array::New(env, messages.size());
+    }
+
+    uint32_t* winners = out.Data();
+    for(size_t i = 0; i < messages.size(); i++) {
+        uint64_t h = siphash24_u64(messages[i].data, messages[i].size, key);
+        winners[i] = siphash24_rendezvous(h, table, count, key);
+    }
+    return out;
+}
+
+/**
+ * crypto_shorthash_siphash24_jump:
+ * Jump consistent hash of a message into one of `buckets` buckets
+ *
+ *     var bucket = sodium.crypto_shorthash_siphash24_jump(message, buckets, key);
+ *
+ * ~ buckets (Number): the number of buckets, 1 to 2^31
+ *
+ * Lamping and Veach's jump hash, seeded with the SipHash of the message. It
+ * needs no node table and no memory, but buckets can only be added or taken
+ * away at the end: growing from n to n + 1 buckets moves 1/(n + 1) of the
+ * messages, all to the new bucket.
+ *
+ * **Returns**:
+ *
+ * ~ bucket (Number): between 0 and `buckets - 1`
+ */
+NAPI_METHOD(crypto_shorthash_siphash24_jump) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments message, buckets and key are required");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_NUMBER(buckets);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphash24_KEYBYTES);
+    if( buckets == 0 || buckets > 0x80000000ULL ) {
+        THROW_ERROR("argument buckets must be between 1 and 2^31");
+    }
+
+    uint64_t h = siphash24_u64(message, message_size, key);
+    int64_t b = -1, j = 0;
+    while( j < (int64_t) buckets ) {
+        b = j;
+        h = h * 2862933555777941757ULL + 1;
+        j = (int64_t) ((b + 1) * ((double) (1LL << 31) / (double) ((h >> 33) + 1)));
+    }
+    return Napi::Number::New(env, (double) b);
+}
+
+/**
+ * int crypto_shorthash_siphashx24(
+ *    unsigned char *out,
+ *    const unsigned char *in,
+ *    unsigned long long inlen,
+ *    const unsigned char *key)
+ *
+ * SipHashX-2-4, the 128 bit variant, for fingerprints where 64 bits would
+ * collide too soon: a dedup cache of millions of keys. Takes the same key
+ * as crypto_shorthash_siphash24.
+ */
+NAPI_METHOD(crypto_shorthash_siphashx24) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments message and key must be buffers");
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphashx24_KEYBYTES);
+
+    NEW_BUFFER_AND_PTR(hash, crypto_shorthash_siphashx24_BYTES);
+
+    if( crypto_shorthash_siphashx24(hash_ptr, message, message_size, key) == 0 ) {
+        return hash;
+    }
+
+    return NAPI_NULL;
+}
+
+// The 16 byte hash as the two 64 bit integers libsodium stores little endian
+static void siphashx24_u64(uint64_t* out, const unsigned char* in, size_t in_size, const unsigned char* key) {
+    unsigned char hash[crypto_shorthash_siphashx24_BYTES];
+    crypto_shorthash_siphashx24(hash, in, in_size, key);
+
+    out[0] = out[1] = 0;
+    for(int i = 7; i >= 0; i--) {
+        out[0] = (out[0] << 8) | hash[i];
+        out[1] = (out[1] << 8) | hash[8 + i];
+    }
+}
+
+/**
+ * crypto_shorthash_siphashx24_batch:
+ * SipHashX-2-4 of many messages packed in one buffer
+ *
+ *     var hashes = sodium.crypto_shorthash_siphashx24_batch(messages, lengths, key, [out]);
+ *
+ * ~ messages, lengths: as for `crypto_shorthash_siphash24_batch`
+ * ~ key (Buffer): `crypto_shorthash_siphashx24_KEYBYTES` key
+ * ~ out (BigUint64Array|Buffer): optional, where to write the hashes. A
+ *   BigUint64Array gets a pair of values per message, elements `2 * i` and
+ *   `2 * i + 1` the low and high 8 bytes read little endian, and a Buffer of
+ *   `count * crypto_shorthash_siphashx24_BYTES` bytes the hashes as
+ *   `crypto_shorthash_siphashx24` returns them
+ *
+ * **Returns**:
+ *
+ * ~ out, or a new BigUint64Array with a pair of values per message
+ *
+ * **Sample**:
+ *
+ *     var fp = sodium.crypto_shorthash_siphashx24_batch(keys, lengths, key);
+ *     // fp[2 * i] and fp[2 * i + 1] fingerprint message i
+ */
+NAPI_METHOD(crypto_shorthash_siphashx24_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments messages, lengths and key are required");
+    ARG_TO_CHUNKS(messages, lengths);
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_shorthash_siphashx24_KEYBYTES);
+    size_t count = messages.size();
+
+    Napi::Value out;
+    if( info.Length() > 3 && !info[3].IsUndefined() ) {
+        out = info[3];
+    } else {
+        napi_value array_buffer, array;
+        void* data = NULL;
+        napi_create_arraybuffer(env, count * 2 * sizeof(uint64_t), &data, &array_buffer);
+        napi_create_typedarray(env, napi_biguint64_array, 2 * count, array_buffer, 0, &array);
+        out = Napi::Value(env, array);
+    }
+
+    napi_typedarray_type type;
+    size_t length = 0;
+    void* data = NULL;
+    if( !out.IsTypedArray() ||
+        napi_get_typedarray_info(env, out, &type, &length, &data, NULL, NULL) != napi_ok ) {
+        THROW_ERROR("argument out must be a BigUint64Array or a Buffer");
+    }
+
+    if( type == napi_biguint64_array && length == 2 * count ) {
+        uint64_t* values = (uint64_t*) data;
+        for(size_t i = 0; i < count; i++) {
+            siphashx24_u64(values + 2 * i, messages[i].data, messages[i].size, key);
+        }
+    } else if( type == napi_uint8_array && length == count * crypto_shorthash_siphashx24_BYTES ) {
+        unsigned char* bytes = (unsigned char*) data;
+        for(size_t i = 0; i < count; i++) {
+            crypto_shorthash_siphashx24(bytes + i * crypto_shorthash_siphashx24_BYTES,
+                                        messages[i].data, messages[i].size, key);
+        }
+    } else {
+        THROW_ERROR("argument out must be a BigUint64Array with two elements per message, "
+                    "or a Buffer with room for one hash per message");
+    }
+    return out;
+}
+
 /**
  * Register function calls in node binding
  */
@@ -52,6 +479,17 @@ void register_crypto_shorthash_siphash24(Napi::Env env, Napi::Object exports) {
 
     // Short Hash
     EXPORT(crypto_shorthash_siphash24);
+    EXPORT(crypto_shorthash_siphash24_bigint);
+    EXPORT(crypto_shorthash_siphash24_uint32);
+    EXPORT(crypto_shorthash_siphash24_batch);
+    EXPORT(crypto_shorthash_siphash24_rendezvous);
+    EXPORT(crypto_shorthash_siphash24_rendezvous_batch);
+    EXPORT(crypto_shorthash_siphash24_jump);
     EXPORT_INT(crypto_shorthash_siphash24_BYTES);
     EXPORT_INT(crypto_shorthash_siphash24_KEYBYTES);
+
+    EXPORT(crypto_shorthash_siphashx24);
+    EXPORT(crypto_shorthash_siphashx24_batch);
+    EXPORT_INT(crypto_shorthash_siphashx24_BYTES);
+    EXPORT_INT(crypto_shorthash_siphashx24_KEYBYTES);
 }
\ No newline at end of file
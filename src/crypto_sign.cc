@@ -17,10 +17,21 @@ void register_crypto_sign(Napi::Env env, Napi::Object exports) {
      // Sign
     EXPORT_ALIAS(crypto_sign, crypto_sign_ed25519);
     EXPORT_ALIAS(crypto_sign_open, crypto_sign_ed25519_open);
+    EXPORT_ALIAS(crypto_sign_open_view, crypto_sign_ed25519_open_view);
+    EXPORT_ALIAS(crypto_sign_into, crypto_sign_ed25519_into);
+    EXPORT_ALIAS(crypto_sign_open_into, crypto_sign_ed25519_open_into);
     EXPORT_ALIAS(crypto_sign_detached, crypto_sign_ed25519_detached);
     EXPORT_ALIAS(crypto_sign_verify_detached, crypto_sign_ed25519_verify_detached);
     EXPORT_ALIAS(crypto_sign_keypair, crypto_sign_ed25519_keypair);
+    EXPORT_ALIAS(crypto_sign_keypair_packed, crypto_sign_ed25519_keypair_packed);
     EXPORT_ALIAS(crypto_sign_seed_keypair, crypto_sign_ed25519_seed_keypair);
+
+    // Multipart, Ed25519ph
+    EXPORT_ALIAS(crypto_sign_init, crypto_sign_ed25519ph_init);
+    EXPORT_ALIAS(crypto_sign_update, crypto_sign_ed25519ph_update);
+    EXPORT_ALIAS(crypto_sign_final_create, crypto_sign_ed25519ph_final_create);
+    EXPORT_ALIAS(crypto_sign_final_verify, crypto_sign_ed25519ph_final_verify);
+    EXPORT_ALIAS(crypto_sign_statebytes, crypto_sign_ed25519ph_statebytes);
     
     EXPORT_INT(crypto_sign_SEEDBYTES);
     EXPORT_INT(crypto_sign_BYTES);
@@ -0,0 +1,625 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "crypto_sign_curve25519_cache.h"
+#include "sodium_memory.h"
+#include "sodium_shared_cache.h"
+
+// Ed25519 public keys decompressed once, in the vendored open.c
+extern "C" {
+size_t crypto_sign_ed25519_verifykeybytes(void);
+int crypto_sign_ed25519_verifykey_init(void *vk, const unsigned char *pk);
+int crypto_sign_ed25519_verify_detached_vk(const unsigned char *sig,
+                                           const unsigned char *m,
+                                           unsigned long long mlen,
+                                           const void *vk);
+}
+
+/**
+ * SigningKey:
+ * Ed25519 signing key object
+ *
+ * Holds the secret key in memory allocated with `sodium_malloc`, protected
+ * with guard pages and made read only, so signing services can keep one key
+ * loaded for their whole life without it sitting in a JS Buffer. The key is
+ * checked once, when the object is built; each call only validates the
+ * messages.
+ *
+ *    var key = new sodium.SigningKey(secretKey);
+ *
+ * ~ secretKey (Buffer): `crypto_sign_ed25519_SECRETKEYBYTES` secret key, or a
+ *   `crypto_sign_ed25519_SEEDBYTES` seed. The object keeps its own copy
+ *
+ * Properties:
+ *
+ * ~ publicKey (Buffer): the matching public key
+ *
+ * Methods:
+ *
+ * ~ sign(message): detached signature, same as `crypto_sign_ed25519_detached`
+ * ~ signBatch(messages, [threads]): sign an array of messages. Returns one
+ *   buffer with `messages.length` signatures back to back. `threads` splits
+ *   the batch across that many threads, the call still blocks
+ * ~ signBatchAsync(messages, [callback]): same as `signBatch` on the libuv
+ *   threadpool. Returns a Promise when no callback is given
+ * ~ dispose(): wipes and frees the key. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var kp = sodium.crypto_sign_ed25519_keypair();
+ *     var key = new sodium.SigningKey(kp.secretKey);
+ *
+ *     var sig = key.sign(message);
+ *     var sigs = key.signBatch([m1, m2, m3]);
+ *     // sigs.slice(64, 128) is the signature of m2
+ */
+class SigningKey : public Napi::ObjectWrap<SigningKey> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "SigningKey", {
+            InstanceMethod("sign", &SigningKey::Sign),
+            InstanceMethod("signBatch", &SigningKey::SignBatch),
+            InstanceMethod("signBatchAsync", &SigningKey::SignBatchAsync),
+            InstanceMethod("dispose", &SigningKey::Dispose),
+            InstanceAccessor("publicKey", &SigningKey::PublicKey, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "SigningKey"), ctor);
+    }
+
+    SigningKey(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<SigningKey>(info), sk(NULL) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() < 1 || !sodium_arg_bytes(info[0], key, key_size) ) {
+            Napi::TypeError::New(env, "argument secretKey must be a buffer").ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( key_size != crypto_sign_ed25519_SECRETKEYBYTES &&
+            key_size != crypto_sign_ed25519_SEEDBYTES ) {
+            Napi::Error::New(env, "argument secretKey must be crypto_sign_ed25519_SECRETKEYBYTES "
+                                  "or crypto_sign_ed25519_SEEDBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+
+        sk = (unsigned char*) sodium_secret_alloc(env, crypto_sign_ed25519_SECRETKEYBYTES);
+        if( sk == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( key_size == crypto_sign_ed25519_SEEDBYTES ) {
+            crypto_sign_ed25519_seed_keypair(pk, sk, key);
+        } else {
+            memcpy(sk, key, crypto_sign_ed25519_SECRETKEYBYTES);
+            crypto_sign_ed25519_sk_to_pk(pk, sk);
+        }
+        sodium_secret_readonly(sk);
+    }
+
+    ~SigningKey() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( sk != NULL ) {
+            sodium_secret_free(Env(), sk, crypto_sign_ed25519_SECRETKEYBYTES);
+            sk = NULL;
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( sk == NULL ) { \
+        THROW_ERROR("SigningKey was disposed"); \
+    }
+
+    Napi::Value PublicKey(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Buffer<unsigned char>::Copy(env, pk, crypto_sign_ed25519_PUBLICKEYBYTES);
+    }
+
+    Napi::Value Sign(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER(message);
+
+        NEW_BUFFER_AND_PTR(sig, crypto_sign_ed25519_BYTES);
+        if( crypto_sign_ed25519_detached(sig_ptr, NULL, message, message_size, sk) == 0 ) {
+            return sig;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value SignBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument messages must be an array of buffers");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(messages, count);
+
+        size_t threads = 1;
+        if( info.Length() > 1 && !info[1].IsUndefined() ) {
+            ARG_TO_NUMBER(nthreads);
+            threads = nthreads;
+        }
+
+        NEW_BUFFER_AND_PTR(sigs, count * crypto_sign_ed25519_BYTES);
+        const unsigned char* key = sk;
+        sodium_batch_parallel(count, threads, 32, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                crypto_sign_ed25519_detached(sigs_ptr + i * crypto_sign_ed25519_BYTES, NULL,
+                                             messages[i].data, messages[i].size, key);
+            }
+        });
+        return sigs;
+    }
+
+    Napi::Value SignBatchAsync(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument messages must be an array of buffers");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(messages, count);
+
+        NEW_BUFFER_AND_PTR(sigs, count * crypto_sign_ed25519_BYTES);
+
+        // The worker gets its own copies so the JS side may dispose the key
+        // or reuse the message buffers while the batch is being signed.
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "SigningKey.signBatch");
+        unsigned char* out = worker->Pin(sigs);
+        const unsigned char* key = worker->Copy(sk, crypto_sign_ed25519_SECRETKEYBYTES);
+        std::vector<SodiumSpan> copies(count);
+        for(size_t i = 0; i < count; i++) {
+            copies[i].data = messages[i].size ? worker->Copy(messages[i].data, messages[i].size) : NULL;
+            copies[i].size = messages[i].size;
+        }
+
+        return worker->Start([=]() {
+            for(size_t i = 0; i < copies.size(); i++) {
+                crypto_sign_ed25519_detached(out + i * crypto_sign_ed25519_BYTES, NULL,
+                                             copies[i].data, copies[i].size, key);
+            }
+            return 0;
+        }, ASYNC_RESULT_BUFFER);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    unsigned char* sk;
+    unsigned char pk[crypto_sign_ed25519_PUBLICKEYBYTES];
+};
+
+// Decompressed keys shared between processes, see crypto_sign_verifykey_cache_share.
+// Swapped with std::atomic_store, read with std::atomic_load
+static std::shared_ptr<SharedCache> verifykey_shared;
+
+/**
+ * VerifyKey:
+ * Ed25519 public key object
+ *
+ * `crypto_sign_ed25519_verify_detached` checks the public key and
+ * decompresses it to a curve point on every call. A VerifyKey does that once,
+ * when it is built, so services that check many signatures from the same
+ * issuer only pay for the hash and the scalar multiplication. Results are the
+ * same as `crypto_sign_ed25519_verify_detached`. With a segment attached by
+ * `crypto_sign_verifykey_cache_share`, a key another process already
+ * decompressed is copied from there.
+ *
+ *    var key = new sodium.VerifyKey(publicKey);
+ *
+ * ~ publicKey (Buffer): `crypto_sign_ed25519_PUBLICKEYBYTES` public key.
+ *   Throws if it is not a valid Ed25519 key
+ *
+ * Properties:
+ *
+ * ~ publicKey (Buffer): the public key
+ * ~ curve25519PublicKey (Buffer): the same key converted for `crypto_box`
+ *   and `crypto_scalarmult`, as by `crypto_sign_ed25519_pk_to_curve25519`.
+ *   Computed on first use and kept
+ *
+ * Methods:
+ *
+ * ~ verify(signature, message): true if `signature` is a valid detached
+ *   signature of `message`
+ * ~ verifyBatch(signatures, messages, [threads]): verify an array of
+ *   messages. `signatures` is an array of buffers or one buffer with the
+ *   signatures back to back. Returns a bitmap like
+ *   `crypto_sign_ed25519_verify_detached_batch`
+ * ~ dispose(): frees the key. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var issuer = new sodium.VerifyKey(kp.publicKey);
+ *
+ *     if( issuer.verify(sig, token) ) {
+ *         ...
+ *     }
+ */
+class VerifyKey : public Napi::ObjectWrap<VerifyKey> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "VerifyKey", {
+            InstanceMethod("verify", &VerifyKey::Verify),
+            InstanceMethod("verifyBatch", &VerifyKey::VerifyBatch),
+            InstanceMethod("dispose", &VerifyKey::Dispose),
+            InstanceAccessor("publicKey", &VerifyKey::PublicKey, nullptr),
+            InstanceAccessor("curve25519PublicKey", &VerifyKey::Curve25519PublicKey, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "VerifyKey"), ctor);
+    }
+
+    VerifyKey(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<VerifyKey>(info), vk(NULL), has_xpk(false) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() < 1 || !sodium_arg_bytes(info[0], key, key_size) ) {
+            Napi::TypeError::New(env, "argument publicKey must be a buffer").ThrowAsJavaScriptException();
+            return;
+        }
+
+        if( key_size != crypto_sign_ed25519_PUBLICKEYBYTES ) {
+            Napi::Error::New(env, "argument publicKey must be crypto_sign_ed25519_PUBLICKEYBYTES "
+                                  "bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+
+        vk = malloc(crypto_sign_ed25519_verifykeybytes());
+        if( vk == NULL ) {
+            Napi::Error::New(env, "cannot allocate memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_memory_hold(env, crypto_sign_ed25519_verifykeybytes());
+
+        std::shared_ptr<SharedCache> shared = std::atomic_load(&verifykey_shared);
+        unsigned char id[SHARED_CACHE_IDBYTES];
+        if( shared ) {
+            shared_cache_id(shared.get(), id, key, crypto_sign_ed25519_PUBLICKEYBYTES, NULL, 0);
+            if( shared_cache_get(shared.get(), id, (unsigned char*) vk) ) {
+                memcpy(pk, key, crypto_sign_ed25519_PUBLICKEYBYTES);
+                return;
+            }
+        }
+
+        if( crypto_sign_ed25519_verifykey_init(vk, key) != 0 ) {
+            Free();
+            Napi::Error::New(env, "argument publicKey is not a valid Ed25519 public key").ThrowAsJavaScriptException();
+            return;
+        }
+        memcpy(pk, key, crypto_sign_ed25519_PUBLICKEYBYTES);
+        if( shared ) {
+            shared_cache_put(shared.get(), id, (const unsigned char*) vk);
+        }
+    }
+
+    ~VerifyKey() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( vk != NULL ) {
+            free(vk);
+            vk = NULL;
+            sodium_memory_hold(Env(), -(int64_t) crypto_sign_ed25519_verifykeybytes());
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( vk == NULL ) { \
+        THROW_ERROR("VerifyKey was disposed"); \
+    }
+
+    Napi::Value PublicKey(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Buffer<unsigned char>::Copy(env, pk, crypto_sign_ed25519_PUBLICKEYBYTES);
+    }
+
+    Napi::Value Curve25519PublicKey(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( !has_xpk ) {
+            if( sign_curve25519_cache_pk(xpk, pk) != 0 ) {
+                THROW_ERROR("crypto_sign_ed25519_pk_to_curve25519 conversion failed");
+            }
+            has_xpk = true;
+        }
+        return Napi::Buffer<unsigned char>::Copy(env, xpk, crypto_scalarmult_curve25519_BYTES);
+    }
+
+    Napi::Value Verify(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments signature and message must be buffers");
+        ARG_TO_UCHAR_BUFFER_LEN(signature, crypto_sign_ed25519_BYTES);
+        ARG_TO_UCHAR_BUFFER(message);
+
+        if( crypto_sign_ed25519_verify_detached_vk(signature, message, message_size, vk) == 0 ) {
+            return NAPI_TRUE;
+        }
+        return NAPI_FALSE;
+    }
+
+    Napi::Value VerifyBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments must be: signatures, messages");
+
+        size_t count = SODIUM_BATCH_ANY;
+        std::vector<SodiumSpan> messages;
+        if( !sodium_batch_arg(env, info[1], "messages", count, 0, false, messages) ) {
+            return NAPI_NULL;
+        }
+
+        ARG_TO_BATCH_LEN(signatures, count, crypto_sign_ed25519_BYTES);
+        _arg++; // messages
+
+        size_t threads = 1;
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            ARG_TO_NUMBER(nthreads);
+            threads = nthreads;
+        }
+
+        std::vector<unsigned char> ok(count, 0);
+        const void* key = vk;
+        sodium_batch_parallel(count, threads, 64, [&](size_t begin, size_t end) {
+            for(size_t i = begin; i < end; i++) {
+                ok[i] = crypto_sign_ed25519_verify_detached_vk(signatures[i].data,
+                            messages[i].data, messages[i].size, key) == 0;
+            }
+        });
+
+        return sodium_batch_bitmap(env, ok);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    void* vk;
+    unsigned char pk[crypto_sign_ed25519_PUBLICKEYBYTES];
+    unsigned char xpk[crypto_scalarmult_curve25519_BYTES];
+    bool has_xpk;
+};
+
+/**
+ * SignState:
+ * Multipart Ed25519ph signature object
+ *
+ * Signs or verifies a message given in parts, so large files can be signed in
+ * constant memory. The SHA-512 state is kept in `sodium_malloc` memory rather
+ * than in the Buffer returned by `crypto_sign_init`. Signatures are
+ * Ed25519ph, the same as `crypto_sign_final_create`; they do not verify with
+ * `crypto_sign_verify_detached`.
+ *
+ *    var state = new sodium.SignState();
+ *
+ * Methods:
+ *
+ * ~ update(message): add the next part of the message. Returns the object,
+ *   so calls can be chained
+ * ~ finalCreate(secretKey): the signature of everything given to `update`
+ * ~ finalVerify(signature, publicKey): true if `signature` is valid for
+ *   everything given to `update`
+ * ~ dispose(): wipe and release the state without finishing it
+ *
+ * The state is wiped and released by both final calls; later calls throw.
+ *
+ * **Sample**:
+ *
+ *     var state = new sodium.SignState();
+ *     state.update(part1).update(part2);
+ *     var sig = state.finalCreate(kp.secretKey);
+ */
+class SignState : public Napi::ObjectWrap<SignState> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "SignState", {
+            InstanceMethod("update", &SignState::Update),
+            InstanceMethod("finalCreate", &SignState::FinalCreate),
+            InstanceMethod("finalVerify", &SignState::FinalVerify),
+            InstanceMethod("dispose", &SignState::Dispose)
+        });
+        exports.Set(Napi::String::New(env, "SignState"), ctor);
+    }
+
+    SignState(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<SignState>(info), state(NULL) {
+        Napi::Env env = info.Env();
+
+        state = (crypto_sign_ed25519ph_state*) sodium_malloc(sizeof(crypto_sign_ed25519ph_state));
+        if( state == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the sign state").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_memory_hold(env, sodium_secure_footprint(sizeof(crypto_sign_ed25519ph_state)));
+        crypto_sign_ed25519ph_init(state);
+    }
+
+    ~SignState() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( state != NULL ) {
+            sodium_free(state);
+            state = NULL;
+            sodium_memory_hold(Env(), -(int64_t) sodium_secure_footprint(sizeof(crypto_sign_ed25519ph_state)));
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( state == NULL ) { \
+        THROW_ERROR("sign state was finalized or disposed"); \
+    }
+
+    Napi::Value Update(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER(message);
+
+        crypto_sign_ed25519ph_update(state, message, message_size);
+        return info.This();
+    }
+
+    Napi::Value FinalCreate(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument secretKey must be a buffer");
+        ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_sign_ed25519_SECRETKEYBYTES);
+
+        NEW_BUFFER_AND_PTR(sig, crypto_sign_ed25519_BYTES);
+        int ret = crypto_sign_ed25519ph_final_create(state, sig_ptr, NULL, secretKey);
+        Free();
+        if( ret == 0 ) {
+            return sig;
+        }
+        return NAPI_NULL;
+    }
+
+    Napi::Value FinalVerify(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(2, "arguments signature and publicKey must be buffers");
+        ARG_TO_UCHAR_BUFFER_LEN(signature, crypto_sign_ed25519_BYTES);
+        ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
+
+        int ret = crypto_sign_ed25519ph_final_verify(state, signature, publicKey);
+        Free();
+        return Napi::Boolean::New(env, ret == 0);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    crypto_sign_ed25519ph_state* state;
+};
+
+/**
+ * crypto_sign_verifykey_cache_share:
+ * Attach a shared memory segment for the keys VerifyKey decompresses
+ *
+ *     sodium.crypto_sign_verifykey_cache_share(name, capacity);
+ *
+ * ~ name (String): the segment, the same in every process that should share
+ *   keys. null detaches the current one
+ * ~ capacity (Number): keys the segment holds, when this process creates it
+ *
+ * Only valid keys are stored. The segment records the layout of the
+ * decompressed keys, so a build with another field implementation refuses
+ * to attach to it. Not supported on Windows.
+ */
+NAPI_METHOD(crypto_sign_verifykey_cache_share) {
+    Napi::Env env = info.Env();
+
+    if( info.Length() < 1 || info[0].IsNull() || info[0].IsUndefined() ) {
+        std::atomic_store(&verifykey_shared, std::shared_ptr<SharedCache>());
+        return env.Undefined();
+    }
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument name must be a string or null");
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+    ARGS(2, "argument capacity must be a number");
+    _arg = 1;
+    ARG_TO_NUMBER(capacity);
+
+    // The base point, decompressed by this build, names the layout
+    static const unsigned char base[crypto_sign_ed25519_PUBLICKEYBYTES] = {
+        0x58, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+        0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+        0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66
+    };
+    size_t vk_size = crypto_sign_ed25519_verifykeybytes();
+    std::unique_ptr<unsigned char[]> vk(new unsigned char[vk_size]);
+    unsigned char format[SHARED_CACHE_FORMATBYTES];
+    crypto_sign_ed25519_verifykey_init(vk.get(), base);
+    crypto_generichash(format, sizeof format, vk.get(), vk_size, NULL, 0);
+
+    std::string error;
+    SharedCache* cache = shared_cache_open(name.c_str(), vk_size, capacity, format, error);
+    if( cache == NULL ) {
+        THROW_ERROR(error.c_str());
+    }
+    std::atomic_store(&verifykey_shared, std::shared_ptr<SharedCache>(cache, shared_cache_close));
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_sign_verifykey_cache_stats:
+ * Stats of the attached segment
+ *
+ * **Returns**:
+ *
+ * ~ object: null, or `{ name, capacity, size, locked, hits, misses, inserts,
+ *   evictions }`
+ */
+NAPI_METHOD(crypto_sign_verifykey_cache_stats) {
+    Napi::Env env = info.Env();
+
+    std::shared_ptr<SharedCache> shared = std::atomic_load(&verifykey_shared);
+    if( !shared ) {
+        return NAPI_NULL;
+    }
+    return shared_cache_stats(env, shared.get());
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_sign_context(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_sign_verifykey_cache_share);
+    EXPORT(crypto_sign_verifykey_cache_stats);
+
+    SigningKey::Init(env, exports);
+    VerifyKey::Init(env, exports);
+    SignState::Init(env, exports);
+}
@@ -0,0 +1,187 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "node_sodium.h"
+#include "crypto_sign_curve25519_cache.h"
+#include "sodium_memory.h"
+
+/**
+ * Ed25519 to Curve25519 public key cache
+ *
+ * `crypto_sign_ed25519_pk_to_curve25519` decompresses the Edwards point and
+ * inverts a field element on every call. Services that use one identity key
+ * for both signatures and boxes convert the same peer keys over and over.
+ * When enabled, converted keys are kept in a bounded LRU cache keyed by the
+ * Ed25519 public key. Both keys are public, so they are stored as they are.
+ *
+ * Invalid keys are not cached: converting one costs the full check every
+ * time. `VerifyKey.curve25519PublicKey` also goes through the cache.
+ */
+
+struct Curve25519CacheEntry {
+    std::string ed25519_pk;
+    unsigned char curve25519_pk[crypto_scalarmult_curve25519_BYTES];
+};
+
+static std::mutex curve25519_cache_mutex;
+static std::list<Curve25519CacheEntry> curve25519_cache_lru;   // most recent first
+static std::unordered_map<std::string, std::list<Curve25519CacheEntry>::iterator> curve25519_cache_index;
+static size_t curve25519_cache_capacity = 0;
+
+static double curve25519_cache_hits = 0;
+static double curve25519_cache_misses = 0;
+static double curve25519_cache_evictions = 0;
+
+// Caller holds curve25519_cache_mutex
+static void curve25519_cache_reset() {
+    curve25519_cache_lru.clear();
+    curve25519_cache_index.clear();
+}
+
+int sign_curve25519_cache_pk(unsigned char* curve25519_pk, const unsigned char* ed25519_pk) {
+    std::unique_lock<std::mutex> lock(curve25519_cache_mutex);
+
+    if( curve25519_cache_capacity == 0 ) {
+        lock.unlock();
+        return crypto_sign_ed25519_pk_to_curve25519(curve25519_pk, ed25519_pk);
+    }
+
+    std::string id((const char*) ed25519_pk, crypto_sign_ed25519_PUBLICKEYBYTES);
+    auto found = curve25519_cache_index.find(id);
+    if( found != curve25519_cache_index.end() ) {
+        auto it = found->second;
+        curve25519_cache_lru.splice(curve25519_cache_lru.begin(), curve25519_cache_lru, it);
+        memcpy(curve25519_pk, it->curve25519_pk, crypto_scalarmult_curve25519_BYTES);
+        curve25519_cache_hits++;
+        return 0;
+    }
+    curve25519_cache_misses++;
+
+    // Convert without holding the lock
+    lock.unlock();
+    if( crypto_sign_ed25519_pk_to_curve25519(curve25519_pk, ed25519_pk) != 0 ) {
+        return -1;
+    }
+    lock.lock();
+
+    // The cache may have been disabled, or filled by another thread, meanwhile
+    if( curve25519_cache_capacity == 0 || curve25519_cache_index.count(id) != 0 ) {
+        return 0;
+    }
+
+    if( curve25519_cache_lru.size() >= curve25519_cache_capacity ) {
+        auto last = std::prev(curve25519_cache_lru.end());
+        curve25519_cache_index.erase(last->ed25519_pk);
+        curve25519_cache_lru.erase(last);
+        curve25519_cache_evictions++;
+    }
+    curve25519_cache_lru.push_front(Curve25519CacheEntry());
+    curve25519_cache_lru.front().ed25519_pk = id;
+    memcpy(curve25519_cache_lru.front().curve25519_pk, curve25519_pk, crypto_scalarmult_curve25519_BYTES);
+    curve25519_cache_index[id] = curve25519_cache_lru.begin();
+    return 0;
+}
+
+/**
+ * crypto_sign_ed25519_pk_cache_enable:
+ * Turn the Ed25519 to Curve25519 public key cache on, or resize it
+ *
+ *     sodium.crypto_sign_ed25519_pk_cache_enable(capacity);
+ *
+ * ~ capacity (Number): maximum number of converted keys to keep. 0 disables
+ *   the cache
+ *
+ * Enabling an enabled cache clears it. Counters are reset.
+ */
+NAPI_METHOD(crypto_sign_ed25519_pk_cache_enable) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument capacity must be a number");
+    ARG_TO_NUMBER(capacity);
+
+    std::lock_guard<std::mutex> lock(curve25519_cache_mutex);
+    curve25519_cache_reset();
+    curve25519_cache_hits = curve25519_cache_misses = curve25519_cache_evictions = 0;
+
+    curve25519_cache_capacity = capacity;
+    if( capacity != 0 ) {
+        curve25519_cache_index.reserve(capacity);
+    }
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_sign_ed25519_pk_cache_disable:
+ * Turn the conversion cache off and forget every entry
+ */
+NAPI_METHOD(crypto_sign_ed25519_pk_cache_disable) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(curve25519_cache_mutex);
+    curve25519_cache_reset();
+    curve25519_cache_capacity = 0;
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_sign_ed25519_pk_cache_clear:
+ * Forget every entry, keeping the cache enabled
+ */
+NAPI_METHOD(crypto_sign_ed25519_pk_cache_clear) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(curve25519_cache_mutex);
+    curve25519_cache_reset();
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_sign_ed25519_pk_cache_stats:
+ * Cache counters
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ enabled, capacity, size, hits, misses, evictions }`
+ */
+NAPI_METHOD(crypto_sign_ed25519_pk_cache_stats) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(curve25519_cache_mutex);
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "enabled"), Napi::Boolean::New(env, curve25519_cache_capacity != 0));
+    result.Set(Napi::String::New(env, "capacity"), Napi::Number::New(env, (double) curve25519_cache_capacity));
+    result.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double) curve25519_cache_lru.size()));
+    result.Set(Napi::String::New(env, "hits"), Napi::Number::New(env, curve25519_cache_hits));
+    result.Set(Napi::String::New(env, "misses"), Napi::Number::New(env, curve25519_cache_misses));
+    result.Set(Napi::String::New(env, "evictions"), Napi::Number::New(env, curve25519_cache_evictions));
+    return result;
+}
+
+// See sodium_memory_usage
+size_t crypto_sign_curve25519_cache_memory() {
+    std::lock_guard<std::mutex> lock(curve25519_cache_mutex);
+    return sodium_lru_memory(curve25519_cache_lru, curve25519_cache_index, crypto_sign_ed25519_PUBLICKEYBYTES);
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_sign_curve25519_cache(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_sign_ed25519_pk_cache_enable);
+    EXPORT(crypto_sign_ed25519_pk_cache_disable);
+    EXPORT(crypto_sign_ed25519_pk_cache_clear);
+    EXPORT(crypto_sign_ed25519_pk_cache_stats);
+}
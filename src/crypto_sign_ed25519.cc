@@ -6,7 +6,46 @@
  * @License MIT
  */
 #include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "sodium_batch_stream.h"
+#include "crypto_sign_verify_cache.h"
+#include "sodium_stats.h"
+#include "crypto_keypair_pool.h"
+#include "crypto_sign_curve25519_cache.h"
+
+// Batch verification, in the vendored open.c
+extern "C" {
+int crypto_sign_ed25519_verify_batch(unsigned char *ok,
+                                     const unsigned char * const *sigs,
+                                     const unsigned char * const *ms,
+                                     const unsigned long long *mlens,
+                                     const unsigned char * const *pks,
+                                     size_t n);
+}
 
+/**
+ * Check items [begin, end) of a batch, `stride` spans apart, a key being
+ * decompressed once for a run of signatures it made
+ */
+static void verify_batch_range(unsigned char* ok, const SodiumSpan* signatures,
+                               const SodiumSpan* messages, const SodiumSpan* publicKeys,
+                               size_t stride, size_t begin, size_t end) {
+    size_t n = end - begin;
+    std::vector<const unsigned char*> sigs(n), ms(n), pks(n);
+    std::vector<unsigned long long> mlens(n);
+    for(size_t i = 0; i < n; i++) {
+        size_t k = (begin + i) * stride;
+        sigs[i] = signatures[k].data;
+        ms[i] = messages[k].data;
+        mlens[i] = messages[k].size;
+        pks[i] = publicKeys[k].data;
+    }
+    crypto_sign_ed25519_verify_batch(ok + begin, sigs.data(), ms.data(), mlens.data(), pks.data(), n);
+    for(size_t i = 0; i < n; i++) {
+        SODIUM_STAT(verify, mlens[i], 0, ok[begin + i] ? 0 : -1);
+    }
+}
 
 /**
  * Convert a ed25519 signing public key to a curve25519 exchange key.
@@ -29,7 +68,7 @@ NAPI_METHOD(crypto_sign_ed25519_pk_to_curve25519) {
     
     NEW_BUFFER_AND_PTR(curve25519_pk, crypto_box_PUBLICKEYBYTES);
 
-    if( crypto_sign_ed25519_pk_to_curve25519(curve25519_pk_ptr, ed25519_pk) != 0) {
+    if( sign_curve25519_cache_pk(curve25519_pk_ptr, ed25519_pk) != 0) {
       Napi::Error::New(env, "crypto_sign_ed25519_pk_to_curve25519 conversion failed").ThrowAsJavaScriptException();
       return NAPI_NULL;
     }
@@ -75,14 +114,15 @@ NAPI_METHOD(crypto_sign_ed25519) {
     Napi::Env env = info.Env();
 
     ARGS(2, "arguments message, and secretKey must be buffers");
-    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_OR_STRING(message);
     ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_sign_ed25519_SECRETKEYBYTES);
 
     NEW_BUFFER_AND_PTR(sig, message_size + crypto_sign_ed25519_BYTES);
 
     unsigned long long slen = 0;
 
-    if (crypto_sign_ed25519(sig_ptr, &slen, message, message_size, secretKey) == 0) {
+    if (SODIUM_STAT(sign, message_size, message_size + crypto_sign_ed25519_BYTES,
+            crypto_sign_ed25519(sig_ptr, &slen, message, message_size, secretKey)) == 0) {
         return sig;
     }
     
@@ -92,6 +132,9 @@ NAPI_METHOD(crypto_sign_ed25519) {
 /* int crypto_sign_ed25519_open(unsigned char *m, unsigned long long *mlen_p,
                              const unsigned char *sm, unsigned long long smlen,
                              const unsigned char *pk)
+
+   The signature is checked in place on the signed message, so the result is
+   the only allocation.
 */
 NAPI_METHOD(crypto_sign_ed25519_open) {
     Napi::Env env = info.Env();
@@ -100,12 +143,16 @@ NAPI_METHOD(crypto_sign_ed25519_open) {
     ARG_TO_UCHAR_BUFFER(signedMessage);
     ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
 
-    unsigned long long mlen = 0;
-    NEW_BUFFER_AND_PTR(msg, signedMessage_size);
+    if( signedMessage_size < crypto_sign_ed25519_BYTES ) {
+        return NAPI_NULL;
+    }
+    unsigned long long mlen = signedMessage_size - crypto_sign_ed25519_BYTES;
 
-    if (crypto_sign_ed25519_open(msg_ptr, &mlen, signedMessage, signedMessage_size, publicKey) == 0) {
+    if (SODIUM_STAT(verify, signedMessage_size, mlen,
+            crypto_sign_ed25519_verify_detached(signedMessage, signedMessage + crypto_sign_ed25519_BYTES,
+                                                mlen, publicKey)) == 0) {
         NEW_BUFFER_AND_PTR(m, mlen);
-        memcpy(m_ptr, msg_ptr, mlen);
+        memcpy(m_ptr, signedMessage + crypto_sign_ed25519_BYTES, mlen);
 
         return m;
     } 
@@ -113,6 +160,115 @@ NAPI_METHOD(crypto_sign_ed25519_open) {
     return NAPI_NULL;
 }
 
+/**
+ * crypto_sign_ed25519_open_view:
+ * Verify a signed message without copying it
+ *
+ *     var message = sodium.crypto_sign_ed25519_open_view(signedMessage, publicKey);
+ *
+ * ~ signedMessage (Buffer): signature followed by the message, as returned by
+ *   `crypto_sign_ed25519`
+ * ~ publicKey (Buffer): signer's public key
+ *
+ * **Returns**:
+ *
+ * ~ message (Buffer): view on `signedMessage` past the signature. Nothing is
+ *   copied, so changing `signedMessage` changes the message
+ * ~ null: if the signature is not valid
+ */
+NAPI_METHOD(crypto_sign_ed25519_open_view) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments signedMessage and verificationKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(signedMessage);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
+
+    if( signedMessage_size < crypto_sign_ed25519_BYTES ) {
+        return NAPI_NULL;
+    }
+
+    if( SODIUM_STAT(verify, signedMessage_size, 0,
+            crypto_sign_ed25519_verify_detached(signedMessage, signedMessage + crypto_sign_ed25519_BYTES,
+                                                signedMessage_size - crypto_sign_ed25519_BYTES, publicKey)) != 0 ) {
+        return NAPI_NULL;
+    }
+
+    Napi::Function subarray = signedMessage_buffer.Get("subarray").As<Napi::Function>();
+    return subarray.Call(signedMessage_buffer, {
+        Napi::Number::New(env, crypto_sign_ed25519_BYTES), Napi::Number::New(env, (double) signedMessage_size)
+    });
+}
+
+/**
+ * crypto_sign_ed25519_into:
+ * Sign a message into a caller buffer
+ *
+ *     var n = sodium.crypto_sign_ed25519_into(out, offset, message, secretKey);
+ *
+ * Writes the signature and the message, `message.length +
+ * crypto_sign_ed25519_BYTES` bytes, at `out[offset]`. `message` may already
+ * be at `out[offset + crypto_sign_ed25519_BYTES]`; it is then signed in place
+ * and not copied.
+ *
+ * **Returns**:
+ *
+ * ~ the number of bytes written
+ */
+NAPI_METHOD(crypto_sign_ed25519_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments output buffer, offset, message, and secretKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_sign_ed25519_SECRETKEYBYTES);
+    CHECK_OUTPUT_SPACE(out, offset, message_size + crypto_sign_ed25519_BYTES);
+
+    if (SODIUM_STAT(sign, message_size, message_size + crypto_sign_ed25519_BYTES,
+            crypto_sign_ed25519(out + offset, NULL, message, message_size, secretKey)) == 0) {
+        return Napi::Number::New(env, message_size + crypto_sign_ed25519_BYTES);
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_sign_ed25519_open_into:
+ * Verify a signed message and copy the message into a caller buffer
+ *
+ *     var n = sodium.crypto_sign_ed25519_open_into(out, offset, signedMessage, publicKey);
+ *
+ * **Returns**:
+ *
+ * ~ the number of bytes written at `out[offset]`
+ * ~ null: if the signature is not valid. `out` is not changed
+ */
+NAPI_METHOD(crypto_sign_ed25519_open_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments output buffer, offset, signedMessage, and publicKey must be buffers");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_NUMBER(offset);
+    ARG_TO_UCHAR_BUFFER(signedMessage);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
+
+    if( signedMessage_size < crypto_sign_ed25519_BYTES ) {
+        return NAPI_NULL;
+    }
+    unsigned long long mlen = signedMessage_size - crypto_sign_ed25519_BYTES;
+    CHECK_OUTPUT_SPACE(out, offset, mlen);
+
+    if( SODIUM_STAT(verify, signedMessage_size, mlen,
+            crypto_sign_ed25519_verify_detached(signedMessage, signedMessage + crypto_sign_ed25519_BYTES,
+                                                mlen, publicKey)) != 0 ) {
+        return NAPI_NULL;
+    }
+
+    // out may overlap the signed message
+    memmove(out + offset, signedMessage + crypto_sign_ed25519_BYTES, mlen);
+    return Napi::Number::New(env, mlen);
+}
+
 /* int crypto_sign_ed25519_detached(unsigned char *sig,
                                  unsigned long long *siglen_p,
                                  const unsigned char *m,
@@ -123,15 +279,17 @@ NAPI_METHOD(crypto_sign_ed25519_detached) {
     Napi::Env env = info.Env();
 
     ARGS(2, "arguments message, and secretKey must be buffers");
-    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_OR_STRING(message);
     ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_sign_ed25519_SECRETKEYBYTES);
+    ARG_TO_ENCODING(encoding);
 
-    NEW_BUFFER_AND_PTR(sig, crypto_sign_ed25519_BYTES);
+    NEW_OUTPUT_AND_PTR(sig, crypto_sign_ed25519_BYTES, encoding);
 
     unsigned long long slen = 0;
 
-    if (crypto_sign_ed25519_detached(sig_ptr, &slen, message, message_size, secretKey) == 0) {
-        return sig;
+    if (SODIUM_STAT(sign, message_size, crypto_sign_ed25519_BYTES,
+            crypto_sign_ed25519_detached(sig_ptr, &slen, message, message_size, secretKey)) == 0) {
+        return OUTPUT_VALUE(sig, crypto_sign_ed25519_BYTES, encoding);
     }
         
     return NAPI_NULL;
@@ -147,16 +305,256 @@ NAPI_METHOD(crypto_sign_ed25519_verify_detached) {
 
     ARGS(2, "arguments signedMessage and verificationKey must be buffers");
     ARG_TO_UCHAR_BUFFER_LEN(signature, crypto_sign_ed25519_BYTES);
-    ARG_TO_UCHAR_BUFFER(message);
+    ARG_TO_UCHAR_BUFFER_OR_STRING(message);
     ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
 
-    if (crypto_sign_ed25519_verify_detached(signature, message, message_size, publicKey) == 0) {
+    if (SODIUM_STAT(verify, message_size, 0,
+            sign_verify_cache_verify(signature, message, message_size, publicKey)) == 0) {
         return NAPI_TRUE;
     }
     
     return NAPI_FALSE;
 }
 
+// Signatures, messages and public keys of a verify batch. The messages
+// set the batch size, so they are read first, and every other argument
+// must hold as many elements, none when the messages array is empty
+#define ARG_TO_VERIFY_BATCH(COUNT, SIGNATURES, MESSAGES, PUBLIC_KEYS) \
+    size_t COUNT = SODIUM_BATCH_ANY; \
+    std::vector<SodiumSpan> MESSAGES; \
+    if( !sodium_batch_arg(env, info[1], #MESSAGES, COUNT, 0, false, MESSAGES) ) { \
+        return NAPI_NULL; \
+    } \
+    ARG_TO_BATCH_LEN(SIGNATURES, COUNT, crypto_sign_ed25519_BYTES); \
+    _arg++; \
+    ARG_TO_BATCH_LEN(PUBLIC_KEYS, COUNT, crypto_sign_ed25519_PUBLICKEYBYTES); \
+    if( SIGNATURES.size() != COUNT || MESSAGES.size() != COUNT || PUBLIC_KEYS.size() != COUNT ) { \
+        THROW_ERROR("arguments signatures, messages and public keys must have as many elements"); \
+    }
+
+/**
+ * crypto_sign_ed25519_verify_detached_batch:
+ * Verify many detached signatures in one call
+ *
+ *     var bitmap = sodium.crypto_sign_ed25519_verify_detached_batch(
+ *                      signatures, messages, publicKeys, [threads]);
+ *
+ * ~ signatures (Array|Buffer): array of `crypto_sign_ed25519_BYTES` buffers, or
+ *   one buffer with the signatures back to back
+ * ~ messages (Array): array of message buffers. Its length sets the batch size
+ * ~ publicKeys (Array|Buffer): array of `crypto_sign_ed25519_PUBLICKEYBYTES`
+ *   buffers, or one buffer with the keys back to back
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   Default 1. The call still blocks until every signature is checked
+ *
+ * Every signature is checked exactly as `crypto_sign_ed25519_verify_detached`
+ * checks it, so both always agree, even on signatures crafted with points
+ * of small order. A key is checked and decompressed once for a run of
+ * signatures made with it.
+ *
+ * **Returns**:
+ *
+ * ~ bitmap (Buffer): `ceil(messages.length / 8)` bytes. Bit `i % 8` of byte
+ *   `i / 8` is set if signature `i` is valid
+ *
+ * **Sample**:
+ *
+ *     var bitmap = sodium.crypto_sign_ed25519_verify_detached_batch(sigs, msgs, pks);
+ *     var valid = bitmap[i >> 3] & (1 << (i & 7));
+ */
+NAPI_METHOD(crypto_sign_ed25519_verify_detached_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: signatures, messages, public keys");
+
+    ARG_TO_VERIFY_BATCH(count, signatures, messages, publicKeys);
+
+    size_t threads = 1;
+    if( info.Length() > 3 && !info[3].IsUndefined() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    std::vector<unsigned char> ok(count, 0);
+    sodium_batch_parallel(count, threads, 64, [&](size_t begin, size_t end) {
+        verify_batch_range(ok.data(), signatures.data(), messages.data(), publicKeys.data(),
+                           1, begin, end);
+    });
+
+    return sodium_batch_bitmap(env, ok);
+}
+
+/**
+ * crypto_sign_ed25519_verify_detached_batch_async:
+ * Same as `crypto_sign_ed25519_verify_detached_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_sign_ed25519_verify_detached_batch_async(
+ *         signatures, messages, publicKeys, [threads], [options], [callback]);
+ *
+ * Resolves to the bitmap. The inputs are copied, so they can change once
+ * the call returns.
+ */
+NAPI_METHOD(crypto_sign_ed25519_verify_detached_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: signatures, messages, public keys");
+
+    ARG_TO_VERIFY_BATCH(count, signatures, messages, publicKeys);
+
+    size_t threads = 1;
+    if( info.Length() > 3 && info[3].IsNumber() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    NEW_BUFFER_AND_PTR(bitmap, (count + 7) / 8);
+    memset(bitmap_ptr, 0, bitmap.Length());
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_sign_ed25519_verify_detached_batch");
+    unsigned char* bits = worker->Pin(bitmap);
+    std::vector<SodiumSpan> items(3 * count);
+    for(size_t i = 0; i < count; i++) {
+        items[3 * i] = { worker->Copy(signatures[i].data, crypto_sign_ed25519_BYTES), crypto_sign_ed25519_BYTES };
+        items[3 * i + 1] = { worker->Copy(messages[i].data, messages[i].size), messages[i].size };
+        items[3 * i + 2] = { worker->Copy(publicKeys[i].data, crypto_sign_ed25519_PUBLICKEYBYTES), crypto_sign_ed25519_PUBLICKEYBYTES };
+    }
+
+    return worker->Start([=]() {
+        std::vector<unsigned char> ok(count, 0);
+        sodium_batch_parallel(count, threads, 64, [&](size_t begin, size_t end) {
+            verify_batch_range(ok.data(), &items[0], &items[1], &items[2], 3, begin, end);
+        });
+        for(size_t i = 0; i < count; i++) {
+            if( ok[i] ) {
+                bits[i >> 3] |= (unsigned char) (1 << (i & 7));
+            }
+        }
+        return 0;
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * crypto_sign_ed25519_verify_detached_batch_stream:
+ * Verify a batch on the libuv threadpool, handing results back by chunks
+ *
+ *     sodium.crypto_sign_ed25519_verify_detached_batch_stream(
+ *         signatures, messages, publicKeys, options, [callback]);
+ *
+ * `options.onChunk(start, valid)` is called for every `options.chunkSize`
+ * signatures, 1024 by default, in order, with `valid` an Array of booleans
+ * for signatures `start` on. `options.threads` splits each chunk. Resolves
+ * to the number of invalid signatures once every chunk has been delivered.
+ * See src/include/sodium_batch_stream.h
+ */
+NAPI_METHOD(crypto_sign_ed25519_verify_detached_batch_stream) {
+    Napi::Env env = info.Env();
+
+    ARGS(4, "arguments must be: signatures, messages, public keys, options");
+
+    ARG_TO_VERIFY_BATCH(count, signatures, messages, publicKeys);
+    ARG_TO_STREAM_OPTIONS(options);
+
+    SodiumStreamWorker* worker = new SodiumStreamWorker(info, "crypto_sign_ed25519_verify_detached_batch_stream",
+                                                        count, STREAM_RESULT_BOOLEANS, options);
+    std::vector<SodiumSpan> items(3 * count);
+    for(size_t i = 0; i < count; i++) {
+        items[3 * i] = { worker->Copy(signatures[i].data, crypto_sign_ed25519_BYTES), crypto_sign_ed25519_BYTES };
+        items[3 * i + 1] = { worker->Copy(messages[i].data, messages[i].size), messages[i].size };
+        items[3 * i + 2] = { worker->Copy(publicKeys[i].data, crypto_sign_ed25519_PUBLICKEYBYTES), crypto_sign_ed25519_PUBLICKEYBYTES };
+    }
+
+    size_t threads = worker->threads;
+    return worker->Stream([=](size_t begin, size_t end, unsigned char* out, unsigned char* ok) {
+        const SodiumSpan* chunk = &items[3 * begin];
+        sodium_batch_parallel(end - begin, threads, 64, [&](size_t b, size_t e) {
+            verify_batch_range(ok, &chunk[0], &chunk[1], &chunk[2], 3, b, e);
+        });
+    });
+}
+
+#undef ARG_TO_VERIFY_BATCH
+
+/*
+ * int crypto_sign_ed25519ph_init(crypto_sign_ed25519ph_state *state);
+ *
+ * Multipart signatures use Ed25519ph: the message is hashed with SHA-512 as
+ * it comes in and the hash is signed. They do not verify with
+ * crypto_sign_ed25519_verify_detached, nor the other way around.
+ */
+NAPI_METHOD(crypto_sign_ed25519ph_init) {
+    Napi::Env env = info.Env();
+
+    NEW_BUFFER_AND_PTR(state, crypto_sign_ed25519ph_statebytes());
+
+    if( crypto_sign_ed25519ph_init((crypto_sign_ed25519ph_state*) state_ptr) == 0 ) {
+        return state;
+    }
+
+    return NAPI_NULL;
+}
+
+/* int crypto_sign_ed25519ph_update(crypto_sign_ed25519ph_state *state,
+                                    const unsigned char *m,
+                                    unsigned long long mlen);
+
+    Buffer state
+    Buffer message
+ */
+NAPI_METHOD(crypto_sign_ed25519ph_update) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be two buffers: sign state, message part");
+    ARG_TO_UCHAR_BUFFER_LEN(state, crypto_sign_ed25519ph_statebytes());
+    ARG_TO_UCHAR_BUFFER(message);
+
+    if( crypto_sign_ed25519ph_update((crypto_sign_ed25519ph_state*) state, message, message_size) == 0 ) {
+        return NAPI_TRUE;
+    }
+    return NAPI_FALSE;
+}
+
+/* int crypto_sign_ed25519ph_final_create(crypto_sign_ed25519ph_state *state,
+                                          unsigned char *sig,
+                                          unsigned long long *siglen_p,
+                                          const unsigned char *sk);
+ */
+NAPI_METHOD(crypto_sign_ed25519ph_final_create) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be two buffers: sign state, secret key");
+    ARG_TO_UCHAR_BUFFER_LEN(state, crypto_sign_ed25519ph_statebytes());
+    ARG_TO_UCHAR_BUFFER_LEN(secretKey, crypto_sign_ed25519_SECRETKEYBYTES);
+
+    NEW_BUFFER_AND_PTR(sig, crypto_sign_ed25519_BYTES);
+
+    if( crypto_sign_ed25519ph_final_create((crypto_sign_ed25519ph_state*) state, sig_ptr, NULL, secretKey) == 0 ) {
+        return sig;
+    }
+
+    return NAPI_NULL;
+}
+
+/* int crypto_sign_ed25519ph_final_verify(crypto_sign_ed25519ph_state *state,
+                                          unsigned char *sig,
+                                          const unsigned char *pk);
+ */
+NAPI_METHOD(crypto_sign_ed25519ph_final_verify) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be three buffers: sign state, signature, public key");
+    ARG_TO_UCHAR_BUFFER_LEN(state, crypto_sign_ed25519ph_statebytes());
+    ARG_TO_UCHAR_BUFFER_LEN(signature, crypto_sign_ed25519_BYTES);
+    ARG_TO_UCHAR_BUFFER_LEN(publicKey, crypto_sign_ed25519_PUBLICKEYBYTES);
+
+    if( crypto_sign_ed25519ph_final_verify((crypto_sign_ed25519ph_state*) state, signature, publicKey) == 0 ) {
+        return NAPI_TRUE;
+    }
+
+    return NAPI_FALSE;
+}
+
+NAPI_METHOD_FROM_INT(crypto_sign_ed25519ph_statebytes)
+
 /* int crypto_sign_ed25519_keypair(unsigned char *pk, unsigned char *sk);
  */
 NAPI_METHOD(crypto_sign_ed25519_keypair) {
@@ -165,7 +563,7 @@ NAPI_METHOD(crypto_sign_ed25519_keypair) {
     NEW_BUFFER_AND_PTR(vk, crypto_sign_ed25519_PUBLICKEYBYTES);
     NEW_BUFFER_AND_PTR(sk, crypto_sign_ed25519_SECRETKEYBYTES);
 
-    if (crypto_sign_ed25519_keypair(vk_ptr, sk_ptr) == 0) {
+    if (keypair_pool_take(KEYPAIR_POOL_ED25519, vk_ptr, sk_ptr) == 0) {
         Napi::Object result = Napi::Object::New(env);
         result.Set(Napi::String::New(env, "publicKey"), vk);
         result.Set(Napi::String::New(env, "secretKey"), sk);
@@ -176,6 +574,99 @@ NAPI_METHOD(crypto_sign_ed25519_keypair) {
     return NAPI_NULL;
 }
 
+/**
+ * crypto_sign_ed25519_keypair_packed:
+ * Same as crypto_sign_ed25519_keypair, in one buffer
+ *
+ * Returns publicKey || secretKey, `crypto_sign_ed25519_PUBLICKEYBYTES +
+ * crypto_sign_ed25519_SECRETKEYBYTES` bytes
+ */
+NAPI_METHOD(crypto_sign_ed25519_keypair_packed) {
+    Napi::Env env = info.Env();
+
+    NEW_BUFFER_AND_PTR(kp, crypto_sign_ed25519_PUBLICKEYBYTES + crypto_sign_ed25519_SECRETKEYBYTES);
+
+    if (keypair_pool_take(KEYPAIR_POOL_ED25519, kp_ptr, kp_ptr + crypto_sign_ed25519_PUBLICKEYBYTES) == 0) {
+        return kp;
+    }
+
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_sign_ed25519_keypair_batch:
+ * Make many key pairs in one call
+ *
+ *     var kps = sodium.crypto_sign_ed25519_keypair_batch(count, [threads]);
+ *     var kps = sodium.crypto_sign_ed25519_keypair_batch(seeds, [threads]);
+ *
+ * ~ count (Number): random key pairs to make
+ * ~ seeds (Buffer): `crypto_sign_ed25519_SEEDBYTES` seeds back to back, one
+ *   key pair each, as `crypto_sign_ed25519_seed_keypair` makes it
+ * ~ threads (Number): optional, split the batch across this many threads.
+ *   The call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ keyPairs (Buffer): publicKey || secretKey of every pair back to back,
+ *   `crypto_sign_ed25519_PUBLICKEYBYTES + crypto_sign_ed25519_SECRETKEYBYTES`
+ *   bytes each
+ */
+NAPI_METHOD(crypto_sign_ed25519_keypair_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument count or seeds is required");
+    ARG_TO_KEYPAIR_BATCH(count, seeds, crypto_sign_ed25519_SEEDBYTES);
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    NEW_BUFFER_AND_PTR(kps, count * (crypto_sign_ed25519_PUBLICKEYBYTES + crypto_sign_ed25519_SECRETKEYBYTES));
+
+    if( sodium_batch_keypairs(kps_ptr, count, crypto_sign_ed25519_PUBLICKEYBYTES,
+                              crypto_sign_ed25519_SECRETKEYBYTES, seeds, crypto_sign_ed25519_SEEDBYTES,
+                              crypto_sign_ed25519_keypair, crypto_sign_ed25519_seed_keypair,
+                              threads) == 0 ) {
+        return kps;
+    }
+    return NAPI_NULL;
+}
+
+/**
+ * crypto_sign_ed25519_keypair_batch_async:
+ * Same as `crypto_sign_ed25519_keypair_batch` on the libuv threadpool
+ *
+ *     sodium.crypto_sign_ed25519_keypair_batch_async(countOrSeeds, [threads], [callback]);
+ *
+ * Seeds are copied, and the copy wiped once the job is done.
+ */
+NAPI_METHOD(crypto_sign_ed25519_keypair_batch_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument count or seeds is required");
+    ARG_TO_KEYPAIR_BATCH(count, seeds, crypto_sign_ed25519_SEEDBYTES);
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) {
+        ARG_TO_NUMBER(nthreads);
+        threads = nthreads;
+    }
+
+    NEW_BUFFER_AND_PTR(kps, count * (crypto_sign_ed25519_PUBLICKEYBYTES + crypto_sign_ed25519_SECRETKEYBYTES));
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_sign_ed25519_keypair_batch");
+    unsigned char* out = worker->Pin(kps);
+    const unsigned char* sd = seeds != NULL ? worker->Copy(seeds, count * crypto_sign_ed25519_SEEDBYTES) : NULL;
+
+    return worker->Start([=]() {
+        return sodium_batch_keypairs(out, count, crypto_sign_ed25519_PUBLICKEYBYTES,
+                                     crypto_sign_ed25519_SECRETKEYBYTES, sd, crypto_sign_ed25519_SEEDBYTES,
+                                     crypto_sign_ed25519_keypair, crypto_sign_ed25519_seed_keypair,
+                                     threads);
+    }, ASYNC_RESULT_BUFFER);
+}
+
 /* crypto_sign_ed25519_seed_keypair(unsigned char *pk, unsigned char *sk,
                                      const unsigned char *seed);
 */
@@ -244,14 +735,28 @@ void register_crypto_sign_ed25519(Napi::Env env, Napi::Object exports) {
     
     EXPORT(crypto_sign_ed25519);
     EXPORT(crypto_sign_ed25519_open);
+    EXPORT(crypto_sign_ed25519_open_view);
+    EXPORT(crypto_sign_ed25519_into);
+    EXPORT(crypto_sign_ed25519_open_into);
     EXPORT(crypto_sign_ed25519_detached);
     EXPORT(crypto_sign_ed25519_verify_detached);
+    EXPORT(crypto_sign_ed25519_verify_detached_batch);
+    EXPORT(crypto_sign_ed25519_verify_detached_batch_async);
+    EXPORT(crypto_sign_ed25519_verify_detached_batch_stream);
     EXPORT(crypto_sign_ed25519_keypair);
+    EXPORT(crypto_sign_ed25519_keypair_packed);
+    EXPORT(crypto_sign_ed25519_keypair_batch);
+    EXPORT(crypto_sign_ed25519_keypair_batch_async);
     EXPORT(crypto_sign_ed25519_seed_keypair);
     EXPORT(crypto_sign_ed25519_pk_to_curve25519);
     EXPORT(crypto_sign_ed25519_sk_to_curve25519);
     EXPORT(crypto_sign_ed25519_sk_to_seed);
     EXPORT(crypto_sign_ed25519_sk_to_pk);
+    EXPORT(crypto_sign_ed25519ph_init);
+    EXPORT(crypto_sign_ed25519ph_update);
+    EXPORT(crypto_sign_ed25519ph_final_create);
+    EXPORT(crypto_sign_ed25519ph_final_verify);
+    EXPORT(crypto_sign_ed25519ph_statebytes);
     
     EXPORT_INT(crypto_sign_ed25519_PUBLICKEYBYTES);
     EXPORT_INT(crypto_sign_ed25519_SECRETKEYBYTES);
@@ -0,0 +1,238 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "node_sodium.h"
+#include "crypto_sign_verify_cache.h"
+#include "sodium_memory.h"
+
+/**
+ * Ed25519 verification cache
+ *
+ * When enabled, crypto_sign_verify_detached and
+ * crypto_sign_ed25519_verify_detached remember the triples they accepted.
+ * Gossip protocols see the same signed message from many peers; every copy
+ * after the first is then answered with one BLAKE2b pass over the message
+ * instead of a full verification.
+ *
+ * Entries are only the keyed BLAKE2b digest of signature, public key and
+ * message, with a random key drawn when the cache is enabled, so nobody can
+ * choose a triple that collides with an accepted one. Failed verifications
+ * are not cached: a forged signature costs a full check every time.
+ *
+ * The least recently used entry is evicted when the cache is full, and
+ * entries older than the time to live are dropped on lookup.
+ */
+
+typedef std::chrono::steady_clock VerifyCacheClock;
+
+struct VerifyCacheEntry {
+    std::string id;
+    VerifyCacheClock::time_point expires;
+};
+
+static std::mutex verify_cache_mutex;
+static std::list<VerifyCacheEntry> verify_cache_lru;   // most recent first
+static std::unordered_map<std::string, std::list<VerifyCacheEntry>::iterator> verify_cache_index;
+static size_t verify_cache_capacity = 0;
+static VerifyCacheClock::duration verify_cache_ttl;
+static unsigned char verify_cache_id_key[crypto_generichash_KEYBYTES];
+
+static double verify_cache_hits = 0;
+static double verify_cache_misses = 0;
+static double verify_cache_rejects = 0;
+static double verify_cache_evictions = 0;
+static double verify_cache_expirations = 0;
+
+static std::string verify_cache_id(const unsigned char* sig, const unsigned char* m,
+                                   unsigned long long mlen, const unsigned char* pk) {
+    crypto_generichash_state state;
+    unsigned char id[crypto_generichash_BYTES];
+
+    // Signature and key have fixed sizes, so the message can go last unframed
+    crypto_generichash_init(&state, verify_cache_id_key, sizeof verify_cache_id_key, sizeof id);
+    crypto_generichash_update(&state, sig, crypto_sign_ed25519_BYTES);
+    crypto_generichash_update(&state, pk, crypto_sign_ed25519_PUBLICKEYBYTES);
+    crypto_generichash_update(&state, m, mlen);
+    crypto_generichash_final(&state, id, sizeof id);
+
+    return std::string((const char*) id, sizeof id);
+}
+
+// Caller holds verify_cache_mutex
+static void verify_cache_erase(std::list<VerifyCacheEntry>::iterator it) {
+    verify_cache_index.erase(it->id);
+    verify_cache_lru.erase(it);
+}
+
+int sign_verify_cache_verify(const unsigned char* sig, const unsigned char* m,
+                             unsigned long long mlen, const unsigned char* pk) {
+    std::unique_lock<std::mutex> lock(verify_cache_mutex);
+
+    if( verify_cache_capacity == 0 ) {
+        lock.unlock();
+        return crypto_sign_ed25519_verify_detached(sig, m, mlen, pk);
+    }
+
+    std::string id = verify_cache_id(sig, m, mlen, pk);
+    VerifyCacheClock::time_point now = VerifyCacheClock::now();
+
+    auto found = verify_cache_index.find(id);
+    if( found != verify_cache_index.end() ) {
+        auto it = found->second;
+        if( verify_cache_ttl.count() == 0 || now < it->expires ) {
+            verify_cache_lru.splice(verify_cache_lru.begin(), verify_cache_lru, it);
+            verify_cache_hits++;
+            return 0;
+        }
+        verify_cache_erase(it);
+        verify_cache_expirations++;
+    }
+    verify_cache_misses++;
+
+    // Verify without holding the lock
+    lock.unlock();
+    int rc = crypto_sign_ed25519_verify_detached(sig, m, mlen, pk);
+    lock.lock();
+
+    if( rc != 0 ) {
+        verify_cache_rejects++;
+        return rc;
+    }
+
+    // The cache may have been disabled, or filled by another thread, meanwhile
+    if( verify_cache_capacity == 0 || verify_cache_index.count(id) != 0 ) {
+        return 0;
+    }
+
+    if( verify_cache_lru.size() >= verify_cache_capacity ) {
+        verify_cache_erase(std::prev(verify_cache_lru.end()));
+        verify_cache_evictions++;
+    }
+    verify_cache_lru.push_front(VerifyCacheEntry{ id, now + verify_cache_ttl });
+    verify_cache_index[id] = verify_cache_lru.begin();
+    return 0;
+}
+
+/**
+ * crypto_sign_verify_cache_enable:
+ * Turn the verification cache on, or resize it
+ *
+ *     sodium.crypto_sign_verify_cache_enable(capacity, [ttl]);
+ *
+ * ~ capacity (Number): maximum number of accepted signatures to remember.
+ *   0 disables the cache
+ * ~ ttl (Number): optional, verify again this many milliseconds after a
+ *   signature was accepted. 0, the default, keeps entries until evicted
+ *
+ * Enabling an enabled cache clears it. Counters are reset.
+ */
+NAPI_METHOD(crypto_sign_verify_cache_enable) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument capacity must be a number");
+    ARG_TO_NUMBER(capacity);
+    size_t ttl = 0;
+    if( info.Length() > 1 && !info[1].IsUndefined() ) {
+        ARG_TO_NUMBER(ttl_ms);
+        ttl = ttl_ms;
+    }
+
+    std::lock_guard<std::mutex> lock(verify_cache_mutex);
+    verify_cache_lru.clear();
+    verify_cache_index.clear();
+    verify_cache_hits = verify_cache_misses = verify_cache_rejects = 0;
+    verify_cache_evictions = verify_cache_expirations = 0;
+
+    verify_cache_capacity = capacity;
+    verify_cache_ttl = std::chrono::milliseconds(ttl);
+    if( capacity != 0 ) {
+        randombytes_buf(verify_cache_id_key, sizeof verify_cache_id_key);
+        verify_cache_index.reserve(capacity);
+    }
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_sign_verify_cache_disable:
+ * Turn the verification cache off and forget every entry
+ */
+NAPI_METHOD(crypto_sign_verify_cache_disable) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(verify_cache_mutex);
+    verify_cache_lru.clear();
+    verify_cache_index.clear();
+    verify_cache_capacity = 0;
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_sign_verify_cache_clear:
+ * Forget every entry, keeping the cache enabled
+ */
+NAPI_METHOD(crypto_sign_verify_cache_clear) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(verify_cache_mutex);
+    verify_cache_lru.clear();
+    verify_cache_index.clear();
+
+    return env.Undefined();
+}
+
+/**
+ * crypto_sign_verify_cache_stats:
+ * Cache counters
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ enabled, capacity, size, hits, misses, hitRate, rejects,
+ *   evictions, expirations }`. `hitRate` is hits over lookups, 0 before the
+ *   first one
+ */
+NAPI_METHOD(crypto_sign_verify_cache_stats) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> lock(verify_cache_mutex);
+    double lookups = verify_cache_hits + verify_cache_misses;
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "enabled"), Napi::Boolean::New(env, verify_cache_capacity != 0));
+    result.Set(Napi::String::New(env, "capacity"), Napi::Number::New(env, (double) verify_cache_capacity));
+    result.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double) verify_cache_lru.size()));
+    result.Set(Napi::String::New(env, "hits"), Napi::Number::New(env, verify_cache_hits));
+    result.Set(Napi::String::New(env, "misses"), Napi::Number::New(env, verify_cache_misses));
+    result.Set(Napi::String::New(env, "hitRate"), Napi::Number::New(env, lookups > 0 ? verify_cache_hits / lookups : 0));
+    result.Set(Napi::String::New(env, "rejects"), Napi::Number::New(env, verify_cache_rejects));
+    result.Set(Napi::String::New(env, "evictions"), Napi::Number::New(env, verify_cache_evictions));
+    result.Set(Napi::String::New(env, "expirations"), Napi::Number::New(env, verify_cache_expirations));
+    return result;
+}
+
+// See sodium_memory_usage
+size_t crypto_sign_verify_cache_memory() {
+    std::lock_guard<std::mutex> lock(verify_cache_mutex);
+    return sodium_lru_memory(verify_cache_lru, verify_cache_index, crypto_generichash_BYTES);
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_sign_verify_cache(Napi::Env env, Napi::Object exports) {
+    EXPORT(crypto_sign_verify_cache_enable);
+    EXPORT(crypto_sign_verify_cache_disable);
+    EXPORT(crypto_sign_verify_cache_clear);
+    EXPORT(crypto_sign_verify_cache_stats);
+}
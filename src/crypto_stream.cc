@@ -21,6 +21,7 @@ void register_crypto_stream(Napi::Env env, Napi::Object exports) {
     // Stream
     EXPORT_ALIAS(crypto_stream, crypto_stream_xsalsa20);
     EXPORT_ALIAS(crypto_stream_xor, crypto_stream_xsalsa20_xor);
+    EXPORT_ALIAS(crypto_stream_xor_inplace, crypto_stream_xsalsa20_xor_inplace);
 
     EXPORT(crypto_stream_keybytes);
     EXPORT(crypto_stream_noncebytes);
@@ -0,0 +1,336 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+#include <limits>
+
+#include "node_sodium.h"
+#include "sodium_memory.h"
+
+// Key stream buffered by default, in bytes
+#define KEYSTREAM_DEFAULT_SIZE (64 * 1024)
+
+// Largest key stream buffer
+#define KEYSTREAM_MAX_SIZE (64 * 1024 * 1024)
+
+#define KEYSTREAM_BLOCKBYTES 64
+
+// Blocks of a chacha20_ietf key stream, the counter is 32 bits
+#define KEYSTREAM_MAX_BLOCKS ((uint64_t) std::numeric_limits<uint32_t>::max() + 1)
+
+/**
+ * XOR `len` bytes of `in` with `ks` into `out`, a word at a time. The loop
+ * has no dependencies between words, so the compiler vectorizes it
+ */
+static inline void keystream_xor(unsigned char* out, const unsigned char* in,
+                                 const unsigned char* ks, size_t len) {
+    size_t i = 0;
+    for( ; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t) ) {
+        uint64_t a, b;
+        memcpy(&a, in + i, sizeof a);
+        memcpy(&b, ks + i, sizeof b);
+        a ^= b;
+        memcpy(out + i, &a, sizeof a);
+    }
+    for( ; i < len; i++ ) {
+        out[i] = in[i] ^ ks[i];
+    }
+}
+
+/**
+ * KeystreamBuffer:
+ * `crypto_stream_chacha20_ietf_xor_ic` with the key stream computed ahead
+ *
+ * Small packets pay the ChaCha20 setup for every call, and only use the
+ * wide SIMD code paths of libsodium when they span several blocks. A
+ * KeystreamBuffer computes `size` bytes of key stream at once, with the
+ * fastest implementation libsodium picked for this CPU (AVX2 when
+ * available), into memory allocated with `sodium_malloc`: locked, so it is
+ * never swapped out, and surrounded with guard pages. Encrypting a packet is
+ * then an XOR against the next bytes of the buffer, which are wiped as they
+ * are used.
+ *
+ *    var ks = new sodium.KeystreamBuffer(key, nonce, [options]);
+ *
+ * ~ key (Buffer): `crypto_stream_chacha20_ietf_KEYBYTES` key
+ * ~ nonce (Buffer): `crypto_stream_chacha20_ietf_NONCEBYTES` nonce
+ * ~ options (Object): optional
+ *   - `size` (Number): bytes of key stream to buffer, rounded up to whole 64
+ *     byte blocks. Default 64KB
+ *   - `counter` (Number): block counter to start at, as the `ic` argument of
+ *     `crypto_stream_chacha20_ietf_xor_ic`. Default 0
+ *
+ * Methods:
+ *
+ * ~ xor(message): returns `message` XORed with the next `message.length`
+ *   bytes of the key stream. The buffer is refilled when it runs out, which
+ *   is the only call that computes key stream
+ * ~ xorInplace(message, [offset, length]): same, in place
+ * ~ prefetch(): move the unused key stream to the front and fill the rest
+ *   of the buffer now, for instance while the event loop is idle, so the
+ *   next packets find it ready. Returns `available()`
+ * ~ position(): offset in the key stream of the next byte
+ * ~ available(): bytes of key stream ready in the buffer
+ * ~ dispose(): wipes and frees the buffer. Later calls throw
+ *
+ * The output is the same as `crypto_stream_chacha20_ietf_xor_ic` over all
+ * the packets one after the other. Both ends must go through the same
+ * packets in the same order, so use it with an ordered transport, or start
+ * each message at a `counter` of its own. Throws once the 256GB key stream
+ * of a nonce is used up.
+ *
+ * **Sample**:
+ *
+ *     var tx = new sodium.KeystreamBuffer(key, nonce, { size: 16384 });
+ *     socket.send(tx.xor(packet));
+ *     setImmediate(function() { tx.prefetch(); });
+ */
+class KeystreamBuffer : public Napi::ObjectWrap<KeystreamBuffer> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "KeystreamBuffer", {
+            InstanceMethod("xor", &KeystreamBuffer::Xor),
+            InstanceMethod("xorInplace", &KeystreamBuffer::XorInplace),
+            InstanceMethod("prefetch", &KeystreamBuffer::Prefetch),
+            InstanceMethod("position", &KeystreamBuffer::Position),
+            InstanceMethod("available", &KeystreamBuffer::Available),
+            InstanceMethod("dispose", &KeystreamBuffer::Dispose)
+        });
+        exports.Set(Napi::String::New(env, "KeystreamBuffer"), ctor);
+    }
+
+    KeystreamBuffer(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<KeystreamBuffer>(info), secure(NULL), size(0), start(0), end(0), block(0) {
+        Napi::Env env = info.Env();
+
+        unsigned char *key = NULL, *nonce = NULL;
+        size_t key_size = 0, nonce_size = 0;
+        if( info.Length() < 2 || !sodium_arg_bytes(info[0], key, key_size) ||
+            !sodium_arg_bytes(info[1], nonce, nonce_size) ) {
+            Napi::TypeError::New(env, "arguments key and nonce must be buffers").ThrowAsJavaScriptException();
+            return;
+        }
+        if( key_size != crypto_stream_chacha20_ietf_KEYBYTES ) {
+            Napi::Error::New(env, "argument key must be crypto_stream_chacha20_ietf_KEYBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+        if( nonce_size != crypto_stream_chacha20_ietf_NONCEBYTES ) {
+            Napi::Error::New(env, "argument nonce must be crypto_stream_chacha20_ietf_NONCEBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+
+        uint64_t requested = KEYSTREAM_DEFAULT_SIZE;
+        if( info.Length() > 2 && !info[2].IsUndefined() ) {
+            if( !info[2].IsObject() ) {
+                Napi::TypeError::New(env, "argument options must be an object").ThrowAsJavaScriptException();
+                return;
+            }
+            Napi::Object options = info[2].As<Napi::Object>();
+            Napi::Value value = options.Get("size");
+            if( !value.IsUndefined() ) {
+                if( !SODIUM_ARG_IS_INTEGER(value) ) {
+                    Napi::TypeError::New(env, "options.size must be a number").ThrowAsJavaScriptException();
+                    return;
+                }
+                if( !sodium_arg_uint64(value, "size", KEYSTREAM_MAX_SIZE, requested) ) {
+                    return;
+                }
+            }
+            value = options.Get("counter");
+            if( !value.IsUndefined() ) {
+                if( !SODIUM_ARG_IS_INTEGER(value) ) {
+                    Napi::TypeError::New(env, "options.counter must be a number").ThrowAsJavaScriptException();
+                    return;
+                }
+                if( !sodium_arg_uint64(value, "counter", KEYSTREAM_MAX_BLOCKS - 1, block) ) {
+                    return;
+                }
+            }
+        }
+        if( requested == 0 ) {
+            Napi::RangeError::New(env, "size must be at least 1 byte").ThrowAsJavaScriptException();
+            return;
+        }
+        size = (size_t) ((requested + KEYSTREAM_BLOCKBYTES - 1) / KEYSTREAM_BLOCKBYTES * KEYSTREAM_BLOCKBYTES);
+
+        // Key and nonce first, then the key stream
+        secure = (unsigned char*) sodium_malloc(Footprint());
+        if( secure == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the key stream").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_memory_hold(env, sodium_secure_footprint(Footprint()));
+        memcpy(Key(), key, crypto_stream_chacha20_ietf_KEYBYTES);
+        memcpy(Nonce(), nonce, crypto_stream_chacha20_ietf_NONCEBYTES);
+    }
+
+    ~KeystreamBuffer() {
+        Free();
+    }
+
+private:
+    size_t Footprint() const {
+        return crypto_stream_chacha20_ietf_KEYBYTES + crypto_stream_chacha20_ietf_NONCEBYTES + size;
+    }
+
+    unsigned char* Key() const {
+        return secure;
+    }
+
+    unsigned char* Nonce() const {
+        return secure + crypto_stream_chacha20_ietf_KEYBYTES;
+    }
+
+    unsigned char* Stream() const {
+        return Nonce() + crypto_stream_chacha20_ietf_NONCEBYTES;
+    }
+
+    void Free() {
+        if( secure != NULL ) {
+            sodium_free(secure);
+            secure = NULL;
+            sodium_memory_hold(Env(), -(int64_t) sodium_secure_footprint(Footprint()));
+        }
+    }
+
+    /**
+     * Move the unused key stream to the front and compute whole blocks after
+     * it, as many as fit. The unused part always ends on a block boundary,
+     * so `block` is the counter of the first new block. False once the key
+     * stream of the nonce is used up
+     */
+    bool Fill() {
+        size_t left = end - start;
+        if( left > 0 && start > 0 ) {
+            memmove(Stream(), Stream() + start, left);
+        }
+        start = 0;
+        end = left;
+
+        uint64_t blocks = (size - left) / KEYSTREAM_BLOCKBYTES;
+        if( blocks > KEYSTREAM_MAX_BLOCKS - block ) {
+            blocks = KEYSTREAM_MAX_BLOCKS - block;
+        }
+        if( blocks == 0 ) {
+            return left > 0;
+        }
+
+        size_t bytes = (size_t) blocks * KEYSTREAM_BLOCKBYTES;
+        memset(Stream() + end, 0, bytes);
+        crypto_stream_chacha20_ietf_xor_ic(Stream() + end, Stream() + end, bytes,
+                                           Nonce(), (uint32_t) block, Key());
+        end += bytes;
+        block += blocks;
+        return true;
+    }
+
+    // XOR `len` bytes, refilling as needed. False if the key stream ran out
+    bool Apply(unsigned char* out, const unsigned char* in, size_t len) {
+        while( len > 0 ) {
+            if( start == end && !Fill() ) {
+                return false;
+            }
+            size_t n = end - start < len ? end - start : len;
+            keystream_xor(out, in, Stream() + start, n);
+            sodium_memzero(Stream() + start, n);
+            start += n;
+            out += n;
+            in += n;
+            len -= n;
+        }
+        return true;
+    }
+
+    // Bytes of key stream left for this nonce, buffered or not
+    uint64_t Remaining() const {
+        return (KEYSTREAM_MAX_BLOCKS - block) * KEYSTREAM_BLOCKBYTES + (end - start);
+    }
+
+#define CHECK_CONTEXT() \
+    if( secure == NULL ) { \
+        THROW_ERROR("KeystreamBuffer was disposed"); \
+    }
+
+#define CHECK_REMAINING(LEN) \
+    if( (uint64_t) (LEN) > Remaining() ) { \
+        THROW_ERROR("message runs past the end of the crypto_stream_chacha20_ietf key stream"); \
+    }
+
+    Napi::Value Xor(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER(message);
+        CHECK_REMAINING(message_size);
+
+        NEW_BUFFER_AND_PTR(c, message_size);
+        Apply(c_ptr, message, message_size);
+        return c;
+    }
+
+    Napi::Value XorInplace(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument message must be a buffer");
+        ARG_TO_UCHAR_BUFFER_RANGE(message);
+        CHECK_REMAINING(message_size);
+
+        Apply(message, message, message_size);
+        return message_buffer;
+    }
+
+    Napi::Value Prefetch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        Fill();
+        return Napi::Number::New(env, (double) (end - start));
+    }
+
+    Napi::Value Position(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, (double) (block * KEYSTREAM_BLOCKBYTES - (end - start)));
+    }
+
+    Napi::Value Available(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        return Napi::Number::New(env, (double) (end - start));
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_REMAINING
+#undef CHECK_CONTEXT
+
+    // Key, nonce and key stream, in one sodium_malloc block
+    unsigned char* secure;
+    size_t size;
+
+    // Unused key stream is secure[start, end) of the stream part
+    size_t start;
+    size_t end;
+
+    // Counter of the block after the buffered key stream
+    uint64_t block;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_crypto_stream_keystream(Napi::Env env, Napi::Object exports) {
+    KeystreamBuffer::Init(env, exports);
+}
@@ -8,15 +8,18 @@
 #include "node_sodium.h"
 #include "crypto_streams.h"
 
-// Generate the binding methods for each algorithm
+// Generate the binding methods for each algorithm.
+// The _xor_inplace and _xor_ic_inplace variants take the same arguments as
+// _xor and _xor_ic, overwrite the message with the result and return it. The
+// message may be given as (buffer, offset, length) to work on a range of it.
 CRYPTO_STREAM_DEF(salsa20)
-CRYPTO_STREAM_DEF_IC(salsa20)
+CRYPTO_STREAM_DEF_IC(salsa20, uint64_t)
 CRYPTO_STREAM_DEF(xsalsa20)
-CRYPTO_STREAM_DEF_IC(xsalsa20)
+CRYPTO_STREAM_DEF_IC(xsalsa20, uint64_t)
 CRYPTO_STREAM_DEF(salsa208)
 CRYPTO_STREAM_DEF(salsa2012)
 CRYPTO_STREAM_DEF(chacha20)
-CRYPTO_STREAM_DEF_IC(chacha20)
+CRYPTO_STREAM_DEF_IC(chacha20, uint64_t)
 
 // chacha_ietf uses the same key length as crypto_stream_chacha20_KEYBYTES
 // Libsodium does not define it, lets define it here so we don't get compilation errors
@@ -24,7 +27,48 @@ CRYPTO_STREAM_DEF_IC(chacha20)
 // #define crypto_stream_chacha20_ietf_KEYBYTES   crypto_stream_chacha20_KEYBYTES
 //#define crypto_stream_chacha20_ietf_NONCEBYTES crypto_stream_chacha20_IETF_NONCEBYTES
 CRYPTO_STREAM_DEF(chacha20_ietf)
-CRYPTO_STREAM_DEF_IC(chacha20_ietf)
+CRYPTO_STREAM_DEF_IC(chacha20_ietf, uint32_t)
+CRYPTO_STREAM_DEF(xchacha20)
+CRYPTO_STREAM_DEF_IC(xchacha20, uint64_t)
+
+/**
+ * crypto_stream_chacha20_xor_parallel:
+ * XOR a message with the key stream starting at any byte position
+ *
+ *     var c = sodium.crypto_stream_chacha20_xor_parallel(
+ *                message,
+ *                nonce,
+ *                position,
+ *                key,
+ *                [threads]);
+ *
+ * ~ message (Buffer): message to encrypt or decrypt. Can be given as
+ *   (buffer, offset, length)
+ * ~ nonce (Buffer): `crypto_stream_chacha20_NONCEBYTES` nonce
+ * ~ position (Number): offset in the key stream of the first message byte,
+ *   0 for the start of the stream
+ * ~ key (Buffer): `crypto_stream_chacha20_KEYBYTES` key
+ * ~ threads (Number): optional, split the message across this many threads in
+ *   slices of whole 64 byte blocks. The call still blocks
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: same as `crypto_stream_chacha20_xor` over the whole stream,
+ *   sliced at `position`
+ *
+ * Decrypt bytes 1000000 to 1000999 of a blob encrypted with
+ * `crypto_stream_chacha20_xor` without touching the prefix:
+ *
+ *     var part = sodium.crypto_stream_chacha20_xor_parallel(
+ *                    blob, 1000000, 1000, nonce, 1000000, key);
+ *
+ * Also defined for `chacha20_ietf`, `xchacha20`, `salsa20` and `xsalsa20`.
+ */
+CRYPTO_STREAM_DEF_SEEK(chacha20, uint64_t)
+CRYPTO_STREAM_DEF_SEEK(chacha20_ietf, uint32_t)
+CRYPTO_STREAM_DEF_SEEK(xchacha20, uint64_t)
+CRYPTO_STREAM_DEF_SEEK(salsa20, uint64_t)
+CRYPTO_STREAM_DEF_SEEK(xsalsa20, uint64_t)
 
 
 /**
@@ -34,10 +78,14 @@ void register_crypto_streams(Napi::Env env, Napi::Object exports) {
     
     METHODS(xsalsa20);
     EXPORT(crypto_stream_xsalsa20_xor_ic);
+    EXPORT(crypto_stream_xsalsa20_xor_ic_inplace);
+    EXPORT(crypto_stream_xsalsa20_xor_parallel);
     PROPS(xsalsa20);
     
     METHODS(salsa20);
     EXPORT(crypto_stream_salsa20_xor_ic);
+    EXPORT(crypto_stream_salsa20_xor_ic_inplace);
+    EXPORT(crypto_stream_salsa20_xor_parallel);
     PROPS(salsa20);
     
     METHODS(salsa208);
@@ -48,9 +96,19 @@ void register_crypto_streams(Napi::Env env, Napi::Object exports) {
     
     METHODS(chacha20);
     EXPORT(crypto_stream_chacha20_xor_ic);
+    EXPORT(crypto_stream_chacha20_xor_ic_inplace);
+    EXPORT(crypto_stream_chacha20_xor_parallel);
     PROPS(chacha20);
     
     METHODS(chacha20_ietf);
     EXPORT(crypto_stream_chacha20_ietf_xor_ic);
+    EXPORT(crypto_stream_chacha20_ietf_xor_ic_inplace);
+    EXPORT(crypto_stream_chacha20_ietf_xor_parallel);
     PROPS(chacha20_ietf);
+
+    METHODS(xchacha20);
+    EXPORT(crypto_stream_xchacha20_xor_ic);
+    EXPORT(crypto_stream_xchacha20_xor_ic_inplace);
+    EXPORT(crypto_stream_xchacha20_xor_parallel);
+    PROPS(xchacha20);
 }
\ No newline at end of file
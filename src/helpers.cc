@@ -5,7 +5,129 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "sodium_env.h"
+
+unsigned char* sodium_scratch(size_t size) {
+    // Grown once to the largest size, never shrunk or freed
+    static thread_local std::vector<unsigned char> scratch;
+
+    if( size > SODIUM_SCRATCH_MAX ) {
+        return NULL;
+    }
+    if( scratch.size() < size || scratch.empty() ) {
+        scratch.resize(size > 0 ? size : 1);
+    }
+    return scratch.data();
+}
+
+unsigned char* SodiumBase64url::Block(size_t length) {
+    block = sodium_scratch(length);
+    if( block == NULL ) {
+        heap.resize(length);
+        block = heap.data();
+    }
+    room = length;
+    return block;
+}
+
+bool SodiumBase64url::Decode(napi_env env, napi_value value) {
+    // base64url is ASCII, anything else simply fails to decode
+    size_t length = 0;
+    if( napi_get_value_string_latin1(env, value, NULL, 0, &length) != napi_ok ) {
+        return false;
+    }
+
+    // Decoded bytes first, the text behind them
+    size_t max = length / 4 * 3 + 3;
+    Block(max + length + 1);
+    char* text = (char*) block + max;
+    if( napi_get_value_string_latin1(env, value, text, length + 1, &length) != napi_ok ) {
+        return false;
+    }
+
+    const char* end = NULL;
+    data = block;
+    if( sodium_base642bin(data, max, text, length, NULL, &size, &end,
+                          sodium_base64_VARIANT_URLSAFE_NO_PADDING) != 0 || end != text + length ) {
+        size = 0;
+        return false;
+    }
+    return true;
+}
+
+unsigned char* SodiumBase64url::Reserve(size_t length) {
+    Block(length + sodium_base64_ENCODED_LEN(length, sodium_base64_VARIANT_URLSAFE_NO_PADDING));
+    data = block;
+    size = length;
+    return data;
+}
+
+Napi::Value SodiumBase64url::Encode(Napi::Env env) {
+    char* text = (char*) block + size;
+    sodium_bin2base64(text, room - size, data, size, sodium_base64_VARIANT_URLSAFE_NO_PADDING);
+    return Napi::String::New(env, text);
+}
+
+bool sodium_arg_encoding(const Napi::CallbackInfo& info, size_t i, SodiumEncoding& encoding) {
+    encoding = SODIUM_ENCODING_NONE;
+    if( i >= info.Length() || info[i].IsUndefined() ) {
+        return true;
+    }
+    if( info[i].IsString() ) {
+        std::string name = info[i].As<Napi::String>().Utf8Value();
+        if( name == "hex" ) {
+            encoding = SODIUM_ENCODING_HEX;
+        } else if( name == "base64" ) {
+            encoding = SODIUM_ENCODING_BASE64;
+        } else if( name == "base64url" ) {
+            encoding = SODIUM_ENCODING_BASE64URL;
+        }
+    }
+    if( encoding == SODIUM_ENCODING_NONE ) {
+        sodium_throw(info.Env(), "argument encoding must be \"hex\", \"base64\" or \"base64url\"");
+        return false;
+    }
+    return true;
+}
+
+Napi::Value sodium_encode(Napi::Env env, const unsigned char* data, size_t size, SodiumEncoding encoding) {
+    char text[2 * SODIUM_ENCODED_MAX + 1];
+    if( encoding == SODIUM_ENCODING_HEX ) {
+        sodium_bin2hex(text, sizeof text, data, size);
+        return Napi::String::New(env, text, 2 * size);
+    }
+    int variant = encoding == SODIUM_ENCODING_BASE64 ? sodium_base64_VARIANT_ORIGINAL
+                                                     : sodium_base64_VARIANT_URLSAFE_NO_PADDING;
+    sodium_bin2base64(text, sizeof text, data, size, variant);
+    return Napi::String::New(env, text);
+}
+
+bool sodium_fail_quietly(Napi::Env env, const std::string& msg) {
+    SodiumEnv* state = SodiumEnv::Get(env);
+    if( state == NULL || !state->fast_fail ) {
+        return false;
+    }
+    state->last_error = msg;
+    return true;
+}
+
+void sodium_throw(Napi::Env env, const std::string& msg) {
+    if( !sodium_fail_quietly(env, msg) ) {
+        Napi::Error::New(env, msg).ThrowAsJavaScriptException();
+    }
+}
+
+void sodium_throw_range(Napi::Env env, const std::string& msg) {
+    if( !sodium_fail_quietly(env, msg) ) {
+        Napi::RangeError::New(env, msg).ThrowAsJavaScriptException();
+    }
+}
 
 // Lib Sodium Version Functions
 NAPI_METHOD(sodium_version_string) {
@@ -62,33 +184,316 @@ NAPI_METHOD(memcmp) {
     ;
 }
 
+// Hex and base64 codecs
+//
+// libsodium's codecs run in constant time for a given length, so they are
+// safe for keys and other secrets, unlike Buffer.toString and Buffer.from.
+// Encoded text goes through short stack chunks, wiped after use, rather
+// than intermediate strings.
+
+#define CODEC_CHUNK 256
+
+#define CHECK_BASE64_VARIANT(NAME) \
+    if( NAME != sodium_base64_VARIANT_ORIGINAL && \
+        NAME != sodium_base64_VARIANT_ORIGINAL_NO_PADDING && \
+        NAME != sodium_base64_VARIANT_URLSAFE && \
+        NAME != sodium_base64_VARIANT_URLSAFE_NO_PADDING ) { \
+        THROW_ERROR("argument " #NAME " must be one of the sodium_base64_VARIANT_* constants"); \
+    }
+
+// Optional base64 variant argument, sodium_base64_VARIANT_ORIGINAL by default
+#define ARG_TO_BASE64_VARIANT(NAME) \
+    size_t NAME = sodium_base64_VARIANT_ORIGINAL; \
+    if( (size_t) _arg < info.Length() && !info[_arg].IsUndefined() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        NAME = NAME ## _arg; \
+        CHECK_BASE64_VARIANT(NAME); \
+    } else { \
+        _arg++; \
+    }
+
+// Encoded text, given as a String or as bytes
+#define ARG_TO_ENCODED_TEXT(NAME) \
+    std::string NAME ## _string; \
+    const char* NAME = NULL; \
+    size_t NAME ## _size = 0; \
+    if( info[_arg].IsString() ) { \
+        NAME ## _string = info[_arg].As<Napi::String>().Utf8Value(); \
+        NAME = NAME ## _string.data(); \
+        NAME ## _size = NAME ## _string.size(); \
+    } else { \
+        unsigned char* NAME ## _bytes = NULL; \
+        if( !sodium_arg_bytes(info[_arg], NAME ## _bytes, NAME ## _size) ) { \
+            THROW_ERROR("argument " #NAME " must be a string or a buffer"); \
+        } \
+        NAME = (const char*) NAME ## _bytes; \
+    } \
+    _arg++
+
+// Optional string of characters the decoder skips, such as ": "
+#define ARG_TO_IGNORE(NAME) \
+    std::string NAME ## _string; \
+    const char* NAME = NULL; \
+    if( (size_t) _arg < info.Length() && info[_arg].IsString() ) { \
+        NAME ## _string = info[_arg].As<Napi::String>().Utf8Value(); \
+        NAME = NAME ## _string.c_str(); \
+    } \
+    _arg++
+
+static void wipe_string(std::string& s) {
+    sodium_memzero(&s[0], s.size());
+}
+
+static size_t hex_encode(unsigned char* out, const unsigned char* bin, size_t len) {
+    char chunk[2 * CODEC_CHUNK + 1];
+    size_t written = 0;
+
+    while( len > 0 ) {
+        size_t n = len < CODEC_CHUNK ? len : CODEC_CHUNK;
+        sodium_bin2hex(chunk, sizeof chunk, bin, n);
+        memcpy(out + written, chunk, 2 * n);
+        written += 2 * n;
+        bin += n;
+        len -= n;
+    }
+    sodium_memzero(chunk, sizeof chunk);
+    return written;
+}
+
+// Chunks are whole 3 byte groups, so only the last one can be padded
+static size_t base64_encode(unsigned char* out, const unsigned char* bin, size_t len, int variant) {
+    char chunk[4 * CODEC_CHUNK + 1];
+    size_t written = 0;
+
+    do {
+        size_t n = len < 3 * CODEC_CHUNK ? len : 3 * CODEC_CHUNK;
+        size_t encoded = sodium_base64_encoded_len(n, variant) - 1;
+        sodium_bin2base64(chunk, sizeof chunk, bin, n, variant);
+        memcpy(out + written, chunk, encoded);
+        written += encoded;
+        bin += n;
+        len -= n;
+    } while( len > 0 );
+    sodium_memzero(chunk, sizeof chunk);
+    return written;
+}
+
+static Napi::Value encoded_string(Napi::Env env, std::string& text) {
+    Napi::String result = Napi::String::New(env, text);
+    wipe_string(text);
+    return result;
+}
+
 /**
- * char *sodium_bin2hex(char * const hex, const size_t hexlen,
- *                    const unsigned char *bin, const size_t binlen);
+ * sodium_bin2hex:
+ * Hex encode a buffer, in constant time
+ *
+ *     var hex = sodium.sodium_bin2hex(key);
+ *
+ * **Returns**:
+ *
+ * ~ hex (String): lower case hex, two characters per byte
+ *
+ * `sodium_bin2hex_into(out, buffer)` writes the hex characters to the
+ * `out` buffer instead, and returns how many were written.
  */
-NAPI_METHOD(bin2hex) {
+NAPI_METHOD(sodium_bin2hex) {
     Napi::Env env = info.Env();
 
-    Napi::Error::New(env, "use node's native Buffer.toString()").ThrowAsJavaScriptException();
-    return NAPI_NULL;
+    ARGS(1, "argument must be a buffer");
+    ARG_TO_UCHAR_BUFFER(bin);
+
+    std::string hex(2 * bin_size, '\0');
+    hex_encode((unsigned char*) &hex[0], bin, bin_size);
+    return encoded_string(env, hex);
 }
 
-/* int sodium_hex2bin(unsigned char * const bin, const size_t bin_maxlen,
- *                  const char * const hex, const size_t hex_len,
- *                  const char * const ignore, size_t * const bin_len,
- *                  const char ** const hex_end);
+NAPI_METHOD(sodium_bin2hex_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: output buffer, buffer");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_UCHAR_BUFFER(bin);
+    if( out_size / 2 < bin_size ) {
+        THROW_ERROR("argument out must be at least twice as long as the buffer");
+    }
+
+    return Napi::Number::New(env, (double) hex_encode(out, bin, bin_size));
+}
+
+/**
+ * sodium_hex2bin:
+ * Decode hex, in constant time
+ *
+ *     var key = sodium.sodium_hex2bin(hex, [ignore]);
+ *
+ * ~ hex (String|Buffer): hex text, upper or lower case
+ * ~ ignore (String): optional, characters to skip, such as `": "`
+ *
+ * **Returns**:
+ *
+ * ~ buffer (Buffer): decoded bytes
+ * ~ null: if `hex` is not valid hex
+ *
+ * `sodium_hex2bin_into(out, hex, [ignore])` decodes into the `out` buffer
+ * instead, and returns how many bytes were written, or null.
  */
-NAPI_METHOD(hex2bin) {
+NAPI_METHOD(sodium_hex2bin) {
     Napi::Env env = info.Env();
-   /* ARGS();
-    ARG_TO_NUMBER(bin_maxlen);
-    ARG_TO_STRING(hex);
-    ARG_TO_STRING(ignore);
-    ARG_TO_UCA*/
-    Napi::Error::New(env, "use node's native Buffer.toString()").ThrowAsJavaScriptException();
-    return NAPI_NULL;
+
+    ARGS(1, "argument hex must be a string or a buffer");
+    ARG_TO_ENCODED_TEXT(hex);
+    ARG_TO_IGNORE(ignore);
+
+    NEW_BUFFER_AND_PTR(bin, hex_size / 2);
+    size_t bin_len = 0;
+    int rc = sodium_hex2bin(bin_ptr, hex_size / 2, hex, hex_size, ignore, &bin_len, NULL);
+    wipe_string(hex_string);
+    if( rc != 0 ) {
+        sodium_memzero(bin_ptr, hex_size / 2);
+        return NAPI_NULL;
+    }
+    if( bin_len == hex_size / 2 ) {
+        return bin;
+    }
+    Napi::Function subarray = bin.Get("subarray").As<Napi::Function>();
+    return subarray.Call(bin, { Napi::Number::New(env, 0), Napi::Number::New(env, (double) bin_len) });
+}
+
+NAPI_METHOD(sodium_hex2bin_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: output buffer, hex");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_ENCODED_TEXT(hex);
+    ARG_TO_IGNORE(ignore);
+
+    size_t bin_len = 0;
+    int rc = sodium_hex2bin(out, out_size, hex, hex_size, ignore, &bin_len, NULL);
+    wipe_string(hex_string);
+    if( rc != 0 ) {
+        return NAPI_NULL;
+    }
+    return Napi::Number::New(env, (double) bin_len);
+}
+
+/**
+ * sodium_bin2base64:
+ * Base64 encode a buffer, in constant time
+ *
+ *     var text = sodium.sodium_bin2base64(buffer, [variant]);
+ *
+ * ~ variant (Number): optional, one of `sodium_base64_VARIANT_ORIGINAL`
+ *   (the default), `sodium_base64_VARIANT_ORIGINAL_NO_PADDING`,
+ *   `sodium_base64_VARIANT_URLSAFE` or `sodium_base64_VARIANT_URLSAFE_NO_PADDING`
+ *
+ * **Returns**:
+ *
+ * ~ text (String)
+ *
+ * `sodium_bin2base64_into(out, buffer, [variant])` writes to the `out`
+ * buffer instead, and returns how many characters were written.
+ * `sodium_base64_encoded_len(length, [variant])` gives the space needed.
+ */
+NAPI_METHOD(sodium_bin2base64) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument must be a buffer");
+    ARG_TO_UCHAR_BUFFER(bin);
+    ARG_TO_BASE64_VARIANT(variant);
+
+    std::string text(sodium_base64_encoded_len(bin_size, variant) - 1, '\0');
+    base64_encode((unsigned char*) &text[0], bin, bin_size, variant);
+    return encoded_string(env, text);
+}
+
+NAPI_METHOD(sodium_bin2base64_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: output buffer, buffer");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_UCHAR_BUFFER(bin);
+    ARG_TO_BASE64_VARIANT(variant);
+    if( out_size < sodium_base64_encoded_len(bin_size, variant) - 1 ) {
+        THROW_ERROR("argument out is too small, see sodium_base64_encoded_len");
+    }
+
+    return Napi::Number::New(env, (double) base64_encode(out, bin, bin_size, variant));
 }
 
+NAPI_METHOD(sodium_base64_encoded_len) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument length must be a number");
+    ARG_TO_NUMBER(length);
+    ARG_TO_BASE64_VARIANT(variant);
+
+    return Napi::Number::New(env, (double) (sodium_base64_encoded_len(length, variant) - 1));
+}
+
+/**
+ * sodium_base642bin:
+ * Decode base64, in constant time
+ *
+ *     var buffer = sodium.sodium_base642bin(text, [variant], [ignore]);
+ *
+ * ~ text (String|Buffer): base64 text
+ * ~ variant (Number): optional, as in `sodium_bin2base64`. The text must
+ *   match it exactly
+ * ~ ignore (String): optional, characters to skip, such as `"\r\n"`
+ *
+ * **Returns**:
+ *
+ * ~ buffer (Buffer): decoded bytes
+ * ~ null: if `text` is not valid for the variant
+ *
+ * `sodium_base642bin_into(out, text, [variant], [ignore])` decodes into the
+ * `out` buffer instead, and returns how many bytes were written, or null.
+ */
+NAPI_METHOD(sodium_base642bin) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument text must be a string or a buffer");
+    ARG_TO_ENCODED_TEXT(text);
+    ARG_TO_BASE64_VARIANT(variant);
+    ARG_TO_IGNORE(ignore);
+
+    size_t max_len = text_size / 4 * 3 + 2;
+    NEW_BUFFER_AND_PTR(bin, max_len);
+    size_t bin_len = 0;
+    int rc = sodium_base642bin(bin_ptr, max_len, text, text_size, ignore, &bin_len, NULL, variant);
+    wipe_string(text_string);
+    if( rc != 0 ) {
+        sodium_memzero(bin_ptr, max_len);
+        return NAPI_NULL;
+    }
+    Napi::Function subarray = bin.Get("subarray").As<Napi::Function>();
+    return subarray.Call(bin, { Napi::Number::New(env, 0), Napi::Number::New(env, (double) bin_len) });
+}
+
+NAPI_METHOD(sodium_base642bin_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: output buffer, text");
+    ARG_TO_UCHAR_BUFFER(out);
+    ARG_TO_ENCODED_TEXT(text);
+    ARG_TO_BASE64_VARIANT(variant);
+    ARG_TO_IGNORE(ignore);
+
+    size_t bin_len = 0;
+    int rc = sodium_base642bin(out, out_size, text, text_size, ignore, &bin_len, NULL, variant);
+    wipe_string(text_string);
+    if( rc != 0 ) {
+        return NAPI_NULL;
+    }
+    return Napi::Number::New(env, (double) bin_len);
+}
+
+#undef CHECK_BASE64_VARIANT
+#undef ARG_TO_BASE64_VARIANT
+#undef ARG_TO_ENCODED_TEXT
+#undef ARG_TO_IGNORE
+
 NAPI_METHOD(crypto_verify_16) {
     Napi::Env env = info.Env();
 
@@ -189,6 +594,171 @@ NAPI_METHOD(is_zero) {
         Napi::Number::New(env, sodium_is_zero(buffer_1, buffer_1_size));
 }
 
+#define CHECK_PAD_BLOCK_SIZE(NAME) \
+    if( NAME == 0 ) { \
+        THROW_ERROR("argument " #NAME " must be bigger than 0"); \
+    }
+
+/**
+ * sodium_pad:
+ * Pad a buffer to a multiple of `blockSize` with ISO/IEC 7816-4 padding
+ *
+ *     var padded = sodium.sodium_pad(buffer, blockSize);
+ *
+ * ~ buffer (Buffer): data to pad
+ * ~ blockSize (Number): block size in bytes
+ *
+ * **Returns**:
+ *
+ * ~ padded (Buffer): copy of `buffer` followed by `0x80` and zero bytes. At
+ *   least one byte is always added
+ */
+NAPI_METHOD(sodium_pad) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: buffer, block size");
+    ARG_TO_UCHAR_BUFFER(buffer);
+    ARG_TO_NUMBER(blockSize);
+    CHECK_PAD_BLOCK_SIZE(blockSize);
+
+    size_t padded_size = (buffer_size / blockSize + 1) * blockSize;
+    NEW_BUFFER_AND_PTR(padded, padded_size);
+    memcpy(padded_ptr, buffer, buffer_size);
+
+    size_t padded_len;
+    sodium_pad(&padded_len, padded_ptr, buffer_size, blockSize, padded_size);
+    return padded;
+}
+
+/**
+ * sodium_pad_into:
+ * Pad the first `length` bytes of a buffer in place
+ *
+ *     var paddedLength = sodium.sodium_pad_into(buffer, length, blockSize);
+ *
+ * ~ buffer (Buffer): holds the data, with room for the padding after it
+ * ~ length (Number): length of the data
+ * ~ blockSize (Number): block size in bytes
+ *
+ * **Returns**:
+ *
+ * ~ paddedLength (Number): length of the data with its padding
+ */
+NAPI_METHOD(sodium_pad_into) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: buffer, length, block size");
+    ARG_TO_UCHAR_BUFFER(buffer);
+    ARG_TO_NUMBER(length);
+    ARG_TO_NUMBER(blockSize);
+    CHECK_PAD_BLOCK_SIZE(blockSize);
+    if( length > buffer_size ) {
+        THROW_ERROR("argument length is bigger than the buffer");
+    }
+
+    size_t padded_len;
+    if( sodium_pad(&padded_len, buffer, length, blockSize, buffer_size) != 0 ) {
+        THROW_ERROR("argument buffer is too small to hold the padding");
+    }
+    return Napi::Number::New(env, (double) padded_len);
+}
+
+/**
+ * sodium_unpad:
+ * Remove ISO/IEC 7816-4 padding
+ *
+ *     var data = sodium.sodium_unpad(padded, blockSize);
+ *
+ * ~ padded (Buffer): padded data
+ * ~ blockSize (Number): block size the data was padded to
+ *
+ * **Returns**:
+ *
+ * ~ data (Buffer): view on `padded` without the padding. Nothing is copied
+ * ~ null: if the padding is not valid
+ */
+NAPI_METHOD(sodium_unpad) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments must be: buffer, block size");
+    ARG_TO_UCHAR_BUFFER(buffer);
+    ARG_TO_NUMBER(blockSize);
+    CHECK_PAD_BLOCK_SIZE(blockSize);
+
+    size_t unpadded_len;
+    if( sodium_unpad(&unpadded_len, buffer, buffer_size, blockSize) != 0 ) {
+        return NAPI_NULL;
+    }
+
+    Napi::Function subarray = buffer_buffer.Get("subarray").As<Napi::Function>();
+    return subarray.Call(buffer_buffer, {
+        Napi::Number::New(env, 0), Napi::Number::New(env, (double) unpadded_len)
+    });
+}
+
+#undef CHECK_PAD_BLOCK_SIZE
+
+/**
+ * sodium_async_threshold([bytes])
+ *
+ * Get or set the input size, in bytes, below which the tiered async hash and
+ * MAC bindings run inline instead of on the threadpool. 0 always uses the
+ * threadpool.
+ *
+ * Returns the threshold in effect after the call.
+ */
+NAPI_METHOD(sodium_async_threshold) {
+    Napi::Env env = info.Env();
+
+    if( info.Length() > 0 ) {
+        ARGS(1, "argument bytes must be a number");
+        ARG_TO_NUMBER(bytes);
+        sodium_async_threshold() = bytes;
+    }
+
+    return Napi::Number::New(env, (double) sodium_async_threshold());
+}
+
+/**
+ * sodium_fast_fail([enable])
+ *
+ * Get or set fast fail mode for this thread. When on, bindings given a
+ * malformed argument, such as a buffer of the wrong size, return null
+ * instead of throwing, and the message is kept for sodium_last_error.
+ *
+ * Returns whether the mode is on after the call.
+ */
+NAPI_METHOD(sodium_fast_fail) {
+    Napi::Env env = info.Env();
+    SodiumEnv* state = SodiumEnv::Get(env);
+
+    if( info.Length() > 0 ) {
+        state->fast_fail = info[0].ToBoolean().Value();
+        state->last_error.clear();
+    }
+
+    return Napi::Boolean::New(env, state->fast_fail);
+}
+
+/**
+ * sodium_last_error()
+ *
+ * Message of the last argument error kept in fast fail mode, or null if
+ * there was none since the last call. The message is cleared.
+ */
+NAPI_METHOD(sodium_last_error) {
+    Napi::Env env = info.Env();
+    SodiumEnv* state = SodiumEnv::Get(env);
+
+    if( state->last_error.empty() ) {
+        return NAPI_NULL;
+    }
+
+    Napi::String msg = Napi::String::New(env, state->last_error);
+    state->last_error.clear();
+    return msg;
+}
+
 /**
  * Register function calls in node binding
  */
@@ -211,12 +781,43 @@ void register_helpers(Napi::Env env, Napi::Object exports) {
     EXPORT_INT(crypto_verify_64_BYTES);
     
     // Hexadecimal encoding/decoding
-    EXPORT(bin2hex);
-    EXPORT(hex2bin);
+    EXPORT(sodium_bin2hex);
+    EXPORT(sodium_bin2hex_into);
+    EXPORT(sodium_hex2bin);
+    EXPORT(sodium_hex2bin_into);
+    EXPORT_ALIAS(bin2hex, sodium_bin2hex);
+    EXPORT_ALIAS(hex2bin, sodium_hex2bin);
+
+    // Base64 encoding/decoding
+    EXPORT(sodium_bin2base64);
+    EXPORT(sodium_bin2base64_into);
+    EXPORT(sodium_base642bin);
+    EXPORT(sodium_base642bin_into);
+    EXPORT(sodium_base64_encoded_len);
+    EXPORT_INT(sodium_base64_VARIANT_ORIGINAL);
+    EXPORT_INT(sodium_base64_VARIANT_ORIGINAL_NO_PADDING);
+    EXPORT_INT(sodium_base64_VARIANT_URLSAFE);
+    EXPORT_INT(sodium_base64_VARIANT_URLSAFE_NO_PADDING);
     
     // Large Numbers
     EXPORT(increment);
     EXPORT(add);
     EXPORT(compare);
     EXPORT(is_zero);
+    EXPORT_ALIAS(sodium_increment, increment);
+    EXPORT_ALIAS(sodium_add, add);
+    EXPORT_ALIAS(sodium_compare, compare);
+    EXPORT_ALIAS(sodium_is_zero, is_zero);
+
+    // Padding
+    EXPORT(sodium_pad);
+    EXPORT(sodium_pad_into);
+    EXPORT(sodium_unpad);
+
+    // Async tiering
+    EXPORT(sodium_async_threshold);
+
+    // Error mode
+    EXPORT(sodium_fast_fail);
+    EXPORT(sodium_last_error);
 }
\ No newline at end of file
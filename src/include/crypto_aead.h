@@ -8,6 +8,13 @@
 #ifndef __CRYPTO_AEAD_H__
 #define __CRYPTO_AEAD_H__
 
+#include <atomic>
+
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "sodium_batch_stream.h"
+#include "sodium_stats.h"
+
 /*
 int crypto_aead_aes256gcm_encrypt(unsigned char *c,
                                   unsigned long long *clen_p,
@@ -34,14 +41,14 @@ int crypto_aead_aes256gcm_decrypt(unsigned char *m,
     NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt ) { \
         Napi::Env env = info.Env(); \
         ARGS(4, "arguments message, additional data, nonce, and key must be buffers"); \
-        ARG_TO_UCHAR_BUFFER(m); \
+        ARG_TO_UCHAR_BUFFER_RANGE(m); \
         ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
         ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
         ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
         NEW_BUFFER_AND_PTR(c, crypto_aead_ ## ALGO ## _ABYTES + m_size); \
-        sodium_memzero(c_ptr, crypto_aead_ ## ALGO ## _ABYTES + m_size); \
         unsigned long long clen;\
-        if( crypto_aead_ ## ALGO ## _encrypt (c_ptr, &clen, m, m_size, ad, ad_size, NULL, npub, k) == 0 ) { \
+        if( SODIUM_STAT(aead_ ## ALGO, m_size, m_size + crypto_aead_ ## ALGO ## _ABYTES, \
+                crypto_aead_ ## ALGO ## _encrypt (c_ptr, &clen, m, m_size, ad, ad_size, NULL, npub, k)) == 0 ) { \
             return c; \
         } \
         return NAPI_NULL; \
@@ -49,17 +56,52 @@ int crypto_aead_aes256gcm_decrypt(unsigned char *m,
     NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt) { \
         Napi::Env env = info.Env(); \
         ARGS(4, "arguments chiper text, additional data, nonce, and key must be buffers"); \
-        ARG_TO_UCHAR_BUFFER(c); \
+        ARG_TO_UCHAR_BUFFER_RANGE(c); \
         if( c_size < crypto_aead_ ## ALGO ## _ABYTES ) { \
             THROW_ERROR("argument cipher text must be at least crypto_aead_ " #ALGO "_ABYTES bytes long"); \
         } \
         ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
         ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
         ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
-        NEW_BUFFER_AND_PTR(m, c_size - crypto_aead_ ## ALGO ## _ABYTES); \
         unsigned long long mlen;\
-        if( crypto_aead_ ## ALGO ## _decrypt (m_ptr, &mlen, NULL, c, c_size, ad, ad_size, npub, k) == 0 ) { \
-            return m; \
+        RETURN_DECRYPTED(m, c_size - crypto_aead_ ## ALGO ## _ABYTES, \
+            SODIUM_STAT(aead_ ## ALGO, c_size, m_size, \
+                crypto_aead_ ## ALGO ## _decrypt (m_ptr, &mlen, NULL, c, c_size, ad, ad_size, npub, k))); \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_into) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments output buffer, offset, message, additional data, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER(out); \
+        ARG_TO_NUMBER(offset); \
+        ARG_TO_UCHAR_BUFFER_RANGE(m); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        CHECK_OUTPUT_SPACE(out, offset, m_size + crypto_aead_ ## ALGO ## _ABYTES); \
+        unsigned long long clen;\
+        if( SODIUM_STAT(aead_ ## ALGO, m_size, m_size + crypto_aead_ ## ALGO ## _ABYTES, \
+                crypto_aead_ ## ALGO ## _encrypt (out + offset, &clen, m, m_size, ad, ad_size, NULL, npub, k)) == 0 ) { \
+            return Napi::Number::New(env, clen); \
+        } \
+        return NAPI_NULL; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_into) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments output buffer, offset, cipher text, additional data, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER(out); \
+        ARG_TO_NUMBER(offset); \
+        ARG_TO_UCHAR_BUFFER_RANGE(c); \
+        if( c_size < crypto_aead_ ## ALGO ## _ABYTES ) { \
+            THROW_ERROR("argument cipher text must be at least crypto_aead_ " #ALGO "_ABYTES bytes long"); \
+        } \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        CHECK_OUTPUT_SPACE(out, offset, c_size - crypto_aead_ ## ALGO ## _ABYTES); \
+        unsigned long long mlen;\
+        if( SODIUM_STAT(aead_ ## ALGO, c_size, c_size - crypto_aead_ ## ALGO ## _ABYTES, \
+                crypto_aead_ ## ALGO ## _decrypt (out + offset, &mlen, NULL, c, c_size, ad, ad_size, npub, k)) == 0 ) { \
+            return Napi::Number::New(env, mlen); \
         } \
         return NAPI_NULL; \
     } \
@@ -97,7 +139,7 @@ int crypto_aead_aes256gcm_decrypt_detached(unsigned char *m,
     NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_detached) { \
         Napi::Env env = info.Env(); \
         ARGS(4, "arguments message, additional data, nonce, and key must be buffers"); \
-        ARG_TO_UCHAR_BUFFER(m); \
+        ARG_TO_UCHAR_BUFFER_RANGE(m); \
         ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
         ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
         ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
@@ -115,7 +157,7 @@ int crypto_aead_aes256gcm_decrypt_detached(unsigned char *m,
     NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_detached) { \
         Napi::Env env = info.Env(); \
         ARGS(4, "arguments cipher message, mac, additional data, nsec, nonce, and key must be buffers"); \
-        ARG_TO_UCHAR_BUFFER(c); \
+        ARG_TO_UCHAR_BUFFER_RANGE(c); \
         ARG_TO_UCHAR_BUFFER(mac); \
         ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
         if( mac_size > crypto_aead_ ## ALGO ## _ABYTES ) { \
@@ -129,18 +171,729 @@ int crypto_aead_aes256gcm_decrypt_detached(unsigned char *m,
         } \
         return NAPI_NULL; \
     } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_detached_into) { \
+        Napi::Env env = info.Env(); \
+        ARGS(8, "arguments output buffer, offset, mac buffer, mac offset, message, additional data, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER(out); \
+        ARG_TO_NUMBER(offset); \
+        ARG_TO_UCHAR_BUFFER(mac); \
+        ARG_TO_NUMBER(macOffset); \
+        ARG_TO_UCHAR_BUFFER_RANGE(m); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        CHECK_OUTPUT_SPACE(out, offset, m_size); \
+        CHECK_OUTPUT_SPACE(mac, macOffset, crypto_aead_ ## ALGO ## _ABYTES); \
+        if( crypto_aead_ ## ALGO ## _encrypt_detached (out + offset, mac + macOffset, NULL, m, m_size, ad, ad_size, NULL, npub, k) == 0 ) { \
+            return Napi::Number::New(env, m_size); \
+        } \
+        return NAPI_NULL; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_detached_into) { \
+        Napi::Env env = info.Env(); \
+        ARGS(7, "arguments output buffer, offset, cipher message, mac, additional data, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER(out); \
+        ARG_TO_NUMBER(offset); \
+        ARG_TO_UCHAR_BUFFER_RANGE(c); \
+        ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_aead_ ## ALGO ## _ABYTES); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        CHECK_OUTPUT_SPACE(out, offset, c_size); \
+        if( crypto_aead_ ## ALGO ## _decrypt_detached (out + offset, NULL, c, c_size, mac, ad, ad_size, npub, k) == 0 ) { \
+            return Napi::Number::New(env, c_size); \
+        } \
+        return NAPI_NULL; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_detached_inplace) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments message, additional data, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER_RANGE(m); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        NEW_BUFFER_AND_PTR(mac, crypto_aead_ ## ALGO ## _ABYTES); \
+        if( crypto_aead_ ## ALGO ## _encrypt_detached (m, mac_ptr, NULL, m, m_size, ad, ad_size, NULL, npub, k) == 0 ) { \
+            return mac; \
+        } \
+        return NAPI_NULL; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_detached_inplace) { \
+        Napi::Env env = info.Env(); \
+        ARGS(5, "arguments cipher message, mac, additional data, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER_RANGE(c); \
+        ARG_TO_UCHAR_BUFFER_LEN(mac, crypto_aead_ ## ALGO ## _ABYTES); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        if( crypto_aead_ ## ALGO ## _decrypt_detached (c, NULL, c, c_size, mac, ad, ad_size, npub, k) == 0 ) { \
+            return NAPI_TRUE; \
+        } \
+        return NAPI_FALSE; \
+    } \
     NAPI_METHOD_FROM_INT(crypto_aead_ ## ALGO ## _abytes); \
     NAPI_METHOD_FROM_INT(crypto_aead_ ## ALGO ## _keybytes); \
     NAPI_METHOD_FROM_INT(crypto_aead_ ## ALGO ## _npubbytes); \
     NAPI_METHOD_FROM_INT(crypto_aead_ ## ALGO ## _nsecbytes); \
     NAPI_METHOD_FROM_INT(crypto_aead_ ## ALGO ## _messagebytes_max)
 
+/*
+ * Batch interface. One native call encrypts or decrypts N messages under the
+ * same key. Results are written back to back in a single buffer, in order:
+ * message i starts at the sum of the lengths of messages 0..i-1.
+ *
+ * messages (Array of Buffers)
+ * additional data (Array of Buffers or nulls, or null)
+ * nonces (Array of Buffers, or one Buffer with N nonces back to back)
+ * key (Buffer)
+ *
+ * Decryption is all or nothing: if any message fails to authenticate the
+ * output is wiped and null is returned.
+ *
+ * `_decrypt_each_async(cipherTexts, additionalData, nonces, keys, [options],
+ * [callback])` opens messages that have nothing in common, each under its
+ * own key (an Array, or one Buffer with N keys back to back), on the
+ * threadpool. It resolves to an Array holding each message, or null for the
+ * ones that do not authenticate. The messages are views on one Buffer.
+ * `_decrypt_each_stream(cipherTexts, additionalData, nonces, keys, options,
+ * [callback])` does the same but hands the messages to `options.onChunk`
+ * a chunk at a time as they are opened, see sodium_batch_stream.h.
+ *
+ * CRYPTO_AEAD_BATCH_DEF(ALGO) seals and opens the messages of a batch one
+ * after the other. An algorithm with a kernel of its own for many messages
+ * defines `aead_ALGO_encrypt_batch` and `aead_ALGO_decrypt_batch` itself,
+ * and uses CRYPTO_AEAD_BATCH_METHODS(ALGO) for the rest.
+ */
+#define CRYPTO_AEAD_BATCH_KERNELS(ALGO) \
+    static int aead_ ## ALGO ## _encrypt_batch(unsigned char* out, const std::vector<SodiumSpan>& m, \
+                                               const std::vector<SodiumSpan>& ad, const std::vector<SodiumSpan>& npub, \
+                                               const unsigned char* k) { \
+        for(size_t i = 0; i < m.size(); i++) { \
+            unsigned long long clen; \
+            if( crypto_aead_ ## ALGO ## _encrypt (out, &clen, m[i].data, m[i].size, ad[i].data, ad[i].size, NULL, npub[i].data, k) != 0 ) { \
+                return -1; \
+            } \
+            out += clen; \
+        } \
+        return 0; \
+    } \
+    static int aead_ ## ALGO ## _decrypt_batch(unsigned char* out, const std::vector<SodiumSpan>& c, \
+                                               const std::vector<SodiumSpan>& ad, const std::vector<SodiumSpan>& npub, \
+                                               const unsigned char* k) { \
+        for(size_t i = 0; i < c.size(); i++) { \
+            unsigned long long mlen; \
+            if( crypto_aead_ ## ALGO ## _decrypt (out, &mlen, NULL, c[i].data, c[i].size, ad[i].data, ad[i].size, npub[i].data, k) != 0 ) { \
+                return -1; \
+            } \
+            out += mlen; \
+        } \
+        return 0; \
+    }
+
+// Pointer and length arrays of a batch, as the multi-message kernels of
+// libsodium take them. Output i starts where output i - 1 ends.
+struct AeadBatchPointers {
+    AeadBatchPointers(const std::vector<SodiumSpan>& inputs, const std::vector<SodiumSpan>& ads,
+                      const std::vector<SodiumSpan>& nonces, unsigned char* output, size_t abytes, bool seal)
+        : in(inputs.size()), inLen(inputs.size()), ad(inputs.size()), adLen(inputs.size()),
+          npub(inputs.size()), out(inputs.size()) {
+        for(size_t i = 0; i < inputs.size(); i++) {
+            in[i] = inputs[i].data;
+            inLen[i] = inputs[i].size;
+            ad[i] = ads[i].data;
+            adLen[i] = ads[i].size;
+            npub[i] = nonces[i].data;
+            out[i] = output;
+            output += seal ? inputs[i].size + abytes : inputs[i].size - abytes;
+        }
+    }
+
+    std::vector<const unsigned char*> in;
+    std::vector<unsigned long long> inLen;
+    std::vector<const unsigned char*> ad;
+    std::vector<unsigned long long> adLen;
+    std::vector<const unsigned char*> npub;
+    std::vector<unsigned char*> out;
+};
+
+extern "C" {
+int crypto_aead_chacha20poly1305_ietf_encrypt_multi(unsigned char * const *c, const unsigned char * const *m,
+                                                    const unsigned long long *mlen, const unsigned char * const *ad,
+                                                    const unsigned long long *adlen, const unsigned char * const *npub,
+                                                    size_t n, const unsigned char *k);
+int crypto_aead_chacha20poly1305_ietf_decrypt_multi(unsigned char *ok, unsigned char * const *m,
+                                                    const unsigned char * const *c, const unsigned long long *clen,
+                                                    const unsigned char * const *ad, const unsigned long long *adlen,
+                                                    const unsigned char * const *npub, size_t n, const unsigned char *k);
+int crypto_aead_xchacha20poly1305_ietf_encrypt_multi(unsigned char * const *c, const unsigned char * const *m,
+                                                     const unsigned long long *mlen, const unsigned char * const *ad,
+                                                     const unsigned long long *adlen, const unsigned char * const *npub,
+                                                     size_t n, const unsigned char *k);
+int crypto_aead_xchacha20poly1305_ietf_decrypt_multi(unsigned char *ok, unsigned char * const *m,
+                                                     const unsigned char * const *c, const unsigned long long *clen,
+                                                     const unsigned char * const *ad, const unsigned long long *adlen,
+                                                     const unsigned char * const *npub, size_t n, const unsigned char *k);
+}
+
+// Batch kernels on crypto_aead_ALGO_encrypt_multi() and _decrypt_multi(),
+// which seal and open several short messages at a time (AVX2)
+#define CRYPTO_AEAD_MULTI_KERNELS(ALGO) \
+    static int aead_ ## ALGO ## _encrypt_batch(unsigned char* out, const std::vector<SodiumSpan>& m, \
+                                               const std::vector<SodiumSpan>& ad, const std::vector<SodiumSpan>& npub, \
+                                               const unsigned char* k) { \
+        AeadBatchPointers batch(m, ad, npub, out, crypto_aead_ ## ALGO ## _ABYTES, true); \
+        return crypto_aead_ ## ALGO ## _encrypt_multi(batch.out.data(), batch.in.data(), batch.inLen.data(), \
+                                                      batch.ad.data(), batch.adLen.data(), batch.npub.data(), m.size(), k); \
+    } \
+    static int aead_ ## ALGO ## _decrypt_batch(unsigned char* out, const std::vector<SodiumSpan>& c, \
+                                               const std::vector<SodiumSpan>& ad, const std::vector<SodiumSpan>& npub, \
+                                               const unsigned char* k) { \
+        AeadBatchPointers batch(c, ad, npub, out, crypto_aead_ ## ALGO ## _ABYTES, false); \
+        std::vector<unsigned char> ok(c.size()); \
+        return crypto_aead_ ## ALGO ## _decrypt_multi(ok.data(), batch.out.data(), batch.in.data(), batch.inLen.data(), \
+                                                      batch.ad.data(), batch.adLen.data(), batch.npub.data(), c.size(), k); \
+    }
+
+#define CRYPTO_AEAD_BATCH_DEF(ALGO) \
+    CRYPTO_AEAD_BATCH_KERNELS(ALGO) \
+    CRYPTO_AEAD_BATCH_METHODS(ALGO)
+
+#define CRYPTO_AEAD_BATCH_METHODS(ALGO) \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_batch) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments messages, additional data, nonces, and key must be buffers"); \
+        size_t count = SODIUM_BATCH_ANY; \
+        ARG_TO_BATCH(m, count); \
+        ARG_TO_BATCH_OR_NULL(ad, count); \
+        ARG_TO_BATCH_LEN(npub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        size_t total = count * crypto_aead_ ## ALGO ## _ABYTES; \
+        for(size_t i = 0; i < count; i++) { \
+            total += m[i].size; \
+        } \
+        NEW_BUFFER_AND_PTR(c, total); \
+        if( aead_ ## ALGO ## _encrypt_batch(c_ptr, m, ad, npub, k) != 0 ) { \
+            return NAPI_NULL; \
+        } \
+        return c; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_batch) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments cipher texts, additional data, nonces, and key must be buffers"); \
+        size_t count = SODIUM_BATCH_ANY; \
+        ARG_TO_BATCH(c, count); \
+        ARG_TO_BATCH_OR_NULL(ad, count); \
+        ARG_TO_BATCH_LEN(npub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        size_t total = 0; \
+        for(size_t i = 0; i < count; i++) { \
+            if( c[i].size < crypto_aead_ ## ALGO ## _ABYTES ) { \
+                THROW_ERROR("every cipher text must be at least crypto_aead_" #ALGO "_ABYTES bytes long"); \
+            } \
+            total += c[i].size - crypto_aead_ ## ALGO ## _ABYTES; \
+        } \
+        NEW_BUFFER_AND_PTR(m, total); \
+        if( aead_ ## ALGO ## _decrypt_batch(m_ptr, c, ad, npub, k) != 0 ) { \
+            sodium_memzero(m_ptr, total); \
+            return NAPI_NULL; \
+        } \
+        return m; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_each_async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments cipher texts, additional data, nonces, and keys are required"); \
+        size_t count = SODIUM_BATCH_ANY; \
+        ARG_TO_BATCH(c, count); \
+        ARG_TO_BATCH_OR_NULL(ad, count); \
+        ARG_TO_BATCH_LEN(npub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_BATCH_LEN(k, count, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        SodiumEachWorker* worker = new SodiumEachWorker(info, "crypto_aead_" #ALGO "_decrypt_each", count); \
+        size_t total = 0; \
+        for(size_t i = 0; i < count; i++) { \
+            worker->offsets[i] = total; \
+            worker->sizes[i] = c[i].size < crypto_aead_ ## ALGO ## _ABYTES ? 0 : c[i].size - crypto_aead_ ## ALGO ## _ABYTES; \
+            total += worker->sizes[i]; \
+        } \
+        NEW_BUFFER_AND_PTR(m, total); \
+        unsigned char* out = worker->Output(m); \
+        std::vector<SodiumSpan> items(4 * count); \
+        for(size_t i = 0; i < count; i++) { \
+            items[4 * i] = { worker->Copy(c[i].data, c[i].size), c[i].size }; \
+            items[4 * i + 1] = { ad[i].data != NULL ? worker->Copy(ad[i].data, ad[i].size) : NULL, ad[i].size }; \
+            items[4 * i + 2] = { worker->Copy(npub[i].data, npub[i].size), npub[i].size }; \
+            items[4 * i + 3] = { worker->Copy(k[i].data, k[i].size), k[i].size }; \
+        } \
+        return worker->Start([=]() { \
+            for(size_t i = 0; i < count; i++) { \
+                const SodiumSpan* item = &items[4 * i]; \
+                unsigned long long mlen; \
+                worker->ok[i] = item[0].size >= crypto_aead_ ## ALGO ## _ABYTES && \
+                    SODIUM_STAT(aead_ ## ALGO, item[0].size, worker->sizes[i], \
+                        crypto_aead_ ## ALGO ## _decrypt (out + worker->offsets[i], &mlen, NULL, item[0].data, item[0].size, \
+                                                          item[1].data, item[1].size, item[2].data, item[3].data)) == 0; \
+                if( !worker->ok[i] ) { \
+                    sodium_memzero(out + worker->offsets[i], worker->sizes[i]); \
+                } \
+            } \
+            return 0; \
+        }, ASYNC_RESULT_BUFFER); \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_each_stream) { \
+        Napi::Env env = info.Env(); \
+        ARGS(5, "arguments cipher texts, additional data, nonces, keys, and options are required"); \
+        size_t count = SODIUM_BATCH_ANY; \
+        ARG_TO_BATCH(c, count); \
+        ARG_TO_BATCH_OR_NULL(ad, count); \
+        ARG_TO_BATCH_LEN(npub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_BATCH_LEN(k, count, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        ARG_TO_STREAM_OPTIONS(options); \
+        SodiumStreamWorker* worker = new SodiumStreamWorker(info, "crypto_aead_" #ALGO "_decrypt_each_stream", \
+                                                            count, STREAM_RESULT_BUFFERS, options); \
+        std::vector<SodiumSpan> items(4 * count); \
+        for(size_t i = 0; i < count; i++) { \
+            worker->sizes[i] = c[i].size < crypto_aead_ ## ALGO ## _ABYTES ? 0 : c[i].size - crypto_aead_ ## ALGO ## _ABYTES; \
+            items[4 * i] = { worker->Copy(c[i].data, c[i].size), c[i].size }; \
+            items[4 * i + 1] = { ad[i].data != NULL ? worker->Copy(ad[i].data, ad[i].size) : NULL, ad[i].size }; \
+            items[4 * i + 2] = { worker->Copy(npub[i].data, npub[i].size), npub[i].size }; \
+            items[4 * i + 3] = { worker->Copy(k[i].data, k[i].size), k[i].size }; \
+        } \
+        return worker->Stream([=](size_t begin, size_t end, unsigned char* out, unsigned char* ok) { \
+            for(size_t i = begin; i < end; i++) { \
+                const SodiumSpan* item = &items[4 * i]; \
+                size_t m_size = item[0].size < crypto_aead_ ## ALGO ## _ABYTES ? 0 : item[0].size - crypto_aead_ ## ALGO ## _ABYTES; \
+                unsigned long long mlen; \
+                ok[i - begin] = item[0].size >= crypto_aead_ ## ALGO ## _ABYTES && \
+                    SODIUM_STAT(aead_ ## ALGO, item[0].size, m_size, \
+                        crypto_aead_ ## ALGO ## _decrypt (out, &mlen, NULL, item[0].data, item[0].size, \
+                                                          item[1].data, item[1].size, item[2].data, item[3].data)) == 0; \
+                if( !ok[i - begin] ) { \
+                    sodium_memzero(out, m_size); \
+                } \
+                out += m_size; \
+            } \
+        }); \
+    }
+
+/*
+ * Chunked interface, for large messages and for containers that are read a
+ * range at a time. A message is cut in chunks of `chunkSize` bytes, the last
+ * one shorter, and chunk `i` is sealed on its own with the nonce `nonce + i`,
+ * the nonce read as a little endian number like sodium_increment() does.
+ * Chunk `i` of the output starts at `i * (chunkSize + ABYTES)`, its cipher
+ * text followed by its tag, so the chunks can be sealed and opened on
+ * several threads at once, and any run of them without the ones before it.
+ *
+ * Decryption is all or nothing, as for the batch interface.
+ */
+#define AEAD_CHUNKS_MIN_BYTES_PER_THREAD (256 * 1024)
+
+// `out` = `base` + `index`, both little endian, carrying across every byte
+inline void aead_chunk_nonce(unsigned char* out, const unsigned char* base, size_t size, uint64_t index) {
+    unsigned int carry = 0;
+    for(size_t i = 0; i < size; i++) {
+        carry += base[i] + (unsigned int) (index & 0xff);
+        out[i] = (unsigned char) carry;
+        carry >>= 8;
+        index >>= 8;
+    }
+}
+
+// Chunks below this many bytes would make a thread per handful of bytes
+inline size_t aead_chunks_per_thread(size_t chunk_size) {
+    return chunk_size < AEAD_CHUNKS_MIN_BYTES_PER_THREAD ? AEAD_CHUNKS_MIN_BYTES_PER_THREAD / chunk_size : 1;
+}
+
+#define ARG_TO_AEAD_CHUNK_ARGS(ALGO) \
+    ARG_TO_NUMBER(chunkSize); \
+    ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+    ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+    ARG_TO_NUMBER(firstIndex); \
+    ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+    if( chunkSize == 0 ) { \
+        THROW_ERROR("argument chunkSize must be a positive number"); \
+    }
+
+// Optional output buffer of exactly SIZE bytes at the current argument,
+// or a new one
+#define ARG_TO_AEAD_CHUNKS_OUT(NAME, SIZE) \
+    Napi::Object NAME; \
+    if( info.Length() > (size_t) _arg && (info[_arg].IsBuffer() || info[_arg].IsTypedArray()) ) { \
+        ARG_TO_UCHAR_BUFFER(NAME ## _out); \
+        if( NAME ## _out_size != (SIZE) ) { \
+            THROW_ERROR("argument out must be " + std::to_string(SIZE) + " bytes long"); \
+        } \
+        NAME = NAME ## _out_buffer; \
+    } else { \
+        NEW_BUFFER_AND_PTR(NAME ## _new, SIZE); \
+        NAME = NAME ## _new; \
+    }
+
+// Threads of the `threads` option of the async calls, every core by default
+#define ARG_TO_AEAD_CHUNKS_THREADS(NAME) \
+    size_t NAME = std::thread::hardware_concurrency(); \
+    if( info.Length() > (size_t) _arg && sodium_async_is_options(info[_arg]) ) { \
+        Napi::Value NAME ## _value = info[_arg].As<Napi::Object>().Get("threads"); \
+        if( !NAME ## _value.IsUndefined() ) { \
+            if( !NAME ## _value.IsNumber() || !(NAME ## _value.As<Napi::Number>().DoubleValue() >= 1) ) { \
+                THROW_ERROR("option threads must be a positive number"); \
+            } \
+            NAME = (size_t) NAME ## _value.As<Napi::Number>().DoubleValue(); \
+        } \
+    }
+
+#define CRYPTO_AEAD_CHUNKS_DEF(ALGO) \
+    CRYPTO_AEAD_CHUNKS_KERNELS(ALGO) \
+    CRYPTO_AEAD_CHUNKS_METHODS(ALGO)
+
+// The chunk loops alone, which bench/native times without N-API
+#define CRYPTO_AEAD_CHUNKS_KERNELS(ALGO) \
+    static void aead_ ## ALGO ## _encrypt_chunks(unsigned char* c, const unsigned char* m, size_t m_size, \
+            size_t chunk_size, const unsigned char* ad, size_t ad_size, const unsigned char* npub, \
+            uint64_t first, const unsigned char* k, size_t threads, SodiumAsyncWorker* worker, \
+            std::atomic<bool>& stopped) { \
+        size_t count = m_size == 0 ? 1 : (m_size + chunk_size - 1) / chunk_size; \
+        sodium_batch_parallel(count, threads, aead_chunks_per_thread(chunk_size), [&](size_t begin, size_t end) { \
+            unsigned char nonce[crypto_aead_ ## ALGO ## _NPUBBYTES]; \
+            for(size_t i = begin; i < end && !stopped; i++) { \
+                if( worker != NULL && worker->Cancelled() ) { \
+                    stopped = true; \
+                    break; \
+                } \
+                size_t offset = i * chunk_size; \
+                size_t length = m_size - offset < chunk_size ? m_size - offset : chunk_size; \
+                aead_chunk_nonce(nonce, npub, sizeof(nonce), first + i); \
+                crypto_aead_ ## ALGO ## _encrypt(c + offset + i * crypto_aead_ ## ALGO ## _ABYTES, NULL, \
+                    m + offset, length, ad, ad_size, NULL, nonce, k); \
+            } \
+        }); \
+    } \
+    static void aead_ ## ALGO ## _decrypt_chunks(unsigned char* m, const unsigned char* c, size_t c_size, \
+            size_t chunk_size, const unsigned char* ad, size_t ad_size, const unsigned char* npub, \
+            uint64_t first, const unsigned char* k, size_t threads, SodiumAsyncWorker* worker, \
+            std::atomic<bool>& stopped) { \
+        size_t frame = chunk_size + crypto_aead_ ## ALGO ## _ABYTES; \
+        size_t count = c_size == 0 ? 1 : (c_size + frame - 1) / frame; \
+        sodium_batch_parallel(count, threads, aead_chunks_per_thread(chunk_size), [&](size_t begin, size_t end) { \
+            unsigned char nonce[crypto_aead_ ## ALGO ## _NPUBBYTES]; \
+            for(size_t i = begin; i < end && !stopped; i++) { \
+                if( worker != NULL && worker->Cancelled() ) { \
+                    stopped = true; \
+                    break; \
+                } \
+                size_t offset = i * frame; \
+                size_t length = c_size - offset < frame ? c_size - offset : frame; \
+                aead_chunk_nonce(nonce, npub, sizeof(nonce), first + i); \
+                if( crypto_aead_ ## ALGO ## _decrypt(m + i * chunk_size, NULL, NULL, c + offset, length, \
+                        ad, ad_size, nonce, k) != 0 ) { \
+                    stopped = true; \
+                } \
+            } \
+        }); \
+        if( stopped ) { \
+            sodium_memzero(m, c_size - count * crypto_aead_ ## ALGO ## _ABYTES); \
+        } \
+    }
+
+#define CRYPTO_AEAD_CHUNKS_METHODS(ALGO) \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_chunks) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments message, chunkSize, additionalData, nonce, firstIndex and key are required"); \
+        ARG_TO_UCHAR_BUFFER(m); \
+        ARG_TO_AEAD_CHUNK_ARGS(ALGO); \
+        size_t threads = 1; \
+        if( info.Length() > 6 && !info[6].IsUndefined() ) { \
+            ARG_TO_NUMBER(nthreads); \
+            threads = nthreads; \
+        } \
+        size_t count = m_size == 0 ? 1 : (m_size + chunkSize - 1) / chunkSize; \
+        NEW_BUFFER_AND_PTR(c, m_size + count * crypto_aead_ ## ALGO ## _ABYTES); \
+        std::atomic<bool> stopped(false); \
+        aead_ ## ALGO ## _encrypt_chunks(c_ptr, m, m_size, chunkSize, ad, ad_size, npub, firstIndex, k, \
+                                         threads, NULL, stopped); \
+        return c; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_chunks) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments cipherText, chunkSize, additionalData, nonce, firstIndex and key are required"); \
+        ARG_TO_UCHAR_BUFFER(c); \
+        ARG_TO_AEAD_CHUNK_ARGS(ALGO); \
+        size_t threads = 1; \
+        if( info.Length() > 6 && !info[6].IsUndefined() ) { \
+            ARG_TO_NUMBER(nthreads); \
+            threads = nthreads; \
+        } \
+        size_t frame = chunkSize + crypto_aead_ ## ALGO ## _ABYTES; \
+        size_t count = c_size == 0 ? 1 : (c_size + frame - 1) / frame; \
+        if( c_size - (count - 1) * frame < crypto_aead_ ## ALGO ## _ABYTES ) { \
+            THROW_ERROR("argument cipherText must hold whole chunks"); \
+        } \
+        NEW_BUFFER_AND_PTR(m, c_size - count * crypto_aead_ ## ALGO ## _ABYTES); \
+        std::atomic<bool> stopped(false); \
+        aead_ ## ALGO ## _decrypt_chunks(m_ptr, c, c_size, chunkSize, ad, ad_size, npub, firstIndex, k, \
+                                         threads, NULL, stopped); \
+        return stopped ? NAPI_NULL : m; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_chunks_async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments message, chunkSize, additionalData, nonce, firstIndex and key are required"); \
+        ARG_TO_UCHAR_BUFFER(m); \
+        ARG_TO_AEAD_CHUNK_ARGS(ALGO); \
+        size_t count = m_size == 0 ? 1 : (m_size + chunkSize - 1) / chunkSize; \
+        ARG_TO_AEAD_CHUNKS_OUT(c, m_size + count * crypto_aead_ ## ALGO ## _ABYTES); \
+        ARG_TO_AEAD_CHUNKS_THREADS(threads); \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_aead_" #ALGO "_encrypt_chunks"); \
+        unsigned char* out = worker->Pin(c); \
+        const unsigned char* in = worker->Pin(m_buffer); \
+        const unsigned char* a = ad != NULL ? worker->Copy(ad, ad_size) : NULL; \
+        const unsigned char* n = worker->Copy(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        const unsigned char* key = worker->Copy(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        size_t in_size = m_size, a_size = ad_size, chunk_size = chunkSize; \
+        uint64_t first = firstIndex; \
+        return worker->Start([=]() { \
+            std::atomic<bool> stopped(false); \
+            aead_ ## ALGO ## _encrypt_chunks(out, in, in_size, chunk_size, a, a_size, n, first, key, \
+                                             threads, worker, stopped); \
+            return stopped ? -1 : 0; \
+        }, ASYNC_RESULT_BUFFER); \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_chunks_async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments cipherText, chunkSize, additionalData, nonce, firstIndex and key are required"); \
+        ARG_TO_UCHAR_BUFFER(c); \
+        ARG_TO_AEAD_CHUNK_ARGS(ALGO); \
+        size_t frame = chunkSize + crypto_aead_ ## ALGO ## _ABYTES; \
+        size_t count = c_size == 0 ? 1 : (c_size + frame - 1) / frame; \
+        if( c_size - (count - 1) * frame < crypto_aead_ ## ALGO ## _ABYTES ) { \
+            THROW_ERROR("argument cipherText must hold whole chunks"); \
+        } \
+        ARG_TO_AEAD_CHUNKS_OUT(m, c_size - count * crypto_aead_ ## ALGO ## _ABYTES); \
+        ARG_TO_AEAD_CHUNKS_THREADS(threads); \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_aead_" #ALGO "_decrypt_chunks"); \
+        unsigned char* out = worker->Pin(m); \
+        const unsigned char* in = worker->Pin(c_buffer); \
+        const unsigned char* a = ad != NULL ? worker->Copy(ad, ad_size) : NULL; \
+        const unsigned char* n = worker->Copy(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        const unsigned char* key = worker->Copy(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        size_t in_size = c_size, a_size = ad_size, chunk_size = chunkSize; \
+        uint64_t first = firstIndex; \
+        return worker->Start([=]() { \
+            std::atomic<bool> stopped(false); \
+            aead_ ## ALGO ## _decrypt_chunks(out, in, in_size, chunk_size, a, a_size, n, first, key, \
+                                             threads, worker, stopped); \
+            return stopped ? -1 : 0; \
+        }, ASYNC_RESULT_BUFFER); \
+    }
+
+// Combined mode over unpadded base64url text. The cipher text is decoded
+// to scratch memory and opened straight into the returned Buffer, and
+// encrypted to scratch and encoded straight into the returned string
+#define CRYPTO_AEAD_BASE64URL_DEF(ALGO) \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_base64url) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments message, additional data, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER_RANGE(m); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        SodiumBase64url text; \
+        unsigned char* c = text.Reserve(m_size + crypto_aead_ ## ALGO ## _ABYTES); \
+        unsigned long long clen; \
+        if( SODIUM_STAT(aead_ ## ALGO, m_size, text.size, \
+                crypto_aead_ ## ALGO ## _encrypt (c, &clen, m, m_size, ad, ad_size, NULL, npub, k)) == 0 ) { \
+            return text.Encode(env); \
+        } \
+        return NAPI_NULL; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_base64url) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments cipher text string, additional data, nonce, and key"); \
+        if( !info[0].IsString() ) { \
+            THROW_ERROR("argument cipher text must be a base64url string"); \
+        } \
+        _arg++; \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(npub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(k, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        SodiumBase64url text; \
+        if( !text.Decode(env, info[0]) || text.size < crypto_aead_ ## ALGO ## _ABYTES ) { \
+            return NAPI_NULL; \
+        } \
+        NEW_BUFFER_AND_PTR(m, text.size - crypto_aead_ ## ALGO ## _ABYTES); \
+        unsigned long long mlen; \
+        if( SODIUM_STAT(aead_ ## ALGO, text.size, m.Length(), \
+                crypto_aead_ ## ALGO ## _decrypt (m_ptr, &mlen, NULL, text.data, text.size, ad, ad_size, npub, k)) == 0 ) { \
+            return m; \
+        } \
+        sodium_memzero(m_ptr, m.Length()); \
+        return NAPI_NULL; \
+    }
+
+/*
+ * Re-encryption, for key rotation. Each cipher text is opened with the old
+ * nonce and key into scratch `sodium_malloc` memory and sealed again with
+ * the new nonce and key, under the same additional data. The plain text
+ * never reaches a JavaScript Buffer, and the scratch memory is wiped when
+ * the call returns. Cipher texts keep their length.
+ *
+ * Batches are all or nothing, as for the batch interface.
+ */
+
+// Scratch memory for the plain text of one message at a time, wiped and
+// freed by sodium_free()
+class AeadScratch {
+public:
+    explicit AeadScratch(size_t size) : size(size) {
+        data = (unsigned char*) sodium_malloc(size > 0 ? size : 1);
+    }
+
+    ~AeadScratch() {
+        if( data != NULL ) {
+            sodium_free(data);
+        }
+    }
+
+    unsigned char* data;
+    size_t size;
+};
+
+#define CRYPTO_AEAD_REENCRYPT_DEF(ALGO) \
+    static int aead_ ## ALGO ## _reencrypt(unsigned char* out, unsigned char* m, const unsigned char* c, size_t c_size, \
+            const unsigned char* ad, size_t ad_size, const unsigned char* oldNpub, const unsigned char* oldK, \
+            const unsigned char* newNpub, const unsigned char* newK) { \
+        unsigned long long mlen; \
+        if( crypto_aead_ ## ALGO ## _decrypt (m, &mlen, NULL, c, c_size, ad, ad_size, oldNpub, oldK) != 0 ) { \
+            return -1; \
+        } \
+        return crypto_aead_ ## ALGO ## _encrypt (out, NULL, m, mlen, ad, ad_size, NULL, newNpub, newK); \
+    } \
+    static int aead_ ## ALGO ## _reencrypt_batch(unsigned char* out, const std::vector<SodiumSpan>& c, \
+            const std::vector<SodiumSpan>& ad, const std::vector<SodiumSpan>& oldNpub, const unsigned char* oldK, \
+            const std::vector<SodiumSpan>& newNpub, const unsigned char* newK) { \
+        size_t largest = 0; \
+        for(size_t i = 0; i < c.size(); i++) { \
+            if( c[i].size < crypto_aead_ ## ALGO ## _ABYTES ) { \
+                return -1; \
+            } \
+            largest = c[i].size > largest ? c[i].size : largest; \
+        } \
+        AeadScratch m(largest); \
+        if( m.data == NULL ) { \
+            return -1; \
+        } \
+        for(size_t i = 0; i < c.size(); i++) { \
+            if( SODIUM_STAT(aead_ ## ALGO, c[i].size, c[i].size, \
+                    aead_ ## ALGO ## _reencrypt(out, m.data, c[i].data, c[i].size, ad[i].data, ad[i].size, \
+                                                oldNpub[i].data, oldK, newNpub[i].data, newK)) != 0 ) { \
+                return -1; \
+            } \
+            out += c[i].size; \
+        } \
+        return 0; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _reencrypt) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments cipher text, additional data, old nonce, old key, new nonce and new key are required"); \
+        ARG_TO_UCHAR_BUFFER(c); \
+        ARG_TO_UCHAR_BUFFER_OR_NULL(ad); \
+        ARG_TO_UCHAR_BUFFER_LEN(oldNpub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(oldK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(newNpub, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(newK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        if( c_size < crypto_aead_ ## ALGO ## _ABYTES ) { \
+            return NAPI_NULL; \
+        } \
+        AeadScratch m(c_size); \
+        if( m.data == NULL ) { \
+            THROW_ERROR("could not allocate secure memory"); \
+        } \
+        NEW_BUFFER_AND_PTR(out, c_size); \
+        if( SODIUM_STAT(aead_ ## ALGO, c_size, c_size, \
+                aead_ ## ALGO ## _reencrypt(out_ptr, m.data, c, c_size, ad, ad_size, oldNpub, oldK, newNpub, newK)) != 0 ) { \
+            sodium_memzero(out_ptr, c_size); \
+            return NAPI_NULL; \
+        } \
+        return out; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _reencrypt_batch) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments cipher texts, additional data, old nonces, old key, new nonces and new key are required"); \
+        size_t count = SODIUM_BATCH_ANY; \
+        ARG_TO_BATCH(c, count); \
+        ARG_TO_BATCH_OR_NULL(ad, count); \
+        ARG_TO_BATCH_LEN(oldNpub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(oldK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        ARG_TO_BATCH_LEN(newNpub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(newK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        size_t total = 0; \
+        for(size_t i = 0; i < count; i++) { \
+            total += c[i].size; \
+        } \
+        NEW_BUFFER_AND_PTR(out, total); \
+        if( aead_ ## ALGO ## _reencrypt_batch(out_ptr, c, ad, oldNpub, oldK, newNpub, newK) != 0 ) { \
+            sodium_memzero(out_ptr, total); \
+            return NAPI_NULL; \
+        } \
+        return out; \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _reencrypt_batch_async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments cipher texts, additional data, old nonces, old key, new nonces and new key are required"); \
+        size_t count = SODIUM_BATCH_ANY; \
+        ARG_TO_BATCH(c, count); \
+        ARG_TO_BATCH_OR_NULL(ad, count); \
+        ARG_TO_BATCH_LEN(oldNpub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(oldK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        ARG_TO_BATCH_LEN(newNpub, count, crypto_aead_ ## ALGO ## _NPUBBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(newK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_aead_" #ALGO "_reencrypt_batch"); \
+        size_t total = 0; \
+        for(size_t i = 0; i < count; i++) { \
+            c[i].data = worker->Copy(c[i].data, c[i].size); \
+            ad[i].data = ad[i].data != NULL ? worker->Copy(ad[i].data, ad[i].size) : NULL; \
+            oldNpub[i].data = worker->Copy(oldNpub[i].data, oldNpub[i].size); \
+            newNpub[i].data = worker->Copy(newNpub[i].data, newNpub[i].size); \
+            total += c[i].size; \
+        } \
+        NEW_BUFFER_AND_PTR(out, total); \
+        unsigned char* o = worker->Pin(out); \
+        const unsigned char* ok = worker->Copy(oldK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        const unsigned char* nk = worker->Copy(newK, crypto_aead_ ## ALGO ## _KEYBYTES); \
+        return worker->Start([=]() { \
+            if( aead_ ## ALGO ## _reencrypt_batch(o, c, ad, oldNpub, ok, newNpub, nk) != 0 ) { \
+                sodium_memzero(o, total); \
+                return -1; \
+            } \
+            return 0; \
+        }, ASYNC_RESULT_BUFFER); \
+    }
+
+#define CRYPTO_AEAD_CHUNKS_EXPORT(ALGO) \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_chunks); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_chunks); \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_chunks_async); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_chunks_async)
+
 #define METHOD_AND_PROPS(ALGO) \
     EXPORT(crypto_aead_ ## ALGO ## _decrypt); \
     EXPORT(crypto_aead_ ## ALGO ## _decrypt_detached); \
     EXPORT(crypto_aead_ ## ALGO ## _encrypt); \
     EXPORT(crypto_aead_ ## ALGO ## _keygen); \
     EXPORT(crypto_aead_ ## ALGO ## _encrypt_detached); \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_into); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_into); \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_base64url); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_base64url); \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_detached_into); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_detached_into); \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_detached_inplace); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_detached_inplace); \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_batch); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_batch); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_each_async); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_each_stream); \
+    EXPORT(crypto_aead_ ## ALGO ## _reencrypt); \
+    EXPORT(crypto_aead_ ## ALGO ## _reencrypt_batch); \
+    EXPORT(crypto_aead_ ## ALGO ## _reencrypt_batch_async); \
     EXPORT(crypto_aead_ ## ALGO ## _abytes); \
     EXPORT(crypto_aead_ ## ALGO ## _keybytes); \
     EXPORT(crypto_aead_ ## ALGO ## _npubbytes); \
@@ -0,0 +1,47 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __CRYPTO_BOX_CACHE_H__
+#define __CRYPTO_BOX_CACHE_H__
+
+#include "node_sodium.h"
+
+#define BOX_CACHE_DISABLED 1
+
+/**
+ * Get the crypto_box shared key for (pk, sk) from the shared key cache,
+ * computing and caching it on a miss.
+ *
+ * Returns BOX_CACHE_DISABLED if the cache is off, otherwise the
+ * crypto_box_beforenm result: 0 with the key in `k`, -1 on failure.
+ */
+int box_cache_lookup(unsigned char* k, const unsigned char* pk, const unsigned char* sk);
+
+/**
+ * crypto_box_beforenm, through the shared memory segment when one is
+ * attached with crypto_box_cache_share.
+ */
+int box_cache_beforenm(unsigned char* k, const unsigned char* pk, const unsigned char* sk);
+
+/**
+ * Declare `int RC` and set it to AFTERNM_CALL, run with the cached shared key
+ * in `box_k`, or to FULL_CALL when the cache is disabled.
+ */
+#define BOX_CACHE_CALL(RC, PK, SK, AFTERNM_CALL, FULL_CALL) \
+    int RC; \
+    { \
+        unsigned char box_k[crypto_box_BEFORENMBYTES]; \
+        int box_status = box_cache_lookup(box_k, PK, SK); \
+        if( box_status == BOX_CACHE_DISABLED ) { \
+            RC = (FULL_CALL); \
+        } else { \
+            RC = box_status == 0 ? (AFTERNM_CALL) : -1; \
+            sodium_memzero(box_k, sizeof box_k); \
+        } \
+    }
+
+#endif
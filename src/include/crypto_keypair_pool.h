@@ -0,0 +1,36 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __CRYPTO_KEYPAIR_POOL_H__
+#define __CRYPTO_KEYPAIR_POOL_H__
+
+#include "node_sodium.h"
+
+enum KeypairPoolKind {
+    KEYPAIR_POOL_X25519,
+    KEYPAIR_POOL_ED25519
+};
+
+/**
+ * Take a pre-generated key pair of `kind` from the key pair pool, or generate
+ * one now when the pool is off or empty. X25519 pairs are the same as
+ * crypto_box_keypair and crypto_kx_keypair, Ed25519 pairs as
+ * crypto_sign_ed25519_keypair.
+ *
+ * Returns 0, or -1 if a key pair could not be generated.
+ */
+int keypair_pool_take(KeypairPoolKind kind, unsigned char* pk, unsigned char* sk);
+
+/**
+ * crypto_box_seal, with the ephemeral key pair taken from the pool.
+ * The output is the same as crypto_box_seal and opens with
+ * crypto_box_seal_open.
+ */
+int keypair_pool_box_seal(unsigned char* c, const unsigned char* m,
+                          unsigned long long mlen, const unsigned char* pk);
+
+#endif
@@ -12,6 +12,9 @@
 
 NAPI_METHOD(crypto_onetimeauth_poly1305);
 NAPI_METHOD(crypto_onetimeauth_poly1305_verify);
+NAPI_METHOD(crypto_onetimeauth_poly1305_verify_any);
+NAPI_METHOD(crypto_onetimeauth_poly1305_batch);
+NAPI_METHOD(crypto_onetimeauth_poly1305_verify_batch);
 NAPI_METHOD(crypto_onetimeauth_poly1305_init);
 NAPI_METHOD(crypto_onetimeauth_poly1305_update);
 NAPI_METHOD(crypto_onetimeauth_poly1305_final);
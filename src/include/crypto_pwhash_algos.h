@@ -8,6 +8,20 @@
 #ifndef __CRYPTO_PWHASH_ALGOS_H__
 #define __CRYPTO_PWHASH_ALGOS_H__
 
+#include <functional>
+
+#include "node_sodium_async.h"
+
+/**
+ * Run `hash` with the SMix lanes of scrypt parameters with p > 1, or the
+ * lanes of Argon2 parameters with p > 1, spread over up to `threads`
+ * threads, the calling one included. 0 picks p, up to the number of CPUs.
+ * See crypto_pwhash_algos.cc
+ */
+int pwhash_lanes(size_t threads, const std::function<int()>& hash);
+
+#define PWHASH_MAX_LANE_THREADS 64
+
 #define CRYPTO_PWHASH_DEF(ALGO) \
     NAPI_METHOD(crypto_pwhash_ ## ALGO) { \
         Napi::Env env = info.Env(); \
@@ -30,6 +44,31 @@
             return out; \
         } \
         return NAPI_NULL; \
+    } \
+    NAPI_METHOD(crypto_pwhash_ ## ALGO ## _async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(5, "arguments must be: output buffer, password buffer, salt buffer, oLimit, memLimit"); \
+        ARG_TO_NUMBER(outLen); \
+        ARG_TO_BUFFER_TYPE(passwd, char); \
+        ARG_TO_UCHAR_BUFFER_LEN(salt, crypto_pwhash_ ## ALGO ## _SALTBYTES); \
+        ARG_TO_NUMBER(oppLimit); \
+        ARG_TO_NUMBER(memLimit); \
+        if( outLen <= 0 ) { \
+            THROW_ERROR("output buffer length must be bigger than 0."); \
+        } \
+        if( passwd_size < crypto_pwhash_ ## ALGO ## _PASSWD_MIN ||  \
+            passwd_size > crypto_pwhash_ ## ALGO ## _PASSWD_MAX ) {  \
+            THROW_ERROR("password length should be at least sodium.crypto_pwhash_ ## ALGO ## _PASSWD_MIN " \
+                        "and at most sodium.crypto_pwhash_ ## ALGO ## _PASSWD_MAX."); \
+        } \
+        NEW_BUFFER_AND_PTR(out, outLen); \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_" #ALGO); \
+        unsigned char* o = worker->Pin(out); \
+        const char* p = (const char*) worker->Copy(passwd, passwd_size); \
+        const unsigned char* s = worker->Copy(salt, salt_size); \
+        return worker->StartPwhash([=]() { \
+            return crypto_pwhash_ ## ALGO (o, outLen, p, passwd_size, s, oppLimit, memLimit); \
+        }, ASYNC_RESULT_BUFFER); \
     }
 
 #define CRYPTO_PWHASH_DEF_EXT(ALGO) \
@@ -50,6 +89,27 @@
             return out; \
         } \
         return NAPI_NULL; \
+    } \
+    NAPI_METHOD(crypto_pwhash_ ## ALGO ## _async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments must be: output buffer, password buffer, salt buffer, oLimit, memLimit"); \
+        ARG_TO_NUMBER(outLen); \
+        ARG_TO_BUFFER_TYPE(passwd, char); \
+        ARG_TO_UCHAR_BUFFER_LEN(salt, crypto_pwhash_ ## ALGO ## _SALTBYTES); \
+        ARG_TO_NUMBER(oppLimit); \
+        ARG_TO_NUMBER(memLimit); \
+        ARG_TO_NUMBER(alg); \
+        if( outLen <= 0 ) { \
+            THROW_ERROR("output buffer length must be bigger than 0."); \
+        } \
+        NEW_BUFFER_AND_PTR(out, outLen); \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_" #ALGO); \
+        unsigned char* o = worker->Pin(out); \
+        const char* p = (const char*) worker->Copy(passwd, passwd_size); \
+        const unsigned char* s = worker->Copy(salt, salt_size); \
+        return worker->StartPwhash([=]() { \
+            return crypto_pwhash_ ## ALGO (o, outLen, p, passwd_size, s, oppLimit, memLimit, alg); \
+        }, ASYNC_RESULT_BUFFER); \
     }
 
 
@@ -76,6 +136,32 @@
         } \
         return NAPI_FALSE; \
     } \
+    NAPI_METHOD(crypto_pwhash_ ## ALGO ## _str_async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(3, "arguments must be: password buffer, oLimit, memLimit"); \
+        ARG_TO_BUFFER_TYPE(passwd, char); \
+        ARG_TO_NUMBER(oppLimit); \
+        ARG_TO_NUMBER(memLimit); \
+        NEW_BUFFER_AND_PTR(out, crypto_pwhash_ ## ALGO ## _STRBYTES); \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_" #ALGO "_str"); \
+        char* o = (char*) worker->Pin(out); \
+        const char* p = (const char*) worker->Copy(passwd, passwd_size); \
+        return worker->StartPwhash([=]() { \
+            return crypto_pwhash_ ## ALGO ## _str (o, p, passwd_size, oppLimit, memLimit); \
+        }, ASYNC_RESULT_BUFFER); \
+    } \
+    NAPI_METHOD(crypto_pwhash_ ## ALGO ## _str_verify_async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(2, "arguments must be: pwhash string, password"); \
+        ARG_TO_UCHAR_BUFFER_LEN(hash, crypto_pwhash_ ## ALGO ## _STRBYTES); \
+        ARG_TO_BUFFER_TYPE(passwd, char); \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_" #ALGO "_str_verify"); \
+        const char* h = (const char*) worker->Copy(hash, hash_size); \
+        const char* p = (const char*) worker->Copy(passwd, passwd_size); \
+        return worker->StartPwhash([=]() { \
+            return crypto_pwhash_ ## ALGO ## _str_verify(h, p, passwd_size); \
+        }, ASYNC_RESULT_BOOLEAN); \
+    } \
     NAPI_METHOD(crypto_pwhash_ ## ALGO ## _str_needs_rehash) { \
         Napi::Env env = info.Env(); \
         ARGS(2, "arguments must be: pwhash hash, oLimit, memLimit"); \
@@ -117,6 +203,33 @@
             return NAPI_TRUE; \
         } \
         return NAPI_FALSE; \
+    } \
+    NAPI_METHOD(crypto_pwhash_ ## ALGO ## _ll_async) { \
+        Napi::Env env = info.Env(); \
+        ARGS(6, "arguments must be: password buffer, salt buffer, N, r, p, output buffer"); \
+        ARG_TO_BUFFER_TYPE(passwd, uint8_t); \
+        ARG_TO_BUFFER_TYPE(salt, uint8_t); \
+        ARG_TO_NUMBER(N); \
+        ARG_TO_NUMBER(r); \
+        ARG_TO_NUMBER(p); \
+        ARG_TO_BUFFER_TYPE(out, uint8_t); \
+        size_t lanes = 0; \
+        if( info.Length() > 6 && !info[6].IsFunction() && !info[6].IsUndefined() && !sodium_async_is_options(info[6]) ) { \
+            GET_ARG_AS_NUMBER(6, threads); \
+            if( threads < 1 || threads > PWHASH_MAX_LANE_THREADS ) { \
+                THROW_ERROR("argument threads must be between 1 and 64"); \
+            } \
+            lanes = threads; \
+        } \
+        SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "crypto_pwhash_" #ALGO "_ll"); \
+        uint8_t* o = worker->Pin(out_buffer); \
+        const uint8_t* pw = worker->Copy(passwd, passwd_size); \
+        const uint8_t* s = worker->Copy(salt, salt_size); \
+        return worker->StartPwhash([=]() { \
+            return pwhash_lanes(lanes, [=]() { \
+                return crypto_pwhash_ ## ALGO ## _ll(pw, passwd_size, s, salt_size, N, r, p, o, out_size); \
+            }); \
+        }, ASYNC_RESULT_BOOLEAN); \
     }
 
     
@@ -126,6 +239,9 @@
     EXPORT(crypto_pwhash_ ## ALGO ## _str); \
     EXPORT(crypto_pwhash_ ## ALGO ## _str_verify); \
     EXPORT(crypto_pwhash_ ## ALGO ## _str_needs_rehash); \
+    EXPORT(crypto_pwhash_ ## ALGO ## _async); \
+    EXPORT(crypto_pwhash_ ## ALGO ## _str_async); \
+    EXPORT(crypto_pwhash_ ## ALGO ## _str_verify_async); \
     EXPORT(crypto_pwhash_ ## ALGO ## _bytes_max); \
     EXPORT(crypto_pwhash_ ## ALGO ## _bytes_min); \
     EXPORT(crypto_pwhash_ ## ALGO ## _opslimit_max); \
@@ -12,5 +12,9 @@
 
 NAPI_METHOD(crypto_scalarmult_curve25519);
 NAPI_METHOD(crypto_scalarmult_curve25519_base);
+NAPI_METHOD(crypto_scalarmult_curve25519_batch);
+NAPI_METHOD(crypto_scalarmult_curve25519_batch_async);
+NAPI_METHOD(crypto_scalarmult_curve25519_shared_key);
+NAPI_METHOD(crypto_scalarmult_curve25519_shared_key_batch);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,22 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __CRYPTO_SIGN_CURVE25519_CACHE_H__
+#define __CRYPTO_SIGN_CURVE25519_CACHE_H__
+
+#include "node_sodium.h"
+
+/**
+ * crypto_sign_ed25519_pk_to_curve25519, answered from the conversion cache
+ * when the same Ed25519 public key was converted recently. Only successful
+ * conversions are cached.
+ *
+ * Returns 0, or -1 if `ed25519_pk` is not a valid public key.
+ */
+int sign_curve25519_cache_pk(unsigned char* curve25519_pk, const unsigned char* ed25519_pk);
+
+#endif
@@ -12,13 +12,22 @@
 
 NAPI_METHOD(crypto_sign_ed25519);
 NAPI_METHOD(crypto_sign_ed25519_open);
+NAPI_METHOD(crypto_sign_ed25519_open_view);
+NAPI_METHOD(crypto_sign_ed25519_into);
+NAPI_METHOD(crypto_sign_ed25519_open_into);
 NAPI_METHOD(crypto_sign_ed25519_detached);
 NAPI_METHOD(crypto_sign_ed25519_verify_detached);
 NAPI_METHOD(crypto_sign_ed25519_keypair);
+NAPI_METHOD(crypto_sign_ed25519_keypair_packed);
 NAPI_METHOD(crypto_sign_ed25519_seed_keypair);
 NAPI_METHOD(crypto_sign_ed25519_pk_to_curve25519);
 NAPI_METHOD(crypto_sign_ed25519_sk_to_curve25519);
 NAPI_METHOD(crypto_sign_ed25519_sk_to_seed);
 NAPI_METHOD(crypto_sign_ed25519_sk_to_pk);
+NAPI_METHOD(crypto_sign_ed25519ph_init);
+NAPI_METHOD(crypto_sign_ed25519ph_update);
+NAPI_METHOD(crypto_sign_ed25519ph_final_create);
+NAPI_METHOD(crypto_sign_ed25519ph_final_verify);
+NAPI_METHOD(crypto_sign_ed25519ph_statebytes);
     
 #endif
\ No newline at end of file
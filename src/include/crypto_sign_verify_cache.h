@@ -0,0 +1,23 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __CRYPTO_SIGN_VERIFY_CACHE_H__
+#define __CRYPTO_SIGN_VERIFY_CACHE_H__
+
+#include "node_sodium.h"
+
+/**
+ * crypto_sign_ed25519_verify_detached, answered from the verification cache
+ * when the same (signature, message, public key) was accepted recently.
+ * Accepted triples are added to the cache; rejected ones never are.
+ *
+ * Returns 0 if the signature is valid, -1 otherwise.
+ */
+int sign_verify_cache_verify(const unsigned char* sig, const unsigned char* m,
+                             unsigned long long mlen, const unsigned char* pk);
+
+#endif
@@ -8,6 +8,45 @@
 #ifndef __CRYPTO_STREAMS_H__
 #define __CRYPTO_STREAMS_H__
 
+#include <cmath>
+#include <limits>
+
+#include "node_sodium_batch.h"
+
+/**
+ * XOR `mlen` bytes of `m` with the key stream starting at byte `position`,
+ * which need not be block aligned. The aligned part is split into slices of
+ * whole 64 byte blocks, each started at its own block counter with `xor_ic`,
+ * and run on up to `threads` threads.
+ */
+template <typename IC, typename XorIc>
+inline void stream_xor_seek(XorIc xor_ic, unsigned char* c, const unsigned char* m, size_t mlen,
+                            const unsigned char* n, uint64_t position, const unsigned char* k,
+                            size_t threads) {
+    uint64_t block = position / 64;
+    size_t skip = (size_t) (position % 64);
+    size_t head = 0;
+
+    if( skip != 0 && mlen != 0 ) {
+        unsigned char ks[64];
+        memset(ks, 0, sizeof ks);
+        xor_ic(ks, ks, sizeof ks, n, (IC) block, k);
+        head = 64 - skip < mlen ? 64 - skip : mlen;
+        for(size_t i = 0; i < head; i++) {
+            c[i] = m[i] ^ ks[skip + i];
+        }
+        sodium_memzero(ks, sizeof ks);
+        block++;
+    }
+
+    size_t blocks = (mlen - head + 63) / 64;
+    sodium_batch_parallel(blocks, threads, 1024, [&](size_t begin, size_t end) {
+        size_t from = head + begin * 64;
+        size_t to = head + end * 64 < mlen ? head + end * 64 : mlen;
+        xor_ic(c + from, m + from, to - from, n, (IC) (block + begin), k);
+    });
+}
+
 #define CRYPTO_STREAM_DEF(ALGO) \
     NAPI_METHOD(crypto_stream_##ALGO) { \
         Napi::Env env = info.Env(); \
@@ -33,28 +72,92 @@
         } \
         return NAPI_NULL; \
     } \
+    NAPI_METHOD(crypto_stream_ ## ALGO ## _xor_inplace) { \
+        Napi::Env env = info.Env(); \
+        ARGS(3, "arguments message, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER_RANGE(message); \
+        ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_stream_ ## ALGO ## _NONCEBYTES); \
+        ARG_TO_UCHAR_BUFFER_LEN(key, crypto_stream_ ## ALGO ## _KEYBYTES); \
+        if (crypto_stream_ ## ALGO ## _xor(message, message, message_size, nonce, key) == 0) { \
+            return message_buffer; \
+        } \
+        return NAPI_NULL; \
+    } \
     NAPI_METHOD_FROM_INT(crypto_stream_ ## ALGO ## _keybytes); \
     NAPI_METHOD_FROM_INT(crypto_stream_ ## ALGO ## _noncebytes)
 
-#define CRYPTO_STREAM_DEF_IC(ALGO) \
+// Initial block counter, checked against the algorithm's counter type IC
+#define ARG_TO_STREAM_COUNTER(NAME, IC) \
+    uint64_t NAME = 0; \
+    if( !SODIUM_ARG_IS_INTEGER(info[_arg]) ) { \
+        THROW_ERROR("argument " #NAME " must be a number"); \
+    } \
+    if( !sodium_arg_uint64(info[_arg], #NAME, std::numeric_limits<IC>::max(), NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+#define CRYPTO_STREAM_DEF_IC(ALGO, IC) \
     NAPI_METHOD(crypto_stream_ ## ALGO ## _xor_ic) { \
         Napi::Env env = info.Env(); \
         ARGS(4, "arguments message, nonce, and key must be buffers"); \
         ARG_TO_UCHAR_BUFFER(message); \
         ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_stream_ ## ALGO ## _NONCEBYTES); \
-        ARG_TO_NUMBER(ic); \
+        ARG_TO_STREAM_COUNTER(ic, IC); \
         ARG_TO_UCHAR_BUFFER_LEN(key, crypto_stream_ ## ALGO ## _KEYBYTES); \
         NEW_BUFFER_AND_PTR(ctxt, message_size); \
         if (crypto_stream_ ## ALGO ## _xor_ic(ctxt_ptr, message, message_size, nonce, ic, key) == 0) { \
             return ctxt; \
         } \
         return NAPI_NULL; \
-    } 
+    } \
+    NAPI_METHOD(crypto_stream_ ## ALGO ## _xor_ic_inplace) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments message, nonce, and key must be buffers"); \
+        ARG_TO_UCHAR_BUFFER_RANGE(message); \
+        ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_stream_ ## ALGO ## _NONCEBYTES); \
+        ARG_TO_STREAM_COUNTER(ic, IC); \
+        ARG_TO_UCHAR_BUFFER_LEN(key, crypto_stream_ ## ALGO ## _KEYBYTES); \
+        if (crypto_stream_ ## ALGO ## _xor_ic(message, message, message_size, nonce, ic, key) == 0) { \
+            return message_buffer; \
+        } \
+        return NAPI_NULL; \
+    }
+
 
+#define CRYPTO_STREAM_DEF_SEEK(ALGO, IC) \
+    NAPI_METHOD(crypto_stream_ ## ALGO ## _xor_parallel) { \
+        Napi::Env env = info.Env(); \
+        ARGS(4, "arguments message, nonce, position and key are required"); \
+        ARG_TO_UCHAR_BUFFER_RANGE(message); \
+        ARG_TO_UCHAR_BUFFER_LEN(nonce, crypto_stream_ ## ALGO ## _NONCEBYTES); \
+        if( !info[_arg].IsNumber() ) { \
+            THROW_ERROR("argument position must be a number"); \
+        } \
+        double position = info[_arg].As<Napi::Number>().DoubleValue(); \
+        _arg++; \
+        if( !(position >= 0) || position > 9007199254740991.0 || std::floor(position) != position ) { \
+            THROW_ERROR("argument position must be an integer between 0 and 2^53 - 1"); \
+        } \
+        if( (position + (double) message_size) / 64 > (double) std::numeric_limits<IC>::max() + 1 ) { \
+            THROW_ERROR("message runs past the end of the crypto_stream_" #ALGO " key stream"); \
+        } \
+        ARG_TO_UCHAR_BUFFER_LEN(key, crypto_stream_ ## ALGO ## _KEYBYTES); \
+        size_t threads = 1; \
+        if( info.Length() > (size_t) _arg && !info[_arg].IsUndefined() ) { \
+            ARG_TO_NUMBER(nthreads); \
+            threads = nthreads; \
+        } \
+        NEW_BUFFER_AND_PTR(ctxt, message_size); \
+        stream_xor_seek<IC>(crypto_stream_ ## ALGO ## _xor_ic, ctxt_ptr, message, message_size, \
+                            nonce, (uint64_t) position, key, threads); \
+        return ctxt; \
+    }
 
 #define METHODS(ALGO) \
     EXPORT(crypto_stream_ ## ALGO); \
     EXPORT(crypto_stream_ ## ALGO ## _xor); \
+    EXPORT(crypto_stream_ ## ALGO ## _xor_inplace); \
     EXPORT(crypto_stream_ ## ALGO ## _keybytes); \
     EXPORT(crypto_stream_ ## ALGO ## _noncebytes)
 
@@ -64,7 +167,8 @@
 
 #define NAPI_PROTOTYPES(ALGO) \
     NAPI_METHOD(crypto_stream_ ## ALGO); \
-    NAPI_METHOD(crypto_stream_ ## ALGO ## _xor);
+    NAPI_METHOD(crypto_stream_ ## ALGO ## _xor); \
+    NAPI_METHOD(crypto_stream_ ## ALGO ## _xor_inplace);
 
 
 NAPI_PROTOTYPES(xsalsa20);
@@ -73,6 +177,7 @@ NAPI_PROTOTYPES(salsa208);
 NAPI_PROTOTYPES(salsa2012);
 NAPI_PROTOTYPES(chacha20);
 NAPI_PROTOTYPES(chacha20_ietf);
+NAPI_PROTOTYPES(xchacha20);
 
 
 #endif
\ No newline at end of file
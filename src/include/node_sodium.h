@@ -8,49 +8,339 @@
 #ifndef __NODE_SODIUM_H__
 #define __NODE_SODIUM_H__
 
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
 #include <napi.h>
 #include "sodium.h"
 
 // As per Libsodium install docs
 #define SODIUM_STATIC
 
-// Check if a function argument is a node Buffer. If not throw V8 exception
+/**
+ * Point `data` and `size` at the bytes of a Buffer, any other TypedArray, a
+ * DataView or an ArrayBuffer, without copying. Views keep their offset into
+ * the underlying memory, so Uint8Arrays over WebAssembly memory or a
+ * SharedArrayBuffer are read and written in place.
+ *
+ * Returns false if `value` is none of those.
+ */
+inline bool sodium_arg_bytes(napi_env env, napi_value value, void** data, size_t* size) {
+    bool is = false;
+
+    if( napi_is_buffer(env, value, &is) == napi_ok && is ) {
+        return napi_get_buffer_info(env, value, data, size) == napi_ok;
+    }
+    if( napi_is_typedarray(env, value, &is) == napi_ok && is ) {
+        napi_typedarray_type type;
+        size_t length;
+        if( napi_get_typedarray_info(env, value, &type, &length, data, NULL, NULL) != napi_ok ) {
+            return false;
+        }
+        switch( type ) {
+            case napi_int8_array:
+            case napi_uint8_array:
+            case napi_uint8_clamped_array:
+                *size = length;
+                break;
+            case napi_int16_array:
+            case napi_uint16_array:
+                *size = length * 2;
+                break;
+            case napi_int32_array:
+            case napi_uint32_array:
+            case napi_float32_array:
+                *size = length * 4;
+                break;
+            default:
+                *size = length * 8;
+                break;
+        }
+        return true;
+    }
+    if( napi_is_dataview(env, value, &is) == napi_ok && is ) {
+        return napi_get_dataview_info(env, value, size, data, NULL, NULL) == napi_ok;
+    }
+    if( napi_is_arraybuffer(env, value, &is) == napi_ok && is ) {
+        return napi_get_arraybuffer_info(env, value, data, size) == napi_ok;
+    }
+    return false;
+}
+
+inline bool sodium_arg_bytes(Napi::Value value, unsigned char*& data, size_t& size) {
+    void* ptr = NULL;
+    size_t length = 0;
+    if( !sodium_arg_bytes(value.Env(), value, &ptr, &length) ) {
+        return false;
+    }
+    data = (unsigned char*) ptr;
+    size = length;
+    return true;
+}
+
+inline bool sodium_arg_is_bytes(Napi::Value value) {
+    return value.IsBuffer() || value.IsTypedArray() || value.IsDataView() || value.IsArrayBuffer();
+}
+
+// Check if a function argument is a Buffer or other byte view. If not throw V8 exception
 #define ARG_IS_BUFFER(i, MSG) \
-    if (!info[i].IsBuffer()) { \
+    if (!sodium_arg_is_bytes(info[i])) { \
         THROW_ERROR("argument " #MSG " must be a buffer"); \
     }
 
 #define ARG_IS_BUFFER_OR_NULL(i, MSG) \
-    if (!info[i].IsBuffer()) { \
+    if (!sodium_arg_is_bytes(info[i])) { \
         if( !info[i].IsNull() ) { \
             THROW_ERROR("argument " #MSG " must be a buffer"); \
         } \
     }
 
+/**
+ * New output Buffer of `size` bytes. While an Arena is entered, it is a view
+ * on the arena. While `sodium_pool_enable` is on, small sizes are views on a
+ * shared slab instead of their own allocation. See sodium_pool.cc and
+ * sodium_arena.cc
+ */
+Napi::Buffer<unsigned char> sodium_new_buffer(Napi::Env env, size_t size);
+
+/**
+ * Largest plain text decrypted to scratch memory before it is authenticated
+ */
+#define SODIUM_SCRATCH_MAX (64 * 1024)
+
+/**
+ * Scratch block of `size` bytes for the calling thread, or NULL when `size`
+ * is over SODIUM_SCRATCH_MAX. The block is reused by the next call, so wipe
+ * what was written to it. See helpers.cc
+ */
+unsigned char* sodium_scratch(size_t size);
+
+/**
+ * Name of the kernel libsodium picked for a primitive of
+ * `sodium_implementation_report()`, such as "pwhash_argon2", or NULL.
+ * See sodium_runtime.cc
+ */
+const char* sodium_implementation_selected(const char* primitive);
+
+// Decrypt SIZE bytes with CALL, which writes to NAME ## _ptr, and return a
+// Buffer holding them when CALL returns 0, or null. Messages up to
+// SODIUM_SCRATCH_MAX bytes are decrypted to scratch memory and copied out
+// only once authenticated, so forged ones never allocate a Buffer
+#define RETURN_DECRYPTED(NAME, SIZE, CALL) \
+    { \
+        size_t NAME ## _size = (SIZE); \
+        unsigned char* NAME ## _ptr = sodium_scratch(NAME ## _size); \
+        Napi::Buffer<unsigned char> NAME; \
+        if( NAME ## _ptr == NULL ) { \
+            NAME = sodium_new_buffer(env, NAME ## _size); \
+            NAME ## _ptr = NAME.Data(); \
+            if( (CALL) != 0 ) { \
+                return NAPI_NULL; \
+            } \
+            return NAME; \
+        } \
+        int NAME ## _rc = (CALL); \
+        if( NAME ## _rc == 0 ) { \
+            NAME = sodium_new_buffer(env, NAME ## _size); \
+            memcpy(NAME.Data(), NAME ## _ptr, NAME ## _size); \
+        } \
+        sodium_memzero(NAME ## _ptr, NAME ## _size); \
+        if( NAME ## _rc != 0 ) { \
+            return NAPI_NULL; \
+        } \
+        return NAME; \
+    }
+
+/**
+ * Encodings a short result can be returned in instead of a Buffer
+ */
+enum SodiumEncoding {
+    SODIUM_ENCODING_NONE = 0,
+    SODIUM_ENCODING_HEX,
+    SODIUM_ENCODING_BASE64,     // padded, like Buffer's 'base64'
+    SODIUM_ENCODING_BASE64URL   // URL safe, unpadded, like Buffer's 'base64url'
+};
+
+// Largest result returned encoded: digests, MAC tags and signatures
+#define SODIUM_ENCODED_MAX 64
+
+/**
+ * Read the optional output encoding at `info[i]`: undefined for a Buffer,
+ * or "hex", "base64" or "base64url". Throws and returns false on anything
+ * else. See helpers.cc
+ */
+bool sodium_arg_encoding(const Napi::CallbackInfo& info, size_t i, SodiumEncoding& encoding);
+
+/**
+ * `size` bytes, at most SODIUM_ENCODED_MAX, as a string in `encoding`,
+ * encoded with sodium_bin2hex or sodium_bin2base64. See helpers.cc
+ */
+Napi::Value sodium_encode(Napi::Env env, const unsigned char* data, size_t size, SodiumEncoding encoding);
+
+// Result of at most SODIUM_ENCODED_MAX bytes: a new Buffer, or with an
+// ENCODING a stack block that OUTPUT_VALUE returns encoded, so no Buffer is
+// made at all
+#define NEW_OUTPUT_AND_PTR(NAME, SIZE, ENCODING) \
+    unsigned char NAME ## _encoded[SODIUM_ENCODED_MAX]; \
+    Napi::Buffer<unsigned char> NAME; \
+    unsigned char* NAME ## _ptr = NAME ## _encoded; \
+    if( (ENCODING) == SODIUM_ENCODING_NONE ) { \
+        NAME = sodium_new_buffer(info.Env(), SIZE); \
+        NAME ## _ptr = NAME.Data(); \
+    }
+
+#define OUTPUT_VALUE(NAME, SIZE, ENCODING) \
+    ((ENCODING) == SODIUM_ENCODING_NONE ? (Napi::Value) NAME : \
+        sodium_encode(info.Env(), NAME ## _ptr, SIZE, ENCODING))
+
 // Create a new buffer, and get a pointer to it
 #define NEW_BUFFER_AND_PTR(NAME, size) \
-    Napi::Buffer<unsigned char> NAME = Napi::Buffer<unsigned char>::New(info.Env(), size); \
+    Napi::Buffer<unsigned char> NAME = sodium_new_buffer(info.Env(), size); \
     unsigned char* NAME ## _ptr = (unsigned char*) NAME.Data(); \
     if( *NAME ## _ptr == 0 ) { }
 
+// Read a byte argument in place. NAME ## _buffer is the JS object itself, for
+// async bindings that must keep it alive
 #define GET_ARG_AS(i, NAME, TYPE) \
-    ARG_IS_BUFFER(i,#NAME); \
-    Napi::Buffer<TYPE> NAME ## _buffer = info[i].As<Napi::Buffer<TYPE>>(); \
-    TYPE *NAME = (TYPE *) NAME ## _buffer.Data(); \
-    unsigned long long NAME ## _size = NAME ## _buffer.Length(); \
+    TYPE *NAME = NULL; \
+    unsigned long long NAME ## _size = 0; \
+    { \
+        void* NAME ## _data = NULL; \
+        size_t NAME ## _length = 0; \
+        if( !sodium_arg_bytes(info.Env(), info[i], &NAME ## _data, &NAME ## _length) ) { \
+            THROW_ERROR("argument \"" #NAME "\" must be a buffer"); \
+        } \
+        NAME = (TYPE *) NAME ## _data; \
+        NAME ## _size = NAME ## _length; \
+    } \
+    Napi::Object NAME ## _buffer = info[i].As<Napi::Object>(); \
     if( NAME ## _size == 0 ) { }
 
 #define GET_ARG_AS_OR_NULL(i, NAME, TYPE) \
-    TYPE *NAME; \
+    TYPE *NAME = NULL; \
     unsigned long long NAME ## _size = 0; \
     if( !info[i].IsNull() ) { \
-        ARG_IS_BUFFER(i,#NAME); \
-        Napi::Buffer<TYPE> NAME ## _buffer = info[i].As<Napi::Buffer<TYPE>>(); \
-        NAME = (TYPE *) NAME ## _buffer.Data(); \
-        NAME ## _size = NAME ## _buffer.Length(); \
-        if( NAME ## _size == 0 ) { } \
+        void* NAME ## _data = NULL; \
+        size_t NAME ## _length = 0; \
+        if( !sodium_arg_bytes(info.Env(), info[i], &NAME ## _data, &NAME ## _length) ) { \
+            THROW_ERROR("argument \"" #NAME "\" must be a buffer"); \
+        } \
+        NAME = (TYPE *) NAME ## _data; \
+        NAME ## _size = NAME ## _length; \
+    }
+
+/**
+ * The UTF-8 bytes of a string argument, encoded without a Buffer: on the
+ * stack when short, and in a block of its own past that, so several strings
+ * and the scratch block can be in use at once. Heap bytes are wiped when the
+ * object goes away.
+ */
+class SodiumStringBytes {
+  public:
+    SodiumStringBytes() : data(NULL), size(0) {}
+    SodiumStringBytes(const SodiumStringBytes&) = delete;
+    SodiumStringBytes& operator=(const SodiumStringBytes&) = delete;
+
+    ~SodiumStringBytes() {
+        if( !heap.empty() ) {
+            sodium_memzero(heap.data(), heap.size());
+        }
+    }
+
+    // Encode `value`, which must be a string
+    bool Set(napi_env env, napi_value value) {
+        size_t length = 0;
+        if( napi_get_value_string_utf8(env, value, (char*) stack, sizeof stack, &length) != napi_ok ) {
+            return false;
+        }
+        // Only whole characters are written, so a cut short string can come
+        // back up to 3 bytes shorter than the room left for it
+        if( length < sizeof stack - 4 ) {
+            data = stack;
+            size = length;
+            return true;
+        }
+
+        // Possibly cut short: measure, then encode again where it fits
+        if( napi_get_value_string_utf8(env, value, NULL, 0, &length) != napi_ok ) {
+            return false;
+        }
+        heap.resize(length + 1);
+        data = heap.data();
+        size = length;
+        return napi_get_value_string_utf8(env, value, (char*) data, length + 1, &length) == napi_ok;
+    }
+
+    unsigned char* data;
+    size_t size;
+
+  private:
+    unsigned char stack[256];
+    std::vector<unsigned char> heap;
+};
+
+/**
+ * Bytes carried as unpadded base64url text, the way tokens and cookies
+ * travel. The binary form and its text share one block of scratch memory,
+ * or of `heap` when larger, so neither costs a JS allocation:
+ *
+ *     SodiumBase64url text;
+ *     if( !text.Decode(env, info[0]) ) ...  // text.data, text.size
+ *
+ *     unsigned char* c = text.Reserve(c_size);  // fill c, then
+ *     return text.Encode(env);
+ *
+ * Only one may be in use at a time, and not with anything else in scratch.
+ * See helpers.cc
+ */
+class SodiumBase64url {
+  public:
+    SodiumBase64url() : data(NULL), size(0), block(NULL), room(0) {}
+    SodiumBase64url(const SodiumBase64url&) = delete;
+    SodiumBase64url& operator=(const SodiumBase64url&) = delete;
+
+    // Decode the string `value`. False when it is not valid base64url
+    bool Decode(napi_env env, napi_value value);
+
+    // Room for `length` bytes to encode
+    unsigned char* Reserve(size_t length);
+
+    // The reserved bytes as a string
+    Napi::Value Encode(Napi::Env env);
+
+    unsigned char* data;
+    size_t size;
+
+  private:
+    unsigned char* Block(size_t length);
+
+    unsigned char* block;
+    size_t room;
+    std::vector<unsigned char> heap;
+};
+
+// A byte argument that may also be a string, read as its UTF-8 bytes. No
+// NAME ## _buffer is defined, the argument may not be an object
+#define GET_ARG_AS_OR_STRING(i, NAME, TYPE) \
+    SodiumStringBytes NAME ## _string; \
+    TYPE *NAME = NULL; \
+    unsigned long long NAME ## _size = 0; \
+    if( info[i].IsString() ) { \
+        if( !NAME ## _string.Set(info.Env(), info[i]) ) { \
+            THROW_ERROR("argument \"" #NAME "\" cannot be read as UTF-8"); \
+        } \
+        NAME = (TYPE *) NAME ## _string.data; \
+        NAME ## _size = NAME ## _string.size; \
     } else { \
-        NAME = NULL; \
+        void* NAME ## _data = NULL; \
+        size_t NAME ## _length = 0; \
+        if( !sodium_arg_bytes(info.Env(), info[i], &NAME ## _data, &NAME ## _length) ) { \
+            THROW_ERROR("argument \"" #NAME "\" must be a buffer or a string"); \
+        } \
+        NAME = (TYPE *) NAME ## _data; \
+        NAME ## _size = NAME ## _length; \
     }
 
 #define GET_ARG_AS_LEN(i, NAME, MAXLEN, TYPE) \
@@ -59,12 +349,70 @@
         THROW_ERROR("argument " #NAME " must be " #MAXLEN " bytes long, but got a different value"); \
     }
 
+/**
+ * Report an argument error. Throws an Error, or in fast fail mode (see
+ * sodium_fast_fail) keeps the message for sodium_last_error and throws
+ * nothing. Either way the binding then returns null.
+ */
+void sodium_throw(Napi::Env env, const std::string& msg);
+
+// sodium_throw for values out of range: the same, with a RangeError
+void sodium_throw_range(Napi::Env env, const std::string& msg);
+
+// True, with msg kept for sodium_last_error, if errors must not throw
+bool sodium_fail_quietly(Napi::Env env, const std::string& msg);
+
+// Largest integer a JS Number holds exactly
+#define SODIUM_MAX_SAFE_INTEGER 9007199254740991.0
+
+/**
+ * Read a Number or BigInt argument as a 64 bit unsigned integer. Numbers
+ * have their fraction dropped; BigInts are exact, so values past 2^53 such
+ * as a `memLimit` of `8n << 30n` can be given as they are.
+ *
+ * On a negative value, or one above `max`, a RangeError is thrown, or kept
+ * in fast fail mode, and false is returned. `value` must already be known to be a Number or a BigInt.
+ */
+inline bool sodium_arg_uint64(Napi::Value value, const char* name, uint64_t max, uint64_t& result) {
+    bool in_range = true;
+
+    if( value.IsNumber() ) {
+        double number = value.As<Napi::Number>().DoubleValue();
+        in_range = number >= 0 && number < 18446744073709551616.0;
+        result = in_range ? (uint64_t) number : 0;
+    }
+#if NAPI_VERSION > 5
+    else if( napi_get_value_bigint_uint64(value.Env(), value, &result, &in_range) != napi_ok ) {
+        in_range = false;
+    }
+#endif
+
+    if( !in_range || result > max ) {
+        sodium_throw_range(value.Env(), std::string("argument ") + name + " is out of range");
+        return false;
+    }
+    return true;
+}
+
+#if NAPI_VERSION > 5
+#define SODIUM_ARG_IS_INTEGER(V)    ((V).IsNumber() || (V).IsBigInt())
+#else
+#define SODIUM_ARG_IS_INTEGER(V)    ((V).IsNumber())
+#endif
+
+// size_t number argument. Accepts BigInts so lengths and memory limits are
+// not cut to 32 bits
 #define GET_ARG_AS_NUMBER(i, NAME) \
     size_t NAME; \
-    if (info[i].IsNumber()) { \
-        NAME = info[i].As<Napi::Number>().Uint32Value(); \
-    } else { \
-        THROW_ERROR("argument " #NAME " must be a number"); \
+    { \
+        uint64_t NAME ## _value = 0; \
+        if( !SODIUM_ARG_IS_INTEGER(info[i]) ) { \
+            THROW_ERROR("argument " #NAME " must be a number"); \
+        } \
+        if( !sodium_arg_uint64(info[i], #NAME, SIZE_MAX, NAME ## _value) ) { \
+            return NAPI_NULL; \
+        } \
+        NAME = (size_t) NAME ## _value; \
     }
 
 #define GET_ARG_AS_STRING(i, NAME) \
@@ -84,6 +432,64 @@
 #define ARG_TO_UCHAR_BUFFER(NAME)                   GET_ARG_AS(_arg, NAME, unsigned char); _arg++
 #define ARG_TO_UCHAR_BUFFER_LEN(NAME, MAXLEN)       GET_ARG_AS_LEN(_arg, NAME, MAXLEN, unsigned char); _arg++
 #define ARG_TO_UCHAR_BUFFER_OR_NULL(NAME)           GET_ARG_AS_OR_NULL(_arg, NAME, unsigned char); _arg++
+#define ARG_TO_UCHAR_BUFFER_OR_STRING(NAME)         GET_ARG_AS_OR_STRING(_arg, NAME, unsigned char); _arg++
+#define ARG_TO_ENCODING(NAME) \
+    SodiumEncoding NAME = SODIUM_ENCODING_NONE; \
+    if( !sodium_arg_encoding(info, _arg, NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+/**
+ * Read the optional `offset` and `length` numbers that may follow a byte
+ * argument, starting at `info[arg]`. `arg` is moved past the numbers found.
+ * With no numbers the whole argument is used; with only an offset the range
+ * runs to its end.
+ *
+ * On a bad range a RangeError is thrown, or kept in fast fail mode, and
+ * false is returned.
+ */
+inline bool sodium_arg_range(const Napi::CallbackInfo& info, int& arg,
+                             unsigned long long& size, size_t& offset) {
+    unsigned long long length = size;
+    offset = 0;
+
+    for(int i = 0; i < 2 && (size_t) arg < info.Length() && info[arg].IsNumber(); i++, arg++) {
+        double value = info[arg].As<Napi::Number>().DoubleValue();
+        if( !(value >= 0) || value > 9007199254740991.0 ||
+            value != (double) (unsigned long long) value ) {
+            sodium_throw_range(info.Env(), "offset and length must be positive integers");
+            return false;
+        }
+        if( i == 0 ) {
+            offset = (size_t) value;
+            length = offset <= size ? size - offset : 0;
+        } else {
+            length = (unsigned long long) value;
+        }
+    }
+
+    if( offset > size || length > size - offset ) {
+        sodium_throw_range(info.Env(), "offset and length are out of the argument's bounds");
+        return false;
+    }
+    size = length;
+    return true;
+}
+
+// Byte argument optionally followed by `offset` and `length`, so callers
+// parsing one big receive buffer can pass `(frame, offset, length)` instead
+// of `frame.subarray(...)`. Only use it for arguments that are not followed
+// by a number argument of their own.
+#define ARG_TO_UCHAR_BUFFER_RANGE(NAME) \
+    ARG_TO_UCHAR_BUFFER(NAME); \
+    { \
+        size_t NAME ## _offset = 0; \
+        if( !sodium_arg_range(info, _arg, NAME ## _size, NAME ## _offset) ) { \
+            return NAPI_NULL; \
+        } \
+        NAME += NAME ## _offset; \
+    }
 
 #define ARG_TO_UCHAR_BUFFER_LEN_OR_NULL(NAME, MAXLEN) \
     GET_ARG_AS_OR_NULL(_arg, NAME, unsigned char); \
@@ -103,6 +509,12 @@
         THROW_ERROR(#NAME " length cannot be smaller than " #MIN_SIZE " bytes"); \
     }
 
+// Check that NAME has room for NEEDED bytes starting at OFFSET
+#define CHECK_OUTPUT_SPACE(NAME, OFFSET, NEEDED) \
+    if( (OFFSET) > NAME ## _size || NAME ## _size - (OFFSET) < (NEEDED) ) { \
+        THROW_ERROR("argument " #NAME " is too small to hold the result at the given offset"); \
+    }
+
 #define CHECK_SIZE(NAME, MIN_SIZE, MAX_SIZE) \
     CHECK_MIN_SIZE(NAME, MIN_SIZE); \
     CHECK_MAX_SIZE(NAME, MAX_SIZE)
@@ -173,7 +585,7 @@
     }
 
 #define THROW_ERROR(msg) \
-    Napi::Error::New(env, (msg)).ThrowAsJavaScriptException(); \
+    sodium_throw(env, (msg)); \
     return NAPI_NULL; \
 
 
@@ -0,0 +1,251 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __NODE_SODIUM_ARGS_H__
+#define __NODE_SODIUM_ARGS_H__
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+
+/**
+ * Typed argument extraction for bindings written as templates
+ *
+ * Each ARG_TO_* macro expands to its own copy of the checks and error
+ * strings in every binding. SodiumArgs keeps the checks inline and builds
+ * the errors out of line, in sodium_args.cc, and sizes are template
+ * arguments so the length compares are against constants.
+ *
+ * Arguments are read in order. After the first failure the error has been
+ * thrown, or kept in fast fail mode, and every later read fails at once, so
+ * reads can be chained:
+ *
+ *     SodiumArgs args(info, 2, "arguments message, and key must be buffers");
+ *     SodiumBytes msg, key;
+ *     if( !args.Bytes(msg, "msg") || !args.Bytes<KEYBYTES>(key, "key") ) {
+ *         return args.Failed();
+ *     }
+ */
+struct SodiumBytes {
+    unsigned char* data;
+    size_t size;
+
+    // The JS object, for async bindings that must keep it alive
+    Napi::Value value;
+};
+
+class SodiumArgs {
+  public:
+    SodiumArgs(const Napi::CallbackInfo& info, size_t required, const char* usage)
+        : info(info), next(0), ok(true) {
+        if( info.Length() < required ) {
+            ok = Fail(usage);
+        }
+    }
+
+    // Next argument, any number of bytes
+    bool Bytes(SodiumBytes& arg, const char* name) {
+        if( ok ) {
+            arg.value = info[next];
+            if( !sodium_arg_bytes(arg.value, arg.data, arg.size) ) {
+                ok = FailType(name);
+            }
+        }
+        next++;
+        return ok;
+    }
+
+    // Next argument, exactly N bytes
+    template<size_t N>
+    bool Bytes(SodiumBytes& arg, const char* name) {
+        if( Bytes(arg, name) && arg.size != N ) {
+            ok = FailSize(name, N, arg.size);
+        }
+        return ok;
+    }
+
+    // Next argument, any number of bytes, or null for none
+    bool BytesOrNull(SodiumBytes& arg, const char* name) {
+        if( ok && info[next].IsNull() ) {
+            arg.data = NULL;
+            arg.size = 0;
+            arg.value = info[next];
+            next++;
+            return true;
+        }
+        return Bytes(arg, name);
+    }
+
+    // Next argument, any number of bytes, or a string read as UTF-8 into `text`
+    bool BytesOrString(SodiumBytes& arg, SodiumStringBytes& text, const char* name) {
+        if( ok && info[next].IsString() ) {
+            arg.value = info[next];
+            if( !text.Set(info.Env(), arg.value) ) {
+                ok = FailType(name);
+            }
+            arg.data = text.data;
+            arg.size = text.size;
+            next++;
+            return ok;
+        }
+        return Bytes(arg, name);
+    }
+
+    // Optional trailing output encoding, see sodium_arg_encoding
+    bool Encoding(SodiumEncoding& encoding) {
+        if( ok && !sodium_arg_encoding(info, next, encoding) ) {
+            ok = false;
+        }
+        next++;
+        return ok;
+    }
+
+    // What a binding returns once a read failed
+    Napi::Value Failed() const {
+        return info.Env().Null();
+    }
+
+  private:
+    bool Fail(const char* usage);
+    bool FailType(const char* name);
+    bool FailSize(const char* name, size_t expected, size_t got);
+
+    const Napi::CallbackInfo& info;
+    size_t next;
+    bool ok;
+};
+
+/**
+ * Generic binding bodies, one per operation shape
+ *
+ * A family of primitives with the same C signature shares one body, given
+ * the primitive and its sizes as template arguments:
+ *
+ *     NAPI_METHOD(crypto_auth_hmacsha256) {
+ *         return sodium_keyed<crypto_auth_hmacsha256_BYTES,
+ *                             crypto_auth_hmacsha256_KEYBYTES,
+ *                             crypto_auth_hmacsha256>(info);
+ *     }
+ */
+
+// int f(unsigned char *out, const unsigned char *in, unsigned long long inlen,
+//       const unsigned char *k)
+typedef int (*SodiumKeyedFn)(unsigned char*, const unsigned char*, unsigned long long,
+                             const unsigned char*);
+
+// int f(const unsigned char *h, const unsigned char *in, unsigned long long inlen,
+//       const unsigned char *k)
+typedef int (*SodiumKeyedVerifyFn)(const unsigned char*, const unsigned char*, unsigned long long,
+                                   const unsigned char*);
+
+// out = f(message, key), BYTES long. Null when f fails. `message` may be a
+// string, and an optional encoding returns `out` as a string
+template<size_t BYTES, size_t KEYBYTES, SodiumKeyedFn FN>
+Napi::Value sodium_keyed(const Napi::CallbackInfo& info) {
+    SodiumArgs args(info, 2, "arguments message, and key must be buffers");
+    SodiumBytes msg, key;
+    SodiumStringBytes text;
+    SodiumEncoding encoding;
+    if( !args.BytesOrString(msg, text, "msg") || !args.Bytes<KEYBYTES>(key, "key") ||
+        !args.Encoding(encoding) ) {
+        return args.Failed();
+    }
+
+    NEW_OUTPUT_AND_PTR(out, BYTES, encoding);
+    if( FN(out_ptr, msg.data, msg.size, key.data) == 0 ) {
+        return OUTPUT_VALUE(out, BYTES, encoding);
+    }
+    return info.Env().Null();
+}
+
+// sodium_keyed on the libuv threadpool, or inline for small messages. The
+// message is pinned, the key copied and wiped once the job is done
+template<size_t BYTES, size_t KEYBYTES, SodiumKeyedFn FN>
+Napi::Value sodium_keyed_async(const Napi::CallbackInfo& info, const char* name) {
+    SodiumArgs args(info, 2, "arguments message, and key must be buffers");
+    SodiumBytes msg, key;
+    if( !args.Bytes(msg, "msg") || !args.Bytes<KEYBYTES>(key, "key") ) {
+        return args.Failed();
+    }
+
+    NEW_BUFFER_AND_PTR(out, BYTES);
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, name);
+    unsigned char* o = worker->Pin(out);
+    const unsigned char* m = worker->Pin(msg.value.As<Napi::Object>());
+    const unsigned char* k = worker->Copy(key.data, KEYBYTES);
+    size_t m_size = msg.size;
+    return worker->StartTiered([=]() {
+        return FN(o, m, m_size, k);
+    }, ASYNC_RESULT_BUFFER, m_size);
+}
+
+// f(tag, message, key) as a Number, 0 when the tag is valid
+template<size_t BYTES, size_t KEYBYTES, SodiumKeyedVerifyFn FN>
+Napi::Value sodium_keyed_verify(const Napi::CallbackInfo& info) {
+    SodiumArgs args(info, 3, "arguments token, message, and key must be buffers");
+    SodiumBytes token, msg, key;
+    SodiumStringBytes text;
+    if( !args.Bytes<BYTES>(token, "token") || !args.BytesOrString(msg, text, "message") ||
+        !args.Bytes<KEYBYTES>(key, "key") ) {
+        return args.Failed();
+    }
+
+    return Napi::Number::New(info.Env(), FN(token.data, msg.data, msg.size, key.data));
+}
+
+// Streaming state of STATE from a key of any length
+template<typename STATE, int (*INIT)(STATE*, const unsigned char*, size_t)>
+Napi::Value sodium_state_init(const Napi::CallbackInfo& info) {
+    SodiumArgs args(info, 1, "argument key must a buffer");
+    SodiumBytes key;
+    if( !args.Bytes(key, "key") ) {
+        return args.Failed();
+    }
+
+    NEW_BUFFER_AND_PTR(state, sizeof(STATE));
+    if( INIT((STATE*) state_ptr, key.data, key.size) == 0 ) {
+        return state;
+    }
+    return info.Env().Null();
+}
+
+// Add a message part, null for none, to a state from sodium_state_init
+template<typename STATE, int (*UPDATE)(STATE*, const unsigned char*, unsigned long long)>
+Napi::Value sodium_state_update(const Napi::CallbackInfo& info) {
+    SodiumArgs args(info, 2, "arguments must be two buffers: hash state, message part");
+    SodiumBytes state, msg;
+    if( !args.Bytes<sizeof(STATE)>(state, "state") || !args.BytesOrNull(msg, "msg") ) {
+        return args.Failed();
+    }
+
+    return Napi::Boolean::New(info.Env(), UPDATE((STATE*) state.data, msg.data, msg.size) == 0);
+}
+
+// BYTES long result of a state from sodium_state_init
+template<typename STATE, size_t BYTES, int (*FINAL)(STATE*, unsigned char*)>
+Napi::Value sodium_state_final(const Napi::CallbackInfo& info) {
+    SodiumArgs args(info, 1, "arguments must be a hash state buffer");
+    SodiumBytes state;
+    if( !args.Bytes<sizeof(STATE)>(state, "state") ) {
+        return args.Failed();
+    }
+
+    NEW_BUFFER_AND_PTR(out, BYTES);
+    if( FINAL((STATE*) state.data, out_ptr) == 0 ) {
+        return out;
+    }
+    return info.Env().Null();
+}
+
+// New random key of KEYBYTES
+template<size_t KEYBYTES>
+Napi::Value sodium_keygen(const Napi::CallbackInfo& info) {
+    NEW_BUFFER_AND_PTR(key, KEYBYTES);
+    randombytes_buf(key_ptr, KEYBYTES);
+    return key;
+}
+
+#endif
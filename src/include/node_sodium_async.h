@@ -0,0 +1,556 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __NODE_SODIUM_ASYNC_H__
+#define __NODE_SODIUM_ASYNC_H__
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <list>
+#include <memory>
+#include <vector>
+
+#include "node_sodium.h"
+#include "sodium_latency.h"
+#include "sodium_probes.h"
+
+/**
+ * What an async job hands back to JavaScript once libsodium returns.
+ *
+ *   ASYNC_RESULT_BUFFER   the first pinned buffer on success, null on failure
+ *   ASYNC_RESULT_BOOLEAN  true on success, false on failure
+ *
+ * These mirror the return values of the synchronous bindings.
+ */
+enum SodiumAsyncResult {
+    ASYNC_RESULT_BUFFER,
+    ASYNC_RESULT_BOOLEAN
+};
+
+/**
+ * Priority classes of the async scheduler, see sodium_async_scheduler.cc.
+ * Jobs pick one with the `priority` option; jobs without it go to the libuv
+ * threadpool.
+ *
+ *   ASYNC_PRIORITY_INTERACTIVE  latency critical work, served first
+ *   ASYNC_PRIORITY_BULK         throughput work, capped below the thread count
+ */
+enum SodiumAsyncPriority {
+    ASYNC_PRIORITY_NONE = -1,
+    ASYNC_PRIORITY_INTERACTIVE,
+    ASYNC_PRIORITY_BULK,
+    ASYNC_PRIORITY_CLASSES
+};
+
+/**
+ * Tiered async bindings run jobs over fewer than this many input bytes inline
+ * on the JS thread: for small inputs the threadpool round trip costs more
+ * than the work itself. Set from JavaScript with sodium_async_threshold().
+ */
+#define SODIUM_ASYNC_DEFAULT_THRESHOLD (64 * 1024)
+
+inline size_t& sodium_async_threshold() {
+    static size_t threshold = SODIUM_ASYNC_DEFAULT_THRESHOLD;
+    return threshold;
+}
+
+/**
+ * Long jobs work through their input in pieces of this many bytes, and stop
+ * between pieces once they are cancelled
+ */
+#define SODIUM_ASYNC_CHUNK_SIZE (1024 * 1024)
+
+/**
+ * True for the options object async bindings take as their last argument
+ * before the callback: a plain object, not bytes or an array
+ */
+inline bool sodium_async_is_options(Napi::Value value) {
+    return value.IsObject() && !value.IsFunction() && !value.IsBuffer() && !value.IsTypedArray() &&
+           !value.IsArrayBuffer() && !value.IsDataView() && !value.IsArray();
+}
+
+/**
+ * libuv threadpool job for a single libsodium call.
+ *
+ * If the last JavaScript argument is a function it is called node style,
+ * `callback(err, result)`, otherwise the binding returns a Promise.
+ *
+ * Input buffers are copied with Copy() so JS code cannot change them while
+ * the pool thread is reading; copies are wiped when the job is destroyed.
+ * Output buffers are allocated on the JS thread and kept alive with Pin(),
+ * so the pool thread writes straight into the Buffer handed back to JS.
+ *
+ * Jobs can be cancelled with an options object as the last argument before
+ * the callback, `{ signal, deadline, timeout }`: an AbortSignal, a Date or
+ * epoch milliseconds, and milliseconds from now. A job cancelled while it
+ * waits for a thread is dropped without running, and long jobs check
+ * Cancelled() between chunks. The job then fails with the signal's reason,
+ * or an AbortError or TimeoutError.
+ *
+ * The same object can carry `priority: 'interactive'` or `'bulk'` to run the
+ * job on the async scheduler instead of the libuv threadpool.
+ *
+ * The time a job waits for a thread and the time it runs go to the latency
+ * histograms of sodium_latency.cc, under `name`, which must be a literal,
+ * and to the job probes of sodium_probes.h.
+ */
+class SodiumAsyncWorker : public Napi::AsyncWorker {
+public:
+    typedef std::function<int()> Job;
+
+    SodiumAsyncWorker(const Napi::CallbackInfo& info, const char* name)
+        : Napi::AsyncWorker(info.Env(), name),
+          name(name),
+          result(ASYNC_RESULT_BUFFER),
+          status(-1) {
+        size_t argc = info.Length();
+        if (argc > 0 && info[argc - 1].IsFunction()) {
+            callback = Napi::Persistent(info[argc - 1].As<Napi::Function>());
+        } else {
+            deferred.reset(new Napi::Promise::Deferred(info.Env()));
+        }
+
+        size_t last = callback.IsEmpty() ? argc : argc - 1;
+        if (last > 0 && sodium_async_is_options(info[last - 1])) {
+            ReadCancelOptions(info[last - 1].As<Napi::Object>());
+        }
+    }
+
+    /**
+     * True once the signal has fired or the deadline has passed. Safe to
+     * call from the pool thread
+     */
+    bool Cancelled() {
+        if (cancelled != ASYNC_NOT_CANCELLED) {
+            return true;
+        }
+        if (has_deadline && std::chrono::steady_clock::now() >= deadline) {
+            int expected = ASYNC_NOT_CANCELLED;
+            cancelled.compare_exchange_strong(expected, ASYNC_CANCEL_DEADLINE);
+            return true;
+        }
+        return false;
+    }
+
+    ~SodiumAsyncWorker() {
+        for (auto& copy : copies) {
+            if (!copy.empty()) {
+                sodium_memzero(copy.data(), copy.size());
+            }
+        }
+    }
+
+    const unsigned char* Copy(const void* data, size_t size) {
+        copies.emplace_back((const unsigned char*) data, (const unsigned char*) data + size);
+        return copies.back().data();
+    }
+
+    unsigned char* Pin(Napi::Object buffer) {
+        unsigned char* data = NULL;
+        size_t size = 0;
+        sodium_arg_bytes(buffer, data, size);
+        pinned.push_back(Napi::Persistent(buffer));
+        return data;
+    }
+
+    /**
+     * Queue `job` on the threadpool.
+     * Returns the Promise, or undefined when a callback was given.
+     */
+    Napi::Value Start(Job job, SodiumAsyncResult result) {
+        Napi::Env env = Env();
+
+        if (!options_error.empty()) {
+            return ThrowOptionsError(env);
+        }
+
+        if (priority != ASYNC_PRIORITY_NONE) {
+            return StartScheduled(job, result);
+        }
+
+        this->job = job;
+        this->result = result;
+
+        Napi::Value ret = deferred ? deferred->Promise() : env.Undefined();
+        queued = ASYNC_QUEUED_LIBUV;
+        submitted = std::chrono::steady_clock::now();
+        SODIUM_PROBE2(job_queue, name, queued);
+        Queue();
+        return ret;
+    }
+
+    /**
+     * Like Start(), but when a Promise is returned and the job reads fewer
+     * than sodium_async_threshold() `bytes`, run it inline and resolve the
+     * Promise right away. The worker is destroyed in that case, so it must
+     * not be used after this call.
+     *
+     * Callbacks always go through the threadpool, so they are never called
+     * before the binding returns.
+     */
+    Napi::Value StartTiered(Job job, SodiumAsyncResult result, size_t bytes) {
+        if (!deferred || bytes >= sodium_async_threshold()) {
+            return Start(job, result);
+        }
+
+        Napi::Env env = Env();
+        if (!options_error.empty()) {
+            return ThrowOptionsError(env);
+        }
+
+        this->job = job;
+        this->result = result;
+        Napi::Promise promise = deferred->Promise();
+        if (Cancelled()) {
+            deferred->Reject(CancelError(env));
+        } else {
+            status = job();
+            deferred->Resolve(Result(env));
+        }
+        StopListening();
+        delete this;
+        return promise;
+    }
+
+    /**
+     * Like Start(), but for the memory hard password hashes: the job goes to
+     * the bounded pool in sodium_pwhash_pool.cc, so a burst of logins cannot
+     * take every libuv thread away from fs and dns work. When that pool's
+     * queue is full the job fails right away with a "queue is full" error.
+     * Falls back to Start() when the pool has been configured with no threads.
+     */
+    Napi::Value StartPwhash(Job job, SodiumAsyncResult result);
+
+    /**
+     * Like Start(), but on the async scheduler in sodium_async_scheduler.cc,
+     * in the job's priority class. When the class queue is full the job
+     * fails right away with a "queue is full" error. Falls back to the libuv
+     * threadpool when the scheduler has been configured with no threads.
+     */
+    Napi::Value StartScheduled(Job job, SodiumAsyncResult result);
+
+    /**
+     * A job cancelled by libuv before it started completes as cancelled,
+     * which would leave its Promise pending: settle it like a failed job
+     */
+    void OnWorkComplete(Napi::Env env, napi_status status) override {
+        if (status == napi_cancelled) {
+            SetError("cancelled");
+            status = napi_ok;
+        }
+        Napi::AsyncWorker::OnWorkComplete(env, status);
+    }
+
+protected:
+    void Execute() override {
+        started = std::chrono::steady_clock::now();
+        SODIUM_PROBE2(job_start, name, (int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            started - submitted).count());
+        Run();
+        finished = std::chrono::steady_clock::now();
+        SODIUM_PROBE3(job_done, name, (int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(
+            finished - started).count(), status);
+    }
+
+    /**
+     * The work of the job, on a pool thread. Override for jobs that do more
+     * than call `job`
+     */
+    virtual void Run() {
+        if (Cancelled()) {
+            SetError("cancelled");
+            return;
+        }
+        status = job();
+        if (status != 0 && Cancelled()) {
+            SetError("cancelled");
+        }
+    }
+
+    /**
+     * Build the JavaScript result value. Runs on the JS thread.
+     * Override for jobs that return something other than a buffer or a boolean.
+     */
+    virtual Napi::Value Result(Napi::Env env) {
+        if (result == ASYNC_RESULT_BOOLEAN) {
+            return Napi::Boolean::New(env, status == 0);
+        }
+        if (status != 0 || pinned.empty()) {
+            return env.Null();
+        }
+        return pinned.front().Value();
+    }
+
+    void OnOK() override {
+        Napi::Env env = Env();
+        StopListening();
+        RecordLatency();
+        Napi::Value value = Result(env);
+
+        if (deferred) {
+            deferred->Resolve(value);
+        } else {
+            callback.Call({ env.Null(), value });
+        }
+    }
+
+    void OnError(const Napi::Error& e) override {
+        Napi::Env env = Env();
+        StopListening();
+        RecordLatency();
+        Napi::Value error = cancelled != ASYNC_NOT_CANCELLED ? CancelError(env) : Napi::Value(e.Value());
+
+        if (deferred) {
+            deferred->Reject(error);
+        } else {
+            callback.Call({ error });
+        }
+    }
+
+    // True when the options object was bad, so Start() will throw
+    bool OptionsFailed() const {
+        return !options_error.empty();
+    }
+
+    const char* name;
+    Job job;
+    SodiumAsyncResult result;
+    int status;
+    std::chrono::steady_clock::time_point submitted;
+
+private:
+    enum {
+        ASYNC_NOT_CANCELLED,
+        ASYNC_CANCEL_ABORTED,
+        ASYNC_CANCEL_DEADLINE
+    };
+    enum {
+        ASYNC_NOT_QUEUED,
+        ASYNC_QUEUED_LIBUV,
+        ASYNC_QUEUED_PWHASH,
+        ASYNC_QUEUED_SCHEDULER
+    };
+
+    void ReadCancelOptions(Napi::Object options) {
+        Napi::Env env = Env();
+        Napi::Value signal = options.Get("signal");
+        Napi::Value at = options.Get("deadline");
+        Napi::Value timeout = options.Get("timeout");
+        Napi::Value priority = options.Get("priority");
+
+        if (!priority.IsUndefined()) {
+            std::string name = priority.IsString() ? priority.As<Napi::String>().Utf8Value() : "";
+            if (name == "interactive") {
+                this->priority = ASYNC_PRIORITY_INTERACTIVE;
+            } else if (name == "bulk") {
+                this->priority = ASYNC_PRIORITY_BULK;
+            } else {
+                options_error = "options.priority must be 'interactive' or 'bulk'";
+                return;
+            }
+        }
+
+        if (!at.IsUndefined()) {
+            if (at.IsObject() && at.As<Napi::Object>().Get("getTime").IsFunction()) {
+                at = at.As<Napi::Object>().Get("getTime").As<Napi::Function>().Call(at, {});
+            }
+            if (!at.IsNumber()) {
+                options_error = "options.deadline must be a Date or a number of milliseconds since the epoch";
+                return;
+            }
+            double now = (double) std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            SetDeadline(at.As<Napi::Number>().DoubleValue() - now);
+        }
+        if (!timeout.IsUndefined()) {
+            if (!timeout.IsNumber() || !(timeout.As<Napi::Number>().DoubleValue() >= 0)) {
+                options_error = "options.timeout must be a positive number of milliseconds";
+                return;
+            }
+            SetDeadline(timeout.As<Napi::Number>().DoubleValue());
+        }
+
+        if (signal.IsUndefined()) {
+            return;
+        }
+        if (!signal.IsObject() || !signal.As<Napi::Object>().Get("addEventListener").IsFunction()) {
+            options_error = "options.signal must be an AbortSignal";
+            return;
+        }
+        Napi::Object s = signal.As<Napi::Object>();
+        this->signal = Napi::Persistent(s);
+        if (s.Get("aborted").ToBoolean().Value()) {
+            cancelled = ASYNC_CANCEL_ABORTED;
+            return;
+        }
+        Napi::Function listener = Napi::Function::New(env, [this](const Napi::CallbackInfo&) {
+            int expected = ASYNC_NOT_CANCELLED;
+            cancelled.compare_exchange_strong(expected, ASYNC_CANCEL_ABORTED);
+            Abandon();
+        }, "abort");
+        abort_listener = Napi::Persistent(listener);
+        s.Get("addEventListener").As<Napi::Function>().Call(s, { Napi::String::New(env, "abort"), listener });
+    }
+
+    // The earlier of the deadlines wins
+    void SetDeadline(double ms) {
+        if (ms < 0) {
+            ms = 0;
+        }
+        auto at = std::chrono::steady_clock::now() +
+                  std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                      std::chrono::duration<double, std::milli>(ms < 1e15 ? ms : 1e15));
+        if (!has_deadline || at < deadline) {
+            deadline = at;
+        }
+        has_deadline = true;
+    }
+
+    Napi::Value ThrowOptionsError(Napi::Env env) {
+        Napi::TypeError::New(env, options_error).ThrowAsJavaScriptException();
+        StopListening();
+        delete this;
+        return env.Null();
+    }
+
+    // Take a job that has not started off its queue, so it fails now
+    // instead of when a thread gets to it
+    void Abandon() {
+        if (queued == ASYNC_QUEUED_PWHASH) {
+            DropPwhash();
+        } else if (queued == ASYNC_QUEUED_SCHEDULER) {
+            DropScheduled();
+        } else if (queued == ASYNC_QUEUED_LIBUV) {
+            // Fails harmlessly once the job is running
+            napi_cancel_async_work(Env(), *this);
+        }
+    }
+
+    // Jobs that never reached a thread are left out
+    void RecordLatency() {
+        if (started == std::chrono::steady_clock::time_point() ||
+            submitted == std::chrono::steady_clock::time_point()) {
+            return;
+        }
+        sodium_latency_record(name,
+            std::chrono::duration_cast<std::chrono::nanoseconds>(started - submitted).count(),
+            std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started).count());
+    }
+
+    // See StartPwhash(). True if the job was still queued
+    bool DropPwhash();
+
+    // See StartScheduled(). True if the job was still queued
+    bool DropScheduled();
+
+    void StopListening() {
+        if (abort_listener.IsEmpty()) {
+            return;
+        }
+        Napi::Object s = signal.Value();
+        Napi::Value remove = s.Get("removeEventListener");
+        if (remove.IsFunction()) {
+            remove.As<Napi::Function>().Call(s, { Napi::String::New(Env(), "abort"), abort_listener.Value() });
+        }
+        abort_listener.Reset();
+    }
+
+    Napi::Value CancelError(Napi::Env env) {
+        bool aborted = cancelled == ASYNC_CANCEL_ABORTED;
+        if (aborted && !signal.IsEmpty()) {
+            Napi::Value reason = signal.Value().Get("reason");
+            if (!reason.IsUndefined()) {
+                return reason;
+            }
+        }
+        Napi::Error e = Napi::Error::New(env, aborted ? "The operation was aborted" : "The operation timed out");
+        e.Value().Set("name", Napi::String::New(env, aborted ? "AbortError" : "TimeoutError"));
+        e.Value().Set("code", Napi::String::New(env, aborted ? "ABORT_ERR" : "ETIMEDOUT"));
+        return e.Value();
+    }
+
+    std::atomic<int> cancelled{ ASYNC_NOT_CANCELLED };
+    bool has_deadline = false;
+    std::chrono::steady_clock::time_point deadline;
+    int queued = ASYNC_NOT_QUEUED;
+    int priority = ASYNC_PRIORITY_NONE;
+    std::chrono::steady_clock::time_point started;
+    std::chrono::steady_clock::time_point finished;
+    std::string options_error;
+    Napi::ObjectReference signal;
+    Napi::FunctionReference abort_listener;
+
+    std::unique_ptr<Napi::Promise::Deferred> deferred;
+    Napi::FunctionReference callback;
+    std::vector<Napi::ObjectReference> pinned;
+    std::list<std::vector<unsigned char>> copies;
+};
+
+/**
+ * Async job over a batch whose items succeed or fail on their own, such as
+ * messages under different keys. The job writes the result of item `i` at
+ * `offsets[i]` of the Output() buffer and sets `ok[i]`. The result is an
+ * Array with a view of `sizes[i]` bytes for each item that succeeded, and
+ * null for the others.
+ */
+class SodiumEachWorker : public SodiumAsyncWorker {
+public:
+    SodiumEachWorker(const Napi::CallbackInfo& info, const char* name, size_t count)
+        : SodiumAsyncWorker(info, name), ok(count, 0), offsets(count, 0), sizes(count, 0) {}
+
+    unsigned char* Output(Napi::Object buffer) {
+        unsigned char* data = NULL;
+        size_t size = 0;
+        sodium_arg_bytes(buffer, data, size);
+        out = Napi::Persistent(buffer);
+        return data;
+    }
+
+    std::vector<unsigned char> ok;
+    std::vector<size_t> offsets;
+    std::vector<size_t> sizes;
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        Napi::Array result = Napi::Array::New(env, ok.size());
+        Napi::Object buffer = out.Value();
+        Napi::Function subarray = buffer.Get("subarray").As<Napi::Function>();
+        for (size_t i = 0; i < ok.size(); i++) {
+            if (!ok[i]) {
+                result.Set((uint32_t) i, env.Null());
+                continue;
+            }
+            result.Set((uint32_t) i, subarray.Call(buffer, {
+                Napi::Number::New(env, (double) offsets[i]),
+                Napi::Number::New(env, (double) (offsets[i] + sizes[i]))
+            }));
+        }
+        return result;
+    }
+
+private:
+    Napi::ObjectReference out;
+};
+
+/**
+ * Hand `in` to `update(piece, size)` in SODIUM_ASYNC_CHUNK_SIZE pieces,
+ * stopping once `worker` is cancelled. Returns false if it stopped early
+ */
+template <typename Update>
+inline bool sodium_async_chunks(SodiumAsyncWorker* worker, const unsigned char* in, size_t size, Update update) {
+    for (size_t done = 0; done < size; done += SODIUM_ASYNC_CHUNK_SIZE) {
+        if (worker->Cancelled()) {
+            return false;
+        }
+        size_t n = size - done < SODIUM_ASYNC_CHUNK_SIZE ? size - done : SODIUM_ASYNC_CHUNK_SIZE;
+        update(in + done, n);
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,436 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __NODE_SODIUM_BATCH_H__
+#define __NODE_SODIUM_BATCH_H__
+
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "node_sodium.h"
+
+/**
+ * One element of a batch argument: a pointer into a JS buffer and its length.
+ * A null element has data == NULL and size == 0.
+ */
+struct SodiumSpan {
+    const unsigned char* data;
+    size_t size;
+};
+
+// Batch size no argument has set yet. 0 is a batch of no elements
+#define SODIUM_BATCH_ANY ((size_t) -1)
+
+/**
+ * Packed batches
+ *
+ * The layout every batch argument takes next to an Array of Buffers, laid
+ * out as a struct of arrays:
+ *
+ *     { data: Buffer, offsets: Uint32Array, lengths: Uint32Array }
+ *
+ * Element `i` is the `lengths[i]` bytes of `data` at `offsets[i]`, or null
+ * when `lengths[i]` is SODIUM_BATCH_NULL. `offsets` may be left out when
+ * the elements are back to back. Reading one costs three property lookups
+ * whatever the number of elements, where an Array costs one per element,
+ * and the elements sit in one block. lib/batch-pack.js builds them.
+ */
+#define SODIUM_BATCH_NULL 0xffffffffU
+
+/**
+ * Read a packed batch into `spans`, checking each element as
+ * sodium_batch_arg() does. Throws and returns false if `arg` is not one.
+ */
+inline bool sodium_batch_packed(Napi::Env env, Napi::Object arg, const char* name,
+                                size_t& count, size_t stride, bool allowNull,
+                                std::vector<SodiumSpan>& spans) {
+    std::string msg = std::string("argument ") + name +
+                      " must be an array of buffers or a packed batch";
+    Napi::Value data_value = arg.Get("data");
+    Napi::Value offsets_value = arg.Get("offsets");
+    Napi::Value lengths_value = arg.Get("lengths");
+
+    unsigned char* data = NULL;
+    size_t size = 0;
+    if( !sodium_arg_bytes(data_value, data, size) || !lengths_value.IsTypedArray() ||
+        lengths_value.As<Napi::TypedArray>().TypedArrayType() != napi_uint32_array ) {
+        sodium_throw(env, msg);
+        return false;
+    }
+    Napi::Uint32Array lengths = lengths_value.As<Napi::Uint32Array>();
+    const uint32_t* offsets = NULL;
+    if( !offsets_value.IsUndefined() && !offsets_value.IsNull() ) {
+        if( !offsets_value.IsTypedArray() ||
+            offsets_value.As<Napi::TypedArray>().TypedArrayType() != napi_uint32_array ||
+            offsets_value.As<Napi::Uint32Array>().ElementLength() != lengths.ElementLength() ) {
+            msg = std::string("argument ") + name + ".offsets must be a Uint32Array as long as its lengths";
+            sodium_throw(env, msg);
+            return false;
+        }
+        offsets = offsets_value.As<Napi::Uint32Array>().Data();
+    }
+
+    size_t n = lengths.ElementLength();
+    if( count == SODIUM_BATCH_ANY ) {
+        count = n;
+    } else if( n != count ) {
+        msg = std::string("argument ") + name + " must have " + std::to_string(count) + " elements";
+        sodium_throw(env, msg);
+        return false;
+    }
+
+    const uint32_t* length = lengths.Data();
+    size_t next = 0;
+    spans.resize(count);
+    for(size_t i = 0; i < count; i++) {
+        if( length[i] == SODIUM_BATCH_NULL ) {
+            if( !allowNull ) {
+                msg = std::string("argument ") + name + "[" + std::to_string(i) + "] must be a buffer";
+                sodium_throw(env, msg);
+                return false;
+            }
+            spans[i].data = NULL;
+            spans[i].size = 0;
+            continue;
+        }
+        size_t offset = offsets != NULL ? offsets[i] : next;
+        if( offset > size || length[i] > size - offset ) {
+            msg = std::string("argument ") + name + "[" + std::to_string(i) + "] is out of its data";
+            sodium_throw(env, msg);
+            return false;
+        }
+        if( stride != 0 && length[i] != stride ) {
+            msg = std::string("argument ") + name + "[" + std::to_string(i) + "] must be " +
+                  std::to_string(stride) + " bytes long";
+            sodium_throw(env, msg);
+            return false;
+        }
+        spans[i].data = data + offset;
+        spans[i].size = length[i];
+        next = offset + length[i];
+    }
+    return true;
+}
+
+/**
+ * Read a batch argument into `spans`.
+ *
+ * Accepted forms:
+ *   - an Array of Buffers (null elements allowed only if `allowNull`)
+ *   - a packed batch, see above
+ *   - a single Buffer holding `count` elements of `stride` bytes back to back,
+ *     only when `stride` is not 0
+ *
+ * Anything sodium_arg_bytes() accepts counts as a Buffer.
+ *   - null, if `allowNull`, meaning `count` null elements
+ *
+ * If `count` is SODIUM_BATCH_ANY the argument sets it, else it must hold
+ * `count` elements: declare the count of a batch SODIUM_BATCH_ANY and pass
+ * it to each of its arguments. If `stride` is not 0 every element must be
+ * exactly `stride` bytes long.
+ *
+ * On error a JS exception is thrown, or kept in fast fail mode, and false
+ * is returned.
+ */
+inline bool sodium_batch_arg(Napi::Env env, Napi::Value arg, const char* name,
+                             size_t& count, size_t stride, bool allowNull,
+                             std::vector<SodiumSpan>& spans) {
+    std::string msg;
+
+    if( arg.IsNull() && allowNull ) {
+        if( count == SODIUM_BATCH_ANY ) {
+            count = 0;
+        }
+        spans.assign(count, SodiumSpan{ NULL, 0 });
+        return true;
+    }
+
+    unsigned char* data = NULL;
+    size_t size = 0;
+    if( stride != 0 && sodium_arg_bytes(arg, data, size) ) {
+        if( count == SODIUM_BATCH_ANY ) {
+            if( size % stride != 0 ) {
+                msg = std::string("argument ") + name + " must be a multiple of " +
+                      std::to_string(stride) + " bytes long";
+                sodium_throw(env, msg);
+                return false;
+            }
+            count = size / stride;
+        }
+        if( size / stride != count || size % stride != 0 ) {
+            msg = std::string("argument ") + name + " must be " +
+                  std::to_string(count) + " x " + std::to_string(stride) + " bytes long";
+            sodium_throw(env, msg);
+            return false;
+        }
+        spans.resize(count);
+        for(size_t i = 0; i < count; i++) {
+            spans[i].data = data + i * stride;
+            spans[i].size = stride;
+        }
+        return true;
+    }
+
+    if( !arg.IsArray() && arg.IsObject() && !arg.IsTypedArray() && !arg.IsArrayBuffer() ) {
+        return sodium_batch_packed(env, arg.As<Napi::Object>(), name, count, stride, allowNull, spans);
+    }
+
+    if( !arg.IsArray() ) {
+        msg = std::string("argument ") + name + " must be an array of buffers";
+        sodium_throw(env, msg);
+        return false;
+    }
+
+    Napi::Array array = arg.As<Napi::Array>();
+    if( count == SODIUM_BATCH_ANY ) {
+        count = array.Length();
+    } else if( array.Length() != count ) {
+        msg = std::string("argument ") + name + " must have " + std::to_string(count) + " elements";
+        sodium_throw(env, msg);
+        return false;
+    }
+
+    spans.resize(count);
+    for(uint32_t i = 0; i < count; i++) {
+        Napi::Value v = array.Get(i);
+        if( v.IsNull() && allowNull ) {
+            spans[i].data = NULL;
+            spans[i].size = 0;
+            continue;
+        }
+        if( !sodium_arg_bytes(v, data, size) ) {
+            msg = std::string("argument ") + name + "[" + std::to_string(i) + "] must be a buffer";
+            sodium_throw(env, msg);
+            return false;
+        }
+        if( stride != 0 && size != stride ) {
+            msg = std::string("argument ") + name + "[" + std::to_string(i) + "] must be " +
+                  std::to_string(stride) + " bytes long";
+            sodium_throw(env, msg);
+            return false;
+        }
+        spans[i].data = data;
+        spans[i].size = size;
+    }
+    return true;
+}
+
+/**
+ * Split one packed buffer into `spans` following a length table.
+ *
+ * `lengths` is an Array of Numbers or a Uint32Array with the length of each
+ * element, which must add up to `size`, or a single Number to cut the buffer
+ * into elements of that many bytes, the last one possibly shorter.
+ *
+ * On error a JS exception is thrown, or kept in fast fail mode, and false
+ * is returned.
+ */
+inline bool sodium_batch_chunks(Napi::Env env, const unsigned char* data, size_t size,
+                                Napi::Value lengths, const char* name,
+                                std::vector<SodiumSpan>& spans) {
+    std::string msg = std::string("argument ") + name +
+                      " must be a chunk length, or an Array or Uint32Array of lengths";
+    spans.clear();
+
+    if( lengths.IsNumber() ) {
+        double stride = lengths.As<Napi::Number>().DoubleValue();
+        if( !(stride >= 1) || stride > SODIUM_MAX_SAFE_INTEGER ) {
+            sodium_throw(env, msg);
+            return false;
+        }
+        size_t chunk = (size_t) stride;
+        spans.reserve(size / chunk + 1);
+        for(size_t offset = 0; offset < size; offset += chunk) {
+            spans.push_back(SodiumSpan{ data + offset, chunk < size - offset ? chunk : size - offset });
+        }
+        return true;
+    }
+
+    size_t offset = 0;
+    auto add = [&](double length) {
+        if( !(length >= 0) || length > (double) (size - offset) ) {
+            return false;
+        }
+        spans.push_back(SodiumSpan{ data + offset, (size_t) length });
+        offset += (size_t) length;
+        return true;
+    };
+
+    if( lengths.IsTypedArray() && lengths.As<Napi::TypedArray>().TypedArrayType() == napi_uint32_array ) {
+        Napi::Uint32Array table = lengths.As<Napi::Uint32Array>();
+        spans.reserve(table.ElementLength());
+        for(size_t i = 0; i < table.ElementLength(); i++) {
+            if( !add(table[i]) ) {
+                break;
+            }
+        }
+    } else if( lengths.IsArray() ) {
+        Napi::Array table = lengths.As<Napi::Array>();
+        spans.reserve(table.Length());
+        for(uint32_t i = 0; i < table.Length(); i++) {
+            Napi::Value v = table.Get(i);
+            if( !v.IsNumber() || !add(v.As<Napi::Number>().DoubleValue()) ) {
+                break;
+            }
+        }
+    } else {
+        sodium_throw(env, msg);
+        return false;
+    }
+
+    if( offset != size ) {
+        msg = std::string("the lengths in argument ") + name + " must add up to the buffer length";
+        sodium_throw(env, msg);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Run `work(begin, end)` over [0, count), split across up to `threads` OS
+ * threads. The calling thread takes the first slice and waits for the rest.
+ *
+ * Slices are never smaller than `minPerThread` items, so small batches stay
+ * on the calling thread. `threads` is capped at the number of hardware
+ * threads. `work` must not touch JS values.
+ */
+inline void sodium_batch_parallel(size_t count, size_t threads, size_t minPerThread,
+                                  const std::function<void(size_t, size_t)>& work) {
+    size_t hw = std::thread::hardware_concurrency();
+    if( hw != 0 && threads > hw ) {
+        threads = hw;
+    }
+    if( minPerThread == 0 ) {
+        minPerThread = 1;
+    }
+    if( threads > count / minPerThread ) {
+        threads = count / minPerThread;
+    }
+    if( threads <= 1 ) {
+        work(0, count);
+        return;
+    }
+
+    size_t slice = (count + threads - 1) / threads;
+    std::vector<std::thread> pool;
+    for(size_t begin = slice; begin < count; begin += slice) {
+        size_t end = begin + slice < count ? begin + slice : count;
+        pool.emplace_back(work, begin, end);
+    }
+    work(0, slice);
+    for(auto& t : pool) {
+        t.join();
+    }
+}
+
+/**
+ * Pack per item results (0 or 1) into a bitmap Buffer: bit `i % 8` of byte
+ * `i / 8` is set when item `i` succeeded.
+ */
+inline Napi::Buffer<unsigned char> sodium_batch_bitmap(Napi::Env env, const std::vector<unsigned char>& ok) {
+    Napi::Buffer<unsigned char> bitmap = Napi::Buffer<unsigned char>::New(env, (ok.size() + 7) / 8);
+    unsigned char* bits = bitmap.Data();
+    memset(bits, 0, bitmap.Length());
+    for(size_t i = 0; i < ok.size(); i++) {
+        if( ok[i] ) {
+            bits[i >> 3] |= (unsigned char) (1U << (i & 7));
+        }
+    }
+    return bitmap;
+}
+
+typedef int (*SodiumKeypairFn)(unsigned char* pk, unsigned char* sk);
+typedef int (*SodiumSeedKeypairFn)(unsigned char* pk, unsigned char* sk, const unsigned char* seed);
+
+/**
+ * Make `count` key pairs into `out`, each publicKey || secretKey, split over
+ * `threads`. Pair `i` comes from seed `i` of `seeds`, `seedBytes` each, when
+ * `seeds` is not NULL, else from `keypair`.
+ */
+inline int sodium_batch_keypairs(unsigned char* out, size_t count, size_t pkBytes, size_t skBytes,
+                                 const unsigned char* seeds, size_t seedBytes,
+                                 SodiumKeypairFn keypair, SodiumSeedKeypairFn seedKeypair,
+                                 size_t threads) {
+    size_t stride = pkBytes + skBytes;
+    std::vector<unsigned char> ok(count, 0);
+
+    sodium_batch_parallel(count, threads, 64, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            unsigned char* pk = out + i * stride;
+            ok[i] = (seeds != NULL ? seedKeypair(pk, pk + pkBytes, seeds + i * seedBytes)
+                                   : keypair(pk, pk + pkBytes)) == 0;
+        }
+    });
+
+    for(size_t i = 0; i < count; i++) {
+        if( !ok[i] ) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Most key pairs made by one `*_keypair_batch` call
+#define SODIUM_KEYPAIR_BATCH_MAX (1 << 24)
+
+// A count of random key pairs, or one buffer of seeds back to back
+#define ARG_TO_KEYPAIR_BATCH(COUNT, SEEDS, SEEDBYTES) \
+    size_t COUNT = 0; \
+    unsigned char* SEEDS = NULL; \
+    if( SODIUM_ARG_IS_INTEGER(info[_arg]) ) { \
+        uint64_t COUNT ## _value = 0; \
+        if( !sodium_arg_uint64(info[_arg], #COUNT, SODIUM_KEYPAIR_BATCH_MAX, COUNT ## _value) ) { \
+            return NAPI_NULL; \
+        } \
+        COUNT = (size_t) COUNT ## _value; \
+    } else { \
+        size_t SEEDS ## _size = 0; \
+        if( !sodium_arg_bytes(info[_arg], SEEDS, SEEDS ## _size) || SEEDS ## _size % (SEEDBYTES) != 0 ) { \
+            THROW_ERROR("argument " #COUNT " must be a number or a buffer of " #SEEDBYTES " byte seeds"); \
+        } \
+        COUNT = SEEDS ## _size / (SEEDBYTES); \
+        if( COUNT > SODIUM_KEYPAIR_BATCH_MAX ) { \
+            THROW_ERROR("argument seeds holds too many seeds"); \
+        } \
+    } \
+    _arg++
+
+// Batch argument macros. COUNT must be a size_t variable; if it is
+// SODIUM_BATCH_ANY the argument sets it.
+#define ARG_TO_BATCH(NAME, COUNT) \
+    std::vector<SodiumSpan> NAME; \
+    if( !sodium_batch_arg(env, info[_arg], #NAME, COUNT, 0, false, NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+#define ARG_TO_BATCH_LEN(NAME, COUNT, STRIDE) \
+    std::vector<SodiumSpan> NAME; \
+    if( !sodium_batch_arg(env, info[_arg], #NAME, COUNT, STRIDE, false, NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+// A packed buffer followed by its length table
+#define ARG_TO_CHUNKS(NAME, LENGTHS) \
+    ARG_TO_UCHAR_BUFFER(NAME ## _packed); \
+    std::vector<SodiumSpan> NAME; \
+    if( !sodium_batch_chunks(env, NAME ## _packed, NAME ## _packed_size, info[_arg], #LENGTHS, NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+#define ARG_TO_BATCH_OR_NULL(NAME, COUNT) \
+    std::vector<SodiumSpan> NAME; \
+    if( !sodium_batch_arg(env, info[_arg], #NAME, COUNT, 0, true, NAME) ) { \
+        return NAPI_NULL; \
+    } \
+    _arg++
+
+#endif
@@ -5,6 +5,7 @@
 #include <uv.h>
 
 void register_helpers(Napi::Env env, Napi::Object exports);
+void register_sodium_bench(Napi::Env env, Napi::Object exports);
 void register_randombytes(Napi::Env env, Napi::Object exports);
 void register_crypto_pwhash_algos(Napi::Env env, Napi::Object exports);
 void register_crypto_pwhash(Napi::Env env, Napi::Object exports);
@@ -13,24 +14,71 @@ void register_crypto_hash_sha256(Napi::Env env, Napi::Object exports);
 void register_crypto_hash_sha512(Napi::Env env, Napi::Object exports);
 void register_crypto_shorthash(Napi::Env env, Napi::Object exports);
 void register_crypto_shorthash_siphash24(Napi::Env env, Napi::Object exports);
+void register_crypto_shorthash_filter(Napi::Env env, Napi::Object exports);
 void register_crypto_generichash(Napi::Env env, Napi::Object exports);
 void register_crypto_generichash_blake2b(Napi::Env env, Napi::Object exports);
+void register_crypto_generichash_index(Napi::Env env, Napi::Object exports);
 void register_crypto_auth(Napi::Env env, Napi::Object exports);
+void register_crypto_auth_key(Napi::Env env, Napi::Object exports);
 void register_crypto_onetimeauth(Napi::Env env, Napi::Object exports);
 void register_crypto_onetimeauth_poly1305(Napi::Env env, Napi::Object exports);
 void register_crypto_stream(Napi::Env env, Napi::Object exports);
 void register_crypto_streams(Napi::Env env, Napi::Object exports);
+void register_crypto_stream_keystream(Napi::Env env, Napi::Object exports);
 void register_crypto_secretbox(Napi::Env env, Napi::Object exports);
 void register_crypto_secretbox_xsalsa20poly1305(Napi::Env env, Napi::Object exports);
+void register_crypto_secretbox_xchacha20poly1305(Napi::Env env, Napi::Object exports);
 void register_crypto_sign(Napi::Env env, Napi::Object exports);
+void register_crypto_paseto(Napi::Env env, Napi::Object exports);
 void register_crypto_sign_ed25519(Napi::Env env, Napi::Object exports);
+void register_crypto_sign_context(Napi::Env env, Napi::Object exports);
+void register_crypto_sign_verify_cache(Napi::Env env, Napi::Object exports);
+void register_crypto_sign_curve25519_cache(Napi::Env env, Napi::Object exports);
 void register_crypto_box(Napi::Env env, Napi::Object exports);
+void register_crypto_box_session(Napi::Env env, Napi::Object exports);
+void register_crypto_box_multi(Napi::Env env, Napi::Object exports);
+void register_crypto_box_cache(Napi::Env env, Napi::Object exports);
+void register_crypto_box_signed(Napi::Env env, Napi::Object exports);
+void register_crypto_age(Napi::Env env, Napi::Object exports);
+void register_crypto_keypair_pool(Napi::Env env, Napi::Object exports);
 void register_crypto_scalarmult(Napi::Env env, Napi::Object exports);
 void register_crypto_scalarmult_curve25519(Napi::Env env, Napi::Object exports);
+void register_crypto_kx(Napi::Env env, Napi::Object exports);
+void register_crypto_noise(Napi::Env env, Napi::Object exports);
+void register_crypto_ratchet(Napi::Env env, Napi::Object exports);
+void register_crypto_kdf(Napi::Env env, Napi::Object exports);
+void register_crypto_kdf_tree(Napi::Env env, Napi::Object exports);
 void register_crypto_core(Napi::Env env, Napi::Object exports);
 void register_crypto_auth_algos(Napi::Env env, Napi::Object exports);
 void register_crypto_aead(Napi::Env env, Napi::Object exports);
+void register_crypto_aead_context(Napi::Env env, Napi::Object exports);
+void register_crypto_aead_envelope(Napi::Env env, Napi::Object exports);
+void register_crypto_aead_convergent(Napi::Env env, Napi::Object exports);
+void register_crypto_aead_column(Napi::Env env, Napi::Object exports);
+void register_crypto_aead_transport(Napi::Env env, Napi::Object exports);
+void register_crypto_aead_packet(Napi::Env env, Napi::Object exports);
+void register_nonce_sequence(Napi::Env env, Napi::Object exports);
+void register_crypto_secretstream(Napi::Env env, Napi::Object exports);
 void register_runtime(Napi::Env env, Napi::Object exports);
+void register_sodium_pool(Napi::Env env, Napi::Object exports);
+void register_sodium_stats(Napi::Env env, Napi::Object exports);
+void register_sodium_latency(Napi::Env env, Napi::Object exports);
+void register_sodium_memory(Napi::Env env, Napi::Object exports);
+void register_sodium_secure_pool(Napi::Env env, Napi::Object exports);
+void register_sodium_arena(Napi::Env env, Napi::Object exports);
+void register_crypto_hash_state(Napi::Env env, Napi::Object exports);
+void register_crypto_merkle(Napi::Env env, Napi::Object exports);
+void register_sodium_file(Napi::Env env, Napi::Object exports);
+void register_sodium_chunker(Napi::Env env, Napi::Object exports);
+void register_sodium_log(Napi::Env env, Napi::Object exports);
+void register_sodium_pwhash_pool(Napi::Env env, Napi::Object exports);
+void register_sodium_async_scheduler(Napi::Env env, Napi::Object exports);
+void register_sodium_ring(Napi::Env env, Napi::Object exports);
+void register_sodium_pipeline(Napi::Env env, Napi::Object exports);
+void register_sodium_pwhash_memory(Napi::Env env, Napi::Object exports);
+void register_sodium_shared_cache(Napi::Env env, Napi::Object exports);
+void register_sodium_snapshot(Napi::Env env, Napi::Object exports);
 void register_crypto_box_curve25519xsalsa20poly1305(Napi::Env env, Napi::Object exports);
+void register_crypto_box_curve25519xchacha20poly1305(Napi::Env env, Napi::Object exports);
 
 #endif
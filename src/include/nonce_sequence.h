@@ -0,0 +1,48 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __NONCE_SEQUENCE_H__
+#define __NONCE_SEQUENCE_H__
+
+#include "node_sodium.h"
+
+// Longest nonce a sequence can hold
+#define NONCE_SEQUENCE_MAX_BYTES 64
+
+class NonceSequence : public Napi::ObjectWrap<NonceSequence> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports);
+
+    // The NonceSequence wrapped by `value`, or NULL if it is not one
+    static NonceSequence* From(Napi::Value value);
+
+    NonceSequence(const Napi::CallbackInfo& info);
+
+    size_t Size() const { return size; }
+
+    // Write the nonce that comes after the last one issued to `out`, without
+    // issuing it. Returns false once every value has been used
+    bool Peek(unsigned char* out) const;
+
+    // Record `nonce`, as returned by Peek, as issued
+    void Commit(const unsigned char* nonce);
+
+private:
+    Napi::Value Next(const Napi::CallbackInfo& info);
+    Napi::Value Current(const Napi::CallbackInfo& info);
+
+    // next() returns `buffer`, but the state is kept apart in `counter` so
+    // that writes to the returned Buffer cannot make nonces repeat
+    Napi::Reference<Napi::Buffer<unsigned char>> buffer;
+    unsigned char* view;
+    unsigned char counter[NONCE_SEQUENCE_MAX_BYTES];
+    unsigned char first[NONCE_SEQUENCE_MAX_BYTES];
+    size_t size;
+    bool started;
+};
+
+#endif
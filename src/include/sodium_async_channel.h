@@ -0,0 +1,54 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_ASYNC_CHANNEL_H__
+#define __SODIUM_ASYNC_CHANNEL_H__
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+
+/**
+ * Async channel
+ *
+ * The addon's own thread pools, the password hashing pool and the async
+ * scheduler, hand finished jobs back to the environment that queued them
+ * through that environment's channel: a thread safe function that runs
+ * OnWorkComplete() on its JS thread, just as libuv would. The channel is
+ * referenced, keeping the event loop alive, only while jobs are pending.
+ *
+ * Every job handed to a pool is first counted with
+ * sodium_async_channel_expect(). A job that goes on a queue also holds the
+ * channel, from sodium_async_channel_hold() to sodium_async_channel_release(),
+ * and the pool thread brackets running it with sodium_async_channel_begin()
+ * and sodium_async_channel_end().
+ */
+struct AsyncChannel;
+
+// The channel of `env`, created on first use. JS thread only
+AsyncChannel* sodium_async_channel(Napi::Env env);
+
+// Count a job that will complete through the channel. JS thread only
+void sodium_async_channel_expect(Napi::Env env, AsyncChannel* channel);
+
+// Keep the channel for a job that goes on a queue
+void sodium_async_channel_hold(AsyncChannel* channel);
+
+// A job may only run while its environment, which owns the output buffers,
+// is there. Returns false for jobs queued by an environment that is gone
+bool sodium_async_channel_begin(AsyncChannel* channel);
+
+// Hand a job back to its environment, unless the environment is gone. In
+// that case the worker, which holds references into it, is left behind
+void sodium_async_channel_send(AsyncChannel* channel, SodiumAsyncWorker* worker);
+
+// Hand back a job that began, letting teardown go on once none are running
+void sodium_async_channel_end(AsyncChannel* channel, SodiumAsyncWorker* worker);
+
+// Give back the hold of a job once the pool is done with it
+void sodium_async_channel_release(AsyncChannel* channel);
+
+#endif
@@ -0,0 +1,322 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_BATCH_STREAM_H__
+#define __SODIUM_BATCH_STREAM_H__
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+
+/**
+ * Streamed batches
+ *
+ * The `_batch_async` and `_each_async` bindings settle once the whole batch
+ * is done, so with 100k items the first result waits for the last one, and
+ * every output is held until then. A streamed batch hands its results back
+ * a chunk of items at a time, in order, as soon as each chunk is done:
+ *
+ *     options.onChunk(start, results)
+ *
+ * is called on the JS thread with the index of the chunk's first item and
+ * an Array of that chunk's results. The job then resolves, or calls back,
+ * with the number of items that failed, once every chunk has been
+ * delivered.
+ *
+ * Chunks go through a thread safe function whose queue holds at most
+ * SODIUM_STREAM_QUEUE of them: when JavaScript falls that far behind, the
+ * pool thread waits for it instead of piling up outputs. Only the chunks in
+ * that queue are held natively; each is wiped once it has been copied into
+ * its Buffer.
+ *
+ * Options, next to the usual `signal`, `deadline`, `timeout` and
+ * `priority`:
+ *
+ *   onChunk    function called for each chunk, required
+ *   chunkSize  items per chunk, SODIUM_STREAM_DEFAULT_CHUNK by default
+ *   threads    threads the kernel may split each chunk across, 1 by default
+ *
+ * A cancelled job stops between chunks. Chunks already delivered stay
+ * delivered.
+ */
+#define SODIUM_STREAM_DEFAULT_CHUNK 1024
+#define SODIUM_STREAM_QUEUE 4
+
+// Results of a streamed batch: a view of each item's output, or null for
+// the items that failed, or just true and false
+enum SodiumStreamResult {
+    STREAM_RESULT_BUFFERS,
+    STREAM_RESULT_BOOLEANS
+};
+
+// One chunk of results on its way to the JS thread
+struct SodiumStreamChunk {
+    size_t start;
+    std::vector<unsigned char> ok;
+    std::vector<size_t> sizes;
+    std::vector<unsigned char> data;
+
+    ~SodiumStreamChunk() {
+        if( !data.empty() ) {
+            sodium_memzero(data.data(), data.size());
+        }
+    }
+};
+
+// The stream options of a binding's arguments
+struct SodiumStreamOptions {
+    Napi::Value on_chunk;
+    size_t chunk_size;
+    size_t threads;
+};
+
+/**
+ * Read the stream options from the options object of `info`, the last
+ * argument or the one before a callback. Throws and returns false when
+ * onChunk is missing or a number is out of range. Read them before the
+ * worker is made, so a bad call leaves nothing behind
+ */
+inline bool sodium_stream_options(const Napi::CallbackInfo& info, SodiumStreamOptions& options) {
+    Napi::Env env = info.Env();
+    size_t argc = info.Length();
+    size_t last = argc > 0 && info[argc - 1].IsFunction() ? argc - 1 : argc;
+
+    options.on_chunk = env.Undefined();
+    options.chunk_size = SODIUM_STREAM_DEFAULT_CHUNK;
+    options.threads = 1;
+    if( last > 0 && sodium_async_is_options(info[last - 1]) ) {
+        Napi::Object o = info[last - 1].As<Napi::Object>();
+        Napi::Value size = o.Get("chunkSize");
+        Napi::Value threads = o.Get("threads");
+        options.on_chunk = o.Get("onChunk");
+        if( !size.IsUndefined() ) {
+            double v = size.IsNumber() ? size.As<Napi::Number>().DoubleValue() : 0;
+            if( !(v >= 1 && v <= 1e9) ) {
+                Napi::TypeError::New(env, "options.chunkSize must be a positive number of items")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            options.chunk_size = (size_t) v;
+        }
+        if( !threads.IsUndefined() ) {
+            double v = threads.IsNumber() ? threads.As<Napi::Number>().DoubleValue() : 0;
+            if( !(v >= 1 && v <= 1024) ) {
+                Napi::TypeError::New(env, "options.threads must be a number from 1 to 1024")
+                    .ThrowAsJavaScriptException();
+                return false;
+            }
+            options.threads = (size_t) v;
+        }
+    }
+    if( !options.on_chunk.IsFunction() ) {
+        Napi::TypeError::New(env, "options.onChunk must be a function").ThrowAsJavaScriptException();
+        return false;
+    }
+    return true;
+}
+
+// Read the stream options into NAME, or return null
+#define ARG_TO_STREAM_OPTIONS(NAME) \
+    SodiumStreamOptions NAME; \
+    if( !sodium_stream_options(info, NAME) ) { \
+        return NAPI_NULL; \
+    }
+
+class SodiumStreamWorker : public SodiumAsyncWorker {
+public:
+    /**
+     * Work out items [begin, end) of the batch: item `i` writes its
+     * `sizes[i]` bytes at `out`, the items back to back, and sets
+     * `ok[i - begin]`. Runs on a pool thread
+     */
+    typedef std::function<void(size_t begin, size_t end, unsigned char* out, unsigned char* ok)> Kernel;
+
+    SodiumStreamWorker(const Napi::CallbackInfo& info, const char* name, size_t count,
+                       SodiumStreamResult mode, const SodiumStreamOptions& options)
+        : SodiumAsyncWorker(info, name), sizes(count, 0), threads(options.threads), count(count),
+          mode(mode), chunk_size(options.chunk_size), on_chunk(options.on_chunk), chunks(NULL), failed(0) {
+        SuppressDestruct();
+    }
+
+    // Output bytes of each item, 0 for boolean results. Set before Stream()
+    std::vector<size_t> sizes;
+
+    // Threads the kernel may split a chunk across, from options.threads
+    size_t threads;
+
+    /**
+     * Queue `kernel`. Returns the Promise, or undefined when a callback was
+     * given. The worker must not be used after this call
+     */
+    Napi::Value Stream(Kernel kernel) {
+        Napi::Env env = Env();
+        if( OptionsFailed() ) {
+            // Throws the options error and deletes the worker
+            return Start(nullptr, ASYNC_RESULT_BUFFER);
+        }
+
+        napi_value resource_name = Napi::String::New(env, this->name);
+        if( napi_create_threadsafe_function(env, on_chunk, NULL, resource_name, SODIUM_STREAM_QUEUE, 1,
+                this, Finalize, this, CallChunk, &chunks) != napi_ok ) {
+            // Nothing to wait for: the job fails as soon as it runs
+            chunks = NULL;
+            released = true;
+            finalized = true;
+        }
+        this->kernel = kernel;
+        return Start(nullptr, ASYNC_RESULT_BUFFER);
+    }
+
+protected:
+    void Run() override {
+        if( chunks == NULL ) {
+            SetError("cannot create the chunk callback");
+            return;
+        }
+        for(size_t begin = 0; begin < count; begin += chunk_size) {
+            if( Cancelled() ) {
+                SetError("cancelled");
+                Release();
+                return;
+            }
+            size_t end = count - begin < chunk_size ? count : begin + chunk_size;
+            SodiumStreamChunk* chunk = new SodiumStreamChunk();
+            size_t bytes = 0;
+            chunk->start = begin;
+            chunk->ok.assign(end - begin, 0);
+            chunk->sizes.assign(sizes.begin() + begin, sizes.begin() + end);
+            for(size_t size : chunk->sizes) {
+                bytes += size;
+            }
+            chunk->data.resize(bytes);
+            kernel(begin, end, chunk->data.data(), chunk->ok.data());
+            for(unsigned char ok : chunk->ok) {
+                failed += ok ? 0 : 1;
+            }
+            // Waits while SODIUM_STREAM_QUEUE chunks are undelivered
+            if( napi_call_threadsafe_function(chunks, chunk, napi_tsfn_blocking) != napi_ok ) {
+                delete chunk;
+                SetError("environment is shutting down");
+                Release();
+                return;
+            }
+        }
+        status = 0;
+        Release();
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return Napi::Number::New(env, (double) failed);
+    }
+
+    // The job is done, but chunks may still be queued: settle once the
+    // thread safe function has delivered them all and is finalized. The
+    // worker deletes itself then, so not from inside OnOK() or OnError()
+    void OnWorkComplete(Napi::Env env, napi_status status) override {
+        SodiumAsyncWorker::OnWorkComplete(env, status);
+        completed = true;
+        Release();
+        if( finalized ) {
+            Settle();
+        }
+    }
+
+    void OnOK() override {}
+
+    void OnError(const Napi::Error& e) override {
+        error = e.Message();
+        if( error.empty() ) {
+            error = "failed";
+        }
+    }
+
+private:
+    // Once per job: from the pool thread when it is done, or from the JS
+    // thread for a job that never ran
+    void Release() {
+        if( !released.exchange(true) ) {
+            napi_release_threadsafe_function(chunks, napi_tsfn_release);
+        }
+    }
+
+    void Settle() {
+        Napi::HandleScope scope(Env());
+        if( error.empty() ) {
+            SodiumAsyncWorker::OnOK();
+        } else {
+            SodiumAsyncWorker::OnError(Napi::Error::New(Env(), error));
+        }
+        delete this;
+    }
+
+    static void Finalize(napi_env env, void* data, void* hint) {
+        SodiumStreamWorker* worker = (SodiumStreamWorker*) data;
+        worker->finalized = true;
+        if( worker->completed && env != NULL ) {
+            worker->Settle();
+        }
+    }
+
+    static void CallChunk(napi_env env, napi_value js_cb, void* context, void* data) {
+        SodiumStreamChunk* chunk = (SodiumStreamChunk*) data;
+        SodiumStreamWorker* worker = (SodiumStreamWorker*) context;
+        if( env == NULL || js_cb == NULL ) {
+            delete chunk;
+            return;
+        }
+
+        Napi::Env e(env);
+        Napi::HandleScope scope(e);
+        size_t n = chunk->ok.size();
+        Napi::Array results = Napi::Array::New(e, n);
+        if( worker->mode == STREAM_RESULT_BOOLEANS ) {
+            for(size_t i = 0; i < n; i++) {
+                results.Set((uint32_t) i, Napi::Boolean::New(e, chunk->ok[i] != 0));
+            }
+        } else {
+            // One Buffer per chunk, each result a view of it
+            Napi::Buffer<unsigned char> buffer = Napi::Buffer<unsigned char>::Copy(e,
+                chunk->data.data(), chunk->data.size());
+            Napi::Function subarray = buffer.Get("subarray").As<Napi::Function>();
+            size_t offset = 0;
+            for(size_t i = 0; i < n; i++) {
+                if( !chunk->ok[i] ) {
+                    results.Set((uint32_t) i, e.Null());
+                } else {
+                    results.Set((uint32_t) i, subarray.Call(buffer, {
+                        Napi::Number::New(e, (double) offset),
+                        Napi::Number::New(e, (double) (offset + chunk->sizes[i]))
+                    }));
+                }
+                offset += chunk->sizes[i];
+            }
+        }
+        napi_value argv[2] = { Napi::Number::New(e, (double) chunk->start), results };
+        delete chunk;
+        napi_value undefined;
+        napi_get_undefined(env, &undefined);
+        napi_call_function(env, undefined, js_cb, 2, argv, NULL);
+    }
+
+    Kernel kernel;
+    size_t count;
+    SodiumStreamResult mode;
+    size_t chunk_size;
+    napi_value on_chunk;
+    napi_threadsafe_function chunks;
+    std::atomic<bool> released{ false };
+    size_t failed;
+    bool completed = false;
+    bool finalized = false;
+    std::string error;
+};
+
+#endif
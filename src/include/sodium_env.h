@@ -0,0 +1,67 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_ENV_H__
+#define __SODIUM_ENV_H__
+
+#include "node_sodium.h"
+
+#if NAPI_VERSION < 6
+#error "node-sodium keeps per environment state and needs N-API version 6 or newer"
+#endif
+
+/**
+ * Per environment state
+ *
+ * The addon is loaded once per process but registered once per environment:
+ * the main thread and each worker thread get their own exports. Anything
+ * that holds JavaScript values, such as references to pooled slabs, belongs
+ * to one environment and lives here, never in a global. State shared by all
+ * threads, like libsodium itself, must be safe to use from all of them.
+ */
+
+struct SodiumPool;
+struct AsyncChannel;
+class SodiumArena;
+
+struct SodiumEnv {
+    // Output buffer pool, NULL until sodium_pool_enable is called
+    SodiumPool* pool;
+
+    // Object holding the hash state constructors, used by clone()
+    napi_ref hash_state_classes;
+
+    // HmacKey constructor, to tell HmacKeys in a keyring from raw keys
+    napi_ref hmac_key_class;
+
+    // Arena results are cut from, NULL unless one was entered. See
+    // sodium_arena.cc
+    SodiumArena* arena;
+
+    // Hands jobs finished on the addon's own thread pools back to this
+    // environment, NULL until the first one is queued
+    AsyncChannel* channel;
+
+    // Argument errors return null instead of throwing, see sodium_fast_fail
+    bool fast_fail;
+
+    // Message of the last argument error in fast fail mode, empty if none
+    std::string last_error;
+
+    static SodiumEnv* Get(Napi::Env env);
+};
+
+// Set up the state of a new environment, torn down with it
+void sodium_env_init(Napi::Env env);
+
+// Release the pool of an environment that is going away
+void sodium_pool_free(Napi::Env env, SodiumPool* pool);
+
+// A view of `size` bytes on `arena`, false when it has no room left
+bool sodium_arena_alloc(Napi::Env env, SodiumArena* arena, size_t size, Napi::Buffer<unsigned char>& out);
+
+#endif
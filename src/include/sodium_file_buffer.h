@@ -0,0 +1,102 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_FILE_BUFFER_H__
+#define __SODIUM_FILE_BUFFER_H__
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "node_sodium.h"
+
+/**
+ * Block size of the file jobs of sodium_file.cc and crypto_age.cc: files are
+ * read and written in pieces this large, and cancelled jobs stop between them
+ */
+#define FILE_DIGEST_BLOCK_SIZE (1024 * 1024)
+
+/**
+ * Two buffers handed between a producer and a consumer thread, in turns.
+ * Stop() wakes both sides and makes every wait return false
+ */
+class FileDoubleBuffer {
+public:
+    explicit FileDoubleBuffer(size_t size) {
+        for(int i = 0; i < 2; i++) {
+            slots[i].data.resize(size);
+        }
+    }
+
+    ~FileDoubleBuffer() {
+        for(int i = 0; i < 2; i++) {
+            sodium_memzero(slots[i].data.data(), slots[i].data.size());
+        }
+    }
+
+    unsigned char* Data(int i) { return slots[i].data.data(); }
+    size_t Size() const { return slots[0].data.size(); }
+    size_t Length(int i) const { return slots[i].length; }
+    bool Last(int i) const { return slots[i].last; }
+
+    // Producer: wait until slot `i` is free, false once stopped
+    bool WaitEmpty(int i) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this, i] { return !slots[i].full || stopped; });
+        return !stopped;
+    }
+
+    // Producer: hand slot `i` over with `length` bytes. `last` ends the file
+    void Fill(int i, size_t length, bool last) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            slots[i].length = length;
+            slots[i].last = last;
+            slots[i].full = true;
+        }
+        changed.notify_all();
+    }
+
+    // Consumer: wait until slot `i` is filled, false once stopped
+    bool WaitFull(int i) {
+        std::unique_lock<std::mutex> guard(lock);
+        changed.wait(guard, [this, i] { return slots[i].full || stopped; });
+        return !stopped;
+    }
+
+    // Consumer: give slot `i` back to the producer
+    void Empty(int i) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            slots[i].full = false;
+        }
+        changed.notify_all();
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopped = true;
+        }
+        changed.notify_all();
+    }
+
+private:
+    struct Slot {
+        std::vector<unsigned char> data;
+        size_t length = 0;
+        bool last = false;
+        bool full = false;
+    };
+
+    Slot slots[2];
+    std::mutex lock;
+    std::condition_variable changed;
+    bool stopped = false;
+};
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_FIXED_H__
+#define __SODIUM_FIXED_H__
+
+#include <string>
+
+#include "node_sodium.h"
+#include "sodium_stats.h"
+
+/*
+ * Fixed size fast paths, for payloads whose length is known when the addon
+ * is built: wrapped 32 byte keys, 64 byte session tokens. The generic
+ * bindings read an optional offset and length after the message, check
+ * every size against a run time value and decrypt through the thread's
+ * scratch block. Here the message, nonce and key sizes are template
+ * arguments, so the checks fold to constant compares done in one pass,
+ * plain text is opened into a stack block of exactly N bytes and the
+ * output Buffer is the only allocation.
+ *
+ * The results are byte for byte those of the generic bindings.
+ */
+
+// Sizes the `_32` and `_64` bindings are built for
+#define SODIUM_FIXED_SMALL 32
+#define SODIUM_FIXED_LARGE 64
+
+/**
+ * Read one argument per entry of SIZES, from `info[0]` on, into `out`. An
+ * entry that is 0 takes null or a buffer of any length, for the additional
+ * data, whose length goes to `ad_size`. Throws naming the first bad argument and returns false.
+ */
+template<size_t... SIZES>
+inline bool sodium_args_fixed(const Napi::CallbackInfo& info, const char* const* names,
+                              const unsigned char** out, unsigned long long* ad_size) {
+    static constexpr size_t sizes[] = { SIZES... };
+    const size_t count = sizeof sizes / sizeof sizes[0];
+    napi_env env = info.Env();
+
+    if( info.Length() < count ) {
+        sodium_throw(info.Env(), "expected " + std::to_string(count) + " arguments");
+        return false;
+    }
+    for(size_t i = 0; i < count; i++) {
+        void* data = NULL;
+        size_t size = 0;
+        if( sizes[i] == 0 && info[i].IsNull() ) {
+            out[i] = NULL;
+            *ad_size = 0;
+            continue;
+        }
+        if( !sodium_arg_bytes(env, info[i], &data, &size) ) {
+            sodium_throw(info.Env(), std::string("argument ") + names[i] + " must be a buffer");
+            return false;
+        }
+        if( sizes[i] == 0 ) {
+            *ad_size = size;
+        } else if( size != sizes[i] ) {
+            sodium_throw(info.Env(), std::string("argument ") + names[i] + " must be " +
+                         std::to_string(sizes[i]) + " bytes long");
+            return false;
+        }
+        out[i] = (const unsigned char*) data;
+    }
+    return true;
+}
+
+/**
+ * Combined mode AEAD encryption of exactly N bytes:
+ * (message, additionalData, nonce, key) => Buffer of N + ABYTES
+ *
+ * ALGO is a traits struct made by CRYPTO_AEAD_FIXED_DEF
+ */
+template<typename ALGO, size_t N>
+Napi::Value aead_encrypt_fixed(const Napi::CallbackInfo& info) {
+    static const char* const names[] = { "message", "additional data", "nonce", "key" };
+    const unsigned char* arg[4];
+    unsigned long long ad_size = 0;
+    if( !sodium_args_fixed<N, 0, ALGO::NPUBBYTES, ALGO::KEYBYTES>(info, names, arg, &ad_size) ) {
+        return info.Env().Null();
+    }
+
+    Napi::Buffer<unsigned char> c = sodium_new_buffer(info.Env(), N + ALGO::ABYTES);
+    unsigned long long clen;
+    if( SODIUM_STAT_AS(ALGO::STAT, N, N + ALGO::ABYTES,
+            ALGO::Encrypt(c.Data(), &clen, arg[0], N, arg[1], ad_size, NULL, arg[2], arg[3])) != 0 ) {
+        return info.Env().Null();
+    }
+    return c;
+}
+
+/**
+ * Combined mode AEAD decryption of exactly N + ABYTES bytes:
+ * (cipherText, additionalData, nonce, key) => Buffer of N, or null
+ */
+template<typename ALGO, size_t N>
+Napi::Value aead_decrypt_fixed(const Napi::CallbackInfo& info) {
+    static const char* const names[] = { "cipher text", "additional data", "nonce", "key" };
+    const unsigned char* arg[4];
+    unsigned long long ad_size = 0;
+    if( !sodium_args_fixed<N + ALGO::ABYTES, 0, ALGO::NPUBBYTES, ALGO::KEYBYTES>(info, names, arg, &ad_size) ) {
+        return info.Env().Null();
+    }
+
+    unsigned char m[N];
+    unsigned long long mlen;
+    if( SODIUM_STAT_AS(ALGO::STAT, N + ALGO::ABYTES, N,
+            ALGO::Decrypt(m, &mlen, NULL, arg[0], N + ALGO::ABYTES, arg[1], ad_size, arg[2], arg[3])) != 0 ) {
+        sodium_memzero(m, sizeof m);
+        return info.Env().Null();
+    }
+    Napi::Buffer<unsigned char> out = sodium_new_buffer(info.Env(), N);
+    memcpy(out.Data(), m, N);
+    sodium_memzero(m, sizeof m);
+    return out;
+}
+
+// Traits of one AEAD algorithm for the templates above, and its `_32` and
+// `_64` bindings
+#define CRYPTO_AEAD_FIXED_DEF(ALGO) \
+    struct aead_ ## ALGO ## _fixed { \
+        static const size_t NPUBBYTES = crypto_aead_ ## ALGO ## _NPUBBYTES; \
+        static const size_t KEYBYTES = crypto_aead_ ## ALGO ## _KEYBYTES; \
+        static const size_t ABYTES = crypto_aead_ ## ALGO ## _ABYTES; \
+        static const SodiumStatKind STAT = SODIUM_STAT_aead_ ## ALGO; \
+        static int Encrypt(unsigned char* c, unsigned long long* clen, const unsigned char* m, \
+                           unsigned long long mlen, const unsigned char* ad, unsigned long long adlen, \
+                           const unsigned char* nsec, const unsigned char* npub, const unsigned char* k) { \
+            return crypto_aead_ ## ALGO ## _encrypt(c, clen, m, mlen, ad, adlen, nsec, npub, k); \
+        } \
+        static int Decrypt(unsigned char* m, unsigned long long* mlen, unsigned char* nsec, \
+                           const unsigned char* c, unsigned long long clen, const unsigned char* ad, \
+                           unsigned long long adlen, const unsigned char* npub, const unsigned char* k) { \
+            return crypto_aead_ ## ALGO ## _decrypt(m, mlen, nsec, c, clen, ad, adlen, npub, k); \
+        } \
+    }; \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_32) { \
+        return aead_encrypt_fixed<aead_ ## ALGO ## _fixed, SODIUM_FIXED_SMALL>(info); \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_32) { \
+        return aead_decrypt_fixed<aead_ ## ALGO ## _fixed, SODIUM_FIXED_SMALL>(info); \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _encrypt_64) { \
+        return aead_encrypt_fixed<aead_ ## ALGO ## _fixed, SODIUM_FIXED_LARGE>(info); \
+    } \
+    NAPI_METHOD(crypto_aead_ ## ALGO ## _decrypt_64) { \
+        return aead_decrypt_fixed<aead_ ## ALGO ## _fixed, SODIUM_FIXED_LARGE>(info); \
+    }
+
+#define CRYPTO_AEAD_FIXED_EXPORT(ALGO) \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_32); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_32); \
+    EXPORT(crypto_aead_ ## ALGO ## _encrypt_64); \
+    EXPORT(crypto_aead_ ## ALGO ## _decrypt_64)
+
+/**
+ * crypto_secretbox_easy of exactly N bytes:
+ * (message, nonce, key) => Buffer of N + crypto_secretbox_MACBYTES
+ */
+template<size_t N>
+Napi::Value secretbox_easy_fixed(const Napi::CallbackInfo& info) {
+    static const char* const names[] = { "message", "nonce", "key" };
+    const unsigned char* arg[3];
+    if( !sodium_args_fixed<N, crypto_secretbox_NONCEBYTES, crypto_secretbox_KEYBYTES>(info, names, arg, NULL) ) {
+        return info.Env().Null();
+    }
+
+    Napi::Buffer<unsigned char> c = sodium_new_buffer(info.Env(), N + crypto_secretbox_MACBYTES);
+    if( SODIUM_STAT(secretbox, N, N + crypto_secretbox_MACBYTES,
+            crypto_secretbox_easy(c.Data(), arg[0], N, arg[1], arg[2])) != 0 ) {
+        return info.Env().Null();
+    }
+    return c;
+}
+
+/**
+ * crypto_secretbox_open_easy of exactly N + crypto_secretbox_MACBYTES bytes:
+ * (cipherText, nonce, key) => Buffer of N, or null
+ */
+template<size_t N>
+Napi::Value secretbox_open_easy_fixed(const Napi::CallbackInfo& info) {
+    static const char* const names[] = { "cipher text", "nonce", "key" };
+    const unsigned char* arg[3];
+    if( !sodium_args_fixed<N + crypto_secretbox_MACBYTES, crypto_secretbox_NONCEBYTES,
+                           crypto_secretbox_KEYBYTES>(info, names, arg, NULL) ) {
+        return info.Env().Null();
+    }
+
+    unsigned char m[N];
+    if( SODIUM_STAT(secretbox, N + crypto_secretbox_MACBYTES, N,
+            crypto_secretbox_open_easy(m, arg[0], N + crypto_secretbox_MACBYTES, arg[1], arg[2])) != 0 ) {
+        sodium_memzero(m, sizeof m);
+        return info.Env().Null();
+    }
+    Napi::Buffer<unsigned char> out = sodium_new_buffer(info.Env(), N);
+    memcpy(out.Data(), m, N);
+    sodium_memzero(m, sizeof m);
+    return out;
+}
+
+#endif
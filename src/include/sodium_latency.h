@@ -0,0 +1,20 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_LATENCY_H__
+#define __SODIUM_LATENCY_H__
+
+#include <cstdint>
+
+/**
+ * Add one async job of `name`, such as "crypto_pwhash", to the latency
+ * histograms: `wait_ns` between the binding queueing it and a thread
+ * starting it, `run_ns` on the thread. See sodium_latency.cc
+ */
+void sodium_latency_record(const char* name, uint64_t wait_ns, uint64_t run_ns);
+
+#endif
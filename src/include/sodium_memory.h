@@ -0,0 +1,96 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_MEMORY_H__
+#define __SODIUM_MEMORY_H__
+
+#include "node_sodium.h"
+#include "sodium_secure_slots.h"
+
+/**
+ * Memory accounting, see sodium_memory_usage in sodium_memory.cc
+ *
+ * Memory that the GC frees, the `sodium_malloc` Buffers and the keys and
+ * states of wrapped objects such as AeadContext, is also reported to V8 with
+ * napi_adjust_external_memory, so a heap of small objects holding pages of
+ * locked memory each gets collected. Caches and pools are only freed when
+ * they are disabled, and are counted without telling V8.
+ */
+
+/**
+ * Count `bytes` held by a wrapped object, negative once it lets them go,
+ * and report them to the GC of `env`
+ */
+void sodium_memory_hold(napi_env env, int64_t bytes);
+
+/**
+ * A `sodium_malloc` Buffer of `size` bytes, as made by the sodium_malloc
+ * binding, with its bytes in `data`. On failure `data` is NULL and a JS
+ * exception is pending
+ */
+Napi::Value sodium_secure_buffer(Napi::Env env, size_t size, unsigned char*& data);
+
+/**
+ * Secret memory of a wrapped object, see sodium_secure_pool.cc
+ *
+ * `sodium_secret_alloc` returns a slot of the secure pool when it is enabled
+ * and `size` fits, a `sodium_malloc` block otherwise, and holds its footprint
+ * with sodium_memory_hold. `sodium_secret_readonly` makes `sodium_malloc`
+ * blocks read only and leaves slots as they are. `sodium_secret_free` wipes
+ * and frees either kind, given the `size` it was allocated with.
+ */
+void* sodium_secret_alloc(napi_env env, size_t size);
+void sodium_secret_readonly(void* p);
+void sodium_secret_free(napi_env env, void* p, size_t size);
+
+// Give the secure pool, when it is on, an open region for the common key
+// sizes, so the first objects do not wait for sodium_malloc
+void sodium_secure_pool_warmup();
+
+/**
+ * Approximate heap bytes of an LRU cache kept as a list of entries and an
+ * index from `id_size` byte string ids to list positions
+ */
+template<typename LIST, typename INDEX>
+size_t sodium_lru_memory(const LIST& lru, const INDEX& index, size_t id_size) {
+    // Ids past the small string buffer have their own allocation
+    size_t id = id_size > 15 ? id_size + 1 : 0;
+    return lru.size() * (sizeof(typename LIST::value_type) + 2 * sizeof(void*) + id) +
+           index.size() * (sizeof(typename INDEX::value_type) + 2 * sizeof(void*) + id) +
+           index.bucket_count() * sizeof(void*);
+}
+
+// Bytes held by each cache and pool, each takes its own lock. Subsystems
+// left out of the build hold none
+#ifndef SODIUM_NO_BOX
+size_t crypto_box_cache_memory();
+#else
+inline size_t crypto_box_cache_memory() { return 0; }
+#endif
+size_t crypto_keypair_pool_memory();
+#ifndef SODIUM_NO_SIGN
+size_t crypto_sign_verify_cache_memory();
+size_t crypto_sign_curve25519_cache_memory();
+#else
+inline size_t crypto_sign_verify_cache_memory() { return 0; }
+inline size_t crypto_sign_curve25519_cache_memory() { return 0; }
+#endif
+#ifndef SODIUM_NO_HASH
+size_t crypto_hash_state_memory();
+#else
+inline size_t crypto_hash_state_memory() { return 0; }
+#endif
+#ifndef SODIUM_NO_PWHASH
+size_t sodium_pwhash_memory_pool_memory();
+#else
+inline size_t sodium_pwhash_memory_pool_memory() { return 0; }
+#endif
+size_t sodium_secure_pool_memory();
+size_t sodium_shared_cache_memory();
+size_t sodium_pool_memory(Napi::Env env);
+
+#endif
@@ -0,0 +1,40 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_PERF_COUNTERS_H__
+#define __SODIUM_PERF_COUNTERS_H__
+
+#include <cstdint>
+#include <string>
+
+/**
+ * Hardware counters of the calling thread, see sodium_perf_counters.cc
+ *
+ * Plain C++ without N-API, so bench/native links it as it is. sodium_bench.cc
+ * puts the bindings of bench/run.js on top.
+ *
+ * `sodium_perf_counters_open` opens the counters of the calling thread and
+ * returns false, with the reason in `error`, where they cannot be read: not
+ * Linux, no PMU in a virtual machine, or `kernel.perf_event_paranoid` above
+ * 2. `sodium_perf_counters_start` zeroes and starts them, and
+ * `sodium_perf_counters_stop` stops them and returns their counts since the
+ * start, scaled up when the kernel multiplexed them with other events.
+ */
+struct SodiumPerfCounts {
+    bool valid;
+    double cycles;
+    double instructions;
+    double cacheReferences;         // last level cache, -1 where the CPU
+    double cacheMisses;             // does not count it
+};
+
+bool sodium_perf_counters_open(std::string& error);
+void sodium_perf_counters_close();
+void sodium_perf_counters_start();
+SodiumPerfCounts sodium_perf_counters_stop();
+
+#endif
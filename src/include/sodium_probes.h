@@ -0,0 +1,47 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_PROBES_H__
+#define __SODIUM_PROBES_H__
+
+/**
+ * USDT probes of the `sodium` provider, for bpftrace, perf and SystemTap.
+ *
+ * Built in on Linux when <sys/sdt.h> is found (systemtap-sdt-dev or
+ * systemtap-sdt-devel), unless `SODIUM_NO_USDT` is defined. A probe that
+ * nothing is attached to is a single nop, plus loading its arguments.
+ *
+ *   call_start(name, kind, in)               before a counted libsodium call
+ *   call_done(name, kind, in, out, rc)       after it, `rc` 0 on success
+ *   job_queue(name, queue)                   async job queued: 1 libuv
+ *                                            threadpool, 2 password hashing
+ *                                            pool, 3 async scheduler
+ *   job_start(name, wait_ns)                 async job picked up by a thread
+ *   job_done(name, run_ns, status)           async job done on that thread
+ *
+ * `name` is a C string: the primitive of sodium_stats() for the call
+ * probes, the binding for the job probes. `kind` is its index in
+ * SODIUM_STAT_LIST.
+ */
+#if !defined(SODIUM_NO_USDT) && defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+#define SODIUM_USDT 1
+#endif
+#endif
+
+#ifdef SODIUM_USDT
+#define SODIUM_PROBE2(NAME, A, B) DTRACE_PROBE2(sodium, NAME, A, B)
+#define SODIUM_PROBE3(NAME, A, B, C) DTRACE_PROBE3(sodium, NAME, A, B, C)
+#define SODIUM_PROBE5(NAME, A, B, C, D, E) DTRACE_PROBE5(sodium, NAME, A, B, C, D, E)
+#else
+#define SODIUM_PROBE2(NAME, A, B) do {} while (0)
+#define SODIUM_PROBE3(NAME, A, B, C) do {} while (0)
+#define SODIUM_PROBE5(NAME, A, B, C, D, E) do {} while (0)
+#endif
+
+#endif
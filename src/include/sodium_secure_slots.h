@@ -0,0 +1,53 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_SECURE_SLOTS_H__
+#define __SODIUM_SECURE_SLOTS_H__
+
+#include <cstddef>
+
+// Page size assumed for the guard and canary pages of sodium_malloc
+#define SODIUM_PAGE_SIZE 4096
+
+// Bytes a sodium_malloc(size) allocation takes: its pages plus the guard
+// and canary pages libsodium puts around it
+inline size_t sodium_secure_footprint(size_t size) {
+    return ((size + SODIUM_PAGE_SIZE - 1) / SODIUM_PAGE_SIZE + 3) * SODIUM_PAGE_SIZE;
+}
+
+/**
+ * Slot allocator of the secure pool, see sodium_secure_slots.cc
+ *
+ * Plain C++ over libsodium, without N-API, so bench/native links it as it
+ * is. sodium_secure_pool.cc puts the memory accounting and the bindings on
+ * top.
+ *
+ * `sodium_slot_alloc` returns a slot of at least `size` bytes and sets
+ * `footprint` to its bytes, or NULL if the pool is off, `size` is over
+ * SODIUM_SLOT_MAX or no region could be made. `sodium_slot_free` checks the
+ * canary, wipes and gives back a slot, and returns false if `p` is not one.
+ */
+#define SODIUM_SLOT_MAX 1024
+
+struct SodiumSlotStats {
+    bool enabled;
+    size_t regions;
+    size_t slots;                   // slots in use
+    size_t used;                    // their bytes, canaries included
+    size_t bytes;                   // bytes of the regions, guard pages included
+};
+
+void* sodium_slot_alloc(size_t size, size_t& footprint);
+bool sodium_slot_free(void* p);
+bool sodium_slot_owns(const void* p);
+size_t sodium_slot_size(size_t size);
+void sodium_slots_enable();
+void sodium_slots_disable();
+void sodium_slots_warmup();
+SodiumSlotStats sodium_slots_stats();
+
+#endif
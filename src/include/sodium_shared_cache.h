@@ -0,0 +1,64 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_SHARED_CACHE_H__
+#define __SODIUM_SHARED_CACHE_H__
+
+#include <string>
+
+#include "node_sodium.h"
+
+#define SHARED_CACHE_IDBYTES 16
+#define SHARED_CACHE_FORMATBYTES 16
+
+struct SharedCache;
+
+/**
+ * Map the shared memory cache segment `name`, creating it with room for
+ * `capacity` values of `value_size` bytes if no process has yet.
+ *
+ * `format` identifies what the values are. A segment created with another
+ * format or value size is refused, so that builds with different internal
+ * layouts never read each other's values.
+ *
+ * Returns NULL with a message in `error` on failure.
+ */
+SharedCache* shared_cache_open(const char* name, size_t value_size, size_t capacity,
+                               const unsigned char* format, std::string& error);
+
+/**
+ * Unmap the segment. Other processes keep using it.
+ */
+void shared_cache_close(SharedCache* cache);
+
+/**
+ * Compute the index of a value from its inputs, keyed with the segment key
+ * every process attached to it shares.
+ */
+void shared_cache_id(const SharedCache* cache, unsigned char* id,
+                     const unsigned char* a, size_t a_size,
+                     const unsigned char* b, size_t b_size);
+
+/**
+ * Copy the value for `id` to `value`. Returns false on a miss, or when a
+ * writer holds the slot.
+ */
+bool shared_cache_get(SharedCache* cache, const unsigned char* id, unsigned char* value);
+
+/**
+ * Store the value for `id`, evicting the least recently used entry of its
+ * bucket. Skipped if another writer holds the slot.
+ */
+void shared_cache_put(SharedCache* cache, const unsigned char* id, const unsigned char* value);
+
+/**
+ * `{ name, capacity, size, locked, hits, misses, inserts, evictions }`.
+ * `size` is read from the segment, the counters are this process's.
+ */
+Napi::Object shared_cache_stats(Napi::Env env, SharedCache* cache);
+
+#endif
@@ -0,0 +1,54 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_SNAPSHOT_H__
+#define __SODIUM_SNAPSHOT_H__
+
+#include <string>
+
+#include "node_sodium.h"
+
+#define SNAPSHOT_KEYBYTES crypto_aead_xchacha20poly1305_ietf_KEYBYTES
+#define SNAPSHOT_KINDBYTES 32
+
+/**
+ * Encrypted snapshot files, see sodium_snapshot.cc
+ *
+ * A snapshot is a fixed layout body, a prefix then `count` records of
+ * `record_size` bytes, sealed under a 32 byte key. `kind` names what the
+ * records are, so a file of one kind is never loaded as another.
+ */
+struct SodiumSnapshot {
+    unsigned char* body;        // prefix then records, in secret memory
+    size_t size;
+    size_t prefix_size;
+    size_t record_size;
+    uint64_t count;
+    double created;             // epoch milliseconds
+};
+
+/**
+ * Seal `body` into the file `path`, replaced as a whole: the file is
+ * written next to it and renamed over it. Returns an empty string, or the
+ * error
+ */
+std::string sodium_snapshot_save(const std::string& path, const char* kind, const unsigned char* body,
+                                 size_t prefix_size, size_t record_size, uint64_t count,
+                                 const unsigned char* key);
+
+/**
+ * Map the file `path`, check it is a snapshot of `kind` with a prefix of
+ * `prefix_size` bytes, and open its body straight into secret memory.
+ * Returns an empty string, or the error. Release the body with
+ * sodium_snapshot_release
+ */
+std::string sodium_snapshot_load(napi_env env, const std::string& path, const char* kind,
+                                 size_t prefix_size, const unsigned char* key, SodiumSnapshot& snapshot);
+
+void sodium_snapshot_release(napi_env env, SodiumSnapshot& snapshot);
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_STATS_H__
+#define __SODIUM_STATS_H__
+
+#include <atomic>
+#include <cstdint>
+
+#include "node_sodium.h"
+#include "sodium_probes.h"
+
+// Primitives with their own counters, in the order sodium_stats() lists them
+#define SODIUM_STAT_LIST(X) \
+    X(aead_aes256gcm) \
+    X(aead_chacha20poly1305) \
+    X(aead_chacha20poly1305_ietf) \
+    X(aead_xchacha20poly1305_ietf) \
+    X(box) \
+    X(secretbox) \
+    X(sign) \
+    X(verify) \
+    X(hash) \
+    X(pwhash) \
+    X(random)
+
+enum SodiumStatKind {
+#define SODIUM_STAT_ENUM(NAME) SODIUM_STAT_ ## NAME,
+    SODIUM_STAT_LIST(SODIUM_STAT_ENUM)
+#undef SODIUM_STAT_ENUM
+    SODIUM_STAT_COUNT
+};
+
+struct SodiumStatCounters {
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> bytes_in;
+    std::atomic<uint64_t> bytes_out;
+    std::atomic<uint64_t> failures;
+};
+
+/**
+ * Counters of the calling thread. Only that thread writes them, so adding
+ * is a plain load and store; sodium_stats() reads every thread's block.
+ * See sodium_stats.cc
+ */
+SodiumStatCounters* sodium_stats_local();
+
+inline void sodium_stat_add(std::atomic<uint64_t>& counter, uint64_t n) {
+    counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+// Name of `kind`, as sodium_stats() lists it
+inline const char* sodium_stat_name(SodiumStatKind kind) {
+    static const char* const names[] = {
+#define SODIUM_STAT_NAME(NAME) #NAME,
+        SODIUM_STAT_LIST(SODIUM_STAT_NAME)
+#undef SODIUM_STAT_NAME
+    };
+    return names[kind];
+}
+
+// Fires the call_start probe of sodium_probes.h
+inline void sodium_stat_start(SodiumStatKind kind, uint64_t in) {
+    SODIUM_PROBE3(call_start, sodium_stat_name(kind), (int) kind, in);
+}
+
+/**
+ * Count a call of `kind` that read `in` bytes and, when `rc` is 0, wrote
+ * `out`. Returns `rc`, so a libsodium call can be wrapped where it stands:
+ *
+ *     if( SODIUM_STAT(secretbox, m_size, c_size, crypto_secretbox_easy(...)) == 0 )
+ *
+ * The call_start and call_done probes fire around the call.
+ */
+inline int sodium_stat(SodiumStatKind kind, uint64_t in, uint64_t out, int rc) {
+    SODIUM_PROBE5(call_done, sodium_stat_name(kind), (int) kind, in, out, rc);
+    SodiumStatCounters& c = sodium_stats_local()[kind];
+    sodium_stat_add(c.calls, 1);
+    sodium_stat_add(c.bytes_in, in);
+    if( rc == 0 ) {
+        sodium_stat_add(c.bytes_out, out);
+    } else {
+        sodium_stat_add(c.failures, 1);
+    }
+    return rc;
+}
+
+#define SODIUM_STAT(KIND, IN, OUT, CALL) \
+    SODIUM_STAT_AS(SODIUM_STAT_ ## KIND, IN, OUT, CALL)
+
+// SODIUM_STAT with a SodiumStatKind value, for code that picks the kind
+// at run time
+#define SODIUM_STAT_AS(KIND, IN, OUT, CALL) \
+    (sodium_stat_start((KIND), (IN)), sodium_stat((KIND), (IN), (OUT), (CALL)))
+
+#endif
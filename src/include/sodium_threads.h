@@ -0,0 +1,76 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#ifndef __SODIUM_THREADS_H__
+#define __SODIUM_THREADS_H__
+
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+
+/**
+ * Pool thread placement
+ *
+ * The password hashing pool and the async scheduler can pin their threads
+ * to a list of CPUs: slot `i` of a pool runs on `cpus[i % cpus.length]`.
+ * Listing the CPUs of one NUMA node keeps the threads, and the memory they
+ * fault in, on that node. Each slot also counts its jobs and where they ran,
+ * so locality can be checked from JavaScript.
+ *
+ * SodiumThreadSlots is not locked on its own: every call is made with the
+ * lock of the pool that owns it held.
+ */
+
+// CPU and NUMA node the calling thread is on, -1 for what is not known
+void sodium_thread_where(int& cpu, int& node);
+
+struct SodiumThreadSlot {
+    bool used = false;
+    size_t placed = 0;          // generation of the CPU list last applied
+    int pinned = -1;            // CPU the thread is pinned to, or -1
+    int cpu = -1;               // where the last job ran
+    int node = -1;
+    double jobs = 0;
+    double busy = 0;            // ms spent running jobs
+};
+
+class SodiumThreadSlots {
+public:
+    // A slot for a new thread
+    size_t Take();
+
+    // The thread of `slot` exits
+    void Free(size_t slot);
+
+    // Apply the CPU list to the calling thread if it changed since the last
+    // call from `slot`. Called by the thread before each job
+    void Place(size_t slot);
+
+    // The thread of `slot` ran a job for `ms` milliseconds
+    void Record(size_t slot, double ms);
+
+    /**
+     * Read a `cpus` option: an array of CPU numbers, or null to let the
+     * threads run anywhere again. Returns false and sets `error` when it is
+     * not valid. Applied when each thread picks up its next job
+     */
+    bool Configure(Napi::Value cpus, std::string& error);
+
+    // `[{ pinned, cpu, node, jobs, busy }]`, one per running thread
+    Napi::Value Stats(Napi::Env env);
+
+    // The configured CPUs, or null
+    Napi::Value Cpus(Napi::Env env);
+
+private:
+    std::vector<SodiumThreadSlot> slots;
+    std::vector<int> cpus;
+    size_t generation = 1;
+};
+
+#endif
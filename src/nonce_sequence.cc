@@ -0,0 +1,142 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstring>
+
+#include "node_sodium.h"
+#include "nonce_sequence.h"
+
+/**
+ * NonceSequence:
+ * Counter nonces for a key that is used by a single sender
+ *
+ * Gives out `start`, `start + 1`, `start + 2` and so on, incremented with
+ * `sodium_increment` (little endian, like `sodium.increment`). Unlike random
+ * nonces they never collide, but only as long as one sequence is the only
+ * user of the key.
+ *
+ *     var nonces = new sodium.NonceSequence(sizeOrStart);
+ *
+ * ~ sizeOrStart (Number|Buffer): nonce length in bytes, to start from zero,
+ *   or the first nonce. The sequence keeps its own copy
+ *
+ * Methods:
+ *
+ * ~ next(): issue the next nonce. The same Buffer is returned on every call
+ *   and overwritten by the next one, so copy it if it must be kept. Throws
+ *   when the counter would come back to the first nonce
+ * ~ current(): copy of the last nonce issued, or null before the first
+ *
+ * A sequence can also be given to `AeadContext`, which then takes its
+ * nonces from it.
+ *
+ * **Sample**:
+ *
+ *     var nonces = new sodium.NonceSequence(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES);
+ *     var c = sodium.crypto_aead_chacha20poly1305_ietf_encrypt(m, ad, nonces.next(), key);
+ */
+
+static const napi_type_tag nonce_sequence_tag = {
+    0x6e6f6e6365736571ULL, 0x7565e1c2b0f1a35dULL
+};
+
+void NonceSequence::Init(Napi::Env env, Napi::Object exports) {
+    Napi::Function ctor = DefineClass(env, "NonceSequence", {
+        InstanceMethod("next", &NonceSequence::Next),
+        InstanceMethod("current", &NonceSequence::Current)
+    });
+    exports.Set(Napi::String::New(env, "NonceSequence"), ctor);
+}
+
+NonceSequence* NonceSequence::From(Napi::Value value) {
+    bool tagged = false;
+    if( !value.IsObject() ||
+        napi_check_object_type_tag(value.Env(), value, &nonce_sequence_tag, &tagged) != napi_ok ||
+        !tagged ) {
+        return NULL;
+    }
+    return NonceSequence::Unwrap(value.As<Napi::Object>());
+}
+
+NonceSequence::NonceSequence(const Napi::CallbackInfo& info)
+    : Napi::ObjectWrap<NonceSequence>(info), view(NULL), size(0), started(false) {
+    Napi::Env env = info.Env();
+
+    unsigned char* start = NULL;
+    if( info.Length() > 0 && info[0].IsNumber() ) {
+        size = info[0].As<Napi::Number>().Uint32Value();
+    } else if( info.Length() == 0 || !sodium_arg_bytes(info[0], start, size) ) {
+        Napi::TypeError::New(env, "argument must be: nonce size or first nonce").ThrowAsJavaScriptException();
+        return;
+    }
+    if( size == 0 || size > NONCE_SEQUENCE_MAX_BYTES ) {
+        Napi::RangeError::New(env, "nonce size must be between 1 and 64 bytes").ThrowAsJavaScriptException();
+        return;
+    }
+
+    if( start != NULL ) {
+        memcpy(counter, start, size);
+    } else {
+        memset(counter, 0, size);
+    }
+    memcpy(first, counter, size);
+
+    Napi::Buffer<unsigned char> nonce = Napi::Buffer<unsigned char>::New(env, size);
+    view = nonce.Data();
+    memcpy(view, counter, size);
+    buffer.Reset(nonce, 1);
+
+    napi_type_tag_object(env, info.This(), &nonce_sequence_tag);
+}
+
+bool NonceSequence::Peek(unsigned char* out) const {
+    memcpy(out, counter, size);
+    if( !started ) {
+        return true;
+    }
+    sodium_increment(out, size);
+    return memcmp(out, first, size) != 0;
+}
+
+void NonceSequence::Commit(const unsigned char* nonce) {
+    memcpy(counter, nonce, size);
+    memcpy(view, nonce, size);
+    started = true;
+}
+
+Napi::Value NonceSequence::Next(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if( view == NULL ) {
+        THROW_ERROR("NonceSequence was not initialized");
+    }
+    unsigned char next[NONCE_SEQUENCE_MAX_BYTES];
+    if( !Peek(next) ) {
+        THROW_ERROR("nonce sequence is exhausted");
+    }
+    Commit(next);
+
+    return buffer.Value();
+}
+
+Napi::Value NonceSequence::Current(const Napi::CallbackInfo& info) {
+    Napi::Env env = info.Env();
+
+    if( view == NULL || !started ) {
+        return NAPI_NULL;
+    }
+    NEW_BUFFER_AND_PTR(nonce, size);
+    memcpy(nonce_ptr, counter, size);
+    return nonce;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_nonce_sequence(Napi::Env env, Napi::Object exports) {
+    NonceSequence::Init(env, exports);
+}
@@ -5,7 +5,19 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <atomic>
+#include <cstring>
+#include <string>
+
+#if !defined(_WIN32)
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 #include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "sodium_stats.h"
 
 // Generating Random Data
 // Docs: https://download.libsodium.org/doc/generating_random_data/index.html
@@ -20,14 +32,480 @@ NAPI_METHOD(randombytes_buf) {
 
     ARG_TO_UCHAR_BUFFER(buffer);
     randombytes_buf(buffer, buffer_size);
+    SODIUM_STAT(random, 0, buffer_size, 0);
+
+    return NAPI_NULL;
+}
+
+// Buffered random source
+//
+// Each thread keeps a block of randombytes_buf output and serves small
+// requests from it, so generating a 24 byte nonce does not cost a call into
+// the system random generator. Served bytes are wiped from the block at
+// once. randombytes_stir and randombytes_close drop every thread's block.
+#define RANDOM_BLOCK_SIZE 16384
+
+static std::atomic<unsigned long> random_generation(0);
+
+struct RandomBlock {
+    unsigned char bytes[RANDOM_BLOCK_SIZE];
+    size_t used = RANDOM_BLOCK_SIZE;
+    unsigned long generation = 0;
+
+    ~RandomBlock() {
+        sodium_memzero(bytes, sizeof bytes);
+    }
+};
+
+static void randombytes_buf_buffered(unsigned char* buf, size_t size) {
+    if( size >= RANDOM_BLOCK_SIZE / 4 ) {
+        randombytes_buf(buf, size);
+        return;
+    }
+
+    static thread_local RandomBlock block;
+    unsigned long generation = random_generation.load();
+    if( block.generation != generation ) {
+        sodium_memzero(block.bytes, sizeof block.bytes);
+        block.used = RANDOM_BLOCK_SIZE;
+        block.generation = generation;
+    }
+
+    while( size > 0 ) {
+        if( block.used == RANDOM_BLOCK_SIZE ) {
+            randombytes_buf(block.bytes, RANDOM_BLOCK_SIZE);
+            block.used = 0;
+        }
+        size_t n = RANDOM_BLOCK_SIZE - block.used;
+        if( n > size ) {
+            n = size;
+        }
+        memcpy(buf, block.bytes + block.used, n);
+        sodium_memzero(block.bytes + block.used, n);
+        block.used += n;
+        buf += n;
+        size -= n;
+    }
+}
+
+/**
+ * randombytes_buf_buffered:
+ * Fill a buffer with random bytes, like `randombytes_buf`, from a block
+ * of random data refilled only once every 16 KiB
+ *
+ *     sodium.randombytes_buf_buffered(nonce);
+ *
+ * ~ buffer (Buffer): buffer to fill. Buffers of 4 KiB or more are filled
+ *   directly by `randombytes_buf`
+ */
+NAPI_METHOD(randombytes_buf_buffered) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument must be a buffer");
+    ARG_TO_UCHAR_BUFFER(buffer);
+    randombytes_buf_buffered(buffer, buffer_size);
+    SODIUM_STAT(random, 0, buffer_size, 0);
 
     return NAPI_NULL;
 }
 
+// Fast key erasure ChaCha20 generator
+//
+// A randombytes implementation for libsodium: each thread keeps a ChaCha20
+// key seeded from the system generator (getrandom where there is one) and
+// expands it a block at a time. The first 32 bytes of every block replace
+// the key and the rest are served and wiped as they go, so the state never
+// holds a byte that was handed out, nor the key that made it. A thread
+// reseeds on first use, after randombytes_stir or randombytes_close, and in
+// a forked child, so parent and child never share a stream.
+#define RANDOM_CHACHA_BLOCK 512
+
+static std::atomic<unsigned long> random_chacha_generation(1);
+
+struct RandomChaCha {
+    unsigned char key[crypto_stream_chacha20_KEYBYTES];
+    unsigned char bytes[RANDOM_CHACHA_BLOCK];
+    size_t used = RANDOM_CHACHA_BLOCK;
+    unsigned long generation = 0;
+#if !defined(_WIN32)
+    pid_t pid = 0;
+#endif
+
+    ~RandomChaCha() {
+        sodium_memzero(key, sizeof key);
+        sodium_memzero(bytes, sizeof bytes);
+    }
+
+    void Refill() {
+        static const unsigned char nonce[crypto_stream_chacha20_NONCEBYTES] = { 0 };
+        crypto_stream_chacha20(bytes, sizeof bytes, nonce, key);
+        memcpy(key, bytes, sizeof key);
+        sodium_memzero(bytes, sizeof key);
+        used = sizeof key;
+    }
+
+    void Take(unsigned char* buf, size_t size) {
+        while( size > 0 ) {
+            if( used == RANDOM_CHACHA_BLOCK ) {
+                Refill();
+            }
+            size_t n = RANDOM_CHACHA_BLOCK - used;
+            if( n > size ) {
+                n = size;
+            }
+            memcpy(buf, bytes + used, n);
+            sodium_memzero(bytes + used, n);
+            used += n;
+            buf += n;
+            size -= n;
+        }
+    }
+};
+
+static RandomChaCha& random_chacha_state() {
+    static thread_local RandomChaCha state;
+    unsigned long generation = random_chacha_generation.load();
+    bool reseed = state.generation != generation;
+#if !defined(_WIN32)
+    // A child forked by a native library skips the atfork handler of a
+    // process that forked before it was installed, the pid still tells
+    pid_t pid = getpid();
+    reseed = reseed || state.pid != pid;
+    state.pid = pid;
+#endif
+    if( reseed ) {
+        randombytes_sysrandom_implementation.buf(state.key, sizeof state.key);
+        sodium_memzero(state.bytes, sizeof state.bytes);
+        state.used = RANDOM_CHACHA_BLOCK;
+        state.generation = generation;
+    }
+    return state;
+}
+
+static const char* random_chacha_name() {
+    return "chacha20";
+}
+
+static void random_chacha_buf(void* const buf, const size_t size) {
+    RandomChaCha& state = random_chacha_state();
+    if( size < RANDOM_CHACHA_BLOCK ) {
+        state.Take((unsigned char*) buf, size);
+        return;
+    }
+
+    // Large requests get a key of their own, erased from the state, and
+    // its stream is written straight into the buffer
+    static const unsigned char nonce[crypto_stream_chacha20_NONCEBYTES] = { 0 };
+    unsigned char key[crypto_stream_chacha20_KEYBYTES];
+    state.Take(key, sizeof key);
+    crypto_stream_chacha20((unsigned char*) buf, size, nonce, key);
+    sodium_memzero(key, sizeof key);
+}
+
+static uint32_t random_chacha_random() {
+    uint32_t r;
+    random_chacha_buf(&r, sizeof r);
+    return r;
+}
+
+static void random_chacha_stir() {
+    random_chacha_generation++;
+}
+
+static int random_chacha_close() {
+    random_chacha_generation++;
+    return 0;
+}
+
+static randombytes_implementation random_chacha_implementation = {
+    random_chacha_name, random_chacha_random, random_chacha_stir, NULL, random_chacha_buf, random_chacha_close
+};
+
+#if !defined(_WIN32)
+static void random_chacha_atfork_child() {
+    random_chacha_generation++;
+    random_generation++;
+}
+#endif
+
+/**
+ * randombytes_set_implementation:
+ * Choose the generator behind every random byte of the addon: keys, nonces,
+ * salts and `randombytes_*`
+ *
+ *     sodium.randombytes_set_implementation('chacha20');
+ *
+ * ~ name (String): `sysrandom`, libsodium's default, asks the system for
+ *   every request; `salsa20`, libsodium's own buffered generator, expands a
+ *   system seed with Salsa20; `chacha20` keeps a fast key erasure ChaCha20
+ *   generator per thread, seeded from the system generator and reseeded in
+ *   forked children and by `randombytes_stir`
+ *
+ * The implementation is shared by every thread of the process: choose it
+ * at startup, before other threads generate keys. `randombytes_buf_buffered`
+ * blocks drawn from the previous generator are dropped.
+ */
+NAPI_METHOD(randombytes_set_implementation) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument name must be a string");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument name must be a string");
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+
+    randombytes_implementation* implementation;
+    if( name == "sysrandom" ) {
+        implementation = &randombytes_sysrandom_implementation;
+    } else if( name == "salsa20" ) {
+        implementation = &randombytes_salsa20_implementation;
+    } else if( name == "chacha20" ) {
+        implementation = &random_chacha_implementation;
+#if !defined(_WIN32)
+        static bool atfork = false;
+        if( !atfork ) {
+            pthread_atfork(NULL, NULL, random_chacha_atfork_child);
+            atfork = true;
+        }
+#endif
+    } else {
+        THROW_ERROR("unknown randombytes implementation " + name +
+                    ", expected sysrandom, salsa20 or chacha20");
+    }
+
+    randombytes_set_implementation(implementation);
+    randombytes_stir();
+    random_generation++;
+
+    return NAPI_NULL;
+}
+
+/**
+ * randombytes_implementation_name:
+ * Name of the current random generator, as given to
+ * `randombytes_set_implementation`
+ */
+NAPI_METHOD(randombytes_implementation_name) {
+    Napi::Env env = info.Env();
+
+    return Napi::String::New(env, randombytes_implementation_name());
+}
+
+/**
+ * randombytes_buf_batch:
+ * Generate `count` random values of `size` bytes in one call
+ *
+ *     var nonces = sodium.randombytes_buf_batch(
+ *                      1000,
+ *                      sodium.crypto_secretbox_NONCEBYTES);
+ *
+ * ~ count (Number): number of values
+ * ~ size (Number): size of each value in bytes
+ *
+ * **Returns**:
+ *
+ * ~ buffer (Buffer): `count * size` bytes, value `i` at `i * size`
+ */
+NAPI_METHOD(randombytes_buf_batch) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments count and size must be numbers");
+    ARG_TO_NUMBER(count);
+    ARG_TO_NUMBER(size);
+    if( size != 0 && count > SIZE_MAX / size ) {
+        THROW_ERROR("count * size is too big");
+    }
+
+    NEW_BUFFER_AND_PTR(values, count * size);
+    randombytes_buf_buffered(values_ptr, count * size);
+    SODIUM_STAT(random, 0, count * size, 0);
+
+    return values;
+}
+
+// Random 32 bit words, drawn from the buffered source a block at a time
+struct RandomWords {
+    uint32_t words[256];
+    size_t next = 256;
+
+    ~RandomWords() {
+        sodium_memzero(words, sizeof words);
+    }
+
+    uint32_t Next() {
+        if( next == 256 ) {
+            randombytes_buf_buffered((unsigned char*) words, sizeof words);
+            next = 0;
+        }
+        return words[next++];
+    }
+
+    // Uniform in [0, upper), rejecting the same words randombytes_uniform does
+    uint32_t Uniform(uint32_t upper) {
+        if( upper < 2 ) {
+            return 0;
+        }
+        uint32_t min = (1U + ~upper) % upper;
+        uint32_t r;
+        do {
+            r = Next();
+        } while( r < min );
+        return r % upper;
+    }
+};
+
+// Typed array argument: its type, number of elements and data
+#define ARG_TO_TYPED_ARRAY(NAME) \
+    napi_typedarray_type NAME ## _type; \
+    size_t NAME ## _length = 0; \
+    void* NAME ## _data = NULL; \
+    if( !info[_arg].IsTypedArray() || \
+        napi_get_typedarray_info(env, info[_arg], &NAME ## _type, &NAME ## _length, \
+                                 &NAME ## _data, NULL, NULL) != napi_ok ) { \
+        THROW_ERROR("argument " #NAME " must be a typed array"); \
+    } \
+    Napi::Value NAME = info[_arg]; \
+    _arg++
+
+/**
+ * randombytes_random_fill:
+ * Fill a Uint32Array with random values, like `randombytes_random` for each
+ * element, in one call
+ *
+ *     var values = sodium.randombytes_random_fill(new Uint32Array(1000000));
+ *
+ * ~ array (Uint32Array): array to fill
+ *
+ * **Returns**:
+ *
+ * ~ Uint32Array: `array`
+ */
+NAPI_METHOD(randombytes_random_fill) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument array must be a Uint32Array");
+    ARG_TO_TYPED_ARRAY(array);
+    if( array_type != napi_uint32_array ) {
+        THROW_ERROR("argument array must be a Uint32Array");
+    }
+
+    randombytes_buf_buffered((unsigned char*) array_data, array_length * sizeof(uint32_t));
+    SODIUM_STAT(random, 0, array_length * sizeof(uint32_t), 0);
+    return array;
+}
+
+/**
+ * randombytes_uniform_fill:
+ * Fill a Uint32Array with values between 0 and `upperBound` (excluded),
+ * like `randombytes_uniform` for each element, in one call
+ *
+ *     var ids = sodium.randombytes_uniform_fill(new Uint32Array(1000), 1000000);
+ *
+ * ~ array (Uint32Array): array to fill
+ * ~ upperBound (Number): up to 2^32 - 1. Values are uniform, not biased by
+ *   a modulo. An `upperBound` under 2 fills the array with zeros
+ *
+ * **Returns**:
+ *
+ * ~ Uint32Array: `array`
+ */
+NAPI_METHOD(randombytes_uniform_fill) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments array must be a Uint32Array and upperBound a number");
+    ARG_TO_TYPED_ARRAY(array);
+    if( array_type != napi_uint32_array ) {
+        THROW_ERROR("argument array must be a Uint32Array");
+    }
+    ARG_TO_NUMBER(upper_bound);
+    if( upper_bound > UINT32_MAX ) {
+        THROW_ERROR("argument upperBound must be at most 2^32 - 1");
+    }
+
+    uint32_t* values = (uint32_t*) array_data;
+    uint32_t upper = (uint32_t) upper_bound;
+    if( upper < 2 ) {
+        memset(values, 0, array_length * sizeof(uint32_t));
+        return array;
+    }
+
+    // Draw every value at once and only redraw the rare rejected ones
+    randombytes_buf_buffered((unsigned char*) values, array_length * sizeof(uint32_t));
+    RandomWords words;
+    uint32_t min = (1U + ~upper) % upper;
+    for(size_t i = 0; i < array_length; i++) {
+        while( values[i] < min ) {
+            values[i] = words.Next();
+        }
+        values[i] %= upper;
+    }
+    SODIUM_STAT(random, 0, array_length * sizeof(uint32_t), 0);
+    return array;
+}
+
+/**
+ * randombytes_shuffle:
+ * Shuffle a typed array in place, with a Fisher-Yates shuffle driven by the
+ * system random generator
+ *
+ *     var order = new Uint32Array(deck.length).map(function(v, i) { return i; });
+ *     sodium.randombytes_shuffle(order);
+ *
+ * ~ array (TypedArray): any typed array or Buffer, of less than 2^32
+ *   elements. Every order of the elements is equally likely
+ *
+ * **Returns**:
+ *
+ * ~ TypedArray: `array`
+ */
+NAPI_METHOD(randombytes_shuffle) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument array must be a typed array");
+    ARG_TO_TYPED_ARRAY(array);
+    if( array_length > UINT32_MAX ) {
+        THROW_ERROR("argument array cannot have more than 2^32 - 1 elements");
+    }
+
+    size_t element;
+    switch( array_type ) {
+        case napi_int8_array:
+        case napi_uint8_array:
+        case napi_uint8_clamped_array:
+            element = 1;
+            break;
+        case napi_int16_array:
+        case napi_uint16_array:
+            element = 2;
+            break;
+        case napi_int32_array:
+        case napi_uint32_array:
+        case napi_float32_array:
+            element = 4;
+            break;
+        default:
+            element = 8;
+    }
+
+    unsigned char* data = (unsigned char*) array_data;
+    unsigned char tmp[8];
+    RandomWords words;
+    for(size_t i = array_length; i > 1; i--) {
+        size_t j = words.Uniform((uint32_t) i);
+        if( j != i - 1 ) {
+            memcpy(tmp, data + j * element, element);
+            memcpy(data + j * element, data + (i - 1) * element, element);
+            memcpy(data + (i - 1) * element, tmp, element);
+        }
+    }
+    return array;
+}
+
 // void randombytes_stir()
 NAPI_METHOD(randombytes_stir) {
     Napi::Env env = info.Env();
     randombytes_stir();
+    random_generation++;
 
     return NAPI_NULL;
 }
@@ -35,6 +513,8 @@ NAPI_METHOD(randombytes_stir) {
 NAPI_METHOD(randombytes_close) {
     Napi::Env env = info.Env();
 
+    random_generation++;
+
     // int randombytes_close()
     return 
         Napi::Number::New(env, randombytes_close());
@@ -67,14 +547,209 @@ NAPI_METHOD(randombytes_keygen) {
 }
 */
 
+// Nonce libsodium's randombytes_buf_deterministic uses with the seed as a
+// crypto_stream_chacha20_ietf key
+static const unsigned char random_deterministic_nonce[crypto_stream_chacha20_ietf_NONCEBYTES] = {
+    'L', 'i', 'b', 's', 'o', 'd', 'i', 'u', 'm', 'D', 'R', 'G'
+};
+
+// Bytes of one seed's stream, 2^32 blocks of 64 bytes
+#define RANDOM_DETERMINISTIC_MAX_BYTES (1ULL << 38)
+
+/**
+ * Write bytes `position` to `position + size` of the stream of
+ * `randombytes_buf_deterministic(seed)` to `buf`. Pieces of
+ * SODIUM_ASYNC_CHUNK_SIZE bytes are generated in place, on up to `threads`
+ * threads, each from its own block counter. Returns false if `worker` was
+ * cancelled
+ */
+static bool random_deterministic_fill(unsigned char* buf, size_t size, uint64_t position,
+                                      const unsigned char* seed, size_t threads,
+                                      SodiumAsyncWorker* worker) {
+    uint64_t block = position / 64;
+    size_t skip = (size_t) (position % 64);
+    size_t head = 0;
+
+    if( skip != 0 && size != 0 ) {
+        unsigned char ks[64];
+        memset(ks, 0, sizeof ks);
+        crypto_stream_chacha20_ietf_xor_ic(ks, ks, sizeof ks, random_deterministic_nonce,
+                                           (uint32_t) block, seed);
+        head = 64 - skip < size ? 64 - skip : size;
+        memcpy(buf, ks + skip, head);
+        sodium_memzero(ks, sizeof ks);
+        block++;
+    }
+
+    std::atomic<bool> stopped(false);
+    size_t pieces = (size - head + SODIUM_ASYNC_CHUNK_SIZE - 1) / SODIUM_ASYNC_CHUNK_SIZE;
+    sodium_batch_parallel(pieces, threads, 1, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end && !stopped; i++) {
+            if( worker != NULL && worker->Cancelled() ) {
+                stopped = true;
+                break;
+            }
+            size_t from = head + i * SODIUM_ASYNC_CHUNK_SIZE;
+            size_t length = size - from < SODIUM_ASYNC_CHUNK_SIZE ? size - from : SODIUM_ASYNC_CHUNK_SIZE;
+            memset(buf + from, 0, length);
+            crypto_stream_chacha20_ietf_xor_ic(buf + from, buf + from, length, random_deterministic_nonce,
+                (uint32_t) (block + i * (SODIUM_ASYNC_CHUNK_SIZE / 64)), seed);
+        }
+    });
+    return !stopped;
+}
+
+// `threads` option of the async fills, left as it is when not given
+static bool random_option_threads(Napi::Object options, size_t& threads) {
+    Napi::Value value = options.Get("threads");
+    if( value.IsUndefined() ) {
+        return true;
+    }
+    if( !value.IsNumber() || !(value.As<Napi::Number>().DoubleValue() >= 1) ) {
+        return false;
+    }
+    threads = (size_t) value.As<Napi::Number>().DoubleValue();
+    return true;
+}
+
+/**
+ * randombytes_buf_deterministic:
+ * Pseudo random bytes that only depend on a seed
+ *
+ *     sodium.randombytes_buf_deterministic(buffer, seed);
+ *
+ * ~ buffer (Buffer): filled in place, can be given as (buffer, offset,
+ *   length), so no zero buffer or second copy is needed
+ * ~ seed (Buffer): `randombytes_SEEDBYTES` seed
+ *
+ * **Returns**:
+ *
+ * ~ Buffer: `buffer`. The same seed always gives the same bytes, on every
+ *   platform
+ */
 NAPI_METHOD(randombytes_buf_deterministic) {
     Napi::Env env = info.Env();
-    
+
     ARGS(2, "arguments buf and seed must be buffers");
-    ARG_TO_UCHAR_BUFFER(buffer);
+    ARG_TO_UCHAR_BUFFER_RANGE(out);
     ARG_TO_UCHAR_BUFFER_LEN(seed, randombytes_SEEDBYTES);
-    randombytes_buf_deterministic(buffer, buffer_size, seed);
-    return NAPI_NULL;
+    if( out_size > RANDOM_DETERMINISTIC_MAX_BYTES ) {
+        THROW_ERROR("size cannot be bigger than 2^38 bytes");
+    }
+
+    randombytes_buf_deterministic(out, out_size, seed);
+    return out_buffer;
+}
+
+/**
+ * randombytes_buf_deterministic_async:
+ * Same as `randombytes_buf_deterministic`, on the threadpool, for large
+ * sizes
+ *
+ *     await sodium.randombytes_buf_deterministic_async(
+ *               buffer,
+ *               seed,
+ *               [options],
+ *               [callback]);
+ *
+ * ~ buffer (Buffer): filled in place, can be given as (buffer, offset,
+ *   length). The Promise resolves to it
+ * ~ seed (Buffer): `randombytes_SEEDBYTES` seed
+ * ~ options (Object): optional, the cancel options of every async call, plus
+ *   - `position` (Number): offset of the first byte in the seed's stream, so
+ *     a large stream can be generated a piece at a time. Default 0
+ *   - `threads` (Number): generate 1MB pieces on this many threads of their
+ *     own. Default 1
+ *
+ * With a `position`, the buffer gets the same bytes as that slice of a
+ * buffer of `position + buffer.length` bytes filled from the same seed.
+ */
+NAPI_METHOD(randombytes_buf_deterministic_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments buf and seed must be buffers");
+    ARG_TO_UCHAR_BUFFER_RANGE(out);
+    ARG_TO_UCHAR_BUFFER_LEN(seed, randombytes_SEEDBYTES);
+
+    uint64_t position = 0;
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && sodium_async_is_options(info[_arg]) ) {
+        Napi::Object options = info[_arg].As<Napi::Object>();
+        Napi::Value value = options.Get("position");
+        if( !value.IsUndefined() ) {
+            if( !SODIUM_ARG_IS_INTEGER(value) ) {
+                THROW_ERROR("option position must be a number");
+            }
+            if( !sodium_arg_uint64(value, "position", RANDOM_DETERMINISTIC_MAX_BYTES, position) ) {
+                return NAPI_NULL;
+            }
+        }
+        if( !random_option_threads(options, threads) ) {
+            THROW_ERROR("option threads must be a positive number");
+        }
+    }
+    if( out_size > RANDOM_DETERMINISTIC_MAX_BYTES - position ) {
+        THROW_ERROR("position + size cannot be bigger than 2^38 bytes");
+    }
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "randombytes_buf_deterministic");
+    worker->Pin(out_buffer);
+    unsigned char* buf = out;
+    size_t size = out_size;
+    const unsigned char* key = worker->Copy(seed, randombytes_SEEDBYTES);
+    return worker->Start([=]() {
+        return random_deterministic_fill(buf, size, position, key, threads, worker) ? 0 : -1;
+    }, ASYNC_RESULT_BUFFER);
+}
+
+/**
+ * randombytes_buf_async:
+ * Fill a buffer with random bytes on the threadpool
+ *
+ *     await sodium.randombytes_buf_async(buffer, [options], [callback]);
+ *
+ * ~ buffer (Buffer): filled in place, can be given as (buffer, offset,
+ *   length). The Promise resolves to it
+ * ~ options (Object): optional, the cancel options of every async call, plus
+ *   - `threads` (Number): fill 1MB pieces on this many threads of their own.
+ *     Default 1
+ *
+ * The bytes are a ChaCha20 key stream, as `randombytes_buf_deterministic`,
+ * under a seed drawn from `randombytes_buf` for each call and wiped once
+ * the buffer is full. Pieces are generated from their own block counters,
+ * so threads share nothing and the fill runs at memory speed. Up to 2^38
+ * bytes per call.
+ */
+NAPI_METHOD(randombytes_buf_async) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument must be a buffer");
+    ARG_TO_UCHAR_BUFFER_RANGE(out);
+
+    size_t threads = 1;
+    if( info.Length() > (size_t) _arg && sodium_async_is_options(info[_arg]) ) {
+        if( !random_option_threads(info[_arg].As<Napi::Object>(), threads) ) {
+            THROW_ERROR("option threads must be a positive number");
+        }
+    }
+    if( out_size > RANDOM_DETERMINISTIC_MAX_BYTES ) {
+        THROW_ERROR("size cannot be bigger than 2^38 bytes");
+    }
+
+    SodiumAsyncWorker* worker = new SodiumAsyncWorker(info, "randombytes_buf");
+    worker->Pin(out_buffer);
+    unsigned char* buf = out;
+    size_t size = out_size;
+
+    unsigned char seed[randombytes_SEEDBYTES];
+    randombytes_buf(seed, sizeof seed);
+    const unsigned char* key = worker->Copy(seed, sizeof seed);
+    sodium_memzero(seed, sizeof seed);
+    SODIUM_STAT(random, 0, out_size, 0);
+
+    return worker->Start([=]() {
+        return random_deterministic_fill(buf, size, 0, key, threads, worker) ? 0 : -1;
+    }, ASYNC_RESULT_BUFFER);
 }
 
 /**
@@ -89,6 +764,15 @@ void register_randombytes(Napi::Env env, Napi::Object exports) {
     EXPORT(randombytes_random);
     EXPORT(randombytes_uniform);
     EXPORT(randombytes_buf_deterministic);
+    EXPORT(randombytes_buf_deterministic_async);
+    EXPORT(randombytes_buf_async);
+    EXPORT(randombytes_buf_buffered);
+    EXPORT(randombytes_buf_batch);
+    EXPORT(randombytes_random_fill);
+    EXPORT(randombytes_uniform_fill);
+    EXPORT(randombytes_shuffle);
+    EXPORT(randombytes_set_implementation);
+    EXPORT(randombytes_implementation_name);
 
     EXPORT_INT(randombytes_SEEDBYTES);
 }
\ No newline at end of file
@@ -5,47 +5,164 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <mutex>
+
 #include "node_sodium.h"
 #include "node_sodium_register.h"
+#include "sodium_env.h"
+
+static std::once_flag sodium_once;
+static int sodium_status = -1;
+
+SodiumEnv* SodiumEnv::Get(Napi::Env env) {
+    void* data = NULL;
+    napi_get_instance_data(env, &data);
+    return (SodiumEnv*) data;
+}
+
+static void sodium_env_finalize(napi_env env, void* data, void* hint) {
+    SodiumEnv* state = (SodiumEnv*) data;
+    if( state->pool != NULL ) {
+        sodium_pool_free(Napi::Env(env), state->pool);
+    }
+    if( state->hash_state_classes != NULL ) {
+        napi_delete_reference(env, state->hash_state_classes);
+    }
+    if( state->hmac_key_class != NULL ) {
+        napi_delete_reference(env, state->hmac_key_class);
+    }
+    delete state;
+}
+
+void sodium_env_init(Napi::Env env) {
+    SodiumEnv* state = new SodiumEnv();
+    state->pool = NULL;
+    state->arena = NULL;
+    state->hash_state_classes = NULL;
+    state->hmac_key_class = NULL;
+    state->channel = NULL;
+    state->fast_fail = false;
+    napi_set_instance_data(env, state, sodium_env_finalize, NULL);
+}
 
 Napi::Object RegisterModule(Napi::Env env, Napi::Object exports) {
 //void RegisterModule(Handle<Object> target) {
-    // init sodium library before we do anything
-    if( sodium_init() == -1 ) {
+    // init sodium library before we do anything. Every worker thread that
+    // loads the addon registers it again, but the process wide random
+    // generator must only be set up once, not while other threads use it
+    std::call_once(sodium_once, []() {
+        sodium_status = sodium_init();
+        if( sodium_status != -1 ) {
+            randombytes_stir();
+        }
+    });
+    if( sodium_status == -1 ) {
         Napi::Error::New(env, "libsodium cannot be initialized!").ThrowAsJavaScriptException();
         return Napi::Object::New(env);
     }
 
-    randombytes_stir();
+    sodium_env_init(env);
 
     register_helpers(env, exports);
     register_runtime(env, exports);
+    register_sodium_pool(env, exports);
+    register_sodium_stats(env, exports);
+    register_sodium_latency(env, exports);
+    register_sodium_memory(env, exports);
+    register_sodium_secure_pool(env, exports);
+    register_sodium_arena(env, exports);
+    register_sodium_bench(env, exports);
+    register_sodium_file(env, exports);
+    register_sodium_chunker(env, exports);
+    register_sodium_log(env, exports);
+    register_sodium_async_scheduler(env, exports);
+    register_sodium_ring(env, exports);
+    register_sodium_pipeline(env, exports);
+    register_sodium_shared_cache(env, exports);
+    register_sodium_snapshot(env, exports);
     register_randombytes(env, exports);
+    register_crypto_keypair_pool(env, exports);
+
+    // Subsystems, see lib/subsystems.js
+#ifndef SODIUM_NO_PWHASH
+    register_sodium_pwhash_pool(env, exports);
+    register_sodium_pwhash_memory(env, exports);
     register_crypto_pwhash_algos(env, exports);
     register_crypto_pwhash(env, exports);
+#endif
+#ifndef SODIUM_NO_HASH
     register_crypto_hash(env, exports);
     register_crypto_hash_sha256(env, exports);
     register_crypto_hash_sha512(env, exports);
     register_crypto_shorthash(env, exports);
     register_crypto_shorthash_siphash24(env, exports);
+    register_crypto_shorthash_filter(env, exports);
     register_crypto_generichash(env, exports);
     register_crypto_generichash_blake2b(env, exports);
+    register_crypto_generichash_index(env, exports);
+    register_crypto_hash_state(env, exports);
+    register_crypto_merkle(env, exports);
+#endif
+#ifndef SODIUM_NO_AUTH
     register_crypto_auth_algos(env, exports);
     register_crypto_auth(env, exports);
+    register_crypto_auth_key(env, exports);
     register_crypto_onetimeauth(env, exports);
     register_crypto_onetimeauth_poly1305(env, exports);
+#endif
+#ifndef SODIUM_NO_STREAM
     register_crypto_stream(env, exports);
     register_crypto_streams(env, exports);
+    register_crypto_stream_keystream(env, exports);
+#endif
+#ifndef SODIUM_NO_SECRETBOX
     register_crypto_secretbox(env, exports);
     register_crypto_secretbox_xsalsa20poly1305(env, exports);
+    register_crypto_secretbox_xchacha20poly1305(env, exports);
+#endif
+#ifndef SODIUM_NO_SIGN
     register_crypto_sign(env, exports);
+    register_crypto_paseto(env, exports);
     register_crypto_sign_ed25519(env, exports);
+    register_crypto_sign_context(env, exports);
+    register_crypto_sign_verify_cache(env, exports);
+    register_crypto_sign_curve25519_cache(env, exports);
+#endif
+#ifndef SODIUM_NO_BOX
     register_crypto_box(env, exports);
+    register_crypto_box_session(env, exports);
+    register_crypto_box_multi(env, exports);
+    register_crypto_box_cache(env, exports);
+    register_crypto_box_signed(env, exports);
+    register_crypto_age(env, exports);
     register_crypto_box_curve25519xsalsa20poly1305(env, exports);
+    register_crypto_box_curve25519xchacha20poly1305(env, exports);
+#endif
+#ifndef SODIUM_NO_KX
     register_crypto_scalarmult(env, exports);
     register_crypto_scalarmult_curve25519(env, exports);
+    register_crypto_kx(env, exports);
+    register_crypto_noise(env, exports);
+    register_crypto_ratchet(env, exports);
+#endif
+#ifndef SODIUM_NO_KDF
+    register_crypto_kdf(env, exports);
+    register_crypto_kdf_tree(env, exports);
     register_crypto_core(env, exports);
+#endif
+#ifndef SODIUM_NO_AEAD
     register_crypto_aead(env, exports);
+    register_crypto_aead_context(env, exports);
+    register_crypto_aead_envelope(env, exports);
+    register_crypto_aead_convergent(env, exports);
+    register_crypto_aead_column(env, exports);
+    register_crypto_aead_transport(env, exports);
+    register_crypto_aead_packet(env, exports);
+    register_nonce_sequence(env, exports);
+#endif
+#ifndef SODIUM_NO_SECRETSTREAM
+    register_crypto_secretstream(env, exports);
+#endif
     
     return exports;
 }
@@ -0,0 +1,185 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+#include "sodium_env.h"
+
+// Results start on a 16 byte boundary, as they do in the output pool
+#define ARENA_ALIGN 16
+#define ARENA_MAX_SIZE 0x7fffffff
+
+/**
+ * Arena:
+ * Request scoped output buffer
+ *
+ * A request handler making a dozen calls gets a dozen Buffers, each its own
+ * allocation with a finalizer, all dead once the response is sent. While an
+ * Arena is entered, results of sync calls are instead views on its one
+ * backing Buffer, cut one after the other, and `reset` takes them all back
+ * in one call.
+ *
+ *    var arena = new sodium.Arena(size);
+ *
+ * ~ size (Number): bytes of the backing Buffer
+ *
+ * Methods:
+ *
+ * ~ enter(): makes it the current arena of this thread, until `exit`.
+ *   Arenas nest: `exit` makes the one entered before current again
+ * ~ exit(): throws unless it is the current arena
+ * ~ reset([wipe]): makes the whole buffer free again, wiping the bytes used
+ *   so far if `wipe` is true. Returns the bytes that were used
+ * ~ stats(): `{ size, used, allocations, overflows }`. Results that did
+ *   not fit in the space left were allocated on their own and are counted
+ *   as `overflows`
+ *
+ * Views still point into the arena after `reset`: the next request writes
+ * over them. Copy any result that must outlive the request, and never hand
+ * `buffer.buffer` of a result to code that should not see the others.
+ * Async calls allocate their results on their own.
+ *
+ * **Sample**:
+ *
+ *     var arena = new sodium.Arena(4096);
+ *     arena.enter();
+ *     try {
+ *         var tag = sodium.crypto_auth(message, key);  // view on the arena
+ *         ...
+ *     } finally {
+ *         arena.exit();
+ *         arena.reset(true);
+ *     }
+ */
+class SodiumArena : public Napi::ObjectWrap<SodiumArena> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "Arena", {
+            InstanceMethod("enter", &SodiumArena::Enter),
+            InstanceMethod("exit", &SodiumArena::Exit),
+            InstanceMethod("reset", &SodiumArena::Reset),
+            InstanceMethod("stats", &SodiumArena::Stats)
+        });
+        exports.Set(Napi::String::New(env, "Arena"), ctor);
+    }
+
+    SodiumArena(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<SodiumArena>(info), data(NULL), size(0), used(0),
+          allocations(0), overflows(0), entered(false), previous(NULL) {
+        Napi::Env env = info.Env();
+
+        uint64_t bytes = 0;
+        if( info.Length() < 1 || !SODIUM_ARG_IS_INTEGER(info[0]) ) {
+            Napi::TypeError::New(env, "argument size must be a positive integer").ThrowAsJavaScriptException();
+            return;
+        }
+        if( !sodium_arg_uint64(info[0], "size", ARENA_MAX_SIZE, bytes) ) {
+            return;
+        }
+        if( bytes == 0 ) {
+            Napi::TypeError::New(env, "argument size must be a positive integer").ThrowAsJavaScriptException();
+            return;
+        }
+        size = (size_t) bytes;
+
+        Napi::Buffer<unsigned char> buffer = Napi::Buffer<unsigned char>::New(env, size);
+        data = buffer.Data();
+        backing = Napi::Persistent(buffer);
+        subarray = Napi::Persistent(buffer.Get("subarray").As<Napi::Function>());
+    }
+
+    /**
+     * A view of `length` bytes on the arena, false when it does not fit
+     */
+    bool Alloc(Napi::Env env, size_t length, Napi::Buffer<unsigned char>& out) {
+        size_t start = (used + ARENA_ALIGN - 1) & ~((size_t) ARENA_ALIGN - 1);
+        if( length == 0 || start > size || length > size - start ) {
+            overflows++;
+            return false;
+        }
+        Napi::Value view = subarray.Value().Call(backing.Value(), {
+            Napi::Number::New(env, (double) start),
+            Napi::Number::New(env, (double) (start + length))
+        });
+        used = start + length;
+        allocations++;
+        out = Napi::Buffer<unsigned char>(env, view);
+        return true;
+    }
+
+private:
+    Napi::Value Enter(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if( entered ) {
+            THROW_ERROR("Arena was already entered");
+        }
+        SodiumEnv* state = SodiumEnv::Get(env);
+        previous = state->arena;
+        state->arena = this;
+        entered = true;
+        // Keep it alive while results may be cut from it
+        Ref();
+        return info.This();
+    }
+
+    Napi::Value Exit(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        SodiumEnv* state = SodiumEnv::Get(env);
+        if( state->arena != this ) {
+            THROW_ERROR("Arena is not the current arena");
+        }
+        state->arena = previous;
+        previous = NULL;
+        entered = false;
+        Unref();
+        return env.Undefined();
+    }
+
+    Napi::Value Reset(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        size_t was = used;
+        if( info.Length() > 0 && info[0].ToBoolean() ) {
+            sodium_memzero(data, used);
+        }
+        used = 0;
+        return Napi::Number::New(env, (double) was);
+    }
+
+    Napi::Value Stats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        Napi::Object result = Napi::Object::New(env);
+        result.Set(Napi::String::New(env, "size"), Napi::Number::New(env, (double) size));
+        result.Set(Napi::String::New(env, "used"), Napi::Number::New(env, (double) used));
+        result.Set(Napi::String::New(env, "allocations"), Napi::Number::New(env, allocations));
+        result.Set(Napi::String::New(env, "overflows"), Napi::Number::New(env, overflows));
+        return result;
+    }
+
+    Napi::ObjectReference backing;
+    Napi::FunctionReference subarray;
+    unsigned char* data;
+    size_t size;
+    size_t used;
+    double allocations;
+    double overflows;
+    bool entered;
+    SodiumArena* previous;
+};
+
+bool sodium_arena_alloc(Napi::Env env, SodiumArena* arena, size_t size, Napi::Buffer<unsigned char>& out) {
+    return arena->Alloc(env, size, out);
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_arena(Napi::Env env, Napi::Object exports) {
+    SodiumArena::Init(env, exports);
+}
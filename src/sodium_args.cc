@@ -0,0 +1,29 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <string>
+
+#include "node_sodium_args.h"
+
+// Errors of SodiumArgs. Kept out of line so the templates that read
+// arguments stay small; these only run when an argument is wrong
+
+bool SodiumArgs::Fail(const char* usage) {
+    sodium_throw(info.Env(), usage);
+    return false;
+}
+
+bool SodiumArgs::FailType(const char* name) {
+    sodium_throw(info.Env(), std::string("argument \"") + name + "\" must be a buffer");
+    return false;
+}
+
+bool SodiumArgs::FailSize(const char* name, size_t expected, size_t got) {
+    sodium_throw(info.Env(), std::string("argument ") + name + " must be " +
+                 std::to_string(expected) + " bytes long, but got " + std::to_string(got));
+    return false;
+}
@@ -0,0 +1,115 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <condition_variable>
+#include <mutex>
+
+#include "node_sodium.h"
+#include "sodium_async_channel.h"
+#include "sodium_env.h"
+
+struct AsyncChannel {
+    std::mutex lock;
+    std::condition_variable idle;
+    napi_threadsafe_function complete;
+    bool open;          // false once the environment is being torn down
+    size_t users;       // the environment and each job queued from it
+    size_t running;     // jobs on a pool thread, writing to its buffers
+    size_t pending;     // jobs not completed yet, used on the JS thread only
+};
+
+void sodium_async_channel_release(AsyncChannel* channel) {
+    bool last;
+    {
+        std::lock_guard<std::mutex> guard(channel->lock);
+        last = --channel->users == 0;
+    }
+    if( last ) {
+        delete channel;
+    }
+}
+
+void sodium_async_channel_hold(AsyncChannel* channel) {
+    std::lock_guard<std::mutex> guard(channel->lock);
+    channel->users++;
+}
+
+bool sodium_async_channel_begin(AsyncChannel* channel) {
+    std::lock_guard<std::mutex> guard(channel->lock);
+    if( !channel->open ) {
+        return false;
+    }
+    channel->running++;
+    return true;
+}
+
+void sodium_async_channel_send(AsyncChannel* channel, SodiumAsyncWorker* worker) {
+    std::lock_guard<std::mutex> guard(channel->lock);
+    if( channel->open ) {
+        napi_call_threadsafe_function(channel->complete, worker, napi_tsfn_nonblocking);
+    }
+}
+
+void sodium_async_channel_end(AsyncChannel* channel, SodiumAsyncWorker* worker) {
+    sodium_async_channel_send(channel, worker);
+    std::lock_guard<std::mutex> guard(channel->lock);
+    if( --channel->running == 0 ) {
+        channel->idle.notify_all();
+    }
+}
+
+void sodium_async_channel_expect(Napi::Env env, AsyncChannel* channel) {
+    if( channel->pending++ == 0 ) {
+        napi_ref_threadsafe_function(env, channel->complete);
+    }
+}
+
+static void async_channel_complete(napi_env env, napi_value js_cb, void* context, void* data) {
+    if( env == NULL ) {
+        return;
+    }
+    SodiumAsyncWorker* worker = (SodiumAsyncWorker*) data;
+    worker->OnWorkComplete(Napi::Env(env), napi_ok);
+
+    AsyncChannel* channel = (AsyncChannel*) context;
+    if( --channel->pending == 0 ) {
+        napi_unref_threadsafe_function(env, channel->complete);
+    }
+}
+
+// Runs before the thread safe function is torn down, since cleanup hooks run
+// in reverse order and this one is added after it is created. Jobs still
+// queued are dropped, and teardown waits for the running ones, which write
+// to buffers the environment is about to free
+static void async_channel_close(void* data) {
+    AsyncChannel* channel = (AsyncChannel*) data;
+    {
+        std::unique_lock<std::mutex> guard(channel->lock);
+        channel->open = false;
+        channel->idle.wait(guard, [channel] { return channel->running == 0; });
+    }
+    sodium_async_channel_release(channel);
+}
+
+AsyncChannel* sodium_async_channel(Napi::Env env) {
+    SodiumEnv* state = SodiumEnv::Get(env);
+    if( state->channel == NULL ) {
+        AsyncChannel* channel = new AsyncChannel();
+        channel->open = true;
+        channel->users = 1;
+        channel->running = 0;
+        channel->pending = 0;
+
+        napi_value name = Napi::String::New(env, "sodium_async_channel");
+        napi_create_threadsafe_function(env, NULL, NULL, name, 0, 1, NULL, NULL,
+            channel, async_channel_complete, &channel->complete);
+        napi_unref_threadsafe_function(env, channel->complete);
+        napi_add_env_cleanup_hook(env, async_channel_close, channel);
+        state->channel = channel;
+    }
+    return state->channel;
+}
@@ -0,0 +1,369 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "sodium_async_channel.h"
+#include "sodium_threads.h"
+
+/**
+ * Async scheduler
+ *
+ * On the libuv threadpool a token check waits behind whatever was queued
+ * before it, so one backup job hashing a few gigabytes holds up every small
+ * AEAD call in the process. Async jobs given a `priority` option run here
+ * instead, on threads of their own shared by all the environments of the
+ * process, in one of two classes:
+ *
+ *   interactive  taken first whenever a thread is free
+ *   bulk         taken only while fewer than its `concurrency` bulk jobs
+ *                run, so the other threads are always there for interactive
+ *                work
+ *
+ * Each class has a bounded queue. A job that finds its queue full fails at
+ * once instead of waiting, which is the signal for the caller to back off;
+ * sodium_async_scheduler_stats() shows how close each queue is to its limit.
+ *
+ * Jobs are handed back through the environment's channel, and cancelled the
+ * same way as on the password hashing pool. The threads can be pinned to
+ * CPUs like the password hashing ones, see sodium_threads.h.
+ */
+
+#define SCHEDULER_DEFAULT_THREADS   4
+#define SCHEDULER_MAX_THREADS       64
+
+typedef std::chrono::steady_clock scheduler_clock;
+
+struct SchedulerTask {
+    SodiumAsyncWorker* worker;
+    AsyncChannel* channel;
+    scheduler_clock::time_point queued;
+};
+
+struct SchedulerClass {
+    const char* name;
+    std::deque<SchedulerTask> queue;
+
+    size_t concurrency;         // most jobs of the class running at once
+    size_t max_queue;
+    size_t running = 0;
+
+    double submitted = 0;
+    double completed = 0;
+    double rejected = 0;
+    double cancelled = 0;
+    double wait_total = 0;
+    double wait_max = 0;
+    size_t queue_peak = 0;
+};
+
+struct AsyncScheduler {
+    std::mutex lock;
+    std::condition_variable wake;
+
+    size_t threads = SCHEDULER_DEFAULT_THREADS;
+    size_t alive = 0;
+
+    // In the order threads look at them
+    SchedulerClass classes[ASYNC_PRIORITY_CLASSES];
+
+    SodiumThreadSlots slots;
+
+    AsyncScheduler() {
+        classes[ASYNC_PRIORITY_INTERACTIVE].name = "interactive";
+        classes[ASYNC_PRIORITY_INTERACTIVE].concurrency = SCHEDULER_DEFAULT_THREADS;
+        classes[ASYNC_PRIORITY_INTERACTIVE].max_queue = 1024;
+        classes[ASYNC_PRIORITY_BULK].name = "bulk";
+        classes[ASYNC_PRIORITY_BULK].concurrency = SCHEDULER_DEFAULT_THREADS / 2;
+        classes[ASYNC_PRIORITY_BULK].max_queue = 64;
+    }
+};
+
+// Never destroyed: the threads are detached and may still be waiting on the
+// condition variable while the process exits
+static AsyncScheduler& scheduler = *new AsyncScheduler();
+
+// The class the next job comes from, or NULL. The caps no longer apply once
+// the last thread is draining the queues. Called with the lock held
+static SchedulerClass* scheduler_next() {
+    bool draining = scheduler.alive > scheduler.threads && scheduler.alive == 1;
+    for( SchedulerClass& c : scheduler.classes ) {
+        if( !c.queue.empty() && (c.running < c.concurrency || draining) ) {
+            return &c;
+        }
+    }
+    return NULL;
+}
+
+static void scheduler_thread(size_t slot) {
+    std::unique_lock<std::mutex> guard(scheduler.lock);
+    for(;;) {
+        SchedulerClass* next = NULL;
+        scheduler.wake.wait(guard, [&next] {
+            next = scheduler_next();
+            return next != NULL || scheduler.alive > scheduler.threads;
+        });
+        // Surplus threads exit, but the last one stays until the queues are
+        // drained, so jobs queued before the scheduler was turned off still run
+        if( scheduler.alive > scheduler.threads && (next == NULL || scheduler.alive > 1) ) {
+            break;
+        }
+
+        SchedulerTask task = next->queue.front();
+        next->queue.pop_front();
+        next->running++;
+        scheduler.slots.Place(slot);
+
+        double waited = std::chrono::duration<double, std::milli>(scheduler_clock::now() - task.queued).count();
+        next->wait_total += waited;
+        if( waited > next->wait_max ) {
+            next->wait_max = waited;
+        }
+
+        guard.unlock();
+        bool run = sodium_async_channel_begin(task.channel);
+        bool cancelled = false;
+        scheduler_clock::time_point started = scheduler_clock::now();
+        if( run ) {
+            cancelled = task.worker->Cancelled();
+            task.worker->OnExecute(task.worker->Env());
+        }
+        double busy = std::chrono::duration<double, std::milli>(scheduler_clock::now() - started).count();
+        guard.lock();
+        next->running--;
+        scheduler.slots.Record(slot, busy);
+        if( cancelled ) {
+            next->cancelled++;
+        } else {
+            next->completed++;
+        }
+        guard.unlock();
+
+        if( run ) {
+            sodium_async_channel_end(task.channel, task.worker);
+        }
+        sodium_async_channel_release(task.channel);
+        guard.lock();
+    }
+    scheduler.alive--;
+    scheduler.slots.Free(slot);
+}
+
+// Start threads up to the configured limit. Called with the lock held
+static void scheduler_grow() {
+    while( scheduler.alive < scheduler.threads ) {
+        std::thread(scheduler_thread, scheduler.slots.Take()).detach();
+        scheduler.alive++;
+    }
+}
+
+Napi::Value SodiumAsyncWorker::StartScheduled(Job job, SodiumAsyncResult result) {
+    Napi::Env env = Env();
+
+    std::unique_lock<std::mutex> guard(scheduler.lock);
+    if( scheduler.threads == 0 ) {
+        guard.unlock();
+        priority = ASYNC_PRIORITY_NONE;
+        return Start(job, result);
+    }
+
+    SchedulerClass& c = scheduler.classes[priority];
+    AsyncChannel* channel = sodium_async_channel(env);
+    this->job = job;
+    this->result = result;
+    Napi::Value ret = deferred ? deferred->Promise() : env.Undefined();
+
+    sodium_async_channel_expect(env, channel);
+    c.submitted++;
+
+    if( c.max_queue > 0 && c.queue.size() >= c.max_queue ) {
+        // Fail without running, on a later turn of the event loop so that a
+        // callback is never called before the binding returns
+        c.rejected++;
+        guard.unlock();
+        SetError(std::string(c.name) + " queue is full");
+        sodium_async_channel_send(channel, this);
+        return ret;
+    }
+
+    sodium_async_channel_hold(channel);
+    queued = ASYNC_QUEUED_SCHEDULER;
+    submitted = std::chrono::steady_clock::now();
+    SODIUM_PROBE2(job_queue, name, queued);
+    c.queue.push_back({ this, channel, scheduler_clock::now() });
+    if( c.queue.size() > c.queue_peak ) {
+        c.queue_peak = c.queue.size();
+    }
+    scheduler_grow();
+    guard.unlock();
+    scheduler.wake.notify_one();
+
+    return ret;
+}
+
+bool SodiumAsyncWorker::DropScheduled() {
+    std::unique_lock<std::mutex> guard(scheduler.lock);
+    SchedulerClass& c = scheduler.classes[priority];
+    for(auto it = c.queue.begin(); it != c.queue.end(); ++it) {
+        if( it->worker != this ) {
+            continue;
+        }
+        AsyncChannel* channel = it->channel;
+        c.queue.erase(it);
+        c.cancelled++;
+        guard.unlock();
+
+        SetError("cancelled");
+        sodium_async_channel_send(channel, this);
+        sodium_async_channel_release(channel);
+        return true;
+    }
+    return false;
+}
+
+static bool scheduler_count(Napi::Value value, double min, double max) {
+    if( !value.IsNumber() ) {
+        return false;
+    }
+    double n = value.As<Napi::Number>().DoubleValue();
+    return n >= min && n <= max && n == (double) (size_t) n;
+}
+
+/**
+ * sodium_async_scheduler_configure:
+ * Size the async scheduler used by jobs with a `priority` option
+ *
+ *     sodium.sodium_async_scheduler_configure({
+ *         threads: 4,
+ *         interactive: { concurrency: 4, maxQueue: 1024 },
+ *         bulk: { concurrency: 2, maxQueue: 64 }
+ *     });
+ *
+ * ~ options.threads (Number): scheduler threads, 4 by default, shared by all
+ *   the worker threads of the process. 0 sends the jobs back to the libuv
+ *   threadpool
+ * ~ options.interactive, options.bulk (Object): `concurrency`, the most jobs
+ *   of the class running at once, from 1 to 64, and `maxQueue`, the most
+ *   waiting for a thread. Further jobs fail at once with an "interactive
+ *   queue is full" or "bulk queue is full" error. 0 lets the queue grow
+ *   without limit. Bulk jobs run at most 2 at a time by default
+ * ~ options.cpus (Array): CPUs to pin the threads to, thread `i` on
+ *   `cpus[i % cpus.length]`. `null` lets them run anywhere again. Linux only
+ *
+ * Keep the bulk `concurrency` below `threads`, or bulk jobs can take every
+ * thread. Lowering `threads` lets the extra threads finish the job they are on.
+ */
+NAPI_METHOD(sodium_async_scheduler_configure) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument options must be an object");
+    if( !info[0].IsObject() ) {
+        THROW_ERROR("argument options must be an object");
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    Napi::Value threads = options.Get("threads");
+    Napi::Value cpus = options.Get("cpus");
+    if( !threads.IsUndefined() && !scheduler_count(threads, 0, SCHEDULER_MAX_THREADS) ) {
+        THROW_ERROR("options.threads must be an integer between 0 and 64");
+    }
+
+    Napi::Value concurrency[ASYNC_PRIORITY_CLASSES];
+    Napi::Value maxQueue[ASYNC_PRIORITY_CLASSES];
+    for( int i = 0; i < ASYNC_PRIORITY_CLASSES; i++ ) {
+        Napi::Value c = options.Get(scheduler.classes[i].name);
+        concurrency[i] = maxQueue[i] = env.Undefined();
+        if( c.IsUndefined() ) {
+            continue;
+        }
+        if( !c.IsObject() ) {
+            THROW_ERROR("options.interactive and options.bulk must be objects");
+        }
+        concurrency[i] = c.As<Napi::Object>().Get("concurrency");
+        maxQueue[i] = c.As<Napi::Object>().Get("maxQueue");
+        if( !concurrency[i].IsUndefined() && !scheduler_count(concurrency[i], 1, SCHEDULER_MAX_THREADS) ) {
+            THROW_ERROR("concurrency must be an integer between 1 and 64");
+        }
+        if( !maxQueue[i].IsUndefined() && !scheduler_count(maxQueue[i], 0, SODIUM_MAX_SAFE_INTEGER) ) {
+            THROW_ERROR("maxQueue must be a positive integer or 0");
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(scheduler.lock);
+        std::string error;
+        if( !cpus.IsUndefined() && !scheduler.slots.Configure(cpus, error) ) {
+            THROW_ERROR(error.c_str());
+        }
+        if( !threads.IsUndefined() ) {
+            scheduler.threads = (size_t) threads.As<Napi::Number>().DoubleValue();
+        }
+        for( int i = 0; i < ASYNC_PRIORITY_CLASSES; i++ ) {
+            if( !concurrency[i].IsUndefined() ) {
+                scheduler.classes[i].concurrency = (size_t) concurrency[i].As<Napi::Number>().DoubleValue();
+            }
+            if( !maxQueue[i].IsUndefined() ) {
+                scheduler.classes[i].max_queue = (size_t) maxQueue[i].As<Napi::Number>().DoubleValue();
+            }
+        }
+        scheduler_grow();
+    }
+    scheduler.wake.notify_all();
+
+    return env.Undefined();
+}
+
+/**
+ * sodium_async_scheduler_stats:
+ * Async scheduler counters, for all environments of the process
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ threads, cpus, workers, interactive, bulk }`, each class
+ *   being `{ concurrency, maxQueue, running, queued, queuePeak, submitted,
+ *   completed, rejected, cancelled, waitTotal, waitMax }`. Wait times are the
+ *   milliseconds jobs spent queued before a thread picked them up. `workers`
+ *   has per thread counters, as in sodium_pwhash_pool_stats()
+ */
+NAPI_METHOD(sodium_async_scheduler_stats) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> guard(scheduler.lock);
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "threads"), Napi::Number::New(env, (double) scheduler.threads));
+    result.Set(Napi::String::New(env, "cpus"), scheduler.slots.Cpus(env));
+    result.Set(Napi::String::New(env, "workers"), scheduler.slots.Stats(env));
+    for( SchedulerClass& c : scheduler.classes ) {
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set(Napi::String::New(env, "concurrency"), Napi::Number::New(env, (double) c.concurrency));
+        stats.Set(Napi::String::New(env, "maxQueue"), Napi::Number::New(env, (double) c.max_queue));
+        stats.Set(Napi::String::New(env, "running"), Napi::Number::New(env, (double) c.running));
+        stats.Set(Napi::String::New(env, "queued"), Napi::Number::New(env, (double) c.queue.size()));
+        stats.Set(Napi::String::New(env, "queuePeak"), Napi::Number::New(env, (double) c.queue_peak));
+        stats.Set(Napi::String::New(env, "submitted"), Napi::Number::New(env, c.submitted));
+        stats.Set(Napi::String::New(env, "completed"), Napi::Number::New(env, c.completed));
+        stats.Set(Napi::String::New(env, "rejected"), Napi::Number::New(env, c.rejected));
+        stats.Set(Napi::String::New(env, "cancelled"), Napi::Number::New(env, c.cancelled));
+        stats.Set(Napi::String::New(env, "waitTotal"), Napi::Number::New(env, c.wait_total));
+        stats.Set(Napi::String::New(env, "waitMax"), Napi::Number::New(env, c.wait_max));
+        result.Set(Napi::String::New(env, c.name), stats);
+    }
+    return result;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_async_scheduler(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_async_scheduler_configure);
+    EXPORT(sodium_async_scheduler_stats);
+}
@@ -0,0 +1,221 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+#include "sodium_perf_counters.h"
+
+/**
+ * Binding overhead probes
+ *
+ * The time of a call from JavaScript is the N-API crossing, the argument
+ * macros, the output allocation and the libsodium work. These functions let
+ * `bench/overhead.js` take it apart: empty calls measure the crossing and
+ * the macros, and `sodium_bench_native` times the libsodium work alone in a
+ * C++ loop.
+ */
+
+/**
+ * sodium_bench_noop:
+ * Return at once, without reading the arguments
+ */
+NAPI_METHOD(sodium_bench_noop) {
+    return info.Env().Undefined();
+}
+
+/**
+ * sodium_bench_args:
+ * Parse two buffers with the argument macros, then return
+ *
+ *     sodium.sodium_bench_args(a, b);
+ */
+NAPI_METHOD(sodium_bench_args) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments a and b must be buffers");
+    ARG_TO_UCHAR_BUFFER(a);
+    ARG_TO_UCHAR_BUFFER(b);
+
+    return env.Undefined();
+}
+
+/**
+ * sodium_bench_alloc:
+ * Parse a number and allocate an output buffer of that size, like a binding
+ * returning its result
+ */
+NAPI_METHOD(sodium_bench_alloc) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument size must be a number");
+    ARG_TO_NUMBER(size);
+
+    NEW_BUFFER_AND_PTR(out, size);
+    return out;
+}
+
+static void bench_generichash(unsigned char* out, const unsigned char* in, size_t size, const unsigned char* key) {
+    crypto_generichash(out, crypto_generichash_BYTES, in, size, NULL, 0);
+}
+
+static void bench_verify_16(unsigned char* out, const unsigned char* in, size_t size, const unsigned char* key) {
+    out[0] = (unsigned char) crypto_verify_16(key, key + 16);
+}
+
+static void bench_auth(unsigned char* out, const unsigned char* in, size_t size, const unsigned char* key) {
+    crypto_auth(out, in, size, key);
+}
+
+static void bench_onetimeauth(unsigned char* out, const unsigned char* in, size_t size, const unsigned char* key) {
+    crypto_onetimeauth(out, in, size, key);
+}
+
+static void bench_secretbox_easy(unsigned char* out, const unsigned char* in, size_t size, const unsigned char* key) {
+    crypto_secretbox_easy(out, in, size, key + crypto_secretbox_KEYBYTES, key);
+}
+
+static void bench_randombytes_buf(unsigned char* out, const unsigned char* in, size_t size, const unsigned char* key) {
+    randombytes_buf(out, size);
+}
+
+struct BenchCase {
+    const char* name;
+    void (*run)(unsigned char* out, const unsigned char* in, size_t size, const unsigned char* key);
+};
+
+static const BenchCase bench_cases[] = {
+    { "crypto_generichash", bench_generichash },
+    { "crypto_verify_16", bench_verify_16 },
+    { "crypto_auth", bench_auth },
+    { "crypto_onetimeauth", bench_onetimeauth },
+    { "crypto_secretbox_easy", bench_secretbox_easy },
+    { "randombytes_buf", bench_randombytes_buf }
+};
+
+/**
+ * sodium_bench_native:
+ * Time a libsodium call in a C++ loop
+ *
+ *     var ns = sodium.sodium_bench_native(name, size, iterations);
+ *
+ * ~ name (String): `crypto_generichash`, `crypto_verify_16`, `crypto_auth`,
+ *   `crypto_onetimeauth`, `crypto_secretbox_easy` or `randombytes_buf`
+ * ~ size (Number): message size in bytes
+ * ~ iterations (Number): calls to make
+ *
+ * **Returns**:
+ *
+ * ~ ns (Number): nanoseconds per call
+ */
+NAPI_METHOD(sodium_bench_native) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments must be: name, size, iterations");
+    ARG_TO_STRING(name);
+    ARG_TO_NUMBER(size);
+    ARG_TO_NUMBER(iterations);
+
+    std::string bench_name = name.Utf8Value();
+    const BenchCase* bench = NULL;
+    for(size_t i = 0; i < sizeof bench_cases / sizeof bench_cases[0]; i++) {
+        if( bench_name == bench_cases[i].name ) {
+            bench = &bench_cases[i];
+        }
+    }
+    if( bench == NULL ) {
+        THROW_ERROR("unknown benchmark");
+    }
+    if( iterations == 0 ) {
+        THROW_ERROR("argument iterations must be bigger than 0");
+    }
+
+    std::vector<unsigned char> in(size + 1), out(size + 64);
+    unsigned char key[64];
+    randombytes_buf(in.data(), in.size());
+    randombytes_buf(key, sizeof key);
+
+    auto start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < iterations; i++) {
+        bench->run(out.data(), in.data(), size, key);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    return Napi::Number::New(env,
+        std::chrono::duration<double, std::nano>(elapsed).count() / (double) iterations);
+}
+
+/**
+ * sodium_bench_counters_open:
+ * Open the hardware counters of the calling thread, see
+ * sodium_perf_counters.cc
+ *
+ *     sodium.sodium_bench_counters_open();
+ *
+ * Throws with the reason, such as no PMU in a virtual machine or
+ * `kernel.perf_event_paranoid` above 2, where they cannot be read.
+ */
+NAPI_METHOD(sodium_bench_counters_open) {
+    Napi::Env env = info.Env();
+
+    std::string error;
+    if( !sodium_perf_counters_open(error) ) {
+        THROW_ERROR(error);
+    }
+    return env.Undefined();
+}
+
+/**
+ * sodium_bench_counters_start:
+ * Zero and start the counters opened by sodium_bench_counters_open
+ */
+NAPI_METHOD(sodium_bench_counters_start) {
+    sodium_perf_counters_start();
+    return info.Env().Undefined();
+}
+
+/**
+ * sodium_bench_counters_stop:
+ * Stop the counters
+ *
+ *     var counts = sodium.sodium_bench_counters_stop();
+ *
+ * **Returns**:
+ *
+ * ~ counts (Object): `{ cycles, instructions, cacheReferences, cacheMisses }`
+ *   since sodium_bench_counters_start, the cache counts -1 where the CPU does
+ *   not have them, or `undefined` if the counters are not open
+ */
+NAPI_METHOD(sodium_bench_counters_stop) {
+    Napi::Env env = info.Env();
+
+    SodiumPerfCounts counts = sodium_perf_counters_stop();
+    if( !counts.valid ) {
+        return env.Undefined();
+    }
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("cycles", Napi::Number::New(env, counts.cycles));
+    result.Set("instructions", Napi::Number::New(env, counts.instructions));
+    result.Set("cacheReferences", Napi::Number::New(env, counts.cacheReferences));
+    result.Set("cacheMisses", Napi::Number::New(env, counts.cacheMisses));
+    return result;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_bench(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_bench_noop);
+    EXPORT(sodium_bench_args);
+    EXPORT(sodium_bench_alloc);
+    EXPORT(sodium_bench_native);
+    EXPORT(sodium_bench_counters_open);
+    EXPORT(sodium_bench_counters_start);
+    EXPORT(sodium_bench_counters_stop);
+}
@@ -0,0 +1,537 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "sodium_memory.h"
+#include "sodium_stats.h"
+
+/**
+ * Content defined chunking for deduplication
+ *
+ * Chunk boundaries are found with FastCDC: a gear rolling hash,
+ * `h = (h << 1) + gear[byte]`, cuts where its top bits are zero, with a
+ * stricter mask before the average size and a looser one after it
+ * (normalized chunking, level 1), and nothing is hashed in the first
+ * `minSize` bytes of a chunk. Each chunk is hashed with keyed BLAKE2b in
+ * the same pass.
+ *
+ * The gear table is derived from the key, entry `i` being
+ * `crypto_shorthash(LE64(i))` under a key that is the BLAKE2b of a label
+ * keyed with it, so the boundaries do not reveal the content to anyone
+ * without the key, the same as the digests.
+ */
+#define CHUNKER_DEFAULT_MIN_SIZE 2048
+#define CHUNKER_DEFAULT_AVG_SIZE 8192
+#define CHUNKER_DEFAULT_MAX_SIZE 65536
+#define CHUNKER_MIN_AVG_SIZE 256
+#define CHUNKER_MAX_SIZE (1U << 30)
+#define CHUNKER_FILE_BLOCK_SIZE (1024 * 1024)
+
+struct ChunkerParams {
+    size_t min_size;
+    size_t avg_size;
+    size_t max_size;
+    size_t bytes;
+    uint64_t mask_s;
+    uint64_t mask_l;
+};
+
+// Lives in sodium_malloc memory: the gear table is as secret as the key
+struct ChunkerState {
+    uint64_t gear[256];
+    unsigned char key[crypto_generichash_blake2b_KEYBYTES_MAX];
+    size_t key_size;
+    crypto_generichash_blake2b_state hash;
+    uint64_t h;
+    size_t length;
+    uint64_t offset;
+};
+
+struct ChunkList {
+    std::vector<uint64_t> offsets;
+    std::vector<size_t> lengths;
+    std::vector<unsigned char> digests;
+};
+
+static void chunker_init(ChunkerState* s, const ChunkerParams& p, const unsigned char* key, size_t key_size) {
+    static const char label[] = "sodium content chunker gear";
+    unsigned char gear_key[crypto_shorthash_KEYBYTES];
+    crypto_generichash_blake2b(gear_key, sizeof gear_key, (const unsigned char*) label, sizeof label - 1,
+                               key, key_size);
+    for(unsigned int i = 0; i < 256; i++) {
+        unsigned char in[8] = { (unsigned char) i };
+        unsigned char out[crypto_shorthash_BYTES];
+        crypto_shorthash(out, in, sizeof in, gear_key);
+        uint64_t g = 0;
+        for(int j = 7; j >= 0; j--) {
+            g = (g << 8) | out[j];
+        }
+        s->gear[i] = g;
+    }
+    sodium_memzero(gear_key, sizeof gear_key);
+
+    memcpy(s->key, key, key_size);
+    s->key_size = key_size;
+    s->h = 0;
+    s->length = 0;
+    s->offset = 0;
+    crypto_generichash_blake2b_init(&s->hash, s->key, s->key_size, p.bytes);
+}
+
+static void chunker_emit(ChunkerState* s, const ChunkerParams& p, ChunkList& out) {
+    size_t at = out.digests.size();
+    out.digests.resize(at + p.bytes);
+    crypto_generichash_blake2b_final(&s->hash, out.digests.data() + at, p.bytes);
+    out.offsets.push_back(s->offset);
+    out.lengths.push_back(s->length);
+    SODIUM_STAT(hash, s->length, p.bytes, 0);
+
+    s->offset += s->length;
+    s->h = 0;
+    s->length = 0;
+    crypto_generichash_blake2b_init(&s->hash, s->key, s->key_size, p.bytes);
+}
+
+// Chunk `len` more bytes, adding the chunks they complete to `out`
+static void chunker_update(ChunkerState* s, const ChunkerParams& p, const unsigned char* data, size_t len,
+                           ChunkList& out) {
+    size_t start = 0;
+    size_t i = 0;
+    while( i < len ) {
+        if( s->length < p.min_size ) {
+            size_t skip = p.min_size - s->length;
+            if( skip > len - i ) {
+                skip = len - i;
+            }
+            s->length += skip;
+            i += skip;
+            continue;
+        }
+
+        // Scan up to the next cut point or the end of the data
+        uint64_t h = s->h;
+        size_t length = s->length;
+        bool cut = false;
+        while( i < len ) {
+            h = (h << 1) + s->gear[data[i++]];
+            length++;
+            if( (h & (length < p.avg_size ? p.mask_s : p.mask_l)) == 0 || length >= p.max_size ) {
+                cut = true;
+                break;
+            }
+        }
+        s->h = h;
+        s->length = length;
+        if( cut ) {
+            crypto_generichash_blake2b_update(&s->hash, data + start, i - start);
+            start = i;
+            chunker_emit(s, p, out);
+        }
+    }
+    crypto_generichash_blake2b_update(&s->hash, data + start, len - start);
+}
+
+// The last chunk, if any bytes are left, then start a new stream
+static void chunker_final(ChunkerState* s, const ChunkerParams& p, ChunkList& out) {
+    if( s->length > 0 ) {
+        chunker_emit(s, p, out);
+    }
+    s->offset = 0;
+}
+
+static bool chunker_option(Napi::Object options, const char* name, size_t& out, std::string& error) {
+    Napi::Value value = options.Get(name);
+    if( value.IsUndefined() ) {
+        return true;
+    }
+    if( !value.IsNumber() || !(value.As<Napi::Number>().DoubleValue() >= 1) ) {
+        error = std::string("option ") + name + " must be a positive number";
+        return false;
+    }
+    out = (size_t) value.As<Napi::Number>().DoubleValue();
+    return true;
+}
+
+// Sizes and digest length from `options`, or false with `error` set
+static bool chunker_params(Napi::Value value, ChunkerParams& p, std::string& error) {
+    p.min_size = CHUNKER_DEFAULT_MIN_SIZE;
+    p.avg_size = CHUNKER_DEFAULT_AVG_SIZE;
+    p.max_size = CHUNKER_DEFAULT_MAX_SIZE;
+    p.bytes = crypto_generichash_blake2b_BYTES;
+    if( value.IsObject() && !value.IsFunction() ) {
+        Napi::Object options = value.As<Napi::Object>();
+        if( !chunker_option(options, "minSize", p.min_size, error) ||
+            !chunker_option(options, "avgSize", p.avg_size, error) ||
+            !chunker_option(options, "maxSize", p.max_size, error) ||
+            !chunker_option(options, "bytes", p.bytes, error) ) {
+            return false;
+        }
+    }
+    if( p.avg_size < CHUNKER_MIN_AVG_SIZE || (p.avg_size & (p.avg_size - 1)) != 0 ) {
+        error = "option avgSize must be a power of two, 256 or more";
+        return false;
+    }
+    if( p.min_size > p.avg_size || p.avg_size > p.max_size || p.max_size > CHUNKER_MAX_SIZE ) {
+        error = "options must be minSize <= avgSize <= maxSize <= 1 GiB";
+        return false;
+    }
+    if( p.bytes < crypto_generichash_blake2b_BYTES_MIN || p.bytes > crypto_generichash_blake2b_BYTES_MAX ) {
+        error = "option bytes must be between crypto_generichash_BYTES_MIN and crypto_generichash_BYTES_MAX";
+        return false;
+    }
+
+    int bits = 0;
+    while( ((size_t) 1 << bits) < p.avg_size ) {
+        bits++;
+    }
+    p.mask_s = ~(uint64_t) 0 << (64 - (bits + 1));
+    p.mask_l = ~(uint64_t) 0 << (64 - (bits - 1));
+    return true;
+}
+
+// `{ offsets, lengths, digests }` of `chunks`
+static Napi::Object chunker_result(Napi::Env env, const ChunkList& chunks) {
+    size_t count = chunks.lengths.size();
+    Napi::Array offsets = Napi::Array::New(env, count);
+    Napi::Array lengths = Napi::Array::New(env, count);
+    for(size_t i = 0; i < count; i++) {
+        offsets.Set((uint32_t) i, Napi::Number::New(env, (double) chunks.offsets[i]));
+        lengths.Set((uint32_t) i, Napi::Number::New(env, (double) chunks.lengths[i]));
+    }
+    Napi::Buffer<unsigned char> digests = Napi::Buffer<unsigned char>::Copy(env,
+        chunks.digests.data(), chunks.digests.size());
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "offsets"), offsets);
+    result.Set(Napi::String::New(env, "lengths"), lengths);
+    result.Set(Napi::String::New(env, "digests"), digests);
+    return result;
+}
+
+#define ARG_TO_CHUNKER_KEY(NAME) \
+    ARG_TO_UCHAR_BUFFER(NAME); \
+    if( NAME ## _size < crypto_generichash_blake2b_KEYBYTES_MIN || \
+        NAME ## _size > crypto_generichash_blake2b_KEYBYTES_MAX ) { \
+        THROW_ERROR("argument key must be between crypto_generichash_KEYBYTES_MIN and crypto_generichash_KEYBYTES_MAX bytes long"); \
+    }
+
+/**
+ * Chunks data on the threadpool: the rest of a ContentChunker stream, or a
+ * whole file
+ */
+class ChunkerWorker : public SodiumAsyncWorker {
+public:
+    // Chunk `data` into `state`, which the caller keeps alive
+    ChunkerWorker(const Napi::CallbackInfo& info, ChunkerState* state, const ChunkerParams& params,
+                  const unsigned char* data, size_t size, bool* busy)
+        : SodiumAsyncWorker(info, "ContentChunker.pushAsync"), state(state), params(params),
+          data(data), size(size), busy(busy), own_state(false) {}
+
+    // Chunk the file at `path` with its own state
+    ChunkerWorker(const Napi::CallbackInfo& info, const std::string& path, const ChunkerParams& params)
+        : SodiumAsyncWorker(info, "sodium_chunk_file"), state(NULL), params(params),
+          data(NULL), size(0), busy(NULL), own_state(true), path(path) {}
+
+    ~ChunkerWorker() {
+        if( busy != NULL ) {
+            *busy = false;
+        }
+        if( own_state && state != NULL ) {
+            sodium_free(state);
+        }
+    }
+
+    // Queue the job. The file key is copied
+    Napi::Value Run(Napi::Object self, const unsigned char* key, size_t key_size) {
+        if( !self.IsEmpty() ) {
+            owner = Napi::Persistent(self);
+        }
+        if( own_state ) {
+            state = (ChunkerState*) sodium_malloc(sizeof(ChunkerState));
+            if( state == NULL ) {
+                Napi::Error::New(Env(), "cannot allocate secure memory for the chunker").ThrowAsJavaScriptException();
+                delete this;
+                return Env().Null();
+            }
+            chunker_init(state, params, key, key_size);
+        } else {
+            *busy = true;
+        }
+        return Start(nullptr, ASYNC_RESULT_BUFFER);
+    }
+
+protected:
+    void Run() override {
+        if( Cancelled() ) {
+            SetError("cancelled");
+            return;
+        }
+        if( !own_state ) {
+            chunker_update(state, params, data, size, chunks);
+            status = 0;
+            return;
+        }
+
+        FILE* file = fopen(path.c_str(), "rb");
+        if( file == NULL ) {
+            SetError("cannot open " + path + ": " + strerror(errno));
+            return;
+        }
+        setvbuf(file, NULL, _IONBF, 0);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        std::vector<unsigned char> block(CHUNKER_FILE_BLOCK_SIZE);
+        size_t n;
+        bool cancelled = false;
+        while( !(cancelled = Cancelled()) && (n = fread(block.data(), 1, block.size(), file)) > 0 ) {
+            chunker_update(state, params, block.data(), n, chunks);
+        }
+        bool failed = ferror(file) != 0;
+        int error = errno;
+        fclose(file);
+        sodium_memzero(block.data(), block.size());
+
+        if( failed ) {
+            SetError("cannot read " + path + ": " + strerror(error));
+            return;
+        }
+        if( cancelled ) {
+            SetError("cancelled");
+            return;
+        }
+        chunker_final(state, params, chunks);
+        status = 0;
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return chunker_result(env, chunks);
+    }
+
+private:
+    ChunkerState* state;
+    ChunkerParams params;
+    const unsigned char* data;
+    size_t size;
+    // Cleared when the worker is deleted, while `owner` still holds the chunker
+    bool* busy;
+    bool own_state;
+    std::string path;
+    Napi::ObjectReference owner;
+    ChunkList chunks;
+};
+
+/**
+ * ContentChunker:
+ * Streaming content defined chunker with keyed BLAKE2b chunk digests
+ *
+ * Cuts a stream into chunks at content defined boundaries, with FastCDC,
+ * and hashes each chunk with keyed BLAKE2b in the same pass. The same
+ * content under the same key gives the same chunks wherever it is in the
+ * stream. The key and the gear table derived from it live in memory
+ * allocated with `sodium_malloc`.
+ *
+ *    var chunker = new sodium.ContentChunker(key, [options]);
+ *
+ * ~ key (Buffer): `crypto_generichash_KEYBYTES_MIN` to `_MAX` bytes
+ * ~ options.minSize, options.avgSize, options.maxSize (Number): chunk sizes,
+ *   2 KiB, 8 KiB and 64 KiB by default. `avgSize` must be a power of two
+ * ~ options.bytes (Number): digest length, `crypto_generichash_BYTES` by
+ *   default
+ *
+ * Methods:
+ *
+ * ~ push(data): chunk the next part of the stream. Returns
+ *   `{ offsets, lengths, digests }` for the chunks it completed: offsets
+ *   in the stream, lengths, and the digests back to back
+ * ~ pushAsync(data, [options], [callback]): `push` on the threadpool.
+ *   `data` must not change until it completes, and the chunker cannot be
+ *   used meanwhile
+ * ~ end(): the last chunk, if the stream did not end on a boundary. The
+ *   chunker is then ready for a new stream
+ * ~ dispose(): wipes and frees the state. Later calls throw
+ *
+ * **Sample**:
+ *
+ *     var chunker = new sodium.ContentChunker(key, { avgSize: 16384 });
+ *     var chunks = await chunker.pushAsync(data);
+ *     var last = chunker.end();
+ */
+class ContentChunker : public Napi::ObjectWrap<ContentChunker> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "ContentChunker", {
+            InstanceMethod("push", &ContentChunker::Push),
+            InstanceMethod("pushAsync", &ContentChunker::PushAsync),
+            InstanceMethod("end", &ContentChunker::End),
+            InstanceMethod("dispose", &ContentChunker::Dispose)
+        });
+        exports.Set(Napi::String::New(env, "ContentChunker"), ctor);
+    }
+
+    ContentChunker(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<ContentChunker>(info), state(NULL), busy(false) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() < 1 || !sodium_arg_bytes(info[0], key, key_size) ) {
+            Napi::TypeError::New(env, "argument key must be a buffer").ThrowAsJavaScriptException();
+            return;
+        }
+        if( key_size < crypto_generichash_blake2b_KEYBYTES_MIN || key_size > crypto_generichash_blake2b_KEYBYTES_MAX ) {
+            Napi::Error::New(env, "argument key must be between crypto_generichash_KEYBYTES_MIN and "
+                "crypto_generichash_KEYBYTES_MAX bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+        std::string error;
+        if( !chunker_params(info.Length() > 1 ? info[1] : env.Undefined(), params, error) ) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+
+        state = (ChunkerState*) sodium_malloc(sizeof(ChunkerState));
+        if( state == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the chunker").ThrowAsJavaScriptException();
+            return;
+        }
+        sodium_memory_hold(env, sodium_secure_footprint(sizeof(ChunkerState)));
+        chunker_init(state, params, key, key_size);
+    }
+
+    ~ContentChunker() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( state != NULL ) {
+            sodium_free(state);
+            state = NULL;
+            sodium_memory_hold(Env(), -(int64_t) sodium_secure_footprint(sizeof(ChunkerState)));
+        }
+    }
+
+#define CHECK_CONTEXT() \
+    if( state == NULL ) { \
+        THROW_ERROR("ContentChunker was disposed"); \
+    } \
+    if( busy ) { \
+        THROW_ERROR("ContentChunker is busy with pushAsync"); \
+    }
+
+    Napi::Value Push(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument data must be a buffer");
+        ARG_TO_UCHAR_BUFFER(data);
+
+        ChunkList chunks;
+        chunker_update(state, params, data, data_size, chunks);
+        return chunker_result(env, chunks);
+    }
+
+    Napi::Value PushAsync(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument data must be a buffer");
+        ARG_TO_UCHAR_BUFFER(data);
+
+        ChunkerWorker* worker = new ChunkerWorker(info, state, params, data, data_size, &busy);
+        worker->Pin(data_buffer);
+        return worker->Run(Value(), NULL, 0);
+    }
+
+    Napi::Value End(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ChunkList chunks;
+        chunker_final(state, params, chunks);
+        return chunker_result(env, chunks);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if( busy ) {
+            THROW_ERROR("ContentChunker is busy with pushAsync");
+        }
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    ChunkerState* state;
+    ChunkerParams params;
+    bool busy;
+};
+
+/**
+ * sodium_chunk_file:
+ * Content defined chunks of a file, found on the libuv threadpool
+ *
+ *     sodium.sodium_chunk_file(path, key, [options], [callback]);
+ *
+ * ~ path (String): file to chunk
+ * ~ key (Buffer): as for ContentChunker. The worker keeps its own copy,
+ *   wiped when done
+ * ~ options (Object): optional, the ContentChunker options, and `signal`,
+ *   `deadline` and `timeout`
+ * ~ callback (Function): optional, called as `callback(err, chunks)`
+ *
+ * **Returns**:
+ *
+ * ~ a Promise, when no callback is given, for `{ offsets, lengths, digests }`
+ *   of every chunk, the same as pushing the whole file to a ContentChunker
+ *   and ending it. It is rejected when the file cannot be opened or read
+ */
+NAPI_METHOD(sodium_chunk_file) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments path and key are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument path must be a string");
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    _arg++;
+    ARG_TO_CHUNKER_KEY(key);
+
+    ChunkerParams params;
+    std::string error;
+    if( !chunker_params(info.Length() > 2 ? info[2] : env.Undefined(), params, error) ) {
+        THROW_ERROR(error);
+    }
+
+    ChunkerWorker* worker = new ChunkerWorker(info, path, params);
+    return worker->Run(Napi::Object(), key, key_size);
+}
+
+#undef ARG_TO_CHUNKER_KEY
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_chunker(Napi::Env env, Napi::Object exports) {
+    ContentChunker::Init(env, exports);
+
+    EXPORT(sodium_chunk_file);
+}
@@ -0,0 +1,726 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#endif
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "sodium_file_buffer.h"
+
+/**
+ * File digests
+ *
+ * Hashing a file from JavaScript reads every block into a Buffer, hands it
+ * to `_update` and goes back to the event loop for the next one. These
+ * functions open and read the file on a libuv pool thread and feed the
+ * blocks straight to libsodium, so JavaScript only sees the digest.
+ *
+ * Files are read in large sequential blocks, with a readahead hint where
+ * the platform has one, instead of being mapped: a mapping turns every page
+ * into a fault and does not work for pipes or files that change size. The
+ * block buffer is wiped once the digest is done.
+ */
+enum FileDigestAlgorithm {
+    FILE_DIGEST_GENERICHASH,
+    FILE_DIGEST_SHA256,
+    FILE_DIGEST_SHA512,
+    FILE_DIGEST_HMACSHA256,
+    FILE_DIGEST_HMACSHA512,
+    FILE_DIGEST_HMACSHA512256
+};
+
+struct FileDigestName {
+    const char* name;
+    FileDigestAlgorithm algorithm;
+    size_t bytes;
+};
+
+static const FileDigestName file_hash_names[] = {
+    { "generichash", FILE_DIGEST_GENERICHASH, crypto_generichash_BYTES },
+    { "blake2b", FILE_DIGEST_GENERICHASH, crypto_generichash_BYTES },
+    { "sha256", FILE_DIGEST_SHA256, crypto_hash_sha256_BYTES },
+    { "sha512", FILE_DIGEST_SHA512, crypto_hash_sha512_BYTES }
+};
+
+static const FileDigestName file_auth_names[] = {
+    { "hmacsha512256", FILE_DIGEST_HMACSHA512256, crypto_auth_hmacsha512256_BYTES },
+    { "hmacsha256", FILE_DIGEST_HMACSHA256, crypto_auth_hmacsha256_BYTES },
+    { "hmacsha512", FILE_DIGEST_HMACSHA512, crypto_auth_hmacsha512_BYTES }
+};
+
+template <size_t N>
+static const FileDigestName* file_digest_find(const FileDigestName (&names)[N], const std::string& name) {
+    for(size_t i = 0; i < N; i++) {
+        if( name == names[i].name ) {
+            return &names[i];
+        }
+    }
+    return NULL;
+}
+
+class FileDigestWorker : public SodiumAsyncWorker {
+public:
+    FileDigestWorker(const Napi::CallbackInfo& info, const char* name, const std::string& path,
+                     FileDigestAlgorithm algorithm)
+        : SodiumAsyncWorker(info, name), path(path), algorithm(algorithm),
+          key(NULL), key_size(0), out(NULL), out_size(0) {}
+
+    // Queue the job, writing the digest to `result`. The key is copied
+    Napi::Value Run(Napi::Object result, const unsigned char* k, size_t k_size) {
+        out = Pin(result);
+        out_size = result.As<Napi::Buffer<unsigned char>>().Length();
+        key = k != NULL ? Copy(k, k_size) : NULL;
+        key_size = k_size;
+        return Start(nullptr, ASYNC_RESULT_BUFFER);
+    }
+
+protected:
+    void Run() override {
+        FILE* file = fopen(path.c_str(), "rb");
+        if( file == NULL ) {
+            SetError("cannot open " + path + ": " + strerror(errno));
+            return;
+        }
+        // Reads go straight to the block buffer, and the kernel is told to
+        // read ahead of them
+        setvbuf(file, NULL, _IONBF, 0);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(fileno(file), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        union {
+            crypto_generichash_state generichash;
+            crypto_hash_sha256_state sha256;
+            crypto_hash_sha512_state sha512;
+            crypto_auth_hmacsha256_state hmacsha256;
+            crypto_auth_hmacsha512_state hmacsha512;
+            crypto_auth_hmacsha512256_state hmacsha512256;
+        } state;
+
+        switch( algorithm ) {
+            case FILE_DIGEST_GENERICHASH: crypto_generichash_init(&state.generichash, key, key_size, out_size); break;
+            case FILE_DIGEST_SHA256: crypto_hash_sha256_init(&state.sha256); break;
+            case FILE_DIGEST_SHA512: crypto_hash_sha512_init(&state.sha512); break;
+            case FILE_DIGEST_HMACSHA256: crypto_auth_hmacsha256_init(&state.hmacsha256, key, key_size); break;
+            case FILE_DIGEST_HMACSHA512: crypto_auth_hmacsha512_init(&state.hmacsha512, key, key_size); break;
+            case FILE_DIGEST_HMACSHA512256: crypto_auth_hmacsha512256_init(&state.hmacsha512256, key, key_size); break;
+        }
+
+        std::vector<unsigned char> block(FILE_DIGEST_BLOCK_SIZE);
+        size_t n;
+        bool cancelled = false;
+        while( !(cancelled = Cancelled()) && (n = fread(block.data(), 1, block.size(), file)) > 0 ) {
+            switch( algorithm ) {
+                case FILE_DIGEST_GENERICHASH: crypto_generichash_update(&state.generichash, block.data(), n); break;
+                case FILE_DIGEST_SHA256: crypto_hash_sha256_update(&state.sha256, block.data(), n); break;
+                case FILE_DIGEST_SHA512: crypto_hash_sha512_update(&state.sha512, block.data(), n); break;
+                case FILE_DIGEST_HMACSHA256: crypto_auth_hmacsha256_update(&state.hmacsha256, block.data(), n); break;
+                case FILE_DIGEST_HMACSHA512: crypto_auth_hmacsha512_update(&state.hmacsha512, block.data(), n); break;
+                case FILE_DIGEST_HMACSHA512256: crypto_auth_hmacsha512256_update(&state.hmacsha512256, block.data(), n); break;
+            }
+        }
+        bool failed = ferror(file) != 0;
+        int error = errno;
+        fclose(file);
+        sodium_memzero(block.data(), block.size());
+
+        if( !failed && !cancelled ) {
+            switch( algorithm ) {
+                case FILE_DIGEST_GENERICHASH: crypto_generichash_final(&state.generichash, out, out_size); break;
+                case FILE_DIGEST_SHA256: crypto_hash_sha256_final(&state.sha256, out); break;
+                case FILE_DIGEST_SHA512: crypto_hash_sha512_final(&state.sha512, out); break;
+                case FILE_DIGEST_HMACSHA256: crypto_auth_hmacsha256_final(&state.hmacsha256, out); break;
+                case FILE_DIGEST_HMACSHA512: crypto_auth_hmacsha512_final(&state.hmacsha512, out); break;
+                case FILE_DIGEST_HMACSHA512256: crypto_auth_hmacsha512256_final(&state.hmacsha512256, out); break;
+            }
+        }
+        sodium_memzero(&state, sizeof(state));
+
+        if( failed ) {
+            SetError("cannot read " + path + ": " + strerror(error));
+            return;
+        }
+        if( cancelled ) {
+            SetError("cancelled");
+            return;
+        }
+        status = 0;
+    }
+
+private:
+    std::string path;
+    FileDigestAlgorithm algorithm;
+    const unsigned char* key;
+    size_t key_size;
+    unsigned char* out;
+    size_t out_size;
+};
+
+/**
+ * File encryption
+ *
+ * `sodium_encrypt_file` writes the same format as the SecretStream
+ * Encryptor of lib/secretstream.js: the crypto_secretstream_xchacha20poly1305
+ * header, then one frame of `chunkSize` plain text bytes plus ABYTES per
+ * chunk. The last chunk is tagged TAG_FINAL and is only empty when the whole
+ * file is, so either side can decrypt what the other encrypted.
+ *
+ * Three threads share the work: a reader, the pool thread that runs the
+ * cipher, and a writer. Each pair hands blocks of whole chunks over through
+ * two buffers, so the next block is read and the previous one written while
+ * the current one is encrypted. The buffers are wiped when the job is done.
+ */
+#define FILE_CRYPT_DEFAULT_CHUNK_SIZE (64 * 1024)
+
+// Bytes of the source file read so far, and its size
+struct FileCryptProgress {
+    double done;
+    double total;
+};
+
+class FileCryptWorker : public SodiumAsyncWorker {
+public:
+    FileCryptWorker(const Napi::CallbackInfo& info, const char* name, bool encrypt,
+                    const std::string& src, const std::string& dst, size_t chunk_size)
+        : SodiumAsyncWorker(info, name), encrypt(encrypt), src(src), dst(dst),
+          chunk_size(chunk_size), key(NULL), progress(NULL), written(0) {}
+
+    ~FileCryptWorker() {
+        ReleaseProgress();
+    }
+
+    /**
+     * Queue the job. The key is copied. `on_progress`, if a function, is
+     * called as `on_progress(done, total)` after each block
+     */
+    Napi::Value Run(const unsigned char* k, Napi::Value on_progress) {
+        Napi::Env env = Env();
+        key = Copy(k, crypto_secretstream_xchacha20poly1305_KEYBYTES);
+        if( on_progress.IsFunction() ) {
+            napi_value name = Napi::String::New(env, this->name);
+            napi_create_threadsafe_function(env, on_progress, NULL, name, 2, 1, NULL, NULL,
+                NULL, CallProgress, &progress);
+        }
+        return Start(nullptr, ASYNC_RESULT_BUFFER);
+    }
+
+protected:
+    void Run() override {
+        FILE* in = fopen(src.c_str(), "rb");
+        if( in == NULL ) {
+            SetError("cannot open " + src + ": " + strerror(errno));
+            ReleaseProgress();
+            return;
+        }
+        FILE* out = fopen(dst.c_str(), "wb");
+        if( out == NULL ) {
+            SetError("cannot open " + dst + ": " + strerror(errno));
+            fclose(in);
+            ReleaseProgress();
+            return;
+        }
+        setvbuf(in, NULL, _IONBF, 0);
+        setvbuf(out, NULL, _IONBF, 0);
+#if defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(fileno(in), 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        struct stat st;
+        total = fstat(fileno(in), &st) == 0 ? (double) st.st_size : 0;
+
+        Pipeline(in, out);
+
+        fclose(in);
+        if( fclose(out) != 0 ) {
+            Fail("cannot write " + dst, errno);
+        }
+        if( Failed() ) {
+            // Never leave a partial file behind, it would look complete
+            remove(dst.c_str());
+            SetError(failure);
+        } else {
+            status = 0;
+        }
+        ReleaseProgress();
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        return Napi::Number::New(env, (double) written);
+    }
+
+private:
+    // Record the first failure, with the errno of the call that failed
+    void Fail(const std::string& message, int error = 0) {
+        std::lock_guard<std::mutex> guard(failure_lock);
+        if( failure.empty() ) {
+            failure = error != 0 ? message + ": " + strerror(error) : message;
+        }
+    }
+
+    bool Failed() {
+        std::lock_guard<std::mutex> guard(failure_lock);
+        return !failure.empty();
+    }
+
+    void Pipeline(FILE* in, FILE* out) {
+        size_t frame_size = chunk_size + crypto_secretstream_xchacha20poly1305_ABYTES;
+        size_t chunks = chunk_size < FILE_DIGEST_BLOCK_SIZE ? FILE_DIGEST_BLOCK_SIZE / chunk_size : 1;
+
+        crypto_secretstream_xchacha20poly1305_state state;
+        unsigned char header[crypto_secretstream_xchacha20poly1305_HEADERBYTES];
+        double done = 0;
+
+        if( encrypt ) {
+            crypto_secretstream_xchacha20poly1305_init_push(&state, header, key);
+            if( fwrite(header, 1, sizeof(header), out) != sizeof(header) ) {
+                Fail("cannot write " + dst, errno);
+                return;
+            }
+        } else {
+            size_t n = fread(header, 1, sizeof(header), in);
+            if( ferror(in) ) {
+                Fail("cannot read " + src, errno);
+                return;
+            }
+            if( n < sizeof(header) ) {
+                Fail("secretstream truncated");
+                return;
+            }
+            if( crypto_secretstream_xchacha20poly1305_init_pull(&state, header, key) != 0 ) {
+                Fail("invalid secretstream header");
+                return;
+            }
+            done = sizeof(header);
+        }
+
+        FileDoubleBuffer input(chunks * (encrypt ? chunk_size : frame_size));
+        FileDoubleBuffer output(chunks * (encrypt ? frame_size : chunk_size));
+
+        std::thread reader([this, in, &input, &output] {
+            for(int i = 0; ; i ^= 1) {
+                if( !input.WaitEmpty(i) ) {
+                    return;
+                }
+                size_t n = fread(input.Data(i), 1, input.Size(), in);
+                if( ferror(in) ) {
+                    Fail("cannot read " + src, errno);
+                    input.Stop();
+                    output.Stop();
+                    return;
+                }
+                bool last = n < input.Size();
+                input.Fill(i, n, last);
+                if( last ) {
+                    return;
+                }
+            }
+        });
+        std::thread writer([this, out, &input, &output] {
+            for(int i = 0; ; i ^= 1) {
+                if( !output.WaitFull(i) ) {
+                    return;
+                }
+                size_t n = output.Length(i);
+                if( n > 0 && fwrite(output.Data(i), 1, n, out) != n ) {
+                    Fail("cannot write " + dst, errno);
+                    input.Stop();
+                    output.Stop();
+                    return;
+                }
+                bool last = output.Last(i);
+                output.Empty(i);
+                if( last ) {
+                    return;
+                }
+            }
+        });
+
+        for(int i = 0; ; i ^= 1) {
+            if( Cancelled() ) {
+                Fail("cancelled");
+                break;
+            }
+            if( !input.WaitFull(i) ) {
+                break;
+            }
+            // A full block is the last one when the reader finds nothing
+            // after it, which it is reading while this one waits
+            bool last = input.Last(i);
+            if( !last ) {
+                if( !input.WaitFull(i ^ 1) ) {
+                    break;
+                }
+                last = input.Last(i ^ 1) && input.Length(i ^ 1) == 0;
+            }
+            if( !output.WaitEmpty(i) ) {
+                break;
+            }
+
+            size_t n = input.Length(i);
+            size_t length = 0;
+            bool ok = encrypt ? Encrypt(&state, input.Data(i), n, output.Data(i), length, last)
+                              : Decrypt(&state, input.Data(i), n, output.Data(i), length, last);
+            input.Empty(i);
+            if( !ok ) {
+                break;
+            }
+            written += length;
+            output.Fill(i, length, last);
+
+            done += (double) n;
+            Progress(done);
+            if( last ) {
+                break;
+            }
+        }
+
+        if( Failed() ) {
+            input.Stop();
+            output.Stop();
+        }
+        reader.join();
+        writer.join();
+        sodium_memzero(&state, sizeof(state));
+    }
+
+    bool Encrypt(crypto_secretstream_xchacha20poly1305_state* state, const unsigned char* in, size_t n,
+                 unsigned char* out, size_t& length, bool last) {
+        size_t pos = 0;
+        do {
+            size_t m = n - pos < chunk_size ? n - pos : chunk_size;
+            unsigned char tag = last && pos + m == n ? crypto_secretstream_xchacha20poly1305_TAG_FINAL
+                                                     : crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+            unsigned long long c_size;
+            crypto_secretstream_xchacha20poly1305_push(state, out + length, &c_size, in + pos, m, NULL, 0, tag);
+            length += (size_t) c_size;
+            pos += m;
+        } while( pos < n );
+        return true;
+    }
+
+    bool Decrypt(crypto_secretstream_xchacha20poly1305_state* state, const unsigned char* in, size_t n,
+                 unsigned char* out, size_t& length, bool last) {
+        size_t frame_size = chunk_size + crypto_secretstream_xchacha20poly1305_ABYTES;
+        size_t pos = 0;
+        do {
+            size_t m = n - pos;
+            bool final_frame = last && m <= frame_size;
+            if( !final_frame ) {
+                m = frame_size;
+            } else if( m < crypto_secretstream_xchacha20poly1305_ABYTES ) {
+                Fail("secretstream truncated");
+                return false;
+            }
+            unsigned long long p_size;
+            unsigned char tag;
+            if( crypto_secretstream_xchacha20poly1305_pull(state, out + length, &p_size, &tag,
+                                                           in + pos, m, NULL, 0) != 0 ) {
+                Fail("secretstream chunk failed authentication");
+                return false;
+            }
+            if( !final_frame && tag == crypto_secretstream_xchacha20poly1305_TAG_FINAL ) {
+                Fail("secretstream data after the final chunk");
+                return false;
+            }
+            if( final_frame && tag != crypto_secretstream_xchacha20poly1305_TAG_FINAL ) {
+                Fail("secretstream truncated");
+                return false;
+            }
+            length += (size_t) p_size;
+            pos += m;
+        } while( pos < n );
+        return true;
+    }
+
+    // Calls JavaScript may not keep up with are dropped, not queued
+    void Progress(double done) {
+        if( progress == NULL ) {
+            return;
+        }
+        FileCryptProgress* p = new FileCryptProgress { done, total };
+        if( napi_call_threadsafe_function(progress, p, napi_tsfn_nonblocking) != napi_ok ) {
+            delete p;
+        }
+    }
+
+    // Progress already queued is still delivered, possibly after the result
+    void ReleaseProgress() {
+        if( progress != NULL ) {
+            napi_release_threadsafe_function(progress, napi_tsfn_release);
+            progress = NULL;
+        }
+    }
+
+    static void CallProgress(napi_env env, napi_value js_cb, void* context, void* data) {
+        FileCryptProgress* p = (FileCryptProgress*) data;
+        if( env != NULL && js_cb != NULL ) {
+            napi_value undefined, argv[2];
+            napi_get_undefined(env, &undefined);
+            napi_create_double(env, p->done, &argv[0]);
+            napi_create_double(env, p->total, &argv[1]);
+            napi_call_function(env, undefined, js_cb, 2, argv, NULL);
+        }
+        delete p;
+    }
+
+    bool encrypt;
+    std::string src;
+    std::string dst;
+    size_t chunk_size;
+    const unsigned char* key;
+    napi_threadsafe_function progress;
+    double total = 0;
+    size_t written;
+    std::mutex failure_lock;
+    std::string failure;
+};
+
+// Optional options object at the current argument. A callback in its place
+// leaves it out
+#define ARG_TO_OPTIONS(NAME) \
+    Napi::Object NAME = Napi::Object::New(env); \
+    if( info.Length() > (size_t) _arg && info[_arg].IsObject() && !info[_arg].IsFunction() ) { \
+        NAME = info[_arg].As<Napi::Object>(); \
+    } \
+    _arg++
+
+/**
+ * sodium_hash_file:
+ * Hash a file on the libuv threadpool
+ *
+ *     sodium.sodium_hash_file(path, [algorithm], [options], [callback]);
+ *
+ * ~ path (String): file to hash
+ * ~ algorithm (String): optional, `"generichash"` (the default, also
+ *   `"blake2b"`), `"sha256"` or `"sha512"`
+ * ~ options (Object): optional, for `generichash` only:
+ *     `outputLength`, `crypto_generichash_BYTES` by default, and `key`.
+ *     `signal`, `deadline` and `timeout` stop the hash between blocks, for
+ *     every algorithm
+ * ~ callback (Function): optional, called as `callback(err, hash)`
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the hash when no callback is given. It is rejected when
+ *   the file cannot be opened or read
+ *
+ * The result is the same as hashing the whole file with the matching one
+ * shot function.
+ *
+ * **Sample**:
+ *
+ *     var hash = await sodium.sodium_hash_file('release.tar.gz', 'sha256');
+ */
+NAPI_METHOD(sodium_hash_file) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument path must be a string");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument path must be a string");
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    _arg++;
+
+    std::string name = "generichash";
+    if( info.Length() > 1 && info[1].IsString() ) {
+        name = info[1].As<Napi::String>().Utf8Value();
+    }
+    const FileDigestName* algorithm = file_digest_find(file_hash_names, name);
+    if( algorithm == NULL ) {
+        THROW_ERROR("argument algorithm must be one of generichash, blake2b, sha256 or sha512");
+    }
+    _arg++;
+    ARG_TO_OPTIONS(options);
+
+    size_t out_size = algorithm->bytes;
+    unsigned char* key = NULL;
+    size_t key_size = 0;
+    if( algorithm->algorithm == FILE_DIGEST_GENERICHASH ) {
+        Napi::Value length = options.Get("outputLength");
+        if( !length.IsUndefined() ) {
+            if( !length.IsNumber() ) {
+                THROW_ERROR("option outputLength must be a number");
+            }
+            out_size = length.As<Napi::Number>().Uint32Value();
+            CHECK_SIZE(out_size, crypto_generichash_BYTES_MIN, crypto_generichash_BYTES_MAX);
+        }
+        Napi::Value k = options.Get("key");
+        if( !k.IsUndefined() && !k.IsNull() ) {
+            if( !sodium_arg_bytes(k, key, key_size) ) {
+                THROW_ERROR("option key must be a buffer");
+            }
+            CHECK_SIZE(key_size, crypto_generichash_KEYBYTES_MIN, crypto_generichash_KEYBYTES_MAX);
+        }
+    }
+
+    NEW_BUFFER_AND_PTR(hash, out_size);
+    FileDigestWorker* worker = new FileDigestWorker(info, "sodium_hash_file", path, algorithm->algorithm);
+    return worker->Run(hash, key, key_size);
+}
+
+/**
+ * sodium_auth_file:
+ * Authentication tag of a file, computed on the libuv threadpool
+ *
+ *     sodium.sodium_auth_file(path, key, [algorithm], [options], [callback]);
+ *
+ * ~ path (String): file to authenticate
+ * ~ key (Buffer): secret key. The worker keeps its own copy, wiped when done
+ * ~ algorithm (String): optional, `"hmacsha512256"` (the default, the same
+ *   as `crypto_auth`), `"hmacsha256"` or `"hmacsha512"`
+ * ~ options (Object): optional, `signal`, `deadline` and `timeout`
+ * ~ callback (Function): optional, called as `callback(err, token)`
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the token when no callback is given
+ *
+ * Compare the token with a known one using `crypto_verify_32` (or
+ * `crypto_verify_64` for `hmacsha512`), never with `Buffer.equals`.
+ */
+NAPI_METHOD(sodium_auth_file) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments path and key are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument path must be a string");
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    _arg++;
+    ARG_TO_UCHAR_BUFFER(key);
+    if( key_size == 0 ) {
+        THROW_ERROR("argument key must not be empty");
+    }
+
+    std::string name = "hmacsha512256";
+    if( info.Length() > 2 && info[2].IsString() ) {
+        name = info[2].As<Napi::String>().Utf8Value();
+    }
+    const FileDigestName* algorithm = file_digest_find(file_auth_names, name);
+    if( algorithm == NULL ) {
+        THROW_ERROR("argument algorithm must be one of hmacsha512256, hmacsha256 or hmacsha512");
+    }
+
+    NEW_BUFFER_AND_PTR(token, algorithm->bytes);
+    FileDigestWorker* worker = new FileDigestWorker(info, "sodium_auth_file", path, algorithm->algorithm);
+    return worker->Run(token, key, key_size);
+}
+
+// Arguments and options shared by sodium_encrypt_file and sodium_decrypt_file
+static Napi::Value file_crypt(const Napi::CallbackInfo& info, const char* name, bool encrypt) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments src, dst and key are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument src must be a string");
+    }
+    if( !info[1].IsString() ) {
+        THROW_ERROR("argument dst must be a string");
+    }
+    std::string src = info[0].As<Napi::String>().Utf8Value();
+    std::string dst = info[1].As<Napi::String>().Utf8Value();
+    if( src == dst ) {
+        THROW_ERROR("arguments src and dst must be different files");
+    }
+    _arg = 2;
+    ARG_TO_UCHAR_BUFFER_LEN(key, crypto_secretstream_xchacha20poly1305_KEYBYTES);
+    ARG_TO_OPTIONS(options);
+
+    size_t chunk_size = FILE_CRYPT_DEFAULT_CHUNK_SIZE;
+    Napi::Value chunk = options.Get("chunkSize");
+    if( !chunk.IsUndefined() ) {
+        if( !chunk.IsNumber() || !(chunk.As<Napi::Number>().DoubleValue() >= 1) ||
+            chunk.As<Napi::Number>().DoubleValue() > FILE_DIGEST_BLOCK_SIZE * 16.0 ) {
+            THROW_ERROR("option chunkSize must be a number of bytes from 1 to 16MB");
+        }
+        chunk_size = (size_t) chunk.As<Napi::Number>().DoubleValue();
+    }
+    Napi::Value on_progress = options.Get("onProgress");
+    if( !on_progress.IsUndefined() && !on_progress.IsFunction() ) {
+        THROW_ERROR("option onProgress must be a function");
+    }
+
+    FileCryptWorker* worker = new FileCryptWorker(info, name, encrypt, src, dst, chunk_size);
+    return worker->Run(key, on_progress);
+}
+
+/**
+ * sodium_encrypt_file:
+ * Encrypt a file into another with crypto_secretstream_xchacha20poly1305,
+ * on the libuv threadpool
+ *
+ *     sodium.sodium_encrypt_file(src, dst, key, [options], [callback]);
+ *
+ * ~ src (String): file to encrypt
+ * ~ dst (String): file to write, replaced if it exists
+ * ~ key (Buffer): `crypto_secretstream_xchacha20poly1305_KEYBYTES` long.
+ *   The worker keeps its own copy, wiped when done
+ * ~ options (Object): optional
+ *     `chunkSize`: plain text bytes per chunk, 64KB by default
+ *     `onProgress`: called as `onProgress(done, total)` on the JS thread
+ *     with the bytes of `src` read so far and its size. Calls are dropped
+ *     while JavaScript is behind, and the last ones may come after the
+ *     result
+ *     `signal`, `deadline` and `timeout` stop the job between blocks
+ * ~ callback (Function): optional, called as `callback(err, bytes)`
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the bytes written to `dst` when no callback is given.
+ *   On failure `dst` is removed
+ *
+ * The output is the same as piping `src` through a SecretStream Encryptor
+ * with the same `chunkSize`.
+ *
+ * **Sample**:
+ *
+ *     var key = sodium.crypto_secretstream_xchacha20poly1305_keygen();
+ *     await sodium.sodium_encrypt_file('backup.tar', 'backup.tar.enc', key);
+ */
+NAPI_METHOD(sodium_encrypt_file) {
+    return file_crypt(info, "sodium_encrypt_file", true);
+}
+
+/**
+ * sodium_decrypt_file:
+ * Decrypt a file written by sodium_encrypt_file or a SecretStream Encryptor
+ *
+ *     sodium.sodium_decrypt_file(src, dst, key, [options], [callback]);
+ *
+ * Same arguments as sodium_encrypt_file, `chunkSize` must be the one the
+ * file was encrypted with.
+ *
+ * **Returns**:
+ *
+ * ~ a Promise for the plain text bytes written to `dst`. It is rejected,
+ *   and `dst` removed, when a chunk fails authentication or the file was
+ *   truncated or extended
+ */
+NAPI_METHOD(sodium_decrypt_file) {
+    return file_crypt(info, "sodium_decrypt_file", false);
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_file(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_hash_file);
+    EXPORT(sodium_auth_file);
+    EXPORT(sodium_encrypt_file);
+    EXPORT(sodium_decrypt_file);
+}
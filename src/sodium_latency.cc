@@ -0,0 +1,200 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "node_sodium.h"
+#include "sodium_latency.h"
+
+/**
+ * Async job latency histograms
+ *
+ * Two histograms per job name, queue wait and run time, in nanoseconds.
+ * Buckets are log-linear like HdrHistogram: each power of two is split in
+ * LATENCY_SUB_BUCKETS, so a recorded value is off by at most 1/8 and the
+ * whole uint64_t range fits in 496 counters.
+ *
+ * Jobs are recorded from the JS thread that completes them, so the lock is
+ * only taken once per async call, next to a threadpool round trip.
+ */
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_BUCKETS (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS ((64 - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS)
+
+static size_t latency_bucket(uint64_t ns) {
+    if( ns < LATENCY_SUB_BUCKETS ) {
+        return (size_t) ns;
+    }
+    int msb = LATENCY_SUB_BITS;
+    while( msb < 63 && (ns >> (msb + 1)) != 0 ) {
+        msb++;
+    }
+    return ((size_t) (msb - LATENCY_SUB_BITS + 1) << LATENCY_SUB_BITS) +
+           (size_t) ((ns >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_BUCKETS - 1));
+}
+
+// Smallest value that goes to bucket `i`
+static uint64_t latency_bucket_low(size_t i) {
+    if( i < LATENCY_SUB_BUCKETS ) {
+        return i;
+    }
+    size_t group = i >> LATENCY_SUB_BITS;
+    return (uint64_t) (LATENCY_SUB_BUCKETS + (i & (LATENCY_SUB_BUCKETS - 1))) << (group - 1);
+}
+
+// Largest value that goes to bucket `i`
+static uint64_t latency_bucket_high(size_t i) {
+    return i + 1 < LATENCY_BUCKETS ? latency_bucket_low(i + 1) - 1 : UINT64_MAX;
+}
+
+struct LatencyHistogram {
+    uint64_t counts[LATENCY_BUCKETS] = {};
+    uint64_t count = 0;
+    uint64_t min = UINT64_MAX;
+    uint64_t max = 0;
+    double sum = 0;
+    double sum_squares = 0;
+
+    void Record(uint64_t ns) {
+        counts[latency_bucket(ns)]++;
+        count++;
+        if( ns < min ) {
+            min = ns;
+        }
+        if( ns > max ) {
+            max = ns;
+        }
+        sum += (double) ns;
+        sum_squares += (double) ns * (double) ns;
+    }
+
+    // Highest value of the bucket holding the `p` percentile, at most max
+    uint64_t Percentile(double p) const {
+        uint64_t rank = (uint64_t) std::ceil(p / 100 * (double) count);
+        if( rank == 0 ) {
+            rank = 1;
+        }
+        uint64_t seen = 0;
+        for(size_t i = 0; i < LATENCY_BUCKETS; i++) {
+            seen += counts[i];
+            if( seen >= rank ) {
+                uint64_t high = latency_bucket_high(i);
+                return high < max ? high : max;
+            }
+        }
+        return max;
+    }
+};
+
+struct LatencyEntry {
+    LatencyHistogram wait;
+    LatencyHistogram run;
+};
+
+struct LatencyRegistry {
+    std::mutex lock;
+    std::map<std::string, LatencyEntry> entries;
+};
+
+// Never destroyed: jobs may still complete while the process exits
+static LatencyRegistry* latency = new LatencyRegistry();
+
+void sodium_latency_record(const char* name, uint64_t wait_ns, uint64_t run_ns) {
+    std::lock_guard<std::mutex> guard(latency->lock);
+    LatencyEntry& entry = latency->entries[name];
+    entry.wait.Record(wait_ns);
+    entry.run.Record(run_ns);
+}
+
+static const double latency_percentiles[] = { 50, 75, 90, 99, 99.9 };
+
+// Same fields as a perf_hooks Histogram, percentiles as a plain object
+static Napi::Object latency_histogram_object(Napi::Env env, const LatencyHistogram& h) {
+    Napi::Object result = Napi::Object::New(env);
+    double mean = h.count ? h.sum / (double) h.count : 0;
+    double variance = h.count ? h.sum_squares / (double) h.count - mean * mean : 0;
+
+    result.Set("count", Napi::Number::New(env, (double) h.count));
+    result.Set("min", Napi::Number::New(env, h.count ? (double) h.min : 0));
+    result.Set("max", Napi::Number::New(env, (double) h.max));
+    result.Set("mean", Napi::Number::New(env, mean));
+    result.Set("stddev", Napi::Number::New(env, variance > 0 ? std::sqrt(variance) : 0));
+    result.Set("sum", Napi::Number::New(env, h.sum));
+
+    Napi::Object percentiles = Napi::Object::New(env);
+    if( h.count ) {
+        for(double p : latency_percentiles) {
+            percentiles.Set(Napi::Number::New(env, p), Napi::Number::New(env, (double) h.Percentile(p)));
+        }
+    }
+    result.Set("percentiles", percentiles);
+
+    // Non empty buckets as [highest value, count] pairs, lowest first
+    Napi::Array buckets = Napi::Array::New(env);
+    uint32_t n = 0;
+    for(size_t i = 0; i < LATENCY_BUCKETS; i++) {
+        if( h.counts[i] == 0 ) {
+            continue;
+        }
+        Napi::Array bucket = Napi::Array::New(env, 2);
+        bucket.Set((uint32_t) 0, Napi::Number::New(env, (double) latency_bucket_high(i)));
+        bucket.Set((uint32_t) 1, Napi::Number::New(env, (double) h.counts[i]));
+        buckets.Set(n++, bucket);
+    }
+    result.Set("buckets", buckets);
+    return result;
+}
+
+/**
+ * sodium_async_latency:
+ * Queue wait and run time histograms of the async bindings, in nanoseconds
+ *
+ *     var latency = sodium.sodium_async_latency([reset]);
+ *     // { crypto_pwhash: { wait: { count, min, max, mean, stddev, sum,
+ *     //                            percentiles: { 50, 75, 90, 99, 99.9 },
+ *     //                            buckets: [[highest, count], ...] },
+ *     //                    run: { ... } }, ... }
+ *
+ * ~ reset (Boolean): clear the histograms once they are read
+ *
+ * Jobs of every thread are counted, whichever pool ran them. Jobs run
+ * inline by the tiered bindings and jobs cancelled before a thread got to
+ * them are not.
+ */
+NAPI_METHOD(sodium_async_latency) {
+    Napi::Env env = info.Env();
+    bool reset = info.Length() > 0 && info[0].ToBoolean().Value();
+
+    std::map<std::string, LatencyEntry> entries;
+    {
+        std::lock_guard<std::mutex> guard(latency->lock);
+        if( reset ) {
+            entries.swap(latency->entries);
+        } else {
+            entries = latency->entries;
+        }
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    for(const auto& entry : entries) {
+        Napi::Object op = Napi::Object::New(env);
+        op.Set("wait", latency_histogram_object(env, entry.second.wait));
+        op.Set("run", latency_histogram_object(env, entry.second.run));
+        result.Set(entry.first, op);
+    }
+    return result;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_latency(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_async_latency);
+}
@@ -0,0 +1,819 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "sodium_memory.h"
+#include "sodium_stats.h"
+
+/**
+ * Encrypted append-only logs
+ *
+ * Encrypting each record of a log with `crypto_secretbox_easy` and writing
+ * it costs a native call, a Buffer and a write per record. An EncryptedLog
+ * copies records into one buffer of frames as they are appended, and a
+ * flush encrypts the whole batch and writes it with one write and one
+ * fdatasync on a pool thread. Flushes asked for while one is running are
+ * committed together by the next one (group commit).
+ *
+ * A log is a sequence of segments, one per writer:
+ *
+ *     segment:  "NSLOG\x01\0\0" (8) || salt (16) || record frames
+ *     frame:    LE32(length + ABYTES) || cipher text || tag (16)
+ *
+ * Records are XChaCha20-Poly1305 with the nonce `salt || LE64(sequence)`,
+ * the sequence counting the records of the segment from 0, and the length
+ * field as additional data. The HChaCha20 subkey is derived once per
+ * segment, so each record costs a ChaCha20-Poly1305-IETF call. Records
+ * moved, dropped or duplicated inside a segment fail authentication; the
+ * end of the log, and whole segments, can be cut without detection.
+ *
+ * The magic, read as a frame length, is larger than any record frame, so
+ * readers tell segment headers and frames apart.
+ */
+#define LOG_MAGIC "NSLOG\x01\0\0"
+#define LOG_MAGICBYTES 8
+#define LOG_SALTBYTES crypto_core_hchacha20_INPUTBYTES
+#define LOG_SEGMENTBYTES (LOG_MAGICBYTES + LOG_SALTBYTES)
+#define LOG_LENGTHBYTES 4
+#define LOG_ABYTES crypto_aead_chacha20poly1305_ietf_ABYTES
+#define LOG_OVERHEAD (LOG_LENGTHBYTES + LOG_ABYTES)
+#define LOG_MAX_RECORD (16 * 1024 * 1024)
+#define LOG_READ_BLOCK_SIZE (1024 * 1024)
+#define LOG_MIN_BUFFER (64 * 1024)
+
+// The key, and the subkey of the current segment
+struct LogKeys {
+    unsigned char key[crypto_aead_xchacha20poly1305_ietf_KEYBYTES];
+    unsigned char subkey[crypto_core_hchacha20_OUTPUTBYTES];
+    unsigned char salt[LOG_SALTBYTES];
+};
+
+static uint32_t log_load32(const unsigned char* p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static void log_nonce(unsigned char* npub, uint64_t sequence) {
+    memset(npub, 0, 4);
+    for(int i = 0; i < 8; i++) {
+        npub[4 + i] = (unsigned char) (sequence >> (8 * i));
+    }
+}
+
+// Grow `buffer` by `extra` bytes. Plain text is never left behind in a
+// buffer given back to the heap
+static unsigned char* log_grow(std::vector<unsigned char>& buffer, size_t extra) {
+    size_t size = buffer.size();
+    if( size + extra > buffer.capacity() ) {
+        size_t capacity = buffer.capacity() * 2;
+        if( capacity < size + extra ) {
+            capacity = size + extra;
+        }
+        if( capacity < LOG_MIN_BUFFER ) {
+            capacity = LOG_MIN_BUFFER;
+        }
+        std::vector<unsigned char> bigger;
+        bigger.reserve(capacity);
+        bigger.assign(buffer.begin(), buffer.end());
+        if( size > 0 ) {
+            sodium_memzero(buffer.data(), size);
+        }
+        buffer.swap(bigger);
+    }
+    buffer.resize(size + extra);
+    return buffer.data() + size;
+}
+
+static void log_wipe(std::vector<unsigned char>& buffer) {
+    if( !buffer.empty() ) {
+        sodium_memzero(buffer.data(), buffer.size());
+    }
+    std::vector<unsigned char>().swap(buffer);
+}
+
+// Write all of `data`, 0 or the errno
+static int log_write(int fd, const unsigned char* data, size_t size) {
+    while( size > 0 ) {
+#if defined(_WIN32)
+        int n = _write(fd, data, size > 0x40000000 ? 0x40000000 : (unsigned int) size);
+#else
+        ssize_t n = write(fd, data, size);
+#endif
+        if( n < 0 ) {
+            if( errno == EINTR ) {
+                continue;
+            }
+            return errno;
+        }
+        data += n;
+        size -= (size_t) n;
+    }
+    return 0;
+}
+
+static int log_sync(int fd) {
+#if defined(_WIN32)
+    return _commit(fd) == 0 ? 0 : errno;
+#elif defined(__linux__)
+    return fdatasync(fd) == 0 ? 0 : errno;
+#else
+    return fsync(fd) == 0 ? 0 : errno;
+#endif
+}
+
+// Read up to `size` bytes at `offset`: the count, 0 at the end, -1 and errno
+static int64_t log_read(int fd, unsigned char* data, size_t size, uint64_t offset) {
+#if defined(_WIN32)
+    if( _lseeki64(fd, (__int64) offset, SEEK_SET) < 0 ) {
+        return -1;
+    }
+    return _read(fd, data, size > 0x40000000 ? 0x40000000 : (unsigned int) size);
+#else
+    ssize_t n;
+    do {
+        n = pread(fd, data, size, (off_t) offset);
+    } while( n < 0 && errno == EINTR );
+    return n;
+#endif
+}
+
+// A flush() caller: its Promise, or its callback
+struct LogWaiter {
+    std::shared_ptr<Napi::Promise::Deferred> deferred;
+    std::shared_ptr<Napi::FunctionReference> callback;
+};
+
+class EncryptedLog;
+
+/**
+ * Encrypts and writes one batch of frames on the threadpool
+ */
+class LogFlushWorker : public Napi::AsyncWorker {
+public:
+    LogFlushWorker(EncryptedLog* log, Napi::Object self, const LogKeys* keys, int fd, bool sync,
+                   std::vector<unsigned char>& batch, uint64_t sequence, size_t records,
+                   std::vector<LogWaiter>& waiters)
+        : Napi::AsyncWorker(self.Env(), "EncryptedLog.flush"), log(log), keys(keys), fd(fd),
+          sync(sync), sequence(sequence), records(records) {
+        owner = Napi::Persistent(self);
+        this->batch.swap(batch);
+        this->waiters.swap(waiters);
+    }
+
+    ~LogFlushWorker() {
+        log_wipe(batch);
+    }
+
+protected:
+    void Execute() override {
+        unsigned char npub[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+        unsigned char* p = batch.data();
+        unsigned char* end = p + batch.size();
+        while( p < end ) {
+            if( memcmp(p, LOG_MAGIC, LOG_MAGICBYTES) == 0 ) {
+                p += LOG_SEGMENTBYTES;
+                continue;
+            }
+            size_t length = log_load32(p) - LOG_ABYTES;
+            unsigned char* m = p + LOG_LENGTHBYTES;
+            log_nonce(npub, sequence++);
+            SODIUM_STAT(aead_xchacha20poly1305_ietf, length, length + LOG_ABYTES,
+                crypto_aead_chacha20poly1305_ietf_encrypt_detached(m, m + length, NULL, m, length,
+                                                                   p, LOG_LENGTHBYTES, NULL, npub, keys->subkey));
+            p = m + length + LOG_ABYTES;
+        }
+
+        int error = log_write(fd, batch.data(), batch.size());
+        if( error != 0 ) {
+            SetError(std::string("cannot write the log: ") + strerror(error));
+            return;
+        }
+        if( sync && (error = log_sync(fd)) != 0 ) {
+            SetError(std::string("cannot sync the log: ") + strerror(error));
+        }
+    }
+
+    void OnOK() override;
+    void OnError(const Napi::Error& e) override;
+
+private:
+    friend class EncryptedLog;
+
+    EncryptedLog* log;
+    Napi::ObjectReference owner;
+    const LogKeys* keys;
+    int fd;
+    bool sync;
+    std::vector<unsigned char> batch;
+    uint64_t sequence;
+    size_t records;
+    std::vector<LogWaiter> waiters;
+};
+
+/**
+ * EncryptedLog:
+ * Writer of an encrypted append-only log with group commit
+ *
+ *    var log = new sodium.EncryptedLog(fd, key, [options]);
+ *
+ * ~ fd (Number): file descriptor to append to, opened by the caller with
+ *   `fs.openSync(path, 'a')`, and closed by it once the log is disposed
+ * ~ key (Buffer): `crypto_aead_xchacha20poly1305_ietf_KEYBYTES` long
+ * ~ options.sync (Boolean): fdatasync after each batch, true by default
+ *
+ * Each writer starts a new segment with a random salt, so any number of
+ * writers can append to the same file one after the other under one key.
+ *
+ * Methods:
+ *
+ * ~ append(record): copy a record into the next batch. Returns its
+ *   sequence number in the segment. Records are at most 16MB
+ * ~ appendBatch(records): append an array of records, returns the sequence
+ *   number of the first
+ * ~ flush([callback]): encrypt and write every record appended so far.
+ *   Returns a Promise, when no callback is given, for the number of records
+ *   committed. A failed write fails the log: later calls throw the error
+ * ~ stats(): `{ records, bytes, flushes, pending }`, the records and bytes
+ *   committed, the batches written and the records not flushed yet
+ * ~ dispose(): wipes the key and the records not flushed. Throws while a
+ *   flush is running
+ *
+ * **Sample**:
+ *
+ *     var log = new sodium.EncryptedLog(fs.openSync('audit.log', 'a'), key);
+ *     log.append(Buffer.from(JSON.stringify(event)));
+ *     await log.flush();
+ */
+class EncryptedLog : public Napi::ObjectWrap<EncryptedLog> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "EncryptedLog", {
+            InstanceMethod("append", &EncryptedLog::Append),
+            InstanceMethod("appendBatch", &EncryptedLog::AppendBatch),
+            InstanceMethod("flush", &EncryptedLog::Flush),
+            InstanceMethod("stats", &EncryptedLog::Stats),
+            InstanceMethod("dispose", &EncryptedLog::Dispose)
+        });
+        ctor.Set("OVERHEAD", Napi::Number::New(env, LOG_OVERHEAD));
+        ctor.Set("MAX_RECORD", Napi::Number::New(env, LOG_MAX_RECORD));
+        exports.Set(Napi::String::New(env, "EncryptedLog"), ctor);
+    }
+
+    EncryptedLog(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<EncryptedLog>(info), keys(NULL), fd(-1), sync(true), sequence(0),
+          pending_records(0), flushing(NULL), committed(0), bytes(0), flushes(0) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() < 2 || !info[0].IsNumber() || !sodium_arg_bytes(info[1], key, key_size) ) {
+            Napi::TypeError::New(env, "arguments must be: file descriptor and key buffer").ThrowAsJavaScriptException();
+            return;
+        }
+        double d = info[0].As<Napi::Number>().DoubleValue();
+        if( !(d >= 0) || d > 2147483647.0 || d != (double) (int) d ) {
+            Napi::Error::New(env, "argument fd must be a file descriptor").ThrowAsJavaScriptException();
+            return;
+        }
+        if( key_size != crypto_aead_xchacha20poly1305_ietf_KEYBYTES ) {
+            Napi::Error::New(env, "argument key must be crypto_aead_xchacha20poly1305_ietf_KEYBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+        if( info.Length() > 2 && sodium_async_is_options(info[2]) ) {
+            Napi::Value s = info[2].As<Napi::Object>().Get("sync");
+            if( !s.IsUndefined() ) {
+                if( !s.IsBoolean() ) {
+                    Napi::Error::New(env, "option sync must be a boolean").ThrowAsJavaScriptException();
+                    return;
+                }
+                sync = s.As<Napi::Boolean>().Value();
+            }
+        }
+        fd = (int) d;
+
+        keys = (LogKeys*) sodium_secret_alloc(env, sizeof(LogKeys));
+        if( keys == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        memcpy(keys->key, key, sizeof keys->key);
+        randombytes_buf(keys->salt, sizeof keys->salt);
+        crypto_core_hchacha20(keys->subkey, keys->salt, keys->key, NULL);
+        sodium_secret_readonly(keys);
+
+        // The segment header goes out with the first batch
+        unsigned char* header = log_grow(pending, LOG_SEGMENTBYTES);
+        memcpy(header, LOG_MAGIC, LOG_MAGICBYTES);
+        memcpy(header + LOG_MAGICBYTES, keys->salt, LOG_SALTBYTES);
+    }
+
+    ~EncryptedLog() {
+        Free();
+    }
+
+    // A batch was written, or failed. On the JS thread
+    void Flushed(Napi::Env env, LogFlushWorker* worker, const std::string& error) {
+        flushing = NULL;
+        if( error.empty() ) {
+            committed += worker->records;
+            bytes += worker->batch.size();
+            flushes++;
+            Settle(env, worker->waiters, "");
+        } else {
+            failure = error;
+            Settle(env, worker->waiters, failure);
+            Settle(env, waiting, failure);
+            waiting.clear();
+        }
+        if( !waiting.empty() && keys != NULL ) {
+            Start();
+        }
+    }
+
+private:
+    void Free() {
+        log_wipe(pending);
+        if( keys != NULL ) {
+            sodium_secret_free(Env(), keys, sizeof(LogKeys));
+            keys = NULL;
+        }
+    }
+
+    void Start() {
+        uint64_t first = sequence - pending_records;
+        flushing = new LogFlushWorker(this, Value(), keys, fd, sync, pending, first, pending_records, waiting);
+        pending_records = 0;
+        waiting.clear();
+        flushing->Queue();
+    }
+
+    void Settle(Napi::Env env, std::vector<LogWaiter>& waiters, const std::string& error) {
+        for(auto& waiter : waiters) {
+            Napi::Value value = error.empty() ? Napi::Value(Napi::Number::New(env, (double) committed))
+                                              : Napi::Value(Napi::Error::New(env, error).Value());
+            if( waiter.deferred ) {
+                if( error.empty() ) {
+                    waiter.deferred->Resolve(value);
+                } else {
+                    waiter.deferred->Reject(value);
+                }
+            } else if( error.empty() ) {
+                waiter.callback->Call({ env.Null(), value });
+            } else {
+                waiter.callback->Call({ value });
+            }
+        }
+    }
+
+    // Copy a record in as a frame, its tag left to the flush
+    uint64_t Frame(const unsigned char* record, size_t size) {
+        unsigned char* frame = log_grow(pending, LOG_OVERHEAD + size);
+        uint32_t length = (uint32_t) (size + LOG_ABYTES);
+        for(int i = 0; i < LOG_LENGTHBYTES; i++) {
+            frame[i] = (unsigned char) (length >> (8 * i));
+        }
+        memcpy(frame + LOG_LENGTHBYTES, record, size);
+        pending_records++;
+        return sequence++;
+    }
+
+#define CHECK_CONTEXT() \
+    if( keys == NULL ) { \
+        THROW_ERROR("EncryptedLog was disposed"); \
+    } \
+    if( !failure.empty() ) { \
+        THROW_ERROR(failure); \
+    }
+
+    Napi::Value Append(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument record must be a buffer");
+        ARG_TO_UCHAR_BUFFER(record);
+        if( record_size > LOG_MAX_RECORD ) {
+            THROW_ERROR("argument record must be at most EncryptedLog.MAX_RECORD bytes long");
+        }
+        return Napi::Number::New(env, (double) Frame(record, record_size));
+    }
+
+    Napi::Value AppendBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        if( info.Length() < 1 || !info[0].IsArray() ) {
+            THROW_ERROR("argument records must be an array of buffers");
+        }
+        Napi::Array records = info[0].As<Napi::Array>();
+        uint32_t count = records.Length();
+
+        // Check every record before appending any
+        std::vector<unsigned char*> data(count);
+        std::vector<size_t> sizes(count);
+        for(uint32_t i = 0; i < count; i++) {
+            if( !sodium_arg_bytes(records.Get(i), data[i], sizes[i]) ) {
+                THROW_ERROR("argument records must be an array of buffers");
+            }
+            if( sizes[i] > LOG_MAX_RECORD ) {
+                THROW_ERROR("records must be at most EncryptedLog.MAX_RECORD bytes long");
+            }
+        }
+        uint64_t first = sequence;
+        for(uint32_t i = 0; i < count; i++) {
+            Frame(data[i], sizes[i]);
+        }
+        return Napi::Number::New(env, (double) first);
+    }
+
+    Napi::Value Flush(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if( keys == NULL ) {
+            THROW_ERROR("EncryptedLog was disposed");
+        }
+        LogWaiter waiter;
+        Napi::Value ret = env.Undefined();
+        if( info.Length() > 0 && info[info.Length() - 1].IsFunction() ) {
+            waiter.callback = std::make_shared<Napi::FunctionReference>(
+                Napi::Persistent(info[info.Length() - 1].As<Napi::Function>()));
+        } else {
+            waiter.deferred = std::make_shared<Napi::Promise::Deferred>(env);
+            ret = waiter.deferred->Promise();
+        }
+
+        waiting.push_back(waiter);
+        if( !failure.empty() ) {
+            Settle(env, waiting, failure);
+            waiting.clear();
+        } else if( flushing == NULL ) {
+            Start();
+        }
+        return ret;
+    }
+
+    Napi::Value Stats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        Napi::Object stats = Napi::Object::New(env);
+        stats.Set("records", Napi::Number::New(env, (double) committed));
+        stats.Set("bytes", Napi::Number::New(env, (double) bytes));
+        stats.Set("flushes", Napi::Number::New(env, (double) flushes));
+        stats.Set("pending", Napi::Number::New(env, (double) pending_records));
+        return stats;
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if( flushing != NULL ) {
+            THROW_ERROR("EncryptedLog is busy with flush");
+        }
+        Free();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+
+    LogKeys* keys;
+    int fd;
+    bool sync;
+    uint64_t sequence;
+    std::vector<unsigned char> pending;
+    size_t pending_records;
+    std::vector<LogWaiter> waiting;
+    LogFlushWorker* flushing;
+    std::string failure;
+    uint64_t committed;
+    uint64_t bytes;
+    uint64_t flushes;
+};
+
+void LogFlushWorker::OnOK() {
+    log->Flushed(Env(), this, "");
+}
+
+void LogFlushWorker::OnError(const Napi::Error& e) {
+    log->Flushed(Env(), this, e.Message());
+}
+
+// Position of a record in the block a read returns
+struct LogRecord {
+    size_t offset;
+    size_t size;
+};
+
+/**
+ * Reads and decrypts the next records of a log on the threadpool
+ */
+class LogReadWorker : public SodiumAsyncWorker {
+public:
+    LogReadWorker(const Napi::CallbackInfo& info, LogKeys* keys, int fd, uint64_t* offset,
+                  uint64_t* sequence, bool* segment, std::string* failure, bool* busy)
+        : SodiumAsyncWorker(info, "EncryptedLogReader.read"), keys(keys), fd(fd), offset(offset),
+          sequence(sequence), segment(segment), failure(failure), busy(busy), used(0) {}
+
+    ~LogReadWorker() {
+        if( busy != NULL ) {
+            *busy = false;
+        }
+        log_wipe(block);
+    }
+
+    Napi::Value Run(Napi::Object self) {
+        owner = Napi::Persistent(self);
+        *busy = true;
+        return Start(nullptr, ASYNC_RESULT_BUFFER);
+    }
+
+protected:
+    void Run() override {
+        if( !failure->empty() ) {
+            SetError(*failure);
+            return;
+        }
+        if( Cancelled() ) {
+            SetError("cancelled");
+            return;
+        }
+
+        block.resize(LOG_READ_BLOCK_SIZE);
+        size_t have = 0;
+        bool eof = false;
+        for(;;) {
+            while( have < block.size() && !eof ) {
+                int64_t n = log_read(fd, block.data() + have, block.size() - have, *offset + have);
+                if( n < 0 ) {
+                    Fail(std::string("cannot read the log: ") + strerror(errno));
+                    return;
+                }
+                eof = n == 0;
+                have += (size_t) n;
+            }
+
+            size_t need = Parse(have);
+            if( !error.empty() || !records.empty() ) {
+                break;
+            }
+            // Only segment headers so far: drop them and read the rest of
+            // the frame, growing the block if the frame is larger
+            memmove(block.data(), block.data() + used, have - used);
+            *offset += used;
+            have -= used;
+            used = 0;
+            if( eof ) {
+                if( have > 0 ) {
+                    error = "the log ends with a partial record";
+                }
+                break;
+            }
+            if( need > block.size() ) {
+                block.resize(need);
+            }
+        }
+
+        *offset += used;
+        if( !error.empty() && records.empty() ) {
+            Fail(error);
+            return;
+        }
+        // The records read are returned, the error comes with the next read
+        if( !error.empty() ) {
+            *failure = error;
+        }
+        status = 0;
+    }
+
+    Napi::Value Result(Napi::Env env) override {
+        if( records.empty() ) {
+            return env.Null();
+        }
+        Napi::Buffer<unsigned char> data = Napi::Buffer<unsigned char>::Copy(env, block.data(), used);
+        Napi::Function subarray = data.Get("subarray").As<Napi::Function>();
+        Napi::Array result = Napi::Array::New(env, records.size());
+        for(size_t i = 0; i < records.size(); i++) {
+            result.Set((uint32_t) i, subarray.Call(data, {
+                Napi::Number::New(env, (double) records[i].offset),
+                Napi::Number::New(env, (double) (records[i].offset + records[i].size))
+            }));
+        }
+        return result;
+    }
+
+private:
+    void Fail(const std::string& message) {
+        *failure = message;
+        SetError(message);
+    }
+
+    /**
+     * Decrypt the complete frames of the first `have` bytes of the block,
+     * from `used`. Returns the length the next frame needs, from `used`,
+     * when it is not complete
+     */
+    size_t Parse(size_t have) {
+        unsigned char npub[crypto_aead_chacha20poly1305_ietf_NPUBBYTES];
+        while( used < have ) {
+            unsigned char* p = block.data() + used;
+            size_t left = have - used;
+            if( left < LOG_LENGTHBYTES ) {
+                return LOG_LENGTHBYTES;
+            }
+            if( memcmp(p, LOG_MAGIC, LOG_LENGTHBYTES) == 0 ) {
+                if( left < LOG_SEGMENTBYTES ) {
+                    return LOG_SEGMENTBYTES;
+                }
+                if( memcmp(p, LOG_MAGIC, LOG_MAGICBYTES) != 0 ) {
+                    error = "unknown encrypted log version at offset " + std::to_string(*offset + used);
+                    return 0;
+                }
+                memcpy(keys->salt, p + LOG_MAGICBYTES, LOG_SALTBYTES);
+                crypto_core_hchacha20(keys->subkey, keys->salt, keys->key, NULL);
+                *sequence = 0;
+                *segment = true;
+                used += LOG_SEGMENTBYTES;
+                continue;
+            }
+            if( !*segment ) {
+                error = "not an encrypted log";
+                return 0;
+            }
+            size_t length = log_load32(p);
+            if( length < LOG_ABYTES || length > LOG_MAX_RECORD + LOG_ABYTES ) {
+                error = "corrupt encrypted log at offset " + std::to_string(*offset + used);
+                return 0;
+            }
+            if( left < LOG_LENGTHBYTES + length ) {
+                return LOG_LENGTHBYTES + length;
+            }
+            unsigned char* c = p + LOG_LENGTHBYTES;
+            size_t size = length - LOG_ABYTES;
+            log_nonce(npub, *sequence);
+            if( SODIUM_STAT(aead_xchacha20poly1305_ietf, length, size,
+                    crypto_aead_chacha20poly1305_ietf_decrypt_detached(c, NULL, c, size, c + size,
+                                                                       p, LOG_LENGTHBYTES, npub, keys->subkey)) != 0 ) {
+                error = "encrypted log record failed authentication at offset " + std::to_string(*offset + used);
+                return 0;
+            }
+            (*sequence)++;
+            records.push_back({ used + LOG_LENGTHBYTES, size });
+            used += LOG_LENGTHBYTES + length;
+        }
+        return 0;
+    }
+
+    LogKeys* keys;
+    int fd;
+    uint64_t* offset;
+    uint64_t* sequence;
+    bool* segment;
+    std::string* failure;
+    // Cleared when the worker is deleted, while `owner` still holds the reader
+    bool* busy;
+    Napi::ObjectReference owner;
+    std::vector<unsigned char> block;
+    size_t used;
+    std::vector<LogRecord> records;
+    std::string error;
+};
+
+/**
+ * EncryptedLogReader:
+ * Sequential reader of a log written by EncryptedLog
+ *
+ *    var reader = new sodium.EncryptedLogReader(fd, key);
+ *
+ * ~ fd (Number): file descriptor opened for reading by the caller
+ * ~ key (Buffer): the key of the log
+ *
+ * Methods:
+ *
+ * ~ read([options], [callback]): decrypt the next records on the
+ *   threadpool, a block of about 1MB at a time. Returns a Promise, when no
+ *   callback is given, for an array of Buffers, views of one block, or
+ *   null at the end of the log. It is rejected for a record that fails
+ *   authentication or a partial record at the end; the records before it
+ *   are returned first. Errors are final
+ * ~ offset: the end of the last record read. A log cut by a crash can be
+ *   truncated there and appended to again
+ * ~ dispose(): wipes the key. Throws while a read is running
+ *
+ * **Sample**:
+ *
+ *     var records;
+ *     while( (records = await reader.read()) !== null ) {
+ *         records.forEach(process);
+ *     }
+ */
+class EncryptedLogReader : public Napi::ObjectWrap<EncryptedLogReader> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "EncryptedLogReader", {
+            InstanceMethod("read", &EncryptedLogReader::Read),
+            InstanceMethod("dispose", &EncryptedLogReader::Dispose),
+            InstanceAccessor("offset", &EncryptedLogReader::Offset, nullptr)
+        });
+        exports.Set(Napi::String::New(env, "EncryptedLogReader"), ctor);
+    }
+
+    EncryptedLogReader(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<EncryptedLogReader>(info), keys(NULL), fd(-1), offset(0), sequence(0),
+          segment(false), busy(false) {
+        Napi::Env env = info.Env();
+
+        unsigned char* key = NULL;
+        size_t key_size = 0;
+        if( info.Length() < 2 || !info[0].IsNumber() || !sodium_arg_bytes(info[1], key, key_size) ) {
+            Napi::TypeError::New(env, "arguments must be: file descriptor and key buffer").ThrowAsJavaScriptException();
+            return;
+        }
+        double d = info[0].As<Napi::Number>().DoubleValue();
+        if( !(d >= 0) || d > 2147483647.0 || d != (double) (int) d ) {
+            Napi::Error::New(env, "argument fd must be a file descriptor").ThrowAsJavaScriptException();
+            return;
+        }
+        if( key_size != crypto_aead_xchacha20poly1305_ietf_KEYBYTES ) {
+            Napi::Error::New(env, "argument key must be crypto_aead_xchacha20poly1305_ietf_KEYBYTES bytes long").ThrowAsJavaScriptException();
+            return;
+        }
+        fd = (int) d;
+
+        // Not read only: the subkey changes with each segment
+        keys = (LogKeys*) sodium_secret_alloc(env, sizeof(LogKeys));
+        if( keys == NULL ) {
+            Napi::Error::New(env, "cannot allocate secure memory for the key").ThrowAsJavaScriptException();
+            return;
+        }
+        memcpy(keys->key, key, sizeof keys->key);
+    }
+
+    ~EncryptedLogReader() {
+        Free();
+    }
+
+private:
+    void Free() {
+        if( keys != NULL ) {
+            sodium_secret_free(Env(), keys, sizeof(LogKeys));
+            keys = NULL;
+        }
+    }
+
+    Napi::Value Read(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if( keys == NULL ) {
+            THROW_ERROR("EncryptedLogReader was disposed");
+        }
+        if( busy ) {
+            THROW_ERROR("EncryptedLogReader is busy with read");
+        }
+        LogReadWorker* worker = new LogReadWorker(info, keys, fd, &offset, &sequence, &segment, &failure, &busy);
+        return worker->Run(Value());
+    }
+
+    Napi::Value Offset(const Napi::CallbackInfo& info) {
+        return Napi::Number::New(info.Env(), (double) offset);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        if( busy ) {
+            THROW_ERROR("EncryptedLogReader is busy with read");
+        }
+        Free();
+        return env.Undefined();
+    }
+
+    LogKeys* keys;
+    int fd;
+    uint64_t offset;
+    uint64_t sequence;
+    bool segment;
+    bool busy;
+    std::string failure;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_log(Napi::Env env, Napi::Object exports) {
+    EncryptedLog::Init(env, exports);
+    EncryptedLogReader::Init(env, exports);
+}
@@ -0,0 +1,280 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+
+#include "node_sodium.h"
+#include "sodium_memory.h"
+
+/**
+ * Secure memory
+ *
+ * `sodium_malloc` Buffers are external Buffers over libsodium guarded
+ * allocations: locked in memory so they are never swapped, placed right
+ * before a guard page, and wiped and freed by `sodium_free` when the GC
+ * collects the Buffer. V8 never moves or copies their bytes, and since they
+ * are regular Buffers every binding uses them in place.
+ *
+ * Live allocations are tracked so the `sodium_mprotect_*` calls only ever
+ * see pointers that came from `sodium_malloc`.
+ */
+
+static std::mutex secure_mutex;
+static std::unordered_map<void*, size_t> secure_allocations;
+static size_t secure_bytes = 0;     // footprint of secure_allocations
+
+// Footprint reported to the GC, see sodium_secure_footprint
+static int64_t secure_footprint(size_t size) {
+    return (int64_t) sodium_secure_footprint(size);
+}
+
+// Keys and states of wrapped objects, see sodium_memory_hold
+static std::atomic<int64_t> held_bytes(0);
+
+void sodium_memory_hold(napi_env env, int64_t bytes) {
+    held_bytes += bytes;
+    int64_t adjusted;
+    napi_adjust_external_memory(env, bytes, &adjusted);
+}
+
+static void secure_finalize(napi_env env, void* data, void* hint) {
+    size_t size = 0;
+    {
+        std::lock_guard<std::mutex> lock(secure_mutex);
+        auto it = secure_allocations.find(data);
+        if( it != secure_allocations.end() ) {
+            size = it->second;
+            secure_allocations.erase(it);
+            secure_bytes -= sodium_secure_footprint(size);
+        }
+    }
+    sodium_free(data);
+
+    int64_t adjusted;
+    napi_adjust_external_memory(env, -secure_footprint(size), &adjusted);
+}
+
+// Data pointer of a Buffer made by sodium_malloc, or NULL
+static void* secure_data(Napi::Value value) {
+    unsigned char* data = NULL;
+    size_t size = 0;
+    if( !value.IsBuffer() || !sodium_arg_bytes(value, data, size) ) {
+        return NULL;
+    }
+    std::lock_guard<std::mutex> lock(secure_mutex);
+    auto it = secure_allocations.find(data);
+    return it != secure_allocations.end() && it->second == size ? data : NULL;
+}
+
+Napi::Value sodium_secure_buffer(Napi::Env env, size_t size, unsigned char*& data) {
+    data = (unsigned char*) sodium_malloc(size);
+    if( data == NULL ) {
+        THROW_ERROR("cannot allocate secure memory");
+    }
+
+    napi_value buffer;
+    if( napi_create_external_buffer(env, size, data, secure_finalize, NULL, &buffer) != napi_ok ) {
+        sodium_free(data);
+        data = NULL;
+        THROW_ERROR("cannot create a Buffer over secure memory in this environment");
+    }
+    {
+        std::lock_guard<std::mutex> lock(secure_mutex);
+        secure_allocations[data] = size;
+        secure_bytes += sodium_secure_footprint(size);
+    }
+
+    int64_t adjusted;
+    napi_adjust_external_memory(env, secure_footprint(size), &adjusted);
+
+    return Napi::Value(env, buffer);
+}
+
+/**
+ * sodium_malloc:
+ * Allocate a Buffer in locked memory, guarded against overflows
+ *
+ *     var key = sodium.sodium_malloc(sodium.crypto_secretbox_KEYBYTES);
+ *
+ * ~ size (Number): size of the buffer in bytes, at least 1
+ *
+ * **Returns**:
+ *
+ * ~ buffer (Buffer): filled with `0xdb` bytes. Its memory is wiped when the
+ *   Buffer is garbage collected. Each allocation takes a few pages, so keep
+ *   these for long lived secrets
+ */
+NAPI_METHOD(sodium_malloc) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument size must be a number");
+    ARG_TO_NUMBER(size);
+    if( size == 0 ) {
+        THROW_ERROR("argument size must be bigger than 0");
+    }
+
+    unsigned char* data;
+    Napi::Value buffer = sodium_secure_buffer(env, size, data);
+    if( data == NULL ) {
+        return NAPI_NULL;
+    }
+    return buffer;
+}
+
+/**
+ * sodium_is_secure_buffer:
+ * Check if a buffer was allocated by `sodium_malloc`
+ *
+ * **Returns**:
+ *
+ * ~ true | false
+ */
+NAPI_METHOD(sodium_is_secure_buffer) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument buffer is required");
+    return Napi::Boolean::New(env, secure_data(info[0]) != NULL);
+}
+
+#define NAPI_METHOD_MPROTECT(NAME) \
+    NAPI_METHOD(NAME) { \
+        Napi::Env env = info.Env(); \
+        \
+        ARGS(1, "argument buffer must be a buffer from sodium_malloc"); \
+        void* data = secure_data(info[0]); \
+        if( data == NULL ) { \
+            THROW_ERROR("argument buffer must be a buffer from sodium_malloc"); \
+        } \
+        return Napi::Boolean::New(env, NAME(data) == 0); \
+    }
+
+/**
+ * sodium_mprotect_noaccess:
+ * Make a `sodium_malloc` buffer inaccessible. Any read or write of it,
+ * including by a binding, crashes the process until
+ * `sodium_mprotect_readwrite` is called
+ *
+ *     sodium.sodium_mprotect_noaccess(key);
+ *
+ * **Returns**:
+ *
+ * ~ true | false: if the protection could be changed
+ *
+ * `sodium_mprotect_readonly` works the same way but still allows reads, so
+ * a key can be used but not modified.
+ */
+NAPI_METHOD_MPROTECT(sodium_mprotect_noaccess)
+NAPI_METHOD_MPROTECT(sodium_mprotect_readonly)
+NAPI_METHOD_MPROTECT(sodium_mprotect_readwrite)
+
+/**
+ * sodium_mlock:
+ * Lock the memory of any buffer so it is never swapped to disk
+ *
+ *     sodium.sodium_mlock(buffer);
+ *
+ * **Returns**:
+ *
+ * ~ true | false: if the memory could be locked. The number of bytes a
+ *   process may lock is usually limited
+ *
+ * `sodium_munlock` unlocks it again, and wipes it first.
+ */
+NAPI_METHOD(sodium_mlock) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument buffer must be a buffer");
+    ARG_TO_UCHAR_BUFFER(buffer);
+
+    return Napi::Boolean::New(env, sodium_mlock(buffer, buffer_size) == 0);
+}
+
+NAPI_METHOD(sodium_munlock) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument buffer must be a buffer");
+    ARG_TO_UCHAR_BUFFER(buffer);
+
+    return Napi::Boolean::New(env, sodium_munlock(buffer, buffer_size) == 0);
+}
+
+/**
+ * Register function calls in node binding
+ */
+/**
+ * sodium_memory_usage:
+ * Native memory held by the addon, in bytes
+ *
+ *     var usage = sodium.sodium_memory_usage();
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ secure, objects, hashStates, boxCache, keypairPool,
+ *   verifyCache, curve25519Cache, argon2, securePool, sharedCaches,
+ *   outputPool, total }`.
+ *   `secure` are the `sodium_malloc` Buffers, `objects` the keys and states
+ *   of AeadContext, AeadKeyring, AgeStream, BloomFilter, BoxSession, ContentChunker,
+ *   EncryptedLog, EncryptedLogReader, HmacKey, KdfTree, KeyIndex, NoiseHandshake,
+ *   PacketProtector, PasetoKey, RatchetSession, SigningKey, SodiumPipeline, TransportSession, VerifyKey and SignState objects, the key stream of KeystreamBuffer objects and the digest table of KeyIndex objects, `hashStates` the slabs of the hash
+ *   state classes, `argon2` the regions of the password hashing memory
+ *   pool, kept or in use, `securePool` the secure pool regions not taken
+ *   by the slots counted in `objects`, `sharedCaches` the shared memory
+ *   cache segments this process has mapped, and `outputPool` the current slabs of this
+ *   thread's output buffer pool. The caches count their entries
+ *   approximately
+ *
+ * Guarded allocations are counted with their guard pages. Every category but
+ * `outputPool` is shared by the whole process.
+ */
+NAPI_METHOD(sodium_memory_usage) {
+    Napi::Env env = info.Env();
+
+    size_t secure;
+    {
+        std::lock_guard<std::mutex> lock(secure_mutex);
+        secure = secure_bytes;
+    }
+
+    struct {
+        const char* name;
+        double bytes;
+    } categories[] = {
+        { "secure", (double) secure },
+        { "objects", (double) held_bytes.load() },
+        { "hashStates", (double) crypto_hash_state_memory() },
+        { "boxCache", (double) crypto_box_cache_memory() },
+        { "keypairPool", (double) crypto_keypair_pool_memory() },
+        { "verifyCache", (double) crypto_sign_verify_cache_memory() },
+        { "curve25519Cache", (double) crypto_sign_curve25519_cache_memory() },
+        { "argon2", (double) sodium_pwhash_memory_pool_memory() },
+        { "securePool", (double) sodium_secure_pool_memory() },
+        { "sharedCaches", (double) sodium_shared_cache_memory() },
+        { "outputPool", (double) sodium_pool_memory(env) }
+    };
+
+    Napi::Object result = Napi::Object::New(env);
+    double total = 0;
+    for(const auto& category : categories) {
+        result.Set(Napi::String::New(env, category.name), Napi::Number::New(env, category.bytes));
+        total += category.bytes;
+    }
+    result.Set(Napi::String::New(env, "total"), Napi::Number::New(env, total));
+    return result;
+}
+
+void register_sodium_memory(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_malloc);
+    EXPORT(sodium_is_secure_buffer);
+    EXPORT(sodium_mprotect_noaccess);
+    EXPORT(sodium_mprotect_readonly);
+    EXPORT(sodium_mprotect_readwrite);
+    EXPORT(sodium_mlock);
+    EXPORT(sodium_munlock);
+    EXPORT(sodium_memory_usage);
+}
@@ -0,0 +1,147 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cerrno>
+#include <cstring>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "sodium_perf_counters.h"
+
+/**
+ * Hardware performance counters
+ *
+ * Ops/s depend on the clock speed and the load of the host, so they do not
+ * compare across machines. Cycles per byte and instructions per cycle do:
+ * a kernel that runs at 1 cycle per byte on one host and 4 on another is not
+ * the same kernel, and a binding change that adds cache misses shows up in
+ * the misses per call even when the time hides it.
+ *
+ * The counters are one `perf_event_open` group on the calling thread, user
+ * space only, so they also work with `kernel.perf_event_paranoid` at 2, the
+ * default of most distributions: cycles as the leader, instructions, and
+ * the last level cache references and misses when the CPU has them. Being
+ * one group they are counted over the same cycles, and if the kernel has to
+ * multiplex them with other events all four are scaled by the same
+ * enabled over running time.
+ */
+
+#if defined(__linux__)
+
+#define COUNTERS 4
+
+// Group of the thread that opened it, -1 when closed. Only the opening
+// thread may start and stop it, since its events count that thread
+static thread_local int counters_fd[COUNTERS] = { -1, -1, -1, -1 };
+static thread_local int counters_open = 0;
+
+static int open_counter(uint64_t config, int group) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof attr);
+    attr.size = sizeof attr;
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = group == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+}
+
+bool sodium_perf_counters_open(std::string& error) {
+    static const uint64_t events[COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_REFERENCES,
+        PERF_COUNT_HW_CACHE_MISSES
+    };
+
+    if( counters_open ) {
+        return true;
+    }
+    for(int i = 0; i < COUNTERS; i++) {
+        int fd = open_counter(events[i], i == 0 ? -1 : counters_fd[0]);
+        if( fd == -1 ) {
+            // The cache events are optional, cycles and instructions are not
+            if( i >= 2 ) {
+                break;
+            }
+            error = std::string("perf_event_open: ") + strerror(errno);
+            sodium_perf_counters_close();
+            return false;
+        }
+        counters_fd[i] = fd;
+        counters_open = i + 1;
+    }
+    return true;
+}
+
+void sodium_perf_counters_close() {
+    for(int i = 0; i < COUNTERS; i++) {
+        if( counters_fd[i] != -1 ) {
+            close(counters_fd[i]);
+            counters_fd[i] = -1;
+        }
+    }
+    counters_open = 0;
+}
+
+void sodium_perf_counters_start() {
+    if( counters_open ) {
+        ioctl(counters_fd[0], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counters_fd[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+SodiumPerfCounts sodium_perf_counters_stop() {
+    SodiumPerfCounts counts = { false, 0, 0, -1, -1 };
+    if( !counters_open ) {
+        return counts;
+    }
+    ioctl(counters_fd[0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // { nr, time_enabled, time_running, value[nr] }
+    uint64_t data[3 + COUNTERS];
+    ssize_t n = read(counters_fd[0], data, sizeof data);
+    if( n < (ssize_t) (3 * sizeof(uint64_t)) || data[0] != (uint64_t) counters_open || data[2] == 0 ) {
+        return counts;
+    }
+    double scale = (double) data[1] / (double) data[2];
+    counts.valid = true;
+    counts.cycles = data[3] * scale;
+    counts.instructions = data[4] * scale;
+    if( counters_open == COUNTERS ) {
+        counts.cacheReferences = data[5] * scale;
+        counts.cacheMisses = data[6] * scale;
+    }
+    return counts;
+}
+
+#else
+
+bool sodium_perf_counters_open(std::string& error) {
+    error = "hardware counters are only read on Linux";
+    return false;
+}
+
+void sodium_perf_counters_close() {
+}
+
+void sodium_perf_counters_start() {
+}
+
+SodiumPerfCounts sodium_perf_counters_stop() {
+    SodiumPerfCounts counts = { false, 0, 0, -1, -1 };
+    return counts;
+}
+
+#endif
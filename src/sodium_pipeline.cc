@@ -0,0 +1,742 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "node_sodium_batch.h"
+#include "sodium_memory.h"
+
+/**
+ * SodiumPipeline:
+ * A fixed chain of operations compiled once and run over many inputs
+ *
+ * Request paths often run the same steps over every message: decode the
+ * base64, open the AEAD frame, hash it, check the MAC. Done with one binding
+ * per step, each step is a crossing and a Buffer. A pipeline takes the steps
+ * once, with their keys, and runs the whole chain in one call, the bytes
+ * between steps staying in the calling thread's scratch memory.
+ *
+ *     var pipe = new sodium.SodiumPipeline(steps);
+ *
+ * ~ steps (Array): the operations in order, each an op name or an object
+ *   `{ op, key, ad, bytes, variant, append }`. `SodiumPipeline.ops` lists
+ *   the names
+ *
+ * Each step reads what the step before it wrote:
+ *
+ * ~ `sodium_base642bin`, `sodium_bin2base64`: `variant` is one of the
+ *   `sodium_base64_VARIANT_*` constants, ORIGINAL by default. Decoding
+ *   fails on anything that is not whole base64
+ * ~ `sodium_hex2bin`, `sodium_bin2hex`
+ * ~ `crypto_hash_sha256`, `crypto_hash_sha512`, `crypto_generichash` with
+ *   an optional `key` and `bytes`, `crypto_auth_hmacsha256` and
+ *   `crypto_auth_hmacsha512`: the digest, or the input followed by the
+ *   digest with `append: true`
+ * ~ `crypto_auth_hmacsha256_verify`, `crypto_auth_hmacsha512_verify`: the
+ *   input ends with the tag. Checks it and passes on what is before it
+ * ~ `crypto_secretbox_easy`, `crypto_aead_xchacha20poly1305_ietf_encrypt`
+ *   with an optional `ad`: a random nonce followed by the cipher text
+ * ~ `crypto_secretbox_open_easy`, `crypto_aead_xchacha20poly1305_ietf_decrypt`:
+ *   the reverse, the input starting with the nonce
+ * ~ `crypto_sign_detached` with the secret key as `key`: the input followed
+ *   by its signature
+ * ~ `crypto_sign_verify_detached` with the public key as `key`: the input
+ *   ends with the signature. Checks it and passes on what is before it
+ *
+ * Keys are copied into one `sodium_malloc` block, or a secure pool slot,
+ * made read only. Steps that only check a tag pass a view of their input on
+ * instead of copying it, and scratch memory is wiped after each run.
+ *
+ * Properties:
+ *
+ * ~ steps (Number): the number of steps
+ *
+ * Methods:
+ *
+ * ~ run(input): the output of the last step, or null as soon as a step fails
+ * ~ runAsync(input, [options], [callback]): same as `run` on the libuv
+ *   threadpool. The input is pinned, not copied: leave it alone until the
+ *   result is delivered. Inputs under `sodium_async_threshold()` bytes run
+ *   inline when a Promise is returned
+ * ~ runBatch(inputs, [threads]): run an array of inputs. Returns an array
+ *   holding the output of each, views of one Buffer, or null where a step
+ *   failed. `threads` splits the batch across that many threads, the call
+ *   still blocks
+ * ~ runBatchAsync(inputs, [threads], [options], [callback]): same as
+ *   `runBatch` on the libuv threadpool
+ * ~ dispose(): wipes and frees the keys. Later calls throw; jobs already
+ *   queued keep their own reference to the keys and finish
+ *
+ * **Sample**:
+ *
+ *     var pipe = new sodium.SodiumPipeline([
+ *         { op: 'sodium_base642bin', variant: sodium.sodium_base64_VARIANT_URLSAFE_NO_PADDING },
+ *         { op: 'crypto_aead_xchacha20poly1305_ietf_decrypt', key: key, ad: Buffer.from('v1') },
+ *         { op: 'crypto_auth_hmacsha256_verify', key: macKey }
+ *     ]);
+ *
+ *     var body = pipe.run(Buffer.from(token));    // null if anything fails
+ */
+
+#define PIPELINE_MAX_STEPS 32
+
+// Scratch blocks over this size are released after the run instead of kept
+#define PIPELINE_SCRATCH_KEEP (1024 * 1024)
+
+enum PipelineOp {
+    PIPELINE_BASE64_DECODE,
+    PIPELINE_BASE64_ENCODE,
+    PIPELINE_HEX_DECODE,
+    PIPELINE_HEX_ENCODE,
+    PIPELINE_HASH_SHA256,
+    PIPELINE_HASH_SHA512,
+    PIPELINE_GENERICHASH,
+    PIPELINE_AUTH_HMACSHA256,
+    PIPELINE_AUTH_HMACSHA512,
+    PIPELINE_AUTH_HMACSHA256_VERIFY,
+    PIPELINE_AUTH_HMACSHA512_VERIFY,
+    PIPELINE_SECRETBOX_EASY,
+    PIPELINE_SECRETBOX_OPEN_EASY,
+    PIPELINE_AEAD_XCHACHA20POLY1305_ENCRYPT,
+    PIPELINE_AEAD_XCHACHA20POLY1305_DECRYPT,
+    PIPELINE_SIGN_DETACHED,
+    PIPELINE_SIGN_VERIFY_DETACHED
+};
+
+// Key lengths a step accepts; 0, 0 for steps without a key. A step with
+// `key_min` 0 and `key_max` set takes an optional key
+static const struct {
+    const char* name;
+    int op;
+    size_t key_min;
+    size_t key_max;
+} pipeline_ops[] = {
+    { "sodium_base642bin", PIPELINE_BASE64_DECODE, 0, 0 },
+    { "sodium_bin2base64", PIPELINE_BASE64_ENCODE, 0, 0 },
+    { "sodium_hex2bin", PIPELINE_HEX_DECODE, 0, 0 },
+    { "sodium_bin2hex", PIPELINE_HEX_ENCODE, 0, 0 },
+    { "crypto_hash_sha256", PIPELINE_HASH_SHA256, 0, 0 },
+    { "crypto_hash_sha512", PIPELINE_HASH_SHA512, 0, 0 },
+    { "crypto_generichash", PIPELINE_GENERICHASH, 0, crypto_generichash_KEYBYTES_MAX },
+    { "crypto_auth_hmacsha256", PIPELINE_AUTH_HMACSHA256,
+      crypto_auth_hmacsha256_KEYBYTES, crypto_auth_hmacsha256_KEYBYTES },
+    { "crypto_auth_hmacsha512", PIPELINE_AUTH_HMACSHA512,
+      crypto_auth_hmacsha512_KEYBYTES, crypto_auth_hmacsha512_KEYBYTES },
+    { "crypto_auth_hmacsha256_verify", PIPELINE_AUTH_HMACSHA256_VERIFY,
+      crypto_auth_hmacsha256_KEYBYTES, crypto_auth_hmacsha256_KEYBYTES },
+    { "crypto_auth_hmacsha512_verify", PIPELINE_AUTH_HMACSHA512_VERIFY,
+      crypto_auth_hmacsha512_KEYBYTES, crypto_auth_hmacsha512_KEYBYTES },
+    { "crypto_secretbox_easy", PIPELINE_SECRETBOX_EASY,
+      crypto_secretbox_KEYBYTES, crypto_secretbox_KEYBYTES },
+    { "crypto_secretbox_open_easy", PIPELINE_SECRETBOX_OPEN_EASY,
+      crypto_secretbox_KEYBYTES, crypto_secretbox_KEYBYTES },
+    { "crypto_aead_xchacha20poly1305_ietf_encrypt", PIPELINE_AEAD_XCHACHA20POLY1305_ENCRYPT,
+      crypto_aead_xchacha20poly1305_ietf_KEYBYTES, crypto_aead_xchacha20poly1305_ietf_KEYBYTES },
+    { "crypto_aead_xchacha20poly1305_ietf_decrypt", PIPELINE_AEAD_XCHACHA20POLY1305_DECRYPT,
+      crypto_aead_xchacha20poly1305_ietf_KEYBYTES, crypto_aead_xchacha20poly1305_ietf_KEYBYTES },
+    { "crypto_sign_detached", PIPELINE_SIGN_DETACHED,
+      crypto_sign_ed25519_SECRETKEYBYTES, crypto_sign_ed25519_SECRETKEYBYTES },
+    { "crypto_sign_verify_detached", PIPELINE_SIGN_VERIFY_DETACHED,
+      crypto_sign_ed25519_PUBLICKEYBYTES, crypto_sign_ed25519_PUBLICKEYBYTES }
+};
+
+struct PipelineStep {
+    int op;
+    size_t key;                     // offset of the key in the key block
+    size_t key_size;
+    std::vector<unsigned char> ad;
+    size_t bytes;                   // crypto_generichash output length
+    int variant;                    // base64 variant
+    bool append;
+};
+
+/**
+ * The compiled steps and their keys. Shared with the jobs in flight, so
+ * dispose() only drops the pipeline's own reference
+ */
+struct PipelineProgram {
+    PipelineProgram(napi_env env) : env(env), keys(NULL), keys_size(0) {}
+
+    ~PipelineProgram() {
+        if( keys != NULL ) {
+            sodium_secret_free(env, keys, keys_size);
+        }
+    }
+
+    napi_env env;
+    std::vector<PipelineStep> steps;
+    unsigned char* keys;
+    size_t keys_size;
+};
+
+// Most bytes step `s` writes for `in` bytes of input
+static size_t pipeline_bound(const PipelineStep& s, size_t in) {
+    size_t prefix = s.append ? in : 0;
+    switch( s.op ) {
+    case PIPELINE_BASE64_DECODE:
+        return in / 4 * 3 + 3;
+    case PIPELINE_BASE64_ENCODE:
+        return sodium_base64_ENCODED_LEN(in, s.variant);
+    case PIPELINE_HEX_DECODE:
+        return in / 2;
+    case PIPELINE_HEX_ENCODE:
+        return in * 2 + 1;
+    case PIPELINE_HASH_SHA256:
+        return prefix + crypto_hash_sha256_BYTES;
+    case PIPELINE_HASH_SHA512:
+        return prefix + crypto_hash_sha512_BYTES;
+    case PIPELINE_GENERICHASH:
+        return prefix + s.bytes;
+    case PIPELINE_AUTH_HMACSHA256:
+        return prefix + crypto_auth_hmacsha256_BYTES;
+    case PIPELINE_AUTH_HMACSHA512:
+        return prefix + crypto_auth_hmacsha512_BYTES;
+    case PIPELINE_SECRETBOX_EASY:
+        return in + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+    case PIPELINE_AEAD_XCHACHA20POLY1305_ENCRYPT:
+        return in + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES;
+    case PIPELINE_SIGN_DETACHED:
+        return in + crypto_sign_ed25519_BYTES;
+    default:
+        // Opens and checks only ever shrink their input
+        return in;
+    }
+}
+
+/**
+ * Run step `s` over `in`. Returns where its `out_len` bytes of output are,
+ * `out` or the start of `in`, or NULL when the step fails
+ */
+static const unsigned char* pipeline_step(const PipelineStep& s, const unsigned char* keys,
+                                          const unsigned char* in, size_t in_len,
+                                          unsigned char* out, size_t& out_len) {
+    const unsigned char* k = keys + s.key;
+    const char* end = NULL;
+    size_t prefix = s.append ? in_len : 0;
+    int rc = -1;
+
+    if( s.append && in_len > 0 ) {
+        memcpy(out, in, in_len);
+    }
+
+    switch( s.op ) {
+    case PIPELINE_BASE64_DECODE:
+        rc = sodium_base642bin(out, pipeline_bound(s, in_len), (const char*) in, in_len,
+                               NULL, &out_len, &end, s.variant);
+        return rc == 0 && end == (const char*) in + in_len ? out : NULL;
+    case PIPELINE_BASE64_ENCODE:
+        out_len = sodium_base64_ENCODED_LEN(in_len, s.variant) - 1;
+        sodium_bin2base64((char*) out, out_len + 1, in, in_len, s.variant);
+        return out;
+    case PIPELINE_HEX_DECODE:
+        rc = sodium_hex2bin(out, in_len / 2, (const char*) in, in_len, NULL, &out_len, &end);
+        return rc == 0 && end == (const char*) in + in_len ? out : NULL;
+    case PIPELINE_HEX_ENCODE:
+        out_len = in_len * 2;
+        sodium_bin2hex((char*) out, out_len + 1, in, in_len);
+        return out;
+    case PIPELINE_HASH_SHA256:
+        out_len = prefix + crypto_hash_sha256_BYTES;
+        rc = crypto_hash_sha256(out + prefix, in, in_len);
+        break;
+    case PIPELINE_HASH_SHA512:
+        out_len = prefix + crypto_hash_sha512_BYTES;
+        rc = crypto_hash_sha512(out + prefix, in, in_len);
+        break;
+    case PIPELINE_GENERICHASH:
+        out_len = prefix + s.bytes;
+        rc = crypto_generichash(out + prefix, s.bytes, in, in_len, s.key_size ? k : NULL, s.key_size);
+        break;
+    case PIPELINE_AUTH_HMACSHA256:
+        out_len = prefix + crypto_auth_hmacsha256_BYTES;
+        rc = crypto_auth_hmacsha256(out + prefix, in, in_len, k);
+        break;
+    case PIPELINE_AUTH_HMACSHA512:
+        out_len = prefix + crypto_auth_hmacsha512_BYTES;
+        rc = crypto_auth_hmacsha512(out + prefix, in, in_len, k);
+        break;
+    case PIPELINE_AUTH_HMACSHA256_VERIFY:
+        if( in_len < crypto_auth_hmacsha256_BYTES ) {
+            return NULL;
+        }
+        out_len = in_len - crypto_auth_hmacsha256_BYTES;
+        return crypto_auth_hmacsha256_verify(in + out_len, in, out_len, k) == 0 ? in : NULL;
+    case PIPELINE_AUTH_HMACSHA512_VERIFY:
+        if( in_len < crypto_auth_hmacsha512_BYTES ) {
+            return NULL;
+        }
+        out_len = in_len - crypto_auth_hmacsha512_BYTES;
+        return crypto_auth_hmacsha512_verify(in + out_len, in, out_len, k) == 0 ? in : NULL;
+    case PIPELINE_SECRETBOX_EASY:
+        out_len = in_len + crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES;
+        randombytes_buf(out, crypto_secretbox_NONCEBYTES);
+        rc = crypto_secretbox_easy(out + crypto_secretbox_NONCEBYTES, in, in_len, out, k);
+        break;
+    case PIPELINE_SECRETBOX_OPEN_EASY:
+        if( in_len < crypto_secretbox_NONCEBYTES + crypto_secretbox_MACBYTES ) {
+            return NULL;
+        }
+        out_len = in_len - crypto_secretbox_NONCEBYTES - crypto_secretbox_MACBYTES;
+        rc = crypto_secretbox_open_easy(out, in + crypto_secretbox_NONCEBYTES,
+                                        in_len - crypto_secretbox_NONCEBYTES, in, k);
+        break;
+    case PIPELINE_AEAD_XCHACHA20POLY1305_ENCRYPT: {
+        unsigned long long clen;
+        randombytes_buf(out, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+        rc = crypto_aead_xchacha20poly1305_ietf_encrypt(out + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES,
+                                                        &clen, in, in_len, s.ad.data(), s.ad.size(),
+                                                        NULL, out, k);
+        out_len = crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + (size_t) clen;
+        break;
+    }
+    case PIPELINE_AEAD_XCHACHA20POLY1305_DECRYPT: {
+        if( in_len < crypto_aead_xchacha20poly1305_ietf_NPUBBYTES + crypto_aead_xchacha20poly1305_ietf_ABYTES ) {
+            return NULL;
+        }
+        unsigned long long mlen;
+        rc = crypto_aead_xchacha20poly1305_ietf_decrypt(out, &mlen, NULL,
+                                                        in + crypto_aead_xchacha20poly1305_ietf_NPUBBYTES,
+                                                        in_len - crypto_aead_xchacha20poly1305_ietf_NPUBBYTES,
+                                                        s.ad.data(), s.ad.size(), in, k);
+        out_len = (size_t) mlen;
+        break;
+    }
+    case PIPELINE_SIGN_DETACHED:
+        if( in_len > 0 ) {
+            memcpy(out, in, in_len);
+        }
+        out_len = in_len + crypto_sign_ed25519_BYTES;
+        rc = crypto_sign_ed25519_detached(out + in_len, NULL, in, in_len, k);
+        break;
+    case PIPELINE_SIGN_VERIFY_DETACHED:
+        if( in_len < crypto_sign_ed25519_BYTES ) {
+            return NULL;
+        }
+        out_len = in_len - crypto_sign_ed25519_BYTES;
+        return crypto_sign_ed25519_verify_detached(in + out_len, in, out_len, k) == 0 ? in : NULL;
+    }
+    return rc == 0 ? out : NULL;
+}
+
+// Two blocks per thread the steps write to in turn, grown to the largest
+// run. `used` is how much of each was written since the last wipe
+struct PipelineScratch {
+    std::vector<unsigned char> block[2];
+    size_t used;
+};
+
+static thread_local PipelineScratch pipeline_scratch;
+
+/**
+ * Run every step of `p` over `in`. Returns the output, in the calling
+ * thread's scratch or in `in`, or NULL as soon as a step fails. Call
+ * pipeline_wipe once the output is copied out
+ */
+static const unsigned char* pipeline_run(const PipelineProgram& p, const unsigned char* in,
+                                         size_t in_len, size_t& out_len) {
+    PipelineScratch& scratch = pipeline_scratch;
+
+    size_t need = 0, len = in_len;
+    for(const PipelineStep& s : p.steps) {
+        len = pipeline_bound(s, len);
+        if( len > need ) {
+            need = len;
+        }
+    }
+    for(int b = 0; b < 2; b++) {
+        if( scratch.block[b].size() < need || scratch.block[b].empty() ) {
+            scratch.block[b].resize(need > 0 ? need : 1);
+        }
+    }
+    scratch.used = need;
+
+    const unsigned char* data = in;
+    len = in_len;
+    for(const PipelineStep& s : p.steps) {
+        // Write to the block the current data is not in
+        unsigned char* out = data == scratch.block[0].data() ? scratch.block[1].data() : scratch.block[0].data();
+        size_t next = 0;
+        data = pipeline_step(s, p.keys, data, len, out, next);
+        if( data == NULL ) {
+            return NULL;
+        }
+        len = next;
+    }
+    out_len = len;
+    return data;
+}
+
+static void pipeline_wipe() {
+    PipelineScratch& scratch = pipeline_scratch;
+    for(int b = 0; b < 2; b++) {
+        sodium_memzero(scratch.block[b].data(), scratch.used);
+        if( scratch.block[b].size() > PIPELINE_SCRATCH_KEEP ) {
+            std::vector<unsigned char>().swap(scratch.block[b]);
+        }
+    }
+    scratch.used = 0;
+}
+
+// Run `p` over each input into its own vector; `ok[i]` says if input `i` made it through
+static void pipeline_run_batch(const PipelineProgram& p, const std::vector<SodiumSpan>& inputs,
+                               std::vector<std::vector<unsigned char>>& outputs,
+                               std::vector<unsigned char>& ok, size_t threads) {
+    sodium_batch_parallel(inputs.size(), threads, 8, [&](size_t begin, size_t end) {
+        for(size_t i = begin; i < end; i++) {
+            size_t len = 0;
+            const unsigned char* out = pipeline_run(p, inputs[i].data, inputs[i].size, len);
+            if( out != NULL ) {
+                outputs[i].assign(out, out + len);
+                ok[i] = 1;
+            }
+            pipeline_wipe();
+        }
+    });
+}
+
+// The outputs of a batch as views of one Buffer, null where a step failed.
+// The vectors are wiped as they are copied
+static Napi::Value pipeline_batch_result(Napi::Env env, std::vector<std::vector<unsigned char>>& outputs,
+                                         const std::vector<unsigned char>& ok) {
+    size_t total = 0;
+    for(const auto& out : outputs) {
+        total += out.size();
+    }
+    Napi::Buffer<unsigned char> packed = sodium_new_buffer(env, total);
+    Napi::Function subarray = packed.Get("subarray").As<Napi::Function>();
+    Napi::Array result = Napi::Array::New(env, outputs.size());
+
+    size_t offset = 0;
+    for(size_t i = 0; i < outputs.size(); i++) {
+        if( !ok[i] ) {
+            result.Set((uint32_t) i, env.Null());
+            continue;
+        }
+        size_t size = outputs[i].size();
+        if( size > 0 ) {
+            memcpy(packed.Data() + offset, outputs[i].data(), size);
+            sodium_memzero(outputs[i].data(), size);
+        }
+        result.Set((uint32_t) i, subarray.Call(packed, {
+            Napi::Number::New(env, (double) offset), Napi::Number::New(env, (double) (offset + size)) }));
+        offset += size;
+    }
+    return result;
+}
+
+/**
+ * Resolves to the output of a pipeline run, or to the outputs of a batch
+ */
+class PipelineWorker : public SodiumAsyncWorker {
+public:
+    PipelineWorker(const Napi::CallbackInfo& info, std::shared_ptr<const PipelineProgram> program, size_t count)
+        : SodiumAsyncWorker(info, "SodiumPipeline.run"), program(program), outputs(count), ok(count, 0) {}
+
+    ~PipelineWorker() {
+        for(auto& out : outputs) {
+            if( !out.empty() ) {
+                sodium_memzero(out.data(), out.size());
+            }
+        }
+    }
+
+    std::shared_ptr<const PipelineProgram> program;
+    std::vector<std::vector<unsigned char>> outputs;
+    std::vector<unsigned char> ok;
+    bool batch = false;
+
+protected:
+    Napi::Value Result(Napi::Env env) override {
+        if( batch ) {
+            return pipeline_batch_result(env, outputs, ok);
+        }
+        if( !ok[0] ) {
+            return env.Null();
+        }
+        return Napi::Buffer<unsigned char>::Copy(env, outputs[0].data(), outputs[0].size());
+    }
+};
+
+// Read step `i` of the recipe into `step`, its key appended to `keys`.
+// Returns an empty string, or the error
+static std::string pipeline_parse_step(Napi::Env env, Napi::Value value, size_t i, PipelineStep& step,
+                                       std::vector<unsigned char>& keys) {
+    std::string where = "step " + std::to_string(i) + ": ";
+    Napi::Object options;
+    Napi::Value op = value;
+    if( value.IsObject() && !value.IsArray() ) {
+        options = value.As<Napi::Object>();
+        op = options.Get("op");
+    }
+    if( !op.IsString() ) {
+        return where + "must be an op name or an object with an op";
+    }
+
+    std::string name = op.As<Napi::String>().Utf8Value();
+    size_t key_min = 0, key_max = 0;
+    step.op = -1;
+    for( const auto& o : pipeline_ops ) {
+        if( name == o.name ) {
+            step.op = o.op;
+            key_min = o.key_min;
+            key_max = o.key_max;
+        }
+    }
+    if( step.op < 0 ) {
+        return where + "unknown op " + name;
+    }
+
+    step.key = keys.size();
+    step.key_size = 0;
+    step.bytes = crypto_generichash_BYTES;
+    step.variant = sodium_base64_VARIANT_ORIGINAL;
+    step.append = false;
+    if( options.IsEmpty() ) {
+        return key_min > 0 ? where + name + " needs a key" : "";
+    }
+
+    Napi::Value key = options.Get("key");
+    if( key_max > 0 && !key.IsUndefined() ) {
+        unsigned char* data = NULL;
+        if( !sodium_arg_bytes(key, data, step.key_size) ) {
+            return where + "key must be a buffer";
+        }
+        if( step.key_size < std::max(key_min, (size_t) crypto_generichash_KEYBYTES_MIN) || step.key_size > key_max ) {
+            return where + name + " takes a key of " +
+                (key_min == key_max ? std::to_string(key_max) :
+                 std::to_string(crypto_generichash_KEYBYTES_MIN) + " to " + std::to_string(key_max)) + " bytes";
+        }
+        keys.insert(keys.end(), data, data + step.key_size);
+    } else if( key_min > 0 ) {
+        return where + name + " needs a key";
+    }
+
+    Napi::Value ad = options.Get("ad");
+    if( !ad.IsUndefined() && !ad.IsNull() ) {
+        unsigned char* data = NULL;
+        size_t size = 0;
+        if( (step.op != PIPELINE_AEAD_XCHACHA20POLY1305_ENCRYPT && step.op != PIPELINE_AEAD_XCHACHA20POLY1305_DECRYPT) ||
+            !sodium_arg_bytes(ad, data, size) ) {
+            return where + "ad must be a buffer, and only for the AEAD ops";
+        }
+        step.ad.assign(data, data + size);
+    }
+
+    Napi::Value bytes = options.Get("bytes");
+    if( !bytes.IsUndefined() ) {
+        double b = bytes.IsNumber() ? bytes.As<Napi::Number>().DoubleValue() : 0;
+        if( step.op != PIPELINE_GENERICHASH || !(b >= crypto_generichash_BYTES_MIN && b <= crypto_generichash_BYTES_MAX) ) {
+            return where + "bytes must be between crypto_generichash_BYTES_MIN and crypto_generichash_BYTES_MAX, and only for crypto_generichash";
+        }
+        step.bytes = (size_t) b;
+    }
+
+    Napi::Value variant = options.Get("variant");
+    if( !variant.IsUndefined() ) {
+        int v = variant.IsNumber() ? variant.As<Napi::Number>().Int32Value() : -1;
+        if( (step.op != PIPELINE_BASE64_DECODE && step.op != PIPELINE_BASE64_ENCODE) ||
+            (v != sodium_base64_VARIANT_ORIGINAL && v != sodium_base64_VARIANT_ORIGINAL_NO_PADDING &&
+             v != sodium_base64_VARIANT_URLSAFE && v != sodium_base64_VARIANT_URLSAFE_NO_PADDING) ) {
+            return where + "variant must be a sodium_base64_VARIANT_ constant, and only for the base64 ops";
+        }
+        step.variant = v;
+    }
+
+    step.append = options.Get("append").ToBoolean().Value();
+    if( step.append && (step.op < PIPELINE_HASH_SHA256 || step.op > PIPELINE_AUTH_HMACSHA512) ) {
+        return where + "append is only for the hash and auth ops";
+    }
+    return "";
+}
+
+class SodiumPipeline : public Napi::ObjectWrap<SodiumPipeline> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "SodiumPipeline", {
+            InstanceMethod("run", &SodiumPipeline::Run),
+            InstanceMethod("runAsync", &SodiumPipeline::RunAsync),
+            InstanceMethod("runBatch", &SodiumPipeline::RunBatch),
+            InstanceMethod("runBatchAsync", &SodiumPipeline::RunBatchAsync),
+            InstanceMethod("dispose", &SodiumPipeline::Dispose)
+        });
+
+        Napi::Array ops = Napi::Array::New(env);
+        uint32_t n = 0;
+        for( const auto& op : pipeline_ops ) {
+            ops.Set(n++, Napi::String::New(env, op.name));
+        }
+        ctor.Set("ops", ops);
+
+        exports.Set(Napi::String::New(env, "SodiumPipeline"), ctor);
+    }
+
+    SodiumPipeline(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<SodiumPipeline>(info) {
+        Napi::Env env = info.Env();
+
+        if( info.Length() < 1 || !info[0].IsArray() ) {
+            Napi::TypeError::New(env, "argument steps must be an array").ThrowAsJavaScriptException();
+            return;
+        }
+        Napi::Array steps = info[0].As<Napi::Array>();
+        if( steps.Length() == 0 || steps.Length() > PIPELINE_MAX_STEPS ) {
+            Napi::RangeError::New(env, "a pipeline takes 1 to " + std::to_string(PIPELINE_MAX_STEPS) + " steps").ThrowAsJavaScriptException();
+            return;
+        }
+
+        std::shared_ptr<PipelineProgram> p = std::make_shared<PipelineProgram>(env);
+        std::vector<unsigned char> keys;
+        std::string error;
+        p->steps.resize(steps.Length());
+        for(uint32_t i = 0; i < steps.Length() && error.empty(); i++) {
+            error = pipeline_parse_step(env, steps.Get(i), i, p->steps[i], keys);
+        }
+
+        if( error.empty() && !keys.empty() ) {
+            p->keys = (unsigned char*) sodium_secret_alloc(env, keys.size());
+            if( p->keys == NULL ) {
+                error = "cannot allocate secure memory for the keys";
+            } else {
+                p->keys_size = keys.size();
+                memcpy(p->keys, keys.data(), keys.size());
+                sodium_secret_readonly(p->keys);
+            }
+        }
+        if( !keys.empty() ) {
+            sodium_memzero(keys.data(), keys.size());
+        }
+        if( !error.empty() ) {
+            Napi::Error::New(env, error).ThrowAsJavaScriptException();
+            return;
+        }
+
+        program = p;
+        info.This().As<Napi::Object>().Set("steps", Napi::Number::New(env, (double) p->steps.size()));
+    }
+
+private:
+#define CHECK_CONTEXT() \
+    if( !program ) { \
+        THROW_ERROR("SodiumPipeline was disposed"); \
+    }
+
+// Optional `threads` number argument
+#define ARG_TO_THREADS(NAME) \
+    size_t NAME = 1; \
+    if( info.Length() > (size_t) _arg && info[_arg].IsNumber() ) { \
+        ARG_TO_NUMBER(NAME ## _arg); \
+        NAME = NAME ## _arg; \
+    }
+
+    Napi::Value Run(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument input must be a buffer");
+        ARG_TO_UCHAR_BUFFER(input);
+
+        size_t len = 0;
+        const unsigned char* out = pipeline_run(*program, input, input_size, len);
+        if( out == NULL ) {
+            pipeline_wipe();
+            return NAPI_NULL;
+        }
+        NEW_BUFFER_AND_PTR(result, len);
+        if( len > 0 ) {
+            memcpy(result_ptr, out, len);
+        }
+        pipeline_wipe();
+        return result;
+    }
+
+    Napi::Value RunAsync(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument input must be a buffer");
+        ARG_TO_UCHAR_BUFFER(input);
+
+        PipelineWorker* worker = new PipelineWorker(info, program, 1);
+        const unsigned char* in = worker->Pin(input_buffer);
+        size_t in_size = input_size;
+
+        return worker->StartTiered([=]() {
+            size_t len = 0;
+            const unsigned char* out = pipeline_run(*worker->program, in, in_size, len);
+            if( out != NULL ) {
+                worker->outputs[0].assign(out, out + len);
+                worker->ok[0] = 1;
+            }
+            pipeline_wipe();
+            return out != NULL ? 0 : -1;
+        }, ASYNC_RESULT_BUFFER, input_size);
+    }
+
+    Napi::Value RunBatch(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument inputs must be an array of buffers");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(inputs, count);
+        ARG_TO_THREADS(threads);
+
+        std::vector<std::vector<unsigned char>> outputs(count);
+        std::vector<unsigned char> ok(count, 0);
+        pipeline_run_batch(*program, inputs, outputs, ok, threads);
+        return pipeline_batch_result(env, outputs, ok);
+    }
+
+    Napi::Value RunBatchAsync(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+
+        CHECK_CONTEXT();
+        ARGS(1, "argument inputs must be an array of buffers");
+        size_t count = SODIUM_BATCH_ANY;
+        ARG_TO_BATCH(inputs, count);
+        ARG_TO_THREADS(threads);
+
+        // The worker gets its own copies so the inputs may be reused while
+        // the batch runs
+        PipelineWorker* worker = new PipelineWorker(info, program, count);
+        worker->batch = true;
+        std::vector<SodiumSpan> copies(count);
+        for(size_t i = 0; i < count; i++) {
+            copies[i].data = inputs[i].size ? worker->Copy(inputs[i].data, inputs[i].size) : NULL;
+            copies[i].size = inputs[i].size;
+        }
+
+        return worker->Start([=]() {
+            pipeline_run_batch(*worker->program, copies, worker->outputs, worker->ok, threads);
+            return 0;
+        }, ASYNC_RESULT_BUFFER);
+    }
+
+    Napi::Value Dispose(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        program.reset();
+        return env.Undefined();
+    }
+
+#undef CHECK_CONTEXT
+#undef ARG_TO_THREADS
+
+    std::shared_ptr<const PipelineProgram> program;
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_pipeline(Napi::Env env, Napi::Object exports) {
+    SodiumPipeline::Init(env, exports);
+}
@@ -0,0 +1,252 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+#include "sodium_env.h"
+#include "sodium_memory.h"
+
+/**
+ * Output buffer pool
+ *
+ * A Buffer made with `Napi::Buffer::New` is its own allocation, with an
+ * external memory adjustment and a finalizer. For 16 byte tags and 32 byte
+ * hashes that bookkeeping costs more than the crypto. When the pool is on,
+ * small results are instead views carved from shared slabs, the way
+ * `Buffer.allocUnsafe` uses Node's own pool.
+ *
+ * Each power of two size class from 16 bytes up to the pooled maximum has
+ * its own slab, and a result takes the slot of the smallest class it fits,
+ * so tags, hashes and signatures stay aligned to their size. A full slab is
+ * dropped, not reused: it is freed by the GC once its last view is gone.
+ *
+ * Every environment, the main thread and each worker, has its own pool in
+ * its SodiumEnv, enabled and sized independently.
+ */
+
+#define POOL_MIN_CLASS          16
+#define POOL_MAX_CLASSES        16
+#define POOL_DEFAULT_SLAB_SIZE  8192
+#define POOL_DEFAULT_MAX_SIZE   128
+
+struct PoolClass {
+    napi_ref slab;
+    size_t used;
+};
+
+struct SodiumPool {
+    bool enabled;
+    napi_ref subarray;
+    PoolClass classes[POOL_MAX_CLASSES];
+    size_t class_count;
+    size_t slab_size;
+    size_t max_size;
+
+    double pooled;
+    double unpooled;
+    double slabs;
+};
+
+static void pool_reset(Napi::Env env, SodiumPool* pool) {
+    if( !pool->enabled ) {
+        return;
+    }
+    for(size_t i = 0; i < pool->class_count; i++) {
+        if( pool->classes[i].slab != NULL ) {
+            napi_delete_reference(env, pool->classes[i].slab);
+            pool->classes[i].slab = NULL;
+        }
+    }
+    napi_delete_reference(env, pool->subarray);
+    pool->subarray = NULL;
+    pool->class_count = 0;
+    pool->enabled = false;
+}
+
+void sodium_pool_free(Napi::Env env, SodiumPool* pool) {
+    pool_reset(env, pool);
+    delete pool;
+}
+
+Napi::Buffer<unsigned char> sodium_new_buffer(Napi::Env env, size_t size) {
+    SodiumEnv* state = SodiumEnv::Get(env);
+    if( state != NULL && state->arena != NULL ) {
+        Napi::Buffer<unsigned char> view;
+        if( sodium_arena_alloc(env, state->arena, size, view) ) {
+            return view;
+        }
+    }
+    if( state == NULL || state->pool == NULL || !state->pool->enabled ) {
+        return Napi::Buffer<unsigned char>::New(env, size);
+    }
+    SodiumPool* pool = state->pool;
+    if( size == 0 || size > pool->max_size ) {
+        pool->unpooled++;
+        return Napi::Buffer<unsigned char>::New(env, size);
+    }
+
+    size_t stride = POOL_MIN_CLASS, c = 0;
+    while( stride < size ) {
+        stride <<= 1;
+        c++;
+    }
+    PoolClass& slot = pool->classes[c];
+
+    Napi::Buffer<unsigned char> slab;
+    if( slot.slab == NULL || slot.used + stride > pool->slab_size ) {
+        slab = Napi::Buffer<unsigned char>::New(env, pool->slab_size);
+        if( slot.slab != NULL ) {
+            napi_delete_reference(env, slot.slab);
+        }
+        napi_create_reference(env, slab, 1, &slot.slab);
+        slot.used = 0;
+        pool->slabs++;
+    } else {
+        napi_value value;
+        napi_get_reference_value(env, slot.slab, &value);
+        slab = Napi::Buffer<unsigned char>(env, value);
+    }
+
+    napi_value subarray;
+    napi_get_reference_value(env, pool->subarray, &subarray);
+    Napi::Value view = Napi::Function(env, subarray).Call(slab, {
+        Napi::Number::New(env, (double) slot.used),
+        Napi::Number::New(env, (double) (slot.used + size))
+    });
+    slot.used += stride;
+    pool->pooled++;
+
+    return Napi::Buffer<unsigned char>(env, view);
+}
+
+/**
+ * sodium_pool_enable:
+ * Carve small results out of shared slabs
+ *
+ *     sodium.sodium_pool_enable([slabSize], [maxSize]);
+ *
+ * ~ slabSize (Number): optional, bytes per slab, 8192 by default
+ * ~ maxSize (Number): optional, largest result served from the pool, 128 by
+ *   default. It is rounded up to a power of two and cannot exceed `slabSize`
+ *
+ * Pooled results share memory with each other through `buffer.buffer`,
+ * exactly like `Buffer.allocUnsafe` results do. Only enable the pool when
+ * no code hands a result's `ArrayBuffer` to an untrusted party.
+ *
+ * Enabling an enabled pool starts new slabs. Counters are reset.
+ */
+NAPI_METHOD(sodium_pool_enable) {
+    Napi::Env env = info.Env();
+
+    size_t slabSize = POOL_DEFAULT_SLAB_SIZE;
+    size_t maxSize = POOL_DEFAULT_MAX_SIZE;
+    if( info.Length() > 0 && !info[0].IsUndefined() ) {
+        GET_ARG_AS_NUMBER(0, slab_size);
+        slabSize = slab_size;
+    }
+    if( info.Length() > 1 && !info[1].IsUndefined() ) {
+        GET_ARG_AS_NUMBER(1, max_size);
+        maxSize = max_size;
+    }
+
+    size_t classes = 1, largest = POOL_MIN_CLASS;
+    while( largest < maxSize ) {
+        largest <<= 1;
+        classes++;
+    }
+    if( classes > POOL_MAX_CLASSES || largest > slabSize ) {
+        THROW_ERROR("maxSize, rounded up to a power of two, cannot be bigger than slabSize");
+    }
+
+    SodiumEnv* state = SodiumEnv::Get(env);
+    if( state->pool == NULL ) {
+        state->pool = new SodiumPool();
+        state->pool->enabled = false;
+    }
+    SodiumPool* pool = state->pool;
+    pool_reset(env, pool);
+
+    Napi::Object prototype = env.Global().Get("Buffer").As<Napi::Object>()
+                                .Get("prototype").As<Napi::Object>();
+    Napi::Value subarray = prototype.Get("subarray");
+
+    napi_create_reference(env, subarray, 1, &pool->subarray);
+    for(size_t i = 0; i < classes; i++) {
+        pool->classes[i].slab = NULL;
+        pool->classes[i].used = 0;
+    }
+    pool->class_count = classes;
+    pool->slab_size = slabSize;
+    pool->max_size = largest;
+    pool->pooled = pool->unpooled = pool->slabs = 0;
+    pool->enabled = true;
+
+    return env.Undefined();
+}
+
+/**
+ * sodium_pool_disable:
+ * Go back to one allocation per result. Slabs are freed by the GC once no
+ * view uses them
+ */
+NAPI_METHOD(sodium_pool_disable) {
+    Napi::Env env = info.Env();
+
+    SodiumEnv* state = SodiumEnv::Get(env);
+    if( state->pool != NULL ) {
+        pool_reset(env, state->pool);
+    }
+
+    return env.Undefined();
+}
+
+/**
+ * sodium_pool_stats:
+ * Pool counters
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ enabled, slabSize, maxSize, pooled, unpooled, slabs }`
+ */
+NAPI_METHOD(sodium_pool_stats) {
+    Napi::Env env = info.Env();
+
+    SodiumPool* pool = SodiumEnv::Get(env)->pool;
+    bool enabled = pool != NULL && pool->enabled;
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "enabled"), Napi::Boolean::New(env, enabled));
+    result.Set(Napi::String::New(env, "slabSize"), Napi::Number::New(env, enabled ? (double) pool->slab_size : 0));
+    result.Set(Napi::String::New(env, "maxSize"), Napi::Number::New(env, enabled ? (double) pool->max_size : 0));
+    result.Set(Napi::String::New(env, "pooled"), Napi::Number::New(env, pool != NULL ? pool->pooled : 0));
+    result.Set(Napi::String::New(env, "unpooled"), Napi::Number::New(env, pool != NULL ? pool->unpooled : 0));
+    result.Set(Napi::String::New(env, "slabs"), Napi::Number::New(env, pool != NULL ? pool->slabs : 0));
+    return result;
+}
+
+// See sodium_memory_usage. Only the slabs results are still being cut
+// from: older ones live as long as their views
+size_t sodium_pool_memory(Napi::Env env) {
+    SodiumPool* pool = SodiumEnv::Get(env)->pool;
+    if( pool == NULL || !pool->enabled ) {
+        return 0;
+    }
+    size_t bytes = 0;
+    for(size_t i = 0; i < pool->class_count; i++) {
+        if( pool->classes[i].slab != NULL ) {
+            bytes += pool->slab_size;
+        }
+    }
+    return bytes;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_pool(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_pool_enable);
+    EXPORT(sodium_pool_disable);
+    EXPORT(sodium_pool_stats);
+}
@@ -0,0 +1,502 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#else
+#include <malloc.h>
+#endif
+
+#include "node_sodium.h"
+#include "sodium_threads.h"
+#include "sodium_memory.h"
+
+/**
+ * Argon2 memory pool
+ *
+ * Every Argon2 hash maps `memlimit` bytes, faults each page in and unmaps
+ * them when it is done: at 64MB and more per login the kernel spends about
+ * as long zeroing pages as Argon2 spends filling them. When the pool is on,
+ * the memory of a finished hash is wiped and kept for the next one instead.
+ *
+ * Regions are shared by all threads, so each hash running at the same time
+ * holds one of them; `maxRegions` is best set to the number of password
+ * hashing threads. A hash takes the smallest free region that fits it.
+ *
+ * The hooks are installed in the vendored Argon2 (argon2-core.c) when the
+ * module loads, and fall back to its own allocation while the pool is off.
+ *
+ * Huge pages
+ *
+ * Argon2 reads its blocks pseudo-randomly over the whole region, so on 4KB
+ * pages almost every reference block is a TLB miss. On Linux the regions
+ * can be backed with 2MB pages, either transparent huge pages (an aligned
+ * mapping with `madvise(MADV_HUGEPAGE)`) or explicit ones from the hugetlb
+ * reserve (`MAP_HUGETLB`). Explicit pages fall back to transparent ones, and
+ * those to plain pages, when the system has none to give; the stats say
+ * which backing each mapped byte got. Huge pages apply whether or not the
+ * pool keeps regions between hashes.
+ *
+ * NUMA
+ *
+ * Pages are placed on the NUMA node of the thread that first touches them,
+ * so a region belongs to the node it was faulted in on. A hash takes a free
+ * region of its own node over a closer fitting one elsewhere, and the stats
+ * count the hits that had to cross nodes.
+ */
+
+extern "C" {
+typedef void *(*argon2_region_alloc_fn)(size_t size);
+typedef void (*argon2_region_release_fn)(void *base, size_t size);
+
+void argon2_set_region_allocator(argon2_region_alloc_fn alloc,
+                                 argon2_region_release_fn release);
+}
+
+#define ARGON2_POOL_DEFAULT_REGIONS 2
+
+// Argon2 works on 1KB blocks, in 4 slices per lane
+#define ARGON2_POOL_BLOCK_BYTES 1024
+#define ARGON2_POOL_MIN_BLOCKS  8
+
+#define ARGON2_HUGE_PAGE_BYTES  (2 * 1024 * 1024)
+
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+#define ARGON2_HAVE_HUGE_PAGES 1
+#endif
+
+// Region backings, also the huge page modes
+enum {
+    ARGON2_PAGES_NORMAL = 0,
+    ARGON2_PAGES_TRANSPARENT,
+    ARGON2_PAGES_EXPLICIT,
+    ARGON2_PAGES_COUNT
+};
+
+static const char* argon2_pages_names[ARGON2_PAGES_COUNT] = {
+    "off", "transparent", "explicit"
+};
+
+struct Argon2Region {
+    void* base;
+    size_t size;
+    int backing;
+    int node;               // NUMA node the pages were faulted in on, or -1
+};
+
+static struct Argon2Pool {
+    std::mutex lock;
+    bool enabled = false;
+    size_t max_regions = 0;
+    std::vector<Argon2Region> free;
+    std::unordered_map<void*, Argon2Region> used;
+
+    int huge_pages = ARGON2_PAGES_NORMAL;
+    double mapped[ARGON2_PAGES_COUNT] = { 0 };  // bytes mapped per backing
+    double fallbacks = 0;
+
+    double hits = 0;
+    double misses = 0;
+    double remote_hits = 0;     // hits on a region of another NUMA node
+} &argon2_pool = *new Argon2Pool();
+
+#if defined(ARGON2_HAVE_HUGE_PAGES)
+static size_t argon2_round_huge(size_t size) {
+    return (size + ARGON2_HUGE_PAGE_BYTES - 1) & ~((size_t) ARGON2_HUGE_PAGE_BYTES - 1);
+}
+
+// Transparent huge pages need 2MB aligned ranges: map a huge page more than
+// needed and cut off both ends. The pages are faulted in after the advice,
+// MAP_POPULATE would fault them in as 4KB pages first
+static void* argon2_region_map_transparent(size_t size) {
+    size_t span = size + ARGON2_HUGE_PAGE_BYTES;
+    unsigned char* raw = (unsigned char*) mmap(NULL, span, PROT_READ | PROT_WRITE,
+                                               MAP_ANON | MAP_PRIVATE, -1, 0);
+    if( raw == (unsigned char*) MAP_FAILED ) {
+        return NULL;
+    }
+    uintptr_t start = ((uintptr_t) raw + ARGON2_HUGE_PAGE_BYTES - 1) & ~((uintptr_t) ARGON2_HUGE_PAGE_BYTES - 1);
+    unsigned char* base = (unsigned char*) start;
+    if( base > raw ) {
+        munmap(raw, base - raw);
+    }
+    munmap(base + size, (raw + span) - (base + size));
+
+    if( madvise(base, size, MADV_HUGEPAGE) != 0 ) {
+        munmap(base, size);
+        return NULL;
+    }
+    for(size_t i = 0; i < size; i += 4096) {
+        ((volatile unsigned char*) base)[i] = 0;
+    }
+    return base;
+}
+#endif
+
+// Map a region with the requested backing, falling back one step at a time.
+// `region.size` comes back as the mapped length, `region.backing` as the
+// backing it got
+static bool argon2_region_map(size_t size, int want, Argon2Region& region) {
+#if defined(ARGON2_HAVE_HUGE_PAGES)
+    if( want != ARGON2_PAGES_NORMAL ) {
+        size_t rounded = argon2_round_huge(size);
+        void* base;
+#if defined(MAP_HUGETLB)
+        if( want == ARGON2_PAGES_EXPLICIT ) {
+            base = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                        MAP_ANON | MAP_PRIVATE | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+            if( base != MAP_FAILED ) {
+                region = { base, rounded, ARGON2_PAGES_EXPLICIT, -1 };
+                return true;
+            }
+        }
+#endif
+        base = argon2_region_map_transparent(rounded);
+        if( base != NULL ) {
+            region = { base, rounded, ARGON2_PAGES_TRANSPARENT, -1 };
+            return true;
+        }
+    }
+#else
+    (void) want;
+#endif
+
+#if defined(_WIN32)
+    void* base = _aligned_malloc(size, 64);
+    if( base == NULL ) {
+        return false;
+    }
+#else
+    int flags = MAP_ANON | MAP_PRIVATE;
+#ifdef MAP_POPULATE
+    flags |= MAP_POPULATE;
+#endif
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if( base == MAP_FAILED ) {
+        return false;
+    }
+#endif
+    region = { base, size, ARGON2_PAGES_NORMAL, -1 };
+    return true;
+}
+
+// Map a region on the calling thread, which faults its pages in, and note
+// the node they landed on
+static bool argon2_region_map_here(size_t size, int want, Argon2Region& region) {
+    if( !argon2_region_map(size, want, region) ) {
+        return false;
+    }
+    int cpu;
+    sodium_thread_where(cpu, region.node);
+    return true;
+}
+
+static void argon2_region_unmap(const Argon2Region& region) {
+#if defined(_WIN32)
+    _aligned_free(region.base);
+#else
+    munmap(region.base, region.size);
+#endif
+}
+
+static void* argon2_pool_alloc(size_t size) {
+    std::unique_lock<std::mutex> guard(argon2_pool.lock);
+    if( !argon2_pool.enabled && argon2_pool.huge_pages == ARGON2_PAGES_NORMAL ) {
+        return NULL;
+    }
+
+    // The smallest region that fits, from this thread's node if it has one
+    int cpu, node;
+    sodium_thread_where(cpu, node);
+    size_t none = argon2_pool.free.size();
+    size_t best = none;
+    for(size_t i = 0; i < argon2_pool.free.size(); i++) {
+        const Argon2Region& r = argon2_pool.free[i];
+        if( r.size < size ) {
+            continue;
+        }
+        if( best == none ) {
+            best = i;
+            continue;
+        }
+        bool local = r.node == node;
+        bool best_local = argon2_pool.free[best].node == node;
+        if( (local && !best_local) || (local == best_local && r.size < argon2_pool.free[best].size) ) {
+            best = i;
+        }
+    }
+    if( best < none ) {
+        Argon2Region region = argon2_pool.free[best];
+        argon2_pool.free.erase(argon2_pool.free.begin() + best);
+        argon2_pool.used[region.base] = region;
+        argon2_pool.hits++;
+        if( region.node != node ) {
+            argon2_pool.remote_hits++;
+        }
+        return region.base;
+    }
+
+    argon2_pool.misses++;
+    int want = argon2_pool.huge_pages;
+    guard.unlock();
+    Argon2Region region;
+    bool mapped = argon2_region_map_here(size, want, region);
+    guard.lock();
+    if( !mapped ) {
+        return NULL;
+    }
+    if( region.backing != want ) {
+        argon2_pool.fallbacks++;
+    }
+    argon2_pool.mapped[region.backing] += (double) region.size;
+    argon2_pool.used[region.base] = region;
+    return region.base;
+}
+
+// Called with the lock held
+static void argon2_pool_unmap(const Argon2Region& region) {
+    argon2_pool.mapped[region.backing] -= (double) region.size;
+    argon2_region_unmap(region);
+}
+
+// `size` is what the hash asked for, so only the bytes it used are wiped
+static void argon2_pool_release(void* base, size_t size) {
+    sodium_memzero(base, size);
+
+    std::unique_lock<std::mutex> guard(argon2_pool.lock);
+    auto it = argon2_pool.used.find(base);
+    Argon2Region region = it->second;
+    argon2_pool.used.erase(it);
+
+    if( argon2_pool.enabled && argon2_pool.free.size() < argon2_pool.max_regions ) {
+        argon2_pool.free.push_back(region);
+        return;
+    }
+    argon2_pool_unmap(region);
+}
+
+// Release free regions beyond `keep`. Called with the lock held
+static void argon2_pool_trim(size_t keep) {
+    while( argon2_pool.free.size() > keep ) {
+        Argon2Region region = argon2_pool.free.back();
+        argon2_pool.free.pop_back();
+        argon2_pool_unmap(region);
+    }
+}
+
+/**
+ * sodium_pwhash_memory_pool_enable:
+ * Keep the memory of finished Argon2 hashes for the next ones
+ *
+ *     sodium.sodium_pwhash_memory_pool_enable([maxRegions], [memlimit]);
+ *
+ * ~ maxRegions (Number): optional, most regions kept between hashes, 2 by
+ *   default
+ * ~ memlimit (Number): optional, map and fault in `maxRegions` regions for
+ *   hashes with this memory limit right away, so even the first logins do
+ *   not pay for it. Prefaulted regions are on the NUMA node of the calling
+ *   thread; on multi node hosts, leave it out so that regions are faulted
+ *   in by the hashing threads
+ *
+ * Pooled memory is wiped when a hash is done with it, but it stays mapped,
+ * and counts towards the resident size of the process, until the pool is
+ * disabled.
+ */
+NAPI_METHOD(sodium_pwhash_memory_pool_enable) {
+    Napi::Env env = info.Env();
+
+    size_t maxRegions = ARGON2_POOL_DEFAULT_REGIONS;
+    size_t memlimit = 0;
+    if( info.Length() > 0 && !info[0].IsUndefined() ) {
+        GET_ARG_AS_NUMBER(0, max_regions);
+        maxRegions = max_regions;
+    }
+    if( info.Length() > 1 && !info[1].IsUndefined() ) {
+        GET_ARG_AS_NUMBER(1, prefault);
+        memlimit = prefault;
+    }
+
+    // The size Argon2 asks for: whole blocks, a multiple of its 4 slices
+    size_t blocks = memlimit / ARGON2_POOL_BLOCK_BYTES;
+    if( blocks < ARGON2_POOL_MIN_BLOCKS ) {
+        blocks = ARGON2_POOL_MIN_BLOCKS;
+    }
+    size_t size = (blocks / 4) * 4 * ARGON2_POOL_BLOCK_BYTES;
+
+    std::lock_guard<std::mutex> guard(argon2_pool.lock);
+    argon2_pool.enabled = true;
+    argon2_pool.max_regions = maxRegions;
+    argon2_pool_trim(maxRegions);
+
+    if( memlimit > 0 ) {
+        // Regions too small for these hashes would only be in the way
+        for(size_t i = argon2_pool.free.size(); i-- > 0; ) {
+            if( argon2_pool.free[i].size < size ) {
+                argon2_pool_unmap(argon2_pool.free[i]);
+                argon2_pool.free.erase(argon2_pool.free.begin() + i);
+            }
+        }
+        while( argon2_pool.free.size() < argon2_pool.max_regions ) {
+            Argon2Region region;
+            if( !argon2_region_map_here(size, argon2_pool.huge_pages, region) ) {
+                THROW_ERROR("could not map memory for the Argon2 memory pool");
+            }
+            if( region.backing != argon2_pool.huge_pages ) {
+                argon2_pool.fallbacks++;
+            }
+            argon2_pool.mapped[region.backing] += (double) region.size;
+            argon2_pool.free.push_back(region);
+        }
+    }
+
+    return env.Undefined();
+}
+
+/**
+ * sodium_pwhash_memory_pool_disable:
+ * Unmap the free regions and go back to one mapping per hash. Regions in use
+ * are unmapped when their hash is done
+ */
+NAPI_METHOD(sodium_pwhash_memory_pool_disable) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> guard(argon2_pool.lock);
+    argon2_pool.enabled = false;
+    argon2_pool_trim(0);
+
+    return env.Undefined();
+}
+
+/**
+ * sodium_pwhash_memory_huge_pages:
+ * Back Argon2 memory with huge pages
+ *
+ *     sodium.sodium_pwhash_memory_huge_pages(mode);
+ *
+ * ~ mode (String): `'off'`, `'transparent'` or `'explicit'`
+ *
+ * Applies to regions mapped from now on; call it before
+ * `sodium_pwhash_memory_pool_enable()` to prefault huge page regions.
+ * Regions are rounded up to whole 2MB pages, so hashes with small or odd
+ * memory limits map a little more than they use.
+ *
+ * **Returns**:
+ *
+ * ~ string: the mode in effect, `'off'` where huge pages are not supported
+ */
+NAPI_METHOD(sodium_pwhash_memory_huge_pages) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument mode must be a string");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument mode must be a string");
+    }
+    std::string name = info[0].As<Napi::String>().Utf8Value();
+
+    int mode = ARGON2_PAGES_COUNT;
+    for(int i = 0; i < ARGON2_PAGES_COUNT; i++) {
+        if( name == argon2_pages_names[i] ) {
+            mode = i;
+        }
+    }
+    if( mode == ARGON2_PAGES_COUNT ) {
+        THROW_ERROR("mode must be 'off', 'transparent' or 'explicit'");
+    }
+#if !defined(ARGON2_HAVE_HUGE_PAGES)
+    mode = ARGON2_PAGES_NORMAL;
+#endif
+
+    std::lock_guard<std::mutex> guard(argon2_pool.lock);
+    argon2_pool.huge_pages = mode;
+
+    return Napi::String::New(env, argon2_pages_names[mode]);
+}
+
+/**
+ * sodium_pwhash_memory_pool_stats:
+ * Argon2 memory pool counters
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ enabled, maxRegions, regions, bytes, inUse, hits, misses,
+ *   hugePages, mapped, fallbacks, remoteHits, nodes }`. `regions` and
+ *   `bytes` are the free regions kept by the pool, `inUse` the regions
+ *   hashes are working on.
+ *   `mapped` splits the bytes of all regions by what backs them,
+ *   `{ normal, transparent, explicit }`, and `fallbacks` counts the regions
+ *   that did not get the huge pages asked for. The kernel may still split
+ *   transparent huge pages; `AnonHugePages` in `/proc/self/smaps` has the
+ *   final word. `remoteHits` counts the hits on a region faulted in on
+ *   another NUMA node than the hash ran on, and `nodes` the free bytes kept
+ *   per node
+ */
+NAPI_METHOD(sodium_pwhash_memory_pool_stats) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> guard(argon2_pool.lock);
+    double bytes = 0;
+    for(const Argon2Region& region : argon2_pool.free) {
+        bytes += (double) region.size;
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "enabled"), Napi::Boolean::New(env, argon2_pool.enabled));
+    result.Set(Napi::String::New(env, "maxRegions"), Napi::Number::New(env, (double) argon2_pool.max_regions));
+    result.Set(Napi::String::New(env, "regions"), Napi::Number::New(env, (double) argon2_pool.free.size()));
+    result.Set(Napi::String::New(env, "bytes"), Napi::Number::New(env, bytes));
+    result.Set(Napi::String::New(env, "inUse"), Napi::Number::New(env, (double) argon2_pool.used.size()));
+    result.Set(Napi::String::New(env, "hits"), Napi::Number::New(env, argon2_pool.hits));
+    result.Set(Napi::String::New(env, "misses"), Napi::Number::New(env, argon2_pool.misses));
+    result.Set(Napi::String::New(env, "hugePages"), Napi::String::New(env, argon2_pages_names[argon2_pool.huge_pages]));
+
+    Napi::Object mapped = Napi::Object::New(env);
+    mapped.Set(Napi::String::New(env, "normal"), Napi::Number::New(env, argon2_pool.mapped[ARGON2_PAGES_NORMAL]));
+    mapped.Set(Napi::String::New(env, "transparent"), Napi::Number::New(env, argon2_pool.mapped[ARGON2_PAGES_TRANSPARENT]));
+    mapped.Set(Napi::String::New(env, "explicit"), Napi::Number::New(env, argon2_pool.mapped[ARGON2_PAGES_EXPLICIT]));
+    result.Set(Napi::String::New(env, "mapped"), mapped);
+    result.Set(Napi::String::New(env, "fallbacks"), Napi::Number::New(env, argon2_pool.fallbacks));
+    result.Set(Napi::String::New(env, "remoteHits"), Napi::Number::New(env, argon2_pool.remote_hits));
+
+    Napi::Object nodes = Napi::Object::New(env);
+    for(const Argon2Region& region : argon2_pool.free) {
+        Napi::String key = Napi::String::New(env, std::to_string(region.node));
+        Napi::Value had = nodes.Get(key);
+        nodes.Set(key, Napi::Number::New(env, (had.IsNumber() ? had.As<Napi::Number>().DoubleValue() : 0) + (double) region.size));
+    }
+    result.Set(Napi::String::New(env, "nodes"), nodes);
+    return result;
+}
+
+// See sodium_memory_usage: every region mapped, kept or in use
+size_t sodium_pwhash_memory_pool_memory() {
+    std::lock_guard<std::mutex> guard(argon2_pool.lock);
+    double bytes = 0;
+    for(double mapped : argon2_pool.mapped) {
+        bytes += mapped;
+    }
+    return (size_t) bytes;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_pwhash_memory(Napi::Env env, Napi::Object exports) {
+    static std::once_flag hooks;
+    std::call_once(hooks, [] {
+        argon2_set_region_allocator(argon2_pool_alloc, argon2_pool_release);
+    });
+
+    EXPORT(sodium_pwhash_memory_pool_enable);
+    EXPORT(sodium_pwhash_memory_pool_disable);
+    EXPORT(sodium_pwhash_memory_huge_pages);
+    EXPORT(sodium_pwhash_memory_pool_stats);
+}
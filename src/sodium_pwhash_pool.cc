@@ -0,0 +1,312 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include "node_sodium.h"
+#include "node_sodium_async.h"
+#include "sodium_async_channel.h"
+#include "sodium_threads.h"
+
+/**
+ * Password hashing pool
+ *
+ * Argon2 and scrypt hold a thread for as long as it takes to fill their
+ * memory, tens or hundreds of milliseconds. Queued on the libuv threadpool,
+ * a handful of concurrent logins occupy all of its threads and every `fs`,
+ * `dns` and `zlib` call in the process waits behind them.
+ *
+ * The `_async` pwhash bindings use this pool instead: a few threads of its
+ * own, shared by every environment of the process so the limit holds across
+ * worker threads, and a bounded queue. When the queue is full a job fails at
+ * once instead of waiting, so an overloaded server answers quickly with an
+ * error.
+ *
+ * A finished job is handed back to the environment that queued it through
+ * that environment's channel, see sodium_async_channel.h.
+ *
+ * The threads can be pinned to CPUs with the `cpus` option, see
+ * sodium_threads.h. Argon2 faults its memory in from the hashing thread, so
+ * pinned threads fill memory local to their NUMA node.
+ *
+ * Jobs whose AbortSignal fires while they are queued are taken off the queue
+ * and fail at once. Jobs past their deadline fail when a thread picks them
+ * up, without hashing.
+ */
+
+#define PWHASH_POOL_DEFAULT_THREADS   2
+#define PWHASH_POOL_DEFAULT_MAX_QUEUE 256
+#define PWHASH_POOL_MAX_THREADS       64
+
+typedef std::chrono::steady_clock pwhash_clock;
+
+struct PwhashTask {
+    SodiumAsyncWorker* worker;
+    AsyncChannel* channel;
+    pwhash_clock::time_point queued;
+};
+
+struct PwhashPool {
+    std::mutex lock;
+    std::condition_variable wake;
+    std::deque<PwhashTask> queue;
+
+    size_t threads = PWHASH_POOL_DEFAULT_THREADS;   // configured limit
+    size_t alive = 0;                               // started and not exited
+    size_t max_queue = PWHASH_POOL_DEFAULT_MAX_QUEUE;
+    size_t running = 0;
+
+    double submitted = 0;
+    double completed = 0;
+    double rejected = 0;
+    double cancelled = 0;       // dropped, or failed before hashing
+    double wait_total = 0;      // ms spent in the queue by started jobs
+    double wait_max = 0;
+    size_t queue_peak = 0;
+
+    SodiumThreadSlots slots;
+};
+
+// Never destroyed: the threads are detached and may still be waiting on the
+// condition variable while the process exits
+static PwhashPool& pwhash_pool = *new PwhashPool();
+
+static void pwhash_pool_thread(size_t slot) {
+    std::unique_lock<std::mutex> guard(pwhash_pool.lock);
+    for(;;) {
+        pwhash_pool.wake.wait(guard, [] {
+            return !pwhash_pool.queue.empty() || pwhash_pool.alive > pwhash_pool.threads;
+        });
+        // Surplus threads exit, but the last one stays until the queue is
+        // drained, so jobs queued before the pool was turned off still run
+        if( pwhash_pool.alive > pwhash_pool.threads &&
+            (pwhash_pool.queue.empty() || pwhash_pool.alive > 1) ) {
+            break;
+        }
+
+        PwhashTask task = pwhash_pool.queue.front();
+        pwhash_pool.queue.pop_front();
+        pwhash_pool.running++;
+        pwhash_pool.slots.Place(slot);
+
+        double waited = std::chrono::duration<double, std::milli>(pwhash_clock::now() - task.queued).count();
+        pwhash_pool.wait_total += waited;
+        if( waited > pwhash_pool.wait_max ) {
+            pwhash_pool.wait_max = waited;
+        }
+
+        guard.unlock();
+        bool run = sodium_async_channel_begin(task.channel);
+        bool cancelled = false;
+        pwhash_clock::time_point started = pwhash_clock::now();
+        if( run ) {
+            cancelled = task.worker->Cancelled();
+            task.worker->OnExecute(task.worker->Env());
+        }
+        double busy = std::chrono::duration<double, std::milli>(pwhash_clock::now() - started).count();
+        guard.lock();
+        pwhash_pool.running--;
+        pwhash_pool.slots.Record(slot, busy);
+        if( cancelled ) {
+            pwhash_pool.cancelled++;
+        } else {
+            pwhash_pool.completed++;
+        }
+        guard.unlock();
+
+        if( run ) {
+            sodium_async_channel_end(task.channel, task.worker);
+        }
+        sodium_async_channel_release(task.channel);
+        guard.lock();
+    }
+    pwhash_pool.alive--;
+    pwhash_pool.slots.Free(slot);
+}
+
+// Start threads up to the configured limit. Called with the lock held
+static void pwhash_pool_grow() {
+    while( pwhash_pool.alive < pwhash_pool.threads ) {
+        std::thread(pwhash_pool_thread, pwhash_pool.slots.Take()).detach();
+        pwhash_pool.alive++;
+    }
+}
+
+Napi::Value SodiumAsyncWorker::StartPwhash(Job job, SodiumAsyncResult result) {
+    Napi::Env env = Env();
+    if( !options_error.empty() ) {
+        return ThrowOptionsError(env);
+    }
+
+    std::unique_lock<std::mutex> guard(pwhash_pool.lock);
+    if( pwhash_pool.threads == 0 ) {
+        guard.unlock();
+        return Start(job, result);
+    }
+
+    AsyncChannel* channel = sodium_async_channel(env);
+    this->job = job;
+    this->result = result;
+    Napi::Value ret = deferred ? deferred->Promise() : env.Undefined();
+
+    sodium_async_channel_expect(env, channel);
+    pwhash_pool.submitted++;
+
+    if( pwhash_pool.max_queue > 0 && pwhash_pool.queue.size() >= pwhash_pool.max_queue ) {
+        // Fail without running, on a later turn of the event loop so that a
+        // callback is never called before the binding returns
+        pwhash_pool.rejected++;
+        guard.unlock();
+        SetError("password hashing queue is full");
+        sodium_async_channel_send(channel, this);
+        return ret;
+    }
+
+    sodium_async_channel_hold(channel);
+    queued = ASYNC_QUEUED_PWHASH;
+    submitted = std::chrono::steady_clock::now();
+    SODIUM_PROBE2(job_queue, name, queued);
+    pwhash_pool.queue.push_back({ this, channel, pwhash_clock::now() });
+    if( pwhash_pool.queue.size() > pwhash_pool.queue_peak ) {
+        pwhash_pool.queue_peak = pwhash_pool.queue.size();
+    }
+    pwhash_pool_grow();
+    guard.unlock();
+    pwhash_pool.wake.notify_one();
+
+    return ret;
+}
+
+bool SodiumAsyncWorker::DropPwhash() {
+    std::unique_lock<std::mutex> guard(pwhash_pool.lock);
+    for(auto it = pwhash_pool.queue.begin(); it != pwhash_pool.queue.end(); ++it) {
+        if( it->worker != this ) {
+            continue;
+        }
+        AsyncChannel* channel = it->channel;
+        pwhash_pool.queue.erase(it);
+        pwhash_pool.cancelled++;
+        guard.unlock();
+
+        // Completes on a later turn, like a job that ran
+        SetError("cancelled");
+        sodium_async_channel_send(channel, this);
+        sodium_async_channel_release(channel);
+        return true;
+    }
+    return false;
+}
+
+static bool pwhash_pool_count(Napi::Value value, double max) {
+    if( !value.IsNumber() ) {
+        return false;
+    }
+    double n = value.As<Napi::Number>().DoubleValue();
+    return n >= 0 && n <= max && n == (double) (size_t) n;
+}
+
+/**
+ * sodium_pwhash_pool_configure:
+ * Size the password hashing pool used by the `crypto_pwhash*_async` calls
+ *
+ *     sodium.sodium_pwhash_pool_configure({ threads: 2, maxQueue: 256 });
+ *
+ * ~ options.threads (Number): most hashes computed at once, 2 by default.
+ *   0 sends the jobs back to the libuv threadpool. The pool is shared by
+ *   all the worker threads of the process
+ * ~ options.maxQueue (Number): most jobs waiting for a thread, 256 by
+ *   default. Further jobs fail at once with a "password hashing queue is
+ *   full" error. 0 lets the queue grow without limit
+ * ~ options.cpus (Array): CPUs to pin the threads to, thread `i` on
+ *   `cpus[i % cpus.length]`. `null` lets them run anywhere again. Linux only
+ *
+ * Lowering `threads` lets the extra threads finish the job they are on.
+ */
+NAPI_METHOD(sodium_pwhash_pool_configure) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument options must be an object");
+    if( !info[0].IsObject() ) {
+        THROW_ERROR("argument options must be an object");
+    }
+    Napi::Object options = info[0].As<Napi::Object>();
+    Napi::Value threads = options.Get("threads");
+    Napi::Value maxQueue = options.Get("maxQueue");
+    Napi::Value cpus = options.Get("cpus");
+
+    if( !threads.IsUndefined() && !pwhash_pool_count(threads, PWHASH_POOL_MAX_THREADS) ) {
+        THROW_ERROR("options.threads must be an integer between 0 and 64");
+    }
+    if( !maxQueue.IsUndefined() && !pwhash_pool_count(maxQueue, SODIUM_MAX_SAFE_INTEGER) ) {
+        THROW_ERROR("options.maxQueue must be a positive integer or 0");
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(pwhash_pool.lock);
+        std::string error;
+        if( !cpus.IsUndefined() && !pwhash_pool.slots.Configure(cpus, error) ) {
+            THROW_ERROR(error.c_str());
+        }
+        if( !threads.IsUndefined() ) {
+            pwhash_pool.threads = (size_t) threads.As<Napi::Number>().DoubleValue();
+        }
+        if( !maxQueue.IsUndefined() ) {
+            pwhash_pool.max_queue = (size_t) maxQueue.As<Napi::Number>().DoubleValue();
+        }
+        pwhash_pool_grow();
+    }
+    pwhash_pool.wake.notify_all();
+
+    return env.Undefined();
+}
+
+/**
+ * sodium_pwhash_pool_stats:
+ * Password hashing pool counters, for all environments of the process
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ threads, maxQueue, running, queued, queuePeak, submitted,
+ *   completed, rejected, cancelled, waitTotal, waitMax, cpus, workers }`.
+ *   `cancelled` counts the jobs aborted or past their deadline before they
+ *   hashed. Wait times are the milliseconds jobs spent queued before a
+ *   thread picked them up. `workers` has one `{ pinned, cpu, node, jobs,
+ *   busy }` per thread: the CPU it is pinned to or -1, the CPU and NUMA node
+ *   its last job ran on, and the jobs it ran and the milliseconds they took
+ */
+NAPI_METHOD(sodium_pwhash_pool_stats) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> guard(pwhash_pool.lock);
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "threads"), Napi::Number::New(env, (double) pwhash_pool.threads));
+    result.Set(Napi::String::New(env, "maxQueue"), Napi::Number::New(env, (double) pwhash_pool.max_queue));
+    result.Set(Napi::String::New(env, "running"), Napi::Number::New(env, (double) pwhash_pool.running));
+    result.Set(Napi::String::New(env, "queued"), Napi::Number::New(env, (double) pwhash_pool.queue.size()));
+    result.Set(Napi::String::New(env, "queuePeak"), Napi::Number::New(env, (double) pwhash_pool.queue_peak));
+    result.Set(Napi::String::New(env, "submitted"), Napi::Number::New(env, pwhash_pool.submitted));
+    result.Set(Napi::String::New(env, "completed"), Napi::Number::New(env, pwhash_pool.completed));
+    result.Set(Napi::String::New(env, "rejected"), Napi::Number::New(env, pwhash_pool.rejected));
+    result.Set(Napi::String::New(env, "cancelled"), Napi::Number::New(env, pwhash_pool.cancelled));
+    result.Set(Napi::String::New(env, "waitTotal"), Napi::Number::New(env, pwhash_pool.wait_total));
+    result.Set(Napi::String::New(env, "waitMax"), Napi::Number::New(env, pwhash_pool.wait_max));
+    result.Set(Napi::String::New(env, "cpus"), pwhash_pool.slots.Cpus(env));
+    result.Set(Napi::String::New(env, "workers"), pwhash_pool.slots.Stats(env));
+    return result;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_pwhash_pool(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_pwhash_pool_configure);
+    EXPORT(sodium_pwhash_pool_stats);
+}
@@ -0,0 +1,502 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "node_sodium.h"
+
+/**
+ * SodiumRing:
+ * Submission and completion rings in shared memory, served by a native thread
+ *
+ * For the hottest paths even a batched call costs an N-API crossing and a
+ * Promise per job. A ring takes both away: JavaScript writes job descriptors
+ * into an Int32Array over a SharedArrayBuffer, the ring's thread reads them,
+ * runs them on the bytes of a shared arena in place and writes completions
+ * back. Neither side calls the other while both are busy.
+ *
+ *     var ring = new binding.SodiumRing(control, arena, onWake);
+ *
+ * ~ control (Int32Array): the header, the submission queue and the
+ *   completion queue, laid out as `SodiumRing.layout` says. `control[ENTRIES]`
+ *   must hold the queue length, a power of two, before the ring is built
+ * ~ arena (Uint8Array): the bytes jobs read and write, by offset
+ * ~ onWake (Function): called when completions are posted while the
+ *   WAITING flag is set
+ *
+ * Each queue is single producer, single consumer and lock free: JavaScript
+ * only writes SQ_TAIL and CQ_HEAD, the thread only SQ_HEAD and CQ_TAIL, all
+ * with Atomics. `Atomics.notify` cannot wake a native thread, nor a native
+ * thread an `Atomics.wait`, so each side raises a flag before it sleeps:
+ *
+ *   SLEEPING  the thread found no work and waits for wake()
+ *   WAITING   JavaScript found no completions and wants onWake
+ *
+ * and the other side makes the one call needed only when it sees the flag.
+ * The thread spins a little before it sleeps, so under load neither flag is
+ * raised. lib/ring.js wraps all of this as `CryptoRing`.
+ *
+ * Every descriptor is checked against the arena before it runs; one that
+ * points outside it completes with RING_BAD_JOB. The secretbox and AEAD jobs
+ * may write over their input, `out == in`, to work fully in place.
+ *
+ * Methods:
+ *
+ * ~ wake(): wake the thread after publishing jobs while SLEEPING is set
+ * ~ ref(), unref(): whether a pending onWake keeps the process alive
+ * ~ stats(): `{ jobs, failed, sleeps, wakeups, notified }`
+ * ~ close(): stop the thread. Jobs it has not taken are left in the queue
+ */
+
+// Header slots, each queue index on a cache line of its own
+#define RING_SQ_HEAD    0
+#define RING_SQ_TAIL    16
+#define RING_CQ_HEAD    32
+#define RING_CQ_TAIL    48
+#define RING_FLAGS      56
+#define RING_ENTRIES    60
+#define RING_HEADER     64
+
+// Int32 slots per entry. A submission entry is one 64 byte cache line:
+// op, id, out, outLen, in, inLen, aux, auxLen, key, nonce. A completion
+// entry is id, status, length
+#define RING_SQE        16
+#define RING_CQE        4
+#define RING_MAX_ENTRIES (1 << 16)
+
+#define RING_FLAG_SLEEPING 1
+#define RING_FLAG_WAITING  2
+
+// Completion status
+#define RING_OK         0
+#define RING_FAILED     -1
+#define RING_BAD_JOB    -2
+
+// Spins on an empty queue before sleeping
+#define RING_SPINS      2000
+
+enum RingOp {
+    RING_OP_HASH_SHA256 = 1,
+    RING_OP_HASH_SHA512,
+    RING_OP_GENERICHASH,
+    RING_OP_AUTH_HMACSHA256,
+    RING_OP_ONETIMEAUTH,
+    RING_OP_SECRETBOX_EASY,
+    RING_OP_SECRETBOX_OPEN_EASY,
+    RING_OP_AEAD_XCHACHA20POLY1305_ENCRYPT,
+    RING_OP_AEAD_XCHACHA20POLY1305_DECRYPT,
+    RING_OP_AEAD_CHACHA20POLY1305_ENCRYPT,
+    RING_OP_AEAD_CHACHA20POLY1305_DECRYPT,
+    RING_OP_SIGN_DETACHED,
+    RING_OP_SIGN_VERIFY_DETACHED
+};
+
+static const struct {
+    const char* name;
+    int op;
+} ring_ops[] = {
+    { "crypto_hash_sha256", RING_OP_HASH_SHA256 },
+    { "crypto_hash_sha512", RING_OP_HASH_SHA512 },
+    { "crypto_generichash", RING_OP_GENERICHASH },
+    { "crypto_auth_hmacsha256", RING_OP_AUTH_HMACSHA256 },
+    { "crypto_onetimeauth", RING_OP_ONETIMEAUTH },
+    { "crypto_secretbox_easy", RING_OP_SECRETBOX_EASY },
+    { "crypto_secretbox_open_easy", RING_OP_SECRETBOX_OPEN_EASY },
+    { "crypto_aead_xchacha20poly1305_ietf_encrypt", RING_OP_AEAD_XCHACHA20POLY1305_ENCRYPT },
+    { "crypto_aead_xchacha20poly1305_ietf_decrypt", RING_OP_AEAD_XCHACHA20POLY1305_DECRYPT },
+    { "crypto_aead_chacha20poly1305_ietf_encrypt", RING_OP_AEAD_CHACHA20POLY1305_ENCRYPT },
+    { "crypto_aead_chacha20poly1305_ietf_decrypt", RING_OP_AEAD_CHACHA20POLY1305_DECRYPT },
+    { "crypto_sign_detached", RING_OP_SIGN_DETACHED },
+    { "crypto_sign_verify_detached", RING_OP_SIGN_VERIFY_DETACHED }
+};
+
+typedef std::atomic<int32_t> ring_slot;
+static_assert(sizeof(ring_slot) == sizeof(int32_t), "ring slots are Int32Array elements");
+
+class SodiumRing : public Napi::ObjectWrap<SodiumRing> {
+public:
+    static void Init(Napi::Env env, Napi::Object exports) {
+        Napi::Function ctor = DefineClass(env, "SodiumRing", {
+            InstanceMethod("wake", &SodiumRing::Wake),
+            InstanceMethod("ref", &SodiumRing::Ref),
+            InstanceMethod("unref", &SodiumRing::Unref),
+            InstanceMethod("stats", &SodiumRing::Stats),
+            InstanceMethod("close", &SodiumRing::Close)
+        });
+
+        Napi::Object layout = Napi::Object::New(env);
+        layout.Set("SQ_HEAD", Napi::Number::New(env, RING_SQ_HEAD));
+        layout.Set("SQ_TAIL", Napi::Number::New(env, RING_SQ_TAIL));
+        layout.Set("CQ_HEAD", Napi::Number::New(env, RING_CQ_HEAD));
+        layout.Set("CQ_TAIL", Napi::Number::New(env, RING_CQ_TAIL));
+        layout.Set("FLAGS", Napi::Number::New(env, RING_FLAGS));
+        layout.Set("ENTRIES", Napi::Number::New(env, RING_ENTRIES));
+        layout.Set("HEADER", Napi::Number::New(env, RING_HEADER));
+        layout.Set("SQE", Napi::Number::New(env, RING_SQE));
+        layout.Set("CQE", Napi::Number::New(env, RING_CQE));
+        layout.Set("MAX_ENTRIES", Napi::Number::New(env, RING_MAX_ENTRIES));
+        layout.Set("SLEEPING", Napi::Number::New(env, RING_FLAG_SLEEPING));
+        layout.Set("WAITING", Napi::Number::New(env, RING_FLAG_WAITING));
+        layout.Set("OK", Napi::Number::New(env, RING_OK));
+        layout.Set("FAILED", Napi::Number::New(env, RING_FAILED));
+        layout.Set("BAD_JOB", Napi::Number::New(env, RING_BAD_JOB));
+        ctor.Set("layout", layout);
+
+        Napi::Object ops = Napi::Object::New(env);
+        for( const auto& op : ring_ops ) {
+            ops.Set(op.name, Napi::Number::New(env, op.op));
+        }
+        ctor.Set("ops", ops);
+
+        exports.Set(Napi::String::New(env, "SodiumRing"), ctor);
+    }
+
+    SodiumRing(const Napi::CallbackInfo& info)
+        : Napi::ObjectWrap<SodiumRing>(info) {
+        Napi::Env env = info.Env();
+
+        unsigned char* c = NULL;
+        size_t c_size = 0;
+        if( info.Length() < 3 || !info[0].IsTypedArray() ||
+            info[0].As<Napi::TypedArray>().TypedArrayType() != napi_int32_array ||
+            !sodium_arg_bytes(info[0], c, c_size) ) {
+            Napi::TypeError::New(env, "argument control must be an Int32Array").ThrowAsJavaScriptException();
+            return;
+        }
+        if( !sodium_arg_bytes(info[1], arena, arena_size) ) {
+            Napi::TypeError::New(env, "argument arena must be a buffer").ThrowAsJavaScriptException();
+            return;
+        }
+        if( !info[2].IsFunction() ) {
+            Napi::TypeError::New(env, "argument onWake must be a function").ThrowAsJavaScriptException();
+            return;
+        }
+
+        control = (ring_slot*) c;
+        size_t slots = c_size / sizeof(int32_t);
+        entries = slots > RING_ENTRIES ? (uint32_t) control[RING_ENTRIES].load() : 0;
+        if( entries == 0 || entries > RING_MAX_ENTRIES || (entries & (entries - 1)) != 0 ) {
+            Napi::RangeError::New(env, "control[ENTRIES] must be a power of two up to 65536").ThrowAsJavaScriptException();
+            return;
+        }
+        if( slots < RING_HEADER + (size_t) entries * (RING_SQE + RING_CQE) ) {
+            Napi::RangeError::New(env, "argument control is too short for its entries").ThrowAsJavaScriptException();
+            return;
+        }
+        sq = control + RING_HEADER;
+        cq = sq + (size_t) entries * RING_SQE;
+
+        // The thread reads the shared memory until it is joined
+        keep_control = Napi::Persistent(info[0].As<Napi::Object>());
+        keep_arena = Napi::Persistent(info[1].As<Napi::Object>());
+
+        napi_value name = Napi::String::New(env, "SodiumRing");
+        napi_create_threadsafe_function(env, info[2], NULL, name, 0, 1, NULL, NULL,
+            NULL, NULL, &notify);
+        napi_unref_threadsafe_function(env, notify);
+        napi_add_env_cleanup_hook(env, StopHook, this);
+
+        running = true;
+        thread = std::thread(&SodiumRing::Run, this);
+    }
+
+    ~SodiumRing() {
+        Stop();
+    }
+
+private:
+    static void StopHook(void* data) {
+        ((SodiumRing*) data)->Stop();
+    }
+
+    void Stop() {
+        if( !running ) {
+            return;
+        }
+        {
+            // Under the lock, so the thread cannot miss it between its check
+            // and its wait
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+        running = false;
+        napi_release_threadsafe_function(notify, napi_tsfn_abort);
+        napi_remove_env_cleanup_hook(Env(), StopHook, this);
+    }
+
+    // True if [offset, offset + size) is inside the arena
+    bool Fits(uint32_t offset, uint64_t size) {
+        return (uint64_t) offset + size <= arena_size;
+    }
+
+    /**
+     * Run one job in place. Returns the completion status and sets `length`
+     * to the bytes written at `out`
+     */
+    int32_t Execute(const int32_t* e, uint32_t& length) {
+        uint32_t op = (uint32_t) e[0];
+        uint32_t out = (uint32_t) e[2], out_len = (uint32_t) e[3];
+        uint32_t in = (uint32_t) e[4], in_len = (uint32_t) e[5];
+        uint32_t aux = (uint32_t) e[6], aux_len = (uint32_t) e[7];
+        uint32_t key = (uint32_t) e[8], nonce = (uint32_t) e[9];
+        length = 0;
+
+        if( !Fits(in, in_len) || !Fits(aux, aux_len) ) {
+            return RING_BAD_JOB;
+        }
+        unsigned char* o = arena + out;
+        const unsigned char* m = arena + in;
+        const unsigned char* a = arena + aux;
+        const unsigned char* k = arena + key;
+        const unsigned char* n = arena + nonce;
+
+#define RING_NEED(OUT, KEY, NONCE) \
+        if( out_len < (OUT) || !Fits(out, (OUT)) || !Fits(key, (KEY)) || !Fits(nonce, (NONCE)) ) { \
+            return RING_BAD_JOB; \
+        } \
+        length = (uint32_t) (OUT)
+
+        int ret;
+        switch( op ) {
+        case RING_OP_HASH_SHA256:
+            RING_NEED(crypto_hash_sha256_BYTES, 0, 0);
+            ret = crypto_hash_sha256(o, m, in_len);
+            break;
+        case RING_OP_HASH_SHA512:
+            RING_NEED(crypto_hash_sha512_BYTES, 0, 0);
+            ret = crypto_hash_sha512(o, m, in_len);
+            break;
+        case RING_OP_GENERICHASH:
+            // The output length is outLen, the key is the aux bytes
+            if( out_len < crypto_generichash_BYTES_MIN || out_len > crypto_generichash_BYTES_MAX ||
+                (aux_len != 0 && (aux_len < crypto_generichash_KEYBYTES_MIN || aux_len > crypto_generichash_KEYBYTES_MAX)) ) {
+                return RING_BAD_JOB;
+            }
+            RING_NEED(out_len, 0, 0);
+            ret = crypto_generichash(o, out_len, m, in_len, aux_len ? a : NULL, aux_len);
+            break;
+        case RING_OP_AUTH_HMACSHA256:
+            RING_NEED(crypto_auth_hmacsha256_BYTES, crypto_auth_hmacsha256_KEYBYTES, 0);
+            ret = crypto_auth_hmacsha256(o, m, in_len, k);
+            break;
+        case RING_OP_ONETIMEAUTH:
+            RING_NEED(crypto_onetimeauth_BYTES, crypto_onetimeauth_KEYBYTES, 0);
+            ret = crypto_onetimeauth(o, m, in_len, k);
+            break;
+        case RING_OP_SECRETBOX_EASY:
+            RING_NEED((uint64_t) in_len + crypto_secretbox_MACBYTES, crypto_secretbox_KEYBYTES, crypto_secretbox_NONCEBYTES);
+            ret = crypto_secretbox_easy(o, m, in_len, n, k);
+            break;
+        case RING_OP_SECRETBOX_OPEN_EASY:
+            if( in_len < crypto_secretbox_MACBYTES ) {
+                return RING_BAD_JOB;
+            }
+            RING_NEED(in_len - crypto_secretbox_MACBYTES, crypto_secretbox_KEYBYTES, crypto_secretbox_NONCEBYTES);
+            ret = crypto_secretbox_open_easy(o, m, in_len, n, k);
+            break;
+        case RING_OP_AEAD_XCHACHA20POLY1305_ENCRYPT:
+            RING_NEED((uint64_t) in_len + crypto_aead_xchacha20poly1305_ietf_ABYTES,
+                      crypto_aead_xchacha20poly1305_ietf_KEYBYTES, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+            ret = crypto_aead_xchacha20poly1305_ietf_encrypt(o, NULL, m, in_len, a, aux_len, NULL, n, k);
+            break;
+        case RING_OP_AEAD_XCHACHA20POLY1305_DECRYPT:
+            if( in_len < crypto_aead_xchacha20poly1305_ietf_ABYTES ) {
+                return RING_BAD_JOB;
+            }
+            RING_NEED(in_len - crypto_aead_xchacha20poly1305_ietf_ABYTES,
+                      crypto_aead_xchacha20poly1305_ietf_KEYBYTES, crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+            ret = crypto_aead_xchacha20poly1305_ietf_decrypt(o, NULL, NULL, m, in_len, a, aux_len, n, k);
+            break;
+        case RING_OP_AEAD_CHACHA20POLY1305_ENCRYPT:
+            RING_NEED((uint64_t) in_len + crypto_aead_chacha20poly1305_ietf_ABYTES,
+                      crypto_aead_chacha20poly1305_ietf_KEYBYTES, crypto_aead_chacha20poly1305_ietf_NPUBBYTES);
+            ret = crypto_aead_chacha20poly1305_ietf_encrypt(o, NULL, m, in_len, a, aux_len, NULL, n, k);
+            break;
+        case RING_OP_AEAD_CHACHA20POLY1305_DECRYPT:
+            if( in_len < crypto_aead_chacha20poly1305_ietf_ABYTES ) {
+                return RING_BAD_JOB;
+            }
+            RING_NEED(in_len - crypto_aead_chacha20poly1305_ietf_ABYTES,
+                      crypto_aead_chacha20poly1305_ietf_KEYBYTES, crypto_aead_chacha20poly1305_ietf_NPUBBYTES);
+            ret = crypto_aead_chacha20poly1305_ietf_decrypt(o, NULL, NULL, m, in_len, a, aux_len, n, k);
+            break;
+        case RING_OP_SIGN_DETACHED:
+            RING_NEED(crypto_sign_BYTES, crypto_sign_SECRETKEYBYTES, 0);
+            ret = crypto_sign_detached(o, NULL, m, in_len, k);
+            break;
+        case RING_OP_SIGN_VERIFY_DETACHED:
+            // The signature is the aux bytes, nothing is written
+            if( aux_len != crypto_sign_BYTES || !Fits(key, crypto_sign_PUBLICKEYBYTES) ) {
+                return RING_BAD_JOB;
+            }
+            ret = crypto_sign_verify_detached(a, m, in_len, k);
+            break;
+        default:
+            return RING_BAD_JOB;
+        }
+#undef RING_NEED
+
+        if( ret != 0 ) {
+            length = 0;
+            return RING_FAILED;
+        }
+        return RING_OK;
+    }
+
+    // Wait for work. Returns false once the ring is stopping
+    bool Idle(uint32_t head) {
+        for( int i = 0; i < RING_SPINS; i++ ) {
+            if( (uint32_t) control[RING_SQ_TAIL].load() != head ) {
+                return true;
+            }
+            std::this_thread::yield();
+        }
+
+        std::unique_lock<std::mutex> guard(lock);
+        control[RING_FLAGS].fetch_or(RING_FLAG_SLEEPING);
+        // The producer stores its tail before it reads the flags, so either
+        // it sees SLEEPING and calls wake(), or the tail is seen here
+        if( (uint32_t) control[RING_SQ_TAIL].load() == head && !stopping ) {
+            sleeps++;
+            wakeup.wait(guard, [this] { return kicked || stopping; });
+            wakeups++;
+        }
+        kicked = false;
+        control[RING_FLAGS].fetch_and(~RING_FLAG_SLEEPING);
+        return !stopping;
+    }
+
+    void Notify() {
+        if( control[RING_FLAGS].fetch_and(~RING_FLAG_WAITING) & RING_FLAG_WAITING ) {
+            notified++;
+            napi_call_threadsafe_function(notify, NULL, napi_tsfn_nonblocking);
+        }
+    }
+
+    void Run() {
+        uint32_t head = (uint32_t) control[RING_SQ_HEAD].load();
+        uint32_t cq_tail = (uint32_t) control[RING_CQ_TAIL].load();
+        uint32_t mask = entries - 1;
+
+        while( !stopping ) {
+            uint32_t tail = (uint32_t) control[RING_SQ_TAIL].load();
+            if( tail == head ) {
+                if( !Idle(head) ) {
+                    return;
+                }
+                continue;
+            }
+
+            while( head != tail ) {
+                // Completions go out only as fast as they are read
+                if( cq_tail - (uint32_t) control[RING_CQ_HEAD].load() >= entries ) {
+                    Notify();
+                    std::this_thread::yield();
+                    break;
+                }
+
+                int32_t e[RING_SQE];
+                for( int i = 0; i < RING_SQE; i++ ) {
+                    e[i] = sq[(size_t) (head & mask) * RING_SQE + i].load(std::memory_order_relaxed);
+                }
+                uint32_t length;
+                int32_t status = Execute(e, length);
+                jobs++;
+                if( status != RING_OK ) {
+                    failed++;
+                }
+
+                ring_slot* c = cq + (size_t) (cq_tail & mask) * RING_CQE;
+                c[0].store(e[1], std::memory_order_relaxed);
+                c[1].store(status, std::memory_order_relaxed);
+                c[2].store((int32_t) length, std::memory_order_relaxed);
+                head++;
+                cq_tail++;
+                control[RING_SQ_HEAD].store((int32_t) head);
+                control[RING_CQ_TAIL].store((int32_t) cq_tail);
+            }
+            Notify();
+        }
+    }
+
+    Napi::Value Wake(const Napi::CallbackInfo& info) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            kicked = true;
+        }
+        wakeup.notify_one();
+        return info.Env().Undefined();
+    }
+
+    Napi::Value Ref(const Napi::CallbackInfo& info) {
+        if( running ) {
+            napi_ref_threadsafe_function(info.Env(), notify);
+        }
+        return info.Env().Undefined();
+    }
+
+    Napi::Value Unref(const Napi::CallbackInfo& info) {
+        if( running ) {
+            napi_unref_threadsafe_function(info.Env(), notify);
+        }
+        return info.Env().Undefined();
+    }
+
+    Napi::Value Stats(const Napi::CallbackInfo& info) {
+        Napi::Env env = info.Env();
+        Napi::Object result = Napi::Object::New(env);
+        result.Set("jobs", Napi::Number::New(env, (double) jobs.load()));
+        result.Set("failed", Napi::Number::New(env, (double) failed.load()));
+        result.Set("sleeps", Napi::Number::New(env, (double) sleeps.load()));
+        result.Set("wakeups", Napi::Number::New(env, (double) wakeups.load()));
+        result.Set("notified", Napi::Number::New(env, (double) notified.load()));
+        return result;
+    }
+
+    Napi::Value Close(const Napi::CallbackInfo& info) {
+        Stop();
+        keep_control.Reset();
+        keep_arena.Reset();
+        return info.Env().Undefined();
+    }
+
+    ring_slot* control = NULL;
+    ring_slot* sq = NULL;
+    ring_slot* cq = NULL;
+    uint32_t entries = 0;
+    unsigned char* arena = NULL;
+    size_t arena_size = 0;
+    Napi::ObjectReference keep_control;
+    Napi::ObjectReference keep_arena;
+
+    napi_threadsafe_function notify = NULL;
+    std::thread thread;
+    bool running = false;
+
+    std::mutex lock;
+    std::condition_variable wakeup;
+    bool kicked = false;
+    std::atomic<bool> stopping{ false };
+
+    std::atomic<uint64_t> jobs{ 0 };
+    std::atomic<uint64_t> failed{ 0 };
+    std::atomic<uint64_t> sleeps{ 0 };
+    std::atomic<uint64_t> wakeups{ 0 };
+    std::atomic<uint64_t> notified{ 0 };
+};
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_ring(Napi::Env env, Napi::Object exports) {
+    SodiumRing::Init(env, exports);
+}
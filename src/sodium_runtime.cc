@@ -5,7 +5,14 @@
  * @email paixaop at gmail dot com
  * @License MIT
  */
+#include <chrono>
+#include <cstring>
+#include <string>
+
 #include "node_sodium.h"
+#include "sodium_memory.h"
+#include "sodium_probes.h"
+#include "sodium_stats.h"
 
 // int sodium_runtime_has_aesni(void);
 NAPI_METHOD(sodium_runtime_has_aesni) {
@@ -70,6 +77,403 @@ NAPI_METHOD(sodium_runtime_has_pclmul) {
         Napi::Number::New(env, sodium_runtime_has_pclmul());
 }
 
+//int sodium_runtime_has_avx512f(void);
+NAPI_METHOD(sodium_runtime_has_avx512f) {
+    Napi::Env env = info.Env();
+    return 
+        Napi::Number::New(env, sodium_runtime_has_avx512f());
+}
+
+//int sodium_runtime_has_rdrand(void);
+NAPI_METHOD(sodium_runtime_has_rdrand) {
+    Napi::Env env = info.Env();
+    return 
+        Napi::Number::New(env, sodium_runtime_has_rdrand());
+}
+
+//int sodium_runtime_has_shani(void);
+NAPI_METHOD(sodium_runtime_has_shani) {
+    Napi::Env env = info.Env();
+    return 
+        Napi::Number::New(env, sodium_runtime_has_shani());
+}
+
+//int sodium_runtime_has_armcrypto(void);
+NAPI_METHOD(sodium_runtime_has_armcrypto) {
+    Napi::Env env = info.Env();
+    return 
+        Napi::Number::New(env, sodium_runtime_has_armcrypto());
+}
+
+// libsodium picks its kernels in sodium_init() and keeps the choice in
+// static pointers, so it cannot be read back. The report repeats the
+// choice instead: the candidates of each primitive in the order libsodium
+// 1.0.16 tries them, each taken if it was compiled into the library and the
+// CPU supports it. Whether a kernel was compiled is known from its symbol,
+// looked up as a weak reference, where the toolchain has them.
+#if defined(__GNUC__) && !defined(_WIN32)
+#define IMPLEMENTATION_SYMBOLS 1
+#define WEAK_SYMBOL(NAME) extern "C" const char NAME __attribute__((weak));
+#define SYMBOL(NAME) (&NAME)
+#else
+#define WEAK_SYMBOL(NAME)
+#define SYMBOL(NAME) NULL
+#endif
+
+WEAK_SYMBOL(blake2b_compress_avx2)
+WEAK_SYMBOL(blake2b_compress_sse41)
+WEAK_SYMBOL(blake2b_compress_ssse3)
+WEAK_SYMBOL(blake2b_compress_neon)
+WEAK_SYMBOL(fill_segment_avx512f)
+WEAK_SYMBOL(fill_segment_avx2)
+WEAK_SYMBOL(fill_segment_ssse3)
+WEAK_SYMBOL(fill_segment_neon)
+WEAK_SYMBOL(crypto_stream_chacha20_dolbeau_avx2_implementation)
+WEAK_SYMBOL(crypto_stream_chacha20_dolbeau_ssse3_implementation)
+WEAK_SYMBOL(crypto_stream_chacha20_neon_implementation)
+WEAK_SYMBOL(crypto_stream_salsa20_xmm6int_avx2_implementation)
+WEAK_SYMBOL(crypto_stream_salsa20_xmm6_implementation)
+WEAK_SYMBOL(crypto_stream_salsa20_xmm6int_sse2_implementation)
+WEAK_SYMBOL(crypto_onetimeauth_poly1305_avx2_implementation)
+WEAK_SYMBOL(crypto_onetimeauth_poly1305_sse2_implementation)
+WEAK_SYMBOL(crypto_scalarmult_curve25519_sandy2x_implementation)
+WEAK_SYMBOL(crypto_hash_sha256_blocks_shani)
+WEAK_SYMBOL(crypto_hash_sha256_blocks_armcrypto)
+
+static int runtime_always(void) {
+    return 1;
+}
+
+static int runtime_has_aesni(void) {
+    return sodium_runtime_has_aesni() && sodium_runtime_has_pclmul() &&
+        crypto_aead_aes256gcm_is_available();
+}
+
+static int runtime_has_aes_armcrypto(void) {
+    return sodium_runtime_has_armcrypto() && crypto_aead_aes256gcm_is_available();
+}
+
+static int runtime_has_shani(void) {
+    return sodium_runtime_has_shani() && sodium_runtime_has_sse41();
+}
+
+struct Implementation {
+    const char* name;
+    const char* requires;   // CPU feature, or NULL
+    int (*supported)(void);
+    const void* symbol;
+    bool by_symbol;         // if not, it is always compiled in, like the
+                            // portable code, or `supported` covers it
+};
+
+struct Primitive {
+    const char* name;
+    Implementation candidates[6];
+};
+
+static const Primitive primitives[] = {
+    { "generichash_blake2b", {
+        { "avx2", "avx2", sodium_runtime_has_avx2, SYMBOL(blake2b_compress_avx2), true },
+        { "sse41", "sse41", sodium_runtime_has_sse41, SYMBOL(blake2b_compress_sse41), true },
+        { "ssse3", "ssse3", sodium_runtime_has_ssse3, SYMBOL(blake2b_compress_ssse3), true },
+        { "neon", "neon", sodium_runtime_has_neon, SYMBOL(blake2b_compress_neon), true },
+        { "ref", NULL, runtime_always, NULL, false },
+        { NULL } } },
+    { "pwhash_argon2", {
+        { "avx512f", "avx512f", sodium_runtime_has_avx512f, SYMBOL(fill_segment_avx512f), true },
+        { "avx2", "avx2", sodium_runtime_has_avx2, SYMBOL(fill_segment_avx2), true },
+        { "ssse3", "ssse3", sodium_runtime_has_ssse3, SYMBOL(fill_segment_ssse3), true },
+        { "neon", "neon", sodium_runtime_has_neon, SYMBOL(fill_segment_neon), true },
+        { "ref", NULL, runtime_always, NULL, false },
+        { NULL } } },
+    { "stream_chacha20", {
+        { "dolbeau_avx2", "avx2", sodium_runtime_has_avx2, SYMBOL(crypto_stream_chacha20_dolbeau_avx2_implementation), true },
+        { "dolbeau_ssse3", "ssse3", sodium_runtime_has_ssse3, SYMBOL(crypto_stream_chacha20_dolbeau_ssse3_implementation), true },
+        { "neon", "neon", sodium_runtime_has_neon, SYMBOL(crypto_stream_chacha20_neon_implementation), true },
+        { "ref", NULL, runtime_always, NULL, false },
+        { NULL } } },
+    { "stream_salsa20", {
+        { "xmm6int_avx2", "avx2", sodium_runtime_has_avx2, SYMBOL(crypto_stream_salsa20_xmm6int_avx2_implementation), true },
+        { "xmm6", NULL, runtime_always, SYMBOL(crypto_stream_salsa20_xmm6_implementation), true },
+        { "xmm6int_sse2", "sse2", sodium_runtime_has_sse2, SYMBOL(crypto_stream_salsa20_xmm6int_sse2_implementation), true },
+        { "ref", NULL, runtime_always, NULL, false },
+        { NULL } } },
+    { "onetimeauth_poly1305", {
+        { "avx2", "avx2", sodium_runtime_has_avx2, SYMBOL(crypto_onetimeauth_poly1305_avx2_implementation), true },
+        { "sse2", "sse2", sodium_runtime_has_sse2, SYMBOL(crypto_onetimeauth_poly1305_sse2_implementation), true },
+        { "donna", NULL, runtime_always, NULL, false },
+        { NULL } } },
+    { "scalarmult_curve25519", {
+        { "sandy2x", "avx", sodium_runtime_has_avx, SYMBOL(crypto_scalarmult_curve25519_sandy2x_implementation), true },
+        { "ref10", NULL, runtime_always, NULL, false },
+        { NULL } } },
+    { "hash_sha256", {
+        { "shani", "shani+sse41", runtime_has_shani, SYMBOL(crypto_hash_sha256_blocks_shani), true },
+        { "armcrypto", "armcrypto", sodium_runtime_has_armcrypto, SYMBOL(crypto_hash_sha256_blocks_armcrypto), true },
+        { "cp", NULL, runtime_always, NULL, false },
+        { NULL } } },
+    { "aead_aes256gcm", {
+        { "aesni", "aesni+pclmul", runtime_has_aesni, NULL, false },
+        { "armcrypto", "armcrypto", runtime_has_aes_armcrypto, NULL, false },
+        { "unavailable", NULL, runtime_always, NULL, false },
+        { NULL } } }
+};
+
+// The kernel libsodium runs for `name`, a key of `primitives`, or NULL
+const char* sodium_implementation_selected(const char* name) {
+    for(size_t p = 0; p < sizeof primitives / sizeof primitives[0]; p++) {
+        if( strcmp(primitives[p].name, name) != 0 ) {
+            continue;
+        }
+        for(size_t i = 0; primitives[p].candidates[i].name != NULL; i++) {
+            const Implementation& c = primitives[p].candidates[i];
+#ifdef IMPLEMENTATION_SYMBOLS
+            bool has_symbol = !c.by_symbol || c.symbol != NULL;
+#else
+            bool has_symbol = true;
+#endif
+            if( has_symbol && c.supported() != 0 ) {
+                return c.name;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * sodium_implementation_report:
+ * Which kernel libsodium uses for each primitive that has several
+ *
+ *     var report = sodium.sodium_implementation_report();
+ *     // report.generichash_blake2b.selected === 'avx2'
+ *
+ * **Returns**:
+ *
+ * ~ report (Object): for each primitive, `{ selected, candidates }`, where
+ *   `candidates` lists `{ name, requires, compiled, supported }` in the
+ *   order libsodium tries them. `compiled` is `null` when it cannot be told
+ *   on this platform, and such candidates are assumed to be compiled. The
+ *   report also has `cpu`, the features detected at runtime
+ */
+NAPI_METHOD(sodium_implementation_report) {
+    Napi::Env env = info.Env();
+
+    Napi::Object report = Napi::Object::New(env);
+    for(size_t p = 0; p < sizeof primitives / sizeof primitives[0]; p++) {
+        const Primitive& primitive = primitives[p];
+        Napi::Array candidates = Napi::Array::New(env);
+        const char* selected = NULL;
+
+        for(uint32_t i = 0; primitive.candidates[i].name != NULL; i++) {
+            const Implementation& c = primitive.candidates[i];
+            bool supported = c.supported() != 0;
+            bool has_symbol = !c.by_symbol || c.symbol != NULL;
+#ifdef IMPLEMENTATION_SYMBOLS
+            Napi::Value compiled = Napi::Boolean::New(env, has_symbol);
+#else
+            Napi::Value compiled = c.by_symbol ? env.Null() : Napi::Value(Napi::Boolean::New(env, true));
+            has_symbol = true;
+#endif
+            if( selected == NULL && supported && has_symbol ) {
+                selected = c.name;
+            }
+
+            Napi::Object candidate = Napi::Object::New(env);
+            candidate.Set("name", Napi::String::New(env, c.name));
+            candidate.Set("requires", c.requires != NULL ? Napi::Value(Napi::String::New(env, c.requires)) : env.Null());
+            candidate.Set("compiled", compiled);
+            candidate.Set("supported", Napi::Boolean::New(env, supported));
+            candidates.Set(i, candidate);
+        }
+
+        Napi::Object entry = Napi::Object::New(env);
+        entry.Set("selected", Napi::String::New(env, selected));
+        entry.Set("candidates", candidates);
+        report.Set(primitive.name, entry);
+    }
+
+    Napi::Object cpu = Napi::Object::New(env);
+    cpu.Set("neon", Napi::Boolean::New(env, sodium_runtime_has_neon() != 0));
+    cpu.Set("sse2", Napi::Boolean::New(env, sodium_runtime_has_sse2() != 0));
+    cpu.Set("sse3", Napi::Boolean::New(env, sodium_runtime_has_sse3() != 0));
+    cpu.Set("ssse3", Napi::Boolean::New(env, sodium_runtime_has_ssse3() != 0));
+    cpu.Set("sse41", Napi::Boolean::New(env, sodium_runtime_has_sse41() != 0));
+    cpu.Set("avx", Napi::Boolean::New(env, sodium_runtime_has_avx() != 0));
+    cpu.Set("avx2", Napi::Boolean::New(env, sodium_runtime_has_avx2() != 0));
+    cpu.Set("avx512f", Napi::Boolean::New(env, sodium_runtime_has_avx512f() != 0));
+    cpu.Set("pclmul", Napi::Boolean::New(env, sodium_runtime_has_pclmul() != 0));
+    cpu.Set("aesni", Napi::Boolean::New(env, sodium_runtime_has_aesni() != 0));
+    cpu.Set("rdrand", Napi::Boolean::New(env, sodium_runtime_has_rdrand() != 0));
+    cpu.Set("shani", Napi::Boolean::New(env, sodium_runtime_has_shani() != 0));
+    cpu.Set("armcrypto", Napi::Boolean::New(env, sodium_runtime_has_armcrypto() != 0));
+    report.Set("cpu", cpu);
+
+    return report;
+}
+
+#undef WEAK_SYMBOL
+#undef SYMBOL
+
+// Set by binding.gyp from the sodium_build, sodium_march, sodium_subsystems
+// and sodium_pgo variables
+#ifndef SODIUM_BUILD_PROFILE
+#define SODIUM_BUILD_PROFILE "default"
+#endif
+#ifndef SODIUM_BUILD_MARCH
+#define SODIUM_BUILD_MARCH ""
+#endif
+#ifndef SODIUM_BUILD_SUBSYSTEMS
+#define SODIUM_BUILD_SUBSYSTEMS "all"
+#endif
+#ifndef SODIUM_BUILD_PGO
+#define SODIUM_BUILD_PGO ""
+#endif
+
+/**
+ * sodium_build_info:
+ * How the addon was built
+ *
+ *     var build = sodium.sodium_build_info();
+ *
+ * **Returns**:
+ *
+ * ~ build (Object): `{ profile, march, lto, optimized, compiler, subsystems,
+ *   usdt, pgo }`.
+ *   `profile` is `"performance"` for `SODIUM_BUILD=performance` builds, which
+ *   compile libsodium and the addon with `-O3` and link time optimization.
+ *   `march` is the CPU the build targets, empty for a generic build.
+ *   `subsystems` is `"all"` or the `SODIUM_SUBSYSTEMS` list the addon was
+ *   built with, see lib/subsystems.js. `usdt` is true when the USDT probes
+ *   of sodium_probes.h are compiled in. `pgo` is `"use"` for a `make pgo`
+ *   build, `"generate"` for its instrumented build, empty otherwise
+ */
+NAPI_METHOD(sodium_build_info) {
+    Napi::Env env = info.Env();
+
+    Napi::Object build = Napi::Object::New(env);
+    build.Set("profile", Napi::String::New(env, SODIUM_BUILD_PROFILE));
+    build.Set("march", Napi::String::New(env, SODIUM_BUILD_MARCH));
+    build.Set("subsystems", Napi::String::New(env, SODIUM_BUILD_SUBSYSTEMS));
+    build.Set("pgo", Napi::String::New(env, SODIUM_BUILD_PGO));
+#ifdef SODIUM_BUILD_LTO
+    build.Set("lto", Napi::Boolean::New(env, true));
+#else
+    build.Set("lto", Napi::Boolean::New(env, false));
+#endif
+#ifdef SODIUM_USDT
+    build.Set("usdt", Napi::Boolean::New(env, true));
+#else
+    build.Set("usdt", Napi::Boolean::New(env, false));
+#endif
+#if defined(__OPTIMIZE__) || (defined(_MSC_VER) && defined(NDEBUG))
+    build.Set("optimized", Napi::Boolean::New(env, true));
+#else
+    build.Set("optimized", Napi::Boolean::New(env, false));
+#endif
+#if defined(__clang__)
+    build.Set("compiler", Napi::String::New(env, "clang " __clang_version__));
+#elif defined(__GNUC__)
+    build.Set("compiler", Napi::String::New(env, "gcc " __VERSION__));
+#elif defined(_MSC_VER)
+    build.Set("compiler", Napi::String::New(env, "msvc " + std::to_string(_MSC_VER)));
+#else
+    build.Set("compiler", Napi::String::New(env, "unknown"));
+#endif
+
+    return build;
+}
+
+// One small call of each primitive built in, so its code and tables are
+// paged in and libsodium has run its first call setup
+static void warmup_primitives() {
+    unsigned char key[64], nonce[32], m[64], c[64 + 64], out[64];
+    randombytes_buf(key, sizeof key);
+    randombytes_buf(nonce, sizeof nonce);
+    memset(m, 0, sizeof m);
+
+#ifndef SODIUM_NO_HASH
+    crypto_generichash(out, crypto_generichash_BYTES, m, sizeof m, key, crypto_generichash_KEYBYTES);
+    crypto_hash_sha256(out, m, sizeof m);
+    crypto_hash_sha512(out, m, sizeof m);
+    crypto_shorthash(out, m, sizeof m, key);
+#endif
+#ifndef SODIUM_NO_AUTH
+    crypto_auth(out, m, sizeof m, key);
+    crypto_onetimeauth(out, m, sizeof m, key);
+#endif
+#ifndef SODIUM_NO_SECRETBOX
+    crypto_secretbox_easy(c, m, sizeof m, nonce, key);
+    crypto_secretbox_open_easy(out, c, sizeof m + crypto_secretbox_MACBYTES, nonce, key);
+#endif
+#ifndef SODIUM_NO_AEAD
+    crypto_aead_xchacha20poly1305_ietf_encrypt(c, NULL, m, sizeof m, NULL, 0, NULL, nonce, key);
+    crypto_aead_chacha20poly1305_ietf_encrypt(c, NULL, m, sizeof m, NULL, 0, NULL, nonce, key);
+    if( crypto_aead_aes256gcm_is_available() ) {
+        crypto_aead_aes256gcm_encrypt(c, NULL, m, sizeof m, NULL, 0, NULL, nonce, key);
+    }
+#endif
+#ifndef SODIUM_NO_STREAM
+    crypto_stream_xchacha20_xor(c, m, sizeof m, nonce, key);
+#endif
+#ifndef SODIUM_NO_KDF
+    crypto_kdf_derive_from_key(out, 32, 1, "warmup__", key);
+#endif
+#ifndef SODIUM_NO_BOX
+    {
+        unsigned char pk[crypto_box_PUBLICKEYBYTES], sk[crypto_box_SECRETKEYBYTES], k[crypto_box_BEFORENMBYTES];
+        crypto_box_seed_keypair(pk, sk, key);
+        crypto_box_beforenm(k, pk, sk);
+        crypto_box_easy_afternm(c, m, sizeof m, nonce, k);
+        sodium_memzero(sk, sizeof sk);
+        sodium_memzero(k, sizeof k);
+    }
+#endif
+#ifndef SODIUM_NO_SIGN
+    {
+        unsigned char pk[crypto_sign_PUBLICKEYBYTES], sk[crypto_sign_SECRETKEYBYTES];
+        crypto_sign_seed_keypair(pk, sk, key);
+        crypto_sign_detached(out, NULL, m, sizeof m, sk);
+        crypto_sign_verify_detached(out, m, sizeof m, pk);
+        sodium_memzero(sk, sizeof sk);
+    }
+#endif
+#ifndef SODIUM_NO_KX
+    crypto_scalarmult_base(out, key);
+#endif
+
+    sodium_memzero(key, sizeof key);
+    sodium_memzero(out, sizeof out);
+}
+
+/**
+ * sodium_warmup:
+ * Pay now what the first calls of a fresh process would
+ *
+ *     var ms = sodium.sodium_warmup();
+ *
+ * Makes one small call of each primitive the addon was built with, so
+ * their code is paged in and libsodium has done its first call setup,
+ * gives the calling thread its operation counters, and, when the secure
+ * pool is on, opens its regions for 32 and 64 byte secrets. libsodium
+ * picks its CPU specific code when the addon loads, before this call.
+ * Password hashing is left out: see sodium_pwhash_memory_pool_enable().
+ *
+ * **Returns**:
+ *
+ * ~ ms (Number): milliseconds taken
+ */
+NAPI_METHOD(sodium_warmup) {
+    Napi::Env env = info.Env();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    sodium_stats_local();
+    warmup_primitives();
+    sodium_secure_pool_warmup();
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    return Napi::Number::New(env, ms);
+}
+
 /**
  * Register function calls in node binding
  */
@@ -84,4 +488,11 @@ void register_runtime(Napi::Env env, Napi::Object exports) {
     EXPORT(sodium_runtime_has_sse3);
     EXPORT(sodium_runtime_has_sse41);
     EXPORT(sodium_runtime_has_ssse3);
+    EXPORT(sodium_runtime_has_avx512f);
+    EXPORT(sodium_runtime_has_rdrand);
+    EXPORT(sodium_runtime_has_shani);
+    EXPORT(sodium_runtime_has_armcrypto);
+    EXPORT(sodium_implementation_report);
+    EXPORT(sodium_build_info);
+    EXPORT(sodium_warmup);
 }
\ No newline at end of file
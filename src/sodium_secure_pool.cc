@@ -0,0 +1,120 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include "node_sodium.h"
+#include "sodium_memory.h"
+
+/**
+ * Secret memory of wrapped objects: a slot of the secure pool, see
+ * sodium_secure_slots.cc, or a `sodium_malloc` block of its own
+ */
+
+void* sodium_secret_alloc(napi_env env, size_t size) {
+    size_t footprint = 0;
+    void* p = sodium_slot_alloc(size, footprint);
+    if( p == NULL ) {
+        p = sodium_malloc(size);
+        if( p == NULL ) {
+            return NULL;
+        }
+        footprint = sodium_secure_footprint(size);
+    }
+    sodium_memory_hold(env, (int64_t) footprint);
+    return p;
+}
+
+void sodium_secret_readonly(void* p) {
+    if( sodium_slot_owns(p) ) {
+        return;
+    }
+    sodium_mprotect_readonly(p);
+}
+
+void sodium_secret_free(napi_env env, void* p, size_t size) {
+    if( p == NULL ) {
+        return;
+    }
+    int64_t footprint;
+    if( sodium_slot_free(p) ) {
+        footprint = (int64_t) sodium_slot_size(size);
+    } else {
+        sodium_free(p);
+        footprint = (int64_t) sodium_secure_footprint(size);
+    }
+    sodium_memory_hold(env, -footprint);
+}
+
+void sodium_secure_pool_warmup() {
+    sodium_slots_warmup();
+}
+
+size_t sodium_secure_pool_memory() {
+    SodiumSlotStats stats = sodium_slots_stats();
+    return stats.bytes - stats.used;
+}
+
+/**
+ * sodium_secure_pool_enable:
+ * Keep the secrets of new objects in slots of shared locked regions
+ *
+ *     sodium.sodium_secure_pool_enable();
+ *
+ * Applies to the keys and states, up to 1KB, of `AeadContext`,
+ * `AeadKeyring`, `BoxSession`, `HmacKey`, `PasetoKey` and `SigningKey`
+ * objects made from now on. A 32 byte key then takes a 64 byte slot
+ * instead of four pages. Slots are not made read only.
+ */
+NAPI_METHOD(sodium_secure_pool_enable) {
+    Napi::Env env = info.Env();
+
+    sodium_slots_enable();
+    return NAPI_TRUE;
+}
+
+/**
+ * sodium_secure_pool_disable:
+ * Give new objects their own `sodium_malloc` blocks again. Slots in use
+ * stay until their objects are freed, and each region is freed with its
+ * last slot
+ */
+NAPI_METHOD(sodium_secure_pool_disable) {
+    Napi::Env env = info.Env();
+
+    sodium_slots_disable();
+    return NAPI_TRUE;
+}
+
+/**
+ * sodium_secure_pool_stats:
+ *
+ * **Returns**:
+ *
+ * ~ object: `{ enabled, regions, slots, used, bytes }`. `slots` are the
+ *   slots in use and `used` their bytes, canaries included. `bytes` is the
+ *   memory of the regions, guard pages included
+ */
+NAPI_METHOD(sodium_secure_pool_stats) {
+    Napi::Env env = info.Env();
+
+    SodiumSlotStats stats = sodium_slots_stats();
+    Napi::Object result = Napi::Object::New(env);
+    result.Set("enabled", Napi::Boolean::New(env, stats.enabled));
+    result.Set("regions", Napi::Number::New(env, (double) stats.regions));
+    result.Set("slots", Napi::Number::New(env, (double) stats.slots));
+    result.Set("used", Napi::Number::New(env, (double) stats.used));
+    result.Set("bytes", Napi::Number::New(env, (double) stats.bytes));
+    return result;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_secure_pool(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_secure_pool_enable);
+    EXPORT(sodium_secure_pool_disable);
+    EXPORT(sodium_secure_pool_stats);
+}
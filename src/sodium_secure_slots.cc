@@ -0,0 +1,228 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "sodium.h"
+#include "sodium_secure_slots.h"
+
+/**
+ * Secure slot pool
+ *
+ * Each `sodium_malloc` block takes its own pages plus three guard and canary
+ * pages, and a few mmap, mprotect and mlock calls: 16KB and a handful of
+ * system calls for a 32 byte session key. With the pool on, the secrets of
+ * wrapped objects up to SODIUM_SLOT_MAX bytes are instead carved out of
+ * shared 64KB regions, themselves `sodium_malloc` blocks: locked, kept out
+ * of core dumps, and between guard pages.
+ *
+ * Every region holds slots of one size class, a multiple of 64 bytes so
+ * each slot is 64 byte aligned. The last 16 bytes of a slot are a canary,
+ * random per process, checked when the slot is freed: an overflow into the
+ * next slot aborts the process, as it does for `sodium_free`. Slots are
+ * wiped when freed.
+ *
+ * What the pool gives up is per secret page protection: slots cannot be
+ * made read only, and an overflow within a slot's own object is only caught
+ * when the slot is freed, not on the faulting write. Keep the pool off for
+ * a few long lived master keys, and turn it on for many short lived ones.
+ */
+
+#define SECURE_REGION_SIZE (64 * 1024)
+#define SECURE_SLOT_ALIGN 64
+#define SECURE_CANARY_SIZE 16
+
+struct SecureRegion {
+    unsigned char* base;
+    size_t slot;                    // bytes per slot, canary included
+    size_t used;
+    std::vector<unsigned char*> free;
+};
+
+static std::mutex pool_mutex;
+static bool pool_enabled = false;
+static unsigned char canary[SECURE_CANARY_SIZE];
+static bool canary_set = false;
+
+// Regions by base address, to find the region of a pointer being freed
+static std::map<uintptr_t, SecureRegion*> regions;
+
+// Regions with free slots, by slot size
+static std::map<size_t, std::vector<SecureRegion*> > partial;
+
+static size_t pool_slots_used = 0;
+static size_t pool_bytes_used = 0;
+
+size_t sodium_slot_size(size_t size) {
+    return (size + SECURE_CANARY_SIZE + SECURE_SLOT_ALIGN - 1) / SECURE_SLOT_ALIGN * SECURE_SLOT_ALIGN;
+}
+
+static SecureRegion* region_new(size_t slot) {
+    unsigned char* base = (unsigned char*) sodium_malloc(SECURE_REGION_SIZE);
+    if( base == NULL ) {
+        return NULL;
+    }
+    SecureRegion* region = new SecureRegion();
+    region->base = base;
+    region->slot = slot;
+    region->used = 0;
+    size_t count = SECURE_REGION_SIZE / slot;
+    region->free.reserve(count);
+    for(size_t i = count; i > 0; i--) {
+        region->free.push_back(base + (i - 1) * slot);
+    }
+    regions[(uintptr_t) base] = region;
+    return region;
+}
+
+static void region_free(SecureRegion* region) {
+    regions.erase((uintptr_t) region->base);
+    sodium_free(region->base);
+    delete region;
+}
+
+// Region holding `p`, or NULL if `p` is not a slot
+static SecureRegion* region_of(const void* p) {
+    auto it = regions.upper_bound((uintptr_t) p);
+    if( it == regions.begin() ) {
+        return NULL;
+    }
+    --it;
+    SecureRegion* region = it->second;
+    return (uintptr_t) p < (uintptr_t) region->base + SECURE_REGION_SIZE ? region : NULL;
+}
+
+void* sodium_slot_alloc(size_t size, size_t& footprint) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if( !pool_enabled || size > SODIUM_SLOT_MAX ) {
+        return NULL;
+    }
+
+    size_t slot = sodium_slot_size(size);
+    std::vector<SecureRegion*>& open = partial[slot];
+    if( open.empty() ) {
+        SecureRegion* region = region_new(slot);
+        if( region == NULL ) {
+            return NULL;
+        }
+        open.push_back(region);
+    }
+
+    SecureRegion* region = open.back();
+    unsigned char* p = region->free.back();
+    region->free.pop_back();
+    if( region->free.empty() ) {
+        open.pop_back();
+    }
+    region->used++;
+    pool_slots_used++;
+    pool_bytes_used += slot;
+
+    memcpy(p + slot - SECURE_CANARY_SIZE, canary, SECURE_CANARY_SIZE);
+    footprint = slot;
+    return p;
+}
+
+bool sodium_slot_free(void* p) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    SecureRegion* region = region_of(p);
+    if( region == NULL ) {
+        return false;
+    }
+
+    unsigned char* slot = (unsigned char*) p;
+    if( sodium_memcmp(slot + region->slot - SECURE_CANARY_SIZE, canary, SECURE_CANARY_SIZE) != 0 ) {
+        sodium_misuse();
+    }
+    sodium_memzero(slot, region->slot);
+
+    std::vector<SecureRegion*>& open = partial[region->slot];
+    if( region->free.empty() ) {
+        open.push_back(region);
+    }
+    region->free.push_back(slot);
+    region->used--;
+    pool_slots_used--;
+    pool_bytes_used -= region->slot;
+
+    // Keep one empty region per size class while the pool is on
+    if( region->used == 0 && (!pool_enabled || open.size() > 1) ) {
+        for(auto it = open.begin(); it != open.end(); ++it) {
+            if( *it == region ) {
+                open.erase(it);
+                break;
+            }
+        }
+        region_free(region);
+    }
+    return true;
+}
+
+bool sodium_slot_owns(const void* p) {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return region_of(p) != NULL;
+}
+
+void sodium_slots_enable() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if( !canary_set ) {
+        randombytes_buf(canary, sizeof canary);
+        canary_set = true;
+    }
+    pool_enabled = true;
+}
+
+// Slots in use stay until they are freed, and each region is freed with
+// its last slot
+void sodium_slots_disable() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    pool_enabled = false;
+    for(auto& entry : partial) {
+        std::vector<SecureRegion*>& open = entry.second;
+        for(size_t i = 0; i < open.size(); ) {
+            if( open[i]->used == 0 ) {
+                region_free(open[i]);
+                open.erase(open.begin() + i);
+            } else {
+                i++;
+            }
+        }
+    }
+}
+
+void sodium_slots_warmup() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    if( !pool_enabled ) {
+        return;
+    }
+    // Regions for 32 byte keys and 64 byte secret keys and states
+    const size_t sizes[] = { 32, 64 };
+    for(size_t size : sizes) {
+        std::vector<SecureRegion*>& open = partial[sodium_slot_size(size)];
+        if( open.empty() ) {
+            SecureRegion* region = region_new(sodium_slot_size(size));
+            if( region != NULL ) {
+                open.push_back(region);
+            }
+        }
+    }
+}
+
+SodiumSlotStats sodium_slots_stats() {
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    SodiumSlotStats stats;
+    stats.enabled = pool_enabled;
+    stats.regions = regions.size();
+    stats.slots = pool_slots_used;
+    stats.used = pool_bytes_used;
+    stats.bytes = regions.size() * sodium_secure_footprint(SECURE_REGION_SIZE);
+    return stats;
+}
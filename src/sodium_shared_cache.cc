@@ -0,0 +1,397 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#if !defined(_WIN32)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "node_sodium.h"
+#include "sodium_memory.h"
+#include "sodium_shared_cache.h"
+
+/**
+ * Shared memory cache segments
+ *
+ * The worker processes of a `cluster` each compute the same box shared keys
+ * and decompressed verify keys for the same peers. A segment lets them
+ * compute each once: it is a POSIX shared memory object mapped by every
+ * process that opens the same name, locked in memory and left out of core
+ * dumps.
+ *
+ * The segment is a header and a table of slots grouped in buckets of
+ * SHARED_CACHE_WAYS. A value goes to the bucket picked by its id, replacing
+ * an empty slot or else the least recently used one of the bucket. Every
+ * slot has a sequence lock: a writer takes it by moving the sequence from
+ * even to odd, and a reader copies the slot and keeps the copy only if the
+ * sequence was even and did not change meanwhile. Reads never block or
+ * write anything but the slot's use tick, and a writer that finds a slot
+ * taken skips the insert instead of waiting.
+ *
+ * Ids are a keyed BLAKE2b of the inputs. The key is drawn by the process
+ * that creates the segment and read by the others, so ids match across
+ * processes while secret keys never reach the table.
+ */
+
+#define SHARED_CACHE_MAGIC 0x4e534843   // "NSHC"
+#define SHARED_CACHE_VERSION 1
+#define SHARED_CACHE_WAYS 8
+
+// Segment states
+#define SHARED_CACHE_FRESH 0
+#define SHARED_CACHE_READY 1
+
+// How long an opener waits for the creator to finish the header
+#define SHARED_CACHE_INIT_WAIT_MS 2000
+
+#if ATOMIC_INT_LOCK_FREE != 2 || ATOMIC_LLONG_LOCK_FREE != 2
+#error "shared cache segments need lock free atomics"
+#endif
+
+struct SharedCacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<uint32_t> state;
+    uint32_t value_size;
+    uint64_t buckets;
+    std::atomic<uint64_t> clock;
+    std::atomic<uint64_t> size;
+    unsigned char format[SHARED_CACHE_FORMATBYTES];
+    unsigned char id_key[crypto_generichash_KEYBYTES];
+};
+
+struct SharedCacheSlot {
+    std::atomic<uint32_t> seq;
+    uint32_t used;
+    std::atomic<uint64_t> tick;
+    unsigned char id[SHARED_CACHE_IDBYTES];
+    // followed by the value
+};
+
+struct SharedCache {
+    std::string name;
+    unsigned char* base;
+    size_t mapped;
+    size_t slot_size;
+    bool locked;
+    SharedCacheHeader* header;
+    unsigned char* slots;
+
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    std::atomic<uint64_t> inserts;
+    std::atomic<uint64_t> evictions;
+};
+
+// Bytes of every segment this process has mapped
+static std::atomic<size_t> shared_cache_bytes(0);
+
+static size_t shared_cache_header_size() {
+    return (sizeof(SharedCacheHeader) + 63) & ~(size_t) 63;
+}
+
+static SharedCacheSlot* shared_cache_slot(const SharedCache* cache, uint64_t i) {
+    return (SharedCacheSlot*) (cache->slots + i * cache->slot_size);
+}
+
+static unsigned char* shared_cache_value(SharedCacheSlot* slot) {
+    return (unsigned char*) (slot + 1);
+}
+
+static uint64_t shared_cache_bucket(const SharedCache* cache, const unsigned char* id) {
+    uint64_t h;
+    memcpy(&h, id, sizeof h);
+    return (h % cache->header->buckets) * SHARED_CACHE_WAYS;
+}
+
+#if !defined(_WIN32)
+
+SharedCache* shared_cache_open(const char* name, size_t value_size, size_t capacity,
+                               const unsigned char* format, std::string& error) {
+    std::string path = std::string("/node-sodium-") + name;
+    size_t slot_size = (sizeof(SharedCacheSlot) + value_size + 7) & ~(size_t) 7;
+    uint64_t buckets = (capacity + SHARED_CACHE_WAYS - 1) / SHARED_CACHE_WAYS;
+    if( buckets == 0 ) {
+        buckets = 1;
+    }
+    size_t size = shared_cache_header_size() + buckets * SHARED_CACHE_WAYS * slot_size;
+
+    bool created = true;
+    int fd = shm_open(path.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if( fd < 0 && errno == EEXIST ) {
+        created = false;
+        fd = shm_open(path.c_str(), O_RDWR, 0600);
+    }
+    if( fd < 0 ) {
+        error = std::string("cannot open shared memory segment ") + path + ": " + strerror(errno);
+        return NULL;
+    }
+
+    if( created ) {
+        if( ftruncate(fd, (off_t) size) != 0 ) {
+            error = std::string("cannot size shared memory segment ") + path + ": " + strerror(errno);
+            close(fd);
+            shm_unlink(path.c_str());
+            return NULL;
+        }
+    } else {
+        // Take the geometry of the segment, once its creator has sized it
+        struct stat st;
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(SHARED_CACHE_INIT_WAIT_MS);
+        while( fstat(fd, &st) == 0 && (size_t) st.st_size < shared_cache_header_size() &&
+               std::chrono::steady_clock::now() < deadline ) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        if( (size_t) st.st_size < shared_cache_header_size() ) {
+            error = std::string("shared memory segment ") + path + " was never initialized";
+            close(fd);
+            return NULL;
+        }
+        size = (size_t) st.st_size;
+    }
+
+    void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if( base == MAP_FAILED ) {
+        error = std::string("cannot map shared memory segment ") + path + ": " + strerror(errno);
+        if( created ) {
+            shm_unlink(path.c_str());
+        }
+        return NULL;
+    }
+
+    SharedCacheHeader* header = (SharedCacheHeader*) base;
+    if( created ) {
+        header->magic = SHARED_CACHE_MAGIC;
+        header->version = SHARED_CACHE_VERSION;
+        header->value_size = (uint32_t) value_size;
+        header->buckets = buckets;
+        memcpy(header->format, format, SHARED_CACHE_FORMATBYTES);
+        randombytes_buf(header->id_key, sizeof header->id_key);
+        header->state.store(SHARED_CACHE_READY, std::memory_order_release);
+    } else {
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::milliseconds(SHARED_CACHE_INIT_WAIT_MS);
+        while( header->state.load(std::memory_order_acquire) != SHARED_CACHE_READY &&
+               std::chrono::steady_clock::now() < deadline ) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        const char* problem = NULL;
+        if( header->state.load(std::memory_order_acquire) != SHARED_CACHE_READY ) {
+            problem = "was never initialized";
+        } else if( header->magic != SHARED_CACHE_MAGIC || header->version != SHARED_CACHE_VERSION ) {
+            problem = "is not a node-sodium cache of this version";
+        } else if( header->value_size != value_size ||
+                   sodium_memcmp(header->format, format, SHARED_CACHE_FORMATBYTES) != 0 ) {
+            problem = "holds another kind of value";
+        } else if( shared_cache_header_size() + header->buckets * SHARED_CACHE_WAYS * slot_size > size ) {
+            problem = "is truncated";
+        }
+        if( problem != NULL ) {
+            error = std::string("shared memory segment ") + path + " " + problem;
+            munmap(base, size);
+            return NULL;
+        }
+    }
+
+    SharedCache* cache = new SharedCache();
+    cache->name = name;
+    cache->base = (unsigned char*) base;
+    cache->mapped = size;
+    cache->slot_size = slot_size;
+    // Best effort: mlock fails past RLIMIT_MEMLOCK, and stats() says so
+    cache->locked = sodium_mlock(base, size) == 0;
+    cache->header = header;
+    cache->slots = cache->base + shared_cache_header_size();
+    cache->hits = cache->misses = cache->inserts = cache->evictions = 0;
+    shared_cache_bytes += size;
+    return cache;
+}
+
+void shared_cache_close(SharedCache* cache) {
+    if( cache == NULL ) {
+        return;
+    }
+    // Not sodium_munlock: it would wipe the segment under the other processes
+    if( cache->locked ) {
+        munlock(cache->base, cache->mapped);
+    }
+    munmap(cache->base, cache->mapped);
+    shared_cache_bytes -= cache->mapped;
+    delete cache;
+}
+
+#else
+
+SharedCache* shared_cache_open(const char* name, size_t value_size, size_t capacity,
+                               const unsigned char* format, std::string& error) {
+    error = "shared memory cache segments are not supported on Windows";
+    return NULL;
+}
+
+void shared_cache_close(SharedCache* cache) {
+}
+
+#endif
+
+void shared_cache_id(const SharedCache* cache, unsigned char* id,
+                     const unsigned char* a, size_t a_size,
+                     const unsigned char* b, size_t b_size) {
+    crypto_generichash_state state;
+
+    crypto_generichash_init(&state, cache->header->id_key, sizeof cache->header->id_key,
+                            SHARED_CACHE_IDBYTES);
+    crypto_generichash_update(&state, a, a_size);
+    if( b != NULL ) {
+        crypto_generichash_update(&state, b, b_size);
+    }
+    crypto_generichash_final(&state, id, SHARED_CACHE_IDBYTES);
+    sodium_memzero(&state, sizeof state);
+}
+
+bool shared_cache_get(SharedCache* cache, const unsigned char* id, unsigned char* value) {
+    uint64_t first = shared_cache_bucket(cache, id);
+    size_t value_size = cache->header->value_size;
+
+    for(uint64_t i = first; i < first + SHARED_CACHE_WAYS; i++) {
+        SharedCacheSlot* slot = shared_cache_slot(cache, i);
+        uint32_t seq = slot->seq.load(std::memory_order_acquire);
+        if( (seq & 1) != 0 || slot->used == 0 ||
+            memcmp(slot->id, id, SHARED_CACHE_IDBYTES) != 0 ) {
+            continue;
+        }
+        memcpy(value, shared_cache_value(slot), value_size);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if( slot->seq.load(std::memory_order_relaxed) != seq ) {
+            // Rewritten while we copied it
+            break;
+        }
+        slot->tick.store(cache->header->clock.fetch_add(1, std::memory_order_relaxed) + 1,
+                         std::memory_order_relaxed);
+        cache->hits++;
+        return true;
+    }
+    cache->misses++;
+    return false;
+}
+
+void shared_cache_put(SharedCache* cache, const unsigned char* id, const unsigned char* value) {
+    uint64_t first = shared_cache_bucket(cache, id);
+    SharedCacheSlot* victim = NULL;
+    uint64_t oldest = UINT64_MAX;
+
+    for(uint64_t i = first; i < first + SHARED_CACHE_WAYS; i++) {
+        SharedCacheSlot* slot = shared_cache_slot(cache, i);
+        if( slot->used == 0 ) {
+            victim = slot;
+            oldest = 0;
+            break;
+        }
+        if( memcmp(slot->id, id, SHARED_CACHE_IDBYTES) == 0 ) {
+            // Another process got there first
+            return;
+        }
+        uint64_t tick = slot->tick.load(std::memory_order_relaxed);
+        if( tick < oldest ) {
+            victim = slot;
+            oldest = tick;
+        }
+    }
+
+    uint32_t seq = victim->seq.load(std::memory_order_relaxed);
+    if( (seq & 1) != 0 ||
+        !victim->seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire) ) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    bool evicting = victim->used != 0;
+    memcpy(victim->id, id, SHARED_CACHE_IDBYTES);
+    memcpy(shared_cache_value(victim), value, cache->header->value_size);
+    victim->used = 1;
+    victim->tick.store(cache->header->clock.fetch_add(1, std::memory_order_relaxed) + 1,
+                       std::memory_order_relaxed);
+    victim->seq.store(seq + 2, std::memory_order_release);
+
+    cache->inserts++;
+    if( evicting ) {
+        cache->evictions++;
+    } else {
+        cache->header->size.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+Napi::Object shared_cache_stats(Napi::Env env, SharedCache* cache) {
+    Napi::Object result = Napi::Object::New(env);
+    result.Set(Napi::String::New(env, "name"), Napi::String::New(env, cache->name));
+    result.Set(Napi::String::New(env, "capacity"),
+               Napi::Number::New(env, (double) (cache->header->buckets * SHARED_CACHE_WAYS)));
+    result.Set(Napi::String::New(env, "size"),
+               Napi::Number::New(env, (double) cache->header->size.load(std::memory_order_relaxed)));
+    result.Set(Napi::String::New(env, "locked"), Napi::Boolean::New(env, cache->locked));
+    result.Set(Napi::String::New(env, "hits"), Napi::Number::New(env, (double) cache->hits.load()));
+    result.Set(Napi::String::New(env, "misses"), Napi::Number::New(env, (double) cache->misses.load()));
+    result.Set(Napi::String::New(env, "inserts"), Napi::Number::New(env, (double) cache->inserts.load()));
+    result.Set(Napi::String::New(env, "evictions"), Napi::Number::New(env, (double) cache->evictions.load()));
+    return result;
+}
+
+// See sodium_memory_usage
+size_t sodium_shared_cache_memory() {
+    return shared_cache_bytes.load();
+}
+
+/**
+ * sodium_shared_cache_unlink:
+ * Remove the name of a shared memory cache segment
+ *
+ *     sodium.sodium_shared_cache_unlink(name);
+ *
+ * ~ name (String): the name given to `crypto_box_cache_share` or
+ *   `crypto_sign_verifykey_cache_share`
+ *
+ * Processes that mapped the segment keep using it; it is freed once the last
+ * one unmaps it, and the next process to share the name creates a new one.
+ * The primary of a cluster should call it on exit, or the segment, and the
+ * box shared keys in it, stay in memory until the next reboot.
+ *
+ * **Returns**:
+ *
+ * ~ boolean: false if there was no such segment
+ */
+NAPI_METHOD(sodium_shared_cache_unlink) {
+    Napi::Env env = info.Env();
+
+    ARGS(1, "argument name must be a string");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument name must be a string");
+    }
+
+#if !defined(_WIN32)
+    std::string path = "/node-sodium-" + info[0].As<Napi::String>().Utf8Value();
+    return Napi::Boolean::New(env, shm_unlink(path.c_str()) == 0);
+#else
+    return Napi::Boolean::New(env, false);
+#endif
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_shared_cache(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_shared_cache_unlink);
+}
@@ -0,0 +1,415 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "node_sodium.h"
+#include "node_sodium_batch.h"
+#include "sodium_memory.h"
+#include "sodium_snapshot.h"
+
+/**
+ * Encrypted snapshots
+ *
+ * A process that derives thousands of keys from a master secret before it
+ * serves traffic pays for it on every restart. A snapshot keeps the result:
+ * the keys of an AeadKeyring, the box shared key cache or a set of named
+ * secrets, written to one file and loaded back in a single pass.
+ *
+ * The file is a fixed header and one body sealed with
+ * `crypto_aead_xchacha20poly1305_ietf`, the header as additional data:
+ *
+ *     header = magic | version | kind (32) | prefix size | record size |
+ *              count (8) | created (8) | nonce (24)
+ *     body   = prefix | count records of record size | tag (16)
+ *
+ * Numbers are in host byte order, the file is meant for restarts on the
+ * same host; a file from another byte order fails on its magic. Loading
+ * maps the file read only and opens the body straight from the mapping
+ * into secret memory, so the keys are never in a Buffer or a heap copy, and
+ * checks every size against the header before it reads anything. A file
+ * that was changed, truncated or sealed under another key fails as a whole.
+ *
+ * Files are written next to their path and renamed over it, so a crash
+ * while saving leaves the previous snapshot in place.
+ */
+#define SNAPSHOT_MAGIC 0x534b534e   // "NSKS"
+#define SNAPSHOT_VERSION 1
+
+// Larger files, records or prefixes are refused before they are mapped
+#define SNAPSHOT_MAX_SIZE ((uint64_t) 1 << 30)
+#define SNAPSHOT_MAX_RECORD (64 * 1024)
+
+struct SnapshotHeader {
+    uint32_t magic;
+    uint32_t version;
+    char kind[SNAPSHOT_KINDBYTES];
+    uint32_t prefix_size;
+    uint32_t record_size;
+    uint64_t count;
+    uint64_t created;
+    unsigned char nonce[crypto_aead_xchacha20poly1305_ietf_NPUBBYTES];
+};
+
+#define SNAPSHOT_ABYTES crypto_aead_xchacha20poly1305_ietf_ABYTES
+
+// Body bytes of `count` records, or 0 past SNAPSHOT_MAX_SIZE
+static uint64_t snapshot_body_size(size_t prefix_size, size_t record_size, uint64_t count) {
+    if( record_size > SNAPSHOT_MAX_RECORD || prefix_size > SNAPSHOT_MAX_RECORD ||
+        (record_size != 0 && count > SNAPSHOT_MAX_SIZE / record_size) ) {
+        return 0;
+    }
+    uint64_t size = prefix_size + count * record_size;
+    return size + sizeof(SnapshotHeader) + SNAPSHOT_ABYTES <= SNAPSHOT_MAX_SIZE ? size : 0;
+}
+
+static std::string snapshot_write_file(const std::string& path, const std::vector<unsigned char>& data) {
+    std::string temp = path + ".tmp";
+#if !defined(_WIN32)
+    // Only the owner reads a snapshot, even sealed
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if( fd == -1 ) {
+        return "cannot open " + temp + ": " + strerror(errno);
+    }
+    size_t done = 0;
+    while( done < data.size() ) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if( n < 0 && errno == EINTR ) {
+            continue;
+        }
+        if( n <= 0 ) {
+            std::string error = "cannot write " + temp + ": " + strerror(errno);
+            close(fd);
+            unlink(temp.c_str());
+            return error;
+        }
+        done += (size_t) n;
+    }
+    if( fsync(fd) != 0 || close(fd) != 0 ) {
+        std::string error = "cannot write " + temp + ": " + strerror(errno);
+        unlink(temp.c_str());
+        return error;
+    }
+#else
+    FILE* file = fopen(temp.c_str(), "wb");
+    if( file == NULL ) {
+        return "cannot open " + temp + ": " + strerror(errno);
+    }
+    bool written = fwrite(data.data(), 1, data.size(), file) == data.size();
+    if( fclose(file) != 0 || !written ) {
+        remove(temp.c_str());
+        return "cannot write " + temp;
+    }
+    remove(path.c_str());
+#endif
+    if( rename(temp.c_str(), path.c_str()) != 0 ) {
+        std::string error = "cannot rename " + temp + " to " + path + ": " + strerror(errno);
+        remove(temp.c_str());
+        return error;
+    }
+    return "";
+}
+
+std::string sodium_snapshot_save(const std::string& path, const char* kind, const unsigned char* body,
+                                 size_t prefix_size, size_t record_size, uint64_t count,
+                                 const unsigned char* key) {
+    uint64_t body_size = snapshot_body_size(prefix_size, record_size, count);
+    if( body_size == 0 && prefix_size + count * record_size != 0 ) {
+        return "the snapshot would be over 1GB";
+    }
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof header);
+    header.magic = SNAPSHOT_MAGIC;
+    header.version = SNAPSHOT_VERSION;
+    strncpy(header.kind, kind, SNAPSHOT_KINDBYTES - 1);
+    header.prefix_size = (uint32_t) prefix_size;
+    header.record_size = (uint32_t) record_size;
+    header.count = count;
+    header.created = (uint64_t) std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    randombytes_buf(header.nonce, sizeof header.nonce);
+
+    std::vector<unsigned char> data(sizeof header + (size_t) body_size + SNAPSHOT_ABYTES);
+    memcpy(data.data(), &header, sizeof header);
+    crypto_aead_xchacha20poly1305_ietf_encrypt(data.data() + sizeof header, NULL, body, body_size,
+                                               data.data(), sizeof header, NULL, header.nonce, key);
+    return snapshot_write_file(path, data);
+}
+
+// Open the body of the `size` byte file at `data`
+static std::string snapshot_open(napi_env env, const unsigned char* data, size_t size, const char* kind,
+                                 size_t prefix_size, const unsigned char* key, SodiumSnapshot& snapshot) {
+    SnapshotHeader header;
+    if( size < sizeof header + SNAPSHOT_ABYTES ) {
+        return "not a node-sodium snapshot";
+    }
+    memcpy(&header, data, sizeof header);
+    if( header.magic != SNAPSHOT_MAGIC ) {
+        return "not a node-sodium snapshot";
+    }
+    if( header.version != SNAPSHOT_VERSION ) {
+        return "a snapshot of version " + std::to_string(header.version) + ", this build reads version " +
+               std::to_string(SNAPSHOT_VERSION);
+    }
+    char expected[SNAPSHOT_KINDBYTES] = { 0 };
+    strncpy(expected, kind, SNAPSHOT_KINDBYTES - 1);
+    if( memcmp(header.kind, expected, SNAPSHOT_KINDBYTES) != 0 ) {
+        header.kind[SNAPSHOT_KINDBYTES - 1] = 0;
+        return std::string("a snapshot of ") + header.kind + ", not of " + kind;
+    }
+    uint64_t body_size = snapshot_body_size(header.prefix_size, header.record_size, header.count);
+    if( header.prefix_size != prefix_size ||
+        (body_size == 0 && header.prefix_size + header.count * header.record_size != 0) ||
+        size != sizeof header + body_size + SNAPSHOT_ABYTES ) {
+        return "the snapshot is truncated or its layout is invalid";
+    }
+
+    unsigned char* body = NULL;
+    if( body_size > 0 ) {
+        body = (unsigned char*) sodium_secret_alloc(env, (size_t) body_size);
+        if( body == NULL ) {
+            return "cannot allocate secure memory for the snapshot";
+        }
+    }
+    if( crypto_aead_xchacha20poly1305_ietf_decrypt(body, NULL, NULL, data + sizeof header,
+                                                   body_size + SNAPSHOT_ABYTES, data, sizeof header,
+                                                   header.nonce, key) != 0 ) {
+        if( body != NULL ) {
+            sodium_secret_free(env, body, (size_t) body_size);
+        }
+        return "the snapshot does not verify with this key";
+    }
+
+    snapshot.body = body;
+    snapshot.size = (size_t) body_size;
+    snapshot.prefix_size = header.prefix_size;
+    snapshot.record_size = header.record_size;
+    snapshot.count = header.count;
+    snapshot.created = (double) header.created;
+    return "";
+}
+
+std::string sodium_snapshot_load(napi_env env, const std::string& path, const char* kind,
+                                 size_t prefix_size, const unsigned char* key, SodiumSnapshot& snapshot) {
+    memset(&snapshot, 0, sizeof snapshot);
+#if !defined(_WIN32)
+    int fd = open(path.c_str(), O_RDONLY);
+    if( fd == -1 ) {
+        return "cannot open " + path + ": " + strerror(errno);
+    }
+    struct stat st;
+    if( fstat(fd, &st) != 0 ) {
+        std::string error = "cannot read " + path + ": " + strerror(errno);
+        close(fd);
+        return error;
+    }
+    if( st.st_size <= 0 || (uint64_t) st.st_size > SNAPSHOT_MAX_SIZE ) {
+        close(fd);
+        return path + " is not a node-sodium snapshot";
+    }
+    size_t size = (size_t) st.st_size;
+    void* map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if( map == MAP_FAILED ) {
+        return "cannot map " + path + ": " + strerror(errno);
+    }
+    std::string error = snapshot_open(env, (const unsigned char*) map, size, kind, prefix_size, key, snapshot);
+    munmap(map, size);
+#else
+    FILE* file = fopen(path.c_str(), "rb");
+    if( file == NULL ) {
+        return "cannot open " + path + ": " + strerror(errno);
+    }
+    std::vector<unsigned char> data;
+    unsigned char block[64 * 1024];
+    size_t n;
+    while( (n = fread(block, 1, sizeof block, file)) > 0 && data.size() <= SNAPSHOT_MAX_SIZE ) {
+        data.insert(data.end(), block, block + n);
+    }
+    fclose(file);
+    std::string error = snapshot_open(env, data.data(), data.size(), kind, prefix_size, key, snapshot);
+#endif
+    return error.empty() || error.compare(0, 7, "cannot ") == 0 ? error : path + ": " + error;
+}
+
+void sodium_snapshot_release(napi_env env, SodiumSnapshot& snapshot) {
+    if( snapshot.body != NULL ) {
+        sodium_secret_free(env, snapshot.body, snapshot.size);
+        snapshot.body = NULL;
+    }
+}
+
+/**
+ * Named secrets
+ *
+ * Each record is a name of up to 63 bytes, zero padded, the secret's length
+ * and the secret, zero padded to the longest one.
+ */
+#define SNAPSHOT_NAMEBYTES 64
+#define SNAPSHOT_SECRETS_KIND "secrets"
+
+static uint32_t snapshot_get32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof v);
+    return v;
+}
+
+/**
+ * sodium_snapshot_save:
+ * Seal named secrets, such as derived subkeys, into a snapshot file
+ *
+ *     sodium.sodium_snapshot_save(path, key, secrets);
+ *
+ * ~ path (String): file to write, replaced as a whole
+ * ~ key (Buffer): `crypto_aead_xchacha20poly1305_ietf_KEYBYTES` long
+ * ~ secrets (Object): Buffers by name. Names are up to 63 bytes and
+ *   secrets up to 64KB
+ *
+ * **Returns**:
+ *
+ * ~ the number of secrets written. Throws when the file cannot be written
+ */
+NAPI_METHOD(sodium_snapshot_save) {
+    Napi::Env env = info.Env();
+
+    ARGS(3, "arguments path, key and secrets are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument path must be a string");
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    _arg++;
+    ARG_TO_UCHAR_BUFFER_LEN(key, SNAPSHOT_KEYBYTES);
+    if( !info[2].IsObject() || info[2].IsArray() || info[2].IsBuffer() ) {
+        THROW_ERROR("argument secrets must be an object of buffers by name");
+    }
+    Napi::Object secrets = info[2].As<Napi::Object>();
+    Napi::Array names = secrets.GetPropertyNames();
+
+    size_t longest = 0;
+    std::vector<std::string> keys(names.Length());
+    std::vector<SodiumSpan> values(names.Length());
+    for(uint32_t i = 0; i < names.Length(); i++) {
+        keys[i] = names.Get(i).ToString().Utf8Value();
+        unsigned char* data = NULL;
+        size_t size = 0;
+        if( !sodium_arg_bytes(secrets.Get(keys[i]), data, size) ) {
+            THROW_ERROR("secret " + keys[i] + " must be a buffer");
+        }
+        if( keys[i].size() >= SNAPSHOT_NAMEBYTES ) {
+            THROW_ERROR("secret name " + keys[i] + " is over 63 bytes");
+        }
+        if( size > SNAPSHOT_MAX_RECORD - SNAPSHOT_NAMEBYTES - 4 ) {
+            THROW_ERROR("secret " + keys[i] + " is over 64KB");
+        }
+        values[i] = SodiumSpan { data, size };
+        longest = size > longest ? size : longest;
+    }
+
+    size_t record_size = SNAPSHOT_NAMEBYTES + 4 + longest;
+    size_t body_size = record_size * keys.size();
+    unsigned char* body = NULL;
+    if( body_size > 0 ) {
+        body = (unsigned char*) sodium_secret_alloc(env, body_size);
+        if( body == NULL ) {
+            THROW_ERROR("cannot allocate secure memory for the snapshot");
+        }
+        memset(body, 0, body_size);
+    }
+    for(size_t i = 0; i < keys.size(); i++) {
+        unsigned char* record = body + i * record_size;
+        uint32_t size = (uint32_t) values[i].size;
+        memcpy(record, keys[i].data(), keys[i].size());
+        memcpy(record + SNAPSHOT_NAMEBYTES, &size, sizeof size);
+        memcpy(record + SNAPSHOT_NAMEBYTES + 4, values[i].data, values[i].size);
+    }
+
+    std::string error = sodium_snapshot_save(path, SNAPSHOT_SECRETS_KIND, body, 0, record_size, keys.size(), key);
+    if( body != NULL ) {
+        sodium_secret_free(env, body, body_size);
+    }
+    if( !error.empty() ) {
+        THROW_ERROR(error);
+    }
+    return Napi::Number::New(env, (double) keys.size());
+}
+
+/**
+ * sodium_snapshot_load:
+ * Open a snapshot of named secrets
+ *
+ *     var secrets = sodium.sodium_snapshot_load(path, key);
+ *
+ * **Returns**:
+ *
+ * ~ an object of `sodium_malloc` Buffers by name. Throws when the file
+ *   cannot be read, is not a snapshot of secrets or does not verify
+ */
+NAPI_METHOD(sodium_snapshot_load) {
+    Napi::Env env = info.Env();
+
+    ARGS(2, "arguments path and key are required");
+    if( !info[0].IsString() ) {
+        THROW_ERROR("argument path must be a string");
+    }
+    std::string path = info[0].As<Napi::String>().Utf8Value();
+    _arg++;
+    ARG_TO_UCHAR_BUFFER_LEN(key, SNAPSHOT_KEYBYTES);
+
+    SodiumSnapshot snapshot;
+    std::string error = sodium_snapshot_load(env, path, SNAPSHOT_SECRETS_KIND, 0, key, snapshot);
+    if( !error.empty() ) {
+        THROW_ERROR(error);
+    }
+    if( snapshot.count > 0 && snapshot.record_size < SNAPSHOT_NAMEBYTES + 4 ) {
+        sodium_snapshot_release(env, snapshot);
+        THROW_ERROR(path + ": the snapshot layout is invalid");
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    for(uint64_t i = 0; i < snapshot.count; i++) {
+        const unsigned char* record = snapshot.body + i * snapshot.record_size;
+        uint32_t size = snapshot_get32(record + SNAPSHOT_NAMEBYTES);
+        if( size > snapshot.record_size - SNAPSHOT_NAMEBYTES - 4 || record[SNAPSHOT_NAMEBYTES - 1] != 0 ) {
+            sodium_snapshot_release(env, snapshot);
+            THROW_ERROR(path + ": the snapshot layout is invalid");
+        }
+        unsigned char* data;
+        Napi::Value value = sodium_secure_buffer(env, size > 0 ? size : 1, data);
+        if( data == NULL ) {
+            sodium_snapshot_release(env, snapshot);
+            return NAPI_NULL;
+        }
+        memcpy(data, record + SNAPSHOT_NAMEBYTES + 4, size);
+        if( size == 0 ) {
+            value = Napi::Buffer<unsigned char>::New(env, 0);
+        }
+        result.Set(std::string((const char*) record), value);
+    }
+    sodium_snapshot_release(env, snapshot);
+    return result;
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_snapshot(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_snapshot_save);
+    EXPORT(sodium_snapshot_load);
+}
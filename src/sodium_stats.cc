@@ -0,0 +1,156 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <mutex>
+#include <vector>
+
+#include "node_sodium.h"
+#include "sodium_stats.h"
+
+/**
+ * Operation counters
+ *
+ * Every thread that makes a counted call, the JS threads as well as the
+ * libuv and addon pool threads, gets its own block of counters, so counting
+ * takes no lock and no shared cache line. The blocks are listed in the
+ * registry; sodium_stats() adds them up. A thread that exits folds its
+ * block into `retired` first.
+ *
+ * Reset does not touch the blocks, which other threads are writing, but
+ * records the totals at that point as the new zero.
+ */
+
+enum { STAT_CALLS, STAT_BYTES_IN, STAT_BYTES_OUT, STAT_FAILURES, STAT_FIELDS };
+
+typedef uint64_t StatTotals[SODIUM_STAT_COUNT][STAT_FIELDS];
+
+struct StatsRegistry {
+    std::mutex lock;
+    std::vector<SodiumStatCounters*> blocks;
+    StatTotals retired = {};
+    StatTotals baseline = {};
+};
+
+// Never destroyed: pool threads may still count while the process exits
+static StatsRegistry* registry = new StatsRegistry();
+
+static const char* stat_names[SODIUM_STAT_COUNT] = {
+#define SODIUM_STAT_NAME(NAME) #NAME,
+    SODIUM_STAT_LIST(SODIUM_STAT_NAME)
+#undef SODIUM_STAT_NAME
+};
+
+static void stats_add(StatTotals& totals, const SodiumStatCounters* block) {
+    for(size_t i = 0; i < SODIUM_STAT_COUNT; i++) {
+        totals[i][STAT_CALLS] += block[i].calls.load(std::memory_order_relaxed);
+        totals[i][STAT_BYTES_IN] += block[i].bytes_in.load(std::memory_order_relaxed);
+        totals[i][STAT_BYTES_OUT] += block[i].bytes_out.load(std::memory_order_relaxed);
+        totals[i][STAT_FAILURES] += block[i].failures.load(std::memory_order_relaxed);
+    }
+}
+
+// Retired plus live counters. Call with the registry locked
+static void stats_totals(StatTotals& totals) {
+    memcpy(totals, registry->retired, sizeof(StatTotals));
+    for(const SodiumStatCounters* block : registry->blocks) {
+        stats_add(totals, block);
+    }
+}
+
+class StatsThread {
+  public:
+    StatsThread() {
+        block = new SodiumStatCounters[SODIUM_STAT_COUNT];
+        for(size_t i = 0; i < SODIUM_STAT_COUNT; i++) {
+            block[i].calls.store(0, std::memory_order_relaxed);
+            block[i].bytes_in.store(0, std::memory_order_relaxed);
+            block[i].bytes_out.store(0, std::memory_order_relaxed);
+            block[i].failures.store(0, std::memory_order_relaxed);
+        }
+        std::lock_guard<std::mutex> guard(registry->lock);
+        registry->blocks.push_back(block);
+    }
+
+    ~StatsThread() {
+        std::lock_guard<std::mutex> guard(registry->lock);
+        stats_add(registry->retired, block);
+        std::vector<SodiumStatCounters*>& blocks = registry->blocks;
+        for(size_t i = 0; i < blocks.size(); i++) {
+            if( blocks[i] == block ) {
+                blocks[i] = blocks.back();
+                blocks.pop_back();
+                break;
+            }
+        }
+        delete[] block;
+    }
+
+    SodiumStatCounters* block;
+};
+
+SodiumStatCounters* sodium_stats_local() {
+    static thread_local StatsThread thread;
+    return thread.block;
+}
+
+/**
+ * sodium_stats()
+ *
+ * Counters of every primitive since the addon was loaded or
+ * sodium_stats_reset was last called, summed over all threads:
+ *
+ *     { secretbox: { calls, bytesIn, bytesOut, failures }, box: { ... }, ... }
+ *
+ * ~ calls: number of calls
+ * ~ bytesIn: message, cipher text or password bytes read
+ * ~ bytesOut: bytes written by successful calls
+ * ~ failures: calls that failed, such as forged cipher texts or signatures
+ *   that did not verify
+ */
+NAPI_METHOD(sodium_stats) {
+    Napi::Env env = info.Env();
+
+    StatTotals totals;
+    StatTotals baseline;
+    {
+        std::lock_guard<std::mutex> guard(registry->lock);
+        stats_totals(totals);
+        memcpy(baseline, registry->baseline, sizeof(StatTotals));
+    }
+
+    Napi::Object result = Napi::Object::New(env);
+    for(size_t i = 0; i < SODIUM_STAT_COUNT; i++) {
+        Napi::Object stat = Napi::Object::New(env);
+        stat.Set("calls", Napi::Number::New(env, (double) (totals[i][STAT_CALLS] - baseline[i][STAT_CALLS])));
+        stat.Set("bytesIn", Napi::Number::New(env, (double) (totals[i][STAT_BYTES_IN] - baseline[i][STAT_BYTES_IN])));
+        stat.Set("bytesOut", Napi::Number::New(env, (double) (totals[i][STAT_BYTES_OUT] - baseline[i][STAT_BYTES_OUT])));
+        stat.Set("failures", Napi::Number::New(env, (double) (totals[i][STAT_FAILURES] - baseline[i][STAT_FAILURES])));
+        result.Set(stat_names[i], stat);
+    }
+    return result;
+}
+
+/**
+ * sodium_stats_reset()
+ *
+ * Start the counters of sodium_stats from zero
+ */
+NAPI_METHOD(sodium_stats_reset) {
+    Napi::Env env = info.Env();
+
+    std::lock_guard<std::mutex> guard(registry->lock);
+    stats_totals(registry->baseline);
+    return env.Undefined();
+}
+
+/**
+ * Register function calls in node binding
+ */
+void register_sodium_stats(Napi::Env env, Napi::Object exports) {
+    EXPORT(sodium_stats);
+    EXPORT(sodium_stats_reset);
+}
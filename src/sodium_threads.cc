@@ -0,0 +1,157 @@
+/**
+ * Node Native Module for Lib Sodium
+ *
+ * @Author Pedro Paixao
+ * @email paixaop at gmail dot com
+ * @License MIT
+ */
+#include <mutex>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define SODIUM_HAVE_AFFINITY 1
+#endif
+
+#include "sodium_threads.h"
+
+#if defined(SODIUM_HAVE_AFFINITY)
+// The CPUs the process may use, captured from the JS thread before any pool
+// thread is pinned. Unpinned threads go back to it
+static cpu_set_t sodium_threads_mask;
+static std::once_flag sodium_threads_once;
+
+static const cpu_set_t& sodium_threads_default_mask() {
+    std::call_once(sodium_threads_once, [] {
+        CPU_ZERO(&sodium_threads_mask);
+        if( sched_getaffinity(0, sizeof sodium_threads_mask, &sodium_threads_mask) != 0 ) {
+            for(int i = 0; i < CPU_SETSIZE; i++) {
+                CPU_SET(i, &sodium_threads_mask);
+            }
+        }
+    });
+    return sodium_threads_mask;
+}
+#endif
+
+void sodium_thread_where(int& cpu, int& node) {
+    cpu = node = -1;
+#if defined(SODIUM_HAVE_AFFINITY) && defined(SYS_getcpu)
+    unsigned c, n;
+    if( syscall(SYS_getcpu, &c, &n, NULL) == 0 ) {
+        cpu = (int) c;
+        node = (int) n;
+    }
+#endif
+}
+
+size_t SodiumThreadSlots::Take() {
+#if defined(SODIUM_HAVE_AFFINITY)
+    sodium_threads_default_mask();
+#endif
+    for(size_t i = 0; i < slots.size(); i++) {
+        if( !slots[i].used ) {
+            slots[i] = SodiumThreadSlot();
+            slots[i].used = true;
+            return i;
+        }
+    }
+    slots.push_back(SodiumThreadSlot());
+    slots.back().used = true;
+    return slots.size() - 1;
+}
+
+void SodiumThreadSlots::Free(size_t slot) {
+    slots[slot].used = false;
+}
+
+void SodiumThreadSlots::Place(size_t slot) {
+    SodiumThreadSlot& s = slots[slot];
+    if( s.placed == generation ) {
+        return;
+    }
+    s.placed = generation;
+#if defined(SODIUM_HAVE_AFFINITY)
+    if( cpus.empty() ) {
+        if( s.pinned >= 0 ) {
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &sodium_threads_default_mask());
+        }
+        s.pinned = -1;
+        return;
+    }
+    int cpu = cpus[slot % cpus.size()];
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    s.pinned = pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0 ? cpu : -1;
+#endif
+}
+
+void SodiumThreadSlots::Record(size_t slot, double ms) {
+    SodiumThreadSlot& s = slots[slot];
+    sodium_thread_where(s.cpu, s.node);
+    s.jobs++;
+    s.busy += ms;
+}
+
+bool SodiumThreadSlots::Configure(Napi::Value value, std::string& error) {
+    std::vector<int> list;
+    if( !value.IsNull() ) {
+        if( !value.IsArray() ) {
+            error = "options.cpus must be an array of CPU numbers or null";
+            return false;
+        }
+        Napi::Array array = value.As<Napi::Array>();
+#if !defined(SODIUM_HAVE_AFFINITY)
+        if( array.Length() > 0 ) {
+            error = "pinning threads to CPUs is not supported on this platform";
+            return false;
+        }
+#else
+        const cpu_set_t& allowed = sodium_threads_default_mask();
+        for(uint32_t i = 0; i < array.Length(); i++) {
+            Napi::Value v = array.Get(i);
+            double n = v.IsNumber() ? v.As<Napi::Number>().DoubleValue() : -1;
+            if( !(n >= 0 && n < CPU_SETSIZE && n == (double) (int) n) || !CPU_ISSET((int) n, &allowed) ) {
+                error = "options.cpus must only list CPUs this process may run on";
+                return false;
+            }
+            list.push_back((int) n);
+        }
+#endif
+    }
+    cpus = list;
+    generation++;
+    return true;
+}
+
+Napi::Value SodiumThreadSlots::Stats(Napi::Env env) {
+    Napi::Array result = Napi::Array::New(env);
+    uint32_t n = 0;
+    for(const SodiumThreadSlot& s : slots) {
+        if( !s.used ) {
+            continue;
+        }
+        Napi::Object o = Napi::Object::New(env);
+        o.Set(Napi::String::New(env, "pinned"), Napi::Number::New(env, s.pinned));
+        o.Set(Napi::String::New(env, "cpu"), Napi::Number::New(env, s.cpu));
+        o.Set(Napi::String::New(env, "node"), Napi::Number::New(env, s.node));
+        o.Set(Napi::String::New(env, "jobs"), Napi::Number::New(env, s.jobs));
+        o.Set(Napi::String::New(env, "busy"), Napi::Number::New(env, s.busy));
+        result.Set(n++, o);
+    }
+    return result;
+}
+
+Napi::Value SodiumThreadSlots::Cpus(Napi::Env env) {
+    if( cpus.empty() ) {
+        return env.Null();
+    }
+    Napi::Array result = Napi::Array::New(env, cpus.size());
+    for(size_t i = 0; i < cpus.size(); i++) {
+        result.Set((uint32_t) i, Napi::Number::New(env, cpus[i]));
+    }
+    return result;
+}
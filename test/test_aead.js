@@ -0,0 +1,93 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var Aead = require('../lib/aead');
+
+describe("Aead", function () {
+    var key = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+    var message = Buffer.from("This is a test");
+    var ad = Buffer.from("header");
+
+    it("should pick the best algorithm for this host", function (done) {
+        var aead = new Aead(key);
+        var expected = sodium.crypto_aead_aes256gcm_is_available() ? 'aes256gcm' : 'xchacha20poly1305_ietf';
+        assert.equal(aead.primitive(), expected);
+        assert.equal(Aead.best(), expected);
+        done();
+    });
+
+    it("should encrypt and decrypt", function (done) {
+        var aead = new Aead(key);
+        var box = aead.encrypt(message, ad);
+        assert.equal(box.length, aead.boxBytes(message.length));
+        assert(aead.decrypt(box, ad).equals(message));
+        assert.equal(aead.decrypt(box, ad, 'utf8'), "This is a test");
+
+        assert.strictEqual(aead.decrypt(box, Buffer.from("other")), undefined);
+        box[box.length - 1] ^= 1;
+        assert.strictEqual(aead.decrypt(box, ad), undefined);
+        done();
+    });
+
+    it("should open boxes sealed with another algorithm", function (done) {
+        var chacha = new Aead(key, { algorithm: 'xchacha20poly1305_ietf' });
+        var box = chacha.encrypt(message);
+        assert.equal(box[0], 2);
+        assert(new Aead(key).decrypt(box).equals(message));
+
+        if( sodium.crypto_aead_aes256gcm_is_available() ) {
+            var gcm = new Aead(key, { algorithm: 'aes256gcm' });
+            box = gcm.encrypt(message);
+            assert.equal(box[0], 1);
+            assert(chacha.decrypt(box).equals(message));
+        }
+        done();
+    });
+
+    it("should encrypt and decrypt batches", function (done) {
+        var aead = new Aead(key);
+        var messages = [message, Buffer.from("second"), Buffer.alloc(0)];
+        var boxes = aead.encryptBatch(messages, ad);
+        assert.equal(boxes.length, 3);
+
+        var chacha = new Aead(key, { algorithm: 'xchacha20poly1305_ietf' });
+        boxes.push(chacha.encrypt(message, ad));
+
+        var opened = aead.decryptBatch(boxes, ad);
+        assert(opened[0].equals(message));
+        assert(opened[1].equals(messages[1]));
+        assert.equal(opened[2].length, 0);
+        assert(opened[3].equals(message));
+
+        boxes[1][boxes[1].length - 1] ^= 1;
+        assert.strictEqual(aead.decryptBatch(boxes, ad), undefined);
+        done();
+    });
+
+    it("should reject bad keys, boxes and algorithms", function (done) {
+        assert.throws(function() {
+            new Aead(Buffer.alloc(3));
+        });
+        assert.throws(function() {
+            new Aead(key, { algorithm: 'rot13' });
+        });
+        var aead = new Aead(key);
+        assert.throws(function() {
+            aead.decrypt(Buffer.from([9, 1, 2]));
+        });
+        assert.throws(function() {
+            aead.decrypt(Buffer.from([2, 1, 2]));
+        });
+        done();
+    });
+
+    it("should throw after dispose", function (done) {
+        var aead = new Aead(key);
+        var box = aead.encrypt(message);
+        aead.dispose();
+        assert.throws(function() {
+            aead.decrypt(box);
+        });
+        done();
+    });
+});
@@ -0,0 +1,130 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+var Age = require('../lib/sodium').Age;
+
+function pipe(transform, data) {
+    return new Promise(function (resolve, reject) {
+        var out = [];
+        transform.on('data', function (d) { out.push(d); });
+        transform.on('end', function () { resolve(Buffer.concat(out)); });
+        transform.on('error', reject);
+        // Odd sized writes, so chunks and the header straddle them
+        for (var i = 0; i < data.length; i += 10007) {
+            transform.write(data.slice(i, i + 10007));
+        }
+        transform.end();
+    });
+}
+
+describe("Age", function () {
+    var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-age-'));
+    var file = path.join(dir, 'data.bin');
+    var enc = path.join(dir, 'data.age');
+    var dec = path.join(dir, 'data.dec');
+    var alice = Age.keygen();
+    var bob = Age.keygen();
+    var eve = Age.keygen();
+    // Several read blocks, and not a multiple of the chunk size
+    var data = Buffer.alloc(2 * 1024 * 1024 + 12345);
+    sodium.randombytes_buf(data);
+    fs.writeFileSync(file, data);
+
+    after(function () {
+        [file, enc, dec].forEach(function (f) {
+            if (fs.existsSync(f)) {
+                fs.unlinkSync(f);
+            }
+        });
+        fs.rmdirSync(dir);
+    });
+
+    it("should round trip a file to several recipients", function () {
+        return sodium.crypto_age_encrypt_file(file, enc, [alice.publicKey, bob.publicKey]).then(function (written) {
+            var head = fs.readFileSync(enc);
+            assert.equal(written, head.length);
+            assert.equal(head.toString('latin1', 0, 22), 'age-encryption.org/v1\n');
+            assert.equal(head.toString('latin1').split('-> X25519 ').length, 3);
+            return sodium.crypto_age_decrypt_file(enc, dec, [eve.secretKey, bob.secretKey]);
+        }).then(function (written) {
+            assert.equal(written, data.length);
+            assert(fs.readFileSync(dec).equals(data));
+        });
+    });
+
+    it("should read and write the same format with streams and files", function () {
+        return Age.encryptFile(file, enc, [alice.recipient]).then(function () {
+            return pipe(new Age.Decryptor(alice.identity), fs.readFileSync(enc));
+        }).then(function (plain) {
+            assert(plain.equals(data));
+            return pipe(new Age.Encryptor(bob.recipient), data);
+        }).then(function (sealed) {
+            fs.writeFileSync(enc, sealed);
+            return Age.decryptFile(enc, dec, [bob.identity]);
+        }).then(function () {
+            assert(fs.readFileSync(dec).equals(data));
+        });
+    });
+
+    it("should handle empty payloads and whole chunks", function () {
+        return Promise.all([0, 1, Age.CHUNK_SIZE, 2 * Age.CHUNK_SIZE].map(function (size) {
+            var plain = data.slice(0, size);
+            return pipe(new Age.Encryptor(alice.publicKey), plain).then(function (sealed) {
+                return pipe(new Age.Decryptor(alice.secretKey), sealed);
+            }).then(function (opened) {
+                assert(opened.equals(plain));
+            });
+        }));
+    });
+
+    it("should reject forged, truncated and foreign files and remove the output", function () {
+        function rejects(bytes, identity, pattern) {
+            fs.writeFileSync(enc, bytes);
+            return sodium.crypto_age_decrypt_file(enc, dec, [identity]).then(function () {
+                assert.fail('should not decrypt');
+            }, function (err) {
+                assert(pattern.test(err.message), err.message);
+                assert(!fs.existsSync(dec));
+            });
+        }
+        return pipe(new Age.Encryptor(alice.recipient), data.slice(0, 200000)).then(function (sealed) {
+            var forged = Buffer.from(sealed);
+            forged[forged.length - 100] ^= 1;
+            var header = Buffer.from(sealed);
+            header[50] ^= 1;
+            return Promise.all([
+                rejects(sealed, eve.secretKey, /no identity/),
+                rejects(forged, alice.secretKey, /authentication/),
+                rejects(header, alice.secretKey, /authentication|malformed|identity/),
+                rejects(sealed.slice(0, sealed.length - 20000), alice.secretKey, /truncated|authentication/),
+                rejects(Buffer.from('not an age file'), alice.secretKey, /not an age file/)
+            ]);
+        });
+    });
+
+    it("should encode keys as age does", function () {
+        var pk = Age.parseRecipient('age1ql3z7hjy54pw3hyww5ayyfg7zqgvc7w3j2elw8zmrj2kg5sfn9aqmcac8p');
+        assert.equal(pk.toString('hex'), '07e22f5e44a542e8dc8e753a42251e1010cc79d192b3f71c5b1c95645209997a');
+        assert(/^AGE-SECRET-KEY-1[0-9A-Z]+$/.test(alice.identity));
+        assert(Age.parseIdentity(alice.identity).equals(alice.secretKey));
+        assert(Age.parseRecipient(alice.recipient).equals(alice.publicKey));
+        assert.throws(function () {
+            Age.parseRecipient('age1ql3z7hjy54pw3hyww5ayyfg7zqgvc7w3j2elw8zmrj2kg5sfn9aqmcac8q');
+        });
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () { sodium.crypto_age_encrypt_file(42, enc, [alice.publicKey]); });
+        assert.throws(function () { sodium.crypto_age_encrypt_file(file, file, [alice.publicKey]); });
+        assert.throws(function () { sodium.crypto_age_encrypt_file(file, enc, []); });
+        assert.throws(function () { sodium.crypto_age_encrypt_file(file, enc, [Buffer.alloc(32)]); });
+        assert.throws(function () { new sodium.AgeStream({}); });
+        var s = new sodium.AgeStream({ recipients: [alice.publicKey] });
+        assert.throws(function () { s.seal(Buffer.alloc(10), false); });
+        assert.throws(function () { s.open(Buffer.alloc(10), true); });
+        s.dispose();
+        assert.throws(function () { s.seal(Buffer.alloc(10), true); });
+    });
+});
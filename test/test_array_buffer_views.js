@@ -0,0 +1,117 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("ArrayBuffer and TypedArray arguments", function () {
+    var key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 3);
+    var nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES, 4);
+    var message = Buffer.from("message inside a bigger frame");
+    var expected = sodium.crypto_secretbox_easy(message, nonce, key);
+
+    // The message sits at offset 5 of a larger ArrayBuffer
+    var frame = new ArrayBuffer(message.length + 10);
+    new Uint8Array(frame, 5, message.length).set(message);
+
+    it("should read Uint8Array views at their offset", function (done) {
+        var view = new Uint8Array(frame, 5, message.length);
+        assert(sodium.crypto_secretbox_easy(view, nonce, key).equals(expected));
+        assert(sodium.crypto_secretbox_easy(message, new Uint8Array(nonce), new Uint8Array(key)).equals(expected));
+        done();
+    });
+
+    it("should read DataView, ArrayBuffer and other TypedArrays", function (done) {
+        assert(sodium.crypto_secretbox_easy(new DataView(frame, 5, message.length), nonce, key).equals(expected));
+
+        var exact = new Uint8Array(message).buffer;
+        assert(sodium.crypto_secretbox_easy(exact, nonce, key).equals(expected));
+
+        var words = new Uint32Array(key.buffer.slice(key.byteOffset, key.byteOffset + key.length));
+        assert.strictEqual(words.length * 4, key.length);
+        assert(sodium.crypto_secretbox_easy(message, nonce, words).equals(expected));
+        done();
+    });
+
+    it("should write into views in place", function (done) {
+        var memory = new ArrayBuffer(64);
+        var view = new Uint8Array(memory, 16, 32);
+        sodium.randombytes_buf(view);
+        var bytes = new Uint8Array(memory);
+        assert(bytes.slice(0, 16).every(function (b) { return b === 0; }));
+        assert(bytes.slice(48).every(function (b) { return b === 0; }));
+        assert(!bytes.slice(16, 48).every(function (b) { return b === 0; }));
+        done();
+    });
+
+    it("should accept views in batch arguments and key objects", function (done) {
+        var kp = sodium.crypto_sign_ed25519_keypair();
+        var signingKey = new sodium.SigningKey(new Uint8Array(kp.secretKey));
+        var sigs = signingKey.signBatch([new Uint8Array(message), message]);
+        assert(sigs.slice(0, 64).equals(sigs.slice(64)));
+        done();
+    });
+
+    it("should still reject other values", function (done) {
+        assert.throws(function () {
+            sodium.crypto_secretbox_easy([1, 2, 3], nonce, key);
+        });
+        assert.throws(function () {
+            sodium.crypto_secretbox_easy("message", nonce, key);
+        });
+        done();
+    });
+
+    it("should hash, MAC and sign strings as UTF-8", function (done) {
+        var short = '{"id":42,"name":"caf\u00e9"}';
+        var long = new Array(5000).join('\u20ac json ');
+        var authKey = Buffer.alloc(sodium.crypto_auth_KEYBYTES, 5);
+        var keys = sodium.crypto_sign_keypair();
+
+        [short, long, ''].forEach(function (text) {
+            var bytes = Buffer.from(text);
+            assert(sodium.crypto_generichash(32, text, null).equals(sodium.crypto_generichash(32, bytes, null)));
+            assert(sodium.crypto_hash_sha256(text).equals(sodium.crypto_hash_sha256(bytes)));
+            assert(sodium.crypto_hash_sha512(text).equals(sodium.crypto_hash_sha512(bytes)));
+            var tag = sodium.crypto_auth(text, authKey);
+            assert(tag.equals(sodium.crypto_auth(bytes, authKey)));
+            assert.strictEqual(sodium.crypto_auth_verify(tag, text, authKey), 0);
+            var sig = sodium.crypto_sign_detached(text, keys.secretKey);
+            assert(sodium.crypto_sign_verify_detached(sig, bytes, keys.publicKey));
+            assert(sodium.crypto_sign_verify_detached(sig, text, keys.publicKey));
+        });
+
+        // 255 bytes and more no longer fit the stack buffer
+        var edge = new Array(256).join('a');
+        assert(sodium.crypto_hash_sha256(edge).equals(sodium.crypto_hash_sha256(Buffer.from(edge))));
+        // A multibyte character across the end of the stack buffer
+        for( var n = 248; n < 258; n++ ) {
+            var cut = 'a'.repeat(n) + '\u20ac';
+            assert(sodium.crypto_hash_sha256(cut).equals(sodium.crypto_hash_sha256(Buffer.from(cut))));
+        }
+        var hmac = new sodium.HmacKey('hmacsha256', authKey);
+        assert(hmac.verify(hmac.mac(short), Buffer.from(short)));
+        assert.throws(function () { sodium.crypto_hash_sha256(42); });
+        done();
+    });
+
+    it("should return hashes, tags and signatures encoded", function (done) {
+        var message = Buffer.from('encode me');
+        var authKey = Buffer.alloc(sodium.crypto_auth_KEYBYTES, 9);
+        var keys = sodium.crypto_sign_keypair();
+        var hmac = new sodium.HmacKey('hmacsha512', authKey);
+
+        ['hex', 'base64', 'base64url'].forEach(function (encoding) {
+            assert.strictEqual(sodium.crypto_hash(message, encoding), sodium.crypto_hash(message).toString(encoding));
+            assert.strictEqual(sodium.crypto_hash_sha256(message, encoding), sodium.crypto_hash_sha256(message).toString(encoding));
+            assert.strictEqual(sodium.crypto_generichash(17, message, null, encoding),
+                               sodium.crypto_generichash(17, message, null).toString(encoding));
+            assert.strictEqual(sodium.crypto_auth(message, authKey, encoding), sodium.crypto_auth(message, authKey).toString(encoding));
+            assert.strictEqual(sodium.crypto_sign_detached(message, keys.secretKey, encoding),
+                               sodium.crypto_sign_detached(message, keys.secretKey).toString(encoding));
+            assert.strictEqual(hmac.mac(message, encoding), hmac.mac(message).toString(encoding));
+        });
+
+        assert(Buffer.isBuffer(sodium.crypto_hash_sha512(message, undefined)));
+        assert.throws(function () { sodium.crypto_hash_sha512(message, 'utf8'); });
+        assert.throws(function () { sodium.crypto_auth(message, authKey, 1); });
+        done();
+    });
+});
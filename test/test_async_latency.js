@@ -0,0 +1,49 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var latency = require('../lib/latency');
+
+describe('sodium_async_latency', function() {
+    var message = Buffer.alloc(1024 * 1024, 0x5a);
+
+    beforeEach(function() {
+        sodium.sodium_async_latency(true);
+    });
+
+    it('should record the wait and run time of a threadpool job', function() {
+        return sodium.crypto_hash_sha256_async(message).then(function() {
+            var op = sodium.sodium_async_latency().crypto_hash_sha256;
+            assert.equal(op.wait.count, 1);
+            assert.equal(op.run.count, 1);
+            assert(op.run.min > 0);
+            assert.equal(op.run.min, op.run.max);
+            assert(op.run.percentiles['50'] <= op.run.max);
+            assert.equal(op.run.buckets.length, 1);
+            assert.equal(op.run.buckets[0][1], 1);
+        });
+    });
+
+    it('should leave out jobs run inline', function() {
+        return sodium.crypto_hash_sha256_async(Buffer.from('short')).then(function() {
+            assert.strictEqual(sodium.sodium_async_latency().crypto_hash_sha256, undefined);
+        });
+    });
+
+    it('should clear the histograms on reset', function() {
+        return sodium.crypto_hash_sha512_async(message).then(function() {
+            assert.equal(sodium.sodium_async_latency(true).crypto_hash_sha512.run.count, 1);
+            assert.deepEqual(sodium.sodium_async_latency(), {});
+        });
+    });
+
+    it('should render Prometheus histograms', function() {
+        return sodium.crypto_hash_sha256_async(message).then(function() {
+            var text = latency.prometheus({ prefix: 'test', buckets: [1e-9, 1000] });
+            assert(/# TYPE test_run_seconds histogram/.test(text));
+            assert(/test_run_seconds_bucket\{op="crypto_hash_sha256",le="1e-9"\} 0/.test(text));
+            assert(/test_run_seconds_bucket\{op="crypto_hash_sha256",le="1000"\} 1/.test(text));
+            assert(/test_wait_seconds_count\{op="crypto_hash_sha256"\} 1/.test(text));
+        });
+    });
+});
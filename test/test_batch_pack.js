@@ -0,0 +1,96 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var BatchPack = require('../lib/batch-pack');
+
+var random = function (n) {
+    var b = Buffer.alloc(n);
+    sodium.randombytes_buf(b);
+    return b;
+};
+
+describe("Packed batches", function () {
+    var keys = sodium.crypto_sign_ed25519_keypair();
+    var messages = [], signatures = [], publicKeys = [];
+    for (var i = 0; i < 50; i++) {
+        messages.push(random(i * 7));
+        signatures.push(sodium.crypto_sign_ed25519_detached(messages[i], keys.secretKey));
+        publicKeys.push(keys.publicKey);
+    }
+
+    it("should pack elements back to back", function () {
+        var pack = new BatchPack(4, 1);
+        messages.forEach(function (m) {
+            pack.push(m);
+        });
+        var batch = pack.toBatch();
+        assert.equal(batch.lengths.length, messages.length);
+        messages.forEach(function (m, i) {
+            assert(batch.data.subarray(batch.offsets[i], batch.offsets[i] + batch.lengths[i]).equals(m));
+        });
+        pack.reset();
+        assert.equal(pack.toBatch().lengths.length, 0);
+    });
+
+    it("should take the place of an Array of Buffers", function () {
+        var expected = sodium.crypto_sign_ed25519_verify_detached_batch(signatures, messages, publicKeys);
+        var packed = sodium.crypto_sign_ed25519_verify_detached_batch(
+            BatchPack.from(signatures).toBatch(), BatchPack.from(messages).toBatch(), BatchPack.from(publicKeys).toBatch());
+        assert.deepEqual(packed, expected);
+    });
+
+    it("should read offsets out of order and null elements", function () {
+        var algo = 'chacha20poly1305_ietf';
+        var prefix = 'crypto_aead_' + algo;
+        var key = random(sodium[prefix + '_KEYBYTES']);
+        var nonce = random(sodium[prefix + '_NPUBBYTES']);
+        var m = [Buffer.from('first'), Buffer.from('second')];
+        var ad = Buffer.from('ad');
+        var c = [sodium[prefix + '_encrypt'](m[0], null, nonce, key),
+                 sodium[prefix + '_encrypt'](m[1], ad, nonce, key)];
+
+        var data = Buffer.concat([c[1], c[0]]);
+        var batch = {
+            data: data,
+            offsets: new Uint32Array([c[1].length, 0]),
+            lengths: new Uint32Array([c[0].length, c[1].length])
+        };
+        var ads = new BatchPack();
+        ads.pushNull();
+        ads.push(ad);
+
+        var out = sodium[prefix + '_decrypt_batch'](batch, ads.toBatch(), [nonce, nonce], key);
+        assert(out.equals(Buffer.concat(m)));
+    });
+
+    it("should check the layout", function () {
+        var batch = BatchPack.from(messages).toBatch();
+        assert.throws(function () {
+            sodium.crypto_sign_ed25519_verify_detached_batch(signatures, {
+                data: batch.data, lengths: Array.from(batch.lengths)
+            }, publicKeys);
+        }, /packed batch/);
+        assert.throws(function () {
+            sodium.crypto_sign_ed25519_verify_detached_batch(signatures, {
+                data: batch.data.subarray(1), offsets: batch.offsets, lengths: batch.lengths
+            }, publicKeys);
+        }, /out of its data/);
+        assert.throws(function () {
+            sodium.crypto_sign_ed25519_verify_detached_batch(BatchPack.from(messages).toBatch(), messages, publicKeys);
+        }, /must be 64 bytes/);
+        var nulls = new BatchPack();
+        messages.forEach(function () {
+            nulls.pushNull();
+        });
+        assert.throws(function () {
+            sodium.crypto_sign_ed25519_verify_detached_batch(signatures, nulls.toBatch(), publicKeys);
+        }, /must be a buffer/);
+    });
+
+    it("should feed the length table bindings", function () {
+        var batch = BatchPack.from(messages).toBatch();
+        var hashes = sodium.crypto_generichash_many(32, batch.data, batch.lengths);
+        messages.forEach(function (m, i) {
+            assert(hashes.subarray(i * 32, (i + 1) * 32).equals(sodium.crypto_generichash(32, m, null)));
+        });
+    });
+});
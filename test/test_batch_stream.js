@@ -0,0 +1,130 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var batchStream = require('../lib/batch-stream');
+
+var random = function (n) {
+    var b = Buffer.alloc(n);
+    sodium.randombytes_buf(b);
+    return b;
+};
+
+describe("Streamed batches", function () {
+    var N = 100;
+    var keys = sodium.crypto_sign_ed25519_keypair();
+    var messages = [], signatures = [], publicKeys = [];
+    for (var i = 0; i < N; i++) {
+        messages.push(random(i + 1));
+        signatures.push(sodium.crypto_sign_ed25519_detached(messages[i], keys.secretKey));
+        publicKeys.push(keys.publicKey);
+    }
+    signatures[42] = Buffer.from(signatures[42]);
+    signatures[42][0] ^= 1;
+
+    it("should verify signatures by chunks", function () {
+        var seen = [];
+        return sodium.crypto_sign_ed25519_verify_detached_batch_stream(signatures, messages, publicKeys, {
+            chunkSize: 16,
+            threads: 2,
+            onChunk: function (start, valid) {
+                assert.equal(start, seen.length);
+                assert(valid.length <= 16);
+                seen = seen.concat(valid);
+            }
+        }).then(function (failed) {
+            assert.equal(failed, 1);
+            assert.equal(seen.length, N);
+            seen.forEach(function (v, i) {
+                assert.strictEqual(v, i !== 42);
+            });
+        });
+    });
+
+    it("should open messages by chunks", function (done) {
+        var algo = 'chacha20poly1305_ietf';
+        var prefix = 'crypto_aead_' + algo;
+        var plain = [], cipher = [], nonces = [], aeadKeys = [];
+        for (var i = 0; i < 10; i++) {
+            plain.push(random(i * 3));
+            nonces.push(random(sodium[prefix + '_NPUBBYTES']));
+            aeadKeys.push(random(sodium[prefix + '_KEYBYTES']));
+            cipher.push(sodium[prefix + '_encrypt'](plain[i], null, nonces[i], aeadKeys[i]));
+        }
+        cipher[3][0] ^= 1;
+
+        var seen = [];
+        sodium[prefix + '_decrypt_each_stream'](cipher, null, nonces, aeadKeys, {
+            chunkSize: 4,
+            onChunk: function (start, results) {
+                assert.equal(start, seen.length);
+                seen = seen.concat(results);
+            }
+        }, function (err, failed) {
+            assert.ifError(err);
+            assert.equal(failed, 1);
+            seen.forEach(function (m, i) {
+                if (i === 3) {
+                    assert.strictEqual(m, null);
+                } else {
+                    assert(m.equals(plain[i]));
+                }
+            });
+            done();
+        });
+    });
+
+    it("should hash chunks by chunks", function () {
+        var data = random(10000);
+        var hashes = [];
+        return sodium.crypto_generichash_many_stream(32, data, 1000, null, {
+            chunkSize: 3,
+            onChunk: function (start, results) {
+                hashes = hashes.concat(results);
+            }
+        }).then(function () {
+            assert.equal(hashes.length, 10);
+            hashes.forEach(function (h, i) {
+                assert(h.equals(sodium.crypto_generichash(32, data.subarray(i * 1000, (i + 1) * 1000), null)));
+            });
+        });
+    });
+
+    it("should require onChunk", function () {
+        assert.throws(function () {
+            sodium.crypto_sign_ed25519_verify_detached_batch_stream(signatures, messages, publicKeys, {});
+        }, /onChunk/);
+        assert.throws(function () {
+            sodium.crypto_sign_ed25519_verify_detached_batch_stream(signatures, messages, publicKeys, {
+                onChunk: function () {},
+                chunkSize: 0
+            });
+        }, /chunkSize/);
+    });
+
+    it("should iterate over chunks", async function () {
+        var count = 0;
+        var chunks = batchStream('crypto_sign_ed25519_verify_detached_batch_stream',
+                                 [signatures, messages, publicKeys], { chunkSize: 10 });
+        for await (var chunk of chunks) {
+            assert.equal(chunk.start, count);
+            count += chunk.results.length;
+        }
+        assert.equal(count, N);
+    });
+
+    it("should cancel the job when the loop is left", async function () {
+        var chunks = batchStream('crypto_sign_ed25519_verify_detached_batch_stream',
+                                 [signatures, messages, publicKeys], { chunkSize: 1 });
+        var count = 0;
+        for await (var chunk of chunks) {
+            count++;
+            if (count === 2) {
+                break;
+            }
+        }
+        assert.equal(count, 2);
+        assert.deepEqual(await chunks.next(), { value: undefined, done: true });
+        assert.throws(function () {
+            batchStream('crypto_sign_ed25519_verify_detached_batch_async', []);
+        }, TypeError);
+    });
+});
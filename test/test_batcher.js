@@ -0,0 +1,73 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../lib/sodium');
+var binding = require('../build/Release/sodium');
+
+describe("Batcher", function () {
+    it("should verify the signatures of one tick in one job", function () {
+        var batcher = new sodium.Batcher({ maxBatch: 8 });
+        var keys = binding.crypto_sign_keypair();
+        var calls = [];
+        for (var i = 0; i < 20; i++) {
+            var m = Buffer.from("message " + i);
+            var sig = binding.crypto_sign_detached(m, keys.secretKey);
+            if (i % 3 === 0) {
+                sig = Buffer.from(sig);
+                sig[0] ^= 1;
+            }
+            calls.push(batcher.verifyDetached(sig, m, keys.publicKey));
+        }
+        return Promise.all(calls).then(function (valid) {
+            valid.forEach(function (ok, i) {
+                assert.strictEqual(ok, i % 3 !== 0);
+            });
+            assert.strictEqual(batcher.stats.calls, 20);
+            assert.strictEqual(batcher.stats.batches, 3);
+        });
+    });
+
+    it("should open messages under different keys", function () {
+        var batcher = new sodium.Batcher();
+        var algo = 'xchacha20poly1305_ietf';
+        var nonce = Buffer.alloc(binding.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, 5);
+        var calls = [];
+        for (var i = 0; i < 10; i++) {
+            var key = Buffer.alloc(binding.crypto_aead_xchacha20poly1305_ietf_KEYBYTES, i);
+            var ad = i % 2 ? Buffer.from("ad") : null;
+            var c = binding.crypto_aead_xchacha20poly1305_ietf_encrypt(Buffer.from("m" + i), ad, nonce, key);
+            if (i === 4) {
+                c[0] ^= 1;
+            }
+            calls.push(batcher.decrypt(algo, c, ad, nonce, key));
+        }
+        return Promise.all(calls).then(function (messages) {
+            messages.forEach(function (m, i) {
+                if (i === 4) {
+                    assert.strictEqual(m, null);
+                } else {
+                    assert.strictEqual(m.toString(), "m" + i);
+                }
+            });
+            assert.strictEqual(batcher.stats.batches, 1);
+        });
+    });
+
+    it("should reject bad calls on their own", function () {
+        var batcher = new sodium.Batcher();
+        var keys = binding.crypto_sign_keypair();
+        var m = Buffer.from("ok");
+        var good = batcher.verifyDetached(binding.crypto_sign_detached(m, keys.secretKey), m, keys.publicKey);
+        var bad = batcher.verifyDetached(Buffer.alloc(3), m, keys.publicKey);
+        var unknown = batcher.decrypt('rot13', Buffer.alloc(32), null, Buffer.alloc(12), Buffer.alloc(32));
+        return Promise.all([
+            good,
+            bad.then(function () { throw new Error('resolved'); }, function (err) { return err; }),
+            unknown.then(function () { throw new Error('resolved'); }, function (err) { return err; })
+        ]).then(function (results) {
+            assert.strictEqual(results[0], true);
+            assert(results[1] instanceof TypeError);
+            assert(results[2] instanceof TypeError);
+        });
+    });
+});
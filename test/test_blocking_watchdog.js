@@ -0,0 +1,53 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../lib/sodium');
+
+describe('BlockingWatchdog', function() {
+    var message = Buffer.alloc(1024 * 1024, 7);
+
+    it('should report synchronous calls over the threshold', function(done) {
+        var reports = [];
+        var watchdog = new sodium.BlockingWatchdog({ thresholdMs: 0 }, function(report) {
+            reports.push(report);
+        });
+        sodium.api.crypto_hash_sha256(message);
+        watchdog.stop();
+
+        assert.equal(reports.length, 1);
+        assert.equal(reports[0].primitive, 'crypto_hash_sha256');
+        assert.equal(reports[0].size, message.length);
+        assert.equal(reports[0].asyncAlternative, 'crypto_hash_sha256_async');
+
+        var stats = watchdog.stats().crypto_hash_sha256;
+        assert.equal(stats.count, 1);
+        assert.equal(stats.maxSize, message.length);
+        done();
+    });
+
+    it('should leave out calls under the threshold and async calls', function() {
+        var watchdog = new sodium.BlockingWatchdog({ thresholdMs: 60000 });
+        sodium.api.crypto_hash_sha256(message);
+        assert.deepEqual(watchdog.stats(), {});
+        watchdog.thresholdMs = 0;
+        return sodium.api.crypto_hash_sha256_async(message).then(function() {
+            watchdog.stop();
+            assert.deepEqual(watchdog.stats(), {});
+        });
+    });
+
+    it('should stop counting once stopped', function(done) {
+        var watchdog = new sodium.BlockingWatchdog({ thresholdMs: 0 });
+        watchdog.stop();
+        sodium.api.crypto_hash_sha256(message);
+        assert.deepEqual(watchdog.stats(), {});
+        done();
+    });
+
+    it('should reject a bad threshold', function(done) {
+        assert.throws(function() {
+            new sodium.BlockingWatchdog({ thresholdMs: -1 });
+        }, TypeError);
+        done();
+    });
+});
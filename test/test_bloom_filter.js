@@ -0,0 +1,80 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("BloomFilter", function () {
+    var key = Buffer.alloc(sodium.crypto_shorthash_KEYBYTES, 7);
+    var items = [];
+    for (var i = 0; i < 1000; i++) {
+        items.push(Buffer.from('nonce ' + i));
+    }
+
+    it("should find every item it added", function (done) {
+        var filter = new sodium.BloomFilter(key, { capacity: 1000, rate: 0.001 });
+        items.forEach(function (item) {
+            assert.strictEqual(filter.add(item), true);
+        });
+        items.forEach(function (item) {
+            assert.strictEqual(filter.has(item), true);
+            assert.strictEqual(filter.add(item), false);
+        });
+        assert.strictEqual(filter.bits % 512, 0);
+
+        var false_positives = 0;
+        for (var i = 0; i < 10000; i++) {
+            false_positives += filter.has(Buffer.from('other ' + i)) ? 1 : 0;
+        }
+        assert(false_positives < 50);
+
+        filter.clear();
+        assert.strictEqual(filter.has(items[0]), false);
+        done();
+    });
+
+    it("should add and query packed batches", function (done) {
+        var filter = new sodium.BloomFilter(key, { bits: 1 << 16 });
+        var ids = sodium.randombytes_buf(24 * 100);
+        var added = filter.addBatch(ids, 24);
+        assert.strictEqual(added.length, 13);
+        assert.strictEqual(added[0], 0xff);
+
+        var again = filter.addBatch(ids, 24, 2);
+        assert.strictEqual(again[0], 0);
+        var found = filter.hasBatch(ids, 24);
+        for (var i = 0; i < 100; i++) {
+            assert(found[i >> 3] & (1 << (i & 7)));
+            assert.strictEqual(filter.has(ids.slice(i * 24, i * 24 + 24)), true);
+        }
+
+        var mixed = filter.hasBatch([ids.slice(0, 24), Buffer.from('missing')]);
+        assert.strictEqual(mixed[0] & 1, 1);
+        done();
+    });
+
+    it("should share its storage", function (done) {
+        var sab = new SharedArrayBuffer(64 * 64);
+        var a = new sodium.BloomFilter(key, { buffer: new Uint8Array(sab) });
+        var b = new sodium.BloomFilter(key, { buffer: new Uint8Array(sab) });
+        a.add(items[1]);
+        assert.strictEqual(b.has(items[1]), true);
+        assert.strictEqual(b.bits, 64 * 512);
+
+        var other = new sodium.BloomFilter(Buffer.alloc(sodium.crypto_shorthash_KEYBYTES, 8), { buffer: new Uint8Array(sab) });
+        assert.strictEqual(other.has(items[1]), false);
+
+        var copy = new sodium.BloomFilter(key, { buffer: Uint8Array.from(a.buffer) });
+        assert.strictEqual(copy.has(items[1]), true);
+        done();
+    });
+
+    it("should reject bad arguments and disposed filters", function (done) {
+        assert.throws(function () { new sodium.BloomFilter(Buffer.alloc(8)); });
+        assert.throws(function () { new sodium.BloomFilter(key, { hashes: 17 }); });
+        assert.throws(function () { new sodium.BloomFilter(key, { buffer: Buffer.alloc(100) }); });
+        assert.throws(function () { new sodium.BloomFilter(key, { buffer: new Uint8Array(new ArrayBuffer(72), 1, 64) }); });
+        var filter = new sodium.BloomFilter(key);
+        assert.throws(function () { filter.addBatch(Buffer.alloc(10), 3); });
+        filter.dispose();
+        assert.throws(function () { filter.add(items[0]); });
+        done();
+    });
+});
@@ -0,0 +1,68 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var BoxSession = require('../lib/box-session');
+var Box = require('../lib/box');
+
+describe("BoxSession", function () {
+    var alice = sodium.crypto_box_keypair();
+    var bob = sodium.crypto_box_keypair();
+
+    it("native session should match crypto_box_easy", function (done) {
+        var session = new sodium.BoxSession(bob.publicKey, alice.secretKey);
+        var peer = new sodium.BoxSession(alice.publicKey, bob.secretKey);
+        var nonce = Buffer.alloc(sodium.crypto_box_NONCEBYTES, 1);
+        var m = Buffer.from("This is a test");
+
+        var c = session.encrypt(m, nonce);
+        assert(c.equals(sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey)));
+        assert(peer.decrypt(c, nonce).equals(m));
+
+        var d = session.encryptDetached(m, nonce);
+        assert(Buffer.concat([d.mac, d.cipherText]).equals(c));
+        assert(peer.decryptDetached(d.cipherText, d.mac, nonce).equals(m));
+
+        c[0] ^= 1;
+        assert.strictEqual(peer.decrypt(c, nonce), null);
+        done();
+    });
+
+    it("native session should throw after dispose", function (done) {
+        var session = new sodium.BoxSession(bob.publicKey, alice.secretKey);
+        session.dispose();
+        assert.throws(function() {
+            session.encrypt(Buffer.from("x"), Buffer.alloc(sodium.crypto_box_NONCEBYTES));
+        });
+        assert.throws(function() {
+            new sodium.BoxSession(Buffer.alloc(3), alice.secretKey);
+        });
+        done();
+    });
+
+    it("encrypt/decrypt and validate message", function (done) {
+        var session = new BoxSession(bob.publicKey, alice.secretKey);
+        var peer = new BoxSession(alice.publicKey, bob.secretKey);
+        session.setEncoding('utf8');
+        var cipherBox = session.encrypt("This is a test");
+        assert.ok(cipherBox.cipherText instanceof Buffer);
+        assert.ok(cipherBox.nonce instanceof Buffer);
+        assert.equal(peer.decrypt(cipherBox, 'utf8'), "This is a test");
+        done();
+    });
+
+    it("should interoperate with Box in easy mode", function (done) {
+        var session = new BoxSession(bob.publicKey, alice.secretKey);
+        var box = new Box(alice.publicKey, bob.secretKey, true);
+        var cipherBox = session.encrypt(Buffer.from("hello bob"));
+        assert.equal(box.decrypt(cipherBox, 'utf8'), "hello bob");
+        done();
+    });
+
+    it("decrypt should return undefined for forged boxes", function (done) {
+        var session = new BoxSession(bob.publicKey, alice.secretKey);
+        var cipherBox = session.encrypt(Buffer.from("This is a test"));
+        cipherBox.cipherText[3] ^= 1;
+        assert.strictEqual(session.decrypt(cipherBox), undefined);
+        done();
+    });
+});
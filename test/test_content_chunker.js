@@ -0,0 +1,113 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+
+function digest(chunks, i) {
+    return chunks.digests.slice(i * 32, i * 32 + 32);
+}
+
+describe("ContentChunker", function () {
+    var key = Buffer.alloc(32, 7);
+    var data = Buffer.alloc(1024 * 1024 + 4321);
+    sodium.randombytes_buf(data);
+
+    function chunkAll(buffer, step) {
+        var chunker = new sodium.ContentChunker(key);
+        var offsets = [], lengths = [], digests = [];
+        for (var i = 0; i <= buffer.length; i += step) {
+            var part = i < buffer.length ? chunker.push(buffer.slice(i, i + step)) : chunker.end();
+            offsets = offsets.concat(part.offsets);
+            lengths = lengths.concat(part.lengths);
+            digests.push(part.digests);
+        }
+        return { offsets: offsets, lengths: lengths, digests: Buffer.concat(digests) };
+    }
+
+    it("should cut the same chunks however the data is pushed", function (done) {
+        var whole = chunkAll(data, data.length);
+        var parts = chunkAll(data, 1000);
+        assert.deepStrictEqual(parts.offsets, whole.offsets);
+        assert.deepStrictEqual(parts.lengths, whole.lengths);
+        assert(parts.digests.equals(whole.digests));
+
+        var total = 0;
+        whole.lengths.forEach(function (length, i) {
+            assert.strictEqual(whole.offsets[i], total);
+            assert(length <= 65536);
+            if (i < whole.lengths.length - 1) {
+                assert(length > 2048);
+            }
+            total += length;
+        });
+        assert.strictEqual(total, data.length);
+        done();
+    });
+
+    it("should hash each chunk with keyed BLAKE2b", function (done) {
+        var chunks = chunkAll(data, data.length);
+        [0, 5, chunks.lengths.length - 1].forEach(function (i) {
+            var chunk = data.slice(chunks.offsets[i], chunks.offsets[i] + chunks.lengths[i]);
+            assert(digest(chunks, i).equals(sodium.crypto_generichash(32, chunk, key)));
+        });
+        done();
+    });
+
+    it("should keep most chunks when data is inserted", function (done) {
+        var before = chunkAll(data, data.length);
+        var edited = Buffer.concat([data.slice(0, 50000), Buffer.from('inserted'), data.slice(50000)]);
+        var after = chunkAll(edited, edited.length);
+        var known = {};
+        for (var i = 0; i < before.lengths.length; i++) {
+            known[digest(before, i).toString('hex')] = true;
+        }
+        var shared = 0;
+        for (i = 0; i < after.lengths.length; i++) {
+            shared += known[digest(after, i).toString('hex')] ? 1 : 0;
+        }
+        assert(shared >= after.lengths.length - 3);
+        done();
+    });
+
+    it("should depend on the key", function (done) {
+        var a = new sodium.ContentChunker(key).push(data);
+        var b = new sodium.ContentChunker(Buffer.alloc(32, 8)).push(data);
+        assert.notDeepStrictEqual(a.lengths, b.lengths);
+        done();
+    });
+
+    it("should chunk on the threadpool", function () {
+        var chunker = new sodium.ContentChunker(key);
+        var whole = chunkAll(data, data.length);
+        var promise = chunker.pushAsync(data);
+        assert.throws(function () { chunker.push(data); });
+        return promise.then(function (chunks) {
+            var last = chunker.end();
+            assert.deepStrictEqual(chunks.lengths.concat(last.lengths), whole.lengths);
+        });
+    });
+
+    it("should chunk a file", function () {
+        var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-chunk-'));
+        var file = path.join(dir, 'data.bin');
+        fs.writeFileSync(file, data);
+        return sodium.sodium_chunk_file(file, key).then(function (chunks) {
+            var whole = chunkAll(data, data.length);
+            assert.deepStrictEqual(chunks.offsets, whole.offsets);
+            assert(chunks.digests.equals(whole.digests));
+            fs.unlinkSync(file);
+            fs.rmdirSync(dir);
+        });
+    });
+
+    it("should check its arguments", function (done) {
+        assert.throws(function () { new sodium.ContentChunker(Buffer.alloc(8)); });
+        assert.throws(function () { new sodium.ContentChunker(key, { avgSize: 5000 }); });
+        assert.throws(function () { new sodium.ContentChunker(key, { minSize: 16384 }); });
+        var chunker = new sodium.ContentChunker(key);
+        chunker.dispose();
+        assert.throws(function () { chunker.push(data); });
+        done();
+    });
+});
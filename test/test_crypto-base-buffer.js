@@ -33,6 +33,15 @@ describe("CryptoBaseBuffer", function () {
         done();
     });
 
+    it('methods should be shared, not copied to each instance', function(done) {
+        var a = new CryptoBaseBuffer();
+        var b = new CryptoBaseBuffer();
+        assert.strictEqual(a.toString, b.toString);
+        assert(!a.hasOwnProperty('set'));
+        assert.strictEqual(a.bytes, a.size);
+        done();
+    });
+
 });
 
 describe("cb.toBuffer", function () {
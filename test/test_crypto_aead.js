@@ -305,5 +305,20 @@ describe("AEAD Precompute Interface", function () {
         done();
     });
 
-
+    it("xchacha20poly1305_ietf should encrypt to and decrypt from base64url", function (done) {
+        var message = Buffer.from("session=42; role=admin");
+        var additionalData = Buffer.from("cookie");
+        var nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, 7);
+        var key = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+
+        var token = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_base64url(message, additionalData, nonce, key);
+        var c = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(message, additionalData, nonce, key);
+        assert.strictEqual(token, c.toString('base64url'));
+
+        var m = sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_base64url(token, additionalData, nonce, key);
+        assert(m.equals(message));
+        assert.strictEqual(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_base64url(token, Buffer.from("other"), nonce, key), null);
+        assert.strictEqual(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_base64url(token.slice(0, 8), additionalData, nonce, key), null);
+        done();
+    });
 });
@@ -0,0 +1,137 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var algos = ['aes256gcm', 'chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'];
+
+algos.forEach(function(algo) {
+    var prefix = 'crypto_aead_' + algo;
+
+    describe("AEAD " + algo + " batch", function () {
+        var available = algo !== 'aes256gcm' || sodium.crypto_aead_aes256gcm_is_available();
+        var abytes = sodium[prefix + '_ABYTES'];
+        var npubbytes = sodium[prefix + '_NPUBBYTES'];
+        var key = Buffer.allocUnsafe(sodium[prefix + '_KEYBYTES']);
+        sodium.randombytes_buf(key);
+
+        var messages = [], ads = [], nonces = [];
+        for(var i = 0; i < 20; i++) {
+            var m = Buffer.allocUnsafe(i * 13);
+            sodium.randombytes_buf(m);
+            messages.push(m);
+            ads.push(i % 3 ? Buffer.from('record ' + i) : null);
+            var n = Buffer.allocUnsafe(npubbytes);
+            sodium.randombytes_buf(n);
+            nonces.push(n);
+        }
+
+        it("should match one call per message", function (done) {
+            if( !available ) { done(); return; }
+
+            var out = sodium[prefix + '_encrypt_batch'](messages, ads, nonces, key);
+            var offset = 0;
+            var cipherTexts = [];
+            for(var i = 0; i < messages.length; i++) {
+                var c = sodium[prefix + '_encrypt'](messages[i], ads[i], nonces[i], key);
+                assert(sodium.compare(out.slice(offset, offset + c.length), c) == 0);
+                cipherTexts.push(out.slice(offset, offset + c.length));
+                offset += c.length;
+            }
+            assert.equal(offset, out.length);
+
+            var plain = sodium[prefix + '_decrypt_batch'](cipherTexts, ads, Buffer.concat(nonces), key);
+            assert(sodium.compare(plain, Buffer.concat(messages)) == 0);
+            done();
+        });
+
+        it("should fail the whole batch if one message is forged", function (done) {
+            if( !available ) { done(); return; }
+
+            var cipherTexts = messages.map(function(m, i) {
+                return sodium[prefix + '_encrypt'](m, ads[i], nonces[i], key);
+            });
+            cipherTexts[7][0] ^= 1;
+            assert.strictEqual(sodium[prefix + '_decrypt_batch'](cipherTexts, ads, nonces, key), null);
+            done();
+        });
+
+        it("should accept null additional data for the whole batch", function (done) {
+            if( !available ) { done(); return; }
+
+            var out = sodium[prefix + '_encrypt_batch'](messages.slice(0, 2), null, nonces.slice(0, 2), key);
+            var c0 = sodium[prefix + '_encrypt'](messages[0], null, nonces[0], key);
+            assert(sodium.compare(out.slice(0, c0.length), c0) == 0);
+            done();
+        });
+
+        it("should validate arguments", function (done) {
+            assert.throws(function() {
+                sodium[prefix + '_encrypt_batch'](messages, ads, nonces.slice(1), key);
+            });
+            assert.throws(function() {
+                sodium[prefix + '_encrypt_batch'](messages, ads, Buffer.alloc(3), key);
+            });
+            assert.throws(function() {
+                sodium[prefix + '_encrypt_batch']([ 'not a buffer' ], null, [ nonces[0] ], key);
+            });
+            assert.throws(function() {
+                sodium[prefix + '_decrypt_batch']([ Buffer.alloc(abytes - 1) ], null, [ nonces[0] ], key);
+            });
+            done();
+        });
+
+        it("should not let a later argument size an empty batch", function (done) {
+            assert.throws(function() {
+                sodium[prefix + '_encrypt_batch']([], [ ads[1] ], [ nonces[0] ], key);
+            }, /must have 0 elements/);
+            assert.throws(function() {
+                sodium[prefix + '_decrypt_batch']([], null, [ nonces[0] ], key);
+            }, /must have 0 elements/);
+            assert.throws(function() {
+                sodium[prefix + '_encrypt_batch']([], null, nonces[0], key);
+            }, /must be 0 x/);
+            if( available ) {
+                assert.equal(sodium[prefix + '_encrypt_batch']([], [], [], key).length, 0);
+            }
+            done();
+        });
+    });
+});
+
+// Short messages go through multi-message kernels, long ones on their own
+['aes256gcm', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'].forEach(function(algo) {
+    var prefix = 'crypto_aead_' + algo;
+
+    describe("AEAD " + algo + " batch of mixed sizes", function () {
+        var available = algo !== 'aes256gcm' || sodium.crypto_aead_aes256gcm_is_available();
+
+        it("should match one call per message across groups", function (done) {
+            if( !available ) { done(); return; }
+
+            var key = Buffer.allocUnsafe(sodium[prefix + '_KEYBYTES']);
+            sodium.randombytes_buf(key);
+            var messages = [], ads = [], nonces = [];
+            for(var i = 0; i < 200; i++) {
+                var m = Buffer.allocUnsafe(i % 9 ? (i * 37) % 600 : i * 11);
+                sodium.randombytes_buf(m);
+                messages.push(m);
+                ads.push(i % 2 ? Buffer.alloc(i % 80, i) : null);
+                var n = Buffer.allocUnsafe(sodium[prefix + '_NPUBBYTES']);
+                sodium.randombytes_buf(n);
+                nonces.push(n);
+            }
+
+            var out = sodium[prefix + '_encrypt_batch'](messages, ads, nonces, key);
+            var cipherTexts = messages.map(function(m, i) {
+                return sodium[prefix + '_encrypt'](m, ads[i], nonces[i], key);
+            });
+            assert(sodium.compare(out, Buffer.concat(cipherTexts)) == 0);
+
+            var plain = sodium[prefix + '_decrypt_batch'](cipherTexts, ads, nonces, key);
+            assert(sodium.compare(plain, Buffer.concat(messages)) == 0);
+
+            cipherTexts[150][cipherTexts[150].length - 1] ^= 1;
+            assert.strictEqual(sodium[prefix + '_decrypt_batch'](cipherTexts, ads, nonces, key), null);
+            done();
+        });
+    });
+});
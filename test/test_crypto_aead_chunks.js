@@ -0,0 +1,57 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("AEAD chunks", function () {
+    var message = Buffer.alloc(3 * 1024 * 1024 + 777);
+    sodium.randombytes_buf(message);
+    var chunkSize = 256 * 1024;
+
+    ['chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'].forEach(function (algo) {
+        var api = function (name) { return sodium['crypto_aead_' + algo + '_' + name]; };
+        var abytes = sodium['crypto_aead_' + algo + '_ABYTES'];
+        var key = api('keygen')();
+        var nonce = Buffer.alloc(sodium['crypto_aead_' + algo + '_NPUBBYTES']);
+        sodium.randombytes_buf(nonce);
+
+        it(algo + " should lay chunks out back to back", function () {
+            var c = api('encrypt_chunks')(message, chunkSize, null, nonce, 0, key, 4);
+            var frame = chunkSize + abytes;
+            var n = Buffer.from(nonce);
+            var three = Buffer.alloc(nonce.length);
+            three[0] = 3;
+            sodium.sodium_add(n, three);
+            assert(api('decrypt')(c.slice(3 * frame, 4 * frame), null, n, key)
+                .equals(message.slice(3 * chunkSize, 4 * chunkSize)));
+            assert(api('decrypt_chunks')(c, chunkSize, null, nonce, 0, key, 4).equals(message));
+        });
+
+        it(algo + " should encrypt and verify in parallel on the threadpool", function () {
+            var count = Math.ceil(message.length / chunkSize);
+            var out = Buffer.alloc(message.length + count * abytes);
+            return api('encrypt_chunks_async')(message, chunkSize, null, nonce, 0, key, out, { threads: 4 })
+                .then(function (c) {
+                    assert.strictEqual(c, out);
+                    assert(c.equals(api('encrypt_chunks')(message, chunkSize, null, nonce, 0, key)));
+                    return api('decrypt_chunks_async')(c, chunkSize, null, nonce, 0, key);
+                }).then(function (m) {
+                    assert(m.equals(message));
+                    out[out.length - 1] ^= 1;
+                    return api('decrypt_chunks_async')(out, chunkSize, null, nonce, 0, key);
+                }).then(function (m) {
+                    assert.strictEqual(m, null);
+                });
+        });
+    });
+
+    it("should check the output size", function () {
+        var key = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+        var nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+        assert.throws(function () {
+            sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_chunks_async(message, chunkSize, null, nonce, 0, key,
+                Buffer.alloc(10));
+        });
+        assert.throws(function () {
+            sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_chunks(Buffer.alloc(5), chunkSize, null, nonce, 0, key);
+        });
+    });
+});
@@ -0,0 +1,80 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_aead_column", function () {
+    var key = Buffer.alloc(sodium.crypto_aead_column_KEYBYTES, 3);
+    var ad = Buffer.from('users.email');
+    var values = ['alice@example.com', '', 'bob@example.com', 'alice@example.com'].map(function (v) {
+        return Buffer.from(v);
+    });
+    var lengths = values.map(function (v) {
+        return v.length;
+    });
+    var packed = Buffer.concat(values);
+
+    function split(buffer, sizes) {
+        var offset = 0;
+        return sizes.map(function (size) {
+            offset += size;
+            return buffer.slice(offset - size, offset);
+        });
+    }
+
+    it("should encrypt and index a column", function () {
+        var column = sodium.crypto_aead_column_encrypt_batch(packed, lengths, ad, key, 8, 2);
+        var cLengths = lengths.map(function (n) {
+            return n + sodium.crypto_aead_column_ABYTES;
+        });
+        assert.strictEqual(column.cipherTexts.length, packed.length + 4 * sodium.crypto_aead_column_ABYTES);
+        assert.strictEqual(column.indexes.length, 4 * 8);
+
+        var indexes = split(column.indexes, [8, 8, 8, 8]);
+        assert(indexes[0].equals(indexes[3]));
+        assert(!indexes[0].equals(indexes[2]));
+        values.forEach(function (v, i) {
+            assert(sodium.crypto_aead_column_index(v, key, 8).equals(indexes[i]));
+        });
+        assert(sodium.crypto_aead_column_index(values[0], key, 4).equals(indexes[0].slice(0, 4)));
+
+        // Random nonces: equal values still encrypt differently
+        var cs = split(column.cipherTexts, cLengths);
+        assert(!cs[0].equals(cs[3]));
+
+        var plain = sodium.crypto_aead_column_decrypt_batch(column.cipherTexts, cLengths, ad, key, 2);
+        assert(plain.equals(packed));
+        assert.strictEqual(sodium.crypto_aead_column_decrypt_batch(column.cipherTexts, cLengths, null, key), null);
+        column.cipherTexts[30] ^= 1;
+        assert.strictEqual(sodium.crypto_aead_column_decrypt_batch(column.cipherTexts, cLengths, ad, key), null);
+    });
+
+    it("should give other columns other indexes", function () {
+        var other = Buffer.alloc(sodium.crypto_aead_column_KEYBYTES, 4);
+        assert(!sodium.crypto_aead_column_index(values[0], key, 16).equals(
+            sodium.crypto_aead_column_index(values[0], other, 16)));
+    });
+
+    it("should encrypt on the threadpool", function () {
+        return sodium.crypto_aead_column_encrypt_batch_async(packed, lengths, ad, key, 16, 2).then(function (column) {
+            var cLengths = lengths.map(function (n) {
+                return n + sodium.crypto_aead_column_ABYTES;
+            });
+            assert(sodium.crypto_aead_column_decrypt_batch(column.cipherTexts, cLengths, ad, key).equals(packed));
+            assert(split(column.indexes, [16, 16, 16, 16])[1].equals(sodium.crypto_aead_column_index(values[1], key, 16)));
+        });
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () {
+            sodium.crypto_aead_column_encrypt_batch(packed, lengths, ad, key, 0);
+        });
+        assert.throws(function () {
+            sodium.crypto_aead_column_encrypt_batch(packed, lengths, ad, key, sodium.crypto_aead_column_INDEXBYTES_MAX + 1);
+        });
+        assert.throws(function () {
+            sodium.crypto_aead_column_encrypt_batch(packed, [1, 2], ad, key, 8);
+        });
+        assert.throws(function () {
+            sodium.crypto_aead_column_decrypt_batch(Buffer.alloc(10), 10, ad, key);
+        });
+    });
+});
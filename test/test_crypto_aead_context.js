@@ -0,0 +1,235 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var algos = ['aes256gcm', 'chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'];
+
+algos.forEach(function(algo) {
+    var prefix = 'crypto_aead_' + algo;
+
+    describe("AeadContext " + algo, function () {
+        var available = algo !== 'aes256gcm' || sodium.crypto_aead_aes256gcm_is_available();
+        var message = Buffer.from("This is a plain text message");
+        var additionalData = Buffer.from("this is metadata");
+        var nonce = Buffer.allocUnsafe(sodium[prefix + '_NPUBBYTES']);
+        var key = Buffer.allocUnsafe(sodium[prefix + '_KEYBYTES']);
+        sodium.randombytes_buf(nonce);
+        sodium.randombytes_buf(key);
+
+        it("should match the stateless functions", function (done) {
+            if( !available ) { done(); return; }
+
+            var ctx = new sodium.AeadContext(algo, key);
+            var c = ctx.encrypt(message, additionalData, nonce);
+            assert(sodium.compare(c, sodium[prefix + '_encrypt'](message, additionalData, nonce, key)) == 0);
+
+            var m = ctx.decrypt(c, additionalData, nonce);
+            assert(sodium.compare(m, message) == 0);
+
+            c[0] ^= 1;
+            assert.strictEqual(ctx.decrypt(c, additionalData, nonce), null);
+            done();
+        });
+
+        it("should encrypt and decrypt detached", function (done) {
+            if( !available ) { done(); return; }
+
+            var ctx = new sodium.AeadContext(algo, key);
+            var r = ctx.encryptDetached(message, null, nonce);
+            var expected = sodium[prefix + '_encrypt_detached'](message, null, nonce, key);
+            assert(sodium.compare(r.cipherText, expected.cipherText) == 0);
+            assert(sodium.compare(r.mac, expected.mac) == 0);
+
+            var m = ctx.decryptDetached(r.cipherText, r.mac, null, nonce);
+            assert(sodium.compare(m, message) == 0);
+            done();
+        });
+
+        it("should encrypt and decrypt into a buffer", function (done) {
+            if( !available ) { done(); return; }
+
+            var ctx = new sodium.AeadContext(algo, key);
+            var abytes = sodium[prefix + '_ABYTES'];
+            var frame = Buffer.alloc(4 + message.length + abytes);
+            var clen = ctx.encryptInto(frame, 4, message, additionalData, nonce);
+            assert.equal(clen, message.length + abytes);
+            var c = frame.slice(4);
+            assert(sodium.compare(c, ctx.encrypt(message, additionalData, nonce)) == 0);
+
+            var out = Buffer.alloc(message.length);
+            assert.equal(ctx.decryptInto(out, 0, c, additionalData, nonce), message.length);
+            assert(sodium.compare(out, message) == 0);
+            assert.throws(function() {
+                ctx.encryptInto(out, 0, message, additionalData, nonce);
+            });
+            done();
+        });
+
+        it("should encrypt and decrypt batches", function (done) {
+            if( !available ) { done(); return; }
+
+            var ctx = new sodium.AeadContext(algo, key);
+            var messages = [message, Buffer.from("second"), Buffer.alloc(0)];
+            var nonces = messages.map(function() {
+                var n = Buffer.allocUnsafe(nonce.length);
+                sodium.randombytes_buf(n);
+                return n;
+            });
+            var c = ctx.encryptBatch(messages, null, nonces);
+            assert(sodium.compare(c, sodium[prefix + '_encrypt_batch'](messages, null, nonces, key)) == 0);
+
+            var abytes = sodium[prefix + '_ABYTES'];
+            var cipherTexts = [], pos = 0;
+            messages.forEach(function(m) {
+                cipherTexts.push(c.slice(pos, pos + m.length + abytes));
+                pos += m.length + abytes;
+            });
+            var m = ctx.decryptBatch(cipherTexts, null, Buffer.concat(nonces));
+            assert(sodium.compare(m, Buffer.concat(messages)) == 0);
+
+            cipherTexts[1][0] ^= 1;
+            assert.strictEqual(ctx.decryptBatch(cipherTexts, null, nonces), null);
+            done();
+        });
+
+        it("should keep its own copy of the key", function (done) {
+            if( !available ) { done(); return; }
+
+            var k = Buffer.from(key);
+            var ctx = new sodium.AeadContext(algo, k);
+            k.fill(0);
+            var c = ctx.encrypt(message, null, nonce);
+            assert(sodium.compare(c, sodium[prefix + '_encrypt'](message, null, nonce, key)) == 0);
+            done();
+        });
+
+        it("should throw after dispose", function (done) {
+            if( !available ) { done(); return; }
+
+            var ctx = new sodium.AeadContext(algo, key);
+            ctx.dispose();
+            assert.throws(function() {
+                ctx.encrypt(message, null, nonce);
+            });
+            done();
+        });
+
+        it("should validate arguments", function (done) {
+            assert.throws(function() {
+                new sodium.AeadContext(algo, Buffer.alloc(3));
+            });
+            if( !available ) { done(); return; }
+
+            var ctx = new sodium.AeadContext(algo, key);
+            assert.throws(function() {
+                ctx.encrypt(message, null, Buffer.alloc(1));
+            });
+            done();
+        });
+    });
+});
+
+describe("AeadContext", function () {
+    it("should reject unknown algorithms", function (done) {
+        assert.throws(function() {
+            new sodium.AeadContext('rot13', Buffer.alloc(32));
+        });
+        done();
+    });
+
+    it("should reuse xchacha20 subkeys across nonce prefixes", function (done) {
+        var key = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+        var ctx = new sodium.AeadContext('xchacha20poly1305_ietf', key);
+        var ad = Buffer.from("session");
+
+        // Six prefixes take more than the cached slots, so some are derived again
+        for (var round = 0; round < 3; round++) {
+            for (var p = 0; p < 6; p++) {
+                var nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, p);
+                nonce.writeUInt32LE(round, 20);
+                var message = Buffer.from("message " + round + " " + p);
+                var c = ctx.encrypt(message, ad, nonce);
+                assert(c.equals(sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(message, ad, nonce, key)));
+                assert(ctx.decrypt(c, ad, nonce).equals(message));
+                nonce[0] ^= 1;
+                assert.strictEqual(ctx.decrypt(c, ad, nonce), null);
+            }
+        }
+        done();
+    });
+
+    it("afternm functions should accept an unaligned aes256gcm state", function (done) {
+        if( !sodium.crypto_aead_aes256gcm_is_available() ) { done(); return; }
+
+        var key = sodium.crypto_aead_aes256gcm_keygen();
+        var nonce = Buffer.alloc(sodium.crypto_aead_aes256gcm_NPUBBYTES, 1);
+        var state = sodium.crypto_aead_aes256gcm_beforenm(key);
+        var shifted = Buffer.alloc(state.length + 1).slice(1);
+        state.copy(shifted);
+
+        var message = Buffer.from("unaligned state");
+        var c = sodium.crypto_aead_aes256gcm_encrypt_afternm(message, null, nonce, shifted);
+        assert(sodium.compare(c, sodium.crypto_aead_aes256gcm_encrypt(message, null, nonce, key)) == 0);
+        var m = sodium.crypto_aead_aes256gcm_decrypt_afternm(c, null, nonce, shifted);
+        assert(sodium.compare(m, message) == 0);
+        done();
+    });
+});
+
+describe("AeadKeyring", function () {
+    var message = Buffer.from("This is a plain text message");
+    var ad = Buffer.from("tenant 42");
+
+    it("should decrypt frames of every key it holds", function (done) {
+        var oldKey = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+        var newKey = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+        var ring = new sodium.AeadKeyring('xchacha20poly1305_ietf');
+        assert.strictEqual(ring.primary, -1);
+
+        ring.add(7, oldKey);
+        var oldFrame = ring.encrypt(message, ad);
+        ring.add(0x80000001, newKey, true);
+        var newFrame = ring.encrypt(message, ad);
+
+        assert.strictEqual(ring.size, 2);
+        assert.strictEqual(ring.primary, 0x80000001);
+        assert.strictEqual(ring.keyId(oldFrame), 7);
+        assert.strictEqual(ring.keyId(newFrame), 0x80000001);
+        assert.strictEqual(newFrame.length, message.length + ring.overhead);
+
+        var nonce = newFrame.slice(4, 4 + sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+        var c = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(message, ad, nonce, newKey);
+        assert(newFrame.slice(4 + nonce.length).equals(c));
+
+        assert(ring.decrypt(oldFrame, ad).equals(message));
+        assert(ring.decrypt(newFrame, ad).equals(message));
+        assert.strictEqual(ring.decrypt(newFrame, Buffer.from("tenant 43")), null);
+
+        ring.remove(7);
+        assert.strictEqual(ring.has(7), false);
+        assert.strictEqual(ring.decrypt(oldFrame, ad), null);
+        done();
+    });
+
+    it("should require nonces for short nonce algorithms", function (done) {
+        var ring = new sodium.AeadKeyring('chacha20poly1305_ietf');
+        var key = sodium.crypto_aead_chacha20poly1305_ietf_keygen();
+        ring.add(1, key);
+        assert.throws(function() { ring.encrypt(message, ad); });
+
+        var nonce = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES, 3);
+        var frame = ring.encrypt(message, ad, nonce);
+        assert(ring.decrypt(frame, ad).equals(message));
+        done();
+    });
+
+    it("should reject bad key ids and disposed keyrings", function (done) {
+        var ring = new sodium.AeadKeyring('xchacha20poly1305_ietf');
+        assert.throws(function() { ring.encrypt(message, ad); });
+        assert.throws(function() { ring.add(-1, sodium.crypto_aead_xchacha20poly1305_ietf_keygen()); });
+        assert.throws(function() { ring.add(2, Buffer.alloc(16)); });
+        assert.throws(function() { ring.setPrimary(3); });
+        ring.dispose();
+        assert.throws(function() { ring.add(1, sodium.crypto_aead_xchacha20poly1305_ietf_keygen()); });
+        done();
+    });
+});
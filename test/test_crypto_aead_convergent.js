@@ -0,0 +1,73 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_aead_convergent", function () {
+    var secret = Buffer.alloc(sodium.crypto_aead_convergent_KEYBYTES, 5);
+    var m = Buffer.from('a chunk that is stored once');
+    var ad = Buffer.from('tenant group 1');
+
+    it("should encrypt deterministically", function (done) {
+        var a = sodium.crypto_aead_convergent_encrypt(m, ad, secret);
+        var b = sodium.crypto_aead_convergent_encrypt(m, ad, secret);
+        assert.strictEqual(a.key.length, sodium.crypto_aead_convergent_KEYBYTES);
+        assert.strictEqual(a.cipherText.length, m.length + sodium.crypto_aead_convergent_ABYTES);
+        assert(a.key.equals(b.key) && a.cipherText.equals(b.cipherText));
+
+        var other = sodium.crypto_aead_convergent_encrypt(m, Buffer.from('tenant group 2'), secret);
+        assert(!other.key.equals(a.key));
+        var otherSecret = sodium.crypto_aead_convergent_encrypt(m, ad, Buffer.alloc(32, 6));
+        assert(!otherSecret.cipherText.equals(a.cipherText));
+        done();
+    });
+
+    it("should decrypt with the key", function (done) {
+        var sealed = sodium.crypto_aead_convergent_encrypt(m, null, secret);
+        assert(sodium.crypto_aead_convergent_decrypt(sealed.cipherText, null, sealed.key).equals(m));
+        assert.strictEqual(sodium.crypto_aead_convergent_decrypt(sealed.cipherText, ad, sealed.key), null);
+
+        var npub = sealed.cipherText.slice(0, sodium.crypto_aead_convergent_NPUBBYTES);
+        var c = sealed.cipherText.slice(sodium.crypto_aead_convergent_NPUBBYTES);
+        assert(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt(c, null, npub, sealed.key).equals(m));
+
+        sealed.cipherText[30] ^= 1;
+        assert.strictEqual(sodium.crypto_aead_convergent_decrypt(sealed.cipherText, null, sealed.key), null);
+        done();
+    });
+
+    it("should encrypt and decrypt batches", function (done) {
+        var messages = [m, Buffer.alloc(0), Buffer.alloc(5000, 1)];
+        var batch = sodium.crypto_aead_convergent_encrypt_batch(messages, ad, secret, 2);
+        var offset = 0;
+        messages.forEach(function (message, i) {
+            var one = sodium.crypto_aead_convergent_encrypt(message, ad, secret);
+            assert(batch.keys.slice(i * 32, i * 32 + 32).equals(one.key));
+            assert(batch.cipherTexts.slice(offset, offset + one.cipherText.length).equals(one.cipherText));
+            offset += one.cipherText.length;
+        });
+
+        var cipherTexts = [];
+        offset = 0;
+        messages.forEach(function (message) {
+            var length = message.length + sodium.crypto_aead_convergent_ABYTES;
+            cipherTexts.push(batch.cipherTexts.slice(offset, offset + length));
+            offset += length;
+        });
+        var plain = sodium.crypto_aead_convergent_decrypt_batch(cipherTexts, ad, batch.keys, 2);
+        assert(plain.equals(Buffer.concat(messages)));
+        cipherTexts[2] = Buffer.from(cipherTexts[2]);
+        cipherTexts[2][40] ^= 1;
+        assert.strictEqual(sodium.crypto_aead_convergent_decrypt_batch(cipherTexts, ad, batch.keys), null);
+        done();
+    });
+
+    it("should encrypt on the threadpool", function () {
+        var one = sodium.crypto_aead_convergent_encrypt(m, ad, secret);
+        return Promise.all([
+            sodium.crypto_aead_convergent_encrypt_async(m, ad, secret),
+            sodium.crypto_aead_convergent_encrypt_batch_async([m, m], ad, secret, 2)
+        ]).then(function (results) {
+            assert(results[0].key.equals(one.key) && results[0].cipherText.equals(one.cipherText));
+            assert(results[1].cipherTexts.equals(Buffer.concat([one.cipherText, one.cipherText])));
+        });
+    });
+});
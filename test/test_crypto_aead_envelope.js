@@ -0,0 +1,51 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_aead_envelope", function () {
+    var kek = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+    var message = Buffer.from("This is a plain text message");
+    var ad = Buffer.from("object 17");
+
+    it("should seal and open", function (done) {
+        var sealed = sodium.crypto_aead_envelope_seal(message, ad, kek);
+        assert.strictEqual(sealed.wrappedKey.length, sodium.crypto_aead_envelope_WRAPPEDBYTES);
+        assert.strictEqual(sealed.cipherText.length, message.length + sodium.crypto_aead_envelope_ABYTES);
+
+        var m = sodium.crypto_aead_envelope_open(sealed.wrappedKey, sealed.cipherText, ad, kek);
+        assert(m.equals(message));
+
+        // The layers are plain XChaCha20-Poly1305
+        var npub = sodium.crypto_aead_envelope_NPUBBYTES;
+        var dek = sodium.crypto_aead_xchacha20poly1305_ietf_decrypt(
+            sealed.wrappedKey.slice(npub), ad, sealed.wrappedKey.slice(0, npub), kek);
+        m = sodium.crypto_aead_xchacha20poly1305_ietf_decrypt(
+            sealed.cipherText.slice(npub), ad, sealed.cipherText.slice(0, npub), dek);
+        assert(m.equals(message));
+
+        assert.strictEqual(sodium.crypto_aead_envelope_open(sealed.wrappedKey, sealed.cipherText,
+            Buffer.from("object 18"), kek), null);
+        assert.strictEqual(sodium.crypto_aead_envelope_open(sealed.wrappedKey, sealed.cipherText,
+            ad, sodium.crypto_aead_xchacha20poly1305_ietf_keygen()), null);
+        done();
+    });
+
+    it("should generate and unwrap keys in batches", function (done) {
+        var batch = sodium.crypto_aead_envelope_keygen(1000, kek, null, 4);
+        assert.strictEqual(batch.keys.length, 1000 * sodium.crypto_aead_envelope_KEYBYTES);
+        assert.strictEqual(batch.wrappedKeys.length, 1000 * sodium.crypto_aead_envelope_WRAPPEDBYTES);
+
+        var keys = sodium.crypto_aead_envelope_unwrap(batch.wrappedKeys, kek, null, 4);
+        assert(keys.equals(batch.keys));
+
+        var w = sodium.crypto_aead_envelope_WRAPPEDBYTES;
+        var one = sodium.crypto_aead_envelope_unwrap([batch.wrappedKeys.slice(3 * w, 4 * w)], kek);
+        assert(one.equals(batch.keys.slice(3 * 32, 4 * 32)));
+
+        batch.wrappedKeys[5 * w] ^= 1;
+        assert.strictEqual(sodium.crypto_aead_envelope_unwrap(batch.wrappedKeys, kek), null);
+        assert.throws(function() {
+            sodium.crypto_aead_envelope_unwrap(batch.wrappedKeys.slice(1), kek);
+        });
+        done();
+    });
+});
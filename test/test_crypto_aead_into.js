@@ -0,0 +1,103 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var algos = ['aes256gcm', 'chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'];
+
+algos.forEach(function(algo) {
+    var prefix = 'crypto_aead_' + algo;
+
+    describe("AEAD " + algo + " into", function () {
+        var message = Buffer.from("This is a plain text message");
+        var additionalData = Buffer.from("this is metadata");
+        var nonce = Buffer.allocUnsafe(sodium[prefix + '_NPUBBYTES']);
+        var key = Buffer.allocUnsafe(sodium[prefix + '_KEYBYTES']);
+        var abytes = sodium[prefix + '_ABYTES'];
+        sodium.randombytes_buf(nonce);
+        sodium.randombytes_buf(key);
+
+        var available = algo !== 'aes256gcm' || sodium.crypto_aead_aes256gcm_is_available();
+
+        it("should encrypt into a buffer at an offset", function (done) {
+            if( !available ) { done(); return; }
+
+            var frame = Buffer.alloc(message.length + abytes + 8, 0xff);
+            var clen = sodium[prefix + '_encrypt_into'](frame, 4, message, additionalData, nonce, key);
+            assert.equal(clen, message.length + abytes);
+
+            var expected = sodium[prefix + '_encrypt'](message, additionalData, nonce, key);
+            assert(sodium.compare(frame.slice(4, 4 + clen), expected) == 0);
+            assert.equal(frame[0], 0xff);
+            assert.equal(frame[frame.length - 1], 0xff);
+
+            var plain = Buffer.alloc(message.length + 2);
+            var mlen = sodium[prefix + '_decrypt_into'](plain, 2, frame.slice(4, 4 + clen), additionalData, nonce, key);
+            assert.equal(mlen, message.length);
+            assert(sodium.compare(plain.slice(2), message) == 0);
+            done();
+        });
+
+        it("should return null when decryption fails", function (done) {
+            if( !available ) { done(); return; }
+
+            var c = sodium[prefix + '_encrypt'](message, additionalData, nonce, key);
+            c[0] ^= 1;
+            var plain = Buffer.alloc(message.length);
+            assert.strictEqual(sodium[prefix + '_decrypt_into'](plain, 0, c, additionalData, nonce, key), null);
+            done();
+        });
+
+        it("should throw when the output does not fit", function (done) {
+            var out = Buffer.alloc(message.length + abytes);
+            assert.throws(function() {
+                sodium[prefix + '_encrypt_into'](out, 1, message, additionalData, nonce, key);
+            });
+            assert.throws(function() {
+                sodium[prefix + '_encrypt_into'](out, out.length + 10, message, additionalData, nonce, key);
+            });
+            done();
+        });
+
+        it("should encrypt and decrypt detached into buffers", function (done) {
+            if( !available ) { done(); return; }
+
+            var out = Buffer.alloc(message.length);
+            var mac = Buffer.alloc(abytes + 3);
+            var n = sodium[prefix + '_encrypt_detached_into'](out, 0, mac, 3, message, additionalData, nonce, key);
+            assert.equal(n, message.length);
+
+            var expected = sodium[prefix + '_encrypt_detached'](message, additionalData, nonce, key);
+            assert(sodium.compare(out, expected.cipherText) == 0);
+            assert(sodium.compare(mac.slice(3), expected.mac) == 0);
+
+            var plain = Buffer.alloc(message.length);
+            n = sodium[prefix + '_decrypt_detached_into'](plain, 0, out, mac.slice(3), additionalData, nonce, key);
+            assert.equal(n, message.length);
+            assert(sodium.compare(plain, message) == 0);
+            done();
+        });
+    });
+});
+
+describe("AEAD aes256gcm precompute into", function () {
+    it("should encrypt and decrypt into buffers", function (done) {
+        if( !sodium.crypto_aead_aes256gcm_is_available() ) { done(); return; }
+
+        var message = Buffer.from("This is a plain text message");
+        var nonce = Buffer.allocUnsafe(sodium.crypto_aead_aes256gcm_NPUBBYTES);
+        var key = Buffer.allocUnsafe(sodium.crypto_aead_aes256gcm_KEYBYTES);
+        sodium.randombytes_buf(nonce);
+        sodium.randombytes_buf(key);
+        var state = sodium.crypto_aead_aes256gcm_beforenm(key);
+
+        var out = Buffer.alloc(message.length + sodium.crypto_aead_aes256gcm_ABYTES);
+        var clen = sodium.crypto_aead_aes256gcm_encrypt_afternm_into(out, 0, message, null, nonce, state);
+        assert.equal(clen, out.length);
+        assert(sodium.compare(out, sodium.crypto_aead_aes256gcm_encrypt(message, null, nonce, key)) == 0);
+
+        var plain = Buffer.alloc(message.length);
+        var mlen = sodium.crypto_aead_aes256gcm_decrypt_afternm_into(plain, 0, out, null, nonce, state);
+        assert.equal(mlen, message.length);
+        assert(sodium.compare(plain, message) == 0);
+        done();
+    });
+});
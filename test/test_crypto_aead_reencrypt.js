@@ -0,0 +1,64 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var algos = ['aes256gcm', 'chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'];
+
+algos.forEach(function(algo) {
+    var prefix = 'crypto_aead_' + algo;
+
+    describe("AEAD " + algo + " reencrypt", function () {
+        var available = algo !== 'aes256gcm' || sodium.crypto_aead_aes256gcm_is_available();
+        var npubbytes = sodium[prefix + '_NPUBBYTES'];
+        var oldKey = Buffer.alloc(sodium[prefix + '_KEYBYTES'], 1);
+        var newKey = Buffer.alloc(sodium[prefix + '_KEYBYTES'], 2);
+
+        var messages = [], ads = [], oldNonces = [], newNonces = [], cipherTexts = [];
+        for(var i = 0; i < 10; i++) {
+            var m = Buffer.allocUnsafe(i * 37);
+            sodium.randombytes_buf(m);
+            messages.push(m);
+            ads.push(i % 2 ? Buffer.from('row ' + i) : null);
+            oldNonces.push(Buffer.alloc(npubbytes, i));
+            newNonces.push(Buffer.alloc(npubbytes, 100 + i));
+        }
+
+        before(function () {
+            if( !available ) { this.skip(); }
+            cipherTexts = messages.map(function(m, i) {
+                return sodium[prefix + '_encrypt'](m, ads[i], oldNonces[i], oldKey);
+            });
+        });
+
+        it("should move one cipher text to the new key", function () {
+            var c = sodium[prefix + '_reencrypt'](cipherTexts[3], ads[3], oldNonces[3], oldKey, newNonces[3], newKey);
+            assert(c.equals(sodium[prefix + '_encrypt'](messages[3], ads[3], newNonces[3], newKey)));
+            assert.strictEqual(sodium[prefix + '_reencrypt'](cipherTexts[3], ads[3], oldNonces[3], newKey, newNonces[3], newKey), null);
+            assert.strictEqual(sodium[prefix + '_reencrypt'](cipherTexts[3], null, oldNonces[3], oldKey, newNonces[3], newKey), null);
+        });
+
+        it("should move a batch to the new key", function () {
+            var out = sodium[prefix + '_reencrypt_batch'](cipherTexts, ads, oldNonces, oldKey, Buffer.concat(newNonces), newKey);
+            assert(out.equals(sodium[prefix + '_encrypt_batch'](messages, ads, newNonces, newKey)));
+
+            var forged = cipherTexts.slice();
+            forged[5] = Buffer.from(forged[5]);
+            forged[5][0] ^= 1;
+            assert.strictEqual(sodium[prefix + '_reencrypt_batch'](forged, ads, oldNonces, oldKey, newNonces, newKey), null);
+        });
+
+        it("should move a batch on the threadpool", function () {
+            return sodium[prefix + '_reencrypt_batch_async'](cipherTexts, ads, oldNonces, oldKey, newNonces, newKey).then(function(out) {
+                assert(sodium[prefix + '_decrypt_batch'](out, ads, newNonces, newKey).equals(Buffer.concat(messages)));
+            });
+        });
+
+        it("should check its arguments", function () {
+            assert.throws(function() {
+                sodium[prefix + '_reencrypt'](cipherTexts[0], null, oldNonces[0], oldKey, Buffer.alloc(1), newKey);
+            });
+            assert.throws(function() {
+                sodium[prefix + '_reencrypt_batch'](cipherTexts, ads, oldNonces.slice(1), oldKey, newNonces, newKey);
+            });
+        });
+    });
+});
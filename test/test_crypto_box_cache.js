@@ -0,0 +1,128 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_box shared key cache", function () {
+    var alice = sodium.crypto_box_keypair();
+    var bob = sodium.crypto_box_keypair();
+    var nonce = Buffer.alloc(sodium.crypto_box_NONCEBYTES, 2);
+    var m = Buffer.from("This is a test");
+
+    after(function () {
+        sodium.crypto_box_cache_disable();
+    });
+
+    it("should be disabled by default", function (done) {
+        var stats = sodium.crypto_box_cache_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.strictEqual(stats.size, 0);
+        done();
+    });
+
+    it("should give the same results enabled and disabled", function (done) {
+        var c = sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+        var nacl = sodium.crypto_box(m, nonce, bob.publicKey, alice.secretKey);
+        var d = sodium.crypto_box_detached(m, nonce, bob.publicKey, alice.secretKey);
+
+        sodium.crypto_box_cache_enable(8);
+        for (var i = 0; i < 2; i++) {
+            assert(sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey).equals(c));
+            assert(sodium.crypto_box_open_easy(c, nonce, alice.publicKey, bob.secretKey).equals(m));
+            assert(sodium.crypto_box(m, nonce, bob.publicKey, alice.secretKey).equals(nacl));
+            assert(sodium.crypto_box_open(nacl, nonce, alice.publicKey, bob.secretKey).equals(m));
+
+            var d2 = sodium.crypto_box_detached(m, nonce, bob.publicKey, alice.secretKey);
+            assert(d2.cipherText.equals(d.cipherText) && d2.mac.equals(d.mac));
+            assert(sodium.crypto_box_open_detached(d.cipherText, d.mac, nonce, alice.publicKey, bob.secretKey).equals(m));
+        }
+
+        var forged = Buffer.from(c);
+        forged[0] ^= 1;
+        assert.strictEqual(sodium.crypto_box_open_easy(forged, nonce, alice.publicKey, bob.secretKey), null);
+
+        var stats = sodium.crypto_box_cache_stats();
+        assert.strictEqual(stats.enabled, true);
+        assert.strictEqual(stats.size, 2);
+        assert.strictEqual(stats.misses, 2);
+        assert.strictEqual(stats.hits, 11);
+        done();
+    });
+
+    it("should evict the least recently used key pair", function (done) {
+        sodium.crypto_box_cache_enable(2);
+        var peers = [0, 1, 2].map(function () { return sodium.crypto_box_keypair(); });
+        var box = function (peer) {
+            return sodium.crypto_box_easy(m, nonce, peer.publicKey, alice.secretKey);
+        };
+
+        box(peers[0]);
+        box(peers[1]);
+        box(peers[0]);
+        box(peers[2]);          // evicts peers[1]
+        box(peers[0]);
+        box(peers[1]);
+
+        var stats = sodium.crypto_box_cache_stats();
+        assert.strictEqual(stats.capacity, 2);
+        assert.strictEqual(stats.size, 2);
+        assert.strictEqual(stats.hits, 2);
+        assert.strictEqual(stats.misses, 4);
+        assert.strictEqual(stats.evictions, 2);
+        done();
+    });
+
+    it("should expire entries", function (done) {
+        sodium.crypto_box_cache_enable(4, 1);
+        sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+        setTimeout(function () {
+            sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+            var stats = sodium.crypto_box_cache_stats();
+            assert.strictEqual(stats.hits, 0);
+            assert.strictEqual(stats.misses, 2);
+            assert.strictEqual(stats.expirations, 1);
+            assert.strictEqual(stats.size, 1);
+            done();
+        }, 20);
+    });
+
+    it("should clear and disable", function (done) {
+        sodium.crypto_box_cache_enable(4);
+        sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+        sodium.crypto_box_cache_clear();
+        assert.strictEqual(sodium.crypto_box_cache_stats().size, 0);
+        assert.strictEqual(sodium.crypto_box_cache_stats().enabled, true);
+
+        sodium.crypto_box_cache_disable();
+        sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+        var stats = sodium.crypto_box_cache_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.strictEqual(stats.size, 0);
+        done();
+    });
+
+    it("should share keys through a shared memory segment", function (done) {
+        if( process.platform === 'win32' ) {
+            return done();
+        }
+        var name = 'test-' + process.pid;
+        sodium.crypto_box_cache_disable();
+        sodium.crypto_box_cache_share(name, 16);
+        try {
+            var c = sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+            var session = new sodium.BoxSession(alice.publicKey, bob.secretKey);
+            assert.deepEqual(session.decrypt(c, nonce), m);
+            session.dispose();
+
+            var shared = sodium.crypto_box_cache_stats().shared;
+            assert.strictEqual(shared.name, name);
+            assert.strictEqual(shared.capacity, 16);
+            assert.strictEqual(shared.inserts, 2);
+            assert.strictEqual(shared.size, 2);
+        }
+        finally {
+            sodium.crypto_box_cache_share(null);
+            sodium.sodium_shared_cache_unlink(name);
+        }
+        assert.strictEqual(sodium.crypto_box_cache_stats().shared, null);
+        done();
+    });
+});
@@ -0,0 +1,107 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var alice = sodium.crypto_box_curve25519xchacha20poly1305_seed_keypair(Buffer.alloc(32, 1));
+var bob = sodium.crypto_box_curve25519xchacha20poly1305_seed_keypair(Buffer.alloc(32, 2));
+var nonce = Buffer.alloc(sodium.crypto_box_curve25519xchacha20poly1305_NONCEBYTES, 0x35);
+var message = Buffer.from("peer to peer message sealed with XChaCha20-Poly1305");
+
+describe('crypto_box_curve25519xchacha20poly1305', function() {
+    it('should export the sizes', function() {
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_NONCEBYTES, 24);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_MACBYTES, 16);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_SEALBYTES, 48);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_beforenmbytes(), 32);
+    });
+
+    it('seed_keypair should be deterministic and keypair random', function() {
+        var again = sodium.crypto_box_curve25519xchacha20poly1305_seed_keypair(Buffer.alloc(32, 1));
+        assert.deepEqual(again.publicKey, alice.publicKey);
+        var a = sodium.crypto_box_curve25519xchacha20poly1305_keypair();
+        var b = sodium.crypto_box_curve25519xchacha20poly1305_keypair();
+        assert.notDeepEqual(a.secretKey, b.secretKey);
+        assert.deepEqual(sodium.crypto_scalarmult_base(a.secretKey), a.publicKey);
+    });
+
+    it('easy should be secretbox_xchacha20poly1305 under the beforenm key', function() {
+        var k = sodium.crypto_box_curve25519xchacha20poly1305_beforenm(bob.publicKey, alice.secretKey);
+        assert.deepEqual(k, sodium.crypto_box_curve25519xchacha20poly1305_beforenm(alice.publicKey, bob.secretKey));
+
+        var c = sodium.crypto_box_curve25519xchacha20poly1305_easy(message, nonce, bob.publicKey, alice.secretKey);
+        assert.deepEqual(c, sodium.crypto_secretbox_xchacha20poly1305_easy(message, nonce, k));
+        assert.deepEqual(c, sodium.crypto_box_curve25519xchacha20poly1305_easy_afternm(message, nonce, k));
+
+        assert.deepEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_easy(c, nonce, alice.publicKey, bob.secretKey), message);
+        assert.deepEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_easy_afternm(c, nonce, k), message);
+
+        c[20] ^= 1;
+        assert.strictEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_easy(c, nonce, alice.publicKey, bob.secretKey), null);
+        assert.strictEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_easy_afternm(c, nonce, k), null);
+    });
+
+    it('detached should split the easy box', function() {
+        var k = sodium.crypto_box_curve25519xchacha20poly1305_beforenm(bob.publicKey, alice.secretKey);
+        var easy = sodium.crypto_box_curve25519xchacha20poly1305_easy(message, nonce, bob.publicKey, alice.secretKey);
+
+        var d = sodium.crypto_box_curve25519xchacha20poly1305_detached(message, nonce, bob.publicKey, alice.secretKey);
+        assert.deepEqual(Buffer.concat([d.mac, d.cipherText]), easy);
+        assert.deepEqual(sodium.crypto_box_curve25519xchacha20poly1305_detached_afternm(message, nonce, k), d);
+
+        assert.deepEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_detached(d.cipherText, d.mac, nonce, alice.publicKey, bob.secretKey), message);
+        assert.deepEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_detached_afternm(d.cipherText, d.mac, nonce, k), message);
+
+        d.mac[0] ^= 1;
+        assert.strictEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_detached_afternm(d.cipherText, d.mac, nonce, k), null);
+    });
+
+    it('seal should open only with the recipient key pair', function() {
+        var c = sodium.crypto_box_curve25519xchacha20poly1305_seal(message, bob.publicKey);
+        assert.equal(c.length, message.length + sodium.crypto_box_curve25519xchacha20poly1305_SEALBYTES);
+        assert.deepEqual(sodium.crypto_box_curve25519xchacha20poly1305_seal_open(c, bob.publicKey, bob.secretKey), message);
+        assert.strictEqual(sodium.crypto_box_curve25519xchacha20poly1305_seal_open(c, alice.publicKey, alice.secretKey), null);
+        assert.strictEqual(sodium.crypto_box_curve25519xchacha20poly1305_seal_open(c.slice(0, 10), bob.publicKey, bob.secretKey), null);
+    });
+
+    it('_into variants should write at the offset', function() {
+        var k = sodium.crypto_box_curve25519xchacha20poly1305_beforenm(bob.publicKey, alice.secretKey);
+        var size = message.length + sodium.crypto_box_curve25519xchacha20poly1305_MACBYTES;
+        var out = Buffer.alloc(size + 8);
+
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_easy_into(out, 8, message, nonce, bob.publicKey, alice.secretKey), size);
+        assert.deepEqual(out.slice(8), sodium.crypto_box_curve25519xchacha20poly1305_easy_afternm(message, nonce, k));
+
+        var plain = Buffer.alloc(message.length);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_open_easy_into(plain, 0, out, 8, size, nonce, alice.publicKey, bob.secretKey), message.length);
+        assert.deepEqual(plain, message);
+
+        var frame = Buffer.alloc(size);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_easy_afternm_into(frame, 0, message, nonce, k), size);
+        assert.deepEqual(frame, out.slice(8));
+        plain.fill(0);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_open_easy_afternm_into(plain, 0, frame, nonce, k), message.length);
+        assert.deepEqual(plain, message);
+
+        frame[0] ^= 1;
+        assert.strictEqual(sodium.crypto_box_curve25519xchacha20poly1305_open_easy_afternm_into(plain, 0, frame, nonce, k), null);
+
+        assert.throws(function() {
+            sodium.crypto_box_curve25519xchacha20poly1305_easy_afternm_into(frame, 1, message, nonce, k);
+        });
+    });
+
+    it('seal_into and seal_open_into should round trip', function() {
+        var size = message.length + sodium.crypto_box_curve25519xchacha20poly1305_SEALBYTES;
+        var out = Buffer.alloc(size + 2);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_seal_into(out, 2, message, bob.publicKey), size);
+
+        var plain = Buffer.alloc(message.length + 4);
+        assert.equal(sodium.crypto_box_curve25519xchacha20poly1305_seal_open_into(plain, 4, out.slice(2), bob.publicKey, bob.secretKey), message.length);
+        assert.deepEqual(plain.slice(4), message);
+
+        assert.throws(function() {
+            sodium.crypto_box_curve25519xchacha20poly1305_seal_into(out, 3, message, bob.publicKey);
+        });
+    });
+});
@@ -0,0 +1,66 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_box_easy_async and crypto_secretbox_easy_async", function () {
+    var alice = sodium.crypto_box_keypair();
+    var bob = sodium.crypto_box_keypair();
+    var key = sodium.randombytes_buf(sodium.crypto_secretbox_KEYBYTES);
+    var large = sodium.randombytes_buf(4 * 1024 * 1024);
+    var small = Buffer.from("hello");
+
+    it("should box like crypto_box_easy", function () {
+        var nonce = sodium.randombytes_buf(sodium.crypto_box_NONCEBYTES);
+        return Promise.all([large, small].map(function (m) {
+            return sodium.crypto_box_easy_async(m, nonce, bob.publicKey, alice.secretKey).then(function (c) {
+                assert(c.equals(sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey)));
+                return sodium.crypto_box_open_easy_async(c, nonce, alice.publicKey, bob.secretKey);
+            }).then(function (m2) {
+                assert(m2.equals(m));
+            });
+        }));
+    });
+
+    it("should secretbox like crypto_secretbox_easy", function () {
+        var nonce = sodium.randombytes_buf(sodium.crypto_secretbox_NONCEBYTES);
+        return Promise.all([large, small].map(function (m) {
+            return sodium.crypto_secretbox_easy_async(m, nonce, key).then(function (c) {
+                assert(c.equals(sodium.crypto_secretbox_easy(m, nonce, key)));
+                return sodium.crypto_secretbox_open_easy_async(c, nonce, key);
+            }).then(function (m2) {
+                assert(m2.equals(m));
+            });
+        }));
+    });
+
+    it("should resolve to null for a forged box", function () {
+        var nonce = sodium.randombytes_buf(sodium.crypto_secretbox_NONCEBYTES);
+        var c = sodium.crypto_secretbox_easy(large, nonce, key);
+        c[100] ^= 1;
+        return sodium.crypto_secretbox_open_easy_async(c, nonce, key).then(function (m) {
+            assert.strictEqual(m, null);
+            var boxed = sodium.crypto_box_easy(large, nonce, bob.publicKey, alice.secretKey);
+            return sodium.crypto_box_open_easy_async(boxed, nonce, alice.publicKey, alice.secretKey);
+        }).then(function (m) {
+            assert.strictEqual(m, null);
+        });
+    });
+
+    it("should take a callback", function (done) {
+        var nonce = sodium.randombytes_buf(sodium.crypto_secretbox_NONCEBYTES);
+        sodium.crypto_secretbox_easy_async(small, nonce, key, function (err, c) {
+            assert.ifError(err);
+            assert(c.equals(sodium.crypto_secretbox_easy(small, nonce, key)));
+            done();
+        });
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () {
+            sodium.crypto_secretbox_easy_async(small, Buffer.alloc(8), key);
+        });
+        assert.throws(function () {
+            sodium.crypto_box_open_easy_async(Buffer.alloc(4), Buffer.alloc(sodium.crypto_box_NONCEBYTES),
+                alice.publicKey, bob.secretKey);
+        });
+    });
+});
@@ -0,0 +1,55 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_box_multi", function () {
+    var message = Buffer.from("group message");
+    var members = [];
+    for (var i = 0; i < 50; i++) {
+        members.push(sodium.crypto_box_keypair());
+    }
+    var publicKeys = members.map(function (r) { return r.publicKey; });
+    var size = message.length + sodium.crypto_box_multi_HEADERBYTES + sodium.crypto_box_multi_ABYTES +
+               members.length * sodium.crypto_box_multi_WRAPBYTES;
+
+    var checkEnvelope = function (envelope) {
+        assert.strictEqual(envelope.length, size);
+        members.forEach(function (r, i) {
+            assert(sodium.crypto_box_multi_open(envelope, r.publicKey, r.secretKey, i).equals(message));
+        });
+    };
+
+    it("should open for every recipient", function (done) {
+        checkEnvelope(sodium.crypto_box_multi_seal(message, publicKeys));
+        checkEnvelope(sodium.crypto_box_multi_seal(message, Buffer.concat(publicKeys), 4));
+        done();
+    });
+
+    it("should find the recipient without an index", function (done) {
+        var envelope = sodium.crypto_box_multi_seal(message, publicKeys);
+        var r = members[37];
+        assert(sodium.crypto_box_multi_open(envelope, r.publicKey, r.secretKey).equals(message));
+
+        var outsider = sodium.crypto_box_keypair();
+        assert.strictEqual(sodium.crypto_box_multi_open(envelope, outsider.publicKey, outsider.secretKey), null);
+        assert.strictEqual(sodium.crypto_box_multi_open(envelope, r.publicKey, r.secretKey, 36), null);
+        done();
+    });
+
+    it("should authenticate the recipient list", function (done) {
+        var envelope = sodium.crypto_box_multi_seal(message, publicKeys);
+        var r = members[0];
+        envelope[sodium.crypto_box_multi_HEADERBYTES + 10 * sodium.crypto_box_multi_WRAPBYTES] ^= 1;
+        assert.strictEqual(sodium.crypto_box_multi_open(envelope, r.publicKey, r.secretKey, 0), null);
+        assert.throws(function () {
+            sodium.crypto_box_multi_open(envelope.slice(0, 100), r.publicKey, r.secretKey);
+        });
+        done();
+    });
+
+    it("should seal on the threadpool", function (done) {
+        sodium.crypto_box_multi_seal_async(message, publicKeys, { threads: 2 }).then(function (envelope) {
+            checkEnvelope(envelope);
+            done();
+        }).catch(done);
+    });
+});
@@ -0,0 +1,58 @@
+"use strict";
+
+var assert = require('assert');
+var crypto = require('crypto');
+var sodium = require('../build/Release/sodium');
+
+// The NaCl style crypto_box/crypto_secretbox output is BOXZEROBYTES zeros
+// followed by the _easy output, so the two APIs must interoperate.
+describe('NaCl box and secretbox layout', function() {
+    var alice = sodium.crypto_box_keypair();
+    var bob = sodium.crypto_box_keypair();
+    var nonce = crypto.randomBytes(sodium.crypto_box_NONCEBYTES);
+    var key = crypto.randomBytes(sodium.crypto_secretbox_KEYBYTES);
+    var zeros = Buffer.alloc(sodium.crypto_box_BOXZEROBYTES);
+
+    [0, 1, 1000, 1024 * 1024].forEach(function(size) {
+        var m = crypto.randomBytes(size);
+
+        it('crypto_box should match crypto_box_easy for ' + size + ' bytes', function(done) {
+            var c = sodium.crypto_box(m, nonce, bob.publicKey, alice.secretKey);
+            var easy = sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+            assert.equal(c.length, size + sodium.crypto_box_ZEROBYTES);
+            assert(c.equals(Buffer.concat([zeros, easy])));
+
+            var k = sodium.crypto_box_beforenm(bob.publicKey, alice.secretKey);
+            assert(sodium.crypto_box_afternm(m, nonce, k).equals(c));
+
+            assert(sodium.crypto_box_open(c, nonce, alice.publicKey, bob.secretKey).equals(m));
+            assert(sodium.crypto_box_open_afternm(c, nonce, k).equals(m));
+            assert(sodium.crypto_box_curve25519xsalsa20poly1305(m, nonce, bob.publicKey, alice.secretKey).equals(c));
+            assert(sodium.crypto_box_curve25519xsalsa20poly1305_open(c, nonce, alice.publicKey, bob.secretKey).equals(m));
+            done();
+        });
+
+        it('crypto_secretbox should match crypto_secretbox_easy for ' + size + ' bytes', function(done) {
+            var c = sodium.crypto_secretbox(m, nonce, key);
+            var easy = sodium.crypto_secretbox_easy(m, nonce, key);
+            assert(c.equals(Buffer.concat([zeros, easy])));
+            assert(sodium.crypto_secretbox_open(c, nonce, key).equals(m));
+            assert(sodium.crypto_secretbox_xsalsa20poly1305(m, nonce, key).equals(c));
+            assert(sodium.crypto_secretbox_xsalsa20poly1305_open(c, nonce, key).equals(m));
+            done();
+        });
+    });
+
+    it('should return null for forged or short cipher texts', function(done) {
+        var c = sodium.crypto_box(Buffer.from('hello'), nonce, bob.publicKey, alice.secretKey);
+        c[c.length - 1] ^= 1;
+        assert.strictEqual(sodium.crypto_box_open(c, nonce, alice.publicKey, bob.secretKey), null);
+        assert.strictEqual(sodium.crypto_box_open(Buffer.alloc(20), nonce, alice.publicKey, bob.secretKey), null);
+
+        var s = sodium.crypto_secretbox(Buffer.from('hello'), nonce, key);
+        s[20] ^= 1;
+        assert.strictEqual(sodium.crypto_secretbox_open(s, nonce, key), null);
+        assert.strictEqual(sodium.crypto_secretbox_open(Buffer.alloc(20), nonce, key), null);
+        done();
+    });
+});
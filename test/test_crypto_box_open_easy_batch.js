@@ -0,0 +1,76 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_box_open_easy_batch", function () {
+    var recipient = sodium.crypto_box_keypair();
+    var senders = [];
+    for (var i = 0; i < 8; i++) {
+        senders.push(sodium.crypto_box_keypair());
+    }
+
+    var messages = [], boxes = [], nonces = [], publicKeys = [];
+    for (var i = 0; i < 300; i++) {
+        var sender = senders[i % senders.length];
+        var nonce = sodium.randombytes_buf(sodium.crypto_box_NONCEBYTES);
+        messages.push(Buffer.from("message " + i + " " + "x".repeat(i % 40)));
+        boxes.push(sodium.crypto_box_easy(messages[i], nonce, recipient.publicKey, sender.secretKey));
+        nonces.push(nonce);
+        publicKeys.push(sender.publicKey);
+    }
+    // A forged box and one from the wrong sender
+    boxes[10][0] ^= 1;
+    publicKeys[20] = senders[0].publicKey;
+    var lengths = boxes.map(function (c) { return c.length; });
+
+    var opened = function (status, i) {
+        return (status[i >> 3] & (1 << (i & 7))) != 0;
+    };
+
+    var check = function (r) {
+        var offset = 0;
+        messages.forEach(function (m, i) {
+            var p = r.plainTexts.subarray(offset, offset + m.length);
+            offset += m.length;
+            if (i == 10 || i == 20) {
+                assert(!opened(r.status, i));
+                assert(sodium.sodium_is_zero(p));
+            } else {
+                assert(opened(r.status, i));
+                assert(p.equals(m));
+            }
+        });
+        assert.equal(offset, r.plainTexts.length);
+    };
+
+    it("should open every box that verifies", function () {
+        check(sodium.crypto_box_open_easy_batch(Buffer.concat(boxes), lengths, Buffer.concat(nonces),
+            publicKeys, recipient.secretKey, 4));
+    });
+
+    it("should go through the shared key cache", function () {
+        sodium.crypto_box_cache_enable(16);
+        try {
+            check(sodium.crypto_box_open_easy_batch(Buffer.concat(boxes), lengths, nonces,
+                Buffer.concat(publicKeys), recipient.secretKey));
+            assert(sodium.crypto_box_cache_stats().misses <= senders.length);
+        } finally {
+            sodium.crypto_box_cache_disable();
+        }
+    });
+
+    it("should run on the threadpool", function () {
+        return sodium.crypto_box_open_easy_batch_async(Buffer.concat(boxes), lengths, nonces,
+            publicKeys, recipient.secretKey, 2).then(check);
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () {
+            sodium.crypto_box_open_easy_batch(Buffer.concat(boxes), lengths, nonces.slice(1),
+                publicKeys, recipient.secretKey);
+        });
+        assert.throws(function () {
+            sodium.crypto_box_open_easy_batch(Buffer.concat(boxes), lengths, nonces,
+                publicKeys, Buffer.alloc(8));
+        });
+    });
+});
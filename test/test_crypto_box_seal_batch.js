@@ -0,0 +1,90 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_box_seal async and batch", function () {
+    var message = Buffer.from("notification payload");
+    var recipients = [];
+    for (var i = 0; i < 40; i++) {
+        recipients.push(sodium.crypto_box_keypair());
+    }
+    var publicKeys = recipients.map(function (r) { return r.publicKey; });
+    var stride = message.length + sodium.crypto_box_SEALBYTES;
+
+    var checkSealed = function (c) {
+        assert.strictEqual(c.length, recipients.length * stride);
+        recipients.forEach(function (r, i) {
+            var box = c.slice(i * stride, (i + 1) * stride);
+            assert(sodium.crypto_box_seal_open(box, r.publicKey, r.secretKey).equals(message));
+        });
+    };
+
+    it("crypto_box_seal_async should open with crypto_box_seal_open", function () {
+        var r = recipients[0];
+        return sodium.crypto_box_seal_async(message, r.publicKey).then(function (c) {
+            assert(sodium.crypto_box_seal_open(c, r.publicKey, r.secretKey).equals(message));
+            return sodium.crypto_box_seal_open_async(c, r.publicKey, r.secretKey);
+        }).then(function (m) {
+            assert(m.equals(message));
+        });
+    });
+
+    it("crypto_box_seal_open_async should resolve to null on forgery", function (done) {
+        var r = recipients[0];
+        var c = sodium.crypto_box_seal(message, r.publicKey);
+        c[c.length - 1] ^= 1;
+        sodium.crypto_box_seal_open_async(c, r.publicKey, r.secretKey, function (err, m) {
+            assert.ifError(err);
+            assert.strictEqual(m, null);
+            done();
+        });
+    });
+
+    it("crypto_box_seal_batch should seal to every recipient", function (done) {
+        checkSealed(sodium.crypto_box_seal_batch(message, publicKeys));
+        checkSealed(sodium.crypto_box_seal_batch(message, Buffer.concat(publicKeys), 4));
+        assert.strictEqual(sodium.crypto_box_seal_batch(message, []).length, 0);
+        done();
+    });
+
+    it("crypto_box_seal_batch should reject bad public keys", function (done) {
+        assert.throws(function () {
+            sodium.crypto_box_seal_batch(message, [Buffer.alloc(3)]);
+        });
+        assert.throws(function () {
+            sodium.crypto_box_seal_batch(message, Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES + 1));
+        });
+        done();
+    });
+
+    it("crypto_box_seal_batch_async should seal to every recipient", function () {
+        return sodium.crypto_box_seal_batch_async(message, publicKeys, 4).then(checkSealed);
+    });
+
+    it("crypto_box_seal_open_batch should open boxes for one recipient", function (done) {
+        var r = recipients[1];
+        var messages = [Buffer.from("a"), Buffer.alloc(0), Buffer.from("third message")];
+        var boxes = messages.map(function (m) { return sodium.crypto_box_seal(m, r.publicKey); });
+
+        var m = sodium.crypto_box_seal_open_batch(boxes, r.publicKey, r.secretKey, 2);
+        assert(m.equals(Buffer.concat(messages)));
+
+        boxes[2][0] ^= 1;
+        assert.strictEqual(sodium.crypto_box_seal_open_batch(boxes, r.publicKey, r.secretKey), null);
+        assert.throws(function () {
+            sodium.crypto_box_seal_open_batch([Buffer.alloc(4)], r.publicKey, r.secretKey);
+        });
+        done();
+    });
+
+    it("crypto_box_seal_open_batch_async should open boxes for one recipient", function (done) {
+        var r = recipients[2];
+        var messages = [Buffer.from("one"), Buffer.from("two")];
+        var boxes = messages.map(function (m) { return sodium.crypto_box_seal(m, r.publicKey); });
+
+        sodium.crypto_box_seal_open_batch_async(boxes, r.publicKey, r.secretKey, function (err, m) {
+            assert.ifError(err);
+            assert(m.equals(Buffer.concat(messages)));
+            done();
+        });
+    });
+});
@@ -0,0 +1,116 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var Box = require('../lib/box');
+
+describe("crypto_box_sign_easy", function () {
+    var alice = sodium.crypto_box_keypair();
+    var bob = sodium.crypto_box_keypair();
+    var aliceSign = sodium.crypto_sign_keypair();
+    var eveSign = sodium.crypto_sign_keypair();
+    var nonce = Buffer.alloc(sodium.crypto_box_NONCEBYTES, 7);
+    var overhead = sodium.crypto_box_MACBYTES + sodium.crypto_sign_BYTES;
+
+    var random = function (n) {
+        var b = Buffer.alloc(n);
+        sodium.randombytes_buf(b);
+        return b;
+    };
+
+    var opened = function (status, i) {
+        return (status[i >> 3] & (1 << (i & 7))) != 0;
+    };
+
+    it("should box what signing then boxing boxes", function () {
+        [0, 1, 100, 70000].forEach(function (n) {
+            var m = random(n);
+            var c = sodium.crypto_box_sign_easy(m, nonce, bob.publicKey, alice.secretKey, aliceSign.secretKey);
+            assert.equal(c.length, n + overhead);
+
+            var sig = sodium.crypto_sign_detached(m, aliceSign.secretKey);
+            var two = sodium.crypto_box_easy(Buffer.concat([sig, m]), nonce, bob.publicKey, alice.secretKey);
+            assert(c.equals(two));
+
+            var p = sodium.crypto_box_open_verify_easy(c, nonce, alice.publicKey, bob.secretKey, aliceSign.publicKey);
+            assert(p.equals(m));
+        });
+    });
+
+    it("should refuse a changed box or another signer", function () {
+        var m = Buffer.from("pay 10 to bob");
+        var c = sodium.crypto_box_sign_easy(m, nonce, bob.publicKey, alice.secretKey, aliceSign.secretKey);
+        assert.strictEqual(sodium.crypto_box_open_verify_easy(c, nonce, alice.publicKey, bob.secretKey, eveSign.publicKey), null);
+
+        var forged = Buffer.from(c);
+        forged[forged.length - 1] ^= 1;
+        assert.strictEqual(sodium.crypto_box_open_verify_easy(forged, nonce, alice.publicKey, bob.secretKey, aliceSign.publicKey), null);
+        assert.strictEqual(sodium.crypto_box_open_verify_easy(c.subarray(0, overhead - 1), nonce,
+            alice.publicKey, bob.secretKey, aliceSign.publicKey), null);
+
+        // A valid box of a message that is not signed by aliceSign
+        var unsigned = sodium.crypto_box_easy(Buffer.concat([Buffer.alloc(64), m]), nonce, bob.publicKey, alice.secretKey);
+        assert.strictEqual(sodium.crypto_box_open_verify_easy(unsigned, nonce, alice.publicKey, bob.secretKey, aliceSign.publicKey), null);
+    });
+
+    it("should run on the threadpool", function () {
+        var m = random(100000);
+        return sodium.crypto_box_sign_easy_async(m, nonce, bob.publicKey, alice.secretKey, aliceSign.secretKey)
+            .then(function (c) {
+                return sodium.crypto_box_open_verify_easy_async(c, nonce, alice.publicKey, bob.secretKey, aliceSign.publicKey);
+            })
+            .then(function (p) {
+                assert(p.equals(m));
+            });
+    });
+
+    it("should sign and open batches", function () {
+        var messages = [], nonces = [], recipients = [], senders = [], signers = [];
+        for (var i = 0; i < 50; i++) {
+            messages.push(Buffer.from("message " + i + " " + "x".repeat(i % 13)));
+            nonces.push(random(sodium.crypto_box_NONCEBYTES));
+            recipients.push(bob.publicKey);
+            senders.push(alice.publicKey);
+            signers.push(aliceSign.publicKey);
+        }
+        var lengths = messages.map(function (m) { return m.length; });
+        var c = sodium.crypto_box_sign_easy_batch(Buffer.concat(messages), lengths, nonces, recipients,
+            alice.secretKey, aliceSign.secretKey, 4);
+        var boxLengths = lengths.map(function (n) { return n + overhead; });
+
+        var offset = 0;
+        messages.forEach(function (m, i) {
+            var one = sodium.crypto_box_sign_easy(m, nonces[i], bob.publicKey, alice.secretKey, aliceSign.secretKey);
+            assert(c.subarray(offset, offset + one.length).equals(one));
+            offset += one.length;
+        });
+        assert.equal(offset, c.length);
+
+        c[boxLengths[0] + 3] ^= 1;
+        signers[7] = eveSign.publicKey;
+        var check = function (r) {
+            var offset = 0;
+            messages.forEach(function (m, i) {
+                var p = r.plainTexts.subarray(offset, offset + m.length);
+                offset += m.length;
+                if (i == 1 || i == 7) {
+                    assert(!opened(r.status, i));
+                    assert(sodium.sodium_is_zero(p));
+                } else {
+                    assert(opened(r.status, i));
+                    assert(p.equals(m));
+                }
+            });
+        };
+        check(sodium.crypto_box_open_verify_easy_batch(c, boxLengths, Buffer.concat(nonces), senders,
+            bob.secretKey, signers, 3));
+        return sodium.crypto_box_open_verify_easy_batch_async(c, boxLengths, nonces, senders,
+            bob.secretKey, Buffer.concat(signers)).then(check);
+    });
+
+    it("should back Box.signAndBox and Box.openAndVerify", function () {
+        var sender = new Box(bob.publicKey, alice.secretKey);
+        var receiver = new Box(alice.publicKey, bob.secretKey);
+        var cipherBox = sender.signAndBox("hello bob", aliceSign.secretKey, 'utf8');
+        assert.equal(receiver.openAndVerify(cipherBox, aliceSign.publicKey, 'utf8'), "hello bob");
+        assert.strictEqual(receiver.openAndVerify(cipherBox, eveSign.publicKey), undefined);
+    });
+});
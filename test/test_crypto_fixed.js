@@ -0,0 +1,80 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var random = function (n) {
+    var b = Buffer.alloc(n);
+    sodium.randombytes_buf(b);
+    return b;
+};
+
+describe("Fixed size bindings", function () {
+    var ALGOS = ['chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'];
+    if (sodium.crypto_aead_aes256gcm_is_available()) {
+        ALGOS.push('aes256gcm');
+    }
+
+    ALGOS.forEach(function (algo) {
+        var prefix = 'crypto_aead_' + algo;
+        var key = random(sodium[prefix + '_KEYBYTES']);
+        var nonce = random(sodium[prefix + '_NPUBBYTES']);
+        var abytes = sodium[prefix + '_ABYTES'];
+
+        [32, 64].forEach(function (size) {
+            it(algo + " should match the generic bindings for " + size + " bytes", function () {
+                var m = random(size);
+                var ad = Buffer.from('key id');
+                [ad, null].forEach(function (a) {
+                    var c = sodium[prefix + '_encrypt_' + size](m, a, nonce, key);
+                    assert(c.equals(sodium[prefix + '_encrypt'](m, a, nonce, key)));
+                    assert(sodium[prefix + '_decrypt_' + size](c, a, nonce, key).equals(m));
+                    assert(sodium[prefix + '_decrypt'](c, a, nonce, key).equals(m));
+                });
+
+                var c = sodium[prefix + '_encrypt_' + size](m, ad, nonce, key);
+                c[0] ^= 1;
+                assert.strictEqual(sodium[prefix + '_decrypt_' + size](c, ad, nonce, key), null);
+                c[0] ^= 1;
+                assert.strictEqual(sodium[prefix + '_decrypt_' + size](c, null, nonce, key), null);
+
+                assert.throws(function () {
+                    sodium[prefix + '_encrypt_' + size](Buffer.alloc(size + 1), ad, nonce, key);
+                }, /message must be/);
+                assert.throws(function () {
+                    sodium[prefix + '_decrypt_' + size](Buffer.alloc(size), ad, nonce, key);
+                }, new RegExp('cipher text must be ' + (size + abytes) + ' bytes'));
+                assert.throws(function () {
+                    sodium[prefix + '_encrypt_' + size](m, ad, nonce, Buffer.alloc(8));
+                }, /key must be/);
+            });
+        });
+    });
+
+    [32, 64].forEach(function (size) {
+        it("crypto_secretbox_easy_" + size + " should match crypto_secretbox_easy", function () {
+            var key = random(sodium.crypto_secretbox_KEYBYTES);
+            var nonce = random(sodium.crypto_secretbox_NONCEBYTES);
+            var m = random(size);
+
+            var c = sodium['crypto_secretbox_easy_' + size](m, nonce, key);
+            assert(c.equals(sodium.crypto_secretbox_easy(m, nonce, key)));
+            assert(sodium['crypto_secretbox_open_easy_' + size](c, nonce, key).equals(m));
+
+            c[c.length - 1] ^= 1;
+            assert.strictEqual(sodium['crypto_secretbox_open_easy_' + size](c, nonce, key), null);
+            assert.throws(function () {
+                sodium['crypto_secretbox_easy_' + size](Buffer.alloc(size - 1), nonce, key);
+            }, /message must be/);
+            assert.throws(function () {
+                sodium['crypto_secretbox_open_easy_' + size](c, nonce);
+            }, /expected 3 arguments/);
+        });
+    });
+
+    it("should take other byte views", function () {
+        var key = new Uint8Array(sodium.crypto_secretbox_KEYBYTES);
+        var nonce = new Uint8Array(sodium.crypto_secretbox_NONCEBYTES);
+        var m = new Uint8Array(32).fill(7);
+        var c = sodium.crypto_secretbox_easy_32(m, nonce, key);
+        assert(sodium.crypto_secretbox_open_easy_32(c, nonce, key).equals(Buffer.from(m)));
+    });
+});
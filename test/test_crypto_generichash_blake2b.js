@@ -931,4 +931,120 @@ describe('Generic Hash', function() {
         });
         done();
     });
+
+    describe('crypto_generichash_blake2b_many', function() {
+        var data = Buffer.alloc(10000);
+        for (var i = 0; i < data.length; i++) {
+            data[i] = i & 0xff;
+        }
+
+        function expected(size, lengths, key) {
+            var out = [], offset = 0;
+            lengths.forEach(function(l) {
+                out.push(sodium.crypto_generichash_blake2b(size, data.slice(offset, offset + l), key || null));
+                offset += l;
+            });
+            return Buffer.concat(out);
+        }
+
+        it('should hash chunks given by a length table', function(done) {
+            var lengths = [0, 1, 4096, 5000, 903];
+            var hashes = sodium.crypto_generichash_blake2b_many(32, data, lengths);
+            assert(hashes.equals(expected(32, lengths)));
+            assert(sodium.crypto_generichash_blake2b_many(32, data, new Uint32Array(lengths)).equals(hashes));
+            done();
+        });
+
+        it('should cut chunks of a fixed size, with a key and threads', function(done) {
+            var key = Buffer.alloc(32, 3);
+            var hashes = sodium.crypto_generichash_blake2b_many(16, data, 4096, key, 4);
+            assert.equal(hashes.length, 3 * 16);
+            assert(hashes.equals(expected(16, [4096, 4096, 1808], key)));
+            assert(sodium.crypto_generichash_many(16, data, 4096, key).equals(hashes));
+            done();
+        });
+
+        it('should check the lengths', function(done) {
+            assert.throws(function() { sodium.crypto_generichash_blake2b_many(32, data, [1, 2]); });
+            assert.throws(function() { sodium.crypto_generichash_blake2b_many(32, data, [20000]); });
+            assert.throws(function() { sodium.crypto_generichash_blake2b_many(32, data, 0); });
+            assert.throws(function() { sodium.crypto_generichash_blake2b_many(32, data, 'x'); });
+            assert.throws(function() { sodium.crypto_generichash_blake2b_many(8, data, 4096); });
+            done();
+        });
+
+        it('should hash on the threadpool', function(done) {
+            sodium.crypto_generichash_blake2b_many_async(32, data, 1000).then(function(hashes) {
+                assert(hashes.equals(expected(32, [1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000, 1000])));
+                sodium.crypto_generichash_many_async(32, data, [10000], null, function(err, h) {
+                    assert.ifError(err);
+                    assert(h.equals(expected(32, [10000])));
+                    done();
+                });
+            }).catch(done);
+        });
+    });
+
+    describe('crypto_generichash_blake2b_tree', function() {
+        var key = Buffer.alloc(32, 9);
+        var data = Buffer.alloc(5 * 1024 + 300);
+        for (var i = 0; i < data.length; i++) {
+            data[i] = (i * 7) & 0xff;
+        }
+
+        function salt(a, b) {
+            var s = Buffer.alloc(16);
+            s.writeUInt32LE(a, 0);
+            s.writeUInt32LE(b, 8);
+            return s;
+        }
+
+        it('should match the documented construction', function(done) {
+            var leafSize = 2048, leaves = [];
+            for (var i = 0; i * leafSize < data.length; i++) {
+                var leaf = Buffer.alloc(64);
+                sodium.crypto_generichash_blake2b_salt_personal(leaf, data.slice(i * leafSize, (i + 1) * leafSize),
+                    key, salt(i, leafSize), Buffer.from('node-sodium-leaf'));
+                leaves.push(leaf);
+            }
+            var root = Buffer.alloc(32);
+            sodium.crypto_generichash_blake2b_salt_personal(root, Buffer.concat(leaves),
+                key, salt(leaves.length, leafSize), Buffer.from('node-sodium-root'));
+
+            assert(sodium.crypto_generichash_blake2b_tree(32, data, key, leafSize).equals(root));
+            assert(sodium.crypto_generichash_blake2b_tree(32, data, key, leafSize, 4).equals(root));
+            assert(!root.equals(sodium.crypto_generichash_blake2b(32, data, key)));
+            done();
+        });
+
+        it('should give the same root when hashed part by part', function(done) {
+            var leafSize = 1024;
+            var whole = sodium.crypto_generichash_blake2b_tree(64, data, null, leafSize);
+            var a = sodium.crypto_generichash_blake2b_tree_leaves(data.slice(0, 3072), 0, null, leafSize);
+            var b = sodium.crypto_generichash_blake2b_tree_leaves(data.slice(3072), 3, null, leafSize);
+            assert.equal(a.length, 3 * sodium.crypto_generichash_blake2b_TREE_LEAFBYTES);
+            var root = sodium.crypto_generichash_blake2b_tree_root(64, Buffer.concat([a, b]), null, leafSize);
+            assert(root.equals(whole));
+            assert(!whole.equals(sodium.crypto_generichash_blake2b_tree(64, data, null, 2048)));
+            assert(sodium.crypto_generichash_blake2b_tree(32, data)
+                .equals(sodium.crypto_generichash_blake2b_tree(32, data, null, sodium.crypto_generichash_blake2b_TREE_LEAFSIZE)));
+            assert.equal(sodium.crypto_generichash_blake2b_tree(32, Buffer.alloc(0)).length, 32);
+            done();
+        });
+
+        it('should check its arguments', function(done) {
+            assert.throws(function() { sodium.crypto_generichash_blake2b_tree(32, data, null, 1000); });
+            assert.throws(function() { sodium.crypto_generichash_blake2b_tree(8, data); });
+            assert.throws(function() { sodium.crypto_generichash_blake2b_tree_root(32, Buffer.alloc(63)); });
+            done();
+        });
+
+        it('should hash on the threadpool', function(done) {
+            var expected = sodium.crypto_generichash_blake2b_tree(32, data, key, 1024);
+            sodium.crypto_generichash_blake2b_tree_async(32, data, key, 1024, 2).then(function(hash) {
+                assert(hash.equals(expected));
+                done();
+            }).catch(done);
+        });
+    });
 });
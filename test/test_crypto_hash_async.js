@@ -0,0 +1,80 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var small = Buffer.from('a short message', 'utf8');
+var large = Buffer.alloc(1024 * 1024, 0x5a);
+
+var hashes = {
+    crypto_hash_sha256: function(m) { return [m]; },
+    crypto_hash_sha512: function(m) { return [m]; },
+    crypto_generichash: function(m) { return [64, m, Buffer.alloc(32, 1)]; },
+    crypto_auth_hmacsha256: function(m) { return [m, Buffer.alloc(sodium.crypto_auth_hmacsha256_KEYBYTES, 2)]; },
+    crypto_auth_hmacsha512: function(m) { return [m, Buffer.alloc(sodium.crypto_auth_hmacsha512_KEYBYTES, 3)]; },
+    crypto_auth_hmacsha512256: function(m) { return [m, Buffer.alloc(sodium.crypto_auth_hmacsha512256_KEYBYTES, 4)]; }
+};
+
+describe('Hash and MAC async', function() {
+    var threshold = sodium.sodium_async_threshold();
+
+    after(function() {
+        sodium.sodium_async_threshold(threshold);
+    });
+
+    it('sodium_async_threshold should get and set the threshold', function(done) {
+        assert.equal(typeof threshold, 'number');
+        assert.equal(sodium.sodium_async_threshold(1000), 1000);
+        assert.equal(sodium.sodium_async_threshold(), 1000);
+        sodium.sodium_async_threshold(threshold);
+        done();
+    });
+
+    Object.keys(hashes).forEach(function(name) {
+        [small, large].forEach(function(m) {
+            it(name + '_async should match the sync version for ' + m.length + ' bytes', function(done) {
+                var args = hashes[name](m);
+                var expected = sodium[name].apply(null, args);
+                var p = sodium[name + '_async'].apply(null, args);
+                assert(p instanceof Promise);
+                p.then(function(out) {
+                    assert(out.equals(expected));
+                    done();
+                }).catch(done);
+            });
+        });
+
+        it(name + '_async should call a callback', function(done) {
+            var args = hashes[name](small);
+            var expected = sodium[name].apply(null, args);
+            var returned = false;
+            args.push(function(err, out) {
+                assert.ifError(err);
+                assert(returned);
+                assert(out.equals(expected));
+                done();
+            });
+            assert.strictEqual(sodium[name + '_async'].apply(null, args), undefined);
+            returned = true;
+        });
+    });
+
+    it('should use the threadpool when the threshold is 0', function(done) {
+        sodium.sodium_async_threshold(0);
+        sodium.crypto_hash_sha256_async(small).then(function(out) {
+            sodium.sodium_async_threshold(threshold);
+            assert(out.equals(sodium.crypto_hash_sha256(small)));
+            done();
+        }).catch(done);
+    });
+
+    it('should throw on bad arguments before queueing', function(done) {
+        assert.throws(function() {
+            sodium.crypto_hash_sha512_async('not a buffer');
+        });
+        assert.throws(function() {
+            sodium.crypto_auth_hmacsha256_async(small, Buffer.alloc(3));
+        });
+        done();
+    });
+});
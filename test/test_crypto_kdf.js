@@ -0,0 +1,128 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_kdf", function () {
+    var key = sodium.crypto_kdf_keygen();
+
+    it("should derive distinct subkeys", function (done) {
+        assert.strictEqual(key.length, sodium.crypto_kdf_KEYBYTES);
+        var a = sodium.crypto_kdf_derive_from_key(32, 1, "Examples", key);
+        var b = sodium.crypto_kdf_derive_from_key(32, 2, "Examples", key);
+        var c = sodium.crypto_kdf_derive_from_key(32, 1, Buffer.from("Examples"), key);
+        var d = sodium.crypto_kdf_derive_from_key(32, 1, "Examplez", key);
+
+        assert.strictEqual(a.length, 32);
+        assert(!a.equals(b));
+        assert(a.equals(c));
+        assert(!a.equals(d));
+        assert(a.equals(sodium.crypto_kdf_blake2b_derive_from_key(32, 1, "Examples", key)));
+        done();
+    });
+
+    it("should match a known answer", function (done) {
+        var master = Buffer.alloc(sodium.crypto_kdf_KEYBYTES);
+        for (var i = 0; i < master.length; i++) {
+            master[i] = i;
+        }
+        // libsodium test/default/kdf.c, first subkey of "KDF test"
+        var subkey = sodium.crypto_kdf_derive_from_key(sodium.crypto_kdf_BYTES_MAX, 0, "KDF test", master);
+        assert.strictEqual(subkey.toString('hex'),
+            'a0c724404728c8bb95e5433eb6a9716171144d61efb23e74b873fcbeda51d807' +
+            '1b5d70aae12066dfc94ce943f145aa176c055040c3dd73b0a15e36254d450614');
+        done();
+    });
+
+    it("crypto_kdf_derive_batch should match derive_from_key", function (done) {
+        var first = 4294967290;     // crosses 2^32
+        var batch = sodium.crypto_kdf_derive_batch(16, first, 3000, "Tenants_", key, 4);
+        assert.strictEqual(batch.length, 3000 * 16);
+        [0, 5, 6, 1999, 2999].forEach(function (i) {
+            var subkey = sodium.crypto_kdf_derive_from_key(16, first + i, "Tenants_", key);
+            assert(batch.slice(i * 16, (i + 1) * 16).equals(subkey));
+        });
+        assert.strictEqual(sodium.crypto_kdf_derive_batch(16, 0, 0, "Tenants_", key).length, 0);
+        done();
+    });
+
+    it("should check parameters", function (done) {
+        assert.throws(function () {
+            sodium.crypto_kdf_derive_from_key(8, 1, "Examples", key);
+        });
+        assert.throws(function () {
+            sodium.crypto_kdf_derive_from_key(32, 1, "short", key);
+        });
+        assert.throws(function () {
+            sodium.crypto_kdf_derive_from_key(32, -1, "Examples", key);
+        });
+        assert.throws(function () {
+            sodium.crypto_kdf_derive_from_key(32, 1.5, "Examples", key);
+        });
+        assert.throws(function () {
+            sodium.crypto_kdf_derive_batch(32, Number.MAX_SAFE_INTEGER, 2, "Examples", key);
+        });
+        assert.strictEqual(sodium.crypto_kdf_PRIMITIVE, "blake2b");
+        done();
+    });
+});
+
+describe("crypto_kdf_hkdf", function () {
+    var crypto = require('crypto');
+
+    // RFC 5869 test case 1
+    var ikm = Buffer.alloc(22, 0x0b);
+    var salt = Buffer.from('000102030405060708090a0b0c', 'hex');
+    var info = Buffer.from('f0f1f2f3f4f5f6f7f8f9', 'hex');
+    var prk = '077709362c2e32df0ddc3f0dc47bba6390b6c73bb50f9c3122ec844ad7c2b3e5';
+    var okm = '3cb25f25faacd57a90434f64d0362f2a2d2d0a90cf1a5a4c5db02d56ecc4c5bf34007208d5b887185865';
+
+    it("should match the RFC 5869 test vectors", function (done) {
+        assert.strictEqual(sodium.crypto_kdf_hkdf_sha256_extract(ikm, salt).toString('hex'), prk);
+        assert.strictEqual(sodium.crypto_kdf_hkdf_sha256_expand(Buffer.from(prk, 'hex'), info, 42).toString('hex'), okm);
+        assert.strictEqual(sodium.crypto_kdf_hkdf_sha256(ikm, salt, [{ info: info, length: 42 }]).toString('hex'), okm);
+        done();
+    });
+
+    it("should derive several outputs in one call", function (done) {
+        ['sha256', 'sha512'].forEach(function (hash) {
+            var outputs = [
+                { info: 'client write key', length: 32 },
+                { info: Buffer.from('server write key'), length: 100 },
+                { length: 12 }
+            ];
+            [salt, null].forEach(function (s) {
+                var out = sodium['crypto_kdf_hkdf_' + hash](ikm, s, outputs);
+                var offset = 0;
+                outputs.forEach(function (o) {
+                    var expected = Buffer.from(crypto.hkdfSync(hash, ikm, s || Buffer.alloc(0), o.info || '', o.length));
+                    assert(out.slice(offset, offset + o.length).equals(expected));
+                    offset += o.length;
+                });
+                assert.strictEqual(out.length, offset);
+            });
+        });
+        done();
+    });
+
+    it("should derive the same outputs for many salts", function (done) {
+        var salts = [];
+        for (var i = 0; i < 600; i++) {
+            salts.push(Buffer.from('salt ' + i));
+        }
+        var outputs = [{ info: 'a', length: 16 }, { info: 'b', length: 40 }];
+        var out = sodium.crypto_kdf_hkdf_sha512_batch(ikm, salts, outputs, 4);
+        assert.strictEqual(out.length, 600 * 56);
+        [0, 1, 599].forEach(function (i) {
+            assert(out.slice(i * 56, (i + 1) * 56).equals(sodium.crypto_kdf_hkdf_sha512(ikm, salts[i], outputs)));
+        });
+        done();
+    });
+
+    it("should reject bad outputs", function (done) {
+        assert.throws(function () { sodium.crypto_kdf_hkdf_sha256(ikm, salt, [{ info: 'x', length: 0 }]); });
+        assert.throws(function () { sodium.crypto_kdf_hkdf_sha256(ikm, salt, [{ info: 'x', length: 255 * 32 + 1 }]); });
+        assert.throws(function () { sodium.crypto_kdf_hkdf_sha256(ikm, salt, [{ info: 3, length: 32 }]); });
+        assert.throws(function () { sodium.crypto_kdf_hkdf_sha256(ikm, salt, { info: 'x', length: 32 }); });
+        assert.throws(function () { sodium.crypto_kdf_hkdf_sha256_expand(Buffer.alloc(31), info, 32); });
+        done();
+    });
+});
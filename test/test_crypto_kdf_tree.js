@@ -0,0 +1,94 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("KdfTree", function () {
+    var master = Buffer.alloc(sodium.crypto_generichash_KEYBYTES);
+    sodium.randombytes_buf(master);
+
+    // The derivation done by hand, one keyed hash per level
+    var chained = function (path, bytes) {
+        var key = master;
+        path.forEach(function (label, i) {
+            var last = i == path.length - 1;
+            key = sodium.crypto_generichash(last ? bytes || 32 : 32, Buffer.from(label), key);
+        });
+        return key;
+    };
+
+    it("should match chained crypto_generichash calls", function () {
+        var tree = new sodium.KdfTree(master);
+        var paths = [['acme'], ['acme', 'billing'], ['acme', 'billing', 'invoice-42'],
+                     ['acme', 'billing', 'invoice-43'], [Buffer.from([0, 1, 2]), '', 'x']];
+        paths.forEach(function (path) {
+            assert(tree.derive(path).equals(chained(path)));
+            assert(tree.derive(path).equals(chained(path)));
+        });
+
+        var short = new sodium.KdfTree(master, { bytes: 16, capacity: 0 });
+        assert(short.derive(['a', 'b']).equals(chained(['a', 'b'], 16)));
+        assert.strictEqual(short.stats().size, 0);
+        tree.dispose();
+        short.dispose();
+    });
+
+    it("should cost one hash per leaf once the parent is cached", function () {
+        var tree = new sodium.KdfTree(master, { capacity: 16 });
+        tree.derive(['t1', 'p1', 'o1']);
+        var stats = tree.stats();
+        assert.strictEqual(stats.derived, 2);
+        assert.strictEqual(stats.hits, 0);
+
+        tree.derive(['t1', 'p1', 'o2']);
+        tree.derive(['t1', 'p2', 'o1']);
+        stats = tree.stats();
+        assert.strictEqual(stats.hits, 1);
+        assert.strictEqual(stats.derived, 3);
+        assert.strictEqual(stats.size, 3);
+
+        tree.clear();
+        assert.strictEqual(tree.stats().size, 0);
+        assert(tree.derive(['t1', 'p1', 'o1']).equals(chained(['t1', 'p1', 'o1'])));
+        tree.dispose();
+        assert.throws(function () { tree.derive(['t1']); }, /disposed/);
+    });
+
+    it("should evict the least recently used nodes", function () {
+        var tree = new sodium.KdfTree(master, { capacity: 2 });
+        tree.derive(['a', 'x']);
+        tree.derive(['b', 'x']);
+        tree.derive(['a', 'y']);
+        tree.derive(['c', 'x']);
+        var stats = tree.stats();
+        assert.strictEqual(stats.size, 2);
+        assert.strictEqual(stats.evictions, 1);
+        tree.derive(['a', 'z']);
+        assert.strictEqual(tree.stats().hits, stats.hits + 1);
+        tree.dispose();
+    });
+
+    it("should derive batches", function () {
+        var tree = new sodium.KdfTree(master, { capacity: 64 });
+        var paths = [];
+        for (var i = 0; i < 500; i++) {
+            paths.push(['tenant' + (i % 5), 'project' + (i % 7), 'object' + i]);
+        }
+        var keys = tree.deriveBatch(paths, 4);
+        assert.equal(keys.length, paths.length * 32);
+        paths.forEach(function (path, i) {
+            assert(keys.subarray(i * 32, i * 32 + 32).equals(chained(path)));
+        });
+        // 40 inner nodes, each derived at most once per thread
+        assert(tree.stats().derived <= 4 * 40);
+        tree.dispose();
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () { new sodium.KdfTree(Buffer.alloc(8)); });
+        assert.throws(function () { new sodium.KdfTree(master, { bytes: 8 }); });
+        var tree = new sodium.KdfTree(master);
+        assert.throws(function () { tree.derive([]); }, /1 to 32 labels/);
+        assert.throws(function () { tree.derive('acme'); }, /array of labels/);
+        assert.throws(function () { tree.deriveBatch([['a'], [42]]); }, /paths\[1\]/);
+        tree.dispose();
+    });
+});
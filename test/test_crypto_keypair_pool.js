@@ -0,0 +1,81 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+// The refill thread runs in the background; poll until the stock is full
+function whenFull(kind, done) {
+    var stats = sodium.crypto_keypair_pool_stats()[kind];
+    if( stats.size === stats.capacity ) {
+        return done();
+    }
+    setTimeout(function () { whenFull(kind, done); }, 5);
+}
+
+describe("crypto_keypair_pool", function () {
+    after(function () {
+        sodium.crypto_keypair_pool_disable();
+    });
+
+    it("should be disabled by default", function (done) {
+        var stats = sodium.crypto_keypair_pool_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.strictEqual(stats.x25519.capacity, 0);
+        done();
+    });
+
+    it("should fill the stocks in the background", function (done) {
+        sodium.crypto_keypair_pool_enable(8, 4);
+        whenFull('x25519', function () {
+            whenFull('ed25519', function () {
+                var stats = sodium.crypto_keypair_pool_stats();
+                assert.strictEqual(stats.enabled, true);
+                assert.strictEqual(stats.generated, 12);
+                done();
+            });
+        });
+    });
+
+    it("should hand out valid, distinct key pairs", function (done) {
+        var a = sodium.crypto_box_keypair();
+        var b = sodium.crypto_kx_keypair();
+        assert(!a.publicKey.equals(b.publicKey));
+        assert(sodium.crypto_scalarmult_base(a.secretKey).equals(a.publicKey));
+        assert(sodium.crypto_scalarmult_base(b.secretKey).equals(b.publicKey));
+
+        var s = sodium.crypto_sign_keypair();
+        assert(sodium.crypto_sign_ed25519_sk_to_pk(s.secretKey).equals(s.publicKey));
+
+        var stats = sodium.crypto_keypair_pool_stats();
+        assert.strictEqual(stats.x25519.taken, 2);
+        assert.strictEqual(stats.ed25519.taken, 1);
+        done();
+    });
+
+    it("sealed boxes should open with crypto_box_seal_open", function (done) {
+        var bob = sodium.crypto_box_keypair();
+        var message = Buffer.from("pooled ephemeral key");
+
+        for (var i = 0; i < 20; i++) {
+            var c = sodium.crypto_box_seal(message, bob.publicKey);
+            var m = sodium.crypto_box_seal_open(c, bob.publicKey, bob.secretKey);
+            assert(m.equals(message));
+        }
+
+        var c2 = sodium.crypto_box_seal_batch(message, [bob.publicKey, bob.publicKey]);
+        var first = c2.slice(0, message.length + sodium.crypto_box_SEALBYTES);
+        assert(sodium.crypto_box_seal_open(first, bob.publicKey, bob.secretKey).equals(message));
+        done();
+    });
+
+    it("should generate on demand the kinds that are not pooled", function (done) {
+        sodium.crypto_keypair_pool_enable(0, 1);
+        sodium.crypto_box_keypair();
+        var stats = sodium.crypto_keypair_pool_stats();
+        assert.strictEqual(stats.x25519.misses, 0);
+
+        sodium.crypto_keypair_pool_disable();
+        stats = sodium.crypto_keypair_pool_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.strictEqual(stats.ed25519.size, 0);
+        done();
+    });
+});
@@ -0,0 +1,52 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_kx", function () {
+    it("client and server should agree on session keys", function (done) {
+        var client = sodium.crypto_kx_keypair();
+        var server = sodium.crypto_kx_keypair();
+
+        var c = sodium.crypto_kx_client_session_keys(client.publicKey, client.secretKey, server.publicKey);
+        var s = sodium.crypto_kx_server_session_keys(server.publicKey, server.secretKey, client.publicKey);
+
+        assert.strictEqual(c.rx.length, sodium.crypto_kx_SESSIONKEYBYTES);
+        assert.strictEqual(c.tx.length, sodium.crypto_kx_SESSIONKEYBYTES);
+        assert(c.rx.equals(s.tx));
+        assert(c.tx.equals(s.rx));
+        assert(!c.rx.equals(c.tx));
+
+        // rx and tx are views on one allocation
+        assert.strictEqual(c.rx.buffer, c.tx.buffer);
+        assert.strictEqual(c.tx.byteOffset - c.rx.byteOffset, sodium.crypto_kx_SESSIONKEYBYTES);
+        done();
+    });
+
+    it("seed key pairs should be deterministic", function (done) {
+        var seed = Buffer.alloc(sodium.crypto_kx_SEEDBYTES, 7);
+        var a = sodium.crypto_kx_seed_keypair(seed);
+        var b = sodium.crypto_kx_seed_keypair(seed);
+        assert(a.publicKey.equals(b.publicKey));
+        assert(a.secretKey.equals(b.secretKey));
+        assert(sodium.crypto_scalarmult_base(a.secretKey).equals(a.publicKey));
+        done();
+    });
+
+    it("should return null for a low order public key", function (done) {
+        var client = sodium.crypto_kx_keypair();
+        var zero = Buffer.alloc(sodium.crypto_kx_PUBLICKEYBYTES);
+        assert.strictEqual(sodium.crypto_kx_client_session_keys(client.publicKey, client.secretKey, zero), null);
+        done();
+    });
+
+    it("should check parameters", function (done) {
+        var client = sodium.crypto_kx_keypair();
+        assert.throws(function () {
+            sodium.crypto_kx_client_session_keys(client.publicKey, client.secretKey);
+        });
+        assert.throws(function () {
+            sodium.crypto_kx_seed_keypair(Buffer.alloc(3));
+        });
+        assert.strictEqual(sodium.crypto_kx_primitive(), sodium.crypto_kx_PRIMITIVE);
+        done();
+    });
+});
@@ -131,4 +131,58 @@ describe('crypto_onetimeauth_verify verify parameters', function() {
         });
         done();
     });
+
+    it('verify_any should return the index of the matching key', function(done) {
+        var buf = crypto.randomBytes(256);
+        var keys = [0, 1, 2].map(function() { return sodium.crypto_onetimeauth_keygen(); });
+        var token = sodium.crypto_onetimeauth(buf, keys[2]);
+
+        assert.strictEqual(sodium.crypto_onetimeauth_verify_any(token, buf, keys), 2);
+        assert.strictEqual(sodium.crypto_onetimeauth_verify_any(token, buf, keys.slice(0, 2)), -1);
+        assert.strictEqual(sodium.crypto_onetimeauth_verify_any(token, buf, []), -1);
+        assert.throws(function() {
+            sodium.crypto_onetimeauth_verify_any(token, buf, [keys[0], Buffer.alloc(2)]);
+        });
+        done();
+    });
+
+    it('should tag and verify batches', function(done) {
+        var messages = [crypto.randomBytes(100), Buffer.alloc(0), crypto.randomBytes(1000)];
+        var lengths = messages.map(function(m) { return m.length; });
+        var keys = messages.map(function() { return sodium.crypto_onetimeauth_keygen(); });
+        var packed = Buffer.concat(messages);
+
+        var tags = sodium.crypto_onetimeauth_batch(packed, lengths, Buffer.concat(keys));
+        messages.forEach(function(m, i) {
+            assert(tags.slice(16 * i, 16 * i + 16).equals(sodium.crypto_onetimeauth(m, keys[i])));
+        });
+        assert(sodium.crypto_onetimeauth_batch(packed, lengths, keys, 2).equals(tags));
+
+        tags[20] ^= 1;
+        assert.strictEqual(sodium.crypto_onetimeauth_verify_batch(tags, packed, lengths, keys)[0], 5);
+        assert.throws(function() { sodium.crypto_onetimeauth_batch(packed, lengths, keys.slice(1)); });
+        done();
+    });
+
+    it('should derive frame keys from ChaCha20', function(done) {
+        var key = crypto.randomBytes(sodium.crypto_stream_chacha20_KEYBYTES);
+        var frames = Buffer.alloc(64 * 10, 'frame');
+        var nonces = crypto.randomBytes(sodium.crypto_stream_chacha20_NONCEBYTES * 10);
+
+        var tags = sodium.crypto_onetimeauth_poly1305_chacha20_batch(frames, 64, nonces, key);
+        for (var i = 0; i < 10; i++) {
+            var nonce = nonces.slice(8 * i, 8 * i + 8);
+            var polyKey = sodium.crypto_stream_chacha20(32, nonce, key);
+            var tag = sodium.crypto_onetimeauth_poly1305(frames.slice(64 * i, 64 * i + 64), polyKey);
+            assert(tags.slice(16 * i, 16 * i + 16).equals(tag));
+        }
+
+        var valid = sodium.crypto_onetimeauth_poly1305_chacha20_verify_batch(tags, frames, 64, nonces, key);
+        assert.strictEqual(valid[0], 0xff);
+        assert.strictEqual(valid[1], 0x03);
+        frames[64 * 9] ^= 1;
+        valid = sodium.crypto_onetimeauth_poly1305_chacha20_verify_batch(tags, frames, 64, nonces, key);
+        assert.strictEqual(valid[1], 0x01);
+        done();
+    });
 });
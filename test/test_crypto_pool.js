@@ -0,0 +1,85 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../lib/sodium');
+var binding = require('../build/Release/sodium');
+
+var hasWorkers = true;
+try {
+    require('worker_threads');
+}
+catch (e) {
+    hasWorkers = false;
+}
+
+describe("CryptoPool", function () {
+    if (!hasWorkers) {
+        return;
+    }
+
+    var pool;
+    before(function () {
+        pool = new sodium.CryptoPool({ threads: 2, maxBatch: 16 });
+    });
+    after(function () {
+        return pool.close();
+    });
+
+    it("should give the same results as the sync calls", function () {
+        this.timeout(20000);
+        var keys = binding.crypto_sign_keypair();
+        var key = Buffer.alloc(binding.crypto_secretbox_KEYBYTES);
+        binding.randombytes_buf(key);
+        var nonce = Buffer.alloc(binding.crypto_secretbox_NONCEBYTES, 3);
+        var jobs = [];
+        for (var i = 0; i < 100; i++) {
+            var m = Buffer.from("message " + i);
+            jobs.push(pool.run('crypto_sign_detached', m, keys.secretKey));
+            jobs.push(pool.run('crypto_secretbox_easy', m, nonce, key));
+            jobs.push(pool.run('crypto_generichash', 32, m, null));
+        }
+        return Promise.all(jobs).then(function (results) {
+            for (var i = 0; i < 100; i++) {
+                var m = Buffer.from("message " + i);
+                assert(results[3 * i].equals(binding.crypto_sign_detached(m, keys.secretKey)));
+                assert(results[3 * i + 1].equals(binding.crypto_secretbox_easy(m, nonce, key)));
+                assert(results[3 * i + 2].equals(binding.crypto_generichash(32, m, null)));
+            }
+            assert.strictEqual(pool.stats.jobs, 300);
+            assert(pool.stats.batches < 300);
+        });
+    });
+
+    it("should return objects and plain values", function () {
+        return Promise.all([
+            pool.run('crypto_box_keypair'),
+            pool.run('crypto_verify_32', Buffer.alloc(32), Buffer.alloc(32))
+        ]).then(function (results) {
+            assert.strictEqual(results[0].publicKey.length, binding.crypto_box_PUBLICKEYBYTES);
+            assert.strictEqual(results[0].secretKey.length, binding.crypto_box_SECRETKEYBYTES);
+            assert.strictEqual(results[1], 0);
+        });
+    });
+
+    it("should reject a job that throws without failing the batch", function () {
+        var bad = pool.run('crypto_secretbox_easy', Buffer.alloc(1));
+        var unknown = pool.run('no_such_function');
+        var good = pool.run('crypto_generichash', 16, Buffer.alloc(1), null);
+        return Promise.all([
+            bad.then(function () { assert.fail('should reject'); }, function (e) { assert(e instanceof Error); }),
+            unknown.then(function () { assert.fail('should reject'); }, function (e) { assert(/unknown/.test(e.message)); }),
+            good.then(function (h) { assert.strictEqual(h.length, 16); })
+        ]);
+    });
+
+    it("should reject jobs after close", function () {
+        var other = new sodium.CryptoPool({ threads: 1 });
+        return other.close().then(function () {
+            return other.run('crypto_box_keypair').then(function () {
+                assert.fail('should reject');
+            }, function (e) {
+                assert(/closed/.test(e.message));
+            });
+        });
+    });
+});
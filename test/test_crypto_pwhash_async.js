@@ -0,0 +1,291 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var password = Buffer.from('this is a test password','utf8');
+var badPassword = Buffer.from('this is a bad password','utf8');
+
+describe('PWHash async', function() {
+    it('crypto_pwhash_async should match the sync version', function(done) {
+        var salt = Buffer.alloc(sodium.crypto_pwhash_SALTBYTES, 7);
+        var expected = sodium.crypto_pwhash(32, password, salt,
+                    sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_ALG_DEFAULT);
+
+        sodium.crypto_pwhash_async(32, password, salt,
+                    sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_ALG_DEFAULT).then(function(out) {
+            assert(sodium.compare(out, expected) == 0);
+            done();
+        }).catch(done);
+    });
+
+    it('crypto_pwhash_str_async should return a promise', function(done) {
+        var p = sodium.crypto_pwhash_str_async(
+                    password,
+                    sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE);
+        assert(p instanceof Promise);
+
+        p.then(function(out) {
+            assert.equal(out.length, sodium.crypto_pwhash_STRBYTES);
+            assert(sodium.crypto_pwhash_str_verify(out, password));
+            return sodium.crypto_pwhash_str_verify_async(out, badPassword);
+        }).then(function(valid) {
+            assert.strictEqual(valid, false);
+            done();
+        }).catch(done);
+    });
+
+    it('should accept a node style callback', function(done) {
+        var out = sodium.crypto_pwhash_str(
+                    password,
+                    sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE);
+
+        var ret = sodium.crypto_pwhash_str_verify_async(out, password, function(err, valid) {
+            assert.ifError(err);
+            assert.strictEqual(valid, true);
+            done();
+        });
+        assert.strictEqual(ret, undefined);
+    });
+
+    it('should not be affected by changes to the input after the call', function(done) {
+        var pw = Buffer.from(password);
+        var salt = Buffer.alloc(sodium.crypto_pwhash_SALTBYTES, 1);
+        var expected = sodium.crypto_pwhash(16, password, salt,
+                    sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_ALG_DEFAULT);
+
+        sodium.crypto_pwhash_async(16, pw, salt,
+                    sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE,
+                    sodium.crypto_pwhash_ALG_DEFAULT, function(err, out) {
+            assert.ifError(err);
+            assert(sodium.compare(out, expected) == 0);
+            done();
+        });
+        pw.fill(0);
+        salt.fill(0);
+    });
+
+    it('should throw synchronously on bad arguments', function(done) {
+        assert.throws(function() {
+            sodium.crypto_pwhash_str_async("not a buffer", 1, 1);
+        });
+        assert.throws(function() {
+            sodium.crypto_pwhash_async(32, password, Buffer.alloc(2), 1, 1, 1);
+        });
+        done();
+    });
+});
+
+describe('PWHash verify and rehash', function() {
+    var ops = sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE;
+    var mem = sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE;
+
+    it('should rehash a valid password with stale limits', function() {
+        var stale = sodium.crypto_pwhash_str(password, ops + 1, mem);
+        return sodium.crypto_pwhash_str_verify_rehash_async(stale, password, ops, mem).then(function(result) {
+            assert.strictEqual(result.valid, true);
+            assert.equal(result.newHash.length, sodium.crypto_pwhash_STRBYTES);
+            assert(sodium.crypto_pwhash_str_verify(result.newHash, password));
+            return sodium.crypto_pwhash_str_verify_rehash_async(result.newHash, password, ops, mem);
+        }).then(function(result) {
+            assert.deepEqual(result, { valid: true, newHash: null });
+            return sodium.crypto_pwhash_str_verify_rehash_async(stale, badPassword, ops, mem);
+        }).then(function(result) {
+            assert.deepEqual(result, { valid: false, newHash: null });
+        });
+    });
+
+    it('should migrate a table in one batch', function() {
+        var current = sodium.crypto_pwhash_str(password, ops, mem);
+        var argon2i = sodium.crypto_pwhash_argon2i_str(password,
+            sodium.crypto_pwhash_argon2i_OPSLIMIT_INTERACTIVE, mem).toString().replace(/\0+$/, '');
+        var hashes = [current, argon2i, 'not a hash', argon2i];
+
+        return sodium.crypto_pwhash_str_verify_rehash_batch_async(hashes, null, ops, mem).then(function(result) {
+            assert.deepEqual(Array.from(result.needsRehash), [0, 1, 1, 1]);
+            assert.strictEqual(result.valid, undefined);
+            return sodium.crypto_pwhash_str_verify_rehash_batch_async(hashes,
+                [password, password, password, badPassword], ops, mem);
+        }).then(function(result) {
+            assert.deepEqual(Array.from(result.valid), [1, 1, 0, 0]);
+            assert.strictEqual(result.newHashes[0], null);
+            assert.equal(result.newHashes[1].toString().indexOf(sodium.crypto_pwhash_STRPREFIX), 0);
+            assert(sodium.crypto_pwhash_str_verify(result.newHashes[1], password));
+            assert.strictEqual(result.newHashes[2], null);
+            assert.strictEqual(result.newHashes[3], null);
+        });
+    });
+
+    it('should check its arguments', function() {
+        assert.throws(function() {
+            sodium.crypto_pwhash_str_verify_rehash_batch_async([Buffer.alloc(8)], [], ops, mem);
+        });
+        assert.throws(function() {
+            sodium.crypto_pwhash_str_verify_rehash_async(Buffer.alloc(200), password, ops, mem);
+        });
+    });
+});
+
+['argon2i', 'argon2id', 'scryptsalsa208sha256'].forEach(function(algo) {
+    var prefix = 'crypto_pwhash_' + algo;
+
+    describe('PWHash ' + algo + ' async', function() {
+        it(prefix + '_str_async should verify with the same password', function(done) {
+            sodium[prefix + '_str_async'](password,
+                        sodium[prefix + '_OPSLIMIT_INTERACTIVE'],
+                        sodium[prefix + '_MEMLIMIT_INTERACTIVE']).then(function(out) {
+                assert(sodium[prefix + '_str_verify'](out, password));
+                return sodium[prefix + '_str_verify_async'](out, badPassword);
+            }).then(function(valid) {
+                assert.strictEqual(valid, false);
+                done();
+            }).catch(done);
+        });
+
+        it(prefix + '_async should match the sync version', function(done) {
+            var salt = Buffer.alloc(sodium[prefix + '_SALTBYTES'], 3);
+            var args = [32, password, salt,
+                        sodium[prefix + '_OPSLIMIT_INTERACTIVE'],
+                        sodium[prefix + '_MEMLIMIT_INTERACTIVE']];
+            if( algo !== 'scryptsalsa208sha256' ) {
+                args.push(sodium[prefix + '_alg_' + algo + '13']());
+            }
+            var expected = sodium[prefix].apply(sodium, args);
+
+            args.push(function(err, out) {
+                assert.ifError(err);
+                assert(sodium.compare(out, expected) == 0);
+                done();
+            });
+            sodium[prefix + '_async'].apply(sodium, args);
+        });
+    });
+});
+
+describe('PWHash scryptsalsa208sha256 low level async', function() {
+    it('should match the known answer', function(done) {
+        var output = Buffer.allocUnsafe(64);
+        sodium.crypto_pwhash_scryptsalsa208sha256_ll_async(
+            Buffer.from("pleaseletmein",'utf8'), Buffer.from('SodiumChloride','utf8'),
+            16384, 8, 1, output).then(function(ok) {
+            assert.strictEqual(ok, true);
+            assert.equal(output.toString('hex'), "7023bdcb3afd7348461c06cd81fd38ebfda8fbba904f8e3ea9b543f6545da1f2d5432955613f0fcf62d49705242a9af9e61e85dc0d651e40dfcf017b45575887");
+            done();
+        }).catch(done);
+    });
+
+    // RFC 7914 vector with 16 lanes
+    var lanesExpected = "fdbabe1c9d3472007856e7190d01e9fe7c6ad7cbc8237830e77376634b3731622eaf30d92e22a3886ff109279d9830dac727afb94a83ee6d8360cbdfa2cc0640";
+
+    function lanes(threads) {
+        var output = Buffer.alloc(64);
+        var args = [Buffer.from('password'), Buffer.from('NaCl'), 1024, 8, 16, output];
+        if (threads !== undefined) {
+            args.push(threads);
+        }
+        return sodium.crypto_pwhash_scryptsalsa208sha256_ll_async.apply(sodium, args).then(function(ok) {
+            assert.strictEqual(ok, true);
+            return output.toString('hex');
+        });
+    }
+
+    it('should run p > 1 lanes on several threads', function() {
+        return Promise.all([lanes(), lanes(1), lanes(4), lanes(16), lanes(64)]).then(function(results) {
+            results.forEach(function(hex) {
+                assert.equal(hex, lanesExpected);
+            });
+        });
+    });
+
+    it('should take the threads before a callback', function(done) {
+        var output = Buffer.alloc(64);
+        sodium.crypto_pwhash_scryptsalsa208sha256_ll_async(
+            Buffer.from('password'), Buffer.from('NaCl'), 1024, 8, 16, output, 3, function(err, ok) {
+            assert.ifError(err);
+            assert.strictEqual(ok, true);
+            assert.equal(output.toString('hex'), lanesExpected);
+            done();
+        });
+    });
+
+    it('should validate the threads', function() {
+        var output = Buffer.alloc(64);
+        [0, 65].forEach(function(threads) {
+            assert.throws(function() {
+                sodium.crypto_pwhash_scryptsalsa208sha256_ll_async(
+                    Buffer.from('password'), Buffer.from('NaCl'), 1024, 8, 16, output, threads);
+            });
+        });
+    });
+
+    it('should leave the sync version serial and equal', function() {
+        var output = Buffer.alloc(64);
+        assert.strictEqual(sodium.crypto_pwhash_scryptsalsa208sha256_ll(
+            Buffer.from('password'), Buffer.from('NaCl'), 1024, 8, 16, output), true);
+        assert.equal(output.toString('hex'), lanesExpected);
+    });
+});
+
+describe('PWHash argon2id parallel lanes', function() {
+    var pw = Buffer.from('password');
+    var salt = Buffer.from('somesaltsomesalt');
+    var mem = 8 * 1024 * 1024;
+    // $argon2id$v=19$m=8192,t=3,p=4$c29tZXNhbHRzb21lc2FsdA$...
+    var expected = Buffer.from('3h6Qg5gZUPjvsGs8f3cQV72qKe2gt6TKkjZNzKY3lYU', 'base64');
+
+    it('should not depend on the number of threads', function() {
+        [undefined, 1, 2, 4, 16].forEach(function(threads) {
+            var out = sodium.crypto_pwhash_argon2id_parallel(32, pw, salt, 3, mem, 4, threads);
+            assert(out.equals(expected));
+        });
+        return sodium.crypto_pwhash_argon2id_parallel_async(32, pw, salt, 3, mem, 4, 3).then(function(out) {
+            assert(out.equals(expected));
+        });
+    });
+
+    it('should match crypto_pwhash_argon2id with one lane', function() {
+        var out = sodium.crypto_pwhash_argon2id_parallel(32, pw, salt, 3, mem, 1);
+        var serial = sodium.crypto_pwhash_argon2id(32, pw, salt, 3, mem,
+            sodium.crypto_pwhash_argon2id_ALG_ARGON2ID13);
+        assert(out.equals(serial));
+    });
+
+    it('should write hash strings the other verifiers accept', function(done) {
+        var hash = sodium.crypto_pwhash_argon2id_str_parallel(password, 2, mem, 4);
+        assert.equal(hash.length, sodium.crypto_pwhash_argon2id_STRBYTES);
+        assert(/^\$argon2id\$v=19\$m=8192,t=2,p=4\$/.test(hash.toString()));
+        assert.strictEqual(sodium.crypto_pwhash_str_verify(hash, password), true);
+        assert.strictEqual(sodium.crypto_pwhash_argon2id_str_verify_parallel(hash, password, 4), true);
+        assert.strictEqual(sodium.crypto_pwhash_argon2id_str_verify_parallel(hash, badPassword), false);
+
+        sodium.crypto_pwhash_argon2id_str_verify_parallel_async(hash, password, 2, function(err, ok) {
+            assert.ifError(err);
+            assert.strictEqual(ok, true);
+            done();
+        });
+    });
+
+    it('should validate the lanes and threads', function() {
+        assert.throws(function() {
+            sodium.crypto_pwhash_argon2id_parallel(32, pw, salt, 3, mem, 0);
+        });
+        assert.throws(function() {
+            sodium.crypto_pwhash_argon2id_parallel(32, pw, salt, 3, mem, 256);
+        });
+        assert.throws(function() {
+            sodium.crypto_pwhash_argon2id_str_parallel(password, 2, mem, 4, 65);
+        });
+        assert.throws(function() {
+            sodium.crypto_pwhash_argon2id_str_parallel(password, 2, 1024 * 1024, 255);
+        });
+    });
+});
@@ -0,0 +1,56 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var MAX_MEM = 8 << 20;
+
+describe('crypto_pwhash_calibrate', function() {
+    this.timeout(20000);
+
+    it('should validate options', function() {
+        assert.throws(function() { sodium.crypto_pwhash_calibrate(); });
+        assert.throws(function() { sodium.crypto_pwhash_calibrate({}); });
+        assert.throws(function() { sodium.crypto_pwhash_calibrate({ targetMs: 0 }); });
+        assert.throws(function() { sodium.crypto_pwhash_calibrate({ targetMs: 10, maxMem: 1024 }); });
+        assert.throws(function() { sodium.crypto_pwhash_calibrate({ targetMs: 10, alg: 99 }); });
+        assert.throws(function() { sodium.crypto_pwhash_calibrate({ targetMs: 10, concurrency: 1.5 }); });
+    });
+
+    it('should return limits that fit the budget', function() {
+        var params = sodium.crypto_pwhash_calibrate({ targetMs: 40, maxMem: MAX_MEM, cache: false });
+        assert.equal(params.alg, sodium.crypto_pwhash_ALG_DEFAULT);
+        assert.ok(params.memlimit >= sodium.crypto_pwhash_MEMLIMIT_MIN);
+        assert.ok(params.memlimit <= MAX_MEM);
+        assert.ok(params.opslimit >= sodium.crypto_pwhash_argon2id_OPSLIMIT_MIN);
+        assert.equal(params.met, params.ms <= 40);
+        assert.equal(params.cached, false);
+        assert.ok(['avx512f', 'avx2', 'ssse3', 'ref'].indexOf(params.kernel) >= 0);
+
+        var str = sodium.crypto_pwhash_str(Buffer.from('password'), params.opslimit, params.memlimit);
+        assert.ok(sodium.crypto_pwhash_str_verify(str, Buffer.from('password')));
+    });
+
+    it('should cache results per options', function() {
+        var options = { targetMs: 20, maxMem: MAX_MEM, alg: sodium.crypto_pwhash_ALG_ARGON2I13 };
+        var first = sodium.crypto_pwhash_calibrate(options);
+        var second = sodium.crypto_pwhash_calibrate(options);
+        assert.equal(second.cached, true);
+        assert.equal(second.opslimit, first.opslimit);
+        assert.equal(second.memlimit, first.memlimit);
+        assert.ok(first.opslimit >= sodium.crypto_pwhash_argon2i_OPSLIMIT_MIN);
+    });
+
+    it('should raise the passes when memory is capped', function() {
+        var params = sodium.crypto_pwhash_calibrate({ targetMs: 10, maxMem: sodium.crypto_pwhash_MEMLIMIT_MIN, cache: false });
+        assert.equal(params.memlimit, sodium.crypto_pwhash_MEMLIMIT_MIN);
+        assert.ok(params.opslimit > sodium.crypto_pwhash_argon2id_OPSLIMIT_MIN);
+        assert.equal(params.met, params.ms <= 10);
+    });
+
+    it('should time concurrent hashes', function() {
+        var params = sodium.crypto_pwhash_calibrate({ targetMs: 30, maxMem: MAX_MEM, concurrency: 2, cache: false });
+        assert.equal(params.concurrency, 2);
+        assert.ok(params.memlimit <= MAX_MEM);
+    });
+});
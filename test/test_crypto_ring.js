@@ -0,0 +1,163 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../lib/sodium');
+var binding = require('../build/Release/sodium');
+
+describe("CryptoRing", function () {
+    var rings = [];
+    function ring(options) {
+        var r = new sodium.CryptoRing(options);
+        rings.push(r);
+        return r;
+    }
+    afterEach(function () {
+        rings.splice(0).forEach(function (r) { r.close(); });
+    });
+
+    // Resolve with the completions of `count` jobs, by id
+    function collect(count) {
+        var done = {};
+        var finish;
+        var promise = new Promise(function (resolve) { finish = resolve; });
+        return {
+            promise: promise,
+            onComplete: function (id, status, length) {
+                done[id] = { status: status, length: length };
+                if( --count === 0 ) {
+                    finish(done);
+                }
+            }
+        };
+    }
+
+    it("should hash and authenticate in the arena", function () {
+        var c = collect(3);
+        var r = ring({ entries: 8, arenaSize: 4096, onComplete: c.onComplete });
+        var message = Buffer.from("hashed in shared memory");
+        var key = Buffer.alloc(32, 5);
+        r.arena.set(message, 0);
+        r.arena.set(key, 1024);
+
+        var a = r.submit('crypto_hash_sha256', 2048, 32, 0, message.length);
+        var b = r.submit('crypto_generichash', 2112, 48, 0, message.length, 1024, 32);
+        var h = r.submit('crypto_auth_hmacsha256', 2176, 32, 0, message.length, 0, 0, 1024);
+        assert.equal(r.inflight, 3);
+
+        return c.promise.then(function (done) {
+            assert.equal(done[a].status, sodium.CryptoRing.OK);
+            assert.equal(done[a].length, 32);
+            assert.deepEqual(Buffer.from(r.arena.slice(2048, 2080)), binding.crypto_hash_sha256(message));
+            assert.equal(done[b].length, 48);
+            assert.deepEqual(Buffer.from(r.arena.slice(2112, 2160)), binding.crypto_generichash(48, message, key));
+            assert.deepEqual(Buffer.from(r.arena.slice(2176, 2208)), binding.crypto_auth_hmacsha256(message, key));
+            assert.equal(r.inflight, 0);
+        });
+    });
+
+    it("should seal and open AEAD messages in place", function () {
+        var c = collect(1);
+        var r = ring({ entries: 4, arenaSize: 4096, onComplete: c.onComplete });
+        var key = Buffer.alloc(32, 1), nonce = Buffer.alloc(24, 2), ad = Buffer.from("header");
+        var message = Buffer.from("encrypted where it lies");
+        r.arena.set(key, 0);
+        r.arena.set(nonce, 32);
+        r.arena.set(ad, 64);
+        r.arena.set(message, 128);
+
+        var size = message.length + 16;
+        r.submit('crypto_aead_xchacha20poly1305_ietf_encrypt', 128, size, 128, message.length, 64, ad.length, 0, 32);
+        return c.promise.then(function () {
+            var sealed = Buffer.from(r.arena.slice(128, 128 + size));
+            assert.deepEqual(sealed, binding.crypto_aead_xchacha20poly1305_ietf_encrypt(message, ad, nonce, key));
+
+            var d = collect(2);
+            var r2 = ring({ entries: 4, arena: r.arena, onComplete: d.onComplete });
+            r.close();
+            var good = r2.submit('crypto_aead_xchacha20poly1305_ietf_decrypt', 128, message.length, 128, size, 64, ad.length, 0, 32);
+            var forged = r2.submit('crypto_aead_xchacha20poly1305_ietf_decrypt', 1024, 64, 128, size, 64, ad.length - 1, 0, 32);
+            return d.promise.then(function (done) {
+                assert.equal(done[good].status, sodium.CryptoRing.OK);
+                assert.deepEqual(Buffer.from(r2.arena.slice(128, 128 + message.length)), message);
+                assert.equal(done[forged].status, sodium.CryptoRing.FAILED);
+                assert.equal(done[forged].length, 0);
+            });
+        });
+    });
+
+    it("should sign and verify", function () {
+        var c = collect(3);
+        var r = ring({ entries: 4, arenaSize: 4096, onComplete: c.onComplete });
+        var keys = binding.crypto_sign_seed_keypair(Buffer.alloc(32, 9));
+        var message = Buffer.from("signed from the ring");
+        r.arena.set(keys.secretKey, 0);
+        r.arena.set(keys.publicKey, 64);
+        r.arena.set(message, 128);
+        r.arena.set(binding.crypto_sign_detached(message, keys.secretKey), 512);
+
+        var sign = r.submit('crypto_sign_detached', 256, 64, 128, message.length, 0, 0, 0);
+        var ok = r.submit('crypto_sign_verify_detached', 0, 0, 128, message.length, 512, 64, 64);
+        var bad = r.submit('crypto_sign_verify_detached', 0, 0, 128, message.length - 1, 512, 64, 64);
+        return c.promise.then(function (done) {
+            assert.equal(done[sign].status, 0);
+            assert.deepEqual(Buffer.from(r.arena.slice(256, 320)), binding.crypto_sign_detached(message, keys.secretKey));
+            assert.equal(done[ok].status, sodium.CryptoRing.OK);
+            assert.equal(done[bad].status, sodium.CryptoRing.FAILED);
+        });
+    });
+
+    it("should refuse jobs outside the arena", function () {
+        var c = collect(3);
+        var r = ring({ entries: 4, arenaSize: 256, onComplete: c.onComplete });
+        var a = r.submit('crypto_hash_sha256', 240, 32, 0, 16);
+        var b = r.submit('crypto_hash_sha512', 0, 64, 200, 0xffffff);
+        var d = r.submit(99, 0, 64, 0, 16);
+        return c.promise.then(function (done) {
+            [a, b, d].forEach(function (id) {
+                assert.equal(done[id].status, sodium.CryptoRing.BAD_JOB);
+            });
+            assert.equal(r.stats().failed, 3);
+        });
+    });
+
+    it("should report a full ring and take jobs again once reaped", function () {
+        var count = 0;
+        var r = ring({ entries: 2, arenaSize: 1024, onComplete: function () { count++; } });
+        assert.ok(r.submit('crypto_hash_sha256', 512, 32, 0, 64) >= 0);
+        assert.ok(r.submit('crypto_hash_sha256', 544, 32, 0, 64) >= 0);
+        assert.equal(r.submit('crypto_hash_sha256', 576, 32, 0, 64), -1);
+        return new Promise(function (resolve) {
+            (function wait() {
+                if( r.inflight > 0 ) {
+                    return setTimeout(wait, 1);
+                }
+                resolve();
+            })();
+        }).then(function () {
+            assert.equal(count, 2);
+            assert.ok(r.submit('crypto_hash_sha256', 576, 32, 0, 64) >= 0);
+        });
+    });
+
+    it("should wake its thread after sleeping", function () {
+        this.timeout(10000);
+        var c = collect(1);
+        var r = ring({ entries: 4, arenaSize: 1024, onComplete: c.onComplete });
+        return new Promise(function (resolve) { setTimeout(resolve, 50); }).then(function () {
+            assert.ok(r.stats().sleeps >= 1);
+            r.submit('crypto_hash_sha256', 512, 32, 0, 64);
+            return c.promise;
+        }).then(function () {
+            assert.ok(r.stats().wakeups >= 1);
+        });
+    });
+
+    it("should validate its options", function () {
+        assert.throws(function () { new sodium.CryptoRing({ entries: 3 }); });
+        assert.throws(function () { new binding.SodiumRing(new Uint8Array(4), new Uint8Array(4), function () {}); });
+        var r = ring({ entries: 2, arenaSize: 64 });
+        assert.throws(function () { r.submit('crypto_box_easy', 0, 0, 0, 0); }, TypeError);
+        r.close();
+        assert.throws(function () { r.submit('crypto_hash_sha256', 0, 32, 0, 0); });
+    });
+});
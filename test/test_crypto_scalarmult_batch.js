@@ -0,0 +1,90 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+function makeKeys(n) {
+    var keys = { secretKeys: [], publicKeys: [] };
+    for (var i = 0; i < n; i++) {
+        var kp = sodium.crypto_box_keypair();
+        keys.secretKeys.push(kp.secretKey);
+        keys.publicKeys.push(kp.publicKey);
+    }
+    return keys;
+}
+
+function expected(scalars, points) {
+    return Buffer.concat(points.map(function(p, i) {
+        return sodium.crypto_scalarmult(scalars.length === 1 ? scalars[0] : scalars[i], p);
+    }));
+}
+
+describe('crypto_scalarmult_batch', function() {
+    var me = sodium.crypto_box_keypair();
+    var peers = makeKeys(40);
+
+    it('should multiply one scalar with every point', function(done) {
+        var q = sodium.crypto_scalarmult_batch(me.secretKey, peers.publicKeys);
+        assert.equal(q.length, 40 * sodium.crypto_scalarmult_BYTES);
+        assert(q.equals(expected([me.secretKey], peers.publicKeys)));
+        done();
+    });
+
+    it('should multiply packed pairs', function(done) {
+        var q = sodium.crypto_scalarmult_batch(Buffer.concat(peers.secretKeys),
+                                               Buffer.concat(peers.publicKeys));
+        assert(q.equals(expected(peers.secretKeys, peers.publicKeys)));
+        done();
+    });
+
+    it('should give the same result with threads', function(done) {
+        var many = makeKeys(300);
+        var one = sodium.crypto_scalarmult_batch(me.secretKey, many.publicKeys);
+        var four = sodium.crypto_scalarmult_batch(me.secretKey, many.publicKeys, 4);
+        assert(one.equals(four));
+        done();
+    });
+
+    it('should zero the product of a rejected point', function(done) {
+        var points = peers.publicKeys.slice(0, 3);
+        points[1] = Buffer.alloc(sodium.crypto_scalarmult_BYTES);
+        var q = sodium.crypto_scalarmult_batch(me.secretKey, points);
+        assert(q.slice(32, 64).equals(Buffer.alloc(32)));
+        assert(q.slice(64, 96).equals(sodium.crypto_scalarmult(me.secretKey, points[2])));
+        done();
+    });
+
+    it('should throw on mismatched batches', function(done) {
+        assert.throws(function() {
+            sodium.crypto_scalarmult_batch(peers.secretKeys.slice(1), peers.publicKeys);
+        });
+        assert.throws(function() {
+            sodium.crypto_scalarmult_batch(me.secretKey, Buffer.alloc(33));
+        });
+        done();
+    });
+
+    it('crypto_scalarmult_batch_async should match the sync batch', function() {
+        return sodium.crypto_scalarmult_batch_async(me.secretKey, peers.publicKeys, 2).then(function(q) {
+            assert(q.equals(expected([me.secretKey], peers.publicKeys)));
+        });
+    });
+});
+
+describe('crypto_scalarmult_base', function() {
+    it('should match the RFC 7748 test vector', function(done) {
+        var n = Buffer.from('77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a', 'hex');
+        assert.equal(sodium.crypto_scalarmult_base(n).toString('hex'),
+                     '8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a');
+        done();
+    });
+
+    it('should match a multiplication of the base point', function(done) {
+        var base = Buffer.alloc(sodium.crypto_scalarmult_BYTES);
+        base[0] = 9;
+        for (var i = 0; i < 64; i++) {
+            var n = Buffer.alloc(sodium.crypto_scalarmult_SCALARBYTES);
+            sodium.randombytes_buf(n);
+            assert(sodium.crypto_scalarmult_base(n).equals(sodium.crypto_scalarmult(n, base)));
+        }
+        done();
+    });
+});
@@ -109,6 +109,26 @@ describe('Secretbox', function() {
         assert.deepEqual(plainMsg, plainText);
         done();
     });
+
+    it('crypto_secretbox_easy_base64url/crypto_secretbox_open_easy_base64url should round trip text', function(done) {
+        var text = sodium.crypto_secretbox_easy_base64url(plainText, nonce, key);
+        assert.strictEqual(text, cipherTextEasy.toString('base64url'));
+        assert.deepEqual(sodium.crypto_secretbox_open_easy_base64url(text, nonce, key), plainText);
+
+        var big = crypto.randomBytes(100000);
+        var bigText = sodium.crypto_secretbox_easy_base64url(big, nonce, key);
+        assert(sodium.crypto_secretbox_open_easy_base64url(bigText, nonce, key).equals(big));
+
+        var forged = (text[0] === 'A' ? 'B' : 'A') + text.slice(1);
+        assert.strictEqual(sodium.crypto_secretbox_open_easy_base64url(forged, nonce, key), null);
+        assert.strictEqual(sodium.crypto_secretbox_open_easy_base64url(text + '=', nonce, key), null);
+        assert.strictEqual(sodium.crypto_secretbox_open_easy_base64url('not+base64', nonce, key), null);
+        assert.strictEqual(sodium.crypto_secretbox_open_easy_base64url('', nonce, key), null);
+        assert.throws(function () {
+            sodium.crypto_secretbox_open_easy_base64url(Buffer.from(text), nonce, key);
+        });
+        done();
+    });
 });
 
 describe('Secretbox_easy', function() {
@@ -0,0 +1,110 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var SecretBox = require('../lib/secretbox');
+
+var key = Buffer.alloc(sodium.crypto_secretbox_xchacha20poly1305_KEYBYTES, 0x42);
+var nonce = Buffer.alloc(sodium.crypto_secretbox_xchacha20poly1305_NONCEBYTES, 0x24);
+var message = Buffer.from("XChaCha20 with a Poly1305 authenticator, in the secretbox layout");
+
+describe('crypto_secretbox_xchacha20poly1305', function() {
+    it('should have the secretbox sizes', function() {
+        assert.equal(sodium.crypto_secretbox_xchacha20poly1305_KEYBYTES, 32);
+        assert.equal(sodium.crypto_secretbox_xchacha20poly1305_NONCEBYTES, 24);
+        assert.equal(sodium.crypto_secretbox_xchacha20poly1305_MACBYTES, 16);
+    });
+
+    it('should be the XChaCha20 stream with a Poly1305 tag', function() {
+        // The first 32 bytes of keystream are the one time authenticator key
+        var stream = sodium.crypto_stream_xchacha20_xor(
+            Buffer.concat([Buffer.alloc(32), message]), nonce, key);
+        var c = stream.slice(32);
+        var mac = sodium.crypto_onetimeauth(c, stream.slice(0, 32));
+
+        var box = sodium.crypto_secretbox_xchacha20poly1305_easy(message, nonce, key);
+        assert.deepEqual(box, Buffer.concat([mac, c]));
+    });
+
+    it('easy and open_easy should round trip', function() {
+        var c = sodium.crypto_secretbox_xchacha20poly1305_easy(message, nonce, key);
+        assert.equal(c.length, message.length + sodium.crypto_secretbox_xchacha20poly1305_MACBYTES);
+        assert.deepEqual(sodium.crypto_secretbox_xchacha20poly1305_open_easy(c, nonce, key), message);
+
+        c[c.length - 1] ^= 1;
+        assert.strictEqual(sodium.crypto_secretbox_xchacha20poly1305_open_easy(c, nonce, key), null);
+        assert.strictEqual(sodium.crypto_secretbox_xchacha20poly1305_open_easy(Buffer.alloc(8), nonce, key), null);
+    });
+
+    it('detached should split the easy box', function() {
+        var mac = Buffer.alloc(sodium.crypto_secretbox_xchacha20poly1305_MACBYTES);
+        var c = sodium.crypto_secretbox_xchacha20poly1305_detached(mac, message, nonce, key);
+        var easy = sodium.crypto_secretbox_xchacha20poly1305_easy(message, nonce, key);
+        assert.deepEqual(Buffer.concat([mac, c]), easy);
+
+        assert.deepEqual(sodium.crypto_secretbox_xchacha20poly1305_open_detached(c, mac, nonce, key), message);
+        mac[0] ^= 1;
+        assert.strictEqual(sodium.crypto_secretbox_xchacha20poly1305_open_detached(c, mac, nonce, key), null);
+    });
+
+    it('_into variants should write at the offset', function() {
+        var size = message.length + sodium.crypto_secretbox_xchacha20poly1305_MACBYTES;
+        var out = Buffer.alloc(size + 10, 0xee);
+        assert.equal(sodium.crypto_secretbox_xchacha20poly1305_easy_into(out, 4, message, nonce, key), size);
+        assert.deepEqual(out.slice(4, 4 + size), sodium.crypto_secretbox_xchacha20poly1305_easy(message, nonce, key));
+        assert.equal(out[3], 0xee);
+        assert.equal(out[4 + size], 0xee);
+
+        var plain = Buffer.alloc(message.length);
+        assert.equal(sodium.crypto_secretbox_xchacha20poly1305_open_easy_into(plain, 0, out.slice(4, 4 + size), nonce, key), message.length);
+        assert.deepEqual(plain, message);
+
+        out[5] ^= 1;
+        assert.strictEqual(sodium.crypto_secretbox_xchacha20poly1305_open_easy_into(plain, 0, out.slice(4, 4 + size), nonce, key), null);
+
+        assert.throws(function() {
+            sodium.crypto_secretbox_xchacha20poly1305_easy_into(out, 11, message, nonce, key);
+        });
+    });
+
+    it('detached _into variants should work in place', function() {
+        var buf = Buffer.from(message);
+        var mac = Buffer.alloc(20);
+        assert.equal(sodium.crypto_secretbox_xchacha20poly1305_detached_into(buf, 0, mac, 4, buf, nonce, key), message.length);
+        var expected = Buffer.alloc(16);
+        assert.deepEqual(buf, sodium.crypto_secretbox_xchacha20poly1305_detached(expected, message, nonce, key));
+        assert.deepEqual(mac.slice(4), expected);
+
+        assert.equal(sodium.crypto_secretbox_xchacha20poly1305_open_detached_into(buf, 0, buf, expected, nonce, key), message.length);
+        assert.deepEqual(buf, message);
+
+        assert.throws(function() {
+            sodium.crypto_secretbox_xchacha20poly1305_detached_into(buf, 0, mac, 8, buf, nonce, key);
+        });
+    });
+});
+
+describe('SecretBox with xchacha20poly1305', function() {
+    it('should encrypt and decrypt', function() {
+        var box = new SecretBox(key, { algorithm: 'xchacha20poly1305' });
+        box.setEncoding('utf8');
+        var cipherBox = box.encrypt("This is a test");
+        assert.equal(cipherBox.cipherText.length, 14 + sodium.crypto_secretbox_xchacha20poly1305_MACBYTES);
+        assert.equal(box.decrypt(cipherBox), "This is a test");
+        assert.deepEqual(cipherBox.cipherText,
+            sodium.crypto_secretbox_xchacha20poly1305_easy(Buffer.from("This is a test"), cipherBox.nonce, key));
+    });
+
+    it('should not open xsalsa20poly1305 boxes', function() {
+        var xsalsa = new SecretBox(key);
+        var xchacha = new SecretBox(key, undefined, { algorithm: 'xchacha20poly1305' });
+        assert.equal(xsalsa.algorithm, 'xsalsa20poly1305');
+        assert.ok(!xchacha.decrypt(xsalsa.encrypt(Buffer.from("message"))));
+    });
+
+    it('should reject unknown algorithms', function() {
+        assert.throws(function() {
+            new SecretBox(key, { algorithm: 'aes256gcm' });
+        });
+    });
+});
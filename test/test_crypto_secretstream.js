@@ -0,0 +1,159 @@
+var assert = require('assert');
+var crypto = require('crypto');
+var sodium = require('../build/Release/sodium');
+var SecretStream = require('../lib/secretstream');
+
+var ABYTES = sodium.crypto_secretstream_xchacha20poly1305_ABYTES;
+var TAG_MESSAGE = sodium.crypto_secretstream_xchacha20poly1305_TAG_MESSAGE;
+var TAG_FINAL = sodium.crypto_secretstream_xchacha20poly1305_TAG_FINAL;
+
+// Write `chunks` to `s` and collect its output
+function run(s, chunks, done) {
+    var out = [];
+    s.on('data', function(d) { out.push(d); });
+    s.on('error', function(err) { done(err); });
+    s.on('end', function() { done(null, Buffer.concat(out)); });
+    chunks.forEach(function(c) { s.write(c); });
+    s.end();
+}
+
+// Split `buf` into random sized pieces
+function pieces(buf) {
+    var out = [];
+    var pos = 0;
+    while( pos < buf.length ) {
+        var n = 1 + Math.floor(Math.random() * 5000);
+        out.push(buf.slice(pos, pos + n));
+        pos += n;
+    }
+    return out;
+}
+
+describe('crypto_secretstream_xchacha20poly1305', function() {
+    var key = sodium.crypto_secretstream_xchacha20poly1305_keygen();
+
+    it('should encrypt and decrypt chunks', function(done) {
+        var m1 = Buffer.from('first chunk');
+        var m2 = Buffer.from('second chunk');
+        var ad = Buffer.from('header data');
+
+        var s = sodium.crypto_secretstream_xchacha20poly1305_init_push(key);
+        assert.equal(s.header.length, sodium.crypto_secretstream_xchacha20poly1305_HEADERBYTES);
+        var c1 = sodium.crypto_secretstream_xchacha20poly1305_push(s.state, m1, ad, TAG_MESSAGE);
+        var c2 = sodium.crypto_secretstream_xchacha20poly1305_push(s.state, m2, null, TAG_FINAL);
+        assert.equal(c1.length, m1.length + ABYTES);
+
+        var state = sodium.crypto_secretstream_xchacha20poly1305_init_pull(s.header, key);
+        var r1 = sodium.crypto_secretstream_xchacha20poly1305_pull(state, c1, ad);
+        assert.ok(r1.message.equals(m1));
+        assert.equal(r1.tag, TAG_MESSAGE);
+        var r2 = sodium.crypto_secretstream_xchacha20poly1305_pull(state, c2, null);
+        assert.ok(r2.message.equals(m2));
+        assert.equal(r2.tag, TAG_FINAL);
+        done();
+    });
+
+    it('should reject tampered or reordered chunks', function(done) {
+        var s = sodium.crypto_secretstream_xchacha20poly1305_init_push(key);
+        var c1 = sodium.crypto_secretstream_xchacha20poly1305_push(s.state, Buffer.from('a'), null, TAG_MESSAGE);
+        var c2 = sodium.crypto_secretstream_xchacha20poly1305_push(s.state, Buffer.from('b'), null, TAG_MESSAGE);
+
+        var state = sodium.crypto_secretstream_xchacha20poly1305_init_pull(s.header, key);
+        assert.equal(sodium.crypto_secretstream_xchacha20poly1305_pull(state, c2, null), null);
+
+        state = sodium.crypto_secretstream_xchacha20poly1305_init_pull(s.header, key);
+        c1[0] ^= 1;
+        assert.equal(sodium.crypto_secretstream_xchacha20poly1305_pull(state, c1, null), null);
+        done();
+    });
+
+    it('should rekey both sides', function(done) {
+        var s = sodium.crypto_secretstream_xchacha20poly1305_init_push(key);
+        var state = sodium.crypto_secretstream_xchacha20poly1305_init_pull(s.header, key);
+        sodium.crypto_secretstream_xchacha20poly1305_rekey(s.state);
+        sodium.crypto_secretstream_xchacha20poly1305_rekey(state);
+        var c = sodium.crypto_secretstream_xchacha20poly1305_push(s.state, Buffer.from('abc'), null, TAG_FINAL);
+        var r = sodium.crypto_secretstream_xchacha20poly1305_pull(state, c, null);
+        assert.equal(r.message.toString(), 'abc');
+        done();
+    });
+
+    it('should throw on short cipher text', function(done) {
+        var s = sodium.crypto_secretstream_xchacha20poly1305_init_push(key);
+        var state = sodium.crypto_secretstream_xchacha20poly1305_init_pull(s.header, key);
+        assert.throws(function() {
+            sodium.crypto_secretstream_xchacha20poly1305_pull(state, Buffer.alloc(ABYTES - 1), null);
+        });
+        done();
+    });
+});
+
+describe('SecretStream', function() {
+    var key = SecretStream.keygen();
+    var options = { chunkSize: 1000 };
+
+    [0, 1, 999, 1000, 1001, 5000, 123457].forEach(function(size) {
+        it('should round trip ' + size + ' bytes', function(done) {
+            var plain = crypto.randomBytes(size);
+            run(new SecretStream.Encryptor(key, options), pieces(plain), function(err, cipher) {
+                assert.ifError(err);
+                var chunks = Math.max(1, Math.ceil(size / 1000));
+                assert.equal(cipher.length,
+                    sodium.crypto_secretstream_xchacha20poly1305_HEADERBYTES + size + chunks * ABYTES);
+                run(new SecretStream.Decryptor(key, options), pieces(cipher), function(err, out) {
+                    assert.ifError(err);
+                    assert.ok(out.equals(plain));
+                    done();
+                });
+            });
+        });
+    });
+
+    it('should pipe with the default chunk size', function(done) {
+        var plain = crypto.randomBytes(200000);
+        var enc = new SecretStream.Encryptor(key);
+        var dec = new SecretStream.Decryptor(key);
+        enc.pipe(dec);
+        run({
+            on: dec.on.bind(dec),
+            write: enc.write.bind(enc),
+            end: enc.end.bind(enc)
+        }, [plain], function(err, out) {
+            assert.ifError(err);
+            assert.ok(out.equals(plain));
+            done();
+        });
+    });
+
+    it('should detect truncation', function(done) {
+        var plain = crypto.randomBytes(3500);
+        run(new SecretStream.Encryptor(key, options), [plain], function(err, cipher) {
+            // drop the final chunk
+            var truncated = cipher.slice(0, cipher.length - (500 + ABYTES));
+            run(new SecretStream.Decryptor(key, options), [truncated], function(err) {
+                assert.ok(err instanceof Error);
+                done();
+            });
+        });
+    });
+
+    it('should detect tampering', function(done) {
+        var plain = crypto.randomBytes(3500);
+        run(new SecretStream.Encryptor(key, options), [plain], function(err, cipher) {
+            cipher[cipher.length - 600] ^= 1;
+            run(new SecretStream.Decryptor(key, options), [cipher], function(err) {
+                assert.ok(err instanceof Error);
+                done();
+            });
+        });
+    });
+
+    it('should fail with the wrong key', function(done) {
+        run(new SecretStream.Encryptor(key, options), [Buffer.from('secret')], function(err, cipher) {
+            run(new SecretStream.Decryptor(SecretStream.keygen(), options), [cipher], function(err) {
+                assert.ok(err instanceof Error);
+                done();
+            });
+        });
+    });
+});
@@ -0,0 +1,136 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe('crypto_shorthash', function() {
+    var key = Buffer.alloc(sodium.crypto_shorthash_KEYBYTES);
+    for (var i = 0; i < key.length; i++) {
+        key[i] = i;
+    }
+    // SipHash-2-4 reference vector for an empty message and key 00..0f
+    var emptyHash = '310e0edd47db6f72';
+
+    it('should match the reference vector', function() {
+        assert.equal(sodium.crypto_shorthash(Buffer.alloc(0), key).toString('hex'), emptyHash);
+        assert.equal(sodium.crypto_shorthash_siphash24(Buffer.alloc(0), key).toString('hex'), emptyHash);
+    });
+
+    it('should return the hash as a BigInt or a Number', function() {
+        var m = Buffer.from('bucket key');
+        var h = sodium.crypto_shorthash_siphash24(m, key);
+        assert.strictEqual(sodium.crypto_shorthash_bigint(m, key), h.readBigUInt64LE(0));
+        assert.strictEqual(sodium.crypto_shorthash_siphash24_uint32(m, key), h.readUInt32LE(0));
+        assert.throws(function() { sodium.crypto_shorthash_bigint(m, Buffer.alloc(8)); });
+    });
+
+    it('should hash a packed batch', function() {
+        var messages = [Buffer.from('a'), Buffer.alloc(0), Buffer.from('longer message')];
+        var packed = Buffer.concat(messages);
+        var lengths = messages.map(function(m) { return m.length; });
+        var expected = messages.map(function(m) { return sodium.crypto_shorthash(m, key); });
+
+        var hashes = sodium.crypto_shorthash_batch(packed, lengths, key);
+        assert(hashes instanceof BigUint64Array);
+        assert.equal(hashes.length, 3);
+
+        var low = new Uint32Array(3);
+        assert.strictEqual(sodium.crypto_shorthash_siphash24_batch(packed, lengths, key, low), low);
+        var halves = sodium.crypto_shorthash_siphash24_batch(packed, new Uint32Array(lengths), key, new Uint32Array(6));
+        var bytes = sodium.crypto_shorthash_siphash24_batch(packed, lengths, key, Buffer.alloc(24));
+
+        expected.forEach(function(h, i) {
+            assert.strictEqual(hashes[i], h.readBigUInt64LE(0));
+            assert.strictEqual(low[i], h.readUInt32LE(0));
+            assert.strictEqual(halves[2 * i], h.readUInt32LE(0));
+            assert.strictEqual(halves[2 * i + 1], h.readUInt32LE(4));
+            assert(bytes.slice(8 * i, 8 * i + 8).equals(h));
+        });
+    });
+
+    it('should hash 128 bits with SipHashX-2-4', function() {
+        // SipHash-2-4 128 bit reference vector for an empty message and key 00..0f
+        assert.equal(sodium.crypto_shorthash_siphashx24(Buffer.alloc(0), key).toString('hex'),
+                     'a3817f04ba25a8e66df67214c7550293');
+        assert.equal(sodium.crypto_shorthash_siphashx24_BYTES, 16);
+        assert.throws(function() { sodium.crypto_shorthash_siphashx24(Buffer.alloc(0), Buffer.alloc(8)); });
+
+        var messages = [Buffer.from('a'), Buffer.alloc(0), Buffer.from('longer message')];
+        var packed = Buffer.concat(messages);
+        var lengths = messages.map(function(m) { return m.length; });
+        var pairs = sodium.crypto_shorthash_siphashx24_batch(packed, lengths, key);
+        var bytes = sodium.crypto_shorthash_siphashx24_batch(packed, lengths, key, Buffer.alloc(48));
+        assert(pairs instanceof BigUint64Array);
+        assert.equal(pairs.length, 6);
+        messages.forEach(function(m, i) {
+            var h = sodium.crypto_shorthash_siphashx24(m, key);
+            assert.strictEqual(pairs[2 * i], h.readBigUInt64LE(0));
+            assert.strictEqual(pairs[2 * i + 1], h.readBigUInt64LE(8));
+            assert(bytes.slice(16 * i, 16 * i + 16).equals(h));
+        });
+        assert.throws(function() {
+            sodium.crypto_shorthash_siphashx24_batch(packed, lengths, key, new BigUint64Array(3));
+        });
+    });
+
+    it('should cut fixed size messages and check the output', function() {
+        var ids = Buffer.alloc(64, 0xab);
+        var hashes = sodium.crypto_shorthash_siphash24_batch(ids, 16, key);
+        assert.equal(hashes.length, 4);
+        assert.strictEqual(hashes[3], sodium.crypto_shorthash_bigint(ids.slice(48), key));
+        assert.throws(function() { sodium.crypto_shorthash_batch(ids, 16, key, new Uint32Array(3)); });
+        assert.throws(function() { sodium.crypto_shorthash_batch(ids, 16, key, new Float64Array(4)); });
+        assert.throws(function() { sodium.crypto_shorthash_batch(ids, [10], key); });
+    });
+
+    it('should pick nodes by rendezvous hashing', function() {
+        var ids = [];
+        for (var i = 0; i < 8; i++) {
+            ids.push(Buffer.from('node-' + i));
+        }
+        var nodes = sodium.crypto_shorthash_batch(Buffer.concat(ids), 6, key);
+
+        // The winner is the best score: the hash of the message hash and the node hash
+        function score(m, node) {
+            var pair = Buffer.alloc(16);
+            pair.writeBigUInt64LE(sodium.crypto_shorthash_bigint(m, key), 0);
+            pair.writeBigUInt64LE(node, 8);
+            return sodium.crypto_shorthash_bigint(pair, key);
+        }
+        var messages = [Buffer.from('user 1'), Buffer.from('user 2'), Buffer.from('user 3')];
+        messages.forEach(function(m) {
+            var scores = Array.from(nodes).map(function(node) { return score(m, node); });
+            var ranking = scores.map(function(s, i) { return i; }).sort(function(a, b) {
+                return scores[a] < scores[b] ? 1 : -1;
+            });
+            assert.strictEqual(sodium.crypto_shorthash_rendezvous(m, nodes, key), ranking[0]);
+            assert.deepEqual(Array.from(sodium.crypto_shorthash_rendezvous(m, nodes, key, 3)), ranking.slice(0, 3));
+
+            // Removing a losing node does not move the message
+            var others = nodes.filter(function(n, i) { return i !== ranking[7]; });
+            assert.strictEqual(others[sodium.crypto_shorthash_rendezvous(m, others, key)], nodes[ranking[0]]);
+        });
+
+        var winners = sodium.crypto_shorthash_rendezvous_batch(Buffer.from('user 1user 2user 3'), 6, nodes, key);
+        messages.forEach(function(m, i) {
+            assert.strictEqual(winners[i], sodium.crypto_shorthash_rendezvous(m, nodes, key));
+        });
+        assert.throws(function() { sodium.crypto_shorthash_rendezvous(messages[0], new BigUint64Array(0), key); });
+        assert.throws(function() { sodium.crypto_shorthash_rendezvous(messages[0], nodes, key, 9); });
+    });
+
+    it('should jump hash into buckets', function() {
+        var moved = 0;
+        for (var i = 0; i < 1000; i++) {
+            var m = Buffer.from('item ' + i);
+            var a = sodium.crypto_shorthash_jump(m, 10, key);
+            var b = sodium.crypto_shorthash_jump(m, 11, key);
+            assert(a >= 0 && a < 10);
+            if (a !== b) {
+                assert.strictEqual(b, 10);
+                moved++;
+            }
+        }
+        assert(moved > 40 && moved < 150);
+        assert.strictEqual(sodium.crypto_shorthash_jump(Buffer.from('x'), 1, key), 0);
+        assert.throws(function() { sodium.crypto_shorthash_jump(Buffer.from('x'), 0, key); });
+    });
+});
@@ -109,4 +109,47 @@ describe('Sign', function() {
         });
         done();
     });
+
+    it('open_view should return a view on the signed message', function(done) {
+        var message = Buffer.from("Libsodium is cool", 'utf8');
+        var keys = sodium.crypto_sign_keypair();
+        var signedMsg = sodium.crypto_sign(message, keys.secretKey);
+
+        var view = sodium.crypto_sign_open_view(signedMsg, keys.publicKey);
+        assert.ok(view.equals(message));
+        assert.strictEqual(view.buffer, signedMsg.buffer);
+        assert.strictEqual(view.byteOffset, signedMsg.byteOffset + sodium.crypto_sign_BYTES);
+
+        signedMsg[signedMsg.length - 1] ^= 1;
+        assert.strictEqual(sodium.crypto_sign_open_view(signedMsg, keys.publicKey), null);
+        assert.strictEqual(sodium.crypto_sign_open_view(Buffer.alloc(10), keys.publicKey), null);
+        done();
+    });
+
+    it('into functions should sign and open in caller buffers', function(done) {
+        var message = Buffer.from("Libsodium is cool", 'utf8');
+        var keys = sodium.crypto_sign_keypair();
+        var signedMsg = sodium.crypto_sign(message, keys.secretKey);
+
+        var out = Buffer.alloc(signedMsg.length + 3);
+        assert.strictEqual(sodium.crypto_sign_into(out, 3, message, keys.secretKey), signedMsg.length);
+        assert.ok(out.slice(3).equals(signedMsg));
+
+        // Message already in place after the signature
+        var frame = Buffer.alloc(sodium.crypto_sign_BYTES + message.length);
+        message.copy(frame, sodium.crypto_sign_BYTES);
+        sodium.crypto_sign_into(frame, 0, frame.slice(sodium.crypto_sign_BYTES), keys.secretKey);
+        assert.ok(frame.equals(signedMsg));
+
+        var plain = Buffer.alloc(message.length + 1);
+        assert.strictEqual(sodium.crypto_sign_open_into(plain, 1, signedMsg, keys.publicKey), message.length);
+        assert.ok(plain.slice(1).equals(message));
+
+        assert.throws(function() {
+            sodium.crypto_sign_open_into(Buffer.alloc(4), 0, signedMsg, keys.publicKey);
+        });
+        signedMsg[0] ^= 1;
+        assert.strictEqual(sodium.crypto_sign_open_into(plain, 0, signedMsg, keys.publicKey), null);
+        done();
+    });
 });
@@ -0,0 +1,162 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+function isSet(bitmap, i) {
+    return (bitmap[i >> 3] & (1 << (i & 7))) !== 0;
+}
+
+function makeBatch(n) {
+    var batch = { signatures: [], messages: [], publicKeys: [] };
+    var keys = [sodium.crypto_sign_ed25519_keypair(), sodium.crypto_sign_ed25519_keypair()];
+    for (var i = 0; i < n; i++) {
+        var kp = keys[i % 2];
+        var m = Buffer.from('event number ' + i);
+        batch.messages.push(m);
+        batch.signatures.push(sodium.crypto_sign_ed25519_detached(m, kp.secretKey));
+        batch.publicKeys.push(kp.publicKey);
+    }
+    return batch;
+}
+
+// Signatures with points of small order, that a cofactored check accepts
+var SMALL_ORDER = [
+    // R plus a point of order 8
+    { pk: '8e28b6098782d38e773d8c52120cb1f984f6d7863d15c7bc3dd07ca944ed3aa0',
+      sig: 'ecadd1a51e109f77c5cc12fdefcedc75f586124b4bad3de2e4f79b071b8bc147' +
+           'b9bd10eeb145b7992075780b755f496c3db5b6d3b3173e4288076994b9e8db00',
+      m: 'R plus a point of order 8', valid: false },
+    // R plus the point of order 2
+    { pk: '8e28b6098782d38e773d8c52120cb1f984f6d7863d15c7bc3dd07ca944ed3aa0',
+      sig: 'b81aca857a71e450ae6c32ad2780aa7d3edfe174d0e10f9df8da2dfca638643e' +
+           '027a28ee825c2abea243b015f73c9c472a0560d70e3a784ecfe90555eb9f1105',
+      m: 'R plus the point of order 2', valid: false },
+    // Accepted, key and R with small order components
+    { pk: 'f1b7ace445df6065e3250753773a2c340c0945a931dd81be8db2883c3b8a8c95',
+      sig: 'e75d149b74f0a7760061b1615a37da68237f01769a88db4ed73d08bf97999829' +
+           '0aa9c4687bbb9b75ef1b57f89d386775a3f8a112cc893b8afead135409a22d0a',
+      m: 'key with a small order component', valid: true },
+    // Rejected, key with a small order component
+    { pk: 'f1b7ace445df6065e3250753773a2c340c0945a931dd81be8db2883c3b8a8c95',
+      sig: 'b673cffd4d70e0b4c02010618bc8fe4c114fbb8d4f0460c4afc3283fd3aacfe7' +
+           '8c8725263bc0f6901d036a13f23d24c42fab2be1adb9af9068ee692acc8d8b00',
+      m: 'key with a small order component, rejected', valid: false }
+];
+
+describe('crypto_sign_ed25519_verify_detached_batch', function() {
+    it('should verify an array batch', function(done) {
+        var b = makeBatch(21);
+        b.signatures[3] = Buffer.from(b.signatures[3]);
+        b.signatures[3][0] ^= 1;
+        b.messages[20] = Buffer.from('tampered');
+
+        var bitmap = sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, b.messages, b.publicKeys);
+        assert.equal(bitmap.length, 3);
+        for (var i = 0; i < 21; i++) {
+            assert.equal(isSet(bitmap, i), i !== 3 && i !== 20, 'item ' + i);
+        }
+        assert.equal(bitmap[2] & 0xe0, 0);
+        done();
+    });
+
+    it('should accept packed signatures and keys', function(done) {
+        var b = makeBatch(10);
+        var bitmap = sodium.crypto_sign_ed25519_verify_detached_batch(
+            Buffer.concat(b.signatures), b.messages, Buffer.concat(b.publicKeys));
+        assert.equal(bitmap[0], 0xff);
+        assert.equal(bitmap[1], 0x03);
+        done();
+    });
+
+    it('should give the same result with threads', function(done) {
+        var b = makeBatch(500);
+        b.publicKeys[450] = b.publicKeys[451];
+        var one = sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, b.messages, b.publicKeys);
+        var many = sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, b.messages, b.publicKeys, 4);
+        assert(one.equals(many));
+        assert(!isSet(many, 450));
+        assert(isSet(many, 451));
+        done();
+    });
+
+    it('should find bad signatures in groups of 64', function(done) {
+        var b = makeBatch(200);
+        var bad = [0, 63, 64, 130, 199];
+        bad.forEach(function(i) {
+            b.signatures[i] = Buffer.from(b.signatures[i]);
+            b.signatures[i][40] ^= 1;
+        });
+        var bitmap = sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, b.messages, b.publicKeys);
+        for (var i = 0; i < 200; i++) {
+            assert.equal(isSet(bitmap, i), bad.indexOf(i) === -1, 'item ' + i);
+            assert.equal(isSet(bitmap, i),
+                sodium.crypto_sign_ed25519_verify_detached(b.signatures[i], b.messages[i], b.publicKeys[i]));
+        }
+        done();
+    });
+
+    it('should agree with single verification on points of small order', function() {
+        var b = makeBatch(200);
+        [1, 63, 64, 100, 150, 199].forEach(function(at, k) {
+            var v = SMALL_ORDER[k % SMALL_ORDER.length];
+            b.signatures[at] = Buffer.from(v.sig, 'hex');
+            b.messages[at] = Buffer.from(v.m);
+            b.publicKeys[at] = Buffer.from(v.pk, 'hex');
+        });
+        SMALL_ORDER.forEach(function(v) {
+            assert.equal(sodium.crypto_sign_ed25519_verify_detached(
+                Buffer.from(v.sig, 'hex'), Buffer.from(v.m), Buffer.from(v.pk, 'hex')), v.valid);
+        });
+
+        var check = function(bitmap) {
+            for (var i = 0; i < 200; i++) {
+                assert.equal(isSet(bitmap, i),
+                    sodium.crypto_sign_ed25519_verify_detached(b.signatures[i], b.messages[i], b.publicKeys[i]),
+                    'item ' + i);
+            }
+        };
+        for (var round = 0; round < 10; round++) {
+            check(sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, b.messages, b.publicKeys));
+        }
+        check(sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, b.messages, b.publicKeys, 3));
+        return sodium.crypto_sign_ed25519_verify_detached_batch_async(b.signatures, b.messages, b.publicKeys)
+            .then(check);
+    });
+
+    it('should handle an empty batch', function(done) {
+        var bitmap = sodium.crypto_sign_ed25519_verify_detached_batch([], [], []);
+        assert.equal(bitmap.length, 0);
+        done();
+    });
+
+    it('should throw on mismatched batches', function(done) {
+        var b = makeBatch(4);
+        assert.throws(function() {
+            sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures.slice(1), b.messages, b.publicKeys);
+        });
+        assert.throws(function() {
+            sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, b.messages, Buffer.alloc(10));
+        });
+        done();
+    });
+
+    it('should not let signatures or keys size an empty messages array', function() {
+        var b = makeBatch(1);
+        assert.throws(function() {
+            sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures, [], b.publicKeys);
+        }, /must have 0 elements/);
+        assert.throws(function() {
+            sodium.crypto_sign_ed25519_verify_detached_batch(b.signatures[0], [], b.publicKeys[0]);
+        }, /must be 0 x 64/);
+        assert.throws(function() {
+            sodium.crypto_sign_ed25519_verify_detached_batch_async(b.signatures, [], b.publicKeys);
+        }, /must have 0 elements/);
+        assert.throws(function() {
+            sodium.crypto_sign_ed25519_verify_detached_batch_stream(b.signatures, [], b.publicKeys, {
+                onChunk: function() {}
+            });
+        }, /must have 0 elements/);
+        return sodium.crypto_sign_ed25519_verify_detached_batch_async([], [], []).then(function(bitmap) {
+            assert.equal(bitmap.length, 0);
+        });
+    });
+});
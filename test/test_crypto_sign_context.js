@@ -0,0 +1,141 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe('SigningKey', function() {
+    var kp = sodium.crypto_sign_ed25519_keypair();
+    var messages = [];
+    for (var i = 0; i < 100; i++) {
+        messages.push(Buffer.from('token ' + i));
+    }
+    messages.push(Buffer.alloc(0));
+
+    it('should sign like crypto_sign_ed25519_detached', function(done) {
+        var key = new sodium.SigningKey(kp.secretKey);
+        assert(key.publicKey.equals(kp.publicKey));
+        var sig = key.sign(messages[0]);
+        assert(sig.equals(sodium.crypto_sign_ed25519_detached(messages[0], kp.secretKey)));
+        assert(sodium.crypto_sign_ed25519_verify_detached(sig, messages[0], kp.publicKey));
+        done();
+    });
+
+    it('should accept a seed', function(done) {
+        var seed = Buffer.alloc(sodium.crypto_sign_ed25519_SEEDBYTES, 9);
+        var skp = sodium.crypto_sign_ed25519_seed_keypair(seed);
+        var key = new sodium.SigningKey(seed);
+        assert(key.publicKey.equals(skp.publicKey));
+        assert(key.sign(messages[1]).equals(sodium.crypto_sign_ed25519_detached(messages[1], skp.secretKey)));
+        done();
+    });
+
+    it('signBatch should return packed signatures', function(done) {
+        var key = new sodium.SigningKey(kp.secretKey);
+        [undefined, 4].forEach(function(threads) {
+            var sigs = key.signBatch(messages, threads);
+            assert.equal(sigs.length, messages.length * sodium.crypto_sign_ed25519_BYTES);
+            var bitmap = sodium.crypto_sign_ed25519_verify_detached_batch(sigs, messages,
+                Buffer.concat(messages.map(function() { return kp.publicKey; })));
+            for (var i = 0; i < messages.length; i++) {
+                assert(bitmap[i >> 3] & (1 << (i & 7)));
+            }
+            assert(sigs.slice(64, 128).equals(key.sign(messages[1])));
+        });
+        done();
+    });
+
+    it('signBatchAsync should match signBatch', function(done) {
+        var key = new sodium.SigningKey(kp.secretKey);
+        var expected = key.signBatch(messages);
+        var p = key.signBatchAsync(messages);
+        assert(p instanceof Promise);
+        p.then(function(sigs) {
+            assert(sigs.equals(expected));
+            key.signBatchAsync(messages, function(err, sigs) {
+                assert.ifError(err);
+                assert(sigs.equals(expected));
+                done();
+            });
+            key.dispose();
+        }).catch(done);
+    });
+
+    it('should throw after dispose', function(done) {
+        var key = new sodium.SigningKey(kp.secretKey);
+        key.dispose();
+        assert.throws(function() { key.sign(messages[0]); });
+        assert.throws(function() { key.signBatch(messages); });
+        key.dispose();
+        done();
+    });
+
+    it('should reject bad keys', function(done) {
+        assert.throws(function() { new sodium.SigningKey(Buffer.alloc(10)); });
+        assert.throws(function() { new sodium.SigningKey('key'); });
+        done();
+    });
+});
+
+describe('VerifyKey', function() {
+    var kp = sodium.crypto_sign_ed25519_keypair();
+    var messages = [];
+    for (var i = 0; i < 100; i++) {
+        messages.push(Buffer.from('token ' + i));
+    }
+    messages.push(Buffer.alloc(0));
+    var signer = new sodium.SigningKey(kp.secretKey);
+    var sigs = signer.signBatch(messages);
+
+    it('should verify like crypto_sign_ed25519_verify_detached', function(done) {
+        var key = new sodium.VerifyKey(kp.publicKey);
+        assert(key.publicKey.equals(kp.publicKey));
+        for (var i = 0; i < messages.length; i++) {
+            var sig = sigs.slice(i * 64, (i + 1) * 64);
+            assert.strictEqual(key.verify(sig, messages[i]), true);
+            assert.strictEqual(key.verify(sig, Buffer.from('forged')), false);
+        }
+        var bad = Buffer.from(sigs.slice(0, 64));
+        bad[5] ^= 1;
+        assert.strictEqual(key.verify(bad, messages[0]), false);
+        assert.strictEqual(sodium.crypto_sign_ed25519_verify_detached(bad, messages[0], kp.publicKey), false);
+        done();
+    });
+
+    it('should not verify signatures of another key', function(done) {
+        var other = sodium.crypto_sign_ed25519_keypair();
+        var key = new sodium.VerifyKey(other.publicKey);
+        assert.strictEqual(key.verify(sigs.slice(0, 64), messages[0]), false);
+        done();
+    });
+
+    it('verifyBatch should return a bitmap', function(done) {
+        var key = new sodium.VerifyKey(kp.publicKey);
+        var forged = Buffer.from(sigs);
+        forged[3 * 64] ^= 1;
+        [undefined, 4].forEach(function(threads) {
+            var bitmap = key.verifyBatch(forged, messages, threads);
+            assert.equal(bitmap.length, Math.ceil(messages.length / 8));
+            for (var i = 0; i < messages.length; i++) {
+                assert.equal(!!(bitmap[i >> 3] & (1 << (i & 7))), i !== 3);
+            }
+        });
+        done();
+    });
+
+    it('should reject invalid public keys', function(done) {
+        assert.throws(function() { new sodium.VerifyKey(Buffer.alloc(10)); });
+        assert.throws(function() { new sodium.VerifyKey('key'); });
+        // The identity point has small order
+        var identity = Buffer.alloc(32);
+        identity[0] = 1;
+        assert.throws(function() { new sodium.VerifyKey(identity); });
+        done();
+    });
+
+    it('should throw after dispose', function(done) {
+        var key = new sodium.VerifyKey(kp.publicKey);
+        key.dispose();
+        assert.throws(function() { key.verify(sigs.slice(0, 64), messages[0]); });
+        assert.throws(function() { key.publicKey; });
+        key.dispose();
+        done();
+    });
+});
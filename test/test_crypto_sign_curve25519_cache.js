@@ -0,0 +1,65 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_sign_ed25519_pk_to_curve25519 cache", function () {
+    var kp = sodium.crypto_sign_ed25519_keypair();
+    var expected = sodium.crypto_sign_ed25519_pk_to_curve25519(kp.publicKey);
+
+    after(function () {
+        sodium.crypto_sign_ed25519_pk_cache_disable();
+    });
+
+    it("should be disabled by default", function (done) {
+        var stats = sodium.crypto_sign_ed25519_pk_cache_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.strictEqual(stats.size, 0);
+        done();
+    });
+
+    it("should give the same results enabled and disabled", function (done) {
+        sodium.crypto_sign_ed25519_pk_cache_enable(4);
+        for (var i = 0; i < 3; i++) {
+            assert(sodium.crypto_sign_ed25519_pk_to_curve25519(kp.publicKey).equals(expected));
+        }
+        assert.throws(function () {
+            sodium.crypto_sign_ed25519_pk_to_curve25519(Buffer.alloc(32));
+        });
+
+        var stats = sodium.crypto_sign_ed25519_pk_cache_stats();
+        assert.strictEqual(stats.size, 1);
+        assert.strictEqual(stats.hits, 2);
+        assert.strictEqual(stats.misses, 2);
+        done();
+    });
+
+    it("should evict the least recently used key", function (done) {
+        sodium.crypto_sign_ed25519_pk_cache_enable(2);
+        var keys = [0, 1, 2].map(function () { return sodium.crypto_sign_ed25519_keypair().publicKey; });
+        [0, 1, 0, 2, 0, 1].forEach(function (i) {
+            sodium.crypto_sign_ed25519_pk_to_curve25519(keys[i]);
+        });
+
+        var stats = sodium.crypto_sign_ed25519_pk_cache_stats();
+        assert.strictEqual(stats.size, 2);
+        assert.strictEqual(stats.hits, 2);
+        assert.strictEqual(stats.misses, 4);
+        assert.strictEqual(stats.evictions, 2);
+
+        sodium.crypto_sign_ed25519_pk_cache_clear();
+        assert.strictEqual(sodium.crypto_sign_ed25519_pk_cache_stats().size, 0);
+        done();
+    });
+
+    it("VerifyKey should expose the converted key for boxes", function (done) {
+        var key = new sodium.VerifyKey(kp.publicKey);
+        assert(key.curve25519PublicKey.equals(expected));
+        assert(key.curve25519PublicKey.equals(expected));
+
+        var bob = sodium.crypto_box_keypair();
+        var curveSk = sodium.crypto_sign_ed25519_sk_to_curve25519(kp.secretKey);
+        var nonce = Buffer.alloc(sodium.crypto_box_NONCEBYTES, 1);
+        var c = sodium.crypto_box_easy(Buffer.from("hi"), nonce, key.curve25519PublicKey, bob.secretKey);
+        assert(sodium.crypto_box_open_easy(c, nonce, bob.publicKey, curveSk).equals(Buffer.from("hi")));
+        done();
+    });
+});
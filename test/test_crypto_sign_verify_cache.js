@@ -0,0 +1,94 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_sign verification cache", function () {
+    var kp = sodium.crypto_sign_keypair();
+    var m = Buffer.from("gossip message");
+    var sig = sodium.crypto_sign_detached(m, kp.secretKey);
+
+    after(function () {
+        sodium.crypto_sign_verify_cache_disable();
+    });
+
+    it("should be disabled by default", function (done) {
+        var stats = sodium.crypto_sign_verify_cache_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.strictEqual(stats.size, 0);
+        done();
+    });
+
+    it("should give the same results enabled and disabled", function (done) {
+        var forged = Buffer.from(sig);
+        forged[0] ^= 1;
+
+        sodium.crypto_sign_verify_cache_enable(8);
+        for (var i = 0; i < 3; i++) {
+            assert.strictEqual(sodium.crypto_sign_verify_detached(sig, m, kp.publicKey), true);
+            assert.strictEqual(sodium.crypto_sign_ed25519_verify_detached(sig, m, kp.publicKey), true);
+            assert.strictEqual(sodium.crypto_sign_verify_detached(forged, m, kp.publicKey), false);
+            assert.strictEqual(sodium.crypto_sign_verify_detached(sig, Buffer.from("other"), kp.publicKey), false);
+        }
+
+        var stats = sodium.crypto_sign_verify_cache_stats();
+        assert.strictEqual(stats.enabled, true);
+        assert.strictEqual(stats.size, 1);
+        assert.strictEqual(stats.hits, 5);
+        assert.strictEqual(stats.misses, 7);
+        assert.strictEqual(stats.rejects, 6);
+        assert.strictEqual(stats.hitRate, 5 / 12);
+        done();
+    });
+
+    it("should evict the least recently used signature", function (done) {
+        sodium.crypto_sign_verify_cache_enable(2);
+        var msgs = [0, 1, 2].map(function (i) { return Buffer.from("message " + i); });
+        var sigs = msgs.map(function (msg) { return sodium.crypto_sign_detached(msg, kp.secretKey); });
+        var verify = function (i) {
+            assert(sodium.crypto_sign_verify_detached(sigs[i], msgs[i], kp.publicKey));
+        };
+
+        verify(0);
+        verify(1);
+        verify(0);
+        verify(2);          // evicts 1
+        verify(0);
+        verify(1);
+
+        var stats = sodium.crypto_sign_verify_cache_stats();
+        assert.strictEqual(stats.capacity, 2);
+        assert.strictEqual(stats.size, 2);
+        assert.strictEqual(stats.hits, 2);
+        assert.strictEqual(stats.misses, 4);
+        assert.strictEqual(stats.evictions, 2);
+        done();
+    });
+
+    it("should expire entries", function (done) {
+        sodium.crypto_sign_verify_cache_enable(4, 1);
+        sodium.crypto_sign_verify_detached(sig, m, kp.publicKey);
+        setTimeout(function () {
+            assert(sodium.crypto_sign_verify_detached(sig, m, kp.publicKey));
+            var stats = sodium.crypto_sign_verify_cache_stats();
+            assert.strictEqual(stats.hits, 0);
+            assert.strictEqual(stats.misses, 2);
+            assert.strictEqual(stats.expirations, 1);
+            assert.strictEqual(stats.size, 1);
+            done();
+        }, 20);
+    });
+
+    it("should clear and disable", function (done) {
+        sodium.crypto_sign_verify_cache_enable(4);
+        sodium.crypto_sign_verify_detached(sig, m, kp.publicKey);
+        sodium.crypto_sign_verify_cache_clear();
+        assert.strictEqual(sodium.crypto_sign_verify_cache_stats().size, 0);
+        assert.strictEqual(sodium.crypto_sign_verify_cache_stats().enabled, true);
+
+        sodium.crypto_sign_verify_cache_disable();
+        assert(sodium.crypto_sign_verify_detached(sig, m, kp.publicKey));
+        var stats = sodium.crypto_sign_verify_cache_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.strictEqual(stats.size, 0);
+        done();
+    });
+});
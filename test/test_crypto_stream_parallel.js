@@ -0,0 +1,52 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("crypto_stream_*_xor_parallel", function () {
+    var blob = Buffer.alloc(300 * 1024 + 17);
+    sodium.randombytes_buf(blob);
+
+    ['chacha20', 'chacha20_ietf', 'xchacha20', 'salsa20', 'xsalsa20'].forEach(function (algo) {
+        var prefix = 'crypto_stream_' + algo;
+        var nonce = Buffer.alloc(sodium[prefix + '_NONCEBYTES'], 1);
+        var key = Buffer.alloc(sodium[prefix + '_KEYBYTES'], 2);
+        var whole = sodium[prefix + '_xor'](blob, nonce, key);
+
+        it(algo + " should match _xor across threads", function (done) {
+            assert(sodium[prefix + '_xor_parallel'](blob, nonce, 0, key).equals(whole));
+            assert(sodium[prefix + '_xor_parallel'](blob, nonce, 0, key, 4).equals(whole));
+            done();
+        });
+
+        it(algo + " should decrypt any byte range", function (done) {
+            [[0, 1], [5, 59], [63, 2], [64, 64], [100, 200000], [blob.length - 1, 1]].forEach(function (r) {
+                var start = r[0], length = r[1];
+                var part = sodium[prefix + '_xor_parallel'](whole, start, length, nonce, start, key, 3);
+                assert(part.equals(blob.slice(start, start + length)), algo + ' ' + start);
+            });
+            assert.strictEqual(sodium[prefix + '_xor_parallel'](whole, 10, 0, nonce, 10, key).length, 0);
+            done();
+        });
+    });
+
+    it("xchacha20 should be bound like the other streams", function (done) {
+        var nonce = Buffer.alloc(sodium.crypto_stream_xchacha20_NONCEBYTES, 3);
+        var key = Buffer.alloc(sodium.crypto_stream_xchacha20_KEYBYTES, 4);
+        var c = sodium.crypto_stream_xchacha20_xor(blob, nonce, key);
+        assert(sodium.crypto_stream_xchacha20_xor_ic(blob, nonce, 0, key).equals(c));
+        assert(sodium.crypto_stream_xchacha20(64, nonce, key).equals(sodium.crypto_stream_xchacha20_xor(Buffer.alloc(64), nonce, key)));
+        done();
+    });
+
+    it("should reject positions past the key stream", function (done) {
+        var nonce = Buffer.alloc(sodium.crypto_stream_chacha20_ietf_NONCEBYTES);
+        var key = Buffer.alloc(sodium.crypto_stream_chacha20_ietf_KEYBYTES);
+        assert.throws(function () {
+            sodium.crypto_stream_chacha20_ietf_xor_parallel(Buffer.alloc(65), nonce, 64 * Math.pow(2, 32) - 64, key);
+        });
+        assert.throws(function () {
+            sodium.crypto_stream_chacha20_xor_parallel(Buffer.alloc(1), Buffer.alloc(8), -1, Buffer.alloc(32));
+        });
+        assert.strictEqual(sodium.crypto_stream_chacha20_ietf_xor_parallel(Buffer.alloc(64), nonce, 64 * Math.pow(2, 32) - 64, key).length, 64);
+        done();
+    });
+});
@@ -34,3 +34,121 @@ describe("memzero verify parameters", function () {
         done();
     });
 });
+
+describe("sodium_pad", function () {
+    it("should pad to the block size", function (done) {
+        [0, 1, 15, 16, 17].forEach(function (len) {
+            var data = Buffer.alloc(len, 0xaa);
+            var padded = sodium.sodium_pad(data, 16);
+            assert.strictEqual(padded.length, (Math.floor(len / 16) + 1) * 16);
+            assert(padded.slice(0, len).equals(data));
+            assert.strictEqual(padded[len], 0x80);
+            assert(sodium.is_zero(padded.slice(len + 1)));
+
+            var unpadded = sodium.sodium_unpad(padded, 16);
+            assert(unpadded.equals(data));
+            assert.strictEqual(unpadded.buffer, padded.buffer);
+        });
+        done();
+    });
+
+    it("should pad in place", function (done) {
+        var record = Buffer.alloc(64);
+        record.write("hello");
+        var len = sodium.sodium_pad_into(record, 5, 32);
+        assert.strictEqual(len, 32);
+        assert(sodium.sodium_unpad(record.slice(0, len), 32).equals(Buffer.from("hello")));
+        assert.throws(function () {
+            sodium.sodium_pad_into(Buffer.alloc(16), 16, 16);
+        });
+        done();
+    });
+
+    it("should reject bad padding", function (done) {
+        assert.strictEqual(sodium.sodium_unpad(Buffer.alloc(16), 16), null);
+        assert.throws(function () {
+            sodium.sodium_pad(Buffer.alloc(4), 0);
+        });
+        done();
+    });
+
+    it("should export the sodium_ names of the number helpers", function (done) {
+        var n = Buffer.from([0xff, 0]);
+        sodium.sodium_increment(n);
+        assert(n.equals(Buffer.from([0, 1])));
+        sodium.sodium_add(n, Buffer.from([1, 0]));
+        assert.strictEqual(sodium.sodium_compare(n, Buffer.from([1, 1])), 0);
+        assert.strictEqual(sodium.sodium_is_zero(Buffer.alloc(3)), 1);
+        done();
+    });
+});
+
+describe("hex and base64 codecs", function () {
+    var variants = [
+        [sodium.sodium_base64_VARIANT_ORIGINAL, function (b) { return b.toString('base64'); }],
+        [sodium.sodium_base64_VARIANT_ORIGINAL_NO_PADDING, function (b) { return b.toString('base64').replace(/=+$/, ''); }],
+        [sodium.sodium_base64_VARIANT_URLSAFE, function (b) { return b.toString('base64').replace(/\+/g, '-').replace(/\//g, '_'); }],
+        [sodium.sodium_base64_VARIANT_URLSAFE_NO_PADDING, function (b) { return b.toString('base64url'); }]
+    ];
+
+    it("should match Buffer hex encoding", function (done) {
+        [0, 1, 31, 256, 257, 1000].forEach(function (len) {
+            var data = Buffer.alloc(len);
+            sodium.randombytes_buf(data);
+            var hex = sodium.sodium_bin2hex(data);
+            assert.strictEqual(hex, data.toString('hex'));
+            assert(sodium.sodium_hex2bin(hex).equals(data));
+            assert(sodium.sodium_hex2bin(Buffer.from(hex.toUpperCase())).equals(data));
+
+            var out = Buffer.alloc(2 * len + 3);
+            assert.strictEqual(sodium.sodium_bin2hex_into(out, data), 2 * len);
+            assert.strictEqual(out.slice(0, 2 * len).toString(), hex);
+        });
+        done();
+    });
+
+    it("should decode hex with ignored characters", function (done) {
+        assert(sodium.sodium_hex2bin("de:ad be:ef", ": ").equals(Buffer.from("deadbeef", "hex")));
+        var out = Buffer.alloc(8);
+        assert.strictEqual(sodium.sodium_hex2bin_into(out, "0102"), 2);
+        assert.strictEqual(sodium.sodium_hex2bin_into(Buffer.alloc(1), "0102"), null);
+        assert.strictEqual(sodium.sodium_hex2bin("abc"), null);
+        assert.strictEqual(sodium.sodium_hex2bin("zz"), null);
+        assert(sodium.hex2bin("0102").equals(Buffer.from([1, 2])));
+        done();
+    });
+
+    it("should match Buffer base64 encoding for every variant", function (done) {
+        [0, 1, 2, 3, 767, 768, 769, 2000].forEach(function (len) {
+            var data = Buffer.alloc(len);
+            sodium.randombytes_buf(data);
+            variants.forEach(function (v) {
+                var text = sodium.sodium_bin2base64(data, v[0]);
+                assert.strictEqual(text, v[1](data));
+                assert.strictEqual(sodium.sodium_base64_encoded_len(len, v[0]), text.length);
+                assert(sodium.sodium_base642bin(text, v[0]).equals(data));
+
+                var out = Buffer.alloc(text.length);
+                assert.strictEqual(sodium.sodium_bin2base64_into(out, data, v[0]), text.length);
+                assert.strictEqual(out.toString(), text);
+                var bin = Buffer.alloc(len + 1);
+                assert.strictEqual(sodium.sodium_base642bin_into(bin, out, v[0]), len);
+            });
+        });
+        done();
+    });
+
+    it("should reject base64 of another variant", function (done) {
+        assert.strictEqual(sodium.sodium_bin2base64(Buffer.alloc(1)), "AA==");
+        assert.strictEqual(sodium.sodium_base642bin("AA", sodium.sodium_base64_VARIANT_ORIGINAL), null);
+        assert.strictEqual(sodium.sodium_base642bin("-_8=", sodium.sodium_base64_VARIANT_ORIGINAL), null);
+        assert(sodium.sodium_base642bin("AA\nAA", undefined, "\n").equals(Buffer.alloc(3)));
+        assert.throws(function () {
+            sodium.sodium_bin2base64(Buffer.alloc(1), 2);
+        });
+        assert.throws(function () {
+            sodium.sodium_bin2base64_into(Buffer.alloc(3), Buffer.alloc(1));
+        });
+        done();
+    });
+});
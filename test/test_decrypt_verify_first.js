@@ -0,0 +1,52 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+// Small messages are decrypted to scratch memory and copied out once
+// authenticated; messages over 64 KiB go straight to their own Buffer
+var sizes = [0, 100, 64 * 1024, 64 * 1024 + 1];
+
+describe("decryption before allocation", function () {
+    var key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 7);
+    var nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES, 1);
+    var alice = sodium.crypto_box_keypair();
+    var bob = sodium.crypto_box_keypair();
+
+    sizes.forEach(function (size) {
+        var m = Buffer.alloc(size, 3);
+
+        it("crypto_secretbox_open_easy " + size + " bytes", function (done) {
+            var c = sodium.crypto_secretbox_easy(m, nonce, key);
+            assert(sodium.crypto_secretbox_open_easy(c, nonce, key).equals(m));
+            // The result does not share the scratch block
+            var first = sodium.crypto_secretbox_open_easy(c, nonce, key);
+            sodium.crypto_secretbox_open_easy(sodium.crypto_secretbox_easy(Buffer.alloc(size, 9), nonce, key), nonce, key);
+            assert(first.equals(m));
+
+            c[c.length - 1] ^= 1;
+            assert.strictEqual(sodium.crypto_secretbox_open_easy(c, nonce, key), null);
+            done();
+        });
+
+        it("crypto_box_open_easy " + size + " bytes", function (done) {
+            var c = sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+            assert(sodium.crypto_box_open_easy(c, nonce, alice.publicKey, bob.secretKey).equals(m));
+            c[0] ^= 1;
+            assert.strictEqual(sodium.crypto_box_open_easy(c, nonce, alice.publicKey, bob.secretKey), null);
+            done();
+        });
+
+        it("crypto_aead_xchacha20poly1305_ietf_decrypt " + size + " bytes", function (done) {
+            var npub = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, 2);
+            var c = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(m, null, npub, key);
+            assert(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt(c, null, npub, key).equals(m));
+            c[0] ^= 1;
+            assert.strictEqual(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt(c, null, npub, key), null);
+            done();
+        });
+    });
+
+    it("crypto_secretbox_open_easy should reject a cipher text shorter than the MAC", function (done) {
+        assert.strictEqual(sodium.crypto_secretbox_open_easy(Buffer.alloc(3), nonce, key), null);
+        done();
+    });
+});
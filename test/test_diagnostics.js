@@ -0,0 +1,84 @@
+"use strict";
+
+var assert = require('assert');
+var dc = require('diagnostics_channel');
+var sodium = require('../lib/sodium');
+
+describe('diagnostics_channel', function() {
+    var binding = sodium.api;
+    var messages;
+
+    function onMessage(message) {
+        messages.push(Object.assign({}, message));
+    }
+
+    beforeEach(function() {
+        messages = [];
+        dc.subscribe('sodium:crypto', onMessage);
+    });
+
+    afterEach(function() {
+        dc.unsubscribe('sodium:crypto', onMessage);
+    });
+
+    it('should publish sync calls with their size', function(done) {
+        binding.crypto_hash_sha256(Buffer.alloc(10));
+        assert.equal(messages.length, 1);
+        assert.equal(messages[0].primitive, 'crypto_hash_sha256');
+        assert.equal(messages[0].size, 10);
+        assert.equal(messages[0].async, false);
+        assert.strictEqual(messages[0].error, null);
+        assert(messages[0].duration >= 0);
+        done();
+    });
+
+    it('should publish calls that throw', function(done) {
+        assert.throws(function() {
+            binding.crypto_hash_sha256(5);
+        });
+        assert.equal(messages.length, 1);
+        assert(messages[0].error instanceof Error);
+        done();
+    });
+
+    it('should publish async calls once they settle', function() {
+        var promise = binding.crypto_hash_sha256_async(Buffer.alloc(1024 * 1024));
+        assert.equal(messages.length, 0);
+        return promise.then(function() {
+            assert.equal(messages.length, 1);
+            assert.equal(messages[0].async, true);
+        });
+    });
+
+    it('should leave size getters alone', function(done) {
+        binding.crypto_hash_sha256_bytes();
+        assert.equal(messages.length, 0);
+        done();
+    });
+
+    it('should publish nothing without subscribers', function(done) {
+        dc.unsubscribe('sodium:crypto', onMessage);
+        binding.crypto_hash_sha256(Buffer.alloc(10));
+        assert.equal(messages.length, 0);
+        done();
+    });
+
+    if (dc.tracingChannel) {
+        it('should trace calls on the tracing channels', function() {
+            var events = [];
+            var handlers = {
+                start: function() { events.push('start'); },
+                end: function() { events.push('end'); },
+                asyncStart: function() { events.push('asyncStart'); },
+                asyncEnd: function() { events.push('asyncEnd'); },
+                error: function() { events.push('error'); }
+            };
+            var tracing = dc.tracingChannel('sodium:crypto');
+            tracing.subscribe(handlers);
+            return binding.crypto_hash_sha256_async(Buffer.alloc(1024 * 1024)).then(function() {
+                tracing.unsubscribe(handlers);
+                assert.deepEqual(events, ['start', 'end', 'asyncStart', 'asyncEnd']);
+            });
+        });
+    }
+});
@@ -39,4 +39,42 @@ describe("ECDH", function () {
         assert.deepEqual(bobSecret, aliceSecret);
         done();
     });
+    it("should derive the shared key of the libsodium recipe", function (done) {
+        var bob = new DHKey();
+        var alice = new DHKey();
+
+        var aliceDH = new ECDH(bob.pk().get(), alice.sk().get());
+        var bobDH = new ECDH(alice.pk().get(), bob.sk().get());
+
+        var key = aliceDH.sharedKey(true);
+        assert.deepEqual(key, bobDH.sharedKey(false));
+        var q = sodium.crypto_scalarmult(alice.sk().get(), bob.pk().get());
+        assert.deepEqual(key, sodium.crypto_generichash(32, Buffer.concat([q, alice.pk().get(), bob.pk().get()]), null));
+
+        assert.deepEqual(aliceDH.sharedKey(), bobDH.sharedKey());
+        assert.equal(aliceDH.sharedKey(undefined, 64).length, 64);
+        assert.deepEqual(aliceDH.publicKey(), alice.pk().get());
+        done();
+    });
+
+    it("should derive the shared keys of many clients", function (done) {
+        var server = new DHKey();
+        var clients = [new DHKey(), new DHKey(), new DHKey()];
+        var serverDH = new ECDH(clients[0].pk().get(), server.sk().get());
+
+        var peers = clients.map(function (c) { return c.pk().get(); });
+        peers.push(Buffer.alloc(32));
+        var keys = serverDH.sharedKeys(peers, undefined, 2);
+        assert.equal(keys.length, 4 * 32);
+        clients.forEach(function (c, i) {
+            var clientDH = new ECDH(server.pk().get(), c.sk().get());
+            assert.deepEqual(keys.subarray(i * 32, (i + 1) * 32), clientDH.sharedKey(true));
+        });
+        assert(sodium.sodium_is_zero(keys.subarray(96)));
+        assert.deepEqual(sodium.crypto_scalarmult_shared_key_batch(server.sk().get(), server.pk().get(),
+            Buffer.concat(peers)), keys);
+        assert.strictEqual(sodium.crypto_scalarmult_shared_key(server.sk().get(), Buffer.alloc(32),
+            server.pk().get(), server.pk().get()), null);
+        done();
+    });
 });
\ No newline at end of file
@@ -0,0 +1,154 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+
+describe("EncryptedLog", function () {
+    var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-log-'));
+    var file = path.join(dir, 'audit.log');
+    var key = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+
+    function record(i) {
+        return Buffer.from("record " + i + " " + "x".repeat(i % 50));
+    }
+
+    function readAll(k) {
+        var reader = new sodium.EncryptedLogReader(fs.openSync(file, 'r'), k || key);
+        var out = [];
+        function next() {
+            return reader.read().then(function (records) {
+                if (records === null) {
+                    return out;
+                }
+                out = out.concat(records.map(function (r) { return Buffer.from(r); }));
+                return next();
+            });
+        }
+        return next();
+    }
+
+    beforeEach(function () {
+        if (fs.existsSync(file)) {
+            fs.unlinkSync(file);
+        }
+    });
+
+    after(function () {
+        if (fs.existsSync(file)) {
+            fs.unlinkSync(file);
+        }
+        fs.rmdirSync(dir);
+    });
+
+    it("should write XChaCha20-Poly1305 frames", function () {
+        var fd = fs.openSync(file, 'a');
+        var log = new sodium.EncryptedLog(fd, key);
+        assert.equal(log.append(Buffer.from("hello")), 0);
+        return log.flush().then(function (committed) {
+            assert.equal(committed, 1);
+            log.dispose();
+            fs.closeSync(fd);
+
+            var data = fs.readFileSync(file);
+            assert.equal(data.length, 24 + 5 + sodium.EncryptedLog.OVERHEAD);
+            assert.equal(data.subarray(0, 5).toString(), "NSLOG");
+            var nonce = Buffer.alloc(24);
+            data.copy(nonce, 0, 8, 24);
+            var c = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(Buffer.from("hello"),
+                data.subarray(24, 28), nonce, key);
+            assert(data.subarray(28).equals(c));
+        });
+    });
+
+    it("should group commit and read back several segments", function () {
+        var fd = fs.openSync(file, 'a');
+        var log = new sodium.EncryptedLog(fd, key);
+        var expected = [];
+        var flushes = [];
+        for (var i = 0; i < 3000; i++) {
+            expected.push(record(i));
+            log.append(expected[i]);
+            if (i % 100 == 99) {
+                flushes.push(log.flush());
+            }
+        }
+        return Promise.all(flushes).then(function (committed) {
+            assert.equal(committed[committed.length - 1], 3000);
+            var stats = log.stats();
+            assert.equal(stats.records, 3000);
+            assert.equal(stats.pending, 0);
+            assert(stats.flushes < flushes.length);
+            log.dispose();
+
+            // A second writer starts a new segment in the same file
+            var big = Buffer.alloc(2 * 1024 * 1024, 7);
+            var second = new sodium.EncryptedLog(fd, key, { sync: false });
+            assert.equal(second.appendBatch([big, record(1)]), 0);
+            expected.push(big, record(1));
+            return second.flush();
+        }).then(function () {
+            fs.closeSync(fd);
+            return readAll();
+        }).then(function (records) {
+            assert.equal(records.length, expected.length);
+            records.forEach(function (r, i) {
+                assert(r.equals(expected[i]));
+            });
+        });
+    });
+
+    it("should report tampered and truncated logs", function () {
+        var fd = fs.openSync(file, 'a');
+        var log = new sodium.EncryptedLog(fd, key);
+        for (var i = 0; i < 10; i++) {
+            log.append(record(i));
+        }
+        return log.flush().then(function () {
+            fs.closeSync(fd);
+            var size = fs.statSync(file).size;
+            fs.truncateSync(file, size - 3);
+            var reader = new sodium.EncryptedLogReader(fs.openSync(file, 'r'), key);
+            return reader.read().then(function (records) {
+                assert.equal(records.length, 9);
+                return reader.read();
+            }).then(function () {
+                assert.fail("partial record accepted");
+            }, function (err) {
+                assert(/partial record/.test(err.message));
+                assert.equal(reader.offset, size - record(9).length - sodium.EncryptedLog.OVERHEAD);
+            });
+        }).then(function () {
+            var data = fs.readFileSync(file);
+            data[40] ^= 1;
+            fs.writeFileSync(file, data);
+            return readAll();
+        }).then(function () {
+            assert.fail("tampered record accepted");
+        }, function (err) {
+            assert(/failed authentication/.test(err.message));
+            return readAll(sodium.crypto_aead_xchacha20poly1305_ietf_keygen());
+        }).then(function () {
+            assert.fail("wrong key accepted");
+        }, function (err) {
+            assert(/failed authentication/.test(err.message));
+        });
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () {
+            new sodium.EncryptedLog(-1, key);
+        });
+        assert.throws(function () {
+            new sodium.EncryptedLog(1, Buffer.alloc(16));
+        });
+        var log = new sodium.EncryptedLog(1, key, { sync: false });
+        assert.throws(function () {
+            log.append(Buffer.alloc(sodium.EncryptedLog.MAX_RECORD + 1));
+        });
+        log.dispose();
+        assert.throws(function () {
+            log.append(Buffer.from("x"));
+        });
+    });
+});
@@ -0,0 +1,59 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe('sodium_fast_fail', function() {
+    var key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 1);
+    var nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES, 2);
+
+    afterEach(function() {
+        sodium.sodium_fast_fail(false);
+    });
+
+    it('should be off by default', function(done) {
+        assert.equal(sodium.sodium_fast_fail(), false);
+        assert.throws(function() {
+            sodium.crypto_secretbox_easy(Buffer.from('hi'), nonce, Buffer.alloc(3));
+        });
+        done();
+    });
+
+    it('should return null and keep the message', function(done) {
+        assert.equal(sodium.sodium_fast_fail(true), true);
+        assert.strictEqual(sodium.crypto_secretbox_easy(Buffer.from('hi'), nonce, Buffer.alloc(3)), null);
+        assert(/key/.test(sodium.sodium_last_error()));
+        assert.strictEqual(sodium.sodium_last_error(), null);
+        done();
+    });
+
+    it('should not set an error on a forged box', function(done) {
+        sodium.sodium_fast_fail(true);
+        var c = sodium.crypto_secretbox_easy(Buffer.from('hello'), nonce, key);
+        c[0] ^= 1;
+        assert.strictEqual(sodium.crypto_secretbox_open_easy(c, nonce, key), null);
+        assert.strictEqual(sodium.sodium_last_error(), null);
+        done();
+    });
+
+    it('should cover batch and number arguments', function(done) {
+        sodium.sodium_fast_fail(true);
+        var kp = sodium.crypto_box_keypair();
+        assert.strictEqual(sodium.crypto_scalarmult_batch(kp.secretKey, Buffer.alloc(33)), null);
+        assert(sodium.sodium_last_error());
+        assert.strictEqual(sodium.randombytes_uniform(-1), null);
+        assert(sodium.sodium_last_error());
+        done();
+    });
+
+    it('should cover offset and length arguments', function(done) {
+        var c = sodium.crypto_secretbox_easy(Buffer.from('hello'), nonce, key);
+        assert.throws(function() {
+            sodium.crypto_secretbox_open_easy(c, c.length + 1, nonce, key);
+        }, RangeError);
+        sodium.sodium_fast_fail(true);
+        assert.strictEqual(sodium.crypto_secretbox_open_easy(c, c.length + 1, nonce, key), null);
+        assert(/bounds/.test(sodium.sodium_last_error()));
+        assert.strictEqual(sodium.crypto_secretbox_open_easy(c, 1.5, 10, nonce, key), null);
+        assert(/positive integers/.test(sodium.sodium_last_error()));
+        done();
+    });
+});
@@ -0,0 +1,108 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+var SecretStream = require('../lib/sodium').SecretStream;
+
+function pipe(transform, data) {
+    return new Promise(function (resolve, reject) {
+        var out = [];
+        transform.on('data', function (d) { out.push(d); });
+        transform.on('end', function () { resolve(Buffer.concat(out)); });
+        transform.on('error', reject);
+        transform.end(data);
+    });
+}
+
+describe("File encryption", function () {
+    var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-crypt-'));
+    var file = path.join(dir, 'data.bin');
+    var enc = path.join(dir, 'data.enc');
+    var dec = path.join(dir, 'data.dec');
+    var key = sodium.crypto_secretstream_xchacha20poly1305_keygen();
+    // Several read blocks, and not a multiple of the chunk size
+    var data = Buffer.alloc(3 * 1024 * 1024 + 12345);
+    sodium.randombytes_buf(data);
+    fs.writeFileSync(file, data);
+
+    after(function () {
+        [file, enc, dec].forEach(function (f) {
+            if (fs.existsSync(f)) {
+                fs.unlinkSync(f);
+            }
+        });
+        fs.rmdirSync(dir);
+    });
+
+    it("should round trip a file and report progress", function () {
+        var last = 0;
+        return sodium.sodium_encrypt_file(file, enc, key, {
+            onProgress: function (done, total) {
+                assert(done >= last && done <= total);
+                assert.equal(total, data.length);
+                last = done;
+            }
+        }).then(function (written) {
+            assert.equal(written, fs.statSync(enc).size);
+            return sodium.sodium_decrypt_file(enc, dec, key);
+        }).then(function (written) {
+            assert.equal(written, data.length);
+            assert(fs.readFileSync(dec).equals(data));
+        });
+    });
+
+    it("should write the format of the SecretStream Encryptor", function () {
+        return SecretStream.encryptFile(file, enc, key, { chunkSize: 1000 }).then(function () {
+            return pipe(new SecretStream.Decryptor(key, { chunkSize: 1000 }), fs.readFileSync(enc));
+        }).then(function (plain) {
+            assert(plain.equals(data));
+            return pipe(new SecretStream.Encryptor(key), data);
+        }).then(function (ciphertext) {
+            fs.writeFileSync(enc, ciphertext);
+            return SecretStream.decryptFile(enc, dec, key);
+        }).then(function () {
+            assert(fs.readFileSync(dec).equals(data));
+        });
+    });
+
+    it("should encrypt an empty file", function () {
+        fs.writeFileSync(dec, Buffer.alloc(0));
+        return sodium.sodium_encrypt_file(dec, enc, key).then(function (written) {
+            assert.equal(written, sodium.crypto_secretstream_xchacha20poly1305_HEADERBYTES +
+                                  sodium.crypto_secretstream_xchacha20poly1305_ABYTES);
+            return sodium.sodium_decrypt_file(enc, dec, key);
+        }).then(function (written) {
+            assert.equal(written, 0);
+        });
+    });
+
+    it("should reject forged and truncated files and remove the output", function () {
+        return sodium.sodium_encrypt_file(file, enc, key).then(function () {
+            var ciphertext = fs.readFileSync(enc);
+            fs.writeFileSync(enc, ciphertext.slice(0, ciphertext.length - 1));
+            return sodium.sodium_decrypt_file(enc, dec, key).then(function () {
+                assert.fail('should not decrypt a truncated file');
+            }, function (err) {
+                assert(/truncated|authentication/.test(err.message));
+                assert(!fs.existsSync(dec));
+                ciphertext[100] ^= 1;
+                fs.writeFileSync(enc, ciphertext);
+                return sodium.sodium_decrypt_file(enc, dec, key);
+            });
+        }).then(function () {
+            assert.fail('should not decrypt a forged file');
+        }, function (err) {
+            assert(/authentication/.test(err.message));
+            assert(!fs.existsSync(dec));
+        });
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () { sodium.sodium_encrypt_file(42, enc, key); });
+        assert.throws(function () { sodium.sodium_encrypt_file(file, file, key); });
+        assert.throws(function () { sodium.sodium_encrypt_file(file, enc, Buffer.alloc(16)); });
+        assert.throws(function () { sodium.sodium_encrypt_file(file, enc, key, { chunkSize: 0 }); });
+        assert.throws(function () { sodium.sodium_encrypt_file(file, enc, key, { onProgress: 1 }); });
+    });
+});
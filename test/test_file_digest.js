@@ -0,0 +1,72 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+var Hash = require('../lib/sodium').Hash;
+
+describe("File digests", function () {
+    var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-file-'));
+    var file = path.join(dir, 'data.bin');
+    var empty = path.join(dir, 'empty.bin');
+    // Larger than one read block, and not a multiple of it
+    var data = Buffer.alloc(1024 * 1024 + 12345);
+    sodium.randombytes_buf(data);
+    fs.writeFileSync(file, data);
+    fs.writeFileSync(empty, Buffer.alloc(0));
+
+    after(function () {
+        fs.unlinkSync(file);
+        fs.unlinkSync(empty);
+        fs.rmdirSync(dir);
+    });
+
+    it("should hash a file like the one shot functions", function () {
+        return Promise.all([
+            sodium.sodium_hash_file(file),
+            sodium.sodium_hash_file(file, 'sha256'),
+            sodium.sodium_hash_file(file, 'sha512'),
+            sodium.sodium_hash_file(file, 'blake2b', { outputLength: 64, key: Buffer.alloc(32, 1) }),
+            sodium.sodium_hash_file(empty, 'sha256')
+        ]).then(function (hashes) {
+            assert(hashes[0].equals(sodium.crypto_generichash(sodium.crypto_generichash_BYTES, data, null)));
+            assert(hashes[1].equals(sodium.crypto_hash_sha256(data)));
+            assert(hashes[2].equals(sodium.crypto_hash_sha512(data)));
+            assert(hashes[3].equals(sodium.crypto_generichash(64, data, Buffer.alloc(32, 1))));
+            assert(hashes[4].equals(sodium.crypto_hash_sha256(Buffer.alloc(0))));
+        });
+    });
+
+    it("should authenticate a file", function (done) {
+        var key = Buffer.alloc(32, 5);
+        Hash.authFile(file, key, function (err, token) {
+            assert.ifError(err);
+            assert(token.equals(sodium.crypto_auth_hmacsha512256(data, key)));
+            Hash.authFile(file, key, 'hmacsha256').then(function (t) {
+                assert(t.equals(sodium.crypto_auth_hmacsha256(data, key)));
+                done();
+            }).catch(done);
+        });
+    });
+
+    it("should reject files that cannot be read", function () {
+        return sodium.sodium_hash_file(path.join(dir, 'missing')).then(function () {
+            assert.fail('should not hash a missing file');
+        }, function (err) {
+            assert(/cannot open/.test(err.message));
+            return Hash.hashFile(dir, 'sha256').then(function () {
+                assert.fail('should not hash a directory');
+            }, function (err) {
+                assert(/cannot (open|read)/.test(err.message));
+            });
+        });
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () { sodium.sodium_hash_file(42); });
+        assert.throws(function () { sodium.sodium_hash_file(file, 'md5'); });
+        assert.throws(function () { sodium.sodium_hash_file(file, 'generichash', { outputLength: 4 }); });
+        assert.throws(function () { sodium.sodium_auth_file(file, Buffer.alloc(0)); });
+        assert.throws(function () { sodium.sodium_auth_file(file, Buffer.alloc(32), 'poly1305'); });
+    });
+});
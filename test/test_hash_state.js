@@ -0,0 +1,110 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var message = Buffer.from('The quick brown fox jumps over the lazy dog');
+var key = Buffer.alloc(32, 7);
+
+function parts(state) {
+    return state.update(message.slice(0, 10)).update(message.slice(10)).final();
+}
+
+describe("Hash state objects", function () {
+    it("should match the one shot functions", function (done) {
+        assert(parts(new sodium.GenerichashState())
+            .equals(sodium.crypto_generichash(sodium.crypto_generichash_BYTES, message, null)));
+        assert(parts(new sodium.GenerichashState(key, 64))
+            .equals(sodium.crypto_generichash(64, message, key)));
+        assert(parts(new sodium.Sha256State()).equals(sodium.crypto_hash_sha256(message)));
+        assert(parts(new sodium.Sha512State()).equals(sodium.crypto_hash_sha512(message)));
+        assert(parts(new sodium.HmacSha256State(key)).equals(sodium.crypto_auth_hmacsha256(message, key)));
+        assert(parts(new sodium.HmacSha512State(key)).equals(sodium.crypto_auth_hmacsha512(message, key)));
+        assert(parts(new sodium.HmacSha512256State(key)).equals(sodium.crypto_auth_hmacsha512256(message, key)));
+        assert(parts(new sodium.Poly1305State(key)).equals(sodium.crypto_onetimeauth_poly1305(message, key)));
+        done();
+    });
+
+    it("should clone the state for a shared prefix", function (done) {
+        var prefix = new sodium.HmacSha256State(key).update(message.slice(0, 16));
+        var a = prefix.clone().update(message.slice(16)).final();
+        var b = prefix.clone().update(Buffer.from('other')).final();
+        assert(a.equals(sodium.crypto_auth_hmacsha256(message, key)));
+        assert(b.equals(sodium.crypto_auth_hmacsha256(
+            Buffer.concat([message.slice(0, 16), Buffer.from('other')]), key)));
+        assert(prefix.update(message.slice(16)).final().equals(a));
+
+        var h = new sodium.GenerichashState(null, 20).update(message);
+        var copy = h.clone();
+        assert(copy instanceof sodium.GenerichashState);
+        assert.equal(copy.final().length, 20);
+        done();
+    });
+
+    it("should fork a scratch object from a prefix with copy", function (done) {
+        var prefix = new sodium.Sha512State().update(message.slice(0, 20));
+        var scratch = new sodium.Sha512State();
+        for (var i = 0; i < 3; i++) {
+            assert(scratch.copy(prefix).update(message.slice(20)).final()
+                .equals(sodium.crypto_hash_sha512(message)));
+        }
+        assert.throws(function () { scratch.copy(new sodium.Sha256State()); });
+        assert.throws(function () { scratch.copy({}); });
+        var done1 = new sodium.Sha512State();
+        done1.final();
+        assert.throws(function () { scratch.copy(done1); });
+        done();
+    });
+
+    it("should hash many messages after one prefix with finalBatch", function (done) {
+        var prefix = new sodium.HmacSha512256State(key).update(message.slice(0, 9));
+        var bodies = [message.slice(9), Buffer.alloc(0), Buffer.from('tenant 42')];
+        var tags = prefix.finalBatch(bodies);
+        assert.equal(tags.length, 3 * sodium.crypto_auth_hmacsha512256_BYTES);
+        bodies.forEach(function (body, i) {
+            var expected = sodium.crypto_auth_hmacsha512256(Buffer.concat([message.slice(0, 9), body]), key);
+            assert(tags.slice(i * 32, (i + 1) * 32).equals(expected));
+        });
+
+        var many = [];
+        for (var i = 0; i < 300; i++) {
+            many.push(Buffer.from('message ' + i));
+        }
+        var h = new sodium.GenerichashState(null, 16).update(message);
+        var hashes = h.finalBatch(many, 4);
+        assert(hashes.slice(16 * 299).equals(h.clone().update(many[299]).final()));
+        assert(h.final().equals(sodium.crypto_generichash(16, message, null)));
+        done();
+    });
+
+    it("should throw once finalized or disposed", function (done) {
+        var h = new sodium.Sha256State();
+        h.final();
+        assert.throws(function () { h.update(message); });
+        assert.throws(function () { h.final(); });
+        var d = new sodium.Sha512State();
+        d.dispose();
+        assert.throws(function () { d.clone(); });
+        done();
+    });
+
+    it("should check the constructor arguments", function (done) {
+        assert.throws(function () { new sodium.HmacSha256State(); });
+        assert.throws(function () { new sodium.Poly1305State(Buffer.alloc(16)); });
+        assert.throws(function () { new sodium.GenerichashState(Buffer.alloc(4)); });
+        assert.throws(function () { new sodium.GenerichashState(null, 8); });
+        assert.throws(function () { new sodium.Sha256State().update('abc'); });
+        done();
+    });
+
+    it("should handle more states than one slab holds", function (done) {
+        var states = [];
+        for (var i = 0; i < 200; i++) {
+            states.push(new sodium.Sha256State().update(message));
+        }
+        var expected = sodium.crypto_hash_sha256(message);
+        states.forEach(function (s) {
+            assert(s.final().equals(expected));
+        });
+        assert(parts(new sodium.Sha256State()).equals(expected));
+        done();
+    });
+});
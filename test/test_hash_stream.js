@@ -0,0 +1,84 @@
+var assert = require('assert');
+var crypto = require('crypto');
+var sodium = require('../build/Release/sodium');
+var HashStream = require('../lib/hash-stream');
+
+// Split `buf` into random sized pieces, some larger than the coalesce size
+function pieces(buf, max) {
+    var out = [];
+    var pos = 0;
+    while( pos < buf.length ) {
+        var n = 1 + Math.floor(Math.random() * max);
+        out.push(buf.slice(pos, pos + n));
+        pos += n;
+    }
+    return out;
+}
+
+var data = crypto.randomBytes(300000);
+
+var expected = {
+    generichash: sodium.crypto_generichash(sodium.crypto_generichash_BYTES, data, null),
+    sha256: sodium.crypto_hash_sha256(data),
+    sha512: sodium.crypto_hash_sha512(data)
+};
+
+describe('HashStream', function() {
+    Object.keys(expected).forEach(function(algorithm) {
+        it(algorithm + ' update/digest should match the one shot hash', function(done) {
+            var h = HashStream.createHash(algorithm, { coalesceSize: 4096 });
+            pieces(data, 10000).forEach(function(p) { h.update(p); });
+            assert.ok(h.digest().equals(expected[algorithm]));
+            assert.ok(h.digest().equals(expected[algorithm]));
+            assert.throws(function() { h.update(Buffer.from('x')); });
+            done();
+        });
+
+        it(algorithm + ' stream should emit the digest', function(done) {
+            var h = new HashStream.HashStream(algorithm);
+            var out = [];
+            h.on('data', function(d) { out.push(d); });
+            h.on('end', function() {
+                assert.ok(Buffer.concat(out).equals(expected[algorithm]));
+                done();
+            });
+            pieces(data, 100).forEach(function(p) { h.write(p); });
+            h.end();
+        });
+    });
+
+    it('should hash an empty stream', function(done) {
+        var h = HashStream.createHash('sha256');
+        assert.ok(h.digest().equals(sodium.crypto_hash_sha256(Buffer.alloc(0))));
+        done();
+    });
+
+    it('should support keyed generichash', function(done) {
+        var key = Buffer.alloc(sodium.crypto_generichash_KEYBYTES, 7);
+        var h = HashStream.createHash('generichash', { key: key, outputLength: 64 });
+        h.update(data);
+        assert.ok(h.digest().equals(sodium.crypto_generichash(64, data, key)));
+        done();
+    });
+
+    it('should throw on unknown algorithms', function(done) {
+        assert.throws(function() { HashStream.createHash('md5'); });
+        done();
+    });
+
+    it('pass through should forward data and emit the digest', function(done) {
+        var h = new HashStream.HashPassThrough('sha512');
+        var out = [];
+        h.on('data', function(d) { out.push(d); });
+        h.on('digest', function(digest) {
+            assert.ok(digest.equals(expected.sha512));
+        });
+        h.on('end', function() {
+            assert.ok(Buffer.concat(out).equals(data));
+            assert.ok(h.digest().equals(expected.sha512));
+            done();
+        });
+        pieces(data, 5000).forEach(function(p) { h.write(p); });
+        h.end();
+    });
+});
@@ -0,0 +1,125 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("HmacKey", function () {
+    var messages = [];
+    for (var i = 0; i < 300; i++) {
+        messages.push(Buffer.from('message ' + i));
+    }
+
+    ['hmacsha256', 'hmacsha512', 'hmacsha512256'].forEach(function (algo) {
+        it("should match crypto_auth_" + algo, function (done) {
+            var secret = sodium['crypto_auth_' + algo + '_keygen']();
+            var key = new sodium.HmacKey(algo, secret);
+            assert.strictEqual(key.bytes, sodium['crypto_auth_' + algo + '_BYTES']);
+
+            var tag = key.mac(messages[1]);
+            assert(tag.equals(sodium['crypto_auth_' + algo](messages[1], secret)));
+            assert.strictEqual(key.verify(tag, messages[1]), true);
+            assert.strictEqual(key.verify(tag, messages[2]), false);
+            done();
+        });
+    });
+
+    it("should take keys of any length", function (done) {
+        var key = new sodium.HmacKey('hmacsha256', 'webhook secret');
+        var state = sodium.crypto_auth_hmacsha256_init(Buffer.from('webhook secret'));
+        sodium.crypto_auth_hmacsha256_update(state, messages[0]);
+        assert(key.mac(messages[0]).equals(sodium.crypto_auth_hmacsha256_final(state)));
+        done();
+    });
+
+    it("should MAC and verify batches", function (done) {
+        var key = new sodium.HmacKey('hmacsha512256', 'batch secret');
+        var tags = key.macBatch(messages, 4);
+        assert.strictEqual(tags.length, messages.length * 32);
+        assert(tags.slice(32 * 7, 32 * 8).equals(key.mac(messages[7])));
+
+        tags[32 * 5] ^= 1;
+        var bitmap = key.verifyBatch(tags, messages, 4);
+        for (var i = 0; i < messages.length; i++) {
+            assert.strictEqual(!!(bitmap[i >> 3] & (1 << (i & 7))), i !== 5);
+        }
+        done();
+    });
+
+    it("should reject bad arguments and disposed keys", function (done) {
+        assert.throws(function () { new sodium.HmacKey('md5', 'secret'); });
+        assert.throws(function () { new sodium.HmacKey('hmacsha256', 42); });
+        var key = new sodium.HmacKey('hmacsha256', 'secret');
+        assert.throws(function () { key.verify(Buffer.alloc(31), messages[0]); });
+        key.dispose();
+        assert.throws(function () { key.mac(messages[0]); });
+        done();
+    });
+
+    it("should find the matching key of a keyring", function (done) {
+        var keys = [0, 1, 2].map(function () { return sodium.crypto_auth_hmacsha256_keygen(); });
+        var tag = sodium.crypto_auth_hmacsha256(messages[3], keys[1]);
+
+        var keyring = [new sodium.HmacKey('hmacsha256', keys[0]), keys[1], new sodium.HmacKey('hmacsha256', keys[2])];
+        assert.strictEqual(sodium.crypto_auth_hmacsha256_verify_any(tag, messages[3], keyring), 1);
+        keyring[1] = new sodium.HmacKey('hmacsha256', keys[1]);
+        assert.strictEqual(sodium.crypto_auth_hmacsha256_verify_any(tag, messages[3], keyring), 1);
+        assert.strictEqual(sodium.crypto_auth_hmacsha256_verify_any(tag, messages[4], keyring), -1);
+
+        var token = sodium.crypto_auth(messages[3], keys[2]);
+        assert.strictEqual(sodium.crypto_auth_verify_any(token, messages[3], keys), 2);
+
+        assert.throws(function () {
+            sodium.crypto_auth_hmacsha512_verify_any(Buffer.alloc(64), messages[3], keyring);
+        });
+        keyring[0].dispose();
+        assert.throws(function () {
+            sodium.crypto_auth_hmacsha256_verify_any(tag, messages[3], keyring);
+        });
+        done();
+    });
+
+    // RFC 6238 appendix B, SHA-256 and SHA-512
+    var totpVectors = [
+        [59, '46119246', '90693936'],
+        [1111111109, '68084774', '25091201'],
+        [1111111111, '67062674', '99943326'],
+        [1234567890, '91819424', '93441116'],
+        [2000000000, '90698825', '38618901'],
+        [20000000000, '77737706', '47863826']
+    ];
+
+    it("should compute the RFC 6238 one time passwords", function (done) {
+        var sha256 = new sodium.HmacKey('hmacsha256', '12345678901234567890123456789012');
+        var sha512 = new sodium.HmacKey('hmacsha512', '1234567890123456789012345678901234567890123456789012345678901234');
+        totpVectors.forEach(function (v) {
+            assert.strictEqual(sha256.totp(v[0], { digits: 8 }), v[1]);
+            assert.strictEqual(sha512.totp(v[0], { digits: 8 }), v[2]);
+            assert.strictEqual(sha256.hotp(Math.floor(v[0] / 30), 8), v[1]);
+            assert.strictEqual(sha256.totp(v[0]), v[1].slice(2));
+        });
+        done();
+    });
+
+    it("should verify one time passwords within the window", function (done) {
+        var key = new sodium.HmacKey('hmacsha256', '12345678901234567890123456789012');
+        var step = Math.floor(1111111109 / 30);
+
+        assert.strictEqual(key.verifyTotp('68084774', 1111111109, { digits: 8 }), step);
+        assert.strictEqual(key.verifyTotp('68084774', 1111111109 + 30, { digits: 8 }), step);
+        assert.strictEqual(key.verifyTotp('68084774', 1111111109 + 60, { digits: 8 }), null);
+        assert.strictEqual(key.verifyTotp('68084774', 1111111109 + 60, { digits: 8, window: 2 }), step);
+        assert.strictEqual(key.verifyTotp('6808477', 1111111109, { digits: 8 }), null);
+        assert.strictEqual(key.verifyTotp(key.totp()), Math.floor(Date.now() / 30000));
+
+        var code = key.hotp(1005);
+        assert.strictEqual(key.verifyHotp(code, 1000), null);
+        assert.strictEqual(key.verifyHotp(code, 1000, 5), 1005);
+        assert.strictEqual(key.verifyHotp(code, 1006, 5), null);
+        assert.strictEqual(key.verifyHotp('12345', 1000, 5), null);
+
+        assert.throws(function () { key.hotp(1, 5); });
+        assert.throws(function () { key.totp(10, { t0: 20 }); });
+        assert.throws(function () { key.verifyTotp(code, 0, { window: 101 }); });
+        key.dispose();
+        assert.throws(function () { key.hotp(1); });
+        done();
+    });
+});
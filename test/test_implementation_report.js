@@ -0,0 +1,50 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("sodium_implementation_report", function () {
+    var report = sodium.sodium_implementation_report();
+
+    it("should select a supported candidate for every primitive", function (done) {
+        ["generichash_blake2b", "pwhash_argon2", "stream_chacha20", "stream_salsa20",
+         "onetimeauth_poly1305", "hash_sha256", "scalarmult_curve25519", "aead_aes256gcm"].forEach(function (name) {
+            var entry = report[name];
+            var selected = entry.candidates.filter(function (c) {
+                return c.name === entry.selected;
+            })[0];
+            assert(selected, name);
+            assert.strictEqual(selected.supported, true);
+            assert.notStrictEqual(selected.compiled, false);
+        });
+        assert.strictEqual(report.aead_aes256gcm.selected !== "unavailable",
+                           sodium.crypto_aead_aes256gcm_is_available());
+        assert.strictEqual(report.cpu.avx2, sodium.sodium_runtime_has_avx2() === 1);
+        assert.strictEqual(report.cpu.shani, sodium.sodium_runtime_has_shani() === 1);
+        done();
+    });
+
+    // Fleet check: SODIUM_EXPECT_IMPLEMENTATIONS="generichash_blake2b=avx2,stream_chacha20=dolbeau_avx2"
+    // makes the test suite fail on hosts that do not run those kernels
+    it("should match SODIUM_EXPECT_IMPLEMENTATIONS", function (done) {
+        var expected = process.env.SODIUM_EXPECT_IMPLEMENTATIONS;
+        if (!expected) {
+            return done();
+        }
+        expected.split(",").forEach(function (pair) {
+            var kv = pair.trim().split("=");
+            assert(report[kv[0]], "unknown primitive " + kv[0]);
+            assert.strictEqual(report[kv[0]].selected, kv[1], kv[0]);
+        });
+        done();
+    });
+
+    it("should report how the addon was built", function (done) {
+        var build = sodium.sodium_build_info();
+        assert(build.profile === "default" || build.profile === "performance");
+        assert.strictEqual(typeof build.march, "string");
+        assert.strictEqual(build.lto, build.profile === "performance");
+        assert.strictEqual(typeof build.compiler, "string");
+        done();
+    });
+});
@@ -0,0 +1,71 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("in place encryption", function () {
+    var message = Buffer.from("a large media segment, or a small test string");
+
+    it("crypto_stream_*_xor_inplace should match _xor", function (done) {
+        ['xsalsa20', 'salsa20', 'salsa208', 'salsa2012', 'chacha20', 'chacha20_ietf'].forEach(function (algo) {
+            var nonce = Buffer.alloc(sodium['crypto_stream_' + algo + '_NONCEBYTES'], 1);
+            var key = Buffer.alloc(sodium['crypto_stream_' + algo + '_KEYBYTES'], 2);
+            var expected = sodium['crypto_stream_' + algo + '_xor'](message, nonce, key);
+
+            var buf = Buffer.from(message);
+            var ret = sodium['crypto_stream_' + algo + '_xor_inplace'](buf, nonce, key);
+            assert.strictEqual(ret, buf);
+            assert(buf.equals(expected), algo);
+        });
+        done();
+    });
+
+    it("crypto_stream_*_xor_ic_inplace should match _xor_ic on a range", function (done) {
+        var nonce = Buffer.alloc(sodium.crypto_stream_chacha20_NONCEBYTES, 3);
+        var key = Buffer.alloc(sodium.crypto_stream_chacha20_KEYBYTES, 4);
+        var expected = sodium.crypto_stream_chacha20_xor_ic(message, nonce, 7, key);
+
+        var buf = Buffer.concat([Buffer.alloc(3), message, Buffer.alloc(3)]);
+        sodium.crypto_stream_chacha20_xor_ic_inplace(buf, 3, message.length, nonce, 7, key);
+        assert(buf.slice(3, 3 + message.length).equals(expected));
+        assert(buf.slice(0, 3).equals(Buffer.alloc(3)));
+        assert(buf.slice(3 + message.length).equals(Buffer.alloc(3)));
+        done();
+    });
+
+    it("crypto_stream_xor_inplace should round trip", function (done) {
+        var nonce = Buffer.alloc(sodium.crypto_stream_NONCEBYTES, 5);
+        var key = Buffer.alloc(sodium.crypto_stream_KEYBYTES, 6);
+        var buf = Buffer.from(message);
+        sodium.crypto_stream_xor_inplace(buf, nonce, key);
+        assert(!buf.equals(message));
+        sodium.crypto_stream_xor_inplace(buf, nonce, key);
+        assert(buf.equals(message));
+        done();
+    });
+
+    it("crypto_aead_*_detached_inplace should match _detached", function (done) {
+        var algos = ['chacha20poly1305', 'chacha20poly1305_ietf', 'xchacha20poly1305_ietf'];
+        if (sodium.crypto_aead_aes256gcm_is_available()) {
+            algos.push('aes256gcm');
+        }
+        var ad = Buffer.from("header");
+        algos.forEach(function (algo) {
+            var prefix = 'crypto_aead_' + algo;
+            var nonce = Buffer.alloc(sodium[prefix + '_NPUBBYTES'], 7);
+            var key = Buffer.alloc(sodium[prefix + '_KEYBYTES'], 8);
+            var expected = sodium[prefix + '_encrypt_detached'](message, ad, nonce, key);
+
+            var buf = Buffer.from(message);
+            var mac = sodium[prefix + '_encrypt_detached_inplace'](buf, ad, nonce, key);
+            assert(buf.equals(expected.cipherText), algo);
+            assert(mac.equals(expected.mac), algo);
+
+            assert.strictEqual(sodium[prefix + '_decrypt_detached_inplace'](buf, mac, ad, nonce, key), true);
+            assert(buf.equals(message), algo);
+
+            sodium[prefix + '_encrypt_detached_inplace'](buf, ad, nonce, key);
+            mac[0] ^= 1;
+            assert.strictEqual(sodium[prefix + '_decrypt_detached_inplace'](buf, mac, ad, nonce, key), false);
+        });
+        done();
+    });
+});
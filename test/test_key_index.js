@@ -0,0 +1,70 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("KeyIndex", function () {
+    var keys = [];
+    for (var i = 0; i < 2000; i++) {
+        keys.push(sodium.randombytes_buf(32));
+    }
+
+    it("should find the id of every key it stores", function () {
+        var index = new sodium.KeyIndex();
+        keys.forEach(function (key, i) {
+            index.set(key, i);
+        });
+        assert.equal(index.size, keys.length);
+        assert(index.size <= index.capacity * 3 / 4);
+
+        keys.forEach(function (key, i) {
+            assert.strictEqual(index.lookup(key), i);
+            assert.strictEqual(index.lookup(Buffer.from(key)), i);
+        });
+        for (var i = 0; i < 1000; i++) {
+            assert.strictEqual(index.lookup(sodium.randombytes_buf(32)), -1);
+        }
+
+        index.set(keys[7], 1e9);
+        assert.strictEqual(index.lookup(keys[7]), 1e9);
+        assert.equal(index.size, keys.length);
+    });
+
+    it("should remove keys without losing the others", function () {
+        var index = new sodium.KeyIndex({ capacity: keys.length });
+        var capacity = index.capacity;
+        keys.forEach(function (key, i) {
+            index.set(key, i);
+        });
+        assert.equal(index.capacity, capacity);
+
+        keys.forEach(function (key, i) {
+            if (i % 3 == 0) {
+                assert.strictEqual(index.remove(key), true);
+            }
+        });
+        assert.strictEqual(index.remove(keys[0]), false);
+        keys.forEach(function (key, i) {
+            assert.strictEqual(index.lookup(key), i % 3 == 0 ? -1 : i);
+        });
+
+        index.clear();
+        assert.equal(index.size, 0);
+        assert.strictEqual(index.lookup(keys[1]), -1);
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () {
+            new sodium.KeyIndex({ key: Buffer.alloc(8) });
+        });
+        var index = new sodium.KeyIndex({ key: Buffer.alloc(sodium.crypto_generichash_KEYBYTES, 1) });
+        assert.throws(function () {
+            index.set(keys[0], -1);
+        });
+        assert.throws(function () {
+            index.set(keys[0], 1.5);
+        });
+        index.dispose();
+        assert.throws(function () {
+            index.lookup(keys[0]);
+        });
+    });
+});
@@ -0,0 +1,93 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var BOX = sodium.crypto_box_PUBLICKEYBYTES + sodium.crypto_box_SECRETKEYBYTES;
+var SIGN = sodium.crypto_sign_ed25519_PUBLICKEYBYTES + sodium.crypto_sign_ed25519_SECRETKEYBYTES;
+
+function seeds(n, size) {
+    var b = Buffer.alloc(n * size);
+    for (var i = 0; i < b.length; i++) {
+        b[i] = (i * 7 + 3) & 0xff;
+    }
+    return b;
+}
+
+describe('crypto_box_keypair_batch', function() {
+    it('should make matching random key pairs', function(done) {
+        var kps = sodium.crypto_box_keypair_batch(100, 4);
+        assert.equal(kps.length, 100 * BOX);
+        for (var i = 0; i < 100; i++) {
+            var pk = kps.subarray(i * BOX, i * BOX + sodium.crypto_box_PUBLICKEYBYTES);
+            var sk = kps.subarray(i * BOX + sodium.crypto_box_PUBLICKEYBYTES, (i + 1) * BOX);
+            assert(sodium.crypto_scalarmult_base(sk).equals(pk));
+        }
+        assert(!kps.subarray(0, BOX).equals(kps.subarray(BOX, 2 * BOX)));
+        done();
+    });
+
+    it('should derive key pairs from seeds', function(done) {
+        var sd = seeds(70, sodium.crypto_box_SEEDBYTES);
+        var kps = sodium.crypto_box_keypair_batch(sd, 2);
+        assert.equal(kps.length, 70 * BOX);
+        for (var i = 0; i < 70; i++) {
+            var one = sodium.crypto_box_seed_keypair(
+                sd.subarray(i * sodium.crypto_box_SEEDBYTES, (i + 1) * sodium.crypto_box_SEEDBYTES));
+            assert(kps.subarray(i * BOX, (i + 1) * BOX).equals(Buffer.concat([one.publicKey, one.secretKey])));
+        }
+        done();
+    });
+
+    it('should throw on partial seeds', function(done) {
+        assert.throws(function() {
+            sodium.crypto_box_keypair_batch(Buffer.alloc(sodium.crypto_box_SEEDBYTES + 1));
+        });
+        assert.throws(function() {
+            sodium.crypto_box_keypair_batch(-1);
+        });
+        done();
+    });
+
+    it('crypto_box_keypair_batch_async should match the sync batch', function() {
+        var sd = seeds(10, sodium.crypto_box_SEEDBYTES);
+        return sodium.crypto_box_keypair_batch_async(sd, 2).then(function(kps) {
+            assert(kps.equals(sodium.crypto_box_keypair_batch(sd)));
+        });
+    });
+});
+
+describe('crypto_sign_ed25519_keypair_batch', function() {
+    it('should make key pairs that sign', function(done) {
+        var kps = sodium.crypto_sign_ed25519_keypair_batch(20);
+        var m = Buffer.from('device identity');
+        for (var i = 0; i < 20; i++) {
+            var pk = kps.subarray(i * SIGN, i * SIGN + sodium.crypto_sign_ed25519_PUBLICKEYBYTES);
+            var sk = kps.subarray(i * SIGN + sodium.crypto_sign_ed25519_PUBLICKEYBYTES, (i + 1) * SIGN);
+            var sig = sodium.crypto_sign_ed25519_detached(m, sk);
+            assert(sodium.crypto_sign_ed25519_verify_detached(sig, m, pk));
+        }
+        done();
+    });
+
+    it('should derive key pairs from seeds', function(done) {
+        var sd = seeds(130, sodium.crypto_sign_ed25519_SEEDBYTES);
+        var kps = sodium.crypto_sign_ed25519_keypair_batch(sd, 4);
+        for (var i = 0; i < 130; i++) {
+            var one = sodium.crypto_sign_ed25519_seed_keypair(
+                sd.subarray(i * sodium.crypto_sign_ed25519_SEEDBYTES, (i + 1) * sodium.crypto_sign_ed25519_SEEDBYTES));
+            assert(kps.subarray(i * SIGN, (i + 1) * SIGN).equals(Buffer.concat([one.publicKey, one.secretKey])));
+        }
+        done();
+    });
+
+    it('should handle an empty batch', function(done) {
+        assert.equal(sodium.crypto_sign_ed25519_keypair_batch(0).length, 0);
+        assert.equal(sodium.crypto_sign_ed25519_keypair_batch(Buffer.alloc(0)).length, 0);
+        done();
+    });
+
+    it('crypto_sign_ed25519_keypair_batch_async should resolve to the pairs', function() {
+        return sodium.crypto_sign_ed25519_keypair_batch_async(8, 2).then(function(kps) {
+            assert.equal(kps.length, 8 * SIGN);
+        });
+    });
+});
@@ -0,0 +1,54 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("KeystreamBuffer", function () {
+    var key = Buffer.alloc(sodium.crypto_stream_chacha20_ietf_KEYBYTES);
+    var nonce = Buffer.alloc(sodium.crypto_stream_chacha20_ietf_NONCEBYTES);
+    sodium.randombytes_buf(key);
+    sodium.randombytes_buf(nonce);
+    var message = Buffer.alloc(50000);
+    sodium.randombytes_buf(message);
+
+    it("should match crypto_stream_chacha20_ietf_xor_ic across packets", function () {
+        var expected = sodium.crypto_stream_chacha20_ietf_xor_ic(message, nonce, 3, key);
+        [1, 100, 4096].forEach(function (size) {
+            var ks = new sodium.KeystreamBuffer(key, nonce, { size: size, counter: 3 });
+            var out = [];
+            for (var i = 0; i < message.length; ) {
+                var n = Math.min(message.length - i, Math.floor(Math.random() * 200));
+                if (i % 2) {
+                    out.push(ks.xor(message.slice(i, i + n)));
+                } else {
+                    out.push(ks.xorInplace(Buffer.from(message.slice(i, i + n))));
+                }
+                i += n;
+                if (Math.random() < 0.2) {
+                    assert.equal(ks.prefetch(), ks.available());
+                }
+            }
+            assert(Buffer.concat(out).equals(expected));
+            assert.equal(ks.position(), 3 * 64 + message.length);
+            ks.dispose();
+        });
+    });
+
+    it("should stop at the end of the key stream", function () {
+        var ks = new sodium.KeystreamBuffer(key, nonce, { size: 4096, counter: 4294967295 });
+        assert.equal(ks.xor(Buffer.alloc(60)).length, 60);
+        assert.throws(function () {
+            ks.xor(Buffer.alloc(5));
+        });
+        assert.equal(ks.xor(Buffer.alloc(4)).length, 4);
+    });
+
+    it("should reject bad arguments", function () {
+        assert.throws(function () { new sodium.KeystreamBuffer(key.slice(1), nonce); });
+        assert.throws(function () { new sodium.KeystreamBuffer(key, nonce.slice(1)); });
+        assert.throws(function () { new sodium.KeystreamBuffer(key, nonce, { size: 0 }); });
+        assert.throws(function () { new sodium.KeystreamBuffer(key, nonce, { counter: 4294967296 }); });
+
+        var ks = new sodium.KeystreamBuffer(key, nonce);
+        ks.dispose();
+        assert.throws(function () { ks.xor(message); });
+    });
+});
@@ -0,0 +1,58 @@
+"use strict";
+
+var assert = require('assert');
+var path = require('path');
+var spawnSync = require('child_process').spawnSync;
+
+// Run in a fresh process, the other tests have loaded every module already
+function loaded(code) {
+    var script = "var sodium = require(" + JSON.stringify(path.join(__dirname, '..')) + ");" +
+        code +
+        "console.log(JSON.stringify(Object.keys(require.cache).map(function (f) {" +
+        "    return require('path').basename(f);" +
+        "})));";
+    var result = spawnSync(process.execPath, ['-e', script], { encoding: 'utf8' });
+    assert.strictEqual(result.status, 0, result.stderr);
+    return JSON.parse(result.stdout);
+}
+
+describe("lazy loading", function () {
+    it("should not load the high level modules until they are used", function (done) {
+        var files = loaded("");
+        assert(files.indexOf('box.js') < 0);
+        assert(files.indexOf('box-key.js') < 0);
+        assert(files.indexOf('hash-stream.js') < 0);
+        assert(files.indexOf('pool.js') < 0);
+
+        files = loaded("new sodium.Box();");
+        assert(files.indexOf('box.js') >= 0);
+        assert(files.indexOf('sign.js') < 0);
+        done();
+    });
+
+    it("should not load the addon until it is used", function (done) {
+        var files = loaded("");
+        assert(files.indexOf('sodium.node') < 0);
+        assert(files.indexOf('binding.js') < 0);
+
+        files = loaded("sodium.Const.Box.nonceBytes;");
+        assert(files.indexOf('binding.js') >= 0);
+        done();
+    });
+
+    it("should warm up on request", function (done) {
+        var sodium = require('../lib/sodium');
+        assert(sodium.warmup() >= 0);
+        assert.strictEqual(typeof sodium.api.sodium_warmup(), 'number');
+        done();
+    });
+
+    it("should replace the getter with the module", function (done) {
+        var sodium = require('../lib/sodium');
+        var Box = sodium.Box;
+        assert.strictEqual(Object.getOwnPropertyDescriptor(sodium, 'Box').value, Box);
+        assert.strictEqual(sodium.Key.Box, require('../lib/keys/box-key'));
+        assert.strictEqual(typeof sodium.Hash.createHash, 'function');
+        done();
+    });
+});
@@ -102,6 +102,15 @@ describe("libsodium_auth", function () {
         assert(result4.equals(expected4));
     });
 
+    it('crypto_auth_hmacsha256 should check key and state sizes', function() {
+        assert.throws(function() {
+            sodium.crypto_auth_hmacsha256(c, Buffer.alloc(16));
+        }, /key must be 32 bytes long/);
+        assert.throws(function() {
+            sodium.crypto_auth_hmacsha256_final(Buffer.alloc(8));
+        });
+    });
+
     it('check constants' , function() {
         assert(sodium.crypto_auth_BYTES > 0);
         assert(sodium.crypto_auth_KEYBYTES > 0);
@@ -0,0 +1,86 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+function leafHash(chunk) {
+    return sodium.crypto_generichash(32, Buffer.concat([Buffer.from([0]), chunk]));
+}
+
+// RFC 6962 tree hash
+function mth(chunks) {
+    if (chunks.length === 1) {
+        return leafHash(chunks[0]);
+    }
+    var k = 1;
+    while (k * 2 < chunks.length) {
+        k *= 2;
+    }
+    return sodium.crypto_generichash(32, Buffer.concat([Buffer.from([1]), mth(chunks.slice(0, k)), mth(chunks.slice(k))]));
+}
+
+describe("MerkleTree", function () {
+    var data = Buffer.alloc(1000);
+    sodium.randombytes_buf(data);
+    var chunks = [];
+    for (var i = 0; i < data.length; i += 64) {
+        chunks.push(data.slice(i, i + 64));
+    }
+
+    it("should compute the RFC 6962 root", function (done) {
+        var tree = new sodium.MerkleTree(data, { chunkSize: 64, threads: 4 });
+        assert.strictEqual(tree.size, 16);
+        assert(tree.root.equals(mth(chunks)));
+        assert(new sodium.MerkleTree(chunks).root.equals(tree.root));
+        assert(tree.leaf(15).equals(sodium.crypto_merkle_leaf_hash(chunks[15])));
+        assert(tree.leaf(15).equals(leafHash(chunks[15])));
+
+        for (var n = 1; n <= 9; n++) {
+            assert(new sodium.MerkleTree(chunks.slice(0, n)).root.equals(mth(chunks.slice(0, n))));
+        }
+        done();
+    });
+
+    it("should build from leaf digests", function (done) {
+        var leaves = Buffer.concat(chunks.slice(0, 5).map(leafHash));
+        var tree = new sodium.MerkleTree(leaves);
+        assert(tree.root.equals(mth(chunks.slice(0, 5))));
+        assert.throws(function () { new sodium.MerkleTree(leaves.slice(1)); });
+        assert.throws(function () { new sodium.MerkleTree(Buffer.alloc(0)); });
+        done();
+    });
+
+    it("should prove and verify inclusion", function (done) {
+        var tree = new sodium.MerkleTree(chunks.slice(0, 11));
+        for (var i = 0; i < 11; i++) {
+            var proof = tree.proof(i);
+            assert(sodium.crypto_merkle_verify(tree.root, tree.leaf(i), i, 11, proof));
+            assert(!sodium.crypto_merkle_verify(tree.root, tree.leaf(i), i, 12, proof));
+            assert(!sodium.crypto_merkle_verify(tree.root, tree.leaf((i + 1) % 11), i, 11, proof));
+        }
+        assert.strictEqual(new sodium.MerkleTree([chunks[0]]).proof(0).length, 0);
+        done();
+    });
+
+    it("should update leaves", function (done) {
+        var tree = new sodium.MerkleTree(chunks.slice(0, 7));
+        var changed = chunks.slice(0, 7);
+        changed[4] = Buffer.from('new chunk');
+        tree.updateData(4, changed[4]);
+        assert(tree.root.equals(mth(changed)));
+
+        changed[0] = Buffer.from('first');
+        tree.update(0, leafHash(changed[0]));
+        assert(tree.root.equals(mth(changed)));
+        assert.throws(function () { tree.update(7, leafHash(changed[0])); });
+        assert.throws(function () { tree.update(0, Buffer.alloc(16)); });
+        done();
+    });
+
+    it("should use other digest sizes", function (done) {
+        var tree = new sodium.MerkleTree(chunks, { bytes: 64 });
+        assert.strictEqual(tree.root.length, 64);
+        assert(tree.leaf(3).equals(sodium.crypto_merkle_leaf_hash(chunks[3], 64)));
+        assert(sodium.crypto_merkle_verify(tree.root, tree.leaf(3), 3, tree.size, tree.proof(3)));
+        assert.throws(function () { new sodium.MerkleTree(chunks, { bytes: 8 }); });
+        done();
+    });
+});
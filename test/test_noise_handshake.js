@@ -0,0 +1,76 @@
+var assert = require('assert');
+var crypto = require('crypto');
+var sodium = require('../build/Release/sodium');
+
+// Transport nonce: 4 zero bytes and a 64 bit little endian counter
+function nonce(n) {
+    var npub = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES);
+    npub.writeUInt32LE(n, 4);
+    return npub;
+}
+
+describe("NoiseHandshake", function () {
+    var alice = sodium.crypto_box_keypair();
+    var bob = sodium.crypto_box_keypair();
+
+    it("should run an XX handshake", function (done) {
+        var a = new sodium.NoiseHandshake('XX', true, { staticKeyPair: alice, prologue: Buffer.from('v1') });
+        var b = new sodium.NoiseHandshake('XX', false, { staticKeyPair: bob, prologue: Buffer.from('v1') });
+
+        assert.strictEqual(b.readMessage(a.writeMessage()).length, 0);
+        assert(a.readMessage(b.writeMessage(Buffer.from('from bob'))).equals(Buffer.from('from bob')));
+        assert(b.readMessage(a.writeMessage(Buffer.from('from alice'))).equals(Buffer.from('from alice')));
+
+        assert(a.finished && b.finished);
+        assert(a.remoteStaticKey.equals(bob.publicKey));
+        assert(b.remoteStaticKey.equals(alice.publicKey));
+        assert(a.handshakeHash.equals(b.handshakeHash));
+
+        var ka = a.split();
+        var kb = b.split();
+        assert(ka.tx.equals(kb.rx) && ka.rx.equals(kb.tx));
+        assert(!ka.tx.equals(ka.rx));
+        assert(ka.handshakeHash.equals(kb.handshakeHash));
+
+        var c = sodium.crypto_aead_chacha20poly1305_ietf_encrypt(Buffer.from('data'), null, nonce(0), ka.tx);
+        assert(sodium.crypto_aead_chacha20poly1305_ietf_decrypt(c, null, nonce(0), kb.rx).equals(Buffer.from('data')));
+        assert.throws(function () { a.writeMessage(); });
+        done();
+    });
+
+    it("should run an IK handshake", function (done) {
+        var a = new sodium.NoiseHandshake('IK', true, { staticKeyPair: alice, remoteStaticKey: bob.publicKey });
+        var b = new sodium.NoiseHandshake('IK', false, { staticKeyPair: bob });
+
+        assert(b.readMessage(a.writeMessage(Buffer.from('0-RTT'))).equals(Buffer.from('0-RTT')));
+        assert(b.remoteStaticKey.equals(alice.publicKey));
+        a.readMessage(b.writeMessage());
+        assert(a.split().tx.equals(b.split().rx));
+        done();
+    });
+
+    it("should fail on tampered messages and wrong turns", function (done) {
+        var a = new sodium.NoiseHandshake('XX', true, { staticKeyPair: alice });
+        var b = new sodium.NoiseHandshake('XX', false, { staticKeyPair: bob });
+        assert.throws(function () { b.writeMessage(); });
+
+        b.readMessage(a.writeMessage());
+        var m = b.writeMessage(crypto.randomBytes(10));
+        m[40] ^= 1;
+        assert.strictEqual(a.readMessage(m), null);
+        assert.throws(function () { a.writeMessage(); });
+        done();
+    });
+
+    it("should reject a mismatched prologue and bad options", function (done) {
+        var a = new sodium.NoiseHandshake('XX', true, { staticKeyPair: alice, prologue: Buffer.from('v1') });
+        var b = new sodium.NoiseHandshake('XX', false, { staticKeyPair: bob, prologue: Buffer.from('v2') });
+        b.readMessage(a.writeMessage());
+        assert.strictEqual(a.readMessage(b.writeMessage()), null);
+
+        assert.throws(function () { new sodium.NoiseHandshake('NN', true, { staticKeyPair: alice }); });
+        assert.throws(function () { new sodium.NoiseHandshake('XX', true); });
+        assert.throws(function () { new sodium.NoiseHandshake('IK', true, { staticKeyPair: alice }); });
+        done();
+    });
+});
@@ -0,0 +1,88 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("NonceSequence", function () {
+    it("should count up from zero", function (done) {
+        var nonces = new sodium.NonceSequence(4);
+        assert.strictEqual(nonces.current(), null);
+        assert(nonces.next().equals(Buffer.from([0, 0, 0, 0])));
+        assert(nonces.next().equals(Buffer.from([1, 0, 0, 0])));
+        var n = nonces.next();
+        assert(n.equals(Buffer.from([2, 0, 0, 0])));
+        assert.strictEqual(nonces.next(), n);
+        assert(nonces.current().equals(Buffer.from([3, 0, 0, 0])));
+        done();
+    });
+
+    it("should start from a given nonce and keep its own state", function (done) {
+        var start = Buffer.from([0xff, 0x01]);
+        var nonces = new sodium.NonceSequence(start);
+        start.fill(0);
+        var n = nonces.next();
+        assert(n.equals(Buffer.from([0xff, 0x01])));
+        n.fill(0);
+        assert(nonces.next().equals(Buffer.from([0x00, 0x02])));
+        done();
+    });
+
+    it("should stop before repeating", function (done) {
+        var nonces = new sodium.NonceSequence(1);
+        for (var i = 0; i < 256; i++) {
+            assert.strictEqual(nonces.next()[0], i);
+        }
+        assert.throws(function () {
+            nonces.next();
+        });
+        done();
+    });
+
+    it("should check its argument", function (done) {
+        assert.throws(function () { new sodium.NonceSequence(0); });
+        assert.throws(function () { new sodium.NonceSequence(65); });
+        assert.throws(function () { new sodium.NonceSequence("x"); });
+        done();
+    });
+
+    it("should give nonces to an AeadContext", function (done) {
+        var algo = 'chacha20poly1305_ietf';
+        var npubbytes = sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES;
+        var key = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_KEYBYTES, 3);
+        var ad = Buffer.from("header");
+        var tx = new sodium.AeadContext(algo, key, new sodium.NonceSequence(npubbytes));
+        var rx = new sodium.AeadContext(algo, key, new sodium.NonceSequence(npubbytes));
+        var plain = new sodium.AeadContext(algo, key);
+        var check = new sodium.NonceSequence(npubbytes);
+
+        for (var i = 0; i < 3; i++) {
+            var m = Buffer.from("message " + i);
+            var c = tx.encrypt(m, ad);
+            assert(c.equals(sodium.crypto_aead_chacha20poly1305_ietf_encrypt(m, ad, check.next(), key)));
+            assert(tx.nonces.current().equals(check.current()));
+
+            if (i == 1) {
+                // a forged message must not move the receiver on
+                var forged = Buffer.from(c);
+                forged[0] ^= 1;
+                assert.strictEqual(rx.decrypt(forged, ad), null);
+            }
+            assert(rx.decrypt(c, ad).equals(m));
+        }
+
+        var d = tx.encryptDetached(Buffer.from("detached"), ad);
+        assert(rx.decryptDetached(d.cipherText, d.mac, ad).equals(Buffer.from("detached")));
+
+        // an explicit nonce still works and leaves the sequence alone
+        var nonce = Buffer.alloc(npubbytes, 9);
+        var c2 = tx.encrypt(Buffer.from("x"), ad, nonce);
+        assert(plain.decrypt(c2, ad, nonce).equals(Buffer.from("x")));
+        assert(tx.nonces.current().equals(rx.nonces.current()));
+
+        assert.throws(function () {
+            plain.encrypt(Buffer.from("x"), ad);
+        });
+        assert.throws(function () {
+            new sodium.AeadContext(algo, key, new sodium.NonceSequence(24));
+        });
+        done();
+    });
+});
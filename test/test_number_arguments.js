@@ -0,0 +1,72 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("64 bit number arguments", function () {
+    var key = Buffer.alloc(32, 7);
+
+    it("should not cut lengths to 32 bits", function (done) {
+        // 2^32 + 32 used to be read as 32
+        assert.throws(function () {
+            sodium.crypto_generichash(Math.pow(2, 32) + 32, Buffer.from("abc"), null);
+        });
+        assert.throws(function () {
+            sodium.crypto_generichash(-1, Buffer.from("abc"), null);
+        }, RangeError);
+        done();
+    });
+
+    it("should accept BigInts", function (done) {
+        var nonce = Buffer.alloc(sodium.crypto_stream_chacha20_NONCEBYTES, 1);
+        assert(sodium.crypto_stream_chacha20(BigInt(100), nonce, key)
+            .equals(sodium.crypto_stream_chacha20(100, nonce, key)));
+        assert(sodium.crypto_generichash(BigInt(40), Buffer.from("abc"), null)
+            .equals(sodium.crypto_generichash(40, Buffer.from("abc"), null)));
+        assert.throws(function () {
+            sodium.crypto_generichash(BigInt(-40), Buffer.from("abc"), null);
+        }, RangeError);
+        done();
+    });
+
+    it("should take pwhash limits as BigInts", function (done) {
+        var salt = Buffer.alloc(sodium.crypto_pwhash_SALTBYTES, 3);
+        var password = Buffer.from("password");
+        var ops = sodium.crypto_pwhash_OPSLIMIT_INTERACTIVE;
+        var mem = sodium.crypto_pwhash_MEMLIMIT_INTERACTIVE;
+        var alg = sodium.crypto_pwhash_ALG_DEFAULT;
+        assert(sodium.crypto_pwhash(32, password, salt, BigInt(ops), BigInt(mem), alg)
+            .equals(sodium.crypto_pwhash(32, password, salt, ops, mem, alg)));
+        done();
+    });
+
+    it("should use stream counters past 2^32", function (done) {
+        var nonce = Buffer.alloc(sodium.crypto_stream_chacha20_NONCEBYTES, 2);
+        var m = Buffer.alloc(200, 9);
+        var ic = Math.pow(2, 32) + 1;
+        var c = sodium.crypto_stream_chacha20_xor_ic(m, nonce, ic, key);
+        assert(c.equals(sodium.crypto_stream_chacha20_xor_parallel(m, nonce, ic * 64, key)));
+        assert(c.equals(sodium.crypto_stream_chacha20_xor_ic(m, nonce, BigInt(ic), key)));
+        assert(!c.equals(sodium.crypto_stream_chacha20_xor_ic(m, nonce, 1, key)));
+
+        var ietfNonce = Buffer.alloc(sodium.crypto_stream_chacha20_ietf_NONCEBYTES);
+        assert.throws(function () {
+            sodium.crypto_stream_chacha20_ietf_xor_ic(m, ietfNonce, Math.pow(2, 32), key);
+        }, RangeError);
+        done();
+    });
+
+    it("should derive kdf subkeys with 64 bit ids", function (done) {
+        var max = (BigInt(1) << BigInt(64)) - BigInt(1);
+        assert(sodium.crypto_kdf_derive_from_key(32, BigInt(5), "Examples", key)
+            .equals(sodium.crypto_kdf_derive_from_key(32, 5, "Examples", key)));
+
+        var batch = sodium.crypto_kdf_derive_batch(16, max - BigInt(1), 2, "Examples", key);
+        assert(batch.slice(16).equals(sodium.crypto_kdf_derive_from_key(16, max, "Examples", key)));
+        assert.throws(function () {
+            sodium.crypto_kdf_derive_batch(16, max, 2, "Examples", key);
+        });
+        assert.throws(function () {
+            sodium.crypto_kdf_derive_from_key(32, max + BigInt(1), "Examples", key);
+        }, RangeError);
+        done();
+    });
+});
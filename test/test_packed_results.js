@@ -0,0 +1,46 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe('packed results', function() {
+    it('crypto_box_keypair_packed should hold a matching key pair', function(done) {
+        var kp = sodium.crypto_box_keypair_packed();
+        assert.equal(kp.length, sodium.crypto_box_PUBLICKEYBYTES + sodium.crypto_box_SECRETKEYBYTES);
+        var pk = kp.subarray(0, sodium.crypto_box_PUBLICKEYBYTES);
+        var sk = kp.subarray(sodium.crypto_box_PUBLICKEYBYTES);
+        assert(sodium.crypto_scalarmult_base(sk).equals(pk));
+        done();
+    });
+
+    it('crypto_sign_keypair_packed should hold a matching key pair', function(done) {
+        var kp = sodium.crypto_sign_keypair_packed();
+        var pk = kp.subarray(0, sodium.crypto_sign_PUBLICKEYBYTES);
+        var sk = kp.subarray(sodium.crypto_sign_PUBLICKEYBYTES);
+        var sig = sodium.crypto_sign_detached(Buffer.from('hello'), sk);
+        assert(sodium.crypto_sign_verify_detached(sig, Buffer.from('hello'), pk));
+        done();
+    });
+
+    it('crypto_box_detached_packed should be cipher text then mac', function(done) {
+        var a = sodium.crypto_box_keypair();
+        var b = sodium.crypto_box_keypair();
+        var m = Buffer.from('packed box');
+        var n = Buffer.alloc(sodium.crypto_box_NONCEBYTES, 3);
+        var packed = sodium.crypto_box_detached_packed(m, n, b.publicKey, a.secretKey);
+        var c = packed.subarray(0, m.length);
+        var mac = packed.subarray(m.length);
+        assert.equal(mac.length, sodium.crypto_box_MACBYTES);
+        assert(sodium.crypto_box_open_detached(c, mac, n, a.publicKey, b.secretKey).equals(m));
+        done();
+    });
+
+    it('crypto_secretbox_detached_packed should be cipher text then mac', function(done) {
+        var k = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 5);
+        var m = Buffer.from('packed secretbox');
+        var n = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES, 4);
+        var packed = sodium.crypto_secretbox_detached_packed(m, n, k);
+        var easy = sodium.crypto_secretbox_easy(m, n, k);
+        assert(packed.subarray(0, m.length).equals(easy.subarray(sodium.crypto_secretbox_MACBYTES)));
+        assert(packed.subarray(m.length).equals(easy.subarray(0, sodium.crypto_secretbox_MACBYTES)));
+        done();
+    });
+});
@@ -0,0 +1,116 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("PacketProtector", function () {
+    var ABYTES = sodium.PacketProtector.ABYTES;
+
+    it("should match the RFC 9001 ChaCha20-Poly1305 short header packet", function (done) {
+        var p = new sodium.PacketProtector('chacha20poly1305_ietf',
+            Buffer.from('c6d98ff3441c3fe1b2182094f69caa2ed4b716b65488960a7a984979fb23e1c8', 'hex'),
+            Buffer.from('e0459b3474bdd0e44a41c144', 'hex'),
+            Buffer.from('25a282b9e82f06f21f488917a4fc8f1b73573685608597d0efcb076b0ab7a7a4', 'hex'));
+
+        var packet = Buffer.alloc(1 + 3 + 1 + ABYTES);
+        packet[0] = 0x42;
+        packet[4] = 0x01;
+        assert.strictEqual(p.protect(packet, 4, 3, 654360564, 1), packet.length);
+        assert.strictEqual(packet.toString('hex'), '4cfe4189655e5cd55c41f69080575d7999c25a5bfb');
+
+        assert.strictEqual(p.unprotect(packet, 1, 654360560), 654360564);
+        assert.strictEqual(packet[4], 0x01);
+        done();
+    });
+
+    it("should encrypt the payload with the iv xored with the packet number", function (done) {
+        var key = sodium.crypto_aead_chacha20poly1305_ietf_keygen();
+        var iv = Buffer.alloc(12, 7);
+        var p = new sodium.PacketProtector('chacha20poly1305_ietf', key, iv, Buffer.alloc(32, 1));
+
+        var m = Buffer.from("This is a test");
+        var packet = Buffer.alloc(10 + m.length + ABYTES);
+        packet[0] = 0xc0;
+        m.copy(packet, 10);
+        var header = Buffer.from(packet.subarray(0, 10));
+        header[9] = 0x2a;
+        p.protect(packet, 10, 1, 0x12a, m.length);
+
+        var nonce = Buffer.from(iv);
+        nonce.writeUInt16BE(iv.readUInt16BE(10) ^ 0x12a, 10);
+        var c = sodium.crypto_aead_chacha20poly1305_ietf_encrypt(m, header, nonce, key);
+        assert(packet.subarray(10).equals(c));
+
+        // Long header: only the low 4 bits of the first byte are masked
+        assert.strictEqual(packet[0] & 0xf0, 0xc0);
+        assert.strictEqual(p.unprotect(packet, 9, 0x100), 0x12a);
+        assert(packet.subarray(0, 10).equals(header));
+        done();
+    });
+
+    it("should reject forged packets", function (done) {
+        var p = new sodium.PacketProtector('chacha20poly1305_ietf', Buffer.alloc(32, 2),
+                                           Buffer.alloc(12), Buffer.alloc(32, 3));
+        var packet = Buffer.alloc(5 + 20 + ABYTES);
+        packet[0] = 0x40;
+        p.protect(packet, 5, 4, 99, 20);
+        packet[10] ^= 1;
+        assert.strictEqual(p.unprotect(packet, 1, 98), null);
+        assert.strictEqual(p.unprotect(Buffer.alloc(12), 1, -1), null);
+        assert.throws(function() {
+            p.protect(Buffer.alloc(5 + ABYTES), 5, 4, 0, 0);
+        });
+        done();
+    });
+
+    it("should protect and unprotect a GSO burst", function (done) {
+        var algorithms = ['chacha20poly1305_ietf'];
+        if( sodium.crypto_aead_aes256gcm_is_available() ) {
+            algorithms.push('aes256gcm');
+        }
+        algorithms.forEach(function(algorithm) {
+            var key = Buffer.alloc(32, 4), iv = Buffer.alloc(12, 5), hp = Buffer.alloc(32, 6);
+            var tx = new sodium.PacketProtector(algorithm, key, iv, hp);
+            var rx = new sodium.PacketProtector(algorithm, key, iv, hp);
+            var segment = 100, count = 70;
+            var lengths = [];
+            var buffer = Buffer.alloc(segment * count);
+            for( var i = 0; i < count; i++ ) {
+                lengths.push(i == count - 1 ? 30 : segment - 9 - ABYTES);
+                buffer[i * segment] = 0x41;
+                buffer.fill(i, i * segment + 9, i * segment + 9 + lengths[i]);
+            }
+            var total = tx.protectBatch(buffer, segment, 9, 2, 1000, lengths);
+            assert.strictEqual(total, (count - 1) * segment + 9 + 30 + ABYTES);
+
+            // A single protect gives the same packet
+            var single = Buffer.alloc(segment);
+            single[0] = 0x41;
+            single.fill(3, 9, 9 + lengths[3]);
+            new sodium.PacketProtector(algorithm, key, iv, hp).protect(single, 9, 2, 1003, lengths[3]);
+            assert(single.equals(buffer.subarray(3 * segment, 4 * segment)));
+
+            buffer[5 * segment + 20] ^= 1;
+            var numbers = rx.unprotectBatch(buffer.subarray(0, total), segment, 7, 999);
+            assert.strictEqual(numbers.length, count);
+            for( var j = 0; j < count; j++ ) {
+                assert.strictEqual(numbers[j], j == 5 ? -1 : 1000 + j);
+                if( j != 5 ) {
+                    assert.strictEqual(buffer[j * segment + 9 + lengths[j] - 1], j);
+                }
+            }
+        });
+        done();
+    });
+
+    it("should throw once disposed", function (done) {
+        var p = new sodium.PacketProtector('chacha20poly1305_ietf', Buffer.alloc(32),
+                                           Buffer.alloc(12), Buffer.alloc(32));
+        p.dispose();
+        assert.throws(function() {
+            p.unprotect(Buffer.alloc(64), 1, -1);
+        });
+        assert.throws(function() {
+            new sodium.PacketProtector('aes128gcm', Buffer.alloc(32), Buffer.alloc(12), Buffer.alloc(32));
+        });
+        done();
+    });
+});
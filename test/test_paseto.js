@@ -0,0 +1,123 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+function le64(n) {
+    var b = Buffer.alloc(8);
+    b.writeUInt32LE(n, 0);
+    return b;
+}
+
+// Pre-authentication encoding
+function pae(pieces) {
+    var parts = [le64(pieces.length)];
+    pieces.forEach(function (piece) {
+        parts.push(le64(piece.length), piece);
+    });
+    return Buffer.concat(parts);
+}
+
+function body(token) {
+    return Buffer.from(token.split('.')[2], 'base64url');
+}
+
+describe("PasetoKey", function () {
+    var local = sodium.crypto_secretbox_keygen();
+    var keys = sodium.crypto_sign_keypair();
+    var payload = JSON.stringify({ sub: 'alice' });
+
+    ['v2', 'v4'].forEach(function (version) {
+        it("should round trip " + version + ".local tokens", function (done) {
+            var key = new sodium.PasetoKey(version, 'local', local);
+            var token = key.encode(payload, 'kid-1');
+            assert.strictEqual(token.indexOf(version + '.local.'), 0);
+            assert.strictEqual(token.split('.')[3], Buffer.from('kid-1').toString('base64url'));
+
+            var result = key.decode(token);
+            assert.strictEqual(result.payload.toString(), payload);
+            assert.strictEqual(result.footer.toString(), 'kid-1');
+            assert.notStrictEqual(key.encode(payload, 'kid-1'), token);
+
+            // Footer is authenticated
+            var parts = token.split('.');
+            parts[3] = Buffer.from('kid-2').toString('base64url');
+            assert.strictEqual(key.decode(parts.join('.')), null);
+            assert.strictEqual(new sodium.PasetoKey(version, 'local', sodium.crypto_secretbox_keygen()).decode(token), null);
+            done();
+        });
+
+        it("should round trip " + version + ".public tokens", function (done) {
+            var signer = new sodium.PasetoKey(version, 'public', keys.secretKey);
+            var verifier = new sodium.PasetoKey(version, 'public', keys.publicKey);
+            var token = signer.encode(Buffer.from(payload));
+            assert.strictEqual(token.split('.').length, 3);
+            assert.strictEqual(verifier.decode(token).payload.toString(), payload);
+            assert.strictEqual(verifier.decode(token).footer.length, 0);
+            assert.throws(function () { verifier.encode(payload); });
+            done();
+        });
+    });
+
+    it("should sign PAE(header, message, footer) for v2.public", function (done) {
+        var key = new sodium.PasetoKey('v2', 'public', keys.secretKey);
+        var token = key.encode(payload, 'f');
+        var b = body(token);
+        var m = b.slice(0, b.length - sodium.crypto_sign_BYTES);
+        var sig = b.slice(m.length);
+        assert.strictEqual(m.toString(), payload);
+        assert(sodium.crypto_sign_verify_detached(sig,
+            pae([Buffer.from('v2.public.'), m, Buffer.from('f')]), keys.publicKey));
+        done();
+    });
+
+    it("should bind v4 tokens to the implicit assertion", function (done) {
+        var key = new sodium.PasetoKey('v4', 'local', local);
+        var token = key.encode(payload, null, 'tenant-7');
+        assert.strictEqual(key.decode(token, 'tenant-7').payload.toString(), payload);
+        assert.strictEqual(key.decode(token), null);
+        assert.strictEqual(key.decode(token, 'tenant-8'), null);
+        assert.throws(function () { new sodium.PasetoKey('v2', 'local', local).encode(payload, null, 'x'); });
+        done();
+    });
+
+    it("should reject tokens of another version or purpose", function (done) {
+        var v4 = new sodium.PasetoKey('v4', 'local', local);
+        var v2 = new sodium.PasetoKey('v2', 'local', local);
+        assert.strictEqual(v2.decode(v4.encode(payload)), null);
+        assert.strictEqual(v4.decode('v4.local.'), null);
+        assert.strictEqual(v4.decode('v4.local.!!!'), null);
+        assert.strictEqual(v4.decode(''), null);
+        done();
+    });
+
+    it("should decode batches", function (done) {
+        var signer = new sodium.PasetoKey('v4', 'public', keys.secretKey);
+        var tokens = [];
+        for (var i = 0; i < 200; i++) {
+            tokens.push(signer.encode('message ' + i));
+        }
+        tokens[17] = tokens[17].slice(0, -2) + (tokens[17].slice(-2) === 'AA' ? 'AB' : 'AA');
+        var payloads = new sodium.PasetoKey('v4', 'public', keys.publicKey).decodeBatch(tokens, undefined, 4);
+        assert.strictEqual(payloads.length, 200);
+        payloads.forEach(function (p, i) {
+            if (i === 17) {
+                assert.strictEqual(p, null);
+            } else {
+                assert.strictEqual(p.toString(), 'message ' + i);
+            }
+        });
+        done();
+    });
+
+    it("should check its arguments", function (done) {
+        assert.throws(function () { new sodium.PasetoKey('v3', 'local', local); });
+        assert.throws(function () { new sodium.PasetoKey('v4', 'secret', local); });
+        assert.throws(function () { new sodium.PasetoKey('v4', 'local', Buffer.alloc(16)); });
+        assert.throws(function () { new sodium.PasetoKey('v4', 'public', local.slice(0, 31)); });
+
+        var key = new sodium.PasetoKey('v4', 'local', local);
+        assert.throws(function () { key.decode(Buffer.alloc(4)); });
+        key.dispose();
+        assert.throws(function () { key.encode(payload); });
+        done();
+    });
+});
@@ -0,0 +1,125 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("SodiumPipeline", function () {
+    var key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES);
+    var macKey = Buffer.alloc(sodium.crypto_auth_hmacsha256_KEYBYTES);
+    sodium.randombytes_buf(key);
+    sodium.randombytes_buf(macKey);
+    var ad = Buffer.from('v1');
+    var variant = sodium.sodium_base64_VARIANT_URLSAFE_NO_PADDING;
+
+    var seal = new sodium.SodiumPipeline([
+        { op: 'crypto_aead_xchacha20poly1305_ietf_encrypt', key: key, ad: ad },
+        { op: 'crypto_auth_hmacsha256', key: macKey, append: true },
+        { op: 'sodium_bin2base64', variant: variant }
+    ]);
+    var open = new sodium.SodiumPipeline([
+        { op: 'sodium_base642bin', variant: variant },
+        { op: 'crypto_auth_hmacsha256_verify', key: macKey },
+        { op: 'crypto_aead_xchacha20poly1305_ietf_decrypt', key: key, ad: ad },
+        { op: 'crypto_generichash', append: true }
+    ]);
+
+    var expected = function (m) {
+        return Buffer.concat([m, sodium.crypto_generichash(sodium.crypto_generichash_BYTES, m, null)]);
+    };
+
+    it("should run every step in one call", function () {
+        assert.equal(open.steps, 4);
+        [0, 1, 100, 100000].forEach(function (n) {
+            var m = Buffer.alloc(n, n & 0xff);
+            var token = seal.run(m);
+            var raw = Buffer.from(token.toString(), 'base64');
+            assert.equal(raw.length, n + 24 + 16 + 32);
+            assert(sodium.crypto_auth_hmacsha256_verify(raw.subarray(raw.length - 32),
+                raw.subarray(0, raw.length - 32), macKey));
+            assert(open.run(token).equals(expected(m)));
+        });
+    });
+
+    it("should return null when a step fails", function () {
+        var token = seal.run(Buffer.from('hello'));
+        var forged = Buffer.from(token);
+        forged[5] = forged[5] === 0x41 ? 0x42 : 0x41;
+        assert.strictEqual(open.run(forged), null);
+        assert.strictEqual(open.run(Buffer.from('not base64!')), null);
+        assert.strictEqual(open.run(Buffer.alloc(0)), null);
+    });
+
+    it("should sign, verify and convert", function () {
+        var keys = sodium.crypto_sign_keypair();
+        var boxKey = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 9);
+        var pipe = new sodium.SodiumPipeline([
+            { op: 'crypto_sign_detached', key: keys.secretKey },
+            'sodium_bin2hex',
+            'sodium_hex2bin',
+            { op: 'crypto_sign_verify_detached', key: keys.publicKey },
+            { op: 'crypto_secretbox_easy', key: boxKey },
+            { op: 'crypto_secretbox_open_easy', key: boxKey },
+            'crypto_hash_sha256'
+        ]);
+        var m = Buffer.from('signed then boxed');
+        assert(pipe.run(m).equals(sodium.crypto_hash_sha256(m)));
+    });
+
+    it("should run batches", function () {
+        var messages = [];
+        for (var i = 0; i < 40; i++) {
+            messages.push(Buffer.from('message ' + i));
+        }
+        var tokens = seal.runBatch(messages, 4);
+        tokens[3] = Buffer.from('broken');
+        var check = function (outputs) {
+            assert.equal(outputs.length, messages.length);
+            outputs.forEach(function (out, i) {
+                if (i == 3) {
+                    assert.strictEqual(out, null);
+                } else {
+                    assert(out.equals(expected(messages[i])));
+                }
+            });
+        };
+        check(open.runBatch(tokens, 2));
+        return open.runBatchAsync(tokens).then(check);
+    });
+
+    it("should run on the threadpool", function () {
+        var m = Buffer.alloc(200000, 3);
+        return seal.runAsync(m)
+            .then(function (token) {
+                return open.runAsync(token);
+            })
+            .then(function (out) {
+                assert(out.equals(expected(m)));
+                return open.runAsync(Buffer.from('x'));
+            })
+            .then(function (out) {
+                assert.strictEqual(out, null);
+            });
+    });
+
+    it("should check its steps", function () {
+        assert.throws(function () { new sodium.SodiumPipeline([]); }, /1 to 32 steps/);
+        assert.throws(function () { new sodium.SodiumPipeline(['crypto_nope']); }, /unknown op crypto_nope/);
+        assert.throws(function () { new sodium.SodiumPipeline(['crypto_auth_hmacsha256']); }, /needs a key/);
+        assert.throws(function () {
+            new sodium.SodiumPipeline([{ op: 'crypto_secretbox_easy', key: Buffer.alloc(8) }]);
+        }, /key of 32 bytes/);
+        assert.throws(function () {
+            new sodium.SodiumPipeline([{ op: 'crypto_hash_sha256', variant: variant }]);
+        }, /step 0: variant/);
+        assert(sodium.SodiumPipeline.ops.indexOf('crypto_generichash') >= 0);
+    });
+
+    it("should keep queued jobs alive after dispose", function () {
+        var pipe = new sodium.SodiumPipeline(['crypto_hash_sha512']);
+        var m = Buffer.alloc(sodium.sodium_async_threshold() + 1, 1);
+        var p = pipe.runAsync(m);
+        pipe.dispose();
+        assert.throws(function () { pipe.run(m); }, /disposed/);
+        return p.then(function (out) {
+            assert(out.equals(sodium.crypto_hash_sha512(m)));
+        });
+    });
+});
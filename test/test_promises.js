@@ -0,0 +1,53 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../lib/sodium');
+var binding = require('../build/Release/sodium');
+
+describe("promises", function () {
+    after(function () {
+        return sodium.promises.close();
+    });
+
+    it("should have a twin of the crypto functions only", function (done) {
+        var p = sodium.promises;
+        assert.strictEqual(typeof p.crypto_secretbox_easy, 'function');
+        assert.strictEqual(typeof p.crypto_pwhash, 'function');
+        assert.strictEqual(typeof p.crypto_sign_detached, 'function');
+        assert.strictEqual(p.crypto_secretbox_KEYBYTES, undefined);
+        assert.strictEqual(p.crypto_secretbox_keybytes, undefined);
+        assert.strictEqual(p.crypto_generichash_update, undefined);
+        assert.strictEqual(p.crypto_aead_chacha20poly1305_ietf_encrypt_into, undefined);
+        assert.strictEqual(p.crypto_pwhash_async, undefined);
+        done();
+    });
+
+    it("should resolve with the results of the sync calls", function () {
+        this.timeout(20000);
+        var p = sodium.promises;
+        var m = Buffer.from("promised");
+        var key = Buffer.alloc(binding.crypto_secretbox_KEYBYTES, 1);
+        var nonce = Buffer.alloc(binding.crypto_secretbox_NONCEBYTES, 2);
+        var keys = binding.crypto_sign_keypair();
+        return Promise.all([
+            p.crypto_secretbox_easy(m, nonce, key),
+            p.crypto_hash_sha256(m),
+            p.crypto_sign_detached(m, keys.secretKey),
+            p.crypto_sign_keypair()
+        ]).then(function (r) {
+            assert(r[0].equals(binding.crypto_secretbox_easy(m, nonce, key)));
+            assert(r[1].equals(binding.crypto_hash_sha256(m)));
+            assert(r[2].equals(binding.crypto_sign_detached(m, keys.secretKey)));
+            assert.strictEqual(r[3].publicKey.length, binding.crypto_sign_PUBLICKEYBYTES);
+        });
+    });
+
+    it("should reject with the error thrown", function () {
+        this.timeout(20000);
+        return sodium.promises.crypto_secretbox_easy(Buffer.from("m"), Buffer.alloc(3), Buffer.alloc(3)).then(function () {
+            throw new Error('resolved');
+        }, function (err) {
+            assert(err instanceof Error);
+        });
+    });
+});
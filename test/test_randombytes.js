@@ -263,4 +263,194 @@ describe("randombytes_buf_deterministic", function () {
         done();
     });
 
-});
\ No newline at end of file
+});
+describe("randombytes_buf_buffered", function () {
+    it("should fill buffers of any size", function (done) {
+        [1, 24, 1000, 5000, 20000].forEach(function (size) {
+            var b = Buffer.alloc(size);
+            sodium.randombytes_buf_buffered(b);
+            assert(!b.equals(Buffer.alloc(size)));
+        });
+        done();
+    });
+
+    it("should never hand out the same bytes twice", function (done) {
+        var seen = {};
+        for (var i = 0; i < 2000; i++) {
+            var nonce = Buffer.alloc(24);
+            sodium.randombytes_buf_buffered(nonce);
+            var hex = nonce.toString('hex');
+            assert(!seen[hex]);
+            seen[hex] = true;
+            if (i == 1000) {
+                sodium.randombytes_stir();
+            }
+        }
+        done();
+    });
+
+    it("should throw on argument not being a buffer", function (done) {
+        assert.throws(function () {
+            sodium.randombytes_buf_buffered("x");
+        });
+        done();
+    });
+});
+
+describe("randombytes_buf_batch", function () {
+    it("should return count values packed together", function (done) {
+        var nonces = sodium.randombytes_buf_batch(1000, 24);
+        assert.strictEqual(nonces.length, 24000);
+        var seen = {};
+        for (var i = 0; i < 1000; i++) {
+            var hex = nonces.toString('hex', i * 24, (i + 1) * 24);
+            assert(!seen[hex]);
+            seen[hex] = true;
+        }
+        assert.strictEqual(sodium.randombytes_buf_batch(0, 24).length, 0);
+        done();
+    });
+});
+
+describe("randombytes_buf_deterministic ranges and async", function () {
+    var seed = Buffer.alloc(sodium.randombytes_SEEDBYTES);
+    sodium.randombytes_buf(seed);
+    var expected = Buffer.alloc(3 * 1024 * 1024 + 99);
+    sodium.randombytes_buf_deterministic(expected, seed);
+
+    it("should fill part of a buffer and return it", function (done) {
+        var b = Buffer.alloc(100);
+        assert.strictEqual(sodium.randombytes_buf_deterministic(b, 10, 50, seed), b);
+        assert(b.slice(10, 60).equals(expected.slice(0, 50)));
+        assert(b.slice(0, 10).equals(Buffer.alloc(10)));
+        assert(b.slice(60).equals(Buffer.alloc(40)));
+        done();
+    });
+
+    it("should give the same bytes from any position on any threads", function () {
+        var checks = [[0, 1], [1, 2], [63, 64], [1000, expected.length - 1000], [0, 0]];
+        return Promise.all(checks.map(function (c, i) {
+            var b = Buffer.alloc(c[1]);
+            return sodium.randombytes_buf_deterministic_async(b, seed, { position: c[0], threads: 1 + i % 3 })
+                .then(function (result) {
+                    assert.strictEqual(result, b);
+                    assert(b.equals(expected.slice(c[0], c[0] + c[1])));
+                });
+        }));
+    });
+
+    it("should call back", function (done) {
+        var b = Buffer.alloc(expected.length);
+        sodium.randombytes_buf_deterministic_async(b, seed, function (err, result) {
+            assert.ifError(err);
+            assert(result.equals(expected));
+            done();
+        });
+    });
+
+    it("should reject positions past the end of the stream", function () {
+        assert.throws(function () {
+            sodium.randombytes_buf_deterministic_async(Buffer.alloc(2), seed, { position: Math.pow(2, 38) - 1 });
+        });
+    });
+});
+
+describe("randombytes typed array fills", function () {
+    it("should fill a Uint32Array with random values", function (done) {
+        var a = new Uint32Array(10000);
+        assert.strictEqual(sodium.randombytes_random_fill(a), a);
+        var zeros = a.filter(function (v) { return v === 0; }).length;
+        assert(zeros < 5);
+        assert.throws(function () { sodium.randombytes_random_fill(new Uint8Array(4)); });
+        done();
+    });
+
+    it("should fill a Uint32Array with values under upperBound", function (done) {
+        var a = new Uint32Array(30000);
+        sodium.randombytes_uniform_fill(a, 3);
+        var counts = [0, 0, 0];
+        a.forEach(function (v) { counts[v]++; });
+        counts.forEach(function (c) { assert(c > 9000 && c < 11000); });
+
+        sodium.randombytes_uniform_fill(a, 0xffffffff);
+        assert(a.every(function (v) { return v < 0xffffffff; }));
+        assert(sodium.randombytes_uniform_fill(a, 1).every(function (v) { return v === 0; }));
+        assert.throws(function () { sodium.randombytes_uniform_fill(a, Math.pow(2, 32)); });
+        done();
+    });
+
+    it("should shuffle any typed array", function (done) {
+        [Uint8Array, Uint16Array, Uint32Array, Float64Array].forEach(function (Type) {
+            var a = new Type(200).map(function (v, i) { return i; });
+            assert.strictEqual(sodium.randombytes_shuffle(a), a);
+            var sorted = Array.prototype.slice.call(a).sort(function (x, y) { return x - y; });
+            assert.deepEqual(sorted, Array.prototype.slice.call(new Type(200).map(function (v, i) { return i; })));
+            assert(a.some(function (v, i) { return v !== i; }));
+        });
+        assert.throws(function () { sodium.randombytes_shuffle([1, 2, 3]); });
+        done();
+    });
+});
+
+describe("randombytes_buf_async", function () {
+    it("should fill a buffer on the threadpool", function () {
+        var b = Buffer.alloc(3 * 1024 * 1024 + 5);
+        return sodium.randombytes_buf_async(b, { threads: 3 }).then(function (result) {
+            assert.strictEqual(result, b);
+            // No 1MB piece left as zeros
+            for (var i = 0; i < b.length; i += 1024 * 1024) {
+                assert(!b.slice(i, i + 64).equals(Buffer.alloc(Math.min(64, b.length - i))));
+            }
+        });
+    });
+
+    it("should give different bytes on every call", function (done) {
+        var a = Buffer.alloc(1000), b = Buffer.alloc(1000);
+        sodium.randombytes_buf_async(a, function (err) {
+            assert.ifError(err);
+            sodium.randombytes_buf_async(b, function (err) {
+                assert.ifError(err);
+                assert(!a.equals(b));
+                done();
+            });
+        });
+    });
+
+    it("should fill part of a buffer", function () {
+        var b = Buffer.alloc(100);
+        return sodium.randombytes_buf_async(b, 10, 20).then(function () {
+            assert(b.slice(0, 10).equals(Buffer.alloc(10)));
+            assert(b.slice(30).equals(Buffer.alloc(70)));
+        });
+    });
+});
+
+describe("randombytes_set_implementation", function () {
+    after(function () {
+        sodium.randombytes_set_implementation('sysrandom');
+    });
+
+    ['chacha20', 'salsa20', 'sysrandom'].forEach(function (name) {
+        it("should generate random bytes with " + name, function () {
+            sodium.randombytes_set_implementation(name);
+            assert.strictEqual(sodium.randombytes_implementation_name(), name);
+
+            var a = Buffer.alloc(24), b = Buffer.alloc(24), big = Buffer.alloc(100000);
+            sodium.randombytes_buf(a);
+            sodium.randombytes_buf(b);
+            sodium.randombytes_buf(big);
+            assert(!a.equals(b));
+            assert(!big.slice(-64).equals(Buffer.alloc(64)));
+            assert(sodium.randombytes_uniform(10) < 10);
+
+            var keys = sodium.crypto_box_keypair();
+            assert(!keys.secretKey.equals(Buffer.alloc(keys.secretKey.length)));
+        });
+    });
+
+    it("should throw on an unknown name", function () {
+        assert.throws(function () {
+            sodium.randombytes_set_implementation('rdrand');
+        }, /unknown randombytes implementation/);
+    });
+});
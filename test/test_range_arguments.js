@@ -0,0 +1,59 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("offset and length arguments", function () {
+    var key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 5);
+    var nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES, 9);
+    var messages = [Buffer.from("first frame"), Buffer.from("second, longer frame")];
+    var boxes = messages.map(function (m) {
+        return sodium.crypto_secretbox_easy(m, nonce, key);
+    });
+
+    // Frames packed into one receive buffer with junk around them
+    var receive = Buffer.concat([Buffer.from("xx"), boxes[0], boxes[1], Buffer.from("yyy")]);
+    var offsets = [2, 2 + boxes[0].length];
+
+    it("should open secretboxes at an offset and length", function (done) {
+        boxes.forEach(function (box, i) {
+            var m = sodium.crypto_secretbox_open_easy(receive, offsets[i], box.length, nonce, key);
+            assert(m.equals(messages[i]));
+        });
+        done();
+    });
+
+    it("should run to the end of the buffer when only an offset is given", function (done) {
+        var tail = receive.slice(0, receive.length - 3);
+        var m = sodium.crypto_secretbox_open_easy(tail, offsets[1], nonce, key);
+        assert(m.equals(messages[1]));
+        assert(sodium.crypto_secretbox_easy(messages[0], 0, nonce, key).equals(boxes[0]));
+        done();
+    });
+
+    it("should work for AEAD", function (done) {
+        var aeadKey = sodium.crypto_aead_chacha20poly1305_ietf_keygen();
+        var npub = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES, 1);
+        var plain = Buffer.from("..aead message..");
+        var c = sodium.crypto_aead_chacha20poly1305_ietf_encrypt(plain, 2, 12, null, npub, aeadKey);
+        var frame = Buffer.concat([Buffer.alloc(7), c]);
+
+        var m = sodium.crypto_aead_chacha20poly1305_ietf_decrypt(frame, 7, c.length, null, npub, aeadKey);
+        assert(m.equals(plain.slice(2, 14)));
+        done();
+    });
+
+    it("should reject ranges outside the buffer", function (done) {
+        assert.throws(function () {
+            sodium.crypto_secretbox_open_easy(receive, receive.length + 1, nonce, key);
+        }, RangeError);
+        assert.throws(function () {
+            sodium.crypto_secretbox_open_easy(receive, 2, receive.length, nonce, key);
+        }, RangeError);
+        assert.throws(function () {
+            sodium.crypto_secretbox_open_easy(receive, -1, 10, nonce, key);
+        }, RangeError);
+        assert.throws(function () {
+            sodium.crypto_secretbox_open_easy(receive, 1.5, 10, nonce, key);
+        }, RangeError);
+        done();
+    });
+});
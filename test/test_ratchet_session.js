@@ -0,0 +1,114 @@
+var assert = require('assert');
+var crypto = require('crypto');
+var sodium = require('../build/Release/sodium');
+
+describe("RatchetSession", function () {
+    function pair(maxSkip) {
+        var sharedKey = crypto.randomBytes(32);
+        var associatedData = Buffer.from('alice|bob');
+        var bobRatchet = sodium.crypto_box_keypair();
+        return {
+            a: new sodium.RatchetSession({ sharedKey: sharedKey, remotePublicKey: bobRatchet.publicKey,
+                                           associatedData: associatedData, maxSkip: maxSkip }),
+            b: new sodium.RatchetSession({ sharedKey: sharedKey, keyPair: bobRatchet,
+                                           associatedData: associatedData, maxSkip: maxSkip })
+        };
+    }
+
+    it("should exchange messages in both directions", function (done) {
+        var s = pair();
+        assert.throws(function () { s.b.encrypt(Buffer.from('too early')); });
+        for( var round = 0; round < 5; round++ ) {
+            var m = Buffer.from('from alice ' + round);
+            var c = s.a.encrypt(m);
+            assert.strictEqual(c.length, m.length + 80);
+            assert(s.b.decrypt(c).equals(m));
+            assert(s.b.remotePublicKey.equals(s.a.publicKey));
+            m = Buffer.from('from bob ' + round);
+            assert(s.a.decrypt(s.b.encrypt(m)).equals(m));
+        }
+        assert.strictEqual(s.a.skippedKeys, 0);
+        done();
+    });
+
+    it("should decrypt out of order and reject replays", function (done) {
+        var s = pair();
+        var c = [0, 1, 2, 3].map(function (i) { return s.a.encrypt(Buffer.from('m' + i)); });
+        assert.strictEqual(s.b.decrypt(c[2]).toString(), 'm2');
+        assert.strictEqual(s.b.skippedKeys, 2);
+        assert.strictEqual(s.b.decrypt(c[0]).toString(), 'm0');
+        assert.strictEqual(s.b.decrypt(c[0]), null);
+        s.a.decrypt(s.b.encrypt(Buffer.from('reply')));
+        assert.strictEqual(s.b.decrypt(s.a.encrypt(Buffer.from('next'))).toString(), 'next');
+        assert.strictEqual(s.b.decrypt(c[3]).toString(), 'm3');
+        assert.strictEqual(s.b.decrypt(c[1]).toString(), 'm1');
+        assert.strictEqual(s.b.skippedKeys, 0);
+        done();
+    });
+
+    it("should leave the session as it was on a forged message", function (done) {
+        var s = pair(2);
+        var c = s.a.encrypt(Buffer.from('hello'));
+        var forged = Buffer.from(c);
+        forged[forged.length - 1] ^= 1;
+        assert.strictEqual(s.b.decrypt(forged), null);
+        assert.strictEqual(s.b.remotePublicKey, null);
+        assert.strictEqual(s.b.decrypt(Buffer.alloc(10)), null);
+        assert.strictEqual(s.b.decrypt(c).toString(), 'hello');
+
+        s.a.encrypt(Buffer.from('1'));
+        s.a.encrypt(Buffer.from('2'));
+        s.a.encrypt(Buffer.from('3'));
+        assert.strictEqual(s.b.decrypt(s.a.encrypt(Buffer.from('4'))), null);
+        done();
+    });
+
+    it("should not accept messages before the receiving chain exists", function (done) {
+        var sharedKey = crypto.randomBytes(32);
+        var associatedData = Buffer.from('alice|bob');
+        var bobRatchet = sodium.crypto_box_keypair();
+        var a = new sodium.RatchetSession({ sharedKey: sharedKey, remotePublicKey: bobRatchet.publicKey,
+                                            associatedData: associatedData });
+
+        // Bob's ratchet key, pn 0 and n 0, sealed with the message key of
+        // an all zero chain key
+        var header = Buffer.concat([bobRatchet.publicKey, Buffer.alloc(8)]);
+        var npub = crypto.randomBytes(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES);
+        var mk = sodium.crypto_auth_hmacsha256(Buffer.from([1]), Buffer.alloc(32));
+        var c = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(Buffer.from('FORGED'),
+            Buffer.concat([associatedData, header]), npub, mk);
+        assert.strictEqual(a.decrypt(Buffer.concat([header, npub, c])), null);
+        done();
+    });
+
+    it("should restore a serialized session", function (done) {
+        var s = pair();
+        var c = [0, 1, 2].map(function (i) { return s.a.encrypt(Buffer.from('m' + i)); });
+        s.b.decrypt(c[2]);
+        var key = sodium.crypto_aead_xchacha20poly1305_ietf_keygen();
+        var state = s.b.serialize(key);
+        s.b.dispose();
+        assert.throws(function () { s.b.decrypt(c[0]); });
+        assert.throws(function () {
+            new sodium.RatchetSession({ state: state, stateKey: Buffer.alloc(32) });
+        });
+
+        var b = new sodium.RatchetSession({ state: state, stateKey: key });
+        assert.strictEqual(b.skippedKeys, 2);
+        assert.strictEqual(b.decrypt(c[1]).toString(), 'm1');
+        assert.strictEqual(s.a.decrypt(b.encrypt(Buffer.from('back'))).toString(), 'back');
+        done();
+    });
+
+    it("should check its options", function (done) {
+        var kp = sodium.crypto_box_keypair();
+        assert.throws(function () { new sodium.RatchetSession(); });
+        assert.throws(function () { new sodium.RatchetSession({ sharedKey: Buffer.alloc(16), keyPair: kp }); });
+        assert.throws(function () { new sodium.RatchetSession({ sharedKey: Buffer.alloc(32) }); });
+        assert.throws(function () {
+            new sodium.RatchetSession({ sharedKey: Buffer.alloc(32), keyPair: kp, remotePublicKey: kp.publicKey });
+        });
+        assert.throws(function () { new sodium.RatchetSession({ sharedKey: Buffer.alloc(32), keyPair: kp, maxSkip: -1 }); });
+        done();
+    });
+});
@@ -0,0 +1,82 @@
+var assert = require('assert');
+var net = require('net');
+var sodium = require('../build/Release/sodium');
+var SecureChannel = require('../lib/sodium').SecureChannel;
+
+describe("SecureChannel", function () {
+    var client = sodium.crypto_kx_keypair();
+    var server = sodium.crypto_kx_keypair();
+    var clientKeys = sodium.crypto_kx_client_session_keys(client.publicKey, client.secretKey, server.publicKey);
+    var serverKeys = sodium.crypto_kx_server_session_keys(server.publicKey, server.secretKey, client.publicKey);
+
+    // Server that echoes what a channel sends once it ends
+    function echoServer(onError, ready) {
+        var srv = net.createServer(function (socket) {
+            var channel = new SecureChannel(socket, serverKeys);
+            var received = [];
+            channel.on('data', function (d) { received.push(d); });
+            channel.on('end', function () { channel.end(Buffer.concat(received)); });
+            channel.on('error', onError);
+        });
+        srv.listen(0, '127.0.0.1', function () { ready(srv.address().port); });
+        return srv;
+    }
+
+    it("should echo through the channel and coalesce small writes", function (done) {
+        var big = Buffer.alloc(1024 * 1024 + 5);
+        sodium.randombytes_buf(big);
+        var srv = echoServer(done, function (port) {
+            var channel = new SecureChannel(net.connect(port, '127.0.0.1'), clientKeys);
+            var expected = [];
+            for (var i = 0; i < 1000; i++) {
+                expected.push(Buffer.from('message ' + i + '\n'));
+                channel.write('message ' + i + '\n');
+            }
+            expected.push(big);
+            channel.end(big);
+
+            var received = [];
+            channel.on('data', function (d) { received.push(d); });
+            channel.on('end', function () {
+                assert(Buffer.concat(received).equals(Buffer.concat(expected)));
+                // The 1000 writes of the first tick go out as one batch, the
+                // final frame as another
+                assert.equal(channel.stats.batches, 2);
+                srv.close(done);
+            });
+            channel.on('error', done);
+        });
+    });
+
+    it("should reject forged frames", function (done) {
+        var srv = echoServer(function (err) {
+            assert(/authentication/.test(err.message));
+            srv.close(done);
+        }, function (port) {
+            var socket = net.connect(port, '127.0.0.1', function () {
+                var frame = Buffer.alloc(4 + 5 + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES);
+                frame.writeUInt32LE(5, 0);
+                socket.write(frame);
+            });
+            socket.on('error', function () {});
+        });
+    });
+
+    it("should report a socket that ends without the final frame", function (done) {
+        var srv = echoServer(function (err) {
+            assert(/truncated/.test(err.message));
+            srv.close(done);
+        }, function (port) {
+            var socket = net.connect(port, '127.0.0.1', function () {
+                socket.end();
+            });
+            socket.on('error', function () {});
+        });
+    });
+
+    it("should check its keys and options", function () {
+        var socket = new net.Socket();
+        assert.throws(function () { new SecureChannel(socket, { rx: clientKeys.rx }); });
+        assert.throws(function () { new SecureChannel(socket, clientKeys, { frameSize: 0 }); });
+    });
+});
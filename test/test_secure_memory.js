@@ -0,0 +1,150 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var lib = require('../lib/sodium');
+
+describe("sodium_malloc", function () {
+    it("should allocate buffers bindings can use in place", function (done) {
+        var key = sodium.sodium_malloc(sodium.crypto_secretbox_KEYBYTES);
+        assert(Buffer.isBuffer(key));
+        assert.strictEqual(key.length, sodium.crypto_secretbox_KEYBYTES);
+        assert.strictEqual(key[0], 0xdb);
+
+        sodium.randombytes_buf(key);
+        var nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES);
+        var m = Buffer.from("secure");
+        var c = sodium.crypto_secretbox_easy(m, nonce, key);
+        assert(sodium.crypto_secretbox_easy(m, nonce, Buffer.from(key)).equals(c));
+        assert(sodium.crypto_secretbox_open_easy(c, nonce, key).equals(m));
+        done();
+    });
+
+    it("should tell secure buffers apart", function (done) {
+        var secure = sodium.sodium_malloc(16);
+        assert.strictEqual(sodium.sodium_is_secure_buffer(secure), true);
+        assert.strictEqual(sodium.sodium_is_secure_buffer(Buffer.alloc(16)), false);
+        assert.strictEqual(sodium.sodium_is_secure_buffer(secure.subarray(1)), false);
+        assert.strictEqual(sodium.sodium_is_secure_buffer("x"), false);
+        done();
+    });
+
+    it("should change the protection of secure buffers only", function (done) {
+        var key = sodium.sodium_malloc(32);
+        key.fill(1);
+        assert.strictEqual(sodium.sodium_mprotect_readonly(key), true);
+        assert.strictEqual(key[5], 1);
+        assert.strictEqual(sodium.sodium_mprotect_noaccess(key), true);
+        assert.strictEqual(sodium.sodium_mprotect_readwrite(key), true);
+        key[5] = 2;
+        assert.strictEqual(key[5], 2);
+
+        assert.throws(function () {
+            sodium.sodium_mprotect_noaccess(Buffer.alloc(32));
+        });
+        done();
+    });
+
+    it("should check its size", function (done) {
+        assert.throws(function () {
+            sodium.sodium_malloc(0);
+        });
+        done();
+    });
+
+    it("should lock and unlock ordinary buffers", function (done) {
+        var b = Buffer.alloc(64, 7);
+        if (sodium.sodium_mlock(b)) {
+            assert.strictEqual(sodium.sodium_munlock(b), true);
+            assert(b.equals(Buffer.alloc(64)));
+        }
+        done();
+    });
+
+    it("should keep keys in secure memory when asked", function (done) {
+        lib.useSecureMemory(true);
+        try {
+            var key = new lib.Key.SecretBox();
+            assert(sodium.sodium_is_secure_buffer(key.get()));
+            var hex = key.toString('hex');
+            var copy = new lib.Key.SecretBox(hex, 'hex');
+            assert(sodium.sodium_is_secure_buffer(copy.get()));
+            assert.strictEqual(copy.toString('hex'), hex);
+        } finally {
+            lib.useSecureMemory(false);
+        }
+        assert(!sodium.sodium_is_secure_buffer(new lib.Key.SecretBox().get()));
+        done();
+    });
+
+    it("should report the memory it holds", function (done) {
+        var before = sodium.sodium_memory_usage();
+        var key = sodium.sodium_malloc(100);
+        var signer = new sodium.SigningKey(Buffer.alloc(sodium.crypto_sign_SEEDBYTES, 1));
+
+        var usage = sodium.sodium_memory_usage();
+        assert(usage.secure >= before.secure + 100);
+        assert(usage.objects > before.objects);
+        assert(usage.total >= usage.secure + usage.objects);
+
+        signer.dispose();
+        assert.equal(sodium.sodium_memory_usage().objects, before.objects);
+        assert.equal(lib.memoryUsage().secure, usage.secure);
+        assert(key.length === 100);
+        done();
+    });
+});
+
+describe("sodium_secure_pool", function () {
+    afterEach(function () {
+        sodium.sodium_secure_pool_disable();
+    });
+
+    it("should keep object keys in shared slots", function (done) {
+        var before = sodium.sodium_secure_pool_stats();
+        assert.strictEqual(before.enabled, false);
+        assert.strictEqual(sodium.sodium_secure_pool_enable(), true);
+
+        var key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES, 3);
+        var nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, 4);
+        var m = Buffer.from("pooled");
+        var keys = [];
+        for (var i = 0; i < 50; i++) {
+            keys.push(new sodium.AeadContext("xchacha20poly1305_ietf", key));
+            keys.push(new sodium.HmacKey("hmacsha256", key));
+            keys.push(new sodium.SigningKey(Buffer.alloc(sodium.crypto_sign_SEEDBYTES, i)));
+        }
+        var stats = sodium.sodium_secure_pool_stats();
+        assert.strictEqual(stats.enabled, true);
+        assert(stats.slots >= keys.length);
+        assert(stats.regions > 0 && stats.regions < 10);
+        assert(stats.bytes >= stats.used);
+
+        var c = keys[0].encrypt(m, null, nonce);
+        assert(c.equals(sodium.crypto_aead_xchacha20poly1305_ietf_encrypt(m, null, nonce, key)));
+        assert(keys[1].mac(m).equals(sodium.crypto_auth_hmacsha256(m, key)));
+
+        keys.forEach(function (k) {
+            k.dispose();
+        });
+        assert.strictEqual(sodium.sodium_secure_pool_stats().slots, before.slots);
+        done();
+    });
+
+    it("should free its regions once disabled", function (done) {
+        sodium.sodium_secure_pool_enable();
+        var session = new sodium.BoxSession(
+            Buffer.alloc(sodium.crypto_box_PUBLICKEYBYTES, 9),
+            Buffer.alloc(sodium.crypto_box_SECRETKEYBYTES, 1));
+        assert.strictEqual(sodium.sodium_secure_pool_disable(), true);
+        assert(sodium.sodium_secure_pool_stats().regions > 0);
+        assert(sodium.sodium_memory_usage().securePool >= 0);
+
+        // Made after disable, with its own sodium_malloc block
+        var signer = new sodium.SigningKey(Buffer.alloc(sodium.crypto_sign_SEEDBYTES, 1));
+        session.dispose();
+        var stats = sodium.sodium_secure_pool_stats();
+        assert.strictEqual(stats.regions, 0);
+        assert.strictEqual(stats.slots, 0);
+        signer.dispose();
+        done();
+    });
+});
@@ -0,0 +1,72 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var Seekable = require('../lib/sodium').Seekable;
+
+describe("Seekable containers", function () {
+    var key = Seekable.keygen();
+    var message = Buffer.alloc(300000);
+    sodium.randombytes_buf(message);
+
+    it("should decrypt chunks on their own", function () {
+        var nonce = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_NPUBBYTES, 0xff);
+        var ad = Buffer.from('header');
+        var c = sodium.crypto_aead_xchacha20poly1305_ietf_encrypt_chunks(message, 1000, ad, nonce, 0, key, 4);
+        var frame = 1000 + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES;
+        assert.equal(c.length, message.length + 300 * sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES);
+
+        // Chunk 7 alone, with the nonce carried past its top byte
+        var next = Buffer.from(nonce);
+        var seven = Buffer.alloc(nonce.length);
+        seven[0] = 7;
+        sodium.sodium_add(next, seven);
+        assert(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt(c.slice(7 * frame, 8 * frame), ad, next, key)
+            .equals(message.slice(7000, 8000)));
+
+        var part = sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_chunks(c.slice(7 * frame, 20 * frame),
+            1000, ad, nonce, 7, key);
+        assert(part.equals(message.slice(7000, 20000)));
+        assert.equal(sodium.crypto_aead_xchacha20poly1305_ietf_decrypt_chunks(c.slice(7 * frame, 20 * frame),
+            1000, ad, nonce, 8, key), null);
+    });
+
+    it("should decrypt any range of a container", function () {
+        var container = Seekable.encrypt(message, key, { chunkSize: 4096, threads: 2 });
+        assert(Seekable.decryptRange(container, key).equals(message));
+        [[0, 1], [4095, 2], [4096, 4096], [12345, 100000], [message.length - 1, 1], [1000, 0]].forEach(function (r) {
+            assert(Seekable.decryptRange(container, key, r[0], r[1]).equals(message.slice(r[0], r[0] + r[1])));
+        });
+
+        var d = new Seekable.Decryptor(key, container.slice(0, Seekable.HEADERBYTES));
+        assert.equal(d.size, container.length);
+        var range = d.cipherRange(5000, 10);
+        assert.equal(range.end - range.start, 4096 + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        assert(d.decryptRange(5000, 10, container.slice(range.start, range.end)).equals(message.slice(5000, 5010)));
+    });
+
+    it("should write a container in parts", function () {
+        var e = new Seekable.Encryptor(key, message.length, { chunkSize: 1024 });
+        var parts = [e.header];
+        for (var offset = 0; offset < message.length; offset += 65536) {
+            parts.push(e.encryptRange(offset, message.slice(offset, offset + 65536)));
+        }
+        assert(Seekable.decryptRange(Buffer.concat(parts), key).equals(message));
+        assert.throws(function () { e.encryptRange(100, message.slice(100, 2148)); });
+        assert.throws(function () { e.encryptRange(0, message.slice(0, 1000)); });
+    });
+
+    it("should reject forged, truncated and empty containers", function () {
+        var container = Seekable.encrypt(message, key);
+        var forged = Buffer.from(container);
+        forged[10] ^= 1;
+        assert.throws(function () { Seekable.decryptRange(forged, key, 0, 10); });
+        forged = Buffer.from(container);
+        forged[forged.length - 1] ^= 1;
+        assert.throws(function () { Seekable.decryptRange(forged, key, message.length - 10, 10); });
+        assert.throws(function () { Seekable.decryptRange(container.slice(0, -1), key); });
+        assert.throws(function () { Seekable.decryptRange(container, key, message.length, 1); });
+
+        var empty = Seekable.encrypt(Buffer.alloc(0), key);
+        assert.equal(empty.length, Seekable.HEADERBYTES + sodium.crypto_aead_xchacha20poly1305_ietf_ABYTES);
+        assert.equal(Seekable.decryptRange(empty, key).length, 0);
+    });
+});
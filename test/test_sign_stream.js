@@ -0,0 +1,94 @@
+var assert = require('assert');
+var crypto = require('crypto');
+var sodium = require('../build/Release/sodium');
+var SignStream = require('../lib/sign-stream');
+
+// Split `buf` into random sized pieces, some larger than the coalesce size
+function pieces(buf, max) {
+    var out = [];
+    var pos = 0;
+    while( pos < buf.length ) {
+        var n = 1 + Math.floor(Math.random() * max);
+        out.push(buf.slice(pos, pos + n));
+        pos += n;
+    }
+    return out;
+}
+
+var data = crypto.randomBytes(300000);
+var kp = sodium.crypto_sign_keypair();
+
+function signParts(parts) {
+    var state = sodium.crypto_sign_init();
+    parts.forEach(function(p) { sodium.crypto_sign_update(state, p); });
+    return sodium.crypto_sign_final_create(state, kp.secretKey);
+}
+
+describe('crypto_sign multipart', function() {
+    it('should not depend on how the message is split', function(done) {
+        var sig = signParts([data]);
+        assert.equal(sig.length, sodium.crypto_sign_BYTES);
+        assert.ok(signParts(pieces(data, 10000)).equals(sig));
+
+        var state = sodium.crypto_sign_init();
+        assert.equal(state.length, sodium.crypto_sign_statebytes());
+        pieces(data, 5000).forEach(function(p) { sodium.crypto_sign_update(state, p); });
+        assert.ok(sodium.crypto_sign_final_verify(state, sig, kp.publicKey));
+        done();
+    });
+
+    it('should reject a changed message', function(done) {
+        var sig = signParts([data]);
+        var state = sodium.crypto_sign_init();
+        sodium.crypto_sign_update(state, data.slice(1));
+        assert.ok(!sodium.crypto_sign_final_verify(state, sig, kp.publicKey));
+        done();
+    });
+
+    it('SignState should match the buffer state functions', function(done) {
+        var sig = signParts([data]);
+        var state = new sodium.SignState();
+        pieces(data, 10000).forEach(function(p) { state.update(p); });
+        assert.ok(state.finalCreate(kp.secretKey).equals(sig));
+        assert.throws(function() { state.update(data); });
+
+        state = new sodium.SignState().update(data);
+        assert.strictEqual(state.finalVerify(sig, kp.publicKey), true);
+
+        state = new sodium.SignState().update(data);
+        state.dispose();
+        assert.throws(function() { state.finalCreate(kp.secretKey); });
+        done();
+    });
+});
+
+describe('SignStream', function() {
+    it('should emit the multipart signature', function(done) {
+        var s = new SignStream.SignStream(kp.secretKey, { coalesceSize: 4096 });
+        var out = [];
+        s.on('data', function(d) { out.push(d); });
+        s.on('end', function() {
+            assert.ok(Buffer.concat(out).equals(signParts([data])));
+            assert.ok(s.sign().equals(signParts([data])));
+            done();
+        });
+        pieces(data, 100).forEach(function(p) { s.write(p); });
+        s.end();
+    });
+
+    it('VerifyStream should accept good and reject bad signatures', function(done) {
+        var sig = new SignStream.SignStream(kp.secretKey).update(data).sign();
+        var v = new SignStream.VerifyStream(sig, kp.publicKey, { coalesceSize: 4096 });
+        v.on('verify', function(ok) {
+            assert.strictEqual(ok, true);
+
+            var forged = Buffer.from(sig);
+            forged[5] ^= 1;
+            var bad = new SignStream.VerifyStream(forged, kp.publicKey);
+            assert.strictEqual(bad.update(data).verify(), false);
+            done();
+        });
+        pieces(data, 10000).forEach(function(p) { v.write(p); });
+        v.end();
+    });
+});
@@ -0,0 +1,112 @@
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+
+describe("Encrypted snapshots", function () {
+    var dir = fs.mkdtempSync(path.join(os.tmpdir(), 'sodium-snapshot-'));
+    var file = path.join(dir, 'keys.snap');
+    var key = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES);
+    var other = Buffer.alloc(sodium.crypto_aead_xchacha20poly1305_ietf_KEYBYTES);
+    sodium.randombytes_buf(key);
+    sodium.randombytes_buf(other);
+
+    afterEach(function () {
+        if (fs.existsSync(file)) {
+            fs.unlinkSync(file);
+        }
+    });
+
+    after(function () {
+        sodium.crypto_box_cache_disable();
+        fs.rmdirSync(dir);
+    });
+
+    it("should round trip named secrets", function () {
+        var master = Buffer.alloc(sodium.crypto_kdf_KEYBYTES);
+        sodium.randombytes_buf(master);
+        var secrets = {
+            acme: sodium.crypto_kdf_derive_from_key(32, 1, 'tenants_', master),
+            initech: sodium.crypto_kdf_derive_from_key(64, 2, 'tenants_', master),
+            empty: Buffer.alloc(0)
+        };
+        assert.strictEqual(sodium.sodium_snapshot_save(file, key, secrets), 3);
+        if (process.platform !== 'win32') {
+            assert.strictEqual(fs.statSync(file).mode & 0o777, 0o600);
+        }
+
+        var loaded = sodium.sodium_snapshot_load(file, key);
+        assert.deepStrictEqual(Object.keys(loaded).sort(), ['acme', 'empty', 'initech']);
+        assert(loaded.acme.equals(secrets.acme));
+        assert(loaded.initech.equals(secrets.initech));
+        assert.strictEqual(loaded.empty.length, 0);
+        assert(sodium.sodium_is_secure_buffer(loaded.acme));
+    });
+
+    it("should refuse a wrong key, a changed file or another kind", function () {
+        sodium.sodium_snapshot_save(file, key, { a: Buffer.from('secret') });
+        assert.throws(function () { sodium.sodium_snapshot_load(file, other); }, /does not verify/);
+
+        var data = fs.readFileSync(file);
+        data[data.length - 20] ^= 1;
+        fs.writeFileSync(file, data);
+        assert.throws(function () { sodium.sodium_snapshot_load(file, key); }, /does not verify/);
+
+        fs.writeFileSync(file, data.slice(0, data.length - 1));
+        assert.throws(function () { sodium.sodium_snapshot_load(file, key); }, /truncated/);
+
+        var ring = new sodium.AeadKeyring('xchacha20poly1305_ietf');
+        ring.add(1, key);
+        ring.save(file, key);
+        assert.throws(function () { sodium.sodium_snapshot_load(file, key); }, /not of secrets/);
+        ring.dispose();
+    });
+
+    it("should restore an AeadKeyring", function () {
+        var k1 = Buffer.alloc(32, 1), k2 = Buffer.alloc(32, 2);
+        var ring = new sodium.AeadKeyring('xchacha20poly1305_ietf');
+        ring.add(1, k1);
+        ring.add(2, k2, true);
+        var frame1 = ring.encrypt(Buffer.from('old'), null);
+        ring.setPrimary(1);
+        ring.save(file, key);
+        ring.setPrimary(2);
+        var frame2 = ring.encrypt(Buffer.from('new'), null);
+
+        var copy = new sodium.AeadKeyring('xchacha20poly1305_ietf');
+        assert.strictEqual(copy.load(file, key), 2);
+        assert.strictEqual(copy.size, 2);
+        assert.strictEqual(copy.primary, 1);
+        assert.strictEqual(copy.decrypt(frame1, null).toString(), 'old');
+        assert.strictEqual(copy.decrypt(frame2, null).toString(), 'new');
+
+        var chacha = new sodium.AeadKeyring('chacha20poly1305_ietf');
+        assert.throws(function () { chacha.load(file, key); }, /a snapshot of aead.xchacha20poly1305_ietf/);
+        assert.throws(function () { copy.load(file, other); }, /does not verify/);
+        assert.strictEqual(copy.size, 2);
+        [ring, copy, chacha].forEach(function (r) { r.dispose(); });
+    });
+
+    it("should restore the box key cache", function () {
+        var alice = sodium.crypto_box_keypair();
+        var bob = sodium.crypto_box_keypair();
+        var nonce = Buffer.alloc(sodium.crypto_box_NONCEBYTES, 3);
+        var m = Buffer.from('warm restart');
+
+        assert.throws(function () { sodium.crypto_box_cache_save(file, key); }, /disabled/);
+        sodium.crypto_box_cache_enable(4);
+        var c = sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey);
+        assert.strictEqual(sodium.crypto_box_cache_save(file, key), 1);
+
+        sodium.crypto_box_cache_enable(4);
+        assert.strictEqual(sodium.crypto_box_cache_load(file, key), 1);
+        var stats = sodium.crypto_box_cache_stats();
+        assert.strictEqual(stats.size, 1);
+        assert(sodium.crypto_box_easy(m, nonce, bob.publicKey, alice.secretKey).equals(c));
+        assert.strictEqual(sodium.crypto_box_cache_stats().hits, stats.hits + 1);
+
+        assert.throws(function () { sodium.crypto_box_cache_load(file, other); }, /does not verify/);
+        assert.strictEqual(sodium.crypto_box_cache_stats().size, 1);
+    });
+});
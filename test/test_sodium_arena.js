@@ -0,0 +1,80 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("Arena", function () {
+    var key = Buffer.alloc(sodium.crypto_auth_KEYBYTES, 1);
+    var m = Buffer.from("request scoped");
+
+    it("should cut results from its buffer while entered", function (done) {
+        var tag = sodium.crypto_auth(m, key);
+        var arena = new sodium.Arena(1024);
+
+        arena.enter();
+        var a, b;
+        try {
+            a = sodium.crypto_auth(m, key);
+            b = sodium.crypto_hash_sha256(m);
+        } finally {
+            arena.exit();
+        }
+        assert(a.equals(tag));
+        assert(b.equals(sodium.crypto_hash_sha256(Buffer.from(m))));
+        assert.strictEqual(a.buffer, b.buffer);
+        assert.strictEqual(a.buffer.byteLength, 1024);
+        assert.strictEqual(b.byteOffset % 16, 0);
+
+        var c = sodium.crypto_auth(m, key);
+        assert.notStrictEqual(c.buffer, a.buffer);
+
+        var stats = arena.stats();
+        assert.strictEqual(stats.size, 1024);
+        assert.strictEqual(stats.allocations, 2);
+        assert(stats.used >= 64);
+        done();
+    });
+
+    it("should take all results back on reset", function (done) {
+        var arena = new sodium.Arena(64);
+        arena.enter();
+        var a = sodium.crypto_auth(m, key);
+        var big = sodium.crypto_hash_sha512(m);
+        arena.exit();
+
+        assert.strictEqual(arena.stats().overflows, 1);
+        assert.notStrictEqual(big.buffer, a.buffer);
+        assert.strictEqual(arena.reset(true), 32);
+        assert(a.equals(Buffer.alloc(32)));
+        assert.strictEqual(arena.stats().used, 0);
+        done();
+    });
+
+    it("should nest", function (done) {
+        var outer = new sodium.Arena(256), inner = new sodium.Arena(256);
+        outer.enter();
+        inner.enter();
+        assert.throws(function () {
+            outer.exit();
+        });
+        assert.throws(function () {
+            inner.enter();
+        });
+        var a = sodium.crypto_auth(m, key);
+        inner.exit();
+        var b = sodium.crypto_auth(m, key);
+        outer.exit();
+        assert.strictEqual(inner.stats().allocations, 1);
+        assert.strictEqual(outer.stats().allocations, 1);
+        assert(a.equals(b));
+        done();
+    });
+
+    it("should check its size", function (done) {
+        assert.throws(function () {
+            new sodium.Arena(0);
+        });
+        assert.throws(function () {
+            new sodium.Arena("big");
+        });
+        done();
+    });
+});
@@ -0,0 +1,155 @@
+"use strict";
+
+var assert = require('assert');
+var fs = require('fs');
+var os = require('os');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+
+var password = Buffer.from('this is a test password', 'utf8');
+var salt = Buffer.alloc(sodium.crypto_pwhash_SALTBYTES, 5);
+var OPS = sodium.crypto_pwhash_OPSLIMIT_MIN + 1;
+var MEM = 4 << 20;
+
+function hash(options) {
+    return sodium.crypto_pwhash_async(32, password, salt, OPS, MEM, sodium.crypto_pwhash_ALG_DEFAULT, options);
+}
+
+function nameOf(promise) {
+    return promise.then(function() { return 'ok'; }, function(err) { return err.name; });
+}
+
+describe('async cancellation', function() {
+    afterEach(function() {
+        sodium.sodium_pwhash_pool_configure({ threads: 2, maxQueue: 256 });
+    });
+
+    it('should validate the options', function() {
+        assert.throws(function() { hash({ signal: 'abort' }); }, TypeError);
+        assert.throws(function() { hash({ deadline: 'soon' }); }, TypeError);
+        assert.throws(function() { hash({ timeout: -1 }); }, TypeError);
+    });
+
+    it('should reject at once with an aborted signal', function() {
+        var controller = new AbortController();
+        controller.abort();
+        return hash({ signal: controller.signal }).then(function() {
+            assert.fail('should not resolve');
+        }, function(err) {
+            assert.equal(err.name, 'AbortError');
+        });
+    });
+
+    it('should use the reason of the signal', function() {
+        var controller = new AbortController();
+        var reason = new Error('client went away');
+        controller.abort(reason);
+        return hash({ signal: controller.signal }).catch(function(err) {
+            assert.strictEqual(err, reason);
+        });
+    });
+
+    it('should drop queued password hashes when aborted', function() {
+        sodium.sodium_pwhash_pool_configure({ threads: 1 });
+        // Let the surplus thread go, so the first job holds the only one
+        return hash().then(function() {
+            var before = sodium.sodium_pwhash_pool_stats();
+            var controller = new AbortController();
+
+            var first = nameOf(hash());
+            var queued = [0, 1, 2].map(function() {
+                return nameOf(hash({ signal: controller.signal }));
+            });
+            controller.abort();
+
+            return Promise.all([first].concat(queued)).then(function(names) {
+                assert.deepEqual(names, ['ok', 'AbortError', 'AbortError', 'AbortError']);
+                var after = sodium.sodium_pwhash_pool_stats();
+                assert.equal(after.cancelled - before.cancelled, 3);
+                assert.equal(after.completed - before.completed, 1);
+            });
+        });
+    });
+
+    it('should not hash jobs past their deadline', function() {
+        sodium.sodium_pwhash_pool_configure({ threads: 1 });
+        var before = sodium.sodium_pwhash_pool_stats();
+        var first = nameOf(hash());
+        var late = nameOf(hash({ deadline: Date.now() - 1 }));
+        var dated = nameOf(hash({ deadline: new Date(Date.now() - 1) }));
+        var timeout = nameOf(hash({ timeout: 0 }));
+        return Promise.all([first, late, dated, timeout]).then(function(names) {
+            assert.deepEqual(names, ['ok', 'TimeoutError', 'TimeoutError', 'TimeoutError']);
+            assert.equal(sodium.sodium_pwhash_pool_stats().cancelled - before.cancelled, 3);
+        });
+    });
+
+    it('should resolve jobs that finish before the deadline', function() {
+        var expected = sodium.crypto_pwhash(32, password, salt, OPS, MEM, sodium.crypto_pwhash_ALG_DEFAULT);
+        var controller = new AbortController();
+        return hash({ signal: controller.signal, timeout: 60000 }).then(function(out) {
+            assert.deepEqual(out, expected);
+            // The listener is gone: aborting now changes nothing
+            controller.abort();
+        });
+    });
+
+    it('should call callbacks with the cancellation', function(done) {
+        sodium.crypto_pwhash_str_async(password, OPS, MEM, { timeout: 0 }, function(err, out) {
+            assert.equal(err.name, 'TimeoutError');
+            assert.equal(err.code, 'ETIMEDOUT');
+            assert.equal(out, undefined);
+            done();
+        });
+    });
+
+    it('should cancel jobs on the libuv threadpool', function() {
+        var big = Buffer.alloc(8 << 20, 1);
+        var controller = new AbortController();
+        var jobs = [0, 1, 2, 3, 4, 5].map(function() {
+            return nameOf(sodium.crypto_generichash_async(32, big, null, { signal: controller.signal }));
+        });
+        controller.abort();
+        return Promise.all(jobs).then(function(names) {
+            names.forEach(function(name) {
+                assert.equal(name, 'AbortError');
+            });
+        });
+    });
+
+    it('should hash in pieces with the same result', function() {
+        var big = Buffer.alloc((3 << 20) + 17, 7);
+        return Promise.all([
+            sodium.crypto_generichash_async(32, big, null, { timeout: 60000 }),
+            sodium.crypto_hash_sha256_async(big, {}),
+            sodium.crypto_hash_sha512_async(big)
+        ]).then(function(results) {
+            assert.deepEqual(results[0], sodium.crypto_generichash(32, big, null));
+            assert.deepEqual(results[1], sodium.crypto_hash_sha256(big));
+            assert.deepEqual(results[2], sodium.crypto_hash_sha512(big));
+        });
+    });
+
+    it('should reject inline jobs with a passed deadline', function() {
+        return nameOf(sodium.crypto_hash_sha256_async(Buffer.from('small'), { deadline: 0 })).then(function(name) {
+            assert.equal(name, 'TimeoutError');
+        });
+    });
+
+    it('should stop file digests between blocks', function() {
+        var file = path.join(os.tmpdir(), 'sodium-cancel-' + process.pid);
+        fs.writeFileSync(file, Buffer.alloc(4 << 20, 3));
+        var controller = new AbortController();
+        controller.abort();
+        return Promise.all([
+            nameOf(sodium.sodium_hash_file(file, 'sha256', { signal: controller.signal })),
+            nameOf(sodium.sodium_auth_file(file, Buffer.alloc(32, 1), 'hmacsha256', { timeout: 0 })),
+            sodium.sodium_hash_file(file, 'generichash', { timeout: 60000 })
+        ]).then(function(results) {
+            fs.unlinkSync(file);
+            assert.equal(results[0], 'AbortError');
+            assert.equal(results[1], 'TimeoutError');
+            assert.deepEqual(results[2], sodium.crypto_generichash(32, Buffer.alloc(4 << 20, 3), null));
+        });
+    });
+});
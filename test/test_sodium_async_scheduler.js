@@ -0,0 +1,146 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var big = Buffer.alloc(4 << 20, 7);
+var small = Buffer.from('token to check');
+
+function defaults() {
+    sodium.sodium_async_scheduler_configure({
+        threads: 4,
+        interactive: { concurrency: 4, maxQueue: 1024 },
+        bulk: { concurrency: 2, maxQueue: 64 },
+        cpus: null
+    });
+}
+
+function sha256(message, priority, cb) {
+    if( cb ) {
+        return sodium.crypto_hash_sha256_async(message, { priority: priority }, cb);
+    }
+    return sodium.crypto_hash_sha256_async(message, { priority: priority });
+}
+
+describe('sodium_async_scheduler', function() {
+    afterEach(defaults);
+
+    it('should report its configuration and counters', function() {
+        var stats = sodium.sodium_async_scheduler_stats();
+        assert.equal(stats.threads, 4);
+        assert.equal(stats.interactive.concurrency, 4);
+        assert.equal(stats.interactive.maxQueue, 1024);
+        assert.equal(stats.bulk.concurrency, 2);
+        assert.equal(stats.bulk.maxQueue, 64);
+        ['running', 'queued', 'queuePeak', 'submitted', 'completed', 'rejected', 'cancelled', 'waitTotal', 'waitMax'].forEach(function(key) {
+            assert.equal(typeof stats.bulk[key], 'number', key);
+        });
+    });
+
+    it('should validate options', function() {
+        assert.throws(function() { sodium.sodium_async_scheduler_configure(); });
+        assert.throws(function() { sodium.sodium_async_scheduler_configure({ threads: 65 }); });
+        assert.throws(function() { sodium.sodium_async_scheduler_configure({ bulk: 1 }); });
+        assert.throws(function() { sodium.sodium_async_scheduler_configure({ bulk: { concurrency: 0 } }); });
+        assert.throws(function() { sodium.sodium_async_scheduler_configure({ interactive: { maxQueue: -1 } }); });
+        assert.throws(function() { sodium.sodium_async_scheduler_configure({ cpus: ['0'] }); });
+        assert.throws(function() { sha256(big, 'urgent'); }, TypeError);
+    });
+
+    if( process.platform == 'linux' ) {
+        it('should pin its threads to the listed CPUs', function() {
+            sodium.sodium_async_scheduler_configure({ threads: 1, cpus: [0] });
+            return sha256(big, 'interactive').then(function() {
+                var stats = sodium.sodium_async_scheduler_stats();
+                assert.deepEqual(stats.cpus, [0]);
+                var pinned = stats.workers.filter(function(w) { return w.pinned == 0; });
+                assert.equal(pinned.length, 1);
+                assert.equal(pinned[0].cpu, 0);
+                assert.ok(pinned[0].jobs >= 1);
+            });
+        });
+    }
+
+    it('should run jobs in their class', function() {
+        var before = sodium.sodium_async_scheduler_stats();
+        var expected = sodium.crypto_hash_sha256(big);
+        return Promise.all([sha256(big, 'bulk'), sha256(big, 'interactive'), sha256(big, 'bulk')]).then(function(results) {
+            results.forEach(function(out) {
+                assert.deepEqual(out, expected);
+            });
+            var after = sodium.sodium_async_scheduler_stats();
+            assert.equal(after.bulk.completed - before.bulk.completed, 2);
+            assert.equal(after.interactive.completed - before.interactive.completed, 1);
+            assert.equal(after.bulk.running + after.bulk.queued, 0);
+        });
+    });
+
+    it('should run interactive jobs ahead of queued bulk jobs', function(done) {
+        sodium.sodium_async_scheduler_configure({ threads: 1, bulk: { concurrency: 1 } });
+        var order = [];
+        function finished(name) {
+            return function(err) {
+                assert.ifError(err);
+                order.push(name);
+                if( order.length == 4 ) {
+                    // At most the bulk job already on the thread goes first
+                    assert.ok(order.indexOf('interactive') <= 1, order.join());
+                    done();
+                }
+            };
+        }
+        sha256(big, 'bulk', finished('bulk'));
+        sha256(big, 'bulk', finished('bulk'));
+        sha256(big, 'bulk', finished('bulk'));
+        sha256(small, 'interactive', finished('interactive'));
+    });
+
+    it('should keep threads free of bulk jobs', function() {
+        sodium.sodium_async_scheduler_configure({ threads: 2, bulk: { concurrency: 1 } });
+        var jobs = [0, 1, 2].map(function() { return sha256(big, 'bulk'); });
+        var stats = sodium.sodium_async_scheduler_stats();
+        assert.ok(stats.bulk.running <= 1);
+        return Promise.all(jobs);
+    });
+
+    it('should reject jobs when the class queue is full', function() {
+        sodium.sodium_async_scheduler_configure({ threads: 1, bulk: { concurrency: 1, maxQueue: 1 } });
+        var before = sodium.sodium_async_scheduler_stats().bulk.rejected;
+
+        var jobs = [];
+        for (var i = 0; i < 5; i++) {
+            jobs.push(sha256(big, 'bulk').then(function() { return 'ok'; }, function(err) { return err.message; }));
+        }
+        // The interactive queue is not affected
+        jobs.push(sha256(small, 'interactive').then(function() { return 'ok'; }));
+        return Promise.all(jobs).then(function(results) {
+            assert.equal(results[0], 'ok');
+            assert.equal(results[5], 'ok');
+            assert.ok(results.indexOf('bulk queue is full') > 0);
+            var rejected = results.filter(function(r) { return r != 'ok'; }).length;
+            assert.equal(sodium.sodium_async_scheduler_stats().bulk.rejected - before, rejected);
+        });
+    });
+
+    it('should drop queued jobs when aborted', function() {
+        sodium.sodium_async_scheduler_configure({ threads: 1, bulk: { concurrency: 1 } });
+        var before = sodium.sodium_async_scheduler_stats().bulk.cancelled;
+        var controller = new AbortController();
+        var first = sha256(big, 'bulk');
+        var queued = sodium.crypto_hash_sha256_async(big, { priority: 'bulk', signal: controller.signal });
+        controller.abort();
+        return Promise.all([first, queued.then(function() { return 'ok'; }, function(err) { return err.name; })]).then(function(results) {
+            assert.equal(results[1], 'AbortError');
+            assert.equal(sodium.sodium_async_scheduler_stats().bulk.cancelled - before, 1);
+        });
+    });
+
+    it('should fall back to the libuv threadpool with no threads', function() {
+        sodium.sodium_async_scheduler_configure({ threads: 0 });
+        var before = sodium.sodium_async_scheduler_stats().bulk.submitted;
+        return sha256(big, 'bulk').then(function(out) {
+            assert.deepEqual(out, sodium.crypto_hash_sha256(big));
+            assert.equal(sodium.sodium_async_scheduler_stats().bulk.submitted, before);
+        });
+    });
+});
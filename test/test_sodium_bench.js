@@ -0,0 +1,49 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("sodium_bench probes", function () {
+    it("should time libsodium calls natively", function (done) {
+        ["crypto_generichash", "crypto_verify_16", "crypto_auth", "crypto_onetimeauth",
+         "crypto_secretbox_easy", "randombytes_buf"].forEach(function (name) {
+            var ns = sodium.sodium_bench_native(name, 64, 10);
+            assert(ns > 0 && isFinite(ns));
+        });
+        assert.throws(function () {
+            sodium.sodium_bench_native("crypto_nothing", 64, 10);
+        });
+        assert.throws(function () {
+            sodium.sodium_bench_native("crypto_auth", 64, 0);
+        });
+        done();
+    });
+
+    it("should parse arguments like a binding", function (done) {
+        assert.strictEqual(sodium.sodium_bench_noop(1, 2, 3), undefined);
+        assert.strictEqual(sodium.sodium_bench_args(Buffer.alloc(1), Buffer.alloc(2)), undefined);
+        assert.throws(function () {
+            sodium.sodium_bench_args(Buffer.alloc(1));
+        });
+        assert.strictEqual(sodium.sodium_bench_alloc(32).length, 32);
+        done();
+    });
+
+    it("should read the hardware counters where the host has them", function (done) {
+        try {
+            sodium.sodium_bench_counters_open();
+        } catch (e) {
+            // No PMU, as in most containers and virtual machines
+            assert(/perf_event_open|Linux/.test(e.message));
+            assert.strictEqual(sodium.sodium_bench_counters_stop(), undefined);
+            return done();
+        }
+        sodium.sodium_bench_counters_start();
+        sodium.sodium_bench_native("crypto_generichash", 1024, 100);
+        var counts = sodium.sodium_bench_counters_stop();
+        assert(counts.cycles > 0);
+        assert(counts.instructions > 0);
+        assert(counts.cacheMisses === -1 || counts.cacheMisses >= 0);
+        done();
+    });
+});
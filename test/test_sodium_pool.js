@@ -0,0 +1,65 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("sodium_pool", function () {
+    var key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 1);
+    var nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES, 2);
+    var m = Buffer.from("pooled message");
+
+    afterEach(function () {
+        sodium.sodium_pool_disable();
+    });
+
+    it("should be disabled by default", function (done) {
+        assert.strictEqual(sodium.sodium_pool_stats().enabled, false);
+        done();
+    });
+
+    it("should give the same results from the pool", function (done) {
+        var hash = sodium.crypto_generichash(32, m, null);
+        var c = sodium.crypto_secretbox_easy(m, nonce, key);
+
+        sodium.sodium_pool_enable();
+        var pooledHash = sodium.crypto_generichash(32, m, null);
+        var pooledC = sodium.crypto_secretbox_easy(m, nonce, key);
+        assert(Buffer.isBuffer(pooledHash));
+        assert(pooledHash.equals(hash));
+        assert(pooledC.equals(c));
+        assert(sodium.crypto_secretbox_open_easy(pooledC, nonce, key).equals(m));
+        assert.strictEqual(pooledHash.length, 32);
+        assert.strictEqual(pooledHash.buffer.byteLength, 8192);
+        assert.strictEqual(pooledHash.byteOffset % 32, 0);
+
+        var stats = sodium.sodium_pool_stats();
+        assert.strictEqual(stats.enabled, true);
+        assert.strictEqual(stats.maxSize, 128);
+        assert(stats.pooled >= 3);
+        done();
+    });
+
+    it("should keep results apart", function (done) {
+        sodium.sodium_pool_enable(256, 32);
+        var hashes = [];
+        for (var i = 0; i < 20; i++) {
+            hashes.push(sodium.crypto_generichash(32, Buffer.from([i]), null));
+        }
+        hashes.forEach(function (h, i) {
+            assert(h.equals(sodium.crypto_generichash(32, Buffer.from([i]), null)));
+        });
+        assert.strictEqual(sodium.sodium_pool_stats().slabs, 5);
+
+        // larger than maxSize
+        var big = sodium.crypto_generichash(64, m, null);
+        assert.strictEqual(big.buffer.byteLength, 64);
+        assert.strictEqual(sodium.sodium_pool_stats().unpooled, 1);
+        done();
+    });
+
+    it("should check its parameters", function (done) {
+        assert.throws(function () {
+            sodium.sodium_pool_enable(64, 128);
+        });
+        assert.strictEqual(sodium.sodium_pool_stats().enabled, false);
+        done();
+    });
+});
@@ -0,0 +1,140 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var password = Buffer.from('this is a test password', 'utf8');
+var salt = Buffer.alloc(sodium.crypto_pwhash_SALTBYTES, 9);
+var MEM = 2 << 20;
+
+function hash(alg) {
+    return sodium.crypto_pwhash(32, password, salt, 2, MEM, alg || sodium.crypto_pwhash_ALG_ARGON2ID13);
+}
+
+describe('sodium_pwhash_memory_pool', function() {
+    afterEach(function() {
+        sodium.sodium_pwhash_memory_huge_pages('off');
+        sodium.sodium_pwhash_memory_pool_disable();
+    });
+
+    it('should be off by default', function() {
+        var stats = sodium.sodium_pwhash_memory_pool_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.equal(stats.regions, 0);
+    });
+
+    it('should not change the hashes', function() {
+        var expected = hash();
+        var expectedI = hash(sodium.crypto_pwhash_ALG_ARGON2I13);
+        sodium.sodium_pwhash_memory_pool_enable(1);
+        assert.deepEqual(hash(), expected);
+        assert.deepEqual(hash(), expected);
+        assert.deepEqual(hash(sodium.crypto_pwhash_ALG_ARGON2I13), expectedI);
+    });
+
+    it('should reuse regions between hashes', function() {
+        sodium.sodium_pwhash_memory_pool_enable(1);
+        var before = sodium.sodium_pwhash_memory_pool_stats();
+        hash();
+        hash();
+        hash();
+        var after = sodium.sodium_pwhash_memory_pool_stats();
+        assert.equal(after.misses - before.misses, 1);
+        assert.equal(after.hits - before.hits, 2);
+        assert.equal(after.regions, 1);
+        assert.equal(after.bytes, MEM);
+        assert.equal(after.inUse, 0);
+        assert.equal(typeof after.remoteHits, 'number');
+        var nodes = Object.keys(after.nodes);
+        assert.equal(nodes.length, 1);
+        assert.equal(after.nodes[nodes[0]], MEM);
+    });
+
+    it('should prefault regions for a memory limit', function() {
+        sodium.sodium_pwhash_memory_pool_enable(2, MEM);
+        var stats = sodium.sodium_pwhash_memory_pool_stats();
+        assert.equal(stats.maxRegions, 2);
+        assert.equal(stats.regions, 2);
+        assert.equal(stats.bytes, 2 * MEM);
+
+        hash();
+        var after = sodium.sodium_pwhash_memory_pool_stats();
+        assert.equal(after.hits - stats.hits, 1);
+        assert.equal(after.misses, stats.misses);
+    });
+
+    it('should give smaller hashes a pooled region', function() {
+        sodium.sodium_pwhash_memory_pool_enable(1, MEM);
+        var before = sodium.sodium_pwhash_memory_pool_stats();
+        var small = sodium.crypto_pwhash(32, password, salt, 2, MEM / 2, sodium.crypto_pwhash_ALG_ARGON2ID13);
+        var after = sodium.sodium_pwhash_memory_pool_stats();
+        assert.equal(after.hits - before.hits, 1);
+        assert.equal(after.bytes, MEM);
+
+        sodium.sodium_pwhash_memory_pool_disable();
+        assert.deepEqual(small, sodium.crypto_pwhash(32, password, salt, 2, MEM / 2, sodium.crypto_pwhash_ALG_ARGON2ID13));
+    });
+
+    it('should work with the async bindings', function() {
+        var expected = hash();
+        sodium.sodium_pwhash_memory_pool_enable(2);
+        return Promise.all([0, 1, 2, 3].map(function() {
+            return sodium.crypto_pwhash_async(32, password, salt, 2, MEM, sodium.crypto_pwhash_ALG_ARGON2ID13);
+        })).then(function(results) {
+            results.forEach(function(out) {
+                assert.deepEqual(out, expected);
+            });
+            assert.ok(sodium.sodium_pwhash_memory_pool_stats().regions <= 2);
+        });
+    });
+
+    it('should release its regions when disabled', function() {
+        sodium.sodium_pwhash_memory_pool_enable(2, MEM);
+        sodium.sodium_pwhash_memory_pool_disable();
+        var stats = sodium.sodium_pwhash_memory_pool_stats();
+        assert.strictEqual(stats.enabled, false);
+        assert.equal(stats.regions, 0);
+        assert.equal(stats.bytes, 0);
+    });
+
+    it('should validate the huge page mode', function() {
+        assert.throws(function() { sodium.sodium_pwhash_memory_huge_pages(); });
+        assert.throws(function() { sodium.sodium_pwhash_memory_huge_pages(1); });
+        assert.throws(function() { sodium.sodium_pwhash_memory_huge_pages('always'); });
+        assert.equal(sodium.sodium_pwhash_memory_huge_pages('off'), 'off');
+    });
+
+    ['transparent', 'explicit'].forEach(function(mode) {
+        it('should hash the same on ' + mode + ' huge pages', function() {
+            var expected = hash();
+            var got = sodium.sodium_pwhash_memory_huge_pages(mode);
+            assert.ok(got == mode || got == 'off');
+            assert.equal(sodium.sodium_pwhash_memory_pool_stats().hugePages, got);
+
+            var before = sodium.sodium_pwhash_memory_pool_stats();
+            assert.deepEqual(hash(), expected);
+            var after = sodium.sodium_pwhash_memory_pool_stats();
+            // Regions are unmapped after the hash when the pool is off
+            assert.equal(after.misses - before.misses, 1);
+            assert.equal(after.inUse, 0);
+            assert.equal(after.mapped.normal + after.mapped.transparent + after.mapped.explicit, 0);
+        });
+    });
+
+    it('should report the backing of prefaulted regions', function() {
+        var got = sodium.sodium_pwhash_memory_huge_pages('explicit');
+        sodium.sodium_pwhash_memory_pool_enable(1, MEM + 4096);
+        var stats = sodium.sodium_pwhash_memory_pool_stats();
+        var mapped = stats.mapped;
+        assert.equal(mapped.normal + mapped.transparent + mapped.explicit, stats.bytes);
+        if (got == 'off') {
+            assert.equal(mapped.normal, MEM + 4096);
+        } else {
+            // Rounded up to whole 2MB pages
+            assert.equal(stats.bytes, 2 * MEM);
+            assert.equal(stats.fallbacks > 0, mapped.explicit == 0);
+        }
+        hash();
+        assert.equal(sodium.sodium_pwhash_memory_pool_stats().hits - stats.hits, 1);
+    });
+});
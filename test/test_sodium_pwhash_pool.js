@@ -0,0 +1,129 @@
+"use strict";
+
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+var password = Buffer.from('this is a test password', 'utf8');
+var salt = Buffer.alloc(sodium.crypto_pwhash_SALTBYTES, 3);
+var OPS = sodium.crypto_pwhash_OPSLIMIT_MIN + 1;
+var MEM = 1 << 20;
+
+function hash(pw) {
+    return sodium.crypto_pwhash_async(32, pw || password, salt, OPS, MEM, sodium.crypto_pwhash_ALG_DEFAULT);
+}
+
+describe('sodium_pwhash_pool', function() {
+    afterEach(function() {
+        sodium.sodium_pwhash_pool_configure({ threads: 2, maxQueue: 256, cpus: null });
+    });
+
+    it('should report its configuration and counters', function() {
+        var stats = sodium.sodium_pwhash_pool_stats();
+        assert.equal(stats.threads, 2);
+        assert.equal(stats.maxQueue, 256);
+        ['running', 'queued', 'queuePeak', 'submitted', 'completed', 'rejected', 'waitTotal', 'waitMax'].forEach(function(key) {
+            assert.equal(typeof stats[key], 'number', key);
+        });
+    });
+
+    it('should validate options', function() {
+        assert.throws(function() { sodium.sodium_pwhash_pool_configure(); });
+        assert.throws(function() { sodium.sodium_pwhash_pool_configure({ threads: -1 }); });
+        assert.throws(function() { sodium.sodium_pwhash_pool_configure({ threads: 65 }); });
+        assert.throws(function() { sodium.sodium_pwhash_pool_configure({ maxQueue: 1.5 }); });
+        assert.throws(function() { sodium.sodium_pwhash_pool_configure({ cpus: 0 }); });
+        assert.throws(function() { sodium.sodium_pwhash_pool_configure({ cpus: [-1] }); });
+        assert.throws(function() { sodium.sodium_pwhash_pool_configure({ cpus: [1 << 20] }); });
+    });
+
+    it('should count the jobs of each thread', function() {
+        var before = sodium.sodium_pwhash_pool_stats().workers;
+        var total = function(workers) {
+            return workers.reduce(function(sum, w) { return sum + w.jobs; }, 0);
+        };
+        return Promise.all([hash(), hash()]).then(function() {
+            var stats = sodium.sodium_pwhash_pool_stats();
+            assert.strictEqual(stats.cpus, null);
+            assert.equal(stats.workers.length, 2);
+            assert.ok(total(stats.workers) >= total(before) + 2);
+            stats.workers.forEach(function(w) {
+                assert.equal(w.pinned, -1);
+                ['cpu', 'node', 'busy'].forEach(function(key) {
+                    assert.equal(typeof w[key], 'number', key);
+                });
+            });
+        });
+    });
+
+    if( process.platform == 'linux' ) {
+        it('should pin its threads to the listed CPUs', function() {
+            sodium.sodium_pwhash_pool_configure({ cpus: [0] });
+            assert.deepEqual(sodium.sodium_pwhash_pool_stats().cpus, [0]);
+            return Promise.all([hash(), hash(), hash()]).then(function() {
+                var workers = sodium.sodium_pwhash_pool_stats().workers.filter(function(w) { return w.pinned >= 0; });
+                assert.ok(workers.length > 0);
+                workers.forEach(function(w) {
+                    assert.equal(w.pinned, 0);
+                    assert.equal(w.cpu, 0);
+                });
+            });
+        });
+    }
+
+    it('should hash on the pool and count the jobs', function() {
+        var before = sodium.sodium_pwhash_pool_stats();
+        var expected = sodium.crypto_pwhash(32, password, salt, OPS, MEM, sodium.crypto_pwhash_ALG_DEFAULT);
+        return Promise.all([hash(), hash(), hash()]).then(function(results) {
+            results.forEach(function(out) {
+                assert.deepEqual(out, expected);
+            });
+            var after = sodium.sodium_pwhash_pool_stats();
+            assert.equal(after.submitted - before.submitted, 3);
+            assert.equal(after.completed - before.completed, 3);
+            assert.equal(after.running, 0);
+            assert.equal(after.queued, 0);
+            assert.ok(after.waitTotal >= before.waitTotal);
+        });
+    });
+
+    it('should reject jobs when the queue is full', function() {
+        sodium.sodium_pwhash_pool_configure({ threads: 1, maxQueue: 1 });
+        var before = sodium.sodium_pwhash_pool_stats().rejected;
+
+        // One job may be running, one waits, the rest are turned away
+        var jobs = [];
+        for (var i = 0; i < 5; i++) {
+            jobs.push(hash().then(function() { return 'ok'; }, function(err) { return err.message; }));
+        }
+        return Promise.all(jobs).then(function(results) {
+            assert.equal(results[0], 'ok');
+            assert.ok(results.indexOf('password hashing queue is full') > 0);
+            var rejected = results.filter(function(r) { return r != 'ok'; }).length;
+            assert.equal(sodium.sodium_pwhash_pool_stats().rejected - before, rejected);
+        });
+    });
+
+    it('should call callbacks with the rejection after returning', function(done) {
+        sodium.sodium_pwhash_pool_configure({ threads: 1, maxQueue: 1 });
+        var ignore = function() {};
+        hash().catch(ignore);
+        hash().catch(ignore);
+        var returned = false;
+        sodium.crypto_pwhash_str_async(password, OPS, MEM, function(err, out) {
+            assert.ok(returned);
+            assert.ok(err instanceof Error);
+            assert.equal(out, undefined);
+            done();
+        });
+        returned = true;
+    });
+
+    it('should fall back to the libuv threadpool with no threads', function() {
+        sodium.sodium_pwhash_pool_configure({ threads: 0 });
+        var before = sodium.sodium_pwhash_pool_stats().submitted;
+        return sodium.crypto_pwhash_str_async(password, OPS, MEM).then(function(str) {
+            assert.ok(sodium.crypto_pwhash_str_verify(str, password));
+            assert.equal(sodium.sodium_pwhash_pool_stats().submitted, before);
+        });
+    });
+});
@@ -0,0 +1,52 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe('sodium_stats', function() {
+    var key = Buffer.alloc(sodium.crypto_secretbox_KEYBYTES, 1);
+    var nonce = Buffer.alloc(sodium.crypto_secretbox_NONCEBYTES, 2);
+
+    beforeEach(function() {
+        sodium.sodium_stats_reset();
+    });
+
+    it('should list every primitive at zero after a reset', function(done) {
+        var stats = sodium.sodium_stats();
+        ['box', 'secretbox', 'sign', 'verify', 'hash', 'pwhash', 'random'].forEach(function(name) {
+            assert.deepEqual(stats[name], { calls: 0, bytesIn: 0, bytesOut: 0, failures: 0 });
+        });
+        done();
+    });
+
+    it('should count secretbox calls, bytes and failures', function(done) {
+        var c = sodium.crypto_secretbox_easy(Buffer.alloc(10), nonce, key);
+        sodium.crypto_secretbox_open_easy(c, nonce, key);
+        c[0] ^= 1;
+        assert.strictEqual(sodium.crypto_secretbox_open_easy(c, nonce, key), null);
+
+        var stats = sodium.sodium_stats().secretbox;
+        assert.equal(stats.calls, 3);
+        assert.equal(stats.bytesIn, 10 + 2 * c.length);
+        assert.equal(stats.bytesOut, c.length + 10);
+        assert.equal(stats.failures, 1);
+        done();
+    });
+
+    it('should count signatures and verifications apart', function(done) {
+        var kp = sodium.crypto_sign_keypair();
+        var sig = sodium.crypto_sign_detached(Buffer.from('hello'), kp.secretKey);
+        assert(sodium.crypto_sign_verify_detached(sig, Buffer.from('hello'), kp.publicKey));
+        assert(!sodium.crypto_sign_verify_detached(sig, Buffer.from('hellO'), kp.publicKey));
+
+        var stats = sodium.sodium_stats();
+        assert.equal(stats.sign.calls, 1);
+        assert.equal(stats.verify.calls, 2);
+        assert.equal(stats.verify.failures, 1);
+        done();
+    });
+
+    it('should count random bytes', function(done) {
+        sodium.randombytes_buf(Buffer.alloc(32));
+        assert.equal(sodium.sodium_stats().random.bytesOut, 32);
+        done();
+    });
+});
@@ -0,0 +1,80 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var XorStream = require('../lib/sodium').XorStream;
+var ALGORITHMS = require('../lib/stream-xor').ALGORITHMS;
+
+function random(size) {
+    var buf = Buffer.alloc(size);
+    sodium.randombytes_buf(buf);
+    return buf;
+}
+
+// Write `message` cut at random places, collect the output
+function run(xor, message, done) {
+    var out = [];
+    xor.on('data', function (chunk) { out.push(chunk); });
+    xor.on('end', function () { done(Buffer.concat(out)); });
+    for (var i = 0; i < message.length; ) {
+        var n = Math.min(message.length - i, Math.floor(Math.random() * 300));
+        xor.write(message.slice(i, i + n));
+        i += n;
+    }
+    xor.end();
+}
+
+describe("XorStream", function () {
+    var message = random(20000);
+
+    ALGORITHMS.forEach(function (algo) {
+        it("should match crypto_stream_" + algo + "_xor across chunks", function (done) {
+            var key = random(sodium['crypto_stream_' + algo + '_KEYBYTES']);
+            var nonce = random(sodium['crypto_stream_' + algo + '_NONCEBYTES']);
+            var expected = sodium['crypto_stream_' + algo + '_xor'](message, nonce, key);
+            var copy = Buffer.from(message);
+
+            run(new XorStream(algo, key, nonce), message, function (c) {
+                assert(c.equals(expected));
+                assert(message.equals(copy));
+                run(new XorStream(algo, key, nonce, { inPlace: true }), c, function (m) {
+                    assert(m.equals(copy));
+                    done();
+                });
+            });
+        });
+    });
+
+    it("should start at any position", function () {
+        var key = random(sodium.crypto_stream_chacha20_KEYBYTES);
+        var nonce = random(sodium.crypto_stream_chacha20_NONCEBYTES);
+        var expected = sodium.crypto_stream_chacha20_xor(message, nonce, key);
+
+        [0, 1, 63, 64, 65, 1000, 19999].forEach(function (position) {
+            var xor = new XorStream('chacha20', key, nonce, { position: position });
+            var part = Buffer.from(message.slice(position));
+            xor.update(part.slice(0, 7));
+            assert.equal(xor.position(), position + Math.min(7, part.length));
+            xor.update(part.slice(7));
+            assert.equal(xor.position(), message.length);
+            assert(part.equals(expected.slice(position)));
+        });
+    });
+
+    it("should stop at the end of the chacha20_ietf key stream", function () {
+        var key = random(sodium.crypto_stream_chacha20_ietf_KEYBYTES);
+        var nonce = random(sodium.crypto_stream_chacha20_ietf_NONCEBYTES);
+        var xor = new XorStream('chacha20_ietf', key, nonce, { position: 4294967295 * 64 });
+        xor.update(Buffer.alloc(64));
+        assert.throws(function () {
+            xor.update(Buffer.alloc(1));
+        });
+    });
+
+    it("should reject bad arguments", function () {
+        var key = random(sodium.crypto_stream_xsalsa20_KEYBYTES);
+        var nonce = random(sodium.crypto_stream_xsalsa20_NONCEBYTES);
+        assert.throws(function () { new XorStream('salsa208', key, nonce); });
+        assert.throws(function () { new XorStream('xsalsa20', key.slice(1), nonce); });
+        assert.throws(function () { new XorStream('xsalsa20', key, nonce.slice(1)); });
+        assert.throws(function () { new XorStream('xsalsa20', key, nonce, { position: -1 }); });
+    });
+});
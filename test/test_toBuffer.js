@@ -56,5 +56,17 @@ describe("toBuffer", function () {
         done();
     });
 
+    it("should return the same buffer and a view of a Uint8Array", function (done) {
+        var a = Buffer.alloc(5, 5);
+        assert.strictEqual(toBuffer(a, 'hex'), a);
+
+        var u = new Uint8Array([0, 1, 2, 3, 4, 5]).subarray(1);
+        var b = toBuffer(u);
+        assert(Buffer.isBuffer(b));
+        assert.equal(b.length, 5);
+        b[0] = 9;
+        assert.equal(u[0], 9);
+        done();
+    });
 
 });
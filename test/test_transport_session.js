@@ -0,0 +1,84 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+
+describe("TransportSession", function () {
+    var keyA = sodium.crypto_aead_chacha20poly1305_ietf_keygen();
+    var keyB = sodium.crypto_aead_chacha20poly1305_ietf_keygen();
+    var HEADER = sodium.TransportSession.HEADERBYTES;
+    var OVERHEAD = sodium.TransportSession.OVERHEAD;
+
+    function seal(session, message) {
+        var packet = Buffer.alloc(message.length + OVERHEAD);
+        message.copy(packet, HEADER);
+        assert.strictEqual(session.seal(packet, message.length), packet.length);
+        return packet;
+    }
+
+    it("should match crypto_aead_chacha20poly1305_ietf with a counter nonce", function (done) {
+        var alice = new sodium.TransportSession(keyA, keyB);
+        var bob = new sodium.TransportSession(keyB, keyA);
+        var m = Buffer.from("This is a test");
+
+        seal(alice, m);
+        var packet = seal(alice, m);
+        assert.strictEqual(packet.readUInt32LE(0), 1);
+        assert.strictEqual(alice.sendCounter, 2);
+
+        var nonce = Buffer.alloc(sodium.crypto_aead_chacha20poly1305_ietf_NPUBBYTES);
+        packet.copy(nonce, 4, 0, HEADER);
+        var c = sodium.crypto_aead_chacha20poly1305_ietf_encrypt(m, null, nonce, keyA);
+        assert(packet.subarray(HEADER).equals(c));
+
+        assert.strictEqual(bob.open(packet), m.length);
+        assert(packet.subarray(HEADER, HEADER + m.length).equals(m));
+        done();
+    });
+
+    it("should reject replayed, forged and old packets", function (done) {
+        var alice = new sodium.TransportSession(keyA, keyB);
+        var bob = new sodium.TransportSession(keyB, keyA);
+        var m = Buffer.from("x");
+
+        var first = seal(alice, m);
+        var copy = Buffer.from(first);
+        var packets = [];
+        for( var i = 0; i < sodium.TransportSession.WINDOW + 1; i++ ) {
+            packets.push(seal(alice, m));
+        }
+        var forged = seal(alice, m);
+        forged[HEADER] ^= 1;
+
+        // Out of order is fine, once
+        var last = packets.pop();
+        assert.strictEqual(bob.open(last), 1);
+        assert.strictEqual(bob.open(packets[5]), 1);
+        assert.strictEqual(bob.open(Buffer.from(last)), null);
+        assert.strictEqual(bob.open(forged), null);
+        assert.strictEqual(bob.open(first), null);     // older than the window
+        assert.strictEqual(bob.open(Buffer.alloc(OVERHEAD - 1)), null);
+
+        var lengths = bob.openBatch([packets[6], copy, packets[7]]);
+        assert.deepEqual(Array.from(lengths), [1, -1, 1]);
+
+        assert.deepEqual(bob.stats(), { sent: 0, received: 4, replayed: 3, rejected: 2 });
+        done();
+    });
+
+    it("should check its arguments", function (done) {
+        assert.throws(function() {
+            new sodium.TransportSession(keyA, keyA);
+        });
+        assert.throws(function() {
+            new sodium.TransportSession(keyA, Buffer.alloc(3));
+        });
+        var session = new sodium.TransportSession(keyA, keyB);
+        assert.throws(function() {
+            session.seal(Buffer.alloc(OVERHEAD + 3), 4);
+        });
+        session.dispose();
+        assert.throws(function() {
+            session.seal(Buffer.alloc(OVERHEAD), 0);
+        });
+        done();
+    });
+});
@@ -0,0 +1,73 @@
+var assert = require('assert');
+var fs = require('fs');
+var sodium = require('../build/Release/sodium');
+var prebuilds = require('../lib/prebuilds');
+
+describe("WebAssembly build", function () {
+    var wasm;
+
+    before(function () {
+        if (!fs.existsSync(prebuilds.wasm())) {
+            this.skip();
+        }
+        wasm = require('../lib/wasm').load();
+    });
+
+    it("should have the constants of the addon", function () {
+        ['crypto_box_NONCEBYTES', 'crypto_secretbox_KEYBYTES', 'crypto_sign_BYTES',
+         'crypto_pwhash_STRBYTES', 'crypto_pwhash_MEMLIMIT_INTERACTIVE'].forEach(function (name) {
+            assert.strictEqual(wasm[name], sodium[name], name);
+        });
+        assert.strictEqual(wasm.crypto_box_primitive(), sodium.crypto_box_primitive());
+        assert.strictEqual(wasm.version, sodium.version);
+    });
+
+    it("should hash, box and sign like the addon", function () {
+        var message = Buffer.alloc(10000);
+        sodium.randombytes_buf(message);
+        assert(wasm.crypto_hash(message).equals(sodium.crypto_hash(message)));
+        assert(wasm.crypto_generichash(32, message).equals(sodium.crypto_generichash(32, message)));
+
+        var alice = wasm.crypto_box_keypair();
+        var bob = sodium.crypto_box_keypair();
+        var nonce = Buffer.alloc(wasm.crypto_box_NONCEBYTES, 1);
+        var c = wasm.crypto_box_easy(message, nonce, bob.publicKey, alice.secretKey);
+        assert(c.equals(sodium.crypto_box_easy(message, nonce, bob.publicKey, alice.secretKey)));
+        assert(wasm.crypto_box_open_easy(c, nonce, alice.publicKey, bob.secretKey).equals(message));
+        c[0] ^= 1;
+        assert.strictEqual(wasm.crypto_box_open_easy(c, nonce, alice.publicKey, bob.secretKey), null);
+
+        var seed = Buffer.alloc(wasm.crypto_sign_SEEDBYTES, 7);
+        var keys = wasm.crypto_sign_seed_keypair(seed);
+        assert(keys.secretKey.equals(sodium.crypto_sign_seed_keypair(seed).secretKey));
+        var sig = wasm.crypto_sign_detached(message, keys.secretKey);
+        assert(sig.equals(sodium.crypto_sign_detached(message, keys.secretKey)));
+        assert.strictEqual(wasm.crypto_sign_verify_detached(sig, message, keys.publicKey), true);
+    });
+
+    it("should keep streaming state in the caller's buffers", function () {
+        var key = wasm.crypto_secretstream_xchacha20poly1305_keygen();
+        var push = wasm.crypto_secretstream_xchacha20poly1305_init_push(key);
+        var pull = sodium.crypto_secretstream_xchacha20poly1305_init_pull(push.header, key);
+        for (var i = 0; i < 3; i++) {
+            var m = Buffer.from("chunk " + i);
+            var c = wasm.crypto_secretstream_xchacha20poly1305_push(push.state, m, null, 0);
+            assert(sodium.crypto_secretstream_xchacha20poly1305_pull(pull, c).message.equals(m));
+        }
+
+        var state = wasm.crypto_generichash_init(null, 64);
+        wasm.crypto_generichash_update(state, Buffer.from("hello "));
+        wasm.crypto_generichash_update(state, Buffer.from("world"));
+        assert(wasm.crypto_generichash_final(state, 64).equals(
+            sodium.crypto_generichash(64, Buffer.from("hello world"))));
+    });
+
+    it("should check its arguments", function () {
+        assert.throws(function () {
+            wasm.crypto_hash("not a buffer");
+        });
+        assert.throws(function () {
+            wasm.crypto_secretbox_easy(Buffer.alloc(1), Buffer.alloc(3), Buffer.alloc(32));
+        });
+    });
+});
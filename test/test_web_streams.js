@@ -0,0 +1,136 @@
+var assert = require('assert');
+var sodium = require('../build/Release/sodium');
+var lib = require('../lib/sodium');
+var WebStreams = lib.WebStreams;
+
+// Write `chunks` through `transform` and collect the output in one Buffer
+function run(transform, chunks) {
+    var input = new ReadableStream({
+        start: function (controller) {
+            chunks.forEach(function (chunk) {
+                controller.enqueue(chunk);
+            });
+            controller.close();
+        }
+    });
+    var reader = input.pipeThrough(transform).getReader();
+    var out = [];
+    function next() {
+        return reader.read().then(function (r) {
+            if (r.done) {
+                return Buffer.concat(out);
+            }
+            out.push(r.value);
+            return next();
+        });
+    }
+    return next();
+}
+
+// Cut `buf` in pieces of varying sizes, as Uint8Arrays
+function pieces(buf) {
+    var out = [];
+    for (var pos = 0, n = 1; pos < buf.length; pos += n, n = n * 3 % 7919 + 1) {
+        out.push(new Uint8Array(buf.buffer, buf.byteOffset + pos, Math.min(n, buf.length - pos)));
+    }
+    return out;
+}
+
+describe("Web Streams", function () {
+    var message = Buffer.alloc(100000);
+    sodium.randombytes_buf(message);
+
+    it("should round trip secretstreams written in pieces", function () {
+        var key = sodium.crypto_secretstream_xchacha20poly1305_keygen();
+        return run(new WebStreams.SecretStreamEncryptor(key, { chunkSize: 4096 }), pieces(message))
+            .then(function (c) {
+                return run(new WebStreams.SecretStreamDecryptor(key, { chunkSize: 4096 }), pieces(c));
+            })
+            .then(function (plain) {
+                assert(plain.equals(message));
+            });
+    });
+
+    it("should read the output of SecretStream.Encryptor", function (done) {
+        var key = sodium.crypto_secretstream_xchacha20poly1305_keygen();
+        var enc = new lib.SecretStream.Encryptor(key);
+        var out = [];
+        enc.on('data', function (c) { out.push(c); });
+        enc.on('end', function () {
+            run(new WebStreams.SecretStreamDecryptor(key), [Buffer.concat(out)]).then(function (plain) {
+                assert(plain.equals(message));
+                done();
+            }, done);
+        });
+        enc.end(message);
+    });
+
+    it("should error on truncated or tampered secretstreams", function () {
+        var key = sodium.crypto_secretstream_xchacha20poly1305_keygen();
+        return run(new WebStreams.SecretStreamEncryptor(key, { chunkSize: 1000 }), [message]).then(function (c) {
+            var tampered = Buffer.from(c);
+            tampered[5000] ^= 1;
+            return Promise.all([
+                run(new WebStreams.SecretStreamDecryptor(key, { chunkSize: 1000 }), [c.slice(0, c.length - 1016)]),
+                run(new WebStreams.SecretStreamDecryptor(key, { chunkSize: 1000 }), [tampered])
+            ].map(function (p) {
+                return p.then(function () {
+                    assert.fail('should have errored');
+                }, function (err) {
+                    assert(/secretstream/.test(err.message));
+                });
+            }));
+        });
+    });
+
+    it("should write and read Seekable containers", function () {
+        var key = lib.Seekable.keygen();
+        var enc = new WebStreams.SeekableEncryptor(key, message.length, { chunkSize: 4096, threads: 2 });
+        return run(enc, pieces(message)).then(function (container) {
+            assert.equal(container.length, enc.container.size);
+            assert(lib.Seekable.decryptRange(container, key).equals(message));
+            return Promise.all([
+                run(new WebStreams.SeekableDecryptor(key), pieces(container)).then(function (plain) {
+                    assert(plain.equals(message));
+                }),
+                run(new WebStreams.SeekableDecryptor(key), [container.slice(0, container.length - 1)])
+                    .then(function () {
+                        assert.fail('should have errored');
+                    }, function (err) {
+                        assert(/truncated/.test(err.message));
+                    })
+            ]);
+        });
+    });
+
+    it("should write and read empty Seekable containers", function () {
+        var key = lib.Seekable.keygen();
+        return run(new WebStreams.SeekableEncryptor(key, 0), []).then(function (container) {
+            return run(new WebStreams.SeekableDecryptor(key), [container]);
+        }).then(function (plain) {
+            assert.equal(plain.length, 0);
+        });
+    });
+
+    it("should hash like the one shot functions", function () {
+        var tee = new WebStreams.HashPassThrough('sha512');
+        return Promise.all([
+            run(new WebStreams.HashStream('sha256'), pieces(message)),
+            run(tee, pieces(message)),
+            tee.digest
+        ]).then(function (r) {
+            assert(r[0].equals(sodium.crypto_hash_sha256(message)));
+            assert(r[1].equals(message));
+            assert(r[2].equals(sodium.crypto_hash_sha512(message)));
+        });
+    });
+
+    it("should be TransformStreams", function () {
+        var t = new WebStreams.HashStream('generichash');
+        assert(t instanceof TransformStream);
+        assert(t instanceof WebStreams.HashStream);
+        assert.throws(function () {
+            new WebStreams.HashStream('md5');
+        });
+    });
+});
@@ -0,0 +1,66 @@
+"use strict";
+
+var assert = require('assert');
+var path = require('path');
+var sodium = require('../build/Release/sodium');
+
+var Worker;
+try {
+    Worker = require('worker_threads').Worker;
+}
+catch (e) {
+    Worker = null;
+}
+
+// Each worker loads the addon, turns on its own output pool and hashes its
+// id, so the results show both that loading in parallel works and that the
+// pools do not interfere with each other or with the main thread's
+var workerSource = [
+    "var wt = require('worker_threads');",
+    "var sodium = require(" + JSON.stringify(path.join(__dirname, '../build/Release/sodium')) + ");",
+    "sodium.sodium_pool_enable(1024, 64);",
+    "var hashes = [];",
+    "for (var i = 0; i < 200; i++) {",
+    "    hashes.push(sodium.crypto_generichash(32, Buffer.from('worker' + wt.workerData + ':' + i), null).toString('hex'));",
+    "}",
+    "var stats = sodium.sodium_pool_stats();",
+    "var nonce = Buffer.alloc(24);",
+    "sodium.randombytes_buf(nonce);",
+    "wt.parentPort.postMessage({ hashes: hashes, stats: stats, nonce: nonce.toString('hex') });"
+].join("\n");
+
+function runWorker(id) {
+    return new Promise(function (resolve, reject) {
+        var w = new Worker(workerSource, { eval: true, workerData: id });
+        w.once('message', resolve);
+        w.once('error', reject);
+    });
+}
+
+describe("worker_threads", function () {
+    it("should load in several workers at once, each with its own pool", function (done) {
+        if (!Worker) {
+            return done();
+        }
+        this.timeout(20000);
+        sodium.sodium_pool_disable();
+
+        var ids = [0, 1, 2, 3];
+        Promise.all(ids.map(runWorker)).then(function (results) {
+            var nonces = {};
+            results.forEach(function (r, id) {
+                assert.strictEqual(r.stats.enabled, true);
+                assert.strictEqual(r.stats.slabSize, 1024);
+                assert.strictEqual(r.stats.pooled, 200);
+                for (var i = 0; i < 200; i += 50) {
+                    var expected = sodium.crypto_generichash(32, Buffer.from('worker' + id + ':' + i), null);
+                    assert.strictEqual(r.hashes[i], expected.toString('hex'));
+                }
+                assert(!nonces[r.nonce]);
+                nonces[r.nonce] = true;
+            });
+            assert.strictEqual(sodium.sodium_pool_stats().enabled, false);
+            done();
+        }).catch(done);
+    });
+});